@@ -1,42 +1,186 @@
 #include "audio_engine.h"
 
+#include <limits.h>
+#include <stdio.h>
 #include <string.h>
 
+#define _USE_MATH_DEFINES
+#include <math.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define AUDIO_ENGINE_SSE2
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define AUDIO_ENGINE_NEON
+#endif
+
+#include <algorithm>
+#include <atomic>
 #include <mutex>
+#include <thread>
+#include <vector>
 
 #include <SDL.h>
 
+#include "platform_compat.h"
+#include "plib/gnw/prof.h"
+#include "plib/gnw/vclock.h"
+
 namespace fallout {
 
 #define AUDIO_ENGINE_SOUND_BUFFERS 8
 
+// Size of intermediate buffer for converted samples.
+#define AUDIO_ENGINE_MIX_BUFFER_SIZE 4096
+
+// Bits of `AudioEngineSoundBuffer::control`, the rest is a generation counter
+// bumped by every play/stop so the mixer never overrides a newer request.
+#define AUDIO_ENGINE_CONTROL_PLAYING 0x01
+#define AUDIO_ENGINE_CONTROL_LOOPING 0x02
+#define AUDIO_ENGINE_CONTROL_GENERATION 0x04
+
+// Value of `AudioEngineSoundBuffer::seekPos` when no seek is pending.
+#define AUDIO_ENGINE_NO_SEEK UINT_MAX
+
+// Pan range (DirectSound units, hundredths of dB).
+#define AUDIO_ENGINE_PAN_LEFT (-10000)
+#define AUDIO_ENGINE_PAN_RIGHT 10000
+
+// Number of frames mixed with the same volume while fading without mix bus
+// (`SDL_MixAudioFormat` takes one volume per call).
+#define AUDIO_ENGINE_FADE_STEP_FRAMES 32
+
+// CE: Sound buffers are shared between game thread (controls, sample data)
+// and audio callback (mixing). The callback never blocks:
+// - controls are atomics, the callback applies them on its next run;
+// - sample data is a ring, the game writes behind read cursor (`pos`) and
+//   publishes written data with write cursor (`writePos`);
+// - buffer is released only after the callback leaves it (`mixing`).
 struct AudioEngineSoundBuffer {
-    bool active;
+    std::atomic<bool> active;
+    std::atomic<bool> mixing;
     unsigned int size;
     int bitsPerSample;
     int channels;
     int rate;
     void* data;
-    int volume;
-    bool playing;
-    bool looping;
-    unsigned int pos;
+    std::atomic<int> volume;
+    std::atomic<int> pan;
+    std::atomic<unsigned int> control;
+    std::atomic<unsigned int> pos;
+    std::atomic<unsigned int> seekPos;
+    std::atomic<unsigned int> writePos;
     SDL_AudioStream* stream;
-    std::recursive_mutex mutex;
+
+    // Volume envelope requested by the game (see
+    // `audioEngineSoundBufferFade`), picked up by the callback when
+    // `fadeSerial` changes. `fadeDoneSerial` is the last request the callback
+    // has completed.
+    std::atomic<int> fadeVolume;
+    std::atomic<unsigned int> fadeFrames;
+    std::atomic<unsigned int> fadeSerial;
+    std::atomic<unsigned int> fadeDoneSerial;
+
+    // Envelope state private to the audio callback. Volume moves linearly
+    // from start to target over `fadeLength` frames and stays at target
+    // afterwards (until the game sets volume).
+    unsigned int fadeAppliedSerial;
+    bool fadeActive;
+    float fadeStartVolume;
+    float fadeTargetVolume;
+    unsigned int fadeLength;
+    unsigned int fadeElapsed;
 };
 
+// Playback state of sound buffer private to the audio callback.
+typedef struct AudioEngineMixState {
+    unsigned int pos;
+    bool looping;
+    bool playing;
+
+    // Destination, either float bus or device buffer (when bus is not
+    // available for device format).
+    float* bus;
+    Uint8* stream;
+    int volume;
+
+    // Gains of even and odd samples (left and right of stereo).
+    float gains[2];
+
+    // Envelope of this pass: gain at its first output frame, step per frame,
+    // and number of frames until target gain is reached.
+    bool fading;
+    float fadeGain;
+    float fadeStep;
+    float fadeTargetGain;
+    unsigned int fadeFrames;
+
+    // Pan gains of even and odd samples (applied on top of envelope).
+    float pans[2];
+} AudioEngineMixState;
+
 extern bool GNW95_isActive;
 
 static bool soundBufferIsValid(int soundBufferIndex);
+static AudioEngineSoundBuffer* audioEngineGetActiveSoundBuffer(int soundBufferIndex);
 static void audioEngineMixin(void* userData, Uint8* stream, int length);
+static void audioEngineMixSoundBuffer(AudioEngineSoundBuffer* soundBuffer, float* bus, Uint8* stream, int length);
+static void audioEngineSoundBufferAdvance(AudioEngineSoundBuffer* soundBuffer, AudioEngineMixState* state, unsigned int size);
+static void audioEngineMixDirect(AudioEngineSoundBuffer* soundBuffer, AudioEngineMixState* state, int length);
+static void audioEngineMixConverted(AudioEngineSoundBuffer* soundBuffer, AudioEngineMixState* state, int length);
+static void audioEngineMixChunk(AudioEngineMixState* state, int offset, const Uint8* src, int size);
+static void audioEngineMixFadingChunk(AudioEngineMixState* state, int offset, const Uint8* src, int size);
+static void audioEngineFadeBegin(AudioEngineSoundBuffer* soundBuffer, AudioEngineMixState* state);
+static void audioEngineFadeEnd(AudioEngineSoundBuffer* soundBuffer, int length);
+static float audioEngineFadeVolume(AudioEngineSoundBuffer* soundBuffer);
+static void audioEnginePanGains(int pan, float* left, float* right);
+static void audioEngineAccumulateS16(float* bus, const Sint16* src, int count, const float* gains);
+static void audioEngineAccumulateF32(float* bus, const float* src, int count, const float* gains);
+static void audioEngineStoreS16(Sint16* dest, const float* bus, int count);
+static void audioEngineStoreF32(float* dest, const float* bus, int count);
+static bool audioEngineOfflineInit();
+static void audioEngineOfflineExit();
+static void audioEngineOfflinePump();
+static void audioEngineWriteWavHeader(FILE* stream, unsigned int dataSize);
 
 static SDL_AudioSpec gAudioEngineSpec;
 static SDL_AudioDeviceID gAudioEngineDeviceId = -1;
 static AudioEngineSoundBuffer gAudioEngineSoundBuffers[AUDIO_ENGINE_SOUND_BUFFERS];
 
+// Serializes creation and release of sound buffers, never taken by the audio
+// callback.
+static std::mutex gAudioEngineSoundBuffersMutex;
+
+// CE: Mix bus for device formats it supports (16-bit and float), samples are
+// accumulated in 16-bit scale and converted to device format once per
+// callback.
+static std::vector<float> gAudioEngineBus;
+
+// CE: Backend used by next `audioEngineInit`.
+static int gAudioEngineBackend = AUDIO_ENGINE_BACKEND_SDL;
+static char gAudioEngineCapturePath[COMPAT_MAX_PATH];
+
+// CE: Offline backends (null and WAV) have no device and no callback thread.
+// Mixer is run on game thread from API calls, up to current virtual clock
+// time (see `audioEngineOfflinePump`).
+static bool gAudioEngineOffline = false;
+static bool gAudioEngineOfflinePaused = false;
+
+// Clock value output started at (moved forward by pauses), and number of
+// frames rendered since then.
+static unsigned int gAudioEngineOfflineStart = 0;
+static unsigned int gAudioEngineOfflinePauseTime = 0;
+static unsigned long long gAudioEngineOfflineFrames = 0;
+
+// Output of WAV backend (NULL for null backend, which only advances state).
+static FILE* gAudioEngineCaptureStream = NULL;
+static unsigned int gAudioEngineCaptureSize = 0;
+static std::vector<Uint8> gAudioEngineOfflineBuffer;
+
 static bool audioEngineIsInitialized()
 {
-    return gAudioEngineDeviceId != -1;
+    return gAudioEngineDeviceId != -1 || gAudioEngineOffline;
 }
 
 static bool soundBufferIsValid(int soundBufferIndex)
@@ -44,57 +188,510 @@ static bool soundBufferIsValid(int soundBufferIndex)
     return soundBufferIndex >= 0 && soundBufferIndex < AUDIO_ENGINE_SOUND_BUFFERS;
 }
 
+static AudioEngineSoundBuffer* audioEngineGetActiveSoundBuffer(int soundBufferIndex)
+{
+    if (!audioEngineIsInitialized()) {
+        return NULL;
+    }
+
+    if (!soundBufferIsValid(soundBufferIndex)) {
+        return NULL;
+    }
+
+    // CE: Brings offline output up to date before buffer state is observed
+    // or changed.
+    audioEngineOfflinePump();
+
+    AudioEngineSoundBuffer* soundBuffer = &(gAudioEngineSoundBuffers[soundBufferIndex]);
+    if (!soundBuffer->active.load()) {
+        return NULL;
+    }
+
+    return soundBuffer;
+}
+
+// NOTE: `stream` is NULL when called by null backend, which only advances
+// buffers without producing samples.
 static void audioEngineMixin(void* userData, Uint8* stream, int length)
 {
-    memset(stream, gAudioEngineSpec.silence, length);
+    ProfScope profScope(PROF_ZONE_AUDIO_CALLBACK);
+
+    if (stream != NULL) {
+        memset(stream, gAudioEngineSpec.silence, length);
+    }
 
     if (!GNW95_isActive) {
         return;
     }
 
+    int sampleSize = SDL_AUDIO_BITSIZE(gAudioEngineSpec.format) / 8;
+    int count = length / sampleSize;
+
+    float* bus = NULL;
+    if (stream != NULL && !gAudioEngineBus.empty() && count <= static_cast<int>(gAudioEngineBus.size())) {
+        bus = gAudioEngineBus.data();
+        memset(bus, 0, sizeof(*bus) * count);
+    }
+
     for (int index = 0; index < AUDIO_ENGINE_SOUND_BUFFERS; index++) {
         AudioEngineSoundBuffer* soundBuffer = &(gAudioEngineSoundBuffers[index]);
-        std::lock_guard<std::recursive_mutex> lock(soundBuffer->mutex);
-
-        if (soundBuffer->active && soundBuffer->playing) {
-            int srcFrameSize = soundBuffer->bitsPerSample / 8 * soundBuffer->channels;
-
-            unsigned char buffer[1024];
-            int pos = 0;
-            while (pos < length) {
-                int remaining = length - pos;
-                if (remaining > sizeof(buffer)) {
-                    remaining = sizeof(buffer);
-                }
-
-                // TODO: Make something better than frame-by-frame convertion.
-                SDL_AudioStreamPut(soundBuffer->stream, (unsigned char*)soundBuffer->data + soundBuffer->pos, srcFrameSize);
-                soundBuffer->pos += srcFrameSize;
-
-                int bytesRead = SDL_AudioStreamGet(soundBuffer->stream, buffer, remaining);
-                if (bytesRead == -1) {
-                    break;
-                }
-
-                SDL_MixAudioFormat(stream + pos, buffer, gAudioEngineSpec.format, bytesRead, soundBuffer->volume);
-
-                if (soundBuffer->pos >= soundBuffer->size) {
-                    if (soundBuffer->looping) {
-                        soundBuffer->pos %= soundBuffer->size;
-                    } else {
-                        soundBuffer->playing = false;
-                        break;
-                    }
-                }
-
-                pos += bytesRead;
+
+        // Pairs with `audioEngineSoundBufferRelease`: either release sees
+        // the buffer being mixed and waits, or the mixer sees it inactive.
+        soundBuffer->mixing.store(true);
+        if (soundBuffer->active.load()) {
+            audioEngineMixSoundBuffer(soundBuffer, bus, stream, length);
+        }
+        soundBuffer->mixing.store(false);
+    }
+
+    if (bus != NULL) {
+        if (gAudioEngineSpec.format == AUDIO_F32SYS) {
+            audioEngineStoreF32(reinterpret_cast<float*>(stream), bus, count);
+        } else {
+            audioEngineStoreS16(reinterpret_cast<Sint16*>(stream), bus, count);
+        }
+    }
+}
+
+static void audioEngineMixSoundBuffer(AudioEngineSoundBuffer* soundBuffer, float* bus, Uint8* stream, int length)
+{
+    unsigned int control = soundBuffer->control.load();
+    if ((control & AUDIO_ENGINE_CONTROL_PLAYING) == 0) {
+        return;
+    }
+
+    // Makes samples written before last unlock visible.
+    soundBuffer->writePos.load(std::memory_order_acquire);
+
+    AudioEngineMixState state;
+    state.pos = soundBuffer->seekPos.exchange(AUDIO_ENGINE_NO_SEEK);
+    if (state.pos == AUDIO_ENGINE_NO_SEEK) {
+        state.pos = soundBuffer->pos.load();
+    }
+    state.looping = (control & AUDIO_ENGINE_CONTROL_LOOPING) != 0;
+    state.playing = true;
+    state.bus = bus;
+    state.stream = stream;
+
+    if (gAudioEngineSpec.channels == 2) {
+        audioEnginePanGains(soundBuffer->pan.load(), &(state.pans[0]), &(state.pans[1]));
+    } else {
+        state.pans[0] = 1.0f;
+        state.pans[1] = 1.0f;
+    }
+
+    audioEngineFadeBegin(soundBuffer, &state);
+
+    float gain = static_cast<float>(state.volume) / SDL_MIX_MAXVOLUME;
+    state.gains[0] = gain * state.pans[0];
+    state.gains[1] = gain * state.pans[1];
+
+    if (soundBuffer->stream == NULL) {
+        audioEngineMixDirect(soundBuffer, &state, length);
+    } else {
+        audioEngineMixConverted(soundBuffer, &state, length);
+    }
+
+    audioEngineFadeEnd(soundBuffer, length);
+
+    soundBuffer->pos.store(state.pos);
+
+    if (!state.playing) {
+        // Fails if the game restarted or stopped the buffer meanwhile.
+        soundBuffer->control.compare_exchange_strong(control, (control & ~AUDIO_ENGINE_CONTROL_PLAYING) + AUDIO_ENGINE_CONTROL_GENERATION);
+    }
+}
+
+// Advances read position by `size` bytes of source data, wrapping looping
+// sounds and stopping the rest at the end of buffer.
+static void audioEngineSoundBufferAdvance(AudioEngineSoundBuffer* soundBuffer, AudioEngineMixState* state, unsigned int size)
+{
+    state->pos += size;
+
+    if (state->pos >= soundBuffer->size) {
+        if (state->looping) {
+            state->pos %= soundBuffer->size;
+        } else {
+            state->playing = false;
+        }
+    }
+}
+
+// CE: Source data matches device format, mix it as is.
+static void audioEngineMixDirect(AudioEngineSoundBuffer* soundBuffer, AudioEngineMixState* state, int length)
+{
+    int pos = 0;
+    while (pos < length && state->playing) {
+        unsigned int chunk = std::min(static_cast<unsigned int>(length - pos), soundBuffer->size - state->pos);
+        audioEngineMixChunk(state, pos, (unsigned char*)soundBuffer->data + state->pos, chunk);
+        audioEngineSoundBufferAdvance(soundBuffer, state, chunk);
+        pos += chunk;
+    }
+}
+
+// CE: Source data is converted with audio stream. Source is fed in blocks
+// large enough to fill the rest of output at given resample ratio (instead
+// of one frame at a time), converted data left in stream is used by the next
+// callback.
+static void audioEngineMixConverted(AudioEngineSoundBuffer* soundBuffer, AudioEngineMixState* state, int length)
+{
+    int srcFrameSize = soundBuffer->bitsPerSample / 8 * soundBuffer->channels;
+    int dstFrameSize = SDL_AUDIO_BITSIZE(gAudioEngineSpec.format) / 8 * gAudioEngineSpec.channels;
+
+    // Audio stream hands out whole frames only.
+    unsigned char buffer[AUDIO_ENGINE_MIX_BUFFER_SIZE];
+    int bufferSize = sizeof(buffer) / dstFrameSize * dstFrameSize;
+
+    int pos = 0;
+    while (pos < length) {
+        if (SDL_AudioStreamAvailable(soundBuffer->stream) == 0) {
+            if (!state->playing) {
+                break;
+            }
+
+            int dstFrames = (length - pos + dstFrameSize - 1) / dstFrameSize;
+            unsigned int srcFrames = (unsigned int)((Sint64)dstFrames * soundBuffer->rate / gAudioEngineSpec.freq) + 1;
+            unsigned int chunk = std::min(srcFrames * srcFrameSize, soundBuffer->size - state->pos);
+
+            if (SDL_AudioStreamPut(soundBuffer->stream, (unsigned char*)soundBuffer->data + state->pos, chunk) == -1) {
+                break;
             }
+
+            audioEngineSoundBufferAdvance(soundBuffer, state, chunk);
+
+            // Push out samples held back by resampler, otherwise they would
+            // be played at the beginning of next playback.
+            if (!state->playing) {
+                SDL_AudioStreamFlush(soundBuffer->stream);
+            }
+
+            continue;
         }
+
+        int remaining = std::min(length - pos, bufferSize);
+        int bytesRead = SDL_AudioStreamGet(soundBuffer->stream, buffer, remaining);
+        if (bytesRead <= 0) {
+            break;
+        }
+
+        audioEngineMixChunk(state, pos, buffer, bytesRead);
+        pos += bytesRead;
+    }
+}
+
+// Mixes `size` bytes of samples in device format at `offset` (in bytes) of
+// output.
+static void audioEngineMixChunk(AudioEngineMixState* state, int offset, const Uint8* src, int size)
+{
+    if (state->bus == NULL && state->stream == NULL) {
+        return;
+    }
+
+    if (state->fading) {
+        audioEngineMixFadingChunk(state, offset, src, size);
+        return;
+    }
+
+    if (state->bus == NULL) {
+        SDL_MixAudioFormat(state->stream + offset, src, gAudioEngineSpec.format, size, state->volume);
+        return;
+    }
+
+    int sampleSize = SDL_AUDIO_BITSIZE(gAudioEngineSpec.format) / 8;
+    int index = offset / sampleSize;
+
+    // Kernels expect chunk to start with left sample.
+    float gains[2];
+    gains[0] = state->gains[index & 1];
+    gains[1] = state->gains[(index & 1) ^ 1];
+
+    if (gAudioEngineSpec.format == AUDIO_F32SYS) {
+        audioEngineAccumulateF32(state->bus + index, reinterpret_cast<const float*>(src), size / sampleSize, gains);
+    } else {
+        audioEngineAccumulateS16(state->bus + index, reinterpret_cast<const Sint16*>(src), size / sampleSize, gains);
+    }
+}
+
+// Mixes chunk with volume envelope evaluated for every output frame (or
+// every few frames when there is no mix bus).
+static void audioEngineMixFadingChunk(AudioEngineMixState* state, int offset, const Uint8* src, int size)
+{
+    int sampleSize = SDL_AUDIO_BITSIZE(gAudioEngineSpec.format) / 8;
+    int channels = gAudioEngineSpec.channels;
+    int index = offset / sampleSize;
+    int count = size / sampleSize;
+
+    if (state->bus == NULL) {
+        int stepSize = AUDIO_ENGINE_FADE_STEP_FRAMES * channels * sampleSize;
+        for (int pos = 0; pos < size; pos += stepSize) {
+            unsigned int frame = (offset + pos) / sampleSize / channels;
+            float gain = frame < state->fadeFrames ? state->fadeGain + state->fadeStep * frame : state->fadeTargetGain;
+            int volume = std::clamp(static_cast<int>(lrintf(gain * SDL_MIX_MAXVOLUME)), 0, SDL_MIX_MAXVOLUME);
+            SDL_MixAudioFormat(state->stream + offset + pos, src + pos, gAudioEngineSpec.format, std::min(stepSize, size - pos), volume);
+        }
+        return;
+    }
+
+    float* bus = state->bus + index;
+    for (int sample = 0; sample < count; sample++) {
+        unsigned int frame = (index + sample) / channels;
+        float gain = frame < state->fadeFrames ? state->fadeGain + state->fadeStep * frame : state->fadeTargetGain;
+        gain *= state->pans[(index + sample) & 1];
+
+        if (gAudioEngineSpec.format == AUDIO_F32SYS) {
+            bus[sample] += reinterpret_cast<const float*>(src)[sample] * 32768.0f * gain;
+        } else {
+            bus[sample] += static_cast<float>(reinterpret_cast<const Sint16*>(src)[sample]) * gain;
+        }
+    }
+}
+
+// Picks up envelope requested by the game and sets up volume of this pass.
+static void audioEngineFadeBegin(AudioEngineSoundBuffer* soundBuffer, AudioEngineMixState* state)
+{
+    unsigned int serial = soundBuffer->fadeSerial.load(std::memory_order_acquire);
+    if (serial != soundBuffer->fadeAppliedSerial) {
+        // New envelope starts from current volume, so that retargeting a
+        // running fade does not jump.
+        float volume = audioEngineFadeVolume(soundBuffer);
+        unsigned int frames = soundBuffer->fadeFrames.load();
+
+        soundBuffer->fadeAppliedSerial = serial;
+        if (frames != 0) {
+            soundBuffer->fadeActive = true;
+            soundBuffer->fadeStartVolume = volume;
+            soundBuffer->fadeTargetVolume = static_cast<float>(soundBuffer->fadeVolume.load());
+            soundBuffer->fadeLength = frames;
+            soundBuffer->fadeElapsed = 0;
+        } else {
+            // Cancelled by volume change.
+            soundBuffer->fadeActive = false;
+            soundBuffer->fadeDoneSerial.store(serial);
+        }
+    }
+
+    state->fading = false;
+
+    if (!soundBuffer->fadeActive) {
+        state->volume = soundBuffer->volume.load();
+        return;
+    }
+
+    float start = soundBuffer->fadeStartVolume;
+    float target = soundBuffer->fadeTargetVolume;
+    state->volume = static_cast<int>(lrintf(target));
+
+    if (soundBuffer->fadeElapsed >= soundBuffer->fadeLength) {
+        return;
+    }
+
+    state->fading = true;
+    state->fadeGain = audioEngineFadeVolume(soundBuffer) / SDL_MIX_MAXVOLUME;
+    state->fadeStep = (target - start) / soundBuffer->fadeLength / SDL_MIX_MAXVOLUME;
+    state->fadeTargetGain = target / SDL_MIX_MAXVOLUME;
+    state->fadeFrames = soundBuffer->fadeLength - soundBuffer->fadeElapsed;
+}
+
+// Advances envelope by one pass of `length` bytes of output.
+static void audioEngineFadeEnd(AudioEngineSoundBuffer* soundBuffer, int length)
+{
+    if (!soundBuffer->fadeActive || soundBuffer->fadeElapsed >= soundBuffer->fadeLength) {
+        return;
+    }
+
+    int frameSize = SDL_AUDIO_BITSIZE(gAudioEngineSpec.format) / 8 * gAudioEngineSpec.channels;
+    soundBuffer->fadeElapsed = std::min(soundBuffer->fadeElapsed + length / frameSize, soundBuffer->fadeLength);
+
+    if (soundBuffer->fadeElapsed >= soundBuffer->fadeLength) {
+        soundBuffer->fadeDoneSerial.store(soundBuffer->fadeAppliedSerial);
+    }
+}
+
+// Returns volume (0-128) the callback currently applies to sound buffer.
+static float audioEngineFadeVolume(AudioEngineSoundBuffer* soundBuffer)
+{
+    if (!soundBuffer->fadeActive) {
+        return static_cast<float>(soundBuffer->volume.load());
+    }
+
+    float start = soundBuffer->fadeStartVolume;
+    float target = soundBuffer->fadeTargetVolume;
+    return start + (target - start) * soundBuffer->fadeElapsed / soundBuffer->fadeLength;
+}
+
+// Equal-power pan law scaled so that center keeps both channels at full
+// volume, and hard pan leaves the near channel at full volume.
+static void audioEnginePanGains(int pan, float* left, float* right)
+{
+    if (pan == 0) {
+        *left = 1.0f;
+        *right = 1.0f;
+        return;
+    }
+
+    pan = std::clamp(pan, AUDIO_ENGINE_PAN_LEFT, AUDIO_ENGINE_PAN_RIGHT);
+
+    float angle = static_cast<float>(pan - AUDIO_ENGINE_PAN_LEFT) / (AUDIO_ENGINE_PAN_RIGHT - AUDIO_ENGINE_PAN_LEFT) * static_cast<float>(M_PI / 2);
+    *left = std::min(1.0f, static_cast<float>(M_SQRT2) * cosf(angle));
+    *right = std::min(1.0f, static_cast<float>(M_SQRT2) * sinf(angle));
+}
+
+// Adds `count` 16-bit samples scaled by alternating `gains` to bus.
+static void audioEngineAccumulateS16(float* bus, const Sint16* src, int count, const float* gains)
+{
+    int index = 0;
+
+#if defined(AUDIO_ENGINE_SSE2)
+    __m128 gain = _mm_setr_ps(gains[0], gains[1], gains[0], gains[1]);
+    for (; index + 8 <= count; index += 8) {
+        __m128i samples = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + index));
+        __m128 lo = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(samples, samples), 16));
+        __m128 hi = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(samples, samples), 16));
+        _mm_storeu_ps(bus + index, _mm_add_ps(_mm_loadu_ps(bus + index), _mm_mul_ps(lo, gain)));
+        _mm_storeu_ps(bus + index + 4, _mm_add_ps(_mm_loadu_ps(bus + index + 4), _mm_mul_ps(hi, gain)));
+    }
+#elif defined(AUDIO_ENGINE_NEON)
+    const float gainValues[4] = { gains[0], gains[1], gains[0], gains[1] };
+    float32x4_t gain = vld1q_f32(gainValues);
+    for (; index + 8 <= count; index += 8) {
+        int16x8_t samples = vld1q_s16(src + index);
+        float32x4_t lo = vcvtq_f32_s32(vmovl_s16(vget_low_s16(samples)));
+        float32x4_t hi = vcvtq_f32_s32(vmovl_s16(vget_high_s16(samples)));
+        vst1q_f32(bus + index, vmlaq_f32(vld1q_f32(bus + index), lo, gain));
+        vst1q_f32(bus + index + 4, vmlaq_f32(vld1q_f32(bus + index + 4), hi, gain));
+    }
+#endif
+
+    for (; index < count; index++) {
+        bus[index] += static_cast<float>(src[index]) * gains[index & 1];
     }
 }
 
+// Adds `count` float samples scaled by alternating `gains` to bus (in 16-bit
+// scale).
+static void audioEngineAccumulateF32(float* bus, const float* src, int count, const float* gains)
+{
+    float scaledGains[2] = { gains[0] * 32768.0f, gains[1] * 32768.0f };
+
+    int index = 0;
+
+#if defined(AUDIO_ENGINE_SSE2)
+    __m128 gain = _mm_setr_ps(scaledGains[0], scaledGains[1], scaledGains[0], scaledGains[1]);
+    for (; index + 4 <= count; index += 4) {
+        _mm_storeu_ps(bus + index, _mm_add_ps(_mm_loadu_ps(bus + index), _mm_mul_ps(_mm_loadu_ps(src + index), gain)));
+    }
+#elif defined(AUDIO_ENGINE_NEON)
+    const float gainValues[4] = { scaledGains[0], scaledGains[1], scaledGains[0], scaledGains[1] };
+    float32x4_t gain = vld1q_f32(gainValues);
+    for (; index + 4 <= count; index += 4) {
+        vst1q_f32(bus + index, vmlaq_f32(vld1q_f32(bus + index), vld1q_f32(src + index), gain));
+    }
+#endif
+
+    for (; index < count; index++) {
+        bus[index] += src[index] * scaledGains[index & 1];
+    }
+}
+
+// Converts bus to 16-bit samples with saturation.
+static void audioEngineStoreS16(Sint16* dest, const float* bus, int count)
+{
+    int index = 0;
+
+#if defined(AUDIO_ENGINE_SSE2)
+    // Sums of 8 buffers stay far below int32 range, pack saturates.
+    for (; index + 8 <= count; index += 8) {
+        __m128i lo = _mm_cvtps_epi32(_mm_loadu_ps(bus + index));
+        __m128i hi = _mm_cvtps_epi32(_mm_loadu_ps(bus + index + 4));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + index), _mm_packs_epi32(lo, hi));
+    }
+#elif defined(AUDIO_ENGINE_NEON)
+    // Conversion truncates, round half away from zero instead.
+    float32x4_t half = vdupq_n_f32(0.5f);
+    float32x4_t zero = vdupq_n_f32(0.0f);
+    for (; index + 8 <= count; index += 8) {
+        float32x4_t loSamples = vld1q_f32(bus + index);
+        float32x4_t hiSamples = vld1q_f32(bus + index + 4);
+        loSamples = vaddq_f32(loSamples, vbslq_f32(vcltq_f32(loSamples, zero), vnegq_f32(half), half));
+        hiSamples = vaddq_f32(hiSamples, vbslq_f32(vcltq_f32(hiSamples, zero), vnegq_f32(half), half));
+        int32x4_t lo = vcvtq_s32_f32(loSamples);
+        int32x4_t hi = vcvtq_s32_f32(hiSamples);
+        vst1q_s16(dest + index, vcombine_s16(vqmovn_s32(lo), vqmovn_s32(hi)));
+    }
+#endif
+
+    for (; index < count; index++) {
+        float sample = std::clamp(bus[index], -32768.0f, 32767.0f);
+        dest[index] = static_cast<Sint16>(lrintf(sample));
+    }
+}
+
+// Converts bus to float samples with saturation.
+static void audioEngineStoreF32(float* dest, const float* bus, int count)
+{
+    const float scale = 1.0f / 32768.0f;
+
+    int index = 0;
+
+#if defined(AUDIO_ENGINE_SSE2)
+    __m128 scales = _mm_set1_ps(scale);
+    __m128 lower = _mm_set1_ps(-1.0f);
+    __m128 upper = _mm_set1_ps(1.0f);
+    for (; index + 4 <= count; index += 4) {
+        __m128 samples = _mm_mul_ps(_mm_loadu_ps(bus + index), scales);
+        _mm_storeu_ps(dest + index, _mm_min_ps(_mm_max_ps(samples, lower), upper));
+    }
+#elif defined(AUDIO_ENGINE_NEON)
+    float32x4_t scales = vdupq_n_f32(scale);
+    float32x4_t lower = vdupq_n_f32(-1.0f);
+    float32x4_t upper = vdupq_n_f32(1.0f);
+    for (; index + 4 <= count; index += 4) {
+        float32x4_t samples = vmulq_f32(vld1q_f32(bus + index), scales);
+        vst1q_f32(dest + index, vminq_f32(vmaxq_f32(samples, lower), upper));
+    }
+#endif
+
+    for (; index < count; index++) {
+        dest[index] = std::clamp(bus[index] * scale, -1.0f, 1.0f);
+    }
+}
+
+// CE: Selects backend for next `audioEngineInit`. `capturePath` is WAV file
+// written by `AUDIO_ENGINE_BACKEND_WAV`.
+void audioEngineSetBackend(int backend, const char* capturePath)
+{
+    gAudioEngineBackend = backend;
+
+    if (capturePath != NULL) {
+        strncpy(gAudioEngineCapturePath, capturePath, sizeof(gAudioEngineCapturePath) - 1);
+        gAudioEngineCapturePath[sizeof(gAudioEngineCapturePath) - 1] = '\0';
+    } else {
+        gAudioEngineCapturePath[0] = '\0';
+    }
+}
+
+// CE: Returns backend output is running on, or -1 if engine is not
+// initialized.
+int audioEngineGetActiveBackend()
+{
+    if (gAudioEngineOffline) {
+        return gAudioEngineBackend;
+    }
+
+    if (gAudioEngineDeviceId != -1) {
+        return AUDIO_ENGINE_BACKEND_SDL;
+    }
+
+    return -1;
+}
+
 bool audioEngineInit()
 {
+    if (gAudioEngineBackend != AUDIO_ENGINE_BACKEND_SDL) {
+        return audioEngineOfflineInit();
+    }
+
     if (SDL_InitSubSystem(SDL_INIT_AUDIO) == -1) {
         return false;
     }
@@ -111,6 +708,12 @@ bool audioEngineInit()
         return false;
     }
 
+    // CE: Other formats are mixed with `SDL_MixAudioFormat` directly into
+    // device buffer.
+    if (gAudioEngineSpec.format == AUDIO_S16SYS || gAudioEngineSpec.format == AUDIO_F32SYS) {
+        gAudioEngineBus.resize(gAudioEngineSpec.size / (SDL_AUDIO_BITSIZE(gAudioEngineSpec.format) / 8));
+    }
+
     SDL_PauseAudioDevice(gAudioEngineDeviceId, 0);
 
     return true;
@@ -118,11 +721,19 @@ bool audioEngineInit()
 
 void audioEngineExit()
 {
+    if (gAudioEngineOffline) {
+        audioEngineOfflineExit();
+        return;
+    }
+
     if (audioEngineIsInitialized()) {
         SDL_CloseAudioDevice(gAudioEngineDeviceId);
         gAudioEngineDeviceId = -1;
     }
 
+    gAudioEngineBus.clear();
+    gAudioEngineBus.shrink_to_fit();
+
     if (SDL_WasInit(SDL_INIT_AUDIO)) {
         SDL_QuitSubSystem(SDL_INIT_AUDIO);
     }
@@ -130,6 +741,15 @@ void audioEngineExit()
 
 void audioEnginePause()
 {
+    if (gAudioEngineOffline) {
+        if (!gAudioEngineOfflinePaused) {
+            audioEngineOfflinePump();
+            gAudioEngineOfflinePaused = true;
+            gAudioEngineOfflinePauseTime = vclock_peek();
+        }
+        return;
+    }
+
     if (audioEngineIsInitialized()) {
         SDL_PauseAudioDevice(gAudioEngineDeviceId, 1);
     }
@@ -137,33 +757,188 @@ void audioEnginePause()
 
 void audioEngineResume()
 {
+    if (gAudioEngineOffline) {
+        if (gAudioEngineOfflinePaused) {
+            gAudioEngineOfflinePaused = false;
+            gAudioEngineOfflineStart += vclock_peek() - gAudioEngineOfflinePauseTime;
+        }
+        return;
+    }
+
     if (audioEngineIsInitialized()) {
         SDL_PauseAudioDevice(gAudioEngineDeviceId, 0);
     }
 }
 
+// CE: Sets up device-less output in the format SDL backend asks for.
+static bool audioEngineOfflineInit()
+{
+    memset(&gAudioEngineSpec, 0, sizeof(gAudioEngineSpec));
+    gAudioEngineSpec.freq = 22050;
+    gAudioEngineSpec.format = AUDIO_S16SYS;
+    gAudioEngineSpec.channels = 2;
+    gAudioEngineSpec.samples = 1024;
+    gAudioEngineSpec.silence = 0;
+    gAudioEngineSpec.size = gAudioEngineSpec.samples * gAudioEngineSpec.channels * (SDL_AUDIO_BITSIZE(gAudioEngineSpec.format) / 8);
+
+    if (gAudioEngineBackend == AUDIO_ENGINE_BACKEND_WAV) {
+        gAudioEngineCaptureStream = compat_fopen(gAudioEngineCapturePath, "wb");
+        if (gAudioEngineCaptureStream == NULL) {
+            return false;
+        }
+
+        gAudioEngineCaptureSize = 0;
+        audioEngineWriteWavHeader(gAudioEngineCaptureStream, 0);
+
+        gAudioEngineBus.resize(gAudioEngineSpec.size / (SDL_AUDIO_BITSIZE(gAudioEngineSpec.format) / 8));
+        gAudioEngineOfflineBuffer.resize(gAudioEngineSpec.size);
+    }
+
+    gAudioEngineOfflineStart = vclock_peek();
+    gAudioEngineOfflineFrames = 0;
+    gAudioEngineOfflinePaused = false;
+    gAudioEngineOffline = true;
+
+    return true;
+}
+
+static void audioEngineOfflineExit()
+{
+    if (gAudioEngineCaptureStream != NULL) {
+        // Sizes in header were unknown until now.
+        fseek(gAudioEngineCaptureStream, 0, SEEK_SET);
+        audioEngineWriteWavHeader(gAudioEngineCaptureStream, gAudioEngineCaptureSize);
+        fclose(gAudioEngineCaptureStream);
+        gAudioEngineCaptureStream = NULL;
+    }
+
+    gAudioEngineBus.clear();
+    gAudioEngineBus.shrink_to_fit();
+    gAudioEngineOfflineBuffer.clear();
+    gAudioEngineOfflineBuffer.shrink_to_fit();
+
+    gAudioEngineOffline = false;
+}
+
+// CE: Runs mixer for every whole callback period elapsed on virtual clock
+// since the last run. Buffers advance at the same pace as with a device, so
+// completion of sounds is observed at the same (virtual) time.
+static void audioEngineOfflinePump()
+{
+    if (!gAudioEngineOffline || gAudioEngineOfflinePaused) {
+        return;
+    }
+
+    unsigned long long elapsed = vclock_peek() - gAudioEngineOfflineStart;
+    unsigned long long frames = elapsed * gAudioEngineSpec.freq / 1000;
+
+    Uint8* stream = gAudioEngineCaptureStream != NULL ? gAudioEngineOfflineBuffer.data() : NULL;
+    while (gAudioEngineOfflineFrames + gAudioEngineSpec.samples <= frames) {
+        audioEngineMixin(NULL, stream, gAudioEngineSpec.size);
+
+        if (stream != NULL) {
+            if (fwrite(stream, gAudioEngineSpec.size, 1, gAudioEngineCaptureStream) == 1) {
+                gAudioEngineCaptureSize += gAudioEngineSpec.size;
+            }
+        }
+
+        gAudioEngineOfflineFrames += gAudioEngineSpec.samples;
+    }
+}
+
+// CE: Runs mixer once into `stream` (`length` bytes in output format, 16-bit
+// stereo at 22050 Hz for offline backends), same as device callback does.
+// Only available with offline backends, which have no callback thread to race
+// with. Used by benchmarks.
+bool audioEngineMix(unsigned char* stream, int length)
+{
+    if (!gAudioEngineOffline || stream == NULL || length <= 0) {
+        return false;
+    }
+
+    size_t count = static_cast<size_t>(length / (SDL_AUDIO_BITSIZE(gAudioEngineSpec.format) / 8));
+    if (gAudioEngineBus.size() < count) {
+        gAudioEngineBus.resize(count);
+    }
+
+    audioEngineMixin(NULL, stream, length);
+
+    return true;
+}
+
+// Writes 44-byte header of PCM WAV file in output format.
+static void audioEngineWriteWavHeader(FILE* stream, unsigned int dataSize)
+{
+    unsigned int channels = gAudioEngineSpec.channels;
+    unsigned int rate = gAudioEngineSpec.freq;
+    unsigned int bitsPerSample = SDL_AUDIO_BITSIZE(gAudioEngineSpec.format);
+    unsigned int blockAlign = channels * bitsPerSample / 8;
+
+    const unsigned int fields[][2] = {
+        { 0x46464952, 4 }, // "RIFF"
+        { 36 + dataSize, 4 },
+        { 0x45564157, 4 }, // "WAVE"
+        { 0x20746D66, 4 }, // "fmt "
+        { 16, 4 },
+        { 1, 2 }, // PCM
+        { channels, 2 },
+        { rate, 4 },
+        { rate * blockAlign, 4 },
+        { blockAlign, 2 },
+        { bitsPerSample, 2 },
+        { 0x61746164, 4 }, // "data"
+        { dataSize, 4 },
+    };
+
+    for (size_t index = 0; index < sizeof(fields) / sizeof(*fields); index++) {
+        for (unsigned int byte = 0; byte < fields[index][1]; byte++) {
+            fputc((fields[index][0] >> (byte * 8)) & 0xFF, stream);
+        }
+    }
+}
+
 int audioEngineCreateSoundBuffer(unsigned int size, int bitsPerSample, int channels, int rate)
 {
     if (!audioEngineIsInitialized()) {
         return -1;
     }
 
+    std::lock_guard<std::mutex> lock(gAudioEngineSoundBuffersMutex);
+
     for (int index = 0; index < AUDIO_ENGINE_SOUND_BUFFERS; index++) {
         AudioEngineSoundBuffer* soundBuffer = &(gAudioEngineSoundBuffers[index]);
-        std::lock_guard<std::recursive_mutex> lock(soundBuffer->mutex);
 
-        if (!soundBuffer->active) {
-            soundBuffer->active = true;
+        if (!soundBuffer->active.load()) {
             soundBuffer->size = size;
             soundBuffer->bitsPerSample = bitsPerSample;
             soundBuffer->channels = channels;
             soundBuffer->rate = rate;
-            soundBuffer->volume = SDL_MIX_MAXVOLUME;
-            soundBuffer->playing = false;
-            soundBuffer->looping = false;
-            soundBuffer->pos = 0;
+            soundBuffer->volume.store(SDL_MIX_MAXVOLUME);
+            soundBuffer->pan.store(0);
+            soundBuffer->control.store(0);
+            soundBuffer->pos.store(0);
+            soundBuffer->seekPos.store(AUDIO_ENGINE_NO_SEEK);
+            soundBuffer->writePos.store(0);
+            soundBuffer->fadeVolume.store(0);
+            soundBuffer->fadeFrames.store(0);
+            soundBuffer->fadeSerial.store(0);
+            soundBuffer->fadeDoneSerial.store(0);
+            soundBuffer->fadeAppliedSerial = 0;
+            soundBuffer->fadeActive = false;
             soundBuffer->data = malloc(size);
-            soundBuffer->stream = SDL_NewAudioStream(bitsPerSample == 16 ? AUDIO_S16 : AUDIO_S8, channels, rate, gAudioEngineSpec.format, gAudioEngineSpec.channels, gAudioEngineSpec.freq);
+
+            // CE: No conversion is needed when source matches device format,
+            // such buffers are mixed directly.
+            SDL_AudioFormat format = bitsPerSample == 16 ? AUDIO_S16 : AUDIO_S8;
+            if (format == gAudioEngineSpec.format && channels == gAudioEngineSpec.channels && rate == gAudioEngineSpec.freq) {
+                soundBuffer->stream = NULL;
+            } else {
+                soundBuffer->stream = SDL_NewAudioStream(format, channels, rate, gAudioEngineSpec.format, gAudioEngineSpec.channels, gAudioEngineSpec.freq);
+            }
+
+            // Publishes fields above to the audio callback.
+            soundBuffer->active.store(true);
+
             return index;
         }
     }
@@ -181,164 +956,159 @@ bool audioEngineSoundBufferRelease(int soundBufferIndex)
         return false;
     }
 
-    AudioEngineSoundBuffer* soundBuffer = &(gAudioEngineSoundBuffers[soundBufferIndex]);
-    std::lock_guard<std::recursive_mutex> lock(soundBuffer->mutex);
+    std::lock_guard<std::mutex> lock(gAudioEngineSoundBuffersMutex);
 
-    if (!soundBuffer->active) {
+    AudioEngineSoundBuffer* soundBuffer = &(gAudioEngineSoundBuffers[soundBufferIndex]);
+    if (!soundBuffer->active.load()) {
         return false;
     }
 
-    soundBuffer->active = false;
+    soundBuffer->active.store(false);
+
+    // Wait for the audio callback to leave the buffer (at most one mixing
+    // pass of a single buffer).
+    while (soundBuffer->mixing.load()) {
+        std::this_thread::yield();
+    }
 
     free(soundBuffer->data);
     soundBuffer->data = NULL;
 
-    SDL_FreeAudioStream(soundBuffer->stream);
-    soundBuffer->stream = NULL;
+    if (soundBuffer->stream != NULL) {
+        SDL_FreeAudioStream(soundBuffer->stream);
+        soundBuffer->stream = NULL;
+    }
 
     return true;
 }
 
 bool audioEngineSoundBufferSetVolume(int soundBufferIndex, int volume)
 {
-    if (!audioEngineIsInitialized()) {
+    AudioEngineSoundBuffer* soundBuffer = audioEngineGetActiveSoundBuffer(soundBufferIndex);
+    if (soundBuffer == NULL) {
         return false;
     }
 
-    if (!soundBufferIsValid(soundBufferIndex)) {
-        return false;
-    }
-
-    AudioEngineSoundBuffer* soundBuffer = &(gAudioEngineSoundBuffers[soundBufferIndex]);
-    std::lock_guard<std::recursive_mutex> lock(soundBuffer->mutex);
-
-    if (!soundBuffer->active) {
-        return false;
-    }
+    soundBuffer->volume.store(volume);
 
-    soundBuffer->volume = volume;
+    // Cancels running envelope.
+    soundBuffer->fadeFrames.store(0);
+    soundBuffer->fadeSerial.fetch_add(1, std::memory_order_release);
 
     return true;
 }
 
-bool audioEngineSoundBufferGetVolume(int soundBufferIndex, int* volumePtr)
+// CE: Moves volume linearly to `volume` over `duration` ms. Envelope is
+// evaluated by the mixer for every output frame, and is cancelled by
+// `audioEngineSoundBufferSetVolume`. Envelope only advances while buffer is
+// playing.
+bool audioEngineSoundBufferFade(int soundBufferIndex, int volume, unsigned int duration)
 {
-    if (!audioEngineIsInitialized()) {
-        return false;
-    }
-
-    if (!soundBufferIsValid(soundBufferIndex)) {
+    AudioEngineSoundBuffer* soundBuffer = audioEngineGetActiveSoundBuffer(soundBufferIndex);
+    if (soundBuffer == NULL) {
         return false;
     }
 
-    AudioEngineSoundBuffer* soundBuffer = &(gAudioEngineSoundBuffers[soundBufferIndex]);
-    std::lock_guard<std::recursive_mutex> lock(soundBuffer->mutex);
+    unsigned int frames = (unsigned int)((unsigned long long)duration * gAudioEngineSpec.freq / 1000);
 
-    if (!soundBuffer->active) {
-        return false;
-    }
-
-    *volumePtr = soundBuffer->volume;
+    soundBuffer->fadeVolume.store(volume);
+    soundBuffer->fadeFrames.store(std::max(frames, 1U));
+    soundBuffer->fadeSerial.fetch_add(1, std::memory_order_release);
 
     return true;
 }
 
-bool audioEngineSoundBufferSetPan(int soundBufferIndex, int pan)
+// CE: Returns `true` until the mixer completes the last requested envelope.
+bool audioEngineSoundBufferIsFading(int soundBufferIndex)
 {
-    if (!audioEngineIsInitialized()) {
+    AudioEngineSoundBuffer* soundBuffer = audioEngineGetActiveSoundBuffer(soundBufferIndex);
+    if (soundBuffer == NULL) {
         return false;
     }
 
-    if (!soundBufferIsValid(soundBufferIndex)) {
-        return false;
-    }
-
-    AudioEngineSoundBuffer* soundBuffer = &(gAudioEngineSoundBuffers[soundBufferIndex]);
-    std::lock_guard<std::recursive_mutex> lock(soundBuffer->mutex);
+    return soundBuffer->fadeDoneSerial.load() != soundBuffer->fadeSerial.load();
+}
 
-    if (!soundBuffer->active) {
+bool audioEngineSoundBufferGetVolume(int soundBufferIndex, int* volumePtr)
+{
+    AudioEngineSoundBuffer* soundBuffer = audioEngineGetActiveSoundBuffer(soundBufferIndex);
+    if (soundBuffer == NULL) {
         return false;
     }
 
-    // NOTE: Audio engine does not support sound panning. I'm not sure it's
-    // even needed. For now this value is silently ignored.
+    *volumePtr = soundBuffer->volume.load();
 
     return true;
 }
 
-bool audioEngineSoundBufferPlay(int soundBufferIndex, unsigned int flags)
+bool audioEngineSoundBufferSetPan(int soundBufferIndex, int pan)
 {
-    if (!audioEngineIsInitialized()) {
+    AudioEngineSoundBuffer* soundBuffer = audioEngineGetActiveSoundBuffer(soundBufferIndex);
+    if (soundBuffer == NULL) {
         return false;
     }
 
-    if (!soundBufferIsValid(soundBufferIndex)) {
-        return false;
-    }
+    // CE: Applied by the mixer to stereo output only.
+    soundBuffer->pan.store(pan);
 
-    AudioEngineSoundBuffer* soundBuffer = &(gAudioEngineSoundBuffers[soundBufferIndex]);
-    std::lock_guard<std::recursive_mutex> lock(soundBuffer->mutex);
+    return true;
+}
 
-    if (!soundBuffer->active) {
+bool audioEngineSoundBufferPlay(int soundBufferIndex, unsigned int flags)
+{
+    AudioEngineSoundBuffer* soundBuffer = audioEngineGetActiveSoundBuffer(soundBufferIndex);
+    if (soundBuffer == NULL) {
         return false;
     }
 
-    soundBuffer->playing = true;
+    unsigned int control = soundBuffer->control.load();
+    unsigned int newControl;
+    do {
+        newControl = (control | AUDIO_ENGINE_CONTROL_PLAYING) + AUDIO_ENGINE_CONTROL_GENERATION;
 
-    if ((flags & AUDIO_ENGINE_SOUND_BUFFER_PLAY_LOOPING) != 0) {
-        soundBuffer->looping = true;
-    }
+        if ((flags & AUDIO_ENGINE_SOUND_BUFFER_PLAY_LOOPING) != 0) {
+            newControl |= AUDIO_ENGINE_CONTROL_LOOPING;
+        }
+    } while (!soundBuffer->control.compare_exchange_weak(control, newControl));
 
     return true;
 }
 
 bool audioEngineSoundBufferStop(int soundBufferIndex)
 {
-    if (!audioEngineIsInitialized()) {
+    AudioEngineSoundBuffer* soundBuffer = audioEngineGetActiveSoundBuffer(soundBufferIndex);
+    if (soundBuffer == NULL) {
         return false;
     }
 
-    if (!soundBufferIsValid(soundBufferIndex)) {
-        return false;
+    unsigned int control = soundBuffer->control.load();
+    while (!soundBuffer->control.compare_exchange_weak(control, (control & ~AUDIO_ENGINE_CONTROL_PLAYING) + AUDIO_ENGINE_CONTROL_GENERATION)) {
     }
 
-    AudioEngineSoundBuffer* soundBuffer = &(gAudioEngineSoundBuffers[soundBufferIndex]);
-    std::lock_guard<std::recursive_mutex> lock(soundBuffer->mutex);
-
-    if (!soundBuffer->active) {
-        return false;
-    }
-
-    soundBuffer->playing = false;
-
     return true;
 }
 
 bool audioEngineSoundBufferGetCurrentPosition(int soundBufferIndex, unsigned int* readPosPtr, unsigned int* writePosPtr)
 {
-    if (!audioEngineIsInitialized()) {
+    AudioEngineSoundBuffer* soundBuffer = audioEngineGetActiveSoundBuffer(soundBufferIndex);
+    if (soundBuffer == NULL) {
         return false;
     }
 
-    if (!soundBufferIsValid(soundBufferIndex)) {
-        return false;
-    }
-
-    AudioEngineSoundBuffer* soundBuffer = &(gAudioEngineSoundBuffers[soundBufferIndex]);
-    std::lock_guard<std::recursive_mutex> lock(soundBuffer->mutex);
-
-    if (!soundBuffer->active) {
-        return false;
+    // Seek not yet picked up by the audio callback.
+    unsigned int pos = soundBuffer->seekPos.load();
+    if (pos == AUDIO_ENGINE_NO_SEEK) {
+        pos = soundBuffer->pos.load();
     }
 
     if (readPosPtr != NULL) {
-        *readPosPtr = soundBuffer->pos;
+        *readPosPtr = pos;
     }
 
     if (writePosPtr != NULL) {
-        *writePosPtr = soundBuffer->pos;
+        *writePosPtr = pos;
 
-        if (soundBuffer->playing) {
+        if ((soundBuffer->control.load() & AUDIO_ENGINE_CONTROL_PLAYING) != 0) {
             // 15 ms lead
             // See: https://docs.microsoft.com/en-us/previous-versions/windows/desktop/mt708925(v=vs.85)#remarks
             *writePosPtr += soundBuffer->rate / 150;
@@ -351,40 +1121,26 @@ bool audioEngineSoundBufferGetCurrentPosition(int soundBufferIndex, unsigned int
 
 bool audioEngineSoundBufferSetCurrentPosition(int soundBufferIndex, unsigned int pos)
 {
-    if (!audioEngineIsInitialized()) {
+    AudioEngineSoundBuffer* soundBuffer = audioEngineGetActiveSoundBuffer(soundBufferIndex);
+    if (soundBuffer == NULL) {
         return false;
     }
 
-    if (!soundBufferIsValid(soundBufferIndex)) {
-        return false;
+    // Applied by the audio callback, which owns read position while mixing.
+    // Stopped buffers are not mixed, so it's stored directly as well.
+    pos %= soundBuffer->size;
+    soundBuffer->seekPos.store(pos);
+    if ((soundBuffer->control.load() & AUDIO_ENGINE_CONTROL_PLAYING) == 0) {
+        soundBuffer->pos.store(pos);
     }
 
-    AudioEngineSoundBuffer* soundBuffer = &(gAudioEngineSoundBuffers[soundBufferIndex]);
-    std::lock_guard<std::recursive_mutex> lock(soundBuffer->mutex);
-
-    if (!soundBuffer->active) {
-        return false;
-    }
-
-    soundBuffer->pos = pos % soundBuffer->size;
-
     return true;
 }
 
 bool audioEngineSoundBufferLock(int soundBufferIndex, unsigned int writePos, unsigned int writeBytes, void** audioPtr1, unsigned int* audioBytes1, void** audioPtr2, unsigned int* audioBytes2, unsigned int flags)
 {
-    if (!audioEngineIsInitialized()) {
-        return false;
-    }
-
-    if (!soundBufferIsValid(soundBufferIndex)) {
-        return false;
-    }
-
-    AudioEngineSoundBuffer* soundBuffer = &(gAudioEngineSoundBuffers[soundBufferIndex]);
-    std::lock_guard<std::recursive_mutex> lock(soundBuffer->mutex);
-
-    if (!soundBuffer->active) {
+    AudioEngineSoundBuffer* soundBuffer = audioEngineGetActiveSoundBuffer(soundBufferIndex);
+    if (soundBuffer == NULL) {
         return false;
     }
 
@@ -434,40 +1190,29 @@ bool audioEngineSoundBufferLock(int soundBufferIndex, unsigned int writePos, uns
 
 bool audioEngineSoundBufferUnlock(int soundBufferIndex, void* audioPtr1, unsigned int audioBytes1, void* audioPtr2, unsigned int audioBytes2)
 {
-    if (!audioEngineIsInitialized()) {
-        return false;
-    }
-
-    if (!soundBufferIsValid(soundBufferIndex)) {
+    AudioEngineSoundBuffer* soundBuffer = audioEngineGetActiveSoundBuffer(soundBufferIndex);
+    if (soundBuffer == NULL) {
         return false;
     }
 
-    AudioEngineSoundBuffer* soundBuffer = &(gAudioEngineSoundBuffers[soundBufferIndex]);
-    std::lock_guard<std::recursive_mutex> lock(soundBuffer->mutex);
-
-    if (!soundBuffer->active) {
-        return false;
+    // Publishes written samples to the audio callback.
+    unsigned int writePos;
+    if (audioPtr2 != NULL && audioBytes2 != 0) {
+        writePos = (unsigned int)((unsigned char*)audioPtr2 - (unsigned char*)soundBuffer->data) + audioBytes2;
+    } else if (audioPtr1 != NULL) {
+        writePos = (unsigned int)((unsigned char*)audioPtr1 - (unsigned char*)soundBuffer->data) + audioBytes1;
+    } else {
+        writePos = soundBuffer->writePos.load(std::memory_order_relaxed);
     }
-
-    // TODO: Mark range as unlocked.
+    soundBuffer->writePos.store(writePos % soundBuffer->size, std::memory_order_release);
 
     return true;
 }
 
 bool audioEngineSoundBufferGetStatus(int soundBufferIndex, unsigned int* statusPtr)
 {
-    if (!audioEngineIsInitialized()) {
-        return false;
-    }
-
-    if (!soundBufferIsValid(soundBufferIndex)) {
-        return false;
-    }
-
-    AudioEngineSoundBuffer* soundBuffer = &(gAudioEngineSoundBuffers[soundBufferIndex]);
-    std::lock_guard<std::recursive_mutex> lock(soundBuffer->mutex);
-
-    if (!soundBuffer->active) {
+    AudioEngineSoundBuffer* soundBuffer = audioEngineGetActiveSoundBuffer(soundBufferIndex);
+    if (soundBuffer == NULL) {
         return false;
     }
 
@@ -477,10 +1222,11 @@ bool audioEngineSoundBufferGetStatus(int soundBufferIndex, unsigned int* statusP
 
     *statusPtr = 0;
 
-    if (soundBuffer->playing) {
+    unsigned int control = soundBuffer->control.load();
+    if ((control & AUDIO_ENGINE_CONTROL_PLAYING) != 0) {
         *statusPtr |= AUDIO_ENGINE_SOUND_BUFFER_STATUS_PLAYING;
 
-        if (soundBuffer->looping) {
+        if ((control & AUDIO_ENGINE_CONTROL_LOOPING) != 0) {
             *statusPtr |= AUDIO_ENGINE_SOUND_BUFFER_STATUS_LOOPING;
         }
     }
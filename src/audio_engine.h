@@ -11,6 +11,21 @@ namespace fallout {
 #define AUDIO_ENGINE_SOUND_BUFFER_STATUS_PLAYING 0x00000001
 #define AUDIO_ENGINE_SOUND_BUFFER_STATUS_LOOPING 0x00000004
 
+// CE: Output backends, see `audioEngineSetBackend`.
+typedef enum AudioEngineBackend {
+    // Audio device opened with SDL.
+    AUDIO_ENGINE_BACKEND_SDL,
+
+    // No output, sound buffers advance on virtual clock.
+    AUDIO_ENGINE_BACKEND_NULL,
+
+    // Mixed output is written to WAV file, sound buffers advance on virtual
+    // clock.
+    AUDIO_ENGINE_BACKEND_WAV,
+} AudioEngineBackend;
+
+void audioEngineSetBackend(int backend, const char* capturePath);
+int audioEngineGetActiveBackend();
 bool audioEngineInit();
 void audioEngineExit();
 void audioEnginePause();
@@ -19,6 +34,8 @@ int audioEngineCreateSoundBuffer(unsigned int size, int bitsPerSample, int chann
 bool audioEngineSoundBufferRelease(int soundBufferIndex);
 bool audioEngineSoundBufferSetVolume(int soundBufferIndex, int volume);
 bool audioEngineSoundBufferGetVolume(int soundBufferIndex, int* volumePtr);
+bool audioEngineSoundBufferFade(int soundBufferIndex, int volume, unsigned int duration);
+bool audioEngineSoundBufferIsFading(int soundBufferIndex);
 bool audioEngineSoundBufferSetPan(int soundBufferIndex, int pan);
 bool audioEngineSoundBufferPlay(int soundBufferIndex, unsigned int flags);
 bool audioEngineSoundBufferStop(int soundBufferIndex);
@@ -27,6 +44,7 @@ bool audioEngineSoundBufferSetCurrentPosition(int soundBufferIndex, unsigned int
 bool audioEngineSoundBufferLock(int soundBufferIndex, unsigned int writePos, unsigned int writeBytes, void** audioPtr1, unsigned int* audioBytes1, void** audioPtr2, unsigned int* audioBytes2, unsigned int flags);
 bool audioEngineSoundBufferUnlock(int soundBufferIndex, void* audioPtr1, unsigned int audioBytes1, void* audioPtr2, unsigned int audioBytes2);
 bool audioEngineSoundBufferGetStatus(int soundBufferIndex, unsigned int* status);
+bool audioEngineMix(unsigned char* stream, int length);
 
 } // namespace fallout
 
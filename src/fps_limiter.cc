@@ -1,6 +1,7 @@
 #include "fps_limiter.h"
 
-#include <SDL.h>
+#include "plib/gnw/prof.h"
+#include "plib/gnw/vclock.h"
 
 namespace fallout {
 
@@ -12,14 +13,16 @@ FpsLimiter::FpsLimiter(unsigned int fps)
 
 void FpsLimiter::mark()
 {
-    _ticks = SDL_GetTicks();
+    // CE: Every loop marks its iteration start, which is a frame boundary
+    // for profiler.
+    prof_end_frame();
+
+    _ticks = vclock_now();
 }
 
 void FpsLimiter::throttle() const
 {
-    if (1000 / _fps > SDL_GetTicks() - _ticks) {
-        SDL_Delay(1000 / _fps - (SDL_GetTicks() - _ticks));
-    }
+    vclock_wait_frame(_ticks, 1000 / _fps);
 }
 
 } // namespace fallout
@@ -10,12 +10,14 @@
 #include "game/critter.h"
 #include "game/display.h"
 #include "game/game.h"
+#include "game/gdialog.h"
 #include "game/gconfig.h"
 #include "game/gmouse.h"
 #include "game/gsound.h"
 #include "game/intface.h"
 #include "game/item.h"
 #include "game/map.h"
+#include "game/mapmem.h"
 #include "game/object.h"
 #include "game/perk.h"
 #include "game/protinst.h"
@@ -51,10 +53,16 @@ static int can_talk_to(Object* a1, Object* a2);
 static int talk_to(Object* a1, Object* a2);
 static int report_dmg(Attack* attack, Object* a2);
 static int compute_dmg_damage(int min, int max, Object* obj, int* a4, int damage_type);
+static Attack* action_attack_alloc();
+static void action_attack_free(Attack* attack);
 
 // 0x4FEA50
 static bool action_in_explode = false;
 
+// CE: Attack contexts of explosions and scripted damage, which outlive the
+// call scheduling their animation.
+static MapMemPool action_attack_pool = MAPMEM_POOL_INIT(MAPMEM_ATTACKS, sizeof(Attack), 8);
+
 // 0x4FEA54
 unsigned int rotation = 0;
 
@@ -146,7 +154,7 @@ int action_blood(Object* obj, int anim, int delay)
 {
 
     int violence_level = VIOLENCE_LEVEL_MAXIMUM_BLOOD;
-    config_get_value(&game_config, GAME_CONFIG_PREFERENCES_KEY, GAME_CONFIG_VIOLENCE_LEVEL_KEY, &violence_level);
+    config_handle_get_value(&game_config_violence_level, &violence_level);
     if (violence_level == VIOLENCE_LEVEL_NONE) {
         return anim;
     }
@@ -177,7 +185,7 @@ static int pick_death(Object* attacker, Object* defender, int damage, int damage
     bool has_bloody_mess = false;
     int death_anim;
 
-    config_get_value(&game_config, GAME_CONFIG_PREFERENCES_KEY, GAME_CONFIG_VIOLENCE_LEVEL_KEY, &violence_level);
+    config_handle_get_value(&game_config_violence_level, &violence_level);
 
     if (defender->pid == 16777239 || defender->pid == 16777266 || defender->pid == 16777265) {
         return check_death(defender, ANIM_EXPLODED_TO_NOTHING, VIOLENCE_LEVEL_NORMAL, hit_from_front);
@@ -231,7 +239,7 @@ static int check_death(Object* obj, int anim, int min_violence_level, bool hit_f
     int fid;
     int violence_level = VIOLENCE_LEVEL_MAXIMUM_BLOOD;
 
-    config_get_value(&game_config, GAME_CONFIG_PREFERENCES_KEY, GAME_CONFIG_VIOLENCE_LEVEL_KEY, &violence_level);
+    config_handle_get_value(&game_config_violence_level, &violence_level);
     if (violence_level >= min_violence_level) {
         fid = art_id(OBJ_TYPE_CRITTER, obj->fid & 0xFFF, anim, (obj->fid & 0xF000) >> 12, obj->rotation + 1);
         if (art_exists(fid)) {
@@ -405,6 +413,7 @@ static int show_death(Object* obj, int anim)
 
     if (obj->pid != 16777266 && obj->pid != 16777265 && obj->pid != 16777224) {
         obj->flags |= OBJECT_NO_BLOCK;
+        obj_update_blocking(obj);
         if (obj_toggle_flat(obj, &temp_rect) == 0) {
             rect_min_bound(&dirty_rect, &temp_rect, &dirty_rect);
         }
@@ -1556,7 +1565,11 @@ int action_explode(int tile, int elevation, int minDamage, int maxDamage, Object
         return -2;
     }
 
-    Attack* attack = (Attack*)mem_malloc(sizeof(*attack));
+    // CE: Account what explosion allocates to combat.
+    MemTagScope memTagScope(MEM_TAG_COMBAT);
+    mem_count_tag_operation(MEM_TAG_COMBAT);
+
+    Attack* attack = action_attack_alloc();
     if (attack == NULL) {
         return -1;
     }
@@ -1564,7 +1577,7 @@ int action_explode(int tile, int elevation, int minDamage, int maxDamage, Object
     Object* explosion;
     int fid = art_id(OBJ_TYPE_MISC, 10, 0, 0, 0);
     if (obj_new(&explosion, fid, -1) == -1) {
-        mem_free(attack);
+        action_attack_free(attack);
         return -1;
     }
 
@@ -1582,7 +1595,7 @@ int action_explode(int tile, int elevation, int minDamage, int maxDamage, Object
             }
 
             obj_erase_object(explosion, NULL);
-            mem_free(attack);
+            action_attack_free(attack);
             return -1;
         }
 
@@ -1660,7 +1673,7 @@ int action_explode(int tile, int elevation, int minDamage, int maxDamage, Object
                 obj_erase_object(adjacentExplosions[rotation], NULL);
             }
 
-            mem_free(attack);
+            action_attack_free(attack);
 
             game_ui_enable();
             return -1;
@@ -1760,7 +1773,7 @@ static int report_explosion(Attack* attack, Object* a2)
         }
     }
 
-    mem_free(attack);
+    action_attack_free(attack);
     game_ui_enable();
 
     if (a2 == obj_dude) {
@@ -1810,6 +1823,9 @@ int action_talk_to(Object* a1, Object* a2)
         return -1;
     }
 
+    // CE: Load dialogue assets while the dude walks up to critter.
+    gdialog_prefetch(a2);
+
     int anim = FID_ANIM_TYPE(obj_dude->fid);
     if (anim == ANIM_WALK || anim == ANIM_RUNNING) {
         register_clear(obj_dude);
@@ -1861,14 +1877,18 @@ static int talk_to(Object* a1, Object* a2)
 // 0x41320C
 void action_dmg(int tile, int elevation, int minDamage, int maxDamage, int damageType, bool animated, bool bypassArmor)
 {
-    Attack* attack = (Attack*)mem_malloc(sizeof(*attack));
+    // CE: Account what damage allocates to combat.
+    MemTagScope memTagScope(MEM_TAG_COMBAT);
+    mem_count_tag_operation(MEM_TAG_COMBAT);
+
+    Attack* attack = action_attack_alloc();
     if (attack == NULL) {
         return;
     }
 
     Object* attacker;
     if (obj_new(&attacker, FID_0x20001F5, -1) == -1) {
-        mem_free(attack);
+        action_attack_free(attack);
         return;
     }
 
@@ -1908,7 +1928,7 @@ void action_dmg(int tile, int elevation, int minDamage, int maxDamage, int damag
 
         if (register_end() == -1) {
             obj_erase_object(attacker, NULL);
-            mem_free(attack);
+            action_attack_free(attack);
             return;
         }
     } else {
@@ -1932,11 +1952,22 @@ static int report_dmg(Attack* attack, Object* a2)
 {
     combat_display(attack);
     apply_damage(attack, false);
-    mem_free(attack);
+    action_attack_free(attack);
     game_ui_enable();
     return 0;
 }
 
+// CE: Takes attack context from pool instead of heap.
+static Attack* action_attack_alloc()
+{
+    return (Attack*)mapmem_pool_alloc(&action_attack_pool);
+}
+
+static void action_attack_free(Attack* attack)
+{
+    mapmem_pool_free(&action_attack_pool, attack);
+}
+
 // Calculate damage by applying threshold and resistances.
 //
 // 0x4133D8
@@ -1,8 +1,11 @@
 #include "game/anim.h"
 
+#include <limits.h>
 #include <stdio.h>
 #include <string.h>
 
+#include <SDL.h>
+
 #include "game/art.h"
 #include "game/combat.h"
 #include "game/combat_defs.h"
@@ -17,30 +20,54 @@
 #include "game/item.h"
 #include "game/map.h"
 #include "game/object.h"
+#include "game/pathgraph.h"
 #include "game/perk.h"
 #include "game/protinst.h"
 #include "game/proto.h"
 #include "game/roll.h"
 #include "game/scripts.h"
 #include "game/stat.h"
+#include "game/statever.h"
 #include "game/textobj.h"
 #include "game/tile.h"
 #include "game/trait.h"
 #include "plib/color/color.h"
 #include "plib/gnw/debug.h"
 #include "plib/gnw/input.h"
+#include "plib/gnw/prof.h"
 #include "plib/gnw/rect.h"
 #include "plib/gnw/svga.h"
 #include "plib/gnw/vcr.h"
 
 namespace fallout {
 
-#define ANIMATION_SEQUENCE_LIST_CAPACITY 21
+// CE: Original capacities were 21 sequences and 16 sads, which crowded
+// scenes (large fights, many fidgeting critters) run out of.
+#define ANIMATION_SEQUENCE_LIST_CAPACITY 32
 #define ANIMATION_DESCRIPTION_LIST_CAPACITY 40
-#define ANIMATION_SAD_LIST_CAPACITY 16
+#define ANIMATION_SAD_LIST_CAPACITY 32
+
+// CE: Number of sequence slots reserved animations can always claim
+// (original code hardcoded 13 out of 21 for unreserved ones).
+#define ANIMATION_SEQUENCE_RESERVED_SLOTS 8
+
+static_assert(ANIMATION_SEQUENCE_LIST_CAPACITY <= 32, "active sequences are tracked in 32-bit mask");
 
 #define ANIMATION_SEQUENCE_FORCED 0x01
 
+// CE: Number of cached `make_path_func` results.
+#define PATH_CACHE_CAPACITY 16
+
+// CE: Maximum length of path built by `make_path_func`.
+#define PATH_MAX_LENGTH 800
+
+// CE: Number of memoized blocker lookups per callback (power of two).
+#define STRAIGHT_PATH_MEMO_SIZE 2048
+
+// CE: Maximum number of frames `anim_fast_forward` plays, guards against
+// animations which never reach their end.
+#define ANIM_FAST_FORWARD_MAX_FRAMES 10000
+
 typedef enum AnimationKind {
     ANIM_KIND_MOVE_TO_OBJECT = 0,
     ANIM_KIND_MOVE_TO_TILE = 1,
@@ -227,6 +254,12 @@ typedef struct PathNode {
 
 // TODO: I don't know what `sad` means, but it's definitely better than
 // `STRUCT_530014`. Find a better name.
+// CE: Path of the move animation, previously embedded in `AnimationSad`.
+typedef union AnimationSadPath {
+    unsigned char rotations[3200];
+    StraightPathNode field_28[200];
+} AnimationSadPath;
+
 typedef struct AnimationSad {
     unsigned int flags;
     Object* obj;
@@ -244,12 +277,44 @@ typedef struct AnimationSad {
     int field_1C; // length of field_28
     int field_20; // current index in field_28
     int field_24;
-    union {
-        unsigned char rotations[3200];
-        StraightPathNode field_28[200];
-    };
+
+    // CE: Path storage lives in `sad_paths` so that compacting sad list only
+    // moves the header (see `object_anim_compact`).
+    AnimationSadPath* path;
 } AnimationSad;
 
+// CE: Result of `make_path_func`, valid as long as blocking epoch has not
+// changed (see `obj_blocking_epoch`).
+typedef struct PathCacheEntry {
+    Object* object;
+    PathBuilderCallback* callback;
+    unsigned int epoch;
+    unsigned int lastUsed;
+    int from;
+    int to;
+    int elevation;
+    bool checkTarget;
+    bool inCombat;
+    int length;
+    unsigned char rotations[PATH_MAX_LENGTH];
+} PathCacheEntry;
+
+// CE: Result of blocker lookup made by `make_straight_path_func`.
+typedef struct StraightPathMemoEntry {
+    int tile;
+    int elevation;
+    unsigned int generation;
+
+    // Blocker found without excluding any object.
+    Object* obstacle;
+} StraightPathMemoEntry;
+
+typedef enum StraightPathMemoKind {
+    STRAIGHT_PATH_MEMO_BLOCKING,
+    STRAIGHT_PATH_MEMO_SIGHT,
+    STRAIGHT_PATH_MEMO_KIND_COUNT,
+} StraightPathMemoKind;
+
 static int anim_free_slot(int a1);
 static int anim_preload(Object* object, int fid, CacheEntry** cacheEntryPtr);
 static void anim_cleanup();
@@ -257,6 +322,19 @@ static int anim_set_check(int a1);
 static int anim_set_continue(int a1, int a2);
 static int anim_set_end(int a1);
 static bool anim_can_use_door(Object* critter, Object* door);
+static bool path_open_less(int slot1, int slot2);
+static void path_open_push(int* length, int slot);
+static int path_open_pop(int* length);
+static void path_free_push(int* length, int slot);
+static int path_free_pop(int* length);
+static int make_path_build(Object* object, int from, int to, unsigned char* rotations, int a5, PathBuilderCallback* callback);
+static int make_path_search(Object* object, int from, int to, unsigned char* rotations, int a5, PathBuilderCallback* callback);
+static int make_path_hierarchical(Object* object, int from, int to, unsigned char* rotations, PathBuilderCallback* callback);
+static PathCacheEntry* path_cache_find(Object* object, int from, int to, int a5, PathBuilderCallback* callback, bool inCombat, unsigned int epoch);
+static PathCacheEntry* path_cache_reserve(unsigned int epoch);
+static Object* straight_path_memo_lookup(int kind, PathBuilderCallback* callback, Object* a1, int tile, int elevation);
+static Object* straight_path_memo_blocking_at(Object* a1, int tile, int elevation);
+static Object* straight_path_memo_sight_blocking_at(Object* a1, int tile, int elevation);
 static int anim_move_to_object(Object* from, Object* to, int a3, int anim, int animationSequenceIndex);
 static int make_stair_path(Object* object, int from, int fromElevation, int to, int toElevation, StraightPathNode* a6, Object** obstaclePtr);
 static int anim_move_to_tile(Object* obj, int tile_num, int elev, int a4, int anim, int animationSequenceIndex);
@@ -287,27 +365,89 @@ static bool anim_in_bk = false;
 // 0x540014
 static AnimationSad sad[ANIMATION_SAD_LIST_CAPACITY];
 
-// 0x5566D4
-static PathNode dad[2000];
+// CE: Path storage of sad entries. Every entry of `sad` always points to a
+// distinct element, compaction swaps pointers instead of copying paths.
+static AnimationSadPath sad_paths[ANIMATION_SAD_LIST_CAPACITY];
+
 
 // 0x560314
 static AnimationSequence anim_set[ANIMATION_SEQUENCE_LIST_CAPACITY];
 
+// CE: Bit per sequence which has been registered and not yet ended (its
+// `field_0` is not -1000). Lets owner lookups skip idle slots.
+static unsigned int anim_set_active = 0;
+
 // 0x56A1E4
 static unsigned char seen[5000];
 
 // 0x54CA94
 static PathNode child[2000];
 
+// CE: Slots of open nodes in `child` as binary min-heap ordered by total
+// cost, then slot index (see `path_open_less`).
+static int path_open_heap[2000];
+
+// CE: Free slots in `child` as binary min-heap.
+static int path_free_slots[2000];
+
+// CE: Parent tile and rotation of every closed tile, replaces closed node
+// list (`dad`).
+static int path_from[HEX_GRID_SIZE];
+static unsigned char path_rotation[HEX_GRID_SIZE];
+
+// CE: Recently built paths, see `make_path_func`.
+static PathCacheEntry path_cache[PATH_CACHE_CAPACITY];
+static bool path_cache_enabled = false;
+static unsigned int path_cache_clock = 0;
+static CacheStats path_cache_stats;
+static Uint64 path_cache_search_ticks = 0;
+
+// CE: Number of nodes taken from open list by all path searches, used by
+// benchmarks to compare search effort.
+static unsigned int path_nodes_expanded = 0;
+
+// CE: Number of path requests (cached or not).
+static unsigned int path_requests = 0;
+
+// CE: Blocker lookups made by straight paths, valid while blocking epoch
+// stays the same. Consecutive lines from/to the same spot (line of fire
+// checks of every hit location, explosions, bursts) walk the same hexes.
+static StraightPathMemoEntry straight_path_memo[STRAIGHT_PATH_MEMO_KIND_COUNT][STRAIGHT_PATH_MEMO_SIZE];
+static unsigned int straight_path_memo_generation = 1;
+static unsigned int straight_path_memo_epoch = 0;
+
+// CE: Set while `anim_fast_forward` runs, frames are advanced regardless of
+// their time.
+static bool anim_fast_forwarding = false;
+
 // 0x56B56C
 static int curr_anim_counter;
 
+// 0x4FEAAC
+static unsigned int dude_fidget_last_time = 0;
+
+// 0x4FEAB0
+static unsigned int dude_fidget_next_time = 0;
+
 // 0x4134B0
 void anim_init()
 {
     anim_in_init = true;
     anim_reset();
     anim_in_init = false;
+
+    int pathCache;
+    if (config_get_value(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_PATH_CACHE_KEY, &pathCache)) {
+        path_cache_enabled = pathCache != 0;
+    } else {
+        path_cache_enabled = false;
+    }
+
+    memset(path_cache, 0, sizeof(path_cache));
+    memset(&path_cache_stats, 0, sizeof(path_cache_stats));
+    path_cache_search_ticks = 0;
+
+    pathgraph_init();
 }
 
 // 0x4134D0
@@ -327,6 +467,12 @@ void anim_reset()
         anim_set[index].field_0 = -1000;
         anim_set[index].flags = 0;
     }
+
+    anim_set_active = 0;
+
+    for (index = 0; index < ANIMATION_SAD_LIST_CAPACITY; index++) {
+        sad[index].path = &(sad_paths[index]);
+    }
 }
 
 // 0x413548
@@ -334,6 +480,8 @@ void anim_exit()
 {
     // NOTE: Uninline.
     anim_stop();
+
+    pathgraph_exit();
 }
 
 // 0x413584
@@ -396,7 +544,7 @@ static int anim_free_slot(int requestOptions)
         }
 
         return -1;
-    } else if ((requestOptions & ANIMATION_REQUEST_RESERVED) != 0 || v2 < 13) {
+    } else if ((requestOptions & ANIMATION_REQUEST_RESERVED) != 0 || v2 < ANIMATION_SEQUENCE_LIST_CAPACITY - ANIMATION_SEQUENCE_RESERVED_SLOTS) {
         return v1;
     }
 
@@ -423,11 +571,12 @@ int register_priority(int a1)
 int register_clear(Object* a1)
 {
     for (int animationSequenceIndex = 0; animationSequenceIndex < ANIMATION_SEQUENCE_LIST_CAPACITY; animationSequenceIndex++) {
-        AnimationSequence* animationSequence = &(anim_set[animationSequenceIndex]);
-        if (animationSequence->field_0 == -1000) {
+        if ((anim_set_active & (1u << animationSequenceIndex)) == 0) {
             continue;
         }
 
+        AnimationSequence* animationSequence = &(anim_set[animationSequenceIndex]);
+
         int animationDescriptionIndex;
         for (animationDescriptionIndex = 0; animationDescriptionIndex < animationSequence->length; animationDescriptionIndex++) {
             AnimationDescription* animationDescription = &(animationSequence->animations[animationDescriptionIndex]);
@@ -463,6 +612,7 @@ int register_end()
 
     AnimationSequence* animationSequence = &(anim_set[curr_anim_set]);
     animationSequence->field_0 = 0;
+    anim_set_active |= 1u << curr_anim_set;
     animationSequence->length = curr_anim_counter;
     animationSequence->animationIndex = -1;
     animationSequence->flags &= ~ANIM_SEQ_ACCUMULATING;
@@ -487,13 +637,15 @@ static int anim_preload(Object* object, int fid, CacheEntry** cacheEntryPtr)
 {
     *cacheEntryPtr = NULL;
 
-    if (art_ptr_lock(fid, cacheEntryPtr) != NULL) {
-        art_ptr_unlock(*cacheEntryPtr);
-        *cacheEntryPtr = NULL;
-        return 0;
+    // CE: Original code locks (and unlocks) art to load it into cache. Now
+    // it's loaded in background, only its existence is checked here.
+    if (!art_exists(fid)) {
+        return -1;
     }
 
-    return -1;
+    art_preload(&fid, 1);
+
+    return 0;
 }
 
 // 0x413878
@@ -538,9 +690,13 @@ int check_registry(Object* obj)
     }
 
     for (int animationSequenceIndex = 0; animationSequenceIndex < ANIMATION_SEQUENCE_LIST_CAPACITY; animationSequenceIndex++) {
+        if ((anim_set_active & (1u << animationSequenceIndex)) == 0) {
+            continue;
+        }
+
         AnimationSequence* animationSequence = &(anim_set[animationSequenceIndex]);
 
-        if (animationSequenceIndex != curr_anim_set && animationSequence->field_0 != -1000) {
+        if (animationSequenceIndex != curr_anim_set) {
             for (int animationDescriptionIndex = 0; animationDescriptionIndex < animationSequence->length; animationDescriptionIndex++) {
                 AnimationDescription* animationDescription = &(animationSequence->animations[animationDescriptionIndex]);
                 if (obj == animationDescription->owner && animationDescription->kind != 11) {
@@ -567,8 +723,12 @@ int anim_busy(Object* a1)
     }
 
     for (int animationSequenceIndex = 0; animationSequenceIndex < ANIMATION_SEQUENCE_LIST_CAPACITY; animationSequenceIndex++) {
+        if ((anim_set_active & (1u << animationSequenceIndex)) == 0) {
+            continue;
+        }
+
         AnimationSequence* animationSequence = &(anim_set[animationSequenceIndex]);
-        if (animationSequenceIndex != curr_anim_set && animationSequence->field_0 != -1000) {
+        if (animationSequenceIndex != curr_anim_set) {
             for (int animationDescriptionIndex = 0; animationDescriptionIndex < animationSequence->length; animationDescriptionIndex++) {
                 AnimationDescription* animationDescription = &(animationSequence->animations[animationDescriptionIndex]);
                 if (a1 != animationDescription->owner) {
@@ -1338,7 +1498,8 @@ int register_object_play_sfx(Object* owner, const char* soundEffectName, int del
     AnimationDescription* animationDescription = &(animationSequence->animations[curr_anim_counter]);
     animationDescription->kind = ANIM_KIND_CALLBACK;
     animationDescription->owner = owner;
-    if (soundEffectName != NULL) {
+    // CE: Fast combat plays no sounds.
+    if (soundEffectName != NULL && !(isInCombat() && combat_is_fast_mode())) {
         int volume = gsound_compute_relative_volume(owner);
         animationDescription->param1 = gsound_load_sound_volume(soundEffectName, owner, volume);
         if (animationDescription->param1 != NULL) {
@@ -1517,6 +1678,7 @@ static int anim_set_check(int animationSequenceIndex)
                 }
             } else {
                 animationDescription->owner->flags |= animationDescription->objectFlag;
+                obj_update_blocking(animationDescription->owner);
             }
 
             rc = anim_set_continue(animationSequenceIndex, 0);
@@ -1532,6 +1694,7 @@ static int anim_set_check(int animationSequenceIndex)
                 }
             } else {
                 animationDescription->owner->flags &= ~animationDescription->objectFlag;
+                obj_update_blocking(animationDescription->owner);
             }
 
             rc = anim_set_continue(animationSequenceIndex, 0);
@@ -1711,6 +1874,7 @@ static int anim_set_end(int animationSequenceIndex)
 
     animationSequence->animationIndex = -1;
     animationSequence->field_0 = -1000;
+    anim_set_active &= ~(1u << animationSequenceIndex);
     if ((animationSequence->flags & ANIM_SEQ_COMBAT_ANIM_STARTED) != 0) {
         combat_anim_finished();
     }
@@ -1770,6 +1934,100 @@ int make_path(Object* object, int from, int to, unsigned char* rotations, int a5
 
 // 0x4159E8
 int make_path_func(Object* object, int from, int to, unsigned char* rotations, int a5, PathBuilderCallback* callback)
+{
+    path_requests++;
+
+    // CE: Combat AI builds the same paths many times per turn. Results of
+    // known callbacks depend on blocking state only, so they are reused
+    // until any blocker changes.
+    if (!path_cache_enabled
+        || (callback != obj_blocking_at && callback != obj_sight_blocking_at)) {
+        return make_path_build(object, from, to, rotations, a5, callback);
+    }
+
+    unsigned int epoch = obj_blocking_epoch();
+    bool inCombat = isInCombat();
+
+    PathCacheEntry* entry = path_cache_find(object, from, to, a5, callback, inCombat, epoch);
+    if (entry != NULL) {
+        path_cache_stats.hits++;
+    } else {
+        path_cache_stats.misses++;
+        path_cache_stats.reads++;
+
+        Uint64 searchStart = SDL_GetPerformanceCounter();
+
+        entry = path_cache_reserve(epoch);
+        entry->object = object;
+        entry->callback = callback;
+        entry->from = from;
+        entry->to = to;
+        entry->elevation = object->elevation;
+        entry->checkTarget = a5 != 0;
+        entry->inCombat = inCombat;
+        entry->length = make_path_build(object, from, to, entry->rotations, a5, callback);
+
+        path_cache_search_ticks += SDL_GetPerformanceCounter() - searchStart;
+    }
+
+    entry->lastUsed = ++path_cache_clock;
+
+    if (rotations != NULL) {
+        memcpy(rotations, entry->rotations, entry->length);
+    }
+
+    return entry->length;
+}
+
+// CE: Builds path, falling back to coarse route when regular search gives up
+// (it is limited to 2000 nodes, which is not enough for long paths on large
+// maps).
+static int make_path_build(Object* object, int from, int to, unsigned char* rotations, int a5, PathBuilderCallback* callback)
+{
+    int length = make_path_search(object, from, to, rotations, a5, callback);
+    if (length != 0 || from == to || callback != obj_blocking_at || !pathgraph_enabled()) {
+        return length;
+    }
+
+    if (a5 && callback(object, to, object->elevation) != NULL) {
+        return 0;
+    }
+
+    return make_path_hierarchical(object, from, to, rotations, callback);
+}
+
+// CE: Builds path along coarse route found in path graph. Every leg between
+// consecutive waypoints is short, so it is refined with regular search.
+static int make_path_hierarchical(Object* object, int from, int to, unsigned char* rotations, PathBuilderCallback* callback)
+{
+    int waypoints[PATH_MAX_LENGTH];
+    int waypointsLength = pathgraph_find_route(from, to, object->elevation, (object->flags & OBJECT_MULTIHEX) != 0, waypoints, PATH_MAX_LENGTH);
+    if (waypointsLength == 0) {
+        return 0;
+    }
+
+    unsigned char leg[PATH_MAX_LENGTH];
+    int length = 0;
+    int tile = from;
+    for (int index = 0; index < waypointsLength; index++) {
+        int legLength = make_path_search(object, tile, waypoints[index], leg, 0, callback);
+        if (legLength == 0 || length + legLength > PATH_MAX_LENGTH) {
+            return 0;
+        }
+
+        if (rotations != NULL) {
+            memcpy(rotations + length, leg, legLength);
+        }
+
+        length += legLength;
+        tile = waypoints[index];
+    }
+
+    return length;
+}
+
+// CE: Builds path with A* (extracted from `make_path_func`).
+static int make_path_search(Object* object, int from, int to, unsigned char* rotations, int a5, PathBuilderCallback* callback)
 {
     if (a5) {
         if (callback(object, to, object->elevation) != NULL) {
@@ -1789,8 +2047,18 @@ int make_path_func(Object* object, int from, int to, unsigned char* rotations, i
     child[0].field_C = EST(from, to);
     child[0].field_10 = 0;
 
+    // CE: Lowest cost node and lowest free slot were found by scanning
+    // `child`, heaps give the same nodes and slots (ties are broken by slot
+    // index), so paths are identical.
+    int openHeapLength = 0;
+    path_open_push(&openHeapLength, 0);
+
+    int freeSlotsLength = 0;
     for (int index = 1; index < 2000; index += 1) {
         child[index].tile = -1;
+
+        // NOTE: Ascending slots form a valid heap.
+        path_free_slots[freeSlotsLength++] = index;
     }
 
     int toScreenX;
@@ -1802,20 +2070,8 @@ int make_path_func(Object* object, int from, int to, unsigned char* rotations, i
     PathNode temp;
 
     while (1) {
-        int v63 = -1;
-
-        PathNode* prev = NULL;
-        int v12 = 0;
-        for (int index = 0; v12 < openPathNodeListLength; index += 1) {
-            PathNode* curr = &(child[index]);
-            if (curr->tile != -1) {
-                v12++;
-                if (v63 == -1 || (curr->field_C + curr->field_10) < (prev->field_C + prev->field_10)) {
-                    prev = curr;
-                    v63 = index;
-                }
-            }
-        }
+        int v63 = path_open_pop(&openHeapLength);
+        path_nodes_expanded++;
 
         PathNode* curr = &(child[v63]);
 
@@ -1824,6 +2080,7 @@ int make_path_func(Object* object, int from, int to, unsigned char* rotations, i
         openPathNodeListLength -= 1;
 
         curr->tile = -1;
+        path_free_push(&freeSlotsLength, v63);
 
         if (temp.tile == to) {
             if (openPathNodeListLength == 0) {
@@ -1832,8 +2089,8 @@ int make_path_func(Object* object, int from, int to, unsigned char* rotations, i
             break;
         }
 
-        PathNode* curr1 = &(dad[closedPathNodeListLength]);
-        memcpy(curr1, &temp, sizeof(temp));
+        path_from[temp.tile] = temp.from;
+        path_rotation[temp.tile] = temp.rotation & 0xFF;
 
         closedPathNodeListLength += 1;
 
@@ -1857,19 +2114,14 @@ int make_path_func(Object* object, int from, int to, unsigned char* rotations, i
                 }
             }
 
-            int v25 = 0;
-            for (; v25 < 2000; v25++) {
-                if (child[v25].tile == -1) {
-                    break;
-                }
-            }
-
             openPathNodeListLength += 1;
 
             if (openPathNodeListLength == 2000) {
                 return 0;
             }
 
+            int v25 = path_free_pop(&freeSlotsLength);
+
             seen[tile / 8] |= bit;
 
             PathNode* v27 = &(child[v25]);
@@ -1887,6 +2139,8 @@ int make_path_func(Object* object, int from, int to, unsigned char* rotations, i
             if (isNotInCombat && temp.rotation != rotation) {
                 v27->field_10 += 10;
             }
+
+            path_open_push(&openHeapLength, v25);
         }
 
         if (openPathNodeListLength == 0) {
@@ -1897,7 +2151,7 @@ int make_path_func(Object* object, int from, int to, unsigned char* rotations, i
     if (openPathNodeListLength != 0) {
         unsigned char* v39 = rotations;
         int index = 0;
-        for (; index < 800; index++) {
+        for (; index < PATH_MAX_LENGTH; index++) {
             if (temp.tile == from) {
                 break;
             }
@@ -1907,13 +2161,11 @@ int make_path_func(Object* object, int from, int to, unsigned char* rotations, i
                 v39 += 1;
             }
 
-            int j = 0;
-            while (dad[j].tile != temp.from) {
-                j++;
-            }
-
-            PathNode* v36 = &(dad[j]);
-            memcpy(&temp, v36, sizeof(temp));
+            // CE: Parent is looked up by tile instead of scanning closed
+            // nodes.
+            temp.tile = temp.from;
+            temp.from = path_from[temp.tile];
+            temp.rotation = path_rotation[temp.tile];
         }
 
         if (rotations != NULL) {
@@ -1938,6 +2190,247 @@ int make_path_func(Object* object, int from, int to, unsigned char* rotations, i
     return 0;
 }
 
+// CE: Returns `callback(a1, tile, elevation)` using memoized lookups.
+//
+// Both known callbacks return first matching object in hex's list which is
+// not `a1`. So lookup made without excluding any object gives the same
+// result for any `a1`, unless it is `a1` itself.
+static Object* straight_path_memo_lookup(int kind, PathBuilderCallback* callback, Object* a1, int tile, int elevation)
+{
+    if (!hexGridTileIsValid(tile)) {
+        return callback(a1, tile, elevation);
+    }
+
+    unsigned int epoch = obj_blocking_epoch();
+    if (epoch != straight_path_memo_epoch) {
+        straight_path_memo_epoch = epoch;
+        straight_path_memo_generation++;
+    }
+
+    StraightPathMemoEntry* entry = &(straight_path_memo[kind][tile & (STRAIGHT_PATH_MEMO_SIZE - 1)]);
+    if (entry->generation != straight_path_memo_generation
+        || entry->tile != tile
+        || entry->elevation != elevation) {
+        entry->generation = straight_path_memo_generation;
+        entry->tile = tile;
+        entry->elevation = elevation;
+        entry->obstacle = callback(NULL, tile, elevation);
+    }
+
+    if (entry->obstacle != NULL && entry->obstacle == a1) {
+        return callback(a1, tile, elevation);
+    }
+
+    return entry->obstacle;
+}
+
+static Object* straight_path_memo_blocking_at(Object* a1, int tile, int elevation)
+{
+    return straight_path_memo_lookup(STRAIGHT_PATH_MEMO_BLOCKING, obj_blocking_at, a1, tile, elevation);
+}
+
+static Object* straight_path_memo_sight_blocking_at(Object* a1, int tile, int elevation)
+{
+    return straight_path_memo_lookup(STRAIGHT_PATH_MEMO_SIGHT, obj_sight_blocking_at, a1, tile, elevation);
+}
+
+// CE: Returns cached path matching given arguments, or `NULL`.
+static PathCacheEntry* path_cache_find(Object* object, int from, int to, int a5, PathBuilderCallback* callback, bool inCombat, unsigned int epoch)
+{
+    for (int index = 0; index < PATH_CACHE_CAPACITY; index++) {
+        PathCacheEntry* entry = &(path_cache[index]);
+        if (entry->lastUsed != 0
+            && entry->epoch == epoch
+            && entry->object == object
+            && entry->from == from
+            && entry->to == to
+            && entry->elevation == object->elevation
+            && entry->callback == callback
+            && entry->checkTarget == (a5 != 0)
+            && entry->inCombat == inCombat) {
+            return entry;
+        }
+    }
+
+    return NULL;
+}
+
+// CE: Returns entry to store new path in. Entries of past epochs are reused
+// first, then least recently used one.
+static PathCacheEntry* path_cache_reserve(unsigned int epoch)
+{
+    PathCacheEntry* candidate = NULL;
+    for (int index = 0; index < PATH_CACHE_CAPACITY; index++) {
+        PathCacheEntry* entry = &(path_cache[index]);
+        if (entry->lastUsed == 0 || entry->epoch != epoch) {
+            candidate = entry;
+            break;
+        }
+
+        if (candidate == NULL || entry->lastUsed < candidate->lastUsed) {
+            candidate = entry;
+        }
+    }
+
+    if (candidate->lastUsed != 0 && candidate->epoch == epoch) {
+        path_cache_stats.evictions++;
+    }
+
+    candidate->epoch = epoch;
+    candidate->lastUsed = 0;
+
+    return candidate;
+}
+
+// CE: Returns total number of nodes expanded by path searches.
+unsigned int anim_path_nodes_expanded()
+{
+    return path_nodes_expanded;
+}
+
+// CE: Returns total number of path requests, including ones served from
+// path cache.
+unsigned int anim_path_requests()
+{
+    return path_requests;
+}
+
+// CE: Fills path cache statistics. Only entries built since last blocking
+// change are reported as resident.
+bool anim_get_path_cache_stats(CacheStats* stats)
+{
+    if (stats == NULL || !path_cache_enabled) {
+        return false;
+    }
+
+    *stats = path_cache_stats;
+
+    unsigned int epoch = obj_blocking_epoch();
+    for (int index = 0; index < PATH_CACHE_CAPACITY; index++) {
+        if (path_cache[index].lastUsed != 0 && path_cache[index].epoch == epoch) {
+            stats->entries++;
+        }
+    }
+
+    stats->size = stats->entries * (int)sizeof(PathCacheEntry);
+    stats->maxSize = (int)sizeof(path_cache);
+    stats->averageEntrySize = stats->entries != 0 ? stats->size / stats->entries : 0;
+    stats->readTime = (double)path_cache_search_ticks * 1000.0 / (double)SDL_GetPerformanceFrequency();
+
+    return true;
+}
+
+// CE: Returns `true` if open node in `slot1` should be expanded before node
+// in `slot2`.
+static bool path_open_less(int slot1, int slot2)
+{
+    int cost1 = child[slot1].field_C + child[slot1].field_10;
+    int cost2 = child[slot2].field_C + child[slot2].field_10;
+    if (cost1 != cost2) {
+        return cost1 < cost2;
+    }
+
+    return slot1 < slot2;
+}
+
+// CE: Adds slot to open node heap.
+static void path_open_push(int* length, int slot)
+{
+    int index = (*length)++;
+    while (index > 0) {
+        int parent = (index - 1) / 2;
+        if (!path_open_less(slot, path_open_heap[parent])) {
+            break;
+        }
+
+        path_open_heap[index] = path_open_heap[parent];
+        index = parent;
+    }
+
+    path_open_heap[index] = slot;
+}
+
+// CE: Removes and returns slot of lowest cost open node.
+static int path_open_pop(int* length)
+{
+    int top = path_open_heap[0];
+    int slot = path_open_heap[--(*length)];
+
+    int index = 0;
+    while (true) {
+        int next = index * 2 + 1;
+        if (next >= *length) {
+            break;
+        }
+
+        if (next + 1 < *length && path_open_less(path_open_heap[next + 1], path_open_heap[next])) {
+            next++;
+        }
+
+        if (!path_open_less(path_open_heap[next], slot)) {
+            break;
+        }
+
+        path_open_heap[index] = path_open_heap[next];
+        index = next;
+    }
+
+    if (*length != 0) {
+        path_open_heap[index] = slot;
+    }
+
+    return top;
+}
+
+// CE: Adds slot to free slot heap.
+static void path_free_push(int* length, int slot)
+{
+    int index = (*length)++;
+    while (index > 0) {
+        int parent = (index - 1) / 2;
+        if (path_free_slots[parent] < slot) {
+            break;
+        }
+
+        path_free_slots[index] = path_free_slots[parent];
+        index = parent;
+    }
+
+    path_free_slots[index] = slot;
+}
+
+// CE: Removes and returns lowest free slot.
+static int path_free_pop(int* length)
+{
+    int top = path_free_slots[0];
+    int slot = path_free_slots[--(*length)];
+
+    int index = 0;
+    while (true) {
+        int next = index * 2 + 1;
+        if (next >= *length) {
+            break;
+        }
+
+        if (next + 1 < *length && path_free_slots[next + 1] < path_free_slots[next]) {
+            next++;
+        }
+
+        if (path_free_slots[next] > slot) {
+            break;
+        }
+
+        path_free_slots[index] = path_free_slots[next];
+        index = next;
+    }
+
+    if (*length != 0) {
+        path_free_slots[index] = slot;
+    }
+
+    return top;
+}
+
 // 0x415D9C
 int idist(int x1, int y1, int x2, int y2)
 {
@@ -1981,6 +2474,13 @@ int make_straight_path(Object* a1, int from, int to, StraightPathNode* pathNodes
 // 0x415E28
 int make_straight_path_func(Object* a1, int from, int to, StraightPathNode* pathNodes, Object** a5, int a6, PathBuilderCallback* callback)
 {
+    // CE: Reuse blocker lookups of known callbacks.
+    if (callback == obj_blocking_at) {
+        callback = straight_path_memo_blocking_at;
+    } else if (callback == obj_sight_blocking_at) {
+        callback = straight_path_memo_sight_blocking_at;
+    }
+
     if (a5 != NULL) {
         Object* v11 = callback(a1, from, a1->elevation);
         if (v11 != NULL) {
@@ -2170,11 +2670,13 @@ static int anim_move_to_object(Object* from, Object* to, int a3, int anim, int a
 {
     bool hidden = (to->flags & OBJECT_HIDDEN);
     to->flags |= OBJECT_HIDDEN;
+    obj_update_blocking(to);
 
     int moveSadIndex = anim_move(from, to->tile, to->elevation, -1, anim, 0, animationSequenceIndex);
 
     if (!hidden) {
         to->flags &= ~OBJECT_HIDDEN;
+        obj_update_blocking(to);
     }
 
     if (moveSadIndex == -1) {
@@ -2192,10 +2694,10 @@ static int anim_move_to_object(Object* from, Object* to, int a3, int anim, int a
         anim_set_continue(animationSequenceIndex, 0);
     }
 
-    sad_entry->field_24 = tile_num_in_direction(to->tile, sad_entry->rotations[isMultihex ? sad_entry->field_1C + 1 : sad_entry->field_1C], 1);
+    sad_entry->field_24 = tile_num_in_direction(to->tile, sad_entry->path->rotations[isMultihex ? sad_entry->field_1C + 1 : sad_entry->field_1C], 1);
 
     if (isMultihex) {
-        sad_entry->field_24 = tile_num_in_direction(sad_entry->field_24, sad_entry->rotations[sad_entry->field_1C], 1);
+        sad_entry->field_24 = tile_num_in_direction(sad_entry->field_24, sad_entry->path->rotations[sad_entry->field_1C], 1);
     }
 
     if (a3 != -1 && a3 < sad_entry->field_1C) {
@@ -2402,7 +2904,7 @@ static int anim_move_to_tile(Object* obj, int tile, int elev, int a4, int anim,
             anim_set_continue(animationSequenceIndex, 0);
         }
 
-        sad_entry->field_24 = tile_num_in_direction(tile, sad_entry->rotations[sad_entry->field_1C], 1);
+        sad_entry->field_24 = tile_num_in_direction(tile, sad_entry->path->rotations[sad_entry->field_1C], 1);
         if (a4 != -1 && a4 < sad_entry->field_1C) {
             sad_entry->field_1C = a4;
         }
@@ -2435,7 +2937,7 @@ static int anim_move(Object* obj, int tile, int elev, int a3, int anim, int a5,
     sad_entry->animationSequenceIndex = animationSequenceIndex;
     sad_entry->anim = anim;
 
-    sad_entry->field_1C = make_path(obj, obj->tile, tile, sad_entry->rotations, a5);
+    sad_entry->field_1C = make_path(obj, obj->tile, tile, sad_entry->path->rotations, a5);
     if (sad_entry->field_1C == 0) {
         sad_entry->field_20 = -1000;
         return -1;
@@ -2479,7 +2981,7 @@ static int anim_move_straight_to_tile(Object* obj, int tile, int elevation, int
         v15 = 32;
     }
 
-    sad_entry->field_1C = make_straight_path(obj, obj->tile, tile, sad_entry->field_28, NULL, v15);
+    sad_entry->field_1C = make_straight_path(obj, obj->tile, tile, sad_entry->path->field_28, NULL, v15);
     if (sad_entry->field_1C == 0) {
         sad_entry->field_20 = -1000;
         return -1;
@@ -2510,7 +3012,7 @@ int anim_move_on_stairs(Object* obj, int tile, int elevation, int anim, int anim
     sad_entry->animationTimestamp = 0;
     sad_entry->ticksPerFrame = compute_tpf(obj, sad_entry->fid);
     sad_entry->animationSequenceIndex = animationSequenceIndex;
-    sad_entry->field_1C = make_stair_path(obj, obj->tile, obj->elevation, tile, elevation, sad_entry->field_28, NULL);
+    sad_entry->field_1C = make_stair_path(obj, obj->tile, obj->elevation, tile, elevation, sad_entry->path->field_28, NULL);
     if (sad_entry->field_1C == 0) {
         sad_entry->field_20 = -1000;
         return -1;
@@ -2545,7 +3047,7 @@ int check_for_falling(Object* obj, int anim, int a3)
     sad_entry->animationTimestamp = 0;
     sad_entry->ticksPerFrame = compute_tpf(obj, sad_entry->fid);
     sad_entry->animationSequenceIndex = a3;
-    sad_entry->field_1C = make_straight_path_func(obj, obj->tile, obj->tile, sad_entry->field_28, 0, 16, obj_blocking_at);
+    sad_entry->field_1C = make_straight_path_func(obj, obj->tile, obj->tile, sad_entry->path->field_28, 0, 16, obj_blocking_at);
     if (sad_entry->field_1C == 0) {
         sad_entry->field_20 = -1000;
         return -1;
@@ -2571,7 +3073,7 @@ static void object_move(int index)
         obj_set_frame(object, 0, &temp);
         rect_min_bound(&dirty, &temp, &dirty);
 
-        obj_set_rotation(object, sad_entry->rotations[0], &temp);
+        obj_set_rotation(object, sad_entry->path->rotations[0], &temp);
         rect_min_bound(&dirty, &temp, &dirty);
 
         int fid = art_id(FID_TYPE(object->fid), object->fid & 0xFFF, sad_entry->anim, (object->fid & 0xF000) >> 12, object->rotation + 1);
@@ -2599,7 +3101,7 @@ static void object_move(int index)
     obj_offset(object, frameX, frameY, &temp);
     rect_min_bound(&dirty, &temp, &dirty);
 
-    int rotation = sad_entry->rotations[sad_entry->field_20];
+    int rotation = sad_entry->path->rotations[sad_entry->field_20];
     int y = off_tile[1][rotation];
     int x = off_tile[0][rotation];
     if ((x > 0 && x <= object->x) || (x < 0 && x >= object->x) || (y > 0 && y <= object->y) || (y < 0 && y >= object->y)) {
@@ -2610,7 +3112,7 @@ static void object_move(int index)
         Object* v12 = obj_blocking_at(object, v10, object->elevation);
         if (v12 != NULL) {
             if (!anim_can_use_door(object, v12)) {
-                sad_entry->field_1C = make_path(object, object->tile, sad_entry->field_24, sad_entry->rotations, 1);
+                sad_entry->field_1C = make_path(object, object->tile, sad_entry->field_24, sad_entry->path->rotations, 1);
                 if (sad_entry->field_1C != 0) {
                     obj_move_to_tile(object, object->tile, object->elevation, &temp);
                     rect_min_bound(&dirty, &temp, &dirty);
@@ -2618,7 +3120,7 @@ static void object_move(int index)
                     obj_set_frame(object, 0, &temp);
                     rect_min_bound(&dirty, &temp, &dirty);
 
-                    obj_set_rotation(object, sad_entry->rotations[0], &temp);
+                    obj_set_rotation(object, sad_entry->path->rotations[0], &temp);
                     rect_min_bound(&dirty, &temp, &dirty);
 
                     sad_entry->field_20 = 0;
@@ -2653,6 +3155,7 @@ static void object_move(int index)
                 } else {
                     combat_free_move -= v18;
                 }
+                statever_bump(STATE_VERSION_COMBAT);
 
                 if (object == obj_dude) {
                     intface_update_move_points(obj_dude->data.critter.combat.ap, combat_free_move);
@@ -2666,7 +3169,7 @@ static void object_move(int index)
             if (sad_entry->field_20 == sad_entry->field_1C || v17) {
                 sad_entry->field_20 = -1000;
             } else {
-                obj_set_rotation(object, sad_entry->rotations[sad_entry->field_20], &temp);
+                obj_set_rotation(object, sad_entry->path->rotations[sad_entry->field_20], &temp);
                 rect_min_bound(&dirty, &temp, &dirty);
 
                 obj_offset(object, x, y, &temp);
@@ -2711,7 +3214,7 @@ static void object_straight_move(int index)
         }
 
         if (sad_entry->field_20 < sad_entry->field_1C) {
-            StraightPathNode* v12 = &(sad_entry->field_28[sad_entry->field_20]);
+            StraightPathNode* v12 = &(sad_entry->path->field_28[sad_entry->field_20]);
 
             obj_move_to_tile(object, v12->tile, v12->elevation, &temp);
             rect_min_bound(&dirtyRect, &temp, &dirtyRect);
@@ -2771,9 +3274,37 @@ static int anim_animate(Object* obj, int anim, int animationSequenceIndex, int f
     return 0;
 }
 
+// CE: Returns number of ms until any running animation needs next frame
+// (`UINT_MAX` when nothing is animating).
+unsigned int anim_next_frame_delay()
+{
+    unsigned int delay = UINT_MAX;
+    unsigned int time = get_time();
+
+    for (int index = 0; index < curr_sad; index++) {
+        AnimationSad* sad_entry = &(sad[index]);
+        if (sad_entry->field_20 == -1000) {
+            continue;
+        }
+
+        unsigned int elapsed = elapsed_tocks(time, sad_entry->animationTimestamp);
+        if (elapsed >= sad_entry->ticksPerFrame) {
+            return 0;
+        }
+
+        if (sad_entry->ticksPerFrame - elapsed < delay) {
+            delay = sad_entry->ticksPerFrame - elapsed;
+        }
+    }
+
+    return delay;
+}
+
 // 0x417498
 void object_animate()
 {
+    ProfScope profScope(PROF_ZONE_OBJECT_ANIMATE);
+
     if (curr_sad == 0) {
         return;
     }
@@ -2789,7 +3320,7 @@ void object_animate()
         Object* object = sad_entry->obj;
 
         unsigned int time = get_time();
-        if (elapsed_tocks(time, sad_entry->animationTimestamp) < sad_entry->ticksPerFrame) {
+        if (!anim_fast_forwarding && elapsed_tocks(time, sad_entry->animationTimestamp) < sad_entry->ticksPerFrame) {
             continue;
         }
 
@@ -2940,6 +3471,46 @@ void object_animate()
     object_anim_compact();
 }
 
+// CE: Plays running animations to their end without waiting for frame time
+// or drawing intermediate frames. Every frame goes through `object_animate`,
+// so objects end up exactly where normal playback leaves them (tiles, action
+// points, death frames, callbacks in the same order). Endless animations are
+// left running.
+void anim_fast_forward()
+{
+    if (anim_fast_forwarding) {
+        return;
+    }
+
+    bool refreshEnabled = tile_refresh_is_enabled();
+    tile_disable_refresh();
+
+    anim_fast_forwarding = true;
+
+    for (int frame = 0; frame < ANIM_FAST_FORWARD_MAX_FRAMES; frame++) {
+        int index;
+        for (index = 0; index < curr_sad; index++) {
+            AnimationSad* sad_entry = &(sad[index]);
+            if (sad_entry->field_20 != -1000 && (sad_entry->flags & ANIM_SAD_FOREVER) == 0) {
+                break;
+            }
+        }
+
+        if (index == curr_sad) {
+            break;
+        }
+
+        object_animate();
+    }
+
+    anim_fast_forwarding = false;
+
+    if (refreshEnabled) {
+        tile_enable_refresh();
+        tile_refresh_display();
+    }
+}
+
 // 0x417880
 static void object_anim_compact()
 {
@@ -2965,7 +3536,10 @@ static void object_anim_compact()
             }
 
             if (index != v2) {
+                // CE: Swap path storage instead of copying it along.
+                AnimationSadPath* path = sad[index].path;
                 memcpy(&(sad[index]), &(sad[v2]), sizeof(AnimationSad));
+                sad[v2].path = path;
                 sad[v2].field_20 = -1000;
                 sad[v2].flags = 0;
             }
@@ -3078,12 +3652,6 @@ int dude_run(int action_points)
 // 0x417AB0
 void dude_fidget()
 {
-    // 0x4FEAAC
-    static unsigned int last_time = 0;
-
-    // 0x4FEAB0
-    static unsigned int next_time = 0;
-
     // 0x56B570
     static Object* fidget_ptr[100];
 
@@ -3104,14 +3672,15 @@ void dude_fidget()
     }
 
     unsigned int now = get_bk_time();
-    if (elapsed_tocks(now, last_time) <= next_time) {
+    if (elapsed_tocks(now, dude_fidget_last_time) <= dude_fidget_next_time) {
         return;
     }
 
-    last_time = now;
+    dude_fidget_last_time = now;
 
     int count = 0;
-    Object* object = obj_find_first_at(obj_dude->elevation);
+    // CE: Visit critters only.
+    Object* object = obj_find_first_of_type(OBJ_TYPE_CRITTER, obj_dude->elevation);
     while (object != NULL) {
         if (count >= 100) {
             break;
@@ -3127,12 +3696,12 @@ void dude_fidget()
             }
         }
 
-        object = obj_find_next_at();
+        object = obj_find_next_of_type();
     }
 
     int v13;
     if (count != 0) {
-        int r = roll_random(0, count - 1);
+        int r = roll_random_stream(ROLL_STREAM_COSMETIC, 0, count - 1);
         Object* object = fidget_ptr[r];
 
         register_begin(ANIMATION_REQUEST_UNRESERVED | ANIMATION_REQUEST_INSIGNIFICANT);
@@ -3170,7 +3739,13 @@ void dude_fidget()
         v13 = 7;
     }
 
-    next_time = roll_random(0, 3000) + 1000 * v13;
+    dude_fidget_next_time = roll_random_stream(ROLL_STREAM_COSMETIC, 0, 3000) + 1000 * v13;
+}
+
+// CE: Returns number of milliseconds until `dude_fidget` picks next critter.
+unsigned int dude_fidget_next_delay()
+{
+    return remaining_tocks(get_time(), dude_fidget_last_time, dude_fidget_next_time + 1);
 }
 
 // 0x417CB0
@@ -3364,11 +3939,11 @@ unsigned int compute_tpf(Object* object, int fid)
     if (isInCombat()) {
         if (FID_ANIM_TYPE(fid) == ANIM_WALK) {
             int playerSpeedup = 0;
-            config_get_value(&game_config, GAME_CONFIG_PREFERENCES_KEY, GAME_CONFIG_PLAYER_SPEEDUP_KEY, &playerSpeedup);
+            config_handle_get_value(&game_config_player_speedup, &playerSpeedup);
 
             if (object != obj_dude || playerSpeedup == 1) {
                 int combatSpeed = 0;
-                config_get_value(&game_config, GAME_CONFIG_PREFERENCES_KEY, GAME_CONFIG_COMBAT_SPEED_KEY, &combatSpeed);
+                config_handle_get_value(&game_config_combat_speed, &combatSpeed);
                 fps += combatSpeed;
             }
         }
@@ -1,6 +1,7 @@
 #ifndef FALLOUT_GAME_ANIMATION_H_
 #define FALLOUT_GAME_ANIMATION_H_
 
+#include "game/cache.h"
 #include "game/object_types.h"
 
 namespace fallout {
@@ -117,6 +118,7 @@ int register_clear(Object* a1);
 int register_end();
 int check_registry(Object* obj);
 int anim_busy(Object* a1);
+unsigned int anim_next_frame_delay();
 int register_object_move_to_object(Object* owner, Object* destination, int actionPoints, int delay);
 int register_object_run_to_object(Object* owner, Object* destination, int actionPoints, int delay);
 int register_object_move_to_tile(Object* owner, int tile, int elevation, int actionPoints, int delay);
@@ -148,6 +150,9 @@ int register_object_animate_forever(Object* owner, int anim, int delay);
 int register_ping(int a1, int a2);
 int make_path(Object* object, int from, int to, unsigned char* a4, int a5);
 int make_path_func(Object* object, int from, int to, unsigned char* rotations, int a5, PathBuilderCallback* callback);
+bool anim_get_path_cache_stats(CacheStats* stats);
+unsigned int anim_path_nodes_expanded();
+unsigned int anim_path_requests();
 int idist(int a1, int a2, int a3, int a4);
 int EST(int tile1, int tile2);
 int make_straight_path(Object* a1, int from, int to, StraightPathNode* pathNodes, Object** a5, int a6);
@@ -155,12 +160,14 @@ int make_straight_path_func(Object* a1, int from, int to, StraightPathNode* path
 int anim_move_on_stairs(Object* obj, int tile, int elevation, int anim, int animationSequenceIndex);
 int check_for_falling(Object* obj, int anim, int a3);
 void object_animate();
+void anim_fast_forward();
 int check_move(int* a1);
 int dude_move(int a1);
 int dude_run(int a1);
 int dude_move_to_tile(int tile, int actionPoints);
 int dude_run_to_tile(int tile, int actionPoints);
 void dude_fidget();
+unsigned int dude_fidget_next_delay();
 void dude_stand(Object* obj, int rotation, int fid);
 void dude_standup(Object* a1);
 int anim_hide(Object* object, int animationSequenceIndex);
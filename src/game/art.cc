@@ -4,18 +4,71 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <SDL.h>
+
 #include "game/anim.h"
 #include "game/game.h"
 #include "game/gconfig.h"
 #include "game/object.h"
 #include "game/proto.h"
+#include "game/shmcache.h"
 #include "platform_compat.h"
 #include "plib/gnw/debug.h"
 #include "plib/gnw/grbuf.h"
 #include "plib/gnw/memory.h"
+#include "plib/gnw/prof.h"
 
 namespace fallout {
 
+// CE: States of `ArtPreloadJob`.
+#define ART_PRELOAD_QUEUED 0
+#define ART_PRELOAD_DONE 1
+#define ART_PRELOAD_FAILED 2
+
+// CE: Art being loaded in background, see `art_preload`.
+typedef struct ArtPreloadJob {
+    int fid;
+    int state;
+
+    // Decoded art, allocated with plain `malloc` since it's filled on db
+    // prefetch thread.
+    unsigned char* data;
+    int size;
+
+    struct ArtPreloadJob* next;
+} ArtPreloadJob;
+
+// CE: Number of slots in `art_names` (power of 2).
+#define ART_NAME_CACHE_SIZE 1024
+
+// CE: Flags of `ArtNameEntry`.
+#define ART_NAME_EXISTS_KNOWN 0x01
+#define ART_NAME_EXISTS 0x02
+#define ART_NAME_SIZE_KNOWN 0x04
+
+// CE: Memoized result of `art_get_name` and related file lookups.
+typedef struct ArtNameEntry {
+    int fid;
+    int flags;
+    int size;
+
+    // Resolved path (`NULL` when fid cannot be resolved).
+    char* path;
+} ArtNameEntry;
+
+// CE: Number of images downscaled by `scale_art` kept for reuse.
+#define ART_THUMBNAIL_CACHE_SIZE 64
+
+// CE: Art frame downscaled to fit a slot. Transparent pixels (as well as
+// pixels `trans_cscale` does not reach) are 0.
+typedef struct ArtThumbnail {
+    int fid;
+    int width;
+    int height;
+    unsigned char* data;
+    unsigned int lastUsed;
+} ArtThumbnail;
+
 typedef struct ArtListDescription {
     int flags;
     char dir[16];
@@ -29,6 +82,26 @@ static int art_writeSubFrameData(unsigned char* data, DB_FILE* stream, int count
 static int art_writeFrameData(Art* art, DB_FILE* stream);
 static int artGetDataSize(Art* art);
 static int paddingForSize(int size);
+static void art_build_frame_table(Art* art);
+static unsigned char* art_encode_spans(unsigned char* data, int* sizePtr);
+static unsigned char* art_dedup_frames(unsigned char* data, int* sizePtr);
+static int art_find_shared_frame(const int* frameTable, int index);
+static unsigned char* art_decode(const unsigned char* src, size_t srcSize, int* sizePtr);
+static int art_decode_frames(unsigned char* dest, unsigned char* destEnd, int count, const unsigned char* src, size_t srcSize, size_t* posPtr, int* paddingPtr);
+static bool art_preload_init();
+static void art_preload_exit();
+static void art_cache_lock(int fid, Art** artPtr, CacheEntry** handlePtr);
+static void art_preload_read(void* userData, unsigned char* data, size_t size);
+static ArtPreloadJob* art_preload_find(int fid);
+static ArtPreloadJob* art_preload_wait(int fid);
+static void art_preload_remove(ArtPreloadJob* job);
+static ArtPreloadJob* art_load_encoded(int fid, const char* path);
+static unsigned int art_cache_signature();
+static ArtNameEntry* art_name_lookup(int fid);
+static bool art_name_exists(int fid);
+static void art_name_clear();
+static unsigned char* art_thumbnail_get(int fid, unsigned char* frameData, int frameWidth, int frameHeight, int width, int height);
+static void art_thumbnail_clear();
 
 // 0x4FEAB4
 static ArtListDescription art[OBJ_TYPE_COUNT] = {
@@ -76,9 +149,41 @@ HeadDescription* head_info;
 // 0x56B85C
 static int* anon_alias;
 
+// CE: Background loading state, only `art_preload_jobs` list and job states
+// are shared with db prefetch thread (and protected by the mutex).
+static SDL_mutex* art_preload_mutex = NULL;
+static SDL_cond* art_preload_cond = NULL;
+static ArtPreloadJob* art_preload_jobs = NULL;
+
+// CE: Direct-mapped fid to path cache, allocated on first use. Colliding
+// fids simply replace each other.
+static ArtNameEntry* art_names = NULL;
+
+// CE: Specifies whether loaded art is span encoded for faster transparent
+// blits.
+static bool art_spans = false;
+
+// CE: Specifies whether identical frames of loaded art share storage.
+static bool art_dedup = false;
+
+// CE: Total number of bytes saved by `art_dedup_frames` (updated from db
+// prefetch thread).
+static SDL_atomic_t art_dedup_saved;
+
+// CE: Serializes art cache access while map is rendered by several threads
+// (see `art_set_concurrent`).
+static SDL_mutex* art_cache_mutex = NULL;
+static bool art_concurrent = false;
+
+// CE: Scaled images of inventory art (see `scale_art`).
+static ArtThumbnail art_thumbnails[ART_THUMBNAIL_CACHE_SIZE];
+static unsigned int art_thumbnail_counter = 0;
+
 // 0x418170
 int art_init()
 {
+    MemTagScope memTagScope(MEM_TAG_ART);
+
     char path[COMPAT_MAX_PATH];
     DB_FILE* stream;
     char string[200];
@@ -90,11 +195,23 @@ int art_init()
         cacheSize = 8;
     }
 
-    if (!cache_init(&art_cache, art_data_size, art_data_load, art_data_free, cacheSize << 20)) {
+    // CE: Optional slab heap backend, see `HeapType`.
+    int heapType;
+    if (!config_get_value(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_ART_CACHE_HEAP_KEY, &heapType)) {
+        heapType = HEAP_TYPE_COMPACTING;
+    }
+
+    if (!cache_init_with_heap_type(&art_cache, art_data_size, art_data_load, art_data_free, cacheSize << 20, heapType)) {
         debug_printf("cache_init failed in art_init\n");
         return -1;
     }
 
+    // CE: Optional second tier keeping evicted art compressed (in megabytes).
+    int compressedCacheSize;
+    if (config_get_value(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_ART_CACHE_COMPRESSED_SIZE_KEY, &compressedCacheSize) && compressedCacheSize > 0) {
+        cache_set_second_tier(&art_cache, compressedCacheSize << 20);
+    }
+
     for (int objectType = 0; objectType < OBJ_TYPE_COUNT; objectType++) {
         art[objectType].flags = 0;
         snprintf(path, sizeof(path), "%s%s%s\\%s.lst",
@@ -250,19 +367,91 @@ int art_init()
 
     db_fclose(stream);
 
+    // CE: Optional span encoding of loaded art.
+    int spans;
+    if (config_get_value(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_ART_SPANS_KEY, &spans)) {
+        art_spans = spans != 0;
+    }
+
+    // CE: Optional deduplication of identical frames.
+    int dedup;
+    if (config_get_value(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_ART_DEDUP_KEY, &dedup)) {
+        art_dedup = dedup != 0;
+    }
+
+    SDL_AtomicSet(&art_dedup_saved, 0);
+
+    // CE: Optional art cache shared between game processes (size in
+    // megabytes).
+    int shared;
+    if (config_get_value(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_ART_CACHE_SHARED_KEY, &shared) && shared != 0) {
+        int sharedSize;
+        if (!config_get_value(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_ART_CACHE_SHARED_SIZE_KEY, &sharedSize)) {
+            sharedSize = 64;
+        }
+
+        unsigned int signature = art_cache_signature();
+
+        char name[64];
+        snprintf(name, sizeof(name), "/fallout-ce-art-%08x", signature);
+
+        if (sharedSize > 0 && shmcache_open(name, sharedSize << 20, signature)) {
+            cache_set_shared(&art_cache, true);
+        }
+    }
+
     return 0;
 }
 
 // 0x418684
 void art_reset()
 {
+    // CE: Art lookups are memoized per map, patches and files might change
+    // between them.
+    art_name_clear();
+    art_thumbnail_clear();
 }
 
 // 0x418688
 void art_exit()
 {
+    // CE: Report arena fragmentation so heap backends can be compared.
+    HeapFragmentationStats heapStats;
+    if (heap_get_fragmentation_stats(&(art_cache.heap), &heapStats)) {
+        debug_printf("Art cache heap: type %d, capacity %d, blocks %d, requested %d, allocated %d, wasted %d, free %d, largest free %d, fragmentation %d%%, system blocks %d (%d bytes)\n",
+            heapStats.type,
+            heapStats.capacity,
+            heapStats.blocks,
+            heapStats.requestedSize,
+            heapStats.allocatedSize,
+            heapStats.wastedSize,
+            heapStats.freeSize,
+            heapStats.largestFreeBlock,
+            heapStats.fragmentation,
+            heapStats.systemBlocks,
+            heapStats.systemSize);
+    }
+
+    // CE: Wait for background loads, they reference art lists.
+    art_preload_exit();
+
+    art_thumbnail_clear();
+
     cache_exit(&art_cache);
 
+    if (art_cache_mutex != NULL) {
+        SDL_DestroyMutex(art_cache_mutex);
+        art_cache_mutex = NULL;
+    }
+    art_concurrent = false;
+
+    // CE: All shared entries were released by `cache_exit`.
+    shmcache_close();
+
+    art_name_clear();
+    mem_free(art_names);
+    art_names = NULL;
+
     mem_free(anon_alias);
 
     for (int index = 0; index < OBJ_TYPE_COUNT; index++) {
@@ -326,6 +515,64 @@ int art_head_fidgets(int headFid)
     return 0;
 }
 
+// CE: Returns `frameData` scaled to `width`x`height`, building and caching it
+// on first use. Returns NULL if the image cannot be cached.
+static unsigned char* art_thumbnail_get(int fid, unsigned char* frameData, int frameWidth, int frameHeight, int width, int height)
+{
+    if (width <= 0 || height <= 0) {
+        return NULL;
+    }
+
+    art_thumbnail_counter++;
+
+    ArtThumbnail* candidate = &(art_thumbnails[0]);
+    for (int index = 0; index < ART_THUMBNAIL_CACHE_SIZE; index++) {
+        ArtThumbnail* thumbnail = &(art_thumbnails[index]);
+        if (thumbnail->data != NULL
+            && thumbnail->fid == fid
+            && thumbnail->width == width
+            && thumbnail->height == height) {
+            thumbnail->lastUsed = art_thumbnail_counter;
+            return thumbnail->data;
+        }
+
+        if (candidate->data != NULL && (thumbnail->data == NULL || thumbnail->lastUsed < candidate->lastUsed)) {
+            candidate = thumbnail;
+        }
+    }
+
+    unsigned char* data = (unsigned char*)mem_malloc(width * height);
+    if (data == NULL) {
+        return NULL;
+    }
+
+    memset(data, 0, width * height);
+    trans_cscale(frameData, frameWidth, frameHeight, frameWidth, data, width, height, width);
+
+    if (candidate->data != NULL) {
+        mem_free(candidate->data);
+    }
+
+    candidate->fid = fid;
+    candidate->width = width;
+    candidate->height = height;
+    candidate->data = data;
+    candidate->lastUsed = art_thumbnail_counter;
+
+    return data;
+}
+
+static void art_thumbnail_clear()
+{
+    for (int index = 0; index < ART_THUMBNAIL_CACHE_SIZE; index++) {
+        ArtThumbnail* thumbnail = &(art_thumbnails[index]);
+        if (thumbnail->data != NULL) {
+            mem_free(thumbnail->data);
+            thumbnail->data = NULL;
+        }
+    }
+}
+
 // 0x4187C8
 void scale_art(int fid, unsigned char* dest, int width, int height, int pitch)
 {
@@ -349,23 +596,32 @@ void scale_art(int fid, unsigned char* dest, int width, int height, int pitch)
     int remainingWidth = width - frameWidth;
     int remainingHeight = height - frameHeight;
     if (remainingWidth < 0 || remainingHeight < 0) {
+        unsigned char* scaledDest;
+        int scaledWidth;
+        int scaledHeight;
         if (height * frameWidth >= width * frameHeight) {
-            trans_cscale(frameData,
-                frameWidth,
-                frameHeight,
-                frameWidth,
-                dest + pitch * ((height - width * frameHeight / frameWidth) / 2),
-                width,
-                width * frameHeight / frameWidth,
-                pitch);
+            scaledDest = dest + pitch * ((height - width * frameHeight / frameWidth) / 2);
+            scaledWidth = width;
+            scaledHeight = width * frameHeight / frameWidth;
+        } else {
+            scaledDest = dest + (width - height * frameWidth / frameHeight) / 2;
+            scaledWidth = height * frameWidth / frameHeight;
+            scaledHeight = height;
+        }
+
+        // CE: Inventory, loot and barter windows scale the same items on
+        // every redraw, reuse scaled images.
+        unsigned char* thumbnail = art_thumbnail_get(fid, frameData, frameWidth, frameHeight, scaledWidth, scaledHeight);
+        if (thumbnail != NULL) {
+            trans_buf_to_buf(thumbnail, scaledWidth, scaledHeight, scaledWidth, scaledDest, pitch);
         } else {
             trans_cscale(frameData,
                 frameWidth,
                 frameHeight,
                 frameWidth,
-                dest + (width - height * frameWidth / frameHeight) / 2,
-                height * frameWidth / frameHeight,
-                height,
+                scaledDest,
+                scaledWidth,
+                scaledHeight,
                 pitch);
         }
     } else {
@@ -380,6 +636,36 @@ void scale_art(int fid, unsigned char* dest, int width, int height, int pitch)
     art_ptr_unlock(handle);
 }
 
+// CE: Enables art cache locking so that art can be locked and unlocked from
+// several threads at once. Only lock/unlock functions are safe to use while
+// enabled. Returns `false` if locking is not available.
+bool art_set_concurrent(bool enabled)
+{
+    if (enabled && art_cache_mutex == NULL) {
+        art_cache_mutex = SDL_CreateMutex();
+        if (art_cache_mutex == NULL) {
+            return false;
+        }
+    }
+
+    art_concurrent = enabled;
+
+    return true;
+}
+
+// CE: Locks art cache entry and (when concurrent access is enabled)
+// serializes changes to cache state.
+static void art_cache_lock(int fid, Art** artPtr, CacheEntry** handlePtr)
+{
+    if (art_concurrent) {
+        SDL_LockMutex(art_cache_mutex);
+        cache_lock(&art_cache, fid, (void**)artPtr, handlePtr);
+        SDL_UnlockMutex(art_cache_mutex);
+    } else {
+        cache_lock(&art_cache, fid, (void**)artPtr, handlePtr);
+    }
+}
+
 // 0x41892C
 Art* art_ptr_lock(int fid, CacheEntry** handlePtr)
 {
@@ -388,7 +674,7 @@ Art* art_ptr_lock(int fid, CacheEntry** handlePtr)
     }
 
     Art* art = NULL;
-    cache_lock(&art_cache, fid, (void**)&art, handlePtr);
+    art_cache_lock(fid, &art, handlePtr);
     return art;
 }
 
@@ -400,7 +686,7 @@ unsigned char* art_ptr_lock_data(int fid, int frame, int direction, CacheEntry**
 
     art = NULL;
     if (handlePtr) {
-        cache_lock(&art_cache, fid, (void**)&art, handlePtr);
+        art_cache_lock(fid, &art, handlePtr);
     }
 
     if (art != NULL) {
@@ -420,7 +706,7 @@ unsigned char* art_lock(int fid, CacheEntry** handlePtr, int* widthPtr, int* hei
     *handlePtr = NULL;
 
     Art* art = NULL;
-    cache_lock(&art_cache, fid, (void**)&art, handlePtr);
+    art_cache_lock(fid, &art, handlePtr);
 
     if (art == NULL) {
         return NULL;
@@ -445,6 +731,13 @@ unsigned char* art_lock(int fid, CacheEntry** handlePtr, int* widthPtr, int* hei
 // 0x418A2C
 int art_ptr_unlock(CacheEntry* handle)
 {
+    if (art_concurrent) {
+        SDL_LockMutex(art_cache_mutex);
+        int rc = cache_unlock(&art_cache, handle);
+        SDL_UnlockMutex(art_cache_mutex);
+        return rc;
+    }
+
     return cache_unlock(&art_cache, handle);
 }
 
@@ -454,9 +747,114 @@ int art_flush()
     return cache_flush(&art_cache);
 }
 
+// CE: Schedules art to be read and decoded in background (on db prefetch
+// thread). Decoded art is committed into cache by `art_preload_process`,
+// locking art which is still being loaded waits for it. Returns the number
+// of scheduled entries.
+int art_preload(const int* fids, int count)
+{
+    if (!art_preload_init()) {
+        return 0;
+    }
+
+    int queued = 0;
+    for (int index = 0; index < count; index++) {
+        int fid = fids[index];
+
+        if (cache_query(&art_cache, fid) || art_preload_find(fid) != NULL) {
+            continue;
+        }
+
+        ArtPreloadJob* job = (ArtPreloadJob*)mem_malloc(sizeof(*job));
+        if (job == NULL) {
+            break;
+        }
+
+        job->fid = fid;
+        job->state = ART_PRELOAD_QUEUED;
+        job->data = NULL;
+        job->size = 0;
+
+        SDL_LockMutex(art_preload_mutex);
+        job->next = art_preload_jobs;
+        art_preload_jobs = job;
+        SDL_UnlockMutex(art_preload_mutex);
+
+        DB_DATABASE* oldDb = INVALID_DATABASE_HANDLE;
+        if (FID_TYPE(fid) == OBJ_TYPE_CRITTER) {
+            oldDb = db_current();
+            db_select(critter_db_handle);
+        }
+
+        char* artFileName = art_get_name(fid);
+        int rc = artFileName != NULL ? db_read_async(artFileName, art_preload_read, job) : -1;
+
+        if (oldDb != INVALID_DATABASE_HANDLE) {
+            db_select(oldDb);
+        }
+
+        if (rc != 0) {
+            // Callback is not called when request is rejected.
+            art_preload_remove(job);
+            continue;
+        }
+
+        queued++;
+    }
+
+    return queued;
+}
+
+// CE: Commits art loaded in background into cache. Should be called once
+// per frame.
+void art_preload_process()
+{
+    while (art_preload_jobs != NULL) {
+        SDL_LockMutex(art_preload_mutex);
+
+        ArtPreloadJob* job = art_preload_jobs;
+        while (job != NULL && job->state == ART_PRELOAD_QUEUED) {
+            job = job->next;
+        }
+
+        SDL_UnlockMutex(art_preload_mutex);
+
+        if (job == NULL) {
+            break;
+        }
+
+        int fid = job->fid;
+        if (job->state == ART_PRELOAD_DONE) {
+            // Consumes the job (unless art is already cached or cannot be
+            // cached at all).
+            CacheEntry* cacheHandle;
+            if (art_ptr_lock(fid, &cacheHandle) != NULL) {
+                art_ptr_unlock(cacheHandle);
+            }
+        }
+
+        job = art_preload_find(fid);
+        if (job != NULL && job->state != ART_PRELOAD_QUEUED) {
+            art_preload_remove(job);
+        }
+    }
+}
+
 // 0x418A60
 int art_discard(int fid)
 {
+    // CE: Drop copy loaded in background as well.
+    ArtPreloadJob* job = art_preload_find(fid);
+    if (job != NULL) {
+        SDL_LockMutex(art_preload_mutex);
+        bool finished = job->state != ART_PRELOAD_QUEUED;
+        SDL_UnlockMutex(art_preload_mutex);
+
+        if (finished) {
+            art_preload_remove(job);
+        }
+    }
+
     if (cache_discard(&art_cache, fid) == 0) {
         return -1;
     }
@@ -827,37 +1225,38 @@ ArtFrame* frame_ptr(Art* art, int frame, int rotation)
         return NULL;
     }
 
-    ArtFrame* frm = (ArtFrame*)((unsigned char*)art + sizeof(*art) + art->dataOffsets[rotation] + art->padding[rotation]);
-    for (int index = 0; index < frame; index++) {
-        frm = (ArtFrame*)((unsigned char*)frm + sizeof(*frm) + frm->size + paddingForSize(frm->size));
-    }
-    return frm;
+    // CE: Original code walks all preceding frames of the rotation. Their
+    // offsets are now precomputed by `load_frame_into`.
+    const int* frameTable = (const int*)((unsigned char*)art + art->frameTableOffset);
+    return (ArtFrame*)((unsigned char*)art + frameTable[rotation * art->frameCount + frame]);
 }
 
-// 0x419050
-bool art_exists(int fid)
+// CE: Returns span encoded frame data (see `span_encode`), or `NULL` if art is
+// not span encoded.
+unsigned char* art_frame_spans(Art* art, int frame, int rotation)
 {
-    bool result = false;
-    DB_DATABASE* oldDb = INVALID_DATABASE_HANDLE;
-
-    if (FID_TYPE(fid) == OBJ_TYPE_CRITTER) {
-        oldDb = db_current();
-        db_select(critter_db_handle);
+    if (frame_ptr(art, frame, rotation) == NULL) {
+        return NULL;
     }
 
-    char* filePath = art_get_name(fid);
-    if (filePath != NULL) {
-        dir_entry de;
-        if (db_dir_entry(filePath, &de) != -1) {
-            result = true;
-        }
+    if (art->spanTableOffset == 0) {
+        return NULL;
     }
 
-    if (oldDb != INVALID_DATABASE_HANDLE) {
-        db_select(oldDb);
+    const int* spanTable = (const int*)((unsigned char*)art + art->spanTableOffset);
+    int offset = spanTable[rotation * art->frameCount + frame];
+    if (offset == 0) {
+        return NULL;
     }
 
-    return result;
+    return (unsigned char*)art + offset;
+}
+
+// 0x419050
+bool art_exists(int fid)
+{
+    // CE: Path and existence are memoized.
+    return art_name_exists(fid);
 }
 
 // NOTE: Exactly the same implementation as `art_exists`.
@@ -865,27 +1264,7 @@ bool art_exists(int fid)
 // 0x4190B8
 bool art_fid_valid(int fid)
 {
-    bool result = false;
-    DB_DATABASE* oldDb = INVALID_DATABASE_HANDLE;
-
-    if (FID_TYPE(fid) == OBJ_TYPE_CRITTER) {
-        oldDb = db_current();
-        db_select(critter_db_handle);
-    }
-
-    char* filePath = art_get_name(fid);
-    if (filePath != NULL) {
-        dir_entry de;
-        if (db_dir_entry(filePath, &de) != -1) {
-            result = true;
-        }
-    }
-
-    if (oldDb != INVALID_DATABASE_HANDLE) {
-        db_select(oldDb);
-    }
-
-    return result;
+    return art_name_exists(fid);
 }
 
 // 0x419120
@@ -924,13 +1303,41 @@ int art_data_size(int fid, int* sizePtr)
     DB_DATABASE* oldDb = INVALID_DATABASE_HANDLE;
     int result = -1;
 
+    // CE: Use art loaded in background (waiting for it when needed).
+    ArtPreloadJob* job = art_preload_wait(fid);
+    if (job != NULL) {
+        if (job->state == ART_PRELOAD_DONE) {
+            *sizePtr = job->size;
+            return 0;
+        }
+
+        // Fall back to regular loading to report errors the usual way.
+        art_preload_remove(job);
+    }
+
+    // CE: Size is memoized along with resolved path, so reloading evicted
+    // art does not need to read its header twice.
+    ArtNameEntry* entry = art_name_lookup(fid);
+    if (entry != NULL && (entry->flags & ART_NAME_SIZE_KNOWN) != 0) {
+        *sizePtr = entry->size;
+        return 0;
+    }
+
     if (FID_TYPE(fid) == OBJ_TYPE_CRITTER) {
         oldDb = db_current();
         db_select(critter_db_handle);
     }
 
-    char* artFilePath = art_get_name(fid);
-    if (artFilePath != NULL) {
+    char* artFilePath = entry != NULL ? entry->path : art_get_name(fid);
+    if (artFilePath != NULL && (art_spans || art_dedup)) {
+        // CE: Size of span encoded or deduplicated art is only known after
+        // decoding, so decoded art is staged for `art_data_load`.
+        job = art_load_encoded(fid, artFilePath);
+        if (job != NULL) {
+            *sizePtr = job->size;
+            result = 0;
+        }
+    } else if (artFilePath != NULL) {
         DB_FILE* stream = NULL;
 
         stream = db_fopen(artFilePath, "rb");
@@ -944,6 +1351,11 @@ int art_data_size(int fid, int* sizePtr)
         }
     }
 
+    if (entry != NULL && result == 0) {
+        entry->size = *sizePtr;
+        entry->flags |= ART_NAME_SIZE_KNOWN | ART_NAME_EXISTS_KNOWN | ART_NAME_EXISTS;
+    }
+
     if (oldDb != INVALID_DATABASE_HANDLE) {
         db_select(oldDb);
     }
@@ -954,22 +1366,54 @@ int art_data_size(int fid, int* sizePtr)
 // 0x41924C
 int art_data_load(int fid, int* sizePtr, unsigned char* data)
 {
+    MemTagScope memTagScope(MEM_TAG_ART);
+    ProfScope profScope(PROF_ZONE_ART_LOAD);
+
     DB_DATABASE* oldDb = INVALID_DATABASE_HANDLE;
     int result = -1;
 
+    // CE: Use art loaded in background. Size was reported from the same
+    // job by `art_data_size`.
+    ArtPreloadJob* job = art_preload_wait(fid);
+    if (job != NULL) {
+        if (job->state == ART_PRELOAD_DONE) {
+            memcpy(data, job->data, job->size);
+            *sizePtr = job->size;
+            art_preload_remove(job);
+            return 0;
+        }
+
+        art_preload_remove(job);
+    }
+
+    ArtNameEntry* entry = art_name_lookup(fid);
+
     if (FID_TYPE(fid) == OBJ_TYPE_CRITTER) {
         oldDb = db_current();
         db_select(critter_db_handle);
     }
 
-    char* artFileName = art_get_name(fid);
-    if (artFileName != NULL) {
+    char* artFileName = entry != NULL ? entry->path : art_get_name(fid);
+    if (artFileName != NULL && (art_spans || art_dedup)) {
+        job = art_load_encoded(fid, artFileName);
+        if (job != NULL) {
+            memcpy(data, job->data, job->size);
+            *sizePtr = job->size;
+            art_preload_remove(job);
+            result = 0;
+        }
+    } else if (artFileName != NULL) {
         if (load_frame_into(artFileName, data) == 0) {
             *sizePtr = artGetDataSize((Art*)data);
             result = 0;
         }
     }
 
+    if (entry != NULL && result == 0) {
+        entry->size = *sizePtr;
+        entry->flags |= ART_NAME_SIZE_KNOWN | ART_NAME_EXISTS_KNOWN | ART_NAME_EXISTS;
+    }
+
     if (oldDb != INVALID_DATABASE_HANDLE) {
         db_select(oldDb);
     }
@@ -1126,6 +1570,11 @@ int load_frame_into(const char* path, unsigned char* data)
     }
 
     db_fclose(stream);
+
+    // CE: Frame offsets are stored along with art, so they are cached (and
+    // moved or shared) together with it.
+    art_build_frame_table(art);
+
     return 0;
 }
 
@@ -1208,6 +1657,10 @@ static int artGetDataSize(Art* art)
         }
     }
 
+    // CE: Frame offsets table (aligned).
+    dataSize += sizeof(int) - 1;
+    dataSize += sizeof(int) * ROTATION_COUNT * art->frameCount;
+
     return dataSize;
 }
 
@@ -1216,4 +1669,698 @@ static int paddingForSize(int size)
     return (sizeof(int) - size % sizeof(int)) % sizeof(int);
 }
 
+// CE: Fills frame offsets table (placed right after frame data) used by
+// `frame_ptr`.
+static void art_build_frame_table(Art* art)
+{
+    unsigned char* base = (unsigned char*)art;
+
+    int end = sizeof(*art);
+    for (int rotation = 0; rotation < ROTATION_COUNT; rotation++) {
+        int offset = sizeof(*art) + art->dataOffsets[rotation] + art->padding[rotation];
+        for (int index = 0; index < art->frameCount; index++) {
+            ArtFrame* frm = (ArtFrame*)(base + offset);
+            offset += sizeof(*frm) + frm->size + paddingForSize(frm->size);
+        }
+
+        if (offset > end) {
+            end = offset;
+        }
+    }
+
+    art->frameTableOffset = end + paddingForSize(end);
+    art->spanTableOffset = 0;
+
+    int* frameTable = (int*)(base + art->frameTableOffset);
+    for (int rotation = 0; rotation < ROTATION_COUNT; rotation++) {
+        int offset = sizeof(*art) + art->dataOffsets[rotation] + art->padding[rotation];
+        for (int index = 0; index < art->frameCount; index++) {
+            ArtFrame* frm = (ArtFrame*)(base + offset);
+            frameTable[rotation * art->frameCount + index] = offset;
+            offset += sizeof(*frm) + frm->size + paddingForSize(frm->size);
+        }
+    }
+}
+
+// CE: Same as `load_frame_into`, but decodes FRM file contents from memory
+// into buffer allocated with plain `malloc` (this is used on db prefetch
+// thread). Returns `NULL` on error.
+static unsigned char* art_decode(const unsigned char* src, size_t srcSize, int* sizePtr)
+{
+    // Size of FRM header.
+    if (srcSize < 62) {
+        return NULL;
+    }
+
+    Art header;
+    size_t pos = 0;
+
+    header.field_0 = (src[pos] << 24) | (src[pos + 1] << 16) | (src[pos + 2] << 8) | src[pos + 3];
+    pos += 4;
+    header.framesPerSecond = (short)((src[pos] << 8) | src[pos + 1]);
+    pos += 2;
+    header.actionFrame = (short)((src[pos] << 8) | src[pos + 1]);
+    pos += 2;
+    header.frameCount = (short)((src[pos] << 8) | src[pos + 1]);
+    pos += 2;
+
+    for (int index = 0; index < ROTATION_COUNT; index++) {
+        header.xOffsets[index] = (short)((src[pos] << 8) | src[pos + 1]);
+        pos += 2;
+    }
+
+    for (int index = 0; index < ROTATION_COUNT; index++) {
+        header.yOffsets[index] = (short)((src[pos] << 8) | src[pos + 1]);
+        pos += 2;
+    }
+
+    for (int index = 0; index < ROTATION_COUNT; index++) {
+        header.dataOffsets[index] = (src[pos] << 24) | (src[pos + 1] << 16) | (src[pos + 2] << 8) | src[pos + 3];
+        pos += 4;
+    }
+
+    header.dataSize = (src[pos] << 24) | (src[pos + 1] << 16) | (src[pos + 2] << 8) | src[pos + 3];
+    pos += 4;
+
+    if (header.frameCount < 0 || header.dataSize < 0) {
+        return NULL;
+    }
+
+    for (int index = 0; index < ROTATION_COUNT; index++) {
+        if (header.dataOffsets[index] < 0 || header.dataOffsets[index] > header.dataSize) {
+            return NULL;
+        }
+    }
+
+    int size = artGetDataSize(&header);
+    unsigned char* data = (unsigned char*)malloc(size);
+    if (data == NULL) {
+        return NULL;
+    }
+
+    Art* art = (Art*)data;
+    *art = header;
+
+    // Frames must leave room for frame offsets table.
+    unsigned char* dataEnd = data + size - (sizeof(int) - 1) - sizeof(int) * ROTATION_COUNT * art->frameCount;
+
+    int currentPadding = paddingForSize(sizeof(Art));
+    int previousPadding = 0;
+
+    for (int index = 0; index < ROTATION_COUNT; index++) {
+        art->padding[index] = currentPadding;
+
+        if (index == 0 || art->dataOffsets[index - 1] != art->dataOffsets[index]) {
+            art->padding[index] += previousPadding;
+            currentPadding += previousPadding;
+            if (art_decode_frames(data + sizeof(Art) + art->dataOffsets[index] + art->padding[index], dataEnd, art->frameCount, src, srcSize, &pos, &previousPadding) != 0) {
+                free(data);
+                return NULL;
+            }
+        }
+    }
+
+    art_build_frame_table(art);
+
+    if (art_dedup) {
+        data = art_dedup_frames(data, &size);
+    }
+
+    if (art_spans) {
+        data = art_encode_spans(data, &size);
+    }
+
+    *sizePtr = size;
+
+    return data;
+}
+
+// CE: Repacks art allocated with plain `malloc` so that identical frames
+// (including their headers) are stored once and referenced from frame offsets
+// table several times. Returns art as is if there are no duplicates.
+//
+// NOTE: Repacked art can only be accessed through frame offsets table (see
+// `frame_ptr`), `dataOffsets` and `padding` only point to first frames.
+static unsigned char* art_dedup_frames(unsigned char* data, int* sizePtr)
+{
+    Art* art = (Art*)data;
+    int count = ROTATION_COUNT * art->frameCount;
+    if (count == 0) {
+        return data;
+    }
+
+    const int* frameTable = (const int*)(data + art->frameTableOffset);
+
+    unsigned int* hashes = (unsigned int*)malloc(sizeof(*hashes) * count);
+    int* duplicates = (int*)malloc(sizeof(*duplicates) * count);
+    if (hashes == NULL || duplicates == NULL) {
+        free(hashes);
+        free(duplicates);
+        return data;
+    }
+
+    int saved = 0;
+    for (int index = 0; index < count; index++) {
+        ArtFrame* frm = (ArtFrame*)(data + frameTable[index]);
+        int length = sizeof(*frm) + frm->size;
+
+        // FNV-1a
+        unsigned int hash = 2166136261U;
+        unsigned char* ptr = (unsigned char*)frm;
+        for (int pos = 0; pos < length; pos++) {
+            hash = (hash ^ ptr[pos]) * 16777619U;
+        }
+
+        hashes[index] = hash;
+        duplicates[index] = -1;
+
+        for (int other = 0; other < index; other++) {
+            if (duplicates[other] != -1 || hashes[other] != hash) {
+                continue;
+            }
+
+            ArtFrame* otherFrm = (ArtFrame*)(data + frameTable[other]);
+            if (otherFrm == frm || (otherFrm->size == frm->size && memcmp(otherFrm, frm, length) == 0)) {
+                duplicates[index] = other;
+
+                // Rotations sharing frame data in file are not duplicates.
+                if (otherFrm != frm) {
+                    saved += length + paddingForSize(frm->size);
+                }
+                break;
+            }
+        }
+    }
+
+    free(hashes);
+
+    if (saved == 0) {
+        free(duplicates);
+        return data;
+    }
+
+    unsigned char* repacked = (unsigned char*)malloc(*sizePtr);
+    if (repacked == NULL) {
+        free(duplicates);
+        return data;
+    }
+
+    Art* repackedArt = (Art*)repacked;
+    *repackedArt = *art;
+
+    int offset = sizeof(*art) + paddingForSize(sizeof(*art));
+    int* offsets = (int*)malloc(sizeof(*offsets) * count);
+    if (offsets == NULL) {
+        free(repacked);
+        free(duplicates);
+        return data;
+    }
+
+    for (int index = 0; index < count; index++) {
+        if (duplicates[index] != -1) {
+            offsets[index] = offsets[duplicates[index]];
+            continue;
+        }
+
+        ArtFrame* frm = (ArtFrame*)(data + frameTable[index]);
+        memcpy(repacked + offset, frm, sizeof(*frm) + frm->size);
+        offsets[index] = offset;
+        offset += sizeof(*frm) + frm->size + paddingForSize(frm->size);
+    }
+
+    repackedArt->frameTableOffset = offset;
+    memcpy(repacked + offset, offsets, sizeof(*offsets) * count);
+
+    for (int rotation = 0; rotation < ROTATION_COUNT; rotation++) {
+        repackedArt->padding[rotation] = 0;
+        repackedArt->dataOffsets[rotation] = offsets[rotation * art->frameCount] - sizeof(*art);
+    }
+
+    free(offsets);
+    free(duplicates);
+    free(data);
+
+    SDL_AtomicAdd(&art_dedup_saved, saved);
+
+    *sizePtr = offset + sizeof(int) * count;
+
+    return repacked;
+}
+
+// CE: Returns total number of bytes saved by deduplicating frames of loaded
+// art.
+unsigned int art_dedup_saved_size()
+{
+    return (unsigned int)SDL_AtomicGet(&art_dedup_saved);
+}
+
+// CE: Returns index of the first preceding entry of frame offsets table
+// pointing to the same frame, or -1 if there is none.
+static int art_find_shared_frame(const int* frameTable, int index)
+{
+    for (int other = 0; other < index; other++) {
+        if (frameTable[other] == frameTable[index]) {
+            return other;
+        }
+    }
+
+    return -1;
+}
+
+// CE: Appends span encoded copies of all frames to art allocated with plain
+// `malloc`. Art is returned as is when it cannot be grown.
+static unsigned char* art_encode_spans(unsigned char* data, int* sizePtr)
+{
+    Art* art = (Art*)data;
+    int count = ROTATION_COUNT * art->frameCount;
+    const int* frameTable = (const int*)(data + art->frameTableOffset);
+
+    int spanTableOffset = *sizePtr + paddingForSize(*sizePtr);
+    int size = spanTableOffset + sizeof(int) * count;
+
+    for (int index = 0; index < count; index++) {
+        // Frames shared by several rotations (or deduplicated) share their
+        // spans.
+        if (art_find_shared_frame(frameTable, index) != -1) {
+            continue;
+        }
+
+        ArtFrame* frm = (ArtFrame*)(data + frameTable[index]);
+        if (frm->width > 0 && frm->height > 0 && frm->width * frm->height <= frm->size) {
+            size += span_encode_size((unsigned char*)frm + sizeof(*frm), frm->width, frm->height, frm->width);
+            size += sizeof(int) - 1;
+        }
+    }
+
+    unsigned char* encoded = (unsigned char*)realloc(data, size);
+    if (encoded == NULL) {
+        return data;
+    }
+
+    art = (Art*)encoded;
+    frameTable = (const int*)(encoded + art->frameTableOffset);
+
+    int* spanTable = (int*)(encoded + spanTableOffset);
+    int offset = spanTableOffset + sizeof(int) * count;
+
+    for (int index = 0; index < count; index++) {
+        int shared = art_find_shared_frame(frameTable, index);
+        if (shared != -1) {
+            spanTable[index] = spanTable[shared];
+            continue;
+        }
+
+        spanTable[index] = 0;
+
+        ArtFrame* frm = (ArtFrame*)(encoded + frameTable[index]);
+        if (frm->width > 0 && frm->height > 0 && frm->width * frm->height <= frm->size) {
+            unsigned char* pixels = (unsigned char*)frm + sizeof(*frm);
+            offset += paddingForSize(offset);
+            spanTable[index] = offset;
+            span_encode(pixels, frm->width, frm->height, frm->width, encoded + offset);
+            offset += span_encode_size(pixels, frm->width, frm->height, frm->width);
+        }
+    }
+
+    art->spanTableOffset = spanTableOffset;
+    *sizePtr = offset;
+
+    return encoded;
+}
+
+// CE: Same as `art_readSubFrameData`, but reads from memory.
+static int art_decode_frames(unsigned char* dest, unsigned char* destEnd, int count, const unsigned char* src, size_t srcSize, size_t* posPtr, int* paddingPtr)
+{
+    unsigned char* ptr = dest;
+    size_t pos = *posPtr;
+    int padding = 0;
+
+    for (int index = 0; index < count; index++) {
+        // Size of frame header.
+        if (srcSize - pos < 12 || ptr + sizeof(ArtFrame) > destEnd) {
+            return -1;
+        }
+
+        ArtFrame* frame = (ArtFrame*)ptr;
+        frame->width = (short)((src[pos] << 8) | src[pos + 1]);
+        frame->height = (short)((src[pos + 2] << 8) | src[pos + 3]);
+        frame->size = (src[pos + 4] << 24) | (src[pos + 5] << 16) | (src[pos + 6] << 8) | src[pos + 7];
+        frame->x = (short)((src[pos + 8] << 8) | src[pos + 9]);
+        frame->y = (short)((src[pos + 10] << 8) | src[pos + 11]);
+        pos += 12;
+
+        if (frame->size < 0
+            || (size_t)frame->size > srcSize - pos
+            || frame->size > destEnd - ptr - (int)sizeof(ArtFrame)) {
+            return -1;
+        }
+
+        memcpy(ptr + sizeof(ArtFrame), src + pos, frame->size);
+        pos += frame->size;
+
+        ptr += sizeof(ArtFrame) + frame->size;
+        ptr += paddingForSize(frame->size);
+        padding += paddingForSize(frame->size);
+    }
+
+    *posPtr = pos;
+    *paddingPtr = padding;
+
+    return 0;
+}
+
+static bool art_preload_init()
+{
+    if (art_preload_mutex != NULL) {
+        return true;
+    }
+
+    art_preload_mutex = SDL_CreateMutex();
+    if (art_preload_mutex == NULL) {
+        return false;
+    }
+
+    art_preload_cond = SDL_CreateCond();
+    if (art_preload_cond == NULL) {
+        SDL_DestroyMutex(art_preload_mutex);
+        art_preload_mutex = NULL;
+        return false;
+    }
+
+    return true;
+}
+
+// Waits for all pending jobs and frees them.
+static void art_preload_exit()
+{
+    if (art_preload_mutex == NULL) {
+        return;
+    }
+
+    SDL_LockMutex(art_preload_mutex);
+
+    while (true) {
+        ArtPreloadJob* job = art_preload_jobs;
+        while (job != NULL && job->state != ART_PRELOAD_QUEUED) {
+            job = job->next;
+        }
+
+        if (job == NULL) {
+            break;
+        }
+
+        SDL_CondWait(art_preload_cond, art_preload_mutex);
+    }
+
+    SDL_UnlockMutex(art_preload_mutex);
+
+    while (art_preload_jobs != NULL) {
+        art_preload_remove(art_preload_jobs);
+    }
+
+    SDL_DestroyCond(art_preload_cond);
+    SDL_DestroyMutex(art_preload_mutex);
+    art_preload_cond = NULL;
+    art_preload_mutex = NULL;
+}
+
+// Receives file contents on db prefetch thread (or `NULL` on main thread if
+// request was cancelled).
+static void art_preload_read(void* userData, unsigned char* data, size_t size)
+{
+    ArtPreloadJob* job = (ArtPreloadJob*)userData;
+
+    int artSize = 0;
+    unsigned char* art = data != NULL ? art_decode(data, size, &artSize) : NULL;
+
+    SDL_LockMutex(art_preload_mutex);
+    job->data = art;
+    job->size = artSize;
+    job->state = art != NULL ? ART_PRELOAD_DONE : ART_PRELOAD_FAILED;
+    SDL_CondBroadcast(art_preload_cond);
+    SDL_UnlockMutex(art_preload_mutex);
+}
+
+static ArtPreloadJob* art_preload_find(int fid)
+{
+    if (art_preload_jobs == NULL) {
+        return NULL;
+    }
+
+    // Only main thread modifies the list.
+    ArtPreloadJob* job = art_preload_jobs;
+    while (job != NULL && job->fid != fid) {
+        job = job->next;
+    }
+
+    return job;
+}
+
+// Returns finished job for given art, or `NULL` if it was not scheduled.
+static ArtPreloadJob* art_preload_wait(int fid)
+{
+    ArtPreloadJob* job = art_preload_find(fid);
+    if (job == NULL) {
+        return NULL;
+    }
+
+    SDL_LockMutex(art_preload_mutex);
+    while (job->state == ART_PRELOAD_QUEUED) {
+        SDL_CondWait(art_preload_cond, art_preload_mutex);
+    }
+    SDL_UnlockMutex(art_preload_mutex);
+
+    return job;
+}
+
+// Removes finished (or not yet submitted) job.
+static void art_preload_remove(ArtPreloadJob* job)
+{
+    SDL_LockMutex(art_preload_mutex);
+
+    ArtPreloadJob** link = &art_preload_jobs;
+    while (*link != NULL && *link != job) {
+        link = &((*link)->next);
+    }
+
+    if (*link != NULL) {
+        *link = job->next;
+    }
+
+    SDL_UnlockMutex(art_preload_mutex);
+
+    if (job->data != NULL) {
+        free(job->data);
+    }
+
+    mem_free(job);
+}
+
+// CE: Loads and decodes art on main thread (with database already selected by
+// caller). Result is staged as finished background job, so it's picked up by
+// `art_data_load`.
+static ArtPreloadJob* art_load_encoded(int fid, const char* path)
+{
+    if (!art_preload_init()) {
+        return NULL;
+    }
+
+    DB_FILE* stream = db_fopen(path, "rb");
+    if (stream == NULL) {
+        return NULL;
+    }
+
+    long length = db_filelength(stream);
+    unsigned char* contents = length > 0 ? (unsigned char*)malloc(length) : NULL;
+    if (contents == NULL) {
+        db_fclose(stream);
+        return NULL;
+    }
+
+    if (db_fread(contents, 1, length, stream) != (size_t)length) {
+        free(contents);
+        db_fclose(stream);
+        return NULL;
+    }
+
+    db_fclose(stream);
+
+    int size = 0;
+    unsigned char* data = art_decode(contents, length, &size);
+    free(contents);
+
+    if (data == NULL) {
+        return NULL;
+    }
+
+    ArtPreloadJob* job = (ArtPreloadJob*)mem_malloc(sizeof(*job));
+    if (job == NULL) {
+        free(data);
+        return NULL;
+    }
+
+    job->fid = fid;
+    job->state = ART_PRELOAD_DONE;
+    job->data = data;
+    job->size = size;
+
+    SDL_LockMutex(art_preload_mutex);
+    job->next = art_preload_jobs;
+    art_preload_jobs = job;
+    SDL_UnlockMutex(art_preload_mutex);
+
+    return job;
+}
+
+// CE: Identifies game data for shared art cache, processes with different
+// data must not share art.
+static unsigned int art_cache_signature()
+{
+    const char* keys[] = {
+        GAME_CONFIG_MASTER_DAT_KEY,
+        GAME_CONFIG_MASTER_PATCHES_KEY,
+        GAME_CONFIG_CRITTER_DAT_KEY,
+        GAME_CONFIG_CRITTER_PATCHES_KEY,
+    };
+
+    // FNV-1a
+    unsigned int signature = 2166136261U;
+
+    for (int index = 0; index < sizeof(keys) / sizeof(keys[0]); index++) {
+        char* value;
+        if (!config_get_string(&game_config, GAME_CONFIG_SYSTEM_KEY, keys[index], &value)) {
+            value = NULL;
+        }
+
+        if (value != NULL) {
+            for (const char* pch = value; *pch != '\0'; pch++) {
+                signature = (signature ^ (unsigned char)*pch) * 16777619U;
+            }
+
+            // Mix in file size to tell apart different installations using
+            // default names.
+            FILE* stream = compat_fopen(value, "rb");
+            if (stream != NULL) {
+                fseek(stream, 0, SEEK_END);
+                long size = ftell(stream);
+                fclose(stream);
+
+                for (int shift = 0; shift < 32; shift += 8) {
+                    signature = (signature ^ ((unsigned int)size >> shift & 0xFF)) * 16777619U;
+                }
+            }
+        }
+
+        signature = (signature ^ '|') * 16777619U;
+    }
+
+    for (const char* pch = cd_path_base; *pch != '\0'; pch++) {
+        signature = (signature ^ (unsigned char)*pch) * 16777619U;
+    }
+
+    return signature;
+}
+
+// CE: Returns memoized entry for fid resolving its path on first use, or
+// `NULL` when memo cannot be allocated (callers should fall back to
+// `art_get_name`).
+static ArtNameEntry* art_name_lookup(int fid)
+{
+    if (art_names == NULL) {
+        art_names = (ArtNameEntry*)mem_malloc(sizeof(*art_names) * ART_NAME_CACHE_SIZE);
+        if (art_names == NULL) {
+            return NULL;
+        }
+
+        for (int index = 0; index < ART_NAME_CACHE_SIZE; index++) {
+            art_names[index].fid = -1;
+            art_names[index].flags = 0;
+            art_names[index].size = 0;
+            art_names[index].path = NULL;
+        }
+    }
+
+    unsigned int hash = (unsigned int)fid * 2654435761U;
+    ArtNameEntry* entry = &(art_names[(hash >> 16) & (ART_NAME_CACHE_SIZE - 1)]);
+    if (entry->fid == fid) {
+        return entry;
+    }
+
+    char* path = art_get_name(fid);
+    char* copy = NULL;
+    if (path != NULL) {
+        copy = mem_strdup(path);
+        if (copy == NULL) {
+            return NULL;
+        }
+    }
+
+    if (entry->path != NULL) {
+        mem_free(entry->path);
+    }
+
+    entry->fid = fid;
+    entry->flags = 0;
+    entry->size = 0;
+    entry->path = copy;
+
+    return entry;
+}
+
+// CE: Memoized version of original `art_exists` implementation.
+static bool art_name_exists(int fid)
+{
+    ArtNameEntry* entry = art_name_lookup(fid);
+    if (entry != NULL && (entry->flags & ART_NAME_EXISTS_KNOWN) != 0) {
+        return (entry->flags & ART_NAME_EXISTS) != 0;
+    }
+
+    bool result = false;
+    DB_DATABASE* oldDb = INVALID_DATABASE_HANDLE;
+
+    if (FID_TYPE(fid) == OBJ_TYPE_CRITTER) {
+        oldDb = db_current();
+        db_select(critter_db_handle);
+    }
+
+    char* filePath = entry != NULL ? entry->path : art_get_name(fid);
+    if (filePath != NULL) {
+        dir_entry de;
+        if (db_dir_entry(filePath, &de) != -1) {
+            result = true;
+        }
+    }
+
+    if (oldDb != INVALID_DATABASE_HANDLE) {
+        db_select(oldDb);
+    }
+
+    if (entry != NULL) {
+        entry->flags |= ART_NAME_EXISTS_KNOWN;
+        if (result) {
+            entry->flags |= ART_NAME_EXISTS;
+        }
+    }
+
+    return result;
+}
+
+// CE: Forgets all memoized lookups.
+static void art_name_clear()
+{
+    if (art_names == NULL) {
+        return;
+    }
+
+    for (int index = 0; index < ART_NAME_CACHE_SIZE; index++) {
+        if (art_names[index].path != NULL) {
+            mem_free(art_names[index].path);
+            art_names[index].path = NULL;
+        }
+        art_names[index].fid = -1;
+        art_names[index].flags = 0;
+        art_names[index].size = 0;
+    }
+}
+
 } // namespace fallout
@@ -75,6 +75,15 @@ typedef struct Art {
     int dataOffsets[6];
     int padding[6];
     int dataSize;
+
+    // CE: Offset (from the beginning of art) of the table of frame offsets,
+    // `frameCount` entries per rotation, see `frame_ptr`.
+    int frameTableOffset;
+
+    // CE: Offset of the table of span encoded frame offsets (laid out the
+    // same way as frame offsets), or 0 when art is not span encoded, see
+    // `art_frame_spans`.
+    int spanTableOffset;
 } Art;
 
 typedef struct ArtFrame {
@@ -126,8 +135,12 @@ Art* art_ptr_lock(int fid, CacheEntry** cache_entry);
 unsigned char* art_ptr_lock_data(int fid, int frame, int direction, CacheEntry** out_cache_entry);
 unsigned char* art_lock(int fid, CacheEntry** out_cache_entry, int* widthPtr, int* heightPtr);
 int art_ptr_unlock(CacheEntry* cache_entry);
+bool art_set_concurrent(bool enabled);
 int art_discard(int fid);
 int art_flush();
+int art_preload(const int* fids, int count);
+void art_preload_process();
+unsigned int art_dedup_saved_size();
 int art_get_base_name(int objectType, int a2, char* a3);
 int art_get_code(int a1, int a2, char* a3, char* a4);
 char* art_get_name(int a1);
@@ -142,6 +155,7 @@ int art_frame_hot(Art* art, int frame, int direction, int* a4, int* a5);
 int art_frame_offset(Art* art, int rotation, int* out_offset_x, int* out_offset_y);
 unsigned char* art_frame_data(Art* art, int frame, int direction);
 ArtFrame* frame_ptr(Art* art, int frame, int direction);
+unsigned char* art_frame_spans(Art* art, int frame, int direction);
 bool art_exists(int fid);
 bool art_fid_valid(int fid);
 int art_alias_num(int a1);
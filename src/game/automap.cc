@@ -30,6 +30,12 @@ namespace fallout {
 
 #define AUTOMAP_OFFSET_COUNT (AUTOMAP_MAP_COUNT * ELEVATION_COUNT)
 
+// Size of automap.db header (version, data size and offsets).
+#define AUTOMAP_HEADER_SIZE (1 + 4 + 4 * AUTOMAP_OFFSET_COUNT)
+
+// Size of entry header (data size and compression flag).
+#define AUTOMAP_ENTRY_HEADER_SIZE 5
+
 #define AUTOMAP_WINDOW_WIDTH 519
 #define AUTOMAP_WINDOW_HEIGHT 480
 
@@ -61,14 +67,27 @@ typedef enum AutomapFrm {
     AUTOMAP_FRM_COUNT,
 } AutomapFrm;
 
+// CE: Automap database entry kept in memory, data is stored exactly as in
+// the file (compressed unless compression did not help).
+typedef struct AutomapDbEntry {
+    unsigned char* data;
+    int dataSize;
+    unsigned char isCompressed;
+} AutomapDbEntry;
+
 static void draw_top_down_map(int window, int elevation, unsigned char* backgroundData, int flags);
-static int WriteAM_Entry(DB_FILE* stream);
+static void am_plot_object(unsigned char* windowBuffer, Object* object, int flags);
+static void am_draw_static_layer(unsigned char* windowBuffer, int elevation, unsigned char* backgroundData, int flags);
 static int AM_ReadEntry(int map, int elevation);
 static int WriteAM_Header(DB_FILE* stream);
 static int AM_ReadMainHeader(DB_FILE* stream);
 static void decode_map_data(int elevation);
 static int am_pip_init();
-static int copy_file_data(DB_FILE* stream1, DB_FILE* stream2, int length);
+static int am_db_load();
+static void am_db_free();
+static int am_db_write_entry(DB_FILE* stream, AutomapDbEntry* entry);
+static int am_db_append(int map, int elevation);
+static int am_db_rewrite();
 
 // 0x41A420
 static const int defam[AUTOMAP_MAP_COUNT][ELEVATION_COUNT] = {
@@ -155,6 +174,23 @@ static unsigned char* cmpbuf;
 // 0x56BBA4
 static unsigned char* ambuf;
 
+// CE: Entries of automap database by map and elevation, valid (along with
+// `amdbhead`) while `amdb_loaded` is set. Changed entries are appended to
+// the file, so it only has to be rewritten when superseded entries
+// (`amdb_garbage` bytes) take more space than live ones.
+static AutomapDbEntry amdb_entries[AUTOMAP_MAP_COUNT][ELEVATION_COUNT];
+static bool amdb_loaded = false;
+static int amdb_garbage = 0;
+
+// CE: Background with walls and scenery of the automap last shown, see
+// `am_draw_static_layer`.
+static unsigned char* am_static_layer = NULL;
+static bool am_static_layer_valid = false;
+static int am_static_layer_map = -1;
+static int am_static_layer_elevation = -1;
+static int am_static_layer_flags = 0;
+static unsigned int am_static_layer_epoch = 0;
+
 // 0x41A74C
 int automap_init()
 {
@@ -174,6 +210,14 @@ int automap_reset()
 // 0x41A774
 void automap_exit()
 {
+    am_db_free();
+
+    if (am_static_layer != NULL) {
+        mem_free(am_static_layer);
+        am_static_layer = NULL;
+    }
+    am_static_layer_valid = false;
+
     char* masterPatchesPath;
     if (config_get_string(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_MASTER_PATCHES_KEY, &masterPatchesPath)) {
         char path[COMPAT_MAX_PATH];
@@ -387,90 +431,22 @@ static void draw_top_down_map(int window, int elevation, unsigned char* backgrou
     win_border(window);
 
     unsigned char* windowBuffer = win_get_buf(window);
-    buf_to_buf(backgroundData, AUTOMAP_WINDOW_WIDTH, AUTOMAP_WINDOW_HEIGHT, AUTOMAP_WINDOW_WIDTH, windowBuffer, AUTOMAP_WINDOW_WIDTH);
-
-    for (Object* object = obj_find_first_at(elevation); object != NULL; object = obj_find_next_at()) {
-        if (object->tile == -1) {
-            continue;
-        }
 
-        int objectType = FID_TYPE(object->fid);
-        unsigned char objectColor;
-
-        if ((flags & AUTOMAP_IN_GAME) != 0) {
-            if (objectType == OBJ_TYPE_CRITTER
-                && (object->flags & OBJECT_HIDDEN) == 0
-                && (flags & AUTOMAP_WITH_SCANNER) != 0
-                && (object->data.critter.combat.results & DAM_DEAD) == 0) {
-                objectColor = colorTable[31744];
-            } else {
-                if ((object->flags & OBJECT_SEEN) == 0) {
-                    continue;
-                }
+    if ((flags & AUTOMAP_IN_GAME) != 0) {
+        // CE: Walls and scenery are taken from cached layer, only critters
+        // are plotted on every redraw.
+        am_draw_static_layer(windowBuffer, elevation, backgroundData, flags);
 
-                if (object->pid == PROTO_ID_0x2000031) {
-                    objectColor = colorTable[32328];
-                } else if (objectType == OBJ_TYPE_WALL) {
-                    objectColor = colorTable[992];
-                } else if (objectType == OBJ_TYPE_SCENERY
-                    && (flags & AUTOMAP_WTH_HIGH_DETAILS) != 0
-                    && object->pid != PROTO_ID_0x2000158) {
-                    objectColor = colorTable[480];
-                } else if (object == obj_dude) {
-                    objectColor = colorTable[31744];
-                } else {
-                    objectColor = colorTable[0];
-                }
+        for (Object* object = obj_find_first_of_type(OBJ_TYPE_CRITTER, elevation); object != NULL; object = obj_find_next_of_type()) {
+            if (FID_TYPE(object->fid) == OBJ_TYPE_CRITTER) {
+                am_plot_object(windowBuffer, object, flags);
             }
         }
+    } else {
+        buf_to_buf(backgroundData, AUTOMAP_WINDOW_WIDTH, AUTOMAP_WINDOW_HEIGHT, AUTOMAP_WINDOW_WIDTH, windowBuffer, AUTOMAP_WINDOW_WIDTH);
 
-        int v10 = -2 * (object->tile % 200) - 10 + AUTOMAP_WINDOW_WIDTH * (2 * (object->tile / 200) + 9) - 60;
-        if ((flags & AUTOMAP_IN_GAME) == 0) {
-            switch (objectType) {
-            case OBJ_TYPE_ITEM:
-                objectColor = colorTable[6513];
-                break;
-            case OBJ_TYPE_CRITTER:
-                objectColor = colorTable[28672];
-                break;
-            case OBJ_TYPE_SCENERY:
-                objectColor = colorTable[448];
-                break;
-            case OBJ_TYPE_WALL:
-                objectColor = colorTable[12546];
-                break;
-            case OBJ_TYPE_MISC:
-                objectColor = colorTable[31650];
-                break;
-            default:
-                objectColor = colorTable[0];
-            }
-        }
-
-        if (objectColor != colorTable[0]) {
-            unsigned char* v12 = windowBuffer + v10;
-            if ((flags & AUTOMAP_IN_GAME) != 0) {
-                if (*v12 != colorTable[992] || objectColor != colorTable[480]) {
-                    v12[0] = objectColor;
-                    v12[1] = objectColor;
-                }
-
-                if (object == obj_dude) {
-                    v12[-1] = objectColor;
-                    v12[-AUTOMAP_WINDOW_WIDTH] = objectColor;
-                    v12[AUTOMAP_WINDOW_WIDTH] = objectColor;
-                }
-            } else {
-                v12[0] = objectColor;
-                v12[1] = objectColor;
-                v12[AUTOMAP_WINDOW_WIDTH] = objectColor;
-                v12[AUTOMAP_WINDOW_WIDTH + 1] = objectColor;
-
-                v12[AUTOMAP_WINDOW_WIDTH - 1] = objectColor;
-                v12[AUTOMAP_WINDOW_WIDTH + 2] = objectColor;
-                v12[AUTOMAP_WINDOW_WIDTH * 2] = objectColor;
-                v12[AUTOMAP_WINDOW_WIDTH * 2 + 1] = objectColor;
-            }
+        for (Object* object = obj_find_first_at(elevation); object != NULL; object = obj_find_next_at()) {
+            am_plot_object(windowBuffer, object, flags);
         }
     }
 
@@ -492,6 +468,139 @@ static void draw_top_down_map(int window, int elevation, unsigned char* backgrou
     win_draw(window);
 }
 
+// CE: Plots single object on automap, extracted from `draw_top_down_map`.
+static void am_plot_object(unsigned char* windowBuffer, Object* object, int flags)
+{
+    if (object->tile == -1) {
+        return;
+    }
+
+    int objectType = FID_TYPE(object->fid);
+    unsigned char objectColor;
+
+    if ((flags & AUTOMAP_IN_GAME) != 0) {
+        if (objectType == OBJ_TYPE_CRITTER
+            && (object->flags & OBJECT_HIDDEN) == 0
+            && (flags & AUTOMAP_WITH_SCANNER) != 0
+            && (object->data.critter.combat.results & DAM_DEAD) == 0) {
+            objectColor = colorTable[31744];
+        } else {
+            if ((object->flags & OBJECT_SEEN) == 0) {
+                return;
+            }
+
+            if (object->pid == PROTO_ID_0x2000031) {
+                objectColor = colorTable[32328];
+            } else if (objectType == OBJ_TYPE_WALL) {
+                objectColor = colorTable[992];
+            } else if (objectType == OBJ_TYPE_SCENERY
+                && (flags & AUTOMAP_WTH_HIGH_DETAILS) != 0
+                && object->pid != PROTO_ID_0x2000158) {
+                objectColor = colorTable[480];
+            } else if (object == obj_dude) {
+                objectColor = colorTable[31744];
+            } else {
+                objectColor = colorTable[0];
+            }
+        }
+    }
+
+    int v10 = -2 * (object->tile % 200) - 10 + AUTOMAP_WINDOW_WIDTH * (2 * (object->tile / 200) + 9) - 60;
+    if ((flags & AUTOMAP_IN_GAME) == 0) {
+        switch (objectType) {
+        case OBJ_TYPE_ITEM:
+            objectColor = colorTable[6513];
+            break;
+        case OBJ_TYPE_CRITTER:
+            objectColor = colorTable[28672];
+            break;
+        case OBJ_TYPE_SCENERY:
+            objectColor = colorTable[448];
+            break;
+        case OBJ_TYPE_WALL:
+            objectColor = colorTable[12546];
+            break;
+        case OBJ_TYPE_MISC:
+            objectColor = colorTable[31650];
+            break;
+        default:
+            objectColor = colorTable[0];
+        }
+    }
+
+    if (objectColor != colorTable[0]) {
+        unsigned char* v12 = windowBuffer + v10;
+        if ((flags & AUTOMAP_IN_GAME) != 0) {
+            if (*v12 != colorTable[992] || objectColor != colorTable[480]) {
+                v12[0] = objectColor;
+                v12[1] = objectColor;
+            }
+
+            if (object == obj_dude) {
+                v12[-1] = objectColor;
+                v12[-AUTOMAP_WINDOW_WIDTH] = objectColor;
+                v12[AUTOMAP_WINDOW_WIDTH] = objectColor;
+            }
+        } else {
+            v12[0] = objectColor;
+            v12[1] = objectColor;
+            v12[AUTOMAP_WINDOW_WIDTH] = objectColor;
+            v12[AUTOMAP_WINDOW_WIDTH + 1] = objectColor;
+
+            v12[AUTOMAP_WINDOW_WIDTH - 1] = objectColor;
+            v12[AUTOMAP_WINDOW_WIDTH + 2] = objectColor;
+            v12[AUTOMAP_WINDOW_WIDTH * 2] = objectColor;
+            v12[AUTOMAP_WINDOW_WIDTH * 2 + 1] = objectColor;
+        }
+    }
+}
+
+// CE: Copies background with walls and scenery seen so far into window
+// buffer. The layer is rebuilt only when map, elevation, level of details
+// or any wall or scenery changes (see `obj_static_epoch`). Critters are
+// never part of it.
+static void am_draw_static_layer(unsigned char* windowBuffer, int elevation, unsigned char* backgroundData, int flags)
+{
+    int layerFlags = flags & (AUTOMAP_IN_GAME | AUTOMAP_WTH_HIGH_DETAILS);
+    int map = map_get_index_number();
+    unsigned int epoch = obj_static_epoch();
+
+    if (am_static_layer == NULL) {
+        am_static_layer = (unsigned char*)mem_malloc(AUTOMAP_WINDOW_WIDTH * AUTOMAP_WINDOW_HEIGHT);
+        am_static_layer_valid = false;
+    }
+
+    // Without cache layer is drawn directly into window.
+    unsigned char* layer = am_static_layer != NULL ? am_static_layer : windowBuffer;
+
+    if (layer == windowBuffer
+        || !am_static_layer_valid
+        || am_static_layer_map != map
+        || am_static_layer_elevation != elevation
+        || am_static_layer_flags != layerFlags
+        || am_static_layer_epoch != epoch) {
+        buf_to_buf(backgroundData, AUTOMAP_WINDOW_WIDTH, AUTOMAP_WINDOW_HEIGHT, AUTOMAP_WINDOW_WIDTH, layer, AUTOMAP_WINDOW_WIDTH);
+
+        for (Object* object = obj_find_first_at(elevation); object != NULL; object = obj_find_next_at()) {
+            if (FID_TYPE(object->fid) != OBJ_TYPE_CRITTER) {
+                am_plot_object(layer, object, flags);
+            }
+        }
+
+        if (layer == windowBuffer) {
+            return;
+        }
+
+        am_static_layer_map = map;
+        am_static_layer_elevation = elevation;
+        am_static_layer_flags = layerFlags;
+        am_static_layer_epoch = epoch;
+        am_static_layer_valid = true;
+    }
+
+    buf_to_buf(am_static_layer, AUTOMAP_WINDOW_WIDTH, AUTOMAP_WINDOW_HEIGHT, AUTOMAP_WINDOW_WIDTH, windowBuffer, AUTOMAP_WINDOW_WIDTH);
+}
+
 // Renders automap in Pipboy window.
 //
 // 0x41AF5C
@@ -561,8 +670,13 @@ int automap_pip_save()
     int map = map_get_index_number();
     int elevation = map_elevation;
 
-    int entryOffset = amdbhead.offsets[map][elevation];
-    if (entryOffset < 0) {
+    // CE: Header is taken from memory copy of database.
+    if (am_db_load() == -1) {
+        debug_printf("\nAUTOMAP: Error reading automap database file header!\n");
+        return -1;
+    }
+
+    if (amdbhead.offsets[map][elevation] < 0) {
         return 0;
     }
 
@@ -574,36 +688,16 @@ int automap_pip_save()
         cmpbuf = (unsigned char*)mem_malloc(11024);
         if (cmpbuf != NULL) {
             dataBuffersAllocated = true;
+        } else {
+            mem_free(ambuf);
         }
     }
 
     if (!dataBuffersAllocated) {
-        // FIXME: Leaking ambuf.
         debug_printf("\nAUTOMAP: Error allocating data buffers!\n");
         return -1;
     }
 
-    // NOTE: Not sure about the size.
-    char path[256];
-    snprintf(path, sizeof(path), "%s\\%s", "MAPS", AUTOMAP_DB);
-
-    DB_FILE* stream1 = db_fopen(path, "r+b");
-    if (stream1 == NULL) {
-        debug_printf("\nAUTOMAP: Error opening automap database file!\n");
-        debug_printf("Error continued: automap_pip_save: path: %s", path);
-        mem_free(ambuf);
-        mem_free(cmpbuf);
-        return -1;
-    }
-
-    if (AM_ReadMainHeader(stream1) == -1) {
-        debug_printf("\nAUTOMAP: Error reading automap database file header!\n");
-        mem_free(ambuf);
-        mem_free(cmpbuf);
-        db_fclose(stream1);
-        return -1;
-    }
-
     decode_map_data(elevation);
 
     int compressedDataSize = CompLZS(ambuf, cmpbuf, 10000);
@@ -615,278 +709,73 @@ int automap_pip_save()
         amdbsubhead.isCompressed = 1;
     }
 
-    if (entryOffset != 0) {
-        snprintf(path, sizeof(path), "%s\\%s", "MAPS", AUTOMAP_TMP);
-
-        DB_FILE* stream2 = db_fopen(path, "wb");
-        if (stream2 == NULL) {
-            debug_printf("\nAUTOMAP: Error creating temp file!\n");
-            mem_free(ambuf);
-            mem_free(cmpbuf);
-            db_fclose(stream1);
-            return -1;
-        }
-
-        db_rewind(stream1);
-
-        if (copy_file_data(stream1, stream2, entryOffset) == -1) {
-            debug_printf("\nAUTOMAP: Error copying file data!\n");
-            db_fclose(stream1);
-            db_fclose(stream2);
-            mem_free(ambuf);
-            mem_free(cmpbuf);
-            return -1;
-        }
-
-        if (WriteAM_Entry(stream2) == -1) {
-            db_fclose(stream1);
-            mem_free(ambuf);
-            mem_free(cmpbuf);
-            return -1;
-        }
-
-        int nextEntryDataSize;
-        if (db_freadInt32(stream1, &nextEntryDataSize) == -1) {
-            debug_printf("\nAUTOMAP: Error reading database #1!\n");
-            db_fclose(stream1);
-            db_fclose(stream2);
-            mem_free(ambuf);
-            mem_free(cmpbuf);
-            return -1;
-        }
-
-        int automapDataSize = db_filelength(stream1);
-        if (automapDataSize == -1) {
-            debug_printf("\nAUTOMAP: Error reading database #2!\n");
-            db_fclose(stream1);
-            db_fclose(stream2);
-            mem_free(ambuf);
-            mem_free(cmpbuf);
-            return -1;
-        }
-
-        int nextEntryOffset = entryOffset + nextEntryDataSize + 5;
-        if (automapDataSize != nextEntryOffset) {
-            if (db_fseek(stream1, nextEntryOffset, SEEK_SET) == -1) {
-                debug_printf("\nAUTOMAP: Error writing temp data!\n");
-                db_fclose(stream1);
-                db_fclose(stream2);
-                mem_free(ambuf);
-                mem_free(cmpbuf);
-                return -1;
-            }
-
-            if (copy_file_data(stream1, stream2, automapDataSize - nextEntryOffset) == -1) {
-                debug_printf("\nAUTOMAP: Error copying file data!\n");
-                db_fclose(stream1);
-                db_fclose(stream2);
-                mem_free(ambuf);
-                mem_free(cmpbuf);
-                return -1;
-            }
-        }
-
-        int diff = amdbsubhead.dataSize - nextEntryDataSize;
-        for (int map = 0; map < AUTOMAP_MAP_COUNT; map++) {
-            for (int elevation = 0; elevation < ELEVATION_COUNT; elevation++) {
-                if (amdbhead.offsets[map][elevation] > entryOffset) {
-                    amdbhead.offsets[map][elevation] += diff;
-                }
-            }
-        }
-
-        amdbhead.dataSize += diff;
-
-        if (WriteAM_Header(stream2) == -1) {
-            db_fclose(stream1);
-            mem_free(ambuf);
-            mem_free(cmpbuf);
-            return -1;
-        }
-
-        db_fseek(stream2, 0, SEEK_END);
-        db_fclose(stream2);
-        db_fclose(stream1);
+    unsigned char* data = (unsigned char*)mem_malloc(amdbsubhead.dataSize);
+    if (data == NULL) {
+        debug_printf("\nAUTOMAP: Error allocating data buffers!\n");
         mem_free(ambuf);
         mem_free(cmpbuf);
+        return -1;
+    }
 
-        char* masterPatchesPath;
-        if (!config_get_string(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_MASTER_PATCHES_KEY, &masterPatchesPath)) {
-            debug_printf("\nAUTOMAP: Error reading config info!\n");
-            return -1;
-        }
-
-        // NOTE: Not sure about the size.
-        char automapDbPath[512];
-        snprintf(automapDbPath, sizeof(automapDbPath), "%s\\%s\\%s", masterPatchesPath, "MAPS", AUTOMAP_DB);
-        if (compat_remove(automapDbPath) != 0) {
-            debug_printf("\nAUTOMAP: Error removing database!\n");
-            return -1;
-        }
-
-        // NOTE: Not sure about the size.
-        char automapTmpPath[512];
-        snprintf(automapTmpPath, sizeof(automapTmpPath), "%s\\%s\\%s", masterPatchesPath, "MAPS", AUTOMAP_TMP);
-        if (compat_rename(automapTmpPath, automapDbPath) != 0) {
-            debug_printf("\nAUTOMAP: Error renaming database!\n");
-            return -1;
-        }
-    } else {
-        bool proceed = true;
-        if (db_fseek(stream1, 0, SEEK_END) != -1) {
-            if (db_ftell(stream1) != amdbhead.dataSize) {
-                proceed = false;
-            }
-        } else {
-            proceed = false;
-        }
-
-        if (!proceed) {
-            debug_printf("\nAUTOMAP: Error reading automap database file header!\n");
-            mem_free(ambuf);
-            mem_free(cmpbuf);
-            db_fclose(stream1);
-            return -1;
-        }
-
-        if (WriteAM_Entry(stream1) == -1) {
-            mem_free(ambuf);
-            mem_free(cmpbuf);
-            return -1;
-        }
-
-        amdbhead.offsets[map][elevation] = amdbhead.dataSize;
-        amdbhead.dataSize += amdbsubhead.dataSize + 5;
+    memcpy(data, amdbsubhead.isCompressed == 1 ? cmpbuf : ambuf, amdbsubhead.dataSize);
 
-        if (WriteAM_Header(stream1) == -1) {
-            mem_free(ambuf);
-            mem_free(cmpbuf);
-            return -1;
-        }
+    mem_free(ambuf);
+    mem_free(cmpbuf);
 
-        db_fseek(stream1, 0, SEEK_END);
-        db_fclose(stream1);
-        mem_free(ambuf);
-        mem_free(cmpbuf);
+    AutomapDbEntry* entry = &(amdb_entries[map][elevation]);
+    if (entry->data != NULL) {
+        amdb_garbage += entry->dataSize + AUTOMAP_ENTRY_HEADER_SIZE;
+        mem_free(entry->data);
     }
 
-    return 1;
-}
+    entry->data = data;
+    entry->dataSize = amdbsubhead.dataSize;
+    entry->isCompressed = amdbsubhead.isCompressed;
 
-// Saves automap entry into stream.
-//
-// 0x41B798
-static int WriteAM_Entry(DB_FILE* stream)
-{
-    unsigned char* buffer;
-    if (amdbsubhead.isCompressed == 1) {
-        buffer = cmpbuf;
+    // CE: Append changed entry instead of copying the whole database into
+    // temp file. Database is compacted once superseded entries outweigh live
+    // ones.
+    int rc;
+    if (amdb_garbage > amdbhead.dataSize - amdb_garbage) {
+        rc = am_db_rewrite();
     } else {
-        buffer = ambuf;
+        rc = am_db_append(map, elevation);
     }
 
-    if (db_fwriteLong(stream, amdbsubhead.dataSize) == -1) {
-        goto err;
-    }
-
-    if (db_fwriteByte(stream, amdbsubhead.isCompressed) == -1) {
-        goto err;
-    }
-
-    if (db_fwriteByteCount(stream, buffer, amdbsubhead.dataSize) == -1) {
-        goto err;
+    if (rc == -1) {
+        // Memory copy might be ahead of the file now, reread it next time.
+        am_db_free();
+        return -1;
     }
 
-    return 0;
-
-err:
-
-    debug_printf("\nAUTOMAP: Error writing automap database entry data!\n");
-    db_fclose(stream);
-
-    return -1;
+    return 1;
 }
 
 // 0x41B820
 static int AM_ReadEntry(int map, int elevation)
 {
-    cmpbuf = NULL;
-
-    char path[COMPAT_MAX_PATH];
-    snprintf(path, sizeof(path), "%s\\%s", "MAPS", AUTOMAP_DB);
-
-    bool success = true;
-
-    DB_FILE* stream = db_fopen(path, "r+b");
-    if (stream == NULL) {
-        debug_printf("\nAUTOMAP: Error opening automap database file!\n");
-        debug_printf("Error continued: AM_ReadEntry: path: %s", path);
-        return -1;
-    }
-
-    if (AM_ReadMainHeader(stream) == -1) {
+    // CE: Entries are read from memory copy of database.
+    if (am_db_load() == -1) {
         debug_printf("\nAUTOMAP: Error reading automap database header!\n");
-        db_fclose(stream);
         return -1;
     }
 
-    if (amdbhead.offsets[map][elevation] <= 0) {
-        success = false;
-        goto out;
-    }
-
-    if (db_fseek(stream, amdbhead.offsets[map][elevation], SEEK_SET) == -1) {
-        success = false;
-        goto out;
-    }
-
-    if (db_freadInt32(stream, &(amdbsubhead.dataSize)) == -1) {
-        success = false;
-        goto out;
+    AutomapDbEntry* entry = &(amdb_entries[map][elevation]);
+    if (amdbhead.offsets[map][elevation] <= 0 || entry->data == NULL) {
+        debug_printf("\nAUTOMAP: Error reading automap database entry data!\n");
+        return -1;
     }
 
-    if (db_freadByte(stream, &(amdbsubhead.isCompressed)) == -1) {
-        success = false;
-        goto out;
-    }
+    amdbsubhead.dataSize = entry->dataSize;
+    amdbsubhead.isCompressed = entry->isCompressed;
 
-    if (amdbsubhead.isCompressed == 1) {
-        cmpbuf = (unsigned char*)mem_malloc(11024);
-        if (cmpbuf == NULL) {
-            debug_printf("\nAUTOMAP: Error allocating decompression buffer!\n");
-            db_fclose(stream);
-            return -1;
-        }
-
-        if (db_freadByteCount(stream, cmpbuf, amdbsubhead.dataSize) == -1) {
-            success = 0;
-            goto out;
-        }
-
-        if (DecodeLZS(cmpbuf, ambuf, 10000) == -1) {
+    if (entry->isCompressed == 1) {
+        if (DecodeLZS(entry->data, ambuf, 10000) == -1) {
             debug_printf("\nAUTOMAP: Error decompressing DB entry!\n");
-            db_fclose(stream);
             return -1;
         }
     } else {
-        if (db_freadByteCount(stream, ambuf, amdbsubhead.dataSize) == -1) {
-            success = false;
-            goto out;
-        }
-    }
-
-out:
-
-    db_fclose(stream);
-
-    if (!success) {
-        debug_printf("\nAUTOMAP: Error reading automap database entry data!\n");
-
-        return -1;
-    }
-
-    if (cmpbuf != NULL) {
-        mem_free(cmpbuf);
+        memcpy(ambuf, entry->data, entry->dataSize);
     }
 
     return 0;
@@ -1002,6 +891,10 @@ static int am_pip_init()
 
     db_fclose(stream);
 
+    // CE: Database is known to be empty.
+    am_db_free();
+    amdb_loaded = true;
+
     return 0;
 }
 
@@ -1015,62 +908,229 @@ int YesWriteIndex(int mapIndex, int elevation)
     return 0;
 }
 
-// Copy data from stream1 to stream2.
-//
-// 0x41BCC0
-static int copy_file_data(DB_FILE* stream1, DB_FILE* stream2, int length)
+// 0x41BDC8
+int ReadAMList(AutomapHeader** automapHeaderPtr)
 {
-    void* buffer = mem_malloc(0xFFFF);
-    if (buffer == NULL) {
+    // CE: Header is taken from memory copy of database.
+    if (am_db_load() == -1) {
+        debug_printf("\nAUTOMAP: Error reading automap database header pt2!\n");
         return -1;
     }
 
-    // NOTE: Original code is slightly different, but does the same thing.
-    while (length != 0) {
-        int chunkLength = std::min(length, 0xFFFF);
+    *automapHeaderPtr = &amdbhead;
 
-        if (db_fread(buffer, chunkLength, 1, stream1) != 1) {
-            break;
-        }
+    return 0;
+}
 
-        if (db_fwrite(buffer, chunkLength, 1, stream2) != 1) {
-            break;
+// CE: Forgets memory copy of automap database, it's read again on next use.
+// Must be called whenever database file is replaced (e.g. by loading saved
+// game).
+void automap_db_invalidate()
+{
+    am_db_free();
+}
+
+// CE: Reads header and every entry of automap database into memory unless
+// it's already there.
+static int am_db_load()
+{
+    if (amdb_loaded) {
+        return 0;
+    }
+
+    char path[COMPAT_MAX_PATH];
+    snprintf(path, sizeof(path), "%s\\%s", "MAPS", AUTOMAP_DB);
+
+    DB_FILE* stream = db_fopen(path, "rb");
+    if (stream == NULL) {
+        debug_printf("\nAUTOMAP: Error opening automap database file!\n");
+        debug_printf("Error continued: am_db_load: path: %s", path);
+        return -1;
+    }
+
+    if (AM_ReadMainHeader(stream) == -1) {
+        db_fclose(stream);
+        return -1;
+    }
+
+    int liveSize = AUTOMAP_HEADER_SIZE;
+    for (int map = 0; map < AUTOMAP_MAP_COUNT; map++) {
+        for (int elevation = 0; elevation < ELEVATION_COUNT; elevation++) {
+            int offset = amdbhead.offsets[map][elevation];
+            if (offset <= 0) {
+                continue;
+            }
+
+            AutomapDbEntry* entry = &(amdb_entries[map][elevation]);
+            if (db_fseek(stream, offset, SEEK_SET) == -1
+                || db_freadInt32(stream, &(entry->dataSize)) == -1
+                || db_freadByte(stream, &(entry->isCompressed)) == -1
+                || entry->dataSize <= 0
+                || entry->dataSize > 10000) {
+                debug_printf("\nAUTOMAP: Error reading automap database entry data!\n");
+                db_fclose(stream);
+                am_db_free();
+                return -1;
+            }
+
+            entry->data = (unsigned char*)mem_malloc(entry->dataSize);
+            if (entry->data == NULL
+                || db_freadByteCount(stream, entry->data, entry->dataSize) == -1) {
+                debug_printf("\nAUTOMAP: Error reading automap database entry data!\n");
+                db_fclose(stream);
+                am_db_free();
+                return -1;
+            }
+
+            liveSize += entry->dataSize + AUTOMAP_ENTRY_HEADER_SIZE;
         }
+    }
+
+    db_fclose(stream);
 
-        length -= chunkLength;
+    amdb_garbage = std::max(amdbhead.dataSize - liveSize, 0);
+    amdb_loaded = true;
+
+    return 0;
+}
+
+// CE: Releases memory copy of automap database.
+static void am_db_free()
+{
+    for (int map = 0; map < AUTOMAP_MAP_COUNT; map++) {
+        for (int elevation = 0; elevation < ELEVATION_COUNT; elevation++) {
+            AutomapDbEntry* entry = &(amdb_entries[map][elevation]);
+            if (entry->data != NULL) {
+                mem_free(entry->data);
+                entry->data = NULL;
+            }
+        }
     }
 
-    mem_free(buffer);
+    amdb_garbage = 0;
+    amdb_loaded = false;
+}
 
-    if (length != 0) {
+// CE: Saves automap entry into stream.
+static int am_db_write_entry(DB_FILE* stream, AutomapDbEntry* entry)
+{
+    if (db_fwriteLong(stream, entry->dataSize) == -1
+        || db_fwriteByte(stream, entry->isCompressed) == -1
+        || db_fwriteByteCount(stream, entry->data, entry->dataSize) == -1) {
+        debug_printf("\nAUTOMAP: Error writing automap database entry data!\n");
         return -1;
     }
 
     return 0;
 }
 
-// 0x41BDC8
-int ReadAMList(AutomapHeader** automapHeaderPtr)
+// CE: Appends entry at the end of database file and points header to it.
+// Previous data of this entry (if any) is left in place. Falls back to
+// rewriting database if file does not end where header says.
+static int am_db_append(int map, int elevation)
 {
     char path[COMPAT_MAX_PATH];
     snprintf(path, sizeof(path), "%s\\%s", "MAPS", AUTOMAP_DB);
 
-    DB_FILE* stream = db_fopen(path, "rb");
+    DB_FILE* stream = db_fopen(path, "r+b");
     if (stream == NULL) {
-        debug_printf("\nAUTOMAP: Error opening database file for reading!\n");
-        debug_printf("Error continued: ReadAMList: path: %s", path);
+        debug_printf("\nAUTOMAP: Error opening automap database file!\n");
+        debug_printf("Error continued: am_db_append: path: %s", path);
         return -1;
     }
 
-    if (AM_ReadMainHeader(stream) == -1) {
-        debug_printf("\nAUTOMAP: Error reading automap database header pt2!\n");
+    if (db_fseek(stream, 0, SEEK_END) == -1 || db_ftell(stream) != amdbhead.dataSize) {
+        db_fclose(stream);
+        return am_db_rewrite();
+    }
+
+    AutomapDbEntry* entry = &(amdb_entries[map][elevation]);
+    if (am_db_write_entry(stream, entry) == -1) {
         db_fclose(stream);
         return -1;
     }
 
+    amdbhead.offsets[map][elevation] = amdbhead.dataSize;
+    amdbhead.dataSize += entry->dataSize + AUTOMAP_ENTRY_HEADER_SIZE;
+
+    // NOTE: Closes stream on error.
+    if (WriteAM_Header(stream) == -1) {
+        return -1;
+    }
+
+    db_fseek(stream, 0, SEEK_END);
     db_fclose(stream);
 
-    *automapHeaderPtr = &amdbhead;
+    return 0;
+}
+
+// CE: Writes live entries from memory into temp file which then replaces
+// database.
+static int am_db_rewrite()
+{
+    int dataSize = AUTOMAP_HEADER_SIZE;
+    for (int map = 0; map < AUTOMAP_MAP_COUNT; map++) {
+        for (int elevation = 0; elevation < ELEVATION_COUNT; elevation++) {
+            AutomapDbEntry* entry = &(amdb_entries[map][elevation]);
+            if (entry->data != NULL) {
+                amdbhead.offsets[map][elevation] = dataSize;
+                dataSize += entry->dataSize + AUTOMAP_ENTRY_HEADER_SIZE;
+            }
+        }
+    }
+    amdbhead.dataSize = dataSize;
+
+    char path[COMPAT_MAX_PATH];
+    snprintf(path, sizeof(path), "%s\\%s", "MAPS", AUTOMAP_TMP);
+
+    DB_FILE* stream = db_fopen(path, "wb");
+    if (stream == NULL) {
+        debug_printf("\nAUTOMAP: Error creating temp file!\n");
+        return -1;
+    }
+
+    // NOTE: Closes stream on error.
+    if (WriteAM_Header(stream) == -1) {
+        return -1;
+    }
+
+    for (int map = 0; map < AUTOMAP_MAP_COUNT; map++) {
+        for (int elevation = 0; elevation < ELEVATION_COUNT; elevation++) {
+            AutomapDbEntry* entry = &(amdb_entries[map][elevation]);
+            if (entry->data != NULL) {
+                if (am_db_write_entry(stream, entry) == -1) {
+                    db_fclose(stream);
+                    return -1;
+                }
+            }
+        }
+    }
+
+    db_fclose(stream);
+
+    char* masterPatchesPath;
+    if (!config_get_string(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_MASTER_PATCHES_KEY, &masterPatchesPath)) {
+        debug_printf("\nAUTOMAP: Error reading config info!\n");
+        return -1;
+    }
+
+    // NOTE: Not sure about the size.
+    char automapDbPath[512];
+    snprintf(automapDbPath, sizeof(automapDbPath), "%s\\%s\\%s", masterPatchesPath, "MAPS", AUTOMAP_DB);
+    if (compat_remove(automapDbPath) != 0) {
+        debug_printf("\nAUTOMAP: Error removing database!\n");
+        return -1;
+    }
+
+    // NOTE: Not sure about the size.
+    char automapTmpPath[512];
+    snprintf(automapTmpPath, sizeof(automapTmpPath), "%s\\%s\\%s", masterPatchesPath, "MAPS", AUTOMAP_TMP);
+    if (compat_rename(automapTmpPath, automapDbPath) != 0) {
+        debug_printf("\nAUTOMAP: Error renaming database!\n");
+        return -1;
+    }
+
+    amdb_garbage = 0;
 
     return 0;
 }
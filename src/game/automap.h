@@ -42,6 +42,7 @@ int draw_top_down_map_pipboy(int win, int map, int elevation);
 int automap_pip_save();
 int YesWriteIndex(int mapIndex, int elevation);
 int ReadAMList(AutomapHeader** automapHeaderPtr);
+void automap_db_invalidate();
 
 } // namespace fallout
 
@@ -5,25 +5,37 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <SDL.h>
+
+#include "game/shmcache.h"
 #include "int/sound.h"
 #include "plib/gnw/debug.h"
 #include "plib/gnw/memory.h"
 
 namespace fallout {
 
-static bool cache_add(Cache* cache, int key, int* indexPtr);
-static bool cache_insert(Cache* cache, CacheEntry* cacheEntry, int index);
-static int cache_find(Cache* cache, int key, int* indexPtr);
+static bool cache_add(Cache* cache, int key, CacheEntry** cacheEntryPtr);
+static bool cache_add_shared(Cache* cache, int key, CacheEntry** cacheEntryPtr);
+static bool cache_insert(Cache* cache, CacheEntry* cacheEntry);
+static CacheEntry* cache_find(Cache* cache, int key);
 static int cache_create_item(CacheEntry** cacheEntryPtr);
 static bool cache_init_item(CacheEntry* cacheEntry);
 static bool cache_destroy_item(Cache* cache, CacheEntry* cacheEntry);
 static bool cache_unlock_all(Cache* cache);
 static bool cache_reset_counter(Cache* cache);
 static bool cache_make_room(Cache* cache, int size);
-static bool cache_purge(Cache* cache);
+static void cache_remove(Cache* cache, CacheEntry* cacheEntry);
 static bool cache_resize_array(Cache* cache, int newCapacity);
-static int cache_compare_make_room(const void* a1, const void* a2);
-static int cache_compare_reset_counter(const void* a1, const void* a2);
+static bool cache_resize_buckets(Cache* cache, int newCapacity);
+static unsigned int cache_bucket(Cache* cache, int key);
+static void cache_lru_push(Cache* cache, CacheEntry* cacheEntry);
+static void cache_lru_remove(Cache* cache, CacheEntry* cacheEntry);
+static unsigned int cache_tier_bucket(int key);
+static CacheTierEntry* cache_tier_take(Cache* cache, int key);
+static void cache_tier_store(Cache* cache, CacheEntry* cacheEntry);
+static void cache_tier_free(CacheTierEntry* tierEntry);
+static int cache_tier_compress(const unsigned char* src, int size, unsigned char* dest);
+static bool cache_tier_decompress(const unsigned char* src, int compressedSize, unsigned char* dest, int size);
 
 // 0x4FEC7C
 static int lock_sound_ticker = 0;
@@ -31,7 +43,13 @@ static int lock_sound_ticker = 0;
 // 0x41E9C0
 bool cache_init(Cache* cache, CacheSizeProc* sizeProc, CacheReadProc* readProc, CacheFreeProc* freeProc, int maxSize)
 {
-    if (!heap_init(&(cache->heap), maxSize)) {
+    return cache_init_with_heap_type(cache, sizeProc, readProc, freeProc, maxSize, HEAP_TYPE_COMPACTING);
+}
+
+// CE: Same as `cache_init` with explicit heap backend (one of `HeapType`).
+bool cache_init_with_heap_type(Cache* cache, CacheSizeProc* sizeProc, CacheReadProc* readProc, CacheFreeProc* freeProc, int maxSize, int heapType)
+{
+    if (!heap_init_with_type(&(cache->heap), maxSize, heapType)) {
         return false;
     }
 
@@ -44,6 +62,27 @@ bool cache_init(Cache* cache, CacheSizeProc* sizeProc, CacheReadProc* readProc,
     cache->sizeProc = sizeProc;
     cache->readProc = readProc;
     cache->freeProc = freeProc;
+    cache->buckets = NULL;
+    cache->bucketsCapacity = 0;
+    cache->lruHead = NULL;
+    cache->lruTail = NULL;
+    cache->lookupHits = 0;
+    cache->lookupMisses = 0;
+    cache->evictions = 0;
+    cache->reads = 0;
+    cache->readTicks = 0;
+    cache->lockedEntries = 0;
+    cache->lockedSize = 0;
+    cache->tierBuckets = NULL;
+    cache->tierHead = NULL;
+    cache->tierTail = NULL;
+    cache->tierEntriesLength = 0;
+    cache->tierSize = 0;
+    cache->tierMaxSize = 0;
+    cache->tierHits = 0;
+    cache->shared = false;
+    cache->sharedHits = 0;
+    cache->sharedEntries = 0;
 
     if (cache->entries == NULL) {
         return false;
@@ -51,6 +90,12 @@ bool cache_init(Cache* cache, CacheSizeProc* sizeProc, CacheReadProc* readProc,
 
     memset(cache->entries, 0, sizeof(*cache->entries) * cache->entriesCapacity);
 
+    if (!cache_resize_buckets(cache, CACHE_BUCKETS_INITIAL_CAPACITY)) {
+        mem_free(cache->entries);
+        cache->entries = NULL;
+        return false;
+    }
+
     return true;
 }
 
@@ -61,6 +106,9 @@ bool cache_exit(Cache* cache)
         return false;
     }
 
+    // CE: Release second tier first so flush does not compress entries.
+    cache_set_second_tier(cache, 0);
+
     cache_unlock_all(cache);
     cache_flush(cache);
     heap_exit(&(cache->heap));
@@ -76,6 +124,15 @@ bool cache_exit(Cache* cache)
         cache->entries = NULL;
     }
 
+    if (cache->buckets != NULL) {
+        mem_free(cache->buckets);
+        cache->buckets = NULL;
+    }
+
+    cache->bucketsCapacity = 0;
+    cache->lruHead = NULL;
+    cache->lruTail = NULL;
+
     cache->sizeProc = NULL;
     cache->readProc = NULL;
     cache->freeProc = NULL;
@@ -86,13 +143,11 @@ bool cache_exit(Cache* cache)
 // 0x41EAC0
 int cache_query(Cache* cache, int key)
 {
-    int index;
-
     if (cache == NULL) {
         return 0;
     }
 
-    if (cache_find(cache, key, &index) != 2) {
+    if (cache_find(cache, key) == NULL) {
         return 0;
     }
 
@@ -108,35 +163,43 @@ bool cache_lock(Cache* cache, int key, void** data, CacheEntry** cacheEntryPtr)
 
     *cacheEntryPtr = NULL;
 
-    int index;
-    int rc = cache_find(cache, key, &index);
-    if (rc == 2) {
+    CacheEntry* cacheEntry = cache_find(cache, key);
+    if (cacheEntry != NULL) {
         // Use existing cache entry.
-        CacheEntry* cacheEntry = cache->entries[index];
         cacheEntry->hits++;
-    } else if (rc == 3) {
+        cache->lookupHits++;
+    } else {
+        cache->lookupMisses++;
+
         // New cache entry is required.
         if (cache->entriesLength >= INT_MAX) {
             return false;
         }
 
-        if (!cache_add(cache, key, &index)) {
-            return false;
+        // CE: Try shared cache segment first, fall back to private cache
+        // when the entry cannot be shared.
+        if (!(cache->shared && cache_add_shared(cache, key, &cacheEntry))) {
+            if (!cache_add(cache, key, &cacheEntry)) {
+                return false;
+            }
         }
 
         lock_sound_ticker %= 4;
         if (lock_sound_ticker == 0) {
             soundUpdate();
         }
-    } else {
-        return false;
     }
 
-    CacheEntry* cacheEntry = cache->entries[index];
-    if (cacheEntry->referenceCount == 0) {
+    // CE: Shared entries are mapped for their whole lifetime.
+    if (cacheEntry->referenceCount == 0 && (cacheEntry->flags & CACHE_ENTRY_SHARED) == 0) {
         if (!heap_lock(&(cache->heap), cacheEntry->heapHandleIndex, &(cacheEntry->data))) {
             return false;
         }
+
+        cache_lru_remove(cache, cacheEntry);
+
+        cache->lockedEntries++;
+        cache->lockedSize += cacheEntry->size;
     }
 
     cacheEntry->referenceCount++;
@@ -168,7 +231,18 @@ bool cache_unlock(Cache* cache, CacheEntry* cacheEntry)
     cacheEntry->referenceCount--;
 
     if (cacheEntry->referenceCount == 0) {
+        // CE: Shared entries are only kept while locked, so that other
+        // processes can evict them.
+        if ((cacheEntry->flags & CACHE_ENTRY_SHARED) != 0) {
+            cache_remove(cache, cacheEntry);
+            return true;
+        }
+
         heap_unlock(&(cache->heap), cacheEntry->heapHandleIndex);
+        cache_lru_push(cache, cacheEntry);
+
+        cache->lockedEntries--;
+        cache->lockedSize -= cacheEntry->size;
     }
 
     return true;
@@ -177,25 +251,28 @@ bool cache_unlock(Cache* cache, CacheEntry* cacheEntry)
 // 0x41EDEC
 int cache_discard(Cache* cache, int key)
 {
-    int index;
     CacheEntry* cacheEntry;
 
     if (cache == NULL) {
         return 0;
     }
 
-    if (cache_find(cache, key, &index) != 2) {
+    // CE: Discarded entry should not be resurrected from the second tier.
+    CacheTierEntry* tierEntry = cache_tier_take(cache, key);
+    if (tierEntry != NULL) {
+        cache_tier_free(tierEntry);
+    }
+
+    cacheEntry = cache_find(cache, key);
+    if (cacheEntry == NULL) {
         return 0;
     }
 
-    cacheEntry = cache->entries[index];
     if (cacheEntry->referenceCount != 0) {
         return 0;
     }
 
-    cacheEntry->flags |= CACHE_ENTRY_MARKED_FOR_EVICTION;
-
-    cache_purge(cache);
+    cache_remove(cache, cacheEntry);
 
     return 1;
 }
@@ -207,17 +284,13 @@ bool cache_flush(Cache* cache)
         return false;
     }
 
-    // Loop thru cache entries and mark those with no references for eviction.
-    for (int index = 0; index < cache->entriesLength; index++) {
-        CacheEntry* cacheEntry = cache->entries[index];
-        if (cacheEntry->referenceCount == 0) {
-            cacheEntry->flags |= CACHE_ENTRY_MARKED_FOR_EVICTION;
-        }
+    // CE: Evict all entries with no references (which are exactly the ones
+    // in LRU list).
+    while (cache->lruTail != NULL) {
+        cache_tier_store(cache, cache->lruTail);
+        cache_remove(cache, cache->lruTail);
     }
 
-    // Sweep cache entries marked earlier.
-    cache_purge(cache);
-
     // Shrink cache entries array if it's too big.
     int optimalCapacity = cache->entriesLength + CACHE_ENTRIES_GROW_CAPACITY;
     if (optimalCapacity < cache->entriesCapacity) {
@@ -250,7 +323,109 @@ bool cache_stats(Cache* cache, char* dest, size_t size)
         return false;
     }
 
-    snprintf(dest, size, "Cache stats are disabled.%s", "\n");
+    // CE: Original code reports "Cache stats are disabled.".
+    CacheStats stats;
+    cache_get_stats(cache, &stats);
+
+    snprintf(dest, size, "Cache: %u hits, %u misses, %u evictions, %d entries (%d locked), %d/%d bytes (%d locked), %u reads in %.1f ms\n",
+        stats.hits,
+        stats.misses,
+        stats.evictions,
+        stats.entries,
+        stats.lockedEntries,
+        stats.size,
+        stats.maxSize,
+        stats.lockedSize,
+        stats.reads,
+        stats.readTime);
+
+    return true;
+}
+
+// CE: Fills structured cache statistics.
+bool cache_get_stats(Cache* cache, CacheStats* stats)
+{
+    if (cache == NULL || stats == NULL) {
+        return false;
+    }
+
+    stats->hits = cache->lookupHits;
+    stats->misses = cache->lookupMisses;
+    stats->evictions = cache->evictions;
+    stats->entries = cache->entriesLength;
+    stats->lockedEntries = cache->lockedEntries;
+    stats->size = cache->size;
+    stats->lockedSize = cache->lockedSize;
+    stats->maxSize = cache->maxSize;
+    stats->averageEntrySize = cache->entriesLength - cache->sharedEntries != 0 ? cache->size / (cache->entriesLength - cache->sharedEntries) : 0;
+    stats->reads = cache->reads;
+    stats->readTime = (double)cache->readTicks * 1000.0 / (double)SDL_GetPerformanceFrequency();
+    stats->secondTierHits = cache->tierHits;
+    stats->secondTierEntries = cache->tierEntriesLength;
+    stats->secondTierSize = cache->tierSize;
+    stats->secondTierMaxSize = cache->tierMaxSize;
+    stats->sharedHits = cache->sharedHits;
+    stats->sharedEntries = cache->sharedEntries;
+
+    return true;
+}
+
+// CE: Enables second tier which keeps evicted entries compressed within
+// given byte budget, so misses can be served without `readProc`. Passing
+// zero disables second tier and releases its contents.
+//
+// Compression only collapses runs of zero bytes, which is cheap and works
+// well for art (transparent pixels), entries must not depend on their
+// address (they are already moved by heap compaction).
+bool cache_set_second_tier(Cache* cache, int maxSize)
+{
+    if (cache == NULL) {
+        return false;
+    }
+
+    if (maxSize < 0) {
+        maxSize = 0;
+    }
+
+    if (maxSize != 0 && cache->tierBuckets == NULL) {
+        cache->tierBuckets = (CacheTierEntry**)mem_malloc(sizeof(*cache->tierBuckets) * CACHE_TIER_BUCKETS_CAPACITY);
+        if (cache->tierBuckets == NULL) {
+            return false;
+        }
+
+        memset(cache->tierBuckets, 0, sizeof(*cache->tierBuckets) * CACHE_TIER_BUCKETS_CAPACITY);
+    }
+
+    cache->tierMaxSize = maxSize;
+
+    // Shrink to the new budget.
+    while (cache->tierTail != NULL && cache->tierSize > cache->tierMaxSize) {
+        cache_tier_free(cache_tier_take(cache, cache->tierTail->key));
+    }
+
+    if (maxSize == 0 && cache->tierBuckets != NULL) {
+        mem_free(cache->tierBuckets);
+        cache->tierBuckets = NULL;
+    }
+
+    return true;
+}
+
+// CE: Makes cache look up entries in shared cache segment (see
+// `shmcache_open`) before reading them into private heap, so processes
+// running the same game data can reuse each other's entries. Shared entries
+// are mapped read-only and are kept only while locked.
+bool cache_set_shared(Cache* cache, bool shared)
+{
+    if (cache == NULL) {
+        return false;
+    }
+
+    if (shared && !shmcache_is_open()) {
+        return false;
+    }
+
+    cache->shared = shared;
 
     return true;
 }
@@ -358,7 +533,7 @@ int cache_destroy_list(int** tagsPtr)
 // Fetches entry for the specified key into the cache.
 //
 // 0x41F0AC
-static bool cache_add(Cache* cache, int key, int* indexPtr)
+static bool cache_add(Cache* cache, int key, CacheEntry** cacheEntryPtr)
 {
     CacheEntry* cacheEntry;
 
@@ -367,9 +542,15 @@ static bool cache_add(Cache* cache, int key, int* indexPtr)
         return 0;
     }
 
+    // CE: Take compressed copy out of the second tier, so that making room
+    // below does not evict it.
+    CacheTierEntry* tierEntry = cache_tier_take(cache, key);
+
     do {
         int size;
-        if (cache->sizeProc(key, &size) != 0) {
+        if (tierEntry != NULL) {
+            size = tierEntry->size;
+        } else if (cache->sizeProc(key, &size) != 0) {
             break;
         }
 
@@ -415,8 +596,21 @@ static bool cache_add(Cache* cache, int key, int* indexPtr)
                 break;
             }
 
-            if (cache->readProc(key, &size, cacheEntry->data) != 0) {
-                break;
+            if (tierEntry != NULL) {
+                if (!cache_tier_decompress(tierEntry->data, tierEntry->compressedSize, cacheEntry->data, size)) {
+                    break;
+                }
+
+                cache->tierHits++;
+            } else {
+                Uint64 readStart = SDL_GetPerformanceCounter();
+                int rc = cache->readProc(key, &size, cacheEntry->data);
+                cache->readTicks += SDL_GetPerformanceCounter() - readStart;
+                cache->reads++;
+
+                if (rc != 0) {
+                    break;
+                }
             }
 
             heap_unlock(&(cache->heap), cacheEntry->heapHandleIndex);
@@ -424,23 +618,20 @@ static bool cache_add(Cache* cache, int key, int* indexPtr)
             cacheEntry->size = size;
             cacheEntry->key = key;
 
-            bool isNewKey = true;
-            if (*indexPtr < cache->entriesLength) {
-                if (key < cache->entries[*indexPtr]->key) {
-                    if (*indexPtr == 0 || key > cache->entries[*indexPtr - 1]->key) {
-                        isNewKey = false;
-                    }
-                }
+            // CE: Read proc can fetch other entries (which might end up
+            // evicting things or even adding the same key).
+            if (cache_find(cache, key) != NULL) {
+                break;
             }
 
-            if (isNewKey) {
-                if (cache_find(cache, key, indexPtr) != 3) {
-                    break;
-                }
+            if (!cache_insert(cache, cacheEntry)) {
+                break;
             }
 
-            if (!cache_insert(cache, cacheEntry, *indexPtr)) {
-                break;
+            *cacheEntryPtr = cacheEntry;
+
+            if (tierEntry != NULL) {
+                cache_tier_free(tierEntry);
             }
 
             return true;
@@ -449,14 +640,84 @@ static bool cache_add(Cache* cache, int key, int* indexPtr)
         heap_unlock(&(cache->heap), cacheEntry->heapHandleIndex);
     } while (0);
 
+    if (tierEntry != NULL) {
+        cache_tier_free(tierEntry);
+    }
+
     // NOTE: Uninline.
     cache_destroy_item(cache, cacheEntry);
 
     return false;
 }
 
+// CE: Fetches entry for the specified key from shared cache segment,
+// publishing it there first when no other process did. Returns `false` if
+// entry should be cached privately instead (segment is full, or entry is
+// being published by someone else).
+static bool cache_add_shared(Cache* cache, int key, CacheEntry** cacheEntryPtr)
+{
+    int slot;
+    unsigned char* data;
+    int size;
+
+    int rc = shmcache_acquire(key, &slot, &data, &size);
+    if (rc == SHMCACHE_ACQUIRE_BUSY) {
+        return false;
+    }
+
+    if (rc == SHMCACHE_ACQUIRE_OK) {
+        cache->sharedHits++;
+    } else {
+        if (cache->sizeProc(key, &size) != 0) {
+            return false;
+        }
+
+        unsigned char* buffer;
+        if (!shmcache_begin(key, size, &slot, &buffer)) {
+            return false;
+        }
+
+        Uint64 readStart = SDL_GetPerformanceCounter();
+        rc = cache->readProc(key, &size, buffer);
+        cache->readTicks += SDL_GetPerformanceCounter() - readStart;
+        cache->reads++;
+
+        if (rc != 0) {
+            shmcache_abort(slot);
+            return false;
+        }
+
+        data = shmcache_commit(slot, size);
+    }
+
+    CacheEntry* cacheEntry;
+
+    // NOTE: Uninline.
+    if (cache_create_item(&cacheEntry) != 1) {
+        shmcache_release(slot);
+        return false;
+    }
+
+    cacheEntry->key = key;
+    cacheEntry->size = size;
+    cacheEntry->data = data;
+    cacheEntry->flags = CACHE_ENTRY_SHARED;
+    cacheEntry->heapHandleIndex = slot;
+
+    // Read proc can fetch other entries (including the same key).
+    if (cache_find(cache, key) != NULL || !cache_insert(cache, cacheEntry)) {
+        // NOTE: Uninline.
+        cache_destroy_item(cache, cacheEntry);
+        return false;
+    }
+
+    *cacheEntryPtr = cacheEntry;
+
+    return true;
+}
+
 // 0x41F2E8
-static bool cache_insert(Cache* cache, CacheEntry* cacheEntry, int index)
+static bool cache_insert(Cache* cache, CacheEntry* cacheEntry)
 {
     // Ensure cache have enough space for new entry.
     if (cache->entriesLength == cache->entriesCapacity - 1) {
@@ -465,58 +726,52 @@ static bool cache_insert(Cache* cache, CacheEntry* cacheEntry, int index)
         }
     }
 
-    // Move entries below insertion point.
-    memmove(&(cache->entries[index + 1]), &(cache->entries[index]), sizeof(*cache->entries) * (cache->entriesLength - index));
+    // CE: Keep load factor of hash index under one. Failure to grow is not
+    // fatal, chains just become longer.
+    if (cache->entriesLength >= cache->bucketsCapacity) {
+        cache_resize_buckets(cache, cache->bucketsCapacity * 2);
+    }
+
+    unsigned int bucket = cache_bucket(cache, cacheEntry->key);
+    cacheEntry->nextInBucket = cache->buckets[bucket];
+    cache->buckets[bucket] = cacheEntry;
 
-    cache->entries[index] = cacheEntry;
+    cacheEntry->index = cache->entriesLength;
+    cache->entries[cache->entriesLength] = cacheEntry;
     cache->entriesLength++;
+
+    // CE: Shared entries do not occupy private heap.
+    if ((cacheEntry->flags & CACHE_ENTRY_SHARED) != 0) {
+        cache->sharedEntries++;
+        return true;
+    }
+
     cache->size += cacheEntry->size;
 
+    // New entry is not locked yet.
+    cache_lru_push(cache, cacheEntry);
+
     return true;
 }
 
-// Finds index for given key.
+// Finds entry for given key.
 //
-// Returns 2 if entry already exists in cache, or 3 if entry does not exist. In
-// this case indexPtr represents insertion point.
+// CE: Original code performs binary search over sorted `entries` (which
+// degrades to linear scan due to a bug). Returns `NULL` if entry does not
+// exist.
 //
 // 0x41F354
-static int cache_find(Cache* cache, int key, int* indexPtr)
+static CacheEntry* cache_find(Cache* cache, int key)
 {
-    int length = cache->entriesLength;
-    if (length == 0) {
-        *indexPtr = 0;
-        return 3;
-    }
-
-    int r = length - 1;
-    int l = 0;
-    int mid;
-    int cmp;
-
-    do {
-        mid = (l + r) / 2;
-
-        cmp = key - cache->entries[mid]->key;
-        if (cmp == 0) {
-            *indexPtr = mid;
-            return 2;
+    CacheEntry* cacheEntry = cache->buckets[cache_bucket(cache, key)];
+    while (cacheEntry != NULL) {
+        if (cacheEntry->key == key) {
+            return cacheEntry;
         }
-
-        if (cmp > 0) {
-            l = l + 1;
-        } else {
-            r = r - 1;
-        }
-    } while (r >= l);
-
-    if (cmp < 0) {
-        *indexPtr = mid;
-    } else {
-        *indexPtr = mid + 1;
+        cacheEntry = cacheEntry->nextInBucket;
     }
 
-    return 3;
+    return NULL;
 }
 
 // 0x41F3C0
@@ -543,13 +798,19 @@ static bool cache_init_item(CacheEntry* cacheEntry)
     cacheEntry->hits = 0;
     cacheEntry->flags = 0;
     cacheEntry->mru = 0;
+    cacheEntry->index = -1;
+    cacheEntry->nextInBucket = NULL;
+    cacheEntry->prev = NULL;
+    cacheEntry->next = NULL;
     return true;
 }
 
 // 0x41F440
 static bool cache_destroy_item(Cache* cache, CacheEntry* cacheEntry)
 {
-    if (cacheEntry->data != NULL) {
+    if ((cacheEntry->flags & CACHE_ENTRY_SHARED) != 0) {
+        shmcache_release(cacheEntry->heapHandleIndex);
+    } else if (cacheEntry->data != NULL) {
         heap_deallocate(&(cache->heap), &(cacheEntry->heapHandleIndex));
     }
 
@@ -562,18 +823,30 @@ static bool cache_destroy_item(Cache* cache, CacheEntry* cacheEntry)
 static bool cache_unlock_all(Cache* cache)
 {
     Heap* heap = &(cache->heap);
-    for (int index = 0; index < cache->entriesLength; index++) {
+
+    // CE: Iterate backwards since removing shared entries moves the last
+    // entry into the hole.
+    for (int index = cache->entriesLength - 1; index >= 0; index--) {
         CacheEntry* cacheEntry = cache->entries[index];
 
+        if ((cacheEntry->flags & CACHE_ENTRY_SHARED) != 0) {
+            cache_remove(cache, cacheEntry);
+            continue;
+        }
+
         // NOTE: Original code is slightly different. For unknown reason it uses
         // inner loop to decrement `referenceCount` one by one. Probably using
         // some inlined function.
         if (cacheEntry->referenceCount != 0) {
             heap_unlock(heap, cacheEntry->heapHandleIndex);
             cacheEntry->referenceCount = 0;
+            cache_lru_push(cache, cacheEntry);
         }
     }
 
+    cache->lockedEntries = 0;
+    cache->lockedSize = 0;
+
     return true;
 }
 
@@ -584,23 +857,21 @@ static bool cache_reset_counter(Cache* cache)
         return false;
     }
 
-    CacheEntry** entries = (CacheEntry**)mem_malloc(sizeof(*entries) * cache->entriesLength);
-    if (entries == NULL) {
-        return false;
-    }
-
-    memcpy(entries, cache->entries, sizeof(*entries) * cache->entriesLength);
-
-    qsort(entries, cache->entriesLength, sizeof(*entries), cache_compare_reset_counter);
-
+    // CE: `mru` is no longer used for eviction (see `lruHead`), so there is no
+    // need to sort entries. Renumber in LRU order to keep values meaningful.
+    unsigned int mru = 0;
     for (int index = 0; index < cache->entriesLength; index++) {
-        CacheEntry* cacheEntry = entries[index];
-        cacheEntry->mru = index;
+        CacheEntry* cacheEntry = cache->entries[index];
+        if (cacheEntry->referenceCount != 0) {
+            cacheEntry->mru = ++mru;
+        }
     }
 
-    cache->hits = cache->entriesLength;
+    for (CacheEntry* cacheEntry = cache->lruTail; cacheEntry != NULL; cacheEntry = cacheEntry->prev) {
+        cacheEntry->mru = ++mru;
+    }
 
-    // FIXME: Obviously leak `entries`.
+    cache->hits = mru;
 
     return true;
 }
@@ -621,61 +892,21 @@ static bool cache_make_room(Cache* cache, int size)
         return true;
     }
 
-    CacheEntry** entries = (CacheEntry**)mem_malloc(sizeof(*entries) * cache->entriesLength);
-    if (entries != NULL) {
-        memcpy(entries, cache->entries, sizeof(*entries) * cache->entriesLength);
-        qsort(entries, cache->entriesLength, sizeof(*entries), cache_compare_make_room);
-
-        // The sweeping threshold is 20% of cache size plus size for the new
-        // entry. Once the threshold is reached the marking process stops.
-        int threshold = size + (int)((double)cache->size * 0.2);
-
-        int accum = 0;
-        int index;
-        for (index = 0; index < cache->entriesLength; index++) {
-            CacheEntry* entry = entries[index];
-            if (entry->referenceCount == 0) {
-                if (entry->size >= threshold) {
-                    entry->flags |= CACHE_ENTRY_MARKED_FOR_EVICTION;
-
-                    // We've just found one huge entry, there is no point to
-                    // mark individual smaller entries in the code path below,
-                    // reset the accumulator to skip it entirely.
-                    accum = 0;
-                    break;
-                } else {
-                    accum += entry->size;
-
-                    if (accum >= threshold) {
-                        break;
-                    }
-                }
-            }
-        }
-
-        if (accum != 0) {
-            // The loop below assumes index to be positioned on the entry, where
-            // accumulator stopped. If we've reached the end, reposition
-            // it to the last entry.
-            if (index == cache->entriesLength) {
-                index -= 1;
-            }
-
-            // Loop backwards from the point we've stopped and mark all
-            // unreferenced entries for sweeping.
-            for (; index >= 0; index--) {
-                CacheEntry* entry = entries[index];
-                if (entry->referenceCount == 0) {
-                    entry->flags |= CACHE_ENTRY_MARKED_FOR_EVICTION;
-                }
-            }
-        }
-
-        mem_free(entries);
+    // The sweeping threshold is 20% of cache size plus size for the new
+    // entry. Once the threshold is reached the eviction stops.
+    //
+    // CE: Original code picks victims by sorting all entries by number of
+    // hits and recency. Now the least recently used unlocked entries are
+    // evicted in order.
+    int threshold = size + (int)((double)cache->size * 0.2);
+
+    int accum = 0;
+    while (cache->lruTail != NULL && accum < threshold) {
+        accum += cache->lruTail->size;
+        cache_tier_store(cache, cache->lruTail);
+        cache_remove(cache, cache->lruTail);
     }
 
-    cache_purge(cache);
-
     if (cache->maxSize - cache->size >= size) {
         return true;
     }
@@ -683,35 +914,33 @@ static bool cache_make_room(Cache* cache, int size)
     return false;
 }
 
-// 0x41F69C
-static bool cache_purge(Cache* cache)
+// CE: Evicts unlocked entry (or drops shared entry).
+static void cache_remove(Cache* cache, CacheEntry* cacheEntry)
 {
-    for (int index = 0; index < cache->entriesLength; index++) {
-        CacheEntry* cacheEntry = cache->entries[index];
-        if ((cacheEntry->flags & CACHE_ENTRY_MARKED_FOR_EVICTION) != 0) {
-            if (cacheEntry->referenceCount != 0) {
-                // Entry was marked for eviction but still has references,
-                // unmark it.
-                cacheEntry->flags &= ~CACHE_ENTRY_MARKED_FOR_EVICTION;
-            } else {
-                int cacheEntrySize = cacheEntry->size;
-
-                // NOTE: Uninline.
-                cache_destroy_item(cache, cacheEntry);
-
-                // Move entries up.
-                memmove(&(cache->entries[index]), &(cache->entries[index + 1]), sizeof(*cache->entries) * ((cache->entriesLength - index) - 1));
+    CacheEntry** link = &(cache->buckets[cache_bucket(cache, cacheEntry->key)]);
+    while (*link != cacheEntry) {
+        link = &((*link)->nextInBucket);
+    }
+    *link = cacheEntry->nextInBucket;
 
-                cache->entriesLength--;
-                cache->size -= cacheEntrySize;
+    // Move the last entry into the hole.
+    cache->entriesLength--;
+    if (cacheEntry->index != cache->entriesLength) {
+        cache->entries[cacheEntry->index] = cache->entries[cache->entriesLength];
+        cache->entries[cacheEntry->index]->index = cacheEntry->index;
+    }
 
-                // The entry was removed, compensate index.
-                index--;
-            }
-        }
+    // Shared entries are not in LRU list and are not accounted in cache size.
+    if ((cacheEntry->flags & CACHE_ENTRY_SHARED) != 0) {
+        cache->sharedEntries--;
+    } else {
+        cache_lru_remove(cache, cacheEntry);
+        cache->size -= cacheEntry->size;
+        cache->evictions++;
     }
 
-    return true;
+    // NOTE: Uninline.
+    cache_destroy_item(cache, cacheEntry);
 }
 
 // 0x41F740
@@ -732,48 +961,254 @@ static bool cache_resize_array(Cache* cache, int newCapacity)
     return true;
 }
 
-// 0x41F774
-static int cache_compare_make_room(const void* a1, const void* a2)
+static bool cache_resize_buckets(Cache* cache, int newCapacity)
 {
-    CacheEntry* v1 = *(CacheEntry**)a1;
-    CacheEntry* v2 = *(CacheEntry**)a2;
+    CacheEntry** buckets = (CacheEntry**)mem_malloc(sizeof(*buckets) * newCapacity);
+    if (buckets == NULL) {
+        return false;
+    }
+
+    memset(buckets, 0, sizeof(*buckets) * newCapacity);
+
+    if (cache->buckets != NULL) {
+        mem_free(cache->buckets);
+    }
 
-    if (v1->referenceCount != 0 && v2->referenceCount == 0) {
-        return 1;
+    cache->buckets = buckets;
+    cache->bucketsCapacity = newCapacity;
+
+    for (int index = 0; index < cache->entriesLength; index++) {
+        CacheEntry* cacheEntry = cache->entries[index];
+        unsigned int bucket = cache_bucket(cache, cacheEntry->key);
+        cacheEntry->nextInBucket = cache->buckets[bucket];
+        cache->buckets[bucket] = cacheEntry;
     }
 
-    if (v2->referenceCount != 0 && v1->referenceCount == 0) {
-        return -1;
+    return true;
+}
+
+static unsigned int cache_bucket(Cache* cache, int key)
+{
+    // Keys are mostly FIDs which differ in low bits, mix them with
+    // multiplicative hash.
+    return ((unsigned int)key * 2654435761U) & (cache->bucketsCapacity - 1);
+}
+
+// Adds unlocked entry to the front of LRU list.
+static void cache_lru_push(Cache* cache, CacheEntry* cacheEntry)
+{
+    cacheEntry->prev = NULL;
+    cacheEntry->next = cache->lruHead;
+
+    if (cache->lruHead != NULL) {
+        cache->lruHead->prev = cacheEntry;
+    } else {
+        cache->lruTail = cacheEntry;
     }
 
-    if (v1->hits < v2->hits) {
-        return -1;
-    } else if (v1->hits > v2->hits) {
-        return 1;
+    cache->lruHead = cacheEntry;
+}
+
+static void cache_lru_remove(Cache* cache, CacheEntry* cacheEntry)
+{
+    if (cacheEntry->prev != NULL) {
+        cacheEntry->prev->next = cacheEntry->next;
+    } else {
+        cache->lruHead = cacheEntry->next;
     }
 
-    if (v1->mru < v2->mru) {
-        return -1;
-    } else if (v1->mru > v2->mru) {
-        return 1;
+    if (cacheEntry->next != NULL) {
+        cacheEntry->next->prev = cacheEntry->prev;
+    } else {
+        cache->lruTail = cacheEntry->prev;
     }
 
-    return 0;
+    cacheEntry->prev = NULL;
+    cacheEntry->next = NULL;
 }
 
-// 0x41F7E8
-static int cache_compare_reset_counter(const void* a1, const void* a2)
+static unsigned int cache_tier_bucket(int key)
 {
-    CacheEntry* v1 = *(CacheEntry**)a1;
-    CacheEntry* v2 = *(CacheEntry**)a2;
+    return ((unsigned int)key * 2654435761U) & (CACHE_TIER_BUCKETS_CAPACITY - 1);
+}
+
+// Removes compressed entry for given key from the second tier and returns it,
+// or `NULL` if there is no such entry.
+static CacheTierEntry* cache_tier_take(Cache* cache, int key)
+{
+    if (cache->tierBuckets == NULL) {
+        return NULL;
+    }
+
+    CacheTierEntry** link = &(cache->tierBuckets[cache_tier_bucket(key)]);
+    while (*link != NULL && (*link)->key != key) {
+        link = &((*link)->nextInBucket);
+    }
+
+    CacheTierEntry* tierEntry = *link;
+    if (tierEntry == NULL) {
+        return NULL;
+    }
+
+    *link = tierEntry->nextInBucket;
 
-    if (v1->mru < v2->mru) {
-        return 1;
-    } else if (v1->mru > v2->mru) {
-        return -1;
+    if (tierEntry->prev != NULL) {
+        tierEntry->prev->next = tierEntry->next;
     } else {
-        return 0;
+        cache->tierHead = tierEntry->next;
+    }
+
+    if (tierEntry->next != NULL) {
+        tierEntry->next->prev = tierEntry->prev;
+    } else {
+        cache->tierTail = tierEntry->prev;
+    }
+
+    cache->tierEntriesLength--;
+    cache->tierSize -= tierEntry->compressedSize + (int)sizeof(*tierEntry);
+
+    return tierEntry;
+}
+
+// Keeps compressed copy of entry which is about to be evicted.
+static void cache_tier_store(Cache* cache, CacheEntry* cacheEntry)
+{
+    if (cache->tierMaxSize == 0) {
+        return;
+    }
+
+    unsigned char* data;
+    if (!heap_lock(&(cache->heap), cacheEntry->heapHandleIndex, &data)) {
+        return;
     }
+
+    do {
+        int compressedSize = cache_tier_compress(data, cacheEntry->size, NULL);
+        int size = compressedSize + (int)sizeof(CacheTierEntry);
+        if (size > cache->tierMaxSize) {
+            break;
+        }
+
+        while (cache->tierTail != NULL && cache->tierSize + size > cache->tierMaxSize) {
+            cache_tier_free(cache_tier_take(cache, cache->tierTail->key));
+        }
+
+        CacheTierEntry* tierEntry = (CacheTierEntry*)mem_malloc(sizeof(*tierEntry));
+        if (tierEntry == NULL) {
+            break;
+        }
+
+        tierEntry->data = (unsigned char*)mem_malloc(compressedSize > 0 ? compressedSize : 1);
+        if (tierEntry->data == NULL) {
+            mem_free(tierEntry);
+            break;
+        }
+
+        cache_tier_compress(data, cacheEntry->size, tierEntry->data);
+
+        tierEntry->key = cacheEntry->key;
+        tierEntry->size = cacheEntry->size;
+        tierEntry->compressedSize = compressedSize;
+
+        unsigned int bucket = cache_tier_bucket(tierEntry->key);
+        tierEntry->nextInBucket = cache->tierBuckets[bucket];
+        cache->tierBuckets[bucket] = tierEntry;
+
+        tierEntry->prev = NULL;
+        tierEntry->next = cache->tierHead;
+        if (cache->tierHead != NULL) {
+            cache->tierHead->prev = tierEntry;
+        } else {
+            cache->tierTail = tierEntry;
+        }
+        cache->tierHead = tierEntry;
+
+        cache->tierEntriesLength++;
+        cache->tierSize += size;
+    } while (0);
+
+    heap_unlock(&(cache->heap), cacheEntry->heapHandleIndex);
+}
+
+static void cache_tier_free(CacheTierEntry* tierEntry)
+{
+    mem_free(tierEntry->data);
+    mem_free(tierEntry);
+}
+
+// Compresses runs of zero bytes. Control byte below 0x80 is followed by
+// `control + 1` literal bytes, control byte 0x80 and above denotes a run of
+// `control - 0x80 + 3` zero bytes. When `dest` is `NULL` only calculates
+// compressed size.
+static int cache_tier_compress(const unsigned char* src, int size, unsigned char* dest)
+{
+    int compressedSize = 0;
+    int pos = 0;
+    while (pos < size) {
+        int run = 0;
+        while (pos + run < size && src[pos + run] == 0 && run < 130) {
+            run++;
+        }
+
+        if (run >= 3) {
+            if (dest != NULL) {
+                dest[compressedSize] = (unsigned char)(0x80 + run - 3);
+            }
+            compressedSize++;
+            pos += run;
+            continue;
+        }
+
+        // Literals continue up to the next run of at least three zeros.
+        int length = 0;
+        while (pos + length < size && length < 128) {
+            if (src[pos + length] == 0
+                && pos + length + 2 < size
+                && src[pos + length + 1] == 0
+                && src[pos + length + 2] == 0) {
+                break;
+            }
+            length++;
+        }
+
+        if (dest != NULL) {
+            dest[compressedSize] = (unsigned char)(length - 1);
+            memcpy(dest + compressedSize + 1, src + pos, length);
+        }
+        compressedSize += length + 1;
+        pos += length;
+    }
+
+    return compressedSize;
+}
+
+static bool cache_tier_decompress(const unsigned char* src, int compressedSize, unsigned char* dest, int size)
+{
+    int pos = 0;
+    int srcPos = 0;
+    while (srcPos < compressedSize) {
+        int control = src[srcPos++];
+        if (control >= 0x80) {
+            int run = control - 0x80 + 3;
+            if (pos + run > size) {
+                return false;
+            }
+
+            memset(dest + pos, 0, run);
+            pos += run;
+        } else {
+            int length = control + 1;
+            if (pos + length > size || srcPos + length > compressedSize) {
+                return false;
+            }
+
+            memcpy(dest + pos, src + srcPos, length);
+            pos += length;
+            srcPos += length;
+        }
+    }
+
+    return pos == size;
 }
 
 } // namespace fallout
@@ -15,10 +15,20 @@ namespace fallout {
 // The number of cache entries added when cache capacity is reached.
 #define CACHE_ENTRIES_GROW_CAPACITY 50
 
+// CE: The initial number of hash buckets in new cache (power of two).
+#define CACHE_BUCKETS_INITIAL_CAPACITY 256
+
+// CE: The number of hash buckets in second tier (power of two).
+#define CACHE_TIER_BUCKETS_CAPACITY 256
+
 typedef enum CacheEntryFlags {
     // Specifies that cache entry has no references as should be evicted during
     // the next sweep operation.
     CACHE_ENTRY_MARKED_FOR_EVICTION = 0x01,
+
+    // CE: Specifies that cache entry data lives in shared cache segment (see
+    // `cache_set_shared`), `heapHandleIndex` is a slot in that segment.
+    CACHE_ENTRY_SHARED = 0x02,
 } CacheEntryFlags;
 
 typedef enum CacheListRequestType {
@@ -48,8 +58,80 @@ typedef struct CacheEntry {
     unsigned int mru;
 
     int heapHandleIndex;
+
+    // CE: Position in `entries` array.
+    int index;
+
+    // CE: Next entry in the same hash bucket.
+    struct CacheEntry* nextInBucket;
+
+    // CE: Links in LRU list of unlocked entries (only valid when
+    // `referenceCount` is zero).
+    struct CacheEntry* prev;
+    struct CacheEntry* next;
 } CacheEntry;
 
+// CE: Compressed copy of evicted cache entry, see `cache_set_second_tier`.
+typedef struct CacheTierEntry {
+    int key;
+
+    // Size of decompressed entry.
+    int size;
+
+    int compressedSize;
+    unsigned char* data;
+
+    // Next entry in the same hash bucket.
+    struct CacheTierEntry* nextInBucket;
+
+    // Links in LRU list, the least recently evicted entry is at the tail.
+    struct CacheTierEntry* prev;
+    struct CacheTierEntry* next;
+} CacheTierEntry;
+
+// CE: Structured cache statistics, see `cache_get_stats`.
+typedef struct CacheStats {
+    // Number of lookups served from the cache and number of lookups which
+    // required reading the entry.
+    unsigned int hits;
+    unsigned int misses;
+
+    // Number of entries removed from the cache.
+    unsigned int evictions;
+
+    // Number of resident and locked entries.
+    int entries;
+    int lockedEntries;
+
+    // Size of resident and locked entries.
+    int size;
+    int lockedSize;
+
+    // Cache capacity (0 - unbounded).
+    int maxSize;
+
+    int averageEntrySize;
+
+    // Number of reads and total time spent reading entries (in ms).
+    unsigned int reads;
+    double readTime;
+
+    // Number of misses served from the second tier, and its contents.
+    unsigned int secondTierHits;
+    int secondTierEntries;
+    int secondTierSize;
+    int secondTierMaxSize;
+
+    // Number of misses served from shared cache segment, and number of
+    // currently locked shared entries.
+    unsigned int sharedHits;
+    int sharedEntries;
+
+    // Total number of bytes saved by deduplicating contents of read entries
+    // (reported by cache owner, see `art_dedup_saved_size`).
+    unsigned int dedupSavedSize;
+} CacheStats;
+
 typedef struct Cache {
     // Current size of entries in cache.
     int size;
@@ -67,15 +149,53 @@ typedef struct Cache {
     unsigned int hits;
 
     // List of cache entries.
+    //
+    // CE: Entries are no longer sorted by key, lookups are made with `buckets`
+    // hash index.
     CacheEntry** entries;
 
+    // CE: Hash index of entries by key.
+    CacheEntry** buckets;
+    int bucketsCapacity;
+
+    // CE: Unlocked entries, the least recently used one is at the tail (and is
+    // evicted first).
+    CacheEntry* lruHead;
+    CacheEntry* lruTail;
+
     CacheSizeProc* sizeProc;
     CacheReadProc* readProc;
     CacheFreeProc* freeProc;
     Heap heap;
+
+    // CE: Counters for `cache_get_stats`.
+    unsigned int lookupHits;
+    unsigned int lookupMisses;
+    unsigned int evictions;
+    unsigned int reads;
+    unsigned long long readTicks;
+    int lockedEntries;
+    int lockedSize;
+
+    // CE: Optional second tier keeping compressed copies of evicted entries
+    // (disabled when `tierMaxSize` is zero).
+    CacheTierEntry** tierBuckets;
+    CacheTierEntry* tierHead;
+    CacheTierEntry* tierTail;
+    int tierEntriesLength;
+    int tierSize;
+    int tierMaxSize;
+    unsigned int tierHits;
+
+    // CE: Look up entries in shared cache segment first, see
+    // `cache_set_shared`.
+    bool shared;
+    unsigned int sharedHits;
+    int sharedEntries;
 } Cache;
 
 bool cache_init(Cache* cache, CacheSizeProc* sizeProc, CacheReadProc* readProc, CacheFreeProc* freeProc, int maxSize);
+bool cache_init_with_heap_type(Cache* cache, CacheSizeProc* sizeProc, CacheReadProc* readProc, CacheFreeProc* freeProc, int maxSize, int heapType);
 bool cache_exit(Cache* cache);
 int cache_query(Cache* cache, int key);
 bool cache_lock(Cache* cache, int key, void** data, CacheEntry** cacheEntryPtr);
@@ -84,6 +204,9 @@ int cache_discard(Cache* cache, int key);
 bool cache_flush(Cache* cache);
 int cache_size(Cache* cache, int* sizePtr);
 bool cache_stats(Cache* cache, char* dest, size_t size);
+bool cache_get_stats(Cache* cache, CacheStats* stats);
+bool cache_set_second_tier(Cache* cache, int maxSize);
+bool cache_set_shared(Cache* cache, bool shared);
 int cache_create_list(Cache* cache, unsigned int a2, int** tagsPtr, int* tagsLengthPtr);
 int cache_destroy_list(int** tagsPtr);
 
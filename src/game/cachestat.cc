@@ -0,0 +1,242 @@
+#include "game/cachestat.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "game/anim.h"
+#include "game/art.h"
+#include "game/display.h"
+#include "game/gconfig.h"
+#include "game/message.h"
+#include "game/proto.h"
+#include "game/sfxcache.h"
+#include "plib/gnw/debug.h"
+#include "plib/gnw/input.h"
+#include "plib/gnw/memory.h"
+
+namespace fallout {
+
+static void cachestat_format(const char* name, const CacheStats* stats, char* dest, size_t size);
+static void cachestat_publish_memory(int tag, const char* name, const MemTagStats* stats, void* userData);
+
+static const char* cachestat_names[CACHE_STAT_SOURCE_COUNT] = {
+    "art",
+    "sfx",
+    "proto",
+    "message",
+    "path",
+    "sfx_pcm",
+};
+
+// Receives stats of every source on each publish.
+static CacheStatProc* cachestat_proc = NULL;
+static void* cachestat_user_data = NULL;
+
+// Publishing interval in ms (0 - periodic publishing is disabled).
+static unsigned int cachestat_interval = 0;
+
+// Specifies whether published stats are printed to display monitor.
+static bool cachestat_overlay = false;
+
+static unsigned int cachestat_last_publish = 0;
+
+// Reads publishing options from [debug] section of game config.
+void cachestat_init()
+{
+    int interval;
+    if (config_get_value(&game_config, GAME_CONFIG_DEBUG_KEY, GAME_CONFIG_CACHE_STATS_INTERVAL_KEY, &interval) && interval > 0) {
+        cachestat_interval = (unsigned int)interval;
+    } else {
+        cachestat_interval = 0;
+    }
+
+    int overlay;
+    if (config_get_value(&game_config, GAME_CONFIG_DEBUG_KEY, GAME_CONFIG_CACHE_STATS_OVERLAY_KEY, &overlay)) {
+        cachestat_overlay = overlay != 0;
+    } else {
+        cachestat_overlay = false;
+    }
+
+    cachestat_last_publish = get_time();
+}
+
+// Publishes final stats (when publishing is enabled) while all sources are
+// still alive.
+void cachestat_exit()
+{
+    if (cachestat_interval != 0 || cachestat_proc != NULL) {
+        bool overlay = cachestat_overlay;
+        cachestat_overlay = false;
+        cachestat_publish();
+        cachestat_overlay = overlay;
+    }
+
+    cachestat_proc = NULL;
+    cachestat_user_data = NULL;
+}
+
+const char* cachestat_name(int source)
+{
+    if (source < 0 || source >= CACHE_STAT_SOURCE_COUNT) {
+        return NULL;
+    }
+
+    return cachestat_names[source];
+}
+
+bool cachestat_get(int source, CacheStats* stats)
+{
+    if (stats == NULL) {
+        return false;
+    }
+
+    memset(stats, 0, sizeof(*stats));
+
+    switch (source) {
+    case CACHE_STAT_SOURCE_ART:
+        if (!cache_get_stats(&art_cache, stats)) {
+            return false;
+        }
+        stats->dedupSavedSize = art_dedup_saved_size();
+        return true;
+    case CACHE_STAT_SOURCE_SFX:
+        return sfxc_get_stats(stats);
+    case CACHE_STAT_SOURCE_PROTO:
+        return proto_get_cache_stats(stats);
+    case CACHE_STAT_SOURCE_MESSAGE:
+        return message_get_cache_stats(stats);
+    case CACHE_STAT_SOURCE_PATH:
+        return anim_get_path_cache_stats(stats);
+    case CACHE_STAT_SOURCE_SFX_PCM:
+        return sfxc_get_pcm_stats(stats);
+    }
+
+    return false;
+}
+
+void cachestat_set_callback(CacheStatProc* proc, void* userData)
+{
+    cachestat_proc = proc;
+    cachestat_user_data = userData;
+}
+
+void cachestat_set_interval(unsigned int interval)
+{
+    cachestat_interval = interval;
+    cachestat_last_publish = get_time();
+}
+
+void cachestat_set_overlay(bool enabled)
+{
+    cachestat_overlay = enabled;
+}
+
+// Publishes stats when publishing interval has elapsed. Should be called once
+// per frame.
+void cachestat_process()
+{
+    if (cachestat_interval == 0) {
+        return;
+    }
+
+    if (elapsed_time(cachestat_last_publish) < cachestat_interval) {
+        return;
+    }
+
+    cachestat_publish();
+}
+
+// Publishes stats of all sources to the callback, debug log, and (when
+// enabled) display monitor.
+void cachestat_publish()
+{
+    cachestat_last_publish = get_time();
+
+    for (int source = 0; source < CACHE_STAT_SOURCE_COUNT; source++) {
+        CacheStats stats;
+        if (!cachestat_get(source, &stats)) {
+            continue;
+        }
+
+        if (cachestat_proc != NULL) {
+            cachestat_proc(source, cachestat_names[source], &stats, cachestat_user_data);
+        }
+
+        char string[256];
+        cachestat_format(cachestat_names[source], &stats, string, sizeof(string));
+        debug_printf("%s\n", string);
+
+        if (cachestat_overlay) {
+            display_print(string);
+        }
+    }
+
+    mem_visit_tag_stats(cachestat_publish_memory, NULL);
+}
+
+// CE: Publishes memory accounted to tag (see `MemTag`) along with cache
+// stats.
+static void cachestat_publish_memory(int tag, const char* name, const MemTagStats* stats, void* userData)
+{
+    if (stats->allocations == 0) {
+        return;
+    }
+
+    char string[256];
+    int length = snprintf(string, sizeof(string), "mem %s: %u KB (peak %u KB), %u blocks, %llu allocs",
+        name,
+        (unsigned int)(stats->size / 1024),
+        (unsigned int)(stats->peakSize / 1024),
+        stats->blocks,
+        stats->allocations);
+
+    if (stats->operations != 0 && length > 0 && length < (int)sizeof(string)) {
+        snprintf(string + length, sizeof(string) - length, " (%.1f per op over %llu ops)",
+            (double)stats->allocations / (double)stats->operations,
+            stats->operations);
+    }
+    debug_printf("%s\n", string);
+
+    if (cachestat_overlay) {
+        display_print(string);
+    }
+}
+
+static void cachestat_format(const char* name, const CacheStats* stats, char* dest, size_t size)
+{
+    unsigned int lookups = stats->hits + stats->misses;
+    int hitRate = lookups != 0 ? (int)((unsigned long long)stats->hits * 100 / lookups) : 0;
+
+    int length = snprintf(dest, size, "%s: %d%% hits, %u ev, %d KB/%d KB (%d KB locked), %d entries, avg %d B, %.0f ms read",
+        name,
+        hitRate,
+        stats->evictions,
+        stats->size / 1024,
+        stats->maxSize / 1024,
+        stats->lockedSize / 1024,
+        stats->entries,
+        stats->averageEntrySize,
+        stats->readTime);
+
+    if (stats->secondTierMaxSize != 0 && length > 0 && (size_t)length < size) {
+        snprintf(dest + length, size - length, ", tier2 %u hits, %d KB/%d KB",
+            stats->secondTierHits,
+            stats->secondTierSize / 1024,
+            stats->secondTierMaxSize / 1024);
+        length = (int)strlen(dest);
+    }
+
+    if ((stats->sharedHits != 0 || stats->sharedEntries != 0) && length > 0 && (size_t)length < size) {
+        snprintf(dest + length, size - length, ", shared %u hits, %d locked",
+            stats->sharedHits,
+            stats->sharedEntries);
+        length = (int)strlen(dest);
+    }
+
+    if (stats->dedupSavedSize != 0 && length > 0 && (size_t)length < size) {
+        snprintf(dest + length, size - length, ", dedup %u KB saved",
+            stats->dedupSavedSize / 1024);
+    }
+}
+
+} // namespace fallout
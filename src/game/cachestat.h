@@ -0,0 +1,32 @@
+#ifndef FALLOUT_GAME_CACHESTAT_H_
+#define FALLOUT_GAME_CACHESTAT_H_
+
+#include "game/cache.h"
+
+namespace fallout {
+
+typedef enum CacheStatSource {
+    CACHE_STAT_SOURCE_ART,
+    CACHE_STAT_SOURCE_SFX,
+    CACHE_STAT_SOURCE_PROTO,
+    CACHE_STAT_SOURCE_MESSAGE,
+    CACHE_STAT_SOURCE_PATH,
+    CACHE_STAT_SOURCE_SFX_PCM,
+    CACHE_STAT_SOURCE_COUNT,
+} CacheStatSource;
+
+typedef void CacheStatProc(int source, const char* name, const CacheStats* stats, void* userData);
+
+void cachestat_init();
+void cachestat_exit();
+const char* cachestat_name(int source);
+bool cachestat_get(int source, CacheStats* stats);
+void cachestat_set_callback(CacheStatProc* proc, void* userData);
+void cachestat_set_interval(unsigned int interval);
+void cachestat_set_overlay(bool enabled);
+void cachestat_process();
+void cachestat_publish();
+
+} // namespace fallout
+
+#endif /* FALLOUT_GAME_CACHESTAT_H_ */
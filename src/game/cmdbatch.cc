@@ -0,0 +1,311 @@
+#include "game/cmdbatch.h"
+
+#include <string.h>
+
+#include <deque>
+#include <new>
+
+#include "game/actions.h"
+#include "game/anim.h"
+#include "game/combat.h"
+#include "game/game.h"
+#include "game/gamectx.h"
+#include "game/inventry.h"
+#include "game/object.h"
+#include "game/protinst.h"
+#include "plib/gnw/debug.h"
+
+namespace fallout {
+
+// Number of finished batches kept for `cmdbatch_poll`.
+#define CMDBATCH_FINISHED_MAX 16
+
+typedef struct CmdBatch {
+    int id;
+    int flags;
+    int count;
+
+    // Index of next command to execute.
+    int next;
+
+    CmdBatchCommand commands[CMDBATCH_COMMANDS_MAX];
+    CmdBatchResult results[CMDBATCH_COMMANDS_MAX];
+} CmdBatch;
+
+// Command batches of a game (see `GameContext`).
+typedef struct CmdBatchState {
+    // Batches waiting for execution (first one is being executed) and
+    // finished batches, oldest first.
+    std::deque<CmdBatch> queue;
+    std::deque<CmdBatch> finished;
+
+    int nextId;
+
+    // Number of `cmdbatch_process` calls, reported in results.
+    unsigned int ticks;
+} CmdBatchState;
+
+static CmdBatchState* cmdbatch_state();
+static void cmdbatch_state_init(void* data);
+static void cmdbatch_state_exit(void* data);
+static bool cmdbatch_can_execute();
+static Object* cmdbatch_find_object(int id);
+static int cmdbatch_execute(const CmdBatchCommand* command, bool* failedPtr);
+static void cmdbatch_finish(CmdBatch* batch, int status);
+
+static CmdBatchState* cmdbatch_state()
+{
+    return (CmdBatchState*)game_context_state(GAME_CONTEXT_SLOT_CMDBATCH, sizeof(CmdBatchState), cmdbatch_state_init, cmdbatch_state_exit);
+}
+
+static void cmdbatch_state_init(void* data)
+{
+    CmdBatchState* state = new (data) CmdBatchState();
+    state->nextId = 1;
+    state->ticks = 0;
+}
+
+static void cmdbatch_state_exit(void* data)
+{
+    ((CmdBatchState*)data)->~CmdBatchState();
+}
+
+// Queues batch of commands for player, executed in order starting from the
+// next `cmdbatch_process`. Returns batch id, or -1 if batch is invalid.
+int cmdbatch_submit(const CmdBatchCommand* commands, int count, int flags)
+{
+    CmdBatchState* state = cmdbatch_state();
+
+    if (commands == NULL || count <= 0 || count > CMDBATCH_COMMANDS_MAX) {
+        return -1;
+    }
+
+    for (int index = 0; index < count; index++) {
+        if (commands[index].type < 0 || commands[index].type >= CMDBATCH_COMMAND_TYPE_COUNT) {
+            return -1;
+        }
+    }
+
+    CmdBatch batch;
+    memset(&batch, 0, sizeof(batch));
+    batch.id = state->nextId++;
+    batch.flags = flags;
+    batch.count = count;
+    memcpy(batch.commands, commands, sizeof(*commands) * count);
+
+    for (int index = 0; index < count; index++) {
+        batch.results[index].status = CMDBATCH_STATUS_PENDING;
+    }
+
+    state->queue.push_back(batch);
+
+    return batch.id;
+}
+
+// Copies results of batch commands executed so far. Returns
+// `CMDBATCH_STATUS_PENDING` while batch is not finished,
+// `CMDBATCH_STATUS_DONE` once it is, or -1 for unknown (or long finished)
+// batches.
+int cmdbatch_poll(int id, CmdBatchResult* results, int capacity)
+{
+    CmdBatchState* state = cmdbatch_state();
+
+    const CmdBatch* batch = NULL;
+    int status = CMDBATCH_STATUS_PENDING;
+
+    for (const CmdBatch& queued : state->queue) {
+        if (queued.id == id) {
+            batch = &queued;
+            break;
+        }
+    }
+
+    if (batch == NULL) {
+        for (const CmdBatch& finished : state->finished) {
+            if (finished.id == id) {
+                batch = &finished;
+                status = CMDBATCH_STATUS_DONE;
+                break;
+            }
+        }
+    }
+
+    if (batch == NULL) {
+        return -1;
+    }
+
+    if (results != NULL) {
+        int count = capacity < batch->count ? capacity : batch->count;
+        memcpy(results, batch->results, sizeof(*results) * count);
+    }
+
+    return status;
+}
+
+// Player can act when no animation of theirs is running and, in combat, it
+// is their turn.
+static bool cmdbatch_can_execute()
+{
+    if (obj_dude == NULL || game_ui_is_disabled()) {
+        return false;
+    }
+
+    if (anim_busy(obj_dude)) {
+        return false;
+    }
+
+    if (isInCombat() && combat_whose_turn() != obj_dude) {
+        return false;
+    }
+
+    return true;
+}
+
+static Object* cmdbatch_find_object(int id)
+{
+    Object* obj = inven_find_id(obj_dude, id);
+    if (obj != NULL) {
+        return obj;
+    }
+
+    obj = obj_find_first();
+    while (obj != NULL) {
+        if (obj->id == id) {
+            return obj;
+        }
+        obj = obj_find_next();
+    }
+
+    return NULL;
+}
+
+static int cmdbatch_execute(const CmdBatchCommand* command, bool* failedPtr)
+{
+    Object* item;
+    Object* target;
+    int rc;
+
+    *failedPtr = false;
+
+    switch (command->type) {
+    case CMDBATCH_WIELD:
+        item = inven_find_id(obj_dude, command->args[0]);
+        if (item == NULL) {
+            break;
+        }
+        rc = inven_wield(obj_dude, item, command->args[1]);
+        *failedPtr = rc == -1;
+        return rc;
+    case CMDBATCH_UNWIELD:
+        rc = inven_unwield(obj_dude, command->args[0]);
+        *failedPtr = rc == -1;
+        return rc;
+    case CMDBATCH_USE_ITEM:
+        item = inven_find_id(obj_dude, command->args[0]);
+        if (item == NULL) {
+            break;
+        }
+        rc = obj_use_item(obj_dude, item);
+        *failedPtr = rc == -1;
+        return rc;
+    case CMDBATCH_USE_ITEM_ON:
+        item = inven_find_id(obj_dude, command->args[0]);
+        target = cmdbatch_find_object(command->args[1]);
+        if (item == NULL || target == NULL) {
+            break;
+        }
+        rc = action_use_an_item_on_object(obj_dude, item, target);
+        *failedPtr = rc == -1;
+        return rc;
+    case CMDBATCH_USE_OBJECT:
+        target = cmdbatch_find_object(command->args[0]);
+        if (target == NULL) {
+            break;
+        }
+        rc = action_use_an_object(obj_dude, target);
+        *failedPtr = rc == -1;
+        return rc;
+    case CMDBATCH_PICKUP:
+        target = cmdbatch_find_object(command->args[0]);
+        if (target == NULL || target->owner != NULL) {
+            break;
+        }
+        rc = action_get_an_object(obj_dude, target);
+        *failedPtr = rc == -1;
+        return rc;
+    case CMDBATCH_MOVE_TO_TILE:
+        if (command->args[1] != 0) {
+            rc = dude_run_to_tile(command->args[0], -1);
+        } else {
+            rc = dude_move_to_tile(command->args[0], -1);
+        }
+        *failedPtr = rc == -1;
+        return rc;
+    }
+
+    *failedPtr = true;
+    return -1;
+}
+
+static void cmdbatch_finish(CmdBatch* batch, int status)
+{
+    CmdBatchState* state = cmdbatch_state();
+
+    for (int index = batch->next; index < batch->count; index++) {
+        batch->results[index].status = status;
+    }
+    batch->next = batch->count;
+
+    state->finished.push_back(*batch);
+    while (state->finished.size() > CMDBATCH_FINISHED_MAX) {
+        state->finished.pop_front();
+    }
+}
+
+// Executes queued commands on main thread, once per game loop iteration.
+// Commands run back to back within one iteration until one starts an
+// animation (e.g. walking); the rest resume once player is idle again.
+void cmdbatch_process()
+{
+    CmdBatchState* state = cmdbatch_state();
+
+    state->ticks++;
+
+    while (!state->queue.empty()) {
+        CmdBatch* batch = &(state->queue.front());
+
+        while (batch->next < batch->count) {
+            if (!cmdbatch_can_execute()) {
+                return;
+            }
+
+            CmdBatchResult* result = &(batch->results[batch->next]);
+
+            bool failed;
+            result->rc = cmdbatch_execute(&(batch->commands[batch->next]), &failed);
+            result->status = failed ? CMDBATCH_STATUS_FAILED : CMDBATCH_STATUS_DONE;
+            result->tick = state->ticks;
+            batch->next++;
+
+            if (failed && (batch->flags & CMDBATCH_FLAG_STOP_ON_FAILURE) != 0) {
+                break;
+            }
+        }
+
+        cmdbatch_finish(batch, CMDBATCH_STATUS_SKIPPED);
+        state->queue.pop_front();
+    }
+}
+
+// Cancels every queued batch (on game reset or load).
+void cmdbatch_reset()
+{
+    CmdBatchState* state = cmdbatch_state();
+
+    while (!state->queue.empty()) {
+        cmdbatch_finish(&(state->queue.front()), CMDBATCH_STATUS_SKIPPED);
+        state->queue.pop_front();
+    }
+}
+
+} // namespace fallout
@@ -0,0 +1,74 @@
+#ifndef FALLOUT_GAME_CMDBATCH_H_
+#define FALLOUT_GAME_CMDBATCH_H_
+
+namespace fallout {
+
+// Maximum number of commands in one batch.
+#define CMDBATCH_COMMANDS_MAX 32
+
+typedef enum CmdBatchCommandType {
+    // args[0] - item id (in player's inventory), args[1] - hand.
+    CMDBATCH_WIELD,
+
+    // args[0] - hand.
+    CMDBATCH_UNWIELD,
+
+    // args[0] - item id (in player's inventory).
+    CMDBATCH_USE_ITEM,
+
+    // args[0] - item id (in player's inventory), args[1] - target id.
+    CMDBATCH_USE_ITEM_ON,
+
+    // args[0] - object id.
+    CMDBATCH_USE_OBJECT,
+
+    // args[0] - item id (on the map).
+    CMDBATCH_PICKUP,
+
+    // args[0] - tile, args[1] - non-zero to run.
+    CMDBATCH_MOVE_TO_TILE,
+
+    CMDBATCH_COMMAND_TYPE_COUNT,
+} CmdBatchCommandType;
+
+typedef enum CmdBatchFlags {
+    // Skip remaining commands once one fails.
+    CMDBATCH_FLAG_STOP_ON_FAILURE = 0x01,
+} CmdBatchFlags;
+
+typedef enum CmdBatchStatus {
+    // Not executed yet.
+    CMDBATCH_STATUS_PENDING,
+
+    // Executed, `rc` is the result of the underlying game function.
+    CMDBATCH_STATUS_DONE,
+
+    // Executed and failed, or referenced object was not found.
+    CMDBATCH_STATUS_FAILED,
+
+    // Not executed because earlier command failed or batch was cancelled.
+    CMDBATCH_STATUS_SKIPPED,
+} CmdBatchStatus;
+
+typedef struct CmdBatchCommand {
+    int type;
+    int args[2];
+} CmdBatchCommand;
+
+typedef struct CmdBatchResult {
+    int status;
+    int rc;
+
+    // Game loop iteration (counted by `cmdbatch_process`) the command was
+    // executed in.
+    unsigned int tick;
+} CmdBatchResult;
+
+int cmdbatch_submit(const CmdBatchCommand* commands, int count, int flags);
+int cmdbatch_poll(int id, CmdBatchResult* results, int capacity);
+void cmdbatch_process();
+void cmdbatch_reset();
+
+} // namespace fallout
+
+#endif /* FALLOUT_GAME_CMDBATCH_H_ */
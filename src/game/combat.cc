@@ -1,9 +1,16 @@
 #include "game/combat.h"
 
 #include <limits.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <string.h>
 
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
+#include <SDL.h>
+
 #include "game/actions.h"
 #include "game/anim.h"
 #include "game/art.h"
@@ -28,6 +35,7 @@
 #include "game/scripts.h"
 #include "game/skill.h"
 #include "game/stat.h"
+#include "game/statever.h"
 #include "game/tile.h"
 #include "game/trait.h"
 #include "platform_compat.h"
@@ -49,11 +57,50 @@ namespace fallout {
 #define CALLED_SHOT_WINDOW_WIDTH 424
 #define CALLED_SHOT_WINDOW_HEIGHT 309
 
+// CE: Number of slots in `to_hit_cache` (power of 2).
+#define TO_HIT_CACHE_SIZE 32
+
+// CE: Radius of non-grenade explosions and number of hexes it covers
+// (excluding center).
+#define EXPLOSION_MAX_RADIUS 3
+#define EXPLOSION_MAX_HEXES (3 * EXPLOSION_MAX_RADIUS * (EXPLOSION_MAX_RADIUS + 1))
+
+// CE: Memoized part of `determine_to_hit_func` (see `determine_to_hit_base`).
+// Entry is valid while every input it was computed from is unchanged: tiles
+// and wielded weapon are compared directly, line of fire is covered by
+// blocking epoch, stats by `STATE_VERSION_STATS` stamp, and the rest (perks,
+// traits, tagged skills, difficulty) by `combat_to_hit_cache_invalidate`.
+typedef struct ToHitCacheEntry {
+    Object* attacker;
+    Object* defender;
+    int hitMode;
+    int checkRange;
+    Object* weapon;
+    int weaponPid;
+    int attackerTile;
+    int attackerElevation;
+    int attackerResults;
+    int defenderTile;
+    int defenderElevation;
+    unsigned int blockingEpoch;
+    unsigned int statsVersion;
+    unsigned int generation;
+    int accuracy;
+    bool isRangedWeapon;
+} ToHitCacheEntry;
+
+// CE: Critter with its initiative, see `combat_sort_faster`.
+typedef struct CombatSortKey {
+    Object* critter;
+    int sequence;
+    int luck;
+} CombatSortKey;
+
 static void combat_begin(Object* a1);
 static void combat_begin_extra(Object* a1);
 static void combat_over();
 static void combat_add_noncoms();
-static int compare_faster(const void* a1, const void* a2);
+static void combat_sort_faster(Object** critters, int count);
 static void combat_sequence_init(Object* a1, Object* a2);
 static void combat_sequence();
 static int combat_input();
@@ -67,6 +114,8 @@ static int attack_crit_success(Attack* a1);
 static int attack_crit_failure(Attack* attack);
 static void do_random_cripple(int* flagsPtr);
 static int determine_to_hit_func(Object* attacker, Object* defender, int hitLocation, int hitMode, int check_range);
+static int determine_to_hit_cached(Object* attacker, Object* defender, int hitMode, int check_range, bool* isRangedWeaponPtr);
+static int determine_to_hit_base(Object* attacker, Object* defender, Object* weapon, int hitMode, int check_range, bool* isRangedWeaponPtr);
 static void compute_damage(Attack* attack, int ammoQuantity, int bonusDamageMultiplier);
 static void check_for_death(Object* a1, int a2, int* a3);
 static void set_new_results(Object* a1, int a2);
@@ -1538,6 +1587,9 @@ static Object** combat_list;
 // 0x56BC90
 static int list_com;
 
+// CE: Scratch storage of `combat_sort_faster`.
+static std::vector<CombatSortKey> combat_sort_keys;
+
 // Experience received for killing critters during current combat.
 //
 // 0x56BC94
@@ -1546,6 +1598,24 @@ int combat_exps;
 // 0x56BC9C
 int combat_free_move;
 
+// CE: Resolve combat without playing animations, sounds and floating text
+// (see `combat_set_fast_mode`).
+static bool combat_fast_mode = false;
+
+// CE: Counters reported to benchmarks (see `combat_get_stats`).
+static CombatStats combat_stats;
+static Uint64 combat_ai_ticks = 0;
+
+// CE: Ends combat after given number of rounds, 0 means no limit (see
+// `combat_set_round_limit`).
+static int combat_round_limit = 0;
+
+static ToHitCacheEntry to_hit_cache[TO_HIT_CACHE_SIZE];
+
+// CE: Current generation of `to_hit_cache`, bumping it invalidates all
+// entries at once.
+static unsigned int to_hit_cache_generation = 1;
+
 // 0x41F810
 int combat_init()
 {
@@ -1566,6 +1636,12 @@ int combat_init()
 
     combat_cleanup_enabled = 0;
 
+    int fastCombat;
+    if (!config_get_value(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_FAST_COMBAT_KEY, &fastCombat)) {
+        fastCombat = 0;
+    }
+    combat_fast_mode = fastCombat != 0;
+
     if (!message_init(&combat_message_file)) {
         return -1;
     }
@@ -1626,14 +1702,13 @@ int combat_load(DB_FILE* stream)
     if (db_freadUInt32(stream, &combat_state) == -1) return -1;
 
     if (!isInCombat()) {
-        obj = obj_find_first();
+        // CE: Visit critters only.
+        obj = obj_find_first_of_type(OBJ_TYPE_CRITTER, -1);
         while (obj != NULL) {
-            if (PID_TYPE(obj->pid) == OBJ_TYPE_CRITTER) {
-                if (obj->data.critter.combat.whoHitMeCid == -1) {
-                    obj->data.critter.combat.whoHitMe = NULL;
-                }
+            if (obj->data.critter.combat.whoHitMeCid == -1) {
+                obj->data.critter.combat.whoHitMe = NULL;
             }
-            obj = obj_find_next();
+            obj = obj_find_next_of_type();
         }
         return 0;
     }
@@ -1654,33 +1729,50 @@ int combat_load(DB_FILE* stream)
 
     obj_dude->cid = cid;
 
+    // CE: Index critters by cid instead of searching list for every
+    // reference. Critters sharing cid are chained in list order.
+    std::unordered_map<int, int> cidIndexes;
+    std::vector<int> sameCidNext(list_total, -1);
+    for (i = list_total - 1; i >= 0; i--) {
+        auto it = cidIndexes.find(combat_list[i]->cid);
+        if (it != cidIndexes.end()) {
+            sameCidNext[i] = it->second;
+            it->second = i;
+        } else {
+            cidIndexes.emplace(combat_list[i]->cid, i);
+        }
+    }
+
     for (i = 0; i < list_total; i++) {
         if (combat_list[i]->data.critter.combat.whoHitMeCid == -1) {
             combat_list[i]->data.critter.combat.whoHitMe = NULL;
         } else {
-            // NOTE: Uninline.
-            j = find_cid(0, combat_list[i]->data.critter.combat.whoHitMeCid, combat_list, list_total);
-            if (j == list_total) {
+            auto it = cidIndexes.find(combat_list[i]->data.critter.combat.whoHitMeCid);
+            if (it == cidIndexes.end()) {
                 combat_list[i]->data.critter.combat.whoHitMe = NULL;
             } else {
-                combat_list[i]->data.critter.combat.whoHitMe = combat_list[j];
+                combat_list[i]->data.critter.combat.whoHitMe = combat_list[it->second];
             }
         }
     }
 
+    std::vector<Object*> ordered(list_total);
     for (i = 0; i < list_total; i++) {
         if (db_freadInt32(stream, &cid) == -1) return -1;
 
-        // NOTE: Uninline.
-        j = find_cid(i, cid, combat_list, list_total);
-
-        if (j == list_total) {
+        auto it = cidIndexes.find(cid);
+        if (it == cidIndexes.end() || it->second == -1) {
             return -1;
         }
 
-        obj = combat_list[i];
-        combat_list[i] = combat_list[j];
-        combat_list[j] = obj;
+        j = it->second;
+        it->second = sameCidNext[j];
+
+        ordered[i] = combat_list[j];
+    }
+
+    for (i = 0; i < list_total; i++) {
+        combat_list[i] = ordered[i];
     }
 
     for (i = 0; i < list_total; i++) {
@@ -1760,6 +1852,7 @@ static void combat_begin(Object* a1)
         }
 
         combat_state |= COMBAT_STATE_0x01;
+        statever_bump(STATE_VERSION_COMBAT);
 
         tile_refresh_display();
         game_ui_disable(0);
@@ -1792,6 +1885,7 @@ static void combat_begin_extra(Object* a1)
     combat_ctd_init(&main_ctd, a1, NULL, HIT_MODE_PUNCH, HIT_LOCATION_TORSO);
 
     combat_turn_obj = a1;
+    statever_bump(STATE_VERSION_COMBAT);
 
     combat_ai_begin(list_total, combat_list);
 
@@ -1835,6 +1929,7 @@ static void combat_over()
 
     combat_state &= ~COMBAT_STATE_0x01;
     combat_state |= COMBAT_STATE_0x02;
+    statever_bump(STATE_VERSION_COMBAT);
 
     if (list_total != 0) {
         obj_delete_list(combat_list);
@@ -1863,6 +1958,7 @@ void combat_over_from_load()
     combat_over();
     combat_state = 0;
     combat_end_due_to_load = 1;
+    statever_bump(STATE_VERSION_COMBAT);
 }
 
 // Give exp for destroying critter.
@@ -1891,11 +1987,11 @@ void combat_give_exps(int exp_points)
         return;
     }
 
-    prefix.num = roll_random(0, 3) + 622; // generate prefix for message
+    prefix.num = roll_random_stream(ROLL_STREAM_COSMETIC, 0, 3) + 622; // generate prefix for message
 
     current_hp = stat_level(obj_dude, STAT_CURRENT_HIT_POINTS);
     max_hp = stat_level(obj_dude, STAT_MAXIMUM_HIT_POINTS);
-    if (current_hp == max_hp && roll_random(0, 100) > 65) {
+    if (current_hp == max_hp && roll_random_stream(ROLL_STREAM_COSMETIC, 0, 100) > 65) {
         prefix.num = 626; // Best possible prefix: For destroying your enemies without taking a scratch,
     }
 
@@ -1950,31 +2046,30 @@ int combat_in_range(Object* critter)
     return 0;
 }
 
-// Compares critters by sequence.
-//
-// 0x420288
-static int compare_faster(const void* a1, const void* a2)
+// CE: Sorts critters by sequence, then by luck (both descending). Replaces
+// `qsort` with `compare_faster`, which read both stats twice per comparison,
+// stats are now read once per critter. Sort is stable, so critters which
+// compare equal keep their order.
+static void combat_sort_faster(Object** critters, int count)
 {
-    Object* v1 = *(Object**)a1;
-    Object* v2 = *(Object**)a2;
-
-    int sequence1 = stat_level(v1, STAT_SEQUENCE);
-    int sequence2 = stat_level(v2, STAT_SEQUENCE);
-    if (sequence1 > sequence2) {
-        return -1;
-    } else if (sequence1 < sequence2) {
-        return 1;
+    combat_sort_keys.resize(count);
+    for (int index = 0; index < count; index++) {
+        CombatSortKey* key = &(combat_sort_keys[index]);
+        key->critter = critters[index];
+        key->sequence = stat_level(critters[index], STAT_SEQUENCE);
+        key->luck = stat_level(critters[index], STAT_LUCK);
     }
 
-    int luck1 = stat_level(v1, STAT_LUCK);
-    int luck2 = stat_level(v2, STAT_LUCK);
-    if (luck1 > luck2) {
-        return -1;
-    } else if (luck1 < luck2) {
-        return 1;
-    }
+    std::stable_sort(combat_sort_keys.begin(), combat_sort_keys.end(), [](const CombatSortKey& a, const CombatSortKey& b) {
+        if (a.sequence != b.sequence) {
+            return a.sequence > b.sequence;
+        }
+        return a.luck > b.luck;
+    });
 
-    return 0;
+    for (int index = 0; index < count; index++) {
+        critters[index] = combat_sort_keys[index].critter;
+    }
 }
 
 // 0x4202FC
@@ -2072,7 +2167,7 @@ static void combat_sequence()
 
     if (count != 0) {
         list_com = count;
-        qsort(combat_list, count, sizeof(*combat_list), compare_faster);
+        combat_sort_faster(combat_list, count);
         count = list_com;
     }
 
@@ -2129,6 +2224,11 @@ void combat_end()
 // 0x420698
 void combat_turn_run()
 {
+    // CE: Skip to the end states of pending animations.
+    if (combat_fast_mode && combat_turn_running > 0) {
+        anim_fast_forward();
+    }
+
     while (combat_turn_running > 0) {
         sharedFpsLimiter.mark();
 
@@ -2139,6 +2239,39 @@ void combat_turn_run()
     }
 }
 
+// CE: Enables or disables fast combat for headless and batch runs. Attacks,
+// damage, criticals, knockback and AI turns go through the same code and the
+// same random draws as in normal mode, but animations jump to their end
+// states (see `anim_fast_forward`), and sounds and floating text are skipped.
+void combat_set_fast_mode(bool enabled)
+{
+    combat_fast_mode = enabled;
+}
+
+bool combat_is_fast_mode()
+{
+    return combat_fast_mode;
+}
+
+// CE: Makes combat end after `rounds` complete rounds, used by benchmarks to
+// run fixed amount of work. Pass 0 to remove the limit.
+void combat_set_round_limit(int rounds)
+{
+    combat_round_limit = rounds > 0 ? rounds : 0;
+}
+
+void combat_get_stats(CombatStats* stats)
+{
+    *stats = combat_stats;
+    stats->aiTime = (double)combat_ai_ticks * 1000.0 / (double)SDL_GetPerformanceFrequency();
+}
+
+void combat_reset_stats()
+{
+    memset(&combat_stats, 0, sizeof(combat_stats));
+    combat_ai_ticks = 0;
+}
+
 // 0x4206B0
 static int combat_input()
 {
@@ -2180,6 +2313,11 @@ static int combat_input()
             game_handle_input(input, true);
         }
 
+        // CE: Resolve player's moves and attacks at once.
+        if (combat_fast_mode && combat_turn_running > 0) {
+            anim_fast_forward();
+        }
+
         renderPresent();
         sharedFpsLimiter.throttle();
     }
@@ -2217,6 +2355,11 @@ static int combat_turn(Object* a1, bool a2)
     Script* script;
 
     combat_turn_obj = a1;
+    statever_bump(STATE_VERSION_COMBAT);
+    combat_stats.turns++;
+
+    // CE: Keep memoized accuracy within one turn.
+    combat_to_hit_cache_invalidate();
 
     combat_ctd_init(&main_ctd, a1, NULL, HIT_MODE_PUNCH, HIT_LOCATION_TORSO);
 
@@ -2229,12 +2372,14 @@ static int combat_turn(Object* a1, bool a2)
                 action_points += gcsd->actionPointsBonus;
             }
             a1->data.critter.combat.ap = action_points;
+            statever_bump(STATE_VERSION_COMBAT);
         }
 
         if (a1 == obj_dude) {
             kb_clear();
             intface_update_ac(true);
             combat_free_move = 2 * perk_level(PERK_BONUS_MOVE);
+            statever_bump(STATE_VERSION_COMBAT);
             intface_update_move_points(obj_dude->data.critter.combat.ap, combat_free_move);
         } else {
             soundUpdate();
@@ -2296,7 +2441,10 @@ static int combat_turn(Object* a1, bool a2)
                     tile_refresh_rect(&rect, a1->elevation);
                 }
 
+                Uint64 aiStart = SDL_GetPerformanceCounter();
                 combat_ai(a1, gcsd != NULL ? gcsd->defender : NULL);
+                combat_ai_ticks += SDL_GetPerformanceCounter() - aiStart;
+                combat_stats.aiTurns++;
             }
         }
 
@@ -2311,6 +2459,7 @@ static int combat_turn(Object* a1, bool a2)
             combat_turn_obj = NULL;
             intface_update_ac(true);
             combat_turn_obj = obj_dude;
+            statever_bump(STATE_VERSION_COMBAT);
         } else {
             Rect rect;
             if (obj_turn_off_outline(a1, &rect) == 0) {
@@ -2330,6 +2479,7 @@ static int combat_turn(Object* a1, bool a2)
     }
 
     combat_free_move = 0;
+    statever_bump(STATE_VERSION_COMBAT);
 
     return 0;
 }
@@ -2409,6 +2559,8 @@ void combat(STRUCT_664980* attack)
             v6 = 0;
         }
 
+        int rounds = 0;
+
         do {
             if (v6 == -1) {
                 break;
@@ -2432,6 +2584,13 @@ void combat(STRUCT_664980* attack)
 
             combat_sequence();
             v6 = 0;
+
+            combat_stats.rounds++;
+
+            rounds++;
+            if (combat_round_limit != 0 && rounds >= combat_round_limit) {
+                break;
+            }
         } while (!combat_should_end());
 
         if (combat_end_due_to_load) {
@@ -2480,7 +2639,11 @@ int combat_attack(Object* attacker, Object* defender, int hitMode, int hitLocati
     bool aiming;
     int actionPoints;
 
-    if (hitMode == HIT_MODE_PUNCH && roll_random(1, 4) == 1) {
+    // CE: Account what attack allocates to combat.
+    MemTagScope memTagScope(MEM_TAG_COMBAT);
+    mem_count_tag_operation(MEM_TAG_COMBAT);
+
+    if (hitMode == HIT_MODE_PUNCH && roll_random_stream(ROLL_STREAM_COMBAT, 1, 4) == 1) {
         int fid = art_id(OBJ_TYPE_CRITTER, attacker->fid & 0xFFF, ANIM_KICK_LEG, (attacker->fid & 0xF000) >> 12, (attacker->fid & 0x70000000) >> 28);
         if (art_exists(fid)) {
             hitMode = HIT_MODE_KICK;
@@ -2535,6 +2698,7 @@ int combat_attack(Object* attacker, Object* defender, int hitMode, int hitLocati
     } else {
         attacker->data.critter.combat.ap -= actionPoints;
     }
+    statever_bump(STATE_VERSION_COMBAT);
 
     if (attacker == obj_dude) {
         intface_update_move_points(attacker->data.critter.combat.ap, combat_free_move);
@@ -2580,7 +2744,7 @@ static bool check_ranged_miss(Attack* attack)
                             v6 = 5;
                         }
 
-                        if (roll_random(1, 100) <= v6) {
+                        if (roll_random_stream(ROLL_STREAM_COMBAT, 1, 100) <= v6) {
                             roll = ROLL_SUCCESS;
                             break;
                         }
@@ -2639,7 +2803,7 @@ static int shoot_along_path(Attack* attack, int endTile, int rounds, int anim)
             }
 
             int roundsHit = 0;
-            while (roll_random(1, 100) <= accuracy && remainingRounds > 0) {
+            while (roll_random_stream(ROLL_STREAM_COMBAT, 1, 100) <= accuracy && remainingRounds > 0) {
                 remainingRounds -= 1;
                 roundsHit += 1;
             }
@@ -2701,7 +2865,7 @@ static int compute_spray(Attack* attack, int accuracy, int* roundsHitMainTargetP
     *roundsSpentPtr = ammoQuantity;
 
     int criticalChance = stat_level(attack->attacker, STAT_CRITICAL_CHANCE);
-    int roll = roll_check(accuracy, criticalChance, NULL);
+    int roll = roll_check_stream(ROLL_STREAM_COMBAT, accuracy, criticalChance, NULL);
 
     if (roll == ROLL_CRITICAL_FAILURE) {
         return roll;
@@ -2736,7 +2900,7 @@ static int compute_spray(Attack* attack, int accuracy, int* roundsHitMainTargetP
     }
 
     for (int index = 0; index < mainTargetRounds; index += 1) {
-        if (roll_check(accuracy, 0, NULL) >= ROLL_SUCCESS) {
+        if (roll_check_stream(ROLL_STREAM_COMBAT, accuracy, 0, NULL) >= ROLL_SUCCESS) {
             *roundsHitMainTargetPtr += 1;
         }
     }
@@ -2818,12 +2982,12 @@ static int compute_attack(Attack* attack)
         roll = compute_spray(attack, to_hit, &roundsHitMainTarget, &roundsSpent, anim);
     } else {
         critical_chance = stat_level(attack->attacker, STAT_CRITICAL_CHANCE);
-        roll = roll_check(to_hit, critical_chance - hit_location_penalty[attack->defenderHitLocation], NULL);
+        roll = roll_check_stream(ROLL_STREAM_COMBAT, to_hit, critical_chance - hit_location_penalty[attack->defenderHitLocation], NULL);
     }
 
     if (roll == ROLL_FAILURE) {
         if (trait_level(TRAIT_JINXED)) {
-            if (roll_random(0, 1) == 1) {
+            if (roll_random_stream(ROLL_STREAM_COMBAT, 0, 1) == 1) {
                 roll = ROLL_CRITICAL_FAILURE;
             }
         }
@@ -2865,7 +3029,7 @@ static int compute_attack(Attack* attack)
 
         if (roll == ROLL_SUCCESS && attack->attacker == obj_dude) {
             if (perk_level(PERK_SNIPER) != 0) {
-                if (roll_random(1, 10) <= stat_level(obj_dude, STAT_LUCK)) {
+                if (roll_random_stream(ROLL_STREAM_COMBAT, 1, 10) <= stat_level(obj_dude, STAT_LUCK)) {
                     roll = ROLL_CRITICAL_SUCCESS;
                 }
             }
@@ -2902,12 +3066,12 @@ static int compute_attack(Attack* attack)
             Object* defender;
 
             if (is_grenade) {
-                throw_distance = roll_random(1, distance / 2);
+                throw_distance = roll_random_stream(ROLL_STREAM_COMBAT, 1, distance / 2);
                 if (throw_distance == 0) {
                     throw_distance = 1;
                 }
 
-                rotation = roll_random(0, 5);
+                rotation = roll_random_stream(ROLL_STREAM_COMBAT, 0, 5);
                 tile = tile_num_in_direction(attack->defender->tile, rotation, throw_distance);
             } else {
                 tile = tile_num_beyond(attack->attacker->tile, attack->defender->tile, weapon_range);
@@ -2969,43 +3133,18 @@ void compute_explosion_on_extras(Attack* attack, int a2, bool isGrenade, int a4)
         origin_tile = attack->tile;
     }
 
-    int step;
-    int radius = 0;
-    int rotation = 0;
-    int current_tile = -1;
-    int current_center_tile = origin_tile;
-    while (attack->extrasLength < 6) {
-        if (radius != 0 && (current_tile = tile_num_in_direction(current_tile, rotation, 1)) != current_center_tile) {
-            step++;
-            if (step % radius == 0) {
-                rotation += 1;
-                if (rotation == ROTATION_COUNT) {
-                    rotation = ROTATION_NE;
-                }
-            }
-        } else {
-            radius++;
+    // CE: Hexes around origin and their blockers are collected in one query.
+    Object* obstacles[EXPLOSION_MAX_HEXES];
+    int obstaclesLength = obj_ring_blockers(attacker,
+        origin_tile,
+        attack->attacker->elevation,
+        isGrenade ? 2 : EXPLOSION_MAX_RADIUS,
+        obstacles,
+        EXPLOSION_MAX_HEXES);
 
-            if (isGrenade && radius > 2) {
-                current_tile = -1;
-            } else if (!isGrenade && radius > 3) {
-                current_tile = -1;
-            } else {
-                current_tile = tile_num_in_direction(current_center_tile, ROTATION_NE, 1);
-            }
-
-            current_center_tile = current_tile;
-            rotation = ROTATION_SE;
-            step = 0;
-        }
-
-        if (current_tile == -1) {
-            break;
-        }
-
-        Object* obstacle = obj_blocking_at(attacker, current_tile, attack->attacker->elevation);
-        if (obstacle != NULL
-            && FID_TYPE(obstacle->fid) == OBJ_TYPE_CRITTER
+    for (int obstacleIndex = 0; obstacleIndex < obstaclesLength && attack->extrasLength < 6; obstacleIndex++) {
+        Object* obstacle = obstacles[obstacleIndex];
+        if (FID_TYPE(obstacle->fid) == OBJ_TYPE_CRITTER
             && (obstacle->data.critter.combat.results & DAM_DEAD) == 0
             && (obstacle->flags & OBJECT_SHOOT_THRU) == 0
             && !combat_is_shot_blocked(obstacle, obstacle->tile, origin_tile, NULL, NULL)) {
@@ -3051,7 +3190,7 @@ static int attack_crit_success(Attack* attack)
 
     attack->attackerFlags |= DAM_CRITICAL;
 
-    int chance = roll_random(1, 100);
+    int chance = roll_random_stream(ROLL_STREAM_COMBAT, 1, 100);
 
     chance += stat_level(attack->attacker, STAT_BETTER_CRITICALS);
 
@@ -3114,7 +3253,7 @@ static int attack_crit_failure(Attack* attack)
         criticalFailureTableIndex = 0;
     }
 
-    int chance = roll_random(1, 100) - 5 * (stat_level(attack->attacker, STAT_LUCK) - 5);
+    int chance = roll_random_stream(ROLL_STREAM_COMBAT, 1, 100) - 5 * (stat_level(attack->attacker, STAT_LUCK) - 5);
 
     int effect;
     if (chance <= 20) {
@@ -3145,7 +3284,7 @@ static int attack_crit_failure(Attack* attack)
     }
 
     if ((attack->attackerFlags & DAM_HURT_SELF) != 0) {
-        attack->attackerDamage += roll_random(1, 5);
+        attack->attackerDamage += roll_random_stream(ROLL_STREAM_COMBAT, 1, 5);
     }
 
     if ((attack->attackerFlags & DAM_LOSE_TURN) != 0) {
@@ -3191,7 +3330,7 @@ static void do_random_cripple(int* flagsPtr)
 {
     *flagsPtr &= ~DAM_CRIP_RANDOM;
 
-    switch (roll_random(0, 3)) {
+    switch (roll_random_stream(ROLL_STREAM_COMBAT, 0, 3)) {
     case 0:
         *flagsPtr |= DAM_CRIP_LEG_LEFT;
         break;
@@ -3222,12 +3361,140 @@ int determine_to_hit_no_range(Object* a1, Object* a2, int hitLocation, int hitMo
 // 0x421E3C
 static int determine_to_hit_func(Object* attacker, Object* defender, int hitLocation, int hitMode, int check_range)
 {
-    Object* weapon;
+    bool is_ranged_weapon;
+    int accuracy;
+
+    combat_stats.toHitQueries++;
+
+    // CE: Weapon, range, line of fire and strength modifiers are memoized,
+    // the rest is cheap and depends on state that changes without notice
+    // (action points, light, called shot bonus).
+    accuracy = determine_to_hit_cached(attacker, defender, hitMode, check_range, &is_ranged_weapon);
+
+    accuracy -= stat_level(defender, STAT_ARMOR_CLASS);
+
+    if (is_ranged_weapon) {
+        accuracy += hit_location_penalty[hitLocation];
+    } else {
+        accuracy += hit_location_penalty[hitLocation] / 2;
+    }
+
+    if (defender != NULL && (defender->flags & OBJECT_MULTIHEX) != 0) {
+        accuracy += 15;
+    }
+
+    if (attacker == obj_dude) {
+        int lightIntensity = obj_get_visible_light(defender);
+
+        if (lightIntensity <= 26214)
+            accuracy -= 40;
+        else if (lightIntensity <= 39321)
+            accuracy -= 25;
+        else if (lightIntensity <= 52428)
+            accuracy -= 10;
+    }
+
+    if (gcsd != NULL) {
+        accuracy += gcsd->accuracyBonus;
+    }
+
+    if ((attacker->data.critter.combat.results & DAM_BLIND) != 0) {
+        accuracy -= 25;
+    }
+
+    if ((defender->data.critter.combat.results & (DAM_KNOCKED_OUT | DAM_KNOCKED_DOWN)) != 0) {
+        accuracy += 40;
+    }
+
+    if (attacker->data.critter.combat.team != obj_dude->data.critter.combat.team) {
+        int combatDifficuly = COMBAT_DIFFICULTY_NORMAL;
+        config_get_value(&game_config, GAME_CONFIG_PREFERENCES_KEY, GAME_CONFIG_COMBAT_DIFFICULTY_KEY, &combatDifficuly);
+        switch (combatDifficuly) {
+        case COMBAT_DIFFICULTY_EASY:
+            accuracy -= 20;
+            break;
+        case COMBAT_DIFFICULTY_HARD:
+            accuracy += 20;
+            break;
+        }
+    }
+
+    if (accuracy > 95) {
+        accuracy = 95;
+    }
+
+    if (accuracy < -100) {
+        debug_printf("Whoa! Bad skill value in determine_to_hit!\n");
+    }
+
+    return accuracy;
+}
+
+// CE: Returns part of `determine_to_hit_func` that does not depend on hit
+// location, from `to_hit_cache` when possible.
+static int determine_to_hit_cached(Object* attacker, Object* defender, int hitMode, int check_range, bool* isRangedWeaponPtr)
+{
+    Object* weapon = item_hit_with(attacker, hitMode);
+    int weaponPid = weapon != NULL ? weapon->pid : -1;
+    unsigned int blockingEpoch = obj_blocking_epoch();
+    unsigned int statsVersion = statever_get(STATE_VERSION_STATS);
+
+    uintptr_t hash = ((uintptr_t)attacker >> 4) ^ ((uintptr_t)defender >> 3) ^ (uintptr_t)(hitMode * 2 + check_range);
+    ToHitCacheEntry* entry = &(to_hit_cache[hash & (TO_HIT_CACHE_SIZE - 1)]);
+    if (entry->generation == to_hit_cache_generation
+        && entry->attacker == attacker
+        && entry->defender == defender
+        && entry->hitMode == hitMode
+        && entry->checkRange == check_range
+        && entry->weapon == weapon
+        && entry->weaponPid == weaponPid
+        && entry->attackerTile == attacker->tile
+        && entry->attackerElevation == attacker->elevation
+        && entry->attackerResults == attacker->data.critter.combat.results
+        && entry->defenderTile == defender->tile
+        && entry->defenderElevation == defender->elevation
+        && entry->blockingEpoch == blockingEpoch
+        && entry->statsVersion == statsVersion) {
+#ifdef _DEBUG
+        bool isRangedWeapon;
+        int accuracy = determine_to_hit_base(attacker, defender, weapon, hitMode, check_range, &isRangedWeapon);
+        if (entry->accuracy != accuracy || entry->isRangedWeapon != isRangedWeapon) {
+            debug_printf("to_hit_cache: stale accuracy of %s against %s: cached %d, actual %d\n", critter_name(attacker), critter_name(defender), entry->accuracy, accuracy);
+        }
+#endif
+        *isRangedWeaponPtr = entry->isRangedWeapon;
+        return entry->accuracy;
+    }
+
+    int accuracy = determine_to_hit_base(attacker, defender, weapon, hitMode, check_range, isRangedWeaponPtr);
+
+    entry->attacker = attacker;
+    entry->defender = defender;
+    entry->hitMode = hitMode;
+    entry->checkRange = check_range;
+    entry->weapon = weapon;
+    entry->weaponPid = weaponPid;
+    entry->attackerTile = attacker->tile;
+    entry->attackerElevation = attacker->elevation;
+    entry->attackerResults = attacker->data.critter.combat.results;
+    entry->defenderTile = defender->tile;
+    entry->defenderElevation = defender->elevation;
+    entry->blockingEpoch = blockingEpoch;
+    entry->statsVersion = statsVersion;
+    entry->generation = to_hit_cache_generation;
+    entry->accuracy = accuracy;
+    entry->isRangedWeapon = *isRangedWeaponPtr;
+
+    return accuracy;
+}
+
+// CE: Weapon, range, line of fire and strength part of
+// `determine_to_hit_func` (extracted from it).
+static int determine_to_hit_base(Object* attacker, Object* defender, Object* weapon, int hitMode, int check_range, bool* isRangedWeaponPtr)
+{
     bool is_ranged_weapon = false;
     int accuracy = 0;
 
-    weapon = item_hit_with(attacker, hitMode);
-
     if (weapon == NULL) {
         accuracy = skill_level(attacker, SKILL_UNARMED);
     } else {
@@ -3294,63 +3561,19 @@ static int determine_to_hit_func(Object* attacker, Object* defender, int hitLoca
         }
     }
 
-    accuracy -= stat_level(defender, STAT_ARMOR_CLASS);
-
-    if (is_ranged_weapon) {
-        accuracy += hit_location_penalty[hitLocation];
-    } else {
-        accuracy += hit_location_penalty[hitLocation] / 2;
-    }
-
-    if (defender != NULL && (defender->flags & OBJECT_MULTIHEX) != 0) {
-        accuracy += 15;
-    }
-
-    if (attacker == obj_dude) {
-        int lightIntensity = obj_get_visible_light(defender);
-
-        if (lightIntensity <= 26214)
-            accuracy -= 40;
-        else if (lightIntensity <= 39321)
-            accuracy -= 25;
-        else if (lightIntensity <= 52428)
-            accuracy -= 10;
-    }
-
-    if (gcsd != NULL) {
-        accuracy += gcsd->accuracyBonus;
-    }
+    *isRangedWeaponPtr = is_ranged_weapon;
 
-    if ((attacker->data.critter.combat.results & DAM_BLIND) != 0) {
-        accuracy -= 25;
-    }
-
-    if ((defender->data.critter.combat.results & (DAM_KNOCKED_OUT | DAM_KNOCKED_DOWN)) != 0) {
-        accuracy += 40;
-    }
-
-    if (attacker->data.critter.combat.team != obj_dude->data.critter.combat.team) {
-        int combatDifficuly = COMBAT_DIFFICULTY_NORMAL;
-        config_get_value(&game_config, GAME_CONFIG_PREFERENCES_KEY, GAME_CONFIG_COMBAT_DIFFICULTY_KEY, &combatDifficuly);
-        switch (combatDifficuly) {
-        case COMBAT_DIFFICULTY_EASY:
-            accuracy -= 20;
-            break;
-        case COMBAT_DIFFICULTY_HARD:
-            accuracy += 20;
-            break;
-        }
-    }
-
-    if (accuracy > 95) {
-        accuracy = 95;
-    }
+    return accuracy;
+}
 
-    if (accuracy < -100) {
-        debug_printf("Whoa! Bad skill value in determine_to_hit!\n");
+// CE: Must be called when any input of `determine_to_hit_base` not tracked
+// by `ToHitCacheEntry` changes (perks, traits, tagged skills, difficulty).
+void combat_to_hit_cache_invalidate()
+{
+    to_hit_cache_generation++;
+    if (to_hit_cache_generation == 0) {
+        to_hit_cache_generation = 1;
     }
-
-    return accuracy;
 }
 
 // 0x422118
@@ -4139,6 +4362,7 @@ static void combat_standup(Object* critter)
     } else {
         critter->data.critter.combat.ap -= 3;
     }
+    statever_bump(STATE_VERSION_COMBAT);
 
     if (critter == obj_dude) {
         intface_update_move_points(obj_dude->data.critter.combat.ap, combat_free_move);
@@ -11,6 +11,21 @@
 
 namespace fallout {
 
+// CE: Combat counters since last `combat_reset_stats`, used by benchmarks.
+typedef struct CombatStats {
+    // Complete rounds (every combatant had its turn).
+    unsigned int rounds;
+    unsigned int turns;
+
+    // Turns decided by combat AI and time spent deciding them (in ms),
+    // including animations registered by AI but not running them.
+    unsigned int aiTurns;
+    double aiTime;
+
+    // Number of hit chance computations (`determine_to_hit` and friends).
+    unsigned int toHitQueries;
+} CombatStats;
+
 extern unsigned int combat_state;
 extern STRUCT_664980* gcsd;
 extern bool combat_call_display;
@@ -34,6 +49,11 @@ void combat_give_exps(int exp_points);
 int combat_in_range(Object* critter);
 void combat_end();
 void combat_turn_run();
+void combat_set_fast_mode(bool enabled);
+bool combat_is_fast_mode();
+void combat_set_round_limit(int rounds);
+void combat_get_stats(CombatStats* stats);
+void combat_reset_stats();
 void combat_end_turn();
 void combat(STRUCT_664980* attack);
 void combat_ctd_init(Attack* attack, Object* attacker, Object* defender, int hitMode, int hitLocation);
@@ -42,6 +62,7 @@ int combat_bullet_start(const Object* a1, const Object* a2);
 void compute_explosion_on_extras(Attack* attack, int a2, bool isGrenade, int a4);
 int determine_to_hit(Object* a1, Object* a2, int hitLocation, int hitMode);
 int determine_to_hit_no_range(Object* a1, Object* a2, int hitLocation, int hitMode);
+void combat_to_hit_cache_invalidate();
 void death_checks(Attack* attack);
 void apply_damage(Attack* attack, bool animated);
 void combat_display(Attack* attack);
@@ -1,5 +1,6 @@
 #include "game/combatai.h"
 
+#include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -34,6 +35,9 @@
 
 namespace fallout {
 
+// CE: Maximum length of `cap_index`.
+#define AI_CAP_INDEX_MAX_LENGTH 4096
+
 typedef enum HurtTooMuch {
     HURT_BLIND,
     HURT_CRIPPLED,
@@ -42,17 +46,28 @@ typedef enum HurtTooMuch {
     HURT_COUNT,
 } HurtTooMuch;
 
+// CE: Observer-independent part of `is_within_perception`.
+typedef struct AiPerceptionTarget {
+    Object* critter;
+    bool inCombat;
+    bool isSneakingDude;
+
+    // Ambient light is low enough for short-range awareness (outside of
+    // combat, unless target is sneaking dude).
+    bool isDarkCave;
+} AiPerceptionTarget;
+
 static void parse_hurt_str(char* str, int* out_value);
 static AiPacket* ai_cap(Object* obj);
 static int ai_magic_hands(Object* critter, Object* item, int num);
 static int ai_check_drugs(Object* critter);
 static void ai_run_away(Object* critter);
 static int compare_nearer(const void* critter_ptr1, const void* critter_ptr2);
+static int compare_nearer_entry(const void* entry_ptr1, const void* entry_ptr2);
 static void ai_sort_list(Object** critterList, int length, Object* origin);
 static Object* ai_find_nearest_team(Object* critter, Object* other, int flags);
 static int ai_find_attackers(Object* critter, Object** a2, Object** a3, Object** a4);
 static Object* ai_have_ammo(Object* critter, Object* weapon);
-static Object* ai_best_weapon(Object* weapon1, Object* weapon2);
 static bool ai_can_use_weapon(Object* critter, Object* weapon, int hitMode);
 static Object* ai_search_environ(Object* critter, int itemType);
 static Object* ai_retrieve_object(Object* critter, Object* item);
@@ -64,8 +79,12 @@ static int ai_attack(Object* critter, Object* target, int hit_mode);
 static int ai_try_attack(Object* critter, Object* target);
 static int ai_print_msg(Object* critter, int type);
 static int combatai_rating(Object* obj);
+static void ai_perception_target_init(AiPerceptionTarget* target, Object* critter);
+static bool ai_is_perceived(Object* critter1, const AiPerceptionTarget* target);
 static int combatai_load_messages();
 static int combatai_unload_messages();
+static void ai_cap_index_init();
+static void ai_cap_index_exit();
 
 // 0x504BF8
 static Object* combat_obj = NULL;
@@ -76,6 +95,11 @@ static int num_caps = 0;
 // 0x504C00
 static bool combatai_is_initialized = false;
 
+// CE: Maps packet number to index of first packet with this number in `cap`
+// (-1 if there is none), see `ai_cap`.
+static int* cap_index = NULL;
+static int cap_index_length = 0;
+
 // 0x504C04
 static const char* matchHurtStrs[HURT_COUNT] = {
     "blind",
@@ -222,6 +246,7 @@ int combat_ai_init()
                 rc = -1;
             } else {
                 num_caps = config.size;
+                ai_cap_index_init();
             }
         } else {
             rc = -1;
@@ -261,6 +286,8 @@ int combat_ai_exit()
     mem_free(cap);
     num_caps = 0;
 
+    ai_cap_index_exit();
+
     combatai_is_initialized = false;
 
     // NOTE: Uninline.
@@ -312,6 +339,13 @@ static AiPacket* ai_cap(Object* obj)
 {
     int index;
     int packet_num = obj->data.critter.combat.aiPacket;
+
+    // CE: Use packet number index, fall back to scan for numbers out of its
+    // range.
+    if (packet_num >= 0 && packet_num < cap_index_length && cap_index[packet_num] != -1) {
+        return &(cap[cap_index[packet_num]]);
+    }
+
     for (index = 0; index < num_caps; index++) {
         if (packet_num == cap[index].packet_num) {
             return &(cap[index]);
@@ -323,6 +357,54 @@ static AiPacket* ai_cap(Object* obj)
     return &(cap[0]);
 }
 
+// CE: Builds `cap_index` for packets loaded from ai.txt.
+static void ai_cap_index_init()
+{
+    int index;
+    int max_packet_num = -1;
+
+    ai_cap_index_exit();
+
+    for (index = 0; index < num_caps; index++) {
+        if (cap[index].packet_num > max_packet_num) {
+            max_packet_num = cap[index].packet_num;
+        }
+    }
+
+    // Packet numbers are small, do not bother with sparse ones.
+    if (max_packet_num < 0 || max_packet_num >= AI_CAP_INDEX_MAX_LENGTH) {
+        return;
+    }
+
+    cap_index = (int*)mem_malloc(sizeof(*cap_index) * (max_packet_num + 1));
+    if (cap_index == NULL) {
+        return;
+    }
+
+    cap_index_length = max_packet_num + 1;
+
+    for (index = 0; index < cap_index_length; index++) {
+        cap_index[index] = -1;
+    }
+
+    // First packet wins, same as linear scan in `ai_cap`.
+    for (index = num_caps - 1; index >= 0; index--) {
+        if (cap[index].packet_num >= 0) {
+            cap_index[cap[index].packet_num] = index;
+        }
+    }
+}
+
+static void ai_cap_index_exit()
+{
+    if (cap_index != NULL) {
+        mem_free(cap_index);
+        cap_index = NULL;
+    }
+
+    cap_index_length = 0;
+}
+
 // 0x424B40
 static int ai_magic_hands(Object* critter, Object* item, int num)
 {
@@ -476,11 +558,60 @@ static int compare_nearer(const void* critter_ptr1, const void* critter_ptr2)
     }
 }
 
+// CE: Distance of list object to origin, computed once per sort.
+typedef struct AiSortEntry {
+    Object* obj;
+    int distance;
+} AiSortEntry;
+
+// CE: Same ordering as `compare_nearer` (including `NULL`s placed last).
+static int compare_nearer_entry(const void* entry_ptr1, const void* entry_ptr2)
+{
+    const AiSortEntry* entry1 = (const AiSortEntry*)entry_ptr1;
+    const AiSortEntry* entry2 = (const AiSortEntry*)entry_ptr2;
+
+    if (entry1->distance < entry2->distance) {
+        return -1;
+    } else if (entry1->distance > entry2->distance) {
+        return 1;
+    } else {
+        return 0;
+    }
+}
+
 // 0x424E88
 static void ai_sort_list(Object** critterList, int length, Object* origin)
 {
     combat_obj = origin;
-    qsort(critterList, length, sizeof(*critterList), compare_nearer);
+
+    // CE: `compare_nearer` calculates two distances on every comparison.
+    // Sort by distances calculated upfront instead. Comparisons yield the
+    // same results, so resulting order (which matters for ties) is the same.
+    AiSortEntry stackEntries[64];
+    AiSortEntry* entries = stackEntries;
+    if (length > 64) {
+        entries = (AiSortEntry*)mem_malloc(sizeof(*entries) * length);
+        if (entries == NULL) {
+            qsort(critterList, length, sizeof(*critterList), compare_nearer);
+            return;
+        }
+    }
+
+    for (int index = 0; index < length; index++) {
+        Object* obj = critterList[index];
+        entries[index].obj = obj;
+        entries[index].distance = obj != NULL ? obj_dist(obj, origin) : INT_MAX;
+    }
+
+    qsort(entries, length, sizeof(*entries), compare_nearer_entry);
+
+    for (int index = 0; index < length; index++) {
+        critterList[index] = entries[index].obj;
+    }
+
+    if (entries != stackEntries) {
+        mem_free(entries);
+    }
 }
 
 // 0x424EA0
@@ -644,48 +775,6 @@ static Object* ai_have_ammo(Object* critter, Object* weapon)
     return NULL;
 }
 
-// 0x4251B0
-static Object* ai_best_weapon(Object* weapon1, Object* weapon2)
-{
-    int attack_type1;
-    int attack_type2;
-
-    if (weapon1 == NULL) {
-        return weapon2;
-    }
-
-    if (weapon2 == NULL) {
-        return weapon1;
-    }
-
-    attack_type1 = item_w_subtype(weapon1, HIT_MODE_LEFT_WEAPON_PRIMARY);
-    attack_type2 = item_w_subtype(weapon2, HIT_MODE_LEFT_WEAPON_PRIMARY);
-
-    if (attack_type1 != attack_type2) {
-        if (attack_type1 == ATTACK_TYPE_RANGED) {
-            return weapon1;
-        }
-
-        if (attack_type2 == ATTACK_TYPE_RANGED) {
-            return weapon2;
-        }
-
-        if (attack_type1 == ATTACK_TYPE_THROW) {
-            return weapon1;
-        }
-
-        if (attack_type2 == ATTACK_TYPE_THROW) {
-            return weapon2;
-        }
-    }
-
-    if (item_cost(weapon2) > item_cost(weapon1)) {
-        return weapon2;
-    } else {
-        return weapon1;
-    }
-}
-
 // 0x425210
 static bool ai_can_use_weapon(Object* critter, Object* weapon, int hitMode)
 {
@@ -732,6 +821,11 @@ Object* ai_search_inven(Object* critter, int check_action_points)
         return NULL;
     }
 
+    // CE: Attack type and cost of the best weapon so far, so that
+    // comparisons do not recompute them for every candidate.
+    int best_attack_type = ATTACK_TYPE_NONE;
+    int best_cost = 0;
+
     best_weapon = NULL;
     current_item = inven_right_hand(critter);
     while (true) {
@@ -762,7 +856,32 @@ Object* ai_search_inven(Object* critter, int check_action_points)
             }
         }
 
-        best_weapon = ai_best_weapon(best_weapon, candidate);
+        // CE: Prefer ranged weapons, then throwing ones, then more expensive
+        // ones (ties keep the earlier weapon). Inlined `ai_best_weapon`.
+        int attack_type = item_w_subtype(candidate, HIT_MODE_LEFT_WEAPON_PRIMARY);
+        if (best_weapon != NULL && attack_type != best_attack_type) {
+            if (best_attack_type == ATTACK_TYPE_RANGED) {
+                continue;
+            }
+
+            if (attack_type != ATTACK_TYPE_RANGED && best_attack_type == ATTACK_TYPE_THROW) {
+                continue;
+            }
+
+            if (attack_type == ATTACK_TYPE_RANGED || attack_type == ATTACK_TYPE_THROW) {
+                best_weapon = candidate;
+                best_attack_type = attack_type;
+                best_cost = item_cost(candidate);
+                continue;
+            }
+        }
+
+        int cost = item_cost(candidate);
+        if (best_weapon == NULL || cost > best_cost) {
+            best_weapon = candidate;
+            best_attack_type = attack_type;
+            best_cost = cost;
+        }
     }
 
     return best_weapon;
@@ -864,7 +983,7 @@ static int ai_pick_hit_mode(Object* critter, Object* weapon)
         return HIT_MODE_RIGHT_WEAPON_PRIMARY;
     }
 
-    if (roll_random(1, ai_cap(critter)->secondary_freq) != 1) {
+    if (roll_random_stream(ROLL_STREAM_AI, 1, ai_cap(critter)->secondary_freq) != 1) {
         return HIT_MODE_RIGHT_WEAPON_PRIMARY;
     }
 
@@ -952,7 +1071,7 @@ static int ai_called_shot(Object* critter, Object* target, int hit_mode)
     if (item_w_mp_cost(critter, hit_mode, 1) <= critter->data.critter.combat.ap) {
         if (item_w_called_shot(critter, hit_mode)) {
             ai = ai_cap(critter);
-            if (roll_random(1, ai->called_freq) == 1) {
+            if (roll_random_stream(ROLL_STREAM_AI, 1, ai->called_freq) == 1) {
                 combat_difficulty = COMBAT_DIFFICULTY_NORMAL;
                 config_get_value(&game_config, GAME_CONFIG_PREFERENCES_KEY, GAME_CONFIG_COMBAT_DIFFICULTY_KEY, &combat_difficulty);
                 switch (combat_difficulty) {
@@ -968,7 +1087,7 @@ static int ai_called_shot(Object* critter, Object* target, int hit_mode)
                 }
 
                 if (stat_level(critter, STAT_INTELLIGENCE) >= min_intelligence) {
-                    hit_location = roll_random(0, 8);
+                    hit_location = roll_random_stream(ROLL_STREAM_AI, 0, 8);
                     to_hit = determine_to_hit(critter, target, hit_location, hit_mode);
                     if (to_hit < ai->min_to_hit) {
                         hit_location = HIT_LOCATION_TORSO;
@@ -1405,7 +1524,7 @@ int combatai_msg(Object* critter, Attack* attack, int type, int delay)
 
     debug_printf("%s is using %s packet with a %d%% chance to taunt\n", object_name(critter), ai->name, ai->chance);
 
-    if (roll_random(1, 100) > ai->chance) {
+    if (roll_random_stream(ROLL_STREAM_AI, 1, 100) > ai->chance) {
         return -1;
     }
 
@@ -1443,7 +1562,7 @@ int combatai_msg(Object* critter, Attack* attack, int type, int delay)
         return -1;
     }
 
-    messageListItem.num = roll_random(start, end);
+    messageListItem.num = roll_random_stream(ROLL_STREAM_COSMETIC, start, end);
     if (!message_search(&ai_message_file, &messageListItem)) {
         return -1;
     }
@@ -1466,6 +1585,11 @@ static int ai_print_msg(Object* critter, int type)
         return 0;
     }
 
+    // CE: Fast combat shows no floating text.
+    if (combat_is_fast_mode()) {
+        return 0;
+    }
+
     switch (type) {
     case AI_MESSAGE_TYPE_HIT:
     case AI_MESSAGE_TYPE_MISS:
@@ -1479,7 +1603,8 @@ static int ai_print_msg(Object* critter, int type)
     ai = ai_cap(critter);
 
     if (text_object_create(critter, string, ai->font, ai->color, ai->outline_color, &rect) == 0) {
-        tile_refresh_rect(&rect, critter->elevation);
+        // CE: Drawn together with other text objects on next tick.
+        text_object_refresh(&rect);
     }
 
     return 0;
@@ -1499,7 +1624,7 @@ Object* combat_ai_random_target(Attack* attack)
 
     if (curr_crit_num != 0) {
         // Randomize starting critter.
-        int start = roll_random(0, curr_crit_num - 1);
+        int start = roll_random_stream(ROLL_STREAM_AI, 0, curr_crit_num - 1);
         int index = start;
         while (true) {
             Object* obj = curr_crit_list[index];
@@ -1576,27 +1701,46 @@ void combatai_check_retaliation(Object* critter, Object* candidate)
 // 0x4262A0
 bool is_within_perception(Object* critter1, Object* critter2)
 {
+    AiPerceptionTarget target;
+
+    // CE: Split into target and observer parts, see
+    // `combatai_notify_onlookers`.
+    ai_perception_target_init(&target, critter2);
+    return ai_is_perceived(critter1, &target);
+}
+
+// CE: Prepares observer-independent part of `is_within_perception` check
+// of `critter`.
+static void ai_perception_target_init(AiPerceptionTarget* target, Object* critter)
+{
+    // set_light_level(40) maps to this ambient intensity in script-driven dark caves.
+    static constexpr int kDarkCaveAmbientLight = LIGHT_LEVEL_MAX * 40 / 100;
+
+    target->critter = critter;
+    target->inCombat = isInCombat();
+    target->isSneakingDude = critter == obj_dude && is_pc_sneak_working();
+    target->isDarkCave = !target->inCombat && !target->isSneakingDude && light_get_ambient() <= kDarkCaveAmbientLight;
+}
+
+// CE: Observer part of `is_within_perception`.
+static bool ai_is_perceived(Object* critter1, const AiPerceptionTarget* target)
+{
+    Object* critter2 = target->critter;
     int distance;
     int perception;
     int max_distance;
-    bool inCombat;
-    bool targetIsSneakingDude;
 
-    // set_light_level(40) maps to this ambient intensity in script-driven dark caves.
-    static constexpr int kDarkCaveAmbientLight = LIGHT_LEVEL_MAX * 40 / 100;
     static constexpr int kDarkCaveMinDetectionDistance = 2;
 
     distance = obj_dist(critter2, critter1);
     perception = stat_level(critter1, STAT_PERCEPTION);
-    inCombat = isInCombat();
-    targetIsSneakingDude = critter2 == obj_dude && is_pc_sneak_working();
     if (can_see(critter1, critter2)) {
         max_distance = perception * 5;
         if ((critter2->flags & OBJECT_TRANS_GLASS) != 0) {
             max_distance /= 2;
         }
 
-        if (targetIsSneakingDude) {
+        if (target->isSneakingDude) {
             max_distance /= 4;
         }
 
@@ -1608,13 +1752,13 @@ bool is_within_perception(Object* critter1, Object* critter2)
             return true;
         }
     } else {
-        if (inCombat) {
+        if (target->inCombat) {
             max_distance = perception * 2;
         } else {
             max_distance = perception;
         }
 
-        if (targetIsSneakingDude) {
+        if (target->isSneakingDude) {
             max_distance /= 4;
         }
 
@@ -1623,7 +1767,7 @@ bool is_within_perception(Object* critter1, Object* critter2)
         }
 
         // Preserve short-range awareness in dark caves where scripts set low ambient light.
-        if (!inCombat && !targetIsSneakingDude && light_get_ambient() <= kDarkCaveAmbientLight && max_distance < kDarkCaveMinDetectionDistance) {
+        if (target->isDarkCave && max_distance < kDarkCaveMinDetectionDistance) {
             max_distance = kDarkCaveMinDetectionDistance;
         }
 
@@ -1699,9 +1843,14 @@ void combatai_refresh_messages()
 void combatai_notify_onlookers(Object* critter)
 {
     int index;
+    AiPerceptionTarget target;
+
+    // CE: Observed critter is the same for every onlooker, and setting
+    // maneuver does not affect perception, so its part is computed once.
+    ai_perception_target_init(&target, critter);
 
     for (index = 0; index < curr_crit_num; index++) {
-        if (is_within_perception(curr_crit_list[index], critter)) {
+        if (ai_is_perceived(curr_crit_list[index], &target)) {
             curr_crit_list[index]->data.critter.combat.maneuver |= CRITTER_MANEUVER_ENGAGING;
         }
     }
@@ -20,6 +20,12 @@ static bool config_parse_line(Config* config, char* string);
 static bool config_split_line(char* string, char* key, char* value);
 static bool config_add_section(Config* config, const char* sectionKey);
 static bool config_strip_white_space(char* string);
+static void config_handle_resolve(ConfigHandle* handle);
+static void config_handles_refresh(Config* config, const char* sectionKey, const char* key);
+static void config_handles_unbind(Config* config);
+
+// CE: List of bound config handles (see `ConfigHandle`).
+static ConfigHandle* config_handles = NULL;
 
 // 0x426540
 bool config_init(Config* config)
@@ -42,6 +48,8 @@ void config_exit(Config* config)
         return;
     }
 
+    config_handles_unbind(config);
+
     for (int sectionIndex = 0; sectionIndex < config->size; sectionIndex++) {
         assoc_pair* sectionEntry = &(config->list[sectionIndex]);
 
@@ -167,14 +175,18 @@ bool config_set_string(Config* config, const char* sectionKey, const char* key,
 
     char* valueCopy = mem_strdup(value);
     if (valueCopy == NULL) {
+        config_handles_refresh(config, sectionKey, key);
         return false;
     }
 
     if (assoc_insert(section, key, &valueCopy) == -1) {
         mem_free(valueCopy);
+        config_handles_refresh(config, sectionKey, key);
         return false;
     }
 
+    config_handles_refresh(config, sectionKey, key);
+
     return true;
 }
 
@@ -531,4 +543,86 @@ bool configSetBool(Config* config, const char* sectionKey, const char* key, bool
     return config_set_value(config, sectionKey, key, value ? 1 : 0);
 }
 
+// CE: Binds handle to config and resolves its current value. Handle must
+// outlive the binding, it is unbound with [config_handle_unbind] or when config
+// is freed with [config_exit].
+bool config_handle_bind(ConfigHandle* handle, Config* config)
+{
+    if (handle == NULL || config == NULL || handle->sectionKey == NULL || handle->key == NULL) {
+        return false;
+    }
+
+    config_handle_unbind(handle);
+
+    handle->config = config;
+    handle->next = config_handles;
+    config_handles = handle;
+
+    config_handle_resolve(handle);
+
+    return true;
+}
+
+void config_handle_unbind(ConfigHandle* handle)
+{
+    if (handle == NULL) {
+        return;
+    }
+
+    ConfigHandle** link = &config_handles;
+    while (*link != NULL) {
+        if (*link == handle) {
+            *link = handle->next;
+            break;
+        }
+        link = &((*link)->next);
+    }
+
+    handle->config = NULL;
+    handle->valid = false;
+    handle->next = NULL;
+}
+
+static void config_handle_resolve(ConfigHandle* handle)
+{
+    char* stringValue;
+    if (!config_get_string(handle->config, handle->sectionKey, handle->key, &stringValue)) {
+        handle->valid = false;
+        handle->intValue = 0;
+        handle->doubleValue = 0.0;
+        return;
+    }
+
+    handle->valid = true;
+    handle->intValue = atoi(stringValue);
+    handle->doubleValue = strtod(stringValue, NULL);
+}
+
+static void config_handles_refresh(Config* config, const char* sectionKey, const char* key)
+{
+    for (ConfigHandle* handle = config_handles; handle != NULL; handle = handle->next) {
+        if (handle->config == config
+            && compat_stricmp(handle->key, key) == 0
+            && compat_stricmp(handle->sectionKey, sectionKey) == 0) {
+            config_handle_resolve(handle);
+        }
+    }
+}
+
+static void config_handles_unbind(Config* config)
+{
+    ConfigHandle** link = &config_handles;
+    while (*link != NULL) {
+        ConfigHandle* handle = *link;
+        if (handle->config == config) {
+            *link = handle->next;
+            handle->config = NULL;
+            handle->valid = false;
+            handle->next = NULL;
+        } else {
+            link = &(handle->next);
+        }
+    }
+}
+
 } // namespace fallout
@@ -17,6 +17,24 @@ typedef assoc_array Config;
 // key-pair values, and it's values are pointers to strings (char**).
 typedef assoc_array ConfigSection;
 
+// CE: Pre-resolved typed view of a single config value.
+//
+// Handle is bound to a config once with [config_handle_bind] and then kept in
+// sync by [config_set_string] (and every setter built on top of it), so hot
+// paths can read the value without searching sections and parsing strings.
+// `intValue` and `doubleValue` are parsed the same way as in
+// [config_get_value] and [config_get_double]. `valid` is false when the key
+// is missing.
+typedef struct ConfigHandle {
+    const char* sectionKey;
+    const char* key;
+    Config* config;
+    bool valid;
+    int intValue;
+    double doubleValue;
+    struct ConfigHandle* next;
+} ConfigHandle;
+
 bool config_init(Config* config);
 void config_exit(Config* config);
 bool config_cmd_line_parse(Config* config, int argc, char** argv);
@@ -30,6 +48,39 @@ bool config_save(Config* config, const char* filePath, bool isDb);
 bool config_get_double(Config* config, const char* sectionKey, const char* key, double* valuePtr);
 bool config_set_double(Config* config, const char* sectionKey, const char* key, double value);
 
+bool config_handle_bind(ConfigHandle* handle, Config* config);
+void config_handle_unbind(ConfigHandle* handle);
+
+static inline bool config_handle_get_value(const ConfigHandle* handle, int* valuePtr)
+{
+    if (!handle->valid) {
+        return false;
+    }
+
+    *valuePtr = handle->intValue;
+    return true;
+}
+
+static inline bool config_handle_get_double(const ConfigHandle* handle, double* valuePtr)
+{
+    if (!handle->valid) {
+        return false;
+    }
+
+    *valuePtr = handle->doubleValue;
+    return true;
+}
+
+static inline bool config_handle_get_bool(const ConfigHandle* handle, bool* valuePtr)
+{
+    if (!handle->valid) {
+        return false;
+    }
+
+    *valuePtr = handle->intValue != 0;
+    return true;
+}
+
 // TODO: Remove.
 bool configGetBool(Config* config, const char* sectionKey, const char* key, bool* valuePtr);
 bool configSetBool(Config* config, const char* sectionKey, const char* key, bool value);
@@ -22,6 +22,7 @@
 #include "game/scripts.h"
 #include "game/skill.h"
 #include "game/stat.h"
+#include "game/statever.h"
 #include "game/tile.h"
 #include "game/trait.h"
 #include "game/worldmap.h"
@@ -171,6 +172,9 @@ int critter_save(DB_FILE* stream)
 void critter_copy(CritterProtoData* dest, CritterProtoData* src)
 {
     memcpy(dest, src, sizeof(CritterProtoData));
+
+    // CE: Character editor restores dude proto this way.
+    stat_cache_invalidate();
 }
 
 // 0x4279B8
@@ -241,6 +245,7 @@ int critter_adjust_hits(Object* critter, int hp)
     int newHp = critter->data.critter.hp + hp;
 
     critter->data.critter.hp = newHp;
+    statever_bump(STATE_VERSION_OBJECTS);
     if (maximumHp >= newHp) {
         if (newHp <= 0 && (critter->data.critter.combat.results & DAM_DEAD) == 0) {
             critter_kill(critter, -1, true);
@@ -765,6 +770,7 @@ void critter_kill(Object* critter, int anim, bool refresh_window)
 
     if (critter->pid != 16777265 && critter->pid != 16777266 && critter->pid != 16777224) {
         critter->flags |= OBJECT_NO_BLOCK;
+        obj_update_blocking(critter);
         if ((critter->flags & OBJECT_FLAT) == 0) {
             obj_toggle_flat(critter, &tempRect);
         }
@@ -943,6 +949,8 @@ int pc_load_data(const char* path)
     proto->critter.data.experience = 0;
     proto->critter.data.killType = 0;
 
+    stat_cache_invalidate();
+
     db_fclose(stream);
     return 0;
 }
@@ -958,6 +966,9 @@ int critter_read_data(DB_FILE* stream, CritterProtoData* critterData)
     if (db_freadInt(stream, &(critterData->experience)) == -1) return -1;
     if (db_freadInt(stream, &(critterData->killType)) == -1) return -1;
 
+    // CE: Stats of this proto might be memoized.
+    stat_cache_invalidate();
+
     return 0;
 }
 
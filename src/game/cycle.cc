@@ -1,5 +1,9 @@
 #include "game/cycle.h"
 
+#include <limits.h>
+
+#include <algorithm>
+
 #include "game/gconfig.h"
 #include "game/palette.h"
 #include "plib/color/color.h"
@@ -182,6 +186,23 @@ bool cycle_is_enabled()
     return cycle_enabled;
 }
 
+// CE: Returns number of milliseconds until next color cycling step (UINT_MAX
+// if cycling is disabled).
+unsigned int cycle_next_delay()
+{
+    if (!cycle_enabled) {
+        return UINT_MAX;
+    }
+
+    unsigned int time = get_time();
+    unsigned int delay = remaining_tocks(time, last_cycle_slow, COLOR_CYCLE_PERIOD_SLOW * cycle_speed_factor);
+    delay = std::min(delay, remaining_tocks(time, last_cycle_medium, COLOR_CYCLE_PERIOD_MEDIUM * cycle_speed_factor));
+    delay = std::min(delay, remaining_tocks(time, last_cycle_fast, COLOR_CYCLE_PERIOD_FAST * cycle_speed_factor));
+    delay = std::min(delay, remaining_tocks(time, last_cycle_very_fast, COLOR_CYCLE_PERIOD_VERY_FAST * cycle_speed_factor));
+
+    return delay;
+}
+
 // 0x428F5C
 static void cycle_colors()
 {
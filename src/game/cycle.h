@@ -15,6 +15,7 @@ void cycle_exit();
 void cycle_disable();
 void cycle_enable();
 bool cycle_is_enabled();
+unsigned int cycle_next_delay();
 void change_cycle_speed(int value);
 int get_cycle_speed();
 
@@ -79,6 +79,15 @@ static int max_ptr;
 // 0x56E2DE4
 static int disp_start;
 
+// CE: Rendered text of visible lines (one row of `text_height` per line,
+// transparent background), valid for `disp_text_curr`. Appending lines
+// scrolls it and renders new lines only, see `display_render_text`.
+static unsigned char* disp_text_buf;
+static int disp_text_curr;
+static bool disp_text_valid;
+
+static void display_render_text();
+
 // 0x42BBE0
 int display_init()
 {
@@ -97,10 +106,19 @@ int display_init()
             return -1;
         }
 
+        disp_text_buf = (unsigned char*)mem_malloc(DISPLAY_MONITOR_WIDTH * DISPLAY_MONITOR_HEIGHT);
+        if (disp_text_buf == NULL) {
+            mem_free(disp_buf);
+            return -1;
+        }
+
+        disp_text_valid = false;
+
         CacheEntry* backgroundFrmHandle;
         int backgroundFid = art_id(OBJ_TYPE_INTERFACE, 16, 0, 0, 0);
         Art* backgroundFrm = art_ptr_lock(backgroundFid, &backgroundFrmHandle);
         if (backgroundFrm == NULL) {
+            mem_free(disp_text_buf);
             mem_free(disp_buf);
             return -1;
         }
@@ -181,6 +199,7 @@ int display_reset()
 void display_exit()
 {
     if (disp_init) {
+        mem_free(disp_text_buf);
         mem_free(disp_buf);
         disp_init = false;
     }
@@ -289,6 +308,7 @@ void display_clear()
 
         disp_start = 0;
         disp_curr = 0;
+        disp_text_valid = false;
         display_redraw();
     }
 }
@@ -316,9 +336,16 @@ void display_redraw()
     int oldFont = text_curr();
     text_font(DISPLAY_MONITOR_FONT);
 
+    display_render_text();
+
+    int lineHeight = text_height();
     for (int index = 0; index < max_disp_ptr; index++) {
-        int stringIndex = (disp_curr + max_ptr + index - max_disp_ptr) % max_ptr;
-        text_to_buf(buf + index * intface_full_wid * text_height(), disp_str[stringIndex], DISPLAY_MONITOR_WIDTH, intface_full_wid, colorTable[992]);
+        trans_buf_to_buf(disp_text_buf + index * lineHeight * DISPLAY_MONITOR_WIDTH,
+            DISPLAY_MONITOR_WIDTH,
+            lineHeight,
+            DISPLAY_MONITOR_WIDTH,
+            buf + index * intface_full_wid * lineHeight,
+            intface_full_wid);
 
         // Even though the display monitor is rectangular, it's graphic is not.
         // To give a feel of depth it's covered by some metal canopy and
@@ -332,6 +359,49 @@ void display_redraw()
     text_font(oldFont);
 }
 
+// CE: Brings `disp_text_buf` up to date with `disp_curr`. When view moved by
+// less than a screenful (new lines printed, or scrolled by arrows) rows still
+// visible are moved and only lines coming into view are rendered. Expects
+// display monitor font to be current.
+static void display_render_text()
+{
+    int lineHeight = text_height();
+    int lineSize = lineHeight * DISPLAY_MONITOR_WIDTH;
+
+    int firstLine = 0;
+    int lastLine = max_disp_ptr;
+
+    if (disp_text_valid) {
+        int forward = (disp_curr - disp_text_curr + max_ptr) % max_ptr;
+        int backward = (disp_text_curr - disp_curr + max_ptr) % max_ptr;
+        if (forward == 0) {
+            return;
+        }
+
+        if (forward < max_disp_ptr) {
+            memmove(disp_text_buf,
+                disp_text_buf + forward * lineSize,
+                (max_disp_ptr - forward) * lineSize);
+            firstLine = max_disp_ptr - forward;
+        } else if (backward < max_disp_ptr) {
+            memmove(disp_text_buf + backward * lineSize,
+                disp_text_buf,
+                (max_disp_ptr - backward) * lineSize);
+            lastLine = backward;
+        }
+    }
+
+    memset(disp_text_buf + firstLine * lineSize, 0, (lastLine - firstLine) * lineSize);
+
+    for (int index = firstLine; index < lastLine; index++) {
+        int stringIndex = (disp_curr + max_ptr + index - max_disp_ptr) % max_ptr;
+        text_to_buf(disp_text_buf + index * lineSize, disp_str[stringIndex], DISPLAY_MONITOR_WIDTH, DISPLAY_MONITOR_WIDTH, colorTable[992]);
+    }
+
+    disp_text_curr = disp_curr;
+    disp_text_valid = true;
+}
+
 // 0x42C138
 void display_scroll_up(int btn, int keyCode)
 {
@@ -369,7 +369,7 @@ static int endgame_init()
     gsound_speech_callback_set(endgame_voiceover_callback);
 
     endgame_do_subtitles = false;
-    configGetBool(&game_config, GAME_CONFIG_PREFERENCES_KEY, GAME_CONFIG_SUBTITLES_KEY, &endgame_do_subtitles);
+    config_handle_get_bool(&game_config_subtitles, &endgame_do_subtitles);
     if (!endgame_do_subtitles) {
         return 0;
     }
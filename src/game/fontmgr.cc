@@ -30,7 +30,31 @@ typedef struct InterfaceFontDescriptor {
     unsigned char* data;
 } InterfaceFontDescriptor;
 
+// CE: Horizontal run of non-blank pixels of a glyph.
+typedef struct InterfaceFontSpan {
+    short x;
+    short y;
+    short length;
+    // Offset of run's first pixel into [InterfaceFontDescriptor.data].
+    int offset;
+} InterfaceFontSpan;
+
+// CE: Glyphs of a font pre-expanded into spans of non-blank pixels. Blank
+// pixels map to the destination pixel itself in every color blend table, so
+// they can be skipped. Advances make measuring a single lookup per character.
+typedef struct InterfaceFontCache {
+    // Glyph (or word spacing for space) width plus letter spacing.
+    int advance[256];
+
+    // Spans of glyph `n` are `spans[spanIndex[n]]` to
+    // `spans[spanIndex[n + 1] - 1]`. NULL if font is drawn pixel by pixel.
+    int spanIndex[257];
+    InterfaceFontSpan* spans;
+} InterfaceFontCache;
+
 static int FMLoadFont(int font);
+static bool FMEnsureFont(int font);
+static void FMBuildCache(int font, int dataSize);
 static void swapUInt32(unsigned int* value);
 static void swapUInt16(unsigned short* value);
 
@@ -52,21 +76,23 @@ static int gCurrentFontNum;
 // 0x58CC0C
 static InterfaceFontDescriptor* gCurrentFont;
 
+static InterfaceFontCache gFontCacheSpans[INTERFACE_FONT_MAX];
+static InterfaceFontCache* gCurrentFontSpans;
+
+// CE: Set once font was loaded (or failed to load), see `FMEnsureFont`.
+static bool gFontLoadAttempted[INTERFACE_FONT_MAX];
+
 // 0x43A780
 int FMInit()
 {
     int currentFont = -1;
 
+    // CE: Only the first available font is loaded upfront, the rest are
+    // loaded when selected (see `FMtext_font`) or by `FMPreload`.
     for (int font = 0; font < INTERFACE_FONT_MAX; font++) {
-        if (FMLoadFont(font) == -1) {
-            gFontCache[font].maxHeight = 0;
-            gFontCache[font].data = NULL;
-        } else {
-            ++gNumFonts;
-
-            if (currentFont == -1) {
-                currentFont = font;
-            }
+        if (FMEnsureFont(font)) {
+            currentFont = font;
+            break;
         }
     }
 
@@ -87,10 +113,50 @@ void FMExit()
     for (int font = 0; font < INTERFACE_FONT_MAX; font++) {
         if (gFontCache[font].data != NULL) {
             myfree(gFontCache[font].data, __FILE__, __LINE__); // FONTMGR.C, 124
+            gFontCache[font].data = NULL;
         }
+
+        if (gFontCacheSpans[font].spans != NULL) {
+            myfree(gFontCacheSpans[font].spans, __FILE__, __LINE__);
+            gFontCacheSpans[font].spans = NULL;
+        }
+
+        gFontLoadAttempted[font] = false;
     }
 }
 
+// CE: Loads all fonts not loaded yet, so that UI does not stall on first
+// use of a font.
+int FMPreload()
+{
+    if (!gFMInit) {
+        return -1;
+    }
+
+    for (int font = 0; font < INTERFACE_FONT_MAX; font++) {
+        FMEnsureFont(font);
+    }
+
+    return 0;
+}
+
+// CE: Loads font on first use, returns `true` if font is available.
+static bool FMEnsureFont(int font)
+{
+    if (!gFontLoadAttempted[font]) {
+        gFontLoadAttempted[font] = true;
+
+        if (FMLoadFont(font) == -1) {
+            gFontCache[font].maxHeight = 0;
+            gFontCache[font].data = NULL;
+        } else {
+            ++gNumFonts;
+        }
+    }
+
+    return gFontCache[font].data != NULL;
+}
+
 // 0x43A820
 static int FMLoadFont(int font_index)
 {
@@ -180,9 +246,85 @@ static int FMLoadFont(int font_index)
 
     db_fclose(stream);
 
+    FMBuildCache(font_index, glyphDataSize);
+
     return 0;
 }
 
+// CE: Builds glyph cache of font `font_index`. Spans are optional: if glyph
+// data is inconsistent or spans cannot be allocated glyphs are drawn pixel by
+// pixel.
+static void FMBuildCache(int font_index, int dataSize)
+{
+    InterfaceFontDescriptor* fontDescriptor = &(gFontCache[font_index]);
+    InterfaceFontCache* cache = &(gFontCacheSpans[font_index]);
+
+    for (int ch = 0; ch < 256; ch++) {
+        int width = ch == ' ' ? fontDescriptor->wordSpacing : fontDescriptor->glyphs[ch].width;
+        cache->advance[ch] = width + fontDescriptor->letterSpacing;
+    }
+
+    cache->spans = NULL;
+
+    // First pass counts spans, second one stores them.
+    int spansLength = 0;
+    for (int pass = 0; pass < 2; pass++) {
+        if (pass == 1) {
+            cache->spans = (InterfaceFontSpan*)mymalloc(sizeof(*cache->spans) * (spansLength > 0 ? spansLength : 1), __FILE__, __LINE__);
+            if (cache->spans == NULL) {
+                return;
+            }
+        }
+
+        int index = 0;
+        for (int ch = 0; ch < 256; ch++) {
+            InterfaceFontGlyph* glyph = &(fontDescriptor->glyphs[ch]);
+
+            if (glyph->width < 0 || glyph->height < 0 || glyph->offset < 0 || glyph->offset + glyph->width * glyph->height > dataSize) {
+                if (cache->spans != NULL) {
+                    myfree(cache->spans, __FILE__, __LINE__);
+                    cache->spans = NULL;
+                }
+                return;
+            }
+
+            cache->spanIndex[ch] = index;
+
+            unsigned char* row = fontDescriptor->data + glyph->offset;
+            for (int y = 0; y < glyph->height; y++) {
+                int x = 0;
+                while (x < glyph->width) {
+                    while (x < glyph->width && row[x] == 0) {
+                        x++;
+                    }
+
+                    if (x == glyph->width) {
+                        break;
+                    }
+
+                    int start = x;
+                    while (x < glyph->width && row[x] != 0) {
+                        x++;
+                    }
+
+                    if (pass == 1) {
+                        InterfaceFontSpan* span = &(cache->spans[index]);
+                        span->x = start;
+                        span->y = y;
+                        span->length = x - start;
+                        span->offset = (int)(row + start - fontDescriptor->data);
+                    }
+                    index++;
+                }
+                row += glyph->width;
+            }
+        }
+
+        cache->spanIndex[256] = index;
+        spansLength = index;
+    }
+}
+
 // 0x43AC20
 void FMtext_font(int font)
 {
@@ -192,9 +334,10 @@ void FMtext_font(int font)
 
     font -= 100;
 
-    if (gFontCache[font].data != NULL) {
+    if (FMEnsureFont(font)) {
         gCurrentFontNum = font;
         gCurrentFont = &(gFontCache[font]);
+        gCurrentFontSpans = &(gFontCacheSpans[font]);
     }
 }
 
@@ -217,17 +360,10 @@ int FMtext_width(const char* string)
 
     int stringWidth = 0;
 
+    // CE: Sum cached advances.
     while (*string != '\0') {
         unsigned char ch = (unsigned char)(*string++);
-
-        int characterWidth;
-        if (ch == ' ') {
-            characterWidth = gCurrentFont->wordSpacing;
-        } else {
-            characterWidth = gCurrentFont->glyphs[ch].width;
-        }
-
-        stringWidth += characterWidth + gCurrentFont->letterSpacing;
+        stringWidth += gCurrentFontSpans->advance[ch];
     }
 
     return stringWidth;
@@ -350,6 +486,24 @@ void FMtext_to_buf(unsigned char* buf, const char* string, int length, int pitch
         }
 
         InterfaceFontGlyph* glyph = &(gCurrentFont->glyphs[ch]);
+
+        // CE: Blend pre-expanded spans.
+        if (gCurrentFontSpans->spans != NULL) {
+            unsigned char* glyphPtr = ptr + (gCurrentFont->maxHeight - glyph->height) * pitch;
+            InterfaceFontSpan* span = &(gCurrentFontSpans->spans[gCurrentFontSpans->spanIndex[ch]]);
+            InterfaceFontSpan* spanEnd = &(gCurrentFontSpans->spans[gCurrentFontSpans->spanIndex[ch + 1]]);
+            for (; span < spanEnd; span++) {
+                unsigned char* dest = glyphPtr + span->y * pitch + span->x;
+                unsigned char* src = gCurrentFont->data + span->offset;
+                for (int x = 0; x < span->length; x++) {
+                    dest[x] = palette[(src[x] << 8) + dest[x]];
+                }
+            }
+
+            ptr = end;
+            continue;
+        }
+
         unsigned char* glyphDataPtr = gCurrentFont->data + glyph->offset;
 
         // Skip blank pixels (difference between font's line height and glyph height).
@@ -5,6 +5,7 @@ namespace fallout {
 
 int FMInit();
 void FMExit();
+int FMPreload();
 void FMtext_font(int font);
 int FMtext_height();
 int FMtext_width(const char* string);
@@ -3,10 +3,16 @@
 #include <stdio.h>
 #include <string.h>
 
+#include <algorithm>
+#include <chrono>
+
 #include "game/actions.h"
 #include "game/anim.h"
+#include "game/art.h"
 #include "game/automap.h"
 #include "game/bmpdlog.h"
+#include "game/cachestat.h"
+#include "game/cmdbatch.h"
 #include "game/combat.h"
 #include "game/combatai.h"
 #include "game/critter.h"
@@ -16,6 +22,7 @@
 #include "game/endgame.h"
 #include "game/fontmgr.h"
 #include "game/gconfig.h"
+#include "game/gdebug.h"
 #include "game/gdialog.h"
 #include "game/gmemory.h"
 #include "game/gmouse.h"
@@ -25,7 +32,9 @@
 #include "game/inventry.h"
 #include "game/item.h"
 #include "game/loadsave.h"
+#include "game/lockstep.h"
 #include "game/map.h"
+#include "game/mapstat.h"
 #include "game/moviefx.h"
 #include "game/object.h"
 #include "game/options.h"
@@ -41,6 +50,8 @@
 #include "game/skill.h"
 #include "game/skilldex.h"
 #include "game/stat.h"
+#include "game/statever.h"
+#include "game/textobj.h"
 #include "game/tile.h"
 #include "game/trait.h"
 #include "game/version.h"
@@ -50,10 +61,13 @@
 #include "platform_compat.h"
 #include "plib/color/color.h"
 #include "plib/gnw/debug.h"
+#include "plib/gnw/framecap.h"
 #include "plib/gnw/gnw.h"
 #include "plib/gnw/grbuf.h"
 #include "plib/gnw/input.h"
+#include "plib/gnw/jobs.h"
 #include "plib/gnw/memory.h"
+#include "plib/gnw/prof.h"
 #include "plib/gnw/svga.h"
 #include "plib/gnw/text.h"
 
@@ -66,11 +80,21 @@ namespace fallout {
 #define SPLASH_HEIGHT 480
 #define SPLASH_COUNT 10
 
+// CE: Longest idle wait (ms). Subsystems report their own deadlines, the cap
+// only bounds latency of work nobody reports (interpreter programs, window
+// manager housekeeping).
+#define GAME_IDLE_WAIT_MAX 1000
+
 static int game_screendump(int width, int height, unsigned char* buffer, unsigned char* palette);
 static void game_unload_info();
 static void game_help();
 static int game_init_databases();
 static void game_splash_screen();
+static unsigned int game_idle_wait();
+static void game_init_prefetch();
+static void game_init_jobs();
+static void game_init_step(const char* name);
+static void game_init_report();
 
 // TODO: Remove.
 // 0x4F190C
@@ -123,17 +147,65 @@ DB_DATABASE* master_db_handle;
 // 0x58CC1C
 DB_DATABASE* critter_db_handle;
 
+// CE: Forces headless video regardless of `f1_res.ini`, see
+// `game_force_headless`.
+static bool game_headless_forced = false;
+
+// CE: Identifies this build in startup image (see `db_image_save`).
+static const char* game_build_id = __DATE__ " " __TIME__;
+
+// CE: Maximum number of steps timed by `game_init_step`.
+#define GAME_INIT_MAX_STEPS 48
+
+// CE: Wall time of one `game_init` step (in ms).
+typedef struct GameInitStep {
+    const char* name;
+    double time;
+} GameInitStep;
+
+static GameInitStep game_init_steps[GAME_INIT_MAX_STEPS];
+static int game_init_steps_length = 0;
+static std::chrono::steady_clock::time_point game_init_step_start;
+
+// CE: Message files read by `game_init` steps, see `game_init_prefetch`.
+static const char* game_init_message_files[] = {
+    "combat.msg",
+    "combatai.msg",
+    "editor.msg",
+    "intrface.msg",
+    "inventry.msg",
+    "item.msg",
+    "misc.msg",
+    "options.msg",
+    "perk.msg",
+    "pipboy.msg",
+    "proto.msg",
+    "script.msg",
+    "skill.msg",
+    "skilldex.msg",
+    "stat.msg",
+    "trait.msg",
+    "worldmap.msg",
+};
+
 // 0x43B080
 int game_init(const char* windowTitle, bool isMapper, int font, int flags, int argc, char** argv)
 {
     char path[COMPAT_MAX_PATH];
 
+    // CE: Per-step timings are reported once initialization is complete.
+    game_init_steps_length = 0;
+    game_init_step_start = std::chrono::steady_clock::now();
+
     if (gmemory_init() == -1) {
         return -1;
     }
 
     gconfig_init(isMapper, argc, argv);
 
+    // CE: Start job system before any subsystem which adds jobs.
+    game_init_jobs();
+
     game_in_mapper = isMapper;
 
     if (game_init_databases() == -1) {
@@ -141,6 +213,27 @@ int game_init(const char* windowTitle, bool isMapper, int font, int flags, int a
         return -1;
     }
 
+    game_init_step("databases");
+
+    // CE: Seed db cache from startup image saved by previous run, or save
+    // one once initialization is complete.
+    char* startupImage = NULL;
+    config_get_string(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_STARTUP_IMAGE_KEY, &startupImage);
+    bool saveStartupImage = false;
+    if (startupImage != NULL && *startupImage != '\0') {
+        int entries = db_image_load(startupImage, game_build_id);
+        if (entries != -1) {
+            debug_printf("Startup image: %d entries\n", entries);
+        } else {
+            saveStartupImage = true;
+        }
+
+        game_init_step("db_image_load");
+    }
+
+    // CE: Read files parsed by the steps below in background.
+    game_init_prefetch();
+
     win_set_minimized_title(windowTitle);
 
     VideoOptions video_options;
@@ -148,6 +241,17 @@ int game_init(const char* windowTitle, bool isMapper, int font, int flags, int a
     video_options.height = 480;
     video_options.fullscreen = true;
     video_options.scale = 1;
+    video_options.scaleFilter = VIDEO_SCALE_FILTER_NEAREST;
+    video_options.headless = false;
+
+    bool turbo = false;
+    bool turboPresent = true;
+
+    char frameCaptureName[64];
+    frameCaptureName[0] = '\0';
+    int frameCaptureFormat = FRAMECAP_FORMAT_RGBA;
+    int frameCaptureScale = 1;
+    int frameCaptureInterval = 0;
 
     Config resolutionConfig;
     if (config_init(&resolutionConfig)) {
@@ -173,20 +277,72 @@ int game_init(const char* windowTitle, bool isMapper, int font, int flags, int a
                 video_options.width /= video_options.scale;
                 video_options.height /= video_options.scale;
             }
+
+            // CE: Filtering of screen scaled to window (`nearest`,
+            // `integer` or `sharp`).
+            char* scaleFilter;
+            if (config_get_string(&resolutionConfig, "MAIN", "SCALE_FILTER", &scaleFilter)) {
+                if (compat_stricmp(scaleFilter, "integer") == 0) {
+                    video_options.scaleFilter = VIDEO_SCALE_FILTER_INTEGER;
+                } else if (compat_stricmp(scaleFilter, "sharp") == 0) {
+                    video_options.scaleFilter = VIDEO_SCALE_FILTER_SHARP_BILINEAR;
+                }
+            }
+
+            // CE: Run without display, input comes from injected events.
+            bool headless;
+            if (configGetBool(&resolutionConfig, "MAIN", "HEADLESS", &headless)) {
+                video_options.headless = headless;
+            }
+
+            // CE: Run game time on virtual clock as fast as possible
+            // (headless only), optionally without presenting frames.
+            configGetBool(&resolutionConfig, "MAIN", "TURBO", &turbo);
+            configGetBool(&resolutionConfig, "MAIN", "TURBO_PRESENT", &turboPresent);
+
+            // CE: Export frames to shared memory for vision-based
+            // controllers.
+            char* frameCapture;
+            if (config_get_string(&resolutionConfig, "MAIN", "FRAME_CAPTURE", &frameCapture)) {
+                strncpy(frameCaptureName, frameCapture, sizeof(frameCaptureName) - 1);
+                frameCaptureName[sizeof(frameCaptureName) - 1] = '\0';
+            }
+            config_get_value(&resolutionConfig, "MAIN", "FRAME_CAPTURE_FORMAT", &frameCaptureFormat);
+            config_get_value(&resolutionConfig, "MAIN", "FRAME_CAPTURE_SCALE", &frameCaptureScale);
+            config_get_value(&resolutionConfig, "MAIN", "FRAME_CAPTURE_INTERVAL", &frameCaptureInterval);
         }
         config_exit(&resolutionConfig);
     }
 
+    if (game_headless_forced) {
+        video_options.headless = true;
+    }
+
     initWindow(&video_options, flags);
+    game_init_step("initWindow");
+
+    if (turbo && svga_is_headless()) {
+        set_turbo_mode(true, !turboPresent);
+    }
+
+    if (frameCaptureName[0] != '\0') {
+        if (!framecap_start(frameCaptureName, frameCaptureFormat, frameCaptureScale, frameCaptureInterval)) {
+            debug_printf("Failed on framecap_start\n");
+        }
+    }
+
     palette_init();
 
     if (!game_in_mapper) {
         game_splash_screen();
     }
 
+    game_init_step("splash_screen");
+
     FMInit();
     text_add_manager(&alias_mgr);
     text_font(font);
+    game_init_step("FMInit");
 
     register_screendump(KEY_F12, game_screendump);
     register_pause(-1, NULL);
@@ -199,6 +355,38 @@ int game_init(const char* windowTitle, bool isMapper, int font, int flags, int a
 
     roll_init();
     init_message();
+    game_init_step("init_message");
+
+    // CE: Periodic cache stats publishing.
+    cachestat_init();
+
+    // CE: Lockstep ticks for external controllers.
+    if (!lockstep_init()) {
+        debug_printf("Failed on lockstep_init\n");
+    }
+
+    // CE: Map load/save phase timings.
+    mapstat_init();
+
+    // CE: Frame-time profiler zones.
+    int profileTraceEvents;
+    if (config_get_value(&game_config, GAME_CONFIG_DEBUG_KEY, GAME_CONFIG_PROFILE_TRACE_EVENTS_KEY, &profileTraceEvents)) {
+        prof_set_trace_capacity(profileTraceEvents);
+    }
+
+    int profile;
+    if (config_get_value(&game_config, GAME_CONFIG_DEBUG_KEY, GAME_CONFIG_PROFILE_KEY, &profile) && profile != 0) {
+        prof_set_enabled(true);
+        prof_set_trace(true);
+
+        int profileOverlay;
+        if (config_get_value(&game_config, GAME_CONFIG_DEBUG_KEY, GAME_CONFIG_PROFILE_OVERLAY_KEY, &profileOverlay)) {
+            prof_set_overlay(profileOverlay != 0);
+        }
+    }
+
+    game_init_step("diagnostics_init");
+
     skill_init();
     stat_init();
     perk_init();
@@ -206,16 +394,21 @@ int game_init(const char* windowTitle, bool isMapper, int font, int flags, int a
     item_init();
     queue_init();
     critter_init();
+    game_init_step("rules_init");
+
     combat_ai_init();
     inven_reset_dude();
+    game_init_step("combat_ai_init");
 
     if (gsound_init() != 0) {
         debug_printf("Sound initialization failed.\n");
     }
 
+    game_init_step("gsound_init");
     debug_printf(">gsound_init\t");
 
     initMovie();
+    game_init_step("initMovie");
     debug_printf(">initMovie\t\t");
 
     if (gmovie_init() != 0) {
@@ -223,6 +416,7 @@ int game_init(const char* windowTitle, bool isMapper, int font, int flags, int a
         return -1;
     }
 
+    game_init_step("gmovie_init");
     debug_printf(">gmovie_init\t");
 
     if (moviefx_init() != 0) {
@@ -230,6 +424,7 @@ int game_init(const char* windowTitle, bool isMapper, int font, int flags, int a
         return -1;
     }
 
+    game_init_step("moviefx_init");
     debug_printf(">moviefx_init\t");
 
     if (iso_init() != 0) {
@@ -237,6 +432,7 @@ int game_init(const char* windowTitle, bool isMapper, int font, int flags, int a
         return -1;
     }
 
+    game_init_step("iso_init");
     debug_printf(">iso_init\t");
 
     if (gmouse_init() != 0) {
@@ -244,6 +440,7 @@ int game_init(const char* windowTitle, bool isMapper, int font, int flags, int a
         return -1;
     }
 
+    game_init_step("gmouse_init");
     debug_printf(">gmouse_init\t");
 
     if (proto_init() != 0) {
@@ -251,16 +448,25 @@ int game_init(const char* windowTitle, bool isMapper, int font, int flags, int a
         return -1;
     }
 
+    game_init_step("proto_init");
     debug_printf(">proto_init\t");
 
     anim_init();
+    game_init_step("anim_init");
     debug_printf(">anim_init\t");
 
+    // CE: Optionally sleep while screen is static.
+    int idleWait;
+    if (config_get_value(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_IDLE_WAIT_KEY, &idleWait) && idleWait != 0) {
+        set_idle_wait_func(game_idle_wait);
+    }
+
     if (scr_init() != 0) {
         debug_printf("Failed on scr_init\n");
         return -1;
     }
 
+    game_init_step("scr_init");
     debug_printf(">scr_init\t");
 
     if (game_load_info() != 0) {
@@ -268,6 +474,7 @@ int game_init(const char* windowTitle, bool isMapper, int font, int flags, int a
         return -1;
     }
 
+    game_init_step("game_load_info");
     debug_printf(">game_load_info\t");
 
     if (scr_game_init() != 0) {
@@ -275,6 +482,7 @@ int game_init(const char* windowTitle, bool isMapper, int font, int flags, int a
         return -1;
     }
 
+    game_init_step("scr_game_init");
     debug_printf(">scr_game_init\t");
 
     if (init_world_map() != 0) {
@@ -282,15 +490,19 @@ int game_init(const char* windowTitle, bool isMapper, int font, int flags, int a
         return -1;
     }
 
+    game_init_step("init_world_map");
     debug_printf(">init_world_map\t");
 
     CharEditInit();
+    game_init_step("CharEditInit");
     debug_printf(">CharEditInit\t");
 
     pip_init();
+    game_init_step("pip_init");
     debug_printf(">pip_init\t\t");
 
     InitLoadSave();
+    game_init_step("InitLoadSave");
     debug_printf(">InitLoadSave\t");
 
     if (gdialog_init() != 0) {
@@ -298,6 +510,7 @@ int game_init(const char* windowTitle, bool isMapper, int font, int flags, int a
         return -1;
     }
 
+    game_init_step("gdialog_init");
     debug_printf(">gdialog_init\t");
 
     if (combat_init() != 0) {
@@ -305,6 +518,7 @@ int game_init(const char* windowTitle, bool isMapper, int font, int flags, int a
         return -1;
     }
 
+    game_init_step("combat_init");
     debug_printf(">combat_init\t");
 
     if (automap_init() != 0) {
@@ -312,6 +526,7 @@ int game_init(const char* windowTitle, bool isMapper, int font, int flags, int a
         return -1;
     }
 
+    game_init_step("automap_init");
     debug_printf(">automap_init\t");
 
     if (!message_init(&misc_message_file)) {
@@ -319,6 +534,7 @@ int game_init(const char* windowTitle, bool isMapper, int font, int flags, int a
         return -1;
     }
 
+    game_init_step("message_init");
     debug_printf(">message_init\t");
 
     snprintf(path, sizeof(path), "%s%s", msg_path, "misc.msg");
@@ -328,6 +544,7 @@ int game_init(const char* windowTitle, bool isMapper, int font, int flags, int a
         return -1;
     }
 
+    game_init_step("message_load");
     debug_printf(">message_load\t");
 
     if (scr_disable() != 0) {
@@ -335,6 +552,7 @@ int game_init(const char* windowTitle, bool isMapper, int font, int flags, int a
         return -1;
     }
 
+    game_init_step("scr_disable");
     debug_printf(">scr_disable\t");
 
     if (init_options_menu() != 0) {
@@ -342,8 +560,31 @@ int game_init(const char* windowTitle, bool isMapper, int font, int flags, int a
         return -1;
     }
 
+    game_init_step("init_options_menu");
     debug_printf(">init_options_menu\n");
 
+    // CE: Headless sessions load rarely used resources on first use.
+    if (!svga_is_headless()) {
+        game_preload_ui();
+        game_init_step("game_preload_ui");
+    }
+
+    if (saveStartupImage) {
+        // NOTE: Config string may be reallocated by now.
+        if (config_get_string(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_STARTUP_IMAGE_KEY, &startupImage)) {
+            int entries = db_image_save(startupImage, game_build_id);
+            if (entries == -1) {
+                debug_printf("Failed on db_image_save\n");
+            } else {
+                debug_printf("Startup image saved: %d entries\n", entries);
+            }
+        }
+
+        game_init_step("db_image_save");
+    }
+
+    game_init_report();
+
     return 0;
 }
 
@@ -380,6 +621,7 @@ void game_reset()
     ResetLoadSave();
     gdialog_reset();
     combat_reset();
+    cmdbatch_reset();
     game_user_wants_to_quit = 0;
     automap_reset();
     init_options_menu();
@@ -388,7 +630,15 @@ void game_reset()
 // 0x43B654
 void game_exit()
 {
+    // CE: Let background save finish.
+    LoadSaveWaitAsync();
+
+    set_idle_wait_func(NULL);
     tile_disable_refresh();
+    cachestat_exit();
+    lockstep_exit();
+    framecap_stop();
+    mapstat_exit();
     message_exit(&misc_message_file);
     combat_exit();
     gdialog_exit();
@@ -406,6 +656,7 @@ void game_exit()
     gmovie_exit();
     movieClose();
     gsound_exit();
+    jobs_exit();
     combat_ai_exit();
     critter_exit();
     item_exit();
@@ -420,6 +671,8 @@ void game_exit()
     palette_exit();
     FMExit();
     windowClose();
+    gdebug_dump_db_trace();
+    gdebug_dump_profile();
     db_exit();
     gconfig_exit(true);
 }
@@ -535,6 +788,10 @@ int game_handle_input(int eventCode, bool isInCombatMode)
         gsound_play_sfx_file("ib1p1xx1");
         PauseWindow(false);
         break;
+    case KEY_CTRL_T:
+        // CE: Start/stop trace capture.
+        gdebug_toggle_trace_capture();
+        break;
     case KEY_UPPERCASE_A:
     case KEY_LOWERCASE_A:
         if (intface_is_enabled()) {
@@ -938,6 +1195,7 @@ int game_set_global_var(int var, int value)
     }
 
     game_global_vars[var] = value;
+    statever_bump(STATE_VERSION_GLOBALS);
 
     return 0;
 }
@@ -1052,6 +1310,13 @@ void game_state_update()
     game_state_cur = v0;
 }
 
+// CE: Makes next `game_init` run without display. Used by tools which drive
+// game subsystems directly.
+void game_force_headless(bool headless)
+{
+    game_headless_forced = headless;
+}
+
 // 0x43D0AC
 static int game_screendump(int width, int height, unsigned char* buffer, unsigned char* palette)
 {
@@ -1223,10 +1488,18 @@ int game_quit_with_confirm()
 static int game_init_databases()
 {
     int hashing;
+    int use_mmap;
+    int db_cache_size;
+    int dat_index;
+    int db_trace;
     char* main_file_name;
     char* patch_file_name;
 
     hashing = 0;
+    use_mmap = 0;
+    db_cache_size = 0;
+    dat_index = 0;
+    db_trace = 0;
     main_file_name = NULL;
     patch_file_name = NULL;
 
@@ -1234,6 +1507,24 @@ static int game_init_databases()
         db_enable_hash_table();
     }
 
+    if (config_get_value(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_MMAP_KEY, &use_mmap) && use_mmap != 0) {
+        db_enable_mmap();
+    }
+
+    // CE: Size of decompressed entries cache in megabytes.
+    if (config_get_value(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_DB_CACHE_SIZE_KEY, &db_cache_size) && db_cache_size > 0) {
+        db_cache_set_size((size_t)db_cache_size * 1024 * 1024);
+    }
+
+    if (config_get_value(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_DAT_INDEX_KEY, &dat_index) && dat_index != 0) {
+        db_enable_index();
+    }
+
+    // CE: Per-file I/O counters, dumped on exit.
+    if (config_get_value(&game_config, GAME_CONFIG_DEBUG_KEY, GAME_CONFIG_DB_TRACE_KEY, &db_trace) && db_trace != 0) {
+        db_trace_enable(true);
+    }
+
     config_get_string(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_MASTER_DAT_KEY, &main_file_name);
     if (*main_file_name == '\0') {
         main_file_name = NULL;
@@ -1328,4 +1619,146 @@ static void game_splash_screen()
     config_set_value(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_SPLASH_KEY, splash + 1);
 }
 
+// CE: Returns how long message processing can wait for input while screen
+// is static - until the earliest deadline of background processes: timed
+// events and game clock (only advancing on the map), object animations, color
+// cycling, floating text, fidgets, talking heads, cursor and sounds.
+static unsigned int game_idle_wait()
+{
+    unsigned int delay = GAME_IDLE_WAIT_MAX;
+    delay = std::min(delay, scr_next_delay());
+    delay = std::min(delay, anim_next_frame_delay());
+    delay = std::min(delay, cycle_next_delay());
+    delay = std::min(delay, text_object_next_delay());
+    delay = std::min(delay, gdialog_next_delay());
+    delay = std::min(delay, gmouse_next_delay());
+    delay = std::min(delay, gsound_next_delay());
+
+    if (map_bk_processes_enabled()) {
+        delay = std::min(delay, dude_fidget_next_delay());
+    }
+
+    return delay;
+}
+
+// CE: Loads resources which are otherwise loaded on first use, so that
+// interactive UI does not stall on them.
+void game_preload_ui()
+{
+    FMPreload();
+    message_filter_preload();
+}
+
+// CE: Starts job system with the number of threads from `job_threads`
+// (including main thread), 0 - one less worker than there are CPU cores.
+static void game_init_jobs()
+{
+    int threads;
+    if (!config_get_value(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_JOB_THREADS_KEY, &threads)) {
+        threads = 0;
+    }
+
+    int workers = threads > 0 ? threads - 1 : SDL_GetCPUCount() - 1;
+    if (!jobs_init(workers)) {
+        debug_printf("Job system: unable to start worker threads\n");
+    }
+}
+
+// CE: Schedules reads of list, message and data files parsed by `game_init`
+// steps on db prefetch thread, so that they are decompressed and cached by
+// the time the step opens them. Steps themselves stay on the main thread in
+// their original order (db, message lists and configs are not thread-safe).
+static void game_init_prefetch()
+{
+    char paths[64][COMPAT_MAX_PATH];
+    const char* pathPtrs[64];
+    int count = 0;
+
+    for (int font = 0; font < 16 && count < 64; font++) {
+        snprintf(paths[count++], COMPAT_MAX_PATH, "font%d.aaf", font);
+    }
+
+    for (int font = 0; font < 10 && count < 64; font++) {
+        snprintf(paths[count++], COMPAT_MAX_PATH, "font%d.fon", font);
+    }
+
+    char* language;
+    if (config_get_string(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_LANGUAGE_KEY, &language)) {
+        for (size_t index = 0; index < sizeof(game_init_message_files) / sizeof(game_init_message_files[0]) && count < 64; index++) {
+            snprintf(paths[count++], COMPAT_MAX_PATH, "text\\%s\\%s%s", language, msg_path, game_init_message_files[index]);
+        }
+    }
+
+    for (int objectType = 0; objectType < OBJ_TYPE_COUNT && count < 62; objectType++) {
+        if (objectType != OBJ_TYPE_CRITTER) {
+            snprintf(paths[count++], COMPAT_MAX_PATH, "%sart\\%s\\%s.lst", cd_path_base, art_dir(objectType), art_dir(objectType));
+        }
+
+        if (objectType <= OBJ_TYPE_MISC) {
+            proto_make_path(paths[count], objectType << 24);
+            snprintf(paths[count] + strlen(paths[count]), COMPAT_MAX_PATH - strlen(paths[count]), "\\%s.lst", art_dir(objectType));
+            count++;
+        }
+    }
+
+    if (count < 64) {
+        snprintf(paths[count++], COMPAT_MAX_PATH, "data\\ai.txt");
+    }
+
+    if (count < 64) {
+        snprintf(paths[count++], COMPAT_MAX_PATH, "data\\vault13.gam");
+    }
+
+    if (count < 64) {
+        script_make_path(paths[count]);
+        strcat(paths[count++], "scripts.lst");
+    }
+
+    for (int index = 0; index < count; index++) {
+        pathPtrs[index] = paths[index];
+    }
+
+    db_prefetch(pathPtrs, count);
+
+    // Critter art list lives in critter datafile.
+    snprintf(paths[0], COMPAT_MAX_PATH, "%sart\\%s\\%s.lst", cd_path_base, art_dir(OBJ_TYPE_CRITTER), art_dir(OBJ_TYPE_CRITTER));
+    db_select(critter_db_handle);
+    db_prefetch(pathPtrs, 1);
+    db_select(master_db_handle);
+}
+
+// CE: Records time since previous step (or start of `game_init`) as step
+// with given name.
+static void game_init_step(const char* name)
+{
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+    if (game_init_steps_length < GAME_INIT_MAX_STEPS) {
+        GameInitStep* step = &(game_init_steps[game_init_steps_length++]);
+        step->name = name;
+        step->time = std::chrono::duration<double, std::milli>(now - game_init_step_start).count();
+    }
+
+    game_init_step_start = now;
+}
+
+// CE: Prints step timings recorded during `game_init`.
+static void game_init_report()
+{
+    double total = 0.0;
+    for (int index = 0; index < game_init_steps_length; index++) {
+        total += game_init_steps[index].time;
+    }
+
+    debug_printf("game_init: %.2f ms\n", total);
+
+    for (int index = 0; index < game_init_steps_length; index++) {
+        GameInitStep* step = &(game_init_steps[index]);
+        debug_printf("game_init: %-20s %9.2f ms (%4.1f%%)\n",
+            step->name,
+            step->time,
+            total > 0.0 ? step->time * 100.0 / total : 0.0);
+    }
+}
+
 } // namespace fallout
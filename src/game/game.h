@@ -40,6 +40,8 @@ int game_state();
 int game_state_request(int a1);
 void game_state_update();
 int game_quit_with_confirm();
+void game_force_headless(bool headless);
+void game_preload_ui();
 
 } // namespace fallout
 
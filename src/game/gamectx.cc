@@ -0,0 +1,101 @@
+#include "game/gamectx.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+namespace fallout {
+
+typedef struct GameContextState {
+    void* data;
+    GameContextStateProc* exitProc;
+} GameContextState;
+
+typedef struct GameContext {
+    GameContextState states[GAME_CONTEXT_SLOT_COUNT];
+} GameContext;
+
+static GameContext game_context_default;
+
+static thread_local GameContext* game_context_current = &game_context_default;
+
+// NOTE: Contexts and their states are allocated with `malloc` rather than
+// `mem_malloc`, since contexts of different games are used from different
+// threads.
+GameContext* game_context_create()
+{
+    GameContext* context = (GameContext*)malloc(sizeof(*context));
+    if (context == NULL) {
+        return NULL;
+    }
+
+    memset(context, 0, sizeof(*context));
+
+    return context;
+}
+
+// Releases state of every subsystem. Context must not be current on any
+// thread.
+void game_context_destroy(GameContext* context)
+{
+    if (context == NULL || context == &game_context_default) {
+        return;
+    }
+
+    for (int slot = 0; slot < GAME_CONTEXT_SLOT_COUNT; slot++) {
+        GameContextState* state = &(context->states[slot]);
+        if (state->data != NULL) {
+            if (state->exitProc != NULL) {
+                state->exitProc(state->data);
+            }
+            free(state->data);
+        }
+    }
+
+    free(context);
+}
+
+GameContext* game_context_get_default()
+{
+    return &game_context_default;
+}
+
+GameContext* game_context_get_current()
+{
+    return game_context_current;
+}
+
+// Makes `context` current on calling thread (NULL selects the default one).
+// Returns previously current context.
+GameContext* game_context_set_current(GameContext* context)
+{
+    GameContext* prev = game_context_current;
+    game_context_current = context != NULL ? context : &game_context_default;
+    return prev;
+}
+
+// Returns state of subsystem in current context. State is allocated zeroed
+// and passed to `initProc` on first use, `exitProc` is called when context
+// is destroyed. Returns NULL if state cannot be allocated.
+void* game_context_state(int slot, size_t size, GameContextStateProc* initProc, GameContextStateProc* exitProc)
+{
+    GameContextState* state = &(game_context_current->states[slot]);
+    if (state->data == NULL) {
+        void* data = malloc(size);
+        if (data == NULL) {
+            return NULL;
+        }
+
+        memset(data, 0, size);
+
+        if (initProc != NULL) {
+            initProc(data);
+        }
+
+        state->data = data;
+        state->exitProc = exitProc;
+    }
+
+    return state->data;
+}
+
+} // namespace fallout
@@ -0,0 +1,42 @@
+#ifndef FALLOUT_GAME_GAMECTX_H_
+#define FALLOUT_GAME_GAMECTX_H_
+
+#include <stddef.h>
+
+namespace fallout {
+
+// Per-game mutable state.
+//
+// Subsystems moved to game contexts keep their state in a slot of current
+// context (see `game_context_state`) instead of file-static globals, so
+// several games can run in one process, each one on its own thread.
+// Immutable data shared by all games (database indices, decoded art, program
+// images) stays global.
+//
+// Every thread starts with the default context, so code that knows nothing
+// about contexts keeps working as before.
+//
+// NOTE: Only subsystems listed below are moved so far. Objects, scripts,
+// animations, combat, interpreter and the rest still use globals, so running
+// games concurrently is not possible yet.
+typedef enum GameContextSlot {
+    GAME_CONTEXT_SLOT_QUEUE,
+    GAME_CONTEXT_SLOT_STATEVER,
+    GAME_CONTEXT_SLOT_CMDBATCH,
+    GAME_CONTEXT_SLOT_COUNT,
+} GameContextSlot;
+
+typedef struct GameContext GameContext;
+
+typedef void GameContextStateProc(void* state);
+
+GameContext* game_context_create();
+void game_context_destroy(GameContext* context);
+GameContext* game_context_get_default();
+GameContext* game_context_get_current();
+GameContext* game_context_set_current(GameContext* context);
+void* game_context_state(int slot, size_t size, GameContextStateProc* initProc, GameContextStateProc* exitProc);
+
+} // namespace fallout
+
+#endif /* FALLOUT_GAME_GAMECTX_H_ */
@@ -23,6 +23,23 @@ Config game_config;
 // 0x58CC48
 static char gconfig_file_name[COMPAT_MAX_PATH];
 
+ConfigHandle game_config_violence_level = { GAME_CONFIG_PREFERENCES_KEY, GAME_CONFIG_VIOLENCE_LEVEL_KEY };
+ConfigHandle game_config_running = { GAME_CONFIG_PREFERENCES_KEY, GAME_CONFIG_RUNNING_KEY };
+ConfigHandle game_config_subtitles = { GAME_CONFIG_PREFERENCES_KEY, GAME_CONFIG_SUBTITLES_KEY };
+ConfigHandle game_config_combat_speed = { GAME_CONFIG_PREFERENCES_KEY, GAME_CONFIG_COMBAT_SPEED_KEY };
+ConfigHandle game_config_player_speedup = { GAME_CONFIG_PREFERENCES_KEY, GAME_CONFIG_PLAYER_SPEEDUP_KEY };
+ConfigHandle game_config_brightness = { GAME_CONFIG_PREFERENCES_KEY, GAME_CONFIG_BRIGHTNESS_KEY };
+
+// CE: Handles bound to `game_config` for its whole lifetime.
+static ConfigHandle* const gconfig_handles[] = {
+    &game_config_violence_level,
+    &game_config_running,
+    &game_config_subtitles,
+    &game_config_combat_speed,
+    &game_config_player_speedup,
+    &game_config_brightness,
+};
+
 // Inits main game config.
 //
 // `isMapper` is a flag indicating whether we're initing config for a main
@@ -53,6 +70,12 @@ bool gconfig_init(bool isMapper, int argc, char** argv)
         return false;
     }
 
+    // CE: Bind handles before anything is set, so that defaults, file and
+    // command line values all flow into them.
+    for (size_t index = 0; index < sizeof(gconfig_handles) / sizeof(gconfig_handles[0]); index++) {
+        config_handle_bind(gconfig_handles[index], &game_config);
+    }
+
     // Initialize defaults.
     config_set_string(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_EXECUTABLE_KEY, "game");
     config_set_string(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_MASTER_DAT_KEY, "master.dat");
@@ -63,8 +86,38 @@ bool gconfig_init(bool isMapper, int argc, char** argv)
     config_set_value(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_SCROLL_LOCK_KEY, 0);
     config_set_value(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_INTERRUPT_WALK_KEY, 1);
     config_set_value(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_ART_CACHE_SIZE_KEY, 8);
+    config_set_value(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_ART_CACHE_HEAP_KEY, 0);
+    config_set_value(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_ART_CACHE_COMPRESSED_SIZE_KEY, 0);
+    config_set_value(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_ART_CACHE_SHARED_KEY, 0);
+    config_set_value(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_ART_CACHE_SHARED_SIZE_KEY, 64);
+    config_set_value(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_ART_SPANS_KEY, 0);
+    config_set_value(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_ART_DEDUP_KEY, 0);
+    config_set_value(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_IDLE_WAIT_KEY, 0);
+    config_set_value(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_FLOOR_CACHE_KEY, 0);
+    config_set_value(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_ROOF_CACHE_KEY, 0);
+    config_set_value(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_RENDER_THREADS_KEY, 0);
+    config_set_value(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_MOVIE_THREADS_KEY, 0);
+    config_set_string(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_MOVIE_POLICY_KEY, "auto");
+    config_set_value(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_JOB_THREADS_KEY, 0);
+    config_set_value(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_PATH_CACHE_KEY, 0);
+    config_set_value(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_PATH_GRAPH_KEY, 0);
+    config_set_value(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_INSTANT_REST_KEY, 0);
+    config_set_value(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_FAST_COMBAT_KEY, 0);
+    config_set_value(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_SCRIPT_FAST_DISPATCH_KEY, 0);
+    config_set_value(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_CRITTER_SCRIPT_BUDGET_KEY, 0);
+    config_set_value(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_WORLDMAP_PRELOAD_SIZE_KEY, 0);
+    config_set_value(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_MAP_STORE_SIZE_KEY, 0);
+    config_set_value(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_ASYNC_SAVE_KEY, 0);
+    config_set_value(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_PRELOAD_PROTOS_KEY, 0);
+    config_set_value(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_SAVE_CONTAINER_KEY, 0);
     config_set_value(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_COLOR_CYCLING_KEY, 1);
+    config_set_string(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_RNG_KEY, "legacy");
+    config_set_value(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_RNG_SEED_KEY, 0);
     config_set_value(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_HASHING_KEY, 1);
+    config_set_value(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_MMAP_KEY, 1);
+    config_set_value(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_DB_CACHE_SIZE_KEY, 8);
+    config_set_value(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_DAT_INDEX_KEY, 0);
+    config_set_string(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_STARTUP_IMAGE_KEY, "");
     config_set_value(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_SPLASH_KEY, 0);
     config_set_value(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_FREE_SPACE_KEY, 20480);
     config_set_value(&game_config, GAME_CONFIG_PREFERENCES_KEY, GAME_CONFIG_GAME_DIFFICULTY_KEY, 1);
@@ -99,11 +152,25 @@ bool gconfig_init(bool isMapper, int argc, char** argv)
     config_set_value(&game_config, GAME_CONFIG_SOUND_KEY, GAME_CONFIG_CACHE_SIZE_KEY, 448);
     config_set_string(&game_config, GAME_CONFIG_SOUND_KEY, GAME_CONFIG_MUSIC_PATH1_KEY, "sound\\music\\");
     config_set_string(&game_config, GAME_CONFIG_SOUND_KEY, GAME_CONFIG_MUSIC_PATH2_KEY, "sound\\music\\");
+    config_set_value(&game_config, GAME_CONFIG_SOUND_KEY, GAME_CONFIG_DECODE_AHEAD_KEY, 0);
+    config_set_value(&game_config, GAME_CONFIG_SOUND_KEY, GAME_CONFIG_SFX_PCM_CACHE_SIZE_KEY, 0);
+    config_set_string(&game_config, GAME_CONFIG_SOUND_KEY, GAME_CONFIG_AUDIO_BACKEND_KEY, "auto");
+    config_set_string(&game_config, GAME_CONFIG_SOUND_KEY, GAME_CONFIG_AUDIO_CAPTURE_PATH_KEY, "audio.wav");
     config_set_string(&game_config, GAME_CONFIG_DEBUG_KEY, GAME_CONFIG_MODE_KEY, "environment");
     config_set_value(&game_config, GAME_CONFIG_DEBUG_KEY, GAME_CONFIG_SHOW_TILE_NUM_KEY, 0);
     config_set_value(&game_config, GAME_CONFIG_DEBUG_KEY, GAME_CONFIG_SHOW_SCRIPT_MESSAGES_KEY, 0);
     config_set_value(&game_config, GAME_CONFIG_DEBUG_KEY, GAME_CONFIG_SHOW_LOAD_INFO_KEY, 0);
     config_set_value(&game_config, GAME_CONFIG_DEBUG_KEY, GAME_CONFIG_OUTPUT_MAP_DATA_INFO_KEY, 0);
+    config_set_value(&game_config, GAME_CONFIG_DEBUG_KEY, GAME_CONFIG_DB_TRACE_KEY, 0);
+    config_set_value(&game_config, GAME_CONFIG_DEBUG_KEY, GAME_CONFIG_CACHE_STATS_INTERVAL_KEY, 0);
+    config_set_value(&game_config, GAME_CONFIG_DEBUG_KEY, GAME_CONFIG_CACHE_STATS_OVERLAY_KEY, 0);
+    config_set_value(&game_config, GAME_CONFIG_DEBUG_KEY, GAME_CONFIG_SCRIPT_PROFILE_KEY, 0);
+    config_set_value(&game_config, GAME_CONFIG_DEBUG_KEY, GAME_CONFIG_MAP_STATS_KEY, 0);
+    config_set_value(&game_config, GAME_CONFIG_DEBUG_KEY, GAME_CONFIG_PROFILE_KEY, 0);
+    config_set_value(&game_config, GAME_CONFIG_DEBUG_KEY, GAME_CONFIG_PROFILE_OVERLAY_KEY, 0);
+    config_set_value(&game_config, GAME_CONFIG_DEBUG_KEY, GAME_CONFIG_PROFILE_TRACE_EVENTS_KEY, 65536);
+    config_set_string(&game_config, GAME_CONFIG_DEBUG_KEY, GAME_CONFIG_SELFRUN_BENCH_KEY, "");
+    config_set_string(&game_config, GAME_CONFIG_DEBUG_KEY, GAME_CONFIG_MOVIE_BENCH_KEY, "");
 
     if (isMapper) {
         config_set_string(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_EXECUTABLE_KEY, "mapper");
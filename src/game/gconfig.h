@@ -24,9 +24,39 @@ namespace fallout {
 #define GAME_CONFIG_SCROLL_LOCK_KEY "scroll_lock"
 #define GAME_CONFIG_INTERRUPT_WALK_KEY "interrupt_walk"
 #define GAME_CONFIG_ART_CACHE_SIZE_KEY "art_cache_size"
+#define GAME_CONFIG_ART_CACHE_HEAP_KEY "art_cache_heap"
+#define GAME_CONFIG_ART_CACHE_COMPRESSED_SIZE_KEY "art_cache_compressed_size"
+#define GAME_CONFIG_ART_CACHE_SHARED_KEY "art_cache_shared"
+#define GAME_CONFIG_ART_CACHE_SHARED_SIZE_KEY "art_cache_shared_size"
+#define GAME_CONFIG_ART_SPANS_KEY "art_spans"
+#define GAME_CONFIG_ART_DEDUP_KEY "art_dedup"
+#define GAME_CONFIG_IDLE_WAIT_KEY "idle_wait"
+#define GAME_CONFIG_FLOOR_CACHE_KEY "floor_cache"
+#define GAME_CONFIG_ROOF_CACHE_KEY "roof_cache"
+#define GAME_CONFIG_RENDER_THREADS_KEY "render_threads"
+#define GAME_CONFIG_MOVIE_THREADS_KEY "movie_threads"
+#define GAME_CONFIG_MOVIE_POLICY_KEY "movie_policy"
+#define GAME_CONFIG_JOB_THREADS_KEY "job_threads"
+#define GAME_CONFIG_PATH_CACHE_KEY "path_cache"
+#define GAME_CONFIG_PATH_GRAPH_KEY "path_graph"
+#define GAME_CONFIG_INSTANT_REST_KEY "instant_rest"
+#define GAME_CONFIG_FAST_COMBAT_KEY "fast_combat"
+#define GAME_CONFIG_SCRIPT_FAST_DISPATCH_KEY "script_fast_dispatch"
+#define GAME_CONFIG_CRITTER_SCRIPT_BUDGET_KEY "critter_script_budget"
+#define GAME_CONFIG_WORLDMAP_PRELOAD_SIZE_KEY "worldmap_preload_size"
+#define GAME_CONFIG_MAP_STORE_SIZE_KEY "map_store_size"
+#define GAME_CONFIG_ASYNC_SAVE_KEY "async_save"
+#define GAME_CONFIG_PRELOAD_PROTOS_KEY "preload_protos"
+#define GAME_CONFIG_SAVE_CONTAINER_KEY "save_container"
 #define GAME_CONFIG_COLOR_CYCLING_KEY "color_cycling"
+#define GAME_CONFIG_RNG_KEY "rng"
+#define GAME_CONFIG_RNG_SEED_KEY "rng_seed"
 #define GAME_CONFIG_CYCLE_SPEED_FACTOR_KEY "cycle_speed_factor"
 #define GAME_CONFIG_HASHING_KEY "hashing"
+#define GAME_CONFIG_MMAP_KEY "mmap"
+#define GAME_CONFIG_DB_CACHE_SIZE_KEY "db_cache_size"
+#define GAME_CONFIG_DAT_INDEX_KEY "dat_index"
+#define GAME_CONFIG_STARTUP_IMAGE_KEY "startup_image"
 #define GAME_CONFIG_SPLASH_KEY "splash"
 #define GAME_CONFIG_FREE_SPACE_KEY "free_space"
 #define GAME_CONFIG_TIMES_RUN_KEY "times_run"
@@ -63,12 +93,26 @@ namespace fallout {
 #define GAME_CONFIG_CACHE_SIZE_KEY "cache_size"
 #define GAME_CONFIG_MUSIC_PATH1_KEY "music_path1"
 #define GAME_CONFIG_MUSIC_PATH2_KEY "music_path2"
+#define GAME_CONFIG_DECODE_AHEAD_KEY "decode_ahead"
+#define GAME_CONFIG_SFX_PCM_CACHE_SIZE_KEY "sfx_pcm_cache_size"
+#define GAME_CONFIG_AUDIO_BACKEND_KEY "audio_backend"
+#define GAME_CONFIG_AUDIO_CAPTURE_PATH_KEY "audio_capture_path"
 #define GAME_CONFIG_DEBUG_SFXC_KEY "debug_sfxc"
 #define GAME_CONFIG_MODE_KEY "mode"
 #define GAME_CONFIG_SHOW_TILE_NUM_KEY "show_tile_num"
 #define GAME_CONFIG_SHOW_SCRIPT_MESSAGES_KEY "show_script_messages"
 #define GAME_CONFIG_SHOW_LOAD_INFO_KEY "show_load_info"
 #define GAME_CONFIG_OUTPUT_MAP_DATA_INFO_KEY "output_map_data_info"
+#define GAME_CONFIG_DB_TRACE_KEY "db_trace"
+#define GAME_CONFIG_CACHE_STATS_INTERVAL_KEY "cache_stats_interval"
+#define GAME_CONFIG_CACHE_STATS_OVERLAY_KEY "cache_stats_overlay"
+#define GAME_CONFIG_SCRIPT_PROFILE_KEY "script_profile"
+#define GAME_CONFIG_MAP_STATS_KEY "map_stats"
+#define GAME_CONFIG_PROFILE_KEY "profile"
+#define GAME_CONFIG_PROFILE_OVERLAY_KEY "profile_overlay"
+#define GAME_CONFIG_PROFILE_TRACE_EVENTS_KEY "profile_trace_events"
+#define GAME_CONFIG_SELFRUN_BENCH_KEY "selfrun_bench"
+#define GAME_CONFIG_MOVIE_BENCH_KEY "movie_bench"
 #define GAME_CONFIG_EXECUTABLE_KEY "executable"
 #define GAME_CONFIG_OVERRIDE_LIBRARIAN_KEY "override_librarian"
 #define GAME_CONFIG_USE_ART_NOT_PROTOS_KEY "use_art_not_protos"
@@ -115,6 +159,14 @@ typedef enum TargetHighlight {
 
 extern Config game_config;
 
+// CE: Pre-resolved handles for settings read on hot paths.
+extern ConfigHandle game_config_violence_level;
+extern ConfigHandle game_config_running;
+extern ConfigHandle game_config_subtitles;
+extern ConfigHandle game_config_combat_speed;
+extern ConfigHandle game_config_player_speedup;
+extern ConfigHandle game_config_brightness;
+
 bool gconfig_init(bool isMapper, int argc, char** argv);
 bool gconfig_save();
 bool gconfig_exit(bool shouldSave);
@@ -4,8 +4,10 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "plib/db/db.h"
 #include "plib/gnw/debug.h"
 #include "plib/gnw/gnw.h"
+#include "plib/gnw/prof.h"
 
 namespace fallout {
 
@@ -29,4 +31,80 @@ void fatal_error(const char* format, const char* message, const char* file, int
     exit(1);
 }
 
+// CE: Writes db I/O trace (see `db_trace_enable`) next to the executable.
+void gdebug_dump_db_trace()
+{
+    db_trace_file_stats totals;
+
+    if (db_trace_get_file_count() == 0) {
+        return;
+    }
+
+    db_trace_get_totals(&totals);
+    debug_printf("\ndb trace: %d files, %u opens, %u seeks, %llu bytes read, %llu bytes decompressed, %.1f ms decoding\n",
+        db_trace_get_file_count(),
+        totals.opens,
+        totals.seeks,
+        (unsigned long long)totals.bytes_read,
+        (unsigned long long)totals.bytes_decompressed,
+        totals.decode_time);
+
+    if (db_trace_dump_csv("db_trace.csv") != 0) {
+        debug_printf("Unable to write db_trace.csv\n");
+    }
+
+    if (db_trace_dump_chrome("db_trace.json") != 0) {
+        debug_printf("Unable to write db_trace.json\n");
+    }
+}
+
+// CE: Writes frame-time profile (see `prof_set_enabled`) next to the
+// executable.
+void gdebug_dump_profile()
+{
+    if (prof_is_capturing()) {
+        gdebug_toggle_trace_capture();
+    }
+
+    if (!prof_enabled) {
+        return;
+    }
+
+    debug_printf("\nprofile: %u frames\n", prof_get_frame_count());
+
+    if (prof_dump_table("prof.txt") != 0) {
+        debug_printf("Unable to write prof.txt\n");
+    }
+
+    if (prof_dump_chrome("prof_trace.json") != 0) {
+        debug_printf("Unable to write prof_trace.json\n");
+    }
+
+    prof_set_enabled(false);
+}
+
+// CE: Starts trace capture, or ends one in progress writing it to
+// `prof_capture_NNN.json` next to the executable (see `prof_dump_chrome`).
+void gdebug_toggle_trace_capture()
+{
+    static int captureIndex = 0;
+
+    if (!prof_is_capturing()) {
+        if (prof_capture_start()) {
+            debug_printf("profile: trace capture started\n");
+        }
+        return;
+    }
+
+    char path[32];
+    snprintf(path, sizeof(path), "prof_capture_%03d.json", captureIndex++);
+
+    if (prof_capture_stop(path) != 0) {
+        debug_printf("Unable to write %s\n", path);
+        return;
+    }
+
+    debug_printf("profile: trace capture written to %s\n", path);
+}
+
 } // namespace fallout
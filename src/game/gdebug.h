@@ -4,6 +4,9 @@
 namespace fallout {
 
 void fatal_error(const char* format, const char* message, const char* file, int line);
+void gdebug_dump_db_trace();
+void gdebug_dump_profile();
+void gdebug_toggle_trace_capture();
 
 } // namespace fallout
 
@@ -1,6 +1,7 @@
 #include "game/gdialog.h"
 
 #include <assert.h>
+#include <limits.h>
 #include <stdio.h>
 #include <string.h>
 
@@ -127,6 +128,22 @@ typedef struct GameDialogBlock {
     GameDialogOptionEntry options[DIALOG_OPTION_ENTRIES_CAPACITY];
 } GameDialogBlock;
 
+// CE: Number of slots in `gdialog_prefetch_memo` (power of 2).
+#define GDIALOG_PREFETCH_MEMO_SIZE 64
+
+// CE: What last dialogue with critters of given proto needed, used to
+// prefetch assets of the next one, see `gdialog_prefetch`.
+typedef struct GameDialogPrefetchMemo {
+    int pid;
+    int headFrmId;
+    int reaction;
+    int backgroundIndex;
+
+    // Base name of the first speech (without extension), empty if dialogue
+    // did not have one.
+    char speech[16];
+} GameDialogPrefetchMemo;
+
 static int gdialog_hide();
 static int gdialog_unhide();
 static int gdialog_unhide_reply();
@@ -191,6 +208,7 @@ static int about_lookup_word(const char* search);
 static int about_lookup_name(const char* search);
 static void gdialog_refresh_agent_snapshot();
 static void gdialog_clear_agent_snapshot();
+static GameDialogPrefetchMemo* gdialog_prefetch_memo_find(int pid, bool create);
 
 // 0x504FDC
 static int fidgetFID = 0;
@@ -522,10 +540,26 @@ static int talkOldFont;
 static GameDialogBlock dialogBlock;
 
 // Agent bridge dialogue snapshot (read-only for per-tick serialization).
-static char gdialogAgentReplyText[900];
-static char gdialogAgentOptionText[DIALOG_OPTION_ENTRIES_CAPACITY][900];
+//
+// Texts are not copied, snapshot points into `dialogBlock` (which lives for
+// the whole session and is where dialogue texts are assembled). Version
+// changes only when texts or their number actually change, this is checked
+// with a hash of the texts whenever version is queried.
+static const char* gdialogAgentReplyText = "";
+static int gdialogAgentReplyLength = 0;
+static const char* gdialogAgentOptionText[DIALOG_OPTION_ENTRIES_CAPACITY];
+static int gdialogAgentOptionLength[DIALOG_OPTION_ENTRIES_CAPACITY];
 static int gdialogAgentOptionCount = 0;
 static unsigned int gdialogAgentStateVersion = 0;
+static unsigned long long gdialogAgentHash = 0;
+static bool gdialogAgentLive = false;
+
+// CE: See `gdialog_prefetch`.
+static GameDialogPrefetchMemo gdialog_prefetch_memo[GDIALOG_PREFETCH_MEMO_SIZE];
+
+// CE: Memo of current dialogue target, `NULL` once its first speech is
+// recorded.
+static GameDialogPrefetchMemo* gdialog_prefetch_current = NULL;
 
 // 0x5951AC
 static CacheEntry* upper_hi_key;
@@ -573,10 +607,16 @@ static unsigned int fidgetLastTime;
 // 0x5951DC
 static int fidgetFrameCounter;
 
+// 0x5051B0
+static unsigned int head_bk_tocks_waiting = 10000;
+
 // 0x43DE08
 int gdialog_init()
 {
     gdialog_clear_agent_snapshot();
+
+    // CE: Memo is keyed by pid which is never -1.
+    memset(gdialog_prefetch_memo, 0xFF, sizeof(gdialog_prefetch_memo));
     return 0;
 }
 
@@ -771,6 +811,22 @@ void gdialog_setup_speech(const char* audioFileName)
         return;
     }
 
+    // CE: Remember first speech of dialogue for `gdialog_prefetch`.
+    if (gdialog_prefetch_current != NULL) {
+        strncpy(gdialog_prefetch_current->speech, audioFileName, sizeof(gdialog_prefetch_current->speech) - 1);
+        gdialog_prefetch_current->speech[sizeof(gdialog_prefetch_current->speech) - 1] = '\0';
+
+        char* sep = strchr(gdialog_prefetch_current->speech, '.');
+        if (sep != NULL) {
+            *sep = '\0';
+        }
+
+        // Same as `lips_load_file`.
+        gdialog_prefetch_current->speech[8] = '\0';
+
+        gdialog_prefetch_current = NULL;
+    }
+
     if (lips_load_file(audioFileName, name) == -1) {
         return;
     }
@@ -782,6 +838,96 @@ void gdialog_setup_speech(const char* audioFileName)
     debug_printf("Starting lipsynch speech");
 }
 
+// CE: Returns memo slot of critters with `pid`, when `create` is set slot is
+// taken over if it holds another pid.
+static GameDialogPrefetchMemo* gdialog_prefetch_memo_find(int pid, bool create)
+{
+    GameDialogPrefetchMemo* memo = &(gdialog_prefetch_memo[((unsigned int)pid * 2654435761u) >> 26]);
+    if (memo->pid == pid) {
+        return memo;
+    }
+
+    if (!create) {
+        return NULL;
+    }
+
+    memo->pid = pid;
+    memo->headFrmId = -1;
+    memo->reaction = FIDGET_NEUTRAL;
+    memo->backgroundIndex = -1;
+    memo->speech[0] = '\0';
+    return memo;
+}
+
+// CE: Starts loading assets dialogue with `target` is likely to need in
+// background: dialogue interface art, and (if there was a dialogue with
+// critter of the same proto before) its talking head, background and the
+// speech it started with. Called as soon as dialogue becomes likely (the dude
+// heads to talk to critter) so the assets are ready when `gdialog_enter`
+// needs them.
+void gdialog_prefetch(Object* target)
+{
+    if (target == NULL || target->sid == -1) {
+        return;
+    }
+
+    static const int interfaceFrmIds[] = { 99, 95, 96, 97, 98, 103 };
+
+    int fids[16];
+    int count = 0;
+    for (int index = 0; index < (int)(sizeof(interfaceFrmIds) / sizeof(interfaceFrmIds[0])); index++) {
+        fids[count++] = art_id(OBJ_TYPE_INTERFACE, interfaceFrmIds[index], 0, 0, 0);
+    }
+
+    GameDialogPrefetchMemo* memo = gdialog_prefetch_memo_find(target->pid, false);
+    if (memo != NULL) {
+        if (memo->backgroundIndex != -1) {
+            fids[count++] = art_id(OBJ_TYPE_BACKGROUND, memo->backgroundIndex, 0, 0, 0);
+        }
+
+        if (memo->headFrmId != -1) {
+            // See `talk_to_set_up_fidget`.
+            int anim = HEAD_ANIMATION_NEUTRAL_PHONEMES;
+            switch (memo->reaction) {
+            case FIDGET_GOOD:
+                anim = HEAD_ANIMATION_GOOD_PHONEMES;
+                break;
+            case FIDGET_BAD:
+                anim = HEAD_ANIMATION_BAD_PHONEMES;
+                break;
+            }
+
+            fids[count++] = art_id(OBJ_TYPE_HEAD, memo->headFrmId, anim, 0, 0);
+            fids[count++] = art_id(OBJ_TYPE_HEAD, memo->headFrmId, memo->reaction, 1, 0);
+        }
+    }
+
+    art_preload(fids, count);
+
+    if (memo == NULL || memo->headFrmId == -1 || memo->speech[0] == '\0') {
+        return;
+    }
+
+    char headName[16];
+    if (art_get_base_name(OBJ_TYPE_HEAD, memo->headFrmId, headName) == -1) {
+        return;
+    }
+
+    char* sep = strchr(headName, '.');
+    if (sep != NULL) {
+        *sep = '\0';
+    }
+
+    // See `lips_load_file` and `lips_make_speech`.
+    char lipsPath[COMPAT_MAX_PATH];
+    char speechPath[COMPAT_MAX_PATH];
+    snprintf(lipsPath, sizeof(lipsPath), "SOUND\\SPEECH\\%s\\%s.LIP", headName, memo->speech);
+    snprintf(speechPath, sizeof(speechPath), "SOUND\\SPEECH\\%s\\%s.ACM", headName, memo->speech);
+
+    const char* paths[2] = { lipsPath, speechPath };
+    db_prefetch(paths, 2);
+}
+
 // 0x43E164
 void gdialog_free_speech()
 {
@@ -847,6 +993,13 @@ int scr_dialogue_init(int headFid, int reaction)
     talk_to_create_head_window();
     add_bk_process(head_bk);
     talk_to_set_up_fidget(headFid, reaction);
+
+    // CE: Remember what this dialogue uses, see `gdialog_prefetch`.
+    gdialog_prefetch_current = gdialog_prefetch_memo_find(dialog_target->pid, true);
+    gdialog_prefetch_current->headFrmId = headFid != -1 ? (headFid & 0xFFF) : -1;
+    gdialog_prefetch_current->reaction = reaction;
+    gdialog_prefetch_current->backgroundIndex = backgroundIndex;
+    gdialog_prefetch_current->speech[0] = '\0';
     gdialog_state = 1;
     gmouse_disable_scrolling();
 
@@ -877,6 +1030,8 @@ int scr_dialogue_exit()
     gdReviewFree();
     remove_bk_process(head_bk);
 
+    gdialog_prefetch_current = NULL;
+
     if (PID_TYPE(dialog_target->pid) != OBJ_TYPE_ITEM) {
         if (gdPlayerTile != obj_dude->tile) {
             gdCenterTile = obj_dude->tile;
@@ -1024,6 +1179,11 @@ const char* gdialog_get_reply_text()
     return gdialogAgentReplyText;
 }
 
+int gdialog_get_reply_text_length()
+{
+    return gdialogAgentReplyLength;
+}
+
 int gdialog_get_option_count()
 {
     return gdialogAgentOptionCount;
@@ -1038,8 +1198,23 @@ const char* gdialog_get_option_text(int index)
     return gdialogAgentOptionText[index];
 }
 
+int gdialog_get_option_text_length(int index)
+{
+    if (index < 0 || index >= gdialogAgentOptionCount) {
+        return 0;
+    }
+
+    return gdialogAgentOptionLength[index];
+}
+
 unsigned int gdialog_get_state_version()
 {
+    // Texts can be edited in place between refreshes (e.g. "Tell me about"
+    // mode), make sure version covers them.
+    if (gdialogAgentLive) {
+        gdialog_refresh_agent_snapshot();
+    }
+
     return gdialogAgentStateVersion;
 }
 
@@ -1949,39 +2124,56 @@ static void gdialog_bump_agent_state_version()
 
 static void gdialog_clear_agent_snapshot()
 {
-    gdialogAgentReplyText[0] = '\0';
+    gdialogAgentReplyText = "";
+    gdialogAgentReplyLength = 0;
     gdialogAgentOptionCount = 0;
-
-    for (int index = 0; index < DIALOG_OPTION_ENTRIES_CAPACITY; index++) {
-        gdialogAgentOptionText[index][0] = '\0';
-    }
+    gdialogAgentHash = 0;
+    gdialogAgentLive = false;
 
     gdialog_bump_agent_state_version();
 }
 
 static void gdialog_refresh_agent_snapshot()
 {
-    strncpy(gdialogAgentReplyText, dialogBlock.replyText, sizeof(gdialogAgentReplyText) - 1);
-    gdialogAgentReplyText[sizeof(gdialogAgentReplyText) - 1] = '\0';
-
     int optionCount = gdNumOptions;
     if (optionCount < 0) {
         optionCount = 0;
     } else if (optionCount > DIALOG_OPTION_ENTRIES_CAPACITY) {
         optionCount = DIALOG_OPTION_ENTRIES_CAPACITY;
     }
-    gdialogAgentOptionCount = optionCount;
 
-    for (int index = 0; index < gdialogAgentOptionCount; index++) {
-        strncpy(gdialogAgentOptionText[index], dialogBlock.options[index].text, sizeof(gdialogAgentOptionText[index]) - 1);
-        gdialogAgentOptionText[index][sizeof(gdialogAgentOptionText[index]) - 1] = '\0';
+    // FNV-1a over texts including their terminators, so moving text between
+    // entries changes hash too.
+    unsigned long long hash = 14695981039346656037ULL;
+
+    gdialogAgentReplyText = dialogBlock.replyText;
+    gdialogAgentReplyLength = (int)strnlen(dialogBlock.replyText, sizeof(dialogBlock.replyText) - 1);
+    for (int index = 0; index <= gdialogAgentReplyLength; index++) {
+        hash = (hash ^ (unsigned char)dialogBlock.replyText[index]) * 1099511628211ULL;
     }
 
-    for (int index = gdialogAgentOptionCount; index < DIALOG_OPTION_ENTRIES_CAPACITY; index++) {
-        gdialogAgentOptionText[index][0] = '\0';
+    for (int index = 0; index < optionCount; index++) {
+        const char* text = dialogBlock.options[index].text;
+        int length = (int)strnlen(text, sizeof(dialogBlock.options[index].text) - 1);
+        gdialogAgentOptionText[index] = text;
+        gdialogAgentOptionLength[index] = length;
+
+        for (int pos = 0; pos <= length; pos++) {
+            hash = (hash ^ (unsigned char)text[pos]) * 1099511628211ULL;
+        }
     }
 
-    gdialog_bump_agent_state_version();
+    bool changed = !gdialogAgentLive
+        || optionCount != gdialogAgentOptionCount
+        || hash != gdialogAgentHash;
+
+    gdialogAgentOptionCount = optionCount;
+    gdialogAgentHash = hash;
+    gdialogAgentLive = true;
+
+    if (changed) {
+        gdialog_bump_agent_state_version();
+    }
 }
 
 // 0x43F8D4
@@ -2137,9 +2329,6 @@ static void head_bk()
     // 0x5051AC
     static int loop_cnt = -1;
 
-    // 0x5051B0
-    static unsigned int tocksWaiting = 10000;
-
     switch (dialogue_switch_mode) {
     case 2:
         loop_cnt = -1;
@@ -2186,10 +2375,10 @@ static void head_bk()
     }
 
     if (can_start_new_fidget) {
-        if (elapsed_time(fidgetLastTime) >= tocksWaiting) {
+        if (elapsed_time(fidgetLastTime) >= head_bk_tocks_waiting) {
             can_start_new_fidget = false;
-            dialogue_seconds_since_last_input += tocksWaiting / 1000;
-            tocksWaiting = 1000 * (roll_random(0, 3) + 4);
+            dialogue_seconds_since_last_input += head_bk_tocks_waiting / 1000;
+            head_bk_tocks_waiting = 1000 * (roll_random_stream(ROLL_STREAM_COSMETIC, 0, 3) + 4);
             talk_to_set_up_fidget(fidgetFID & 0xFFF, (fidgetFID & 0xFF0000) >> 16);
         }
         return;
@@ -2207,6 +2396,35 @@ static void head_bk()
     }
 }
 
+// CE: Returns number of milliseconds until talking head needs `head_bk`
+// (UINT_MAX if there is no talking head).
+unsigned int gdialog_next_delay()
+{
+    if (!dialog_active()) {
+        return UINT_MAX;
+    }
+
+    // Pending window switch.
+    if (dialogue_switch_mode == 1 || dialogue_switch_mode == 2 || dialogue_switch_mode == 5) {
+        return 0;
+    }
+
+    if (fidgetFp == NULL) {
+        return UINT_MAX;
+    }
+
+    // Lips follow speech phonemes.
+    if (gdialog_speech_playing) {
+        return 0;
+    }
+
+    if (can_start_new_fidget) {
+        return remaining_tocks(get_time(), fidgetLastTime, head_bk_tocks_waiting);
+    }
+
+    return remaining_tocks(get_time(), fidgetLastTime, fidgetTocksPerFrame);
+}
+
 // FIXME: Due to the bug in `gDialogProcessChoice` this function can receive invalid
 // reaction value (50 instead of expected -1, 0, 1). It's handled gracefully by
 // the game.
@@ -3424,7 +3642,7 @@ static void talk_to_set_up_fidget(int headFrmId, int reaction)
         return;
     }
 
-    int chance = roll_random(1, 100) + dialogue_seconds_since_last_input / 2;
+    int chance = roll_random_stream(ROLL_STREAM_COSMETIC, 1, 100) + dialogue_seconds_since_last_input / 2;
 
     int fidget = fidgetCount;
     switch (fidgetCount) {
@@ -21,7 +21,9 @@ int gdialog_init();
 int gdialog_reset();
 int gdialog_exit();
 bool dialog_active();
+unsigned int gdialog_next_delay();
 void gdialog_enter(Object* target, int a2);
+void gdialog_prefetch(Object* target);
 void dialogue_system_enter();
 void gdialog_setup_speech(const char* audioFileName);
 void gdialog_free_speech();
@@ -33,8 +35,10 @@ void gdialog_set_background(int a1);
 void gdialog_display_msg(char* msg);
 void gdialog_refresh_world();
 const char* gdialog_get_reply_text();
+int gdialog_get_reply_text_length();
 int gdialog_get_option_count();
 const char* gdialog_get_option_text(int index);
+int gdialog_get_option_text_length(int index);
 unsigned int gdialog_get_state_version();
 void gdialog_highlight_option(int index);
 int gDialogStart();
@@ -1,6 +1,7 @@
 #include "game/gmouse.h"
 
 #include <assert.h>
+#include <limits.h>
 #include <stdio.h>
 #include <string.h>
 
@@ -46,6 +47,8 @@ static int gmouse_3d_set_flat_fid(int fid, Rect* rect);
 static int gmouse_3d_reset_flat_fid(Rect* rect);
 static int gmouse_3d_move_to(int x, int y, int elevation, Rect* a4);
 static int gmouse_check_scrolling(int x, int y, int cursor);
+static bool gmouse_3d_hex_changed(int x, int y);
+static void gmouse_3d_path_cost(char* string, size_t size, int* colorPtr);
 
 // 0x505258
 static bool gmouse_initialized = false;
@@ -275,6 +278,9 @@ static int gmouse_wait_cursor_frame = 0;
 // 0x5053E4
 static unsigned int gmouse_wait_cursor_time = 0;
 
+// CE: Frame duration of current animated cursor.
+static unsigned int gmouse_wait_cursor_delay = 0;
+
 // 0x5053E8
 static int gmouse_bk_last_cursor = -1;
 
@@ -296,6 +302,19 @@ static int gmouse_3d_last_mouse_x;
 // 0x595208
 static int gmouse_3d_last_mouse_y;
 
+// CE: Last action points preview in move mode, valid while its inputs stay
+// the same (see `gmouse_3d_path_cost`).
+static bool gmouse_3d_path_cost_valid = false;
+static int gmouse_3d_path_cost_from;
+static int gmouse_3d_path_cost_to;
+static int gmouse_3d_path_cost_elevation;
+static unsigned int gmouse_3d_path_cost_epoch;
+static bool gmouse_3d_path_cost_in_combat;
+static int gmouse_3d_path_cost_ap;
+static int gmouse_3d_path_cost_free_move;
+static char gmouse_3d_path_cost_string[8];
+static int gmouse_3d_path_cost_color;
+
 // 0x59520C
 Object* obj_mouse;
 
@@ -420,6 +439,30 @@ int gmouse_scrolling_is_enabled()
     return gmouse_scrolling_enabled;
 }
 
+// CE: Returns number of milliseconds until `gmouse_bk_process` has something
+// to do - next frame of animated cursor, next scroll step, or hover test of
+// stationary 3d cursor (UINT_MAX if there is nothing scheduled).
+unsigned int gmouse_next_delay()
+{
+    if (!gmouse_initialized) {
+        return UINT_MAX;
+    }
+
+    if (gmouse_current_cursor >= FIRST_GAME_MOUSE_ANIMATED_CURSOR) {
+        return remaining_tocks(get_time(), gmouse_wait_cursor_time, gmouse_wait_cursor_delay);
+    }
+
+    if (gmouse_current_cursor >= MOUSE_CURSOR_SCROLL_NW && gmouse_current_cursor <= MOUSE_CURSOR_SCROLL_W) {
+        return 0;
+    }
+
+    if (gmouse_enabled && gmouse_mapper_mode == 0 && !gmouse_3d_hover_test && gmouse_3d_is_on()) {
+        return remaining_tocks(get_time(), gmouse_3d_last_move_time, 250);
+    }
+
+    return UINT_MAX;
+}
+
 // 0x4430DC
 void gmouse_set_click_to_scroll(int a1)
 {
@@ -639,8 +682,12 @@ void gmouse_bk_process()
         break;
     }
 
+    // CE: Hex cursor snaps to hexes in move mode, moving within hex changes
+    // nothing (and keeps action points preview).
+    bool hexChanged = gmouse_3d_hex_changed(mouseX, mouseY);
+
     Rect r1;
-    if (gmouse_3d_move_to(mouseX, mouseY, map_elevation, &r1) == 0) {
+    if (hexChanged && gmouse_3d_move_to(mouseX, mouseY, map_elevation, &r1) == 0) {
         tile_refresh_rect(&r1, map_elevation);
     }
 
@@ -649,7 +696,7 @@ void gmouse_bk_process()
     }
 
     unsigned int v3 = get_bk_time();
-    if (mouseX == gmouse_3d_last_mouse_x && mouseY == gmouse_3d_last_mouse_y) {
+    if ((mouseX == gmouse_3d_last_mouse_x && mouseY == gmouse_3d_last_mouse_y) || !hexChanged) {
         if (gmouse_3d_hover_test || elapsed_tocks(v3, gmouse_3d_last_move_time) < 250) {
             return;
         }
@@ -758,32 +805,7 @@ void gmouse_bk_process()
 
         char formattedActionPoints[8];
         int color;
-        int v6 = make_path(obj_dude, obj_dude->tile, obj_mouse_flat->tile, NULL, 1);
-        if (v6) {
-            if (!isInCombat()) {
-                formattedActionPoints[0] = '\0';
-                color = colorTable[31744];
-            } else {
-                int v7 = critter_compute_ap_from_distance(obj_dude, v6);
-                int v8;
-                if (v7 - combat_free_move >= 0) {
-                    v8 = v7 - combat_free_move;
-                } else {
-                    v8 = 0;
-                }
-
-                if (v8 <= obj_dude->data.critter.combat.ap) {
-                    snprintf(formattedActionPoints, sizeof(formattedActionPoints), "%d", v8);
-                    color = colorTable[32767];
-                } else {
-                    snprintf(formattedActionPoints, sizeof(formattedActionPoints), "%c", 'X');
-                    color = colorTable[31744];
-                }
-            }
-        } else {
-            snprintf(formattedActionPoints, sizeof(formattedActionPoints), "%c", 'X');
-            color = colorTable[31744];
-        }
+        gmouse_3d_path_cost(formattedActionPoints, sizeof(formattedActionPoints), &color);
 
         if (gmouse_3d_build_hex_frame(formattedActionPoints, color) == 0) {
             Rect tmp;
@@ -834,6 +856,87 @@ void gmouse_bk_process()
     }
 }
 
+// CE: Returns `true` if cursor at given position needs hex cursor to be moved.
+// Always `true` outside of move mode, where hex cursor follows mouse
+// pixel by pixel.
+static bool gmouse_3d_hex_changed(int x, int y)
+{
+    if (gmouse_mapper_mode != 0 || gmouse_3d_current_mode != GAME_MOUSE_MODE_MOVE) {
+        return true;
+    }
+
+    // Same hex lookup as `gmouse_3d_move_to`.
+    int tile = tile_num(x, y, 0);
+    return tile == -1
+        || tile != obj_mouse_flat->tile
+        || map_elevation != obj_mouse_flat->elevation;
+}
+
+// CE: Formats action points needed to walk to hex under cursor. Path is only
+// built when dude, target hex, blockers or combat state changed since last
+// preview (and goes through path cache of `make_path`).
+static void gmouse_3d_path_cost(char* string, size_t size, int* colorPtr)
+{
+    int from = obj_dude->tile;
+    int to = obj_mouse_flat->tile;
+    unsigned int epoch = obj_blocking_epoch();
+    bool inCombat = isInCombat();
+    int ap = obj_dude->data.critter.combat.ap;
+
+    if (!gmouse_3d_path_cost_valid
+        || gmouse_3d_path_cost_from != from
+        || gmouse_3d_path_cost_to != to
+        || gmouse_3d_path_cost_elevation != map_elevation
+        || gmouse_3d_path_cost_epoch != epoch
+        || gmouse_3d_path_cost_in_combat != inCombat
+        || gmouse_3d_path_cost_ap != ap
+        || gmouse_3d_path_cost_free_move != combat_free_move) {
+        char* formattedActionPoints = gmouse_3d_path_cost_string;
+        int color;
+
+        int v6 = make_path(obj_dude, from, to, NULL, 1);
+        if (v6) {
+            if (!inCombat) {
+                formattedActionPoints[0] = '\0';
+                color = colorTable[31744];
+            } else {
+                int v7 = critter_compute_ap_from_distance(obj_dude, v6);
+                int v8;
+                if (v7 - combat_free_move >= 0) {
+                    v8 = v7 - combat_free_move;
+                } else {
+                    v8 = 0;
+                }
+
+                if (v8 <= ap) {
+                    snprintf(formattedActionPoints, sizeof(gmouse_3d_path_cost_string), "%d", v8);
+                    color = colorTable[32767];
+                } else {
+                    snprintf(formattedActionPoints, sizeof(gmouse_3d_path_cost_string), "%c", 'X');
+                    color = colorTable[31744];
+                }
+            }
+        } else {
+            snprintf(formattedActionPoints, sizeof(gmouse_3d_path_cost_string), "%c", 'X');
+            color = colorTable[31744];
+        }
+
+        gmouse_3d_path_cost_valid = true;
+        gmouse_3d_path_cost_from = from;
+        gmouse_3d_path_cost_to = to;
+        gmouse_3d_path_cost_elevation = map_elevation;
+        gmouse_3d_path_cost_epoch = epoch;
+        gmouse_3d_path_cost_in_combat = inCombat;
+        gmouse_3d_path_cost_ap = ap;
+        gmouse_3d_path_cost_free_move = combat_free_move;
+        gmouse_3d_path_cost_color = color;
+    }
+
+    strncpy(string, gmouse_3d_path_cost_string, size - 1);
+    string[size - 1] = '\0';
+    *colorPtr = gmouse_3d_path_cost_color;
+}
+
 // 0x443AA0
 void gmouse_handle_event(int mouseX, int mouseY, int mouseState)
 {
@@ -883,7 +986,7 @@ void gmouse_handle_event(int mouseX, int mouseY, int mouseState)
             }
 
             bool running;
-            configGetBool(&game_config, GAME_CONFIG_PREFERENCES_KEY, GAME_CONFIG_RUNNING_KEY, &running);
+            config_handle_get_bool(&game_config_running, &running);
 
             if (keys[SDL_SCANCODE_LSHIFT] || keys[SDL_SCANCODE_RSHIFT]) {
                 if (running) {
@@ -1216,6 +1319,7 @@ int gmouse_set_cursor(int cursor)
         }
 
         unsigned int delay = 1000 / art_frame_fps(mouseCursorFrm);
+        gmouse_wait_cursor_delay = delay;
         if (elapsed_tocks(tick, gmouse_wait_cursor_time) < delay) {
             shouldUpdate = false;
         } else {
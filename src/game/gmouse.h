@@ -85,6 +85,7 @@ void gmouse_set_click_to_scroll(int a1);
 int gmouse_get_click_to_scroll();
 int gmouse_is_scrolling();
 void gmouse_bk_process();
+unsigned int gmouse_next_delay();
 void gmouse_handle_event(int mouseX, int mouseY, int mouseState);
 int gmouse_set_cursor(int cursor);
 int gmouse_get_cursor();
@@ -31,6 +31,8 @@ namespace fallout {
 #define GAME_MOVIE_WINDOW_HEIGHT 480
 
 static char* gmovie_subtitle_func(char* movieFilePath);
+static int gmovie_resolve_policy();
+static void gmovie_skip(int game_movie, int game_movie_flags);
 
 // 0x5053FC
 static const char* movie_list[MOVIE_COUNT] = {
@@ -53,6 +55,9 @@ static const char* movie_list[MOVIE_COUNT] = {
 // 0x596C78
 static unsigned char gmovie_played_list[MOVIE_COUNT];
 
+// CE: See `GameMoviePolicy`.
+static int gmovie_policy = GAME_MOVIE_POLICY_AUTO;
+
 // gmovie_init
 // 0x44E5C0
 int gmovie_init()
@@ -66,6 +71,29 @@ int gmovie_init()
 
     movieSetSubtitleFunc(gmovie_subtitle_func);
 
+    // CE: Video of every frame can be decoded by several threads.
+    int threads;
+    if (config_get_value(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_MOVIE_THREADS_KEY, &threads)) {
+        movieSetDecodeThreads(threads);
+    }
+
+    // CE: Movies can be skipped or reduced to sound.
+    char* policyName;
+    if (config_get_string(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_MOVIE_POLICY_KEY, &policyName)) {
+        if (compat_stricmp(policyName, "play") == 0) {
+            gmovie_policy = GAME_MOVIE_POLICY_PLAY;
+        } else if (compat_stricmp(policyName, "skip") == 0) {
+            gmovie_policy = GAME_MOVIE_POLICY_SKIP;
+        } else if (compat_stricmp(policyName, "audio") == 0) {
+            gmovie_policy = GAME_MOVIE_POLICY_AUDIO_ONLY;
+        } else {
+            if (compat_stricmp(policyName, "auto") != 0) {
+                debug_printf("Unknown movie policy \"%s\", using auto.\n", policyName);
+            }
+            gmovie_policy = GAME_MOVIE_POLICY_AUTO;
+        }
+    }
+
     memset(gmovie_played_list, 0, sizeof(gmovie_played_list));
 
     return 0;
@@ -80,6 +108,80 @@ void gmovie_reset()
 // 0x446064
 void gmovie_exit()
 {
+    // CE: Stop decoder threads.
+    movieSetDecodeThreads(0);
+}
+
+// CE: Decodes movie `name` (or every movie when `name` is "all") without
+// showing it and reports decoding speed to `movie_bench.txt` (next to the
+// executable). Every movie is decoded again with reference block decoders
+// and checksums of frames are compared. Returns non-zero if any movie could
+// not be decoded or checksums do not match.
+int gmovie_benchmark(const char* name)
+{
+    FILE* stream = compat_fopen("movie_bench.txt", "wt");
+    if (stream == NULL) {
+        return 1;
+    }
+
+    int threads = 0;
+    config_get_value(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_MOVIE_THREADS_KEY, &threads);
+
+    int played = 0;
+    int failed = 0;
+
+    for (int index = 0; index < MOVIE_COUNT; index++) {
+        if (compat_stricmp(name, "all") != 0 && compat_stricmp(name, movie_list[index]) != 0) {
+            continue;
+        }
+
+        played++;
+
+        char movieFilePath[COMPAT_MAX_PATH];
+        snprintf(movieFilePath, sizeof(movieFilePath), "art\\cuts\\%s", movie_list[index]);
+
+        double ms;
+        unsigned long long checksum;
+        int frames = movieBenchmark(movieFilePath, false, &ms, &checksum);
+
+        double referenceMs;
+        unsigned long long referenceChecksum;
+        int referenceFrames = movieBenchmark(movieFilePath, true, &referenceMs, &referenceChecksum);
+
+        if (frames == -1 || referenceFrames == -1) {
+            fprintf(stream, "%s: unable to decode\n", movie_list[index]);
+            failed++;
+            continue;
+        }
+
+        const char* verdict;
+        if (frames == referenceFrames && checksum == referenceChecksum) {
+            verdict = "ok";
+        } else {
+            verdict = "MISMATCH";
+            failed++;
+        }
+
+        fprintf(stream, "%s: %d frames, %.1f ms, %.1f fps (%d threads), reference %.1f ms, checksum %016llx (%s)\n",
+            movie_list[index],
+            frames,
+            ms,
+            ms > 0.0 ? frames * 1000.0 / ms : 0.0,
+            threads > 1 ? threads : 1,
+            referenceMs,
+            checksum,
+            verdict);
+        debug_printf("movie benchmark %s: %d frames, %.1f ms, %s\n", movie_list[index], frames, ms, verdict);
+    }
+
+    if (played == 0) {
+        fprintf(stream, "%s: no such movie\n", name);
+        failed++;
+    }
+
+    fclose(stream);
+
+    return failed != 0 ? 1 : 0;
 }
 
 // 0x44E638
@@ -117,15 +219,21 @@ int gmovie_play(int game_movie, int game_movie_flags)
         return -1;
     }
 
+    // CE: Skipped movies are not opened at all.
+    int policy = gmovie_resolve_policy();
+    if (policy == GAME_MOVIE_POLICY_SKIP) {
+        gmovie_skip(game_movie, game_movie_flags);
+
 #ifdef AGENT_BRIDGE
-    // Agent bridge runs headless. Mark the movie as played and skip playback.
-    // Emit one forced movie-context bridge tick so external agents can observe
-    // that a movie was triggered before context returns to normal flow.
-    gmovie_played_list[game_movie] = 1;
-    agentBridgePulseMovieContext();
-    return 0;
+        // Emit one forced movie-context bridge tick so external agents can
+        // observe that a movie was triggered before context returns to
+        // normal flow.
+        agentBridgePulseMovieContext();
 #endif
 
+        return 0;
+    }
+
     if ((game_movie_flags & GAME_MOVIE_FADE_IN) != 0) {
         palette_fade_to(black_palette);
     }
@@ -154,7 +262,7 @@ int gmovie_play(int game_movie, int game_movie_flags)
     if (game_movie == MOVIE_BOIL3 || game_movie == MOVIE_BOIL1 || game_movie == MOVIE_BOIL2) {
         subtitlesEnabled = true;
     } else {
-        configGetBool(&game_config, GAME_CONFIG_PREFERENCES_KEY, GAME_CONFIG_SUBTITLES_KEY, &subtitlesEnabled);
+        config_handle_get_bool(&game_config_subtitles, &subtitlesEnabled);
     }
 
     int movie_flags = 4;
@@ -198,6 +306,7 @@ int gmovie_play(int game_movie, int game_movie_flags)
 
     moviefx_start(movieFilePath);
 
+    movieSetAudioOnly(policy == GAME_MOVIE_POLICY_AUDIO_ONLY);
     movieRun(win, movieFilePath);
 
     int v11 = 0;
@@ -228,6 +337,7 @@ int gmovie_play(int game_movie, int game_movie_flags)
     movieStop();
     moviefx_stop();
     movieUpdate();
+    movieSetAudioOnly(false);
     palette_set_to(black_palette);
 
     gmovie_played_list[game_movie] = 1;
@@ -278,6 +388,69 @@ bool gmovie_has_been_played(int movie)
     return gmovie_played_list[movie] == 1;
 }
 
+// CE: Changes movie policy at runtime (see `GameMoviePolicy`), used by
+// controllers which do not want to wait for movies.
+void gmovie_set_policy(int policy)
+{
+    if (policy < GAME_MOVIE_POLICY_AUTO || policy > GAME_MOVIE_POLICY_AUDIO_ONLY) {
+        return;
+    }
+
+    gmovie_policy = policy;
+}
+
+int gmovie_get_policy()
+{
+    return gmovie_policy;
+}
+
+// CE: Movies have no effect on game state besides being marked as played, so
+// there is nothing to show in headless runs. Turbo runs always skip playback
+// since movies are paced by real time sound.
+static int gmovie_resolve_policy()
+{
+    if (is_turbo_mode()) {
+        return GAME_MOVIE_POLICY_SKIP;
+    }
+
+    if (gmovie_policy != GAME_MOVIE_POLICY_AUTO) {
+        return gmovie_policy;
+    }
+
+#ifdef AGENT_BRIDGE
+    // Agent bridge runs headless.
+    return GAME_MOVIE_POLICY_SKIP;
+#else
+    if (svga_is_headless()) {
+        return GAME_MOVIE_POLICY_SKIP;
+    }
+
+    return GAME_MOVIE_POLICY_PLAY;
+#endif
+}
+
+// CE: Leaves game in the same state as `gmovie_play` would after movie ends:
+// music stopped (paused music is resumed right after playback, so it is left
+// alone), movie marked as played and screen palette black or faded back to
+// game colors.
+static void gmovie_skip(int game_movie, int game_movie_flags)
+{
+    if ((game_movie_flags & GAME_MOVIE_STOP_MUSIC) != 0) {
+        gsound_background_stop();
+    }
+
+    moviefx_stop();
+
+    gmovie_played_list[game_movie] = 1;
+
+    if ((game_movie_flags & GAME_MOVIE_FADE_OUT) != 0) {
+        loadColorTable("color.pal");
+        palette_set_to(cmap);
+    } else {
+        palette_set_to(black_palette);
+    }
+}
+
 // 0x44EB1C
 static char* gmovie_subtitle_func(char* movie_file_path)
 {
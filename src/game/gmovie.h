@@ -12,6 +12,17 @@ typedef enum GameMovieFlags {
     GAME_MOVIE_PAUSE_MUSIC = 0x08,
 } GameMovieFlags;
 
+// CE: What `gmovie_play` does with movies.
+typedef enum GameMoviePolicy {
+    // Play movies in full (or skip them in headless and turbo runs).
+    GAME_MOVIE_POLICY_AUTO,
+    GAME_MOVIE_POLICY_PLAY,
+    // Apply side effects of playback without opening movies.
+    GAME_MOVIE_POLICY_SKIP,
+    // Play sound (and subtitles) only, video is not decoded.
+    GAME_MOVIE_POLICY_AUDIO_ONLY,
+} GameMoviePolicy;
+
 typedef enum GameMovie {
     MOVIE_IPLOGO,
     MOVIE_MPLOGO,
@@ -37,6 +48,9 @@ int gmovie_load(DB_FILE* stream);
 int gmovie_save(DB_FILE* stream);
 int gmovie_play(int game_movie, int game_movie_flags);
 bool gmovie_has_been_played(int game_movie);
+void gmovie_set_policy(int policy);
+int gmovie_get_policy();
+int gmovie_benchmark(const char* name);
 
 } // namespace fallout
 
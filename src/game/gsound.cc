@@ -1,8 +1,10 @@
 #include "game/gsound.h"
 
+#include <limits.h>
 #include <stdio.h>
 #include <string.h>
 
+#include "audio_engine.h"
 #include "game/anim.h"
 #include "game/combat.h"
 #include "game/gconfig.h"
@@ -13,6 +15,7 @@
 #include "game/queue.h"
 #include "game/roll.h"
 #include "game/sfxcache.h"
+#include "game/sfxlist.h"
 #include "game/stat.h"
 #include "game/worldmap.h"
 #include "int/audio.h"
@@ -24,6 +27,7 @@
 #include "plib/gnw/gnw.h"
 #include "plib/gnw/input.h"
 #include "plib/gnw/memory.h"
+#include "plib/gnw/svga.h"
 #include "pointer_registry.h"
 
 namespace fallout {
@@ -54,6 +58,41 @@ static Sound* gsound_get_sound_ready_for_effect();
 static bool gsound_file_exists_f(const char* fname);
 static int gsound_file_exists_db(const char* path);
 static int gsound_setup_paths();
+static void gsound_setup_backend();
+static unsigned int gsound_sfx_memo_hash(const int* key, int count);
+static char* gsound_sfx_name_memo_get(int kind, int a, int b, int c, int d);
+static char* gsound_sfx_name_memo_put(int kind, int a, int b, int c, int d, char* name);
+static bool gsound_sfx_resolve(const char* name, Object* object, char* path, size_t size);
+static bool gsound_sfx_exists(char* path);
+static void gsound_sfx_memo_clear();
+
+// CE: Capacity of resolved sound effect memos (power of two).
+#define GSOUND_SFX_MEMO_CAPACITY 256
+
+typedef enum SoundEffectNameKind {
+    SOUND_EFFECT_NAME_CHARACTER = 1,
+    SOUND_EFFECT_NAME_WEAPON,
+    SOUND_EFFECT_NAME_OPEN,
+} SoundEffectNameKind;
+
+// CE: Sound effect name built from given inputs (empty when builder failed).
+typedef struct SoundEffectNameMemoEntry {
+    int kind;
+    int key[4];
+    char name[13];
+} SoundEffectNameMemoEntry;
+
+// CE: File resolved for sound effect name, taking critter and location
+// aliases into account (empty when there is no such file).
+typedef struct SoundEffectResolveMemoEntry {
+    bool used;
+    char name[13];
+
+    // Critter alias variant (see `gsound_sfx_resolve`), 0 if not applicable.
+    char variant;
+
+    char resolved[13];
+} SoundEffectResolveMemoEntry;
 
 // TODO: Remove.
 // 0x4F2C54
@@ -165,9 +204,16 @@ static char sfx_file_name[13];
 // 0x595562
 static char background_fname_requested[COMPAT_MAX_PATH];
 
+// CE: Direct mapped memos, colliding entries replace each other. Cleared
+// together with sound effects cache.
+static SoundEffectNameMemoEntry gsound_sfx_name_memo[GSOUND_SFX_MEMO_CAPACITY];
+static SoundEffectResolveMemoEntry gsound_sfx_resolve_memo[GSOUND_SFX_MEMO_CAPACITY];
+
 // 0x4475A0
 int gsound_init()
 {
+    MemTagScope memTagScope(MEM_TAG_SOUND);
+
     if (gsound_initialized) {
         if (gsound_debug) {
             debug_printf("Trying to initialize gsound twice.\n");
@@ -209,6 +255,10 @@ int gsound_init()
 
     soundRegisterAlloc(mem_malloc, mem_realloc, mem_free);
 
+    // CE: Headless and turbo runs can go without audio device. Null backend
+    // discards output, wav backend captures it to file.
+    gsound_setup_backend();
+
     // initialize direct sound
     if (soundInit(detectDevices, 24, 0x8000, 0x8000, 22050) != 0) {
         if (gsound_debug) {
@@ -225,6 +275,13 @@ int gsound_init()
     initAudiof(gsound_compressed_query);
     initAudio(gsound_compressed_query);
 
+    // CE: Music can be decoded on a worker thread. Speech and sound effects
+    // are read through the database, which is only used from main thread.
+    int decodeAhead;
+    if (config_get_value(&game_config, GAME_CONFIG_SOUND_KEY, GAME_CONFIG_DECODE_AHEAD_KEY, &decodeAhead)) {
+        soundSetDecodeAhead(decodeAhead);
+    }
+
     int cacheSize;
     config_get_value(&game_config, GAME_CONFIG_SOUND_KEY, GAME_CONFIG_CACHE_SIZE_KEY, &cacheSize);
     if (cacheSize >= 0x40000) {
@@ -359,6 +416,7 @@ void gsound_reset()
     soundFlushAllSounds();
 
     sfxc_flush();
+    gsound_sfx_memo_clear();
 
     gsound_active_effect_counter = 0;
 
@@ -385,6 +443,7 @@ int gsound_exit()
     gsound_background_remove_last_copy();
     soundClose();
     sfxc_exit();
+    gsound_sfx_memo_clear();
     audiofClose();
     audioClose();
 
@@ -631,6 +690,8 @@ int gsound_background_length_get()
 // 0x447FAC
 int gsound_background_play(const char* fileName, int a2, int a3, int a4)
 {
+    MemTagScope memTagScope(MEM_TAG_SOUND);
+
     int rc;
 
     background_storage_requested = a3;
@@ -686,6 +747,13 @@ int gsound_background_play(const char* fileName, int a2, int a3, int a4)
         return -1;
     }
 
+    // CE: Not fatal, music is decoded on main thread instead.
+    if (soundEnableDecodeAhead(gsound_background_tag) != SOUND_NO_ERROR) {
+        if (gsound_debug) {
+            debug_printf("decode ahead could not be enabled...");
+        }
+    }
+
     char path[COMPAT_MAX_PATH + 1];
     if (a3 == 13) {
         rc = gsound_background_find_dont_copy(path, fileName);
@@ -962,6 +1030,8 @@ int gsound_speech_length_get()
 // 0x4485D0
 int gsound_speech_play(const char* fname, int a2, int a3, int a4)
 {
+    MemTagScope memTagScope(MEM_TAG_SOUND);
+
     char path[COMPAT_MAX_PATH + 1];
 
     if (!gsound_initialized) {
@@ -1157,6 +1227,8 @@ int gsound_play_sfx_file_volume(const char* a1, int a2)
 // 0x448A0C
 Sound* gsound_load_sound(const char* name, Object* object)
 {
+    MemTagScope memTagScope(MEM_TAG_SOUND);
+
     if (!gsound_initialized) {
         return NULL;
     }
@@ -1177,6 +1249,23 @@ Sound* gsound_load_sound(const char* name, Object* object)
         return NULL;
     }
 
+    char path[COMPAT_MAX_PATH];
+
+    // CE: With sound effects cache the file (or its absence) is known from
+    // effects list, resolve name once and load right file afterwards.
+    bool resolved = false;
+    if (sfxc_is_initialized()) {
+        if (!gsound_sfx_resolve(name, object, path, sizeof(path))) {
+            if (gsound_debug) {
+                debug_printf("failed (not found).\n");
+            }
+
+            return NULL;
+        }
+
+        resolved = true;
+    }
+
     Sound* sound = gsound_get_sound_ready_for_effect();
     if (sound == NULL) {
         if (gsound_debug) {
@@ -1188,7 +1277,26 @@ Sound* gsound_load_sound(const char* name, Object* object)
 
     ++gsound_active_effect_counter;
 
-    char path[COMPAT_MAX_PATH];
+    if (resolved) {
+        if (soundLoad(sound, path) == 0) {
+            if (gsound_debug) {
+                debug_printf("succeeded (%s).\n", path + strlen(sound_sfx_path));
+            }
+
+            return sound;
+        }
+
+        --gsound_active_effect_counter;
+
+        soundDelete(sound);
+
+        if (gsound_debug) {
+            debug_printf("failed.\n");
+        }
+
+        return NULL;
+    }
+
     snprintf(path, sizeof(path), "%s%s%s", sound_sfx_path, name, ".ACM");
 
     if (soundLoad(sound, path) == 0) {
@@ -1403,16 +1511,25 @@ char* gsnd_build_character_sfx_name(Object* a1, int anim, int extra)
     char v8;
     char v9;
 
+    // CE: Name depends on art and animation only.
+    char* memoized = gsound_sfx_name_memo_get(SOUND_EFFECT_NAME_CHARACTER, a1->fid, anim, extra, 0);
+    if (memoized != NULL) {
+        return memoized[0] != '\0' ? memoized : NULL;
+    }
+
     if (art_get_base_name(FID_TYPE(a1->fid), a1->fid & 0xFFF, v7) == -1) {
+        gsound_sfx_name_memo_put(SOUND_EFFECT_NAME_CHARACTER, a1->fid, anim, extra, 0, NULL);
         return NULL;
     }
 
     if (anim == ANIM_TAKE_OUT) {
         if (art_get_code(anim, extra, &v8, &v9) == -1) {
+            gsound_sfx_name_memo_put(SOUND_EFFECT_NAME_CHARACTER, a1->fid, anim, extra, 0, NULL);
             return NULL;
         }
     } else {
         if (art_get_code(anim, (a1->fid & 0xF000) >> 12, &v8, &v9) == -1) {
+            gsound_sfx_name_memo_put(SOUND_EFFECT_NAME_CHARACTER, a1->fid, anim, extra, 0, NULL);
             return NULL;
         }
     }
@@ -1430,7 +1547,7 @@ char* gsnd_build_character_sfx_name(Object* a1, int anim, int extra)
 
     snprintf(sfx_file_name, sizeof(sfx_file_name), "%s%c%c", v7, v8, v9);
     compat_strupr(sfx_file_name);
-    return sfx_file_name;
+    return gsound_sfx_name_memo_put(SOUND_EFFECT_NAME_CHARACTER, a1->fid, anim, extra, 0, sfx_file_name);
 }
 
 // 0x449020
@@ -1459,6 +1576,15 @@ char* gsnd_build_weapon_sfx_name(int effectType, Object* weapon, int hitMode, Ob
     Proto* proto;
     int damage_type;
 
+    // CE: Name depends on protos of weapon and target only (material of
+    // critters is not used).
+    int weaponPid = weapon != NULL ? weapon->pid : -1;
+    int targetPid = target != NULL ? target->pid : -1;
+    char* memoized = gsound_sfx_name_memo_get(SOUND_EFFECT_NAME_WEAPON, effectType, weaponPid, hitMode, targetPid);
+    if (memoized != NULL) {
+        return memoized;
+    }
+
     weaponSoundCode = item_w_sound_id(weapon);
     effectTypeCode = snd_lookup_weapon_type[effectType];
 
@@ -1521,7 +1647,7 @@ char* gsnd_build_weapon_sfx_name(int effectType, Object* weapon, int hitMode, Ob
 
     snprintf(sfx_file_name, sizeof(sfx_file_name), "W%c%c%1d%cXX%1d", effectTypeCode, weaponSoundCode, v6, materialCode, 1);
     compat_strupr(sfx_file_name);
-    return sfx_file_name;
+    return gsound_sfx_name_memo_put(SOUND_EFFECT_NAME_WEAPON, effectType, weaponPid, hitMode, targetPid, sfx_file_name);
 }
 
 // 0x4491C4
@@ -1539,6 +1665,11 @@ char* gsnd_build_scenery_sfx_name(int actionType, int action, const char* name)
 // 0x449208
 char* gsnd_build_open_sfx_name(Object* object, int action)
 {
+    char* memoized = gsound_sfx_name_memo_get(SOUND_EFFECT_NAME_OPEN, object->fid, object->pid, action, 0);
+    if (memoized != NULL) {
+        return memoized;
+    }
+
     if (FID_TYPE(object->fid) == OBJ_TYPE_SCENERY) {
         char scenerySoundId;
         Proto* proto;
@@ -1554,7 +1685,7 @@ char* gsnd_build_open_sfx_name(Object* object, int action)
         snprintf(sfx_file_name, sizeof(sfx_file_name), "I%cCNTNR%c", snd_lookup_scenery_action[action], proto->item.field_80);
     }
     compat_strupr(sfx_file_name);
-    return sfx_file_name;
+    return gsound_sfx_name_memo_put(SOUND_EFFECT_NAME_OPEN, object->fid, object->pid, action, 0, sfx_file_name);
 }
 
 // 0x44929C
@@ -1632,6 +1763,17 @@ static void gsound_bkg_proc()
     soundUpdate();
 }
 
+// CE: Returns number of milliseconds until sounds need to be serviced by
+// `gsound_bkg_proc`.
+unsigned int gsound_next_delay()
+{
+    if (!gsound_initialized) {
+        return UINT_MAX;
+    }
+
+    return soundUpdateDelay();
+}
+
 // 0x449334
 static int gsound_open(const char* fname, int flags)
 {
@@ -1666,7 +1808,7 @@ static int gsound_close(int fileHandle)
         return -1;
     }
 
-    return db_fclose((DB_FILE*)intToPtr(fileHandle));
+    return db_fclose((DB_FILE*)intToPtr(fileHandle, true));
 }
 
 // 0x44935C
@@ -2157,6 +2299,140 @@ static int gsound_file_exists_db(const char* path)
     return db_dir_entry(path, &de) == 0;
 }
 
+// CE: FNV-1a over memo key.
+static unsigned int gsound_sfx_memo_hash(const int* key, int count)
+{
+    unsigned int hash = 2166136261U;
+    for (int index = 0; index < count; index++) {
+        hash ^= (unsigned int)key[index];
+        hash *= 16777619U;
+    }
+    return hash;
+}
+
+// CE: Returns memoized name built from given inputs (empty string if builder
+// failed for them), or `NULL` if not memoized. Returned name is copied to
+// `sfx_file_name` just like a freshly built one.
+static char* gsound_sfx_name_memo_get(int kind, int a, int b, int c, int d)
+{
+    int key[5] = { kind, a, b, c, d };
+    SoundEffectNameMemoEntry* entry = &(gsound_sfx_name_memo[gsound_sfx_memo_hash(key, 5) & (GSOUND_SFX_MEMO_CAPACITY - 1)]);
+    if (entry->kind != kind
+        || entry->key[0] != a
+        || entry->key[1] != b
+        || entry->key[2] != c
+        || entry->key[3] != d) {
+        return NULL;
+    }
+
+    strcpy(sfx_file_name, entry->name);
+    return sfx_file_name;
+}
+
+// CE: Memoizes name built from given inputs (`NULL` if builder failed), and
+// returns it.
+static char* gsound_sfx_name_memo_put(int kind, int a, int b, int c, int d, char* name)
+{
+    int key[5] = { kind, a, b, c, d };
+    SoundEffectNameMemoEntry* entry = &(gsound_sfx_name_memo[gsound_sfx_memo_hash(key, 5) & (GSOUND_SFX_MEMO_CAPACITY - 1)]);
+    entry->kind = kind;
+    entry->key[0] = a;
+    entry->key[1] = b;
+    entry->key[2] = c;
+    entry->key[3] = d;
+
+    if (name != NULL) {
+        strncpy(entry->name, name, sizeof(entry->name) - 1);
+        entry->name[sizeof(entry->name) - 1] = '\0';
+    } else {
+        entry->name[0] = '\0';
+    }
+
+    return name;
+}
+
+// CE: Finds file of sound effect `name` trying the same aliases as
+// `gsound_load_sound` does, and stores its path in `path`. Returns `false`
+// if there is no such file. Result (including absence) is memoized, so
+// repeated effects (burst fire, footsteps) do not touch effects list again.
+static bool gsound_sfx_resolve(const char* name, Object* object, char* path, size_t size)
+{
+    // Critters fall back to generic human sounds of the same gender.
+    char variant = '\0';
+    if (object != NULL && FID_TYPE(object->fid) == OBJ_TYPE_CRITTER && (name[0] == 'H' || name[0] == 'N')) {
+        variant = name[1];
+        if (variant == 'A') {
+            variant = stat_level(object, STAT_GENDER) ? 'F' : 'M';
+        }
+    }
+
+    int key[4] = { 0, 0, 0, variant };
+    strncpy((char*)key, name, 12);
+
+    SoundEffectResolveMemoEntry* entry = &(gsound_sfx_resolve_memo[gsound_sfx_memo_hash(key, 4) & (GSOUND_SFX_MEMO_CAPACITY - 1)]);
+    if (entry->used && entry->variant == variant && strncmp(entry->name, name, sizeof(entry->name) - 1) == 0) {
+        if (entry->resolved[0] == '\0') {
+            return false;
+        }
+
+        snprintf(path, size, "%s%s%s", sound_sfx_path, entry->resolved, ".ACM");
+        return true;
+    }
+
+    bool found = false;
+
+    snprintf(path, size, "%s%s%s", sound_sfx_path, name, ".ACM");
+    found = gsound_sfx_exists(path);
+
+    if (!found && variant != '\0') {
+        snprintf(path, size, "%sH%cXXXX%s%s", sound_sfx_path, variant, name + 6, ".ACM");
+        found = gsound_sfx_exists(path);
+
+        if (!found && variant == 'F') {
+            snprintf(path, size, "%sHMXXXX%s%s", sound_sfx_path, name + 6, ".ACM");
+            found = gsound_sfx_exists(path);
+        }
+    }
+
+    if (!found && (strncmp(name, "MALIEU", 6) == 0 || strncmp(name, "MAMTN2", 6) == 0)) {
+        snprintf(path, size, "%sMAMTNT%s%s", sound_sfx_path, name + 6, ".ACM");
+        found = gsound_sfx_exists(path);
+    }
+
+    entry->used = true;
+    entry->variant = variant;
+    strncpy(entry->name, name, sizeof(entry->name) - 1);
+    entry->name[sizeof(entry->name) - 1] = '\0';
+
+    if (found) {
+        // Keep file name only, without effects path and extension.
+        size_t pathLength = strlen(sound_sfx_path);
+        size_t nameLength = strlen(path) - pathLength - 4;
+        if (nameLength >= sizeof(entry->resolved)) {
+            nameLength = sizeof(entry->resolved) - 1;
+        }
+        memcpy(entry->resolved, path + pathLength, nameLength);
+        entry->resolved[nameLength] = '\0';
+    } else {
+        entry->resolved[0] = '\0';
+    }
+
+    return found;
+}
+
+// CE: Returns `true` if sound effects cache has file at `path`.
+static bool gsound_sfx_exists(char* path)
+{
+    int tag;
+    return sfxl_name_to_tag(path, &tag) == SFXL_OK;
+}
+
+static void gsound_sfx_memo_clear()
+{
+    memset(gsound_sfx_name_memo, 0, sizeof(gsound_sfx_name_memo));
+    memset(gsound_sfx_resolve_memo, 0, sizeof(gsound_sfx_resolve_memo));
+}
+
 // 0x449E40
 static int gsound_setup_paths()
 {
@@ -2165,4 +2441,34 @@ static int gsound_setup_paths()
     return 0;
 }
 
+// CE: Selects audio engine backend from [sound] audio_backend: `sdl`,
+// `null`, `wav` or `auto` (null when headless, sdl otherwise).
+static void gsound_setup_backend()
+{
+    char* backendName;
+    if (!config_get_string(&game_config, GAME_CONFIG_SOUND_KEY, GAME_CONFIG_AUDIO_BACKEND_KEY, &backendName)) {
+        backendName = NULL;
+    }
+
+    int backend = svga_is_headless() ? AUDIO_ENGINE_BACKEND_NULL : AUDIO_ENGINE_BACKEND_SDL;
+    if (backendName != NULL) {
+        if (compat_stricmp(backendName, "sdl") == 0) {
+            backend = AUDIO_ENGINE_BACKEND_SDL;
+        } else if (compat_stricmp(backendName, "null") == 0) {
+            backend = AUDIO_ENGINE_BACKEND_NULL;
+        } else if (compat_stricmp(backendName, "wav") == 0) {
+            backend = AUDIO_ENGINE_BACKEND_WAV;
+        } else if (compat_stricmp(backendName, "auto") != 0) {
+            debug_printf("Unknown audio backend \"%s\", using auto.\n", backendName);
+        }
+    }
+
+    char* capturePath;
+    if (!config_get_string(&game_config, GAME_CONFIG_SOUND_KEY, GAME_CONFIG_AUDIO_CAPTURE_PATH_KEY, &capturePath)) {
+        capturePath = NULL;
+    }
+
+    audioEngineSetBackend(backend, capturePath);
+}
+
 } // namespace fallout
@@ -42,6 +42,7 @@ typedef void(SoundEndCallback)();
 int gsound_init();
 void gsound_reset();
 int gsound_exit();
+unsigned int gsound_next_delay();
 void gsound_sfx_enable();
 void gsound_sfx_disable();
 int gsound_sfx_is_enabled();
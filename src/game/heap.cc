@@ -36,6 +36,16 @@ namespace fallout {
 
 #define HEAP_HANDLE_STATE_INVALID (-1)
 
+// CE: Size of slab heap page.
+#define HEAP_SLAB_PAGE_SIZE (4096)
+
+// CE: Number of slab heap size classes, see `heap_slab_class_sizes`.
+#define HEAP_SLAB_CLASS_COUNT (12)
+
+// CE: Slab heap page kinds (non-negative values are size class indexes).
+#define HEAP_SLAB_PAGE_FREE (-1)
+#define HEAP_SLAB_PAGE_LARGE (-2)
+
 // The only allowed combination is LOCKED | SYSTEM.
 typedef enum HeapBlockState {
     HEAP_BLOCK_STATE_FREE = 0x00,
@@ -55,6 +65,46 @@ typedef struct HeapBlockFooter {
     int guard;
 } HeapBlockFooter;
 
+// CE: Slab heap page map entry.
+//
+// Arena pages form runs: a single slab page, a multi-page large block, or a
+// range of free pages. The first and the last page of every run have `kind`
+// and `run` set to describe the whole run, pages in between are not
+// maintained.
+typedef struct HeapSlabPage {
+    // Size class index for slab pages, [HEAP_SLAB_PAGE_FREE] or
+    // [HEAP_SLAB_PAGE_LARGE].
+    int kind;
+
+    // Number of pages in the run.
+    int run;
+
+    // Slab pages only: number of used slots, the first free slot (-1 when
+    // the page is full), and links in the list of partially used pages of
+    // the same size class.
+    int used;
+    int freeSlot;
+    int prev;
+    int next;
+} HeapSlabPage;
+
+typedef struct HeapSlab {
+    HeapSlabPage* pages;
+    int pageCount;
+
+    // Heads of partially used page lists per size class.
+    int partial[HEAP_SLAB_CLASS_COUNT];
+
+    // Stack of unused handle indexes.
+    int* freeHandles;
+    int freeHandlesLength;
+
+    int freePages;
+    int freeRuns;
+    int slabPages;
+    int largePages;
+} HeapSlab;
+
 typedef struct HeapMoveableExtent {
     // Pointer to the first block in the extent.
     unsigned char* data;
@@ -88,6 +138,26 @@ static bool heap_build_subblock_list(int extentIndex);
 static bool heap_sort_subblock_list(size_t count);
 static int heap_qsort_compare_subblock(const void* a1, const void* a2);
 static bool heap_build_fake_move_list(size_t count);
+static bool heap_slab_init(Heap* heap, int size);
+static void heap_slab_exit(Heap* heap);
+static bool heap_slab_acquire_handle(Heap* heap, int* handleIndexPtr);
+static void heap_slab_release_handle(Heap* heap, int handleIndex);
+static int heap_slab_class(int size);
+static int heap_slab_alloc_run(HeapSlab* slab, int count, int kind);
+static void heap_slab_free_run(HeapSlab* slab, int page, int count);
+static void heap_slab_set_run(HeapSlab* slab, int page, int count, int kind);
+static void heap_slab_partial_push(HeapSlab* slab, int page);
+static void heap_slab_partial_remove(HeapSlab* slab, int page);
+static unsigned char* heap_slab_alloc_block(Heap* heap, int size, int* blockSizePtr);
+static void heap_slab_free_block(Heap* heap, unsigned char* block);
+static int heap_slab_block_size(Heap* heap, unsigned char* block);
+static bool heap_slab_allocate(Heap* heap, int* handleIndexPtr, int size, int a4);
+static bool heap_slab_deallocate(Heap* heap, int* handleIndexPtr);
+static bool heap_slab_lock(Heap* heap, int handleIndex, unsigned char** bufferPtr);
+static bool heap_slab_unlock(Heap* heap, int handleIndex);
+static bool heap_slab_stats(Heap* heap, char* dest, size_t size);
+static bool heap_slab_validate(Heap* heap);
+static bool heap_slab_get_fragmentation_stats(Heap* heap, HeapFragmentationStats* stats);
 
 // An array of pointers to free heap blocks.
 //
@@ -138,8 +208,31 @@ static size_t heap_fake_move_list_size = 0;
 // 0x5054BC
 static int heap_count = 0;
 
+// CE: Slab sizes per size class. Every class fits at least four slots into
+// a page, larger blocks are allocated as page runs.
+static const int heap_slab_class_sizes[HEAP_SLAB_CLASS_COUNT] = {
+    16,
+    32,
+    48,
+    64,
+    96,
+    128,
+    192,
+    256,
+    384,
+    512,
+    768,
+    1024,
+};
+
 // 0x449F54
 bool heap_init(Heap* heap, int a2)
+{
+    return heap_init_with_type(heap, a2, HEAP_TYPE_COMPACTING);
+}
+
+// CE: Initializes heap with given backend.
+bool heap_init_with_type(Heap* heap, int a2, int type)
 {
     if (heap == NULL) {
         return false;
@@ -153,6 +246,23 @@ bool heap_init(Heap* heap, int a2)
 
     memset(heap, 0, sizeof(*heap));
 
+    if (type == HEAP_TYPE_SLAB) {
+        if (heap_init_handles(heap)) {
+            if (heap_slab_init(heap, a2)) {
+                heap_count++;
+                return true;
+            }
+
+            heap_exit_handles(heap);
+        }
+
+        if (heap_count == 0) {
+            heap_destroy_lists();
+        }
+
+        return false;
+    }
+
     if (heap_init_handles(heap)) {
         int size = (a2 >> 10) + a2;
         heap->data = (unsigned char*)mem_malloc(size);
@@ -197,6 +307,10 @@ bool heap_exit(Heap* heap)
         }
     }
 
+    if (heap->type == HEAP_TYPE_SLAB) {
+        heap_slab_exit(heap);
+    }
+
     // NOTE: Uninline.
     heap_exit_handles(heap);
 
@@ -222,6 +336,12 @@ bool heap_allocate(Heap* heap, int* handleIndexPtr, int size, int a4)
     int blockSize;
     HeapHandle* handle;
 
+    if (heap != NULL && heap->type == HEAP_TYPE_SLAB) {
+        return heap_slab_allocate(heap, handleIndexPtr, size, a4);
+    }
+
+    int requestedSize = size;
+
     size += sizeof(int) - size % sizeof(int);
 
     if (heap == NULL || handleIndexPtr == NULL || size == 0) {
@@ -255,6 +375,7 @@ bool heap_allocate(Heap* heap, int* handleIndexPtr, int size, int a4)
         // Bind handle to block and mark it as system
         handle->state = HEAP_BLOCK_STATE_SYSTEM;
         handle->data = (unsigned char*)block;
+        handle->size = requestedSize;
 
         // Update heap stats
         heap->systemBlocks++;
@@ -303,6 +424,7 @@ bool heap_allocate(Heap* heap, int* handleIndexPtr, int size, int a4)
         // Bind handle to block and mark it as moveable
         handle->state = HEAP_BLOCK_STATE_MOVABLE;
         handle->data = (unsigned char*)block;
+        handle->size = requestedSize;
 
         // Update heap stats
         heap->freeBlocks--;
@@ -341,6 +463,10 @@ bool heap_deallocate(Heap* heap, int* handleIndexPtr)
         return false;
     }
 
+    if (heap->type == HEAP_TYPE_SLAB) {
+        return heap_slab_deallocate(heap, handleIndexPtr);
+    }
+
     int handleIndex = *handleIndexPtr;
 
     HeapHandle* handle = &(heap->handles[handleIndex]);
@@ -410,6 +536,10 @@ bool heap_lock(Heap* heap, int handleIndex, unsigned char** bufferPtr)
         return false;
     }
 
+    if (heap->type == HEAP_TYPE_SLAB) {
+        return heap_slab_lock(heap, handleIndex, bufferPtr);
+    }
+
     HeapHandle* handle = &(heap->handles[handleIndex]);
 
     HeapBlockHeader* blockHeader = (HeapBlockHeader*)handle->data;
@@ -471,6 +601,10 @@ bool heap_unlock(Heap* heap, int handleIndex)
         return false;
     }
 
+    if (heap->type == HEAP_TYPE_SLAB) {
+        return heap_slab_unlock(heap, handleIndex);
+    }
+
     HeapHandle* handle = &(heap->handles[handleIndex]);
 
     HeapBlockHeader* blockHeader = (HeapBlockHeader*)handle->data;
@@ -515,6 +649,10 @@ bool heap_unlock(Heap* heap, int handleIndex)
 // 0x44A5A4
 bool heap_validate(Heap* heap)
 {
+    if (heap->type == HEAP_TYPE_SLAB) {
+        return heap_slab_validate(heap);
+    }
+
     debug_printf("Validating heap...\n");
 
     int blocksCount = heap->freeBlocks + heap->moveableBlocks + heap->lockedBlocks;
@@ -635,6 +773,10 @@ bool heap_stats(Heap* heap, char* dest, size_t size)
         return false;
     }
 
+    if (heap->type == HEAP_TYPE_SLAB) {
+        return heap_slab_stats(heap, dest, size);
+    }
+
     const char* format = "[Heap]\n"
                          "Total free blocks: %d\n"
                          "Total free size: %d\n"
@@ -662,6 +804,54 @@ bool heap_stats(Heap* heap, char* dest, size_t size)
     return true;
 }
 
+// CE: Reports fragmentation and wasted space of heap arena.
+bool heap_get_fragmentation_stats(Heap* heap, HeapFragmentationStats* stats)
+{
+    if (heap == NULL || stats == NULL) {
+        return false;
+    }
+
+    if (heap->type == HEAP_TYPE_SLAB) {
+        return heap_slab_get_fragmentation_stats(heap, stats);
+    }
+
+    memset(stats, 0, sizeof(*stats));
+    stats->type = HEAP_TYPE_COMPACTING;
+    stats->capacity = heap->size;
+
+    for (int handleIndex = 0; handleIndex < heap->handlesLength; handleIndex++) {
+        HeapHandle* handle = &(heap->handles[handleIndex]);
+        if (handle->state == HEAP_HANDLE_STATE_INVALID || (handle->state & HEAP_BLOCK_STATE_SYSTEM) != 0) {
+            continue;
+        }
+
+        HeapBlockHeader* blockHeader = (HeapBlockHeader*)handle->data;
+        stats->blocks++;
+        stats->requestedSize += handle->size;
+        stats->allocatedSize += blockHeader->size + HEAP_BLOCK_OVERHEAD_SIZE;
+    }
+
+    int blocksCount = heap->freeBlocks + heap->moveableBlocks + heap->lockedBlocks;
+    unsigned char* ptr = heap->data;
+    for (int index = 0; index < blocksCount; index++) {
+        HeapBlockHeader* blockHeader = (HeapBlockHeader*)ptr;
+        if (blockHeader->state == HEAP_BLOCK_STATE_FREE && blockHeader->size > stats->largestFreeBlock) {
+            stats->largestFreeBlock = blockHeader->size;
+        }
+        ptr += blockHeader->size + HEAP_BLOCK_OVERHEAD_SIZE;
+    }
+
+    stats->wastedSize = stats->allocatedSize - stats->requestedSize;
+    stats->freeSize = heap->freeSize;
+    if (stats->freeSize > 0) {
+        stats->fragmentation = 100 - (int)((long long)stats->largestFreeBlock * 100 / stats->freeSize);
+    }
+    stats->systemBlocks = heap->systemBlocks;
+    stats->systemSize = heap->systemSize;
+
+    return true;
+}
+
 // 0x44A8E0
 static bool heap_create_lists()
 {
@@ -799,6 +989,7 @@ static bool heap_release_handle(Heap* heap, int handleIndex)
 {
     heap->handles[handleIndex].state = HEAP_HANDLE_STATE_INVALID;
     heap->handles[handleIndex].data = NULL;
+    heap->handles[handleIndex].size = 0;
 
     return true;
 }
@@ -811,6 +1002,7 @@ static bool heap_clear_handles(Heap* heap, HeapHandle* handles, unsigned int cou
     for (index = 0; index < count; index++) {
         handles[index].state = HEAP_HANDLE_STATE_INVALID;
         handles[index].data = NULL;
+        handles[index].size = 0;
     }
 
     return true;
@@ -1326,4 +1518,707 @@ static bool heap_build_fake_move_list(size_t count)
     return true;
 }
 
+
+// CE: Slab heap backend.
+//
+// The arena is split into pages. Small blocks (up to the largest size class)
+// are taken from single-page slabs holding slots of the same size, larger
+// blocks take a run of whole pages (first fit). Freed pages are coalesced
+// with adjacent free runs. Blocks never move, so locking is just a state
+// change and there is no compaction pass when the arena is fragmented -
+// allocation falls back to system memory (when allowed) instead.
+static bool heap_slab_init(Heap* heap, int size)
+{
+    int pageCount = (size + HEAP_SLAB_PAGE_SIZE - 1) / HEAP_SLAB_PAGE_SIZE;
+    if (pageCount <= 0) {
+        return false;
+    }
+
+    HeapSlab* slab = (HeapSlab*)mem_malloc(sizeof(*slab));
+    if (slab == NULL) {
+        return false;
+    }
+
+    memset(slab, 0, sizeof(*slab));
+
+    slab->pages = (HeapSlabPage*)mem_malloc(sizeof(*slab->pages) * pageCount);
+    slab->freeHandles = (int*)mem_malloc(sizeof(*slab->freeHandles) * heap->handlesLength);
+    heap->data = (unsigned char*)mem_malloc(pageCount * HEAP_SLAB_PAGE_SIZE);
+    if (slab->pages == NULL || slab->freeHandles == NULL || heap->data == NULL) {
+        if (heap->data != NULL) {
+            mem_free(heap->data);
+            heap->data = NULL;
+        }
+
+        if (slab->freeHandles != NULL) {
+            mem_free(slab->freeHandles);
+        }
+
+        if (slab->pages != NULL) {
+            mem_free(slab->pages);
+        }
+
+        mem_free(slab);
+
+        debug_printf("Heap Error: Could not initialize slab heap.\n");
+        return false;
+    }
+
+    slab->pageCount = pageCount;
+
+    for (int classIndex = 0; classIndex < HEAP_SLAB_CLASS_COUNT; classIndex++) {
+        slab->partial[classIndex] = -1;
+    }
+
+    // Push handles in reverse so the lowest indexes are used first.
+    for (int index = heap->handlesLength - 1; index >= 0; index--) {
+        slab->freeHandles[slab->freeHandlesLength++] = index;
+    }
+
+    heap_slab_set_run(slab, 0, pageCount, HEAP_SLAB_PAGE_FREE);
+    slab->freePages = pageCount;
+    slab->freeRuns = 1;
+
+    heap->type = HEAP_TYPE_SLAB;
+    heap->slab = slab;
+    heap->size = pageCount * HEAP_SLAB_PAGE_SIZE;
+    heap->freeBlocks = 1;
+    heap->freeSize = heap->size;
+
+    return true;
+}
+
+static void heap_slab_exit(Heap* heap)
+{
+    HeapSlab* slab = heap->slab;
+    if (slab == NULL) {
+        return;
+    }
+
+    mem_free(slab->freeHandles);
+    mem_free(slab->pages);
+    mem_free(slab);
+
+    heap->slab = NULL;
+}
+
+static bool heap_slab_acquire_handle(Heap* heap, int* handleIndexPtr)
+{
+    HeapSlab* slab = heap->slab;
+
+    if (slab->freeHandlesLength == 0) {
+        int handlesLength = heap->handlesLength + HEAP_HANDLES_INITIAL_LENGTH;
+
+        int* freeHandles = (int*)mem_realloc(slab->freeHandles, sizeof(*freeHandles) * handlesLength);
+        if (freeHandles == NULL) {
+            return false;
+        }
+        slab->freeHandles = freeHandles;
+
+        HeapHandle* handles = (HeapHandle*)mem_realloc(heap->handles, sizeof(*handles) * handlesLength);
+        if (handles == NULL) {
+            return false;
+        }
+        heap->handles = handles;
+
+        // NOTE: Uninline.
+        heap_clear_handles(heap, &(heap->handles[heap->handlesLength]), HEAP_HANDLES_INITIAL_LENGTH);
+
+        for (int index = handlesLength - 1; index >= heap->handlesLength; index--) {
+            slab->freeHandles[slab->freeHandlesLength++] = index;
+        }
+
+        heap->handlesLength = handlesLength;
+    }
+
+    *handleIndexPtr = slab->freeHandles[--slab->freeHandlesLength];
+
+    return true;
+}
+
+static void heap_slab_release_handle(Heap* heap, int handleIndex)
+{
+    // NOTE: Uninline.
+    heap_release_handle(heap, handleIndex);
+
+    heap->slab->freeHandles[heap->slab->freeHandlesLength++] = handleIndex;
+}
+
+// Returns size class for block of given size, or -1 if the block should be
+// allocated as a page run.
+static int heap_slab_class(int size)
+{
+    for (int classIndex = 0; classIndex < HEAP_SLAB_CLASS_COUNT; classIndex++) {
+        if (size <= heap_slab_class_sizes[classIndex]) {
+            return classIndex;
+        }
+    }
+
+    return -1;
+}
+
+static void heap_slab_set_run(HeapSlab* slab, int page, int count, int kind)
+{
+    slab->pages[page].kind = kind;
+    slab->pages[page].run = count;
+
+    slab->pages[page + count - 1].kind = kind;
+    slab->pages[page + count - 1].run = count;
+}
+
+// Takes first free run of at least `count` pages, returns index of the first
+// page or -1 if there is no such run.
+static int heap_slab_alloc_run(HeapSlab* slab, int count, int kind)
+{
+    int page = 0;
+    while (page < slab->pageCount) {
+        HeapSlabPage* pageInfo = &(slab->pages[page]);
+        if (pageInfo->kind == HEAP_SLAB_PAGE_FREE && pageInfo->run >= count) {
+            int remaining = pageInfo->run - count;
+
+            heap_slab_set_run(slab, page, count, kind);
+
+            if (remaining > 0) {
+                heap_slab_set_run(slab, page + count, remaining, HEAP_SLAB_PAGE_FREE);
+            } else {
+                slab->freeRuns--;
+            }
+
+            slab->freePages -= count;
+
+            return page;
+        }
+
+        page += pageInfo->run;
+    }
+
+    return -1;
+}
+
+// Returns run of pages to the free space coalescing it with adjacent free
+// runs.
+static void heap_slab_free_run(HeapSlab* slab, int page, int count)
+{
+    slab->freePages += count;
+    slab->freeRuns++;
+
+    int end = page + count;
+    if (end < slab->pageCount && slab->pages[end].kind == HEAP_SLAB_PAGE_FREE) {
+        count += slab->pages[end].run;
+        slab->freeRuns--;
+    }
+
+    if (page > 0 && slab->pages[page - 1].kind == HEAP_SLAB_PAGE_FREE) {
+        int prevCount = slab->pages[page - 1].run;
+        page -= prevCount;
+        count += prevCount;
+        slab->freeRuns--;
+    }
+
+    heap_slab_set_run(slab, page, count, HEAP_SLAB_PAGE_FREE);
+}
+
+static void heap_slab_partial_push(HeapSlab* slab, int page)
+{
+    HeapSlabPage* pageInfo = &(slab->pages[page]);
+    int classIndex = pageInfo->kind;
+
+    pageInfo->prev = -1;
+    pageInfo->next = slab->partial[classIndex];
+    if (pageInfo->next != -1) {
+        slab->pages[pageInfo->next].prev = page;
+    }
+    slab->partial[classIndex] = page;
+}
+
+static void heap_slab_partial_remove(HeapSlab* slab, int page)
+{
+    HeapSlabPage* pageInfo = &(slab->pages[page]);
+
+    if (pageInfo->prev != -1) {
+        slab->pages[pageInfo->prev].next = pageInfo->next;
+    } else {
+        slab->partial[pageInfo->kind] = pageInfo->next;
+    }
+
+    if (pageInfo->next != -1) {
+        slab->pages[pageInfo->next].prev = pageInfo->prev;
+    }
+
+    pageInfo->prev = -1;
+    pageInfo->next = -1;
+}
+
+// Allocates block in the arena, returns NULL when there is not enough room.
+static unsigned char* heap_slab_alloc_block(Heap* heap, int size, int* blockSizePtr)
+{
+    HeapSlab* slab = heap->slab;
+
+    int classIndex = heap_slab_class(size);
+    if (classIndex == -1) {
+        int count = (size + HEAP_SLAB_PAGE_SIZE - 1) / HEAP_SLAB_PAGE_SIZE;
+        int page = heap_slab_alloc_run(slab, count, HEAP_SLAB_PAGE_LARGE);
+        if (page == -1) {
+            return NULL;
+        }
+
+        slab->largePages += count;
+
+        *blockSizePtr = count * HEAP_SLAB_PAGE_SIZE;
+        return heap->data + page * HEAP_SLAB_PAGE_SIZE;
+    }
+
+    int slotSize = heap_slab_class_sizes[classIndex];
+
+    int page = slab->partial[classIndex];
+    if (page == -1) {
+        page = heap_slab_alloc_run(slab, 1, classIndex);
+        if (page == -1) {
+            return NULL;
+        }
+
+        slab->slabPages++;
+
+        // Thread all slots into the free list.
+        unsigned char* pageData = heap->data + page * HEAP_SLAB_PAGE_SIZE;
+        int slots = HEAP_SLAB_PAGE_SIZE / slotSize;
+        for (int slot = 0; slot < slots; slot++) {
+            *(int*)(pageData + slot * slotSize) = slot + 1 < slots ? slot + 1 : -1;
+        }
+
+        HeapSlabPage* pageInfo = &(slab->pages[page]);
+        pageInfo->used = 0;
+        pageInfo->freeSlot = 0;
+
+        heap_slab_partial_push(slab, page);
+    }
+
+    HeapSlabPage* pageInfo = &(slab->pages[page]);
+    unsigned char* block = heap->data + page * HEAP_SLAB_PAGE_SIZE + pageInfo->freeSlot * slotSize;
+
+    pageInfo->freeSlot = *(int*)block;
+    pageInfo->used++;
+
+    if (pageInfo->freeSlot == -1) {
+        heap_slab_partial_remove(slab, page);
+    }
+
+    *blockSizePtr = slotSize;
+    return block;
+}
+
+static void heap_slab_free_block(Heap* heap, unsigned char* block)
+{
+    HeapSlab* slab = heap->slab;
+
+    int offset = (int)(block - heap->data);
+    int page = offset / HEAP_SLAB_PAGE_SIZE;
+    HeapSlabPage* pageInfo = &(slab->pages[page]);
+
+    if (pageInfo->kind == HEAP_SLAB_PAGE_LARGE) {
+        int count = pageInfo->run;
+        slab->largePages -= count;
+        heap_slab_free_run(slab, page, count);
+        return;
+    }
+
+    int slotSize = heap_slab_class_sizes[pageInfo->kind];
+    int slot = (offset % HEAP_SLAB_PAGE_SIZE) / slotSize;
+
+    bool wasFull = pageInfo->freeSlot == -1;
+
+    *(int*)block = pageInfo->freeSlot;
+    pageInfo->freeSlot = slot;
+    pageInfo->used--;
+
+    if (pageInfo->used == 0) {
+        // Release empty slab page so it can be reused by any size class.
+        if (!wasFull) {
+            heap_slab_partial_remove(slab, page);
+        }
+
+        slab->slabPages--;
+        heap_slab_free_run(slab, page, 1);
+    } else if (wasFull) {
+        heap_slab_partial_push(slab, page);
+    }
+}
+
+// Returns arena size occupied by given block.
+static int heap_slab_block_size(Heap* heap, unsigned char* block)
+{
+    HeapSlabPage* pageInfo = &(heap->slab->pages[(block - heap->data) / HEAP_SLAB_PAGE_SIZE]);
+    if (pageInfo->kind == HEAP_SLAB_PAGE_LARGE) {
+        return pageInfo->run * HEAP_SLAB_PAGE_SIZE;
+    }
+
+    return heap_slab_class_sizes[pageInfo->kind];
+}
+
+static bool heap_slab_allocate(Heap* heap, int* handleIndexPtr, int size, int a4)
+{
+    if (heap == NULL || handleIndexPtr == NULL || size <= 0) {
+        debug_printf("Heap Warning: Could not allocate block of %d bytes.\n", size);
+        return false;
+    }
+
+    if (a4 != 0 && a4 != 1) {
+        a4 = 0;
+    }
+
+    int handleIndex;
+    if (!heap_slab_acquire_handle(heap, &handleIndex)) {
+        debug_printf("Heap Error: Could not acquire handle for new block.\n");
+        debug_printf("Heap Warning: Could not allocate block of %d bytes.\n", size);
+        return false;
+    }
+
+    HeapHandle* handle = &(heap->handles[handleIndex]);
+
+    int blockSize;
+    unsigned char* block = heap_slab_alloc_block(heap, size, &blockSize);
+    if (block != NULL) {
+        handle->state = HEAP_BLOCK_STATE_MOVABLE;
+        handle->data = block;
+        handle->size = size;
+
+        heap->moveableBlocks++;
+        heap->moveableSize += blockSize;
+        heap->freeSize -= blockSize;
+        heap->freeBlocks = heap->slab->freeRuns;
+
+        *handleIndexPtr = handleIndex;
+
+        return true;
+    }
+
+    if (a4 == 0) {
+        block = (unsigned char*)mem_malloc(size);
+        if (block != NULL) {
+            handle->state = HEAP_BLOCK_STATE_SYSTEM;
+            handle->data = block;
+            handle->size = size;
+
+            heap->systemBlocks++;
+            heap->systemSize += size;
+
+            *handleIndexPtr = handleIndex;
+
+            return true;
+        }
+    }
+
+    heap_slab_release_handle(heap, handleIndex);
+
+    debug_printf("Heap Warning: Could not allocate block of %d bytes.\n", size);
+    return false;
+}
+
+static bool heap_slab_deallocate(Heap* heap, int* handleIndexPtr)
+{
+    int handleIndex = *handleIndexPtr;
+    HeapHandle* handle = &(heap->handles[handleIndex]);
+
+    if (handle->state == HEAP_HANDLE_STATE_INVALID) {
+        debug_printf("Heap Error: Unknown block state during deallocation.\n");
+        return false;
+    }
+
+    if ((handle->state & HEAP_BLOCK_STATE_LOCKED) != 0) {
+        debug_printf("Heap Error: Attempt to deallocate locked block.\n");
+        return false;
+    }
+
+    if (handle->state == HEAP_BLOCK_STATE_SYSTEM) {
+        mem_free(handle->data);
+
+        heap->systemBlocks--;
+        heap->systemSize -= handle->size;
+    } else {
+        int blockSize = heap_slab_block_size(heap, handle->data);
+        heap_slab_free_block(heap, handle->data);
+
+        heap->moveableBlocks--;
+        heap->moveableSize -= blockSize;
+        heap->freeSize += blockSize;
+        heap->freeBlocks = heap->slab->freeRuns;
+    }
+
+    heap_slab_release_handle(heap, handleIndex);
+
+    return true;
+}
+
+static bool heap_slab_lock(Heap* heap, int handleIndex, unsigned char** bufferPtr)
+{
+    HeapHandle* handle = &(heap->handles[handleIndex]);
+
+    if (handle->state == HEAP_HANDLE_STATE_INVALID) {
+        debug_printf("Heap Error: Unknown block state during lock.\n");
+        return false;
+    }
+
+    if ((handle->state & HEAP_BLOCK_STATE_LOCKED) != 0) {
+        debug_printf("Heap Error: Attempt to lock a previously locked block.");
+        return false;
+    }
+
+    if (handle->state == HEAP_BLOCK_STATE_MOVABLE) {
+        int blockSize = heap_slab_block_size(heap, handle->data);
+
+        heap->moveableBlocks--;
+        heap->lockedBlocks++;
+        heap->moveableSize -= blockSize;
+        heap->lockedSize += blockSize;
+    }
+
+    handle->state |= HEAP_BLOCK_STATE_LOCKED;
+    handle->state &= ~HEAP_BLOCK_STATE_MOVABLE;
+
+    *bufferPtr = handle->data;
+
+    return true;
+}
+
+static bool heap_slab_unlock(Heap* heap, int handleIndex)
+{
+    HeapHandle* handle = &(heap->handles[handleIndex]);
+
+    if (handle->state == HEAP_HANDLE_STATE_INVALID || (handle->state & HEAP_BLOCK_STATE_LOCKED) == 0) {
+        debug_printf("Heap Error: Attempt to unlock a previously unlocked block.\n");
+        debug_printf("Heap Error: Could not unlock block.\n");
+        return false;
+    }
+
+    if ((handle->state & HEAP_BLOCK_STATE_SYSTEM) != 0) {
+        handle->state = HEAP_BLOCK_STATE_SYSTEM;
+        return true;
+    }
+
+    int blockSize = heap_slab_block_size(heap, handle->data);
+
+    heap->moveableBlocks++;
+    heap->lockedBlocks--;
+    heap->moveableSize += blockSize;
+    heap->lockedSize -= blockSize;
+
+    handle->state = HEAP_BLOCK_STATE_MOVABLE;
+
+    return true;
+}
+
+static bool heap_slab_stats(Heap* heap, char* dest, size_t size)
+{
+    HeapSlab* slab = heap->slab;
+
+    const char* format = "[Slab Heap]\n"
+                         "Total free pages: %d\n"
+                         "Total free runs: %d\n"
+                         "Total slab pages: %d\n"
+                         "Total large pages: %d\n"
+                         "Total free size: %d\n"
+                         "Total unlocked blocks: %d\n"
+                         "Total unlocked size: %d\n"
+                         "Total locked blocks: %d\n"
+                         "Total locked size: %d\n"
+                         "Total system blocks: %d\n"
+                         "Total system size: %d\n"
+                         "Total handles: %d\n"
+                         "Total heaps: %d";
+
+    snprintf(dest, size, format,
+        slab->freePages,
+        slab->freeRuns,
+        slab->slabPages,
+        slab->largePages,
+        heap->freeSize,
+        heap->moveableBlocks,
+        heap->moveableSize,
+        heap->lockedBlocks,
+        heap->lockedSize,
+        heap->systemBlocks,
+        heap->systemSize,
+        heap->handlesLength,
+        heap_count);
+
+    return true;
+}
+
+static bool heap_slab_validate(Heap* heap)
+{
+    debug_printf("Validating slab heap...\n");
+
+    HeapSlab* slab = heap->slab;
+
+    int freePages = 0;
+    int freeRuns = 0;
+    int slabPages = 0;
+    int largePages = 0;
+    int usedSlots = 0;
+
+    int page = 0;
+    while (page < slab->pageCount) {
+        HeapSlabPage* pageInfo = &(slab->pages[page]);
+        if (pageInfo->run <= 0 || page + pageInfo->run > slab->pageCount) {
+            debug_printf("Ran off end of heap during validate!\n");
+            return false;
+        }
+
+        HeapSlabPage* lastPageInfo = &(slab->pages[page + pageInfo->run - 1]);
+        if (lastPageInfo->kind != pageInfo->kind || lastPageInfo->run != pageInfo->run) {
+            debug_printf("Mismatched page run detected during validate.\n");
+            return false;
+        }
+
+        if (pageInfo->kind == HEAP_SLAB_PAGE_FREE) {
+            if (page > 0 && slab->pages[page - 1].kind == HEAP_SLAB_PAGE_FREE) {
+                debug_printf("Uncoalesced free pages detected during validate.\n");
+                return false;
+            }
+
+            freePages += pageInfo->run;
+            freeRuns++;
+        } else if (pageInfo->kind == HEAP_SLAB_PAGE_LARGE) {
+            largePages += pageInfo->run;
+        } else {
+            if (pageInfo->used <= 0 || pageInfo->used > HEAP_SLAB_PAGE_SIZE / heap_slab_class_sizes[pageInfo->kind]) {
+                debug_printf("Invalid number of used slots.\n");
+                return false;
+            }
+
+            slabPages++;
+            usedSlots += pageInfo->used;
+        }
+
+        page += pageInfo->run;
+    }
+
+    if (freePages != slab->freePages || freeRuns != slab->freeRuns) {
+        debug_printf("Invalid number of free pages.\n");
+        return false;
+    }
+
+    if (slabPages != slab->slabPages || largePages != slab->largePages) {
+        debug_printf("Invalid number of used pages.\n");
+        return false;
+    }
+
+    int blocks = 0;
+    int blocksSize = 0;
+    int lockedBlocks = 0;
+    int lockedSize = 0;
+    int systemBlocks = 0;
+    int systemSize = 0;
+    int slabBlocks = 0;
+
+    for (int handleIndex = 0; handleIndex < heap->handlesLength; handleIndex++) {
+        HeapHandle* handle = &(heap->handles[handleIndex]);
+        if (handle->state == HEAP_HANDLE_STATE_INVALID) {
+            continue;
+        }
+
+        if ((handle->state & HEAP_BLOCK_STATE_SYSTEM) != 0) {
+            systemBlocks++;
+            systemSize += handle->size;
+            continue;
+        }
+
+        int blockSize = heap_slab_block_size(heap, handle->data);
+        if (handle->size > blockSize) {
+            debug_printf("Invalid block size.\n");
+            return false;
+        }
+
+        if (slab->pages[(handle->data - heap->data) / HEAP_SLAB_PAGE_SIZE].kind >= 0) {
+            slabBlocks++;
+        }
+
+        if ((handle->state & HEAP_BLOCK_STATE_LOCKED) != 0) {
+            lockedBlocks++;
+            lockedSize += blockSize;
+        } else {
+            blocks++;
+            blocksSize += blockSize;
+        }
+    }
+
+    if (slabBlocks != usedSlots) {
+        debug_printf("Invalid number of used slots.\n");
+        return false;
+    }
+
+    if (blocks != heap->moveableBlocks || blocksSize != heap->moveableSize) {
+        debug_printf("Invalid number of unlocked blocks.\n");
+        return false;
+    }
+
+    if (lockedBlocks != heap->lockedBlocks || lockedSize != heap->lockedSize) {
+        debug_printf("Invalid number of locked blocks.\n");
+        return false;
+    }
+
+    if (blocksSize + lockedSize + heap->freeSize != heap->size) {
+        debug_printf("Invalid size of free blocks.\n");
+        return false;
+    }
+
+    if (systemBlocks != heap->systemBlocks || systemSize != heap->systemSize) {
+        debug_printf("Invalid number of system blocks.\n");
+        return false;
+    }
+
+    debug_printf("Heap is O.K.\n");
+
+    return true;
+}
+
+static bool heap_slab_get_fragmentation_stats(Heap* heap, HeapFragmentationStats* stats)
+{
+    HeapSlab* slab = heap->slab;
+
+    memset(stats, 0, sizeof(*stats));
+    stats->type = HEAP_TYPE_SLAB;
+    stats->capacity = heap->size;
+
+    for (int handleIndex = 0; handleIndex < heap->handlesLength; handleIndex++) {
+        HeapHandle* handle = &(heap->handles[handleIndex]);
+        if (handle->state == HEAP_HANDLE_STATE_INVALID || (handle->state & HEAP_BLOCK_STATE_SYSTEM) != 0) {
+            continue;
+        }
+
+        stats->blocks++;
+        stats->requestedSize += handle->size;
+        stats->allocatedSize += heap_slab_block_size(heap, handle->data);
+    }
+
+    int page = 0;
+    while (page < slab->pageCount) {
+        HeapSlabPage* pageInfo = &(slab->pages[page]);
+        if (pageInfo->kind == HEAP_SLAB_PAGE_FREE && pageInfo->run * HEAP_SLAB_PAGE_SIZE > stats->largestFreeBlock) {
+            stats->largestFreeBlock = pageInfo->run * HEAP_SLAB_PAGE_SIZE;
+        }
+        page += pageInfo->run;
+    }
+
+    // Without free pages the only room left is in partially used slabs.
+    if (stats->largestFreeBlock == 0) {
+        for (int classIndex = HEAP_SLAB_CLASS_COUNT - 1; classIndex >= 0; classIndex--) {
+            if (slab->partial[classIndex] != -1) {
+                stats->largestFreeBlock = heap_slab_class_sizes[classIndex];
+                break;
+            }
+        }
+    }
+
+    stats->wastedSize = stats->allocatedSize - stats->requestedSize;
+    stats->freeSize = heap->freeSize;
+    if (stats->freeSize > 0) {
+        stats->fragmentation = 100 - (int)((long long)stats->largestFreeBlock * 100 / stats->freeSize);
+    }
+    stats->systemBlocks = heap->systemBlocks;
+    stats->systemSize = heap->systemSize;
+
+    return true;
+}
+
 } // namespace fallout
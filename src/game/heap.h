@@ -5,9 +5,24 @@
 
 namespace fallout {
 
+// CE: Heap backends, see `heap_init_with_type`.
+typedef enum HeapType {
+    // Original compacting heap: one contiguous arena, blocks are moved around
+    // to make room for new allocations.
+    HEAP_TYPE_COMPACTING = 0,
+
+    // Size-class slabs for small blocks plus page runs for large blocks, no
+    // compaction.
+    HEAP_TYPE_SLAB = 1,
+} HeapType;
+
 typedef struct HeapHandle {
     unsigned int state;
     unsigned char* data;
+
+    // CE: Requested size of the block (before rounding), used in
+    // fragmentation stats.
+    int size;
 } HeapHandle;
 
 typedef struct Heap {
@@ -23,9 +38,50 @@ typedef struct Heap {
     int systemSize;
     HeapHandle* handles;
     unsigned char* data;
+
+    // CE: One of `HeapType`.
+    int type;
+
+    // CE: Slab backend state (only valid when `type` is `HEAP_TYPE_SLAB`).
+    struct HeapSlab* slab;
 } Heap;
 
+// CE: Fragmentation and waste statistics comparable across heap backends.
+typedef struct HeapFragmentationStats {
+    int type;
+
+    // Size of heap arena.
+    int capacity;
+
+    // Number of live blocks in the arena and total size requested for them.
+    int blocks;
+    int requestedSize;
+
+    // Arena bytes occupied by live blocks including rounding and per-block
+    // overhead.
+    int allocatedSize;
+
+    // Difference between `allocatedSize` and `requestedSize`.
+    int wastedSize;
+
+    // Arena bytes available for new blocks.
+    int freeSize;
+
+    // The largest block that can be allocated right away (without compaction
+    // or falling back to system memory).
+    int largestFreeBlock;
+
+    // Percentage of free space not available as the largest block (0 means
+    // free space is contiguous).
+    int fragmentation;
+
+    // Blocks allocated outside of the arena.
+    int systemBlocks;
+    int systemSize;
+} HeapFragmentationStats;
+
 bool heap_init(Heap* heap, int a2);
+bool heap_init_with_type(Heap* heap, int a2, int type);
 bool heap_exit(Heap* heap);
 bool heap_allocate(Heap* heap, int* handleIndexPtr, int size, int a3);
 bool heap_deallocate(Heap* heap, int* handleIndexPtr);
@@ -33,6 +89,7 @@ bool heap_lock(Heap* heap, int handleIndex, unsigned char** bufferPtr);
 bool heap_unlock(Heap* heap, int handleIndex);
 bool heap_stats(Heap* heap, char* dest, size_t size);
 bool heap_validate(Heap* heap);
+bool heap_get_fragmentation_stats(Heap* heap, HeapFragmentationStats* stats);
 
 } // namespace fallout
 
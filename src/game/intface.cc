@@ -59,6 +59,8 @@ typedef enum InterfaceNumbersColor {
 // The maximum number of indicator boxes the indicator bar can display.
 #define INDICATOR_SLOTS_COUNT 4
 
+#define INTERFACE_COUNTER_LAYER_COUNT 2
+
 // Available indicators.
 //
 // Indicator boxes in the bar are displayed according to the order of this enum.
@@ -97,6 +99,38 @@ typedef struct InterfaceItemState {
     int itemFid;
 } InterfaceItemState;
 
+// CE: Parts of the interface bar are redrawn only when values they display
+// change. Each layer remembers what was last drawn into `interfaceBuffer`.
+typedef struct InterfaceCounterLayer {
+    int x;
+    int y;
+    bool valid;
+    int value;
+    int offset;
+} InterfaceCounterLayer;
+
+typedef struct InterfaceMovePointsLayer {
+    bool valid;
+    int actionPoints;
+    int bonusMove;
+} InterfaceMovePointsLayer;
+
+typedef struct InterfaceAmmoLayer {
+    bool valid;
+    int x;
+    int ratio;
+} InterfaceAmmoLayer;
+
+// CE: Inputs item button art is composed from.
+typedef struct InterfaceItemLayer {
+    bool valid;
+    int isDisabled;
+    int bullseyeFid;
+    int primaryFid;
+    int actionPoints;
+    int itemFid;
+} InterfaceItemLayer;
+
 static int intface_init_items();
 static int intface_redraw_items();
 static int intface_redraw_items_callback(Object* a1, Object* a2);
@@ -116,6 +150,8 @@ static void reset_box_bar_win();
 static int bbox_comp(const void* a, const void* b);
 static void draw_bboxes(int count);
 static bool add_bar_box(int indicator);
+static void intface_invalidate_layers();
+static InterfaceCounterLayer* intface_find_counter_layer(int x, int y);
 
 // 0x505508
 static bool insideInit = false;
@@ -386,6 +422,18 @@ static unsigned char* inventoryButtonDown;
 // 0x59B994
 static unsigned char movePointBackground[90 * 5];
 
+// CE: Hit points and armor class counters.
+static InterfaceCounterLayer intface_counter_layers[INTERFACE_COUNTER_LAYER_COUNT] = {
+    { 473, 40, false, 0, 0 },
+    { 473, 75, false, 0, 0 },
+};
+
+static InterfaceMovePointsLayer intface_move_points_layer;
+
+static InterfaceAmmoLayer intface_ammo_layer;
+
+static InterfaceItemLayer intface_item_layer;
+
 // 0x4531F0
 int intface_init()
 {
@@ -424,6 +472,8 @@ int intface_init()
     buf_to_buf(backgroundFrmData, INTERFACE_BAR_WIDTH, INTERFACE_BAR_HEIGHT, INTERFACE_BAR_WIDTH, interfaceBuffer, 640);
     art_ptr_unlock(backgroundFrmHandle);
 
+    intface_invalidate_layers();
+
     fid = art_id(OBJ_TYPE_INTERFACE, 47, 0, 0, 0);
     inventoryButtonUp = art_ptr_lock_data(fid, 0, 0, &inventoryButtonUpKey);
     if (inventoryButtonUp == NULL) {
@@ -1187,6 +1237,17 @@ void intface_update_move_points(int actionPoints, int bonusMove)
         return;
     }
 
+    // CE: Skip redraw when the same lights are already displayed.
+    if (intface_move_points_layer.valid
+        && intface_move_points_layer.actionPoints == actionPoints
+        && intface_move_points_layer.bonusMove == bonusMove) {
+        return;
+    }
+
+    intface_move_points_layer.valid = true;
+    intface_move_points_layer.actionPoints = actionPoints;
+    intface_move_points_layer.bonusMove = bonusMove;
+
     buf_to_buf(movePointBackground, 90, 5, 90, interfaceBuffer + 14 * 640 + 316, 640);
 
     if (actionPoints == -1) {
@@ -1743,86 +1804,56 @@ static int intface_redraw_items()
     win_enable_button(itemButton);
 
     InterfaceItemState* itemState = &(itemButtonItems[itemCurrentItem]);
-    int actionPoints = -1;
 
-    if (itemState->isDisabled == 0) {
-        memcpy(itemButtonUp, itemButtonUpBlank, sizeof(itemButtonUp));
-        memcpy(itemButtonDown, itemButtonDownBlank, sizeof(itemButtonDown));
+    // CE: Resolve art the button is composed from first, so composition can
+    // be skipped when it's the same as displayed.
+    InterfaceItemLayer layer;
+    layer.valid = true;
+    layer.isDisabled = itemState->isDisabled;
+    layer.bullseyeFid = -1;
+    layer.primaryFid = -1;
+    layer.actionPoints = -1;
+    layer.itemFid = itemState->itemFid;
 
+    if (itemState->isDisabled == 0) {
         if (itemState->isWeapon == 0) {
-            int fid;
             if (proto_action_can_use_on(itemState->item->pid)) {
                 // USE ON
-                fid = art_id(OBJ_TYPE_INTERFACE, 294, 0, 0, 0);
+                layer.primaryFid = art_id(OBJ_TYPE_INTERFACE, 294, 0, 0, 0);
             } else if (proto_action_can_use(itemState->item->pid)) {
                 // USE
-                fid = art_id(OBJ_TYPE_INTERFACE, 292, 0, 0, 0);
-            } else {
-                fid = -1;
+                layer.primaryFid = art_id(OBJ_TYPE_INTERFACE, 292, 0, 0, 0);
             }
 
-            if (fid != -1) {
-                CacheEntry* useTextFrmHandle;
-                Art* useTextFrm = art_ptr_lock(fid, &useTextFrmHandle);
-                if (useTextFrm != NULL) {
-                    int width = art_frame_width(useTextFrm, 0, 0);
-                    int height = art_frame_length(useTextFrm, 0, 0);
-                    unsigned char* data = art_frame_data(useTextFrm, 0, 0);
-                    trans_buf_to_buf(data, width, height, width, itemButtonUp + 188 * 7 + 181 - width, 188);
-                    dark_trans_buf_to_buf(data, width, height, width, itemButtonDown, 181 - width + 1, 5, 188, 59641);
-                    art_ptr_unlock(useTextFrmHandle);
-                }
-
-                actionPoints = item_mp_cost(obj_dude, itemState->primaryHitMode, false);
+            if (layer.primaryFid != -1) {
+                layer.actionPoints = item_mp_cost(obj_dude, itemState->primaryHitMode, false);
             }
         } else {
-            int primaryFid = -1;
-            int bullseyeFid = -1;
             int hitMode = -1;
 
             // NOTE: This value is decremented at 0x45FEAC, probably to build
             // jump table.
             switch (itemState->action) {
             case INTERFACE_ITEM_ACTION_PRIMARY_AIMING:
-                bullseyeFid = art_id(OBJ_TYPE_INTERFACE, 288, 0, 0, 0);
+                layer.bullseyeFid = art_id(OBJ_TYPE_INTERFACE, 288, 0, 0, 0);
                 // FALLTHROUGH
             case INTERFACE_ITEM_ACTION_PRIMARY:
                 hitMode = itemState->primaryHitMode;
                 break;
             case INTERFACE_ITEM_ACTION_SECONDARY_AIMING:
-                bullseyeFid = art_id(OBJ_TYPE_INTERFACE, 288, 0, 0, 0);
+                layer.bullseyeFid = art_id(OBJ_TYPE_INTERFACE, 288, 0, 0, 0);
                 // FALLTHROUGH
             case INTERFACE_ITEM_ACTION_SECONDARY:
                 hitMode = itemState->secondaryHitMode;
                 break;
             case INTERFACE_ITEM_ACTION_RELOAD:
-                actionPoints = item_mp_cost(obj_dude, itemCurrentItem == HAND_LEFT ? HIT_MODE_LEFT_WEAPON_RELOAD : HIT_MODE_RIGHT_WEAPON_RELOAD, false);
-                primaryFid = art_id(OBJ_TYPE_INTERFACE, 291, 0, 0, 0);
+                layer.actionPoints = item_mp_cost(obj_dude, itemCurrentItem == HAND_LEFT ? HIT_MODE_LEFT_WEAPON_RELOAD : HIT_MODE_RIGHT_WEAPON_RELOAD, false);
+                layer.primaryFid = art_id(OBJ_TYPE_INTERFACE, 291, 0, 0, 0);
                 break;
             }
 
-            if (bullseyeFid != -1) {
-                CacheEntry* bullseyeFrmHandle;
-                Art* bullseyeFrm = art_ptr_lock(bullseyeFid, &bullseyeFrmHandle);
-                if (bullseyeFrm != NULL) {
-                    int width = art_frame_width(bullseyeFrm, 0, 0);
-                    int height = art_frame_length(bullseyeFrm, 0, 0);
-                    unsigned char* data = art_frame_data(bullseyeFrm, 0, 0);
-                    trans_buf_to_buf(data, width, height, width, itemButtonUp + 188 * (60 - height) + (181 - width), 188);
-
-                    int v9 = 60 - height - 2;
-                    if (v9 < 0) {
-                        v9 = 0;
-                        height -= 2;
-                    }
-
-                    dark_trans_buf_to_buf(data, width, height, width, itemButtonDown, 181 - width + 1, v9, 188, 59641);
-                    art_ptr_unlock(bullseyeFrmHandle);
-                }
-            }
-
             if (hitMode != -1) {
-                actionPoints = item_w_mp_cost(obj_dude, hitMode, bullseyeFid != -1);
+                layer.actionPoints = item_w_mp_cost(obj_dude, hitMode, layer.bullseyeFid != -1);
 
                 int id;
                 int anim = item_w_anim(obj_dude, hitMode);
@@ -1849,12 +1880,49 @@ static int intface_redraw_items()
                     break;
                 }
 
-                primaryFid = art_id(OBJ_TYPE_INTERFACE, id, 0, 0, 0);
+                layer.primaryFid = art_id(OBJ_TYPE_INTERFACE, id, 0, 0, 0);
             }
+        }
+    }
+
+    bool changed = !intface_item_layer.valid
+        || intface_item_layer.isDisabled != layer.isDisabled
+        || intface_item_layer.bullseyeFid != layer.bullseyeFid
+        || intface_item_layer.primaryFid != layer.primaryFid
+        || intface_item_layer.actionPoints != layer.actionPoints
+        || intface_item_layer.itemFid != layer.itemFid;
+
+    if (changed) {
+        intface_item_layer = layer;
+
+        if (layer.isDisabled == 0) {
+            memcpy(itemButtonUp, itemButtonUpBlank, sizeof(itemButtonUp));
+            memcpy(itemButtonDown, itemButtonDownBlank, sizeof(itemButtonDown));
 
-            if (primaryFid != -1) {
+            if (layer.bullseyeFid != -1) {
+                CacheEntry* bullseyeFrmHandle;
+                Art* bullseyeFrm = art_ptr_lock(layer.bullseyeFid, &bullseyeFrmHandle);
+                if (bullseyeFrm != NULL) {
+                    int width = art_frame_width(bullseyeFrm, 0, 0);
+                    int height = art_frame_length(bullseyeFrm, 0, 0);
+                    unsigned char* data = art_frame_data(bullseyeFrm, 0, 0);
+                    trans_buf_to_buf(data, width, height, width, itemButtonUp + 188 * (60 - height) + (181 - width), 188);
+
+                    int v9 = 60 - height - 2;
+                    if (v9 < 0) {
+                        v9 = 0;
+                        height -= 2;
+                    }
+
+                    dark_trans_buf_to_buf(data, width, height, width, itemButtonDown, 181 - width + 1, v9, 188, 59641);
+                    art_ptr_unlock(bullseyeFrmHandle);
+                }
+            }
+
+            // Attack mode, reload or use text.
+            if (layer.primaryFid != -1) {
                 CacheEntry* primaryFrmHandle;
-                Art* primaryFrm = art_ptr_lock(primaryFid, &primaryFrmHandle);
+                Art* primaryFrm = art_ptr_lock(layer.primaryFid, &primaryFrmHandle);
                 if (primaryFrm != NULL) {
                     int width = art_frame_width(primaryFrm, 0, 0);
                     int height = art_frame_length(primaryFrm, 0, 0);
@@ -1865,84 +1933,87 @@ static int intface_redraw_items()
                 }
             }
         }
-    }
 
-    if (actionPoints >= 0 && actionPoints < 10) {
-        // movement point text
-        int fid = art_id(OBJ_TYPE_INTERFACE, 289, 0, 0, 0);
+        int actionPoints = layer.actionPoints;
+        if (actionPoints >= 0 && actionPoints < 10) {
+            // movement point text
+            int fid = art_id(OBJ_TYPE_INTERFACE, 289, 0, 0, 0);
 
-        CacheEntry* handle;
-        Art* art = art_ptr_lock(fid, &handle);
-        if (art != NULL) {
-            int width = art_frame_width(art, 0, 0);
-            int height = art_frame_length(art, 0, 0);
-            unsigned char* data = art_frame_data(art, 0, 0);
+            CacheEntry* handle;
+            Art* art = art_ptr_lock(fid, &handle);
+            if (art != NULL) {
+                int width = art_frame_width(art, 0, 0);
+                int height = art_frame_length(art, 0, 0);
+                unsigned char* data = art_frame_data(art, 0, 0);
 
-            trans_buf_to_buf(data, width, height, width, itemButtonUp + 188 * (60 - height) + 7, 188);
+                trans_buf_to_buf(data, width, height, width, itemButtonUp + 188 * (60 - height) + 7, 188);
 
-            int v29 = 60 - height - 2;
-            if (v29 < 0) {
-                v29 = 0;
-                height -= 2;
-            }
+                int v29 = 60 - height - 2;
+                if (v29 < 0) {
+                    v29 = 0;
+                    height -= 2;
+                }
 
-            dark_trans_buf_to_buf(data, width, height, width, itemButtonDown, 7 + 1, v29, 188, 59641);
-            art_ptr_unlock(handle);
+                dark_trans_buf_to_buf(data, width, height, width, itemButtonDown, 7 + 1, v29, 188, 59641);
+                art_ptr_unlock(handle);
 
-            int offset = width + 7;
+                int offset = width + 7;
 
-            // movement point numbers - ten numbers 0 to 9, each 10 pixels wide.
-            fid = art_id(OBJ_TYPE_INTERFACE, 290, 0, 0, 0);
-            art = art_ptr_lock(fid, &handle);
-            if (art != NULL) {
-                width = art_frame_width(art, 0, 0);
-                height = art_frame_length(art, 0, 0);
-                data = art_frame_data(art, 0, 0);
+                // movement point numbers - ten numbers 0 to 9, each 10 pixels wide.
+                fid = art_id(OBJ_TYPE_INTERFACE, 290, 0, 0, 0);
+                art = art_ptr_lock(fid, &handle);
+                if (art != NULL) {
+                    width = art_frame_width(art, 0, 0);
+                    height = art_frame_length(art, 0, 0);
+                    data = art_frame_data(art, 0, 0);
 
-                trans_buf_to_buf(data + actionPoints * 10, 10, height, width, itemButtonUp + 188 * (60 - height) + 7 + offset, 188);
+                    trans_buf_to_buf(data + actionPoints * 10, 10, height, width, itemButtonUp + 188 * (60 - height) + 7 + offset, 188);
 
-                int v40 = 60 - height - 2;
-                if (v40 < 0) {
-                    v40 = 0;
-                    height -= 2;
-                }
-                dark_trans_buf_to_buf(data + actionPoints * 10, 10, height, width, itemButtonDown, offset + 7 + 1, v40, 188, 59641);
+                    int v40 = 60 - height - 2;
+                    if (v40 < 0) {
+                        v40 = 0;
+                        height -= 2;
+                    }
+                    dark_trans_buf_to_buf(data + actionPoints * 10, 10, height, width, itemButtonDown, offset + 7 + 1, v40, 188, 59641);
 
-                art_ptr_unlock(handle);
+                    art_ptr_unlock(handle);
+                }
             }
+        } else {
+            memcpy(itemButtonUp, itemButtonDisabled, sizeof(itemButtonUp));
+            memcpy(itemButtonDown, itemButtonDisabled, sizeof(itemButtonDown));
         }
-    } else {
-        memcpy(itemButtonUp, itemButtonDisabled, sizeof(itemButtonUp));
-        memcpy(itemButtonDown, itemButtonDisabled, sizeof(itemButtonDown));
-    }
 
-    if (itemState->itemFid != -1) {
-        CacheEntry* itemFrmHandle;
-        Art* itemFrm = art_ptr_lock(itemState->itemFid, &itemFrmHandle);
-        if (itemFrm != NULL) {
-            int width = art_frame_width(itemFrm, 0, 0);
-            int height = art_frame_length(itemFrm, 0, 0);
-            unsigned char* data = art_frame_data(itemFrm, 0, 0);
+        if (itemState->itemFid != -1) {
+            CacheEntry* itemFrmHandle;
+            Art* itemFrm = art_ptr_lock(itemState->itemFid, &itemFrmHandle);
+            if (itemFrm != NULL) {
+                int width = art_frame_width(itemFrm, 0, 0);
+                int height = art_frame_length(itemFrm, 0, 0);
+                unsigned char* data = art_frame_data(itemFrm, 0, 0);
 
-            int v46 = (188 - width) / 2;
-            int v47 = (67 - height) / 2 - 2;
+                int v46 = (188 - width) / 2;
+                int v47 = (67 - height) / 2 - 2;
 
-            trans_buf_to_buf(data, width, height, width, itemButtonUp + 188 * ((67 - height) / 2) + v46, 188);
+                trans_buf_to_buf(data, width, height, width, itemButtonUp + 188 * ((67 - height) / 2) + v46, 188);
 
-            if (v47 < 0) {
-                v47 = 0;
-                height -= 2;
-            }
+                if (v47 < 0) {
+                    v47 = 0;
+                    height -= 2;
+                }
 
-            dark_trans_buf_to_buf(data, width, height, width, itemButtonDown, v46 + 1, v47, 188, 63571);
-            art_ptr_unlock(itemFrmHandle);
+                dark_trans_buf_to_buf(data, width, height, width, itemButtonDown, v46 + 1, v47, 188, 63571);
+                art_ptr_unlock(itemFrmHandle);
+            }
         }
     }
 
     if (!insideInit) {
         intface_update_ammo_lights();
 
-        win_draw_rect(interfaceWindow, &itemButtonRect);
+        if (changed) {
+            win_draw_rect(interfaceWindow, &itemButtonRect);
+        }
 
         if (itemState->isDisabled != 0) {
             win_disable_button(itemButton);
@@ -2160,6 +2231,15 @@ static void intface_draw_ammo_lights(int x, int ratio)
         ratio -= 1;
     }
 
+    // CE: Skip redraw when the same bar is already displayed.
+    if (intface_ammo_layer.valid && intface_ammo_layer.x == x && intface_ammo_layer.ratio == ratio) {
+        return;
+    }
+
+    intface_ammo_layer.valid = true;
+    intface_ammo_layer.x = x;
+    intface_ammo_layer.ratio = ratio;
+
     unsigned char* dest = interfaceBuffer + 640 * 26 + x;
 
     for (int index = 70; index > ratio; index--) {
@@ -2221,6 +2301,25 @@ static void intface_rotate_numbers(int x, int y, int previousValue, int value, i
         value = -999;
     }
 
+    // CE: Without animation the counter ends up showing `value`, which can
+    // be skipped if it's already displayed. Animation leaves the layer
+    // invalid, so the next update always redraws it.
+    InterfaceCounterLayer* layer = intface_find_counter_layer(x, y);
+    if (layer != NULL) {
+        bool animated = !insideInit && delay != 0;
+        if (!animated) {
+            if (layer->valid && layer->value == value && layer->offset == offset) {
+                return;
+            }
+
+            layer->valid = true;
+            layer->value = value;
+            layer->offset = offset;
+        } else {
+            layer->valid = false;
+        }
+    }
+
     unsigned char* numbers = numbersBuffer + offset;
     unsigned char* dest = interfaceBuffer + 640 * y;
 
@@ -2334,6 +2433,31 @@ static void intface_rotate_numbers(int x, int y, int previousValue, int value, i
     }
 }
 
+// CE: Forces every layer to be redrawn on next update, used when interface
+// bar background is redrawn.
+static void intface_invalidate_layers()
+{
+    for (int index = 0; index < INTERFACE_COUNTER_LAYER_COUNT; index++) {
+        intface_counter_layers[index].valid = false;
+    }
+
+    intface_move_points_layer.valid = false;
+    intface_ammo_layer.valid = false;
+    intface_item_layer.valid = false;
+}
+
+static InterfaceCounterLayer* intface_find_counter_layer(int x, int y)
+{
+    for (int index = 0; index < INTERFACE_COUNTER_LAYER_COUNT; index++) {
+        InterfaceCounterLayer* layer = &(intface_counter_layers[index]);
+        if (layer->x == x && layer->y == y) {
+            return layer;
+        }
+    }
+
+    return NULL;
+}
+
 // 0x4566E8
 static int intface_fatal_error(int rc)
 {
@@ -1,5 +1,6 @@
 #include "game/item.h"
 
+#include <stdint.h>
 #include <stdio.h>
 #include <string.h>
 
@@ -22,6 +23,7 @@
 #include "game/roll.h"
 #include "game/skill.h"
 #include "game/stat.h"
+#include "game/statever.h"
 #include "game/tile.h"
 #include "game/trait.h"
 #include "platform_compat.h"
@@ -30,6 +32,30 @@
 
 namespace fallout {
 
+// CE: Number of slots in `item_totals` (power of 2).
+#define ITEM_TOTALS_CACHE_SIZE 256
+
+#define ITEM_TOTALS_WEIGHT 0x01
+#define ITEM_TOTALS_COST 0x02
+#define ITEM_TOTALS_SIZE 0x04
+
+// CE: Memoized sums over contents of an inventory (nested containers
+// included). Hands and armor of critters are not part of these sums, they
+// depend on inventory screen state and are added on every call.
+typedef struct ItemTotalsEntry {
+    Object* obj;
+    unsigned int generation;
+    int flags;
+    int weight;
+    int cost;
+    int size;
+} ItemTotalsEntry;
+
+static ItemTotalsEntry* item_totals_lookup(Object* obj, int flag);
+static bool item_totals_entry_valid(ItemTotalsEntry* entry);
+static int item_list_weight(Object* obj);
+static int item_list_cost(Object* obj);
+static int item_list_size(Object* obj);
 static void item_compact(int inventoryItemIndex, Inventory* inventory);
 static int item_move_func(Object* a1, Object* a2, Object* a3, int quantity, bool a5);
 static bool item_identical(Object* a1, Object* a2);
@@ -43,6 +69,16 @@ static void perform_withdrawal_start(Object* obj, int perk, int a3);
 static void perform_withdrawal_end(Object* obj, int a2);
 static int pid_to_gvar(int drugPid);
 
+// CE: Direct-mapped cache of inventory sums, allocated on first use.
+static ItemTotalsEntry* item_totals = NULL;
+
+// CE: Bumped on every change which can affect inventory sums, invalidates
+// the whole `item_totals` at once.
+static unsigned int item_totals_generation = 1;
+
+// CE: Disables `item_totals` while `item_check_totals` recomputes sums.
+static bool item_totals_bypass = false;
+
 // Maps weapon extended flags to skill.
 //
 // 0x505738
@@ -152,6 +188,12 @@ int item_reset()
 int item_exit()
 {
     message_exit(&item_message_file);
+
+    if (item_totals != NULL) {
+        mem_free(item_totals);
+        item_totals = NULL;
+    }
+
     return 0;
 }
 
@@ -235,6 +277,9 @@ int item_add_force(Object* owner, Object* itemToAdd, int quantity)
         return -1;
     }
 
+    statever_bump(STATE_VERSION_INVENTORY);
+    item_totals_invalidate();
+
     Inventory* inventory = &(owner->data.inventory);
 
     int index;
@@ -308,6 +353,9 @@ int item_add_force(Object* owner, Object* itemToAdd, int quantity)
 // 0x469FB8
 int item_remove_mult(Object* owner, Object* itemToRemove, int quantity)
 {
+    statever_bump(STATE_VERSION_INVENTORY);
+    item_totals_invalidate();
+
     Inventory* inventory = &(owner->data.inventory);
     Object* item1 = inven_left_hand(owner);
     Object* item2 = inven_right_hand(owner);
@@ -704,6 +752,39 @@ int item_total_cost(Object* obj)
         return 0;
     }
 
+    int cost;
+
+    // CE: Sum of inventory contents is memoized.
+    ItemTotalsEntry* entry = item_totals_lookup(obj, ITEM_TOTALS_COST);
+    if (entry != NULL) {
+        cost = entry->cost;
+    } else {
+        cost = item_list_cost(obj);
+    }
+
+    if (FID_TYPE(obj->fid) == OBJ_TYPE_CRITTER) {
+        Object* item2 = inven_right_hand(obj);
+        if (item2 != NULL && (item2->flags & OBJECT_IN_RIGHT_HAND) == 0) {
+            cost += item_cost(item2);
+        }
+
+        Object* item1 = inven_left_hand(obj);
+        if (item1 != NULL && (item1->flags & OBJECT_IN_LEFT_HAND) == 0) {
+            cost += item_cost(item1);
+        }
+
+        Object* armor = inven_worn(obj);
+        if (armor != NULL && (armor->flags & OBJECT_WORN) == 0) {
+            cost += item_cost(armor);
+        }
+    }
+
+    return cost;
+}
+
+// CE: Cost of inventory contents, extracted from `item_total_cost`.
+static int item_list_cost(Object* obj)
+{
     int cost = 0;
 
     Inventory* inventory = &(obj->data.inventory);
@@ -730,23 +811,6 @@ int item_total_cost(Object* obj)
         }
     }
 
-    if (FID_TYPE(obj->fid) == OBJ_TYPE_CRITTER) {
-        Object* item2 = inven_right_hand(obj);
-        if (item2 != NULL && (item2->flags & OBJECT_IN_RIGHT_HAND) == 0) {
-            cost += item_cost(item2);
-        }
-
-        Object* item1 = inven_left_hand(obj);
-        if (item1 != NULL && (item1->flags & OBJECT_IN_LEFT_HAND) == 0) {
-            cost += item_cost(item1);
-        }
-
-        Object* armor = inven_worn(obj);
-        if (armor != NULL && (armor->flags & OBJECT_WORN) == 0) {
-            cost += item_cost(armor);
-        }
-    }
-
     return cost;
 }
 
@@ -757,13 +821,14 @@ int item_total_weight(Object* obj)
         return 0;
     }
 
-    int weight = 0;
+    int weight;
 
-    Inventory* inventory = &(obj->data.inventory);
-    for (int index = 0; index < inventory->length; index++) {
-        InventoryItem* inventoryItem = &(inventory->items[index]);
-        Object* item = inventoryItem->item;
-        weight += item_weight(item) * inventoryItem->quantity;
+    // CE: Sum of inventory contents is memoized.
+    ItemTotalsEntry* entry = item_totals_lookup(obj, ITEM_TOTALS_WEIGHT);
+    if (entry != NULL) {
+        weight = entry->weight;
+    } else {
+        weight = item_list_weight(obj);
     }
 
     if (FID_TYPE(obj->fid) == OBJ_TYPE_CRITTER) {
@@ -792,6 +857,150 @@ int item_total_weight(Object* obj)
     return weight;
 }
 
+// CE: Weight of inventory contents, extracted from `item_total_weight`.
+static int item_list_weight(Object* obj)
+{
+    int weight = 0;
+
+    Inventory* inventory = &(obj->data.inventory);
+    for (int index = 0; index < inventory->length; index++) {
+        InventoryItem* inventoryItem = &(inventory->items[index]);
+        Object* item = inventoryItem->item;
+        weight += item_weight(item) * inventoryItem->quantity;
+    }
+
+    return weight;
+}
+
+// CE: Returns cache entry of `obj` holding sum denoted by `flag`, or NULL
+// if the sum is not available and has to be computed by the caller. Misses
+// are filled in here.
+static ItemTotalsEntry* item_totals_lookup(Object* obj, int flag)
+{
+    if (item_totals_bypass) {
+        return NULL;
+    }
+
+    if (item_totals == NULL) {
+        item_totals = (ItemTotalsEntry*)mem_malloc(sizeof(*item_totals) * ITEM_TOTALS_CACHE_SIZE);
+        if (item_totals == NULL) {
+            return NULL;
+        }
+
+        memset(item_totals, 0, sizeof(*item_totals) * ITEM_TOTALS_CACHE_SIZE);
+    }
+
+    uintptr_t hash = (uintptr_t)obj;
+    hash ^= hash >> 9;
+    ItemTotalsEntry* entry = &(item_totals[hash & (ITEM_TOTALS_CACHE_SIZE - 1)]);
+
+    if (entry->obj != obj || entry->generation != item_totals_generation) {
+        entry->obj = obj;
+        entry->generation = item_totals_generation;
+        entry->flags = 0;
+    }
+
+    if ((entry->flags & flag) != 0) {
+#ifdef _DEBUG
+        if (!item_totals_entry_valid(entry)) {
+            debug_printf("item_totals: stale sums of object %d (pid %d)\n", obj->id, obj->pid);
+        }
+#endif
+        return entry;
+    }
+
+    // Computing sum can visit nested containers which might evict `entry`
+    // (or bump generation), so store result only if it's still ours.
+    unsigned int generation = item_totals_generation;
+    int value;
+    switch (flag) {
+    case ITEM_TOTALS_WEIGHT:
+        value = item_list_weight(obj);
+        break;
+    case ITEM_TOTALS_COST:
+        value = item_list_cost(obj);
+        break;
+    default:
+        value = item_list_size(obj);
+        break;
+    }
+
+    if (entry->obj != obj || entry->generation != generation) {
+        entry->obj = obj;
+        entry->generation = generation;
+        entry->flags = 0;
+    }
+
+    switch (flag) {
+    case ITEM_TOTALS_WEIGHT:
+        entry->weight = value;
+        break;
+    case ITEM_TOTALS_COST:
+        entry->cost = value;
+        break;
+    default:
+        entry->size = value;
+        break;
+    }
+
+    entry->flags |= flag;
+
+    return entry;
+}
+
+// CE: Compares memoized sums of `entry` against freshly computed ones.
+static bool item_totals_entry_valid(ItemTotalsEntry* entry)
+{
+    item_totals_bypass = true;
+
+    bool valid = true;
+    if ((entry->flags & ITEM_TOTALS_WEIGHT) != 0 && entry->weight != item_list_weight(entry->obj)) {
+        valid = false;
+    }
+
+    if ((entry->flags & ITEM_TOTALS_COST) != 0 && entry->cost != item_list_cost(entry->obj)) {
+        valid = false;
+    }
+
+    if ((entry->flags & ITEM_TOTALS_SIZE) != 0 && entry->size != item_list_size(entry->obj)) {
+        valid = false;
+    }
+
+    item_totals_bypass = false;
+
+    return valid;
+}
+
+// CE: Must be called after any change affecting weight, cost or size of
+// inventory contents (items added or removed, quantities, loaded ammo,
+// objects created or destroyed).
+void item_totals_invalidate()
+{
+    item_totals_generation++;
+    if (item_totals_generation == 0) {
+        item_totals_generation = 1;
+    }
+}
+
+// CE: Consistency check of memoized inventory sums of `obj` (only sums
+// already in cache are checked). Returns false if any of them is stale,
+// which means some inventory change misses `item_totals_invalidate`.
+bool item_check_totals(Object* obj)
+{
+    if (obj == NULL || item_totals == NULL) {
+        return true;
+    }
+
+    uintptr_t hash = (uintptr_t)obj;
+    hash ^= hash >> 9;
+    ItemTotalsEntry* entry = &(item_totals[hash & (ITEM_TOTALS_CACHE_SIZE - 1)]);
+    if (entry->obj != obj || entry->generation != item_totals_generation) {
+        return true;
+    }
+
+    return item_totals_entry_valid(entry);
+}
+
 // 0x46A7C4
 bool item_grey(Object* weapon)
 {
@@ -1222,6 +1431,9 @@ void item_w_set_curr_ammo(Object* ammoOrWeapon, int quantity)
     } else {
         ammoOrWeapon->data.item.weapon.ammoQuantity = quantity;
     }
+
+    // CE: Loaded ammo is part of weight and cost.
+    item_totals_invalidate();
 }
 
 // 0x46AF2C
@@ -1959,6 +2171,9 @@ int item_m_turn_on(Object* item)
         item->pid = PROTO_ID_GEIGER_COUNTER_II;
     }
 
+    // CE: Weight and cost come from proto.
+    item_totals_invalidate();
+
     if (critter == obj_dude) {
         // %s is on.
         messageListItem.num = 6;
@@ -2001,6 +2216,8 @@ int item_m_turn_off(Object* item)
         item->pid = PROTO_ID_GEIGER_COUNTER_I;
     }
 
+    item_totals_invalidate();
+
     if (owner == obj_dude) {
         intface_update_items(false);
     }
@@ -2089,6 +2306,17 @@ int item_c_curr_size(Object* container)
         return 0;
     }
 
+    // CE: Memoized.
+    ItemTotalsEntry* entry = item_totals_lookup(container, ITEM_TOTALS_SIZE);
+    if (entry != NULL) {
+        return entry->size;
+    }
+
+    return item_list_size(container);
+}
+
+static int item_list_size(Object* container)
+{
     int totalSize = 0;
 
     Inventory* inventory = &(container->data.inventory);
@@ -2622,6 +2850,8 @@ int item_caps_adjust(Object* obj, int amount)
     }
 
     if (amount <= 0 || caps != 0) {
+        item_totals_invalidate();
+
         Inventory* inventory = &(obj->data.inventory);
 
         for (int index = 0; index < inventory->length && amount != 0; index++) {
@@ -38,6 +38,8 @@ int item_weight(Object* item);
 int item_cost(Object* obj);
 int item_total_cost(Object* obj);
 int item_total_weight(Object* obj);
+void item_totals_invalidate();
+bool item_check_totals(Object* obj);
 bool item_grey(Object* item_obj);
 int item_inv_fid(Object* obj);
 Object* item_hit_with(Object* critter, int hit_mode);
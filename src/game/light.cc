@@ -57,9 +57,12 @@ void light_set_ambient(int new_ambient_light, bool refresh_screen)
     old_ambient_light = ambient_light;
     ambient_light = normalized;
 
-    if (refresh_screen) {
-        if (old_ambient_light != normalized) {
+    if (old_ambient_light != normalized) {
+        if (refresh_screen) {
             tile_refresh_display();
+        } else {
+            // CE: Screen is now lit with previous ambient light.
+            tile_invalidate_display();
         }
     }
 }
@@ -123,6 +126,9 @@ void light_set_tile(int elevation, int tile, int lightIntensity)
     }
 
     tile_intensity[elevation][tile] = lightIntensity;
+
+    // CE: Floor chunks lit by this tile are outdated.
+    floor_cache_invalidate_tile(elevation, tile);
 }
 
 // 0x46CB78
@@ -137,6 +143,9 @@ void light_add_to_tile(int elevation, int tile, int lightIntensity)
     }
 
     tile_intensity[elevation][tile] += lightIntensity;
+
+    // CE: Floor chunks lit by this tile are outdated.
+    floor_cache_invalidate_tile(elevation, tile);
 }
 
 // 0x46CBB0
@@ -151,6 +160,9 @@ void light_subtract_from_tile(int elevation, int tile, int lightIntensity)
     }
 
     tile_intensity[elevation][tile] -= lightIntensity;
+
+    // CE: Floor chunks lit by this tile are outdated.
+    floor_cache_invalidate_tile(elevation, tile);
 }
 
 // 0x46CBEC
@@ -164,6 +176,9 @@ void light_reset_tiles()
             tile_intensity[elevation][tile] = 655;
         }
     }
+
+    // CE: Floor chunks are lit with previous intensities.
+    floor_cache_invalidate();
 }
 
 } // namespace fallout
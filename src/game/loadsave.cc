@@ -6,6 +6,12 @@
 #include <time.h>
 
 #include <algorithm>
+#include <chrono>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <SDL.h>
 
 #include "game/automap.h"
 #include "game/bmpdlog.h"
@@ -33,6 +39,7 @@
 #include "game/scripts.h"
 #include "game/skill.h"
 #include "game/stat.h"
+#include "game/statever.h"
 #include "game/tile.h"
 #include "game/trait.h"
 #include "game/version.h"
@@ -46,6 +53,7 @@
 #include "plib/gnw/grbuf.h"
 #include "plib/gnw/input.h"
 #include "plib/gnw/memory.h"
+#include "plib/gnw/prof.h"
 #include "plib/gnw/svga.h"
 #include "plib/gnw/text.h"
 
@@ -64,6 +72,12 @@ namespace fallout {
 #define LS_PREVIEW_HEIGHT 133
 #define LS_PREVIEW_SIZE ((LS_PREVIEW_WIDTH) * (LS_PREVIEW_HEIGHT))
 
+// CE: Size of header written by `SaveHeader` (including thumbnail).
+#define LS_HEADER_SIZE (131 + (LS_PREVIEW_SIZE) + 128)
+
+#define LS_INDEX_MAGIC 0x5849534C // "LSIX"
+#define LS_INDEX_VERSION 1
+
 #define LS_COMMENT_WINDOW_X 169
 #define LS_COMMENT_WINDOW_Y 116
 
@@ -130,6 +144,49 @@ typedef enum LoadSaveFrm {
 static int QuickSnapShot();
 static int LSGameStart(int windowType);
 static int LSGameEnd(int windowType);
+// CE: Header of slot kept in slot index (see `GetSlotList`).
+typedef struct LoadSaveIndexEntry {
+    // Size and modification time of slot file header belongs to.
+    long long size;
+    long long mtime;
+
+    // Bytes written by `SaveHeader` (empty - slot is not indexed).
+    std::vector<unsigned char> header;
+} LoadSaveIndexEntry;
+
+// CE: File of slot written by background save.
+typedef struct LoadSaveAsyncFile {
+    std::string name;
+    std::vector<unsigned char> data;
+
+    // File is unchanged since slot was written and is linked (or copied)
+    // from existing slot directory instead of [data].
+    bool linked;
+} LoadSaveAsyncFile;
+
+// CE: Serialized slot handed to background save thread.
+typedef struct LoadSaveAsyncJob {
+    int slot;
+    std::vector<LoadSaveAsyncFile> files;
+    std::unordered_map<std::string, unsigned int> versions;
+    SDL_Thread* thread;
+    SDL_atomic_t done;
+
+    // Files are written into single container (see `db_pack_write`).
+    bool packed;
+
+    // Files are collected for in-memory snapshot and are never linked from
+    // slot directory.
+    bool snapshot;
+    int result;
+} LoadSaveAsyncJob;
+
+// CE: Files of slot (`SAVE.DAT`, map states and automap) kept in memory.
+typedef struct LoadSaveSnapshot {
+    std::vector<LoadSaveAsyncFile> files;
+    size_t size;
+} LoadSaveSnapshot;
+
 static int SaveSlot();
 static int LoadSlot(int slot);
 static void GetTimeDate(short* day, short* month, short* year, int* hour);
@@ -148,11 +205,34 @@ static int GameMap2Slot(DB_FILE* stream);
 static int SlotMap2Game(DB_FILE* stream);
 static int mygets(char* dest, DB_FILE* stream);
 static int copy_file(const char* a1, const char* a2);
+static int copy_file_native(const char* a1, const char* a2);
+static int copy_stream(DB_FILE* stream1, const char* a2);
 static int SaveBackup();
 static int RestoreSave();
 static int LoadObjDudeCid(DB_FILE* stream);
 static int SaveObjDudeCid(DB_FILE* stream);
 static int EraseSave();
+static int SaveSlotAsync();
+static int AddAsyncFile(const char* name, const char* path);
+static int StartAsyncSave(LoadSaveAsyncJob* job);
+static int AsyncSaveThread(void* data);
+static int WriteAsyncJob(LoadSaveAsyncJob* job);
+static void FinishAsyncSave();
+static void EraseSlotDir(const char* relativePath);
+static std::string SlotFileKey(const char* name);
+static bool IsSlotFileUnchanged(const char* name);
+static int LinkSlotBackup(const char* name);
+static int AddAsyncLink(const char* name);
+static bool IsSlotPacked(int slot);
+static DB_FILE* OpenSlotFile(int slot, const char* name);
+static int CopySlotFile(const char* name, const char* a2);
+static int SaveSlotHeader(int slot);
+static int StatSlot(int slot, long long* sizePtr, long long* mtimePtr);
+static bool IsSlotIndexed(int slot, long long size, long long mtime);
+static void ReadSlotIndex();
+static int WriteSlotIndex();
+static void CommitSlotIndex(int slot);
+static const LoadSaveAsyncFile* FindSnapshotFile(const LoadSaveSnapshot* snapshot, const char* name);
 
 // 0x46D930
 static const int lsgrphs[LOAD_SAVE_FRM_COUNT] = {
@@ -317,6 +397,47 @@ static int fontsave;
 // 0x612D8C
 static CacheEntry* grphkey[LOAD_SAVE_FRM_COUNT];
 
+// CE: Background saves (see `SaveSlotAsync`).
+static bool ls_async_enabled = false;
+
+// Job being serialized by main thread.
+static LoadSaveAsyncJob* ls_async_collect = NULL;
+
+// Job being written by background thread.
+static LoadSaveAsyncJob* ls_async_running = NULL;
+
+static LoadSaveAsyncProc* ls_async_proc = NULL;
+static void* ls_async_user_data = NULL;
+
+// Slot and result of last finished background save.
+static int ls_async_last_slot = -1;
+static int ls_async_last_result = 0;
+
+// CE: Headers of slots read from (and written to) `SAVEGAME\SLOTS.IDX`, so
+// that slot list does not have to open every slot. Index is read once and
+// kept in memory along with thumbnails.
+static LoadSaveIndexEntry ls_index[10];
+static bool ls_index_loaded = false;
+
+// CE: Snapshot being restored by `agentLoadSaveRestore`, files of slot are
+// taken from it.
+static const LoadSaveSnapshot* ls_restore_snapshot = NULL;
+
+static LoadSaveSnapshotStats ls_snapshot_stats;
+
+// CE: Slots are saved as single container file (`SAVE.PAK`) instead of
+// directory of files.
+static bool ls_pack_enabled = false;
+
+// CE: Versions of map states (see `map_state_version`) written to every
+// slot during this session. Maps which are unchanged since then are linked
+// from previous slot contents instead of being copied again.
+static std::unordered_map<std::string, unsigned int> ls_slot_versions[10];
+
+// Versions of map states collected by `GameMap2Slot` which become slot
+// versions once save succeeds.
+static std::unordered_map<std::string, unsigned int> ls_pending_versions;
+
 // 0x46D954
 void InitLoadSave()
 {
@@ -328,12 +449,29 @@ void InitLoadSave()
         patches = emgpath;
     }
 
+    int asyncSave;
+    if (config_get_value(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_ASYNC_SAVE_KEY, &asyncSave)) {
+        ls_async_enabled = asyncSave != 0;
+    } else {
+        ls_async_enabled = false;
+    }
+
+    int saveContainer;
+    if (config_get_value(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_SAVE_CONTAINER_KEY, &saveContainer)) {
+        ls_pack_enabled = saveContainer != 0;
+    } else {
+        ls_pack_enabled = false;
+    }
+
+    map_store_clear();
     MapDirErase("MAPS\\", "SAV");
 }
 
 // 0x46D9B0
 void ResetLoadSave()
 {
+    LoadSaveWaitAsync();
+    map_store_clear();
     MapDirErase("MAPS\\", "SAV");
 }
 
@@ -344,16 +482,17 @@ int SaveGame(int mode)
 
     ls_error_code = 0;
 
+    // CE: Slot list reads headers of slots which might still be written in
+    // background.
+    LoadSaveWaitAsync();
+
     if (!config_get_string(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_MASTER_PATCHES_KEY, &patches)) {
         debug_printf("\nLOADSAVE: Error reading patches config variable! Using default.\n");
         patches = emgpath;
     }
 
     if (mode == LOAD_SAVE_MODE_QUICK && quick_done) {
-        snprintf(gmpath, sizeof(gmpath), "%s\\%s%.2d\\", "SAVEGAME", "SLOT", slot_cursor + 1);
-        strcat(gmpath, "SAVE.DAT");
-
-        flptr = db_fopen(gmpath, "rb");
+        flptr = OpenSlotFile(slot_cursor, "SAVE.DAT");
         if (flptr != NULL) {
             LoadHeader(slot_cursor);
             db_fclose(flptr);
@@ -857,6 +996,10 @@ int LoadGame(int mode)
 
     ls_error_code = 0;
 
+    // CE: Slot list reads headers of slots which might still be written in
+    // background.
+    LoadSaveWaitAsync();
+
     if (!config_get_string(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_MASTER_PATCHES_KEY, &patches)) {
         debug_printf("\nLOADSAVE: Error reading patches config variable! Using default.\n");
         patches = emgpath;
@@ -1527,6 +1670,13 @@ static int LSGameEnd(int windowType)
 // 0x46F978
 static int SaveSlot()
 {
+    // CE: Serialize into memory and write slot in background. Containers
+    // are assembled the same way (written on main thread unless background
+    // saves are enabled).
+    if (ls_async_enabled || ls_pack_enabled) {
+        return SaveSlotAsync();
+    }
+
     ls_error_code = 0;
     map_backup_count = -1;
     gmouse_set_cursor(MOUSE_CURSOR_WAIT_PLANET);
@@ -1554,19 +1704,23 @@ static int SaveSlot()
         RestoreSave();
         snprintf(gmpath, sizeof(gmpath), "%s\\%s%.2d\\", "SAVEGAME", "SLOT", slot_cursor + 1);
         MapDirErase(gmpath, "BAK");
+        ls_slot_versions[slot_cursor].clear();
+        ls_index[slot_cursor].header.clear();
         partyMemberUnPrepSave();
         gsound_background_unpause();
         return -1;
     }
 
     long pos = db_ftell(flptr);
-    if (SaveHeader(slot_cursor) == -1) {
+    if (SaveSlotHeader(slot_cursor) == -1) {
         debug_printf("\nLOADSAVE: ** Error writing save game header! **\n");
         debug_printf("LOADSAVE: Save file header size written: %d bytes.\n", db_ftell(flptr) - pos);
         db_fclose(flptr);
         RestoreSave();
         snprintf(gmpath, sizeof(gmpath), "%s\\%s%.2d\\", "SAVEGAME", "SLOT", slot_cursor + 1);
         MapDirErase(gmpath, "BAK");
+        ls_slot_versions[slot_cursor].clear();
+        ls_index[slot_cursor].header.clear();
         partyMemberUnPrepSave();
         gsound_background_unpause();
         return -1;
@@ -1581,6 +1735,8 @@ static int SaveSlot()
             RestoreSave();
             snprintf(gmpath, sizeof(gmpath), "%s\\%s%.2d\\", "SAVEGAME", "SLOT", slot_cursor + 1);
             MapDirErase(gmpath, "BAK");
+            ls_slot_versions[slot_cursor].clear();
+            ls_index[slot_cursor].header.clear();
             partyMemberUnPrepSave();
             gsound_background_unpause();
             return -1;
@@ -1596,6 +1752,15 @@ static int SaveSlot()
     snprintf(gmpath, sizeof(gmpath), "%s\\%s%.2d\\", "SAVEGAME", "SLOT", slot_cursor + 1);
     MapDirErase(gmpath, "BAK");
 
+    // CE: Container takes precedence over files, remove container slot was
+    // saved to previously.
+    MapDirErase(gmpath, "PAK");
+
+    CommitSlotIndex(slot_cursor);
+
+    ls_slot_versions[slot_cursor] = std::move(ls_pending_versions);
+    ls_pending_versions.clear();
+
     lsgmesg.num = 140;
     if (message_search(&lsgame_msgfl, &lsgmesg)) {
         display_print(lsgmesg.text);
@@ -1723,248 +1888,1192 @@ int agentLoadSaveLoadSlotFromLoadScreen(int slot)
     return 0;
 }
 
-// 0x46FCCC
-static int LoadSlot(int slot)
+// Reports state of background save: returns `true` while it is running.
+// Slot and result of last finished save are stored in [slotPtr] and
+// [resultPtr] (-1 slot if none has finished yet).
+bool agentLoadSaveGetAsyncStatus(int* slotPtr, int* resultPtr)
 {
-    gmouse_set_cursor(MOUSE_CURSOR_WAIT_PLANET);
+    if (slotPtr != NULL) {
+        *slotPtr = ls_async_last_slot;
+    }
 
-    if (isInCombat()) {
-        intface_end_window_close(false);
-        combat_over_from_load();
-        gmouse_set_cursor(MOUSE_CURSOR_WAIT_PLANET);
+    if (resultPtr != NULL) {
+        *resultPtr = ls_async_last_result;
     }
 
-    loadingGame = 1;
+    return ls_async_running != NULL;
+}
 
-    snprintf(gmpath, sizeof(gmpath), "%s\\%s%.2d\\", "SAVEGAME", "SLOT", slot_cursor + 1);
-    strcat(gmpath, "SAVE.DAT");
+// CE: Captures game state (everything saved to slot) in memory. Header
+// data of current slot is left intact. Returns `NULL` on failure.
+LoadSaveSnapshot* agentLoadSaveSnapshot()
+{
+    auto start = std::chrono::steady_clock::now();
 
-    LoadSaveSlotData* ptr = &(LSData[slot]);
-    debug_printf("\nLOADSAVE: Load name: %s\n", ptr->description);
+    LoadSaveWaitAsync();
 
-    flptr = db_fopen(gmpath, "rb");
-    if (flptr == NULL) {
-        debug_printf("\nLOADSAVE: ** Error opening load game file for reading! **\n");
-        loadingGame = 0;
-        return -1;
+    if (!config_get_string(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_MASTER_PATCHES_KEY, &patches)) {
+        patches = emgpath;
     }
 
-    long pos = db_ftell(flptr);
-    if (LoadHeader(slot) == -1) {
-        debug_printf("\nLOADSAVE: ** Error reading save  game header! **\n");
-        db_fclose(flptr);
-        game_reset();
-        loadingGame = 0;
-        return -1;
-    }
+    LoadSaveAsyncJob job;
+    job.slot = slot_cursor;
+    job.thread = NULL;
+    job.result = -1;
+    job.packed = false;
+    job.snapshot = true;
+    SDL_AtomicSet(&(job.done), 0);
 
-    debug_printf("LOADSAVE: Load file header size read: %d bytes.\n", db_ftell(flptr) - pos);
+    // Header is written for current slot, keep what slot list shows.
+    LoadSaveSlotData slotData = LSData[slot_cursor];
+    std::vector<unsigned char> thumbnail(LS_PREVIEW_SIZE, 0);
+    unsigned char* thumbnailImage = thumbnail_image[1];
+    thumbnail_image[1] = thumbnail.data();
 
-    for (int index = 0; index < LOAD_SAVE_HANDLER_COUNT; index += 1) {
-        long pos = db_ftell(flptr);
-        LoadGameHandler* handler = master_load_list[index];
-        if (handler(flptr) == -1) {
-            debug_printf("\nLOADSAVE: ** Error reading load function #%d data! **\n", index);
-            int v12 = db_ftell(flptr);
-            debug_printf("LOADSAVE: Load function #%d data size read: %d bytes.\n", index, db_ftell(flptr) - pos);
-            db_fclose(flptr);
-            game_reset();
-            loadingGame = 0;
-            return -1;
-        }
+    ls_async_collect = &job;
 
-        debug_printf("LOADSAVE: Load function #%d data size read: %d bytes.\n", index, db_ftell(flptr) - pos);
-    }
+    int rc = -1;
+    flptr = db_fopen_memory_write();
+    if (flptr != NULL) {
+        rc = SaveHeader(slot_cursor);
+
+        for (int index = 0; index < LOAD_SAVE_HANDLER_COUNT && rc == 0; index++) {
+            SaveGameHandler* handler = master_save_list[index];
+            if (handler(flptr) == -1) {
+                debug_printf("\nLOADSAVE: ** Error writing snapshot function #%d data! **\n", index);
+                rc = -1;
+            }
+        }
 
-    debug_printf("LOADSAVE: Total load data read: %ld bytes.\n", db_ftell(flptr));
-    db_fclose(flptr);
+        size_t size;
+        unsigned char* data = db_fclose_memory(flptr, &size);
+        flptr = NULL;
 
-    snprintf(str, sizeof(str), "%s\\", "MAPS");
-    MapDirErase(str, "BAK");
-    proto_dude_update_gender();
+        if (rc == 0 && data != NULL) {
+            job.files.emplace_back();
+            job.files.back().name = "SAVE.DAT";
+            job.files.back().data.assign(data, data + size);
+            job.files.back().linked = false;
+        } else {
+            rc = -1;
+        }
 
-    // Game Loaded.
-    lsgmesg.num = 141;
-    if (message_search(&lsgame_msgfl, &lsgmesg) == 1) {
-        display_print(lsgmesg.text);
-    } else {
-        debug_printf("\nError: Couldn't find LoadSave Message!");
+        db_free_memory(data);
     }
 
-    loadingGame = 0;
+    ls_async_collect = NULL;
+    ls_pending_versions.clear();
 
-    return 0;
-}
+    thumbnail_image[1] = thumbnailImage;
+    LSData[slot_cursor] = slotData;
 
-// 0x46FF38
-static void GetTimeDate(short* day, short* month, short* year, int* hour)
-{
-    time_t now;
-    struct tm* local;
+    if (rc == -1) {
+        partyMemberUnPrepSave();
+        return NULL;
+    }
 
-    now = time(NULL);
-    local = localtime(&now);
+    LoadSaveSnapshot* snapshot = new LoadSaveSnapshot();
+    snapshot->files = std::move(job.files);
+    snapshot->size = 0;
+    for (LoadSaveAsyncFile& file : snapshot->files) {
+        snapshot->size += file.data.size();
+    }
 
-    *day = local->tm_mday;
-    *month = local->tm_mon + 1;
-    *year = local->tm_year + 1900;
-    *hour = local->tm_hour + local->tm_min;
+    ls_snapshot_stats.snapshots++;
+    ls_snapshot_stats.lastSnapshotSize = snapshot->size;
+    ls_snapshot_stats.lastSnapshotTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    return snapshot;
 }
 
-// 0x46FF80
-static int SaveHeader(int slot)
+// CE: Replaces game state with snapshot taken by `agentLoadSaveSnapshot`.
+// Handlers are run the same way `LoadSlot` does, but without load screen
+// and with files taken from memory. Returns 0 on success.
+int agentLoadSaveRestore(const LoadSaveSnapshot* snapshot)
 {
-    ls_error_code = 4;
-
-    LoadSaveSlotData* ptr = &(LSData[slot]);
-    strncpy(ptr->signature, LOAD_SAVE_SIGNATURE, 24);
+    if (snapshot == NULL) {
+        return -1;
+    }
 
-    if (db_fwrite(ptr->signature, 1, 24, flptr) == -1) {
+    const LoadSaveAsyncFile* saveFile = FindSnapshotFile(snapshot, "SAVE.DAT");
+    if (saveFile == NULL) {
         return -1;
     }
 
-    short temp[3];
-    temp[0] = VERSION_MAJOR;
-    temp[1] = VERSION_MINOR;
+    auto start = std::chrono::steady_clock::now();
 
-    ptr->versionMinor = temp[0];
-    ptr->versionMajor = temp[1];
+    LoadSaveWaitAsync();
 
-    if (db_fwriteInt16List(flptr, temp, 2) == -1) {
-        return -1;
+    if (!config_get_string(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_MASTER_PATCHES_KEY, &patches)) {
+        patches = emgpath;
     }
 
-    ptr->versionRelease = VERSION_RELEASE;
-    if (db_fwriteByte(flptr, VERSION_RELEASE) == -1) {
-        return -1;
+    if (isInCombat()) {
+        intface_end_window_close(false);
+        combat_over_from_load();
     }
 
-    char* characterName = critter_name(obj_dude);
-    strncpy(ptr->characterName, characterName, 32);
+    loadingGame = 1;
+    ls_restore_snapshot = snapshot;
 
-    if (db_fwrite(ptr->characterName, 32, 1, flptr) != 1) {
-        return -1;
+    int rc = -1;
+    flptr = db_fopen_memory(saveFile->data.data(), saveFile->data.size());
+    if (flptr != NULL) {
+        rc = LoadHeader(slot_cursor);
+
+        for (int index = 0; index < LOAD_SAVE_HANDLER_COUNT && rc == 0; index++) {
+            LoadGameHandler* handler = master_load_list[index];
+            if (handler(flptr) == -1) {
+                debug_printf("\nLOADSAVE: ** Error reading snapshot function #%d data! **\n", index);
+                rc = -1;
+            }
+        }
+
+        db_fclose(flptr);
+        flptr = NULL;
     }
 
-    if (db_fwrite(ptr->description, 30, 1, flptr) != 1) {
+    ls_restore_snapshot = NULL;
+
+    if (rc == -1) {
+        game_reset();
+        loadingGame = 0;
         return -1;
     }
 
-    // NOTE: Uninline.
-    int file_time;
-    GetTimeDate(&(temp[0]), &(temp[1]), &(temp[2]), &file_time);
+    snprintf(str, sizeof(str), "%s\\", "MAPS");
+    MapDirErase(str, "BAK");
+    proto_dude_update_gender();
 
-    ptr->fileDay = temp[0];
-    ptr->fileMonth = temp[1];
-    ptr->fileYear = temp[2];
-    ptr->fileTime = file_time;
+    loadingGame = 0;
 
-    if (db_fwriteInt16List(flptr, temp, 3) == -1) {
-        return -1;
-    }
+    ls_snapshot_stats.restores++;
+    ls_snapshot_stats.lastRestoreTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
 
-    if (db_fwriteInt32(flptr, ptr->fileTime) == -1) {
-        return -1;
-    }
+    return 0;
+}
 
-    int month;
-    int day;
-    int year;
-    game_time_date(&month, &day, &year);
+void agentLoadSaveFreeSnapshot(LoadSaveSnapshot* snapshot)
+{
+    delete snapshot;
+}
 
-    temp[0] = month;
-    temp[1] = day;
-    temp[2] = year;
-    ptr->gameTime = game_time();
+size_t agentLoadSaveGetSnapshotSize(const LoadSaveSnapshot* snapshot)
+{
+    return snapshot != NULL ? snapshot->size : 0;
+}
 
-    if (db_fwriteInt16List(flptr, temp, 3) == -1) {
-        return -1;
+void agentLoadSaveGetSnapshotStats(LoadSaveSnapshotStats* stats)
+{
+    if (stats != NULL) {
+        *stats = ls_snapshot_stats;
     }
+}
 
-    if (db_fwriteInt32(flptr, ptr->gameTime) == -1) {
-        return -1;
+// CE: Serializes snapshot into buffer allocated with `mem_malloc` (every
+// file is stored as name length, name, data length and data). Buffer is only
+// meaningful to the same build of the game.
+unsigned char* agentLoadSaveSerializeSnapshot(const LoadSaveSnapshot* snapshot, size_t* sizePtr)
+{
+    *sizePtr = 0;
+
+    if (snapshot == NULL) {
+        return NULL;
     }
 
-    ptr->elevation = map_elevation;
-    if (db_fwriteShort(flptr, ptr->elevation) == -1) {
-        return -1;
+    size_t size = sizeof(unsigned int);
+    for (const LoadSaveAsyncFile& file : snapshot->files) {
+        size += sizeof(unsigned int) * 2 + file.name.size() + file.data.size();
     }
 
-    ptr->map = map_get_index_number();
-    if (db_fwriteShort(flptr, ptr->map) == -1) {
-        return -1;
+    unsigned char* data = (unsigned char*)mem_malloc(size);
+    if (data == NULL) {
+        return NULL;
     }
 
-    char mapName[128];
-    strcpy(mapName, map_data.name);
+    unsigned char* pos = data;
 
-    char* v1 = strmfe(str, mapName, "sav");
-    strncpy(ptr->fileName, v1, 16);
-    if (db_fwrite(ptr->fileName, 16, 1, flptr) != 1) {
-        return -1;
-    }
+    unsigned int count = (unsigned int)snapshot->files.size();
+    memcpy(pos, &count, sizeof(count));
+    pos += sizeof(count);
 
-    if (db_fwrite(thumbnail_image[1], LS_PREVIEW_SIZE, 1, flptr) != 1) {
-        return -1;
-    }
+    for (const LoadSaveAsyncFile& file : snapshot->files) {
+        unsigned int length = (unsigned int)file.name.size();
+        memcpy(pos, &length, sizeof(length));
+        pos += sizeof(length);
+        memcpy(pos, file.name.data(), length);
+        pos += length;
 
-    memset(mapName, 0, 128);
-    if (db_fwrite(mapName, 1, 128, flptr) != 128) {
-        return -1;
+        length = (unsigned int)file.data.size();
+        memcpy(pos, &length, sizeof(length));
+        pos += sizeof(length);
+        if (length != 0) {
+            memcpy(pos, file.data.data(), length);
+            pos += length;
+        }
     }
 
-    ls_error_code = 0;
-
-    return 0;
+    *sizePtr = size;
+    return data;
 }
 
-// 0x470350
-static int LoadHeader(int slot)
+LoadSaveSnapshot* agentLoadSaveDeserializeSnapshot(const unsigned char* data, size_t size)
 {
-    ls_error_code = 3;
+    if (data == NULL || size < sizeof(unsigned int)) {
+        return NULL;
+    }
 
-    LoadSaveSlotData* ptr = &(LSData[slot]);
+    const unsigned char* pos = data;
+    const unsigned char* end = data + size;
 
-    if (db_fread(ptr->signature, 1, 24, flptr) != 24) {
-        return -1;
-    }
+    unsigned int count;
+    memcpy(&count, pos, sizeof(count));
+    pos += sizeof(count);
 
-    if (strncmp(ptr->signature, LOAD_SAVE_SIGNATURE, 18) != 0) {
-        debug_printf("\nLOADSAVE: ** Invalid save file on load! **\n");
-        ls_error_code = 2;
-        return -1;
-    }
+    LoadSaveSnapshot* snapshot = new LoadSaveSnapshot();
+    snapshot->size = 0;
 
-    short v8[3];
-    if (db_freadInt16List(flptr, v8, 2) == -1) {
-        return -1;
-    }
+    for (unsigned int index = 0; index < count; index++) {
+        unsigned int nameLength;
+        if ((size_t)(end - pos) < sizeof(nameLength)) {
+            delete snapshot;
+            return NULL;
+        }
+        memcpy(&nameLength, pos, sizeof(nameLength));
+        pos += sizeof(nameLength);
 
-    ptr->versionMinor = v8[0];
-    ptr->versionMajor = v8[1];
+        if ((size_t)(end - pos) < (size_t)nameLength + sizeof(unsigned int)) {
+            delete snapshot;
+            return NULL;
+        }
 
-    if (db_freadByte(flptr, &(ptr->versionRelease)) == -1) {
-        return -1;
-    }
+        snapshot->files.emplace_back();
+        LoadSaveAsyncFile* file = &(snapshot->files.back());
+        file->name.assign((const char*)pos, nameLength);
+        file->linked = false;
+        pos += nameLength;
 
-    if (db_fread(ptr->characterName, 32, 1, flptr) != 1) {
-        return -1;
-    }
+        unsigned int dataLength;
+        memcpy(&dataLength, pos, sizeof(dataLength));
+        pos += sizeof(dataLength);
 
-    if (db_fread(ptr->description, 30, 1, flptr) != 1) {
-        return -1;
-    }
+        if ((size_t)(end - pos) < dataLength) {
+            delete snapshot;
+            return NULL;
+        }
 
-    if (db_freadInt16List(flptr, v8, 3) == -1) {
-        return -1;
+        file->data.assign(pos, pos + dataLength);
+        pos += dataLength;
+        snapshot->size += dataLength;
     }
 
-    ptr->fileMonth = v8[0];
-    ptr->fileDay = v8[1];
-    ptr->fileYear = v8[2];
+    return snapshot;
+}
 
-    if (db_freadInt32(flptr, &(ptr->fileTime)) == -1) {
-        return -1;
+static const LoadSaveAsyncFile* FindSnapshotFile(const LoadSaveSnapshot* snapshot, const char* name)
+{
+    for (const LoadSaveAsyncFile& file : snapshot->files) {
+        if (compat_stricmp(file.name.c_str(), name) == 0) {
+            return &file;
+        }
+    }
+
+    return NULL;
+}
+
+// CE: Background variant of `SaveSlot`. Save handlers run on main thread as
+// usual, but write into memory, and map files are snapshotted instead of
+// being copied. The resulting slot contents are written by background thread
+// into temporary directory which then replaces slot directory (see
+// `FinishAsyncSave`), so a failed or interrupted save never leaves slot
+// half-written.
+static int SaveSlotAsync()
+{
+    size_t size;
+    unsigned char* data;
+
+    LoadSaveWaitAsync();
+
+    ls_error_code = 0;
+    map_backup_count = -1;
+    gmouse_set_cursor(MOUSE_CURSOR_WAIT_PLANET);
+
+    gsound_background_pause();
+
+    ls_async_collect = new LoadSaveAsyncJob();
+    ls_async_collect->slot = slot_cursor;
+    ls_async_collect->thread = NULL;
+    ls_async_collect->result = -1;
+    ls_async_collect->packed = ls_pack_enabled;
+    ls_async_collect->snapshot = false;
+    SDL_AtomicSet(&(ls_async_collect->done), 0);
+
+    debug_printf("\nLOADSAVE: Background save to slot %d\n", slot_cursor + 1);
+
+    flptr = db_fopen_memory_write();
+    if (flptr == NULL) {
+        debug_printf("\nLOADSAVE: ** Error opening save game for writing! **\n");
+        goto err;
+    }
+
+    if (SaveSlotHeader(slot_cursor) == -1) {
+        debug_printf("\nLOADSAVE: ** Error writing save game header! **\n");
+        goto err;
+    }
+
+    for (int index = 0; index < LOAD_SAVE_HANDLER_COUNT; index++) {
+        long pos = db_ftell(flptr);
+        SaveGameHandler* handler = master_save_list[index];
+        if (handler(flptr) == -1) {
+            debug_printf("\nLOADSAVE: ** Error writing save function #%d data! **\n", index);
+            goto err;
+        }
+
+        debug_printf("LOADSAVE: Save function #%d data size written: %d bytes.\n", index, db_ftell(flptr) - pos);
+    }
+
+    debug_printf("LOADSAVE: Total save data written: %ld bytes.\n", db_ftell(flptr));
+
+    data = db_fclose_memory(flptr, &size);
+    flptr = NULL;
+
+    if (data == NULL) {
+        goto err;
+    }
+
+    ls_async_collect->files.emplace_back();
+    ls_async_collect->files.back().name = "SAVE.DAT";
+    ls_async_collect->files.back().data.assign(data, data + size);
+    ls_async_collect->files.back().linked = false;
+    db_free_memory(data);
+
+    ls_async_collect->versions = std::move(ls_pending_versions);
+    ls_pending_versions.clear();
+
+    if (StartAsyncSave(ls_async_collect) == -1) {
+        ls_async_collect = NULL;
+        gsound_background_unpause();
+        return -1;
+    }
+
+    ls_async_collect = NULL;
+
+    lsgmesg.num = 140;
+    if (message_search(&lsgame_msgfl, &lsgmesg)) {
+        display_print(lsgmesg.text);
+    } else {
+        debug_printf("\nError: Couldn't find LoadSave Message!");
+    }
+
+    gsound_background_unpause();
+
+    return 0;
+
+err:
+
+    if (flptr != NULL) {
+        db_free_memory(db_fclose_memory(flptr, &size));
+        flptr = NULL;
+    }
+
+    delete ls_async_collect;
+    ls_async_collect = NULL;
+
+    ls_index[slot_cursor].header.clear();
+
+    partyMemberUnPrepSave();
+    gsound_background_unpause();
+
+    return -1;
+}
+
+// CE: Snapshots file into background save job under given name.
+static int AddAsyncFile(const char* name, const char* path)
+{
+    DB_FILE* stream = db_fopen(path, "rb");
+    if (stream == NULL) {
+        return -1;
+    }
+
+    int length = db_filelength(stream);
+    if (length == -1) {
+        db_fclose(stream);
+        return -1;
+    }
+
+    ls_async_collect->files.emplace_back();
+    LoadSaveAsyncFile* file = &(ls_async_collect->files.back());
+    file->name = name;
+    file->data.resize(length);
+    file->linked = false;
+
+    if (length != 0 && db_fread(file->data.data(), length, 1, stream) != 1) {
+        db_fclose(stream);
+        return -1;
+    }
+
+    db_fclose(stream);
+
+    return 0;
+}
+
+// CE: Prepares temporary directory and hands job to background thread. Job is
+// released on failure.
+static int StartAsyncSave(LoadSaveAsyncJob* job)
+{
+    char path[COMPAT_MAX_PATH];
+
+    snprintf(path, sizeof(path), "%s\\%s", patches, "SAVEGAME");
+    compat_mkdir(path);
+
+    // Leftovers of interrupted save.
+    snprintf(path, sizeof(path), "%s\\%s%.2d.TMP\\", "SAVEGAME", "SLOT", job->slot + 1);
+    EraseSlotDir(path);
+
+    snprintf(path, sizeof(path), "%s\\%s\\%s%.2d.TMP", patches, "SAVEGAME", "SLOT", job->slot + 1);
+    if (compat_mkdir(path) != 0) {
+        debug_printf("\nLOADSAVE: ** Error creating %s! **\n", path);
+        delete job;
+        return -1;
+    }
+
+    ls_async_running = job;
+
+    job->thread = ls_async_enabled ? SDL_CreateThread(AsyncSaveThread, "loadsave", job) : NULL;
+    if (job->thread == NULL) {
+        // Write on main thread instead.
+        AsyncSaveThread(job);
+        FinishAsyncSave();
+    }
+
+    return 0;
+}
+
+static int AsyncSaveThread(void* data)
+{
+    LoadSaveAsyncJob* job = (LoadSaveAsyncJob*)data;
+    ProfScope profScope(PROF_ZONE_SAVE_WORKER);
+    job->result = WriteAsyncJob(job);
+    SDL_AtomicSet(&(job->done), 1);
+    return 0;
+}
+
+// CE: Writes files of job into temporary directory. Runs on background
+// thread, so it only uses stdio.
+static int WriteAsyncJob(LoadSaveAsyncJob* job)
+{
+    char path[COMPAT_MAX_PATH];
+
+    if (job->packed) {
+        std::vector<db_pack_member> members(job->files.size());
+        for (size_t index = 0; index < job->files.size(); index++) {
+            members[index].name = job->files[index].name.c_str();
+            members[index].data = job->files[index].data.data();
+            members[index].size = job->files[index].data.size();
+        }
+
+        snprintf(path, sizeof(path), "%s\\%s\\%s%.2d.TMP\\%s", patches, "SAVEGAME", "SLOT", job->slot + 1, "SAVE.PAK");
+        return db_pack_write(path, members.data(), (int)members.size());
+    }
+
+    for (LoadSaveAsyncFile& file : job->files) {
+        snprintf(path, sizeof(path), "%s\\%s\\%s%.2d.TMP\\%s", patches, "SAVEGAME", "SLOT", job->slot + 1, file.name.c_str());
+
+        if (file.linked) {
+            char sourcePath[COMPAT_MAX_PATH];
+            snprintf(sourcePath, sizeof(sourcePath), "%s\\%s\\%s%.2d\\%s", patches, "SAVEGAME", "SLOT", job->slot + 1, file.name.c_str());
+            if (compat_link(sourcePath, path) != 0 && compat_copy_file(sourcePath, path) != 0) {
+                return -1;
+            }
+            continue;
+        }
+
+        FILE* stream = compat_fopen(path, "wb");
+        if (stream == NULL) {
+            return -1;
+        }
+
+        size_t written = file.data.empty() ? 0 : fwrite(file.data.data(), 1, file.data.size(), stream);
+        if (fclose(stream) != 0 || written != file.data.size()) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+// CE: Replaces slot directory with the one written by finished background
+// save and reports result. Must be called on main thread.
+static void FinishAsyncSave()
+{
+    LoadSaveAsyncJob* job = ls_async_running;
+    if (job == NULL) {
+        return;
+    }
+
+    if (job->thread != NULL) {
+        SDL_WaitThread(job->thread, NULL);
+        job->thread = NULL;
+    }
+
+    ls_async_running = NULL;
+
+    char slotPath[COMPAT_MAX_PATH];
+    char tempPath[COMPAT_MAX_PATH];
+    char oldPath[COMPAT_MAX_PATH];
+    snprintf(slotPath, sizeof(slotPath), "%s\\%s\\%s%.2d", patches, "SAVEGAME", "SLOT", job->slot + 1);
+    snprintf(tempPath, sizeof(tempPath), "%s.TMP", slotPath);
+    snprintf(oldPath, sizeof(oldPath), "%s.OLD", slotPath);
+
+    char relativePath[COMPAT_MAX_PATH];
+    int rc = job->result;
+    if (rc == 0) {
+        snprintf(relativePath, sizeof(relativePath), "%s\\%s%.2d.OLD\\", "SAVEGAME", "SLOT", job->slot + 1);
+        EraseSlotDir(relativePath);
+
+        bool hasSlot = compat_stat(slotPath, NULL, NULL) == 0;
+        if (hasSlot && compat_rename(slotPath, oldPath) != 0) {
+            rc = -1;
+        } else if (compat_rename(tempPath, slotPath) != 0) {
+            if (hasSlot) {
+                compat_rename(oldPath, slotPath);
+            }
+            rc = -1;
+        } else if (hasSlot) {
+            EraseSlotDir(relativePath);
+        }
+    }
+
+    if (rc == 0) {
+        // Make new files visible to path index.
+        if (job->packed) {
+            snprintf(relativePath, sizeof(relativePath), "%s\\%s%.2d\\%s", "SAVEGAME", "SLOT", job->slot + 1, "SAVE.PAK");
+            db_add_hash_entry(relativePath, '\\');
+        } else {
+            for (LoadSaveAsyncFile& file : job->files) {
+                snprintf(relativePath, sizeof(relativePath), "%s\\%s%.2d\\%s", "SAVEGAME", "SLOT", job->slot + 1, file.name.c_str());
+                db_add_hash_entry(relativePath, '\\');
+            }
+        }
+
+        ls_slot_versions[job->slot] = std::move(job->versions);
+    } else {
+        ls_slot_versions[job->slot].clear();
+        ls_index[job->slot].header.clear();
+
+        debug_printf("\nLOADSAVE: ** Error writing slot %d in background! **\n", job->slot + 1);
+
+        snprintf(relativePath, sizeof(relativePath), "%s\\%s%.2d.TMP\\", "SAVEGAME", "SLOT", job->slot + 1);
+        EraseSlotDir(relativePath);
+    }
+
+    db_file_list_invalidate();
+
+    if (rc == 0) {
+        CommitSlotIndex(job->slot);
+    }
+
+    ls_async_last_slot = job->slot;
+    ls_async_last_result = rc;
+
+    int slot = job->slot;
+    delete job;
+
+    if (ls_async_proc != NULL) {
+        ls_async_proc(slot, rc, ls_async_user_data);
+    }
+}
+
+// CE: Removes slot directory (relative to patches path, with trailing
+// separator) along with files save can produce there.
+static void EraseSlotDir(const char* relativePath)
+{
+    char path[COMPAT_MAX_PATH];
+
+    MapDirErase(relativePath, "SAV");
+    MapDirErase(relativePath, "BAK");
+    MapDirErase(relativePath, "DAT");
+    MapDirErase(relativePath, "PAK");
+
+    snprintf(path, sizeof(path), "%s\\%s", patches, relativePath);
+    path[strlen(path) - 1] = '\0';
+    compat_rmdir(path);
+}
+
+static std::string SlotFileKey(const char* name)
+{
+    char key[COMPAT_MAX_PATH];
+    strncpy(key, name, sizeof(key) - 1);
+    key[sizeof(key) - 1] = '\0';
+    compat_strupr(key);
+    return key;
+}
+
+// CE: Returns `true` if state of given map is the same as the one written
+// to current slot by previous save.
+static bool IsSlotFileUnchanged(const char* name)
+{
+    const std::unordered_map<std::string, unsigned int>& versions = ls_slot_versions[slot_cursor];
+    if (versions.empty()) {
+        return false;
+    }
+
+    auto it = versions.find(SlotFileKey(name));
+    return it != versions.end() && it->second == map_state_version(name);
+}
+
+// CE: Restores unchanged map of current slot from backup made by
+// `SaveBackup` (backup itself is removed once save succeeds). Hard link is
+// used when possible so nothing is rewritten.
+static int LinkSlotBackup(const char* name)
+{
+    char backupName[COMPAT_MAX_PATH];
+    strmfe(backupName, name, "BAK");
+
+    char backupPath[COMPAT_MAX_PATH];
+    char path[COMPAT_MAX_PATH];
+    snprintf(backupPath, sizeof(backupPath), "%s\\%s\\%s%.2d\\%s", patches, "SAVEGAME", "SLOT", slot_cursor + 1, backupName);
+    snprintf(path, sizeof(path), "%s\\%s\\%s%.2d\\%s", patches, "SAVEGAME", "SLOT", slot_cursor + 1, name);
+
+    if (compat_stat(backupPath, NULL, NULL) != 0) {
+        return -1;
+    }
+
+    if (compat_link(backupPath, path) != 0 && compat_copy_file(backupPath, path) != 0) {
+        return -1;
+    }
+
+    snprintf(path, sizeof(path), "%s\\%s%.2d\\%s", "SAVEGAME", "SLOT", slot_cursor + 1, name);
+    db_add_hash_entry(path, '\\');
+
+    return 0;
+}
+
+// CE: Adds unchanged map to background save job. File is linked from
+// current slot directory by background thread.
+static int AddAsyncLink(const char* name)
+{
+    char path[COMPAT_MAX_PATH];
+    snprintf(path, sizeof(path), "%s\\%s\\%s%.2d\\%s", patches, "SAVEGAME", "SLOT", ls_async_collect->slot + 1, name);
+    if (compat_stat(path, NULL, NULL) != 0) {
+        return -1;
+    }
+
+    ls_async_collect->files.emplace_back();
+    ls_async_collect->files.back().name = name;
+    ls_async_collect->files.back().linked = true;
+
+    return 0;
+}
+
+// CE: Returns `true` if slot is saved as container.
+static bool IsSlotPacked(int slot)
+{
+    char path[COMPAT_MAX_PATH];
+    snprintf(path, sizeof(path), "%s\\%s%.2d\\%s", "SAVEGAME", "SLOT", slot + 1, "SAVE.PAK");
+
+    dir_entry de;
+    return db_dir_entry(path, &de) == 0;
+}
+
+// CE: Opens file of slot for reading, either from container (decoded into
+// memory) or from slot directory.
+static DB_FILE* OpenSlotFile(int slot, const char* name)
+{
+    char path[COMPAT_MAX_PATH];
+
+    if (IsSlotPacked(slot)) {
+        snprintf(path, sizeof(path), "%s\\%s%.2d\\%s", "SAVEGAME", "SLOT", slot + 1, "SAVE.PAK");
+        return db_fopen_pack(path, name);
+    }
+
+    snprintf(path, sizeof(path), "%s\\%s%.2d\\%s", "SAVEGAME", "SLOT", slot + 1, name);
+    return db_fopen(path, "rb");
+}
+
+// CE: Copies file of current slot to [a2].
+static int CopySlotFile(const char* name, const char* a2)
+{
+    char path[COMPAT_MAX_PATH];
+
+    if (ls_restore_snapshot != NULL) {
+        const LoadSaveAsyncFile* file = FindSnapshotFile(ls_restore_snapshot, name);
+        if (file == NULL) {
+            return -1;
+        }
+
+        DB_FILE* stream = db_fopen(a2, "wb");
+        if (stream == NULL) {
+            return -1;
+        }
+
+        int rc = 0;
+        if (!file->data.empty() && db_fwrite(file->data.data(), file->data.size(), 1, stream) != 1) {
+            rc = -1;
+        }
+
+        if (db_fclose(stream) != 0) {
+            rc = -1;
+        }
+
+        return rc;
+    }
+
+    if (!IsSlotPacked(slot_cursor)) {
+        snprintf(path, sizeof(path), "%s\\%s%.2d\\%s", "SAVEGAME", "SLOT", slot_cursor + 1, name);
+        return copy_file(path, a2);
+    }
+
+    DB_FILE* stream = OpenSlotFile(slot_cursor, name);
+    if (stream == NULL) {
+        return -1;
+    }
+
+    int rc = copy_stream(stream, a2);
+    db_fclose(stream);
+
+    return rc;
+}
+
+// CE: Writes header to current save stream and keeps copy of it in slot
+// index (stamped once save succeeds, see `CommitSlotIndex`).
+static int SaveSlotHeader(int slot)
+{
+    DB_FILE* stream = flptr;
+
+    flptr = db_fopen_memory_write();
+    if (flptr == NULL) {
+        flptr = stream;
+        return -1;
+    }
+
+    int rc = SaveHeader(slot);
+
+    size_t size;
+    unsigned char* data = db_fclose_memory(flptr, &size);
+    flptr = stream;
+
+    if (data == NULL) {
+        return -1;
+    }
+
+    if (rc == 0 && db_fwrite(data, size, 1, flptr) != 1) {
+        rc = -1;
+    }
+
+    if (!ls_index_loaded) {
+        ReadSlotIndex();
+    }
+
+    LoadSaveIndexEntry* entry = &(ls_index[slot]);
+    if (rc == 0 && size == LS_HEADER_SIZE) {
+        entry->header.assign(data, data + size);
+        entry->size = -1;
+        entry->mtime = -1;
+    } else {
+        entry->header.clear();
+    }
+
+    db_free_memory(data);
+
+    return rc;
+}
+
+// CE: Obtains size and modification time of file which holds slot header.
+static int StatSlot(int slot, long long* sizePtr, long long* mtimePtr)
+{
+    char path[COMPAT_MAX_PATH];
+
+    snprintf(path, sizeof(path), "%s\\%s\\%s%.2d\\%s", patches, "SAVEGAME", "SLOT", slot + 1, "SAVE.PAK");
+    if (compat_stat(path, sizePtr, mtimePtr) == 0) {
+        return 0;
+    }
+
+    snprintf(path, sizeof(path), "%s\\%s\\%s%.2d\\%s", patches, "SAVEGAME", "SLOT", slot + 1, "SAVE.DAT");
+    return compat_stat(path, sizePtr, mtimePtr);
+}
+
+static bool IsSlotIndexed(int slot, long long size, long long mtime)
+{
+    const LoadSaveIndexEntry* entry = &(ls_index[slot]);
+    return entry->header.size() == LS_HEADER_SIZE
+        && entry->size == size
+        && entry->mtime == mtime;
+}
+
+// CE: Reads `SAVEGAME\SLOTS.IDX`. Index is a list of slot file stamps (size
+// and modification time) followed by header bytes of slot. Missing or
+// malformed index leaves every slot unindexed.
+static void ReadSlotIndex()
+{
+    ls_index_loaded = true;
+
+    for (int slot = 0; slot < 10; slot++) {
+        ls_index[slot].header.clear();
+    }
+
+    char path[COMPAT_MAX_PATH];
+    snprintf(path, sizeof(path), "%s\\%s", "SAVEGAME", "SLOTS.IDX");
+
+    DB_FILE* stream = db_fopen(path, "rb");
+    if (stream == NULL) {
+        return;
+    }
+
+    int magic;
+    int version;
+    if (db_freadInt32(stream, &magic) == -1
+        || magic != LS_INDEX_MAGIC
+        || db_freadInt32(stream, &version) == -1
+        || version != LS_INDEX_VERSION) {
+        db_fclose(stream);
+        return;
+    }
+
+    for (int slot = 0; slot < 10; slot++) {
+        int fields[5];
+        if (db_freadInt32List(stream, fields, 5) == -1) {
+            break;
+        }
+
+        if (fields[4] != LS_HEADER_SIZE) {
+            continue;
+        }
+
+        LoadSaveIndexEntry* entry = &(ls_index[slot]);
+        entry->size = ((long long)fields[0] << 32) | (unsigned int)fields[1];
+        entry->mtime = ((long long)fields[2] << 32) | (unsigned int)fields[3];
+        entry->header.resize(LS_HEADER_SIZE);
+
+        if (db_fread(entry->header.data(), LS_HEADER_SIZE, 1, stream) != 1) {
+            entry->header.clear();
+            break;
+        }
+    }
+
+    db_fclose(stream);
+}
+
+static int WriteSlotIndex()
+{
+    char path[COMPAT_MAX_PATH];
+    snprintf(path, sizeof(path), "%s\\%s", patches, "SAVEGAME");
+    compat_mkdir(path);
+
+    snprintf(path, sizeof(path), "%s\\%s", "SAVEGAME", "SLOTS.IDX");
+
+    DB_FILE* stream = db_fopen(path, "wb");
+    if (stream == NULL) {
+        return -1;
+    }
+
+    int rc = 0;
+    if (db_fwriteInt32(stream, LS_INDEX_MAGIC) == -1
+        || db_fwriteInt32(stream, LS_INDEX_VERSION) == -1) {
+        rc = -1;
+    }
+
+    for (int slot = 0; slot < 10 && rc == 0; slot++) {
+        const LoadSaveIndexEntry* entry = &(ls_index[slot]);
+        bool indexed = entry->header.size() == LS_HEADER_SIZE && entry->size != -1;
+
+        int fields[5];
+        fields[0] = indexed ? (int)(entry->size >> 32) : 0;
+        fields[1] = indexed ? (int)(entry->size & 0xFFFFFFFF) : 0;
+        fields[2] = indexed ? (int)(entry->mtime >> 32) : 0;
+        fields[3] = indexed ? (int)(entry->mtime & 0xFFFFFFFF) : 0;
+        fields[4] = indexed ? LS_HEADER_SIZE : 0;
+
+        if (db_fwriteInt32List(stream, fields, 5) == -1) {
+            rc = -1;
+        } else if (indexed && db_fwrite(entry->header.data(), LS_HEADER_SIZE, 1, stream) != 1) {
+            rc = -1;
+        }
+    }
+
+    if (db_fclose(stream) != 0) {
+        rc = -1;
+    }
+
+    return rc;
+}
+
+// CE: Stamps header kept by `SaveSlotHeader` with slot file written by
+// successful save and updates index on disk.
+static void CommitSlotIndex(int slot)
+{
+    LoadSaveIndexEntry* entry = &(ls_index[slot]);
+    if (entry->header.size() != LS_HEADER_SIZE || StatSlot(slot, &(entry->size), &(entry->mtime)) != 0) {
+        entry->header.clear();
+    }
+
+    WriteSlotIndex();
+}
+
+// CE: Finalizes background save once its thread is done. Should be called
+// once per frame.
+void LoadSaveProcessAsync()
+{
+    if (ls_async_running != NULL && SDL_AtomicGet(&(ls_async_running->done)) != 0) {
+        FinishAsyncSave();
+    }
+}
+
+// CE: Blocks until background save (if any) is finished.
+void LoadSaveWaitAsync()
+{
+    FinishAsyncSave();
+}
+
+void LoadSaveSetAsyncCallback(LoadSaveAsyncProc* proc, void* userData)
+{
+    ls_async_proc = proc;
+    ls_async_user_data = userData;
+}
+
+// 0x46FCCC
+static int LoadSlot(int slot)
+{
+    // CE: Slot might still be written in background.
+    LoadSaveWaitAsync();
+
+    gmouse_set_cursor(MOUSE_CURSOR_WAIT_PLANET);
+
+    if (isInCombat()) {
+        intface_end_window_close(false);
+        combat_over_from_load();
+        gmouse_set_cursor(MOUSE_CURSOR_WAIT_PLANET);
+    }
+
+    loadingGame = 1;
+
+    LoadSaveSlotData* ptr = &(LSData[slot]);
+    debug_printf("\nLOADSAVE: Load name: %s\n", ptr->description);
+
+    flptr = OpenSlotFile(slot_cursor, "SAVE.DAT");
+    if (flptr == NULL) {
+        debug_printf("\nLOADSAVE: ** Error opening load game file for reading! **\n");
+        loadingGame = 0;
+        return -1;
+    }
+
+    long pos = db_ftell(flptr);
+    if (LoadHeader(slot) == -1) {
+        debug_printf("\nLOADSAVE: ** Error reading save  game header! **\n");
+        db_fclose(flptr);
+        game_reset();
+        loadingGame = 0;
+        return -1;
+    }
+
+    debug_printf("LOADSAVE: Load file header size read: %d bytes.\n", db_ftell(flptr) - pos);
+
+    for (int index = 0; index < LOAD_SAVE_HANDLER_COUNT; index += 1) {
+        long pos = db_ftell(flptr);
+        LoadGameHandler* handler = master_load_list[index];
+        if (handler(flptr) == -1) {
+            debug_printf("\nLOADSAVE: ** Error reading load function #%d data! **\n", index);
+            int v12 = db_ftell(flptr);
+            debug_printf("LOADSAVE: Load function #%d data size read: %d bytes.\n", index, db_ftell(flptr) - pos);
+            db_fclose(flptr);
+            game_reset();
+            loadingGame = 0;
+            return -1;
+        }
+
+        debug_printf("LOADSAVE: Load function #%d data size read: %d bytes.\n", index, db_ftell(flptr) - pos);
+    }
+
+    debug_printf("LOADSAVE: Total load data read: %ld bytes.\n", db_ftell(flptr));
+    db_fclose(flptr);
+
+    snprintf(str, sizeof(str), "%s\\", "MAPS");
+    MapDirErase(str, "BAK");
+    proto_dude_update_gender();
+    statever_bump_all();
+
+    // Game Loaded.
+    lsgmesg.num = 141;
+    if (message_search(&lsgame_msgfl, &lsgmesg) == 1) {
+        display_print(lsgmesg.text);
+    } else {
+        debug_printf("\nError: Couldn't find LoadSave Message!");
+    }
+
+    loadingGame = 0;
+
+    return 0;
+}
+
+// 0x46FF38
+static void GetTimeDate(short* day, short* month, short* year, int* hour)
+{
+    time_t now;
+    struct tm* local;
+
+    now = time(NULL);
+    local = localtime(&now);
+
+    *day = local->tm_mday;
+    *month = local->tm_mon + 1;
+    *year = local->tm_year + 1900;
+    *hour = local->tm_hour + local->tm_min;
+}
+
+// 0x46FF80
+static int SaveHeader(int slot)
+{
+    ls_error_code = 4;
+
+    LoadSaveSlotData* ptr = &(LSData[slot]);
+    strncpy(ptr->signature, LOAD_SAVE_SIGNATURE, 24);
+
+    if (db_fwrite(ptr->signature, 1, 24, flptr) == -1) {
+        return -1;
+    }
+
+    short temp[3];
+    temp[0] = VERSION_MAJOR;
+    temp[1] = VERSION_MINOR;
+
+    ptr->versionMinor = temp[0];
+    ptr->versionMajor = temp[1];
+
+    if (db_fwriteInt16List(flptr, temp, 2) == -1) {
+        return -1;
+    }
+
+    ptr->versionRelease = VERSION_RELEASE;
+    if (db_fwriteByte(flptr, VERSION_RELEASE) == -1) {
+        return -1;
+    }
+
+    char* characterName = critter_name(obj_dude);
+    strncpy(ptr->characterName, characterName, 32);
+
+    if (db_fwrite(ptr->characterName, 32, 1, flptr) != 1) {
+        return -1;
+    }
+
+    if (db_fwrite(ptr->description, 30, 1, flptr) != 1) {
+        return -1;
+    }
+
+    // NOTE: Uninline.
+    int file_time;
+    GetTimeDate(&(temp[0]), &(temp[1]), &(temp[2]), &file_time);
+
+    ptr->fileDay = temp[0];
+    ptr->fileMonth = temp[1];
+    ptr->fileYear = temp[2];
+    ptr->fileTime = file_time;
+
+    if (db_fwriteInt16List(flptr, temp, 3) == -1) {
+        return -1;
+    }
+
+    if (db_fwriteInt32(flptr, ptr->fileTime) == -1) {
+        return -1;
+    }
+
+    int month;
+    int day;
+    int year;
+    game_time_date(&month, &day, &year);
+
+    temp[0] = month;
+    temp[1] = day;
+    temp[2] = year;
+    ptr->gameTime = game_time();
+
+    if (db_fwriteInt16List(flptr, temp, 3) == -1) {
+        return -1;
+    }
+
+    if (db_fwriteInt32(flptr, ptr->gameTime) == -1) {
+        return -1;
+    }
+
+    ptr->elevation = map_elevation;
+    if (db_fwriteShort(flptr, ptr->elevation) == -1) {
+        return -1;
+    }
+
+    ptr->map = map_get_index_number();
+    if (db_fwriteShort(flptr, ptr->map) == -1) {
+        return -1;
+    }
+
+    char mapName[128];
+    strcpy(mapName, map_data.name);
+
+    char* v1 = strmfe(str, mapName, "sav");
+    strncpy(ptr->fileName, v1, 16);
+    if (db_fwrite(ptr->fileName, 16, 1, flptr) != 1) {
+        return -1;
+    }
+
+    if (db_fwrite(thumbnail_image[1], LS_PREVIEW_SIZE, 1, flptr) != 1) {
+        return -1;
+    }
+
+    memset(mapName, 0, 128);
+    if (db_fwrite(mapName, 1, 128, flptr) != 128) {
+        return -1;
+    }
+
+    ls_error_code = 0;
+
+    return 0;
+}
+
+// 0x470350
+static int LoadHeader(int slot)
+{
+    ls_error_code = 3;
+
+    LoadSaveSlotData* ptr = &(LSData[slot]);
+
+    if (db_fread(ptr->signature, 1, 24, flptr) != 24) {
+        return -1;
+    }
+
+    if (strncmp(ptr->signature, LOAD_SAVE_SIGNATURE, 18) != 0) {
+        debug_printf("\nLOADSAVE: ** Invalid save file on load! **\n");
+        ls_error_code = 2;
+        return -1;
+    }
+
+    short v8[3];
+    if (db_freadInt16List(flptr, v8, 2) == -1) {
+        return -1;
+    }
+
+    ptr->versionMinor = v8[0];
+    ptr->versionMajor = v8[1];
+
+    if (db_freadByte(flptr, &(ptr->versionRelease)) == -1) {
+        return -1;
+    }
+
+    if (db_fread(ptr->characterName, 32, 1, flptr) != 1) {
+        return -1;
+    }
+
+    if (db_fread(ptr->description, 30, 1, flptr) != 1) {
+        return -1;
+    }
+
+    if (db_freadInt16List(flptr, v8, 3) == -1) {
+        return -1;
+    }
+
+    ptr->fileMonth = v8[0];
+    ptr->fileDay = v8[1];
+    ptr->fileYear = v8[2];
+
+    if (db_freadInt32(flptr, &(ptr->fileTime)) == -1) {
+        return -1;
     }
 
     if (db_freadInt16List(flptr, v8, 3) == -1) {
@@ -2008,14 +3117,37 @@ static int LoadHeader(int slot)
 static int GetSlotList()
 {
     dir_entry de;
+    bool indexChanged = false;
+
+    if (!ls_index_loaded) {
+        ReadSlotIndex();
+    }
+
     int index = 0;
     for (; index < 10; index += 1) {
         snprintf(str, sizeof(str), "%s\\%s%.2d\\%s", "SAVEGAME", "SLOT", index + 1, "SAVE.DAT");
 
-        if (db_dir_entry(str, &de) != 0) {
+        // CE: Header of slot which is unchanged since it was indexed is
+        // parsed from memory.
+        long long size;
+        long long mtime;
+        bool exists = StatSlot(index, &size, &mtime) == 0;
+        bool indexed = exists && IsSlotIndexed(index, size, mtime);
+
+        if (!exists && !ls_index[index].header.empty()) {
+            ls_index[index].header.clear();
+            indexChanged = true;
+        }
+
+        // CE: Slot can also be saved as container.
+        if (!indexed && !IsSlotPacked(index) && db_dir_entry(str, &de) != 0) {
             LSstatus[index] = SLOT_STATE_EMPTY;
         } else {
-            flptr = db_fopen(str, "rb");
+            if (indexed) {
+                flptr = db_fopen_memory(ls_index[index].header.data(), ls_index[index].header.size());
+            } else {
+                flptr = OpenSlotFile(index, "SAVE.DAT");
+            }
 
             if (flptr == NULL) {
                 debug_printf("\nLOADSAVE: ** Error opening save  game for reading! **\n");
@@ -2032,11 +3164,30 @@ static int GetSlotList()
                 }
             } else {
                 LSstatus[index] = SLOT_STATE_OCCUPIED;
+
+                if (!indexed && exists) {
+                    LoadSaveIndexEntry* entry = &(ls_index[index]);
+                    entry->header.resize(LS_HEADER_SIZE);
+                    entry->size = size;
+                    entry->mtime = mtime;
+
+                    if (db_fseek(flptr, 0, SEEK_SET) != 0
+                        || db_fread(entry->header.data(), LS_HEADER_SIZE, 1, flptr) != 1) {
+                        entry->header.clear();
+                    } else {
+                        indexChanged = true;
+                    }
+                }
             }
 
             db_fclose(flptr);
         }
     }
+
+    if (indexChanged) {
+        WriteSlotIndex();
+    }
+
     return index;
 }
 
@@ -2159,10 +3310,16 @@ static int LoadTumbSlot(int a1)
 
     v2 = LSstatus[slot_cursor];
     if (v2 != 0 && v2 != 2 && v2 != 3) {
+        // CE: Thumbnail of indexed slot is kept in memory.
+        if (ls_index[slot_cursor].header.size() == LS_HEADER_SIZE && ls_index[slot_cursor].size != -1) {
+            memcpy(thumbnail_image[0], ls_index[slot_cursor].header.data() + 131, LS_PREVIEW_SIZE);
+            return 0;
+        }
+
         snprintf(str, sizeof(str), "%s\\%s%.2d\\%s", "SAVEGAME", "SLOT", slot_cursor + 1, "SAVE.DAT");
         debug_printf(" Filename %s\n", str);
 
-        stream = db_fopen(str, "rb");
+        stream = OpenSlotFile(slot_cursor, "SAVE.DAT");
         if (stream == NULL) {
             debug_printf("\nLOADSAVE: ** (A) Error reading thumbnail #%d! **\n", a1);
             return -1;
@@ -2455,9 +3612,19 @@ static int GameMap2Slot(DB_FILE* stream)
         return -1;
     }
 
+    // CE: Saved states kept in memory are copied to slot from `MAPS`.
+    if (map_store_flush() == -1) {
+        return -1;
+    }
+
+    ls_pending_versions.clear();
+
     snprintf(str0, sizeof(str0), "%s\\*.%s", "MAPS", "SAV");
 
     char** fileNameList;
+    // CE: Files in patches directory are being moved around, make sure
+    // listing is not stale.
+    db_file_list_invalidate();
     int fileNameListLength = db_get_file_list(str0, &fileNameList, NULL, 0);
     if (fileNameListLength == -1) {
         return -1;
@@ -2473,17 +3640,20 @@ static int GameMap2Slot(DB_FILE* stream)
         return -1;
     }
 
-    snprintf(gmpath, sizeof(gmpath), "%s\\%s%.2d\\", "SAVEGAME", "SLOT", slot_cursor + 1);
+    // CE: Background save writes fresh directory, there is nothing to erase.
+    if (ls_async_collect == NULL) {
+        snprintf(gmpath, sizeof(gmpath), "%s\\%s%.2d\\", "SAVEGAME", "SLOT", slot_cursor + 1);
 
-    if (MapDirErase(gmpath, "SAV") == -1) {
-        db_free_file_list(&fileNameList, NULL);
-        return -1;
-    }
+        if (MapDirErase(gmpath, "SAV") == -1) {
+            db_free_file_list(&fileNameList, NULL);
+            return -1;
+        }
 
-    snprintf(gmpath, sizeof(gmpath), "%s\\%s\\%s%.2d\\", patches, "SAVEGAME", "SLOT", slot_cursor + 1);
-    strmfe(str0, "AUTOMAP.DB", "SAV");
-    strcat(gmpath, str0);
-    compat_remove(gmpath);
+        snprintf(gmpath, sizeof(gmpath), "%s\\%s\\%s%.2d\\", patches, "SAVEGAME", "SLOT", slot_cursor + 1);
+        strmfe(str0, "AUTOMAP.DB", "SAV");
+        strcat(gmpath, str0);
+        compat_remove(gmpath);
+    }
 
     for (int index = 0; index < fileNameListLength; index += 1) {
         char* string = fileNameList[index];
@@ -2492,9 +3662,25 @@ static int GameMap2Slot(DB_FILE* stream)
             return -1;
         }
 
+        // CE: Maps which are unchanged since slot was written are reused
+        // from previous slot contents.
+        bool unchanged = IsSlotFileUnchanged(string);
+        ls_pending_versions[SlotFileKey(string)] = map_state_version(string);
+
         snprintf(str0, sizeof(str0), "%s\\%s", "MAPS", string);
         snprintf(str1, sizeof(str1), "%s\\%s%.2d\\%s", "SAVEGAME", "SLOT", slot_cursor + 1, string);
-        if (copy_file(str0, str1) == -1) {
+        if (ls_async_collect != NULL) {
+            if (unchanged && !ls_async_collect->packed && !ls_async_collect->snapshot && AddAsyncLink(string) == 0) {
+                continue;
+            }
+
+            if (AddAsyncFile(string, str0) == -1) {
+                db_free_file_list(&fileNameList, NULL);
+                return -1;
+            }
+        } else if (unchanged && LinkSlotBackup(string) == 0) {
+            continue;
+        } else if (copy_file(str0, str1) == -1) {
             db_free_file_list(&fileNameList, NULL);
             return -1;
         }
@@ -2503,11 +3689,18 @@ static int GameMap2Slot(DB_FILE* stream)
     db_free_file_list(&fileNameList, NULL);
 
     strmfe(str0, "AUTOMAP.DB", "SAV");
-    snprintf(str1, sizeof(str1), "%s\\%s%.2d\\%s", "SAVEGAME", "SLOT", slot_cursor + 1, str0);
-    snprintf(str0, sizeof(str0), "%s\\%s", "MAPS", "AUTOMAP.DB");
+    if (ls_async_collect != NULL) {
+        snprintf(str1, sizeof(str1), "%s\\%s", "MAPS", "AUTOMAP.DB");
+        if (AddAsyncFile(str0, str1) == -1) {
+            return -1;
+        }
+    } else {
+        snprintf(str1, sizeof(str1), "%s\\%s%.2d\\%s", "SAVEGAME", "SLOT", slot_cursor + 1, str0);
+        snprintf(str0, sizeof(str0), "%s\\%s", "MAPS", "AUTOMAP.DB");
 
-    if (copy_file(str0, str1) == -1) {
-        return -1;
+        if (copy_file(str0, str1) == -1) {
+            return -1;
+        }
     }
 
     snprintf(str0, sizeof(str0), "%s\\%s", "MAPS", "AUTOMAP.DB");
@@ -2547,6 +3740,9 @@ static int SlotMap2Game(DB_FILE* stream)
         return -1;
     }
 
+    map_store_clear();
+    ls_slot_versions[slot_cursor].clear();
+
     snprintf(str0, sizeof(str0), "%s\\", "MAPS");
     if (MapDirErase(str0, "SAV") == -1) {
         return -1;
@@ -2555,25 +3751,33 @@ static int SlotMap2Game(DB_FILE* stream)
     snprintf(str0, sizeof(str0), "%s\\%s\\%s", patches, "MAPS", "AUTOMAP.DB");
     compat_remove(str0);
 
+    // CE: Automap database is replaced with the one from slot.
+    automap_db_invalidate();
+
     for (int index = 0; index < fileNameListLength; index += 1) {
         char fileName[COMPAT_MAX_PATH];
         if (mygets(fileName, stream) == -1) {
             break;
         }
 
-        snprintf(str0, sizeof(str0), "%s\\%s%.2d\\%s", "SAVEGAME", "SLOT", slot_cursor + 1, fileName);
         snprintf(str1, sizeof(str1), "%s\\%s", "MAPS", fileName);
 
-        if (copy_file(str0, str1) == -1) {
+        if (CopySlotFile(fileName, str1) == -1) {
             debug_printf("LOADSAVE: returning 7\n");
             return -1;
         }
+
+        // CE: State in `MAPS` is identical to the one in slot now (unless it
+        // was restored from snapshot).
+        if (ls_restore_snapshot == NULL) {
+            ls_slot_versions[slot_cursor][SlotFileKey(fileName)] = map_state_version(fileName);
+        }
     }
 
-    const char* automapFileName = strmfe(str1, "AUTOMAP.DB", "SAV");
-    snprintf(str0, sizeof(str0), "%s\\%s%.2d\\%s", "SAVEGAME", "SLOT", slot_cursor + 1, automapFileName);
+    char automapFileName[COMPAT_MAX_PATH];
+    strmfe(automapFileName, "AUTOMAP.DB", "SAV");
     snprintf(str1, sizeof(str1), "%s\\%s", "MAPS", "AUTOMAP.DB");
-    if (copy_file(str0, str1) == -1) {
+    if (CopySlotFile(automapFileName, str1) == -1) {
         return -1;
     }
 
@@ -2637,22 +3841,37 @@ static int mygets(char* dest, DB_FILE* stream)
 static int copy_file(const char* a1, const char* a2)
 {
     DB_FILE* stream1;
+    int result;
+
+    // CE: Plain files are copied by the OS.
+    if (copy_file_native(a1, a2) == 0) {
+        return 0;
+    }
+
+    stream1 = db_fopen(a1, "rb");
+    if (stream1 == NULL) {
+        return -1;
+    }
+
+    result = copy_stream(stream1, a2);
+    db_fclose(stream1);
+
+    return result;
+}
+
+// CE: Copies rest of [stream1] to file [a2], extracted from `copy_file`.
+static int copy_stream(DB_FILE* stream1, const char* a2)
+{
     DB_FILE* stream2;
     int length;
     int chunk_length;
     void* buf;
     int result;
 
-    stream1 = NULL;
     stream2 = NULL;
     buf = NULL;
     result = -1;
 
-    stream1 = db_fopen(a1, "rb");
-    if (stream1 == NULL) {
-        goto out;
-    }
-
     length = db_filelength(stream1);
     if (length == -1) {
         goto out;
@@ -2690,10 +3909,6 @@ static int copy_file(const char* a1, const char* a2)
 
 out:
 
-    if (stream1 != NULL) {
-        db_fclose(stream1);
-    }
-
     if (stream2 != NULL) {
         db_fclose(stream2);
     }
@@ -2705,9 +3920,37 @@ out:
     return result;
 }
 
+// CE: Copies file of patches directory with `compat_copy_file`. Returns -1
+// when source is not a plain file (i.e. it is read from datafile) or copying
+// has failed, in which case it is copied through db.
+static int copy_file_native(const char* a1, const char* a2)
+{
+    char sourcePath[COMPAT_MAX_PATH];
+    char destinationPath[COMPAT_MAX_PATH];
+    long long size;
+
+    snprintf(sourcePath, sizeof(sourcePath), "%s\\%s", patches, a1);
+    if (compat_stat(sourcePath, &size, NULL) != 0) {
+        return -1;
+    }
+
+    // Opening destination through db registers it in path index (when it is
+    // enabled) and invalidates file lists the same way regular copy does.
+    DB_FILE* stream = db_fopen(a2, "wb");
+    if (stream == NULL) {
+        return -1;
+    }
+    db_fclose(stream);
+
+    snprintf(destinationPath, sizeof(destinationPath), "%s\\%s", patches, a2);
+    return compat_copy_file(sourcePath, destinationPath);
+}
+
 // 0x471C3C
 void KillOldMaps()
 {
+    map_store_clear();
+
     snprintf(str, sizeof(str), "%s\\", "MAPS");
     MapDirErase(str, "SAV");
 }
@@ -2719,6 +3962,9 @@ int MapDirErase(const char* relativePath, const char* extension)
     snprintf(path, sizeof(path), "%s*.%s", relativePath, extension);
 
     char** fileList;
+    // CE: Files in patches directory are being moved around, make sure
+    // listing is not stale.
+    db_file_list_invalidate();
     int fileListLength = db_get_file_list(path, &fileList, NULL, 0);
     if (fileListLength == -1) {
         return -1;
@@ -2728,10 +3974,12 @@ int MapDirErase(const char* relativePath, const char* extension)
         snprintf(path, sizeof(path), "%s\\%s%s", patches, relativePath, fileList[fileListLength]);
         if (compat_remove(path) != 0) {
             db_free_file_list(&fileList, NULL);
+            db_file_list_invalidate();
             return -1;
         }
     }
     db_free_file_list(&fileList, NULL);
+    db_file_list_invalidate();
 
     return 0;
 }
@@ -2746,6 +3994,8 @@ int MapDirEraseFile(const char* a1, const char* a2)
         return -1;
     }
 
+    db_file_list_invalidate();
+
     return 0;
 }
 
@@ -2773,6 +4023,9 @@ static int SaveBackup()
     snprintf(str0, sizeof(str0), "%s*.%s", gmpath, "SAV");
 
     char** fileList;
+    // CE: Files in patches directory are being moved around, make sure
+    // listing is not stale.
+    db_file_list_invalidate();
     int fileListLength = db_get_file_list(str0, &fileList, NULL, 0);
     if (fileListLength == -1) {
         return -1;
@@ -2842,6 +4095,9 @@ static int RestoreSave()
     snprintf(str0, sizeof(str0), "%s*.%s", gmpath, "BAK");
 
     char** fileList;
+    // CE: Files in patches directory are being moved around, make sure
+    // listing is not stale.
+    db_file_list_invalidate();
     int fileListLength = db_get_file_list(str0, &fileList, NULL, 0);
     if (fileListLength == -1) {
         return -1;
@@ -2924,6 +4180,9 @@ static int EraseSave()
     snprintf(str0, sizeof(str0), "%s*.%s", gmpath, "SAV");
 
     char** fileList;
+    // CE: Files in patches directory are being moved around, make sure
+    // listing is not stale.
+    db_file_list_invalidate();
     int fileListLength = db_get_file_list(str0, &fileList, NULL, 0);
     if (fileListLength == -1) {
         return -1;
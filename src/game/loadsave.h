@@ -19,6 +19,24 @@ typedef enum LoadSaveMode {
     LOAD_SAVE_MODE_QUICK,
 } LoadSaveMode;
 
+// CE: Receives result (0 - success) of every background save.
+typedef void LoadSaveAsyncProc(int slot, int result, void* userData);
+
+// CE: Game state captured in memory by `agentLoadSaveSnapshot`.
+typedef struct LoadSaveSnapshot LoadSaveSnapshot;
+
+typedef struct LoadSaveSnapshotStats {
+    unsigned int snapshots;
+    unsigned int restores;
+
+    // Duration of last snapshot and restore (in ms).
+    double lastSnapshotTime;
+    double lastRestoreTime;
+
+    // Size of last snapshot in bytes.
+    size_t lastSnapshotSize;
+} LoadSaveSnapshotStats;
+
 void InitLoadSave();
 void ResetLoadSave();
 int SaveGame(int mode);
@@ -27,6 +45,9 @@ int isLoadingGame();
 void KillOldMaps();
 int MapDirErase(const char* path, const char* a2);
 int MapDirEraseFile(const char* a1, const char* a2);
+void LoadSaveProcessAsync();
+void LoadSaveWaitAsync();
+void LoadSaveSetAsyncCallback(LoadSaveAsyncProc* proc, void* userData);
 
 // Agent bridge helpers for non-interactive save/load.
 int agentLoadSaveSaveToSlot(int slot, const char* description);
@@ -36,6 +57,14 @@ int agentLoadSaveQuickLoad();
 int agentLoadSaveGetCurrentSlot();
 bool agentLoadSaveIsLoadScreenActive();
 int agentLoadSaveLoadSlotFromLoadScreen(int slot);
+bool agentLoadSaveGetAsyncStatus(int* slotPtr, int* resultPtr);
+LoadSaveSnapshot* agentLoadSaveSnapshot();
+int agentLoadSaveRestore(const LoadSaveSnapshot* snapshot);
+void agentLoadSaveFreeSnapshot(LoadSaveSnapshot* snapshot);
+size_t agentLoadSaveGetSnapshotSize(const LoadSaveSnapshot* snapshot);
+void agentLoadSaveGetSnapshotStats(LoadSaveSnapshotStats* stats);
+unsigned char* agentLoadSaveSerializeSnapshot(const LoadSaveSnapshot* snapshot, size_t* sizePtr);
+LoadSaveSnapshot* agentLoadSaveDeserializeSnapshot(const unsigned char* data, size_t size);
 
 } // namespace fallout
 
@@ -0,0 +1,336 @@
+#include "game/lockstep.h"
+
+#include <string.h>
+
+#include <chrono>
+
+#include <SDL.h>
+
+#include "plib/gnw/debug.h"
+#include "plib/gnw/vclock.h"
+
+namespace fallout {
+
+static void lockstep_sync_clock(bool enabled);
+
+// Guards everything below which is shared with controller thread.
+static SDL_mutex* lockstep_mutex = NULL;
+
+// Signalled when batch is submitted, tick is completed, or lockstep is
+// disabled.
+static SDL_cond* lockstep_cond = NULL;
+
+static bool lockstep_enabled = false;
+
+// Batch waiting for next tick.
+static LockstepBatchProc* lockstep_pending_proc = NULL;
+static void* lockstep_pending_user_data = NULL;
+static bool lockstep_pending = false;
+
+// Number of ticks started and completed.
+static unsigned int lockstep_started = 0;
+static unsigned int lockstep_completed = 0;
+
+static LockstepIdleProc* lockstep_idle_proc = NULL;
+static void* lockstep_idle_user_data = NULL;
+
+static LockstepStats lockstep_stats;
+
+// Main thread only.
+static bool lockstep_tick_running = false;
+static bool lockstep_clock_stepped = false;
+static std::chrono::steady_clock::time_point lockstep_tick_start;
+
+bool lockstep_init()
+{
+    lockstep_mutex = SDL_CreateMutex();
+    if (lockstep_mutex == NULL) {
+        return false;
+    }
+
+    lockstep_cond = SDL_CreateCond();
+    if (lockstep_cond == NULL) {
+        SDL_DestroyMutex(lockstep_mutex);
+        lockstep_mutex = NULL;
+        return false;
+    }
+
+    lockstep_enabled = false;
+    lockstep_pending = false;
+    lockstep_started = 0;
+    lockstep_completed = 0;
+    lockstep_tick_running = false;
+    memset(&lockstep_stats, 0, sizeof(lockstep_stats));
+
+    return true;
+}
+
+// Releases controller waiting in `lockstep_wait`.
+void lockstep_exit()
+{
+    if (lockstep_mutex == NULL) {
+        return;
+    }
+
+    lockstep_set_enabled(false);
+    lockstep_sync_clock(false);
+
+    SDL_DestroyCond(lockstep_cond);
+    lockstep_cond = NULL;
+
+    SDL_DestroyMutex(lockstep_mutex);
+    lockstep_mutex = NULL;
+}
+
+// Switches clock to stepped mode for the duration of lockstep, and back to
+// previous mode afterwards. Clock belongs to main thread, so this happens at
+// tick boundary rather than in `lockstep_set_enabled`.
+static void lockstep_sync_clock(bool enabled)
+{
+    static VClockMode savedMode = VCLOCK_MODE_REAL;
+    static bool savedFrameStep = true;
+
+    if (enabled == lockstep_clock_stepped) {
+        return;
+    }
+
+    if (enabled) {
+        savedMode = vclock_get_mode();
+        savedFrameStep = vclock_get_frame_step();
+        vclock_set_frame_step(true);
+        vclock_set_mode(VCLOCK_MODE_STEPPED);
+    } else {
+        vclock_set_frame_step(savedFrameStep);
+        vclock_set_mode(savedMode);
+    }
+
+    lockstep_clock_stepped = enabled;
+}
+
+// Enables or disables lockstep mode. While enabled main loop runs one tick per
+// submitted batch and clock is stepped by one frame per tick, so every tick
+// sees the same game time regardless of how long controller takes. Can be
+// called from any thread.
+void lockstep_set_enabled(bool enabled)
+{
+    if (lockstep_mutex == NULL) {
+        return;
+    }
+
+    SDL_LockMutex(lockstep_mutex);
+
+    if (enabled != lockstep_enabled) {
+        if (!enabled) {
+            // Batch that never ran.
+            lockstep_pending = false;
+            lockstep_pending_proc = NULL;
+            lockstep_pending_user_data = NULL;
+        }
+
+        lockstep_enabled = enabled;
+        SDL_CondBroadcast(lockstep_cond);
+    }
+
+    SDL_UnlockMutex(lockstep_mutex);
+
+    debug_printf("lockstep: %s\n", enabled ? "enabled" : "disabled");
+}
+
+bool lockstep_is_enabled()
+{
+    return lockstep_enabled;
+}
+
+void lockstep_set_idle_proc(LockstepIdleProc* proc, void* userData)
+{
+    if (lockstep_mutex == NULL) {
+        return;
+    }
+
+    SDL_LockMutex(lockstep_mutex);
+    lockstep_idle_proc = proc;
+    lockstep_idle_user_data = userData;
+    SDL_UnlockMutex(lockstep_mutex);
+}
+
+// Submits batch for next tick. Returns number of tick which is going to run
+// the batch (to be passed to `lockstep_wait`), or -1 if lockstep is disabled
+// or previous batch has not been picked up yet.
+int lockstep_submit(LockstepBatchProc* proc, void* userData)
+{
+    if (lockstep_mutex == NULL) {
+        return -1;
+    }
+
+    SDL_LockMutex(lockstep_mutex);
+
+    if (!lockstep_enabled || lockstep_pending) {
+        SDL_UnlockMutex(lockstep_mutex);
+        return -1;
+    }
+
+    lockstep_pending_proc = proc;
+    lockstep_pending_user_data = userData;
+    lockstep_pending = true;
+
+    int tick = lockstep_started + 1;
+
+    SDL_CondBroadcast(lockstep_cond);
+    SDL_UnlockMutex(lockstep_mutex);
+
+    return tick;
+}
+
+// Waits until given tick is completed. `timeout` is in ms, -1 waits forever.
+// Returns `false` on timeout or when lockstep is disabled before tick
+// completes.
+bool lockstep_wait(unsigned int tick, int timeout)
+{
+    if (lockstep_mutex == NULL) {
+        return false;
+    }
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout);
+
+    SDL_LockMutex(lockstep_mutex);
+
+    while (lockstep_enabled && lockstep_completed < tick) {
+        if (timeout < 0) {
+            SDL_CondWait(lockstep_cond, lockstep_mutex);
+        } else {
+            auto now = std::chrono::steady_clock::now();
+            if (now >= deadline) {
+                break;
+            }
+
+            Uint32 remaining = static_cast<Uint32>(std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now).count());
+            SDL_CondWaitTimeout(lockstep_cond, lockstep_mutex, remaining != 0 ? remaining : 1);
+        }
+    }
+
+    bool completed = lockstep_completed >= tick;
+
+    SDL_UnlockMutex(lockstep_mutex);
+
+    return completed;
+}
+
+// Returns number of completed ticks.
+unsigned int lockstep_get_tick()
+{
+    if (lockstep_mutex == NULL) {
+        return 0;
+    }
+
+    SDL_LockMutex(lockstep_mutex);
+    unsigned int tick = lockstep_completed;
+    SDL_UnlockMutex(lockstep_mutex);
+
+    return tick;
+}
+
+void lockstep_get_stats(LockstepStats* stats)
+{
+    if (lockstep_mutex == NULL) {
+        memset(stats, 0, sizeof(*stats));
+        return;
+    }
+
+    SDL_LockMutex(lockstep_mutex);
+    *stats = lockstep_stats;
+    SDL_UnlockMutex(lockstep_mutex);
+}
+
+// Called by main loop at the start of each iteration. Blocks until next batch
+// is submitted and applies it. Returns `false` without blocking when lockstep
+// is disabled (or becomes disabled while waiting), in this case loop runs
+// freely and `lockstep_end_tick` does nothing.
+bool lockstep_begin_tick()
+{
+    if (lockstep_mutex == NULL) {
+        return false;
+    }
+
+    if (!lockstep_enabled) {
+        lockstep_sync_clock(false);
+        return false;
+    }
+
+    auto waitStart = std::chrono::steady_clock::now();
+
+    SDL_LockMutex(lockstep_mutex);
+
+    while (lockstep_enabled && !lockstep_pending) {
+        if (lockstep_idle_proc != NULL) {
+            LockstepIdleProc* idleProc = lockstep_idle_proc;
+            void* idleUserData = lockstep_idle_user_data;
+
+            SDL_UnlockMutex(lockstep_mutex);
+            idleProc(idleUserData);
+            SDL_LockMutex(lockstep_mutex);
+
+            if (lockstep_enabled && !lockstep_pending) {
+                SDL_CondWaitTimeout(lockstep_cond, lockstep_mutex, 1);
+            }
+        } else {
+            SDL_CondWait(lockstep_cond, lockstep_mutex);
+        }
+    }
+
+    if (!lockstep_enabled) {
+        SDL_UnlockMutex(lockstep_mutex);
+        lockstep_sync_clock(false);
+        return false;
+    }
+
+    LockstepBatchProc* proc = lockstep_pending_proc;
+    void* userData = lockstep_pending_user_data;
+    lockstep_pending_proc = NULL;
+    lockstep_pending_user_data = NULL;
+    lockstep_pending = false;
+    lockstep_started++;
+
+    lockstep_tick_start = std::chrono::steady_clock::now();
+    lockstep_stats.lastWaitTime = std::chrono::duration<double, std::milli>(lockstep_tick_start - waitStart).count();
+
+    SDL_UnlockMutex(lockstep_mutex);
+
+    lockstep_sync_clock(true);
+    lockstep_tick_running = true;
+
+    if (proc != NULL) {
+        proc(userData);
+    }
+
+    return true;
+}
+
+// Called by main loop at the end of iteration started with
+// `lockstep_begin_tick`. Records tick time and releases controller waiting
+// for this tick.
+void lockstep_end_tick()
+{
+    if (!lockstep_tick_running) {
+        return;
+    }
+
+    lockstep_tick_running = false;
+
+    double tickTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - lockstep_tick_start).count();
+
+    SDL_LockMutex(lockstep_mutex);
+
+    lockstep_completed++;
+
+    lockstep_stats.ticks = lockstep_completed;
+    lockstep_stats.lastTickTime = tickTime;
+    lockstep_stats.totalTickTime += tickTime;
+    if (tickTime > lockstep_stats.maxTickTime) {
+        lockstep_stats.maxTickTime = tickTime;
+    }
+
+    SDL_CondBroadcast(lockstep_cond);
+    SDL_UnlockMutex(lockstep_mutex);
+}
+
+} // namespace fallout
@@ -0,0 +1,40 @@
+#ifndef FALLOUT_GAME_LOCKSTEP_H_
+#define FALLOUT_GAME_LOCKSTEP_H_
+
+namespace fallout {
+
+// Applies batch of commands on main thread right before tick runs.
+typedef void LockstepBatchProc(void* userData);
+
+// Called repeatedly on main thread while it waits for next batch. Lets
+// controller running on main thread poll its input.
+typedef void LockstepIdleProc(void* userData);
+
+typedef struct LockstepStats {
+    // Number of completed ticks.
+    unsigned int ticks;
+
+    // Duration of last tick, from applying batch until end of tick (in ms).
+    double lastTickTime;
+    double maxTickTime;
+    double totalTickTime;
+
+    // Time main thread spent waiting for last batch (in ms).
+    double lastWaitTime;
+} LockstepStats;
+
+bool lockstep_init();
+void lockstep_exit();
+void lockstep_set_enabled(bool enabled);
+bool lockstep_is_enabled();
+void lockstep_set_idle_proc(LockstepIdleProc* proc, void* userData);
+int lockstep_submit(LockstepBatchProc* proc, void* userData);
+bool lockstep_wait(unsigned int tick, int timeout);
+unsigned int lockstep_get_tick();
+void lockstep_get_stats(LockstepStats* stats);
+bool lockstep_begin_tick();
+void lockstep_end_tick();
+
+} // namespace fallout
+
+#endif /* FALLOUT_GAME_LOCKSTEP_H_ */
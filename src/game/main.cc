@@ -12,9 +12,12 @@
 
 #include <limits.h>
 #include <stddef.h>
+#include <stdio.h>
 
 #include "game/amutex.h"
 #include "game/art.h"
+#include "game/cachestat.h"
+#include "game/cmdbatch.h"
 #include "game/credits.h"
 #include "game/cycle.h"
 #include "game/endgame.h"
@@ -24,6 +27,7 @@
 #include "game/gmovie.h"
 #include "game/gsound.h"
 #include "game/loadsave.h"
+#include "game/lockstep.h"
 #include "game/mainmenu.h"
 #include "game/map.h"
 #include "game/object.h"
@@ -36,12 +40,14 @@
 #include "game/selfrun.h"
 #include "game/wordwrap.h"
 #include "game/worldmap.h"
+#include "platform_compat.h"
 #include "plib/color/color.h"
 #include "plib/gnw/debug.h"
 #include "plib/gnw/gnw.h"
 #include "plib/gnw/grbuf.h"
 #include "plib/gnw/input.h"
 #include "plib/gnw/intrface.h"
+#include "plib/gnw/prof.h"
 #include "plib/gnw/svga.h"
 #include "plib/gnw/text.h"
 
@@ -65,6 +71,7 @@ static bool main_selfrun_init();
 static void main_selfrun_exit();
 static void main_selfrun_record();
 static void main_selfrun_play();
+static int main_selfrun_benchmark(const char* name);
 static void main_death_scene();
 static void main_death_voiceover_callback();
 
@@ -100,6 +107,31 @@ int gnw_main(int argc, char** argv)
         return 1;
     }
 
+    // CE: Benchmark mode replays recordings and quits.
+    char* benchmark;
+    if (config_get_string(&game_config, GAME_CONFIG_DEBUG_KEY, GAME_CONFIG_SELFRUN_BENCH_KEY, &benchmark) && benchmark[0] != '\0') {
+        int rc = main_selfrun_benchmark(benchmark);
+
+        // NOTE: Uninline.
+        main_exit_system();
+
+        autorun_mutex_destroy();
+
+        return rc;
+    }
+
+    // CE: Movie benchmark mode decodes cutscenes and quits.
+    if (config_get_string(&game_config, GAME_CONFIG_DEBUG_KEY, GAME_CONFIG_MOVIE_BENCH_KEY, &benchmark) && benchmark[0] != '\0') {
+        int rc = gmovie_benchmark(benchmark);
+
+        // NOTE: Uninline.
+        main_exit_system();
+
+        autorun_mutex_destroy();
+
+        return rc;
+    }
+
     gmovie_play(MOVIE_IPLOGO, GAME_MOVIE_FADE_IN);
     gmovie_play(MOVIE_INTRO, 0);
 
@@ -353,11 +385,27 @@ static void main_game_loop()
     scr_enable();
 
     while (game_user_wants_to_quit == 0) {
+        // CE: In lockstep mode wait for controller to submit next batch, then
+        // run exactly one tick.
+        bool lockstep = lockstep_begin_tick();
+
         sharedFpsLimiter.mark();
 
         int keyCode = get_input();
         game_handle_input(keyCode, false);
 
+        // CE: Run queued controller commands.
+        cmdbatch_process();
+
+        // CE: Commit art loaded in background.
+        art_preload_process();
+
+        // CE: Periodic cache stats publishing.
+        cachestat_process();
+
+        // CE: Finalize background save.
+        LoadSaveProcessAsync();
+
         scripts_check_state();
 
         map_check_state();
@@ -373,6 +421,10 @@ static void main_game_loop()
 
         renderPresent();
         sharedFpsLimiter.throttle();
+
+        if (lockstep) {
+            lockstep_end_tick();
+        }
     }
 
     scr_disable();
@@ -513,6 +565,112 @@ static void main_selfrun_play()
     toggle = 1 - toggle;
 }
 
+// CE: Replays selfrun recording `name` (or every recording when `name` is
+// "all") with `selfrun_benchmark_loop`. Summary goes to `selfrun_bench.txt`,
+// subsystem zones of every recording to `<recording>.prof.txt` (both next to
+// the executable). Returns non-zero if any recording failed or its final
+// state does not match the stored one.
+static int main_selfrun_benchmark(const char* name)
+{
+    FILE* stream = compat_fopen("selfrun_bench.txt", "wt");
+    if (stream == NULL) {
+        return 1;
+    }
+
+    bool profiling = prof_enabled;
+    bool turbo = is_turbo_mode();
+    bool skipPresent = turbo_skips_present();
+    int played = 0;
+    int failed = 0;
+
+    for (int index = 0; index < main_selfrun_count; index++) {
+        const char* fileName = main_selfrun_list[index];
+        if (compat_stricmp(name, "all") != 0 && compat_stricmp(name, fileName) != 0) {
+            continue;
+        }
+
+        played++;
+
+        SelfrunData selfrunData;
+        if (selfrun_prep_playback(fileName, &selfrunData) != 0) {
+            fprintf(stream, "%s: unable to load\n", fileName);
+            failed++;
+            continue;
+        }
+
+        gsound_background_stop();
+
+        // Map is loaded on virtual clock too, so that timed events are
+        // scheduled the same way on every run.
+        set_turbo_mode(true, svga_is_headless());
+        roll_set_seed(0xBEEFFEED);
+
+        // NOTE: Uninline.
+        main_reset_system();
+
+        proto_dude_init("premade\\combat.gcd");
+
+        prof_set_enabled(true);
+        prof_reset();
+
+        main_load_new(selfrunData.mapFileName);
+
+        SelfrunBenchResult result;
+        int rc = selfrun_benchmark_loop(&selfrunData, &result);
+
+        char path[COMPAT_MAX_PATH];
+        snprintf(path, sizeof(path), "%s.prof.txt", selfrunData.recordingFileName);
+        prof_dump_table(path);
+
+        // NOTE: Uninline.
+        main_unload_new();
+
+        // NOTE: Uninline.
+        main_reset_system();
+
+        if (rc == -1) {
+            fprintf(stream, "%s: unable to play\n", fileName);
+            failed++;
+            continue;
+        }
+
+        const char* verdict;
+        if (!result.hasExpectedHash) {
+            verdict = result.hashSaved ? "hash saved" : "hash not saved";
+        } else if (rc == 0) {
+            verdict = "ok";
+        } else {
+            verdict = "MISMATCH";
+            failed++;
+        }
+
+        fprintf(stream, "%s: %u frames, %u ms game time, %.1f ms wall time, %.3f ms/frame, hash %016llx (%s)\n",
+            fileName,
+            result.frames,
+            result.gameTime,
+            result.wallTime,
+            result.frames != 0 ? result.wallTime / result.frames : 0.0,
+            result.hash,
+            verdict);
+        debug_printf("selfrun benchmark %s: %u frames, %.1f ms, %s\n", fileName, result.frames, result.wallTime, verdict);
+    }
+
+    if (played == 0) {
+        fprintf(stream, "%s: no such recording\n", name);
+        failed++;
+    }
+
+    fclose(stream);
+
+    set_turbo_mode(turbo, skipPresent);
+
+    if (!profiling) {
+        prof_set_enabled(false);
+    }
+
+    return failed != 0 ? 1 : 0;
+}
+
 // 0x472D90
 static void main_death_scene()
 {
@@ -574,7 +732,7 @@ static void main_death_scene()
                 loadColorTable("art\\intrface\\death.pal");
                 palette_fade_to(cmap);
 
-                int deathFileNameIndex = roll_random(1, sizeof(deathFileNameList) / sizeof(*deathFileNameList)) - 1;
+                int deathFileNameIndex = roll_random_stream(ROLL_STREAM_COSMETIC, 1, sizeof(deathFileNameList) / sizeof(*deathFileNameList)) - 1;
 
                 main_death_voiceover_done = false;
                 gsound_speech_callback_set(main_death_voiceover_callback);
@@ -3,6 +3,9 @@
 #include <stdio.h>
 #include <string.h>
 
+#include <algorithm>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "game/anim.h"
@@ -20,6 +23,8 @@
 #include "game/item.h"
 #include "game/light.h"
 #include "game/loadsave.h"
+#include "game/mapmem.h"
+#include "game/mapstat.h"
 #include "game/object.h"
 #include "game/palette.h"
 #include "game/pipboy.h"
@@ -28,6 +33,7 @@
 #include "game/queue.h"
 #include "game/roll.h"
 #include "game/scripts.h"
+#include "game/statever.h"
 #include "game/textobj.h"
 #include "game/tile.h"
 #include "game/worldmap.h"
@@ -43,6 +49,17 @@
 
 namespace fallout {
 
+// CE: Serialized state of visited map, see `map_store`.
+typedef struct MapStoreEntry {
+    unsigned char* data;
+    size_t size;
+
+    // Specifies whether state is newer than its `.SAV` file.
+    bool dirty;
+
+    unsigned int lastUse;
+} MapStoreEntry;
+
 static int map_age_dead_critters();
 static void map_match_map_number();
 static void map_display_draw(Rect* rect);
@@ -60,6 +77,13 @@ static void square_reset();
 static int square_load(DB_FILE* stream, int a2);
 static int map_write_MapData(MapHeader* ptr, DB_FILE* stream);
 static int map_read_MapData(MapHeader* ptr, DB_FILE* stream);
+static std::string map_store_key(const char* name);
+static MapStoreEntry* map_store_find(const char* name);
+static int map_store_put(const char* name, unsigned char* data, size_t size);
+static void map_store_erase(const char* name);
+static int map_store_write_entry(const std::string& name, MapStoreEntry* entry);
+static void map_store_trim();
+static void map_state_touch(const char* name);
 
 // 0x4735CE
 static const short city_vs_city_idx_table[MAP_COUNT][5] = {
@@ -270,6 +294,36 @@ int display_win;
 static std::vector<void*> map_global_pointers;
 static std::vector<void*> map_local_pointers;
 
+// CE: Number of local vars `map_local_vars` has room for, grows
+// geometrically so that adding scripts does not reallocate every time.
+static int map_local_vars_capacity = 0;
+
+// CE: Offsets of local var blocks released by removed scripts keyed by block
+// length. Released blocks stay in place (so offsets of other scripts never
+// change) and are handed out to new scripts with the same number of vars.
+// Holes are squeezed out with `scr_pack_local_vars` before map is saved.
+static std::unordered_map<int, std::vector<int>> map_free_local_var_blocks;
+
+// CE: Saved states of visited maps keyed by uppercased `.SAV` name. States
+// are written to `MAPS\*.SAV` only when a game is saved (see
+// `map_store_flush`) or when they are evicted to keep the store within its
+// capacity.
+static std::unordered_map<std::string, MapStoreEntry> map_store;
+
+// Capacity of the store in bytes (0 - disabled, states are always written
+// to disk).
+static size_t map_store_capacity = 0;
+
+static size_t map_store_size = 0;
+static unsigned int map_store_clock = 0;
+
+// CE: Versions of saved states keyed by uppercased `.SAV` name. Version is
+// changed every time state is rewritten with different contents, so that
+// save slots can skip copying states which are unchanged since the slot was
+// written (see `map_state_version`).
+static std::unordered_map<std::string, unsigned int> map_state_versions;
+static unsigned int map_state_clock = 0;
+
 // 0x4738E8
 int iso_init()
 {
@@ -389,6 +443,14 @@ void map_init()
         debug_printf("\nError initing map_msg_file!");
     }
 
+    // CE: In-memory map states.
+    int storeSize;
+    if (config_get_value(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_MAP_STORE_SIZE_KEY, &storeSize) && storeSize > 0) {
+        map_store_capacity = (size_t)storeSize * 1024;
+    } else {
+        map_store_capacity = 0;
+    }
+
     // NOTE: Uninline.
     map_reset();
 }
@@ -411,6 +473,10 @@ void map_exit()
     if (!message_exit(&map_msg_file)) {
         debug_printf("\nError exiting map_msg_file!");
     }
+
+    // CE: Saved states are erased on next start anyway.
+    map_store_clear();
+    map_store_capacity = 0;
 }
 
 // 0x473CDC
@@ -444,6 +510,11 @@ bool map_disable_bk_processes()
     return true;
 }
 
+bool map_bk_processes_enabled()
+{
+    return map_bk_enabled;
+}
+
 // 0x473D5C
 int map_set_elevation(int elevation)
 {
@@ -495,6 +566,8 @@ int map_set_global_var(int var, ProgramValue& value)
         map_global_pointers[var] = nullptr;
     }
 
+    statever_bump(STATE_VERSION_GLOBALS);
+
     return 0;
 }
 
@@ -560,22 +633,75 @@ int map_get_local_var(int var, ProgramValue& value)
 // 0x473EA8
 int map_malloc_local_var(int a1)
 {
+    // CE: Reuse block released by removed script.
+    auto it = map_free_local_var_blocks.find(a1);
+    if (it != map_free_local_var_blocks.end() && !it->second.empty()) {
+        int offset = it->second.back();
+        it->second.pop_back();
+
+        memset(map_local_vars + offset, 0, sizeof(*map_local_vars) * a1);
+        std::fill(map_local_pointers.begin() + offset, map_local_pointers.begin() + offset + a1, nullptr);
+
+        return offset;
+    }
+
     int oldMapLocalVarsLength = num_map_local_vars;
-    num_map_local_vars += a1;
 
-    int* vars = (int*)mem_realloc(map_local_vars, sizeof(*vars) * num_map_local_vars);
-    if (vars == NULL) {
-        debug_printf("\nError: Ran out of memory!");
+    if (oldMapLocalVarsLength + a1 > map_local_vars_capacity) {
+        int capacity = std::max(oldMapLocalVarsLength + a1, map_local_vars_capacity * 2);
+        int* vars = (int*)mem_realloc(map_local_vars, sizeof(*vars) * capacity);
+        if (vars == NULL) {
+            debug_printf("\nError: Ran out of memory!");
+            return -1;
+        }
+
+        map_local_vars = vars;
+        map_local_vars_capacity = capacity;
     }
 
-    map_local_vars = vars;
-    memset((unsigned char*)vars + sizeof(*vars) * oldMapLocalVarsLength, 0, sizeof(*vars) * a1);
+    num_map_local_vars += a1;
+    memset(map_local_vars + oldMapLocalVarsLength, 0, sizeof(*map_local_vars) * a1);
 
     map_local_pointers.resize(num_map_local_vars);
 
     return oldMapLocalVarsLength;
 }
 
+// CE: Releases block of local vars allocated with `map_malloc_local_var` for
+// reuse. Offsets of other blocks are not affected.
+void map_free_local_var(int offset, int count)
+{
+    if (offset < 0 || count <= 0 || offset + count > num_map_local_vars) {
+        return;
+    }
+
+    map_free_local_var_blocks[count].push_back(offset);
+}
+
+// CE: Moves block of local vars to lower offset, used by
+// `scr_pack_local_vars`.
+void map_move_local_vars(int dest, int src, int count)
+{
+    if (dest == src || count <= 0) {
+        return;
+    }
+
+    memmove(map_local_vars + dest, map_local_vars + src, sizeof(*map_local_vars) * count);
+    std::copy(map_local_pointers.begin() + src, map_local_pointers.begin() + src + count, map_local_pointers.begin() + dest);
+}
+
+// CE: Cuts local vars down to `count` once blocks are packed at the front
+// with `map_move_local_vars`. All released blocks are gone at this point.
+void map_trim_local_vars(int count)
+{
+    if (count < num_map_local_vars) {
+        num_map_local_vars = count;
+        map_local_pointers.resize(count);
+    }
+
+    map_free_local_var_blocks.clear();
+}
+
 // 0x473F14
 void map_set_entrance_hex(int tile, int elevation, int rotation)
 {
@@ -742,6 +868,13 @@ int map_scroll(int dx, int dy)
         return -1;
     }
 
+    // CE: Shifting display buffer is only valid when its contents match
+    // current view (ambient light, roofs, etc.). Otherwise redraw everything.
+    if (!tile_display_valid()) {
+        tile_refresh_display();
+        return 0;
+    }
+
     Rect r1;
     rectCopy(&r1, &map_display_rect);
 
@@ -800,6 +933,13 @@ int map_scroll(int dx, int dy)
 
     if (screenDx != 0) {
         map_scroll_refresh(&r2);
+
+        // CE: Corner shared by both strips is already rendered.
+        if (screenDx < 0) {
+            r1.ulx = r2.lrx + 1;
+        } else {
+            r1.lrx = r2.ulx - 1;
+        }
     }
 
     if (screenDy != 0) {
@@ -838,6 +978,7 @@ void map_new_map()
     map_data.name[0] = '\0';
     map_data.enteringTile = 20100;
     obj_remove_all();
+    mapmem_map_exit();
     anim_stop();
 
     // NOTE: Uninline.
@@ -861,27 +1002,43 @@ int map_load(char* file_name)
 
     compat_strupr(file_name);
 
+    // CE: Separate map transitions in db I/O trace.
+    db_trace_mark(file_name);
+
     rc = -1;
 
     extension = strstr(file_name, ".MAP");
     if (extension != NULL) {
         strcpy(extension, ".SAV");
 
-        file_path = map_file_path(file_name);
+        // CE: Saved state can be kept in memory.
+        bool saved = map_store_find(file_name) != NULL;
+        if (!saved) {
+            file_path = map_file_path(file_name);
+
+            stream = db_fopen(file_path, "rb");
+            saved = stream != NULL;
+            db_fclose(stream);
+        }
 
-        stream = db_fopen(file_path, "rb");
         strcpy(extension, ".MAP");
-        db_fclose(stream);
 
-        if (stream != NULL) {
+        if (saved) {
             rc = map_load_in_game(file_name);
             PlayCityMapMusic();
         }
     }
 
     if (rc == -1) {
-        file_path = map_file_path(file_name);
-        stream = db_fopen(file_path, "rb");
+        MapStoreEntry* entry = map_store_find(file_name);
+        if (entry != NULL) {
+            entry->lastUse = ++map_store_clock;
+            stream = db_fopen_memory(entry->data, entry->size);
+        } else {
+            file_path = map_file_path(file_name);
+            stream = db_fopen(file_path, "rb");
+        }
+
         if (stream != NULL) {
             rc = map_load_file(stream);
             db_fclose(stream);
@@ -918,6 +1075,9 @@ int map_load_idx(int map)
 // 0x47471C
 int map_load_file(DB_FILE* stream)
 {
+    MemTagScope memTagScope(MEM_TAG_MAP);
+    MapStatScope mapStatScope(MAP_STAT_PHASE_LOAD_FILE);
+
     int rc = 0;
     const char* error;
 
@@ -945,6 +1105,7 @@ int map_load_file(DB_FILE* stream)
         if (map_data.version != 19) break;
 
         obj_remove_all();
+        mapmem_map_exit();
 
         if (map_data.globalVariablesCount < 0) {
             map_data.globalVariablesCount = 0;
@@ -971,6 +1132,11 @@ int map_load_file(DB_FILE* stream)
 
         if (square_load(stream, map_data.flags) != 0) break;
 
+        // CE: Floor and roof art is known once squares are read, start
+        // loading it in background while scripts and objects are parsed.
+        // Object art is scheduled by `obj_load` as objects are read.
+        obj_prefetch_tile_art(map_data.flags);
+
         error = "Error reading scripts";
         if (scr_load(stream) != 0) break;
 
@@ -1077,6 +1243,9 @@ int map_load_file(DB_FILE* stream)
     gmouse_enable_scrolling();
     gmouse_set_cursor(MOUSE_CURSOR_NONE);
 
+    // Everything observed by controllers is replaced along with the map.
+    statever_bump_all();
+
     return rc;
 }
 
@@ -1116,10 +1285,10 @@ static int map_age_dead_critters()
         return 0;
     }
 
-    Object* obj = obj_find_first();
+    // CE: Visit critters only.
+    Object* obj = obj_find_first_of_type(OBJ_TYPE_CRITTER, -1);
     while (obj != NULL) {
-        if (PID_TYPE(obj->pid) == OBJ_TYPE_CRITTER
-            && obj != obj_dude
+        if (obj != obj_dude
             && !isPartyMember(obj)
             && !critter_is_dead(obj)) {
             obj->data.critter.combat.maneuver &= ~CRITTER_MANUEVER_FLEEING;
@@ -1127,7 +1296,7 @@ static int map_age_dead_critters()
                 critter_heal_hours(obj, hoursSinceLastVisit);
             }
         }
-        obj = obj_find_next();
+        obj = obj_find_next_of_type();
     }
 
     int agingType;
@@ -1139,45 +1308,42 @@ static int map_age_dead_critters()
         return 0;
     }
 
-    int capacity = 100;
-    int count = 0;
-    Object** objects = (Object**)mem_malloc(sizeof(*objects) * capacity);
+    // CE: Collect from per-type lists instead of walking every object on
+    // the map.
+    std::vector<Object*> objects;
 
-    obj = obj_find_first();
+    obj = obj_find_first_of_type(OBJ_TYPE_CRITTER, -1);
     while (obj != NULL) {
-        int type = PID_TYPE(obj->pid);
-        if (type == OBJ_TYPE_CRITTER) {
-            if (obj != obj_dude && critter_is_dead(obj)) {
-                if (critter_kill_count_type(obj) != KILL_TYPE_ROBOT) {
-                    objects[count++] = obj;
-
-                    if (count >= capacity) {
-                        capacity *= 2;
-                        objects = (Object**)mem_realloc(objects, sizeof(*objects) * capacity);
-                        if (objects == NULL) {
-                            debug_printf("\nError: Out of Memory!");
-                            return -1;
-                        }
-                    }
-                }
+        if (obj != obj_dude && critter_is_dead(obj)) {
+            if (critter_kill_count_type(obj) != KILL_TYPE_ROBOT) {
+                objects.push_back(obj);
             }
-        } else if (agingType == 2 && type == OBJ_TYPE_MISC && obj->pid == 0x500000B) {
-            objects[count++] = obj;
-            if (count >= capacity) {
-                capacity *= 2;
-                objects = (Object**)mem_realloc(objects, sizeof(*objects) * capacity);
-                if (objects == NULL) {
-                    debug_printf("\nError: Out of Memory!");
-                    return -1;
-                }
+        }
+        obj = obj_find_next_of_type();
+    }
+
+    if (agingType == 2) {
+        obj = obj_find_first_of_type(OBJ_TYPE_MISC, -1);
+        while (obj != NULL) {
+            if (obj->pid == 0x500000B) {
+                objects.push_back(obj);
             }
+            obj = obj_find_next_of_type();
         }
-        obj = obj_find_next();
     }
 
+    if (objects.empty()) {
+        return 0;
+    }
+
+    // CE: Replace bodies as one batch - light is rebuilt and window is
+    // redrawn once at the end instead of after every object.
+    bool refreshWasEnabled = tile_refresh_is_enabled();
+    tile_disable_refresh();
+    obj_light_batch_begin();
+
     int rc = 0;
-    for (int index = 0; index < count; index++) {
-        Object* obj = objects[index];
+    for (Object* obj : objects) {
         if (PID_TYPE(obj->pid) == OBJ_TYPE_CRITTER) {
             int blood_pid;
             if (obj->pid != 16777265 && obj->pid != 213 && obj->pid != 214) {
@@ -1198,7 +1364,7 @@ static int map_age_dead_critters()
             Proto* proto;
             proto_ptr(obj->pid, &proto);
 
-            int frame = roll_random(0, 3);
+            int frame = roll_random_stream(ROLL_STREAM_COSMETIC, 0, 3);
             if ((proto->critter.flags & 0x800)) {
                 frame += 6;
             } else {
@@ -1215,7 +1381,12 @@ static int map_age_dead_critters()
         obj_erase_object(obj, NULL);
     }
 
-    mem_free(objects);
+    obj_light_batch_end();
+
+    if (refreshWasEnabled) {
+        tile_enable_refresh();
+        tile_refresh_display();
+    }
 
     return rc;
 }
@@ -1309,15 +1480,8 @@ int map_check_state()
 // 0x475394
 void map_fix_critter_combat_data()
 {
-    for (Object* object = obj_find_first(); object != NULL; object = obj_find_next()) {
-        if (object->pid == -1) {
-            continue;
-        }
-
-        if (PID_TYPE(object->pid) != OBJ_TYPE_CRITTER) {
-            continue;
-        }
-
+    // CE: Visit critters only.
+    for (Object* object = obj_find_first_of_type(OBJ_TYPE_CRITTER, -1); object != NULL; object = obj_find_next_of_type()) {
         if (object->data.critter.combat.whoHitMeCid == -1) {
             object->data.critter.combat.whoHitMe = NULL;
         }
@@ -1341,11 +1505,36 @@ int map_save()
 
     int rc = -1;
     if (map_data.name[0] != '\0') {
-        char* mapFileName = map_file_path(map_data.name);
-        DB_FILE* stream = db_fopen(mapFileName, "wb");
+        // CE: Saved states are kept in memory when store is enabled.
+        bool stored = map_store_capacity != 0 && strstr(map_data.name, ".SAV") != NULL;
+
+        DB_FILE* stream;
+        if (stored) {
+            stream = db_fopen_memory_write();
+        } else {
+            char* mapFileName = map_file_path(map_data.name);
+            stream = db_fopen(mapFileName, "wb");
+        }
+
         if (stream != NULL) {
             rc = map_save_file(stream);
-            db_fclose(stream);
+
+            if (stored) {
+                size_t size;
+                unsigned char* data = db_fclose_memory(stream, &size);
+                if (rc == 0 && data != NULL) {
+                    rc = map_store_put(map_data.name, data, size);
+                } else {
+                    db_free_memory(data);
+                    rc = -1;
+                }
+            } else {
+                db_fclose(stream);
+
+                if (rc == 0) {
+                    map_state_touch(map_data.name);
+                }
+            }
         } else {
             snprintf(temp, sizeof(temp), "Unable to open %s to write!", map_data.name);
             debug_printf(temp);
@@ -1365,6 +1554,8 @@ int map_save()
 // 0x475590
 int map_save_file(DB_FILE* stream)
 {
+    MapStatScope mapStatScope(MAP_STAT_PHASE_SAVE_FILE);
+
     if (stream == NULL) {
         return -1;
     }
@@ -1408,6 +1599,10 @@ int map_save_file(DB_FILE* stream)
         }
     }
 
+    // CE: Squeeze out blocks of removed scripts, so saved local vars (and
+    // script offsets saved by `scr_save`) are contiguous as before.
+    scr_pack_local_vars();
+
     map_data.localVariablesCount = num_map_local_vars;
     map_data.globalVariablesCount = num_map_global_vars;
     map_data.darkness = 1;
@@ -1479,6 +1674,7 @@ int map_save_in_game(bool a1)
 
         strcpy(name, map_data.name);
         strmfe(map_data.name, name, "SAV");
+        map_store_erase(map_data.name);
         MapDirEraseFile("MAPS\\", map_data.name);
         strcpy(map_data.name, name);
     } else {
@@ -1498,6 +1694,7 @@ int map_save_in_game(bool a1)
     if (a1) {
         map_data.name[0] = '\0';
         obj_remove_all();
+        mapmem_map_exit();
         proto_remove_all();
         square_reset();
         gtime_q_add();
@@ -1524,6 +1721,169 @@ void map_setup_paths()
     compat_mkdir(path);
 }
 
+// CE: Writes saved states which are newer than their `.SAV` files, so that
+// `MAPS` directory reflects every visited map.
+int map_store_flush()
+{
+    int rc = 0;
+    for (auto& pair : map_store) {
+        if (pair.second.dirty && map_store_write_entry(pair.first, &(pair.second)) != 0) {
+            rc = -1;
+        }
+    }
+
+    return rc;
+}
+
+// CE: Discards all saved states kept in memory (`.SAV` files are erased
+// separately).
+void map_store_clear()
+{
+    for (auto& pair : map_store) {
+        db_free_memory(pair.second.data);
+    }
+
+    map_store.clear();
+    map_store_size = 0;
+
+    map_state_versions.clear();
+}
+
+// CE: Returns version of saved state of given map. Versions are only
+// meaningful within one session and are reset by `map_store_clear`, states
+// without version (for example copied from save slot) receive a new one.
+unsigned int map_state_version(const char* name)
+{
+    auto it = map_state_versions.find(map_store_key(name));
+    if (it == map_state_versions.end()) {
+        map_state_touch(name);
+        it = map_state_versions.find(map_store_key(name));
+    }
+
+    return it->second;
+}
+
+static std::string map_store_key(const char* name)
+{
+    char key[COMPAT_MAX_PATH];
+    strncpy(key, name, sizeof(key) - 1);
+    key[sizeof(key) - 1] = '\0';
+    compat_strupr(key);
+    return key;
+}
+
+static MapStoreEntry* map_store_find(const char* name)
+{
+    if (map_store.empty()) {
+        return NULL;
+    }
+
+    auto it = map_store.find(map_store_key(name));
+    if (it == map_store.end()) {
+        return NULL;
+    }
+
+    return &(it->second);
+}
+
+// Takes ownership of [data] (allocated by `db_fclose_memory`).
+static int map_store_put(const char* name, unsigned char* data, size_t size)
+{
+    MapStoreEntry& entry = map_store[map_store_key(name)];
+
+    // Revisiting map without changing anything produces identical state,
+    // keep version (and dirty flag) of the previous one.
+    if (entry.data != NULL && entry.size == size && memcmp(entry.data, data, size) == 0) {
+        db_free_memory(data);
+        entry.lastUse = ++map_store_clock;
+        return 0;
+    }
+
+    if (entry.data != NULL) {
+        map_store_size -= entry.size;
+        db_free_memory(entry.data);
+    }
+
+    entry.data = data;
+    entry.size = size;
+    entry.dirty = true;
+    entry.lastUse = ++map_store_clock;
+    map_store_size += size;
+
+    map_state_touch(name);
+    map_store_trim();
+
+    return 0;
+}
+
+static void map_store_erase(const char* name)
+{
+    map_state_versions.erase(map_store_key(name));
+
+    MapStoreEntry* entry = map_store_find(name);
+    if (entry == NULL) {
+        return;
+    }
+
+    map_store_size -= entry->size;
+    db_free_memory(entry->data);
+    map_store.erase(map_store_key(name));
+}
+
+static int map_store_write_entry(const std::string& name, MapStoreEntry* entry)
+{
+    char fileName[COMPAT_MAX_PATH];
+    snprintf(fileName, sizeof(fileName), "%s", name.c_str());
+
+    DB_FILE* stream = db_fopen(map_file_path(fileName), "wb");
+    if (stream == NULL) {
+        debug_printf("\nError: map_store: unable to open %s to write!", fileName);
+        return -1;
+    }
+
+    int rc = 0;
+    if (db_fwrite(entry->data, 1, entry->size, stream) != entry->size) {
+        rc = -1;
+    }
+
+    if (db_fclose(stream) != 0) {
+        rc = -1;
+    }
+
+    if (rc == 0) {
+        entry->dirty = false;
+    }
+
+    return rc;
+}
+
+// Evicts least recently used states (writing them to disk first) until the
+// store fits its capacity. The most recently used state is always kept.
+static void map_store_trim()
+{
+    while (map_store_size > map_store_capacity && map_store.size() > 1) {
+        auto victim = map_store.end();
+        for (auto it = map_store.begin(); it != map_store.end(); it++) {
+            if (victim == map_store.end() || it->second.lastUse < victim->second.lastUse) {
+                victim = it;
+            }
+        }
+
+        if (victim->second.dirty && map_store_write_entry(victim->first, &(victim->second)) != 0) {
+            break;
+        }
+
+        map_store_size -= victim->second.size;
+        db_free_memory(victim->second.data);
+        map_store.erase(victim);
+    }
+}
+
+static void map_state_touch(const char* name)
+{
+    map_state_versions[map_store_key(name)] = ++map_state_clock;
+}
+
 // 0x475AEC
 int map_match_map_name(const char* name)
 {
@@ -1551,6 +1911,70 @@ int map_match_map_name(const char* name)
     return -1;
 }
 
+// CE: Extracts map script and square art from contents of map file without
+// touching any game state, so it can be used from db prefetch thread. Format
+// matches `map_load_file` up to and including squares. Returns 0 on success,
+// or -1 if file is truncated or has unknown version.
+int map_scan_file(const unsigned char* data, size_t size, MapScanResult* result)
+{
+    // Size of header as read by `map_read_MapData`.
+    const size_t headerSize = 4 + 16 + 4 * 10 + 4 * 44;
+
+    memset(result, 0, sizeof(*result));
+
+    if (data == NULL || size < headerSize) {
+        return -1;
+    }
+
+    auto readInt = [data](size_t offset) {
+        return (int)(((unsigned int)data[offset] << 24)
+            | ((unsigned int)data[offset + 1] << 16)
+            | ((unsigned int)data[offset + 2] << 8)
+            | (unsigned int)data[offset + 3]);
+    };
+
+    if (readInt(0) != 19) {
+        return -1;
+    }
+
+    int localVariablesCount = readInt(32);
+    int flags = readInt(40);
+    int globalVariablesCount = readInt(48);
+
+    result->scriptIndex = readInt(36);
+
+    if (localVariablesCount < 0) {
+        localVariablesCount = 0;
+    }
+
+    if (globalVariablesCount < 0) {
+        globalVariablesCount = 0;
+    }
+
+    size_t offset = headerSize + 4 * ((size_t)globalVariablesCount + (size_t)localVariablesCount);
+
+    for (int elevation = 0; elevation < ELEVATION_COUNT; elevation++) {
+        if ((flags & map_data_elev_flags[elevation]) != 0) {
+            continue;
+        }
+
+        if (offset + 4 * SQUARE_GRID_SIZE > size) {
+            return -1;
+        }
+
+        for (int tile = 0; tile < SQUARE_GRID_SIZE; tile++) {
+            int value = readInt(offset);
+            int floor = value & 0xFFF;
+            int roof = (value >> 16) & 0xFFF;
+            result->tiles[floor / 8] |= 1 << (floor % 8);
+            result->tiles[roof / 8] |= 1 << (roof % 8);
+            offset += 4;
+        }
+    }
+
+    return 0;
+}
+
 // 0x475B70
 static void map_match_map_number()
 {
@@ -1610,7 +2034,7 @@ static void map_scroll_refresh_game(Rect* rect)
         rectGetWidth(&map_display_rect),
         0);
 
-    square_render_floor(&rectToUpdate, map_elevation);
+    square_render_floor_banded(&rectToUpdate, map_elevation);
     grid_render(&rectToUpdate, map_elevation);
     obj_render_pre_roof(&rectToUpdate, map_elevation);
     square_render_roof(&rectToUpdate, map_elevation);
@@ -1695,6 +2119,7 @@ static int map_allocate_local_vars(int count)
     }
 
     num_map_local_vars = count;
+    map_local_vars_capacity = count;
 
     return 0;
 }
@@ -1708,7 +2133,9 @@ static void map_free_local_vars()
         num_map_local_vars = 0;
     }
 
+    map_local_vars_capacity = 0;
     map_local_pointers.clear();
+    map_free_local_var_blocks.clear();
 }
 
 // 0x475E64
@@ -1728,6 +2155,9 @@ static void map_place_dude_and_mouse()
         if (FID_ANIM_TYPE(obj_dude->fid) != ANIM_STAND) {
             obj_set_frame(obj_dude, 0, 0);
             obj_dude->fid = art_id(OBJ_TYPE_CRITTER, obj_dude->fid & 0xFFF, ANIM_STAND, (obj_dude->fid & 0xF000) >> 12, obj_dude->rotation + 1);
+
+            // CE: Fid changed directly.
+            obj_update_hit_bounds(obj_dude);
         }
 
         if (obj_dude->tile == -1) {
@@ -1781,11 +2211,16 @@ static void square_reset()
             }
         }
     }
+
+    // CE: Squares are about to change.
+    tile_invalidate_squares();
 }
 
 // 0x476084
 static int square_load(DB_FILE* stream, int flags)
 {
+    MapStatScope mapStatScope(MAP_STAT_PHASE_SQUARE_LOAD);
+
     int v6;
     int v7;
     int v8;
@@ -1815,6 +2250,9 @@ static int square_load(DB_FILE* stream, int flags)
         }
     }
 
+    // CE: Squares have changed.
+    tile_invalidate_squares();
+
     return 0;
 }
 
@@ -57,6 +57,15 @@ typedef struct MapHeader {
     int field_3C[44];
 } MapHeader;
 
+// CE: Parts of map file needed to warm caches before the map is loaded (see
+// `map_scan_file`).
+typedef struct MapScanResult {
+    int scriptIndex;
+
+    // Bit per floor or roof art index used by squares.
+    unsigned char tiles[4096 / 8];
+} MapScanResult;
+
 typedef struct MapTransition {
     int map;
     int elevation;
@@ -89,6 +98,7 @@ void map_reset();
 void map_exit();
 void map_enable_bk_processes();
 bool map_disable_bk_processes();
+bool map_bk_processes_enabled();
 int map_set_elevation(int elevation);
 bool map_is_elevation_empty(int elevation);
 int map_set_global_var(int var, ProgramValue& value);
@@ -96,6 +106,9 @@ int map_get_global_var(int var, ProgramValue& value);
 int map_set_local_var(int var, ProgramValue& value);
 int map_get_local_var(int var, ProgramValue& value);
 int map_malloc_local_var(int a1);
+void map_free_local_var(int offset, int count);
+void map_move_local_vars(int dest, int src, int count);
+void map_trim_local_vars(int count);
 void map_set_entrance_hex(int a1, int a2, int a3);
 void map_set_name(const char* name);
 void map_get_name(char* name);
@@ -121,7 +134,11 @@ int map_save();
 int map_save_file(DB_FILE* stream);
 int map_save_in_game(bool a1);
 void map_setup_paths();
+int map_store_flush();
+void map_store_clear();
+unsigned int map_state_version(const char* name);
 int map_match_map_name(const char* name);
+int map_scan_file(const unsigned char* data, size_t size, MapScanResult* result);
 
 } // namespace fallout
 
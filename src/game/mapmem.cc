@@ -0,0 +1,234 @@
+#include "game/mapmem.h"
+
+#include <string.h>
+
+#include "plib/gnw/debug.h"
+#include "plib/gnw/memory.h"
+
+namespace fallout {
+
+// Alignment of pool items.
+#define MAPMEM_ALIGNMENT 16
+
+#define MAPMEM_ALIGN(size) (((size) + MAPMEM_ALIGNMENT - 1) & ~((size_t)MAPMEM_ALIGNMENT - 1))
+
+// Header of a pool block, followed by `capacity` slots.
+struct MapMemBlock {
+    MapMemBlock* next;
+
+    // Number of slots handed out.
+    int live;
+
+    int capacity;
+
+    // Size of the block in bytes (including this header).
+    size_t size;
+};
+
+// Header of a pool slot, followed by item. While slot is free first bytes of
+// item link it to the next free slot.
+struct MapMemSlot {
+    MapMemBlock* block;
+};
+
+#define MAPMEM_BLOCK_HEADER_SIZE MAPMEM_ALIGN(sizeof(MapMemBlock))
+#define MAPMEM_SLOT_HEADER_SIZE MAPMEM_ALIGN(sizeof(MapMemSlot))
+
+static size_t mapmem_slot_size(MapMemPool* pool);
+static bool mapmem_pool_grow(MapMemPool* pool);
+static unsigned char* mapmem_slot_data(MapMemSlot* slot);
+static MapMemSlot** mapmem_slot_next(MapMemSlot* slot);
+
+static const char* mapmem_subsystem_names[MAPMEM_SUBSYSTEM_COUNT] = {
+    "objects",
+    "object_nodes",
+    "scripts",
+    "attacks",
+};
+
+static MapMemStats mapmem_stats[MAPMEM_SUBSYSTEM_COUNT];
+
+// Pools trimmed on map exit (registered on first allocation).
+static MapMemPool* mapmem_pools = NULL;
+
+static size_t mapmem_slot_size(MapMemPool* pool)
+{
+    size_t itemSize = pool->itemSize;
+    if (itemSize < sizeof(MapMemSlot*)) {
+        itemSize = sizeof(MapMemSlot*);
+    }
+
+    return MAPMEM_SLOT_HEADER_SIZE + MAPMEM_ALIGN(itemSize);
+}
+
+static unsigned char* mapmem_slot_data(MapMemSlot* slot)
+{
+    return (unsigned char*)slot + MAPMEM_SLOT_HEADER_SIZE;
+}
+
+static MapMemSlot** mapmem_slot_next(MapMemSlot* slot)
+{
+    return (MapMemSlot**)mapmem_slot_data(slot);
+}
+
+// Adds block of free slots to pool.
+static bool mapmem_pool_grow(MapMemPool* pool)
+{
+    size_t slotSize = mapmem_slot_size(pool);
+    size_t size = MAPMEM_BLOCK_HEADER_SIZE + slotSize * pool->blockCapacity;
+
+    unsigned char* data = (unsigned char*)mem_malloc(size);
+    if (data == NULL) {
+        return false;
+    }
+
+    MapMemBlock* block = (MapMemBlock*)data;
+    block->live = 0;
+    block->capacity = pool->blockCapacity;
+    block->size = size;
+    block->next = pool->blocks;
+    pool->blocks = block;
+
+    // Link slots in address order, so items are handed out sequentially.
+    for (int index = pool->blockCapacity - 1; index >= 0; index--) {
+        MapMemSlot* slot = (MapMemSlot*)(data + MAPMEM_BLOCK_HEADER_SIZE + slotSize * index);
+        slot->block = block;
+        *mapmem_slot_next(slot) = pool->freeSlots;
+        pool->freeSlots = slot;
+    }
+
+    mapmem_account(pool->subsystem, 0, (long long)size);
+
+    return true;
+}
+
+// Returns uninitialized item, or NULL when out of memory.
+void* mapmem_pool_alloc(MapMemPool* pool)
+{
+    if (!pool->registered) {
+        pool->next = mapmem_pools;
+        mapmem_pools = pool;
+        pool->registered = true;
+    }
+
+    if (pool->freeSlots == NULL) {
+        if (!mapmem_pool_grow(pool)) {
+            return NULL;
+        }
+    }
+
+    MapMemSlot* slot = pool->freeSlots;
+    pool->freeSlots = *mapmem_slot_next(slot);
+    slot->block->live++;
+
+    mapmem_account(pool->subsystem, (long long)pool->itemSize, 0);
+
+    return mapmem_slot_data(slot);
+}
+
+// Returns item obtained from `mapmem_pool_alloc` of the same pool.
+void mapmem_pool_free(MapMemPool* pool, void* ptr)
+{
+    if (ptr == NULL) {
+        return;
+    }
+
+    MapMemSlot* slot = (MapMemSlot*)((unsigned char*)ptr - MAPMEM_SLOT_HEADER_SIZE);
+    slot->block->live--;
+    *mapmem_slot_next(slot) = pool->freeSlots;
+    pool->freeSlots = slot;
+
+    mapmem_account(pool->subsystem, -(long long)pool->itemSize, 0);
+}
+
+// Returns blocks without live items to heap.
+void mapmem_pool_trim(MapMemPool* pool)
+{
+    MapMemSlot** slotLink = &(pool->freeSlots);
+    while (*slotLink != NULL) {
+        MapMemSlot* slot = *slotLink;
+        if (slot->block->live == 0) {
+            *slotLink = *mapmem_slot_next(slot);
+        } else {
+            slotLink = mapmem_slot_next(slot);
+        }
+    }
+
+    MapMemBlock** blockLink = &(pool->blocks);
+    while (*blockLink != NULL) {
+        MapMemBlock* block = *blockLink;
+        if (block->live == 0) {
+            *blockLink = block->next;
+            mapmem_account(pool->subsystem, 0, -(long long)block->size);
+            mem_free(block);
+        } else {
+            blockLink = &(block->next);
+        }
+    }
+}
+
+// Adjusts accounting of subsystem by given number of bytes, positive `used`
+// counts as an allocation.
+void mapmem_account(int subsystem, long long used, long long reserved)
+{
+    if (subsystem < 0 || subsystem >= MAPMEM_SUBSYSTEM_COUNT) {
+        return;
+    }
+
+    MapMemStats* stats = &(mapmem_stats[subsystem]);
+    if (used > 0) {
+        stats->allocations++;
+    }
+
+    stats->used = (size_t)((long long)stats->used + used);
+    stats->reserved = (size_t)((long long)stats->reserved + reserved);
+
+    if (stats->used > stats->peakUsed) {
+        stats->peakUsed = stats->used;
+    }
+}
+
+// Releases map-scoped memory no longer in use. Called once objects and scripts
+// of the map being left are removed, what is left belongs to the objects
+// carried over (player, party members, their inventories).
+void mapmem_map_exit()
+{
+    for (MapMemPool* pool = mapmem_pools; pool != NULL; pool = pool->next) {
+        mapmem_pool_trim(pool);
+    }
+}
+
+const char* mapmem_subsystem_name(int subsystem)
+{
+    if (subsystem < 0 || subsystem >= MAPMEM_SUBSYSTEM_COUNT) {
+        return NULL;
+    }
+
+    return mapmem_subsystem_names[subsystem];
+}
+
+bool mapmem_get_stats(int subsystem, MapMemStats* stats)
+{
+    if (subsystem < 0 || subsystem >= MAPMEM_SUBSYSTEM_COUNT || stats == NULL) {
+        return false;
+    }
+
+    memcpy(stats, &(mapmem_stats[subsystem]), sizeof(*stats));
+
+    return true;
+}
+
+void mapmem_dump()
+{
+    for (int subsystem = 0; subsystem < MAPMEM_SUBSYSTEM_COUNT; subsystem++) {
+        MapMemStats* stats = &(mapmem_stats[subsystem]);
+        debug_printf("mapmem: %-12s used %9u (peak %9u), reserved %9u, %u allocations\n",
+            mapmem_subsystem_names[subsystem],
+            (unsigned int)stats->used,
+            (unsigned int)stats->peakUsed,
+            (unsigned int)stats->reserved,
+            stats->allocations);
+    }
+}
+
+} // namespace fallout
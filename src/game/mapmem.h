@@ -0,0 +1,68 @@
+#ifndef FALLOUT_GAME_MAPMEM_H_
+#define FALLOUT_GAME_MAPMEM_H_
+
+#include <stddef.h>
+
+namespace fallout {
+
+// Subsystems whose map-scoped allocations are accounted separately.
+typedef enum MapMemSubsystem {
+    MAPMEM_OBJECTS,
+    MAPMEM_OBJECT_NODES,
+    MAPMEM_SCRIPTS,
+    MAPMEM_ATTACKS,
+    MAPMEM_SUBSYSTEM_COUNT,
+} MapMemSubsystem;
+
+typedef struct MapMemStats {
+    // Bytes currently handed out to subsystem.
+    size_t used;
+
+    // Highest value of `used` so far.
+    size_t peakUsed;
+
+    // Bytes currently taken from heap on behalf of subsystem (including free
+    // pool slots and block headers).
+    size_t reserved;
+
+    // Number of allocations made so far.
+    unsigned int allocations;
+} MapMemStats;
+
+typedef struct MapMemBlock MapMemBlock;
+typedef struct MapMemSlot MapMemSlot;
+
+// Pool of fixed size items.
+//
+// Items are carved from blocks of `blockCapacity` slots taken from heap with
+// `mem_malloc`, so the heap sees one allocation per block instead of one per
+// item (and no guard header per item). Freed items are recycled. Blocks whose
+// items are all free are returned to heap in bulk by `mapmem_map_exit`.
+typedef struct MapMemPool {
+    int subsystem;
+    size_t itemSize;
+    int blockCapacity;
+
+    MapMemBlock* blocks;
+    MapMemSlot* freeSlots;
+
+    // Link in list of pools trimmed on map exit.
+    struct MapMemPool* next;
+    bool registered;
+} MapMemPool;
+
+#define MAPMEM_POOL_INIT(subsystem, itemSize, blockCapacity) \
+    { (subsystem), (itemSize), (blockCapacity), NULL, NULL, NULL, false }
+
+void* mapmem_pool_alloc(MapMemPool* pool);
+void mapmem_pool_free(MapMemPool* pool, void* ptr);
+void mapmem_pool_trim(MapMemPool* pool);
+void mapmem_account(int subsystem, long long used, long long reserved);
+void mapmem_map_exit();
+const char* mapmem_subsystem_name(int subsystem);
+bool mapmem_get_stats(int subsystem, MapMemStats* stats);
+void mapmem_dump();
+
+} // namespace fallout
+
+#endif /* FALLOUT_GAME_MAPMEM_H_ */
@@ -0,0 +1,313 @@
+#include "game/mapstat.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <map>
+#include <string>
+
+#include "game/art.h"
+#include "game/cache.h"
+#include "game/gconfig.h"
+#include "game/map.h"
+#include "plib/db/db.h"
+#include "plib/gnw/debug.h"
+
+namespace fallout {
+
+// Counters sampled when outermost load or save starts.
+typedef struct MapStatCounters {
+    unsigned long long bytesRead;
+    unsigned int dbCacheMisses;
+    unsigned int artCacheMisses;
+} MapStatCounters;
+
+static bool mapstat_is_transition(int phase);
+static void mapstat_sample(MapStatCounters* counters);
+static void mapstat_add_timing(MapStatTiming* timing, double time);
+static void mapstat_merge(MapStats* dest, const MapStats* src);
+static MapStats* mapstat_current();
+static void mapstat_log_transition(const char* mapName, const MapStats* stats);
+
+static const char* mapstat_phase_names[MAP_STAT_PHASE_COUNT] = {
+    "map_load_file",
+    "map_save_file",
+    "obj_load",
+    "obj_save",
+    "scr_load",
+    "scr_save",
+    "square_load",
+    "obj_preload_art_cache",
+    "obj_rebuild_all_light",
+    "scr_exec_map_enter_scripts",
+};
+
+static bool mapstat_is_enabled = false;
+
+// Aggregated stats keyed by map name.
+static std::map<std::string, MapStats> mapstat_maps;
+
+// Nesting level of loads and saves. Phases which complete inside a load or
+// save are collected in `mapstat_pending` and attributed to the map once it
+// is finished (map name is not known until the header is read).
+static int mapstat_transition_depth = 0;
+static MapStats mapstat_pending;
+static MapStatCounters mapstat_pending_start;
+
+// Reads [debug] map_stats option.
+void mapstat_init()
+{
+    int enabled;
+    if (config_get_value(&game_config, GAME_CONFIG_DEBUG_KEY, GAME_CONFIG_MAP_STATS_KEY, &enabled)) {
+        mapstat_is_enabled = enabled != 0;
+    } else {
+        mapstat_is_enabled = false;
+    }
+
+    mapstat_reset();
+}
+
+// Writes session summary to debug log.
+void mapstat_exit()
+{
+    if (mapstat_is_enabled) {
+        mapstat_publish();
+    }
+
+    mapstat_reset();
+    mapstat_is_enabled = false;
+}
+
+bool mapstat_enabled()
+{
+    return mapstat_is_enabled;
+}
+
+const char* mapstat_phase_name(int phase)
+{
+    if (phase < 0 || phase >= MAP_STAT_PHASE_COUNT) {
+        return NULL;
+    }
+
+    return mapstat_phase_names[phase];
+}
+
+void mapstat_begin(int phase)
+{
+    if (!mapstat_is_transition(phase)) {
+        return;
+    }
+
+    if (mapstat_transition_depth == 0) {
+        memset(&mapstat_pending, 0, sizeof(mapstat_pending));
+        mapstat_sample(&mapstat_pending_start);
+    }
+
+    mapstat_transition_depth++;
+}
+
+void mapstat_end(int phase, double time)
+{
+    if (phase < 0 || phase >= MAP_STAT_PHASE_COUNT) {
+        return;
+    }
+
+    if (mapstat_transition_depth == 0) {
+        // Phase outside of load or save (for example, light rebuild after
+        // an object has been placed).
+        mapstat_add_timing(&(mapstat_current()->phases[phase]), time);
+        return;
+    }
+
+    mapstat_add_timing(&(mapstat_pending.phases[phase]), time);
+
+    if (!mapstat_is_transition(phase)) {
+        return;
+    }
+
+    mapstat_transition_depth--;
+    if (mapstat_transition_depth != 0) {
+        return;
+    }
+
+    MapStatCounters counters;
+    mapstat_sample(&counters);
+
+    mapstat_pending.transitions = 1;
+    mapstat_pending.bytesRead = counters.bytesRead - mapstat_pending_start.bytesRead;
+    mapstat_pending.dbCacheMisses = counters.dbCacheMisses - mapstat_pending_start.dbCacheMisses;
+    mapstat_pending.artCacheMisses = counters.artCacheMisses - mapstat_pending_start.artCacheMisses;
+
+    mapstat_merge(mapstat_current(), &mapstat_pending);
+    mapstat_log_transition(map_data.name, &mapstat_pending);
+}
+
+bool mapstat_get(const char* mapName, MapStats* stats)
+{
+    if (mapName == NULL || stats == NULL) {
+        return false;
+    }
+
+    auto it = mapstat_maps.find(mapName);
+    if (it == mapstat_maps.end()) {
+        return false;
+    }
+
+    *stats = it->second;
+    return true;
+}
+
+// Passes aggregated stats of every map (sorted by name) to the callback.
+void mapstat_visit(MapStatProc* proc, void* userData)
+{
+    if (proc == NULL) {
+        return;
+    }
+
+    for (auto& entry : mapstat_maps) {
+        proc(entry.first.c_str(), &(entry.second), userData);
+    }
+}
+
+void mapstat_reset()
+{
+    mapstat_maps.clear();
+    mapstat_transition_depth = 0;
+    memset(&mapstat_pending, 0, sizeof(mapstat_pending));
+}
+
+// Writes min/avg/max of every phase of every map to debug log.
+void mapstat_publish()
+{
+    for (auto& entry : mapstat_maps) {
+        const MapStats* stats = &(entry.second);
+
+        debug_printf("map_stats: %s: %u transitions, %llu KB read, %u db misses, %u art misses\n",
+            entry.first.c_str(),
+            stats->transitions,
+            stats->bytesRead / 1024,
+            stats->dbCacheMisses,
+            stats->artCacheMisses);
+
+        for (int phase = 0; phase < MAP_STAT_PHASE_COUNT; phase++) {
+            const MapStatTiming* timing = &(stats->phases[phase]);
+            if (timing->count == 0) {
+                continue;
+            }
+
+            debug_printf("map_stats: %s:   %s: %u calls, min %.2f ms, avg %.2f ms, max %.2f ms\n",
+                entry.first.c_str(),
+                mapstat_phase_names[phase],
+                timing->count,
+                timing->min,
+                timing->total / timing->count,
+                timing->max);
+        }
+    }
+}
+
+static bool mapstat_is_transition(int phase)
+{
+    return phase == MAP_STAT_PHASE_LOAD_FILE || phase == MAP_STAT_PHASE_SAVE_FILE;
+}
+
+static void mapstat_sample(MapStatCounters* counters)
+{
+    memset(counters, 0, sizeof(*counters));
+
+    if (db_trace_is_enabled()) {
+        db_trace_file_stats totals;
+        db_trace_get_totals(&totals);
+        counters->bytesRead = totals.bytes_read;
+    }
+
+    db_cache_stats dbStats;
+    db_cache_get_stats(&dbStats);
+    counters->dbCacheMisses = dbStats.misses;
+
+    CacheStats artStats;
+    if (cache_get_stats(&art_cache, &artStats)) {
+        counters->artCacheMisses = artStats.misses;
+    }
+}
+
+static void mapstat_add_timing(MapStatTiming* timing, double time)
+{
+    if (timing->count == 0 || time < timing->min) {
+        timing->min = time;
+    }
+
+    if (timing->count == 0 || time > timing->max) {
+        timing->max = time;
+    }
+
+    timing->total += time;
+    timing->count++;
+}
+
+static void mapstat_merge(MapStats* dest, const MapStats* src)
+{
+    for (int phase = 0; phase < MAP_STAT_PHASE_COUNT; phase++) {
+        const MapStatTiming* from = &(src->phases[phase]);
+        MapStatTiming* to = &(dest->phases[phase]);
+        if (from->count == 0) {
+            continue;
+        }
+
+        if (to->count == 0 || from->min < to->min) {
+            to->min = from->min;
+        }
+
+        if (to->count == 0 || from->max > to->max) {
+            to->max = from->max;
+        }
+
+        to->total += from->total;
+        to->count += from->count;
+    }
+
+    dest->transitions += src->transitions;
+    dest->bytesRead += src->bytesRead;
+    dest->dbCacheMisses += src->dbCacheMisses;
+    dest->artCacheMisses += src->artCacheMisses;
+}
+
+static MapStats* mapstat_current()
+{
+    auto it = mapstat_maps.find(map_data.name);
+    if (it == mapstat_maps.end()) {
+        MapStats stats;
+        memset(&stats, 0, sizeof(stats));
+        it = mapstat_maps.emplace(map_data.name, stats).first;
+    }
+
+    return &(it->second);
+}
+
+static void mapstat_log_transition(const char* mapName, const MapStats* stats)
+{
+    char string[512];
+    int length = snprintf(string, sizeof(string), "map_stats: %s:", mapName);
+
+    for (int phase = 0; phase < MAP_STAT_PHASE_COUNT; phase++) {
+        const MapStatTiming* timing = &(stats->phases[phase]);
+        if (timing->count == 0 || length <= 0 || (size_t)length >= sizeof(string)) {
+            continue;
+        }
+
+        length += snprintf(string + length, sizeof(string) - length, " %s %.2f ms,",
+            mapstat_phase_names[phase],
+            timing->total);
+    }
+
+    if (length > 0 && (size_t)length < sizeof(string)) {
+        snprintf(string + length, sizeof(string) - length, " %llu KB read, %u db misses, %u art misses",
+            stats->bytesRead / 1024,
+            stats->dbCacheMisses,
+            stats->artCacheMisses);
+    }
+
+    debug_printf("%s\n", string);
+}
+
+} // namespace fallout
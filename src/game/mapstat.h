@@ -0,0 +1,87 @@
+#ifndef FALLOUT_GAME_MAPSTAT_H_
+#define FALLOUT_GAME_MAPSTAT_H_
+
+#include <chrono>
+
+namespace fallout {
+
+typedef enum MapStatPhase {
+    MAP_STAT_PHASE_LOAD_FILE,
+    MAP_STAT_PHASE_SAVE_FILE,
+    MAP_STAT_PHASE_OBJ_LOAD,
+    MAP_STAT_PHASE_OBJ_SAVE,
+    MAP_STAT_PHASE_SCR_LOAD,
+    MAP_STAT_PHASE_SCR_SAVE,
+    MAP_STAT_PHASE_SQUARE_LOAD,
+    MAP_STAT_PHASE_PRELOAD_ART,
+    MAP_STAT_PHASE_REBUILD_LIGHT,
+    MAP_STAT_PHASE_MAP_ENTER_SCRIPTS,
+    MAP_STAT_PHASE_COUNT,
+} MapStatPhase;
+
+// Timings of one phase (in ms).
+typedef struct MapStatTiming {
+    unsigned int count;
+    double min;
+    double max;
+    double total;
+} MapStatTiming;
+
+typedef struct MapStats {
+    MapStatTiming phases[MAP_STAT_PHASE_COUNT];
+
+    // Number of completed loads and saves of the map.
+    unsigned int transitions;
+
+    // Totals over all transitions. Bytes are only counted while db tracing
+    // is enabled (see `db_trace_enable`).
+    unsigned long long bytesRead;
+    unsigned int dbCacheMisses;
+    unsigned int artCacheMisses;
+} MapStats;
+
+typedef void MapStatProc(const char* mapName, const MapStats* stats, void* userData);
+
+void mapstat_init();
+void mapstat_exit();
+bool mapstat_enabled();
+const char* mapstat_phase_name(int phase);
+void mapstat_begin(int phase);
+void mapstat_end(int phase, double time);
+bool mapstat_get(const char* mapName, MapStats* stats);
+void mapstat_visit(MapStatProc* proc, void* userData);
+void mapstat_reset();
+void mapstat_publish();
+
+// Times enclosing function as given phase when map stats are enabled.
+class MapStatScope {
+public:
+    explicit MapStatScope(int phase)
+        : phase(phase)
+        , active(mapstat_enabled())
+    {
+        if (active) {
+            mapstat_begin(phase);
+            start = std::chrono::steady_clock::now();
+        }
+    }
+
+    ~MapStatScope()
+    {
+        if (active) {
+            mapstat_end(phase, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        }
+    }
+
+    MapStatScope(const MapStatScope&) = delete;
+    MapStatScope& operator=(const MapStatScope&) = delete;
+
+private:
+    int phase;
+    bool active;
+    std::chrono::steady_clock::time_point start;
+};
+
+} // namespace fallout
+
+#endif /* FALLOUT_GAME_MAPSTAT_H_ */
@@ -5,6 +5,8 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <SDL.h>
+
 #include "game/gconfig.h"
 #include "game/roll.h"
 #include "platform_compat.h"
@@ -19,7 +21,8 @@ namespace fallout {
 static bool message_find(MessageList* msg, int num, int* out_index);
 static bool message_add(MessageList* msg, MessageListItem* new_entry);
 static bool message_parse_number(int* out_num, const char* str);
-static int message_load_field(DB_FILE* file, char* str);
+static int message_load_field(char** cursor, char* end, char** str);
+static int message_load_badwords();
 
 // 0x505B10
 static char** bad_word = NULL;
@@ -30,13 +33,54 @@ static int bad_total = 0;
 // 0x505B18
 static int* bad_len = NULL;
 
+// CE: Set once badwords list is loaded (or failed to load), see
+// `message_filter_preload`.
+static bool bad_loaded = false;
+
 // Temporary message list item text used during filtering badwords.
 //
 // 0x6305D0
 static char bad_copy[MESSAGE_LIST_ITEM_FIELD_MAX_SIZE];
 
+// CE: Contents of single message file. Fields are parsed in place, so
+// strings of entries point inside `data`.
+typedef struct MessageArena {
+    struct MessageArena* next;
+    size_t size;
+    char data[1];
+} MessageArena;
+
+// CE: Counters of all message lists, see `message_get_cache_stats`.
+static CacheStats message_cache_stats;
+static Uint64 message_cache_read_ticks = 0;
+
 // 0x4764E0
 int init_message()
+{
+    // CE: Badwords list is only needed when language filter is enabled, it's
+    // loaded on first use by `message_filter`.
+    bad_total = 0;
+    bad_loaded = false;
+
+    return 0;
+}
+
+// CE: Loads badwords list used by `message_filter` unless it's already
+// loaded. Lets UI pay for loading upfront instead of on first filtered
+// message list.
+int message_filter_preload()
+{
+    if (bad_loaded) {
+        return bad_total != 0 ? 0 : -1;
+    }
+
+    bad_loaded = true;
+
+    return message_load_badwords();
+}
+
+// CE: Extracted from `init_message`.
+static int message_load_badwords()
 {
     DB_FILE* stream = db_fopen("data\\badwords.txt", "rt");
     if (stream == NULL) {
@@ -52,6 +96,7 @@ int init_message()
 
     bad_word = (char**)mem_malloc(sizeof(*bad_word) * bad_total);
     if (bad_word == NULL) {
+        bad_total = 0;
         db_fclose(stream);
         return -1;
     }
@@ -59,6 +104,7 @@ int init_message()
     bad_len = (int*)mem_malloc(sizeof(*bad_len) * bad_total);
     if (bad_len == NULL) {
         mem_free(bad_word);
+        bad_total = 0;
         db_fclose(stream);
         return -1;
     }
@@ -97,6 +143,9 @@ int init_message()
         mem_free(bad_word);
         mem_free(bad_len);
 
+        // CE: Leave list empty instead of dangling.
+        bad_total = 0;
+
         return -1;
     }
 
@@ -116,6 +165,7 @@ void exit_message()
     }
 
     bad_total = 0;
+    bad_loaded = false;
 }
 
 // 0x4766BC
@@ -124,6 +174,8 @@ bool message_init(MessageList* messageList)
     if (messageList != NULL) {
         messageList->entries_num = 0;
         messageList->entries = NULL;
+        messageList->entries_capacity = 0;
+        messageList->arena = NULL;
     }
     return true;
 }
@@ -131,24 +183,24 @@ bool message_init(MessageList* messageList)
 // 0x4766D4
 bool message_exit(MessageList* messageList)
 {
-    int i;
-    MessageListItem* entry;
-
     if (messageList == NULL) {
         return false;
     }
 
-    for (i = 0; i < messageList->entries_num; i++) {
-        entry = &(messageList->entries[i]);
+    message_cache_stats.size -= sizeof(MessageListItem) * messageList->entries_num;
 
-        if (entry->audio != NULL) {
-            mem_free(entry->audio);
-        }
-
-        if (entry->text != NULL) {
-            mem_free(entry->text);
-        }
+    // CE: Strings live in arenas, they are released all at once.
+    MessageArena* arena = messageList->arena;
+    while (arena != NULL) {
+        MessageArena* next = arena->next;
+        message_cache_stats.size -= arena->size;
+        mem_free(arena);
+        arena = next;
     }
+    messageList->arena = NULL;
+
+    message_cache_stats.entries -= messageList->entries_num;
+    message_cache_stats.evictions += messageList->entries_num;
 
     messageList->entries_num = 0;
 
@@ -157,18 +209,21 @@ bool message_exit(MessageList* messageList)
         messageList->entries = NULL;
     }
 
+    messageList->entries_capacity = 0;
+
     return true;
 }
 
+// CE: Whole file is read into an arena attached to the list and parsed in
+// one pass, entries point to strings inside it.
+//
 // 0x476814
 bool message_load(MessageList* messageList, const char* path)
 {
     char* language;
     char localized_path[COMPAT_MAX_PATH];
     DB_FILE* file_ptr;
-    char num[MESSAGE_LIST_ITEM_FIELD_MAX_SIZE];
-    char audio[MESSAGE_LIST_ITEM_FIELD_MAX_SIZE];
-    char text[MESSAGE_LIST_ITEM_FIELD_MAX_SIZE];
+    char* num;
     int rc;
     bool success;
     MessageListItem entry;
@@ -189,27 +244,59 @@ bool message_load(MessageList* messageList, const char* path)
 
     snprintf(localized_path, sizeof(localized_path), "%s\\%s\\%s", "text", language, path);
 
-    file_ptr = db_fopen(localized_path, "rt");
+    Uint64 readStart = SDL_GetPerformanceCounter();
+    message_cache_stats.reads++;
+
+    file_ptr = db_fopen(localized_path, "rb");
     if (file_ptr == NULL) {
+        message_cache_read_ticks += SDL_GetPerformanceCounter() - readStart;
+        return false;
+    }
+
+    long length = db_filelength(file_ptr);
+    if (length < 0) {
+        length = 0;
+    }
+
+    MessageArena* arena = (MessageArena*)mem_malloc(sizeof(*arena) + length);
+    if (arena == NULL) {
+        db_fclose(file_ptr);
+        message_cache_read_ticks += SDL_GetPerformanceCounter() - readStart;
         return false;
     }
 
+    if (db_fread(arena->data, 1, length, file_ptr) != (size_t)length) {
+        debug_printf("\nError reading message file %s.\n", localized_path);
+        mem_free(arena);
+        db_fclose(file_ptr);
+        message_cache_read_ticks += SDL_GetPerformanceCounter() - readStart;
+        return false;
+    }
+
+    db_fclose(file_ptr);
+
+    arena->size = sizeof(*arena) + length;
+    arena->next = messageList->arena;
+    messageList->arena = arena;
+    message_cache_stats.size += arena->size;
+
+    char* cursor = arena->data;
+    char* end = arena->data + length;
+
     entry.num = 0;
-    entry.audio = audio;
-    entry.text = text;
 
     while (1) {
-        rc = message_load_field(file_ptr, num);
+        rc = message_load_field(&cursor, end, &num);
         if (rc != 0) {
             break;
         }
 
-        if (message_load_field(file_ptr, audio) != 0) {
+        if (message_load_field(&cursor, end, &(entry.audio)) != 0) {
             debug_printf("\nError loading audio field.\n", localized_path);
             goto err;
         }
 
-        if (message_load_field(file_ptr, text) != 0) {
+        if (message_load_field(&cursor, end, &(entry.text)) != 0) {
             debug_printf("\nError loading text field.\n", localized_path);
             goto err;
         }
@@ -232,10 +319,10 @@ bool message_load(MessageList* messageList, const char* path)
 err:
 
     if (!success) {
-        debug_printf("Error loading message file %s at offset %x.", localized_path, db_ftell(file_ptr));
+        debug_printf("Error loading message file %s at offset %x.", localized_path, (unsigned int)(cursor - arena->data));
     }
 
-    db_fclose(file_ptr);
+    message_cache_read_ticks += SDL_GetPerformanceCounter() - readStart;
 
     return success;
 }
@@ -259,9 +346,12 @@ bool message_search(MessageList* msg, MessageListItem* entry)
     }
 
     if (!message_find(msg, entry->num, &index)) {
+        message_cache_stats.misses++;
         return false;
     }
 
+    message_cache_stats.hits++;
+
     ptr = &(msg->entries[index]);
     entry->audio = ptr->audio;
     entry->text = ptr->text;
@@ -293,42 +383,29 @@ bool message_make_path(char* dest, size_t size, const char* path)
     return true;
 }
 
+// CE: Original implementation moved bounds by one on every iteration, which
+// made it a linear scan. Entries are sorted by number and numbers are unique
+// (see `message_add`), so this is a plain binary search for the first entry
+// not less than `num`.
+//
 // 0x476A78
 bool message_find(MessageList* msg, int num, int* out_index)
 {
-    int r, l, mid;
-    int cmp;
-
-    if (msg->entries_num == 0) {
-        *out_index = 0;
-        return false;
-    }
-
-    r = msg->entries_num - 1;
-    l = 0;
+    int l = 0;
+    int r = msg->entries_num;
 
-    do {
-        mid = (l + r) / 2;
-        cmp = num - msg->entries[mid].num;
-        if (cmp == 0) {
-            *out_index = mid;
-            return true;
-        }
-
-        if (cmp > 0) {
-            l = l + 1;
+    while (l < r) {
+        int mid = l + (r - l) / 2;
+        if (msg->entries[mid].num < num) {
+            l = mid + 1;
         } else {
-            r = r - 1;
+            r = mid;
         }
-    } while (r >= l);
-
-    if (cmp < 0) {
-        *out_index = mid;
-    } else {
-        *out_index = mid + 1;
     }
 
-    return false;
+    *out_index = l;
+
+    return l < msg->entries_num && msg->entries[l].num == num;
 }
 
 // 0x476AD0
@@ -338,54 +415,54 @@ bool message_add(MessageList* msg, MessageListItem* new_entry)
     MessageListItem* entries;
     MessageListItem* existing_entry;
 
-    if (message_find(msg, new_entry->num, &index)) {
-        existing_entry = &(msg->entries[index]);
-
-        if (existing_entry->audio != NULL) {
-            mem_free(existing_entry->audio);
-        }
+    // CE: Message files are mostly sorted, so entries are usually appended
+    // without searching.
+    bool found;
+    if (msg->entries_num == 0 || msg->entries[msg->entries_num - 1].num < new_entry->num) {
+        index = msg->entries_num;
+        found = false;
+    } else {
+        found = message_find(msg, new_entry->num, &index);
+    }
 
-        if (existing_entry->text != NULL) {
-            mem_free(existing_entry->text);
-        }
+    if (found) {
+        // CE: Replaced strings stay in their arena until list is released.
+        existing_entry = &(msg->entries[index]);
     } else {
-        if (msg->entries != NULL) {
-            entries = (MessageListItem*)mem_realloc(msg->entries, sizeof(MessageListItem) * (msg->entries_num + 1));
+        // CE: Grow geometrically instead of one entry at a time.
+        if (msg->entries == NULL || msg->entries_num == msg->entries_capacity) {
+            int capacity = msg->entries_capacity != 0 ? msg->entries_capacity * 2 : 64;
+            entries = (MessageListItem*)mem_realloc(msg->entries, sizeof(MessageListItem) * capacity);
             if (entries == NULL) {
                 return false;
             }
 
-            msg->entries = entries;
-
-            if (index != msg->entries_num) {
-                // Move all items below insertion point
-                memmove(&(msg->entries[index + 1]), &(msg->entries[index]), sizeof(MessageListItem) * (msg->entries_num - index));
-            }
-        } else {
-            msg->entries = (MessageListItem*)mem_malloc(sizeof(MessageListItem));
             if (msg->entries == NULL) {
-                return false;
+                msg->entries_num = 0;
+                index = 0;
             }
-            msg->entries_num = 0;
-            index = 0;
+
+            msg->entries = entries;
+            msg->entries_capacity = capacity;
+        }
+
+        if (index != msg->entries_num) {
+            // Move all items below insertion point
+            memmove(&(msg->entries[index + 1]), &(msg->entries[index]), sizeof(MessageListItem) * (msg->entries_num - index));
         }
 
         existing_entry = &(msg->entries[index]);
         existing_entry->audio = 0;
         existing_entry->text = 0;
         msg->entries_num++;
-    }
-
-    existing_entry->audio = mem_strdup(new_entry->audio);
-    if (existing_entry->audio == NULL) {
-        return false;
-    }
 
-    existing_entry->text = mem_strdup(new_entry->text);
-    if (existing_entry->text == NULL) {
-        return false;
+        message_cache_stats.entries++;
+        message_cache_stats.size += sizeof(*existing_entry);
     }
 
+    // CE: Strings are owned by list's arena, see `message_load`.
+    existing_entry->audio = new_entry->audio;
+    existing_entry->text = new_entry->text;
     existing_entry->num = new_entry->num;
 
     return true;
@@ -419,8 +496,11 @@ bool message_parse_number(int* out_num, const char* str)
     return success;
 }
 
-// Read next message file field, the `str` should be at least
-// `MESSAGE_LIST_ITEM_FIELD_MAX_SIZE` bytes long.
+// Read next message file field.
+//
+// CE: Field is read from file contents at `cursor` and is unpacked in place
+// (newlines dropped, closing brace replaced with terminator), `str` is set to
+// point to it. Line breaks are "\r\n" or "\n" like in text mode of db.
 //
 // Returns:
 // 0 - ok
@@ -430,20 +510,20 @@ bool message_parse_number(int* out_num, const char* str)
 // 4 - limit exceeded (> `MESSAGE_LIST_ITEM_FIELD_MAX_SIZE`)
 //
 // 0x476DD4
-int message_load_field(DB_FILE* file, char* str)
+int message_load_field(char** cursor, char* end, char** str)
 {
-    int ch;
-    int len;
-
-    len = 0;
+    char* src = *cursor;
 
     while (1) {
-        ch = db_fgetc(file);
-        if (ch == -1) {
+        if (src == end) {
+            *cursor = src;
             return 1;
         }
 
+        char ch = *src++;
+
         if (ch == '}') {
+            *cursor = src;
             debug_printf("\nError reading message file - mismatched delimiters.\n");
             return 2;
         }
@@ -453,24 +533,35 @@ int message_load_field(DB_FILE* file, char* str)
         }
     }
 
-    while (1) {
-        ch = db_fgetc(file);
+    char* dest = src;
+    *str = dest;
 
-        if (ch == -1) {
+    int len = 0;
+    while (1) {
+        if (src == end) {
+            *cursor = src;
             debug_printf("\nError reading message file - EOF reached.\n");
             return 3;
         }
 
+        char ch = *src++;
+
         if (ch == '}') {
-            *(str + len) = '\0';
+            *dest = '\0';
+            *cursor = src;
             return 0;
         }
 
+        if (ch == '\r' && src != end && *src == '\n') {
+            continue;
+        }
+
         if (ch != '\n') {
-            *(str + len) = ch;
+            *dest++ = ch;
             len++;
 
             if (len >= MESSAGE_LIST_ITEM_FIELD_MAX_SIZE) {
+                *cursor = src;
                 debug_printf("\nError reading message file - text exceeds limit.\n");
                 return 4;
             }
@@ -511,18 +602,21 @@ bool message_filter(MessageList* messageList)
         return true;
     }
 
-    if (bad_total == 0) {
-        return true;
-    }
-
     int languageFilter = 0;
     config_get_value(&game_config, GAME_CONFIG_PREFERENCES_KEY, GAME_CONFIG_LANGUAGE_FILTER_KEY, &languageFilter);
     if (languageFilter != 1) {
         return true;
     }
 
+    // CE: Load badwords on first use.
+    message_filter_preload();
+
+    if (bad_total == 0) {
+        return true;
+    }
+
     int replacementsCount = strlen(replacements);
-    int replacementsIndex = roll_random(1, replacementsCount) - 1;
+    int replacementsIndex = roll_random_stream(ROLL_STREAM_COSMETIC, 1, replacementsCount) - 1;
 
     for (int index = 0; index < messageList->entries_num; index++) {
         MessageListItem* item = &(messageList->entries[index]);
@@ -556,4 +650,19 @@ bool message_filter(MessageList* messageList)
     return true;
 }
 
+// CE: Reports all message lists in terms of cache stats. Message lists are
+// never locked and unbounded, entries are released with `message_exit`.
+bool message_get_cache_stats(CacheStats* stats)
+{
+    if (stats == NULL) {
+        return false;
+    }
+
+    *stats = message_cache_stats;
+    stats->averageEntrySize = stats->entries != 0 ? stats->size / stats->entries : 0;
+    stats->readTime = (double)message_cache_read_ticks * 1000.0 / (double)SDL_GetPerformanceFrequency();
+
+    return true;
+}
+
 } // namespace fallout
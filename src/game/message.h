@@ -3,6 +3,8 @@
 
 #include <stddef.h>
 
+#include "game/cache.h"
+
 namespace fallout {
 
 // TODO: Probably should be private.
@@ -17,6 +19,10 @@ typedef struct MessageListItem {
 typedef struct MessageList {
     int entries_num;
     MessageListItem* entries;
+    // CE: Number of allocated entries, see `message_add`.
+    int entries_capacity;
+    // CE: Blocks holding strings of entries, see `message_load`.
+    struct MessageArena* arena;
 } MessageList;
 
 int init_message();
@@ -28,6 +34,8 @@ bool message_search(MessageList* msg, MessageListItem* entry);
 bool message_make_path(char* dest, size_t size, const char* path);
 char* getmsg(MessageList* msg, MessageListItem* entry, int num);
 bool message_filter(MessageList* messageList);
+int message_filter_preload();
+bool message_get_cache_stats(CacheStats* stats);
 
 } // namespace fallout
 
@@ -1,9 +1,12 @@
 #include "game/object.h"
 
 #include <assert.h>
+#include <limits.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include <algorithm>
+#include <unordered_set>
 
 #include "game/anim.h"
 #include "game/art.h"
@@ -15,14 +18,19 @@
 #include "game/item.h"
 #include "game/light.h"
 #include "game/map.h"
+#include "game/mapmem.h"
+#include "game/mapstat.h"
 #include "game/party.h"
+#include "game/pathgraph.h"
 #include "game/protinst.h"
 #include "game/proto.h"
 #include "game/scripts.h"
+#include "game/statever.h"
 #include "game/textobj.h"
 #include "game/tile.h"
 #include "game/worldmap.h"
 #include "plib/color/color.h"
+#include "plib/db/db.h"
 #include "plib/gnw/debug.h"
 #include "plib/gnw/grbuf.h"
 #include "plib/gnw/input.h"
@@ -31,6 +39,59 @@
 
 namespace fallout {
 
+// CE: Number of cached outline silhouettes (power of 2).
+#define OBJ_OUTLINE_SHAPE_CACHE_SIZE 64
+
+// CE: Kinds of outline edges, each names pixel written relative to frame
+// pixel the edge was found at.
+typedef enum ObjOutlineEdgeKind {
+    // Pixel to the left of the first opaque pixel of a horizontal run.
+    OBJ_OUTLINE_EDGE_LEFT,
+    // First transparent pixel after a horizontal run.
+    OBJ_OUTLINE_EDGE_AFTER_ROW,
+    // Pixel past the right side of frame, after last opaque pixel of a row.
+    OBJ_OUTLINE_EDGE_RIGHT,
+    // Pixel above the first opaque pixel of a vertical run.
+    OBJ_OUTLINE_EDGE_TOP,
+    // First transparent pixel after a vertical run.
+    OBJ_OUTLINE_EDGE_AFTER_COLUMN,
+    // Pixel past the bottom of frame, after last opaque pixel of a column.
+    OBJ_OUTLINE_EDGE_BOTTOM,
+} ObjOutlineEdgeKind;
+
+typedef struct ObjOutlineEdge {
+    short x;
+    short y;
+    unsigned char kind;
+} ObjOutlineEdge;
+
+// CE: Outline edges of one art frame, in the order `obj_render_outline`
+// draws them (rows first, then columns).
+typedef struct ObjOutlineShape {
+    int fid;
+    int frame;
+    int rotation;
+    int count;
+    ObjOutlineEdge* edges;
+} ObjOutlineShape;
+
+// CE: Part of draw order (see `orderTable`) along which both row and column
+// of update area (see `offsetDivTable` and `offsetModTable`) change in one
+// direction (or stay), so hexes of it inside any area anchored at upper left
+// corner form a contiguous span.
+typedef struct ObjectOrderRun {
+    int start;
+    int end;
+    signed char rowStep;
+    signed char columnStep;
+} ObjectOrderRun;
+
+// CE: Span of draw order to visit.
+typedef struct ObjectOrderSpan {
+    int start;
+    int end;
+} ObjectOrderSpan;
+
 static int obj_read_obj(Object* obj, DB_FILE* stream);
 static int obj_load_func(DB_FILE* stream);
 static void obj_fix_combat_cid_for_dude();
@@ -43,6 +104,9 @@ static int obj_order_table_init();
 static int obj_order_comp_func_even(const void* a1, const void* a2);
 static int obj_order_comp_func_odd(const void* a1, const void* a2);
 static void obj_order_table_exit();
+static int obj_order_runs_init(int parity);
+static int obj_order_spans(int parity, int height, int width);
+static int obj_order_run_bound(ObjectOrderRun* run, int* orders, int* table, int limit, bool prefix);
 static int obj_render_table_init();
 static void obj_render_table_exit();
 static void obj_light_table_init();
@@ -58,9 +122,29 @@ static void obj_insert(ObjectListNode* ptr);
 static int obj_remove(ObjectListNode* a1, ObjectListNode* a2);
 static int obj_connect_to_tile(ObjectListNode* node, int tile_index, int elev, Rect* rect);
 static int obj_adjust_light(Object* obj, int a2, Rect* rect);
+static void obj_prefetch_art(int fid);
 static void obj_render_outline(Object* object, Rect* rect);
 static void obj_render_object(Object* object, Rect* rect, int light);
 static int obj_preload_sort(const void* a1, const void* a2);
+static Object* obj_blocking_scan(Object* a1, int tile, int elev);
+static void obj_blocking_update_tile(int tile, int elevation);
+static bool obj_tile_occupied(int tile, int elevation);
+static void obj_hit_grid_init();
+static void obj_hit_grid_exit();
+static bool obj_hit_bounds(Object* obj, int* left, int* top, int* right, int* bottom);
+static void obj_hit_grid_cells(int left, int top, int right, int bottom, int* minColumn, int* minRow, int* maxColumn, int* maxRow);
+static void obj_hit_grid_update(ObjectListNode* node);
+static void obj_hit_grid_remove(ObjectListNode* node);
+static int obj_hit_tile_compare(const void* a1, const void* a2);
+static void obj_type_list_add(ObjectListNode* node);
+static void obj_type_list_remove(ObjectListNode* node);
+static void obj_seen_mark(int index);
+static void obj_static_changed(Object* obj);
+static void obj_seen_clear();
+static unsigned char obj_light_class(int tile, int elevation);
+static ObjOutlineShape* obj_outline_shape(Art* art, int fid, int frame, int rotation);
+static int obj_outline_shape_build(unsigned char* src, int width, int height, ObjOutlineEdge* edges);
+static void obj_outline_shape_exit();
 
 // 0x505B70
 static bool objInitialized = false;
@@ -92,6 +176,17 @@ static int* offsetDivTable = NULL;
 // 0x505B94
 static int* offsetModTable = NULL;
 
+// CE: Monotone runs of `orderTable` for both parities.
+static ObjectOrderRun* orderRuns[2] = {
+    NULL,
+    NULL,
+};
+
+static int orderRunsLength[2];
+
+// CE: Spans of draw order inside area, see `obj_order_spans`.
+static ObjectOrderSpan* orderSpans = NULL;
+
 // 0x505B98
 static ObjectListNode** renderTable = NULL;
 
@@ -115,6 +210,25 @@ static int find_tile = 0;
 // 0x505BB0
 static ObjectListNode* find_ptr = NULL;
 
+// CE: Objects on the map grouped by elevation and proto type, so scans for
+// objects of one type (usually critters) do not have to walk every hex.
+// Order within a list is arbitrary.
+static ObjectListNode* obj_type_lists[ELEVATION_COUNT * OBJ_TYPE_COUNT];
+
+// CE: Nesting depth of `obj_light_batch_begin` and whether light of any
+// object was skipped during the batch.
+static int obj_light_batch_depth = 0;
+static bool obj_light_batch_dirty = false;
+
+// CE: Iteration state of `obj_find_first_of_type`.
+static ObjectListNode* find_type_next = NULL;
+static int find_type = 0;
+static int find_type_elev = 0;
+static int find_type_max_elev = 0;
+
+// CE: Silhouettes of recently outlined frames, see `obj_outline_shape`.
+static ObjOutlineShape obj_outline_shapes[OBJ_OUTLINE_SHAPE_CACHE_SIZE];
+
 // 0x505BB4
 static int* preload_list = NULL;
 
@@ -210,6 +324,24 @@ unsigned char* energyBlendTable = NULL;
 // 0x505D08
 unsigned char* redBlendTable = NULL;
 
+// CE: How objects on a hex affect light footprint, cached per hex by
+// `obj_light_class`, see `obj_adjust_light`.
+#define OBJ_LIGHT_CLASS_VALID 0x80
+#define OBJ_LIGHT_CLASS_BLOCKS 0x01
+#define OBJ_LIGHT_CLASS_WALL_EAST_WEST 0x02
+#define OBJ_LIGHT_CLASS_WALL_NORTH_CORNER 0x04
+#define OBJ_LIGHT_CLASS_WALL_SOUTH_CORNER 0x08
+#define OBJ_LIGHT_CLASS_WALL_NORTH_SOUTH 0x10
+#define OBJ_LIGHT_CLASS_OCCLUDER 0x20
+
+// CE: Cached light classes of every hex, zero (not valid) when objects on
+// the hex have changed since last computation.
+static unsigned char obj_light_classes[ELEVATION_COUNT][HEX_GRID_SIZE];
+
+// CE: Light classes which leave hex at given footprint position (rotation
+// and index into `light_offsets`) unlit.
+static unsigned char obj_light_shadow_masks[ROTATION_COUNT][36];
+
 // 0x637730
 static int light_blocked[6][36];
 
@@ -227,6 +359,61 @@ static Rect buf_rect;
 // 0x6382F0
 static ObjectListNode* objectTable[HEX_GRID_SIZE];
 
+// CE: Per-elevation bitsets of hexes occupied by a potential blocker (either
+// directly or by multihex object standing on a neighbour hex). Cleared bit
+// means `obj_blocking_at` can return `NULL` without walking object lists. Set
+// bit is a hint only, it still includes mover itself, so the lists are walked
+// to find actual blocker.
+static unsigned char obj_blocking_bits[ELEVATION_COUNT][(HEX_GRID_SIZE + 7) / 8];
+
+// CE: Per-elevation bitsets of hexes holding any object of that elevation
+// (hidden ones included). Kept exact along with blocking bits, see
+// `obj_blocking_update_tile`. Renderer and per-hex queries sweep thousands
+// of hexes, most of them empty or used on other elevations only, a 5 KB
+// bitset lets them skip those without touching `objectTable` (320 KB) and
+// nodes and objects behind it.
+static unsigned char obj_occupied_bits[ELEVATION_COUNT][(HEX_GRID_SIZE + 7) / 8];
+
+// CE: Incremented whenever blocking state of any hex might have changed.
+static unsigned int obj_blocking_epoch_value = 0;
+
+// CE: Incremented whenever walls or scenery are added, removed, moved,
+// change art or become seen, see `obj_static_epoch`.
+static unsigned int obj_static_epoch_value = 0;
+
+// CE: Pools of objects and object list nodes. Freed objects are recycled,
+// blocks left empty after map change are returned to heap (see
+// `mapmem_map_exit`).
+static MapMemPool obj_object_pool = MAPMEM_POOL_INIT(MAPMEM_OBJECTS, sizeof(Object), 256);
+static MapMemPool obj_node_pool = MAPMEM_POOL_INIT(MAPMEM_OBJECT_NODES, sizeof(ObjectListNode), 256);
+
+// CE: Size (in pixels) of hit grid cell.
+#define OBJ_HIT_CELL_SIZE 128
+
+// CE: Objects whose bounds intersect hit grid cell.
+typedef struct ObjectHitCell {
+    ObjectListNode** nodes;
+    int length;
+    int capacity;
+} ObjectHitCell;
+
+// CE: Per-elevation grid of object bounds in scroll independent coordinates,
+// used by `obj_create_intersect_list` to test only objects under the mouse.
+// `NULL` when grid is unavailable, intersection falls back to scanning every
+// hex of update area.
+static ObjectHitCell* obj_hit_grid = NULL;
+static int obj_hit_grid_x = 0;
+static int obj_hit_grid_y = 0;
+static int obj_hit_grid_columns = 0;
+static int obj_hit_grid_rows = 0;
+
+// CE: Query stamps of hexes inside intersection area and scratch list of
+// candidate hexes, see `obj_create_intersect_list`.
+static unsigned int obj_hit_query = 0;
+static unsigned int obj_hit_area[HEX_GRID_SIZE];
+static int* obj_hit_tiles = NULL;
+static int obj_hit_tiles_capacity = 0;
+
 // 0x65F3F0
 static Rect updateAreaPixelBounds;
 
@@ -265,13 +452,19 @@ static char obj_seen_check[5001];
 // 0x6609A5
 static char obj_seen[5001];
 
+// CE: Indices of `obj_seen_check` entries marked since last
+// `obj_process_seen`. Check window of a byte of `obj_seen` is marked when it
+// becomes non-zero, so moving around only adds hexes not covered yet.
+static int obj_seen_check_list[5001];
+static int obj_seen_check_count = 0;
+
 // 0x47A590
 int obj_init(unsigned char* buf, int width, int height, int pitch)
 {
     int dudeFid;
     int eggFid;
 
-    memset(obj_seen, 0, 5001);
+    obj_seen_clear();
     updateAreaPixelBounds.lrx = width + 320;
     updateAreaPixelBounds.ulx = -320;
     updateAreaPixelBounds.lry = height + 240;
@@ -315,6 +508,7 @@ int obj_init(unsigned char* buf, int width, int height, int pitch)
     obj_light_table_init();
     obj_blend_table_init();
     obj_misc_table_init();
+    obj_hit_grid_init();
 
     buf_width = width;
     buf_length = height;
@@ -360,7 +554,7 @@ void obj_reset()
     if (objInitialized) {
         text_object_reset();
         obj_remove_all();
-        memset(obj_seen, 0, 5001);
+        obj_seen_clear();
         light_reset();
     }
 }
@@ -387,6 +581,10 @@ void obj_exit()
         obj_order_table_exit();
 
         obj_offset_table_exit();
+
+        obj_hit_grid_exit();
+
+        obj_outline_shape_exit();
     }
 }
 
@@ -439,6 +637,8 @@ static int obj_read_obj(Object* obj, DB_FILE* stream)
 // 0x47AAF4
 int obj_load(DB_FILE* stream)
 {
+    MapStatScope mapStatScope(MAP_STAT_PHASE_OBJ_LOAD);
+
     int rc = obj_load_func(stream);
 
     fix_violence_level = -1;
@@ -458,7 +658,7 @@ static int obj_load_func(DB_FILE* stream)
         fixMapInventory = false;
     }
 
-    if (!config_get_value(&game_config, GAME_CONFIG_PREFERENCES_KEY, GAME_CONFIG_VIOLENCE_LEVEL_KEY, &fix_violence_level)) {
+    if (!config_handle_get_value(&game_config_violence_level, &fix_violence_level)) {
         fix_violence_level = VIOLENCE_LEVEL_MAXIMUM_BLOOD;
     }
 
@@ -479,6 +679,11 @@ static int obj_load_func(DB_FILE* stream)
         preload_list_index = 0;
     }
 
+    // CE: Art of every distinct fid is scheduled for background loading as
+    // soon as object is read, so it overlaps with reading the rest of the
+    // objects and remaining map setup.
+    std::unordered_set<int> prefetchedFids;
+
     for (int elevation = 0; elevation < ELEVATION_COUNT; elevation++) {
         int objectCountAtElevation;
         if (db_freadInt(stream, &objectCountAtElevation) == -1) {
@@ -512,6 +717,10 @@ static int obj_load_func(DB_FILE* stream)
             objectListNode->obj->outline = 0;
             preload_list[preload_list_index++] = objectListNode->obj->fid;
 
+            if (prefetchedFids.insert(objectListNode->obj->fid).second) {
+                obj_prefetch_art(objectListNode->obj->fid);
+            }
+
             if (objectListNode->obj->sid != -1) {
                 Script* script;
                 if (scr_ptr(objectListNode->obj->sid, &script) == -1) {
@@ -547,8 +756,7 @@ static int obj_load_func(DB_FILE* stream)
                     }
 
                     if (fixMapInventory) {
-                        inventoryItem->item = (Object*)mem_malloc(sizeof(Object));
-                        if (inventoryItem->item == NULL) {
+                        if (obj_create_object(&(inventoryItem->item)) == -1) {
                             debug_printf("Error loading inventory\n");
                             return -1;
                         }
@@ -570,6 +778,9 @@ static int obj_load_func(DB_FILE* stream)
         }
     }
 
+    // CE: Objects read from the map bypass item functions.
+    item_totals_invalidate();
+
     obj_rebuild_all_light();
 
     return 0;
@@ -673,6 +884,8 @@ static int obj_write_obj(Object* obj, DB_FILE* stream)
 // 0x47B15C
 int obj_save(DB_FILE* stream)
 {
+    MapStatScope mapStatScope(MAP_STAT_PHASE_OBJ_SAVE);
+
     if (stream == NULL) {
         return -1;
     }
@@ -800,12 +1013,16 @@ void obj_render_pre_roof(Rect* rect, int elevation)
 
     outlineCount = 0;
 
+    // CE: Visit only spans of draw order inside update area instead of
+    // testing every hex of the whole table.
+    int spansLength = obj_order_spans(parity, updateAreaHexHeight, updateAreaHexWidth);
+
     int renderCount = 0;
-    for (int i = 0; i < updateHexArea; i++) {
-        int offsetIndex = *orders++;
-        if (updateAreaHexHeight > offsetDivTable[offsetIndex] && updateAreaHexWidth > offsetModTable[offsetIndex]) {
-            int tile = upperLeftTile + offsetTable[parity][offsetIndex];
-            ObjectListNode* objectListNode = hexGridTileIsValid(tile)
+    for (int span = 0; span < spansLength; span++) {
+        for (int i = orderSpans[span].start; i < orderSpans[span].end; i++) {
+            int offsetIndex = orders[i];
+            int tile = upperLeftTile + offsets[offsetIndex];
+            ObjectListNode* objectListNode = obj_tile_occupied(tile, elevation)
                 ? objectTable[tile]
                 : NULL;
 
@@ -1121,9 +1338,14 @@ int obj_disconnect(Object* obj, Rect* rect)
     }
 
     if (node != NULL) {
-        mem_free(node);
+        obj_hit_grid_remove(node);
+        obj_type_list_remove(node);
+        mapmem_pool_free(&obj_node_pool, node);
     }
 
+    // CE: Update blocking bits of vacated hex.
+    obj_update_blocking(obj);
+
     obj->tile = -1;
 
     return 0;
@@ -1254,6 +1476,8 @@ int obj_move(Object* a1, int a2, int a3, int elevation, Rect* a5)
         return -1;
     }
 
+    statever_bump(STATE_VERSION_OBJECTS);
+
     // TODO: Get rid of initialization.
     ObjectListNode* node = NULL;
     ObjectListNode* previousNode;
@@ -1282,6 +1506,9 @@ int obj_move(Object* a1, int a2, int a3, int elevation, Rect* a5)
             }
         }
 
+        // CE: Update blocking bits of vacated hex.
+        obj_update_blocking(a1);
+
         a1->tile = -1;
         a1->elevation = elevation;
         v22 = 1;
@@ -1361,6 +1588,8 @@ int obj_move_to_tile(Object* obj, int tile, int elevation, Rect* rect)
         return -1;
     }
 
+    statever_bump(STATE_VERSION_OBJECTS);
+
     ObjectListNode* node;
     ObjectListNode* prevNode;
     if (obj_node_ptr(obj, &node, &prevNode) == -1) {
@@ -1389,6 +1618,9 @@ int obj_move_to_tile(Object* obj, int tile, int elevation, Rect* rect)
         }
     }
 
+    // CE: Update blocking bits of vacated hex.
+    obj_update_blocking(obj);
+
     if (obj_connect_to_tile(node, tile, elevation, rect) == -1) {
         return -1;
     }
@@ -1505,6 +1737,8 @@ int obj_change_fid(Object* obj, int fid, Rect* dirtyRect)
         return -1;
     }
 
+    obj_static_changed(obj);
+
     if (dirtyRect != NULL) {
         obj_bound(obj, dirtyRect);
 
@@ -1516,6 +1750,15 @@ int obj_change_fid(Object* obj, int fid, Rect* dirtyRect)
         obj->fid = fid;
     }
 
+    obj_static_changed(obj);
+
+    // CE: Art type decides whether object blocks.
+    obj_update_blocking(obj);
+
+    statever_bump(STATE_VERSION_OBJECTS);
+
+    obj_update_hit_bounds(obj);
+
     return 0;
 }
 
@@ -1555,6 +1798,8 @@ int obj_set_frame(Object* obj, int frame, Rect* rect)
         obj->frame = frame;
     }
 
+    obj_update_hit_bounds(obj);
+
     return 0;
 }
 
@@ -1597,6 +1842,8 @@ int obj_inc_frame(Object* obj, Rect* dirtyRect)
         obj->frame = nextFrame;
     }
 
+    obj_update_hit_bounds(obj);
+
     return 0;
 }
 
@@ -1637,6 +1884,8 @@ int obj_dec_frame(Object* obj, Rect* dirtyRect)
         obj->frame = prevFrame;
     }
 
+    obj_update_hit_bounds(obj);
+
     return 0;
 }
 
@@ -1662,6 +1911,10 @@ int obj_set_rotation(Object* obj, int direction, Rect* dirtyRect)
         obj->rotation = direction;
     }
 
+    statever_bump(STATE_VERSION_OBJECTS);
+
+    obj_update_hit_bounds(obj);
+
     return 0;
 }
 
@@ -1690,6 +1943,8 @@ int obj_dec_rotation(Object* obj, Rect* dirtyRect)
 // 0x47C83C
 void obj_rebuild_all_light()
 {
+    MapStatScope mapStatScope(MAP_STAT_PHASE_REBUILD_LIGHT);
+
     light_reset_tiles();
 
     for (int tile = 0; tile < HEX_GRID_SIZE; tile++) {
@@ -1701,6 +1956,28 @@ void obj_rebuild_all_light()
     }
 }
 
+// CE: Starts batch of object changes. Light of objects moved, added or
+// removed in the batch is not adjusted one by one, `obj_light_batch_end`
+// rebuilds all light once instead.
+void obj_light_batch_begin()
+{
+    if (obj_light_batch_depth++ == 0) {
+        obj_light_batch_dirty = false;
+    }
+}
+
+void obj_light_batch_end()
+{
+    if (obj_light_batch_depth == 0) {
+        return;
+    }
+
+    if (--obj_light_batch_depth == 0 && obj_light_batch_dirty) {
+        obj_light_batch_dirty = false;
+        obj_rebuild_all_light();
+    }
+}
+
 // 0x47C878
 int obj_set_light(Object* obj, int lightDistance, int lightIntensity, Rect* rect)
 {
@@ -1819,6 +2096,8 @@ int obj_turn_on(Object* obj, Rect* rect)
     obj->flags &= ~OBJECT_HIDDEN;
     obj->outline &= ~OUTLINE_DISABLED;
 
+    obj_update_blocking(obj);
+
     if (obj_adjust_light(obj, 0, rect) == -1) {
         if (rect != NULL) {
             obj_bound(obj, rect);
@@ -1855,6 +2134,8 @@ int obj_turn_off(Object* object, Rect* rect)
 
     object->flags |= OBJECT_HIDDEN;
 
+    obj_update_blocking(object);
+
     if ((object->outline & OUTLINE_TYPE_MASK) != 0) {
         object->outline |= OUTLINE_DISABLED;
     }
@@ -2021,6 +2302,8 @@ int obj_inven_free(Inventory* inventory)
         inventory->length = 0;
     }
 
+    item_totals_invalidate();
+
     return 0;
 }
 
@@ -2198,6 +2481,112 @@ Object* obj_find_next_at()
     return NULL;
 }
 
+// CE: Starts iteration over objects on the map of given proto type. Pass -1
+// as `elevation` to visit all elevations. Unlike `obj_find_first`, objects
+// are visited in arbitrary order. Current object can be removed or moved
+// while iterating.
+Object* obj_find_first_of_type(int objectType, int elevation)
+{
+    find_type_next = NULL;
+
+    if (objectType < 0 || objectType >= OBJ_TYPE_COUNT) {
+        return NULL;
+    }
+
+    if (elevation == -1) {
+        find_type_elev = 0;
+        find_type_max_elev = ELEVATION_COUNT - 1;
+    } else if (elevationIsValid(elevation)) {
+        find_type_elev = elevation;
+        find_type_max_elev = elevation;
+    } else {
+        return NULL;
+    }
+
+    find_type = objectType;
+    find_type_next = obj_type_lists[find_type_elev * OBJ_TYPE_COUNT + find_type];
+
+    return obj_find_next_of_type();
+}
+
+// CE: Continues iteration started by `obj_find_first_of_type`.
+Object* obj_find_next_of_type()
+{
+    while (find_type_elev <= find_type_max_elev) {
+        while (find_type_next != NULL) {
+            ObjectListNode* node = find_type_next;
+            find_type_next = node->typeNext;
+
+            if (!art_get_disable(FID_TYPE(node->obj->fid))) {
+                return node->obj;
+            }
+        }
+
+        find_type_elev++;
+        if (find_type_elev <= find_type_max_elev) {
+            find_type_next = obj_type_lists[find_type_elev * OBJ_TYPE_COUNT + find_type];
+        }
+    }
+
+    return NULL;
+}
+
+// CE: Registers node in type list matching its object.
+static void obj_type_list_add(ObjectListNode* node)
+{
+    obj_type_list_remove(node);
+
+    Object* obj = node->obj;
+    if (obj == NULL || obj->tile == -1 || obj->pid == -1 || !elevationIsValid(obj->elevation)) {
+        return;
+    }
+
+    int type = PID_TYPE(obj->pid);
+    if (type < 0 || type >= OBJ_TYPE_COUNT) {
+        return;
+    }
+
+    obj_static_changed(obj);
+
+    int list = obj->elevation * OBJ_TYPE_COUNT + type;
+    node->typePrev = NULL;
+    node->typeNext = obj_type_lists[list];
+    if (node->typeNext != NULL) {
+        node->typeNext->typePrev = node;
+    }
+    obj_type_lists[list] = node;
+    node->typeList = list;
+}
+
+// CE: Removes node from type list it was registered in.
+static void obj_type_list_remove(ObjectListNode* node)
+{
+    if (node->typeList == -1) {
+        return;
+    }
+
+    obj_static_changed(node->obj);
+
+    // Keep iteration going when next object is removed.
+    if (find_type_next == node) {
+        find_type_next = node->typeNext;
+    }
+
+    if (node->typePrev != NULL) {
+        node->typePrev->typeNext = node->typeNext;
+    } else {
+        obj_type_lists[node->typeList] = node->typeNext;
+    }
+
+    if (node->typeNext != NULL) {
+        node->typeNext->typePrev = node->typePrev;
+    }
+
+    node->typePrev = NULL;
+    node->typeNext = NULL;
+    node->typeList = -1;
+}
+
 // 0x47D108
 void obj_bound(Object* obj, Rect* rect)
 {
@@ -2287,14 +2676,27 @@ bool obj_occupied(int tile, int elevation)
 // 0x47D2F0
 Object* obj_blocking_at(Object* a1, int tile, int elev)
 {
-    ObjectListNode* objectListNode;
-    Object* v7;
-    int type;
-
     if (!hexGridTileIsValid(tile)) {
         return NULL;
     }
 
+    // CE: Most of the hexes tested by pathfinder have no blockers at all.
+    if (elevationIsValid(elev)
+        && (obj_blocking_bits[elev][tile >> 3] & (1 << (tile & 7))) == 0) {
+        return NULL;
+    }
+
+    return obj_blocking_scan(a1, tile, elev);
+}
+
+// CE: Walks object lists of `tile` and its neighbours looking for object
+// blocking `tile` (extracted from `obj_blocking_at`).
+static Object* obj_blocking_scan(Object* a1, int tile, int elev)
+{
+    ObjectListNode* objectListNode;
+    Object* v7;
+    int type;
+
     objectListNode = objectTable[tile];
     while (objectListNode != NULL) {
         v7 = objectListNode->obj;
@@ -2337,6 +2739,173 @@ Object* obj_blocking_at(Object* a1, int tile, int elev)
     return NULL;
 }
 
+// CE: Recomputes blocking bit of `tile` from object lists.
+static void obj_blocking_update_tile(int tile, int elevation)
+{
+    // CE: Objects affecting light might have changed as well.
+    obj_light_classes[elevation][tile] = 0;
+
+    unsigned char mask = 1 << (tile & 7);
+
+    // Lists are sorted by elevation, scan stops at first object above.
+    bool occupied = false;
+    for (ObjectListNode* node = objectTable[tile]; node != NULL; node = node->next) {
+        if (node->obj->elevation >= elevation) {
+            occupied = node->obj->elevation == elevation;
+            break;
+        }
+    }
+
+    if (occupied) {
+        obj_occupied_bits[elevation][tile >> 3] |= mask;
+    } else {
+        obj_occupied_bits[elevation][tile >> 3] &= ~mask;
+    }
+    unsigned char bits = obj_blocking_bits[elevation][tile >> 3];
+    if (obj_blocking_scan(NULL, tile, elevation) != NULL) {
+        bits |= mask;
+    } else {
+        bits &= ~mask;
+    }
+
+    if (bits != obj_blocking_bits[elevation][tile >> 3]) {
+        obj_blocking_bits[elevation][tile >> 3] = bits;
+        pathgraph_invalidate_tile(tile, elevation);
+    }
+}
+
+// CE: Returns `true` if `tile` holds any object of `elevation`. `false` for
+// invalid hexes.
+static bool obj_tile_occupied(int tile, int elevation)
+{
+    if (!hexGridTileIsValid(tile)) {
+        return false;
+    }
+
+    return (obj_occupied_bits[elevation][tile >> 3] & (1 << (tile & 7))) != 0;
+}
+
+// CE: Returns `true` if `tile` is blocked by any object (including movers).
+bool obj_hex_blocked(int tile, int elevation)
+{
+    if (!hexGridTileIsValid(tile) || !elevationIsValid(elevation)) {
+        return false;
+    }
+
+    return (obj_blocking_bits[elevation][tile >> 3] & (1 << (tile & 7))) != 0;
+}
+
+// CE: Recomputes blocking bits of hexes affected by `obj`. Should be called
+// whenever object is linked to/unlinked from its tile (while `tile` and
+// `elevation` still point to it), or when its art type, lock state,
+// `OBJECT_HIDDEN` or `OBJECT_NO_BLOCK` flags change.
+void obj_update_blocking(Object* obj)
+{
+    if (obj == NULL) {
+        return;
+    }
+
+    int tile = obj->tile;
+    int elevation = obj->elevation;
+    if (!hexGridTileIsValid(tile) || !elevationIsValid(elevation)) {
+        return;
+    }
+
+    obj_blocking_update_tile(tile, elevation);
+    obj_blocking_epoch_value++;
+
+    if ((obj->flags & OBJECT_MULTIHEX) != 0) {
+        for (int rotation = 0; rotation < ROTATION_COUNT; rotation++) {
+            int neighbor = tile_num_in_direction(tile, rotation, 1);
+            if (neighbor != tile && hexGridTileIsValid(neighbor)) {
+                obj_blocking_update_tile(neighbor, elevation);
+            }
+        }
+    }
+}
+
+// CE: Collects blockers of hexes within `radius` of `tile` (center
+// excluded) into `objects`, one entry per blocked hex (so multihex objects
+// can appear more than once). Hexes are visited ring by ring, each ring
+// starting from its north-east corner and going clockwise, which is the
+// order explosions apply damage in. Empty hexes are skipped using blocking
+// bits, so cost depends on area only. Returns number of entries written.
+int obj_ring_blockers(Object* excluded, int tile, int elevation, int radius, Object** objects, int capacity)
+{
+    int count = 0;
+    int step = 0;
+    int ring = 0;
+    int rotation = 0;
+    int current = -1;
+    int ringStart = tile;
+
+    while (count < capacity) {
+        // Ring is done when walk returns to its start. Rings clipped by map
+        // edge might never get back, these are cut after full walk length.
+        if (ring != 0
+            && step < ROTATION_COUNT * ring - 1
+            && (current = tile_num_in_direction(current, rotation, 1)) != ringStart) {
+            step++;
+            if (step % ring == 0) {
+                rotation += 1;
+                if (rotation == ROTATION_COUNT) {
+                    rotation = ROTATION_NE;
+                }
+            }
+        } else {
+            ring++;
+
+            if (ring > radius) {
+                current = -1;
+            } else {
+                current = tile_num_in_direction(ringStart, ROTATION_NE, 1);
+            }
+
+            ringStart = current;
+            rotation = ROTATION_SE;
+            step = 0;
+        }
+
+        if (current == -1) {
+            break;
+        }
+
+        Object* obstacle = obj_blocking_at(excluded, current, elevation);
+        if (obstacle != NULL) {
+            objects[count++] = obstacle;
+        }
+    }
+
+    return count;
+}
+
+// CE: Returns current blocking epoch. Results computed from blocking state
+// (such as paths) remain valid while epoch stays the same.
+unsigned int obj_blocking_epoch()
+{
+    return obj_blocking_epoch_value;
+}
+
+// CE: Returns current static objects epoch. Images built from walls and
+// scenery (such as automap) remain valid while epoch stays the same.
+unsigned int obj_static_epoch()
+{
+    return obj_static_epoch_value;
+}
+
+// CE: Bumps static objects epoch if `obj` is a wall or scenery.
+static void obj_static_changed(Object* obj)
+{
+    if (obj == NULL) {
+        return;
+    }
+
+    int type = FID_TYPE(obj->fid);
+    if (type == OBJ_TYPE_WALL || type == OBJ_TYPE_SCENERY || PID_TYPE(obj->pid) == OBJ_TYPE_SCENERY) {
+        obj_static_epoch_value++;
+    }
+}
+
 // 0x47D3D8
 int obj_scroll_blocking_at(int tile, int elev)
 {
@@ -2345,6 +2914,10 @@ int obj_scroll_blocking_at(int tile, int elev)
         return -1;
     }
 
+    if (!obj_tile_occupied(tile, elev)) {
+        return -1;
+    }
+
     ObjectListNode* objectListNode = objectTable[tile];
     while (objectListNode != NULL) {
         if (elev < objectListNode->obj->elevation) {
@@ -2364,6 +2937,10 @@ int obj_scroll_blocking_at(int tile, int elev)
 // 0x47D41C
 Object* obj_sight_blocking_at(Object* a1, int tile, int elevation)
 {
+    if (!obj_tile_occupied(tile, elevation)) {
+        return NULL;
+    }
+
     ObjectListNode* objectListNode = objectTable[tile];
     while (objectListNode != NULL) {
         Object* object = objectListNode->obj;
@@ -2423,7 +3000,7 @@ int obj_create_list(int tile, int elevation, int objectType, Object*** objectLis
                 objectListNode = objectListNode->next;
             }
         }
-    } else {
+    } else if (obj_tile_occupied(tile, elevation)) {
         ObjectListNode* objectListNode = objectTable[tile];
         while (objectListNode != NULL) {
             Object* obj = objectListNode->obj;
@@ -2482,103 +3059,254 @@ void obj_delete_list(Object** objectList)
     }
 }
 
-// 0x47D634
-void translucent_trans_buf_to_buf(unsigned char* src, int srcWidth, int srcHeight, int srcPitch, unsigned char* dest, int destX, int destY, int destPitch, unsigned char* a9, unsigned char* a10)
-{
-    dest += destPitch * destY + destX;
-    int srcStep = srcPitch - srcWidth;
-    int destStep = destPitch - srcWidth;
+// CE: Number of light levels (`light >> 9`) with cached shade tables.
+#define OBJ_SHADE_LEVELS 129
+
+// CE: Column of `intensityColorTable` for one light level, gathered into a
+// contiguous table so blitters do not stride 256 bytes per pixel. `dark`
+// variant keeps animated palette colors (0xE5 and above) unchanged, as
+// `dark_trans_buf_to_buf` always did. `identity` is set when table maps
+// every color to itself.
+typedef struct ObjShadeTable {
+    unsigned int version;
+    bool identity;
+    unsigned char colors[256];
+} ObjShadeTable;
+
+static ObjShadeTable obj_shade_tables[2][OBJ_SHADE_LEVELS];
+
+// CE: Pixel operations of sprite blitters (`obj_blit`), each is fixed at
+// compile time so per-pixel loop has no mode tests.
+struct ObjBlitCopy {
+    unsigned char operator()(unsigned char src, unsigned char dest) const
+    {
+        return src;
+    }
+};
 
-    for (int y = 0; y < srcHeight; y++) {
-        for (int x = 0; x < srcWidth; x++) {
-            // TODO: Probably wrong.
-            unsigned char v1 = a10[*src];
-            unsigned char* v2 = a9 + (v1 << 8);
-            unsigned char v3 = *dest;
+struct ObjBlitShade {
+    const unsigned char* shade;
 
-            *dest = v2[v3];
+    unsigned char operator()(unsigned char src, unsigned char dest) const
+    {
+        return shade[src];
+    }
+};
 
-            src++;
-            dest++;
-        }
+struct ObjBlitBlend {
+    const unsigned char* blend;
+    const unsigned char* gray;
 
-        src += srcStep;
-        dest += destStep;
+    unsigned char operator()(unsigned char src, unsigned char dest) const
+    {
+        return blend[(gray[src] << 8) + dest];
     }
-}
+};
 
-// 0x47D758
-void dark_trans_buf_to_buf(unsigned char* src, int srcWidth, int srcHeight, int srcPitch, unsigned char* dest, int destX, int destY, int destPitch, int light)
-{
-    unsigned char* sp = src;
-    unsigned char* dp = dest + destPitch * destY + destX;
+struct ObjBlitTranslucent {
+    const unsigned char* blend;
+    const unsigned char* gray;
+    const unsigned char* shade;
 
-    int srcStep = srcPitch - srcWidth;
-    int destStep = destPitch - srcWidth;
-    // TODO: Name might be confusing.
-    int lightModifier = light >> 9;
+    unsigned char operator()(unsigned char src, unsigned char dest) const
+    {
+        return shade[blend[(gray[src] << 8) + dest]];
+    }
+};
 
+// CE: Blits `srcWidth` x `srcHeight` pixels (already clipped) applying `op`
+// to every pixel, skipping transparent (0) ones when `SkipTransparent` is
+// set.
+template <bool SkipTransparent, typename Op>
+static void obj_blit(unsigned char* src, int srcWidth, int srcHeight, int srcPitch, unsigned char* dest, int destPitch, Op op)
+{
     for (int y = 0; y < srcHeight; y++) {
         for (int x = 0; x < srcWidth; x++) {
-            unsigned char b = *sp;
-            if (b != 0) {
-                if (b < 0xE5) {
-                    b = intensityColorTable[b][lightModifier];
-                }
-
-                *dp = b;
+            unsigned char b = src[x];
+            if (!SkipTransparent || b != 0) {
+                dest[x] = op(b, dest[x]);
             }
-
-            sp++;
-            dp++;
         }
 
-        sp += srcStep;
-        dp += destStep;
+        src += srcPitch;
+        dest += destPitch;
     }
 }
 
-// 0x47D7E4
-void dark_translucent_trans_buf_to_buf(unsigned char* src, int srcWidth, int srcHeight, int srcPitch, unsigned char* dest, int destX, int destY, int destPitch, int light, unsigned char* a10, unsigned char* a11)
+// CE: Span encoded counterpart of `obj_blit` (see `span_encode`), runs hold
+// opaque pixels only. Copies `srcWidth` x `srcHeight` part of sprite starting
+// at `srcX`, `srcY`.
+template <typename Op>
+static void obj_blit_spans(unsigned char* spans, int srcX, int srcY, int srcWidth, int srcHeight, unsigned char* dest, int destPitch, Op op)
 {
-    int srcStep = srcPitch - srcWidth;
-    int destStep = destPitch - srcWidth;
-    int lightModifier = light >> 9;
-
-    dest += destPitch * destY + destX;
+    int* rowOffsets = (int*)spans;
+    int srcRight = srcX + srcWidth;
 
     for (int y = 0; y < srcHeight; y++) {
-        for (int x = 0; x < srcWidth; x++) {
-            unsigned char srcByte = *src;
-            if (srcByte != 0) {
-                unsigned char destByte = *dest;
-                unsigned int index = a11[srcByte] << 8;
-                index = a10[index + destByte];
-                *dest = intensityColorTable[index][lightModifier];
+        unsigned char* ptr = spans + rowOffsets[srcY + y];
+        int count = ptr[0] | (ptr[1] << 8);
+        ptr += 2;
+
+        int x = 0;
+        while (count-- > 0) {
+            x += ptr[0] | (ptr[1] << 8);
+            if (x >= srcRight) {
+                break;
             }
 
-            src++;
-            dest++;
+            int run = ptr[2] | (ptr[3] << 8);
+            ptr += 4;
+
+            int start = x > srcX ? x : srcX;
+            int end = x + run < srcRight ? x + run : srcRight;
+
+            unsigned char* sp = ptr + start - x;
+            unsigned char* p = dest + start - srcX;
+            for (int index = start; index < end; index++) {
+                *p = op(*sp++, *p);
+                p++;
+            }
+
+            ptr += run;
+            x += run;
         }
 
-        src += srcStep;
-        dest += destStep;
+        dest += destPitch;
     }
 }
 
-// 0x47D898
-void intensity_mask_buf_to_buf(unsigned char* src, int srcWidth, int srcHeight, int srcPitch, unsigned char* dest, int destPitch, unsigned char* mask, int maskPitch, int light)
+// CE: Returns shade table for `light` (see `ObjShadeTable`), or `NULL` if
+// light is out of cached range. Built on first use after intensity tables
+// change.
+static ObjShadeTable* obj_shade_table(int light, bool dark)
 {
-    int srcStep = srcPitch - srcWidth;
+    int level = light >> 9;
+    if (level < 0 || level >= OBJ_SHADE_LEVELS) {
+        return NULL;
+    }
+
+    ObjShadeTable* table = &(obj_shade_tables[dark ? 1 : 0][level]);
+    unsigned int version = colorIntensityVersion();
+    if (table->version != version) {
+        bool identity = true;
+        for (int index = 0; index < 256; index++) {
+            unsigned char color = dark && index >= 0xE5
+                ? (unsigned char)index
+                : intensityColorTable[index][level];
+            table->colors[index] = color;
+
+            // Transparent color is never looked up.
+            if (index != 0 && color != index) {
+                identity = false;
+            }
+        }
+
+        table->identity = identity;
+        table->version = version;
+    }
+
+    return table;
+}
+
+// 0x47D634
+void translucent_trans_buf_to_buf(unsigned char* src, int srcWidth, int srcHeight, int srcPitch, unsigned char* dest, int destX, int destY, int destPitch, unsigned char* a9, unsigned char* a10)
+{
+    dest += destPitch * destY + destX;
+
+    // TODO: Probably wrong.
+    // NOTE: Unlike other blitters this one blends transparent pixels as well
+    // and does not apply light.
+    obj_blit<false>(src, srcWidth, srcHeight, srcPitch, dest, destPitch, ObjBlitBlend { a9, a10 });
+}
+
+// 0x47D758
+void dark_trans_buf_to_buf(unsigned char* src, int srcWidth, int srcHeight, int srcPitch, unsigned char* dest, int destX, int destY, int destPitch, int light)
+{
+    dest += destPitch * destY + destX;
+
+    // CE: Light is resolved once per call into shade table (or plain copy
+    // when it changes nothing).
+    ObjShadeTable* table = obj_shade_table(light, true);
+    if (table == NULL) {
+        unsigned char shade[256];
+        for (int index = 0; index < 256; index++) {
+            shade[index] = index < 0xE5 ? intensityColorTable[index][(light >> 9) & 0xFF] : (unsigned char)index;
+        }
+        obj_blit<true>(src, srcWidth, srcHeight, srcPitch, dest, destPitch, ObjBlitShade { shade });
+    } else if (table->identity) {
+        obj_blit<true>(src, srcWidth, srcHeight, srcPitch, dest, destPitch, ObjBlitCopy {});
+    } else {
+        obj_blit<true>(src, srcWidth, srcHeight, srcPitch, dest, destPitch, ObjBlitShade { table->colors });
+    }
+}
+
+// CE: Span encoded version of `dark_trans_buf_to_buf`, see `span_encode`.
+// Copies `srcWidth` x `srcHeight` part of sprite starting at `srcX`, `srcY`.
+void dark_trans_span_to_buf(unsigned char* spans, int srcX, int srcY, int srcWidth, int srcHeight, unsigned char* dest, int destX, int destY, int destPitch, int light)
+{
+    dest += destPitch * destY + destX;
+
+    ObjShadeTable* table = obj_shade_table(light, true);
+    if (table == NULL) {
+        unsigned char shade[256];
+        for (int index = 0; index < 256; index++) {
+            shade[index] = index < 0xE5 ? intensityColorTable[index][(light >> 9) & 0xFF] : (unsigned char)index;
+        }
+        obj_blit_spans(spans, srcX, srcY, srcWidth, srcHeight, dest, destPitch, ObjBlitShade { shade });
+    } else if (table->identity) {
+        obj_blit_spans(spans, srcX, srcY, srcWidth, srcHeight, dest, destPitch, ObjBlitCopy {});
+    } else {
+        obj_blit_spans(spans, srcX, srcY, srcWidth, srcHeight, dest, destPitch, ObjBlitShade { table->colors });
+    }
+}
+
+// 0x47D7E4
+void dark_translucent_trans_buf_to_buf(unsigned char* src, int srcWidth, int srcHeight, int srcPitch, unsigned char* dest, int destX, int destY, int destPitch, int light, unsigned char* a10, unsigned char* a11)
+{
+    dest += destPitch * destY + destX;
+
+    unsigned char shade[256];
+    ObjShadeTable* table = obj_shade_table(light, false);
+    if (table == NULL) {
+        for (int index = 0; index < 256; index++) {
+            shade[index] = intensityColorTable[index][(light >> 9) & 0xFF];
+        }
+    }
+
+    ObjBlitTranslucent op;
+    op.blend = a10;
+    op.gray = a11;
+    op.shade = table != NULL ? table->colors : shade;
+    obj_blit<true>(src, srcWidth, srcHeight, srcPitch, dest, destPitch, op);
+}
+
+// 0x47D898
+void intensity_mask_buf_to_buf(unsigned char* src, int srcWidth, int srcHeight, int srcPitch, unsigned char* dest, int destPitch, unsigned char* mask, int maskPitch, int light)
+{
+    int srcStep = srcPitch - srcWidth;
     int destStep = destPitch - srcWidth;
     int maskStep = maskPitch - srcWidth;
     light >>= 9;
 
+    // CE: Sprite color is shaded with the same light everywhere, mask
+    // weights vary per pixel and still use `intensityColorTable`.
+    unsigned char localShade[256];
+    const unsigned char* shade;
+    ObjShadeTable* table = obj_shade_table(light << 9, false);
+    if (table != NULL) {
+        shade = table->colors;
+    } else {
+        for (int index = 0; index < 256; index++) {
+            localShade[index] = intensityColorTable[index][light & 0xFF];
+        }
+        shade = localShade;
+    }
+
     for (int y = 0; y < srcHeight; y++) {
         for (int x = 0; x < srcWidth; x++) {
             unsigned char b = *src;
             if (b != 0) {
-                b = intensityColorTable[b][light];
+                b = shade[b];
                 unsigned char m = *mask;
                 if (m != 0) {
                     unsigned char d = *dest;
@@ -2747,11 +3475,115 @@ int obj_create_intersect_list(int x, int y, int elevation, int objectType, Objec
     int count = 0;
 
     int parity = tile_center_tile & 1;
-    for (int index = 0; index < updateHexArea; index++) {
-        int offsetIndex = orderTable[parity][index];
-        if (offsetDivTable[offsetIndex] < 30 && offsetModTable[offsetIndex] < 20) {
+
+    // CE: Test only objects whose bounds contain the point. Hexes are visited
+    // in the same order (ascending, limited to the same area) to keep
+    // resulting list identical.
+    if (obj_hit_grid != NULL && elevationIsValid(elevation)) {
+        obj_hit_query++;
+        if (obj_hit_query == 0) {
+            memset(obj_hit_area, 0, sizeof(obj_hit_area));
+            obj_hit_query = 1;
+        }
+
+        int spansLength = obj_order_spans(parity, 30, 20);
+        for (int span = 0; span < spansLength; span++) {
+            for (int index = orderSpans[span].start; index < orderSpans[span].end; index++) {
+                int offsetIndex = orderTable[parity][index];
+                int tile = offsetTable[parity][offsetIndex] + upperLeftTile;
+                if (hexGridTileIsValid(tile)) {
+                    obj_hit_area[tile] = obj_hit_query;
+                }
+            }
+        }
+
+        int originX;
+        int originY;
+        tile_world_origin(&originX, &originY);
+
+        int worldX = x - originX;
+        int worldY = y - originY;
+
+        int column;
+        int row;
+        int maxColumn;
+        int maxRow;
+        obj_hit_grid_cells(worldX, worldY, worldX, worldY, &column, &row, &maxColumn, &maxRow);
+
+        ObjectHitCell* cell = &(obj_hit_grid[(elevation * obj_hit_grid_rows + row) * obj_hit_grid_columns + column]);
+
+        int tileCount = 0;
+        for (int index = 0; index < cell->length; index++) {
+            ObjectListNode* node = cell->nodes[index];
+            Object* object = node->obj;
+            if (worldX < node->hitLeft || worldX > node->hitRight || worldY < node->hitTop || worldY > node->hitBottom) {
+                continue;
+            }
+
+            if (object->elevation != elevation
+                || object->tile == -1
+                || obj_hit_area[object->tile] != obj_hit_query
+                || (objectType != -1 && FID_TYPE(object->fid) != objectType)
+                || object == obj_egg) {
+                continue;
+            }
+
+            if (tileCount == obj_hit_tiles_capacity) {
+                int capacity = obj_hit_tiles_capacity != 0 ? obj_hit_tiles_capacity * 2 : 32;
+                int* tiles = (int*)mem_realloc(obj_hit_tiles, sizeof(*tiles) * capacity);
+                if (tiles == NULL) {
+                    break;
+                }
+
+                obj_hit_tiles = tiles;
+                obj_hit_tiles_capacity = capacity;
+            }
+
+            node->hitQuery = obj_hit_query;
+            obj_hit_tiles[tileCount++] = object->tile;
+        }
+
+        qsort(obj_hit_tiles, tileCount, sizeof(*obj_hit_tiles), obj_hit_tile_compare);
+
+        for (int index = 0; index < tileCount; index++) {
+            if (index > 0 && obj_hit_tiles[index] == obj_hit_tiles[index - 1]) {
+                continue;
+            }
+
+            ObjectListNode* objectListNode = objectTable[obj_hit_tiles[index]];
+            while (objectListNode != NULL) {
+                Object* object = objectListNode->obj;
+                if (object->elevation > elevation) {
+                    break;
+                }
+
+                if (objectListNode->hitQuery == obj_hit_query) {
+                    int flags = obj_intersects_with(object, x, y);
+                    if (flags != 0) {
+                        ObjectWithFlags* entries = (ObjectWithFlags*)mem_realloc(*entriesPtr, sizeof(*entries) * (count + 1));
+                        if (entries != NULL) {
+                            *entriesPtr = entries;
+                            entries[count].object = object;
+                            entries[count].flags = flags;
+                            count++;
+                        }
+                    }
+                }
+
+                objectListNode = objectListNode->next;
+            }
+        }
+
+        return count;
+    }
+
+    // CE: Visit only spans of draw order inside area.
+    int spansLength = obj_order_spans(parity, 30, 20);
+    for (int span = 0; span < spansLength; span++) {
+        for (int index = orderSpans[span].start; index < orderSpans[span].end; index++) {
+            int offsetIndex = orderTable[parity][index];
             int tile = offsetTable[parity][offsetIndex] + upperLeftTile;
-            ObjectListNode* objectListNode = hexGridTileIsValid(tile)
+            ObjectListNode* objectListNode = obj_tile_occupied(tile, elevation)
                 ? objectTable[tile]
                 : NULL;
             while (objectListNode != NULL) {
@@ -2783,6 +3615,223 @@ int obj_create_intersect_list(int x, int y, int elevation, int objectType, Objec
     return count;
 }
 
+// CE: Allocates hit grid covering every hex of the map, with enough margin
+// for art of objects standing on border hexes.
+static void obj_hit_grid_init()
+{
+    int minX = INT_MAX;
+    int minY = INT_MAX;
+    int maxX = INT_MIN;
+    int maxY = INT_MIN;
+
+    for (int tile = 0; tile < HEX_GRID_SIZE; tile++) {
+        int tileX;
+        int tileY;
+        if (tile_coord_world(tile, &tileX, &tileY) == 0) {
+            minX = std::min(minX, tileX);
+            minY = std::min(minY, tileY);
+            maxX = std::max(maxX, tileX);
+            maxY = std::max(maxY, tileY);
+        }
+    }
+
+    if (minX > maxX) {
+        return;
+    }
+
+    obj_hit_grid_x = minX - OBJ_HIT_CELL_SIZE;
+    obj_hit_grid_y = minY - OBJ_HIT_CELL_SIZE * 2;
+    obj_hit_grid_columns = (maxX - minX) / OBJ_HIT_CELL_SIZE + 3;
+    obj_hit_grid_rows = (maxY - minY) / OBJ_HIT_CELL_SIZE + 4;
+
+    size_t size = sizeof(*obj_hit_grid) * ELEVATION_COUNT * obj_hit_grid_rows * obj_hit_grid_columns;
+    obj_hit_grid = (ObjectHitCell*)mem_malloc(size);
+    if (obj_hit_grid != NULL) {
+        memset(obj_hit_grid, 0, size);
+    }
+}
+
+// CE: Releases hit grid. Registered nodes are left as is, so this is only
+// called when all nodes have already been removed or on failure (see
+// `obj_hit_grid_update`), when nodes are never looked up again.
+static void obj_hit_grid_exit()
+{
+    if (obj_hit_grid == NULL) {
+        return;
+    }
+
+    int cellCount = ELEVATION_COUNT * obj_hit_grid_rows * obj_hit_grid_columns;
+    for (int index = 0; index < cellCount; index++) {
+        if (obj_hit_grid[index].nodes != NULL) {
+            mem_free(obj_hit_grid[index].nodes);
+        }
+    }
+
+    mem_free(obj_hit_grid);
+    obj_hit_grid = NULL;
+
+    if (obj_hit_tiles != NULL) {
+        mem_free(obj_hit_tiles);
+        obj_hit_tiles = NULL;
+    }
+    obj_hit_tiles_capacity = 0;
+}
+
+// CE: Calculates bounds of object art in world coordinates. Must match
+// bounds tested by `obj_intersects_with`.
+static bool obj_hit_bounds(Object* obj, int* left, int* top, int* right, int* bottom)
+{
+    int tileX;
+    int tileY;
+    if (tile_coord_world(obj->tile, &tileX, &tileY) != 0) {
+        return false;
+    }
+
+    CacheEntry* handle;
+    Art* art = art_ptr_lock(obj->fid, &handle);
+    if (art == NULL) {
+        return false;
+    }
+
+    int width = art_frame_width(art, obj->frame, obj->rotation);
+    int height = art_frame_length(art, obj->frame, obj->rotation);
+
+    tileX += 16 + art->xOffsets[obj->rotation] + obj->x;
+    tileY += 8 + art->yOffsets[obj->rotation] + obj->y;
+
+    art_ptr_unlock(handle);
+
+    *left = tileX - width / 2;
+    *right = *left + width - 1;
+    *top = tileY - height + 1;
+    *bottom = tileY;
+
+    return true;
+}
+
+// CE: Returns range of hit grid cells covered by given bounds. Bounds outside
+// of grid are attributed to border cells.
+static void obj_hit_grid_cells(int left, int top, int right, int bottom, int* minColumn, int* minRow, int* maxColumn, int* maxRow)
+{
+    int maxX = obj_hit_grid_columns * OBJ_HIT_CELL_SIZE - 1;
+    int maxY = obj_hit_grid_rows * OBJ_HIT_CELL_SIZE - 1;
+
+    *minColumn = std::clamp(left - obj_hit_grid_x, 0, maxX) / OBJ_HIT_CELL_SIZE;
+    *maxColumn = std::clamp(right - obj_hit_grid_x, 0, maxX) / OBJ_HIT_CELL_SIZE;
+    *minRow = std::clamp(top - obj_hit_grid_y, 0, maxY) / OBJ_HIT_CELL_SIZE;
+    *maxRow = std::clamp(bottom - obj_hit_grid_y, 0, maxY) / OBJ_HIT_CELL_SIZE;
+}
+
+// CE: Registers node in cells covered by its current bounds.
+static void obj_hit_grid_update(ObjectListNode* node)
+{
+    obj_hit_grid_remove(node);
+
+    if (obj_hit_grid == NULL) {
+        return;
+    }
+
+    Object* obj = node->obj;
+    if (obj == NULL || obj->tile == -1 || !elevationIsValid(obj->elevation)) {
+        return;
+    }
+
+    int left;
+    int top;
+    int right;
+    int bottom;
+    if (!obj_hit_bounds(obj, &left, &top, &right, &bottom)) {
+        return;
+    }
+
+    int minColumn;
+    int minRow;
+    int maxColumn;
+    int maxRow;
+    obj_hit_grid_cells(left, top, right, bottom, &minColumn, &minRow, &maxColumn, &maxRow);
+
+    for (int row = minRow; row <= maxRow; row++) {
+        for (int column = minColumn; column <= maxColumn; column++) {
+            ObjectHitCell* cell = &(obj_hit_grid[(obj->elevation * obj_hit_grid_rows + row) * obj_hit_grid_columns + column]);
+            if (cell->length == cell->capacity) {
+                int capacity = cell->capacity != 0 ? cell->capacity * 2 : 8;
+                ObjectListNode** nodes = (ObjectListNode**)mem_realloc(cell->nodes, sizeof(*nodes) * capacity);
+                if (nodes == NULL) {
+                    // Grid can no longer be trusted, fallback to scanning
+                    // update area.
+                    debug_printf("\nError: Can't grow object hit grid, disabling it.");
+                    obj_hit_grid_exit();
+                    return;
+                }
+
+                cell->nodes = nodes;
+                cell->capacity = capacity;
+            }
+
+            cell->nodes[cell->length++] = node;
+        }
+    }
+
+    node->hitLeft = left;
+    node->hitTop = top;
+    node->hitRight = right;
+    node->hitBottom = bottom;
+    node->hitElevation = obj->elevation;
+}
+
+// CE: Removes node from cells it was registered in.
+static void obj_hit_grid_remove(ObjectListNode* node)
+{
+    if (node->hitElevation == -1) {
+        return;
+    }
+
+    if (obj_hit_grid != NULL) {
+        int minColumn;
+        int minRow;
+        int maxColumn;
+        int maxRow;
+        obj_hit_grid_cells(node->hitLeft, node->hitTop, node->hitRight, node->hitBottom, &minColumn, &minRow, &maxColumn, &maxRow);
+
+        for (int row = minRow; row <= maxRow; row++) {
+            for (int column = minColumn; column <= maxColumn; column++) {
+                ObjectHitCell* cell = &(obj_hit_grid[(node->hitElevation * obj_hit_grid_rows + row) * obj_hit_grid_columns + column]);
+                for (int index = 0; index < cell->length; index++) {
+                    if (cell->nodes[index] == node) {
+                        cell->nodes[index] = cell->nodes[--cell->length];
+                        break;
+                    }
+                }
+            }
+        }
+    }
+
+    node->hitElevation = -1;
+}
+
+// CE: Refreshes hit grid bounds of an object on the map. Called whenever
+// anything affecting art bounds (fid, frame, rotation) changes outside of
+// `obj_insert`.
+void obj_update_hit_bounds(Object* obj)
+{
+    if (obj_hit_grid == NULL || obj == NULL || obj->tile == -1) {
+        return;
+    }
+
+    ObjectListNode* node;
+    ObjectListNode* previousNode;
+    if (obj_node_ptr(obj, &node, &previousNode) == 0) {
+        obj_hit_grid_update(node);
+    }
+}
+
+static int obj_hit_tile_compare(const void* a1, const void* a2)
+{
+    int v1 = *(int*)a1;
+    int v2 = *(int*)a2;
+    return v1 - v2;
+}
+
 // 0x47DE48
 void obj_delete_intersect_list(ObjectWithFlags** entriesPtr)
 {
@@ -2795,67 +3844,74 @@ void obj_delete_intersect_list(ObjectWithFlags** entriesPtr)
 // 0x47DE68
 void obj_set_seen(int tile)
 {
-    obj_seen[tile >> 3] |= 1 << (tile & 7);
-}
-
-// 0x47DE84
-void obj_process_seen()
-{
-    int i;
-    int v7;
-    int v8;
-    int v5;
-    int v0;
-    int v3;
-    ObjectListNode* obj_entry;
-
-    memset(obj_seen_check, 0, 5001);
-
-    v0 = 400;
-    for (i = 0; i < 5001; i++) {
-        if (obj_seen[i] != 0) {
-            for (v3 = i - 400; v3 != v0; v3 += 25) {
-                if (v3 >= 0 && v3 < 5001) {
-                    obj_seen_check[v3] = -1;
-                    if (v3 > 0) {
-                        obj_seen_check[v3 - 1] = -1;
-                    }
-                    if (v3 < 5000) {
-                        obj_seen_check[v3 + 1] = -1;
-                    }
-                    if (v3 > 1) {
-                        obj_seen_check[v3 - 2] = -1;
-                    }
-                    if (v3 < 4999) {
-                        obj_seen_check[v3 + 2] = -1;
-                    }
+    char* seen = &(obj_seen[tile >> 3]);
+    if (*seen == 0) {
+        int index = tile >> 3;
+        for (int check = index - 400; check != index + 400; check += 25) {
+            if (check >= 0 && check < 5001) {
+                obj_seen_mark(check);
+                if (check > 0) {
+                    obj_seen_mark(check - 1);
+                }
+                if (check < 5000) {
+                    obj_seen_mark(check + 1);
+                }
+                if (check > 1) {
+                    obj_seen_mark(check - 2);
+                }
+                if (check < 4999) {
+                    obj_seen_mark(check + 2);
                 }
             }
         }
-        v0++;
     }
 
-    v7 = 0;
-    for (i = 0; i < 5001; i++) {
-        if (obj_seen_check[i] != 0) {
-            v8 = 1;
-            for (v5 = v7; v5 < v7 + 8; v5++) {
-                if (v8 & obj_seen_check[i]) {
-                    if (v5 < 40000) {
-                        for (obj_entry = objectTable[v5]; obj_entry != NULL; obj_entry = obj_entry->next) {
-                            if (obj_entry->obj->elevation == obj_dude->elevation) {
-                                obj_entry->obj->flags |= OBJECT_SEEN;
-                            }
+    *seen |= 1 << (tile & 7);
+}
+
+// CE: Marks byte of `obj_seen_check` (8 hexes) to be processed.
+static void obj_seen_mark(int index)
+{
+    if (obj_seen_check[index] == 0) {
+        obj_seen_check[index] = -1;
+        obj_seen_check_list[obj_seen_check_count++] = index;
+    }
+}
+
+// CE: Forgets hexes seen since last `obj_process_seen`.
+static void obj_seen_clear()
+{
+    for (int index = 0; index < obj_seen_check_count; index++) {
+        obj_seen_check[obj_seen_check_list[index]] = 0;
+    }
+    obj_seen_check_count = 0;
+
+    memset(obj_seen, 0, 5001);
+}
+
+// 0x47DE84
+void obj_process_seen()
+{
+    // CE: Check windows are marked by `obj_set_seen` as dude moves, only
+    // marked bytes are visited.
+    for (int entry = 0; entry < obj_seen_check_count; entry++) {
+        int index = obj_seen_check_list[entry];
+        int tile = index * 8;
+        for (int bit = 0; bit < 8; bit++, tile++) {
+            if (obj_tile_occupied(tile, obj_dude->elevation)) {
+                for (ObjectListNode* obj_entry = objectTable[tile]; obj_entry != NULL; obj_entry = obj_entry->next) {
+                    if (obj_entry->obj->elevation == obj_dude->elevation) {
+                        if ((obj_entry->obj->flags & OBJECT_SEEN) == 0) {
+                            obj_entry->obj->flags |= OBJECT_SEEN;
+                            obj_static_changed(obj_entry->obj);
                         }
                     }
                 }
-                v8 *= 2;
             }
         }
-        v7 += 8;
     }
 
-    memset(obj_seen, 0, 5001);
+    obj_seen_clear();
 }
 
 // 0x47DFC8
@@ -2885,6 +3941,8 @@ char* object_description(Object* obj)
 // 0x47E01C
 void obj_preload_art_cache(int flags)
 {
+    MapStatScope mapStatScope(MAP_STAT_PHASE_PRELOAD_ART);
+
     if (preload_list == NULL) {
         return;
     }
@@ -2931,33 +3989,27 @@ void obj_preload_art_cache(int flags)
         v11++;
     }
 
-    CacheEntry* cache_handle;
-    if (art_ptr_lock(*preload_list, &cache_handle) != NULL) {
-        art_ptr_unlock(cache_handle);
-    }
+    // CE: Original code locks (and unlocks) every art synchronously. Now it's
+    // loaded in background in the same order, and committed into cache
+    // while the map is already running (see `art_preload`).
+    art_preload(preload_list, 1);
 
     for (int i = 1; i < v11; i++) {
         if (preload_list[i - 1] != preload_list[i]) {
-            if (art_ptr_lock(preload_list[i], &cache_handle) != NULL) {
-                art_ptr_unlock(cache_handle);
-            }
+            art_preload(&(preload_list[i]), 1);
         }
     }
 
     for (int i = 0; i < 4096; i++) {
         if (arr[i] != 0) {
             int fid = art_id(OBJ_TYPE_TILE, i, 0, 0, 0);
-            if (art_ptr_lock(fid, &cache_handle) != NULL) {
-                art_ptr_unlock(cache_handle);
-            }
+            art_preload(&fid, 1);
         }
     }
 
     for (int i = v11; i < preload_list_index; i++) {
         if (preload_list[i - 1] != preload_list[i]) {
-            if (art_ptr_lock(preload_list[i], &cache_handle) != NULL) {
-                art_ptr_unlock(cache_handle);
-            }
+            art_preload(&(preload_list[i]), 1);
         }
     }
 
@@ -2967,6 +4019,75 @@ void obj_preload_art_cache(int flags)
     preload_list_index = 0;
 }
 
+// CE: Schedules background loading of art which is about to be locked by
+// `obj_preload_art_cache` (with the same `flags`). Unlike the latter it does
+// not consume preload list.
+void obj_prefetch_art_cache(int flags)
+{
+    int index;
+
+    obj_prefetch_tile_art(flags);
+
+    if (preload_list != NULL) {
+        for (index = 0; index < preload_list_index; index++) {
+            obj_prefetch_art(preload_list[index]);
+        }
+    }
+}
+
+// CE: Schedules background loading of art with `fid`. Critter art lives in
+// its own database, which has to be selected while path is resolved (see
+// `art_data_size`).
+static void obj_prefetch_art(int fid)
+{
+    const char* name = art_get_name(fid);
+    if (name == NULL) {
+        return;
+    }
+
+    if (FID_TYPE(fid) == OBJ_TYPE_CRITTER) {
+        DB_DATABASE* oldDb = db_current();
+        db_select(critter_db_handle);
+        db_prefetch(&name, 1);
+        db_select(oldDb);
+    } else {
+        db_prefetch(&name, 1);
+    }
+}
+
+// CE: Schedules background loading of floor and roof art of loaded squares.
+// Only needs squares, so map loading calls it before objects are read.
+void obj_prefetch_tile_art(int flags)
+{
+    unsigned char arr[4096];
+    const char* name;
+    int elevation;
+    int index;
+
+    memset(arr, 0, sizeof(arr));
+
+    for (elevation = 0; elevation < ELEVATION_COUNT; elevation++) {
+        if ((flags & (0x02 << elevation)) != 0) {
+            continue;
+        }
+
+        for (index = 0; index < SQUARE_GRID_SIZE; index++) {
+            int v3 = square[elevation]->field_0[index];
+            arr[v3 & 0xFFF] = 1;
+            arr[(v3 >> 16) & 0xFFF] = 1;
+        }
+    }
+
+    for (index = 0; index < 4096; index++) {
+        if (arr[index] != 0) {
+            name = art_get_name(art_id(OBJ_TYPE_TILE, index, 0, 0, 0));
+            if (name != NULL) {
+                db_prefetch(&name, 1);
+            }
+        }
+    }
+}
+
 // 0x47E250
 static int obj_object_table_init()
 {
@@ -2976,6 +4097,15 @@ static int obj_object_table_init()
         objectTable[tile] = NULL;
     }
 
+    memset(obj_blocking_bits, 0, sizeof(obj_blocking_bits));
+    memset(obj_occupied_bits, 0, sizeof(obj_occupied_bits));
+
+    for (int index = 0; index < ELEVATION_COUNT * OBJ_TYPE_COUNT; index++) {
+        obj_type_lists[index] = NULL;
+    }
+
+    memset(obj_light_classes, 0, sizeof(obj_light_classes));
+
     return 0;
 }
 
@@ -3115,6 +4245,16 @@ static int obj_order_table_init()
     qsort(orderTable[0], updateHexArea, sizeof(int), obj_order_comp_func_even);
     qsort(orderTable[1], updateHexArea, sizeof(int), obj_order_comp_func_odd);
 
+    // CE: Split draw order into monotone runs.
+    if (obj_order_runs_init(0) == -1 || obj_order_runs_init(1) == -1) {
+        goto err;
+    }
+
+    orderSpans = (ObjectOrderSpan*)mem_malloc(sizeof(*orderSpans) * std::max(orderRunsLength[0], orderRunsLength[1]));
+    if (orderSpans == NULL) {
+        goto err;
+    }
+
     return 0;
 
 err:
@@ -3144,6 +4284,19 @@ static int obj_order_comp_func_odd(const void* a1, const void* a2)
 // 0x47E634
 static void obj_order_table_exit()
 {
+    if (orderSpans != NULL) {
+        mem_free(orderSpans);
+        orderSpans = NULL;
+    }
+
+    for (int parity = 0; parity < 2; parity++) {
+        if (orderRuns[parity] != NULL) {
+            mem_free(orderRuns[parity]);
+            orderRuns[parity] = NULL;
+        }
+        orderRunsLength[parity] = 0;
+    }
+
     if (orderTable[1] != NULL) {
         mem_free(orderTable[1]);
         orderTable[1] = NULL;
@@ -3155,6 +4308,126 @@ static void obj_order_table_exit()
     }
 }
 
+// CE: Splits draw order of given parity into runs along which row and column
+// of update area are monotone.
+static int obj_order_runs_init(int parity)
+{
+    int* orders = orderTable[parity];
+
+    ObjectOrderRun* runs = (ObjectOrderRun*)mem_malloc(sizeof(*runs) * updateHexArea);
+    if (runs == NULL) {
+        return -1;
+    }
+
+    int length = 0;
+    for (int index = 0; index < updateHexArea; index++) {
+        int row = offsetDivTable[orders[index]];
+        int column = offsetModTable[orders[index]];
+
+        if (length != 0) {
+            ObjectOrderRun* run = &(runs[length - 1]);
+            int prevRow = offsetDivTable[orders[index - 1]];
+            int prevColumn = offsetModTable[orders[index - 1]];
+            int rowStep = (row > prevRow) - (row < prevRow);
+            int columnStep = (column > prevColumn) - (column < prevColumn);
+
+            if ((run->rowStep == 0 || rowStep == 0 || run->rowStep == rowStep)
+                && (run->columnStep == 0 || columnStep == 0 || run->columnStep == columnStep)) {
+                if (run->rowStep == 0) {
+                    run->rowStep = rowStep;
+                }
+
+                if (run->columnStep == 0) {
+                    run->columnStep = columnStep;
+                }
+
+                run->end = index + 1;
+                continue;
+            }
+        }
+
+        ObjectOrderRun* run = &(runs[length++]);
+        run->start = index;
+        run->end = index + 1;
+        run->rowStep = 0;
+        run->columnStep = 0;
+    }
+
+    orderRuns[parity] = runs;
+    orderRunsLength[parity] = length;
+
+    ObjectOrderRun* compacted = (ObjectOrderRun*)mem_realloc(runs, sizeof(*runs) * std::max(length, 1));
+    if (compacted != NULL) {
+        orderRuns[parity] = compacted;
+    }
+
+    return 0;
+}
+
+// CE: Collects spans of draw order (into `orderSpans`) covering hexes of
+// update area whose row is below `height` and column is below `width`, that
+// is area of given size anchored at upper left corner. Returns number of
+// spans.
+static int obj_order_spans(int parity, int height, int width)
+{
+    int* orders = orderTable[parity];
+    int length = 0;
+
+    for (int index = 0; index < orderRunsLength[parity]; index++) {
+        ObjectOrderRun* run = &(orderRuns[parity][index]);
+
+        // Rows grow - hexes inside are at the beginning of run, otherwise
+        // at the end. The same for columns.
+        int rowBound = obj_order_run_bound(run, orders, offsetDivTable, height, run->rowStep >= 0);
+        int columnBound = obj_order_run_bound(run, orders, offsetModTable, width, run->columnStep >= 0);
+
+        int start = run->start;
+        int end = run->end;
+
+        if (run->rowStep >= 0) {
+            end = std::min(end, rowBound);
+        } else {
+            start = std::max(start, rowBound);
+        }
+
+        if (run->columnStep >= 0) {
+            end = std::min(end, columnBound);
+        } else {
+            start = std::max(start, columnBound);
+        }
+
+        if (start < end) {
+            orderSpans[length].start = start;
+            orderSpans[length].end = end;
+            length++;
+        }
+    }
+
+    return length;
+}
+
+// CE: Binary searches run for the boundary between hexes whose value in
+// `table` is below `limit` and the rest. When `prefix` is set such hexes are
+// at the beginning of run and the result is the end of them, otherwise they
+// are at the end of run and the result is the start of them.
+static int obj_order_run_bound(ObjectOrderRun* run, int* orders, int* table, int limit, bool prefix)
+{
+    int low = run->start;
+    int high = run->end;
+
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+        bool inside = table[orders[mid]] < limit;
+        if (inside == prefix) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    return low;
+}
+
 // 0x47E670
 static int obj_render_table_init()
 {
@@ -3202,6 +4475,44 @@ static void obj_light_table_init()
             }
         }
     }
+
+    // CE: Precompute shadow conditions of `obj_adjust_light`.
+    for (int rotation = 0; rotation < ROTATION_COUNT; rotation++) {
+        for (int index = 0; index < 36; index++) {
+            unsigned char mask = 0;
+
+            if (rotation != ROTATION_W
+                && rotation != ROTATION_NW
+                && (rotation != ROTATION_NE || index >= 8)
+                && (rotation != ROTATION_SW || index <= 15)) {
+                mask |= OBJ_LIGHT_CLASS_WALL_EAST_WEST;
+            }
+
+            if (rotation != ROTATION_NE && rotation != ROTATION_NW) {
+                mask |= OBJ_LIGHT_CLASS_WALL_NORTH_CORNER;
+            }
+
+            if (rotation != ROTATION_NE
+                && rotation != ROTATION_E
+                && rotation != ROTATION_W
+                && rotation != ROTATION_NW
+                && (rotation != ROTATION_SW || index <= 15)) {
+                mask |= OBJ_LIGHT_CLASS_WALL_SOUTH_CORNER;
+            }
+
+            if (rotation != ROTATION_NE
+                && rotation != ROTATION_E
+                && (rotation != ROTATION_NW || index <= 7)) {
+                mask |= OBJ_LIGHT_CLASS_WALL_NORTH_SOUTH;
+            }
+
+            if (rotation >= ROTATION_E && rotation <= ROTATION_SW) {
+                mask |= OBJ_LIGHT_CLASS_OCCLUDER;
+            }
+
+            obj_light_shadow_masks[rotation][index] = mask;
+        }
+    }
 }
 
 // 0x47E8C8
@@ -3437,6 +4748,8 @@ int obj_load_dude(DB_FILE* stream)
     tempInventory->capacity = 0;
     tempInventory->items = NULL;
 
+    item_totals_invalidate();
+
     temp->flags &= ~OBJECT_NO_REMOVE;
 
     if (obj_erase_object(temp, NULL) == -1) {
@@ -3463,7 +4776,7 @@ static int obj_create_object(Object** objectPtr)
         return -1;
     }
 
-    Object* object = *objectPtr = (Object*)mem_malloc(sizeof(Object));
+    Object* object = *objectPtr = (Object*)mapmem_pool_alloc(&obj_object_pool);
     if (object == NULL) {
         return -1;
     }
@@ -3479,6 +4792,9 @@ static int obj_create_object(Object** objectPtr)
     object->owner = NULL;
     object->field_80 = -1;
 
+    // CE: Memoized inventory sums are keyed by object address.
+    item_totals_invalidate();
+
     return 0;
 }
 
@@ -3493,9 +4809,11 @@ static void obj_destroy_object(Object** objectPtr)
         return;
     }
 
-    mem_free(*objectPtr);
+    mapmem_pool_free(&obj_object_pool, *objectPtr);
 
     *objectPtr = NULL;
+
+    item_totals_invalidate();
 }
 
 // 0x47EEFC
@@ -3505,13 +4823,18 @@ static int obj_create_object_node(ObjectListNode** nodePtr)
         return -1;
     }
 
-    ObjectListNode* node = *nodePtr = (ObjectListNode*)mem_malloc(sizeof(*node));
+    ObjectListNode* node = *nodePtr = (ObjectListNode*)mapmem_pool_alloc(&obj_node_pool);
     if (node == NULL) {
         return -1;
     }
 
     node->obj = NULL;
     node->next = NULL;
+    node->hitElevation = -1;
+    node->hitQuery = 0;
+    node->typePrev = NULL;
+    node->typeNext = NULL;
+    node->typeList = -1;
 
     return 0;
 }
@@ -3527,7 +4850,12 @@ static void obj_destroy_object_node(ObjectListNode** nodePtr)
         return;
     }
 
-    mem_free(*nodePtr);
+    obj_hit_grid_remove(*nodePtr);
+    obj_type_list_remove(*nodePtr);
+
+    statever_bump(STATE_VERSION_OBJECTS);
+
+    mapmem_pool_free(&obj_node_pool, *nodePtr);
 
     *nodePtr = NULL;
 }
@@ -3637,6 +4965,14 @@ static void obj_insert(ObjectListNode* objectListNode)
 
     objectListNode->next = *objectListNodePtr;
     *objectListNodePtr = objectListNode;
+
+    // CE: Update blocking bits of occupied hex.
+    obj_update_blocking(objectListNode->obj);
+
+    obj_hit_grid_update(objectListNode);
+    obj_type_list_add(objectListNode);
+
+    statever_bump(STATE_VERSION_OBJECTS);
 }
 
 // 0x47F13C
@@ -3668,6 +5004,9 @@ static int obj_remove(ObjectListNode* a1, ObjectListNode* a2)
                 objectTable[tile] = objectTable[tile]->next;
             }
         }
+
+        // CE: Update blocking bits of vacated hex.
+        obj_update_blocking(a1->obj);
     }
 
     // NOTE: Uninline.
@@ -3730,6 +5069,12 @@ static int obj_adjust_light(Object* obj, int a2, Rect* rect)
         return -1;
     }
 
+    // CE: Rebuilt by `obj_light_batch_end`.
+    if (obj_light_batch_depth > 0) {
+        obj_light_batch_dirty = true;
+        return -1;
+    }
+
     if (!hexGridTileIsValid(obj->tile)) {
         return -1;
     }
@@ -4285,68 +5630,36 @@ static int obj_adjust_light(Object* obj, int a2, Rect* rect)
                     // TODO: Check.
                     int tile = obj->tile + v70[rotation][index];
                     if (hexGridTileIsValid(tile)) {
-                        bool v12 = true;
+                        // CE: Objects lit by this light have to be redrawn.
+                        if (rect != NULL) {
+                            ObjectListNode* objectListNode = objectTable[tile];
+                            while (objectListNode != NULL) {
+                                if ((objectListNode->obj->flags & OBJECT_HIDDEN) == 0) {
+                                    if (objectListNode->obj->elevation > obj->elevation) {
+                                        break;
+                                    }
 
-                        ObjectListNode* objectListNode = objectTable[tile];
-                        while (objectListNode != NULL) {
-                            if ((objectListNode->obj->flags & OBJECT_HIDDEN) == 0) {
-                                if (objectListNode->obj->elevation > obj->elevation) {
-                                    break;
-                                }
+                                    if (objectListNode->obj->elevation == obj->elevation) {
+                                        Rect v29;
+                                        obj_bound(objectListNode->obj, &v29);
+                                        rect_min_bound(&objectRect, &v29, &objectRect);
 
-                                if (objectListNode->obj->elevation == obj->elevation) {
-                                    Rect v29;
-                                    obj_bound(objectListNode->obj, &v29);
-                                    rect_min_bound(&objectRect, &v29, &objectRect);
-
-                                    v14 = (objectListNode->obj->flags & OBJECT_LIGHT_THRU) == 0;
-
-                                    if (FID_TYPE(objectListNode->obj->fid) == OBJ_TYPE_WALL) {
-                                        if ((objectListNode->obj->flags & OBJECT_FLAT) == 0) {
-                                            Proto* proto;
-                                            proto_ptr(objectListNode->obj->pid, &proto);
-                                            if ((proto->wall.extendedFlags & 0x8000000) != 0 || (proto->wall.extendedFlags & 0x40000000) != 0) {
-                                                if (rotation != ROTATION_W
-                                                    && rotation != ROTATION_NW
-                                                    && (rotation != ROTATION_NE || index >= 8)
-                                                    && (rotation != ROTATION_SW || index <= 15)) {
-                                                    v12 = false;
-                                                }
-                                            } else if ((proto->wall.extendedFlags & 0x10000000) != 0) {
-                                                if (rotation != ROTATION_NE && rotation != ROTATION_NW) {
-                                                    v12 = false;
-                                                }
-                                            } else if ((proto->wall.extendedFlags & 0x20000000) != 0) {
-                                                if (rotation != ROTATION_NE
-                                                    && rotation != ROTATION_E
-                                                    && rotation != ROTATION_W
-                                                    && rotation != ROTATION_NW
-                                                    && (rotation != ROTATION_SW || index <= 15)) {
-                                                    v12 = false;
-                                                }
-                                            } else {
-                                                if (rotation != ROTATION_NE
-                                                    && rotation != ROTATION_E
-                                                    && (rotation != ROTATION_NW || index <= 7)) {
-                                                    v12 = false;
-                                                }
-                                            }
-                                        }
-                                    } else {
-                                        if (v14 && rotation >= ROTATION_E && rotation <= ROTATION_SW) {
-                                            v12 = false;
+                                        if ((objectListNode->obj->flags & OBJECT_LIGHT_THRU) == 0) {
+                                            break;
                                         }
                                     }
-
-                                    if (v14) {
-                                        break;
-                                    }
                                 }
+                                objectListNode = objectListNode->next;
                             }
-                            objectListNode = objectListNode->next;
                         }
 
-                        if (v12) {
+                        // CE: Whether hex blocks light and whether it stays
+                        // unlit only depends on objects on it, which are
+                        // summarized in cached light class.
+                        unsigned char lightClass = obj_light_class(tile, obj->elevation);
+                        v14 = (lightClass & OBJ_LIGHT_CLASS_BLOCKS) != 0;
+
+                        if ((lightClass & obj_light_shadow_masks[rotation][index]) == 0) {
                             adjustLightIntensity(obj->elevation, tile, v28[index]);
                         }
                     }
@@ -4377,6 +5690,63 @@ static int obj_adjust_light(Object* obj, int a2, Rect* rect)
     return 0;
 }
 
+// CE: Returns light class of a hex (see `OBJ_LIGHT_CLASS_*`). Mirrors object
+// walk of original `obj_adjust_light`: objects are examined until first
+// visible one not letting light through.
+static unsigned char obj_light_class(int tile, int elevation)
+{
+    unsigned char lightClass = obj_light_classes[elevation][tile];
+    if (lightClass != 0) {
+        return lightClass;
+    }
+
+    lightClass = OBJ_LIGHT_CLASS_VALID;
+
+    ObjectListNode* objectListNode = objectTable[tile];
+    while (objectListNode != NULL) {
+        Object* object = objectListNode->obj;
+        if ((object->flags & OBJECT_HIDDEN) == 0) {
+            if (object->elevation > elevation) {
+                break;
+            }
+
+            if (object->elevation == elevation) {
+                bool blocks = (object->flags & OBJECT_LIGHT_THRU) == 0;
+
+                if (FID_TYPE(object->fid) == OBJ_TYPE_WALL) {
+                    if ((object->flags & OBJECT_FLAT) == 0) {
+                        Proto* proto;
+                        proto_ptr(object->pid, &proto);
+                        if ((proto->wall.extendedFlags & 0x8000000) != 0 || (proto->wall.extendedFlags & 0x40000000) != 0) {
+                            lightClass |= OBJ_LIGHT_CLASS_WALL_EAST_WEST;
+                        } else if ((proto->wall.extendedFlags & 0x10000000) != 0) {
+                            lightClass |= OBJ_LIGHT_CLASS_WALL_NORTH_CORNER;
+                        } else if ((proto->wall.extendedFlags & 0x20000000) != 0) {
+                            lightClass |= OBJ_LIGHT_CLASS_WALL_SOUTH_CORNER;
+                        } else {
+                            lightClass |= OBJ_LIGHT_CLASS_WALL_NORTH_SOUTH;
+                        }
+                    }
+                } else {
+                    if (blocks) {
+                        lightClass |= OBJ_LIGHT_CLASS_OCCLUDER;
+                    }
+                }
+
+                if (blocks) {
+                    lightClass |= OBJ_LIGHT_CLASS_BLOCKS;
+                    break;
+                }
+            }
+        }
+        objectListNode = objectListNode->next;
+    }
+
+    obj_light_classes[elevation][tile] = lightClass;
+
+    return lightClass;
+}
+
 // 0x4801A0
 static void obj_render_outline(Object* object, Rect* rect)
 {
@@ -4442,11 +5812,6 @@ static void obj_render_outline(Object* object, Rect* rect)
         v49.lrx = v49.ulx + (objectRect.lrx - objectRect.ulx);
         v49.lry = v49.uly + (objectRect.lry - objectRect.uly);
 
-        unsigned char* src = art_frame_data(art, object->frame, object->rotation);
-
-        unsigned char* dest = back_buf + buf_full * object->sy + object->sx;
-        int destStep = buf_full - frameWidth;
-
         unsigned char color;
         unsigned char* v47 = NULL;
         unsigned char* v48 = NULL;
@@ -4499,126 +5864,179 @@ static void obj_render_outline(Object* object, Rect* rect)
             break;
         }
 
-        unsigned char v54 = color;
-        unsigned char* dest14 = dest;
-        unsigned char* src15 = src;
-        for (int y = 0; y < frameHeight; y++) {
-            bool cycle = true;
-            if (v44 != 0) {
-                if (y % v44 == 0) {
-                    v54++;
-                }
-
-                if (v54 > v43 + color - 1) {
-                    v54 = color;
+        // CE: Original code scans every pixel of the frame twice (by rows
+        // and by columns) looking for edges. They are now found once per
+        // frame and cached, see `obj_outline_shape`. Order of writes (which
+        // matters for translucent outlines) and bound checks are the same.
+        ObjOutlineShape* shape = frameWidth > 0 && frameHeight > 0
+            ? obj_outline_shape(art, object->fid, object->frame, object->rotation)
+            : NULL;
+        if (shape != NULL) {
+            for (int index = 0; index < shape->count; index++) {
+                ObjOutlineEdge* edge = &(shape->edges[index]);
+                int x = edge->x;
+                int y = edge->y;
+                if (x < v49.ulx || x > v49.lrx || y < v49.uly || y > v49.lry) {
+                    continue;
                 }
-            }
 
-            int v22 = dest14 - back_buf;
-            for (int x = 0; x < frameWidth; x++) {
-                v22 = dest14 - back_buf;
-                if (*src15 != 0 && cycle) {
-                    if (x >= v49.ulx && x <= v49.lrx && y >= v49.uly && y <= v49.lry && v22 > 0 && v22 % buf_full != 0) {
-                        unsigned char v20;
-                        if (v53 != 0) {
-                            v20 = v48[(v47[v54] << 8) + *(dest14 - 1)];
-                        } else {
-                            v20 = v54;
-                        }
-                        *(dest14 - 1) = v20;
+                int offset = buf_full * (object->sy + y) + object->sx + x;
+                switch (edge->kind) {
+                case OBJ_OUTLINE_EDGE_LEFT:
+                    if (offset <= 0 || offset % buf_full == 0) {
+                        continue;
                     }
-                    cycle = false;
-                } else if (*src15 == 0 && !cycle) {
-                    if (x >= v49.ulx && x <= v49.lrx && y >= v49.uly && y <= v49.lry) {
-                        int v21;
-                        if (v53 != 0) {
-                            v21 = v48[(v47[v54] << 8) + *dest14];
-                        } else {
-                            v21 = v54;
-                        }
-                        *dest14 = v21 & 0xFF;
+                    offset -= 1;
+                    break;
+                case OBJ_OUTLINE_EDGE_RIGHT:
+                    if (offset >= buf_size) {
+                        continue;
+                    }
+                    offset += 1;
+                    break;
+                case OBJ_OUTLINE_EDGE_TOP:
+                    offset -= buf_full;
+                    if (offset < 0) {
+                        continue;
                     }
-                    cycle = true;
+                    break;
+                case OBJ_OUTLINE_EDGE_BOTTOM:
+                    offset += buf_full;
+                    if (offset >= buf_size) {
+                        continue;
+                    }
+                    break;
                 }
-                dest14++;
-                src15++;
-            }
 
-            if (*(src15 - 1) != 0) {
-                if (v22 < buf_size) {
-                    int v23 = frameWidth - 1;
-                    if (v23 >= v49.ulx && v23 <= v49.lrx && y >= v49.uly && y <= v49.lry) {
-                        if (v53 != 0) {
-                            *dest14 = v48[(v47[v54] << 8) + *dest14];
-                        } else {
-                            *dest14 = v54;
-                        }
-                    }
+                unsigned char v54 = color;
+                if (v44 != 0) {
+                    v54 += (y / v44 + 1) % v43;
                 }
-            }
 
-            dest14 += destStep;
+                unsigned char* ptr = back_buf + offset;
+                if (v53 != 0) {
+                    *ptr = v48[(v47[v54] << 8) + *ptr];
+                } else {
+                    *ptr = v54;
+                }
+            }
         }
+    }
 
-        for (int x = 0; x < frameWidth; x++) {
-            bool cycle = true;
-            unsigned char v28 = color;
-            unsigned char* dest27 = dest + x;
-            unsigned char* src27 = src + x;
-            for (int y = 0; y < frameHeight; y++) {
-                if (v44 != 0) {
-                    if (y % v44 == 0) {
-                        v28++;
-                    }
+    art_ptr_unlock(cacheEntry);
+}
 
-                    if (v28 > color + v43 - 1) {
-                        v28 = color;
-                    }
-                }
+// CE: Returns outline edges of given art frame, building them on first use.
+// Returns `NULL` if frame has no pixel data or edges cannot be allocated.
+static ObjOutlineShape* obj_outline_shape(Art* art, int fid, int frame, int rotation)
+{
+    unsigned int hash = (unsigned int)fid * 31u + (unsigned int)frame * 7u + (unsigned int)rotation;
+    ObjOutlineShape* shape = &(obj_outline_shapes[hash & (OBJ_OUTLINE_SHAPE_CACHE_SIZE - 1)]);
+    if (shape->edges != NULL
+        && shape->fid == fid
+        && shape->frame == frame
+        && shape->rotation == rotation) {
+        return shape;
+    }
+
+    unsigned char* src = art_frame_data(art, frame, rotation);
+    int width = art_frame_width(art, frame, rotation);
+    int height = art_frame_length(art, frame, rotation);
+    if (src == NULL || width <= 0 || height <= 0) {
+        return NULL;
+    }
 
-                if (*src27 != 0 && cycle) {
-                    if (x >= v49.ulx && x <= v49.lrx && y >= v49.uly && y <= v49.lry) {
-                        unsigned char* v29 = dest27 - buf_full;
-                        if (v29 >= back_buf) {
-                            if (v53) {
-                                *v29 = v48[(v47[v28] << 8) + *v29];
-                            } else {
-                                *v29 = v28;
-                            }
-                        }
-                    }
-                    cycle = false;
-                } else if (*src27 == 0 && !cycle) {
-                    if (x >= v49.ulx && x <= v49.lrx && y >= v49.uly && y <= v49.lry) {
-                        if (v53) {
-                            *dest27 = v48[(v47[v28] << 8) + *dest27];
-                        } else {
-                            *dest27 = v28;
-                        }
-                    }
-                    cycle = true;
-                }
+    if (shape->edges != NULL) {
+        mem_free(shape->edges);
+        shape->edges = NULL;
+    }
+
+    int count = obj_outline_shape_build(src, width, height, NULL);
+
+    // Allocate at least one edge so empty silhouettes are cached too.
+    ObjOutlineEdge* edges = (ObjOutlineEdge*)mem_malloc(sizeof(*edges) * (count > 0 ? count : 1));
+    if (edges == NULL) {
+        debug_printf("\nError: obj_outline_shape: out of memory");
+        return NULL;
+    }
+
+    obj_outline_shape_build(src, width, height, edges);
+
+    shape->fid = fid;
+    shape->frame = frame;
+    shape->rotation = rotation;
+    shape->count = count;
+    shape->edges = edges;
+
+    return shape;
+}
+
+// CE: Finds outline edges of `width` x `height` frame, stores them in `edges`
+// (if given) and returns their number.
+static int obj_outline_shape_build(unsigned char* src, int width, int height, ObjOutlineEdge* edges)
+{
+    int count = 0;
 
-                dest27 += buf_full;
-                src27 += frameWidth;
+#define OBJ_OUTLINE_EMIT(edgeX, edgeY, edgeKind) \
+    do { \
+        if (edges != NULL) { \
+            edges[count].x = (short)(edgeX); \
+            edges[count].y = (short)(edgeY); \
+            edges[count].kind = (edgeKind); \
+        } \
+        count++; \
+    } while (0)
+
+    for (int y = 0; y < height; y++) {
+        unsigned char* row = src + width * y;
+        bool cycle = true;
+        for (int x = 0; x < width; x++) {
+            if (row[x] != 0 && cycle) {
+                OBJ_OUTLINE_EMIT(x, y, OBJ_OUTLINE_EDGE_LEFT);
+                cycle = false;
+            } else if (row[x] == 0 && !cycle) {
+                OBJ_OUTLINE_EMIT(x, y, OBJ_OUTLINE_EDGE_AFTER_ROW);
+                cycle = true;
             }
+        }
 
-            if (src27[-frameWidth] != 0) {
-                if (dest27 - back_buf < buf_size) {
-                    int y = frameHeight - 1;
-                    if (x >= v49.ulx && x <= v49.lrx && y >= v49.uly && y <= v49.lry) {
-                        if (v53) {
-                            *dest27 = v48[(v47[v28] << 8) + *dest27];
-                        } else {
-                            *dest27 = v28;
-                        }
-                    }
-                }
+        if (row[width - 1] != 0) {
+            OBJ_OUTLINE_EMIT(width - 1, y, OBJ_OUTLINE_EDGE_RIGHT);
+        }
+    }
+
+    for (int x = 0; x < width; x++) {
+        bool cycle = true;
+        for (int y = 0; y < height; y++) {
+            unsigned char b = src[width * y + x];
+            if (b != 0 && cycle) {
+                OBJ_OUTLINE_EMIT(x, y, OBJ_OUTLINE_EDGE_TOP);
+                cycle = false;
+            } else if (b == 0 && !cycle) {
+                OBJ_OUTLINE_EMIT(x, y, OBJ_OUTLINE_EDGE_AFTER_COLUMN);
+                cycle = true;
             }
         }
+
+        if (src[width * (height - 1) + x] != 0) {
+            OBJ_OUTLINE_EMIT(x, height - 1, OBJ_OUTLINE_EDGE_BOTTOM);
+        }
     }
 
-    art_ptr_unlock(cacheEntry);
+#undef OBJ_OUTLINE_EMIT
+
+    return count;
+}
+
+static void obj_outline_shape_exit()
+{
+    for (int index = 0; index < OBJ_OUTLINE_SHAPE_CACHE_SIZE; index++) {
+        ObjOutlineShape* shape = &(obj_outline_shapes[index]);
+        if (shape->edges != NULL) {
+            mem_free(shape->edges);
+            shape->edges = NULL;
+        }
+    }
 }
 
 // 0x480868
@@ -4679,6 +6097,22 @@ static void obj_render_object(Object* object, Rect* rect, int light)
     int objectWidth = objectRect.lrx - objectRect.ulx + 1;
     int objectHeight = objectRect.lry - objectRect.uly + 1;
 
+    // CE: Span encoded frame (when available) skips transparent pixels
+    // without testing them.
+    unsigned char* spans = art_frame_spans(art, object->frame, object->rotation);
+
+    if (type == 6 && spans != NULL) {
+        span_trans_buf_to_buf(spans,
+            v50,
+            v49,
+            objectWidth,
+            objectHeight,
+            back_buf + buf_full * objectRect.uly + objectRect.ulx,
+            buf_full);
+        art_ptr_unlock(cacheEntry);
+        return;
+    }
+
     if (type == 6) {
         trans_buf_to_buf(src,
             objectWidth,
@@ -4781,7 +6215,9 @@ static void obj_render_object(Object* object, Rect* rect, int light)
 
                     for (int i = 0; i < 4; i++) {
                         Rect* v21 = &(rects[i]);
-                        if (v21->ulx <= v21->lrx && v21->uly <= v21->lry) {
+                        if (v21->ulx <= v21->lrx && v21->uly <= v21->lry && spans != NULL) {
+                            dark_trans_span_to_buf(spans, v50 + (v21->ulx - objectRect.ulx), v49 + (v21->uly - objectRect.uly), v21->lrx - v21->ulx + 1, v21->lry - v21->uly + 1, back_buf, v21->ulx, v21->uly, buf_full, light);
+                        } else if (v21->ulx <= v21->lrx && v21->uly <= v21->lry) {
                             unsigned char* sp = src + frameWidth * (v21->uly - objectRect.uly) + (v21->ulx - objectRect.ulx);
                             dark_trans_buf_to_buf(sp, v21->lrx - v21->ulx + 1, v21->lry - v21->uly + 1, frameWidth, back_buf, v21->ulx, v21->uly, buf_full, light);
                         }
@@ -4825,7 +6261,11 @@ static void obj_render_object(Object* object, Rect* rect, int light)
         dark_translucent_trans_buf_to_buf(src, objectWidth, objectHeight, frameWidth, back_buf, objectRect.ulx, objectRect.uly, buf_full, light, energyBlendTable, commonGrayTable);
         break;
     default:
-        dark_trans_buf_to_buf(src, objectWidth, objectHeight, frameWidth, back_buf, objectRect.ulx, objectRect.uly, buf_full, light);
+        if (spans != NULL) {
+            dark_trans_span_to_buf(spans, v50, v49, objectWidth, objectHeight, back_buf, objectRect.ulx, objectRect.uly, buf_full, light);
+        } else {
+            dark_trans_buf_to_buf(src, objectWidth, objectHeight, frameWidth, back_buf, objectRect.ulx, objectRect.uly, buf_full, light);
+        }
         break;
     }
 
@@ -4843,7 +6283,7 @@ void obj_fix_violence_settings(int* fid)
 
     bool shouldResetViolenceLevel = false;
     if (fix_violence_level == -1) {
-        if (!config_get_value(&game_config, GAME_CONFIG_PREFERENCES_KEY, GAME_CONFIG_VIOLENCE_LEVEL_KEY, &fix_violence_level)) {
+        if (!config_handle_get_value(&game_config_violence_level, &fix_violence_level)) {
             fix_violence_level = VIOLENCE_LEVEL_MAXIMUM_BLOOD;
         }
         shouldResetViolenceLevel = true;
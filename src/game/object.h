@@ -49,6 +49,8 @@ int obj_set_rotation(Object* obj, int direction, Rect* rect);
 int obj_inc_rotation(Object* obj, Rect* rect);
 int obj_dec_rotation(Object* obj, Rect* rect);
 void obj_rebuild_all_light();
+void obj_light_batch_begin();
+void obj_light_batch_end();
 int obj_set_light(Object* obj, int lightDistance, int lightIntensity, Rect* rect);
 int obj_get_visible_light(Object* obj);
 int obj_turn_on_light(Object* obj, Rect* rect);
@@ -67,9 +69,17 @@ Object* obj_find_first();
 Object* obj_find_next();
 Object* obj_find_first_at(int elevation);
 Object* obj_find_next_at();
+Object* obj_find_first_of_type(int objectType, int elevation);
+Object* obj_find_next_of_type();
 void obj_bound(Object* obj, Rect* rect);
 bool obj_occupied(int tile_num, int elev);
 Object* obj_blocking_at(Object* a1, int tile_num, int elev);
+void obj_update_blocking(Object* obj);
+unsigned int obj_blocking_epoch();
+unsigned int obj_static_epoch();
+int obj_ring_blockers(Object* excluded, int tile, int elevation, int radius, Object** objects, int capacity);
+bool obj_hex_blocked(int tile, int elevation);
+void obj_update_hit_bounds(Object* obj);
 int obj_scroll_blocking_at(int tile_num, int elev);
 Object* obj_sight_blocking_at(Object* a1, int tile_num, int elev);
 int obj_dist(Object* object1, Object* object2);
@@ -77,6 +87,7 @@ int obj_create_list(int tile, int elevation, int objectType, Object*** objectsPt
 void obj_delete_list(Object** objects);
 void translucent_trans_buf_to_buf(unsigned char* src, int srcWidth, int srcHeight, int srcPitch, unsigned char* dest, int destX, int destY, int destPitch, unsigned char* a9, unsigned char* a10);
 void dark_trans_buf_to_buf(unsigned char* src, int srcWidth, int srcHeight, int srcPitch, unsigned char* dest, int destX, int destY, int destPitch, int light);
+void dark_trans_span_to_buf(unsigned char* spans, int srcX, int srcY, int srcWidth, int srcHeight, unsigned char* dest, int destX, int destY, int destPitch, int light);
 void dark_translucent_trans_buf_to_buf(unsigned char* src, int srcWidth, int srcHeight, int srcPitch, unsigned char* dest, int destX, int destY, int destPitch, int light, unsigned char* a10, unsigned char* a11);
 void intensity_mask_buf_to_buf(unsigned char* src, int srcWidth, int srcHeight, int srcPitch, unsigned char* dest, int destPitch, unsigned char* mask, int maskPitch, int light);
 int obj_outline_object(Object* obj, int a2, Rect* rect);
@@ -89,6 +100,8 @@ void obj_process_seen();
 char* object_name(Object* obj);
 char* object_description(Object* obj);
 void obj_preload_art_cache(int flags);
+void obj_prefetch_art_cache(int flags);
+void obj_prefetch_tile_art(int flags);
 int obj_save_obj(DB_FILE* stream, Object* object);
 int obj_load_obj(DB_FILE* stream, Object** objectPtr, int elevation, Object* owner);
 int obj_save_dude(DB_FILE* stream);
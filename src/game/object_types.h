@@ -288,6 +288,21 @@ typedef struct Object {
 typedef struct ObjectListNode {
     Object* obj;
     struct ObjectListNode* next;
+
+    // CE: Bounds registered in hit grid (in world coordinates, see
+    // `tile_coord_world`), `hitElevation` is -1 when not registered.
+    int hitLeft;
+    int hitTop;
+    int hitRight;
+    int hitBottom;
+    int hitElevation;
+    unsigned int hitQuery;
+
+    // CE: Links in per-elevation, per-type list of objects on the map (see
+    // `obj_find_first_of_type`), `typeList` is -1 when not registered.
+    struct ObjectListNode* typePrev;
+    struct ObjectListNode* typeNext;
+    int typeList;
 } ObjectListNode;
 
 #define BUILT_TILE_TILE_MASK 0x3FFFFFF
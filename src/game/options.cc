@@ -1707,7 +1707,7 @@ int init_options_menu()
 void IncGamma()
 {
     gamma_value = GAMMA_MIN;
-    config_get_double(&game_config, GAME_CONFIG_PREFERENCES_KEY, GAME_CONFIG_BRIGHTNESS_KEY, &gamma_value);
+    config_handle_get_double(&game_config_brightness, &gamma_value);
 
     if (gamma_value < GAMMA_MAX) {
         gamma_value += GAMMA_STEP;
@@ -1732,7 +1732,7 @@ void IncGamma()
 void DecGamma()
 {
     gamma_value = GAMMA_MIN;
-    config_get_double(&game_config, GAME_CONFIG_PREFERENCES_KEY, GAME_CONFIG_BRIGHTNESS_KEY, &gamma_value);
+    config_handle_get_double(&game_config_brightness, &gamma_value);
 
     if (gamma_value > GAMMA_MIN) {
         gamma_value -= GAMMA_STEP;
@@ -1819,6 +1819,9 @@ static int SavePrefs(bool save)
     config_set_double(&game_config, GAME_CONFIG_PREFERENCES_KEY, GAME_CONFIG_BRIGHTNESS_KEY, gamma_value);
     config_set_double(&game_config, GAME_CONFIG_PREFERENCES_KEY, GAME_CONFIG_MOUSE_SENSITIVITY_KEY, mouse_sens);
 
+    // CE: Game difficulty affects skills of the player.
+    combat_to_hit_cache_invalidate();
+
     if (save) {
         gconfig_save();
     }
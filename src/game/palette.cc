@@ -22,6 +22,17 @@ unsigned char black_palette[256 * 3];
 // 0x662820
 static int fade_steps;
 
+// CE: Duration of `palette_fade_to_async` (`fade_steps` are calibrated to
+// about the same time).
+#define PALETTE_FADE_DURATION 700
+
+// CE: Pending `palette_fade_to_async`.
+static bool fade_cycle_was_enabled;
+static PaletteFadeDoneFunc* fade_callback;
+static void* fade_user_data;
+
+static void palette_fade_done(void* userData);
+
 // 0x485090
 void palette_init()
 {
@@ -61,6 +72,9 @@ void palette_exit()
 // 0x485164
 void palette_fade_to(unsigned char* palette)
 {
+    // CE: Complete pending non-blocking fade first.
+    colorFadeFinish();
+
     bool colorCycleWasEnabled = cycle_is_enabled();
     cycle_disable();
 
@@ -81,6 +95,8 @@ void palette_fade_to(unsigned char* palette)
 // 0x4851D8
 void palette_set_to(unsigned char* palette)
 {
+    colorFadeFinish();
+
     memcpy(current_palette, palette, sizeof(current_palette));
     setSystemPalette(palette);
 }
@@ -92,4 +108,46 @@ void palette_set_entries(unsigned char* palette, int start, int end)
     setSystemPaletteEntries(palette, start, end);
 }
 
+// CE: Same as `palette_fade_to`, but returns right away, fade is advanced by
+// background process. `callback` (optional) is called once fade is complete.
+// Color cycling is suspended until then.
+void palette_fade_to_async(unsigned char* palette, PaletteFadeDoneFunc* callback, void* userData)
+{
+    // Complete pending fade (and restore color cycling) first.
+    colorFadeFinish();
+
+    fade_cycle_was_enabled = cycle_is_enabled();
+    cycle_disable();
+
+    fade_callback = callback;
+    fade_user_data = userData;
+
+    unsigned char oldPalette[256 * 3];
+    memcpy(oldPalette, current_palette, sizeof(oldPalette));
+    memcpy(current_palette, palette, sizeof(current_palette));
+
+    colorFadeStart(oldPalette, current_palette, PALETTE_FADE_DURATION, palette_fade_done, NULL);
+}
+
+// CE: Returns `true` while fade started with `palette_fade_to_async` is in
+// progress.
+bool palette_is_fading()
+{
+    return colorFadeIsActive();
+}
+
+static void palette_fade_done(void* userData)
+{
+    if (fade_cycle_was_enabled) {
+        cycle_enable();
+    }
+
+    PaletteFadeDoneFunc* callback = fade_callback;
+    fade_callback = NULL;
+
+    if (callback != NULL) {
+        callback(fade_user_data);
+    }
+}
+
 } // namespace fallout
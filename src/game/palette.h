@@ -3,6 +3,8 @@
 
 namespace fallout {
 
+typedef void(PaletteFadeDoneFunc)(void* userData);
+
 extern unsigned char white_palette[256 * 3];
 extern unsigned char black_palette[256 * 3];
 
@@ -12,6 +14,8 @@ void palette_exit();
 void palette_fade_to(unsigned char* palette);
 void palette_set_to(unsigned char* palette);
 void palette_set_entries(unsigned char* palette, int start, int end);
+void palette_fade_to_async(unsigned char* palette, PaletteFadeDoneFunc* callback, void* userData);
+bool palette_is_fading();
 
 } // namespace fallout
 
@@ -3,6 +3,9 @@
 #include <stdio.h>
 #include <string.h>
 
+#include <unordered_set>
+#include <vector>
+
 #include "game/anim.h"
 #include "game/combatai.h"
 #include "game/config.h"
@@ -22,40 +25,85 @@
 #include "game/scripts.h"
 #include "game/skill.h"
 #include "game/stat.h"
+#include "game/statever.h"
 #include "game/textobj.h"
 #include "game/tile.h"
 #include "plib/color/color.h"
 #include "plib/gnw/debug.h"
 #include "plib/gnw/gnw.h"
-#include "plib/gnw/memory.h"
 
 namespace fallout {
 
-// TODO: Not sure if the same struct is used in `itemSaveListHead` and
-// `partyMemberList`.
+// First object id of party members, every member gets id derived from its pid
+// (see `partyMemberAdd`).
+#define PARTY_MEMBER_ID_BASE 18000
+
+// First object id of items carried by party members (see
+// `partyMemberNewObjID`), upper bound of party member ids.
+#define PARTY_MEMBER_ITEM_ID_BASE 20000
+
+#define PARTY_MEMBER_MAX 20
+
 typedef struct PartyMember {
     Object* object;
-    Script* script;
-    int* vars;
-    struct PartyMember* next;
+
+    // CE: Script kept while party is moved to another map (see
+    // `partyMemberPrepLoad`), stored in place instead of heap copy.
+    bool hasScript;
+    Script script;
+
+    // CE: Offset of script's local vars in `partyMemberVars`, -1 - none.
+    int varsOffset;
 } PartyMember;
 
+// CE: Script of item carried by party member, kept while party is moved to
+// another map.
+typedef struct PartyMemberItemScript {
+    Object* object;
+    Script script;
+
+    // Offset of script's local vars in `partyMemberVars`, -1 - none.
+    int varsOffset;
+} PartyMemberItemScript;
+
 static Object* partyMemberFindID(int id);
 static int partyMemberNewObjID();
-static int partyMemberNewObjIDRecurseFind(Object* object, int objectId);
+static void partyMemberCollectItemIds(Object* obj);
 static int partyMemberPrepItemSave(Object* object);
 static int partyMemberItemSaveAll(Object* object);
 static int partyMemberItemSave(Object* object);
-static int partyMemberItemRecover(PartyMember* partyMember);
+static int partyMemberItemRecover(PartyMemberItemScript* itemScript);
 static int partyMemberItemRecoverAll();
 static int partyMemberClearItemList();
 static int partyFixMultipleMembers();
+static void partyMemberIndexRebuild();
+static int partyMemberSaveVars(Script* script);
+static void partyMemberRestoreVars(Script* script, int varsOffset);
+
+// CE: Scripts of items carried by party members, replaces `itemSaveListHead`
+// list of heap nodes. Storage is reused between map transitions.
+static std::vector<PartyMemberItemScript> partyMemberItemScripts;
+
+// CE: Local vars of scripts kept in `partyMemberList` and
+// `partyMemberItemScripts`.
+static std::vector<int> partyMemberVars;
+
+// CE: Object ids seen by `partyMemberNewObjID` during current
+// `partyMemberPrepLoad`, collected on first use.
+static std::unordered_set<int> partyMemberUsedIds;
+static bool partyMemberUsedIdsValid = false;
 
-// 0x50630C
-PartyMember* itemSaveListHead = NULL;
+// CE: Index of party member (plus one) by object id minus
+// `PARTY_MEMBER_ID_BASE`, zero - not a member. Makes membership checks
+// independent of party size.
+static unsigned char partyMemberIndex[PARTY_MEMBER_ITEM_ID_BASE - PARTY_MEMBER_ID_BASE];
+
+// CE: Set when some member's id is out of `partyMemberIndex` range, so
+// lookups have to scan `partyMemberList`.
+static bool partyMemberIndexIncomplete = false;
 
 // 0x662824
-static PartyMember partyMemberList[20];
+static PartyMember partyMemberList[PARTY_MEMBER_MAX];
 
 // Number of critters added to party.
 //
@@ -63,7 +111,7 @@ static PartyMember partyMemberList[20];
 static int partyMemberCount = 0;
 
 // 0x506314
-static int partyMemberItemCount = 20000;
+static int partyMemberItemCount = PARTY_MEMBER_ITEM_ID_BASE;
 
 // 0x506318
 static int partyStatePrepped = 0;
@@ -75,7 +123,7 @@ int partyMemberAdd(Object* object)
     PartyMember* partyMember;
     Script* script;
 
-    if (partyMemberCount >= 20) {
+    if (partyMemberCount >= PARTY_MEMBER_MAX) {
         return -1;
     }
 
@@ -93,20 +141,22 @@ int partyMemberAdd(Object* object)
 
     partyMember = &(partyMemberList[partyMemberCount]);
     partyMember->object = object;
-    partyMember->script = NULL;
-    partyMember->vars = NULL;
+    partyMember->hasScript = false;
+    partyMember->varsOffset = -1;
 
-    object->id = (object->pid & 0xFFFFFF) + 18000;
+    object->id = (object->pid & 0xFFFFFF) + PARTY_MEMBER_ID_BASE;
     object->flags |= (OBJECT_NO_REMOVE | OBJECT_NO_SAVE);
 
     partyMemberCount++;
+    partyMemberIndexRebuild();
+    statever_bump(STATE_VERSION_PARTY);
 
     if (scr_ptr(object->sid, &script) != -1) {
         script->scr_flags |= (SCRIPT_FLAG_0x08 | SCRIPT_FLAG_0x10);
         script->scr_oid = object->id;
 
-        object->sid = ((object->pid & 0xFFFFFF) + 18000) | (SCRIPT_TYPE_CRITTER << 24);
-        script->scr_id = object->sid;
+        object->sid = ((object->pid & 0xFFFFFF) + PARTY_MEMBER_ID_BASE) | (SCRIPT_TYPE_CRITTER << 24);
+        scr_set_sid(script, object->sid);
     }
 
     combatai_switch_team(object, 0);
@@ -151,6 +201,8 @@ int partyMemberRemove(Object* object)
     object->flags &= ~(OBJECT_NO_REMOVE | OBJECT_NO_SAVE);
 
     partyMemberCount--;
+    partyMemberIndexRebuild();
+    statever_bump(STATE_VERSION_PARTY);
 
     if (scr_ptr(object->sid, &script) != -1) {
         script->scr_flags &= ~(SCRIPT_FLAG_0x08 | SCRIPT_FLAG_0x10);
@@ -253,27 +305,23 @@ int partyMemberPrepLoad()
 
     partyStatePrepped = 1;
 
+    // CE: Item scripts and vars left from previous transition are consumed
+    // by `partyMemberRecoverLoad`, storage is kept.
+    if (partyMemberItemScripts.empty()) {
+        partyMemberVars.clear();
+    }
+
+    partyMemberUsedIdsValid = false;
+
     for (index = 0; index < partyMemberCount; index++) {
         partyMember = &(partyMemberList[index]);
+        partyMember->hasScript = false;
+        partyMember->varsOffset = -1;
 
         if (scr_ptr(partyMember->object->sid, &script) != -1) {
-            partyMember->script = (Script*)mem_malloc(sizeof(*script));
-            if (partyMember->script == NULL) {
-                GNWSystemError("\n  Error!: partyMemberPrepLoad: Out of memory!");
-                exit(1);
-            }
-
-            memcpy(partyMember->script, script, sizeof(*script));
-
-            if (script->scr_num_local_vars != 0 && script->scr_local_var_offset != -1) {
-                partyMember->vars = (int*)mem_malloc(sizeof(*partyMember->vars) * script->scr_num_local_vars);
-                if (partyMember->vars == NULL) {
-                    GNWSystemError("\n  Error!: partyMemberPrepLoad: Out of memory!");
-                    exit(1);
-                }
-
-                memcpy(partyMember->vars, map_local_vars + script->scr_local_var_offset, sizeof(int) * script->scr_num_local_vars);
-            }
+            memcpy(&(partyMember->script), script, sizeof(*script));
+            partyMember->hasScript = true;
+            partyMember->varsOffset = partyMemberSaveVars(script);
 
             // NOTE: Uninline.
             if (partyMemberItemSaveAll(partyMember->object) == -1) {
@@ -289,6 +337,9 @@ int partyMemberPrepLoad()
         }
     }
 
+    partyMemberUsedIds.clear();
+    partyMemberUsedIdsValid = false;
+
     return 0;
 }
 
@@ -309,7 +360,7 @@ int partyMemberRecoverLoad()
 
     for (index = 0; index < partyMemberCount; index++) {
         partyMember = &(partyMemberList[index]);
-        if (partyMember->script != NULL) {
+        if (partyMember->hasScript) {
             if (scr_new(&sid, SCRIPT_TYPE_CRITTER) == -1) {
                 GNWSystemError("\n  Error!: partyMemberRecoverLoad: Can't create script!");
                 exit(1);
@@ -320,23 +371,20 @@ int partyMemberRecoverLoad()
                 exit(1);
             }
 
-            memcpy(script, partyMember->script, sizeof(*script));
+            memcpy(script, &(partyMember->script), sizeof(*script));
 
-            partyMember->object->sid = ((partyMember->object->pid & 0xFFFFFF) + 18000) | (SCRIPT_TYPE_CRITTER << 24);
-            script->scr_id = partyMember->object->sid;
+            partyMember->object->sid = ((partyMember->object->pid & 0xFFFFFF) + PARTY_MEMBER_ID_BASE) | (SCRIPT_TYPE_CRITTER << 24);
+            scr_set_sid(script, partyMember->object->sid);
 
             script->program = NULL;
             script->scr_flags &= ~(SCRIPT_FLAG_0x01 | SCRIPT_FLAG_0x04);
 
-            mem_free(partyMember->script);
-            partyMember->script = NULL;
+            partyMember->hasScript = false;
 
             script->scr_flags |= (SCRIPT_FLAG_0x08 | SCRIPT_FLAG_0x10);
 
-            if (partyMember->vars != NULL) {
-                script->scr_local_var_offset = map_malloc_local_var(script->scr_num_local_vars);
-                memcpy(map_local_vars + script->scr_local_var_offset, partyMember->vars, sizeof(int) * script->scr_num_local_vars);
-            }
+            partyMemberRestoreVars(script, partyMember->varsOffset);
+            partyMember->varsOffset = -1;
 
             debug_printf("[Party Member %d]: %s\n", index, critter_name(partyMember->object));
         }
@@ -390,6 +438,8 @@ int partyMemberLoad(DB_FILE* stream)
         }
     }
 
+    partyMemberIndexRebuild();
+
     partyFixMultipleMembers();
 
     return 0;
@@ -409,6 +459,7 @@ void partyMemberClear()
     }
 
     partyMemberCount = 1;
+    partyMemberIndexRebuild();
 
     scr_remove_all();
     partyMemberClearItemList();
@@ -464,6 +515,22 @@ Object* partyMemberFindObjFromPid(int pid)
     int index;
     Object* object;
 
+    // CE: Members are indexed by id derived from pid.
+    if (!partyMemberIndexIncomplete) {
+        int id = (pid & 0xFFFFFF) + PARTY_MEMBER_ID_BASE;
+        if (id >= PARTY_MEMBER_ID_BASE && id < PARTY_MEMBER_ITEM_ID_BASE) {
+            index = partyMemberIndex[id - PARTY_MEMBER_ID_BASE];
+            if (index != 0 && index <= partyMemberCount) {
+                object = partyMemberList[index - 1].object;
+                if (object->pid == pid) {
+                    return object;
+                }
+            }
+        }
+
+        return NULL;
+    }
+
     for (index = 0; index < partyMemberCount; index++) {
         object = partyMemberList[index].object;
         if (object->pid == pid) {
@@ -481,10 +548,20 @@ bool isPartyMember(Object* object)
 {
     int index;
 
-    if (object->id < 18000) {
+    if (object->id < PARTY_MEMBER_ID_BASE) {
         return false;
     }
 
+    // CE: Use dense index.
+    if (!partyMemberIndexIncomplete) {
+        if (object->id >= PARTY_MEMBER_ITEM_ID_BASE) {
+            return false;
+        }
+
+        index = partyMemberIndex[object->id - PARTY_MEMBER_ID_BASE];
+        return index != 0 && index <= partyMemberCount && partyMemberList[index - 1].object == object;
+    }
+
     for (index = 0; index < partyMemberCount; index++) {
         if (partyMemberList[index].object == object) {
             return true;
@@ -517,63 +594,46 @@ int getPartyMemberCount()
 static int partyMemberNewObjID()
 {
     // 0x50631C
-    static int curID = 20000;
-
-    Object* object;
+    static int curID = PARTY_MEMBER_ITEM_ID_BASE;
 
-    do {
-        curID++;
+    // CE: Collect ids of objects and their (nested) inventories once per
+    // `partyMemberPrepLoad` instead of scanning all objects for every
+    // candidate id.
+    if (!partyMemberUsedIdsValid) {
+        partyMemberUsedIds.clear();
 
-        object = obj_find_first();
+        Object* object = obj_find_first();
         while (object != NULL) {
-            if (object->id == curID) {
-                break;
-            }
-
-            Inventory* inventory = &(object->data.inventory);
-
-            int index;
-            for (index = 0; index < inventory->length; index++) {
-                InventoryItem* inventoryItem = &(inventory->items[index]);
-                Object* item = inventoryItem->item;
-                if (item->id == curID) {
-                    break;
-                }
-
-                if (partyMemberNewObjIDRecurseFind(item, curID)) {
-                    break;
-                }
-            }
-
-            if (index < inventory->length) {
-                break;
-            }
-
+            partyMemberUsedIds.insert(object->id);
+            partyMemberCollectItemIds(object);
             object = obj_find_next();
         }
-    } while (object != NULL);
+
+        partyMemberUsedIdsValid = true;
+    }
+
+    do {
+        curID++;
+    } while (partyMemberUsedIds.find(curID) != partyMemberUsedIds.end());
 
     curID++;
 
+    // Returned id is assigned to item right away.
+    partyMemberUsedIds.insert(curID);
+
     return curID;
 }
 
-// 0x485BA0
-static int partyMemberNewObjIDRecurseFind(Object* obj, int objectId)
+// CE: Adds ids of items in inventory of `obj` (including nested inventories)
+// to `partyMemberUsedIds`.
+static void partyMemberCollectItemIds(Object* obj)
 {
     Inventory* inventory = &(obj->data.inventory);
     for (int index = 0; index < inventory->length; index++) {
-        InventoryItem* inventoryItem = &(inventory->items[index]);
-        if (inventoryItem->item->id == objectId) {
-            return 1;
-        }
-
-        if (partyMemberNewObjIDRecurseFind(inventoryItem->item, objectId)) {
-            return 1;
-        }
+        Object* item = inventory->items[index].item;
+        partyMemberUsedIds.insert(item->id);
+        partyMemberCollectItemIds(item);
     }
-
-    return 0;
 }
 
 // 0x485BEC
@@ -638,8 +698,6 @@ static int partyMemberItemSaveAll(Object* object)
 static int partyMemberItemSave(Object* object)
 {
     Script* script;
-    PartyMember* node;
-    PartyMember* temp;
     Inventory* inventory;
     int index;
 
@@ -649,42 +707,17 @@ static int partyMemberItemSave(Object* object)
             exit(1);
         }
 
-        if (object->id < 20000) {
+        if (object->id < PARTY_MEMBER_ITEM_ID_BASE) {
             script->scr_oid = partyMemberNewObjID();
             object->id = script->scr_oid;
         }
 
-        node = (PartyMember*)mem_malloc(sizeof(*node));
-        if (node == NULL) {
-            GNWSystemError("\n  Error!: partyMemberItemSave: Out of memory!");
-            exit(1);
-        }
-
-        node->object = object;
-
-        node->script = (Script*)mem_malloc(sizeof(*script));
-        if (node->script == NULL) {
-            GNWSystemError("\n  Error!: partyMemberItemSave: Out of memory!");
-            exit(1);
-        }
-
-        memcpy(node->script, script, sizeof(*script));
-
-        if (script->scr_num_local_vars != 0 && script->scr_local_var_offset != -1) {
-            node->vars = (int*)mem_malloc(sizeof(*node->vars) * script->scr_num_local_vars);
-            if (node->vars == NULL) {
-                GNWSystemError("\n  Error!: partyMemberItemSave: Out of memory!");
-                exit(1);
-            }
-
-            memcpy(node->vars, map_local_vars + script->scr_local_var_offset, sizeof(int) * script->scr_num_local_vars);
-        } else {
-            node->vars = NULL;
-        }
-
-        temp = itemSaveListHead;
-        itemSaveListHead = node;
-        node->next = temp;
+        // CE: Keep script in reusable storage instead of heap nodes.
+        PartyMemberItemScript itemScript;
+        itemScript.object = object;
+        memcpy(&(itemScript.script), script, sizeof(*script));
+        itemScript.varsOffset = partyMemberSaveVars(script);
+        partyMemberItemScripts.push_back(itemScript);
     }
 
     inventory = &(object->data.inventory);
@@ -696,7 +729,7 @@ static int partyMemberItemSave(Object* object)
 }
 
 // 0x485E30
-static int partyMemberItemRecover(PartyMember* partyMember)
+static int partyMemberItemRecover(PartyMemberItemScript* itemScript)
 {
     int sid = -1;
     Script* script;
@@ -711,23 +744,17 @@ static int partyMemberItemRecover(PartyMember* partyMember)
         exit(1);
     }
 
-    memcpy(script, partyMember->script, sizeof(*script));
+    memcpy(script, &(itemScript->script), sizeof(*script));
 
-    partyMember->object->sid = partyMemberItemCount | (SCRIPT_TYPE_ITEM << 24);
-    script->scr_id = partyMemberItemCount | (SCRIPT_TYPE_ITEM << 24);
+    itemScript->object->sid = partyMemberItemCount | (SCRIPT_TYPE_ITEM << 24);
+    scr_set_sid(script, partyMemberItemCount | (SCRIPT_TYPE_ITEM << 24));
 
     script->program = NULL;
     script->scr_flags &= ~(SCRIPT_FLAG_0x01 | SCRIPT_FLAG_0x04 | SCRIPT_FLAG_0x08 | SCRIPT_FLAG_0x10);
 
     partyMemberItemCount++;
 
-    mem_free(partyMember->script);
-    partyMember->script = NULL;
-
-    if (partyMember->vars != NULL) {
-        script->scr_local_var_offset = map_malloc_local_var(script->scr_num_local_vars);
-        memcpy(map_local_vars + script->scr_local_var_offset, partyMember->vars, sizeof(int) * script->scr_num_local_vars);
-    }
+    partyMemberRestoreVars(script, itemScript->varsOffset);
 
     return 0;
 }
@@ -735,41 +762,84 @@ static int partyMemberItemRecover(PartyMember* partyMember)
 // 0x485F38
 static int partyMemberItemRecoverAll()
 {
-    PartyMember* partyMember;
-
-    while (itemSaveListHead != NULL) {
-        partyMember = itemSaveListHead;
-        itemSaveListHead = itemSaveListHead->next;
-        partyMemberItemRecover(partyMember);
-        mem_free(partyMember);
+    // Scripts are recovered in reverse order, the same way they were popped
+    // from original list, so item sids are the same.
+    for (size_t index = partyMemberItemScripts.size(); index > 0; index--) {
+        partyMemberItemRecover(&(partyMemberItemScripts[index - 1]));
     }
 
+    partyMemberItemScripts.clear();
+
     return 0;
 }
 
 // 0x485F6C
 static int partyMemberClearItemList()
 {
-    PartyMember* node;
+    partyMemberItemScripts.clear();
+    partyMemberVars.clear();
 
-    while (itemSaveListHead != NULL) {
-        node = itemSaveListHead;
-        itemSaveListHead = itemSaveListHead->next;
+    partyMemberItemCount = PARTY_MEMBER_ITEM_ID_BASE;
 
-        if (node->script != NULL) {
-            mem_free(node->script);
-        }
+    return 0;
+}
 
-        if (node->vars != NULL) {
-            mem_free(node->vars);
-        }
+// CE: Copies local vars of `script` into `partyMemberVars`. Returns offset of
+// copy, or -1 if script has no vars.
+static int partyMemberSaveVars(Script* script)
+{
+    if (script->scr_num_local_vars == 0 || script->scr_local_var_offset == -1) {
+        return -1;
+    }
+
+    int offset = (int)partyMemberVars.size();
+    partyMemberVars.insert(partyMemberVars.end(),
+        map_local_vars + script->scr_local_var_offset,
+        map_local_vars + script->scr_local_var_offset + script->scr_num_local_vars);
+
+    return offset;
+}
 
-        mem_free(node);
+// CE: Allocates local vars of `script` in current map and fills them from
+// copy made by `partyMemberSaveVars`.
+static void partyMemberRestoreVars(Script* script, int varsOffset)
+{
+    if (varsOffset == -1) {
+        return;
     }
 
-    partyMemberItemCount = 20000;
+    script->scr_local_var_offset = map_malloc_local_var(script->scr_num_local_vars);
+    if (script->scr_local_var_offset == -1) {
+        return;
+    }
 
-    return 0;
+    memcpy(map_local_vars + script->scr_local_var_offset, partyMemberVars.data() + varsOffset, sizeof(int) * script->scr_num_local_vars);
+}
+
+// CE: Rebuilds `partyMemberIndex` after party has changed.
+static void partyMemberIndexRebuild()
+{
+    memset(partyMemberIndex, 0, sizeof(partyMemberIndex));
+    partyMemberIndexIncomplete = false;
+
+    for (int index = 0; index < partyMemberCount; index++) {
+        Object* object = partyMemberList[index].object;
+        if (object == NULL) {
+            continue;
+        }
+
+        // Lookups by pid rely on id being derived from it.
+        int id = object->id;
+        if (id < PARTY_MEMBER_ID_BASE
+            || id >= PARTY_MEMBER_ITEM_ID_BASE
+            || id != (object->pid & 0xFFFFFF) + PARTY_MEMBER_ID_BASE
+            || partyMemberIndex[id - PARTY_MEMBER_ID_BASE] != 0) {
+            partyMemberIndexIncomplete = true;
+            continue;
+        }
+
+        partyMemberIndex[id - PARTY_MEMBER_ID_BASE] = (unsigned char)(index + 1);
+    }
 }
 
 // 0x485FC8
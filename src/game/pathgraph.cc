@@ -0,0 +1,656 @@
+#include "game/pathgraph.h"
+
+#include <string.h>
+
+#include "game/gconfig.h"
+#include "game/map_defs.h"
+#include "game/object.h"
+#include "game/tile.h"
+#include "plib/gnw/memory.h"
+
+namespace fallout {
+
+// CE: Coarse pathfinding graph used when regular search in `make_path_func`
+// runs out of nodes.
+//
+// Hex grid is partitioned into square clusters. Every run of passable hexes
+// along the border of two adjacent clusters gives one entrance - a pair of
+// hexes (one on each side) one step apart. Entrances of same cluster are
+// connected with precomputed number of steps between them. Clusters are
+// rebuilt lazily when blocking state of any of their hexes changes.
+
+// Width and height of cluster in hexes.
+#define PATH_CLUSTER_SIZE 10
+
+#define PATH_CLUSTER_GRID_WIDTH (HEX_GRID_WIDTH / PATH_CLUSTER_SIZE)
+#define PATH_CLUSTER_GRID_HEIGHT (HEX_GRID_HEIGHT / PATH_CLUSTER_SIZE)
+#define PATH_CLUSTER_COUNT (PATH_CLUSTER_GRID_WIDTH * PATH_CLUSTER_GRID_HEIGHT)
+#define PATH_CLUSTER_AREA (PATH_CLUSTER_SIZE * PATH_CLUSTER_SIZE)
+
+// Maximum number of entrances per cluster, excess entrances are ignored.
+#define PATH_CLUSTER_MAX_NODES 24
+
+#define PATH_NODE_COUNT (PATH_CLUSTER_COUNT * PATH_CLUSTER_MAX_NODES)
+
+// Pseudo node id of route destination.
+#define PATH_NODE_GOAL PATH_NODE_COUNT
+
+typedef enum PathNodeState {
+    PATH_NODE_STATE_NEW,
+    PATH_NODE_STATE_OPEN,
+    PATH_NODE_STATE_CLOSED,
+} PathNodeState;
+
+typedef struct PathClusterNode {
+    int tile;
+
+    // Hex in neighbour cluster one step away from `tile`.
+    int partnerTile;
+    int partnerCluster;
+} PathClusterNode;
+
+typedef struct PathCluster {
+    bool dirty;
+    int nodesLength;
+    PathClusterNode nodes[PATH_CLUSTER_MAX_NODES];
+
+    // Number of steps between entrances without leaving cluster (-1 -
+    // unreachable).
+    short costs[PATH_CLUSTER_MAX_NODES][PATH_CLUSTER_MAX_NODES];
+} PathCluster;
+
+typedef struct PathGraph {
+    // Allocated on first query.
+    PathCluster* clusters;
+
+    // Specifies whether any of the clusters are dirty.
+    bool dirty;
+} PathGraph;
+
+static int pathgraph_cluster_of(int tile);
+static bool pathgraph_passable(int tile, int elevation);
+static int pathgraph_border(int elevation, int lowCluster, int highCluster, int* lowTiles, int* highTiles, int capacity);
+static void pathgraph_flood(int tile, int elevation, bool multihex, short* steps);
+static void pathgraph_build_cluster(int elevation, int cluster);
+static bool pathgraph_prepare(int elevation);
+static int pathgraph_find_partner(PathGraph* graph, const PathClusterNode* node);
+static void pathgraph_relax(int node, int cost, int parent);
+static bool pathgraph_heap_less(int node1, int node2);
+static void pathgraph_heap_sift_up(int index);
+static void pathgraph_heap_push(int node);
+static void pathgraph_heap_update(int node);
+static int pathgraph_heap_pop();
+
+static PathGraph pathgraph_graphs[ELEVATION_COUNT];
+static bool pathgraph_is_enabled = false;
+
+// Search state, indexed by node id (`cluster * PATH_CLUSTER_MAX_NODES +
+// index`), and `PATH_NODE_GOAL`.
+static int pathgraph_costs[PATH_NODE_COUNT + 1];
+static int pathgraph_estimates[PATH_NODE_COUNT + 1];
+static int pathgraph_parents[PATH_NODE_COUNT + 1];
+static int pathgraph_heap_positions[PATH_NODE_COUNT + 1];
+static unsigned char pathgraph_states[PATH_NODE_COUNT + 1];
+
+// Open nodes as binary min-heap ordered by estimated total cost.
+static int pathgraph_heap[PATH_NODE_COUNT + 1];
+static int pathgraph_heap_length = 0;
+
+// Graph and destination of current search.
+static PathGraph* pathgraph_search_graph = NULL;
+static int pathgraph_search_to = -1;
+
+// Reads config, graphs are built on first query.
+void pathgraph_init()
+{
+    int enabled;
+    if (config_get_value(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_PATH_GRAPH_KEY, &enabled)) {
+        pathgraph_is_enabled = enabled != 0;
+    } else {
+        pathgraph_is_enabled = false;
+    }
+}
+
+void pathgraph_exit()
+{
+    for (int elevation = 0; elevation < ELEVATION_COUNT; elevation++) {
+        PathGraph* graph = &(pathgraph_graphs[elevation]);
+        if (graph->clusters != NULL) {
+            mem_free(graph->clusters);
+            graph->clusters = NULL;
+        }
+        graph->dirty = false;
+    }
+
+    pathgraph_is_enabled = false;
+}
+
+bool pathgraph_enabled()
+{
+    return pathgraph_is_enabled;
+}
+
+// Marks cluster containing `tile` for rebuilding. Should be called when
+// blocking state of `tile` changes.
+void pathgraph_invalidate_tile(int tile, int elevation)
+{
+    if (!elevationIsValid(elevation) || !hexGridTileIsValid(tile)) {
+        return;
+    }
+
+    PathGraph* graph = &(pathgraph_graphs[elevation]);
+    if (graph->clusters == NULL) {
+        return;
+    }
+
+    graph->clusters[pathgraph_cluster_of(tile)].dirty = true;
+    graph->dirty = true;
+}
+
+// Finds coarse route from `from` to `to` through cluster entrances. Fills
+// `waypoints` with consecutive route hexes (excluding `from`, ending with
+// `to`), any two consecutive waypoints are either one step apart or within
+// the same cluster.
+//
+// Returns number of waypoints, or 0 if there is no route.
+int pathgraph_find_route(int from, int to, int elevation, bool multihex, int* waypoints, int capacity)
+{
+    if (!pathgraph_is_enabled || capacity <= 0) {
+        return 0;
+    }
+
+    if (!hexGridTileIsValid(from) || !hexGridTileIsValid(to) || from == to) {
+        return 0;
+    }
+
+    if (!pathgraph_prepare(elevation)) {
+        return 0;
+    }
+
+    PathGraph* graph = &(pathgraph_graphs[elevation]);
+
+    int fromCluster = pathgraph_cluster_of(from);
+    int toCluster = pathgraph_cluster_of(to);
+
+    short fromSteps[PATH_CLUSTER_AREA];
+    pathgraph_flood(from, elevation, multihex, fromSteps);
+
+    short toSteps[PATH_CLUSTER_AREA];
+    pathgraph_flood(to, elevation, false, toSteps);
+
+    memset(pathgraph_states, PATH_NODE_STATE_NEW, sizeof(pathgraph_states));
+    pathgraph_heap_length = 0;
+    pathgraph_search_graph = graph;
+    pathgraph_search_to = to;
+
+    int originX = (fromCluster % PATH_CLUSTER_GRID_WIDTH) * PATH_CLUSTER_SIZE;
+    int originY = (fromCluster / PATH_CLUSTER_GRID_WIDTH) * PATH_CLUSTER_SIZE;
+
+    // Destination within the same cluster is reached directly.
+    if (fromCluster == toCluster) {
+        int local = (to / HEX_GRID_WIDTH - originY) * PATH_CLUSTER_SIZE + (to % HEX_GRID_WIDTH - originX);
+        if (fromSteps[local] >= 0) {
+            pathgraph_relax(PATH_NODE_GOAL, fromSteps[local], -1);
+        }
+    }
+
+    PathCluster* cluster = &(graph->clusters[fromCluster]);
+    for (int index = 0; index < cluster->nodesLength; index++) {
+        int tile = cluster->nodes[index].tile;
+        int local = (tile / HEX_GRID_WIDTH - originY) * PATH_CLUSTER_SIZE + (tile % HEX_GRID_WIDTH - originX);
+        if (fromSteps[local] >= 0) {
+            pathgraph_relax(fromCluster * PATH_CLUSTER_MAX_NODES + index, fromSteps[local], -1);
+        }
+    }
+
+    int toOriginX = (toCluster % PATH_CLUSTER_GRID_WIDTH) * PATH_CLUSTER_SIZE;
+    int toOriginY = (toCluster / PATH_CLUSTER_GRID_WIDTH) * PATH_CLUSTER_SIZE;
+
+    bool found = false;
+    while (pathgraph_heap_length != 0) {
+        int node = pathgraph_heap_pop();
+        pathgraph_states[node] = PATH_NODE_STATE_CLOSED;
+
+        if (node == PATH_NODE_GOAL) {
+            found = true;
+            break;
+        }
+
+        int clusterIndex = node / PATH_CLUSTER_MAX_NODES;
+        int nodeIndex = node % PATH_CLUSTER_MAX_NODES;
+        int cost = pathgraph_costs[node];
+
+        cluster = &(graph->clusters[clusterIndex]);
+        PathClusterNode* clusterNode = &(cluster->nodes[nodeIndex]);
+
+        if (clusterIndex == toCluster) {
+            int tile = clusterNode->tile;
+            int local = (tile / HEX_GRID_WIDTH - toOriginY) * PATH_CLUSTER_SIZE + (tile % HEX_GRID_WIDTH - toOriginX);
+            if (toSteps[local] >= 0) {
+                pathgraph_relax(PATH_NODE_GOAL, cost + toSteps[local], node);
+            }
+        }
+
+        for (int index = 0; index < cluster->nodesLength; index++) {
+            if (index != nodeIndex && cluster->costs[nodeIndex][index] >= 0) {
+                pathgraph_relax(clusterIndex * PATH_CLUSTER_MAX_NODES + index, cost + cluster->costs[nodeIndex][index], node);
+            }
+        }
+
+        int partner = pathgraph_find_partner(graph, clusterNode);
+        if (partner != -1) {
+            pathgraph_relax(partner, cost + 1, node);
+        }
+    }
+
+    if (!found) {
+        return 0;
+    }
+
+    int length = 0;
+    for (int node = pathgraph_parents[PATH_NODE_GOAL]; node != -1; node = pathgraph_parents[node]) {
+        length++;
+    }
+
+    if (length + 1 > capacity) {
+        return 0;
+    }
+
+    waypoints[length] = to;
+
+    int index = length - 1;
+    for (int node = pathgraph_parents[PATH_NODE_GOAL]; node != -1; node = pathgraph_parents[node]) {
+        int clusterIndex = node / PATH_CLUSTER_MAX_NODES;
+        int nodeIndex = node % PATH_CLUSTER_MAX_NODES;
+        waypoints[index--] = graph->clusters[clusterIndex].nodes[nodeIndex].tile;
+    }
+
+    // Remove repeated hexes (entrances of different borders sharing a hex).
+    int waypointsLength = 0;
+    int previous = from;
+    for (index = 0; index <= length; index++) {
+        if (waypoints[index] != previous) {
+            waypoints[waypointsLength++] = waypoints[index];
+            previous = waypoints[index];
+        }
+    }
+
+    return waypointsLength;
+}
+
+static int pathgraph_cluster_of(int tile)
+{
+    int x = tile % HEX_GRID_WIDTH;
+    int y = tile / HEX_GRID_WIDTH;
+    return (y / PATH_CLUSTER_SIZE) * PATH_CLUSTER_GRID_WIDTH + x / PATH_CLUSTER_SIZE;
+}
+
+static bool pathgraph_passable(int tile, int elevation)
+{
+    return !obj_hex_blocked(tile, elevation);
+}
+
+// Finds entrances on the border of two adjacent clusters. Both clusters
+// request entrances of their shared border with the lower cluster first, so
+// they agree on hexes.
+static int pathgraph_border(int elevation, int lowCluster, int highCluster, int* lowTiles, int* highTiles, int capacity)
+{
+    int transitions[PATH_CLUSTER_AREA];
+    int partners[PATH_CLUSTER_AREA];
+    int transitionsLength = 0;
+
+    int originX = (lowCluster % PATH_CLUSTER_GRID_WIDTH) * PATH_CLUSTER_SIZE;
+    int originY = (lowCluster / PATH_CLUSTER_GRID_WIDTH) * PATH_CLUSTER_SIZE;
+
+    for (int y = originY; y < originY + PATH_CLUSTER_SIZE; y++) {
+        for (int x = originX; x < originX + PATH_CLUSTER_SIZE; x++) {
+            int tile = y * HEX_GRID_WIDTH + x;
+            if (!pathgraph_passable(tile, elevation)) {
+                continue;
+            }
+
+            for (int rotation = 0; rotation < ROTATION_COUNT; rotation++) {
+                int neighbor = tile_num_in_direction(tile, rotation, 1);
+                if (neighbor != tile
+                    && pathgraph_cluster_of(neighbor) == highCluster
+                    && pathgraph_passable(neighbor, elevation)) {
+                    transitions[transitionsLength] = tile;
+                    partners[transitionsLength] = neighbor;
+                    transitionsLength++;
+                    break;
+                }
+            }
+        }
+    }
+
+    // Group adjacent transition hexes into runs, every run gives entrance
+    // in its middle.
+    bool visited[PATH_CLUSTER_AREA];
+    memset(visited, 0, sizeof(visited));
+
+    int group[PATH_CLUSTER_AREA];
+    int length = 0;
+
+    for (int start = 0; start < transitionsLength; start++) {
+        if (visited[start]) {
+            continue;
+        }
+
+        int groupLength = 0;
+        group[groupLength++] = start;
+        visited[start] = true;
+
+        for (int head = 0; head < groupLength; head++) {
+            int tile = transitions[group[head]];
+            for (int rotation = 0; rotation < ROTATION_COUNT; rotation++) {
+                int neighbor = tile_num_in_direction(tile, rotation, 1);
+                for (int other = start + 1; other < transitionsLength; other++) {
+                    if (!visited[other] && transitions[other] == neighbor) {
+                        visited[other] = true;
+                        group[groupLength++] = other;
+                    }
+                }
+            }
+        }
+
+        // Order by tile so middle of the run is picked.
+        for (int i = 1; i < groupLength; i++) {
+            int value = group[i];
+            int j = i - 1;
+            while (j >= 0 && group[j] > value) {
+                group[j + 1] = group[j];
+                j--;
+            }
+            group[j + 1] = value;
+        }
+
+        if (length < capacity) {
+            int middle = group[groupLength / 2];
+            lowTiles[length] = transitions[middle];
+            highTiles[length] = partners[middle];
+            length++;
+        }
+    }
+
+    return length;
+}
+
+// Fills `steps` with number of steps from `tile` to every hex of its cluster
+// without leaving it (-1 - unreachable). `tile` itself is always passable,
+// as well as its neighbours for multihex movers (occupied by mover itself).
+static void pathgraph_flood(int tile, int elevation, bool multihex, short* steps)
+{
+    int cluster = pathgraph_cluster_of(tile);
+    int originX = (cluster % PATH_CLUSTER_GRID_WIDTH) * PATH_CLUSTER_SIZE;
+    int originY = (cluster / PATH_CLUSTER_GRID_WIDTH) * PATH_CLUSTER_SIZE;
+
+    for (int index = 0; index < PATH_CLUSTER_AREA; index++) {
+        steps[index] = -1;
+    }
+
+    int queue[PATH_CLUSTER_AREA];
+    int queueLength = 0;
+
+    queue[queueLength++] = tile;
+    steps[(tile / HEX_GRID_WIDTH - originY) * PATH_CLUSTER_SIZE + (tile % HEX_GRID_WIDTH - originX)] = 0;
+
+    for (int head = 0; head < queueLength; head++) {
+        int current = queue[head];
+        int currentSteps = steps[(current / HEX_GRID_WIDTH - originY) * PATH_CLUSTER_SIZE + (current % HEX_GRID_WIDTH - originX)];
+
+        for (int rotation = 0; rotation < ROTATION_COUNT; rotation++) {
+            int neighbor = tile_num_in_direction(current, rotation, 1);
+            if (neighbor == current || pathgraph_cluster_of(neighbor) != cluster) {
+                continue;
+            }
+
+            int local = (neighbor / HEX_GRID_WIDTH - originY) * PATH_CLUSTER_SIZE + (neighbor % HEX_GRID_WIDTH - originX);
+            if (steps[local] != -1) {
+                continue;
+            }
+
+            bool passable = pathgraph_passable(neighbor, elevation)
+                || (multihex && current == tile);
+            if (!passable) {
+                continue;
+            }
+
+            steps[local] = currentSteps + 1;
+            queue[queueLength++] = neighbor;
+        }
+    }
+}
+
+// Rebuilds entrances of `cluster` and distances between them.
+static void pathgraph_build_cluster(int elevation, int cluster)
+{
+    PathCluster* pathCluster = &(pathgraph_graphs[elevation].clusters[cluster]);
+    pathCluster->nodesLength = 0;
+    pathCluster->dirty = false;
+
+    int clusterX = cluster % PATH_CLUSTER_GRID_WIDTH;
+    int clusterY = cluster / PATH_CLUSTER_GRID_WIDTH;
+
+    for (int dy = -1; dy <= 1; dy++) {
+        for (int dx = -1; dx <= 1; dx++) {
+            int x = clusterX + dx;
+            int y = clusterY + dy;
+            if ((dx == 0 && dy == 0)
+                || x < 0 || x >= PATH_CLUSTER_GRID_WIDTH
+                || y < 0 || y >= PATH_CLUSTER_GRID_HEIGHT) {
+                continue;
+            }
+
+            int neighbor = y * PATH_CLUSTER_GRID_WIDTH + x;
+            int capacity = PATH_CLUSTER_MAX_NODES - pathCluster->nodesLength;
+            if (capacity == 0) {
+                break;
+            }
+
+            int lowTiles[PATH_CLUSTER_MAX_NODES];
+            int highTiles[PATH_CLUSTER_MAX_NODES];
+            int length;
+            if (cluster < neighbor) {
+                length = pathgraph_border(elevation, cluster, neighbor, lowTiles, highTiles, capacity);
+            } else {
+                length = pathgraph_border(elevation, neighbor, cluster, lowTiles, highTiles, capacity);
+            }
+
+            for (int index = 0; index < length; index++) {
+                PathClusterNode* node = &(pathCluster->nodes[pathCluster->nodesLength++]);
+                node->tile = cluster < neighbor ? lowTiles[index] : highTiles[index];
+                node->partnerTile = cluster < neighbor ? highTiles[index] : lowTiles[index];
+                node->partnerCluster = neighbor;
+            }
+        }
+    }
+
+    int originX = clusterX * PATH_CLUSTER_SIZE;
+    int originY = clusterY * PATH_CLUSTER_SIZE;
+
+    for (int from = 0; from < pathCluster->nodesLength; from++) {
+        short steps[PATH_CLUSTER_AREA];
+        pathgraph_flood(pathCluster->nodes[from].tile, elevation, false, steps);
+
+        for (int to = 0; to < pathCluster->nodesLength; to++) {
+            int tile = pathCluster->nodes[to].tile;
+            pathCluster->costs[from][to] = steps[(tile / HEX_GRID_WIDTH - originY) * PATH_CLUSTER_SIZE + (tile % HEX_GRID_WIDTH - originX)];
+        }
+    }
+}
+
+// Builds graph of `elevation` on first use and rebuilds dirty clusters along
+// with their neighbours (which share borders and therefore entrances).
+static bool pathgraph_prepare(int elevation)
+{
+    if (!elevationIsValid(elevation)) {
+        return false;
+    }
+
+    PathGraph* graph = &(pathgraph_graphs[elevation]);
+    if (graph->clusters == NULL) {
+        graph->clusters = (PathCluster*)mem_malloc(sizeof(*graph->clusters) * PATH_CLUSTER_COUNT);
+        if (graph->clusters == NULL) {
+            return false;
+        }
+
+        for (int cluster = 0; cluster < PATH_CLUSTER_COUNT; cluster++) {
+            graph->clusters[cluster].dirty = true;
+            graph->clusters[cluster].nodesLength = 0;
+        }
+
+        graph->dirty = true;
+    }
+
+    if (!graph->dirty) {
+        return true;
+    }
+
+    bool rebuild[PATH_CLUSTER_COUNT];
+    memset(rebuild, 0, sizeof(rebuild));
+
+    for (int cluster = 0; cluster < PATH_CLUSTER_COUNT; cluster++) {
+        if (!graph->clusters[cluster].dirty) {
+            continue;
+        }
+
+        int clusterX = cluster % PATH_CLUSTER_GRID_WIDTH;
+        int clusterY = cluster / PATH_CLUSTER_GRID_WIDTH;
+        for (int y = clusterY - 1; y <= clusterY + 1; y++) {
+            for (int x = clusterX - 1; x <= clusterX + 1; x++) {
+                if (x >= 0 && x < PATH_CLUSTER_GRID_WIDTH && y >= 0 && y < PATH_CLUSTER_GRID_HEIGHT) {
+                    rebuild[y * PATH_CLUSTER_GRID_WIDTH + x] = true;
+                }
+            }
+        }
+    }
+
+    for (int cluster = 0; cluster < PATH_CLUSTER_COUNT; cluster++) {
+        if (rebuild[cluster]) {
+            pathgraph_build_cluster(elevation, cluster);
+        }
+    }
+
+    graph->dirty = false;
+
+    return true;
+}
+
+// Returns node id of entrance on the other side of `node`'s border, or -1.
+static int pathgraph_find_partner(PathGraph* graph, const PathClusterNode* node)
+{
+    PathCluster* cluster = &(graph->clusters[node->partnerCluster]);
+    for (int index = 0; index < cluster->nodesLength; index++) {
+        PathClusterNode* other = &(cluster->nodes[index]);
+        if (other->tile == node->partnerTile && other->partnerTile == node->tile) {
+            return node->partnerCluster * PATH_CLUSTER_MAX_NODES + index;
+        }
+    }
+
+    return -1;
+}
+
+// Opens `node` or lowers its cost when it is reached via `parent` with lower
+// cost.
+static void pathgraph_relax(int node, int cost, int parent)
+{
+    switch (pathgraph_states[node]) {
+    case PATH_NODE_STATE_NEW:
+        if (node == PATH_NODE_GOAL) {
+            pathgraph_estimates[node] = 0;
+        } else {
+            PathCluster* cluster = &(pathgraph_search_graph->clusters[node / PATH_CLUSTER_MAX_NODES]);
+            pathgraph_estimates[node] = tile_dist(cluster->nodes[node % PATH_CLUSTER_MAX_NODES].tile, pathgraph_search_to);
+        }
+        pathgraph_costs[node] = cost;
+        pathgraph_parents[node] = parent;
+        pathgraph_states[node] = PATH_NODE_STATE_OPEN;
+        pathgraph_heap_push(node);
+        break;
+    case PATH_NODE_STATE_OPEN:
+        if (cost < pathgraph_costs[node]) {
+            pathgraph_costs[node] = cost;
+            pathgraph_parents[node] = parent;
+            pathgraph_heap_update(node);
+        }
+        break;
+    }
+}
+
+// Returns `true` if open `node1` should be expanded before `node2`.
+static bool pathgraph_heap_less(int node1, int node2)
+{
+    int cost1 = pathgraph_costs[node1] + pathgraph_estimates[node1];
+    int cost2 = pathgraph_costs[node2] + pathgraph_estimates[node2];
+    if (cost1 != cost2) {
+        return cost1 < cost2;
+    }
+
+    return pathgraph_estimates[node1] < pathgraph_estimates[node2];
+}
+
+static void pathgraph_heap_sift_up(int index)
+{
+    int node = pathgraph_heap[index];
+    while (index > 0) {
+        int parent = (index - 1) / 2;
+        if (!pathgraph_heap_less(node, pathgraph_heap[parent])) {
+            break;
+        }
+
+        pathgraph_heap[index] = pathgraph_heap[parent];
+        pathgraph_heap_positions[pathgraph_heap[index]] = index;
+        index = parent;
+    }
+
+    pathgraph_heap[index] = node;
+    pathgraph_heap_positions[node] = index;
+}
+
+static void pathgraph_heap_push(int node)
+{
+    int index = pathgraph_heap_length++;
+    pathgraph_heap[index] = node;
+    pathgraph_heap_sift_up(index);
+}
+
+// Restores heap order after cost of open `node` was lowered.
+static void pathgraph_heap_update(int node)
+{
+    pathgraph_heap_sift_up(pathgraph_heap_positions[node]);
+}
+
+static int pathgraph_heap_pop()
+{
+    int top = pathgraph_heap[0];
+    int node = pathgraph_heap[--pathgraph_heap_length];
+
+    int index = 0;
+    while (true) {
+        int child = index * 2 + 1;
+        if (child >= pathgraph_heap_length) {
+            break;
+        }
+
+        if (child + 1 < pathgraph_heap_length && pathgraph_heap_less(pathgraph_heap[child + 1], pathgraph_heap[child])) {
+            child += 1;
+        }
+
+        if (!pathgraph_heap_less(pathgraph_heap[child], node)) {
+            break;
+        }
+
+        pathgraph_heap[index] = pathgraph_heap[child];
+        pathgraph_heap_positions[pathgraph_heap[index]] = index;
+        index = child;
+    }
+
+    if (pathgraph_heap_length != 0) {
+        pathgraph_heap[index] = node;
+        pathgraph_heap_positions[node] = index;
+    }
+
+    return top;
+}
+
+} // namespace fallout
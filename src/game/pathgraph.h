@@ -0,0 +1,14 @@
+#ifndef FALLOUT_GAME_PATHGRAPH_H_
+#define FALLOUT_GAME_PATHGRAPH_H_
+
+namespace fallout {
+
+void pathgraph_init();
+void pathgraph_exit();
+bool pathgraph_enabled();
+void pathgraph_invalidate_tile(int tile, int elevation);
+int pathgraph_find_route(int from, int to, int elevation, bool multihex, int* waypoints, int capacity);
+
+} // namespace fallout
+
+#endif /* FALLOUT_GAME_PATHGRAPH_H_ */
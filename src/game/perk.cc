@@ -2,6 +2,7 @@
 
 #include <stdio.h>
 
+#include "game/combat.h"
 #include "game/game.h"
 #include "game/gconfig.h"
 #include "game/message.h"
@@ -249,6 +250,9 @@ int perk_add(int perk)
 
     perk_add_effect(obj_dude, perk);
 
+    // CE: Perks affect skills and accuracy.
+    combat_to_hit_cache_invalidate();
+
     return 0;
 }
 
@@ -267,6 +271,9 @@ int perk_sub(int perk)
 
     perk_remove_effect(obj_dude, perk);
 
+    // CE: See `perk_add`.
+    combat_to_hit_cache_invalidate();
+
     return 0;
 }
 
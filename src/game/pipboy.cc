@@ -2040,6 +2040,12 @@ static bool TimedRest(int hours, int minutes, int duration)
 
     bool rc = false;
 
+    // CE: Skip time without animating clock in between.
+    int instantRest;
+    if (!config_get_value(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_INSTANT_REST_KEY, &instantRest)) {
+        instantRest = 0;
+    }
+
     if (duration == 0) {
         int hoursInMinutes = hours * 60;
         double v1 = (double)hoursInMinutes + (double)minutes;
@@ -2060,6 +2066,21 @@ static bool TimedRest(int hours, int minutes, int duration)
                 unsigned int start = get_time();
 
                 unsigned int v6 = (unsigned int)((double)v5 / v4 * ((double)minutes * 600.0) + (double)gameTime);
+
+                if (instantRest) {
+                    int skip = gtime_skip(v6);
+                    if (skip == 1) {
+                        debug_printf("PIPBOY: Returning from Queue trigger...\n");
+                        proc_bail_flag = 1;
+                    }
+
+                    if (skip != 0) {
+                        rc = true;
+                    }
+
+                    continue;
+                }
+
                 unsigned int nextEventTime = queue_next_time();
                 if (v6 >= nextEventTime) {
                     set_game_time(nextEventTime + 1);
@@ -2128,6 +2149,28 @@ static bool TimedRest(int hours, int minutes, int duration)
                 }
 
                 unsigned int v8 = (unsigned int)((double)hour / v7 * (hours * GAME_TIME_TICKS_PER_HOUR) + gameTime);
+
+                if (instantRest && !rc) {
+                    int skip = gtime_skip(v8);
+                    if (skip == 1) {
+                        debug_printf("PIPBOY: Returning from Queue trigger...\n");
+                        proc_bail_flag = 1;
+                    }
+
+                    if (skip != 0) {
+                        rc = true;
+                        continue;
+                    }
+
+                    int healthToAdd = (int)((double)hoursInMinutes / v7);
+                    if (Check4Health(healthToAdd)) {
+                        // NOTE: Uninline.
+                        AddHealth();
+                    }
+
+                    continue;
+                }
+
                 unsigned int nextEventTime = queue_next_time();
                 if (!rc && v8 >= nextEventTime) {
                     set_game_time(nextEventTime + 1);
@@ -2336,7 +2379,7 @@ static int ScreenSaver()
             break;
         }
 
-        double random = roll_random(0, PIPBOY_RAND_MAX);
+        double random = roll_random_stream(ROLL_STREAM_COSMETIC, 0, PIPBOY_RAND_MAX);
 
         // TODO: Figure out what this constant means. Probably somehow related
         // to PIPBOY_RAND_MAX.
@@ -2351,7 +2394,7 @@ static int ScreenSaver()
             if (index < PIPBOY_BOMB_COUNT) {
                 PipboyBomb* bomb = &(bombs[index]);
                 int v27 = (350 - ginfo[PIPBOY_FRM_BOMB].width / 4) + (406 - ginfo[PIPBOY_FRM_BOMB].height / 4);
-                int v5 = (int)((double)roll_random(0, PIPBOY_RAND_MAX) / (double)PIPBOY_RAND_MAX * (double)v27);
+                int v5 = (int)((double)roll_random_stream(ROLL_STREAM_COSMETIC, 0, PIPBOY_RAND_MAX) / (double)PIPBOY_RAND_MAX * (double)v27);
                 int v6 = ginfo[PIPBOY_FRM_BOMB].height / 4;
                 if (PIPBOY_WINDOW_CONTENT_VIEW_HEIGHT - v6 >= v5) {
                     bomb->x = 602;
@@ -2362,7 +2405,7 @@ static int ScreenSaver()
                 }
 
                 bomb->field_10 = 1;
-                bomb->field_8 = (float)((double)roll_random(0, PIPBOY_RAND_MAX) * (2.75 / PIPBOY_RAND_MAX) + 0.15);
+                bomb->field_8 = (float)((double)roll_random_stream(ROLL_STREAM_COSMETIC, 0, PIPBOY_RAND_MAX) * (2.75 / PIPBOY_RAND_MAX) + 0.15);
                 bomb->field_C = 0;
             }
         }
@@ -96,8 +96,7 @@ int obj_new_sid(Object* object, int* sidPtr)
     }
 
     if (scriptType == SCRIPT_TYPE_SPATIAL) {
-        script->sp.built_tile = builtTileCreate(object->tile, object->elevation);
-        script->sp.radius = 3;
+        scr_spatial_set(script, builtTileCreate(object->tile, object->elevation), 3);
     }
 
     if (object->id == -1) {
@@ -131,8 +130,7 @@ int obj_new_sid_inst(Object* obj, int scriptType, int a3)
 
     script->scr_script_idx = a3;
     if (scriptType == SCRIPT_TYPE_SPATIAL) {
-        script->sp.built_tile = builtTileCreate(obj->tile, obj->elevation);
-        script->sp.radius = 3;
+        scr_spatial_set(script, builtTileCreate(obj->tile, obj->elevation), 3);
     }
 
     obj->sid = sid;
@@ -192,7 +190,7 @@ int obj_look_at_func(Object* a1, Object* a2, void (*a3)(char* string))
         MessageListItem messageListItem;
 
         if (PID_TYPE(a2->pid) == OBJ_TYPE_CRITTER && critter_is_dead(a2)) {
-            messageListItem.num = 491 + roll_random(0, 1);
+            messageListItem.num = 491 + roll_random_stream(ROLL_STREAM_COSMETIC, 0, 1);
         } else {
             messageListItem.num = 490;
         }
@@ -750,6 +748,9 @@ static int obj_use_flare(Object* critter_obj, Object* flare)
 
         flare->pid = PROTO_ID_LIT_FLARE;
 
+        // CE: Weight and cost come from proto.
+        item_totals_invalidate();
+
         obj_set_light(flare, 8, 0x10000, NULL);
         queue_add(72000, flare, NULL, EVENT_TYPE_FLARE);
     }
@@ -811,6 +812,8 @@ static int obj_use_explosive(Object* explosive)
                 explosive->pid = PROTO_ID_PLASTIC_EXPLOSIVES_II;
             }
 
+            item_totals_invalidate();
+
             int delay = 10 * seconds;
             int roll = skill_result(obj_dude, SKILL_TRAPS, 0, NULL);
 
@@ -927,7 +930,7 @@ static int protinst_default_use_item(Object* a1, Object* a2, Object* item)
             // 584: As you reach down, you realize that it is already dead.
             // 585: Alas, you are too late.
             // 586: That won't work on the dead.
-            messageListItem.num = 583 + roll_random(0, 3);
+            messageListItem.num = 583 + roll_random_stream(ROLL_STREAM_COSMETIC, 0, 3);
             if (message_search(&proto_main_msg_file, &messageListItem)) {
                 display_print(messageListItem.text);
             }
@@ -1060,7 +1063,7 @@ int protinst_use_item_on(Object* a1, Object* a2, Object* item)
         return 0;
     }
 
-    if (roll_random(1, 10) != 1) {
+    if (roll_random_stream(ROLL_STREAM_COSMETIC, 1, 10) != 1) {
         return 0;
     }
 
@@ -1225,6 +1228,8 @@ static int sync_door_state_flags(Object* a1, Object* a2)
         a1->flags &= ~OBJECT_OPEN_DOOR;
     }
 
+    obj_update_blocking(a1);
+
     // NOTE: Uninline.
     rebuild_all_light();
 
@@ -1253,6 +1258,8 @@ static int check_door_state(Object* a1, Object* a2)
         a1->flags &= ~OBJECT_OPEN_DOOR;
     }
 
+    obj_update_blocking(a1);
+
     // NOTE: Uninline.
     rebuild_all_light();
 
@@ -1557,6 +1564,8 @@ int obj_lock(Object* object)
         break;
     case OBJ_TYPE_SCENERY:
         object->data.scenery.door.openFlags |= OBJ_LOCKED;
+        // CE: Locked doors cannot be used by pathfinder.
+        obj_update_blocking(object);
         break;
     default:
         return -1;
@@ -1578,6 +1587,7 @@ int obj_unlock(Object* object)
         return 0;
     case OBJ_TYPE_SCENERY:
         object->data.scenery.door.openFlags &= ~OBJ_LOCKED;
+        obj_update_blocking(object);
         return 0;
     }
 
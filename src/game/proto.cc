@@ -1,8 +1,11 @@
 #include "game/proto.h"
 
+#include <stddef.h>
 #include <stdio.h>
 #include <string.h>
 
+#include <SDL.h>
+
 #include "game/art.h"
 #include "game/combat.h"
 #include "game/config.h"
@@ -35,6 +38,9 @@ static int proto_write_item_data(ItemProtoData* item_data, int type, DB_FILE* st
 static int proto_write_scenery_data(SceneryProtoData* scenery_data, int type, DB_FILE* stream);
 static int proto_write_protoSubNode(Proto* buf, DB_FILE* stream);
 static int proto_new_id(int a1);
+static void proto_index_add(Proto* proto);
+static void proto_preload();
+static void proto_index_preloaded();
 
 // 0x50734C
 char cd_path_base[COMPAT_MAX_PATH];
@@ -69,9 +75,170 @@ static const size_t proto_sizes[11] = {
     0,
 };
 
+// CE: Kinds of `proto_data_member` members.
+typedef enum ProtoMemberKind {
+    PROTO_MEMBER_UNIMPLEMENTED,
+    PROTO_MEMBER_INT,
+    PROTO_MEMBER_NAME,
+    PROTO_MEMBER_DESCRIPTION,
+} ProtoMemberKind;
+
+typedef struct ProtoMemberInfo {
+    unsigned char kind;
+    // Value type reported by `proto_data_member`.
+    unsigned char type;
+    unsigned short offset;
+} ProtoMemberInfo;
+
+#define PROTO_MEMBER_TYPE_COUNT 6
+#define PROTO_MEMBER_MAX 16
+
+#define PROTO_MEMBER_INT_AT(field) { PROTO_MEMBER_INT, PROTO_DATA_MEMBER_TYPE_INT, (unsigned short)offsetof(Proto, field) }
+#define PROTO_MEMBER_NAME_STR { PROTO_MEMBER_NAME, PROTO_DATA_MEMBER_TYPE_STRING, 0 }
+#define PROTO_MEMBER_DESCRIPTION_STR { PROTO_MEMBER_DESCRIPTION, PROTO_DATA_MEMBER_TYPE_STRING, 0 }
+#define PROTO_MEMBER_NONE { PROTO_MEMBER_UNIMPLEMENTED, PROTO_DATA_MEMBER_TYPE_INT, 0 }
+
+// CE: Members of each proto type available to `proto_data_member`, indexed
+// by `ItemDataMember`, `CritterDataMember`, etc.
+static constexpr ProtoMemberInfo proto_members[PROTO_MEMBER_TYPE_COUNT][PROTO_MEMBER_MAX] = {
+    // OBJ_TYPE_ITEM
+    {
+        PROTO_MEMBER_INT_AT(pid),
+        PROTO_MEMBER_NAME_STR,
+        PROTO_MEMBER_DESCRIPTION_STR,
+        PROTO_MEMBER_INT_AT(fid),
+        PROTO_MEMBER_INT_AT(item.lightDistance),
+        PROTO_MEMBER_INT_AT(item.lightIntensity),
+        PROTO_MEMBER_INT_AT(item.flags),
+        PROTO_MEMBER_INT_AT(item.extendedFlags),
+        PROTO_MEMBER_INT_AT(item.sid),
+        PROTO_MEMBER_INT_AT(item.type),
+        PROTO_MEMBER_NONE,
+        PROTO_MEMBER_INT_AT(item.material),
+        PROTO_MEMBER_INT_AT(item.size),
+        PROTO_MEMBER_INT_AT(item.weight),
+        PROTO_MEMBER_INT_AT(item.cost),
+        PROTO_MEMBER_INT_AT(item.inventoryFid),
+    },
+    // OBJ_TYPE_CRITTER
+    {
+        PROTO_MEMBER_INT_AT(critter.pid),
+        PROTO_MEMBER_NAME_STR,
+        PROTO_MEMBER_DESCRIPTION_STR,
+        PROTO_MEMBER_INT_AT(critter.fid),
+        PROTO_MEMBER_INT_AT(critter.lightDistance),
+        PROTO_MEMBER_INT_AT(critter.lightIntensity),
+        PROTO_MEMBER_INT_AT(critter.flags),
+        PROTO_MEMBER_INT_AT(critter.extendedFlags),
+        PROTO_MEMBER_INT_AT(critter.sid),
+        PROTO_MEMBER_NONE,
+        PROTO_MEMBER_INT_AT(critter.headFid),
+        PROTO_MEMBER_NONE,
+        PROTO_MEMBER_NONE,
+        PROTO_MEMBER_NONE,
+        PROTO_MEMBER_NONE,
+        PROTO_MEMBER_NONE,
+    },
+    // OBJ_TYPE_SCENERY
+    {
+        PROTO_MEMBER_INT_AT(scenery.pid),
+        PROTO_MEMBER_NAME_STR,
+        PROTO_MEMBER_DESCRIPTION_STR,
+        PROTO_MEMBER_INT_AT(scenery.fid),
+        PROTO_MEMBER_INT_AT(scenery.lightDistance),
+        PROTO_MEMBER_INT_AT(scenery.lightIntensity),
+        PROTO_MEMBER_INT_AT(scenery.flags),
+        PROTO_MEMBER_INT_AT(scenery.extendedFlags),
+        PROTO_MEMBER_INT_AT(scenery.sid),
+        PROTO_MEMBER_INT_AT(scenery.type),
+        PROTO_MEMBER_NONE,
+        PROTO_MEMBER_INT_AT(scenery.material),
+        PROTO_MEMBER_NONE,
+        PROTO_MEMBER_NONE,
+        PROTO_MEMBER_NONE,
+        PROTO_MEMBER_NONE,
+    },
+    // OBJ_TYPE_WALL
+    {
+        PROTO_MEMBER_INT_AT(wall.pid),
+        PROTO_MEMBER_NAME_STR,
+        PROTO_MEMBER_DESCRIPTION_STR,
+        PROTO_MEMBER_INT_AT(wall.fid),
+        PROTO_MEMBER_INT_AT(wall.lightDistance),
+        PROTO_MEMBER_INT_AT(wall.lightIntensity),
+        PROTO_MEMBER_INT_AT(wall.flags),
+        PROTO_MEMBER_INT_AT(wall.extendedFlags),
+        PROTO_MEMBER_INT_AT(wall.sid),
+        PROTO_MEMBER_INT_AT(wall.material),
+        PROTO_MEMBER_NONE,
+        PROTO_MEMBER_NONE,
+        PROTO_MEMBER_NONE,
+        PROTO_MEMBER_NONE,
+        PROTO_MEMBER_NONE,
+        PROTO_MEMBER_NONE,
+    },
+    // OBJ_TYPE_TILE
+    {
+        PROTO_MEMBER_NONE,
+        PROTO_MEMBER_NONE,
+        PROTO_MEMBER_NONE,
+        PROTO_MEMBER_NONE,
+        PROTO_MEMBER_NONE,
+        PROTO_MEMBER_NONE,
+        PROTO_MEMBER_NONE,
+        PROTO_MEMBER_NONE,
+        PROTO_MEMBER_NONE,
+        PROTO_MEMBER_NONE,
+        PROTO_MEMBER_NONE,
+        PROTO_MEMBER_NONE,
+        PROTO_MEMBER_NONE,
+        PROTO_MEMBER_NONE,
+        PROTO_MEMBER_NONE,
+        PROTO_MEMBER_NONE,
+    },
+    // OBJ_TYPE_MISC
+    {
+        PROTO_MEMBER_INT_AT(misc.pid),
+        PROTO_MEMBER_NAME_STR,
+        // FIXME: Errornously report type as int, should be string.
+        { PROTO_MEMBER_DESCRIPTION, PROTO_DATA_MEMBER_TYPE_INT, 0 },
+        PROTO_MEMBER_INT_AT(misc.fid),
+        PROTO_MEMBER_INT_AT(misc.lightDistance),
+        PROTO_MEMBER_INT_AT(misc.lightIntensity),
+        PROTO_MEMBER_INT_AT(misc.flags),
+        PROTO_MEMBER_INT_AT(misc.extendedFlags),
+        PROTO_MEMBER_NONE,
+        PROTO_MEMBER_NONE,
+        PROTO_MEMBER_NONE,
+        PROTO_MEMBER_NONE,
+        PROTO_MEMBER_NONE,
+        PROTO_MEMBER_NONE,
+        PROTO_MEMBER_NONE,
+        PROTO_MEMBER_NONE,
+    },
+};
+
 // 0x50752C
 static int protos_been_initialized = 0;
 
+// CE: Proto lists counters, see `proto_get_cache_stats`.
+static CacheStats proto_cache_stats;
+static Uint64 proto_cache_read_ticks = 0;
+
+// CE: Loaded protos of each type indexed by PID id, see `proto_ptr`.
+static Proto** proto_index[6];
+static int proto_index_size[6];
+
+// CE: Protos read at startup, one packed block per type indexed by PID id
+// minus one, see `proto_preload`.
+static unsigned char* proto_preloaded[6];
+static int proto_preloaded_count[6];
+
+// CE: Copies of `proto_preloaded` as read from disk. Scripts and stats
+// write to loaded protos, these writes are discarded by copying blocks back
+// in `proto_remove_all`, the same way protos read on demand are reread.
+static unsigned char* proto_preloaded_pristine[6];
+
 // 0x507530
 static CritterProto pc_proto = {
     0x1000000,
@@ -784,6 +951,9 @@ int proto_dude_init(const char* path)
     proto->critter.data.experience = 0;
     proto->critter.data.killType = 0;
 
+    // CE: See `stat_cache_invalidate`.
+    stat_cache_invalidate();
+
     proto_dude_update_gender();
     inven_reset_dude();
 
@@ -793,6 +963,7 @@ int proto_dude_init(const char* path)
 
     if ((obj_dude->flags & OBJECT_NO_BLOCK) != 0) {
         obj_dude->flags &= ~OBJECT_NO_BLOCK;
+        obj_update_blocking(obj_dude);
     }
 
     stat_recalc_derived(obj_dude);
@@ -813,226 +984,47 @@ int proto_data_member(int pid, int member, ProtoDataMemberValue* value)
         return -1;
     }
 
-    switch (PID_TYPE(pid)) {
-    case OBJ_TYPE_ITEM:
-        switch (member) {
-        case ITEM_DATA_MEMBER_PID:
-            value->integerValue = proto->pid;
-            break;
-        case ITEM_DATA_MEMBER_NAME:
-            // NOTE: uninline
-            value->stringValue = proto_name(proto->scenery.pid);
-            return PROTO_DATA_MEMBER_TYPE_STRING;
-        case ITEM_DATA_MEMBER_DESCRIPTION:
-            // NOTE: Uninline.
-            value->stringValue = proto_description(proto->pid);
-            return PROTO_DATA_MEMBER_TYPE_STRING;
-        case ITEM_DATA_MEMBER_FID:
-            value->integerValue = proto->fid;
-            break;
-        case ITEM_DATA_MEMBER_LIGHT_DISTANCE:
-            value->integerValue = proto->item.lightDistance;
-            break;
-        case ITEM_DATA_MEMBER_LIGHT_INTENSITY:
-            value->integerValue = proto->item.lightIntensity;
-            break;
-        case ITEM_DATA_MEMBER_FLAGS:
-            value->integerValue = proto->item.flags;
-            break;
-        case ITEM_DATA_MEMBER_EXTENDED_FLAGS:
-            value->integerValue = proto->item.extendedFlags;
-            break;
-        case ITEM_DATA_MEMBER_SID:
-            value->integerValue = proto->item.sid;
-            break;
-        case ITEM_DATA_MEMBER_TYPE:
-            value->integerValue = proto->item.type;
-            break;
-        case ITEM_DATA_MEMBER_MATERIAL:
-            value->integerValue = proto->item.material;
-            break;
-        case ITEM_DATA_MEMBER_SIZE:
-            value->integerValue = proto->item.size;
-            break;
-        case ITEM_DATA_MEMBER_WEIGHT:
-            value->integerValue = proto->item.weight;
-            break;
-        case ITEM_DATA_MEMBER_COST:
-            value->integerValue = proto->item.cost;
-            break;
-        case ITEM_DATA_MEMBER_INVENTORY_FID:
-            value->integerValue = proto->item.inventoryFid;
-            break;
-        default:
-            debug_printf("\n\tError: Unimp'd data member in member in proto_data_member!");
-            break;
-        }
-        break;
-    case OBJ_TYPE_CRITTER:
-        switch (member) {
-        case CRITTER_DATA_MEMBER_PID:
-            value->integerValue = proto->critter.pid;
-            break;
-        case CRITTER_DATA_MEMBER_NAME:
-            // NOTE: Uninline.
-            value->stringValue = proto_name(proto->critter.pid);
-            return PROTO_DATA_MEMBER_TYPE_STRING;
-        case CRITTER_DATA_MEMBER_DESCRIPTION:
-            // NOTE: Uninline.
-            value->stringValue = proto_description(proto->critter.pid);
-            return PROTO_DATA_MEMBER_TYPE_STRING;
-        case CRITTER_DATA_MEMBER_FID:
-            value->integerValue = proto->critter.fid;
-            break;
-        case CRITTER_DATA_MEMBER_LIGHT_DISTANCE:
-            value->integerValue = proto->critter.lightDistance;
-            break;
-        case CRITTER_DATA_MEMBER_LIGHT_INTENSITY:
-            value->integerValue = proto->critter.lightIntensity;
-            break;
-        case CRITTER_DATA_MEMBER_FLAGS:
-            value->integerValue = proto->critter.flags;
-            break;
-        case CRITTER_DATA_MEMBER_EXTENDED_FLAGS:
-            value->integerValue = proto->critter.extendedFlags;
-            break;
-        case CRITTER_DATA_MEMBER_SID:
-            value->integerValue = proto->critter.sid;
-            break;
-        case CRITTER_DATA_MEMBER_HEAD_FID:
-            value->integerValue = proto->critter.headFid;
-            break;
-        default:
-            debug_printf("\n\tError: Unimp'd data member in member in proto_data_member!");
-            break;
-        }
+    // CE: Members are described by `proto_members` table instead of nested
+    // switches.
+    int type = PID_TYPE(pid);
+    if (type < 0 || type >= PROTO_MEMBER_TYPE_COUNT) {
+        return PROTO_DATA_MEMBER_TYPE_INT;
+    }
+
+    const ProtoMemberInfo* info = member >= 0 && member < PROTO_MEMBER_MAX
+        ? &(proto_members[type][member])
+        : NULL;
+
+    int kind = PROTO_MEMBER_UNIMPLEMENTED;
+    if (info != NULL) {
+        kind = info->kind;
+    }
+
+    switch (kind) {
+    case PROTO_MEMBER_INT:
+        memcpy(&(value->integerValue), (unsigned char*)proto + info->offset, sizeof(value->integerValue));
         break;
-    case OBJ_TYPE_SCENERY:
-        switch (member) {
-        case SCENERY_DATA_MEMBER_PID:
-            value->integerValue = proto->scenery.pid;
-            break;
-        case SCENERY_DATA_MEMBER_NAME:
-            // NOTE: Uninline.
-            value->stringValue = proto_name(proto->scenery.pid);
-            return PROTO_DATA_MEMBER_TYPE_STRING;
-        case SCENERY_DATA_MEMBER_DESCRIPTION:
-            // NOTE: Uninline.
-            value->stringValue = proto_description(proto->scenery.pid);
-            return PROTO_DATA_MEMBER_TYPE_STRING;
-        case SCENERY_DATA_MEMBER_FID:
-            value->integerValue = proto->scenery.fid;
-            break;
-        case SCENERY_DATA_MEMBER_LIGHT_DISTANCE:
-            value->integerValue = proto->scenery.lightDistance;
-            break;
-        case SCENERY_DATA_MEMBER_LIGHT_INTENSITY:
-            value->integerValue = proto->scenery.lightIntensity;
-            break;
-        case SCENERY_DATA_MEMBER_FLAGS:
-            value->integerValue = proto->scenery.flags;
-            break;
-        case SCENERY_DATA_MEMBER_EXTENDED_FLAGS:
-            value->integerValue = proto->scenery.extendedFlags;
-            break;
-        case SCENERY_DATA_MEMBER_SID:
-            value->integerValue = proto->scenery.sid;
-            break;
-        case SCENERY_DATA_MEMBER_TYPE:
-            value->integerValue = proto->scenery.type;
-            break;
-        case SCENERY_DATA_MEMBER_MATERIAL:
-            value->integerValue = proto->scenery.material;
-            break;
-        default:
-            debug_printf("\n\tError: Unimp'd data member in member in proto_data_member!");
-            break;
-        }
+    case PROTO_MEMBER_NAME:
+        // NOTE: Uninline.
+        value->stringValue = proto_name(proto->pid);
         break;
-    case OBJ_TYPE_WALL:
-        switch (member) {
-        case WALL_DATA_MEMBER_PID:
-            value->integerValue = proto->wall.pid;
-            break;
-        case WALL_DATA_MEMBER_NAME:
-            // NOTE: Uninline.
-            value->stringValue = proto_name(proto->wall.pid);
-            return PROTO_DATA_MEMBER_TYPE_STRING;
-        case WALL_DATA_MEMBER_DESCRIPTION:
-            // NOTE: Uninline.
-            value->stringValue = proto_description(proto->wall.pid);
-            return PROTO_DATA_MEMBER_TYPE_STRING;
-        case WALL_DATA_MEMBER_FID:
-            value->integerValue = proto->wall.fid;
-            break;
-        case WALL_DATA_MEMBER_LIGHT_DISTANCE:
-            value->integerValue = proto->wall.lightDistance;
-            break;
-        case WALL_DATA_MEMBER_LIGHT_INTENSITY:
-            value->integerValue = proto->wall.lightIntensity;
-            break;
-        case WALL_DATA_MEMBER_FLAGS:
-            value->integerValue = proto->wall.flags;
-            break;
-        case WALL_DATA_MEMBER_EXTENDED_FLAGS:
-            value->integerValue = proto->wall.extendedFlags;
-            break;
-        case WALL_DATA_MEMBER_SID:
-            value->integerValue = proto->wall.sid;
-            break;
-        case WALL_DATA_MEMBER_MATERIAL:
-            value->integerValue = proto->wall.material;
-            break;
-        default:
-            debug_printf("\n\tError: Unimp'd data member in member in proto_data_member!");
-            break;
-        }
+    case PROTO_MEMBER_DESCRIPTION:
+        // NOTE: Uninline.
+        value->stringValue = proto_description(proto->pid);
         break;
-    case OBJ_TYPE_TILE:
+    default:
         debug_printf("\n\tError: Unimp'd data member in member in proto_data_member!");
-        break;
-    case OBJ_TYPE_MISC:
-        switch (member) {
-        case MISC_DATA_MEMBER_PID:
-            value->integerValue = proto->misc.pid;
-            break;
-        case MISC_DATA_MEMBER_NAME:
-            // NOTE: Uninline.
-            value->stringValue = proto_name(proto->misc.pid);
-            return PROTO_DATA_MEMBER_TYPE_STRING;
-        case MISC_DATA_MEMBER_DESCRIPTION:
-            // NOTE: Uninline.
-            value->stringValue = proto_description(proto->misc.pid);
-            // FIXME: Errornously report type as int, should be string.
-            return PROTO_DATA_MEMBER_TYPE_INT;
-        case MISC_DATA_MEMBER_FID:
-            value->integerValue = proto->misc.fid;
-            return 1;
-        case MISC_DATA_MEMBER_LIGHT_DISTANCE:
-            value->integerValue = proto->misc.lightDistance;
-            return 1;
-        case MISC_DATA_MEMBER_LIGHT_INTENSITY:
-            value->integerValue = proto->misc.lightIntensity;
-            break;
-        case MISC_DATA_MEMBER_FLAGS:
-            value->integerValue = proto->misc.flags;
-            break;
-        case MISC_DATA_MEMBER_EXTENDED_FLAGS:
-            value->integerValue = proto->misc.extendedFlags;
-            break;
-        default:
-            debug_printf("\n\tError: Unimp'd data member in member in proto_data_member!");
-            break;
-        }
-        break;
+        return PROTO_DATA_MEMBER_TYPE_INT;
     }
 
-    return PROTO_DATA_MEMBER_TYPE_INT;
+    return info->type;
 }
 
 // 0x48E84C
 int proto_init()
 {
+    MemTagScope memTagScope(MEM_TAG_PROTO);
+
     MessageListItem messageListItem;
     char path[COMPAT_MAX_PATH];
     int i;
@@ -1141,6 +1133,12 @@ int proto_init()
         body_type_strs[i] = getmsg(&proto_main_msg_file, &messageListItem, 400 + i);
     }
 
+    int preloadProtos = 0;
+    config_get_value(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_PRELOAD_PROTOS_KEY, &preloadProtos);
+    if (preloadProtos != 0) {
+        proto_preload();
+    }
+
     return 0;
 }
 
@@ -1173,6 +1171,25 @@ void proto_exit()
     // NOTE: Uninline.
     proto_remove_all();
 
+    for (i = 0; i < 6; i++) {
+        if (proto_index[i] != NULL) {
+            mem_free(proto_index[i]);
+            proto_index[i] = NULL;
+        }
+        proto_index_size[i] = 0;
+
+        if (proto_preloaded[i] != NULL) {
+            mem_free(proto_preloaded[i]);
+            proto_preloaded[i] = NULL;
+        }
+
+        if (proto_preloaded_pristine[i] != NULL) {
+            mem_free(proto_preloaded_pristine[i]);
+            proto_preloaded_pristine[i] = NULL;
+        }
+        proto_preloaded_count[i] = 0;
+    }
+
     protos_been_initialized = 0;
 
     for (i = 0; i < 6; i++) {
@@ -1625,6 +1642,8 @@ int proto_save_pid(int pid)
 // 0x490034
 int proto_load_pid(int pid, Proto** protoPtr)
 {
+    MemTagScope memTagScope(MEM_TAG_PROTO);
+
     char path[COMPAT_MAX_PATH];
     proto_make_path(path, pid);
     strcat(path, "\\");
@@ -1633,25 +1652,27 @@ int proto_load_pid(int pid, Proto** protoPtr)
         return -1;
     }
 
+    Uint64 readStart = SDL_GetPerformanceCounter();
+    proto_cache_stats.reads++;
+
     DB_FILE* stream = db_fopen(path, "rb");
     if (stream == NULL) {
         debug_printf("\nError: Can't fopen proto!\n");
         *protoPtr = NULL;
+        proto_cache_read_ticks += SDL_GetPerformanceCounter() - readStart;
         return -1;
     }
 
+    int rc = 0;
     if (proto_find_free_subnode(PID_TYPE(pid), protoPtr) == -1) {
-        db_fclose(stream);
-        return -1;
-    }
-
-    if (proto_read_protoSubNode(*protoPtr, stream) != 0) {
-        db_fclose(stream);
-        return -1;
+        rc = -1;
+    } else if (proto_read_protoSubNode(*protoPtr, stream) != 0) {
+        rc = -1;
     }
 
     db_fclose(stream);
-    return 0;
+    proto_cache_read_ticks += SDL_GetPerformanceCounter() - readStart;
+    return rc;
 }
 
 // 0x490190
@@ -1680,6 +1701,8 @@ int proto_find_free_subnode(int type, Proto** protoPtr)
             newExtent->length = 0;
             newExtent->next = NULL;
 
+            proto_cache_stats.size += sizeof(ProtoListExtent);
+
             protoList->tail = newExtent;
             protoList->length++;
 
@@ -1696,6 +1719,8 @@ int proto_find_free_subnode(int type, Proto** protoPtr)
         protoListExtent->next = NULL;
         protoListExtent->length = 0;
 
+        proto_cache_stats.size += sizeof(ProtoListExtent);
+
         protoList->length = 1;
         protoList->tail = protoListExtent;
         protoList->head = protoListExtent;
@@ -1704,6 +1729,9 @@ int proto_find_free_subnode(int type, Proto** protoPtr)
     protoListExtent->proto[protoListExtent->length] = proto;
     protoListExtent->length++;
 
+    proto_cache_stats.entries++;
+    proto_cache_stats.size += (int)size;
+
     return 0;
 }
 
@@ -1728,6 +1756,131 @@ void proto_remove_all()
         protoList->head = NULL;
         protoList->tail = NULL;
         protoList->length = 0;
+
+        if (proto_index[type] != NULL) {
+            memset(proto_index[type], 0, sizeof(*proto_index[type]) * proto_index_size[type]);
+        }
+    }
+
+    proto_cache_stats.evictions += proto_cache_stats.entries;
+    proto_cache_stats.entries = 0;
+    proto_cache_stats.size = 0;
+
+    // CE: Preloaded protos survive map changes, but changes made to them
+    // do not.
+    for (int type = OBJ_TYPE_ITEM; type <= OBJ_TYPE_SCENERY; type++) {
+        if (proto_preloaded[type] != NULL) {
+            memcpy(proto_preloaded[type], proto_preloaded_pristine[type], proto_sizes[type] * proto_preloaded_count[type]);
+        }
+    }
+
+    proto_index_preloaded();
+
+    stat_cache_invalidate();
+}
+
+// CE: Reads every item, critter and scenery proto listed in .lst files into
+// one block per type, so they are not read again on demand or after map
+// changes. Protos which fail to load are left to `proto_ptr`.
+static void proto_preload()
+{
+    for (int type = OBJ_TYPE_ITEM; type <= OBJ_TYPE_SCENERY; type++) {
+        int count = proto_max_id(type) - 1;
+        if (count <= 0) {
+            continue;
+        }
+
+        char path[COMPAT_MAX_PATH];
+        proto_make_path(path, type << 24);
+        strcat(path, "\\");
+
+        char* name = path + strlen(path);
+        strcpy(name, art_dir(type));
+        strcat(name, ".lst");
+
+        DB_FILE* listStream = db_fopen(path, "rt");
+        if (listStream == NULL) {
+            continue;
+        }
+
+        size_t size = proto_sizes[type];
+        unsigned char* protos = (unsigned char*)mem_malloc(size * count);
+        if (protos == NULL) {
+            db_fclose(listStream);
+            continue;
+        }
+
+        // Slots with unexpected PID are treated as not loaded.
+        memset(protos, 0xFF, size * count);
+
+        proto_preloaded[type] = protos;
+        proto_preloaded_count[type] = count;
+
+        Uint64 readStart = SDL_GetPerformanceCounter();
+        int loaded = 0;
+
+        char string[256];
+        for (int index = 0; index < count && db_fgets(string, sizeof(string), listStream); index++) {
+            char* pch = strchr(string, ' ');
+            if (pch != NULL) {
+                *pch = '\0';
+            }
+
+            pch = strchr(string, '\n');
+            if (pch != NULL) {
+                *pch = '\0';
+            }
+
+            strcpy(name, string);
+
+            DB_FILE* stream = db_fopen(path, "rb");
+            if (stream == NULL) {
+                continue;
+            }
+
+            Proto* proto = (Proto*)(protos + size * index);
+            if (proto_read_protoSubNode(proto, stream) != 0 || proto->pid != ((type << 24) | (index + 1))) {
+                memset(proto, 0xFF, size);
+            } else {
+                loaded++;
+            }
+
+            db_fclose(stream);
+        }
+
+        db_fclose(listStream);
+
+        unsigned char* pristine = (unsigned char*)mem_malloc(size * count);
+        if (pristine == NULL) {
+            mem_free(protos);
+            proto_preloaded[type] = NULL;
+            proto_preloaded_count[type] = 0;
+            continue;
+        }
+
+        memcpy(pristine, protos, size * count);
+        proto_preloaded_pristine[type] = pristine;
+
+        proto_cache_stats.reads += loaded;
+        proto_cache_read_ticks += SDL_GetPerformanceCounter() - readStart;
+
+        debug_printf("\nPROTO: Preloaded %d of %d %s protos\n", loaded, count, art_dir(type));
+    }
+
+    proto_index_preloaded();
+}
+
+// CE: Adds preloaded protos to `proto_index`.
+static void proto_index_preloaded()
+{
+    for (int type = OBJ_TYPE_ITEM; type <= OBJ_TYPE_SCENERY; type++) {
+        size_t size = proto_sizes[type];
+        for (int index = 0; index < proto_preloaded_count[type]; index++) {
+            Proto* proto = (Proto*)(proto_preloaded[type] + size * index);
+            if (proto->pid != -1) {
+                proto_index_add(proto);
+            }
+        }
     }
 }
 
@@ -1745,6 +1898,16 @@ int proto_ptr(int pid, Proto** protoPtr)
         return 0;
     }
 
+    // CE: Every loaded proto is indexed, lists are only scanned when index
+    // could not grow.
+    int type = PID_TYPE(pid);
+    int id = pid & 0xFFFFFF;
+    if (type >= 0 && type < 6 && id < proto_index_size[type] && proto_index[type][id] != NULL) {
+        *protoPtr = proto_index[type][id];
+        proto_cache_stats.hits++;
+        return 0;
+    }
+
     ProtoList* protoList = &(protolists[PID_TYPE(pid)]);
     ProtoListExtent* protoListExtent = protoList->head;
     while (protoListExtent != NULL) {
@@ -1752,13 +1915,52 @@ int proto_ptr(int pid, Proto** protoPtr)
             Proto* proto = (Proto*)protoListExtent->proto[index];
             if (pid == proto->pid) {
                 *protoPtr = proto;
+                proto_cache_stats.hits++;
                 return 0;
             }
         }
         protoListExtent = protoListExtent->next;
     }
 
-    return proto_load_pid(pid, protoPtr);
+    proto_cache_stats.misses++;
+
+    if (proto_load_pid(pid, protoPtr) == -1) {
+        return -1;
+    }
+
+    proto_index_add(*protoPtr);
+
+    return 0;
+}
+
+// CE: Adds loaded proto to `proto_index`. Index of each type starts with
+// number of protos in the type's .lst and grows when mapper creates new
+// ones.
+static void proto_index_add(Proto* proto)
+{
+    int type = PID_TYPE(proto->pid);
+    int id = proto->pid & 0xFFFFFF;
+    if (type < 0 || type >= 6) {
+        return;
+    }
+
+    if (id >= proto_index_size[type]) {
+        int size = proto_index_size[type] != 0 ? proto_index_size[type] * 2 : proto_max_id(type) + 1;
+        if (size <= id) {
+            size = id + 1;
+        }
+
+        Proto** index = (Proto**)mem_realloc(proto_index[type], sizeof(*index) * size);
+        if (index == NULL) {
+            return;
+        }
+
+        memset(index + proto_index_size[type], 0, sizeof(*index) * (size - proto_index_size[type]));
+        proto_index[type] = index;
+        proto_index_size[type] = size;
+    }
+
+    proto_index[type][id] = proto;
 }
 
 // 0x490530
@@ -1779,6 +1981,21 @@ int proto_max_id(int a1)
     return protolists[a1].max_entries_num;
 }
 
+// CE: Reports proto lists in terms of cache stats. Protos are never locked
+// and lists are unbounded, they are only released with `proto_remove_all`.
+bool proto_get_cache_stats(CacheStats* stats)
+{
+    if (stats == NULL) {
+        return false;
+    }
+
+    *stats = proto_cache_stats;
+    stats->averageEntrySize = stats->entries != 0 ? stats->size / stats->entries : 0;
+    stats->readTime = (double)proto_cache_read_ticks * 1000.0 / (double)SDL_GetPerformanceFrequency();
+
+    return true;
+}
+
 // 0x490614
 int ResetPlayer()
 {
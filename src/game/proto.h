@@ -1,6 +1,7 @@
 #ifndef FALLOUT_GAME_PROTO_H_
 #define FALLOUT_GAME_PROTO_H_
 
+#include "game/cache.h"
 #include "game/message.h"
 #include "game/object_types.h"
 #include "game/perk_defs.h"
@@ -145,6 +146,7 @@ void proto_remove_all();
 int proto_ptr(int pid, Proto** out_proto);
 int proto_undo_new_id(int type);
 int proto_max_id(int a1);
+bool proto_get_cache_stats(CacheStats* stats);
 int ResetPlayer();
 
 } // namespace fallout
@@ -1,9 +1,13 @@
 #include "game/queue.h"
 
+#include <stdint.h>
+#include <stdlib.h>
+
 #include "game/actions.h"
 #include "game/critter.h"
 #include "game/display.h"
 #include "game/game.h"
+#include "game/gamectx.h"
 #include "game/gsound.h"
 #include "game/item.h"
 #include "game/map.h"
@@ -14,18 +18,80 @@
 #include "game/proto.h"
 #include "game/scripts.h"
 #include "plib/gnw/memory.h"
+#include "plib/gnw/prof.h"
 
 namespace fallout {
 
+// CE: Number of nodes allocated at once by `queue_node_alloc`.
+#define QUEUE_NODE_BLOCK_CAPACITY 128
+
+// CE: Number of buckets in owner index (must be power of two).
+#define QUEUE_OWNER_BUCKETS 1024
+
 typedef struct QueueListNode {
     // TODO: Make unsigned.
     int time;
     int type;
     Object* owner;
     void* data;
+
+    // CE: Insertion stamp, orders events with equal time the same way
+    // original sorted list did (first added is first processed).
+    unsigned long long seq;
+
+    // CE: Index in `QueueState::heap`, -1 when node is not scheduled.
+    int heapIndex;
+
+    // CE: Links in owner bucket (`next` also links free nodes).
+    struct QueueListNode* prev;
     struct QueueListNode* next;
 } QueueListNode;
 
+typedef struct QueueNodeBlock {
+    struct QueueNodeBlock* next;
+    QueueListNode nodes[QUEUE_NODE_BLOCK_CAPACITY];
+} QueueNodeBlock;
+
+// CE: Scheduled events of a game (see `GameContext`).
+typedef struct QueueState {
+    // Scheduled events as binary min-heap ordered by time, then insertion
+    // stamp (see `queue_node_less`). Replaces original sorted linked list.
+    //
+    // 0x662F4C
+    QueueListNode** heap;
+    int heapLength;
+    int heapCapacity;
+
+    // Scheduled events hashed by owner. With enough buckets every chain holds
+    // events of one or few objects, so per-object lookups do not walk queue.
+    QueueListNode* owners[QUEUE_OWNER_BUCKETS];
+
+    // Number of scheduled events by type.
+    int typeLengths[EVENT_TYPE_COUNT];
+
+    // Node pool.
+    QueueNodeBlock* blocks;
+    QueueListNode* freeNodes;
+
+    // Next insertion stamp.
+    unsigned long long seq;
+} QueueState;
+
+static QueueState* queue_state();
+static void queue_state_exit(void* data);
+
+static QueueListNode* queue_node_alloc();
+static void queue_node_free(QueueListNode* node);
+static bool queue_node_less(QueueListNode* a, QueueListNode* b);
+static int queue_node_compare(const void* a, const void* b);
+static void queue_heap_sift_up(int index);
+static void queue_heap_sift_down(int index);
+static int queue_heap_insert(QueueListNode* node);
+static void queue_heap_remove(QueueListNode* node);
+static int queue_owner_bucket(Object* owner);
+static void queue_unlink(QueueListNode* node);
+static void queue_discard(QueueListNode* node);
+static QueueListNode** queue_sorted(int eventType, QueueListNode* after, int* lengthPtr);
 static int queue_destroy(Object* obj, void* data);
 static int queue_explode(Object* obj, void* data);
 static int queue_explode_exit(Object* obj, void* data);
@@ -49,13 +115,54 @@ EventTypeDescription q_func[EVENT_TYPE_COUNT] = {
     { scr_map_q_process, NULL, NULL, NULL, true, NULL },
 };
 
-// 0x662F4C
-static QueueListNode* queue;
+static QueueState* queue_state()
+{
+    return (QueueState*)game_context_state(GAME_CONTEXT_SLOT_QUEUE, sizeof(QueueState), NULL, queue_state_exit);
+}
+
+// Releases events and pool of destroyed context. Zeroed state is the same as
+// after `queue_init`, so it needs no init proc.
+static void queue_state_exit(void* data)
+{
+    QueueState* state = (QueueState*)data;
+
+    for (int index = 0; index < state->heapLength; index++) {
+        QueueListNode* node = state->heap[index];
+        if (q_func[node->type].freeProc != NULL) {
+            q_func[node->type].freeProc(node->data);
+        }
+    }
+
+    while (state->blocks != NULL) {
+        QueueNodeBlock* next = state->blocks->next;
+        mem_free(state->blocks);
+        state->blocks = next;
+    }
+
+    if (state->heap != NULL) {
+        mem_free(state->heap);
+    }
+}
 
 // 0x490670
 void queue_init()
 {
-    queue = NULL;
+    QueueState* state = queue_state();
+
+    state->heap = NULL;
+    state->heapLength = 0;
+    state->heapCapacity = 0;
+    state->blocks = NULL;
+    state->freeNodes = NULL;
+    state->seq = 0;
+
+    for (int index = 0; index < QUEUE_OWNER_BUCKETS; index++) {
+        state->owners[index] = NULL;
+    }
+
+    for (int index = 0; index < EVENT_TYPE_COUNT; index++) {
+        state->typeLengths[index] = 0;
+    }
 }
 
 // 0x490680
@@ -68,7 +175,24 @@ int queue_reset()
 // 0x490680
 int queue_exit()
 {
+    QueueState* state = queue_state();
+
     queue_clear();
+
+    // CE: Release pool.
+    while (state->blocks != NULL) {
+        QueueNodeBlock* next = state->blocks->next;
+        mem_free(state->blocks);
+        state->blocks = next;
+    }
+    state->freeNodes = NULL;
+
+    if (state->heap != NULL) {
+        mem_free(state->heap);
+        state->heap = NULL;
+    }
+    state->heapCapacity = 0;
+
     return 0;
 }
 
@@ -80,33 +204,31 @@ int queue_load(DB_FILE* stream)
         return -1;
     }
 
-    queue = NULL;
-
-    QueueListNode** nextPtr = &queue;
-
+    // CE: Events are stored in processing order, so stamping them in file
+    // order preserves relative order of events with equal time.
     int rc = 0;
     for (int index = 0; index < count; index += 1) {
-        QueueListNode* queueListNode = (QueueListNode*)mem_malloc(sizeof(*queueListNode));
+        QueueListNode* queueListNode = queue_node_alloc();
         if (queueListNode == NULL) {
             rc = -1;
             break;
         }
 
         if (db_freadInt(stream, &(queueListNode->time)) == -1) {
-            mem_free(queueListNode);
+            queue_node_free(queueListNode);
             rc = -1;
             break;
         }
 
         if (db_freadInt(stream, &(queueListNode->type)) == -1) {
-            mem_free(queueListNode);
+            queue_node_free(queueListNode);
             rc = -1;
             break;
         }
 
         int objectId;
         if (db_freadInt(stream, &objectId) == -1) {
-            mem_free(queueListNode);
+            queue_node_free(queueListNode);
             rc = -1;
             break;
         }
@@ -130,7 +252,7 @@ int queue_load(DB_FILE* stream)
         EventTypeDescription* eventTypeDescription = &(q_func[queueListNode->type]);
         if (eventTypeDescription->readProc != NULL) {
             if (eventTypeDescription->readProc(stream, &(queueListNode->data)) == -1) {
-                mem_free(queueListNode);
+                queue_node_free(queueListNode);
                 rc = -1;
                 break;
             }
@@ -138,81 +260,80 @@ int queue_load(DB_FILE* stream)
             queueListNode->data = NULL;
         }
 
-        queueListNode->next = NULL;
-
-        *nextPtr = queueListNode;
-        nextPtr = &(queueListNode->next);
-    }
-
-    if (rc == -1) {
-        while (queue != NULL) {
-            QueueListNode* next = queue->next;
-
-            EventTypeDescription* eventTypeDescription = &(q_func[queue->type]);
+        if (queue_heap_insert(queueListNode) == -1) {
             if (eventTypeDescription->freeProc != NULL) {
-                eventTypeDescription->freeProc(queue->data);
+                eventTypeDescription->freeProc(queueListNode->data);
             }
-
-            mem_free(queue);
-
-            queue = next;
+            queue_node_free(queueListNode);
+            rc = -1;
+            break;
         }
     }
 
+    if (rc == -1) {
+        queue_clear();
+    }
+
     return rc;
 }
 
 // 0x4907F4
 int queue_save(DB_FILE* stream)
 {
-    QueueListNode* queueListNode;
+    QueueState* state = queue_state();
 
-    int count = 0;
-
-    queueListNode = queue;
-    while (queueListNode != NULL) {
-        count += 1;
-        queueListNode = queueListNode->next;
+    if (db_fwriteInt(stream, state->heapLength) == -1) {
+        return -1;
     }
 
-    if (db_fwriteInt(stream, count) == -1) {
+    // CE: Write events in processing order, as original list was.
+    int length;
+    QueueListNode** nodes = queue_sorted(-1, NULL, &length);
+    if (length != 0 && nodes == NULL) {
         return -1;
     }
 
-    queueListNode = queue;
-    while (queueListNode != NULL) {
+    int rc = 0;
+    for (int index = 0; index < length; index++) {
+        QueueListNode* queueListNode = nodes[index];
         Object* object = queueListNode->owner;
         int objectId = object != NULL ? object->id : -2;
 
         if (db_fwriteInt(stream, queueListNode->time) == -1) {
-            return -1;
+            rc = -1;
+            break;
         }
 
         if (db_fwriteInt(stream, queueListNode->type) == -1) {
-            return -1;
+            rc = -1;
+            break;
         }
 
         if (db_fwriteInt(stream, objectId) == -1) {
-            return -1;
+            rc = -1;
+            break;
         }
 
         EventTypeDescription* eventTypeDescription = &(q_func[queueListNode->type]);
         if (eventTypeDescription->writeProc != NULL) {
             if (eventTypeDescription->writeProc(stream, queueListNode->data) == -1) {
-                return -1;
+                rc = -1;
+                break;
             }
         }
+    }
 
-        queueListNode = queueListNode->next;
+    if (nodes != NULL) {
+        mem_free(nodes);
     }
 
-    return 0;
+    return rc;
 }
 
 // 0x4908A0
 int queue_add(int delay, Object* obj, void* data, int eventType)
 {
-    QueueListNode* newQueueListNode = (QueueListNode*)mem_malloc(sizeof(QueueListNode));
+    QueueListNode* newQueueListNode = queue_node_alloc();
     if (newQueueListNode == NULL) {
         return -1;
     }
@@ -224,53 +345,33 @@ int queue_add(int delay, Object* obj, void* data, int eventType)
     newQueueListNode->owner = obj;
     newQueueListNode->data = data;
 
-    if (obj != NULL) {
-        obj->flags |= OBJECT_USED;
+    if (queue_heap_insert(newQueueListNode) == -1) {
+        queue_node_free(newQueueListNode);
+        return -1;
     }
 
-    QueueListNode** v3 = &queue;
-
-    if (queue != NULL) {
-        QueueListNode* v4;
-
-        do {
-            v4 = *v3;
-            if (v2 < v4->time) {
-                break;
-            }
-            v3 = &(v4->next);
-        } while (v4->next != NULL);
+    if (obj != NULL) {
+        obj->flags |= OBJECT_USED;
     }
 
-    newQueueListNode->next = *v3;
-    *v3 = newQueueListNode;
-
     return 0;
 }
 
 // 0x490908
 int queue_remove(Object* owner)
 {
-    QueueListNode* queueListNode = queue;
-    QueueListNode** queueListNodePtr = &queue;
-
-    while (queueListNode) {
-        if (queueListNode->owner == owner) {
-            QueueListNode* temp = queueListNode;
+    QueueState* state = queue_state();
 
-            queueListNode = queueListNode->next;
-            *queueListNodePtr = queueListNode;
-
-            EventTypeDescription* eventTypeDescription = &(q_func[temp->type]);
-            if (eventTypeDescription->freeProc != NULL) {
-                eventTypeDescription->freeProc(temp->data);
-            }
+    QueueListNode* queueListNode = state->owners[queue_owner_bucket(owner)];
+    while (queueListNode != NULL) {
+        QueueListNode* next = queueListNode->next;
 
-            mem_free(temp);
-        } else {
-            queueListNodePtr = &(queueListNode->next);
-            queueListNode = queueListNode->next;
+        if (queueListNode->owner == owner) {
+            queue_unlink(queueListNode);
+            queue_discard(queueListNode);
         }
+
+        queueListNode = next;
     }
 
     return 0;
@@ -279,26 +380,22 @@ int queue_remove(Object* owner)
 // 0x490960
 int queue_remove_this(Object* owner, int eventType)
 {
-    QueueListNode* queueListNode = queue;
-    QueueListNode** queueListNodePtr = &queue;
-
-    while (queueListNode) {
-        if (queueListNode->owner == owner && queueListNode->type == eventType) {
-            QueueListNode* temp = queueListNode;
+    QueueState* state = queue_state();
 
-            queueListNode = queueListNode->next;
-            *queueListNodePtr = queueListNode;
+    if (state->typeLengths[eventType] == 0) {
+        return 0;
+    }
 
-            EventTypeDescription* eventTypeDescription = &(q_func[temp->type]);
-            if (eventTypeDescription->freeProc != NULL) {
-                eventTypeDescription->freeProc(temp->data);
-            }
+    QueueListNode* queueListNode = state->owners[queue_owner_bucket(owner)];
+    while (queueListNode != NULL) {
+        QueueListNode* next = queueListNode->next;
 
-            mem_free(temp);
-        } else {
-            queueListNodePtr = &(queueListNode->next);
-            queueListNode = queueListNode->next;
+        if (queueListNode->owner == owner && queueListNode->type == eventType) {
+            queue_unlink(queueListNode);
+            queue_discard(queueListNode);
         }
+
+        queueListNode = next;
     }
 
     return 0;
@@ -309,7 +406,13 @@ int queue_remove_this(Object* owner, int eventType)
 // 0x4909BC
 bool queue_find(Object* owner, int eventType)
 {
-    QueueListNode* queueListEvent = queue;
+    QueueState* state = queue_state();
+
+    if (state->typeLengths[eventType] == 0) {
+        return false;
+    }
+
+    QueueListNode* queueListEvent = state->owners[queue_owner_bucket(owner)];
     while (queueListEvent != NULL) {
         if (owner == queueListEvent->owner && eventType == queueListEvent->type) {
             return true;
@@ -324,16 +427,20 @@ bool queue_find(Object* owner, int eventType)
 // 0x4909E4
 int queue_process()
 {
+    ProfScope profScope(PROF_ZONE_QUEUE_PROCESS);
+
+    QueueState* state = queue_state();
+
     int time = game_time();
     int v1 = 0;
 
-    while (queue != NULL) {
-        QueueListNode* queueListNode = queue;
+    while (state->heapLength != 0) {
+        QueueListNode* queueListNode = state->heap[0];
         if (time < queueListNode->time || v1 != 0) {
             break;
         }
 
-        queue = queueListNode->next;
+        queue_unlink(queueListNode);
 
         EventTypeDescription* eventTypeDescription = &(q_func[queueListNode->type]);
         v1 = eventTypeDescription->handlerProc(queueListNode->owner, queueListNode->data);
@@ -342,7 +449,7 @@ int queue_process()
             eventTypeDescription->freeProc(queueListNode->data);
         }
 
-        mem_free(queueListNode);
+        queue_node_free(queueListNode);
     }
 
     return v1;
@@ -351,51 +458,84 @@ int queue_process()
 // 0x490A5C
 void queue_clear()
 {
-    QueueListNode* queueListNode = queue;
-    while (queueListNode != NULL) {
-        QueueListNode* next = queueListNode->next;
-
-        EventTypeDescription* eventTypeDescription = &(q_func[queueListNode->type]);
-        if (eventTypeDescription->freeProc != NULL) {
-            eventTypeDescription->freeProc(queueListNode->data);
-        }
+    QueueState* state = queue_state();
 
-        mem_free(queueListNode);
-
-        queueListNode = next;
+    while (state->heapLength != 0) {
+        QueueListNode* queueListNode = state->heap[state->heapLength - 1];
+        queue_unlink(queueListNode);
+        queue_discard(queueListNode);
     }
-
-    queue = NULL;
 }
 
 // 0x490AA4
 void queue_clear_type(int eventType, QueueEventHandler* fn)
 {
-    QueueListNode** ptr = &queue;
-    QueueListNode* curr = *ptr;
+    QueueState* state = queue_state();
+
+    // CE: Original code walked the list in order, unlinking each matching
+    // node while `fn` runs and relinking it in place when `fn` keeps it.
+    // Events `fn` schedules are visited when they sort after current one.
+    // Same visiting order is reproduced with sorted snapshots, which are
+    // rebuilt whenever `fn` adds events. Nodes `fn` removes are recognized
+    // by their stamp (pool memory is never released here).
+    QueueListNode last;
+    QueueListNode* after = NULL;
+
+    if (state->typeLengths[eventType] == 0) {
+        return;
+    }
 
-    while (curr != NULL) {
-        if (eventType == curr->type) {
-            QueueListNode* tmp = curr;
+    bool rebuild = true;
+    while (rebuild) {
+        rebuild = false;
+
+        int length;
+        QueueListNode** nodes = queue_sorted(eventType, after, &length);
+        if (nodes == NULL) {
+            break;
+        }
 
-            *ptr = curr->next;
-            curr = *ptr;
+        unsigned long long* seqs = (unsigned long long*)mem_malloc(sizeof(*seqs) * length);
+        if (seqs == NULL) {
+            mem_free(nodes);
+            break;
+        }
 
-            if (fn != NULL && fn(tmp->owner, tmp->data) != 1) {
-                *ptr = tmp;
-                ptr = &(tmp->next);
-            } else {
-                EventTypeDescription* eventTypeDescription = &(q_func[tmp->type]);
-                if (eventTypeDescription->freeProc != NULL) {
-                    eventTypeDescription->freeProc(tmp->data);
+        for (int index = 0; index < length; index++) {
+            seqs[index] = nodes[index]->seq;
+        }
+
+        for (int index = 0; index < length; index++) {
+            QueueListNode* curr = nodes[index];
+            if (curr->heapIndex == -1 || curr->seq != seqs[index]) {
+                // Removed by previous `fn`.
+                continue;
+            }
+
+            last.time = curr->time;
+            last.seq = curr->seq;
+            after = &last;
+
+            unsigned long long seq = state->seq;
+
+            queue_unlink(curr);
+
+            if (fn != NULL && fn(curr->owner, curr->data) != 1) {
+                if (queue_heap_insert(curr) == -1) {
+                    queue_discard(curr);
                 }
+            } else {
+                queue_discard(curr);
+            }
 
-                mem_free(tmp);
+            if (state->seq != seq) {
+                rebuild = true;
+                break;
             }
-        } else {
-            ptr = &(curr->next);
-            curr = *ptr;
         }
+
+        mem_free(seqs);
+        mem_free(nodes);
     }
 }
 
@@ -404,11 +544,284 @@ void queue_clear_type(int eventType, QueueEventHandler* fn)
 // 0x490B1C
 int queue_next_time()
 {
-    if (queue == NULL) {
+    QueueState* state = queue_state();
+
+    if (state->heapLength == 0) {
         return 0;
     }
 
-    return queue->time;
+    return state->heap[0]->time;
+}
+
+// CE: Fills `lengths` (`EVENT_TYPE_COUNT` entries, can be NULL) with number
+// of scheduled events of every type, returns total number of events.
+int queue_stats(int* lengths)
+{
+    QueueState* state = queue_state();
+
+    if (lengths != NULL) {
+        for (int index = 0; index < EVENT_TYPE_COUNT; index++) {
+            lengths[index] = state->typeLengths[index];
+        }
+    }
+
+    return state->heapLength;
+}
+
+// CE: Takes node from pool, growing it when needed.
+static QueueListNode* queue_node_alloc()
+{
+    QueueState* state = queue_state();
+
+    if (state->freeNodes == NULL) {
+        QueueNodeBlock* block = (QueueNodeBlock*)mem_malloc(sizeof(*block));
+        if (block == NULL) {
+            return NULL;
+        }
+
+        block->next = state->blocks;
+        state->blocks = block;
+
+        for (int index = QUEUE_NODE_BLOCK_CAPACITY - 1; index >= 0; index--) {
+            QueueListNode* node = &(block->nodes[index]);
+            node->heapIndex = -1;
+            node->seq = 0;
+            node->next = state->freeNodes;
+            state->freeNodes = node;
+        }
+    }
+
+    QueueListNode* node = state->freeNodes;
+    state->freeNodes = node->next;
+
+    node->heapIndex = -1;
+    node->prev = NULL;
+    node->next = NULL;
+    node->data = NULL;
+
+    return node;
+}
+
+// CE: Returns unscheduled node to pool.
+static void queue_node_free(QueueListNode* node)
+{
+    QueueState* state = queue_state();
+
+    node->heapIndex = -1;
+    node->next = state->freeNodes;
+    state->freeNodes = node;
+}
+
+static bool queue_node_less(QueueListNode* a, QueueListNode* b)
+{
+    if (a->time != b->time) {
+        return a->time < b->time;
+    }
+
+    return a->seq < b->seq;
+}
+
+static int queue_node_compare(const void* a, const void* b)
+{
+    QueueListNode* node1 = *(QueueListNode**)a;
+    QueueListNode* node2 = *(QueueListNode**)b;
+
+    if (queue_node_less(node1, node2)) {
+        return -1;
+    }
+
+    if (queue_node_less(node2, node1)) {
+        return 1;
+    }
+
+    return 0;
+}
+
+static void queue_heap_sift_up(int index)
+{
+    QueueState* state = queue_state();
+
+    QueueListNode* node = state->heap[index];
+    while (index > 0) {
+        int parent = (index - 1) / 2;
+        if (!queue_node_less(node, state->heap[parent])) {
+            break;
+        }
+
+        state->heap[index] = state->heap[parent];
+        state->heap[index]->heapIndex = index;
+        index = parent;
+    }
+
+    state->heap[index] = node;
+    node->heapIndex = index;
+}
+
+static void queue_heap_sift_down(int index)
+{
+    QueueState* state = queue_state();
+
+    QueueListNode* node = state->heap[index];
+    while (true) {
+        int child = index * 2 + 1;
+        if (child >= state->heapLength) {
+            break;
+        }
+
+        if (child + 1 < state->heapLength && queue_node_less(state->heap[child + 1], state->heap[child])) {
+            child++;
+        }
+
+        if (!queue_node_less(state->heap[child], node)) {
+            break;
+        }
+
+        state->heap[index] = state->heap[child];
+        state->heap[index]->heapIndex = index;
+        index = child;
+    }
+
+    state->heap[index] = node;
+    node->heapIndex = index;
+}
+
+// CE: Schedules node (its `time`, `type` and `owner` must be set). Nodes
+// without stamp get next one, rescheduled nodes keep their place.
+static int queue_heap_insert(QueueListNode* node)
+{
+    QueueState* state = queue_state();
+
+    if (state->heapLength == state->heapCapacity) {
+        int capacity = state->heapCapacity != 0 ? state->heapCapacity * 2 : QUEUE_NODE_BLOCK_CAPACITY;
+        QueueListNode** heap = (QueueListNode**)mem_realloc(state->heap, sizeof(*heap) * capacity);
+        if (heap == NULL) {
+            return -1;
+        }
+
+        state->heap = heap;
+        state->heapCapacity = capacity;
+    }
+
+    if (node->heapIndex != -2) {
+        node->seq = ++state->seq;
+    }
+
+    int index = state->heapLength++;
+    state->heap[index] = node;
+    queue_heap_sift_up(index);
+
+    int bucket = queue_owner_bucket(node->owner);
+    node->prev = NULL;
+    node->next = state->owners[bucket];
+    if (node->next != NULL) {
+        node->next->prev = node;
+    }
+    state->owners[bucket] = node;
+
+    state->typeLengths[node->type]++;
+
+    return 0;
+}
+
+static void queue_heap_remove(QueueListNode* node)
+{
+    QueueState* state = queue_state();
+
+    int index = node->heapIndex;
+    QueueListNode* last = state->heap[--state->heapLength];
+    if (last != node) {
+        state->heap[index] = last;
+        last->heapIndex = index;
+        queue_heap_sift_up(index);
+        queue_heap_sift_down(last->heapIndex);
+    }
+}
+
+static int queue_owner_bucket(Object* owner)
+{
+    uintptr_t value = (uintptr_t)owner;
+    value ^= value >> 9;
+    value ^= value >> 17;
+    return (int)((value >> 3) & (QUEUE_OWNER_BUCKETS - 1));
+}
+
+// CE: Removes node from heap and owner index. Node keeps its stamp, so it
+// can be rescheduled at the same place.
+static void queue_unlink(QueueListNode* node)
+{
+    QueueState* state = queue_state();
+
+    queue_heap_remove(node);
+
+    if (node->prev != NULL) {
+        node->prev->next = node->next;
+    } else {
+        state->owners[queue_owner_bucket(node->owner)] = node->next;
+    }
+
+    if (node->next != NULL) {
+        node->next->prev = node->prev;
+    }
+
+    node->prev = NULL;
+    node->next = NULL;
+    node->heapIndex = -2;
+
+    state->typeLengths[node->type]--;
+}
+
+// CE: Frees data of unlinked node and returns it to pool.
+static void queue_discard(QueueListNode* node)
+{
+    EventTypeDescription* eventTypeDescription = &(q_func[node->type]);
+    if (eventTypeDescription->freeProc != NULL) {
+        eventTypeDescription->freeProc(node->data);
+    }
+
+    queue_node_free(node);
+}
+
+// CE: Returns newly allocated array of scheduled nodes in processing order.
+// When `eventType` is not -1 only nodes of that type are included, when
+// `after` is not NULL only nodes that sort after it.
+static QueueListNode** queue_sorted(int eventType, QueueListNode* after, int* lengthPtr)
+{
+    QueueState* state = queue_state();
+
+    *lengthPtr = 0;
+
+    if (state->heapLength == 0) {
+        return NULL;
+    }
+
+    QueueListNode** nodes = (QueueListNode**)mem_malloc(sizeof(*nodes) * state->heapLength);
+    if (nodes == NULL) {
+        return NULL;
+    }
+
+    int length = 0;
+    for (int index = 0; index < state->heapLength; index++) {
+        QueueListNode* node = state->heap[index];
+        if (eventType != -1 && node->type != eventType) {
+            continue;
+        }
+
+        if (after != NULL && !queue_node_less(after, node)) {
+            continue;
+        }
+
+        nodes[length++] = node;
+    }
+
+    if (length == 0) {
+        mem_free(nodes);
+        return NULL;
+    }
+
+    qsort(nodes, length, sizeof(*nodes), queue_node_compare);
+
+    *lengthPtr = length;
+    return nodes;
 }
 
 // 0x490B30
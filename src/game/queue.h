@@ -78,6 +78,7 @@ int queue_process();
 void queue_clear();
 void queue_clear_type(int eventType, QueueEventHandler* fn);
 int queue_next_time();
+int queue_stats(int* lengths);
 void queue_leaving_map();
 
 } // namespace fallout
@@ -1,13 +1,17 @@
 #include "game/roll.h"
 
 #include <limits.h>
+#include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include <random>
 
+#include "game/gconfig.h"
 #include "game/scripts.h"
 #include "platform_compat.h"
 #include "plib/gnw/debug.h"
+#include "plib/gnw/svga.h"
 
 namespace fallout {
 
@@ -17,6 +21,10 @@ static int random_seed();
 static void seed_generator(int seed);
 static unsigned int timer_read();
 static void check_chi_squared();
+static int roll_check_critical_stream(int stream, int delta, int criticalSuccessModifier);
+static uint64_t splitmix64(uint64_t* state);
+static uint64_t xoshiro_next(uint64_t* state);
+static unsigned int xoshiro_range(uint64_t* state, unsigned int max);
 
 // 0x507834
 static int iy = 0;
@@ -27,13 +35,41 @@ static int iv[32];
 // 0x662FD0
 static int idum;
 
+// CE: Generator used by all rolls, see `roll_set_generator`.
+static int roll_generator = ROLL_GENERATOR_LEGACY;
+
+// CE: xoshiro256** state of every stream.
+static uint64_t roll_streams[ROLL_STREAM_COUNT][4];
+
+// CE: Seed given by `roll_seed_streams` (or config). When set, reseeding
+// with -1 (at new game) repeats it instead of taking time-based one.
+static bool roll_seed_fixed = false;
+static unsigned long long roll_fixed_seed = 0;
+
 // 0x4913F0
 void roll_init()
 {
     // NOTE: Uninline.
     init_random();
 
-    check_chi_squared();
+    // CE: Generator and seed from [system] section.
+    char* generator;
+    if (config_get_string(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_RNG_KEY, &generator)
+        && compat_stricmp(generator, "xoshiro") == 0) {
+        roll_set_generator(ROLL_GENERATOR_XOSHIRO);
+    }
+
+    int seed;
+    if (config_get_value(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_RNG_SEED_KEY, &seed) && seed != 0) {
+        roll_seed_streams((unsigned int)seed);
+    }
+
+    // CE: Self-test only prints to debug log, it is not worth startup time
+    // of headless runs (and it advances legacy sequence, so it is skipped
+    // with fixed seed too).
+    if (!svga_is_headless() && !roll_seed_fixed) {
+        check_chi_squared();
+    }
 }
 
 // 0x49140C
@@ -65,8 +101,14 @@ int roll_load(DB_FILE* stream)
 // 0x491410
 int roll_check(int difficulty, int criticalSuccessModifier, int* howMuchPtr)
 {
-    int delta = difficulty - roll_random(1, 100);
-    int result = roll_check_critical(delta, criticalSuccessModifier);
+    return roll_check_stream(ROLL_STREAM_GENERAL, difficulty, criticalSuccessModifier, howMuchPtr);
+}
+
+// CE: Same as `roll_check`, but takes numbers from given stream.
+int roll_check_stream(int stream, int difficulty, int criticalSuccessModifier, int* howMuchPtr)
+{
+    int delta = difficulty - roll_random_stream(stream, 1, 100);
+    int result = roll_check_critical_stream(stream, delta, criticalSuccessModifier);
 
     if (howMuchPtr != NULL) {
         *howMuchPtr = delta;
@@ -80,6 +122,11 @@ int roll_check(int difficulty, int criticalSuccessModifier, int* howMuchPtr)
 //
 // 0x491440
 int roll_check_critical(int delta, int criticalSuccessModifier)
+{
+    return roll_check_critical_stream(ROLL_STREAM_GENERAL, delta, criticalSuccessModifier);
+}
+
+static int roll_check_critical_stream(int stream, int delta, int criticalSuccessModifier)
 {
     int gameTime = game_time();
 
@@ -89,7 +136,7 @@ int roll_check_critical(int delta, int criticalSuccessModifier)
 
         if ((gameTime / GAME_TIME_TICKS_PER_DAY) >= 1) {
             // 10% to become critical failure.
-            if (roll_random(1, 100) <= -delta / 10) {
+            if (roll_random_stream(stream, 1, 100) <= -delta / 10) {
                 roll = ROLL_CRITICAL_FAILURE;
             }
         }
@@ -98,7 +145,7 @@ int roll_check_critical(int delta, int criticalSuccessModifier)
 
         if ((gameTime / GAME_TIME_TICKS_PER_DAY) >= 1) {
             // 10% + modifier to become critical success.
-            if (roll_random(1, 100) <= delta / 10 + criticalSuccessModifier) {
+            if (roll_random_stream(stream, 1, 100) <= delta / 10 + criticalSuccessModifier) {
                 roll = ROLL_CRITICAL_SUCCESS;
             }
         }
@@ -109,13 +156,28 @@ int roll_check_critical(int delta, int criticalSuccessModifier)
 
 // 0x4914D0
 int roll_random(int min, int max)
+{
+    return roll_random_stream(ROLL_STREAM_GENERAL, min, max);
+}
+
+// CE: Returns random number in [min, max] (bounds can be swapped) taken from
+// given stream.
+int roll_random_stream(int stream, int min, int max)
 {
     int result;
 
-    if (min <= max) {
-        result = min + ran1(max - min + 1);
+    if (roll_generator == ROLL_GENERATOR_XOSHIRO && stream >= 0 && stream < ROLL_STREAM_COUNT) {
+        if (min <= max) {
+            result = min + (int)xoshiro_range(roll_streams[stream], (unsigned int)(max - min) + 1);
+        } else {
+            result = max + (int)xoshiro_range(roll_streams[stream], (unsigned int)(min - max) + 1);
+        }
     } else {
-        result = max + ran1(min - max + 1);
+        if (min <= max) {
+            result = min + ran1(max - min + 1);
+        } else {
+            result = max + ran1(min - max + 1);
+        }
     }
 
     if (result < min || result > max) {
@@ -152,18 +214,70 @@ static int ran1(int max)
 static void init_random()
 {
     std::srand(timer_read());
-    seed_generator(random_seed());
+
+    // CE: Seeds streams too.
+    roll_set_seed(random_seed());
 }
 
 // 0x4915B0
 void roll_set_seed(int seed)
 {
     if (seed == -1) {
+        if (roll_seed_fixed) {
+            roll_seed_streams(roll_fixed_seed);
+            return;
+        }
+
         // NOTE: Uninline.
         seed = random_seed();
     }
 
     seed_generator(seed);
+
+    // CE: Streams follow legacy seeding, so fixed legacy seeds (e.g. in
+    // demo mode) are fixed for new generator too.
+    uint64_t state = (unsigned int)seed;
+    for (int stream = 0; stream < ROLL_STREAM_COUNT; stream++) {
+        for (int index = 0; index < 4; index++) {
+            roll_streams[stream][index] = splitmix64(&state);
+        }
+    }
+}
+
+// CE: Selects generator. Legacy one keeps original sequences (e.g. for
+// replaying old recordings), xoshiro gives independent streams.
+void roll_set_generator(int generator)
+{
+    if (generator != ROLL_GENERATOR_LEGACY && generator != ROLL_GENERATOR_XOSHIRO) {
+        return;
+    }
+
+    roll_generator = generator;
+}
+
+int roll_get_generator()
+{
+    return roll_generator;
+}
+
+// CE: Seeds every stream (and legacy generator) from `seed`, used by
+// external controllers to reproduce runs. Seed is remembered, so starting
+// new game restarts the same sequences.
+void roll_seed_streams(unsigned long long seed)
+{
+    roll_seed_fixed = true;
+    roll_fixed_seed = seed;
+
+    uint64_t state = seed;
+
+    // Legacy generator takes 31-bit positive seeds.
+    seed_generator((int)(splitmix64(&state) & INT_MAX));
+
+    for (int stream = 0; stream < ROLL_STREAM_COUNT; stream++) {
+        for (int index = 0; index < 4; index++) {
+            roll_streams[stream][index] = splitmix64(&state);
+        }
+    }
 }
 
 // 0x4915D4
@@ -238,4 +352,57 @@ static void check_chi_squared()
     }
 }
 
+// CE: Used to expand seeds into xoshiro states (as recommended by its
+// authors, so that similar seeds give unrelated states).
+static uint64_t splitmix64(uint64_t* state)
+{
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static inline uint64_t xoshiro_rotl(uint64_t value, int shift)
+{
+    return (value << shift) | (value >> (64 - shift));
+}
+
+// CE: xoshiro256** by Blackman and Vigna.
+static uint64_t xoshiro_next(uint64_t* state)
+{
+    uint64_t result = xoshiro_rotl(state[1] * 5, 7) * 9;
+    uint64_t t = state[1] << 17;
+
+    state[2] ^= state[0];
+    state[3] ^= state[1];
+    state[1] ^= state[2];
+    state[0] ^= state[3];
+
+    state[2] ^= t;
+    state[3] = xoshiro_rotl(state[3], 45);
+
+    return result;
+}
+
+// CE: Returns unbiased number in [0, max) (Lemire's multiply-shift with
+// rejection, which is rarely taken for small ranges used by rolls).
+static unsigned int xoshiro_range(uint64_t* state, unsigned int max)
+{
+    if (max == 0) {
+        return 0;
+    }
+
+    uint64_t product = (xoshiro_next(state) >> 32) * max;
+    uint32_t low = (uint32_t)product;
+    if (low < max) {
+        uint32_t threshold = (uint32_t)(-max) % max;
+        while (low < threshold) {
+            product = (xoshiro_next(state) >> 32) * max;
+            low = (uint32_t)product;
+        }
+    }
+
+    return (unsigned int)(product >> 32);
+}
+
 } // namespace fallout
@@ -12,6 +12,27 @@ typedef enum Roll {
     ROLL_CRITICAL_SUCCESS,
 } Roll;
 
+// CE: Independent sequences of random numbers, so that rolls of one kind do
+// not shift outcomes of another (e.g. extra idle animation does not change
+// next hit roll). With legacy generator all streams share one sequence.
+typedef enum RollStream {
+    ROLL_STREAM_GENERAL,
+    ROLL_STREAM_COMBAT,
+    ROLL_STREAM_AI,
+    ROLL_STREAM_ENCOUNTER,
+    ROLL_STREAM_COSMETIC,
+    ROLL_STREAM_COUNT,
+} RollStream;
+
+typedef enum RollGenerator {
+    // Original generator (Park-Miller with Bays-Durham shuffle), one
+    // sequence for everything.
+    ROLL_GENERATOR_LEGACY,
+
+    // xoshiro256**, one sequence per stream.
+    ROLL_GENERATOR_XOSHIRO,
+} RollGenerator;
+
 void roll_init();
 int roll_reset();
 int roll_exit();
@@ -21,6 +42,11 @@ int roll_check(int difficulty, int criticalSuccessModifier, int* howMuchPtr);
 int roll_check_critical(int delta, int criticalSuccessModifier);
 int roll_random(int min, int max);
 void roll_set_seed(int seed);
+int roll_random_stream(int stream, int min, int max);
+int roll_check_stream(int stream, int difficulty, int criticalSuccessModifier, int* howMuchPtr);
+void roll_set_generator(int generator);
+int roll_get_generator();
+void roll_seed_streams(unsigned long long seed);
 
 } // namespace fallout
 
@@ -0,0 +1,313 @@
+#include "game/rollout.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <chrono>
+#include <vector>
+
+#include <SDL.h>
+
+#if !defined(_WIN32) && !defined(__EMSCRIPTEN__) && !(__APPLE__ && TARGET_OS_IOS)
+#define ROLLOUT_HAVE_FORK
+#include <errno.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#include "audio_engine.h"
+#include "game/loadsave.h"
+#include "game/sfxcache.h"
+#include "int/sound.h"
+#include "plib/db/db.h"
+#include "plib/gnw/debug.h"
+#include "plib/gnw/jobs.h"
+#include "plib/gnw/memory.h"
+#include "plib/gnw/svga.h"
+
+namespace fallout {
+
+#ifdef ROLLOUT_HAVE_FORK
+
+// Message sent by worker through its pipe.
+typedef struct RolloutMessage {
+    int result;
+    unsigned long long size;
+} RolloutMessage;
+
+typedef struct RolloutWorker {
+    pid_t pid;
+    int fd;
+    std::chrono::steady_clock::time_point start;
+} RolloutWorker;
+
+static void rollout_quiesce();
+static void rollout_resume();
+static void rollout_worker_main(int worker, int fd, RolloutProc* proc, void* userData, bool captureState);
+static bool rollout_write_all(int fd, const void* data, size_t size);
+static bool rollout_read_all(int fd, void* data, size_t size);
+static void rollout_collect(RolloutWorker* worker, RolloutResult* result);
+
+#endif
+
+// Forking is only safe without audio device (its thread does not survive
+// `fork`) and without window. WAV capture backend is not allowed either,
+// workers would keep mixing into capture file they share with parent.
+bool rollout_is_available()
+{
+#ifdef ROLLOUT_HAVE_FORK
+    int backend = audioEngineGetActiveBackend();
+    return svga_is_headless()
+        && SDL_WasInit(SDL_INIT_AUDIO) == 0
+        && (backend == -1 || backend == AUDIO_ENGINE_BACKEND_NULL);
+#else
+    return false;
+#endif
+}
+
+// Forks [count] worker processes sharing current game state copy-on-write.
+// Every worker runs [proc] and reports its return value (and state when
+// [captureState] is set) into [results]. Blocks until every worker is done.
+// Returns number of workers which reported, or -1 if rollouts are not
+// available.
+int rollout_run(int count, RolloutProc* proc, void* userData, bool captureState, RolloutResult* results)
+{
+    if (count <= 0 || proc == NULL || results == NULL) {
+        return -1;
+    }
+
+    if (!rollout_is_available()) {
+        debug_printf("rollout: requires headless mode with audio disabled\n");
+        return -1;
+    }
+
+#ifdef ROLLOUT_HAVE_FORK
+    for (int index = 0; index < count; index++) {
+        results[index].status = -1;
+        results[index].result = 0;
+        results[index].snapshot = NULL;
+        results[index].time = 0.0;
+    }
+
+    rollout_quiesce();
+
+    std::vector<RolloutWorker> workers(count);
+    for (int index = 0; index < count; index++) {
+        RolloutWorker* worker = &(workers[index]);
+        worker->pid = -1;
+        worker->fd = -1;
+
+        int fds[2];
+        if (pipe(fds) != 0) {
+            continue;
+        }
+
+        worker->start = std::chrono::steady_clock::now();
+
+        pid_t pid = fork();
+        if (pid == 0) {
+            // Pipes of previously started workers belong to parent.
+            for (int other = 0; other < index; other++) {
+                if (workers[other].fd != -1) {
+                    close(workers[other].fd);
+                }
+            }
+
+            close(fds[0]);
+            rollout_worker_main(index, fds[1], proc, userData, captureState);
+        }
+
+        close(fds[1]);
+
+        if (pid == -1) {
+            close(fds[0]);
+            continue;
+        }
+
+        worker->pid = pid;
+        worker->fd = fds[0];
+    }
+
+    // Workers block once their pipe is full, reading pipes one at a time
+    // only delays them until their turn.
+    int reported = 0;
+    for (int index = 0; index < count; index++) {
+        if (workers[index].pid == -1) {
+            continue;
+        }
+
+        rollout_collect(&(workers[index]), &(results[index]));
+        if (results[index].status == 0) {
+            reported++;
+        }
+    }
+
+    rollout_resume();
+
+    return reported;
+#else
+    return -1;
+#endif
+}
+
+void rollout_free_results(RolloutResult* results, int count)
+{
+    if (results == NULL) {
+        return;
+    }
+
+    for (int index = 0; index < count; index++) {
+        if (results[index].snapshot != NULL) {
+            agentLoadSaveFreeSnapshot(results[index].snapshot);
+            results[index].snapshot = NULL;
+        }
+    }
+}
+
+#ifdef ROLLOUT_HAVE_FORK
+
+// Stops every thread engine can have running, only calling thread survives
+// `fork`.
+static void rollout_quiesce()
+{
+    LoadSaveWaitAsync();
+    db_prefetch_quiesce();
+    jobs_suspend();
+
+    // Decode workers are restarted on demand in workers (and by
+    // `rollout_resume` in parent).
+    sfxc_decode_suspend();
+    soundDecodeSuspend();
+
+    // Buffered output would be written by every process otherwise.
+    fflush(NULL);
+}
+
+static void rollout_resume()
+{
+    soundDecodeResume();
+    sfxc_decode_resume();
+    jobs_resume();
+}
+
+static void rollout_worker_main(int worker, int fd, RolloutProc* proc, void* userData, bool captureState)
+{
+    signal(SIGPIPE, SIG_IGN);
+
+    int rc = 1;
+    if (db_reopen_datafiles() == 0) {
+        RolloutMessage message;
+        message.result = proc(worker, userData);
+        message.size = 0;
+
+        unsigned char* data = NULL;
+        if (captureState) {
+            LoadSaveSnapshot* snapshot = agentLoadSaveSnapshot();
+            if (snapshot != NULL) {
+                size_t size;
+                data = agentLoadSaveSerializeSnapshot(snapshot, &size);
+                if (data != NULL) {
+                    message.size = size;
+                }
+                agentLoadSaveFreeSnapshot(snapshot);
+            }
+        }
+
+        if (rollout_write_all(fd, &message, sizeof(message))
+            && (message.size == 0 || rollout_write_all(fd, data, (size_t)message.size))) {
+            rc = 0;
+        }
+
+        if (data != NULL) {
+            mem_free(data);
+        }
+    }
+
+    close(fd);
+    fflush(NULL);
+
+    // Skip exit handlers, they belong to parent.
+    _exit(rc);
+}
+
+static bool rollout_write_all(int fd, const void* data, size_t size)
+{
+    const unsigned char* pos = (const unsigned char*)data;
+    while (size != 0) {
+        ssize_t written = write(fd, pos, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+
+        pos += written;
+        size -= (size_t)written;
+    }
+
+    return true;
+}
+
+static bool rollout_read_all(int fd, void* data, size_t size)
+{
+    unsigned char* pos = (unsigned char*)data;
+    while (size != 0) {
+        ssize_t bytesRead = read(fd, pos, size);
+        if (bytesRead < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+
+        if (bytesRead == 0) {
+            return false;
+        }
+
+        pos += bytesRead;
+        size -= (size_t)bytesRead;
+    }
+
+    return true;
+}
+
+static void rollout_collect(RolloutWorker* worker, RolloutResult* result)
+{
+    RolloutMessage message;
+    bool received = rollout_read_all(worker->fd, &message, sizeof(message));
+
+    std::vector<unsigned char> data;
+    if (received && message.size != 0) {
+        data.resize((size_t)message.size);
+        received = rollout_read_all(worker->fd, data.data(), data.size());
+    }
+
+    close(worker->fd);
+    worker->fd = -1;
+
+    int status;
+    pid_t pid;
+    do {
+        pid = waitpid(worker->pid, &status, 0);
+    } while (pid == -1 && errno == EINTR);
+
+    result->time = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - worker->start).count();
+
+    if (!received || pid == -1 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        debug_printf("rollout: worker process %d failed\n", (int)worker->pid);
+        return;
+    }
+
+    result->status = 0;
+    result->result = message.result;
+
+    if (!data.empty()) {
+        result->snapshot = agentLoadSaveDeserializeSnapshot(data.data(), data.size());
+    }
+}
+
+#endif
+
+} // namespace fallout
@@ -0,0 +1,34 @@
+#ifndef FALLOUT_GAME_ROLLOUT_H_
+#define FALLOUT_GAME_ROLLOUT_H_
+
+#include <stddef.h>
+
+#include "game/loadsave.h"
+
+namespace fallout {
+
+// Applies command sequence of given worker to game state inherited from
+// parent. Return value is reported to parent as `RolloutResult::result`.
+typedef int RolloutProc(int worker, void* userData);
+
+typedef struct RolloutResult {
+    // 0 - worker finished and reported its result, -1 - worker could not be
+    // started or crashed.
+    int status;
+    int result;
+
+    // State of worker after it finished (`NULL` unless requested), to be
+    // released with `agentLoadSaveFreeSnapshot`.
+    LoadSaveSnapshot* snapshot;
+
+    // Time from fork until result was received (in ms).
+    double time;
+} RolloutResult;
+
+bool rollout_is_available();
+int rollout_run(int count, RolloutProc* proc, void* userData, bool captureState, RolloutResult* results);
+void rollout_free_results(RolloutResult* results, int count);
+
+} // namespace fallout
+
+#endif /* FALLOUT_GAME_ROLLOUT_H_ */
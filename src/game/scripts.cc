@@ -1,10 +1,16 @@
 #include "game/scripts.h"
 
+#include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
 
+#include <algorithm>
+#include <chrono>
+#include <unordered_map>
+#include <vector>
+
 #include "game/actions.h"
 #include "game/automap.h"
 #include "game/combat.h"
@@ -12,9 +18,12 @@
 #include "game/elevator.h"
 #include "game/endgame.h"
 #include "game/game.h"
+#include "game/gconfig.h"
 #include "game/gdialog.h"
 #include "game/gmouse.h"
 #include "game/gmovie.h"
+#include "game/mapmem.h"
+#include "game/mapstat.h"
 #include "game/object.h"
 #include "game/protinst.h"
 #include "game/proto.h"
@@ -30,6 +39,7 @@
 #include "plib/gnw/input.h"
 #include "plib/gnw/intrface.h"
 #include "plib/gnw/memory.h"
+#include "plib/gnw/prof.h"
 
 namespace fallout {
 
@@ -41,6 +51,10 @@ namespace fallout {
 
 #define SCRIPT_LIST_EXTENT_SIZE 16
 
+// CE: Spatial scripts with radius above this are not rasterized into
+// `scr_spatial_grid`, they are tested on every step instead.
+#define SCRIPT_SPATIAL_GRID_MAX_RADIUS 16
+
 typedef struct ScriptListExtent {
     Script scripts[SCRIPT_LIST_EXTENT_SIZE];
     // Number of scripts in the extent
@@ -56,6 +70,12 @@ typedef struct ScriptList {
     int nextScriptId;
 } ScriptList;
 
+// CE: Area registered in `scr_spatial_grid` for a spatial script.
+typedef struct ScriptSpatialCoverage {
+    int builtTile;
+    int radius;
+} ScriptSpatialCoverage;
+
 typedef struct ScriptState {
     unsigned int requests;
     STRUCT_664980 combatState1;
@@ -74,6 +94,8 @@ typedef struct ScriptState {
 
 static void doBkProcesses();
 static void script_chk_critters();
+static void script_chk_critters_budgeted();
+static void scr_critters_rebuild();
 static void script_chk_timed_events();
 static int scr_build_lookup_table(Script* scr);
 static int scr_index_to_name(int scriptIndex, char* name, size_t size);
@@ -84,6 +106,16 @@ static int scr_read_ScriptSubNode(Script* scr, DB_FILE* stream);
 static int scr_read_ScriptNode(ScriptListExtent* a1, DB_FILE* stream);
 static int scr_new_id(int scriptType);
 static void scrExecMapProcScripts(int a1);
+static void scr_index_invalidate(int scriptType);
+static void scr_index_rebuild(int scriptType);
+static bool scr_spatial_cells(const ScriptSpatialCoverage* coverage, std::vector<int>& cells);
+static void scr_spatial_register(int sid, int builtTile, int radius);
+static void scr_spatial_unregister(int sid);
+static void scr_spatial_invalidate();
+static void scr_spatial_positions_rebuild();
+static void scr_spatial_sort_candidates();
+static void scr_spatial_rebuild();
+static void scr_handlers_rebuild();
 
 // Number of lines in scripts.lst
 //
@@ -105,6 +137,72 @@ static bool scrSpatialsEnabled = true;
 // 0x507860
 static ScriptList scriptlists[SCRIPT_TYPE_COUNT];
 
+// CE: Pool of script list extents, see `MapMemPool`.
+static MapMemPool scr_extent_pool = MAPMEM_POOL_INIT(MAPMEM_SCRIPTS, sizeof(ScriptListExtent), 32);
+
+// CE: Maps sid to script for every script in the corresponding list. Scripts
+// are relocated by `scr_remove` and `scr_save`, so entries are kept in sync
+// there; lists rebuilt wholesale (loading) only mark their index as stale and
+// it is rebuilt on next lookup.
+static std::unordered_map<int, Script*> scr_index[SCRIPT_TYPE_COUNT];
+
+// CE: Stale flags for `scr_index`.
+static bool scr_index_stale[SCRIPT_TYPE_COUNT];
+
+// CE: Maps built tile (tile and elevation) to sids of spatial scripts whose
+// trigger area contains it, in registration order.
+static std::unordered_map<int, std::vector<int>> scr_spatial_grid;
+
+// CE: Sids of spatial scripts too wide to be rasterized, per elevation.
+static std::vector<int> scr_spatial_wide[ELEVATION_COUNT];
+
+// CE: Areas registered in `scr_spatial_grid` and `scr_spatial_wide` by sid.
+static std::unordered_map<int, ScriptSpatialCoverage> scr_spatial_coverage;
+
+// CE: Set when spatial script list was replaced and the grid needs to be
+// rebuilt on next step.
+static bool scr_spatial_grid_stale = false;
+
+// CE: Sids of critter scripts in list order, walked round-robin by
+// `script_chk_critters_budgeted`.
+static std::vector<int> scr_critter_sids;
+
+// CE: Set when critter script list changed and `scr_critter_sids` needs to
+// be rebuilt.
+static bool scr_critter_sids_stale = true;
+
+// CE: Position of next critter script in `scr_critter_sids`.
+static size_t scr_critter_cursor = 0;
+
+// CE: Estimated `critter_p_proc` cost by sid (in microseconds).
+static std::unordered_map<int, double> scr_critter_costs;
+
+// CE: Time budget for `critter_p_proc`s per tick (in microseconds). When 0,
+// exactly one critter script is processed per tick as in original code.
+static int scr_critter_budget = 0;
+
+// CE: Sids of scripts with `map_enter_p_proc` and `map_update_p_proc` in
+// list order, rebuilt when stale.
+static std::vector<int> scr_map_enter_sids;
+static std::vector<int> scr_map_update_sids;
+
+// CE: Set when script lists or their procedures changed and handler lists
+// need to be rebuilt.
+static bool scr_handlers_stale = true;
+
+// CE: Candidates collected by `scr_chk_spatials_in`. Triggered scripts can
+// change the grid, so candidates are copied before execution.
+static std::vector<int> scr_spatial_candidates;
+
+// CE: Position of spatial scripts in spatial script list by sid. Candidates
+// are sorted by it so procs fire in the same order as list walk in original
+// code.
+static std::unordered_map<int, int> scr_spatial_positions;
+
+// CE: Set when spatial scripts were relocated within the list and
+// `scr_spatial_positions` needs to be rebuilt.
+static bool scr_spatial_positions_stale = true;
+
 // 0x5078B0
 static char script_path_base[] = "scripts\\";
 
@@ -117,6 +215,9 @@ static int script_engine_run_critters = 0;
 // 0x5078BC
 static int script_engine_game_mode = 0;
 
+// 0x51C7E0
+static int scr_timed_events_last_time = 0;
+
 // Game time in ticks (1/10 second).
 //
 // 0x5078C0
@@ -283,6 +384,47 @@ void inc_game_time_in_seconds(int inc)
     inc_game_time(inc * 10);
 }
 
+// CE: Advances game time up to `time` processing due events (including
+// `gtime_q_process` midnight work) in order, without refreshing UI in
+// between.
+//
+// Returns 0 when `time` is reached, 1 when stopped early by event handler
+// or by pending script request (game time is left at that event), -1 when
+// user wants to quit.
+int gtime_skip(int time)
+{
+    while (true) {
+        if (game_user_wants_to_quit != 0) {
+            return -1;
+        }
+
+        if (scriptState.requests != 0) {
+            return 1;
+        }
+
+        if (queue_stats(NULL) == 0) {
+            break;
+        }
+
+        int nextEventTime = queue_next_time();
+        if (nextEventTime > time) {
+            break;
+        }
+
+        if (nextEventTime > fallout_game_time) {
+            set_game_time(nextEventTime);
+        }
+
+        if (queue_process() != 0) {
+            return 1;
+        }
+    }
+
+    set_game_time(time);
+
+    return 0;
+}
+
 // 0x491900
 int gtime_q_add()
 {
@@ -587,6 +729,12 @@ static void script_chk_critters()
     // 0x51C7DC
     static int count = 0;
 
+    // CE: Process as many critter scripts as fit the configured budget.
+    if (scr_critter_budget > 0) {
+        script_chk_critters_budgeted();
+        return;
+    }
+
     if (!dialog_active() && !isInCombat()) {
         ScriptList* scriptList;
         ScriptListExtent* scriptListExtent;
@@ -625,14 +773,105 @@ static void script_chk_critters()
     }
 }
 
+// CE: Runs critter scripts round-robin until time budget is spent. Cost of
+// every script is tracked as moving average and the pass stops before a
+// script which is not expected to fit, so it's first in the next tick. At
+// least one script runs per tick and no script runs twice in the same tick.
+static void script_chk_critters_budgeted()
+{
+    if (dialog_active() || isInCombat()) {
+        return;
+    }
+
+    if (scr_critter_sids_stale) {
+        scr_critters_rebuild();
+    }
+
+    size_t remaining = scr_critter_sids.size();
+    if (remaining == 0) {
+        return;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    double elapsed = 0.0;
+    bool ran = false;
+
+    while (remaining != 0) {
+        if (scr_critter_cursor >= scr_critter_sids.size()) {
+            scr_critter_cursor = 0;
+        }
+
+        int sid = scr_critter_sids[scr_critter_cursor];
+
+        auto it = scr_critter_costs.find(sid);
+        bool known = it != scr_critter_costs.end();
+        double estimate = known ? it->second : 0.0;
+        if (ran && elapsed + estimate > (double)scr_critter_budget) {
+            break;
+        }
+
+        scr_critter_cursor++;
+        remaining--;
+        ran = true;
+
+        auto procStart = std::chrono::steady_clock::now();
+        exec_script_proc(sid, SCRIPT_PROC_CRITTER);
+        auto procEnd = std::chrono::steady_clock::now();
+
+        double cost = std::chrono::duration<double, std::micro>(procEnd - procStart).count();
+        if (known) {
+            scr_critter_costs[sid] = estimate * 0.75 + cost * 0.25;
+        } else {
+            scr_critter_costs[sid] = cost;
+        }
+
+        elapsed = std::chrono::duration<double, std::micro>(procEnd - start).count();
+
+        if (scr_critter_sids_stale) {
+            // Critters were added or removed, keep position approximately and
+            // do not visit more scripts than were runnable at start.
+            scr_critters_rebuild();
+            remaining = std::min(remaining, scr_critter_sids.size());
+        }
+
+        if (elapsed >= (double)scr_critter_budget) {
+            break;
+        }
+    }
+}
+
+// CE: Rebuilds dense list of critter scripts and drops costs of removed ones.
+static void scr_critters_rebuild()
+{
+    scr_critter_sids.clear();
+
+    ScriptListExtent* extent = scriptlists[SCRIPT_TYPE_CRITTER].head;
+    while (extent != NULL) {
+        for (int index = 0; index < extent->length; index++) {
+            scr_critter_sids.push_back(extent->scripts[index].scr_id);
+        }
+        extent = extent->next;
+    }
+
+    if (scr_critter_costs.size() > scr_critter_sids.size()) {
+        std::unordered_map<int, double> costs;
+        for (int sid : scr_critter_sids) {
+            auto it = scr_critter_costs.find(sid);
+            if (it != scr_critter_costs.end()) {
+                costs.emplace(sid, it->second);
+            }
+        }
+        scr_critter_costs.swap(costs);
+    }
+
+    scr_critter_sids_stale = false;
+}
+
 // TODO: Check.
 //
 // 0x49207C
 static void script_chk_timed_events()
 {
-    // 0x51C7E0
-    static int last_time = 0;
-
     // 0x51C7E4
     static int last_light_time = 0;
 
@@ -655,8 +894,8 @@ static void script_chk_timed_events()
         should_process_queue = false;
     }
 
-    if (elapsed_tocks(now, last_time) >= 100) {
-        last_time = now;
+    if (elapsed_tocks(now, scr_timed_events_last_time) >= 100) {
+        scr_timed_events_last_time = now;
         if (!isInCombat()) {
             fallout_game_time += 1;
         }
@@ -668,6 +907,25 @@ static void script_chk_timed_events()
     }
 }
 
+// CE: Returns number of milliseconds until `script_chk_timed_events` has
+// something to do - due queue events or next game tick (UINT_MAX while
+// critters are not processed).
+unsigned int scr_next_delay()
+{
+    if (!script_engine_running || !script_engine_run_critters || dialog_active()) {
+        return UINT_MAX;
+    }
+
+    if (!isInCombat()) {
+        int nextTime = queue_next_time();
+        if (nextTime != 0 && nextTime <= game_time()) {
+            return 0;
+        }
+    }
+
+    return remaining_tocks(get_time(), scr_timed_events_last_time, 100);
+}
+
 // 0x492100
 int script_q_add(int sid, int delay, int param)
 {
@@ -763,6 +1021,8 @@ int scripts_clear_combat_requests(Script* script)
 // 0x492250
 int scripts_check_state()
 {
+    ProfScope profScope(PROF_ZONE_SCRIPTS_CHECK_STATE);
+
     WorldMapContext ctx;
 
     if (scriptState.requests == 0) {
@@ -1010,6 +1270,10 @@ void scripts_request_dialog(Object* obj)
 {
     scriptState.dialogTarget = obj;
     scriptState.requests |= SCRIPT_REQUEST_DIALOG;
+
+    // CE: Dialogue starts on the next request pass, start loading its
+    // assets now.
+    gdialog_prefetch(obj);
 }
 
 // 0x492884
@@ -1136,6 +1400,17 @@ static int scr_build_lookup_table(Script* script)
         script->procs[action] = proc;
     }
 
+    // CE: Remember which procedures are defined so broadcasts can skip
+    // scripts without handler.
+    script->procMask = 0;
+    for (action = 0; action < SCRIPT_PROC_COUNT; action++) {
+        if (script->procs[action] > 0) {
+            script->procMask |= 1U << action;
+        }
+    }
+
+    scr_handlers_stale = true;
+
     return 0;
 }
 
@@ -1328,6 +1603,22 @@ int scr_init()
     scr_remove_all();
     interpretOutputFunc(win_debug);
     initInterpreter();
+
+    int fastDispatch;
+    if (!config_get_value(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_SCRIPT_FAST_DISPATCH_KEY, &fastDispatch)) {
+        fastDispatch = 0;
+    }
+    interpretSetFastDispatch(fastDispatch != 0);
+
+    int profile;
+    if (!config_get_value(&game_config, GAME_CONFIG_DEBUG_KEY, GAME_CONFIG_SCRIPT_PROFILE_KEY, &profile)) {
+        profile = 0;
+    }
+    interpretProfileSetEnabled(profile != 0);
+
+    if (!config_get_value(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_CRITTER_SCRIPT_BUDGET_KEY, &scr_critter_budget)) {
+        scr_critter_budget = 0;
+    }
     scr_header_load();
 
     // NOTE: Uninline.
@@ -1419,6 +1710,14 @@ int scr_exit()
 
     scr_remove_all();
     scr_remove_all_force();
+
+    // CE: Dump script profile of the whole session.
+    if (interpretProfileIsEnabled()) {
+        interpretProfileSetEnabled(false);
+        interpretProfileWriteTable("script_profile.txt");
+        interpretProfileWriteTrace("script_profile.json");
+    }
+
     interpretClose();
     clearPrograms();
 
@@ -1592,8 +1891,12 @@ static int scr_header_load()
         scriptList->tail = NULL;
         scriptList->length = 0;
         scriptList->nextScriptId = 0;
+
+        scr_index_invalidate(scriptType);
     }
 
+    scr_spatial_invalidate();
+
     return 0;
 }
 
@@ -1658,6 +1961,8 @@ static int scr_write_ScriptNode(ScriptListExtent* a1, DB_FILE* stream)
 // 0x493904
 int scr_save(DB_FILE* stream)
 {
+    MapStatScope mapStatScope(MAP_STAT_PHASE_SCR_SAVE);
+
     for (int scriptType = 0; scriptType < SCRIPT_TYPE_COUNT; scriptType++) {
         ScriptList* scriptList = &(scriptlists[scriptType]);
 
@@ -1706,6 +2011,12 @@ int scr_save(DB_FILE* stream)
                         memcpy(script, &(lastScriptExtent->scripts[backwardsIndex]), sizeof(Script));
                         memcpy(&(lastScriptExtent->scripts[backwardsIndex]), &temp, sizeof(Script));
 
+                        // CE: Keep sid index in sync with swapped scripts.
+                        if (!scr_index_stale[scriptType]) {
+                            scr_index[scriptType][script->scr_id] = script;
+                            scr_index[scriptType][temp.scr_id] = &(lastScriptExtent->scripts[backwardsIndex]);
+                        }
+
                         scriptCount++;
                     }
                 }
@@ -1791,6 +2102,7 @@ static int scr_read_ScriptSubNode(Script* scr, DB_FILE* stream)
     for (int index = 0; index < SCRIPT_PROC_COUNT; index++) {
         scr->procs[index] = 0;
     }
+    scr->procMask = 0;
 
     if (!(map_data.flags & 1)) {
         scr->scr_num_local_vars = 0;
@@ -1824,9 +2136,17 @@ static int scr_read_ScriptNode(ScriptListExtent* scriptExtent, DB_FILE* stream)
 // 0x493DF4
 int scr_load(DB_FILE* stream)
 {
+    MapStatScope mapStatScope(MAP_STAT_PHASE_SCR_LOAD);
+
     for (int index = 0; index < SCRIPT_TYPE_COUNT; index++) {
         ScriptList* scriptList = &(scriptlists[index]);
 
+        scr_index_invalidate(index);
+
+        if (index == SCRIPT_TYPE_SPATIAL) {
+            scr_spatial_invalidate();
+        }
+
         int scriptsCount = 0;
         if (db_freadInt(stream, &scriptsCount) == -1) {
             return -1;
@@ -1839,7 +2159,7 @@ int scr_load(DB_FILE* stream)
                 scriptList->length++;
             }
 
-            ScriptListExtent* extent = (ScriptListExtent*)mem_malloc(sizeof(*extent));
+            ScriptListExtent* extent = (ScriptListExtent*)mapmem_pool_alloc(&scr_extent_pool);
             scriptList->head = extent;
             scriptList->tail = extent;
             if (extent == NULL) {
@@ -1863,7 +2183,7 @@ int scr_load(DB_FILE* stream)
 
             ScriptListExtent* prevExtent = extent;
             for (int extentIndex = 1; extentIndex < scriptList->length; extentIndex++) {
-                ScriptListExtent* extent = (ScriptListExtent*)mem_malloc(sizeof(*extent));
+                ScriptListExtent* extent = (ScriptListExtent*)mapmem_pool_alloc(&scr_extent_pool);
                 if (extent == NULL) {
                     return -1;
                 }
@@ -1912,21 +2232,72 @@ int scr_ptr(int sid, Script** scriptPtr)
         return -1;
     }
 
-    ScriptList* scriptList = &(scriptlists[SID_TYPE(sid)]);
-    ScriptListExtent* scriptListExtent = scriptList->head;
+    int scriptType = SID_TYPE(sid);
+    if (scriptType < 0 || scriptType >= SCRIPT_TYPE_COUNT) {
+        return -1;
+    }
+
+    if (scr_index_stale[scriptType]) {
+        scr_index_rebuild(scriptType);
+    }
+
+    auto it = scr_index[scriptType].find(sid);
+    if (it == scr_index[scriptType].end()) {
+        return -1;
+    }
+
+    *scriptPtr = it->second;
+
+    return 0;
+}
+
+// CE: Changes sid of a script that is already in one of the script lists.
+void scr_set_sid(Script* script, int sid)
+{
+    scr_index_invalidate(SID_TYPE(script->scr_id));
+    scr_index_invalidate(SID_TYPE(sid));
+
+    if (SID_TYPE(script->scr_id) == SCRIPT_TYPE_SPATIAL || SID_TYPE(sid) == SCRIPT_TYPE_SPATIAL) {
+        scr_spatial_invalidate();
+    }
+
+    script->scr_id = sid;
+}
 
+// CE: Drops sid index of given script list, it's rebuilt on next lookup.
+static void scr_index_invalidate(int scriptType)
+{
+    if (scriptType < 0 || scriptType >= SCRIPT_TYPE_COUNT) {
+        return;
+    }
+
+    scr_index[scriptType].clear();
+    scr_index_stale[scriptType] = true;
+
+    if (scriptType == SCRIPT_TYPE_CRITTER) {
+        scr_critter_sids_stale = true;
+    }
+
+    scr_handlers_stale = true;
+}
+
+// CE: Rebuilds sid index from extents of given script list.
+static void scr_index_rebuild(int scriptType)
+{
+    std::unordered_map<int, Script*>& index = scr_index[scriptType];
+    index.clear();
+
+    ScriptListExtent* scriptListExtent = scriptlists[scriptType].head;
     while (scriptListExtent != NULL) {
-        for (int index = 0; index < scriptListExtent->length; index++) {
-            Script* script = &(scriptListExtent->scripts[index]);
-            if (script->scr_id == sid) {
-                *scriptPtr = script;
-                return 0;
-            }
+        for (int scriptIndex = 0; scriptIndex < scriptListExtent->length; scriptIndex++) {
+            Script* script = &(scriptListExtent->scripts[scriptIndex]);
+            // Keep first occurrence to match original list walk.
+            index.emplace(script->scr_id, script);
         }
         scriptListExtent = scriptListExtent->next;
     }
 
-    return -1;
+    scr_index_stale[scriptType] = false;
 }
 
 // 0x494080
@@ -1954,7 +2325,7 @@ int scr_new(int* sidPtr, int scriptType)
     if (scriptList->head != NULL) {
         // There is at least one extent available, which means tail is also set.
         if (scriptListExtent->length == SCRIPT_LIST_EXTENT_SIZE) {
-            ScriptListExtent* newExtent = scriptListExtent->next = (ScriptListExtent*)mem_malloc(sizeof(*newExtent));
+            ScriptListExtent* newExtent = scriptListExtent->next = (ScriptListExtent*)mapmem_pool_alloc(&scr_extent_pool);
             if (newExtent == NULL) {
                 return -1;
             }
@@ -1969,7 +2340,7 @@ int scr_new(int* sidPtr, int scriptType)
         }
     } else {
         // Script head
-        scriptListExtent = (ScriptListExtent*)mem_malloc(sizeof(ScriptListExtent));
+        scriptListExtent = (ScriptListExtent*)mapmem_pool_alloc(&scr_extent_pool);
         if (scriptListExtent == NULL) {
             return -1;
         }
@@ -2010,9 +2381,18 @@ int scr_new(int* sidPtr, int scriptType)
     for (int index = 0; index < SCRIPT_PROC_COUNT; index++) {
         scr->procs[index] = SCRIPT_PROC_NO_PROC;
     }
+    scr->procMask = 0;
 
     scriptListExtent->length++;
 
+    if (!scr_index_stale[scriptType]) {
+        scr_index[scriptType].emplace(sid, scr);
+    }
+
+    if (scriptType == SCRIPT_TYPE_CRITTER) {
+        scr_critter_sids_stale = true;
+    }
+
     return 0;
 }
 
@@ -2023,39 +2403,48 @@ int scr_remove_local_vars(Script* script)
         return -1;
     }
 
-    if (script->scr_num_local_vars != 0) {
-        int oldMapLocalVarsCount = num_map_local_vars;
-        if (oldMapLocalVarsCount > 0 && script->scr_local_var_offset >= 0) {
-            num_map_local_vars -= script->scr_num_local_vars;
-
-            if (oldMapLocalVarsCount - script->scr_num_local_vars != script->scr_local_var_offset && script->scr_local_var_offset != -1) {
-                memmove(map_local_vars + script->scr_local_var_offset,
-                    map_local_vars + (script->scr_local_var_offset + script->scr_num_local_vars),
-                    sizeof(*map_local_vars) * (oldMapLocalVarsCount - script->scr_num_local_vars - script->scr_local_var_offset));
+    // CE: Release block to map's pool instead of compacting local vars and
+    // fixing up offsets of every other script. Holes are squeezed out by
+    // `scr_pack_local_vars` when map is saved.
+    if (script->scr_num_local_vars != 0 && script->scr_local_var_offset >= 0) {
+        map_free_local_var(script->scr_local_var_offset, script->scr_num_local_vars);
+        script->scr_local_var_offset = -1;
+    }
 
-                map_local_vars = (int*)mem_realloc(map_local_vars, sizeof(*map_local_vars) * num_map_local_vars);
-                if (map_local_vars == NULL) {
-                    debug_printf("\nError in mem_realloc in scr_remove_local_vars!\n");
-                }
+    return 0;
+}
 
-                for (int index = 0; index < SCRIPT_TYPE_COUNT; index++) {
-                    ScriptList* scriptList = &(scriptlists[index]);
-                    ScriptListExtent* extent = scriptList->head;
-                    while (extent != NULL) {
-                        for (int index = 0; index < extent->length; index++) {
-                            Script* other = &(extent->scripts[index]);
-                            if (other->scr_local_var_offset > script->scr_local_var_offset) {
-                                other->scr_local_var_offset -= script->scr_num_local_vars;
-                            }
-                        }
-                        extent = extent->next;
-                    }
+// CE: Moves local vars of all scripts to the front of `map_local_vars`,
+// keeping their relative order, and drops released blocks. Produces the same
+// layout as compacting on every removal did, so saved maps are unchanged.
+void scr_pack_local_vars()
+{
+    std::vector<Script*> owners;
+    for (int type = 0; type < SCRIPT_TYPE_COUNT; type++) {
+        ScriptListExtent* extent = scriptlists[type].head;
+        while (extent != NULL) {
+            for (int index = 0; index < extent->length; index++) {
+                Script* script = &(extent->scripts[index]);
+                if (script->scr_num_local_vars > 0 && script->scr_local_var_offset >= 0) {
+                    owners.push_back(script);
                 }
             }
+            extent = extent->next;
         }
     }
 
-    return 0;
+    std::sort(owners.begin(), owners.end(), [](const Script* a, const Script* b) {
+        return a->scr_local_var_offset < b->scr_local_var_offset;
+    });
+
+    int length = 0;
+    for (Script* script : owners) {
+        map_move_local_vars(length, script->scr_local_var_offset, script->scr_num_local_vars);
+        script->scr_local_var_offset = length;
+        length += script->scr_num_local_vars;
+    }
+
+    map_trim_local_vars(length);
 }
 
 // 0x494384
@@ -2065,7 +2454,8 @@ int scr_remove(int sid)
         return -1;
     }
 
-    ScriptList* scriptList = &(scriptlists[SID_TYPE(sid)]);
+    int scriptType = SID_TYPE(sid);
+    ScriptList* scriptList = &(scriptlists[scriptType]);
 
     ScriptListExtent* scriptListExtent = scriptList->head;
     int index;
@@ -2107,13 +2497,32 @@ int scr_remove(int sid)
             debug_printf("\nERROR Removing Timed Events on scr_remove!!\n");
         }
 
+        // CE: Forget removed script, the one relocated into its slot (if any)
+        // is updated below.
+        if (!scr_index_stale[scriptType]) {
+            scr_index[scriptType].erase(sid);
+        }
+
+        if (scriptType == SCRIPT_TYPE_SPATIAL) {
+            scr_spatial_unregister(sid);
+            scr_spatial_positions_stale = true;
+        }
+
+        if (scriptType == SCRIPT_TYPE_CRITTER) {
+            scr_critter_sids_stale = true;
+        }
+
+        if (script->procMask != 0) {
+            scr_handlers_stale = true;
+        }
+
         if (scriptListExtent == scriptList->tail && index + 1 == scriptListExtent->length) {
             // Removing last script in tail extent
             scriptListExtent->length -= 1;
 
             if (scriptListExtent->length == 0) {
                 scriptList->length--;
-                mem_free(scriptListExtent);
+                mapmem_pool_free(&scr_extent_pool, scriptListExtent);
 
                 if (scriptList->length != 0) {
                     ScriptListExtent* v13 = scriptList->head;
@@ -2131,6 +2540,10 @@ int scr_remove(int sid)
             // Relocate last script from tail extent into this script's slot.
             memcpy(&(scriptListExtent->scripts[index]), &(scriptList->tail->scripts[scriptList->tail->length - 1]), sizeof(Script));
 
+            if (!scr_index_stale[scriptType]) {
+                scr_index[scriptType][scriptListExtent->scripts[index].scr_id] = &(scriptListExtent->scripts[index]);
+            }
+
             // Decrement number of scripts in tail extent.
             scriptList->tail->length -= 1;
 
@@ -2146,7 +2559,7 @@ int scr_remove(int sid)
                 }
                 prev->next = NULL;
 
-                mem_free(scriptList->tail);
+                mapmem_pool_free(&scr_extent_pool, scriptList->tail);
                 scriptList->tail = prev;
             }
         }
@@ -2210,15 +2623,23 @@ int scr_remove_all_force()
         ScriptListExtent* extent = scriptList->head;
         while (extent != NULL) {
             ScriptListExtent* next = extent->next;
-            mem_free(extent);
+            mapmem_pool_free(&scr_extent_pool, extent);
             extent = next;
         }
 
         scriptList->head = NULL;
         scriptList->tail = NULL;
         scriptList->length = 0;
+
+        scr_index[type].clear();
+        scr_index_stale[type] = false;
     }
 
+    scr_critter_sids_stale = true;
+    scr_handlers_stale = true;
+
+    scr_spatial_invalidate();
+
     scr_find_first_idx = 0;
     scr_find_first_ptr = 0;
     scr_find_first_elev = 0;
@@ -2339,8 +2760,37 @@ bool scr_chk_spatials_in(Object* object, int tile, int elevation)
 
     built_tile = builtTileCreate(tile, elevation);
 
-    script = scr_find_first_at(elevation);
-    while (script != NULL) {
+    // CE: Only visit spatial scripts whose area contains this tile instead of
+    // every spatial script on the elevation. Candidates are a superset, the
+    // original test below decides whether script is triggered.
+    if (scr_spatial_grid_stale) {
+        scr_spatial_rebuild();
+    }
+
+    scr_spatial_candidates.clear();
+
+    auto it = scr_spatial_grid.find(built_tile);
+    if (it != scr_spatial_grid.end()) {
+        scr_spatial_candidates.insert(scr_spatial_candidates.end(), it->second.begin(), it->second.end());
+    }
+
+    if (elevationIsValid(elevation)) {
+        scr_spatial_candidates.insert(scr_spatial_candidates.end(), scr_spatial_wide[elevation].begin(), scr_spatial_wide[elevation].end());
+    }
+
+    if (scr_spatial_candidates.size() > 1) {
+        scr_spatial_sort_candidates();
+    }
+
+    for (size_t index = 0; index < scr_spatial_candidates.size(); index++) {
+        if (scr_ptr(scr_spatial_candidates[index], &script) == -1) {
+            continue;
+        }
+
+        if ((script->scr_flags & SCRIPT_FLAG_0x02) != 0 || builtTileGetElevation(script->sp.built_tile) != elevation) {
+            continue;
+        }
+
         if (built_tile == script->sp.built_tile) {
             // NOTE: Uninline.
             scr_set_objs(script->scr_id, object, NULL);
@@ -2354,8 +2804,6 @@ bool scr_chk_spatials_in(Object* object, int tile, int elevation)
                 }
             }
         }
-
-        script = scr_find_next_at();
     }
 
     scr_spatials_enable();
@@ -2369,6 +2817,200 @@ bool tile_in_tile_bound(int tile1, int radius, int tile2)
     return tile_dist(tile1, tile2) <= radius;
 }
 
+// CE: Sets trigger area of a spatial script and updates spatial grid.
+void scr_spatial_set(Script* script, int builtTile, int radius)
+{
+    script->sp.built_tile = builtTile;
+    script->sp.radius = radius;
+
+    if (SID_TYPE(script->scr_id) == SCRIPT_TYPE_SPATIAL) {
+        scr_spatial_unregister(script->scr_id);
+        scr_spatial_register(script->scr_id, builtTile, radius);
+    }
+}
+
+// CE: Collects built tiles covered by spatial script area. Returns `false`
+// when area is too wide (or malformed) to be rasterized.
+static bool scr_spatial_cells(const ScriptSpatialCoverage* coverage, std::vector<int>& cells)
+{
+    int tile = builtTileGetTile(coverage->builtTile);
+    int elevation = builtTileGetElevation(coverage->builtTile);
+
+    cells.clear();
+
+    if (!hexGridTileIsValid(tile) || coverage->radius > SCRIPT_SPATIAL_GRID_MAX_RADIUS) {
+        return false;
+    }
+
+    // Exact match is tested against unmodified built tile.
+    cells.push_back(coverage->builtTile);
+
+    if (coverage->radius <= 0) {
+        return true;
+    }
+
+    // Every hex step changes each offset coordinate by at most one, so area
+    // is bounded by a square of twice the radius.
+    int centerX = tile % HEX_GRID_WIDTH;
+    int centerY = tile / HEX_GRID_WIDTH;
+    int minX = std::max(centerX - coverage->radius, 0);
+    int maxX = std::min(centerX + coverage->radius, HEX_GRID_WIDTH - 1);
+    int minY = std::max(centerY - coverage->radius, 0);
+    int maxY = std::min(centerY + coverage->radius, HEX_GRID_HEIGHT - 1);
+
+    for (int y = minY; y <= maxY; y++) {
+        for (int x = minX; x <= maxX; x++) {
+            int other = y * HEX_GRID_WIDTH + x;
+            if (tile_in_tile_bound(tile, coverage->radius, other)) {
+                int cell = builtTileCreate(other, elevation);
+                if (cell != coverage->builtTile) {
+                    cells.push_back(cell);
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+// CE: Adds spatial script area to spatial grid.
+static void scr_spatial_register(int sid, int builtTile, int radius)
+{
+    if (scr_spatial_grid_stale || builtTile == -1) {
+        return;
+    }
+
+    ScriptSpatialCoverage coverage;
+    coverage.builtTile = builtTile;
+    coverage.radius = radius;
+
+    int elevation = builtTileGetElevation(builtTile);
+    if (!elevationIsValid(elevation)) {
+        // Never matches elevation passed to `scr_chk_spatials_in`.
+        return;
+    }
+
+    scr_spatial_coverage[sid] = coverage;
+
+    std::vector<int> cells;
+    if (!scr_spatial_cells(&coverage, cells)) {
+        scr_spatial_wide[elevation].push_back(sid);
+        return;
+    }
+
+    for (int cell : cells) {
+        scr_spatial_grid[cell].push_back(sid);
+    }
+}
+
+// CE: Removes spatial script area from spatial grid.
+static void scr_spatial_unregister(int sid)
+{
+    if (scr_spatial_grid_stale) {
+        return;
+    }
+
+    auto it = scr_spatial_coverage.find(sid);
+    if (it == scr_spatial_coverage.end()) {
+        return;
+    }
+
+    ScriptSpatialCoverage coverage = it->second;
+    scr_spatial_coverage.erase(it);
+
+    std::vector<int> cells;
+    if (!scr_spatial_cells(&coverage, cells)) {
+        std::vector<int>& wide = scr_spatial_wide[builtTileGetElevation(coverage.builtTile)];
+        wide.erase(std::remove(wide.begin(), wide.end(), sid), wide.end());
+        return;
+    }
+
+    for (int cell : cells) {
+        auto cellIt = scr_spatial_grid.find(cell);
+        if (cellIt == scr_spatial_grid.end()) {
+            continue;
+        }
+
+        std::vector<int>& sids = cellIt->second;
+        sids.erase(std::remove(sids.begin(), sids.end(), sid), sids.end());
+        if (sids.empty()) {
+            scr_spatial_grid.erase(cellIt);
+        }
+    }
+}
+
+// CE: Drops spatial grid, it's rebuilt on next step.
+static void scr_spatial_invalidate()
+{
+    scr_spatial_grid.clear();
+    scr_spatial_coverage.clear();
+
+    for (int elevation = 0; elevation < ELEVATION_COUNT; elevation++) {
+        scr_spatial_wide[elevation].clear();
+    }
+
+    scr_spatial_grid_stale = true;
+    scr_spatial_positions_stale = true;
+}
+
+// CE: Rebuilds `scr_spatial_positions` from spatial script list.
+static void scr_spatial_positions_rebuild()
+{
+    scr_spatial_positions.clear();
+    scr_spatial_positions_stale = false;
+
+    int position = 0;
+    ScriptListExtent* extent = scriptlists[SCRIPT_TYPE_SPATIAL].head;
+    while (extent != NULL) {
+        for (int index = 0; index < extent->length; index++) {
+            scr_spatial_positions[extent->scripts[index].scr_id] = position++;
+        }
+        extent = extent->next;
+    }
+}
+
+// CE: Sorts `scr_spatial_candidates` into spatial script list order. Scripts
+// appended since last rebuild are not known yet, they force a rebuild.
+static void scr_spatial_sort_candidates()
+{
+    if (!scr_spatial_positions_stale) {
+        for (int sid : scr_spatial_candidates) {
+            if (scr_spatial_positions.find(sid) == scr_spatial_positions.end()) {
+                scr_spatial_positions_stale = true;
+                break;
+            }
+        }
+    }
+
+    if (scr_spatial_positions_stale) {
+        scr_spatial_positions_rebuild();
+    }
+
+    std::sort(scr_spatial_candidates.begin(), scr_spatial_candidates.end(), [](int a, int b) {
+        auto aIt = scr_spatial_positions.find(a);
+        auto bIt = scr_spatial_positions.find(b);
+        int aPosition = aIt != scr_spatial_positions.end() ? aIt->second : INT_MAX;
+        int bPosition = bIt != scr_spatial_positions.end() ? bIt->second : INT_MAX;
+        return aPosition < bPosition;
+    });
+}
+
+// CE: Rebuilds spatial grid from spatial script list.
+static void scr_spatial_rebuild()
+{
+    scr_spatial_invalidate();
+    scr_spatial_grid_stale = false;
+
+    ScriptListExtent* extent = scriptlists[SCRIPT_TYPE_SPATIAL].head;
+    while (extent != NULL) {
+        for (int index = 0; index < extent->length; index++) {
+            Script* script = &(extent->scripts[index]);
+            scr_spatial_register(script->scr_id, script->sp.built_tile, script->sp.radius);
+        }
+        extent = extent->next;
+    }
+}
+
 // 0x494960
 int scr_load_all_scripts()
 {
@@ -2390,26 +3032,21 @@ int scr_load_all_scripts()
 // 0x4949C0
 void scr_exec_map_enter_scripts()
 {
-    int script_type;
-    ScriptListExtent* script_list_extent;
-    int script_index;
-    int sid;
+    MapStatScope mapStatScope(MAP_STAT_PHASE_MAP_ENTER_SCRIPTS);
 
     scr_spatials_disable();
 
-    for (script_type = 0; script_type < SCRIPT_TYPE_COUNT; script_type++) {
-        script_list_extent = scriptlists[script_type].head;
-        while (script_list_extent != NULL) {
-            for (script_index = 0; script_index < script_list_extent->length; script_index++) {
-                if (script_list_extent->scripts[script_index].procs[SCRIPT_PROC_MAP_ENTER] > 0) {
-                    sid = script_list_extent->scripts[script_index].scr_id;
-                    if (sid != map_script_id) {
-                        scr_set_ext_param(sid, (map_data.flags & 0x1) == 0);
-                        exec_script_proc(sid, SCRIPT_PROC_MAP_ENTER);
-                    }
-                }
-            }
-            script_list_extent = script_list_extent->next;
+    // CE: Only visit scripts which have `map_enter_p_proc`. Handlers can add
+    // or remove scripts, so list is copied.
+    if (scr_handlers_stale) {
+        scr_handlers_rebuild();
+    }
+
+    std::vector<int> sids = scr_map_enter_sids;
+    for (int sid : sids) {
+        if (sid != map_script_id) {
+            scr_set_ext_param(sid, (map_data.flags & 0x1) == 0);
+            exec_script_proc(sid, SCRIPT_PROC_MAP_ENTER);
         }
     }
 
@@ -2419,31 +3056,50 @@ void scr_exec_map_enter_scripts()
 // 0x494A70
 void scr_exec_map_update_scripts()
 {
-    int script_type;
-    ScriptListExtent* script_list_extent;
-    int script_index;
-    int sid;
-
     scr_spatials_disable();
 
     exec_script_proc(map_script_id, SCRIPT_PROC_MAP_UPDATE);
 
-    for (script_type = 0; script_type < SCRIPT_TYPE_COUNT; script_type++) {
-        script_list_extent = scriptlists[script_type].head;
-        while (script_list_extent != NULL) {
-            for (script_index = 0; script_index < script_list_extent->length; script_index++) {
-                if (script_list_extent->scripts[script_index].procs[SCRIPT_PROC_MAP_UPDATE] > 0) {
-                    sid = script_list_extent->scripts[script_index].scr_id;
-                    if (sid != map_script_id) {
-                        exec_script_proc(sid, SCRIPT_PROC_MAP_UPDATE);
-                    }
+    // CE: Only visit scripts which have `map_update_p_proc`. Handlers can
+    // add or remove scripts, so list is copied.
+    if (scr_handlers_stale) {
+        scr_handlers_rebuild();
+    }
+
+    std::vector<int> sids = scr_map_update_sids;
+    for (int sid : sids) {
+        if (sid != map_script_id) {
+            exec_script_proc(sid, SCRIPT_PROC_MAP_UPDATE);
+        }
+    }
+
+    scr_spatials_enable();
+}
+
+// CE: Collects scripts with map enter and map update handlers in list order.
+static void scr_handlers_rebuild()
+{
+    scr_map_enter_sids.clear();
+    scr_map_update_sids.clear();
+
+    for (int scriptType = 0; scriptType < SCRIPT_TYPE_COUNT; scriptType++) {
+        ScriptListExtent* extent = scriptlists[scriptType].head;
+        while (extent != NULL) {
+            for (int index = 0; index < extent->length; index++) {
+                Script* script = &(extent->scripts[index]);
+                if ((script->procMask & (1U << SCRIPT_PROC_MAP_ENTER)) != 0) {
+                    scr_map_enter_sids.push_back(script->scr_id);
+                }
+
+                if ((script->procMask & (1U << SCRIPT_PROC_MAP_UPDATE)) != 0) {
+                    scr_map_update_sids.push_back(script->scr_id);
                 }
             }
-            script_list_extent = script_list_extent->next;
+            extent = extent->next;
         }
     }
 
-    scr_spatials_enable();
+    scr_handlers_stale = false;
 }
 
 // 0x494AFC
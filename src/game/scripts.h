@@ -124,6 +124,9 @@ typedef struct Script {
     int field_D4;
     int field_D8;
     int field_DC;
+
+    // CE: Bit per action (`1 << action`) which has procedure in `procs`.
+    unsigned int procMask;
 } Script;
 
 extern int num_script_indexes;
@@ -139,6 +142,7 @@ void inc_game_time(int inc);
 void inc_game_time_in_seconds(int inc);
 void set_game_time(int time);
 void set_game_time_in_seconds(int time);
+int gtime_skip(int time);
 int gtime_q_add();
 int gtime_q_process(Object* obj, void* data);
 int scr_map_q_process(Object* obj, void* data);
@@ -185,14 +189,17 @@ int scr_enable();
 int scr_disable();
 void scr_enable_critters();
 void scr_disable_critters();
+unsigned int scr_next_delay();
 int scr_game_save(DB_FILE* stream);
 int scr_game_load(DB_FILE* stream);
 int scr_game_load2(DB_FILE* stream);
 int scr_save(DB_FILE* stream);
 int scr_load(DB_FILE* stream);
 int scr_ptr(int sid, Script** script);
+void scr_set_sid(Script* script, int sid);
 int scr_new(int* sidPtr, int scriptType);
 int scr_remove_local_vars(Script* script);
+void scr_pack_local_vars();
 int scr_remove(int index);
 int scr_remove_all();
 int scr_remove_all_force();
@@ -202,6 +209,7 @@ bool scr_spatials_enabled();
 void scr_spatials_enable();
 void scr_spatials_disable();
 bool scr_chk_spatials_in(Object* obj, int tile, int elevation);
+void scr_spatial_set(Script* script, int builtTile, int radius);
 bool tile_in_tile_bound(int tile1, int radius, int tile2);
 int scr_load_all_scripts();
 void scr_exec_map_enter_scripts();
@@ -1,10 +1,16 @@
 #include "game/selfrun.h"
 
+#include <limits.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#include <chrono>
+#include <vector>
+
 #include "game/game.h"
 #include "game/gconfig.h"
+#include "game/statebin.h"
 #include "platform_compat.h"
 #include "plib/db/db.h"
 #include "plib/gnw/input.h"
@@ -22,6 +28,10 @@ typedef enum SelfrunState {
 static void selfrun_playback_callback(int reason);
 static int selfrun_load_data(const char* path, SelfrunData* selfrunData);
 static int selfrun_save_data(const char* path, SelfrunData* selfrunData);
+static void selfrun_hash_path(SelfrunData* selfrunData, char* path, size_t size);
+static bool selfrun_load_hash(SelfrunData* selfrunData, unsigned long long* hashPtr);
+static bool selfrun_save_hash(SelfrunData* selfrunData, unsigned long long hash);
+static void selfrun_hash_bytes(unsigned long long* hash, const void* data, size_t size);
 
 // 0x507A6C
 static int selfrun_state = SELFRUN_STATE_TURNED_OFF;
@@ -194,6 +204,151 @@ void selfrun_recording_loop(SelfrunData* selfrunData)
     }
 }
 
+// CE: Plays recording back as fast as possible for benchmarking. Playback
+// runs in turbo mode, so game logic sees the same (virtual) time on every run
+// regardless of host speed, and user input does not stop it. At the end game
+// state hash is compared with the one stored next to the recording (or
+// stored there, when recording has none yet).
+//
+// Returns 0 if playback completed and state matches (or was stored), 1 if
+// state differs, -1 on error.
+int selfrun_benchmark_loop(SelfrunData* selfrunData, SelfrunBenchResult* result)
+{
+    memset(result, 0, sizeof(*result));
+
+    if (selfrun_state != SELFRUN_STATE_PLAYING) {
+        return -1;
+    }
+
+    char path[COMPAT_MAX_PATH];
+    snprintf(path, sizeof(path), "%s%s", "selfrun\\", selfrunData->recordingFileName);
+
+    if (!vcr_play(path, 0, selfrun_playback_callback)) {
+        selfrun_state = SELFRUN_STATE_TURNED_OFF;
+        return -1;
+    }
+
+    bool turbo = is_turbo_mode();
+    set_turbo_mode(true, svga_is_headless());
+
+    unsigned int startTime = get_time();
+    auto start = std::chrono::steady_clock::now();
+
+    while (selfrun_state == SELFRUN_STATE_PLAYING) {
+        sharedFpsLimiter.mark();
+
+        int keyCode = get_input();
+        if (keyCode != selfrunData->stopKeyCode) {
+            game_handle_input(keyCode, false);
+        }
+
+        renderPresent();
+        sharedFpsLimiter.throttle();
+
+        result->frames++;
+    }
+
+    auto end = std::chrono::steady_clock::now();
+    result->wallTime = std::chrono::duration<double, std::milli>(end - start).count();
+    result->gameTime = elapsed_time(startTime);
+
+    if (!turbo) {
+        set_turbo_mode(false, false);
+    }
+
+    result->hash = selfrun_state_hash();
+    result->hasExpectedHash = selfrun_load_hash(selfrunData, &(result->expectedHash));
+
+    if (!result->hasExpectedHash) {
+        result->hashSaved = selfrun_save_hash(selfrunData, result->hash);
+        return 0;
+    }
+
+    return result->hash == result->expectedHash ? 0 : 1;
+}
+
+// CE: Returns FNV-1a hash of game state (player, every object on the map,
+// inventory, combat state and global variables) used to check that playback
+// is deterministic.
+unsigned long long selfrun_state_hash()
+{
+    StateBinOptions options;
+    options.objectRadius = INT_MAX;
+    options.names = false;
+    options.baseVersions = NULL;
+
+    std::vector<unsigned char> buffer;
+    size_t size = statebin_encode(&buffer, 0, &options);
+
+    unsigned long long hash = 0xCBF29CE484222325ULL;
+    selfrun_hash_bytes(&hash, buffer.data(), size);
+
+    if (game_global_vars != NULL) {
+        selfrun_hash_bytes(&hash, game_global_vars, sizeof(*game_global_vars) * num_game_global_vars);
+    }
+
+    return hash;
+}
+
+static void selfrun_hash_bytes(unsigned long long* hash, const void* data, size_t size)
+{
+    const unsigned char* bytes = (const unsigned char*)data;
+    for (size_t index = 0; index < size; index++) {
+        *hash ^= bytes[index];
+        *hash *= 0x100000001B3ULL;
+    }
+}
+
+// CE: Expected hash is stored in `selfrun\<recording>.hsh`.
+static void selfrun_hash_path(SelfrunData* selfrunData, char* path, size_t size)
+{
+    char name[SELFRUN_RECORDING_FILE_NAME_LENGTH];
+    strcpy(name, selfrunData->recordingFileName);
+
+    char* extension = strrchr(name, '.');
+    if (extension != NULL) {
+        *extension = '\0';
+    }
+
+    snprintf(path, size, "%s%s%s", "selfrun\\", name, ".hsh");
+}
+
+static bool selfrun_load_hash(SelfrunData* selfrunData, unsigned long long* hashPtr)
+{
+    char path[COMPAT_MAX_PATH];
+    selfrun_hash_path(selfrunData, path, sizeof(path));
+
+    DB_FILE* stream = db_fopen(path, "rt");
+    if (stream == NULL) {
+        return false;
+    }
+
+    char string[32];
+    bool loaded = db_fgets(string, sizeof(string), stream) != NULL
+        && sscanf(string, "%llx", hashPtr) == 1;
+
+    db_fclose(stream);
+
+    return loaded;
+}
+
+static bool selfrun_save_hash(SelfrunData* selfrunData, unsigned long long hash)
+{
+    char path[COMPAT_MAX_PATH];
+    selfrun_hash_path(selfrunData, path, sizeof(path));
+
+    DB_FILE* stream = db_fopen(path, "wt");
+    if (stream == NULL) {
+        return false;
+    }
+
+    bool saved = db_fprintf(stream, "%016llx\n", hash) > 0;
+
+    db_fclose(stream);
+
+    return saved;
+}
+
 // 0x496FF4
 static void selfrun_playback_callback(int reason)
 {
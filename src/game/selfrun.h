@@ -12,12 +12,36 @@ typedef struct SelfrunData {
     int stopKeyCode;
 } SelfrunData;
 
+// CE: Results of benchmark playback (see `selfrun_benchmark_loop`).
+typedef struct SelfrunBenchResult {
+    // Number of game loop iterations.
+    unsigned int frames;
+
+    // Time passed on game clock (in ms).
+    unsigned int gameTime;
+
+    // Time passed on wall clock (in ms).
+    double wallTime;
+
+    // Hash of game state at the end of playback (see `selfrun_state_hash`).
+    unsigned long long hash;
+
+    // Hash stored with recording, when present.
+    bool hasExpectedHash;
+    unsigned long long expectedHash;
+
+    // Set when recording had no hash and `hash` was stored as expected one.
+    bool hashSaved;
+} SelfrunBenchResult;
+
 int selfrun_get_list(char*** fileListPtr, int* fileListLengthPtr);
 int selfrun_free_list(char*** fileListPtr);
 int selfrun_prep_playback(const char* fileName, SelfrunData* selfrunData);
 void selfrun_playback_loop(SelfrunData* selfrunData);
 int selfrun_prep_recording(const char* recordingName, const char* mapFileName, SelfrunData* selfrunData);
 void selfrun_recording_loop(SelfrunData* selfrunData);
+int selfrun_benchmark_loop(SelfrunData* selfrunData, SelfrunBenchResult* result);
+unsigned long long selfrun_state_hash();
 
 } // namespace fallout
 
@@ -7,17 +7,51 @@
 #include <string.h>
 
 #include <adecode/adecode.h>
+#include <SDL.h>
 
 #include "game/cache.h"
 #include "game/gconfig.h"
 #include "game/sfxlist.h"
 #include "plib/db/db.h"
+#include "plib/gnw/debug.h"
 #include "plib/gnw/memory.h"
+#include "plib/gnw/prof.h"
 
 namespace fallout {
 
 #define SOUND_EFFECTS_CACHE_MIN_SIZE 0x40000
 
+// CE: Maximum decoded size of sound effect kept in decoded cache.
+#define SFXC_PCM_MAX_EFFECT_SIZE 0x40000
+
+// CE: Maximum number of sound effects waiting for (or done with) background
+// decoding.
+#define SFXC_DECODE_MAX_JOBS 16
+
+typedef enum SfxcDecodeState {
+    SFXC_DECODE_QUEUED,
+    SFXC_DECODE_RUNNING,
+    SFXC_DECODE_DONE,
+    SFXC_DECODE_FAILED,
+} SfxcDecodeState;
+
+// CE: Sound effect decoded by decode worker. Buffers are allocated with
+// `malloc` since they are filled on worker thread.
+typedef struct SfxcDecodeJob {
+    int tag;
+    int state;
+
+    // Copy of compressed file.
+    unsigned char* compressed;
+    int compressedSize;
+    int compressedPosition;
+
+    unsigned char* pcm;
+    int pcmSize;
+
+    struct SfxcDecodeJob* next;
+} SfxcDecodeJob;
+
 typedef struct SoundEffect {
     // NOTE: This field is only 1 byte, likely unsigned char. It always uses
     // cmp for checking implying it's not bitwise flags. Therefore it's better
@@ -31,6 +65,9 @@ typedef struct SoundEffect {
     int position;
     int dataPosition;
     unsigned char* data;
+
+    // CE: Specifies that `data` is decoded copy locked in `sfxc_pcm_cache`.
+    bool decoded;
 } SoundEffect;
 
 static int sfxc_effect_size(int tag, int* sizePtr);
@@ -44,6 +81,17 @@ static bool sfxc_handle_is_legal(int a1);
 static bool sfxc_mode_is_legal(int mode);
 static int sfxc_decode(int handle, void* buf, unsigned int size);
 static unsigned int sfxc_ad_reader(void* stream, void* buf, unsigned int size);
+static int sfxc_pcm_init(int cacheSize);
+static void sfxc_pcm_exit();
+static int sfxc_pcm_size(int tag, int* sizePtr);
+static int sfxc_pcm_load(int tag, int* sizePtr, unsigned char* data);
+static bool sfxc_pcm_lock(int tag, void** dataPtr, CacheEntry** cacheHandlePtr);
+static void sfxc_decode_queue(int tag, const unsigned char* data);
+static void sfxc_decode_collect();
+static void sfxc_decode_cancel();
+static void sfxc_decode_free_job(SfxcDecodeJob* job);
+static int sfxc_decode_thread(void* data);
+static unsigned int sfxc_decode_reader(void* stream, void* buf, unsigned int size);
 
 // 0x507A70
 static int sfxc_dlevel = INT_MAX;
@@ -66,9 +114,32 @@ static bool sfxc_initialized = false;
 // 0x507A88
 static int sfxc_cmpr = 1;
 
+// CE: Decoded copies of short sound effects (NULL when disabled).
+static Cache* sfxc_pcm_cache = NULL;
+
+// CE: Decode worker state, only job list is shared with the worker.
+static SDL_Thread* sfxc_decode_worker = NULL;
+static SDL_mutex* sfxc_decode_mutex = NULL;
+
+// Signalled when jobs are added or finished.
+static SDL_cond* sfxc_decode_cond = NULL;
+
+static SfxcDecodeJob* sfxc_decode_jobs = NULL;
+static int sfxc_decode_jobs_length = 0;
+static bool sfxc_decode_quit = false;
+
+// CE: Worker was stopped by `sfxc_decode_suspend`, it is started again by
+// `sfxc_decode_resume` or when next effect is queued.
+static bool sfxc_decode_suspended = false;
+
+// CE: Job `sfxc_pcm_load` copies decoded data from.
+static SfxcDecodeJob* sfxc_pcm_job = NULL;
+
 // 0x497140
 int sfxc_init(int cacheSize, const char* effectsPath)
 {
+    MemTagScope memTagScope(MEM_TAG_SOUND);
+
     if (!config_get_value(&game_config, GAME_CONFIG_SOUND_KEY, GAME_CONFIG_DEBUG_SFXC_KEY, &sfxc_dlevel)) {
         sfxc_dlevel = 1;
     }
@@ -113,6 +184,15 @@ int sfxc_init(int cacheSize, const char* effectsPath)
         return -1;
     }
 
+    // CE: Decoded cache is optional, sound effects are decoded on every
+    // read without it.
+    int pcmCacheSize;
+    if (config_get_value(&game_config, GAME_CONFIG_SOUND_KEY, GAME_CONFIG_SFX_PCM_CACHE_SIZE_KEY, &pcmCacheSize) && pcmCacheSize > 0) {
+        if (sfxc_pcm_init(pcmCacheSize << 10) != 0) {
+            debug_printf("sfxc_init: Unable to initialize decoded sound effects cache\n");
+        }
+    }
+
     sfxc_initialized = true;
 
     return 0;
@@ -122,6 +202,8 @@ int sfxc_init(int cacheSize, const char* effectsPath)
 void sfxc_exit()
 {
     if (sfxc_initialized) {
+        sfxc_pcm_exit();
+
         cache_exit(sfxc_pcache);
         mem_free(sfxc_pcache);
         sfxc_pcache = NULL;
@@ -142,11 +224,36 @@ int sfxc_is_initialized()
     return sfxc_initialized;
 }
 
+// CE: Reports sound effects cache stats.
+bool sfxc_get_stats(CacheStats* stats)
+{
+    if (!sfxc_initialized) {
+        return false;
+    }
+
+    return cache_get_stats(sfxc_pcache, stats);
+}
+
+// CE: Reports decoded sound effects cache stats.
+bool sfxc_get_pcm_stats(CacheStats* stats)
+{
+    if (!sfxc_initialized || sfxc_pcm_cache == NULL) {
+        return false;
+    }
+
+    return cache_get_stats(sfxc_pcm_cache, stats);
+}
+
 // 0x4972C8
 void sfxc_flush()
 {
     if (sfxc_initialized) {
         cache_flush(sfxc_pcache);
+
+        if (sfxc_pcm_cache != NULL) {
+            sfxc_decode_cancel();
+            cache_flush(sfxc_pcm_cache);
+        }
     }
 }
 
@@ -173,16 +280,31 @@ int sfxc_cached_open(const char* fname, int mode)
 
     void* data;
     CacheEntry* cacheHandle;
+    int handle;
+
+    // CE: Play decoded copy when there is one.
+    if (sfxc_pcm_lock(tag, &data, &cacheHandle)) {
+        if (sfxc_handle_create(&handle, tag, data, cacheHandle) != 0) {
+            cache_unlock(sfxc_pcm_cache, cacheHandle);
+            return -1;
+        }
+
+        sfxc_handle_list[handle].decoded = true;
+
+        return handle;
+    }
+
     if (!cache_lock(sfxc_pcache, tag, &data, &cacheHandle)) {
         return -1;
     }
 
-    int handle;
     if (sfxc_handle_create(&handle, tag, data, cacheHandle) != 0) {
         cache_unlock(sfxc_pcache, cacheHandle);
         return -1;
     }
 
+    sfxc_decode_queue(tag, (unsigned char*)data);
+
     return handle;
 }
 
@@ -194,7 +316,7 @@ int sfxc_cached_close(int handle)
     }
 
     SoundEffect* soundEffect = &(sfxc_handle_list[handle]);
-    if (!cache_unlock(sfxc_pcache, soundEffect->cacheHandle)) {
+    if (!cache_unlock(soundEffect->decoded ? sfxc_pcm_cache : sfxc_pcache, soundEffect->cacheHandle)) {
         return -1;
     }
 
@@ -228,6 +350,12 @@ int sfxc_cached_read(int handle, void* buf, unsigned int size)
         bytesToRead = soundEffect->dataSize - soundEffect->position;
     }
 
+    if (soundEffect->decoded) {
+        memcpy(buf, soundEffect->data + soundEffect->position, bytesToRead);
+        soundEffect->position += bytesToRead;
+        return bytesToRead;
+    }
+
     switch (sfxc_cmpr) {
     case 0:
         memcpy(buf, soundEffect->data + soundEffect->position, bytesToRead);
@@ -335,6 +463,8 @@ static int sfxc_effect_size(int tag, int* sizePtr)
 // 0x4975DC
 static int sfxc_effect_load(int tag, int* sizePtr, unsigned char* data)
 {
+    MemTagScope memTagScope(MEM_TAG_SOUND);
+
     if (!sfxl_tag_is_legal(tag)) {
         return -1;
     }
@@ -427,6 +557,7 @@ static int sfxc_handle_create(int* handlePtr, int tag, void* data, CacheEntry* c
     soundEffect->dataPosition = 0;
 
     soundEffect->data = (unsigned char*)data;
+    soundEffect->decoded = false;
 
     *handlePtr = index;
 
@@ -537,4 +668,369 @@ static unsigned int sfxc_ad_reader(void* stream, void* buf, unsigned int size)
     return bytesToRead;
 }
 
+static int sfxc_pcm_init(int cacheSize)
+{
+    sfxc_pcm_cache = (Cache*)mem_malloc(sizeof(*sfxc_pcm_cache));
+    if (sfxc_pcm_cache == NULL) {
+        return -1;
+    }
+
+    if (!cache_init(sfxc_pcm_cache, sfxc_pcm_size, sfxc_pcm_load, sfxc_effect_free, cacheSize)) {
+        mem_free(sfxc_pcm_cache);
+        sfxc_pcm_cache = NULL;
+        return -1;
+    }
+
+    sfxc_decode_mutex = SDL_CreateMutex();
+    if (sfxc_decode_mutex == NULL) {
+        sfxc_pcm_exit();
+        return -1;
+    }
+
+    sfxc_decode_cond = SDL_CreateCond();
+    if (sfxc_decode_cond == NULL) {
+        sfxc_pcm_exit();
+        return -1;
+    }
+
+    sfxc_decode_quit = false;
+
+    sfxc_decode_worker = SDL_CreateThread(sfxc_decode_thread, "sfxc_decode", NULL);
+    if (sfxc_decode_worker == NULL) {
+        sfxc_pcm_exit();
+        return -1;
+    }
+
+    return 0;
+}
+
+static void sfxc_pcm_exit()
+{
+    sfxc_decode_suspend();
+    sfxc_decode_suspended = false;
+
+    while (sfxc_decode_jobs != NULL) {
+        SfxcDecodeJob* next = sfxc_decode_jobs->next;
+        sfxc_decode_free_job(sfxc_decode_jobs);
+        sfxc_decode_jobs = next;
+    }
+    sfxc_decode_jobs_length = 0;
+
+    if (sfxc_decode_cond != NULL) {
+        SDL_DestroyCond(sfxc_decode_cond);
+        sfxc_decode_cond = NULL;
+    }
+
+    if (sfxc_decode_mutex != NULL) {
+        SDL_DestroyMutex(sfxc_decode_mutex);
+        sfxc_decode_mutex = NULL;
+    }
+
+    if (sfxc_pcm_cache != NULL) {
+        cache_exit(sfxc_pcm_cache);
+        mem_free(sfxc_pcm_cache);
+        sfxc_pcm_cache = NULL;
+    }
+}
+
+static int sfxc_pcm_size(int tag, int* sizePtr)
+{
+    int size;
+    if (sfxl_size_full(tag, &size) == -1) {
+        return -1;
+    }
+
+    *sizePtr = size;
+
+    return 0;
+}
+
+// Copies decoded data from `sfxc_pcm_job`, there is no way to decode effect
+// on demand.
+static int sfxc_pcm_load(int tag, int* sizePtr, unsigned char* data)
+{
+    MemTagScope memTagScope(MEM_TAG_SOUND);
+
+    if (sfxc_pcm_job == NULL || sfxc_pcm_job->tag != tag) {
+        return -1;
+    }
+
+    memcpy(data, sfxc_pcm_job->pcm, sfxc_pcm_job->pcmSize);
+    *sizePtr = sfxc_pcm_job->pcmSize;
+
+    return 0;
+}
+
+static bool sfxc_pcm_lock(int tag, void** dataPtr, CacheEntry** cacheHandlePtr)
+{
+    if (sfxc_pcm_cache == NULL) {
+        return false;
+    }
+
+    sfxc_decode_collect();
+
+    if (!cache_query(sfxc_pcm_cache, tag)) {
+        return false;
+    }
+
+    return cache_lock(sfxc_pcm_cache, tag, dataPtr, cacheHandlePtr);
+}
+
+// Queues decoding of effect which is missing in decoded cache. Several
+// effects with the same tag started at once share one job.
+static void sfxc_decode_queue(int tag, const unsigned char* data)
+{
+    if (sfxc_decode_suspended) {
+        sfxc_decode_resume();
+    }
+
+    if (sfxc_decode_worker == NULL) {
+        return;
+    }
+
+    int pcmSize;
+    if (sfxl_size_full(tag, &pcmSize) == -1) {
+        return;
+    }
+
+    if (pcmSize <= 0 || pcmSize > SFXC_PCM_MAX_EFFECT_SIZE || pcmSize > sfxc_pcm_cache->maxSize) {
+        return;
+    }
+
+    int compressedSize;
+    if (sfxl_size_cached(tag, &compressedSize) == -1) {
+        return;
+    }
+
+    // Jobs are only added (and removed) on main thread, so the list can be
+    // checked before allocating a new one.
+    SDL_LockMutex(sfxc_decode_mutex);
+
+    bool queued = sfxc_decode_jobs_length >= SFXC_DECODE_MAX_JOBS;
+    for (SfxcDecodeJob* job = sfxc_decode_jobs; job != NULL && !queued; job = job->next) {
+        queued = job->tag == tag;
+    }
+
+    SDL_UnlockMutex(sfxc_decode_mutex);
+
+    if (queued) {
+        return;
+    }
+
+    SfxcDecodeJob* job = (SfxcDecodeJob*)malloc(sizeof(*job));
+    if (job == NULL) {
+        return;
+    }
+
+    job->tag = tag;
+    job->state = SFXC_DECODE_QUEUED;
+    job->compressed = (unsigned char*)malloc(compressedSize);
+    job->compressedSize = compressedSize;
+    job->compressedPosition = 0;
+    job->pcm = (unsigned char*)malloc(pcmSize);
+    job->pcmSize = pcmSize;
+    job->next = NULL;
+
+    if (job->compressed == NULL || job->pcm == NULL) {
+        sfxc_decode_free_job(job);
+        return;
+    }
+
+    memcpy(job->compressed, data, compressedSize);
+
+    SDL_LockMutex(sfxc_decode_mutex);
+
+    SfxcDecodeJob** link = &sfxc_decode_jobs;
+    while (*link != NULL) {
+        link = &((*link)->next);
+    }
+    *link = job;
+    sfxc_decode_jobs_length++;
+
+    SDL_CondSignal(sfxc_decode_cond);
+    SDL_UnlockMutex(sfxc_decode_mutex);
+}
+
+// Moves effects decoded by decode worker into decoded cache.
+static void sfxc_decode_collect()
+{
+    if (sfxc_decode_mutex == NULL) {
+        return;
+    }
+
+    SDL_LockMutex(sfxc_decode_mutex);
+
+    SfxcDecodeJob* finished = NULL;
+    SfxcDecodeJob** link = &sfxc_decode_jobs;
+    while (*link != NULL) {
+        SfxcDecodeJob* job = *link;
+        if (job->state == SFXC_DECODE_DONE || job->state == SFXC_DECODE_FAILED) {
+            *link = job->next;
+            sfxc_decode_jobs_length--;
+
+            job->next = finished;
+            finished = job;
+        } else {
+            link = &(job->next);
+        }
+    }
+
+    SDL_UnlockMutex(sfxc_decode_mutex);
+
+    while (finished != NULL) {
+        SfxcDecodeJob* job = finished;
+        finished = job->next;
+
+        if (job->state == SFXC_DECODE_DONE) {
+            void* data;
+            CacheEntry* cacheHandle;
+
+            sfxc_pcm_job = job;
+            if (cache_lock(sfxc_pcm_cache, job->tag, &data, &cacheHandle)) {
+                cache_unlock(sfxc_pcm_cache, cacheHandle);
+            }
+            sfxc_pcm_job = NULL;
+        }
+
+        sfxc_decode_free_job(job);
+    }
+}
+
+// Drops queued jobs and waits for the running one.
+static void sfxc_decode_cancel()
+{
+    if (sfxc_decode_mutex == NULL) {
+        return;
+    }
+
+    SDL_LockMutex(sfxc_decode_mutex);
+
+    for (;;) {
+        bool running = false;
+        for (SfxcDecodeJob* job = sfxc_decode_jobs; job != NULL; job = job->next) {
+            if (job->state == SFXC_DECODE_RUNNING) {
+                running = true;
+                break;
+            }
+        }
+
+        if (!running) {
+            break;
+        }
+
+        SDL_CondWait(sfxc_decode_cond, sfxc_decode_mutex);
+    }
+
+    while (sfxc_decode_jobs != NULL) {
+        SfxcDecodeJob* next = sfxc_decode_jobs->next;
+        sfxc_decode_free_job(sfxc_decode_jobs);
+        sfxc_decode_jobs = next;
+    }
+    sfxc_decode_jobs_length = 0;
+
+    SDL_UnlockMutex(sfxc_decode_mutex);
+}
+
+// CE: Stops decode worker (for example before process is forked). Worker
+// finishes job it is running, so none is left half done, queued jobs wait
+// for `sfxc_decode_resume`.
+void sfxc_decode_suspend()
+{
+    if (sfxc_decode_worker == NULL) {
+        return;
+    }
+
+    SDL_LockMutex(sfxc_decode_mutex);
+    sfxc_decode_quit = true;
+    SDL_CondBroadcast(sfxc_decode_cond);
+    SDL_UnlockMutex(sfxc_decode_mutex);
+
+    SDL_WaitThread(sfxc_decode_worker, NULL);
+    sfxc_decode_worker = NULL;
+    sfxc_decode_suspended = true;
+}
+
+void sfxc_decode_resume()
+{
+    if (!sfxc_decode_suspended) {
+        return;
+    }
+
+    sfxc_decode_suspended = false;
+    sfxc_decode_quit = false;
+
+    sfxc_decode_worker = SDL_CreateThread(sfxc_decode_thread, "sfxc_decode", NULL);
+    if (sfxc_decode_worker == NULL) {
+        debug_printf("sfxc_decode_resume: unable to start decode worker\n");
+    }
+}
+
+static void sfxc_decode_free_job(SfxcDecodeJob* job)
+{
+    free(job->compressed);
+    free(job->pcm);
+    free(job);
+}
+
+static int sfxc_decode_thread(void* data)
+{
+    SDL_LockMutex(sfxc_decode_mutex);
+
+    while (!sfxc_decode_quit) {
+        SfxcDecodeJob* job;
+        for (job = sfxc_decode_jobs; job != NULL; job = job->next) {
+            if (job->state == SFXC_DECODE_QUEUED) {
+                break;
+            }
+        }
+
+        if (job == NULL) {
+            SDL_CondWait(sfxc_decode_cond, sfxc_decode_mutex);
+            continue;
+        }
+
+        job->state = SFXC_DECODE_RUNNING;
+
+        SDL_UnlockMutex(sfxc_decode_mutex);
+
+        size_t bytesRead;
+        {
+            ProfScope profScope(PROF_ZONE_SFX_DECODE_WORKER);
+
+            int channels;
+            int sampleRate;
+            int sampleCount;
+            AudioDecoder* ad = Create_AudioDecoder(sfxc_decode_reader, job, &channels, &sampleRate, &sampleCount);
+            bytesRead = AudioDecoder_Read(ad, job->pcm, job->pcmSize);
+            AudioDecoder_Close(ad);
+        }
+
+        SDL_LockMutex(sfxc_decode_mutex);
+
+        job->state = bytesRead == (size_t)job->pcmSize ? SFXC_DECODE_DONE : SFXC_DECODE_FAILED;
+
+        // Wake up `sfxc_decode_cancel`.
+        SDL_CondBroadcast(sfxc_decode_cond);
+    }
+
+    SDL_UnlockMutex(sfxc_decode_mutex);
+
+    return 0;
+}
+
+static unsigned int sfxc_decode_reader(void* stream, void* buf, unsigned int size)
+{
+    SfxcDecodeJob* job = (SfxcDecodeJob*)stream;
+
+    unsigned int bytesToRead = job->compressedSize - job->compressedPosition;
+    if (size < bytesToRead) {
+        bytesToRead = size;
+    }
+
+    memcpy(buf, job->compressed + job->compressedPosition, bytesToRead);
+    job->compressedPosition += bytesToRead;
+
+    return bytesToRead;
+}
+
 } // namespace fallout
@@ -1,6 +1,8 @@
 #ifndef FALLOUT_GAME_SFXCACHE_H_
 #define FALLOUT_GAME_SFXCACHE_H_
 
+#include "game/cache.h"
+
 namespace fallout {
 
 // The maximum number of sound effects that can be loaded and played
@@ -18,6 +20,10 @@ int sfxc_cached_write(int handle, const void* buf, unsigned int size);
 long sfxc_cached_seek(int handle, long offset, int origin);
 long sfxc_cached_tell(int handle);
 long sfxc_cached_file_size(int handle);
+bool sfxc_get_stats(CacheStats* stats);
+bool sfxc_get_pcm_stats(CacheStats* stats);
+void sfxc_decode_suspend();
+void sfxc_decode_resume();
 
 } // namespace fallout
 
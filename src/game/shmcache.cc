@@ -0,0 +1,517 @@
+#include "game/shmcache.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#include <SDL.h>
+
+#include "platform_compat.h"
+#include "plib/gnw/debug.h"
+
+namespace fallout {
+
+// Shared cache segment layout:
+//
+// | ShmCacheHeader | ShmCacheSlot[slotsLength] | ShmCacheBlock[blocksCapacity] | data |
+//
+// Slots form open-addressing hash table (keys are never removed, evicted
+// entries remain as dead slots). Data is carved into power-of-two blocks
+// which are reused by entries of the same size class once evicted. All
+// cross-process synchronization is done with atomic operations on slot and
+// block state words, there are no locks.
+
+#define SHMCACHE_MAGIC 0x43484D53
+#define SHMCACHE_VERSION 1
+
+// Smallest and largest block sizes (4 KB - 16 MB).
+#define SHMCACHE_MIN_BLOCK_SHIFT 12
+#define SHMCACHE_BLOCK_CLASS_COUNT 13
+
+// Slot control word keeps state in high byte and reference count in the
+// remaining bits, so eviction (which requires zero references) and
+// acquiring reference cannot race.
+#define SHMCACHE_SLOT_STATE_SHIFT 24
+#define SHMCACHE_SLOT_REFS_MASK 0xFFFFFF
+
+#define SHMCACHE_SLOT_EMPTY 0
+#define SHMCACHE_SLOT_LOADING 1
+#define SHMCACHE_SLOT_READY 2
+#define SHMCACHE_SLOT_DEAD 3
+
+// Slot is owned by evicting process, which detaches its block.
+#define SHMCACHE_SLOT_EVICTING 4
+
+// Block states. Zero (from zero-filled segment) denotes block record which
+// is being set up.
+#define SHMCACHE_BLOCK_FREE 1
+#define SHMCACHE_BLOCK_USED 2
+
+// Number of attempts to evict unused entry before giving up.
+#define SHMCACHE_EVICT_ATTEMPTS 4
+
+typedef struct ShmCacheHeader {
+    unsigned int magic;
+    unsigned int version;
+    unsigned int signature;
+    unsigned int size;
+    int slotsLength;
+    int blocksCapacity;
+    unsigned int dataOffset;
+    unsigned int dataSize;
+
+    // Set once the segment is set up by the creator.
+    SDL_atomic_t initialized;
+
+    // Number of processes using the segment.
+    SDL_atomic_t attached;
+
+    SDL_atomic_t blocksLength;
+    SDL_atomic_t dataUsed;
+
+    // Usage counter for picking least recently used eviction victims.
+    SDL_atomic_t tick;
+} ShmCacheHeader;
+
+typedef struct ShmCacheSlot {
+    // Key + 1 (zero means the slot is empty).
+    SDL_atomic_t tag;
+    SDL_atomic_t control;
+    SDL_atomic_t lastUse;
+    int block;
+    int size;
+} ShmCacheSlot;
+
+typedef struct ShmCacheBlock {
+    SDL_atomic_t state;
+    unsigned int offset;
+    int sizeClass;
+} ShmCacheBlock;
+
+static int shmcache_find(int key, bool claim, bool* claimedPtr);
+static int shmcache_size_class(int size);
+static int shmcache_alloc_block(int sizeClass);
+static int shmcache_evict(int sizeClass);
+static unsigned char* shmcache_block_data(unsigned char* base, int block);
+
+static char shmcache_name[64];
+static size_t shmcache_size = 0;
+static ShmCacheHeader* shmcache_header = NULL;
+static ShmCacheSlot* shmcache_slots = NULL;
+static ShmCacheBlock* shmcache_blocks = NULL;
+
+// Read-write mapping (used for metadata and publishing new entries) and
+// read-only mapping (handed out to callers).
+static unsigned char* shmcache_rw = NULL;
+static const unsigned char* shmcache_ro = NULL;
+
+// Opens shared cache segment with given name, creating it if needed. All
+// processes must agree on data they put into the cache, `signature` is
+// used to detect mismatches.
+bool shmcache_open(const char* name, int size, unsigned int signature)
+{
+    if (shmcache_header != NULL) {
+        return false;
+    }
+
+    if (name == NULL || size < (1 << 20)) {
+        return false;
+    }
+
+    // One slot per 16 KB (power of two) and one block record per smallest
+    // block, so block records never run out before data.
+    int slotsLength = 1024;
+    while (slotsLength < size / (16 * 1024)) {
+        slotsLength *= 2;
+    }
+
+    int blocksCapacity = size >> SHMCACHE_MIN_BLOCK_SHIFT;
+
+    size_t metadataSize = sizeof(ShmCacheHeader) + sizeof(ShmCacheSlot) * slotsLength + sizeof(ShmCacheBlock) * blocksCapacity;
+    size_t dataOffset = (metadataSize + (1 << SHMCACHE_MIN_BLOCK_SHIFT) - 1) & ~(size_t)((1 << SHMCACHE_MIN_BLOCK_SHIFT) - 1);
+    size_t totalSize = dataOffset + (size_t)size;
+
+    bool created;
+    void* rw;
+    const void* ro;
+    if (!compat_shm_open(name, totalSize, &created, &rw, &ro)) {
+        debug_printf("Shared cache: could not open %s\n", name);
+        return false;
+    }
+
+    ShmCacheHeader* header = (ShmCacheHeader*)rw;
+
+    if (created) {
+        header->magic = SHMCACHE_MAGIC;
+        header->version = SHMCACHE_VERSION;
+        header->signature = signature;
+        header->size = (unsigned int)totalSize;
+        header->slotsLength = slotsLength;
+        header->blocksCapacity = blocksCapacity;
+        header->dataOffset = (unsigned int)dataOffset;
+        header->dataSize = (unsigned int)size;
+        SDL_AtomicSet(&(header->initialized), 1);
+    } else {
+        int attempt = 0;
+        while (SDL_AtomicGet(&(header->initialized)) == 0 && attempt < 100) {
+            SDL_Delay(10);
+            attempt++;
+        }
+
+        if (SDL_AtomicGet(&(header->initialized)) == 0
+            || header->magic != SHMCACHE_MAGIC
+            || header->version != SHMCACHE_VERSION
+            || header->signature != signature
+            || header->size != totalSize) {
+            debug_printf("Shared cache: %s is incompatible\n", name);
+            compat_shm_close(name, totalSize, rw, ro, false);
+            return false;
+        }
+    }
+
+    SDL_AtomicAdd(&(header->attached), 1);
+
+    strncpy(shmcache_name, name, sizeof(shmcache_name) - 1);
+    shmcache_name[sizeof(shmcache_name) - 1] = '\0';
+    shmcache_size = totalSize;
+    shmcache_rw = (unsigned char*)rw;
+    shmcache_ro = (const unsigned char*)ro;
+    shmcache_header = header;
+    shmcache_slots = (ShmCacheSlot*)(shmcache_rw + sizeof(ShmCacheHeader));
+    shmcache_blocks = (ShmCacheBlock*)(shmcache_rw + sizeof(ShmCacheHeader) + sizeof(ShmCacheSlot) * slotsLength);
+
+    debug_printf("Shared cache: %s %s (%d KB)\n", created ? "created" : "attached", name, size / 1024);
+
+    return true;
+}
+
+// Detaches from shared cache segment. Last process removes segment name.
+//
+// NOTE: All references must be released beforehand.
+void shmcache_close()
+{
+    if (shmcache_header == NULL) {
+        return;
+    }
+
+    bool last = SDL_AtomicAdd(&(shmcache_header->attached), -1) == 1;
+
+    compat_shm_close(shmcache_name, shmcache_size, shmcache_rw, shmcache_ro, last);
+
+    shmcache_header = NULL;
+    shmcache_slots = NULL;
+    shmcache_blocks = NULL;
+    shmcache_rw = NULL;
+    shmcache_ro = NULL;
+    shmcache_size = 0;
+}
+
+bool shmcache_is_open()
+{
+    return shmcache_header != NULL;
+}
+
+// Looks up published entry and acquires reference to it. Returned data is
+// mapped read-only.
+int shmcache_acquire(int key, int* slotPtr, unsigned char** dataPtr, int* sizePtr)
+{
+    if (shmcache_header == NULL) {
+        return SHMCACHE_ACQUIRE_MISS;
+    }
+
+    int slotIndex = shmcache_find(key, false, NULL);
+    if (slotIndex == -1) {
+        return SHMCACHE_ACQUIRE_MISS;
+    }
+
+    ShmCacheSlot* slot = &(shmcache_slots[slotIndex]);
+    while (true) {
+        int control = SDL_AtomicGet(&(slot->control));
+        int state = control >> SHMCACHE_SLOT_STATE_SHIFT;
+
+        if (state == SHMCACHE_SLOT_DEAD) {
+            return SHMCACHE_ACQUIRE_MISS;
+        }
+
+        if (state != SHMCACHE_SLOT_READY || (control & SHMCACHE_SLOT_REFS_MASK) == SHMCACHE_SLOT_REFS_MASK) {
+            return SHMCACHE_ACQUIRE_BUSY;
+        }
+
+        if (SDL_AtomicCAS(&(slot->control), control, control + 1)) {
+            break;
+        }
+    }
+
+    SDL_AtomicSet(&(slot->lastUse), SDL_AtomicAdd(&(shmcache_header->tick), 1));
+
+    *slotPtr = slotIndex;
+    *dataPtr = (unsigned char*)shmcache_block_data((unsigned char*)shmcache_ro, slot->block);
+    *sizePtr = slot->size;
+
+    return SHMCACHE_ACQUIRE_OK;
+}
+
+void shmcache_release(int slotIndex)
+{
+    if (shmcache_header == NULL) {
+        return;
+    }
+
+    SDL_AtomicAdd(&(shmcache_slots[slotIndex].control), -1);
+}
+
+// Reserves block for publishing new entry. Caller is expected to fill
+// returned (writable) buffer and then call `shmcache_commit` or
+// `shmcache_abort`.
+bool shmcache_begin(int key, int size, int* slotPtr, unsigned char** bufferPtr)
+{
+    if (shmcache_header == NULL || size <= 0) {
+        return false;
+    }
+
+    int sizeClass = shmcache_size_class(size);
+    if (sizeClass == -1) {
+        return false;
+    }
+
+    bool claimed;
+    int slotIndex = shmcache_find(key, true, &claimed);
+    if (slotIndex == -1) {
+        return false;
+    }
+
+    ShmCacheSlot* slot = &(shmcache_slots[slotIndex]);
+    int expected = (claimed ? SHMCACHE_SLOT_EMPTY : SHMCACHE_SLOT_DEAD) << SHMCACHE_SLOT_STATE_SHIFT;
+    if (!SDL_AtomicCAS(&(slot->control), expected, SHMCACHE_SLOT_LOADING << SHMCACHE_SLOT_STATE_SHIFT)) {
+        // Published (or being published) by another process.
+        return false;
+    }
+
+    int block = shmcache_alloc_block(sizeClass);
+    if (block == -1) {
+        slot->block = -1;
+        SDL_AtomicSet(&(slot->control), SHMCACHE_SLOT_DEAD << SHMCACHE_SLOT_STATE_SHIFT);
+        return false;
+    }
+
+    slot->block = block;
+    slot->size = size;
+
+    *slotPtr = slotIndex;
+    *bufferPtr = shmcache_block_data(shmcache_rw, block);
+
+    return true;
+}
+
+// Publishes entry reserved with `shmcache_begin`. The caller holds one
+// reference to the entry. Returns read-only pointer to the data.
+unsigned char* shmcache_commit(int slotIndex, int size)
+{
+    ShmCacheSlot* slot = &(shmcache_slots[slotIndex]);
+    slot->size = size;
+
+    SDL_AtomicSet(&(slot->lastUse), SDL_AtomicAdd(&(shmcache_header->tick), 1));
+
+    // Full barrier, block and size are visible once the state is.
+    SDL_AtomicSet(&(slot->control), (SHMCACHE_SLOT_READY << SHMCACHE_SLOT_STATE_SHIFT) | 1);
+
+    return (unsigned char*)shmcache_block_data((unsigned char*)shmcache_ro, slot->block);
+}
+
+void shmcache_abort(int slotIndex)
+{
+    ShmCacheSlot* slot = &(shmcache_slots[slotIndex]);
+
+    if (slot->block != -1) {
+        SDL_AtomicSet(&(shmcache_blocks[slot->block].state), SHMCACHE_BLOCK_FREE);
+        slot->block = -1;
+    }
+
+    SDL_AtomicSet(&(slot->control), SHMCACHE_SLOT_DEAD << SHMCACHE_SLOT_STATE_SHIFT);
+}
+
+// Reports number of published entries, and used and total size of data
+// area.
+bool shmcache_get_usage(int* entriesPtr, int* usedPtr, int* capacityPtr)
+{
+    if (shmcache_header == NULL) {
+        return false;
+    }
+
+    int entries = 0;
+    int used = 0;
+    for (int index = 0; index < shmcache_header->slotsLength; index++) {
+        ShmCacheSlot* slot = &(shmcache_slots[index]);
+        if ((SDL_AtomicGet(&(slot->control)) >> SHMCACHE_SLOT_STATE_SHIFT) == SHMCACHE_SLOT_READY) {
+            entries++;
+            used += slot->size;
+        }
+    }
+
+    *entriesPtr = entries;
+    *usedPtr = used;
+    *capacityPtr = (int)shmcache_header->dataSize;
+
+    return true;
+}
+
+// Returns slot index for given key or -1 if there is no such key. When
+// `claim` is set, empty slot is claimed for the key if needed (reported in
+// `claimedPtr`).
+static int shmcache_find(int key, bool claim, bool* claimedPtr)
+{
+    int tag = (int)((unsigned int)key + 1);
+    if (tag == 0) {
+        return -1;
+    }
+
+    if (claimedPtr != NULL) {
+        *claimedPtr = false;
+    }
+
+    unsigned int mask = (unsigned int)shmcache_header->slotsLength - 1;
+    unsigned int index = ((unsigned int)key * 2654435761U) & mask;
+
+    for (int probe = 0; probe < shmcache_header->slotsLength; probe++) {
+        ShmCacheSlot* slot = &(shmcache_slots[index]);
+
+        int slotTag = SDL_AtomicGet(&(slot->tag));
+        if (slotTag == tag) {
+            return (int)index;
+        }
+
+        if (slotTag == 0) {
+            if (!claim) {
+                return -1;
+            }
+
+            if (SDL_AtomicCAS(&(slot->tag), 0, tag)) {
+                *claimedPtr = true;
+                return (int)index;
+            }
+
+            // Someone else claimed this slot, it might be for the same key.
+            if (SDL_AtomicGet(&(slot->tag)) == tag) {
+                return (int)index;
+            }
+        }
+
+        index = (index + 1) & mask;
+    }
+
+    return -1;
+}
+
+static int shmcache_size_class(int size)
+{
+    for (int sizeClass = 0; sizeClass < SHMCACHE_BLOCK_CLASS_COUNT; sizeClass++) {
+        if (size <= (1 << (SHMCACHE_MIN_BLOCK_SHIFT + sizeClass))) {
+            return sizeClass;
+        }
+    }
+
+    return -1;
+}
+
+// Allocates block of given size class. Tries free blocks of this class
+// first, then unused data space, then evicts unreferenced entry.
+static int shmcache_alloc_block(int sizeClass)
+{
+    int blocksLength = SDL_AtomicGet(&(shmcache_header->blocksLength));
+    for (int block = 0; block < blocksLength; block++) {
+        ShmCacheBlock* blockInfo = &(shmcache_blocks[block]);
+        if (blockInfo->sizeClass == sizeClass
+            && SDL_AtomicGet(&(blockInfo->state)) == SHMCACHE_BLOCK_FREE
+            && SDL_AtomicCAS(&(blockInfo->state), SHMCACHE_BLOCK_FREE, SHMCACHE_BLOCK_USED)) {
+            return block;
+        }
+    }
+
+    unsigned int blockSize = 1U << (SHMCACHE_MIN_BLOCK_SHIFT + sizeClass);
+
+    while (true) {
+        unsigned int used = (unsigned int)SDL_AtomicGet(&(shmcache_header->dataUsed));
+        if (used + blockSize > shmcache_header->dataSize) {
+            break;
+        }
+
+        if (!SDL_AtomicCAS(&(shmcache_header->dataUsed), (int)used, (int)(used + blockSize))) {
+            continue;
+        }
+
+        // Block records cannot run out before data does.
+        int block = SDL_AtomicAdd(&(shmcache_header->blocksLength), 1);
+
+        ShmCacheBlock* blockInfo = &(shmcache_blocks[block]);
+        blockInfo->offset = used;
+        blockInfo->sizeClass = sizeClass;
+        SDL_AtomicSet(&(blockInfo->state), SHMCACHE_BLOCK_USED);
+
+        return block;
+    }
+
+    for (int attempt = 0; attempt < SHMCACHE_EVICT_ATTEMPTS; attempt++) {
+        int block = shmcache_evict(sizeClass);
+        if (block != -1) {
+            return block;
+        }
+    }
+
+    return -1;
+}
+
+// Evicts least recently used unreferenced entry with block of given size
+// class and returns its block, or -1 if there is no such entry.
+static int shmcache_evict(int sizeClass)
+{
+    int victim = -1;
+    int victimLastUse = 0;
+
+    for (int index = 0; index < shmcache_header->slotsLength; index++) {
+        ShmCacheSlot* slot = &(shmcache_slots[index]);
+        if (SDL_AtomicGet(&(slot->control)) != (SHMCACHE_SLOT_READY << SHMCACHE_SLOT_STATE_SHIFT)) {
+            continue;
+        }
+
+        // Slot can change under our feet, its block is only a hint here.
+        int block = slot->block;
+        if (block < 0 || block >= shmcache_header->blocksCapacity || shmcache_blocks[block].sizeClass != sizeClass) {
+            continue;
+        }
+
+        int lastUse = SDL_AtomicGet(&(slot->lastUse));
+        if (victim == -1 || lastUse - victimLastUse < 0) {
+            victim = index;
+            victimLastUse = lastUse;
+        }
+    }
+
+    if (victim == -1) {
+        return -1;
+    }
+
+    ShmCacheSlot* slot = &(shmcache_slots[victim]);
+    if (!SDL_AtomicCAS(&(slot->control), SHMCACHE_SLOT_READY << SHMCACHE_SLOT_STATE_SHIFT, SHMCACHE_SLOT_EVICTING << SHMCACHE_SLOT_STATE_SHIFT)) {
+        // Acquired or evicted by someone else in the meantime.
+        return -1;
+    }
+
+    // The slot might have been republished with another block since it was
+    // picked, so block is checked again now that the slot is owned.
+    int block = slot->block;
+    slot->block = -1;
+    SDL_AtomicSet(&(slot->control), SHMCACHE_SLOT_DEAD << SHMCACHE_SLOT_STATE_SHIFT);
+
+    if (shmcache_blocks[block].sizeClass != sizeClass) {
+        SDL_AtomicSet(&(shmcache_blocks[block].state), SHMCACHE_BLOCK_FREE);
+        return -1;
+    }
+
+    return block;
+}
+
+static unsigned char* shmcache_block_data(unsigned char* base, int block)
+{
+    return base + shmcache_header->dataOffset + shmcache_blocks[block].offset;
+}
+
+} // namespace fallout
@@ -0,0 +1,29 @@
+#ifndef FALLOUT_GAME_SHMCACHE_H_
+#define FALLOUT_GAME_SHMCACHE_H_
+
+namespace fallout {
+
+typedef enum ShmCacheAcquireResult {
+    // Entry is available, reference was acquired.
+    SHMCACHE_ACQUIRE_OK,
+
+    // There is no such entry (it can be published with `shmcache_begin`).
+    SHMCACHE_ACQUIRE_MISS,
+
+    // Entry is being published by another process.
+    SHMCACHE_ACQUIRE_BUSY,
+} ShmCacheAcquireResult;
+
+bool shmcache_open(const char* name, int size, unsigned int signature);
+void shmcache_close();
+bool shmcache_is_open();
+int shmcache_acquire(int key, int* slotPtr, unsigned char** dataPtr, int* sizePtr);
+void shmcache_release(int slot);
+bool shmcache_begin(int key, int size, int* slotPtr, unsigned char** bufferPtr);
+unsigned char* shmcache_commit(int slot, int size);
+void shmcache_abort(int slot);
+bool shmcache_get_usage(int* entriesPtr, int* usedPtr, int* capacityPtr);
+
+} // namespace fallout
+
+#endif /* FALLOUT_GAME_SHMCACHE_H_ */
@@ -0,0 +1,352 @@
+#include "game/shmchan.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#include <SDL.h>
+
+#include "platform_compat.h"
+#include "plib/gnw/debug.h"
+
+namespace fallout {
+
+// Channel segment layout:
+//
+// | ShmChanHeader | state ring data | command ring data |
+//
+// Each ring has exactly one producer and one consumer, so positions are
+// plain counters: producer is the only one advancing `head`, consumer is the
+// only one advancing `tail`, and neither needs locks. Positions count bytes
+// and are reduced modulo capacity (power of two) when accessed.
+//
+// Every message is a 4-byte size followed by payload, padded to 8 bytes. A
+// message never wraps around the end of the ring; when it does not fit in
+// the remaining space, producer writes `SHMCHAN_WRAP` marker and continues at
+// the start.
+//
+// Consumers sleep on ring's `seq` word, which producer increments after every
+// message and wakes waiters with futex (when the platform has it).
+
+#define SHMCHAN_MAGIC 0x4E414843
+#define SHMCHAN_VERSION 1
+
+#define SHMCHAN_WRAP 0xFFFFFFFF
+
+#define SHMCHAN_RING_STATE 0
+#define SHMCHAN_RING_COMMAND 1
+#define SHMCHAN_RING_COUNT 2
+
+// Keeps producer and consumer words on separate cache lines.
+#define SHMCHAN_CACHE_LINE 64
+
+typedef struct ShmChanRing {
+    unsigned int offset;
+    unsigned int capacity;
+    unsigned char padding0[SHMCHAN_CACHE_LINE - 2 * sizeof(unsigned int)];
+
+    // Written by producer.
+    SDL_atomic_t head;
+    SDL_atomic_t seq;
+    unsigned char padding1[SHMCHAN_CACHE_LINE - 2 * sizeof(SDL_atomic_t)];
+
+    // Written by consumer.
+    SDL_atomic_t tail;
+    SDL_atomic_t waiters;
+    unsigned char padding2[SHMCHAN_CACHE_LINE - 2 * sizeof(SDL_atomic_t)];
+} ShmChanRing;
+
+typedef struct ShmChanHeader {
+    unsigned int magic;
+    unsigned int version;
+    unsigned int size;
+
+    // Set once the segment is set up by the creator.
+    SDL_atomic_t initialized;
+
+    // Number of processes using the segment.
+    SDL_atomic_t attached;
+
+    unsigned char padding[SHMCHAN_CACHE_LINE - 3 * sizeof(unsigned int) - 2 * sizeof(SDL_atomic_t)];
+
+    ShmChanRing rings[SHMCHAN_RING_COUNT];
+} ShmChanHeader;
+
+static bool shmchan_ring_capacity_is_valid(int capacity);
+static unsigned int shmchan_message_size(unsigned int size);
+
+static char shmchan_name[64];
+static size_t shmchan_size = 0;
+static ShmChanHeader* shmchan_header = NULL;
+static unsigned char* shmchan_rw = NULL;
+static const unsigned char* shmchan_ro = NULL;
+
+// Rings this process writes to and reads from.
+static ShmChanRing* shmchan_out = NULL;
+static ShmChanRing* shmchan_in = NULL;
+
+// Size of message returned by last `shmchan_peek` (including padding), 0 if
+// there is none.
+static unsigned int shmchan_peeked = 0;
+
+static ShmChanStats shmchan_stats;
+
+static bool shmchan_ring_capacity_is_valid(int capacity)
+{
+    return capacity >= 4096 && capacity <= (1 << 30) && (capacity & (capacity - 1)) == 0;
+}
+
+static unsigned int shmchan_message_size(unsigned int size)
+{
+    return (sizeof(unsigned int) + size + 7) & ~7u;
+}
+
+// Opens channel segment with given name, creating it if needed. Both sides
+// must pass the same capacities (in bytes, powers of two), largest message
+// is half of ring capacity.
+bool shmchan_open(const char* name, int role, int stateCapacity, int commandCapacity)
+{
+    if (shmchan_header != NULL) {
+        return false;
+    }
+
+    if (name == NULL
+        || (role != SHMCHAN_ROLE_GAME && role != SHMCHAN_ROLE_CONTROLLER)
+        || !shmchan_ring_capacity_is_valid(stateCapacity)
+        || !shmchan_ring_capacity_is_valid(commandCapacity)) {
+        return false;
+    }
+
+    size_t totalSize = sizeof(ShmChanHeader) + (size_t)stateCapacity + (size_t)commandCapacity;
+
+    bool created;
+    void* rw;
+    const void* ro;
+    if (!compat_shm_open(name, totalSize, &created, &rw, &ro)) {
+        debug_printf("Shared channel: could not open %s\n", name);
+        return false;
+    }
+
+    ShmChanHeader* header = (ShmChanHeader*)rw;
+
+    if (created) {
+        header->magic = SHMCHAN_MAGIC;
+        header->version = SHMCHAN_VERSION;
+        header->size = (unsigned int)totalSize;
+        header->rings[SHMCHAN_RING_STATE].offset = sizeof(ShmChanHeader);
+        header->rings[SHMCHAN_RING_STATE].capacity = (unsigned int)stateCapacity;
+        header->rings[SHMCHAN_RING_COMMAND].offset = sizeof(ShmChanHeader) + (unsigned int)stateCapacity;
+        header->rings[SHMCHAN_RING_COMMAND].capacity = (unsigned int)commandCapacity;
+        SDL_AtomicSet(&(header->initialized), 1);
+    } else {
+        int attempt = 0;
+        while (SDL_AtomicGet(&(header->initialized)) == 0 && attempt < 100) {
+            SDL_Delay(10);
+            attempt++;
+        }
+
+        if (SDL_AtomicGet(&(header->initialized)) == 0
+            || header->magic != SHMCHAN_MAGIC
+            || header->version != SHMCHAN_VERSION
+            || header->size != totalSize
+            || header->rings[SHMCHAN_RING_STATE].capacity != (unsigned int)stateCapacity
+            || header->rings[SHMCHAN_RING_COMMAND].capacity != (unsigned int)commandCapacity) {
+            debug_printf("Shared channel: %s is incompatible\n", name);
+            compat_shm_close(name, totalSize, rw, ro, false);
+            return false;
+        }
+    }
+
+    SDL_AtomicAdd(&(header->attached), 1);
+
+    strncpy(shmchan_name, name, sizeof(shmchan_name) - 1);
+    shmchan_name[sizeof(shmchan_name) - 1] = '\0';
+    shmchan_size = totalSize;
+    shmchan_rw = (unsigned char*)rw;
+    shmchan_ro = (const unsigned char*)ro;
+    shmchan_header = header;
+
+    if (role == SHMCHAN_ROLE_GAME) {
+        shmchan_out = &(header->rings[SHMCHAN_RING_STATE]);
+        shmchan_in = &(header->rings[SHMCHAN_RING_COMMAND]);
+    } else {
+        shmchan_out = &(header->rings[SHMCHAN_RING_COMMAND]);
+        shmchan_in = &(header->rings[SHMCHAN_RING_STATE]);
+    }
+
+    shmchan_peeked = 0;
+    memset(&shmchan_stats, 0, sizeof(shmchan_stats));
+
+    debug_printf("Shared channel: %s %s (%d KB state, %d KB commands)\n",
+        created ? "created" : "attached",
+        name,
+        stateCapacity / 1024,
+        commandCapacity / 1024);
+
+    return true;
+}
+
+// Detaches from channel segment. Last process removes segment name.
+void shmchan_close()
+{
+    if (shmchan_header == NULL) {
+        return;
+    }
+
+    bool last = SDL_AtomicAdd(&(shmchan_header->attached), -1) == 1;
+
+    compat_shm_close(shmchan_name, shmchan_size, shmchan_rw, shmchan_ro, last);
+
+    shmchan_header = NULL;
+    shmchan_rw = NULL;
+    shmchan_ro = NULL;
+    shmchan_out = NULL;
+    shmchan_in = NULL;
+    shmchan_peeked = 0;
+}
+
+bool shmchan_is_open()
+{
+    return shmchan_header != NULL;
+}
+
+// Copies message into outgoing ring and wakes the other side. Never blocks,
+// returns `false` if ring does not have room for the message.
+bool shmchan_send(const void* data, int size)
+{
+    if (shmchan_header == NULL || size < 0) {
+        return false;
+    }
+
+    ShmChanRing* ring = shmchan_out;
+    unsigned int capacity = ring->capacity;
+    unsigned int messageSize = shmchan_message_size((unsigned int)size);
+    if (messageSize > capacity / 2) {
+        return false;
+    }
+
+    // Only this process advances head, reading it back is not racy.
+    unsigned int head = (unsigned int)SDL_AtomicGet(&(ring->head));
+    unsigned int tail = (unsigned int)SDL_AtomicGet(&(ring->tail));
+
+    unsigned int position = head & (capacity - 1);
+    unsigned int contiguous = capacity - position;
+    unsigned int required = messageSize <= contiguous ? messageSize : contiguous + messageSize;
+
+    if (capacity - (head - tail) < required) {
+        shmchan_stats.dropped++;
+        return false;
+    }
+
+    unsigned char* base = shmchan_rw + ring->offset;
+
+    if (messageSize > contiguous) {
+        *(unsigned int*)(base + position) = SHMCHAN_WRAP;
+        head += contiguous;
+        position = 0;
+    }
+
+    *(unsigned int*)(base + position) = (unsigned int)size;
+    memcpy(base + position + sizeof(unsigned int), data, (size_t)size);
+
+    // Atomic set is a full barrier, payload is visible before new head.
+    SDL_AtomicSet(&(ring->head), (int)(head + messageSize));
+    SDL_AtomicAdd(&(ring->seq), 1);
+
+    if (SDL_AtomicGet(&(ring->waiters)) != 0) {
+        compat_futex_wake(&(ring->seq.value));
+    }
+
+    shmchan_stats.sent++;
+
+    return true;
+}
+
+// Returns next incoming message without copying it. Pointer stays valid until
+// `shmchan_consume`. Returns `false` when there are no messages.
+bool shmchan_peek(const void** dataPtr, int* sizePtr)
+{
+    if (shmchan_header == NULL) {
+        return false;
+    }
+
+    ShmChanRing* ring = shmchan_in;
+    unsigned int capacity = ring->capacity;
+    const unsigned char* base = shmchan_rw + ring->offset;
+
+    unsigned int tail = (unsigned int)SDL_AtomicGet(&(ring->tail));
+    unsigned int head = (unsigned int)SDL_AtomicGet(&(ring->head));
+    if (tail == head) {
+        shmchan_peeked = 0;
+        return false;
+    }
+
+    unsigned int position = tail & (capacity - 1);
+    unsigned int size = *(const unsigned int*)(base + position);
+    if (size == SHMCHAN_WRAP) {
+        tail += capacity - position;
+        SDL_AtomicSet(&(ring->tail), (int)tail);
+
+        if (tail == head) {
+            shmchan_peeked = 0;
+            return false;
+        }
+
+        position = 0;
+        size = *(const unsigned int*)base;
+    }
+
+    shmchan_peeked = shmchan_message_size(size);
+
+    *dataPtr = base + position + sizeof(unsigned int);
+    *sizePtr = (int)size;
+
+    return true;
+}
+
+// Releases message returned by last `shmchan_peek`.
+void shmchan_consume()
+{
+    if (shmchan_header == NULL || shmchan_peeked == 0) {
+        return;
+    }
+
+    ShmChanRing* ring = shmchan_in;
+    SDL_AtomicAdd(&(ring->tail), (int)shmchan_peeked);
+    shmchan_peeked = 0;
+
+    shmchan_stats.received++;
+}
+
+// Waits until there is incoming message or `timeout` ms pass (-1 waits
+// forever). May return early, callers are expected to peek in a loop. Returns
+// `true` if message is available.
+bool shmchan_wait(int timeout)
+{
+    if (shmchan_header == NULL) {
+        return false;
+    }
+
+    ShmChanRing* ring = shmchan_in;
+
+    int seq = SDL_AtomicGet(&(ring->seq));
+    if (SDL_AtomicGet(&(ring->head)) != SDL_AtomicGet(&(ring->tail))) {
+        return true;
+    }
+
+    // Waiter count is published before sequence is checked by futex, so
+    // producer either sees the waiter or the futex sees new sequence.
+    SDL_AtomicAdd(&(ring->waiters), 1);
+    if (!compat_futex_wait(&(ring->seq.value), seq, timeout)) {
+        SDL_Delay(timeout < 0 || timeout > 1 ? 1 : (Uint32)timeout);
+    }
+    SDL_AtomicAdd(&(ring->waiters), -1);
+
+    return SDL_AtomicGet(&(ring->head)) != SDL_AtomicGet(&(ring->tail));
+}
+
+void shmchan_get_stats(ShmChanStats* stats)
+{
+    *stats = shmchan_stats;
+}
+
+} // namespace fallout
@@ -0,0 +1,33 @@
+#ifndef FALLOUT_GAME_SHMCHAN_H_
+#define FALLOUT_GAME_SHMCHAN_H_
+
+namespace fallout {
+
+typedef enum ShmChanRole {
+    // Sends to state ring, receives from command ring.
+    SHMCHAN_ROLE_GAME,
+
+    // Sends to command ring, receives from state ring.
+    SHMCHAN_ROLE_CONTROLLER,
+} ShmChanRole;
+
+typedef struct ShmChanStats {
+    unsigned int sent;
+    unsigned int received;
+
+    // Number of messages not sent because outgoing ring was full.
+    unsigned int dropped;
+} ShmChanStats;
+
+bool shmchan_open(const char* name, int role, int stateCapacity, int commandCapacity);
+void shmchan_close();
+bool shmchan_is_open();
+bool shmchan_send(const void* data, int size);
+bool shmchan_peek(const void** dataPtr, int* sizePtr);
+void shmchan_consume();
+bool shmchan_wait(int timeout);
+void shmchan_get_stats(ShmChanStats* stats);
+
+} // namespace fallout
+
+#endif /* FALLOUT_GAME_SHMCHAN_H_ */
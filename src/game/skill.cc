@@ -21,6 +21,7 @@
 #include "game/roll.h"
 #include "game/scripts.h"
 #include "game/stat.h"
+#include "game/statever.h"
 #include "game/trait.h"
 #include "platform_compat.h"
 #include "plib/color/color.h"
@@ -189,6 +190,9 @@ void skill_set_tags(int* skills, int count)
     for (index = 0; index < count; index++) {
         tag_skill[index] = skills[index];
     }
+
+    // CE: Tagged skills affect accuracy.
+    combat_to_hit_cache_invalidate();
 }
 
 // 0x498364
@@ -295,6 +299,7 @@ int skill_inc_point(Object* obj, int skill)
     rc = stat_pc_set(PC_STAT_UNSPENT_SKILL_POINTS, unspent_skill_points - 1);
     if (rc == 0) {
         proto->critter.data.skills[skill] += 1;
+        statever_bump(STATE_VERSION_STATS);
     }
 
     return rc;
@@ -326,6 +331,7 @@ int skill_dec_point(Object* critter, int skill)
     rc = stat_pc_set(PC_STAT_UNSPENT_SKILL_POINTS, unspent_skill_points + 1);
     if (rc == 0) {
         proto->critter.data.skills[skill] -= 1;
+        statever_bump(STATE_VERSION_STATS);
     }
 
     return 0;
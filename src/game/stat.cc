@@ -1,6 +1,7 @@
 #include "game/stat.h"
 
 #include <limits.h>
+#include <stdint.h>
 #include <stdio.h>
 
 #include <algorithm>
@@ -19,14 +20,32 @@
 #include "game/roll.h"
 #include "game/scripts.h"
 #include "game/skill.h"
+#include "game/statever.h"
 #include "game/tile.h"
 #include "game/trait.h"
 #include "platform_compat.h"
+#include "plib/gnw/debug.h"
 #include "plib/gnw/input.h"
 #include "plib/gnw/memory.h"
 
 namespace fallout {
 
+// CE: Number of slots in `stat_cache` (power of 2).
+#define STAT_CACHE_SIZE 64
+
+// CE: Memoized `base + bonus` of saveable stats of critter proto. Looking up
+// proto is a linear search, and the sum only changes when proto data is
+// written, which always goes through `stat_cache_invalidate`. Adjustments
+// depending on traits, time and combat state are applied on every call.
+typedef struct StatCacheEntry {
+    int pid;
+    unsigned int generation;
+    uint64_t valid;
+    int values[SAVEABLE_STAT_COUNT];
+} StatCacheEntry;
+
+static int stat_cached_sum(Object* critter, int stat);
+
 // Provides metadata about stats.
 typedef struct StatDescription {
     char* name;
@@ -100,6 +119,13 @@ static char* level_description[PRIMARY_STAT_RANGE];
 // 0x6651FC
 static int curr_pc_stat[PC_STAT_COUNT];
 
+// CE: Direct-mapped by pid, colliding protos simply replace each other.
+static StatCacheEntry stat_cache[STAT_CACHE_SIZE];
+
+// CE: Bumped whenever stats of any proto change, invalidates every entry of
+// `stat_cache` at once.
+static unsigned int stat_cache_generation = 1;
+
 // 0x49C2F0
 int stat_init()
 {
@@ -187,8 +213,12 @@ int stat_level(Object* critter, int stat)
 {
     int value;
     if (stat >= 0 && stat < SAVEABLE_STAT_COUNT) {
-        value = stat_get_base(critter, stat);
-        value += stat_get_bonus(critter, stat);
+        // CE: Same as `stat_get_base` plus `stat_get_bonus`, with proto part
+        // memoized.
+        value = stat_cached_sum(critter, stat);
+        if (critter == obj_dude) {
+            value += trait_adjust_stat(stat);
+        }
 
         switch (stat) {
         case STAT_PERCEPTION:
@@ -306,6 +336,8 @@ int stat_set_base(Object* critter, int stat, int value)
 
         proto_ptr(critter->pid, &proto);
         proto->critter.data.baseStats[stat] = value;
+        statever_bump(STATE_VERSION_STATS);
+        stat_cache_invalidate();
 
         if (stat >= STAT_STRENGTH && stat <= STAT_LUCK) {
             stat_recalc_derived(critter);
@@ -362,6 +394,8 @@ int stat_set_bonus(Object* critter, int stat, int value)
         Proto* proto;
         proto_ptr(critter->pid, &proto);
         proto->critter.data.bonusStats[stat] = value;
+        statever_bump(STATE_VERSION_STATS);
+        stat_cache_invalidate();
 
         if (stat >= STAT_STRENGTH && stat <= STAT_LUCK) {
             stat_recalc_derived(critter);
@@ -392,6 +426,8 @@ void stat_set_defaults(CritterProtoData* data)
         data->baseStats[stat] = stat_data[stat].defaultValue;
         data->bonusStats[stat] = 0;
     }
+
+    stat_cache_invalidate();
 }
 
 // 0x49C8D4
@@ -419,6 +455,78 @@ void stat_recalc_derived(Object* critter)
     data->baseStats[STAT_BETTER_CRITICALS] = 0;
     data->baseStats[STAT_RADIATION_RESISTANCE] = 2 * endurance;
     data->baseStats[STAT_POISON_RESISTANCE] = 5 * endurance;
+
+    stat_cache_invalidate();
+}
+
+// CE: Returns `stat_get_base_direct` plus `stat_get_bonus` of saveable
+// stat, from `stat_cache` when possible.
+static int stat_cached_sum(Object* critter, int stat)
+{
+    int pid = critter->pid;
+    StatCacheEntry* entry = &(stat_cache[(pid ^ (pid >> 24)) & (STAT_CACHE_SIZE - 1)]);
+    if (entry->pid != pid || entry->generation != stat_cache_generation) {
+        entry->pid = pid;
+        entry->generation = stat_cache_generation;
+        entry->valid = 0;
+    }
+
+    uint64_t mask = (uint64_t)1 << stat;
+    if ((entry->valid & mask) != 0) {
+#ifdef _DEBUG
+        int value = stat_get_base_direct(critter, stat) + stat_get_bonus(critter, stat);
+        if (entry->values[stat] != value) {
+            debug_printf("stat_cache: stale stat %d of pid %d: cached %d, actual %d\n", stat, pid, entry->values[stat], value);
+        }
+#endif
+        return entry->values[stat];
+    }
+
+    Proto* proto;
+    if (proto_ptr(pid, &proto) == -1) {
+        // Let original accessors deal with missing proto.
+        return stat_get_base_direct(critter, stat) + stat_get_bonus(critter, stat);
+    }
+
+    int value = proto->critter.data.baseStats[stat] + proto->critter.data.bonusStats[stat];
+    entry->values[stat] = value;
+    entry->valid |= mask;
+
+    return value;
+}
+
+// CE: Must be called after writing stats of any critter proto.
+void stat_cache_invalidate()
+{
+    stat_cache_generation++;
+    if (stat_cache_generation == 0) {
+        stat_cache_generation = 1;
+    }
+
+    // Skill points live in the same protos.
+    combat_to_hit_cache_invalidate();
+}
+
+// CE: Verifies memoized stats of `critter` against proto data. Returns false
+// if any of them is stale, which means some proto write misses
+// `stat_cache_invalidate`.
+bool stat_check_cache(Object* critter)
+{
+    int pid = critter->pid;
+    StatCacheEntry* entry = &(stat_cache[(pid ^ (pid >> 24)) & (STAT_CACHE_SIZE - 1)]);
+    if (entry->pid != pid || entry->generation != stat_cache_generation) {
+        return true;
+    }
+
+    for (int stat = 0; stat < SAVEABLE_STAT_COUNT; stat++) {
+        if ((entry->valid & ((uint64_t)1 << stat)) != 0) {
+            if (entry->values[stat] != stat_get_base_direct(critter, stat) + stat_get_bonus(critter, stat)) {
+                return false;
+            }
+        }
+    }
+
+    return true;
 }
 
 // 0x49CA2C
@@ -469,6 +577,7 @@ int stat_pc_set(int pc_stat, int value)
     }
 
     curr_pc_stat[pc_stat] = value;
+    statever_bump(STATE_VERSION_STATS);
 
     if (pc_stat == PC_STAT_EXPERIENCE) {
         rc = stat_pc_add_experience(0);
@@ -586,6 +695,7 @@ int stat_pc_add_experience(int xp)
     }
 
     curr_pc_stat[PC_STAT_EXPERIENCE] = xp;
+    statever_bump(STATE_VERSION_STATS);
 
     while (stat_pc_get(PC_STAT_LEVEL) < PC_LEVEL_MAX && xp >= stat_pc_min_exp()) {
         if (stat_pc_set(PC_STAT_LEVEL, stat_pc_get(PC_STAT_LEVEL) + 1) == 0) {
@@ -25,6 +25,8 @@ int dec_stat(Object* critter, int stat);
 int stat_set_bonus(Object* critter, int stat, int value);
 void stat_set_defaults(CritterProtoData* data);
 void stat_recalc_derived(Object* critter);
+void stat_cache_invalidate();
+bool stat_check_cache(Object* critter);
 char* stat_name(int stat);
 char* stat_description(int stat);
 char* stat_level_description(int value);
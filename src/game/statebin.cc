@@ -0,0 +1,611 @@
+#include "game/statebin.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include "game/combat.h"
+#include "game/critter.h"
+#include "game/gdialog.h"
+#include "game/map.h"
+#include "game/object.h"
+#include "game/scripts.h"
+#include "game/skill.h"
+#include "game/stat.h"
+#include "game/statever.h"
+#include "game/tile.h"
+
+namespace fallout {
+
+static uint32_t statebin_add_string(const char* string);
+static uint32_t statebin_add_string_length(const char* string, size_t length);
+static void statebin_collect_objects(const StateBinOptions* options);
+static void statebin_collect_inventory(const StateBinOptions* options);
+static uint32_t statebin_fix_string(uint32_t offset, uint32_t base);
+static bool statebin_section_changed(int type, const uint32_t* versions, const StateBinOptions* options);
+static void statebin_json_string(std::string* json, const char* string);
+static void statebin_json_printf(std::string* json, const char* format, ...);
+
+// Object types reported in objects section. Walls and tiles are static and
+// far too many.
+static const int statebin_object_types[] = {
+    OBJ_TYPE_ITEM,
+    OBJ_TYPE_CRITTER,
+    OBJ_TYPE_SCENERY,
+    OBJ_TYPE_MISC,
+};
+
+// Subsystems each section is derived from, section is left out of delta
+// documents when none of them changed. Sections without subsystems are
+// always present (dialog has its own version, see `StateBinDialog`).
+static const unsigned int statebin_section_subsystems[STATEBIN_SECTION_COUNT] = {
+    (1 << STATE_VERSION_OBJECTS) | (1 << STATE_VERSION_STATS) | (1 << STATE_VERSION_INVENTORY),
+    (1 << STATE_VERSION_OBJECTS) | (1 << STATE_VERSION_PARTY),
+    1 << STATE_VERSION_INVENTORY,
+    0,
+    1 << STATE_VERSION_COMBAT,
+    0,
+};
+
+// Scratch storage reused between encodes, so steady state encoding does not
+// allocate. String offsets in records are relative to `statebin_strings`
+// until the document is laid out.
+static std::vector<StateBinObject> statebin_objects_scratch;
+static std::vector<StateBinItem> statebin_items_scratch;
+static std::vector<char> statebin_strings;
+
+// Appends string to strings section, returns its relative offset. Offset 0
+// is reserved for "no string".
+static uint32_t statebin_add_string(const char* string)
+{
+    if (string == NULL) {
+        return 0;
+    }
+
+    return statebin_add_string_length(string, strlen(string));
+}
+
+// Same as `statebin_add_string`, for strings whose length is known (which
+// need not be terminated).
+static uint32_t statebin_add_string_length(const char* string, size_t length)
+{
+    if (string == NULL) {
+        return 0;
+    }
+
+    uint32_t offset = static_cast<uint32_t>(statebin_strings.size());
+    statebin_strings.insert(statebin_strings.end(), string, string + length);
+    statebin_strings.push_back('\0');
+    return offset;
+}
+
+static uint32_t statebin_fix_string(uint32_t offset, uint32_t base)
+{
+    return offset != 0 ? base + offset : 0;
+}
+
+static bool statebin_section_changed(int type, const uint32_t* versions, const StateBinOptions* options)
+{
+    if (options->baseVersions == NULL || statebin_section_subsystems[type] == 0) {
+        return true;
+    }
+
+    for (int subsystem = 0; subsystem < STATE_VERSION_COUNT; subsystem++) {
+        if ((statebin_section_subsystems[type] & (1 << subsystem)) != 0
+            && options->baseVersions[subsystem] != versions[subsystem]) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void statebin_collect_objects(const StateBinOptions* options)
+{
+    statebin_objects_scratch.clear();
+
+    if (obj_dude == NULL || obj_dude->tile == -1) {
+        return;
+    }
+
+    for (int type : statebin_object_types) {
+        Object* obj = obj_find_first_of_type(type, obj_dude->elevation);
+        while (obj != NULL) {
+            if (obj != obj_dude && (obj->flags & OBJECT_HIDDEN) == 0) {
+                int distance = tile_dist(obj_dude->tile, obj->tile);
+                if (distance <= options->objectRadius) {
+                    StateBinObject record;
+                    record.id = obj->id;
+                    record.pid = obj->pid;
+                    record.fid = obj->fid;
+                    record.tile = obj->tile;
+                    record.rotation = obj->rotation;
+                    record.flags = obj->flags;
+                    record.distance = distance;
+
+                    if (type == OBJ_TYPE_CRITTER) {
+                        record.hp = obj->data.critter.hp;
+                        record.team = obj->data.critter.combat.team;
+                        record.dead = critter_is_dead(obj) ? 1 : 0;
+                    } else {
+                        record.hp = -1;
+                        record.team = -1;
+                        record.dead = 0;
+                    }
+
+                    record.name = options->names ? statebin_add_string(object_name(obj)) : 0;
+
+                    statebin_objects_scratch.push_back(record);
+                }
+            }
+            obj = obj_find_next_of_type();
+        }
+    }
+
+    // Type lists are unordered, sort so equal states encode equally.
+    std::sort(statebin_objects_scratch.begin(), statebin_objects_scratch.end(), [](const StateBinObject& a, const StateBinObject& b) {
+        if (a.distance != b.distance) {
+            return a.distance < b.distance;
+        }
+        return a.id < b.id;
+    });
+}
+
+static void statebin_collect_inventory(const StateBinOptions* options)
+{
+    statebin_items_scratch.clear();
+
+    if (obj_dude == NULL) {
+        return;
+    }
+
+    Inventory* inventory = &(obj_dude->data.inventory);
+    for (int index = 0; index < inventory->length; index++) {
+        InventoryItem* inventoryItem = &(inventory->items[index]);
+
+        StateBinItem record;
+        record.id = inventoryItem->item->id;
+        record.pid = inventoryItem->item->pid;
+        record.quantity = inventoryItem->quantity;
+        record.equipped = inventoryItem->item->flags & OBJECT_EQUIPPED;
+        record.name = options->names ? statebin_add_string(object_name(inventoryItem->item)) : 0;
+
+        statebin_items_scratch.push_back(record);
+    }
+}
+
+// Encodes current game state into `buffer` (replacing its contents). Returns
+// size of the document.
+size_t statebin_encode(std::vector<unsigned char>* buffer, unsigned int sequence, const StateBinOptions* options)
+{
+    statebin_strings.clear();
+    statebin_strings.push_back('\0');
+
+    uint32_t versions[STATE_VERSION_COUNT];
+    for (int subsystem = 0; subsystem < STATE_VERSION_COUNT; subsystem++) {
+        versions[subsystem] = statever_get(subsystem);
+    }
+
+    // Unchanged sections are not collected at all, which is where delta
+    // documents save most of the time.
+    uint32_t included = 0;
+    for (int type = 0; type < STATEBIN_SECTION_COUNT; type++) {
+        if (statebin_section_changed(type, versions, options)) {
+            included |= 1 << type;
+        }
+    }
+
+    bool hasDude = (included & (1 << STATEBIN_SECTION_DUDE)) != 0;
+
+    StateBinDude dude;
+    memset(&dude, 0, sizeof(dude));
+    if (hasDude && obj_dude != NULL) {
+        dude.id = obj_dude->id;
+        dude.tile = obj_dude->tile;
+        dude.elevation = obj_dude->elevation;
+        dude.rotation = obj_dude->rotation;
+        dude.fid = obj_dude->fid;
+        dude.name = statebin_add_string(critter_name(obj_dude));
+
+        for (int stat = 0; stat < STAT_COUNT; stat++) {
+            dude.stats[stat] = stat_level(obj_dude, stat);
+        }
+
+        for (int pcStat = 0; pcStat < PC_STAT_COUNT; pcStat++) {
+            dude.pcStats[pcStat] = stat_pc_get(pcStat);
+        }
+
+        for (int skill = 0; skill < SKILL_COUNT; skill++) {
+            dude.skills[skill] = skill_level(obj_dude, skill);
+        }
+    }
+
+    if ((included & (1 << STATEBIN_SECTION_OBJECTS)) != 0) {
+        statebin_collect_objects(options);
+    } else {
+        statebin_objects_scratch.clear();
+    }
+
+    if ((included & (1 << STATEBIN_SECTION_INVENTORY)) != 0) {
+        statebin_collect_inventory(options);
+    } else {
+        statebin_items_scratch.clear();
+    }
+
+    bool inDialog = dialog_active();
+
+    StateBinDialog dialog;
+    memset(&dialog, 0, sizeof(dialog));
+    dialog.version = gdialog_get_state_version();
+    if (inDialog) {
+        dialog.optionCount = std::min(gdialog_get_option_count(), STATEBIN_DIALOG_OPTIONS_MAX);
+        dialog.reply = statebin_add_string_length(gdialog_get_reply_text(), gdialog_get_reply_text_length());
+        for (int index = 0; index < dialog.optionCount; index++) {
+            dialog.options[index] = statebin_add_string_length(gdialog_get_option_text(index), gdialog_get_option_text_length(index));
+        }
+    }
+
+    bool inCombat = isInCombat();
+    bool hasCombat = inCombat && (included & (1 << STATEBIN_SECTION_COMBAT)) != 0;
+
+    StateBinCombat combat;
+    combat.turnObjectId = -1;
+    combat.freeMove = 0;
+    combat.ap = 0;
+    if (hasCombat) {
+        Object* turnObject = combat_whose_turn();
+        combat.turnObjectId = turnObject != NULL ? turnObject->id : -1;
+        combat.freeMove = combat_free_move;
+        combat.ap = obj_dude != NULL ? obj_dude->data.critter.combat.ap : 0;
+    }
+
+    // Lay out sections.
+    StateBinHeader header;
+    memset(&header, 0, sizeof(header));
+
+    uint32_t offset = sizeof(header);
+
+    header.sections[STATEBIN_SECTION_DUDE].offset = offset;
+    header.sections[STATEBIN_SECTION_DUDE].count = hasDude ? 1 : 0;
+    offset += hasDude ? sizeof(StateBinDude) : 0;
+
+    header.sections[STATEBIN_SECTION_OBJECTS].offset = offset;
+    header.sections[STATEBIN_SECTION_OBJECTS].count = static_cast<uint32_t>(statebin_objects_scratch.size());
+    offset += static_cast<uint32_t>(sizeof(StateBinObject) * statebin_objects_scratch.size());
+
+    header.sections[STATEBIN_SECTION_INVENTORY].offset = offset;
+    header.sections[STATEBIN_SECTION_INVENTORY].count = static_cast<uint32_t>(statebin_items_scratch.size());
+    offset += static_cast<uint32_t>(sizeof(StateBinItem) * statebin_items_scratch.size());
+
+    header.sections[STATEBIN_SECTION_DIALOG].offset = offset;
+    header.sections[STATEBIN_SECTION_DIALOG].count = inDialog ? 1 : 0;
+    offset += inDialog ? sizeof(StateBinDialog) : 0;
+
+    header.sections[STATEBIN_SECTION_COMBAT].offset = offset;
+    header.sections[STATEBIN_SECTION_COMBAT].count = hasCombat ? 1 : 0;
+    offset += hasCombat ? sizeof(StateBinCombat) : 0;
+
+    uint32_t stringsBase = offset;
+    header.sections[STATEBIN_SECTION_STRINGS].offset = offset;
+    header.sections[STATEBIN_SECTION_STRINGS].count = static_cast<uint32_t>(statebin_strings.size());
+    offset += static_cast<uint32_t>(statebin_strings.size());
+
+    // Keep buffer size multiple of 4 so documents can be concatenated
+    // without breaking alignment.
+    offset = (offset + 3) & ~3u;
+
+    header.magic = STATEBIN_MAGIC;
+    header.version = STATEBIN_VERSION;
+    header.size = offset;
+    header.sequence = sequence;
+    header.gameTime = static_cast<uint32_t>(game_time());
+    header.map = map_get_index_number();
+    header.elevation = map_elevation;
+    header.flags = (inCombat ? STATEBIN_FLAG_IN_COMBAT : 0) | (inDialog ? STATEBIN_FLAG_IN_DIALOG : 0);
+    header.included = included;
+    memcpy(header.versions, versions, sizeof(versions));
+
+    // Write document. Buffer capacity is retained between calls.
+    buffer->resize(offset);
+    unsigned char* data = buffer->data();
+    memset(data + stringsBase, 0, offset - stringsBase);
+
+    memcpy(data, &header, sizeof(header));
+
+    if (hasDude) {
+        dude.name = statebin_fix_string(dude.name, stringsBase);
+        memcpy(data + header.sections[STATEBIN_SECTION_DUDE].offset, &dude, sizeof(dude));
+    }
+
+    StateBinObject* objects = reinterpret_cast<StateBinObject*>(data + header.sections[STATEBIN_SECTION_OBJECTS].offset);
+    for (size_t index = 0; index < statebin_objects_scratch.size(); index++) {
+        objects[index] = statebin_objects_scratch[index];
+        objects[index].name = statebin_fix_string(objects[index].name, stringsBase);
+    }
+
+    StateBinItem* items = reinterpret_cast<StateBinItem*>(data + header.sections[STATEBIN_SECTION_INVENTORY].offset);
+    for (size_t index = 0; index < statebin_items_scratch.size(); index++) {
+        items[index] = statebin_items_scratch[index];
+        items[index].name = statebin_fix_string(items[index].name, stringsBase);
+    }
+
+    if (inDialog) {
+        dialog.reply = statebin_fix_string(dialog.reply, stringsBase);
+        for (int index = 0; index < dialog.optionCount; index++) {
+            dialog.options[index] = statebin_fix_string(dialog.options[index], stringsBase);
+        }
+        memcpy(data + header.sections[STATEBIN_SECTION_DIALOG].offset, &dialog, sizeof(dialog));
+    }
+
+    if (hasCombat) {
+        memcpy(data + header.sections[STATEBIN_SECTION_COMBAT].offset, &combat, sizeof(combat));
+    }
+
+    memcpy(data + stringsBase, statebin_strings.data(), statebin_strings.size());
+
+    return offset;
+}
+
+// Validates document and returns its header, or `NULL` if document is
+// malformed or of another version. Returned pointer (and every record
+// obtained from it) points into `data`.
+const StateBinHeader* statebin_header(const void* data, size_t size)
+{
+    if (data == NULL || size < sizeof(StateBinHeader)) {
+        return NULL;
+    }
+
+    const StateBinHeader* header = static_cast<const StateBinHeader*>(data);
+    if (header->magic != STATEBIN_MAGIC || header->version != STATEBIN_VERSION || header->size > size) {
+        return NULL;
+    }
+
+    static const size_t recordSizes[STATEBIN_SECTION_COUNT] = {
+        sizeof(StateBinDude),
+        sizeof(StateBinObject),
+        sizeof(StateBinItem),
+        sizeof(StateBinDialog),
+        sizeof(StateBinCombat),
+        1,
+    };
+
+    for (int type = 0; type < STATEBIN_SECTION_COUNT; type++) {
+        const StateBinSection* section = &(header->sections[type]);
+        if (section->offset < sizeof(StateBinHeader)
+            || section->offset > header->size
+            || section->count > (header->size - section->offset) / recordSizes[type]) {
+            return NULL;
+        }
+    }
+
+    // Strings section must end with terminator so lookups cannot run past
+    // the buffer.
+    const StateBinSection* strings = &(header->sections[STATEBIN_SECTION_STRINGS]);
+    if (strings->count == 0 || static_cast<const char*>(data)[strings->offset + strings->count - 1] != '\0') {
+        return NULL;
+    }
+
+    return header;
+}
+
+const void* statebin_section(const StateBinHeader* header, int type, int* countPtr)
+{
+    if (type < 0 || type >= STATEBIN_SECTION_COUNT) {
+        *countPtr = 0;
+        return NULL;
+    }
+
+    *countPtr = static_cast<int>(header->sections[type].count);
+    return reinterpret_cast<const unsigned char*>(header) + header->sections[type].offset;
+}
+
+// Returns `true` if section is present in document. Absent sections are
+// unchanged since the document whose versions were passed to encoder.
+bool statebin_section_included(const StateBinHeader* header, int type)
+{
+    if (type < 0 || type >= STATEBIN_SECTION_COUNT) {
+        return false;
+    }
+
+    return (header->included & (1 << type)) != 0;
+}
+
+// Returns `NULL` when left out as unchanged.
+const StateBinDude* statebin_dude(const StateBinHeader* header)
+{
+    int count;
+    const void* section = statebin_section(header, STATEBIN_SECTION_DUDE, &count);
+    return count != 0 ? static_cast<const StateBinDude*>(section) : NULL;
+}
+
+const StateBinObject* statebin_objects(const StateBinHeader* header, int* countPtr)
+{
+    return static_cast<const StateBinObject*>(statebin_section(header, STATEBIN_SECTION_OBJECTS, countPtr));
+}
+
+const StateBinItem* statebin_inventory(const StateBinHeader* header, int* countPtr)
+{
+    return static_cast<const StateBinItem*>(statebin_section(header, STATEBIN_SECTION_INVENTORY, countPtr));
+}
+
+// Returns `NULL` when dialog is not active.
+const StateBinDialog* statebin_dialog(const StateBinHeader* header)
+{
+    int count;
+    const void* section = statebin_section(header, STATEBIN_SECTION_DIALOG, &count);
+    return count != 0 ? static_cast<const StateBinDialog*>(section) : NULL;
+}
+
+// Returns `NULL` when combat is not active or left out as unchanged.
+const StateBinCombat* statebin_combat(const StateBinHeader* header)
+{
+    int count;
+    const void* section = statebin_section(header, STATEBIN_SECTION_COMBAT, &count);
+    return count != 0 ? static_cast<const StateBinCombat*>(section) : NULL;
+}
+
+// Returns string at given offset, or empty string when offset is 0 or does
+// not point into strings section.
+const char* statebin_string(const StateBinHeader* header, uint32_t offset)
+{
+    const StateBinSection* strings = &(header->sections[STATEBIN_SECTION_STRINGS]);
+    if (offset < strings->offset || offset >= strings->offset + strings->count) {
+        return "";
+    }
+
+    return reinterpret_cast<const char*>(header) + offset;
+}
+
+static void statebin_json_string(std::string* json, const char* string)
+{
+    json->push_back('"');
+    for (const char* ch = string; *ch != '\0'; ch++) {
+        unsigned char value = static_cast<unsigned char>(*ch);
+        if (value == '"' || value == '\\') {
+            json->push_back('\\');
+            json->push_back(*ch);
+        } else if (value < 0x20) {
+            statebin_json_printf(json, "\\u%04x", value);
+        } else {
+            json->push_back(*ch);
+        }
+    }
+    json->push_back('"');
+}
+
+static void statebin_json_printf(std::string* json, const char* format, ...)
+{
+    char buffer[256];
+
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+
+    if (length > 0) {
+        json->append(buffer, std::min(static_cast<size_t>(length), sizeof(buffer) - 1));
+    }
+}
+
+// Formats document as JSON. Meant for debugging and for controllers which
+// cannot read binary documents, the content is the same. Sections left out
+// as unchanged have no key.
+void statebin_to_json(const StateBinHeader* header, std::string* json)
+{
+    json->clear();
+
+    statebin_json_printf(json, "{\"version\":%u,\"sequence\":%u,\"game_time\":%u,\"map\":%d,\"elevation\":%d",
+        header->version,
+        header->sequence,
+        header->gameTime,
+        header->map,
+        header->elevation);
+
+    json->append(",\"versions\":[");
+    for (int subsystem = 0; subsystem < STATE_VERSION_COUNT; subsystem++) {
+        statebin_json_printf(json, subsystem != 0 ? ",%u" : "%u", header->versions[subsystem]);
+    }
+    json->push_back(']');
+
+    const StateBinDude* dude = statebin_dude(header);
+    if (dude != NULL) {
+        statebin_json_printf(json, ",\"dude\":{\"id\":%d,\"tile\":%d,\"elevation\":%d,\"rotation\":%d,\"fid\":%d,\"name\":",
+            dude->id,
+            dude->tile,
+            dude->elevation,
+            dude->rotation,
+            dude->fid);
+        statebin_json_string(json, statebin_string(header, dude->name));
+
+        json->append(",\"stats\":[");
+        for (int stat = 0; stat < STAT_COUNT; stat++) {
+            statebin_json_printf(json, stat != 0 ? ",%d" : "%d", dude->stats[stat]);
+        }
+
+        json->append("],\"pc_stats\":[");
+        for (int pcStat = 0; pcStat < PC_STAT_COUNT; pcStat++) {
+            statebin_json_printf(json, pcStat != 0 ? ",%d" : "%d", dude->pcStats[pcStat]);
+        }
+
+        json->append("],\"skills\":[");
+        for (int skill = 0; skill < SKILL_COUNT; skill++) {
+            statebin_json_printf(json, skill != 0 ? ",%d" : "%d", dude->skills[skill]);
+        }
+
+        json->append("]}");
+    }
+
+    if (statebin_section_included(header, STATEBIN_SECTION_OBJECTS)) {
+        int objectCount;
+        const StateBinObject* objects = statebin_objects(header, &objectCount);
+        json->append(",\"objects\":[");
+        for (int index = 0; index < objectCount; index++) {
+            const StateBinObject* object = &(objects[index]);
+            statebin_json_printf(json, "%s{\"id\":%d,\"pid\":%d,\"fid\":%d,\"tile\":%d,\"rotation\":%d,\"flags\":%d,\"distance\":%d,\"hp\":%d,\"team\":%d,\"dead\":%s,\"name\":",
+                index != 0 ? "," : "",
+                object->id,
+                object->pid,
+                object->fid,
+                object->tile,
+                object->rotation,
+                object->flags,
+                object->distance,
+                object->hp,
+                object->team,
+                object->dead ? "true" : "false");
+            statebin_json_string(json, statebin_string(header, object->name));
+            json->push_back('}');
+        }
+        json->push_back(']');
+    }
+
+    if (statebin_section_included(header, STATEBIN_SECTION_INVENTORY)) {
+        int itemCount;
+        const StateBinItem* items = statebin_inventory(header, &itemCount);
+        json->append(",\"inventory\":[");
+        for (int index = 0; index < itemCount; index++) {
+            const StateBinItem* item = &(items[index]);
+            statebin_json_printf(json, "%s{\"id\":%d,\"pid\":%d,\"quantity\":%d,\"equipped\":%d,\"name\":",
+                index != 0 ? "," : "",
+                item->id,
+                item->pid,
+                item->quantity,
+                item->equipped);
+            statebin_json_string(json, statebin_string(header, item->name));
+            json->push_back('}');
+        }
+        json->push_back(']');
+    }
+
+    const StateBinDialog* dialog = statebin_dialog(header);
+    if (dialog != NULL) {
+        statebin_json_printf(json, ",\"dialog\":{\"version\":%u,\"reply\":", dialog->version);
+        statebin_json_string(json, statebin_string(header, dialog->reply));
+        json->append(",\"options\":[");
+        for (int index = 0; index < dialog->optionCount && index < STATEBIN_DIALOG_OPTIONS_MAX; index++) {
+            if (index != 0) {
+                json->push_back(',');
+            }
+            statebin_json_string(json, statebin_string(header, dialog->options[index]));
+        }
+        json->append("]}");
+    } else {
+        json->append(",\"dialog\":null");
+    }
+
+    const StateBinCombat* combat = statebin_combat(header);
+    if (combat != NULL) {
+        statebin_json_printf(json, ",\"combat\":{\"turn\":%d,\"free_move\":%d,\"ap\":%d}",
+            combat->turnObjectId,
+            combat->freeMove,
+            combat->ap);
+    } else if ((header->flags & STATEBIN_FLAG_IN_COMBAT) == 0) {
+        json->append(",\"combat\":null");
+    }
+
+    json->push_back('}');
+}
+
+} // namespace fallout
@@ -0,0 +1,169 @@
+#ifndef FALLOUT_GAME_STATEBIN_H_
+#define FALLOUT_GAME_STATEBIN_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "game/skill_defs.h"
+#include "game/stat_defs.h"
+#include "game/statever.h"
+
+namespace fallout {
+
+// Binary encoding of game state for external controllers.
+//
+// Document is a single buffer in host byte order which starts with
+// `StateBinHeader`. Header points to sections of fixed size records, every
+// record field is 4 bytes wide and aligned, so readers access records directly
+// in the received buffer without parsing. Strings are NUL-terminated and
+// referenced by their offset from the start of the buffer (0 means no
+// string).
+//
+// Header carries subsystem version stamps (see `statever.h`). When encoder is
+// given stamps of a previously sent document, sections whose subsystems did
+// not change since are left out (their bit in `included` is clear), so
+// controllers only process what changed.
+//
+// Layout only changes together with `STATEBIN_VERSION`.
+
+#define STATEBIN_MAGIC 0x54534F46 // "FOST"
+#define STATEBIN_VERSION 2
+
+#define STATEBIN_DIALOG_OPTIONS_MAX 30
+
+typedef enum StateBinSectionType {
+    STATEBIN_SECTION_DUDE,
+    STATEBIN_SECTION_OBJECTS,
+    STATEBIN_SECTION_INVENTORY,
+    STATEBIN_SECTION_DIALOG,
+    STATEBIN_SECTION_COMBAT,
+    STATEBIN_SECTION_STRINGS,
+    STATEBIN_SECTION_COUNT,
+} StateBinSectionType;
+
+typedef enum StateBinFlags {
+    STATEBIN_FLAG_IN_COMBAT = 0x01,
+    STATEBIN_FLAG_IN_DIALOG = 0x02,
+} StateBinFlags;
+
+typedef struct StateBinSection {
+    // Offset from the start of the buffer.
+    uint32_t offset;
+
+    // Number of records (number of bytes for strings section).
+    uint32_t count;
+} StateBinSection;
+
+typedef struct StateBinHeader {
+    uint32_t magic;
+    uint32_t version;
+
+    // Size of the whole buffer.
+    uint32_t size;
+
+    // Caller-supplied sequence number (e.g. lockstep tick).
+    uint32_t sequence;
+
+    uint32_t gameTime;
+    int32_t map;
+    int32_t elevation;
+    uint32_t flags;
+
+    // Bit per section type, set when section is present in this document.
+    // Absent sections have no records and are unchanged since the base
+    // document.
+    uint32_t included;
+
+    uint32_t versions[STATE_VERSION_COUNT];
+    StateBinSection sections[STATEBIN_SECTION_COUNT];
+} StateBinHeader;
+
+typedef struct StateBinDude {
+    int32_t id;
+    int32_t tile;
+    int32_t elevation;
+    int32_t rotation;
+    int32_t fid;
+    uint32_t name;
+    int32_t stats[STAT_COUNT];
+    int32_t pcStats[PC_STAT_COUNT];
+    int32_t skills[SKILL_COUNT];
+} StateBinDude;
+
+typedef struct StateBinObject {
+    int32_t id;
+    int32_t pid;
+    int32_t fid;
+    int32_t tile;
+    int32_t rotation;
+    int32_t flags;
+
+    // Distance to player in hexes.
+    int32_t distance;
+
+    // Critters only, -1 for other objects.
+    int32_t hp;
+    int32_t team;
+    int32_t dead;
+
+    uint32_t name;
+} StateBinObject;
+
+typedef struct StateBinItem {
+    int32_t id;
+    int32_t pid;
+    int32_t quantity;
+
+    // `OBJECT_IN_LEFT_HAND`, `OBJECT_IN_RIGHT_HAND` and `OBJECT_WORN` bits of
+    // item flags.
+    int32_t equipped;
+
+    uint32_t name;
+} StateBinItem;
+
+typedef struct StateBinDialog {
+    // See `gdialog_get_state_version`.
+    uint32_t version;
+    int32_t optionCount;
+    uint32_t reply;
+    uint32_t options[STATEBIN_DIALOG_OPTIONS_MAX];
+} StateBinDialog;
+
+typedef struct StateBinCombat {
+    // Id of critter whose turn it is, -1 if none.
+    int32_t turnObjectId;
+    int32_t freeMove;
+    int32_t ap;
+} StateBinCombat;
+
+// Encoding options.
+typedef struct StateBinOptions {
+    // Radius (in hexes) around player for objects section.
+    int objectRadius;
+
+    // Specifies whether object and item names are included.
+    bool names;
+
+    // Version stamps from header of the last document controller has seen,
+    // or `NULL` to encode every section.
+    const uint32_t* baseVersions;
+} StateBinOptions;
+
+size_t statebin_encode(std::vector<unsigned char>* buffer, unsigned int sequence, const StateBinOptions* options);
+const StateBinHeader* statebin_header(const void* data, size_t size);
+const void* statebin_section(const StateBinHeader* header, int type, int* countPtr);
+bool statebin_section_included(const StateBinHeader* header, int type);
+const StateBinDude* statebin_dude(const StateBinHeader* header);
+const StateBinObject* statebin_objects(const StateBinHeader* header, int* countPtr);
+const StateBinItem* statebin_inventory(const StateBinHeader* header, int* countPtr);
+const StateBinDialog* statebin_dialog(const StateBinHeader* header);
+const StateBinCombat* statebin_combat(const StateBinHeader* header);
+const char* statebin_string(const StateBinHeader* header, uint32_t offset);
+void statebin_to_json(const StateBinHeader* header, std::string* json);
+
+} // namespace fallout
+
+#endif /* FALLOUT_GAME_STATEBIN_H_ */
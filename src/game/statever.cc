@@ -0,0 +1,63 @@
+#include "game/statever.h"
+
+#include "game/gamectx.h"
+
+namespace fallout {
+
+typedef struct StateVersionState {
+    unsigned int versions[STATE_VERSION_COUNT];
+} StateVersionState;
+
+static StateVersionState* statever_state();
+static void statever_state_init(void* data);
+
+static StateVersionState* statever_state()
+{
+    return (StateVersionState*)game_context_state(GAME_CONTEXT_SLOT_STATEVER, sizeof(StateVersionState), statever_state_init, NULL);
+}
+
+// Stamps start at 1 so that 0 can be used by controllers as "never seen".
+static void statever_state_init(void* data)
+{
+    StateVersionState* state = (StateVersionState*)data;
+
+    for (int subsystem = 0; subsystem < STATE_VERSION_COUNT; subsystem++) {
+        state->versions[subsystem] = 1;
+    }
+}
+
+// Marks subsystem as changed. Stamps only increase (0 is skipped on
+// wraparound).
+void statever_bump(int subsystem)
+{
+    if (subsystem < 0 || subsystem >= STATE_VERSION_COUNT) {
+        return;
+    }
+
+    StateVersionState* state = statever_state();
+
+    state->versions[subsystem]++;
+    if (state->versions[subsystem] == 0) {
+        state->versions[subsystem] = 1;
+    }
+}
+
+// Marks every subsystem as changed, used when state is replaced wholesale
+// (map or saved game load).
+void statever_bump_all()
+{
+    for (int subsystem = 0; subsystem < STATE_VERSION_COUNT; subsystem++) {
+        statever_bump(subsystem);
+    }
+}
+
+unsigned int statever_get(int subsystem)
+{
+    if (subsystem < 0 || subsystem >= STATE_VERSION_COUNT) {
+        return 0;
+    }
+
+    return statever_state()->versions[subsystem];
+}
+
+} // namespace fallout
@@ -0,0 +1,41 @@
+#ifndef FALLOUT_GAME_STATEVER_H_
+#define FALLOUT_GAME_STATEVER_H_
+
+namespace fallout {
+
+// Subsystems with version stamps. Stamp is bumped on every change of state
+// observed by external controllers, so they can skip unchanged parts. Stamps
+// may also be bumped without visible change (e.g. on map load), so equal
+// stamps mean "unchanged", but different stamps only mean "maybe changed".
+typedef enum StateVersionSubsystem {
+    // Position, rotation, HP and presence of objects on the map.
+    STATE_VERSION_OBJECTS,
+
+    // Stats, skills and experience of critters.
+    STATE_VERSION_STATS,
+
+    // Contents of inventories.
+    STATE_VERSION_INVENTORY,
+
+    // Party members.
+    STATE_VERSION_PARTY,
+
+    // Combat state, whose turn it is, and action points.
+    STATE_VERSION_COMBAT,
+
+    // Position on the world map.
+    STATE_VERSION_WORLDMAP,
+
+    // Global and map variables (quest state).
+    STATE_VERSION_GLOBALS,
+
+    STATE_VERSION_COUNT,
+} StateVersionSubsystem;
+
+void statever_bump(int subsystem);
+void statever_bump_all();
+unsigned int statever_get(int subsystem);
+
+} // namespace fallout
+
+#endif /* FALLOUT_GAME_STATEVER_H_ */
@@ -1,5 +1,6 @@
 #include "game/textobj.h"
 
+#include <limits.h>
 #include <string.h>
 
 #include "game/gconfig.h"
@@ -18,11 +19,30 @@ namespace fallout {
 // The maximum number of text objects that can exist at the same time.
 #define TEXT_OBJECTS_MAX_COUNT 20
 
+// CE: The maximum number of rendered messages kept for reuse.
+#define TEXT_OBJECT_IMAGE_CACHE_CAPACITY 16
+
 typedef enum TextObjectFlags {
     TEXT_OBJECT_MARKED_FOR_REMOVAL = 0x01,
     TEXT_OBJECT_UNBOUNDED = 0x02,
 } TextObjectFlags;
 
+// CE: Rendered message, shared by text objects showing the same string with
+// the same style.
+typedef struct TextObjectImage {
+    int refs;
+    bool cached;
+    unsigned int lastUse;
+    char* string;
+    int font;
+    int color;
+    int outlineColor;
+    int linesCount;
+    int width;
+    int height;
+    unsigned char* data;
+} TextObjectImage;
+
 typedef struct TextObject {
     int flags;
     Object* owner;
@@ -36,10 +56,17 @@ typedef struct TextObject {
     int width;
     int height;
     unsigned char* data;
+    TextObjectImage* image;
 } TextObject;
 
 static void text_object_bk();
 static void text_object_get_offset(TextObject* textObject);
+static TextObjectImage* text_object_image_get(char* string, int font, int color, int outlineColor);
+static TextObjectImage* text_object_image_render(char* string, int font, int color, int outlineColor);
+static void text_object_image_release(TextObjectImage* image);
+static void text_object_image_free(TextObjectImage* image);
+static void text_object_image_cache_flush();
+static void text_object_refresh_later(Rect* rect);
 
 // 0x508324
 static int text_object_index = 0;
@@ -68,6 +95,17 @@ static bool text_object_enabled;
 // 0x665270
 static bool text_object_initialized;
 
+// CE: Recently rendered messages, see `text_object_image_get`.
+static TextObjectImage* text_object_image_cache[TEXT_OBJECT_IMAGE_CACHE_CAPACITY];
+
+// CE: Use counter for evicting least recently used images from cache.
+static unsigned int text_object_image_clock;
+
+// CE: Union of screen areas changed by text objects since last background
+// tick, refreshed at once by `text_object_bk`.
+static Rect text_object_dirty_rect;
+static bool text_object_dirty;
+
 // 0x49CD80
 int text_object_init(unsigned char* windowBuffer, int width, int height)
 {
@@ -112,11 +150,12 @@ int text_object_reset()
     }
 
     for (index = 0; index < text_object_index; index++) {
-        mem_free(text_object_list[index]->data);
+        text_object_image_release(text_object_list[index]->image);
         mem_free(text_object_list[index]);
     }
 
     text_object_index = 0;
+    text_object_dirty = false;
     add_bk_process(text_object_bk);
 
     return 0;
@@ -127,6 +166,7 @@ void text_object_exit()
 {
     if (text_object_initialized) {
         text_object_reset();
+        text_object_image_cache_flush();
         remove_bk_process(text_object_bk);
         text_object_initialized = false;
     }
@@ -203,93 +243,26 @@ int text_object_create(Object* object, char* string, int font, int color, int a5
         return -1;
     }
 
-    TextObject* textObject = (TextObject*)mem_malloc(sizeof(*textObject));
-    if (textObject == NULL) {
-        return -1;
-    }
-
-    memset(textObject, 0, sizeof(*textObject));
-
-    int oldFont = text_curr();
-    text_font(font);
-
-    short beginnings[WORD_WRAP_MAX_COUNT];
-    short count;
-    if (word_wrap(string, 200, beginnings, &count) != 0) {
-        text_font(oldFont);
+    // CE: Rendering is shared with other text objects showing the same
+    // message (repeated floats in combat bursts and scripted crowds).
+    TextObjectImage* image = text_object_image_get(string, font, color, a5);
+    if (image == NULL) {
         return -1;
     }
 
-    textObject->linesCount = count - 1;
-    if (textObject->linesCount < 1) {
-        debug_printf("**Error in text_object_create()\n");
-    }
-
-    textObject->width = 0;
-
-    for (int index = 0; index < textObject->linesCount; index++) {
-        char* ending = string + beginnings[index + 1];
-        char* beginning = string + beginnings[index];
-        if (ending[-1] == ' ') {
-            --ending;
-        }
-
-        char c = *ending;
-        *ending = '\0';
-
-        // NOTE: Calls [text_width] twice, probably result of using min/max macro
-        int width = text_width(beginning);
-        if (width >= textObject->width) {
-            textObject->width = width;
-        }
-
-        *ending = c;
-    }
-
-    textObject->height = (text_height() + 1) * textObject->linesCount;
-
-    if (a5 != -1) {
-        textObject->width += 2;
-        textObject->height += 2;
-    }
-
-    int size = textObject->width * textObject->height;
-    textObject->data = (unsigned char*)mem_malloc(size);
-    if (textObject->data == NULL) {
-        text_font(oldFont);
+    TextObject* textObject = (TextObject*)mem_malloc(sizeof(*textObject));
+    if (textObject == NULL) {
+        text_object_image_release(image);
         return -1;
     }
 
-    memset(textObject->data, 0, size);
-
-    unsigned char* dest = textObject->data;
-    int skip = textObject->width * (text_height() + 1);
-
-    if (a5 != -1) {
-        dest += textObject->width;
-    }
-
-    for (int index = 0; index < textObject->linesCount; index++) {
-        char* beginning = string + beginnings[index];
-        char* ending = string + beginnings[index + 1];
-        if (ending[-1] == ' ') {
-            --ending;
-        }
-
-        char c = *ending;
-        *ending = '\0';
-
-        int width = text_width(beginning);
-        text_to_buf(dest + (textObject->width - width) / 2, beginning, textObject->width, textObject->width, color);
-
-        *ending = c;
+    memset(textObject, 0, sizeof(*textObject));
 
-        dest += skip;
-    }
-
-    if (a5 != -1) {
-        buf_outline(textObject->data, textObject->width, textObject->height, textObject->width, a5);
-    }
+    textObject->image = image;
+    textObject->data = image->data;
+    textObject->linesCount = image->linesCount;
+    textObject->width = image->width;
+    textObject->height = image->height;
 
     if (object != NULL) {
         textObject->tile = object->tile;
@@ -315,11 +288,21 @@ int text_object_create(Object* object, char* string, int font, int color, int a5
     text_object_list[text_object_index] = textObject;
     text_object_index++;
 
-    text_font(oldFont);
-
     return 0;
 }
 
+// CE: Schedules refresh of area of newly created text object. Objects created
+// during one frame are drawn in a single pass by next background tick instead
+// of refreshing map once per object.
+void text_object_refresh(Rect* rect)
+{
+    if (!text_object_initialized) {
+        return;
+    }
+
+    text_object_refresh_later(rect);
+}
+
 // 0x49D330
 void text_object_render(Rect* rect)
 {
@@ -362,6 +345,39 @@ int text_object_count()
     return text_object_index;
 }
 
+// CE: Returns number of milliseconds until next text object expires (UINT_MAX
+// if there are none).
+unsigned int text_object_next_delay()
+{
+    if (!text_object_enabled) {
+        return UINT_MAX;
+    }
+
+    if (text_object_dirty) {
+        return 0;
+    }
+
+    unsigned int delay = UINT_MAX;
+    unsigned int time = get_time();
+
+    for (int index = 0; index < text_object_index; index++) {
+        TextObject* textObject = text_object_list[index];
+        if ((textObject->flags & TEXT_OBJECT_MARKED_FOR_REMOVAL) != 0) {
+            return 0;
+        }
+
+        // Objects are removed once display time is exceeded, see
+        // `text_object_bk`.
+        unsigned int displayTime = text_object_line_delay * textObject->linesCount + text_object_base_delay + 1;
+        unsigned int remaining = remaining_tocks(time, textObject->time, displayTime);
+        if (remaining < delay) {
+            delay = remaining;
+        }
+    }
+
+    return delay;
+}
+
 // 0x49D440
 static void text_object_bk()
 {
@@ -369,9 +385,6 @@ static void text_object_bk()
         return;
     }
 
-    bool textObjectsRemoved = false;
-    Rect dirtyRect;
-
     for (int index = 0; index < text_object_index; index++) {
         TextObject* textObject = text_object_list[index];
 
@@ -387,14 +400,9 @@ static void text_object_bk()
             textObjectRect.lrx = textObject->width + textObject->x - 1;
             textObjectRect.lry = textObject->height + textObject->y - 1;
 
-            if (textObjectsRemoved) {
-                rect_min_bound(&dirtyRect, &textObjectRect, &dirtyRect);
-            } else {
-                rectCopy(&dirtyRect, &textObjectRect);
-                textObjectsRemoved = true;
-            }
+            text_object_refresh_later(&textObjectRect);
 
-            mem_free(textObject->data);
+            text_object_image_release(textObject->image);
             mem_free(textObject);
 
             memmove(&(text_object_list[index]), &(text_object_list[index + 1]), sizeof(*text_object_list) * (text_object_index - index - 1));
@@ -404,12 +412,219 @@ static void text_object_bk()
         }
     }
 
-    if (textObjectsRemoved) {
-        tile_refresh_rect(&dirtyRect, map_elevation);
+    if (text_object_dirty) {
+        text_object_dirty = false;
+        tile_refresh_rect(&text_object_dirty_rect, map_elevation);
         gdialog_refresh_world();
     }
 }
 
+// CE: Adds area to be refreshed by next `text_object_bk`.
+static void text_object_refresh_later(Rect* rect)
+{
+    if (text_object_dirty) {
+        rect_min_bound(&text_object_dirty_rect, rect, &text_object_dirty_rect);
+    } else {
+        rectCopy(&text_object_dirty_rect, rect);
+        text_object_dirty = true;
+    }
+}
+
+// CE: Returns rendered message from cache, rendering it if needed. Returned
+// image must be released with `text_object_image_release`.
+static TextObjectImage* text_object_image_get(char* string, int font, int color, int outlineColor)
+{
+    text_object_image_clock++;
+
+    for (int index = 0; index < TEXT_OBJECT_IMAGE_CACHE_CAPACITY; index++) {
+        TextObjectImage* image = text_object_image_cache[index];
+        if (image != NULL
+            && image->font == font
+            && image->color == color
+            && image->outlineColor == outlineColor
+            && strcmp(image->string, string) == 0) {
+            image->refs++;
+            image->lastUse = text_object_image_clock;
+            return image;
+        }
+    }
+
+    TextObjectImage* image = text_object_image_render(string, font, color, outlineColor);
+    if (image == NULL) {
+        return NULL;
+    }
+
+    image->lastUse = text_object_image_clock;
+
+    // Take empty slot or evict least recently used image no longer shown.
+    // When every cached image is on screen new one is not cached.
+    int slot = -1;
+    for (int index = 0; index < TEXT_OBJECT_IMAGE_CACHE_CAPACITY; index++) {
+        TextObjectImage* candidate = text_object_image_cache[index];
+        if (candidate == NULL) {
+            slot = index;
+            break;
+        }
+
+        if (candidate->refs == 0) {
+            if (slot == -1 || candidate->lastUse < text_object_image_cache[slot]->lastUse) {
+                slot = index;
+            }
+        }
+    }
+
+    if (slot != -1) {
+        if (text_object_image_cache[slot] != NULL) {
+            text_object_image_free(text_object_image_cache[slot]);
+        }
+
+        image->cached = true;
+        text_object_image_cache[slot] = image;
+    }
+
+    return image;
+}
+
+// CE: Renders message word wrapped to 200 pixels, with optional outline.
+// Extracted from `text_object_create`.
+static TextObjectImage* text_object_image_render(char* string, int font, int color, int outlineColor)
+{
+    int oldFont = text_curr();
+    text_font(font);
+
+    short beginnings[WORD_WRAP_MAX_COUNT];
+    short count;
+    if (word_wrap(string, 200, beginnings, &count) != 0) {
+        text_font(oldFont);
+        return NULL;
+    }
+
+    TextObjectImage* image = (TextObjectImage*)mem_malloc(sizeof(*image));
+    if (image == NULL) {
+        text_font(oldFont);
+        return NULL;
+    }
+
+    memset(image, 0, sizeof(*image));
+
+    image->refs = 1;
+    image->font = font;
+    image->color = color;
+    image->outlineColor = outlineColor;
+
+    image->linesCount = count - 1;
+    if (image->linesCount < 1) {
+        debug_printf("**Error in text_object_create()\n");
+    }
+
+    image->width = 0;
+
+    for (int index = 0; index < image->linesCount; index++) {
+        char* ending = string + beginnings[index + 1];
+        char* beginning = string + beginnings[index];
+        if (ending[-1] == ' ') {
+            --ending;
+        }
+
+        char c = *ending;
+        *ending = '\0';
+
+        // NOTE: Calls [text_width] twice, probably result of using min/max macro
+        int width = text_width(beginning);
+        if (width >= image->width) {
+            image->width = width;
+        }
+
+        *ending = c;
+    }
+
+    image->height = (text_height() + 1) * image->linesCount;
+
+    if (outlineColor != -1) {
+        image->width += 2;
+        image->height += 2;
+    }
+
+    int size = image->width * image->height;
+    image->data = (unsigned char*)mem_malloc(size);
+    image->string = mem_strdup(string);
+    if (image->data == NULL || image->string == NULL) {
+        text_object_image_free(image);
+        text_font(oldFont);
+        return NULL;
+    }
+
+    memset(image->data, 0, size);
+
+    unsigned char* dest = image->data;
+    int skip = image->width * (text_height() + 1);
+
+    if (outlineColor != -1) {
+        dest += image->width;
+    }
+
+    for (int index = 0; index < image->linesCount; index++) {
+        char* beginning = string + beginnings[index];
+        char* ending = string + beginnings[index + 1];
+        if (ending[-1] == ' ') {
+            --ending;
+        }
+
+        char c = *ending;
+        *ending = '\0';
+
+        int width = text_width(beginning);
+        text_to_buf(dest + (image->width - width) / 2, beginning, image->width, image->width, color);
+
+        *ending = c;
+
+        dest += skip;
+    }
+
+    if (outlineColor != -1) {
+        buf_outline(image->data, image->width, image->height, image->width, outlineColor);
+    }
+
+    text_font(oldFont);
+
+    return image;
+}
+
+// CE: Drops reference obtained from `text_object_image_get`. Cached images
+// stay around for reuse until evicted.
+static void text_object_image_release(TextObjectImage* image)
+{
+    image->refs--;
+    if (image->refs == 0 && !image->cached) {
+        text_object_image_free(image);
+    }
+}
+
+static void text_object_image_free(TextObjectImage* image)
+{
+    if (image->string != NULL) {
+        mem_free(image->string);
+    }
+
+    if (image->data != NULL) {
+        mem_free(image->data);
+    }
+
+    mem_free(image);
+}
+
+// CE: Frees cached images, must be called after all text objects are
+// removed.
+static void text_object_image_cache_flush()
+{
+    for (int index = 0; index < TEXT_OBJECT_IMAGE_CACHE_CAPACITY; index++) {
+        if (text_object_image_cache[index] != NULL) {
+            text_object_image_free(text_object_image_cache[index]);
+            text_object_image_cache[index] = NULL;
+        }
+    }
+}
+
 // Finds best position for placing text object.
 //
 // 0x49D59C
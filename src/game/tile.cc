@@ -2,11 +2,17 @@
 
 #include <assert.h>
 #include <limits.h>
+#include <stdint.h>
 #include <string.h>
 
 #define _USE_MATH_DEFINES
 #include <math.h>
 
+#include <algorithm>
+
+#include <SDL.h>
+
+#include "game/art.h"
 #include "game/config.h"
 #include "game/gconfig.h"
 #include "game/gmouse.h"
@@ -18,11 +24,37 @@
 #include "plib/gnw/debug.h"
 #include "plib/gnw/grbuf.h"
 #include "plib/gnw/input.h"
+#include "plib/gnw/jobs.h"
+#include "plib/gnw/memory.h"
+#include "plib/gnw/prof.h"
 
 namespace fallout {
 
 #define TILE_IS_VALID(tile) ((tile) >= 0 && (tile) < grid_size)
 
+// Number of squares along each side of floor or roof chunk.
+#define SQUARE_CHUNK_SIZE 8
+
+// Chunk buffer dimensions. Chunk's first square is placed at
+// (SQUARE_CHUNK_ORIGIN_X, 0), subsequent columns go left/down and rows go
+// right/down.
+#define SQUARE_CHUNK_ORIGIN_X (48 * (SQUARE_CHUNK_SIZE - 1))
+#define SQUARE_CHUNK_WIDTH (SQUARE_CHUNK_ORIGIN_X + 32 * (SQUARE_CHUNK_SIZE - 1) + 80)
+#define SQUARE_CHUNK_HEIGHT (12 * (SQUARE_CHUNK_SIZE - 1) + 24 * (SQUARE_CHUNK_SIZE - 1) + 36)
+
+// Screen area covered by chunk's squares.
+#define SQUARE_CHUNK_AREA (SQUARE_CHUNK_SIZE * SQUARE_CHUNK_SIZE * 1536)
+
+// Maximum number of bands rendered by job system (in addition to the one
+// rendered on main thread).
+#define TILE_RENDER_MAX_THREADS 7
+
+// Minimum height of band worth rendering on separate thread.
+#define TILE_RENDER_MIN_BAND_HEIGHT 32
+
+// Number of roof art ids (art id is 12 bits in square data).
+#define ROOF_MASK_COUNT 4096
+
 typedef struct RightsideUpTableEntry {
     int field_0;
     int field_4;
@@ -51,12 +83,109 @@ typedef struct UpsideDownTriangle {
     int field_8;
 } UpsideDownTriangle;
 
+// Pre-composited floor or roof of SQUARE_CHUNK_SIZE x SQUARE_CHUNK_SIZE
+// squares.
+typedef struct SquareChunk {
+    // Index into cache's `slots`, or -1 when chunk is free.
+    int key;
+    // Ambient light chunk was rendered with.
+    int light;
+    bool valid;
+    // Specifies that nothing was rendered into chunk.
+    bool empty;
+    unsigned int lastUsed;
+    unsigned char* data;
+} SquareChunk;
+
+// Renders squares of chunk into its (cleared) buffer. Returns `true` if
+// anything was rendered.
+typedef bool(SquareChunkBuildProc)(SquareChunk* chunk, int elevation, int chunkX, int chunkY);
+
+typedef struct SquareChunkCache {
+    bool enabled;
+    SquareChunk* chunks;
+    int capacity;
+    unsigned int clock;
+    // Maps chunk of every elevation to its index in `chunks` (or -1).
+    short* slots;
+    SquareChunkBuildProc* buildProc;
+} SquareChunkCache;
+
+// Group of adjacent roof squares which are shown and hidden together.
+typedef struct RoofRegion {
+    // Range of region's squares in `RoofRegions::squares`.
+    int start;
+    int length;
+    // Bounds in squares.
+    int minX;
+    int minY;
+    int maxX;
+    int maxY;
+    bool hidden;
+} RoofRegion;
+
+// Banded map renderer state.
+typedef struct TileRenderState {
+    // Maximum number of bands rendered as jobs, 0 - banded rendering is
+    // disabled.
+    int threadsLength;
+    // Band of every job, main thread renders its band separately.
+    Rect bands[TILE_RENDER_MAX_THREADS];
+    int elevation;
+    JobGroup group;
+} TileRenderState;
+
+typedef struct RoofRegions {
+    // Region number (index + 1) of every square, or 0 if square does not
+    // belong to any region.
+    int* squareRegions;
+    // Squares of every region, grouped by region.
+    int* squares;
+    RoofRegion* regions;
+    int count;
+} RoofRegions;
+
+// Opacity of roof art pixels, one bit per pixel of the first frame.
+typedef struct RoofMask {
+    int width;
+    int height;
+    unsigned char* bits;
+} RoofMask;
+
 static void refresh_mapper(Rect* rect, int elevation);
 static void refresh_game(Rect* rect, int elevation);
 static bool tile_on_edge(int tile);
+static void tile_coord_compute(int tile, int centerX, int centerY, int offsetX, int offsetY, int* screenX, int* screenY);
+static void tile_tables_init();
+static void tile_tables_exit();
+static void tile_tables_update_origin();
 static void roof_fill_on(int x, int y, int elevation);
 static void roof_fill_off(int x, int y, int elevation);
 static void roof_draw(int fid, int x, int y, Rect* rect, int light);
+static void roof_blit(unsigned char* src, int x, int y, int tileWidth, int tileHeight, Rect* rect, int light);
+static void roof_draw_squares(Rect* rect, int elevation, int minX, int minY, int maxX, int maxY, int light);
+static bool square_chunk_cache_init(SquareChunkCache* cache, SquareChunkBuildProc* buildProc, int windowWidth, int windowHeight);
+static void square_chunk_cache_exit(SquareChunkCache* cache);
+static void square_chunk_cache_invalidate(SquareChunkCache* cache);
+static void square_chunk_cache_invalidate_range(SquareChunkCache* cache, int elevation, int minX, int minY, int maxX, int maxY);
+static SquareChunk* square_chunk_cache_get(SquareChunkCache* cache, int elevation, int chunkX, int chunkY, int light);
+static void square_chunk_bounds(int elevation, int chunkX, int chunkY, bool roof, int* minX, int* minY, int* maxX, int* maxY, Rect* chunkRect);
+static void floor_cache_render(Rect* rect, int elevation, int minX, int minY, int maxX, int maxY);
+static void floor_cache_prepare(Rect* rect, int elevation);
+static int square_floor_range(Rect* rect, int elevation, Rect* constrainedRect, int* minXPtr, int* minYPtr, int* maxXPtr, int* maxYPtr);
+static void tile_render_band(void* data);
+static void tile_render_init();
+static void tile_render_exit();
+static bool floor_cache_build(SquareChunk* chunk, int elevation, int chunkX, int chunkY);
+static void roof_cache_render(Rect* rect, int elevation, int minX, int minY, int maxX, int maxY, int light);
+static bool roof_cache_build(SquareChunk* chunk, int elevation, int chunkX, int chunkY);
+static RoofMask* roof_mask_get(int id);
+static void roof_masks_free();
+static void roof_regions_build();
+static void roof_regions_free();
+static bool roof_region_fill(int x, int y, int elevation, bool on);
+static void floor_draw_squares(Rect* rect, int elevation, int minX, int minY, int maxX, int maxY);
+static void floor_draw_to(int fid, int tile, int x, int y, Rect* rect, unsigned char* dest, int destWidth, int destHeight, int destPitch);
 
 // 0x508330
 static bool borderInitialized = false;
@@ -79,6 +208,47 @@ static TileWindowRefreshElevationProc* tile_refresh = refresh_game;
 // 0x508348
 static bool refresh_enabled = true;
 
+// CE: Set when the contents of the display buffer no longer match the current
+// view (refresh was requested while disabled, or the view was changed without
+// refreshing). Incremental scrolling cannot reuse such contents.
+static bool display_stale = true;
+
+// CE: Floor and roof chunk caches (see `square_render_floor` and
+// `square_render_roof`).
+static SquareChunkCache floor_cache;
+static SquareChunkCache roof_cache;
+static int square_chunk_grid_width = 0;
+
+// CE: Opacity masks of roof tile arts by art id (see `roof_mask_get`).
+static RoofMask* roof_masks[ROOF_MASK_COUNT];
+static int square_chunk_grid_height = 0;
+
+// CE: Set while floor is rendered by several threads, chunk caches must not
+// be changed.
+static bool square_chunk_cache_readonly = false;
+
+// CE: Banded map renderer (see `square_render_floor_banded`).
+static TileRenderState tile_render_state;
+
+// CE: Neighbors of every tile in every direction, or -1 when tile is on the
+// edge of the grid (see `tile_num_in_direction`).
+static int* tile_neighbors = NULL;
+
+// CE: Screen coordinates of every tile (as x, y pairs) when grid origin is
+// at (0, 0). Actual screen coordinates are offset by tile coord origin, which
+// depends on center tile only (see `tile_tables_update_origin`).
+static int* tile_coord_offsets = NULL;
+
+// CE: Set when tables are used, see `tile_set_tables_enabled`.
+static bool tile_tables_enabled = true;
+static int tile_coord_origin_x = 0;
+static int tile_coord_origin_y = 0;
+
+// CE: Roof regions of every elevation, built on demand when roofs are
+// toggled.
+static RoofRegions roof_regions[ELEVATION_COUNT];
+static bool roof_regions_valid = false;
+
 // 0x50834C
 int off_tile[2][6] = {
     {
@@ -134,7 +304,7 @@ static UpsideDownTableEntry upside_down_table[13] = {
 };
 
 // 0x50844C
-static STRUCT_51DA6C verticies[10] = {
+static thread_local STRUCT_51DA6C verticies[10] = {
     { 16, -1, -201, 0 },
     { 48, -2, -2, 0 },
     { 960, 0, 0, 0 },
@@ -166,7 +336,7 @@ static UpsideDownTriangle upside_down_triangles[5] = {
 };
 
 // 0x665274
-static int intensity_map[3280];
+static thread_local int intensity_map[3280];
 
 // Deltas to perform tile calculations in given direction.
 //
@@ -400,6 +570,8 @@ int tile_init(TileData** a1, int squareGridWidth, int squareGridHeight, int hexG
         draw_line(tile_grid_blocked, 32, v25, v20, v22, v20, colorTable[31744]);
     }
 
+    tile_tables_init();
+
     // In order to calculate scroll borders correctly we need to pretend we're
     // at original resolution. Since border is calculated only once at start,
     // there is not need to change it all the time.
@@ -423,6 +595,27 @@ int tile_init(TileData** a1, int squareGridWidth, int squareGridHeight, int hexG
         tile_refresh = refresh_mapper;
     }
 
+    // CE: Chunk caches are optional.
+    square_chunk_cache_exit(&floor_cache);
+    square_chunk_cache_exit(&roof_cache);
+
+    square_chunk_grid_width = (square_width + SQUARE_CHUNK_SIZE - 1) / SQUARE_CHUNK_SIZE;
+    square_chunk_grid_height = (square_length + SQUARE_CHUNK_SIZE - 1) / SQUARE_CHUNK_SIZE;
+
+    int floorCache;
+    if (config_get_value(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_FLOOR_CACHE_KEY, &floorCache) && floorCache != 0) {
+        square_chunk_cache_init(&floor_cache, floor_cache_build, windowWidth, windowHeight);
+    }
+
+    int roofCache;
+    if (config_get_value(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_ROOF_CACHE_KEY, &roofCache) && roofCache != 0) {
+        square_chunk_cache_init(&roof_cache, roof_cache_build, windowWidth, windowHeight);
+    }
+
+    roof_regions_valid = false;
+
+    tile_render_init();
+
     return 0;
 }
 
@@ -455,11 +648,18 @@ void tile_set_border(int windowWidth, int windowHeight, int hexGridWidth, int he
 // 0x49DE80
 void tile_reset()
 {
+    tile_invalidate_squares();
 }
 
 // 0x49DE80
 void tile_exit()
 {
+    tile_tables_exit();
+    tile_render_exit();
+    square_chunk_cache_exit(&floor_cache);
+    square_chunk_cache_exit(&roof_cache);
+    roof_regions_free();
+    roof_masks_free();
 }
 
 // 0x49DE8C
@@ -474,6 +674,11 @@ void tile_enable_refresh()
     refresh_enabled = true;
 }
 
+bool tile_refresh_is_enabled()
+{
+    return refresh_enabled;
+}
+
 // 0x49DEA4
 void tile_refresh_rect(Rect* rect, int elevation)
 {
@@ -481,6 +686,8 @@ void tile_refresh_rect(Rect* rect, int elevation)
         if (elevation == map_elevation) {
             tile_refresh(rect, elevation);
         }
+    } else {
+        display_stale = true;
     }
 }
 
@@ -489,9 +696,26 @@ void tile_refresh_display()
 {
     if (refresh_enabled) {
         tile_refresh(&buf_rect, map_elevation);
+        display_stale = false;
+    } else {
+        display_stale = true;
     }
 }
 
+// CE: Marks display buffer contents as no longer matching the view, so the
+// next scroll redraws the whole window.
+void tile_invalidate_display()
+{
+    display_stale = true;
+}
+
+// CE: Returns `true` if display buffer contents can be reused for
+// incremental scrolling.
+bool tile_display_valid()
+{
+    return refresh_enabled && !display_stale;
+}
+
 // 0x49DEDC
 int tile_set_center(int tile, int flags)
 {
@@ -558,6 +782,9 @@ int tile_set_center(int tile, int flags)
 
     tile_center_tile = tile;
 
+    // CE: Tile coordinates depend on new center.
+    tile_tables_update_origin();
+
     // CE: Updates bounds screen coordinates.
     tile_update_bounds_rect();
 
@@ -595,6 +822,8 @@ static void refresh_mapper(Rect* rect, int elevation)
 // 0x49E1CC
 static void refresh_game(Rect* rect, int elevation)
 {
+    ProfScope profScope(PROF_ZONE_REFRESH_GAME);
+
     Rect rectToUpdate;
 
     if (rect_inside_bound(rect, &buf_rect, &rectToUpdate) == -1) {
@@ -607,7 +836,7 @@ static void refresh_game(Rect* rect, int elevation)
         buf_full,
         0);
 
-    square_render_floor(&rectToUpdate, elevation);
+    square_render_floor_banded(&rectToUpdate, elevation);
     obj_render_pre_roof(&rectToUpdate, elevation);
     square_render_roof(&rectToUpdate, elevation);
     bounds_render(&rectToUpdate, elevation);
@@ -623,6 +852,8 @@ void tile_toggle_roof(int a1)
     if (a1) {
         // NOTE: Uninline.
         tile_refresh_display();
+    } else {
+        tile_invalidate_display();
     }
 }
 
@@ -635,27 +866,79 @@ int tile_roof_visible()
 // 0x49E258
 int tile_coord(int tile, int* screenX, int* screenY, int elevation)
 {
-    int v3;
-    int v4;
-    int v5;
-    int v6;
+    if (!TILE_IS_VALID(tile)) {
+        return -1;
+    }
+
+    // CE: Use precomputed coordinates.
+    if (tile_coord_offsets != NULL) {
+        *screenX = tile_coord_origin_x + tile_coord_offsets[tile * 2];
+        *screenY = tile_coord_origin_y + tile_coord_offsets[tile * 2 + 1];
+        return 0;
+    }
 
+    tile_coord_compute(tile, tile_x, tile_y, tile_offx, tile_offy, screenX, screenY);
+
+    return 0;
+}
+
+// CE: Calculates coordinates of a tile which do not depend on scroll
+// position. Screen coordinates are these plus `tile_world_origin`.
+int tile_coord_world(int tile, int* worldX, int* worldY)
+{
     if (!TILE_IS_VALID(tile)) {
         return -1;
     }
 
+    if (tile_coord_offsets != NULL) {
+        *worldX = tile_coord_offsets[tile * 2];
+        *worldY = tile_coord_offsets[tile * 2 + 1];
+        return 0;
+    }
+
+    tile_coord_compute(tile, 0, 0, 0, 0, worldX, worldY);
+
+    return 0;
+}
+
+// CE: Returns screen coordinates of world origin, see `tile_coord_world`.
+void tile_world_origin(int* originX, int* originY)
+{
+    if (tile_coord_offsets != NULL) {
+        *originX = tile_coord_origin_x;
+        *originY = tile_coord_origin_y;
+        return;
+    }
+
+    int centerTile = tile_y * grid_width + (grid_width - 1 - tile_x);
+    int centerX;
+    int centerY;
+    tile_coord_compute(centerTile, 0, 0, 0, 0, &centerX, &centerY);
+    *originX = tile_offx - centerX;
+    *originY = tile_offy - centerY;
+}
+
+// CE: Extracted from `tile_coord`. Calculates screen coordinates of a tile
+// when tile at (centerX, centerY) is at (offsetX, offsetY).
+static void tile_coord_compute(int tile, int centerX, int centerY, int offsetX, int offsetY, int* screenX, int* screenY)
+{
+    int v3;
+    int v4;
+    int v5;
+    int v6;
+
     v3 = grid_width - 1 - tile % grid_width;
     v4 = tile / grid_width;
 
-    *screenX = tile_offx;
-    *screenY = tile_offy;
+    *screenX = offsetX;
+    *screenY = offsetY;
 
-    v5 = (v3 - tile_x) / -2;
-    *screenX += 48 * ((v3 - tile_x) / 2);
+    v5 = (v3 - centerX) / -2;
+    *screenX += 48 * ((v3 - centerX) / 2);
     *screenY += 12 * v5;
 
     if (v3 & 1) {
-        if (v3 <= tile_x) {
+        if (v3 <= centerX) {
             *screenX -= 16;
             *screenY += 12;
         } else {
@@ -663,11 +946,88 @@ int tile_coord(int tile, int* screenX, int* screenY, int elevation)
         }
     }
 
-    v6 = v4 - tile_y;
+    v6 = v4 - centerY;
     *screenX += 16 * v6;
     *screenY += 12 * v6;
+}
 
-    return 0;
+// CE: Builds neighbor and screen coordinate tables. Tables are optional,
+// functions fall back to calculations when they cannot be allocated.
+static void tile_tables_init()
+{
+    tile_tables_exit();
+
+    if (!tile_tables_enabled) {
+        return;
+    }
+
+    tile_neighbors = (int*)mem_malloc(sizeof(*tile_neighbors) * grid_size * ROTATION_COUNT);
+    if (tile_neighbors != NULL) {
+        for (int tile = 0; tile < grid_size; tile++) {
+            int* neighbors = tile_neighbors + tile * ROTATION_COUNT;
+            if (tile_on_edge(tile)) {
+                for (int rotation = 0; rotation < ROTATION_COUNT; rotation++) {
+                    neighbors[rotation] = -1;
+                }
+            } else {
+                int parity = (tile % grid_width) & 1;
+                for (int rotation = 0; rotation < ROTATION_COUNT; rotation++) {
+                    neighbors[rotation] = tile + dir_tile[parity][rotation];
+                }
+            }
+        }
+    }
+
+    // Screen coordinates are translation invariant as long as center column
+    // is even, which is guaranteed by `tile_set_center`.
+    tile_coord_offsets = (int*)mem_malloc(sizeof(*tile_coord_offsets) * grid_size * 2);
+    if (tile_coord_offsets != NULL) {
+        for (int tile = 0; tile < grid_size; tile++) {
+            tile_coord_compute(tile, 0, 0, 0, 0, &(tile_coord_offsets[tile * 2]), &(tile_coord_offsets[tile * 2 + 1]));
+        }
+    }
+
+    tile_tables_update_origin();
+}
+
+// CE: Releases neighbor and screen coordinate tables.
+static void tile_tables_exit()
+{
+    if (tile_neighbors != NULL) {
+        mem_free(tile_neighbors);
+        tile_neighbors = NULL;
+    }
+
+    if (tile_coord_offsets != NULL) {
+        mem_free(tile_coord_offsets);
+        tile_coord_offsets = NULL;
+    }
+}
+
+// CE: Switches between precomputed tables and original calculations, so
+// benchmarks can compare both.
+void tile_set_tables_enabled(bool enabled)
+{
+    tile_tables_enabled = enabled;
+
+    if (enabled) {
+        tile_tables_init();
+    } else {
+        tile_tables_exit();
+    }
+}
+
+// CE: Recalculates screen coordinates of grid origin from current center.
+static void tile_tables_update_origin()
+{
+    if (tile_coord_offsets == NULL) {
+        return;
+    }
+
+    // Tile in center column and row is at (tile_offx, tile_offy).
+    int centerTile = tile_y * grid_width + (grid_width - 1 - tile_x);
+    tile_coord_origin_x = tile_offx - tile_coord_offsets[centerTile * 2];
+    tile_coord_origin_y = tile_offy - tile_coord_offsets[centerTile * 2 + 1];
 }
 
 // 0x49E354
@@ -807,6 +1167,21 @@ bool tile_to_right_of(int tile1, int tile2)
 // 0x49E570
 int tile_num_in_direction(int tile, int rotation, int distance)
 {
+    // CE: Walk precomputed neighbors.
+    if (tile_neighbors != NULL && TILE_IS_VALID(tile) && rotation >= 0 && rotation < ROTATION_COUNT) {
+        int newTile = tile;
+        for (int index = 0; index < distance; index++) {
+            int nextTile = tile_neighbors[newTile * ROTATION_COUNT + rotation];
+            if (nextTile == -1) {
+                break;
+            }
+
+            newTile = nextTile;
+        }
+
+        return newTile;
+    }
+
     int newTile = tile;
     for (int index = 0; index < distance; index++) {
         if (tile_on_edge(newTile)) {
@@ -1189,6 +1564,17 @@ void square_render_roof(Rect* rect, int elevation)
 
     int light = light_get_ambient();
 
+    if (roof_cache.enabled) {
+        roof_cache_render(&constrainedRect, elevation, minX, minY, maxX, maxY, light);
+        return;
+    }
+
+    roof_draw_squares(&constrainedRect, elevation, minX, minY, maxX, maxY, light);
+}
+
+// CE: Extracted from `square_render_roof`.
+static void roof_draw_squares(Rect* rect, int elevation, int minX, int minY, int maxX, int maxY, int light)
+{
     int baseSquareTile = square_width * minY;
 
     for (int y = minY; y <= maxY; y++) {
@@ -1202,7 +1588,7 @@ void square_render_roof(Rect* rect, int elevation)
                     int screenX;
                     int screenY;
                     square_coord_roof(squareTile, &screenX, &screenY, elevation);
-                    roof_draw(fid, screenX, screenY, &constrainedRect, light);
+                    roof_draw(fid, screenX, screenY, rect, light);
                 }
             }
         }
@@ -1238,11 +1624,18 @@ static void roof_fill_on(int x, int y, int elevation)
 // 0x49EEC4
 void tile_fill_roof(int x, int y, int elevation, bool on)
 {
+    // CE: Toggle precomputed region instead of flood filling.
+    if (roof_region_fill(x, y, elevation, on)) {
+        return;
+    }
+
     if (on) {
         roof_fill_on(x, y, elevation);
     } else {
         roof_fill_off(x, y, elevation);
     }
+
+    square_chunk_cache_invalidate(&roof_cache);
 }
 
 // 0x49EECC
@@ -1282,6 +1675,16 @@ static void roof_draw(int fid, int x, int y, Rect* rect, int light)
     int tileWidth = art_frame_width(tileFrm, 0, 0);
     int tileHeight = art_frame_length(tileFrm, 0, 0);
 
+    roof_blit(art_frame_data(tileFrm, 0, 0), x, y, tileWidth, tileHeight, rect, light);
+
+    art_ptr_unlock(tileFrmHandle);
+}
+
+// CE: Extracted from `roof_draw` to blend roof tiles and cached roof chunks.
+// Roof pixels are darkened with ambient light, and blended with underlying
+// pixels within egg.
+static void roof_blit(unsigned char* src, int x, int y, int tileWidth, int tileHeight, Rect* rect, int light)
+{
     Rect tileRect;
     tileRect.ulx = x;
     tileRect.uly = y;
@@ -1289,7 +1692,7 @@ static void roof_draw(int fid, int x, int y, Rect* rect, int light)
     tileRect.lry = y + tileHeight - 1;
 
     if (rect_inside_bound(&tileRect, rect, &tileRect) == 0) {
-        unsigned char* tileFrmBuffer = art_frame_data(tileFrm, 0, 0);
+        unsigned char* tileFrmBuffer = src;
         tileFrmBuffer += tileWidth * (tileRect.uly - y) + (tileRect.ulx - x);
 
         CacheEntry* eggFrmHandle;
@@ -1376,29 +1779,51 @@ static void roof_draw(int fid, int x, int y, Rect* rect, int light)
             art_ptr_unlock(eggFrmHandle);
         }
     }
-
-    art_ptr_unlock(tileFrmHandle);
 }
 
 // 0x49F3EC
 void square_render_floor(Rect* rect, int elevation)
 {
+    int minX;
     int minY;
     int maxX;
     int maxY;
-    int minX;
-    int temp;
 
     // CE: Constrain rect to tile bounds so that we don't draw outside.
-    Rect constrainedRect = *rect;
-    if (tile_inside_bound(&constrainedRect) != 0) {
+    Rect constrainedRect;
+    if (square_floor_range(rect, elevation, &constrainedRect, &minX, &minY, &maxX, &maxY) != 0) {
         return;
     }
 
-    square_xy(constrainedRect.ulx, constrainedRect.uly, elevation, &temp, &minY);
-    square_xy(constrainedRect.lrx, constrainedRect.uly, elevation, &minX, &temp);
-    square_xy(constrainedRect.ulx, constrainedRect.lry, elevation, &maxX, &temp);
-    square_xy(constrainedRect.lrx, constrainedRect.lry, elevation, &temp, &maxY);
+    light_get_ambient();
+
+    if (floor_cache.enabled) {
+        floor_cache_render(&constrainedRect, elevation, minX, minY, maxX, maxY);
+        return;
+    }
+
+    floor_draw_squares(&constrainedRect, elevation, minX, minY, maxX, maxY);
+}
+
+// CE: Extracted from `square_render_floor`. Calculates range of floor
+// squares intersecting given rect.
+static int square_floor_range(Rect* rect, int elevation, Rect* constrainedRect, int* minXPtr, int* minYPtr, int* maxXPtr, int* maxYPtr)
+{
+    int minY;
+    int maxX;
+    int maxY;
+    int minX;
+    int temp;
+
+    *constrainedRect = *rect;
+    if (tile_inside_bound(constrainedRect) != 0) {
+        return -1;
+    }
+
+    square_xy(constrainedRect->ulx, constrainedRect->uly, elevation, &temp, &minY);
+    square_xy(constrainedRect->lrx, constrainedRect->uly, elevation, &minX, &temp);
+    square_xy(constrainedRect->ulx, constrainedRect->lry, elevation, &maxX, &temp);
+    square_xy(constrainedRect->lrx, constrainedRect->lry, elevation, &temp, &maxY);
 
     if (minX < 0) {
         minX = 0;
@@ -1416,8 +1841,126 @@ void square_render_floor(Rect* rect, int elevation)
         minY = square_length - 1;
     }
 
-    light_get_ambient();
+    *minXPtr = minX;
+    *minYPtr = minY;
+    *maxXPtr = maxX;
+    *maxYPtr = maxY;
+
+    return 0;
+}
+
+// CE: Renders floor like `square_render_floor`, splitting rect into
+// horizontal bands rendered by job system (when enabled). Bands do not
+// overlap and every band draws squares in the original order, so the result
+// is identical to serial rendering.
+void square_render_floor_banded(Rect* rect, int elevation)
+{
+    TileRenderState* state = &tile_render_state;
+
+    int threads = std::min(state->threadsLength, jobs_get_worker_count());
+    if (threads == 0) {
+        square_render_floor(rect, elevation);
+        return;
+    }
+
+    Rect bandsRect;
+    if (rect_inside_bound(rect, &buf_rect, &bandsRect) != 0) {
+        return;
+    }
+
+    int height = rectGetHeight(&bandsRect);
+    int bands = threads + 1;
+    if (height / bands < TILE_RENDER_MIN_BAND_HEIGHT) {
+        bands = height / TILE_RENDER_MIN_BAND_HEIGHT;
+    }
+
+    if (bands <= 1) {
+        square_render_floor(rect, elevation);
+        return;
+    }
+
+    // Build missing chunks up front, jobs only read the cache.
+    if (floor_cache.enabled) {
+        floor_cache_prepare(&bandsRect, elevation);
+    }
+
+    if (!art_set_concurrent(true)) {
+        square_render_floor(rect, elevation);
+        return;
+    }
+
+    square_chunk_cache_readonly = true;
+
+    Rect mainBand;
+    for (int index = 0; index < bands; index++) {
+        Rect* band = index == 0 ? &mainBand : &(state->bands[index - 1]);
+        band->ulx = bandsRect.ulx;
+        band->uly = bandsRect.uly + height * index / bands;
+        band->lrx = bandsRect.lrx;
+        band->lry = bandsRect.uly + height * (index + 1) / bands - 1;
+    }
+
+    state->elevation = elevation;
+
+    jobs_group_init(&(state->group));
+    for (int index = 1; index < bands; index++) {
+        jobs_add(&(state->group), tile_render_band, &(state->bands[index - 1]));
+    }
+
+    square_render_floor(&mainBand, elevation);
+
+    jobs_wait(&(state->group));
+
+    square_chunk_cache_readonly = false;
+    art_set_concurrent(false);
+}
+
+// CE: Renders one band published by `square_render_floor_banded`.
+static void tile_render_band(void* data)
+{
+    ProfScope profScope(PROF_ZONE_TILE_RENDER_WORKER);
+
+    Rect* band = (Rect*)data;
+    square_render_floor(band, tile_render_state.elevation);
+}
+
+// CE: Reads number of bands from game config, it includes the one rendered
+// on main thread. Bands are rendered by job system, which has its own cap on
+// worker threads.
+static void tile_render_init()
+{
+    TileRenderState* state = &tile_render_state;
+
+    tile_render_exit();
+
+    int threads;
+    if (!config_get_value(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_RENDER_THREADS_KEY, &threads)) {
+        threads = 0;
+    }
+
+    threads -= 1;
+    if (threads <= 0) {
+        return;
+    }
+
+    if (threads > TILE_RENDER_MAX_THREADS) {
+        threads = TILE_RENDER_MAX_THREADS;
+    }
+
+    state->threadsLength = threads;
 
+    debug_printf("Map renderer: up to %d bands on %d job threads\n", state->threadsLength + 1, jobs_get_worker_count());
+}
+
+static void tile_render_exit()
+{
+    TileRenderState* state = &tile_render_state;
+    state->threadsLength = 0;
+}
+
+// CE: Extracted from `square_render_floor`.
+static void floor_draw_squares(Rect* rect, int elevation, int minX, int minY, int maxX, int maxY)
+{
     int baseSquareTile = square_width * minY;
 
     for (int y = minY; y <= maxY; y++) {
@@ -1429,71 +1972,833 @@ void square_render_floor(Rect* rect, int elevation)
                 int tileScreenY;
                 square_coord(squareTile, &tileScreenX, &tileScreenY, elevation);
                 int fid = art_id(OBJ_TYPE_TILE, frmId & 0xFFF, 0, 0, 0);
-                floor_draw(fid, tileScreenX, tileScreenY, &constrainedRect);
+                floor_draw(fid, tileScreenX, tileScreenY, rect);
             }
         }
         baseSquareTile += square_width;
     }
 }
 
-// 0x49F5B4
-bool square_roof_intersect(int x, int y, int elevation)
+// CE: Allocates chunk slots of square chunk cache. The number of chunks is
+// enough to cover game window with one chunk margin on every side, so that
+// redraws of the whole window do not evict chunks they use.
+static bool square_chunk_cache_init(SquareChunkCache* cache, SquareChunkBuildProc* buildProc, int windowWidth, int windowHeight)
 {
-    if (!show_roof) {
+    int slotsLength = ELEVATION_COUNT * square_chunk_grid_width * square_chunk_grid_height;
+    cache->slots = (short*)mem_malloc(sizeof(*cache->slots) * slotsLength);
+    if (cache->slots == NULL) {
         return false;
     }
 
-    bool result = false;
+    for (int index = 0; index < slotsLength; index++) {
+        cache->slots[index] = -1;
+    }
 
-    int tileX;
-    int tileY;
-    square_xy_roof(x, y, elevation, &tileX, &tileY);
+    long long area = (long long)(windowWidth + 2 * SQUARE_CHUNK_WIDTH) * (windowHeight + 2 * SQUARE_CHUNK_HEIGHT);
+    cache->capacity = (int)(area / SQUARE_CHUNK_AREA) + 1;
+    if (cache->capacity > SHRT_MAX) {
+        cache->capacity = SHRT_MAX;
+    }
 
-    TileData* ptr = squares[elevation];
-    int idx = square_width * tileY + tileX;
-    int upper = ptr->field_0[square_width * tileY + tileX] >> 16;
-    int fid = art_id(OBJ_TYPE_TILE, upper & 0xFFF, 0, 0, 0);
-    if (fid != art_id(OBJ_TYPE_TILE, 1, 0, 0, 0)) {
-        if ((((upper & 0xF000) >> 12) & 1) == 0) {
-            int fid = art_id(OBJ_TYPE_TILE, upper & 0xFFF, 0, 0, 0);
-            CacheEntry* handle;
-            Art* art = art_ptr_lock(fid, &handle);
-            if (art != NULL) {
-                unsigned char* data = art_frame_data(art, 0, 0);
-                if (data != NULL) {
-                    int v18;
-                    int v17;
-                    square_coord_roof(idx, &v18, &v17, elevation);
-
-                    int width = art_frame_width(art, 0, 0);
-                    if (data[width * (y - v17) + x - v18] != 0) {
-                        result = true;
-                    }
-                }
-                art_ptr_unlock(handle);
-            }
-        }
+    cache->chunks = (SquareChunk*)mem_malloc(sizeof(*cache->chunks) * cache->capacity);
+    if (cache->chunks == NULL) {
+        mem_free(cache->slots);
+        cache->slots = NULL;
+        cache->capacity = 0;
+        return false;
     }
 
-    return result;
+    for (int index = 0; index < cache->capacity; index++) {
+        SquareChunk* chunk = &(cache->chunks[index]);
+        chunk->key = -1;
+        chunk->light = 0;
+        chunk->valid = false;
+        chunk->empty = true;
+        chunk->lastUsed = 0;
+        chunk->data = NULL;
+    }
+
+    cache->buildProc = buildProc;
+    cache->clock = 0;
+    cache->enabled = true;
+
+    return true;
 }
 
-// 0x49F900
-void grid_toggle()
+// CE: Releases square chunk cache.
+static void square_chunk_cache_exit(SquareChunkCache* cache)
 {
-    show_grid = 1 - show_grid;
+    if (cache->chunks != NULL) {
+        for (int index = 0; index < cache->capacity; index++) {
+            if (cache->chunks[index].data != NULL) {
+                mem_free(cache->chunks[index].data);
+            }
+        }
+
+        mem_free(cache->chunks);
+        cache->chunks = NULL;
+    }
+
+    if (cache->slots != NULL) {
+        mem_free(cache->slots);
+        cache->slots = NULL;
+    }
+
+    cache->capacity = 0;
+    cache->enabled = false;
 }
 
-// 0x49F918
-void grid_on()
+// CE: Marks every cached chunk as outdated.
+static void square_chunk_cache_invalidate(SquareChunkCache* cache)
 {
-    show_grid = 1;
+    for (int index = 0; index < cache->capacity; index++) {
+        cache->chunks[index].valid = false;
+    }
 }
 
-// 0x49F924
-void grid_off()
+// CE: Marks cached chunks covering given range of squares as outdated.
+static void square_chunk_cache_invalidate_range(SquareChunkCache* cache, int elevation, int minX, int minY, int maxX, int maxY)
 {
-    show_grid = 0;
+    if (!cache->enabled) {
+        return;
+    }
+
+    if (minX < 0) {
+        minX = 0;
+    }
+
+    if (maxX >= square_width) {
+        maxX = square_width - 1;
+    }
+
+    if (minY < 0) {
+        minY = 0;
+    }
+
+    if (maxY >= square_length) {
+        maxY = square_length - 1;
+    }
+
+    short* slots = cache->slots + elevation * square_chunk_grid_width * square_chunk_grid_height;
+    for (int chunkY = minY / SQUARE_CHUNK_SIZE; chunkY <= maxY / SQUARE_CHUNK_SIZE; chunkY++) {
+        for (int chunkX = minX / SQUARE_CHUNK_SIZE; chunkX <= maxX / SQUARE_CHUNK_SIZE; chunkX++) {
+            int slot = slots[chunkY * square_chunk_grid_width + chunkX];
+            if (slot != -1) {
+                cache->chunks[slot].valid = false;
+            }
+        }
+    }
+}
+
+// CE: Returns up-to-date chunk, rendering it into least recently used slot
+// when needed. Returns `NULL` when chunk buffer cannot be allocated.
+static SquareChunk* square_chunk_cache_get(SquareChunkCache* cache, int elevation, int chunkX, int chunkY, int light)
+{
+    int key = (elevation * square_chunk_grid_height + chunkY) * square_chunk_grid_width + chunkX;
+
+    SquareChunk* chunk;
+    int slot = cache->slots[key];
+
+    // Cache is shared by render threads, only look up chunks built by
+    // `floor_cache_prepare`.
+    if (square_chunk_cache_readonly) {
+        if (slot == -1) {
+            return NULL;
+        }
+
+        chunk = &(cache->chunks[slot]);
+        if (!chunk->valid || chunk->light != light) {
+            return NULL;
+        }
+
+        return chunk;
+    }
+
+    if (slot != -1) {
+        chunk = &(cache->chunks[slot]);
+    } else {
+        slot = 0;
+        for (int index = 0; index < cache->capacity; index++) {
+            if (cache->chunks[index].key == -1) {
+                slot = index;
+                break;
+            }
+
+            if (cache->chunks[index].lastUsed < cache->chunks[slot].lastUsed) {
+                slot = index;
+            }
+        }
+
+        chunk = &(cache->chunks[slot]);
+        if (chunk->key != -1) {
+            cache->slots[chunk->key] = -1;
+        }
+
+        chunk->key = key;
+        chunk->valid = false;
+        cache->slots[key] = slot;
+    }
+
+    chunk->lastUsed = ++cache->clock;
+
+    if (chunk->valid && chunk->light == light) {
+        return chunk;
+    }
+
+    if (chunk->data == NULL) {
+        chunk->data = (unsigned char*)mem_malloc(SQUARE_CHUNK_WIDTH * SQUARE_CHUNK_HEIGHT);
+        if (chunk->data == NULL) {
+            return NULL;
+        }
+    }
+
+    memset(chunk->data, 0, SQUARE_CHUNK_WIDTH * SQUARE_CHUNK_HEIGHT);
+    chunk->empty = !cache->buildProc(chunk, elevation, chunkX, chunkY);
+    chunk->light = light;
+    chunk->valid = true;
+
+    return chunk;
+}
+
+// CE: Calculates range of squares of a chunk (clamped to square grid), and
+// screen rect of chunk buffer.
+static void square_chunk_bounds(int elevation, int chunkX, int chunkY, bool roof, int* minX, int* minY, int* maxX, int* maxY, Rect* chunkRect)
+{
+    *minX = chunkX * SQUARE_CHUNK_SIZE;
+    *minY = chunkY * SQUARE_CHUNK_SIZE;
+
+    *maxX = *minX + SQUARE_CHUNK_SIZE - 1;
+    if (*maxX >= square_width) {
+        *maxX = square_width - 1;
+    }
+
+    *maxY = *minY + SQUARE_CHUNK_SIZE - 1;
+    if (*maxY >= square_length) {
+        *maxY = square_length - 1;
+    }
+
+    int screenX;
+    int screenY;
+    if (roof) {
+        square_coord_roof(*minY * square_width + *minX, &screenX, &screenY, elevation);
+    } else {
+        square_coord(*minY * square_width + *minX, &screenX, &screenY, elevation);
+    }
+
+    chunkRect->ulx = screenX - SQUARE_CHUNK_ORIGIN_X;
+    chunkRect->uly = screenY;
+    chunkRect->lrx = chunkRect->ulx + SQUARE_CHUNK_WIDTH - 1;
+    chunkRect->lry = chunkRect->uly + SQUARE_CHUNK_HEIGHT - 1;
+}
+
+// CE: Renders floor squares in given range by copying cached chunks. Chunks
+// which cannot be cached are rendered square by square.
+static void floor_cache_render(Rect* rect, int elevation, int minX, int minY, int maxX, int maxY)
+{
+    if (maxX >= square_width) {
+        maxX = square_width - 1;
+    }
+
+    if (maxY >= square_length) {
+        maxY = square_length - 1;
+    }
+
+    if (maxX < minX || maxY < minY) {
+        return;
+    }
+
+    int ambientLight = light_get_ambient();
+
+    for (int chunkY = minY / SQUARE_CHUNK_SIZE; chunkY <= maxY / SQUARE_CHUNK_SIZE; chunkY++) {
+        for (int chunkX = minX / SQUARE_CHUNK_SIZE; chunkX <= maxX / SQUARE_CHUNK_SIZE; chunkX++) {
+            int chunkMinX;
+            int chunkMinY;
+            int chunkMaxX;
+            int chunkMaxY;
+            Rect chunkRect;
+            square_chunk_bounds(elevation, chunkX, chunkY, false, &chunkMinX, &chunkMinY, &chunkMaxX, &chunkMaxY, &chunkRect);
+
+            Rect drawRect;
+            if (rect_inside_bound(&chunkRect, rect, &drawRect) == -1) {
+                continue;
+            }
+
+            SquareChunk* chunk = square_chunk_cache_get(&floor_cache, elevation, chunkX, chunkY, ambientLight);
+            if (chunk == NULL) {
+                floor_draw_squares(&drawRect, elevation, chunkMinX, chunkMinY, chunkMaxX, chunkMaxY);
+                continue;
+            }
+
+            if (chunk->empty) {
+                continue;
+            }
+
+            trans_buf_to_buf(chunk->data + SQUARE_CHUNK_WIDTH * (drawRect.uly - chunkRect.uly) + (drawRect.ulx - chunkRect.ulx),
+                rectGetWidth(&drawRect),
+                rectGetHeight(&drawRect),
+                SQUARE_CHUNK_WIDTH,
+                buf + buf_full * drawRect.uly + drawRect.ulx,
+                buf_full);
+        }
+    }
+}
+
+// CE: Builds outdated floor chunks intersecting given rect, so that they can
+// be used by `floor_cache_render` from several threads.
+static void floor_cache_prepare(Rect* rect, int elevation)
+{
+    int minX;
+    int minY;
+    int maxX;
+    int maxY;
+    Rect constrainedRect;
+    if (square_floor_range(rect, elevation, &constrainedRect, &minX, &minY, &maxX, &maxY) != 0) {
+        return;
+    }
+
+    if (maxX >= square_width) {
+        maxX = square_width - 1;
+    }
+
+    if (maxY >= square_length) {
+        maxY = square_length - 1;
+    }
+
+    int ambientLight = light_get_ambient();
+
+    for (int chunkY = minY / SQUARE_CHUNK_SIZE; chunkY <= maxY / SQUARE_CHUNK_SIZE; chunkY++) {
+        for (int chunkX = minX / SQUARE_CHUNK_SIZE; chunkX <= maxX / SQUARE_CHUNK_SIZE; chunkX++) {
+            int chunkMinX;
+            int chunkMinY;
+            int chunkMaxX;
+            int chunkMaxY;
+            Rect chunkRect;
+            square_chunk_bounds(elevation, chunkX, chunkY, false, &chunkMinX, &chunkMinY, &chunkMaxX, &chunkMaxY, &chunkRect);
+
+            Rect drawRect;
+            if (rect_inside_bound(&chunkRect, &constrainedRect, &drawRect) == 0) {
+                square_chunk_cache_get(&floor_cache, elevation, chunkX, chunkY, ambientLight);
+            }
+        }
+    }
+}
+
+// CE: Renders chunk's lit floor squares into its buffer in the same order as
+// `square_render_floor` does.
+static bool floor_cache_build(SquareChunk* chunk, int elevation, int chunkX, int chunkY)
+{
+    int minX;
+    int minY;
+    int maxX;
+    int maxY;
+    Rect chunkScreenRect;
+    square_chunk_bounds(elevation, chunkX, chunkY, false, &minX, &minY, &maxX, &maxY, &chunkScreenRect);
+
+    Rect chunkRect;
+    chunkRect.ulx = 0;
+    chunkRect.uly = 0;
+    chunkRect.lrx = SQUARE_CHUNK_WIDTH - 1;
+    chunkRect.lry = SQUARE_CHUNK_HEIGHT - 1;
+
+    bool drawn = false;
+    for (int y = minY; y <= maxY; y++) {
+        for (int x = minX; x <= maxX; x++) {
+            int squareTile = y * square_width + x;
+            int frmId = squares[elevation]->field_0[squareTile];
+            if ((((frmId & 0xF000) >> 12) & 0x01) == 0) {
+                int tileScreenX;
+                int tileScreenY;
+                square_coord(squareTile, &tileScreenX, &tileScreenY, elevation);
+                int fid = art_id(OBJ_TYPE_TILE, frmId & 0xFFF, 0, 0, 0);
+                floor_draw_to(fid,
+                    tile_num(tileScreenX, tileScreenY + 13, map_elevation),
+                    tileScreenX - chunkScreenRect.ulx,
+                    tileScreenY - chunkScreenRect.uly,
+                    &chunkRect,
+                    chunk->data,
+                    SQUARE_CHUNK_WIDTH,
+                    SQUARE_CHUNK_HEIGHT,
+                    SQUARE_CHUNK_WIDTH);
+                drawn = true;
+            }
+        }
+    }
+
+    return drawn;
+}
+
+// CE: Marks every cached floor chunk as outdated. Should be called when
+// floor is lit differently.
+void floor_cache_invalidate()
+{
+    square_chunk_cache_invalidate(&floor_cache);
+}
+
+// CE: Marks cached floor chunks lit by given hex tile as outdated. Should be
+// called when tile's light intensity is changed.
+void floor_cache_invalidate_tile(int elevation, int tile)
+{
+    if (!floor_cache.enabled) {
+        return;
+    }
+
+    if (elevation < 0 || elevation >= ELEVATION_COUNT || !TILE_IS_VALID(tile)) {
+        return;
+    }
+
+    // Floor square samples light of tiles up to one row above and three rows
+    // below its own tile, and up to two columns to the right (see
+    // `verticies`). Squares are twice as large as tiles, pad by one square to
+    // account for rounding.
+    int column = tile % grid_width;
+    int row = tile / grid_width;
+
+    square_chunk_cache_invalidate_range(&floor_cache,
+        elevation,
+        column / 2 - 1,
+        (row - 3) / 2 - 1,
+        (column + 2) / 2 + 1,
+        (row + 1) / 2 + 1);
+}
+
+// CE: Marks floor and roof caches and roof regions as outdated. Should be
+// called when square data is changed.
+void tile_invalidate_squares()
+{
+    square_chunk_cache_invalidate(&floor_cache);
+    square_chunk_cache_invalidate(&roof_cache);
+    roof_regions_valid = false;
+}
+
+// CE: Renders visible roof squares in given range by blending cached chunks
+// (see `roof_blit`). Chunks which cannot be cached are rendered square by
+// square.
+static void roof_cache_render(Rect* rect, int elevation, int minX, int minY, int maxX, int maxY, int light)
+{
+    if (maxX >= square_width) {
+        maxX = square_width - 1;
+    }
+
+    if (maxY >= square_length) {
+        maxY = square_length - 1;
+    }
+
+    if (maxX < minX || maxY < minY) {
+        return;
+    }
+
+    for (int chunkY = minY / SQUARE_CHUNK_SIZE; chunkY <= maxY / SQUARE_CHUNK_SIZE; chunkY++) {
+        for (int chunkX = minX / SQUARE_CHUNK_SIZE; chunkX <= maxX / SQUARE_CHUNK_SIZE; chunkX++) {
+            int chunkMinX;
+            int chunkMinY;
+            int chunkMaxX;
+            int chunkMaxY;
+            Rect chunkRect;
+            square_chunk_bounds(elevation, chunkX, chunkY, true, &chunkMinX, &chunkMinY, &chunkMaxX, &chunkMaxY, &chunkRect);
+
+            Rect drawRect;
+            if (rect_inside_bound(&chunkRect, rect, &drawRect) == -1) {
+                continue;
+            }
+
+            // Roofs are lit by ambient light only, which is applied when
+            // blending, so chunks keep unlit pixels.
+            SquareChunk* chunk = square_chunk_cache_get(&roof_cache, elevation, chunkX, chunkY, 0);
+            if (chunk == NULL) {
+                roof_draw_squares(&drawRect, elevation, chunkMinX, chunkMinY, chunkMaxX, chunkMaxY, light);
+                continue;
+            }
+
+            if (chunk->empty) {
+                continue;
+            }
+
+            roof_blit(chunk->data, chunkRect.ulx, chunkRect.uly, SQUARE_CHUNK_WIDTH, SQUARE_CHUNK_HEIGHT, &drawRect, light);
+        }
+    }
+}
+
+// CE: Copies chunk's visible roof squares into its buffer in the same order
+// as `square_render_roof` does.
+static bool roof_cache_build(SquareChunk* chunk, int elevation, int chunkX, int chunkY)
+{
+    int minX;
+    int minY;
+    int maxX;
+    int maxY;
+    Rect chunkScreenRect;
+    square_chunk_bounds(elevation, chunkX, chunkY, true, &minX, &minY, &maxX, &maxY, &chunkScreenRect);
+
+    Rect chunkRect;
+    chunkRect.ulx = 0;
+    chunkRect.uly = 0;
+    chunkRect.lrx = SQUARE_CHUNK_WIDTH - 1;
+    chunkRect.lry = SQUARE_CHUNK_HEIGHT - 1;
+
+    int emptyFid = art_id(OBJ_TYPE_TILE, 1, 0, 0, 0);
+
+    bool drawn = false;
+    for (int y = minY; y <= maxY; y++) {
+        for (int x = minX; x <= maxX; x++) {
+            int squareTile = y * square_width + x;
+            int frmId = squares[elevation]->field_0[squareTile];
+            frmId >>= 16;
+            if ((((frmId & 0xF000) >> 12) & 0x01) != 0) {
+                continue;
+            }
+
+            int fid = art_id(OBJ_TYPE_TILE, frmId & 0xFFF, 0, 0, 0);
+            if (fid == emptyFid) {
+                continue;
+            }
+
+            CacheEntry* tileFrmHandle;
+            Art* tileFrm = art_ptr_lock(fid, &tileFrmHandle);
+            if (tileFrm == NULL) {
+                continue;
+            }
+
+            int tileScreenX;
+            int tileScreenY;
+            square_coord_roof(squareTile, &tileScreenX, &tileScreenY, elevation);
+            tileScreenX -= chunkScreenRect.ulx;
+            tileScreenY -= chunkScreenRect.uly;
+
+            int tileWidth = art_frame_width(tileFrm, 0, 0);
+            int tileHeight = art_frame_length(tileFrm, 0, 0);
+
+            Rect tileRect;
+            tileRect.ulx = tileScreenX;
+            tileRect.uly = tileScreenY;
+            tileRect.lrx = tileScreenX + tileWidth - 1;
+            tileRect.lry = tileScreenY + tileHeight - 1;
+
+            if (rect_inside_bound(&tileRect, &chunkRect, &tileRect) == 0) {
+                trans_buf_to_buf(art_frame_data(tileFrm, 0, 0) + tileWidth * (tileRect.uly - tileScreenY) + (tileRect.ulx - tileScreenX),
+                    rectGetWidth(&tileRect),
+                    rectGetHeight(&tileRect),
+                    tileWidth,
+                    chunk->data + SQUARE_CHUNK_WIDTH * tileRect.uly + tileRect.ulx,
+                    SQUARE_CHUNK_WIDTH);
+                drawn = true;
+            }
+
+            art_ptr_unlock(tileFrmHandle);
+        }
+    }
+
+    return drawn;
+}
+
+// CE: Splits roof squares of every elevation into regions. Region is a group
+// of adjacent non-empty roof squares which `roof_fill_on` and `roof_fill_off`
+// would toggle together.
+static void roof_regions_build()
+{
+    roof_regions_free();
+
+    roof_regions_valid = true;
+
+    int emptyId = art_id(OBJ_TYPE_TILE, 1, 0, 0, 0) & 0xFFF;
+
+    int* stack = (int*)mem_malloc(sizeof(*stack) * square_size);
+    if (stack == NULL) {
+        return;
+    }
+
+    bool failed = false;
+
+    for (int elevation = 0; elevation < ELEVATION_COUNT; elevation++) {
+        RoofRegions* regions = &(roof_regions[elevation]);
+        int* data = squares[elevation]->field_0;
+
+        regions->squareRegions = (int*)mem_malloc(sizeof(*regions->squareRegions) * square_size);
+        regions->squares = (int*)mem_malloc(sizeof(*regions->squares) * square_size);
+        if (regions->squareRegions == NULL || regions->squares == NULL) {
+            failed = true;
+            break;
+        }
+
+        memset(regions->squareRegions, 0, sizeof(*regions->squareRegions) * square_size);
+
+        // First pass - label regions and collect their squares. Squares are
+        // appended to `squares` region by region, so only region starts need
+        // to be recorded.
+        int count = 0;
+        int length = 0;
+        int capacity = 0;
+        for (int squareTile = 0; squareTile < square_size; squareTile++) {
+            int roof = (data[squareTile] >> 16) & 0xFFFF;
+            if ((roof & 0xFFF) == emptyId || (((roof & 0xF000) >> 12) & 0x02) != 0 || regions->squareRegions[squareTile] != 0) {
+                continue;
+            }
+
+            if (count >= capacity) {
+                int newCapacity = capacity != 0 ? capacity * 2 : 64;
+                RoofRegion* newRegions = (RoofRegion*)mem_realloc(regions->regions, sizeof(*newRegions) * newCapacity);
+                if (newRegions == NULL) {
+                    failed = true;
+                    break;
+                }
+                regions->regions = newRegions;
+                capacity = newCapacity;
+            }
+
+            RoofRegion* region = &(regions->regions[count]);
+            region->start = length;
+            region->hidden = (((roof & 0xF000) >> 12) & 0x01) != 0;
+            region->minX = square_width;
+            region->minY = square_length;
+            region->maxX = -1;
+            region->maxY = -1;
+            count++;
+
+            int top = 0;
+            stack[top++] = squareTile;
+            regions->squareRegions[squareTile] = count;
+
+            while (top > 0) {
+                int current = stack[--top];
+                regions->squares[length++] = current;
+
+                int x = current % square_width;
+                int y = current / square_width;
+
+                if (x < region->minX) region->minX = x;
+                if (x > region->maxX) region->maxX = x;
+                if (y < region->minY) region->minY = y;
+                if (y > region->maxY) region->maxY = y;
+
+                int neighbors[4];
+                int neighborsLength = 0;
+                if (x > 0) neighbors[neighborsLength++] = current - 1;
+                if (x < square_width - 1) neighbors[neighborsLength++] = current + 1;
+                if (y > 0) neighbors[neighborsLength++] = current - square_width;
+                if (y < square_length - 1) neighbors[neighborsLength++] = current + square_width;
+
+                for (int index = 0; index < neighborsLength; index++) {
+                    int neighbor = neighbors[index];
+                    int neighborRoof = (data[neighbor] >> 16) & 0xFFFF;
+                    if ((neighborRoof & 0xFFF) != emptyId
+                        && (((neighborRoof & 0xF000) >> 12) & 0x02) == 0
+                        && regions->squareRegions[neighbor] == 0) {
+                        regions->squareRegions[neighbor] = count;
+                        stack[top++] = neighbor;
+                    }
+                }
+            }
+
+            region->length = length - region->start;
+        }
+
+        regions->count = count;
+
+        if (failed) {
+            break;
+        }
+    }
+
+    mem_free(stack);
+
+    if (failed) {
+        // Fall back to flood fills when regions cannot be built.
+        roof_regions_free();
+    }
+}
+
+// CE: Releases roof regions.
+static void roof_regions_free()
+{
+    for (int elevation = 0; elevation < ELEVATION_COUNT; elevation++) {
+        RoofRegions* regions = &(roof_regions[elevation]);
+        if (regions->squareRegions != NULL) {
+            mem_free(regions->squareRegions);
+            regions->squareRegions = NULL;
+        }
+
+        if (regions->squares != NULL) {
+            mem_free(regions->squares);
+            regions->squares = NULL;
+        }
+
+        if (regions->regions != NULL) {
+            mem_free(regions->regions);
+            regions->regions = NULL;
+        }
+
+        regions->count = 0;
+    }
+}
+
+// CE: Shows or hides roof region containing given square at once. Returns
+// `false` if regions are not available, in which case caller should fall
+// back to flood fill.
+static bool roof_region_fill(int x, int y, int elevation, bool on)
+{
+    if (elevation < 0 || elevation >= ELEVATION_COUNT) {
+        return false;
+    }
+
+    if (!roof_regions_valid) {
+        roof_regions_build();
+    }
+
+    RoofRegions* regions = &(roof_regions[elevation]);
+    if (regions->squareRegions == NULL) {
+        return false;
+    }
+
+    if (x < 0 || x >= square_width || y < 0 || y >= square_length) {
+        return true;
+    }
+
+    int regionIndex = regions->squareRegions[square_width * y + x];
+    if (regionIndex == 0) {
+        return true;
+    }
+
+    RoofRegion* region = &(regions->regions[regionIndex - 1]);
+
+    // Hidden region can only be shown and vice versa, this matches conditions
+    // of the starting square in flood fills.
+    if (region->hidden != on) {
+        return true;
+    }
+
+    region->hidden = !on;
+
+    int* data = squares[elevation]->field_0;
+    int mask = 0x01 << (12 + 16);
+    for (int index = 0; index < region->length; index++) {
+        int squareTile = regions->squares[region->start + index];
+        if (on) {
+            data[squareTile] &= ~mask;
+        } else {
+            data[squareTile] |= mask;
+        }
+    }
+
+    square_chunk_cache_invalidate_range(&roof_cache, elevation, region->minX, region->minY, region->maxX, region->maxY);
+
+    return true;
+}
+
+// 0x49F5B4
+bool square_roof_intersect(int x, int y, int elevation)
+{
+    if (!show_roof) {
+        return false;
+    }
+
+    bool result = false;
+
+    int tileX;
+    int tileY;
+    square_xy_roof(x, y, elevation, &tileX, &tileY);
+
+    TileData* ptr = squares[elevation];
+    int idx = square_width * tileY + tileX;
+    int upper = ptr->field_0[square_width * tileY + tileX] >> 16;
+    int fid = art_id(OBJ_TYPE_TILE, upper & 0xFFF, 0, 0, 0);
+    if (fid != art_id(OBJ_TYPE_TILE, 1, 0, 0, 0)) {
+        if ((((upper & 0xF000) >> 12) & 1) == 0) {
+            // CE: Test opacity mask of roof art instead of locking art on
+            // every call.
+            RoofMask* mask = roof_mask_get(upper & 0xFFF);
+            if (mask != NULL) {
+                int v18;
+                int v17;
+                square_coord_roof(idx, &v18, &v17, elevation);
+
+                int maskX = x - v18;
+                int maskY = y - v17;
+                if (maskX >= 0 && maskX < mask->width && maskY >= 0 && maskY < mask->height) {
+                    int bit = mask->width * maskY + maskX;
+                    if ((mask->bits[bit >> 3] & (1 << (bit & 7))) != 0) {
+                        result = true;
+                    }
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+// CE: Returns opacity mask (one bit per pixel of the first frame) of roof
+// tile art, built on first use. Returns NULL if art cannot be loaded.
+static RoofMask* roof_mask_get(int id)
+{
+    if (id < 0 || id >= ROOF_MASK_COUNT) {
+        return NULL;
+    }
+
+    if (roof_masks[id] != NULL) {
+        return roof_masks[id];
+    }
+
+    int fid = art_id(OBJ_TYPE_TILE, id, 0, 0, 0);
+    CacheEntry* handle;
+    Art* art = art_ptr_lock(fid, &handle);
+    if (art == NULL) {
+        return NULL;
+    }
+
+    RoofMask* mask = NULL;
+    unsigned char* data = art_frame_data(art, 0, 0);
+    if (data != NULL) {
+        int width = art_frame_width(art, 0, 0);
+        int height = art_frame_length(art, 0, 0);
+        int size = (width * height + 7) / 8;
+
+        mask = (RoofMask*)mem_malloc(sizeof(*mask) + size);
+        if (mask != NULL) {
+            mask->width = width;
+            mask->height = height;
+            mask->bits = (unsigned char*)(mask + 1);
+            memset(mask->bits, 0, size);
+
+            for (int index = 0; index < width * height; index++) {
+                if (data[index] != 0) {
+                    mask->bits[index >> 3] |= 1 << (index & 7);
+                }
+            }
+
+            roof_masks[id] = mask;
+        }
+    }
+
+    art_ptr_unlock(handle);
+
+    return mask;
+}
+
+static void roof_masks_free()
+{
+    for (int id = 0; id < ROOF_MASK_COUNT; id++) {
+        if (roof_masks[id] != NULL) {
+            mem_free(roof_masks[id]);
+            roof_masks[id] = NULL;
+        }
+    }
+}
+
+// 0x49F900
+void grid_toggle()
+{
+    show_grid = 1 - show_grid;
+}
+
+// 0x49F918
+void grid_on()
+{
+    show_grid = 1;
+}
+
+// 0x49F924
+void grid_off()
+{
+    show_grid = 0;
 }
 
 // 0x49F930
@@ -1587,6 +2892,13 @@ void draw_grid(int tile, int elevation, Rect* rect)
 
 // 0x49FB64
 void floor_draw(int fid, int x, int y, Rect* rect)
+{
+    floor_draw_to(fid, tile_num(x, y + 13, map_elevation), x, y, rect, buf, buf_width, buf_length, buf_full);
+}
+
+// CE: Extracted from `floor_draw` to render into arbitrary buffer. The `tile`
+// is a hex tile used to sample light intensities.
+static void floor_draw_to(int fid, int tile, int x, int y, Rect* rect, unsigned char* dest, int destWidth, int destHeight, int destPitch)
 {
     if (art_get_disable(FID_TYPE(fid)) != 0) {
         return;
@@ -1605,15 +2917,11 @@ void floor_draw(int fid, int x, int y, Rect* rect)
     int height = rect->lry - rect->uly + 1;
     int frameWidth;
     int frameHeight;
-    int tile;
     int v76;
     int v77;
     int v78;
     int v79;
 
-    int savedX = x;
-    int savedY = y;
-
     if (left < 0) {
         left = 0;
     }
@@ -1622,15 +2930,15 @@ void floor_draw(int fid, int x, int y, Rect* rect)
         top = 0;
     }
 
-    if (left + width > buf_width) {
-        width = buf_width - left;
+    if (left + width > destWidth) {
+        width = destWidth - left;
     }
 
-    if (top + height > buf_length) {
-        height = buf_length - top;
+    if (top + height > destHeight) {
+        height = destHeight - top;
     }
 
-    if (x >= buf_width || x > rect->lrx || y >= buf_length || y > rect->lry) goto out;
+    if (x >= destWidth || x > rect->lrx || y >= destHeight || y > rect->lry) goto out;
 
     frameWidth = art_frame_width(art, 0, 0);
     frameHeight = art_frame_length(art, 0, 0);
@@ -1663,7 +2971,6 @@ void floor_draw(int fid, int x, int y, Rect* rect)
 
     if (v77 <= 0 || v76 <= 0) goto out;
 
-    tile = tile_num(savedX, savedY + 13, map_elevation);
     if (tile != -1) {
         int parity = tile & 1;
         int ambientIntensity = light_get_ambient();
@@ -1688,7 +2995,7 @@ void floor_draw(int fid, int x, int y, Rect* rect)
 
         if (v23 == 9) {
             unsigned char* frame_data = art_frame_data(art, 0, 0);
-            dark_trans_buf_to_buf(frame_data + frameWidth * v78 + v79, v77, v76, frameWidth, buf, x, y, buf_full, verticies[0].intensity);
+            dark_trans_buf_to_buf(frame_data + frameWidth * v78 + v79, v77, v76, frameWidth, dest, x, y, destPitch, verticies[0].intensity);
             goto out;
         }
 
@@ -1800,11 +3107,11 @@ void floor_draw(int fid, int x, int y, Rect* rect)
             }
         }
 
-        unsigned char* v66 = buf + buf_full * y + x;
+        unsigned char* v66 = dest + destPitch * y + x;
         unsigned char* v67 = art_frame_data(art, 0, 0) + frameWidth * v78 + v79;
         int* v68 = &(intensity_map[160 + 80 * v78]) + v79;
         int v86 = frameWidth - v77;
-        int v85 = buf_full - v77;
+        int v85 = destPitch - v77;
         int v87 = 80 - v77;
 
         while (--v76 != -1) {
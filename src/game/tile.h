@@ -23,12 +23,17 @@ void tile_reset();
 void tile_exit();
 void tile_disable_refresh();
 void tile_enable_refresh();
+bool tile_refresh_is_enabled();
 void tile_refresh_rect(Rect* rect, int elevation);
 void tile_refresh_display();
+void tile_invalidate_display();
+bool tile_display_valid();
 int tile_set_center(int tile, int flags);
 void tile_toggle_roof(int a1);
 int tile_roof_visible();
 int tile_coord(int tile, int* x, int* y, int elevation);
+int tile_coord_world(int tile, int* worldX, int* worldY);
+void tile_world_origin(int* originX, int* originY);
 int tile_num(int x, int y, int elevation, bool ignoreBounds = false);
 int tile_dist(int a1, int a2);
 bool tile_in_front_of(int tile1, int tile2);
@@ -36,6 +41,7 @@ bool tile_to_right_of(int tile1, int tile2);
 int tile_num_in_direction(int tile, int rotation, int distance);
 int tile_dir(int a1, int a2);
 int tile_num_beyond(int from, int to, int distance);
+void tile_set_tables_enabled(bool enabled);
 void tile_enable_scroll_blocking();
 void tile_disable_scroll_blocking();
 bool tile_get_scroll_blocking();
@@ -51,6 +57,7 @@ void square_xy_roof(int screenX, int screenY, int elevation, int* coordX, int* c
 void square_render_roof(Rect* rect, int elevation);
 void tile_fill_roof(int x, int y, int elevation, bool on);
 void square_render_floor(Rect* rect, int elevation);
+void square_render_floor_banded(Rect* rect, int elevation);
 bool square_roof_intersect(int x, int y, int elevation);
 void grid_toggle();
 void grid_on();
@@ -60,6 +67,9 @@ void grid_render(Rect* rect, int elevation);
 void grid_draw(int tile, int elevation);
 void draw_grid(int tile, int elevation, Rect* rect);
 void floor_draw(int fid, int x, int y, Rect* rect);
+void floor_cache_invalidate();
+void floor_cache_invalidate_tile(int elevation, int tile);
+void tile_invalidate_squares();
 int tile_make_line(int currentCenterTile, int newCenterTile, int* tiles, int tilesCapacity);
 int tile_scroll_to(int tile, int flags);
 
@@ -8,8 +8,98 @@
 
 namespace fallout {
 
-// 0x4A91C0
+// CE: Number of wrapped strings remembered by `word_wrap`.
+#define WORD_WRAP_CACHE_CAPACITY 32
+
+// CE: Longest string (including terminator) remembered by `word_wrap`.
+#define WORD_WRAP_CACHE_STRING_MAX 1024
+
+// CE: Wrapping of one string. Result depends only on string, width and font
+// metrics, so font number is part of the key.
+typedef struct WordWrapCacheEntry {
+    unsigned int lastUsed;
+    unsigned int hash;
+    int font;
+    int width;
+    int rc;
+    short breakpointsLength;
+    short breakpoints[WORD_WRAP_MAX_COUNT];
+    char string[WORD_WRAP_CACHE_STRING_MAX];
+} WordWrapCacheEntry;
+
+static int word_wrap_internal(const char* string, int width, short* breakpoints, short* breakpointsLengthPtr);
+static unsigned int word_wrap_hash(const char* string, size_t length);
+
+// CE: Pipboy, editor and dialog boxes wrap the same text on every redraw.
+static WordWrapCacheEntry word_wrap_cache[WORD_WRAP_CACHE_CAPACITY];
+static unsigned int word_wrap_cache_clock = 0;
+
+// CE: Returns cached wrapping when the same string was wrapped with the same
+// font and width recently.
 int word_wrap(const char* string, int width, short* breakpoints, short* breakpointsLengthPtr)
+{
+    size_t length = strlen(string);
+    if (length >= WORD_WRAP_CACHE_STRING_MAX) {
+        return word_wrap_internal(string, width, breakpoints, breakpointsLengthPtr);
+    }
+
+    unsigned int hash = word_wrap_hash(string, length);
+    int font = text_curr();
+
+    word_wrap_cache_clock++;
+    if (word_wrap_cache_clock == 0) {
+        // Clock wrapped around, forget everything rather than keep stale
+        // recency.
+        memset(word_wrap_cache, 0, sizeof(word_wrap_cache));
+        word_wrap_cache_clock = 1;
+    }
+
+    WordWrapCacheEntry* candidate = NULL;
+    for (int index = 0; index < WORD_WRAP_CACHE_CAPACITY; index++) {
+        WordWrapCacheEntry* entry = &(word_wrap_cache[index]);
+        if (entry->lastUsed != 0
+            && entry->hash == hash
+            && entry->font == font
+            && entry->width == width
+            && strcmp(entry->string, string) == 0) {
+            entry->lastUsed = word_wrap_cache_clock;
+            memcpy(breakpoints, entry->breakpoints, sizeof(entry->breakpoints));
+            *breakpointsLengthPtr = entry->breakpointsLength;
+            return entry->rc;
+        }
+
+        if (candidate == NULL || entry->lastUsed < candidate->lastUsed) {
+            candidate = entry;
+        }
+    }
+
+    int rc = word_wrap_internal(string, width, breakpoints, breakpointsLengthPtr);
+
+    candidate->lastUsed = word_wrap_cache_clock;
+    candidate->hash = hash;
+    candidate->font = font;
+    candidate->width = width;
+    candidate->rc = rc;
+    candidate->breakpointsLength = *breakpointsLengthPtr;
+    memcpy(candidate->breakpoints, breakpoints, sizeof(candidate->breakpoints));
+    memcpy(candidate->string, string, length + 1);
+
+    return rc;
+}
+
+// CE: FNV-1a.
+static unsigned int word_wrap_hash(const char* string, size_t length)
+{
+    unsigned int hash = 2166136261u;
+    for (size_t index = 0; index < length; index++) {
+        hash ^= (unsigned char)string[index];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// 0x4A91C0
+static int word_wrap_internal(const char* string, int width, short* breakpoints, short* breakpointsLengthPtr)
 {
     breakpoints[0] = 0;
     *breakpointsLengthPtr = 1;
@@ -4,6 +4,11 @@
 #include <stdio.h>
 #include <string.h>
 
+#include <SDL.h>
+
+#include <algorithm>
+#include <vector>
+
 #include "game/anim.h"
 #include "game/art.h"
 #include "game/bmpdlog.h"
@@ -21,6 +26,7 @@
 #include "game/gsound.h"
 #include "game/intface.h"
 #include "game/item.h"
+#include "game/map.h"
 #include "game/map_defs.h"
 #include "game/message.h"
 #include "game/object.h"
@@ -34,6 +40,7 @@
 #include "game/scripts.h"
 #include "game/skill.h"
 #include "game/stat.h"
+#include "game/statever.h"
 #include "game/tile.h"
 #include "game/worldmap_walkmask.h"
 #include "platform_compat.h"
@@ -54,6 +61,7 @@ namespace fallout {
 #define WM_WINDOW_HEIGHT 480
 
 #define WM_WORLDMAP_WIDTH 1400
+#define WM_WORLDMAP_HEIGHT 1500
 
 #define LOCATION_MARKER_WIDTH 5
 #define LOCATION_MARKER_HEIGHT 5
@@ -91,6 +99,33 @@ typedef struct TownHotSpotEntry {
     char name[16];
 } TownHotSpotEntry;
 
+// CE: Tags speculative destination reads in db prefetch queue.
+#define WM_PRELOAD_GROUP 0x574D
+
+// CE: Maximum number of entrances (and therefore map files) of a town.
+#define WM_PRELOAD_MAP_CAPACITY 7
+
+#define WM_PRELOAD_IDLE 0
+#define WM_PRELOAD_READING 1
+#define WM_PRELOAD_READ 2
+
+// CE: Destination map file being scanned on db prefetch thread.
+typedef struct WorldmapPreloadMap {
+    int state;
+    // Set when preload is cancelled while file is being read, result is
+    // dropped.
+    bool cancelled;
+    MapScanResult scan;
+} WorldmapPreloadMap;
+
+// CE: Party position and game time elapsed since start of travel after each
+// travel iteration, see `wm_travel`.
+typedef struct WorldmapTravelStep {
+    int x;
+    int y;
+    int time;
+} WorldmapTravelStep;
+
 static void UpdVisualArea();
 static int CheckEvents();
 static int LoadTownMap(const char* filename, int map_idx);
@@ -101,7 +136,11 @@ static void UpdateTownStatus();
 static int InCity(unsigned int x, unsigned int y);
 static void world_move_init();
 static int world_move_step();
+static int wm_travel_step();
+static int wm_travel();
 static void block_map(unsigned int x, unsigned int y, unsigned char* dst);
+static void wm_compose_cell(int row, int column);
+static void wm_draw_map(int x, int y);
 static void DrawTownLabels(unsigned char* src, unsigned char* dst);
 static void DrawMapTime(int is_town_map);
 static void map_num(int value, int digits, int x, int y, int is_town_map);
@@ -113,6 +152,11 @@ static void CalcTimeAdder();
 static void BlackOut();
 static bool worldmapIsValidArea(int area);
 static bool worldmapIsValidEntrance(int area, int entrance);
+static void wmPreloadStart(int town);
+static void wmPreloadBegin(int town);
+static void wmPreloadCancel();
+static void wmPreloadProcess();
+static void wmPreloadMapRead(void* userData, unsigned char* data, size_t size);
 
 // 0x4A9330
 static const unsigned char mouse_table1[3][3][2] = {
@@ -893,6 +937,14 @@ static unsigned char WorldGrid[31][29];
 // 0x6713C4
 static unsigned char wwin_flag;
 
+// CE: Worldmap at full resolution with fog of war applied. Allocated while
+// worldmap is open, see `wm_draw_map`.
+static unsigned char* wmap_composed = NULL;
+
+// CE: State of `WorldGrid` cells as composed into `wmap_composed`, 0xFF
+// means cell was not composed yet.
+static unsigned char wmap_composed_grid[31][29];
+
 // True only while world_map() is executing its modal UI loop/context.
 static bool gWorldmapActive;
 static bool gWorldmapTownmapActive = false;
@@ -900,6 +952,22 @@ static int gWorldmapTownmapArea = -1;
 static int gAgentTownmapPendingEntrance = -1;
 static bool gAgentWmForceExit = false;
 
+// CE: Speculative preloading of destination town maps during travel. Map
+// files are scanned on db prefetch thread, square art and map script found
+// there are prefetched on main thread (see `wmPreloadProcess`). Everything is
+// only read into db cache, so cancelling is just dropping queued reads.
+static SDL_mutex* wmPreloadMutex = NULL;
+static WorldmapPreloadMap wmPreloadMaps[WM_PRELOAD_MAP_CAPACITY];
+
+// Town whose maps are being preloaded.
+static int wmPreloadTown = -1;
+
+// Town to preload once reads for previous one are finished.
+static int wmPreloadPendingTown = -1;
+
+// Remaining number of bytes to schedule for current town.
+static size_t wmPreloadBudget = 0;
+
 static bool worldmapIsValidArea(int area)
 {
     return area >= 0 && area < TOWN_COUNT;
@@ -972,6 +1040,7 @@ int init_world_map()
     first_visit_flag = 0;
     world_xpos = 50 * city_location[TOWN_VAULT_13].column + 50 / 2;
     world_ypos = 50 * city_location[TOWN_VAULT_13].row + 50 / 2;
+    statever_bump(STATE_VERSION_WORLDMAP);
     our_town = 0;
     our_section = 1;
     first_visit_flag |= 1;
@@ -1008,6 +1077,8 @@ int load_world_map(DB_FILE* stream)
     if (db_freadInt32(stream, &world_xpos) == -1) return -1;
     if (db_freadInt32(stream, &world_ypos) == -1) return -1;
 
+    statever_bump(STATE_VERSION_WORLDMAP);
+
     return 0;
 }
 
@@ -1185,14 +1256,8 @@ int world_map(WorldMapContext ctx)
             viewport_y = VIEWPORT_MAX_Y;
         }
 
-        buf_to_buf(wmapbmp[WORLDMAP_FRM_WORLDMAP] + WM_WORLDMAP_WIDTH * viewport_y + viewport_x,
-            450,
-            442,
-            WM_WORLDMAP_WIDTH,
-            world_buf + WM_WINDOW_WIDTH * 21 + 22,
-            WM_WINDOW_WIDTH);
         UpdVisualArea();
-        block_map(viewport_x, viewport_y, world_buf);
+        wm_draw_map(viewport_x, viewport_y);
         trans_buf_to_buf(wmapbmp[WORLDMAP_FRM_BOX],
             WM_WINDOW_WIDTH,
             WM_WINDOW_HEIGHT,
@@ -1324,6 +1389,13 @@ int world_map(WorldMapContext ctx)
                         world_move_init();
                         dropbtn = 0;
                         is_moving_to_town = InCity(target_xpos, target_ypos) != -1;
+
+                        // CE: Route changed, follow new destination (if any).
+                        if (is_moving_to_town) {
+                            wmPreloadStart(InCity(target_xpos, target_ypos));
+                        } else {
+                            wmPreloadCancel();
+                        }
                     }
                 }
             } else {
@@ -1518,6 +1590,9 @@ int world_map(WorldMapContext ctx)
             }
 
             if (is_moving) {
+                // CE: Hand over scanned destination maps.
+                wmPreloadProcess();
+
                 v109 = 0;
                 dropbtn = 0;
                 while (v109 < 2) {
@@ -1530,12 +1605,10 @@ int world_map(WorldMapContext ctx)
                         move_counter -= 1;
                         if (move_counter <= 0) {
                             is_moving = world_move_step() == 0;
-                            if (world_xpos < 1064 && world_ypos > 0) {
-                                if (((128 >> (world_xpos % 8)) & WALKMASK_MASK_DATA[world_ypos][world_xpos / 8]) != 0) {
-                                    world_xpos = old_world_xpos;
-                                    world_ypos = old_world_ypos;
-                                    is_moving = 0;
-                                }
+                            if (walkmask_is_blocked(world_xpos, world_ypos)) {
+                                world_xpos = old_world_xpos;
+                                world_ypos = old_world_ypos;
+                                is_moving = 0;
                             }
                             move_counter = 2;
                         }
@@ -1566,23 +1639,19 @@ int world_map(WorldMapContext ctx)
                         break;
                     case TERRAIN_TYPE_CITY:
                         is_moving = world_move_step() == 0;
-                        if (world_xpos < 1064 && world_ypos > 0) {
-                            if (((128 >> (world_xpos % 8)) & WALKMASK_MASK_DATA[world_ypos][world_xpos / 8]) != 0) {
-                                world_xpos = old_world_xpos;
-                                world_ypos = old_world_ypos;
-                                is_moving = false;
-                            }
+                        if (walkmask_is_blocked(world_xpos, world_ypos)) {
+                            world_xpos = old_world_xpos;
+                            world_ypos = old_world_ypos;
+                            is_moving = false;
                         }
 
                         move_counter -= 1;
                         if (move_counter <= 0 && is_moving) {
                             is_moving = world_move_step() == 0;
-                            if (world_xpos < 1064 && world_ypos > 0) {
-                                if (((128 >> (world_xpos % 8)) & WALKMASK_MASK_DATA[world_ypos][world_xpos / 8]) != 0) {
-                                    world_xpos = old_world_xpos;
-                                    world_ypos = old_world_ypos;
-                                    is_moving = false;
-                                }
+                            if (walkmask_is_blocked(world_xpos, world_ypos)) {
+                                world_xpos = old_world_xpos;
+                                world_ypos = old_world_ypos;
+                                is_moving = false;
                             }
                             move_counter = 4;
                         } else {
@@ -1613,12 +1682,10 @@ int world_map(WorldMapContext ctx)
                         break;
                     default:
                         is_moving = world_move_step() == 0;
-                        if (world_xpos < 1064 && world_ypos > 0) {
-                            if (((128 >> (world_xpos % 8)) & WALKMASK_MASK_DATA[world_ypos][world_xpos / 8]) != 0) {
-                                world_xpos = old_world_xpos;
-                                world_ypos = old_world_ypos;
-                                is_moving = 0;
-                            }
+                        if (walkmask_is_blocked(world_xpos, world_ypos)) {
+                            world_xpos = old_world_xpos;
+                            world_ypos = old_world_ypos;
+                            is_moving = 0;
                         }
 
                         move_counter = 0;
@@ -1660,9 +1727,9 @@ int world_map(WorldMapContext ctx)
                         wmap_mile = 0;
                         partyMemberRestingHeal(24);
 
-                        random_enc_chance = roll_random(1, 6);
-                        random_enc_chance += roll_random(1, 6);
-                        random_enc_chance += roll_random(1, 6);
+                        random_enc_chance = roll_random_stream(ROLL_STREAM_ENCOUNTER, 1, 6);
+                        random_enc_chance += roll_random_stream(ROLL_STREAM_ENCOUNTER, 1, 6);
+                        random_enc_chance += roll_random_stream(ROLL_STREAM_ENCOUNTER, 1, 6);
                         if (InCity(world_xpos, world_ypos) == -1) {
                             switch (WorldEcountChanceTable[world_ypos / 50][world_xpos / 50]) {
                             case 0:
@@ -1691,9 +1758,9 @@ int world_map(WorldMapContext ctx)
                         if (is_entering_random_encounter) {
                             v142 = 0;
                             while (v142 == 0) {
-                                special_enc_chance = roll_random(1, 6);
-                                special_enc_chance += roll_random(1, 6);
-                                special_enc_chance += roll_random(1, 6);
+                                special_enc_chance = roll_random_stream(ROLL_STREAM_ENCOUNTER, 1, 6);
+                                special_enc_chance += roll_random_stream(ROLL_STREAM_ENCOUNTER, 1, 6);
+                                special_enc_chance += roll_random_stream(ROLL_STREAM_ENCOUNTER, 1, 6);
                                 special_enc_chance -= 5;
                                 special_enc_chance += stat_level(obj_dude, STAT_LUCK);
                                 special_enc_chance += 2 * perk_level(PERK_EXPLORER);
@@ -1702,7 +1769,7 @@ int world_map(WorldMapContext ctx)
                                     break;
                                 }
 
-                                special_enc_chance = roll_random(1, 100);
+                                special_enc_chance = roll_random_stream(ROLL_STREAM_ENCOUNTER, 1, 100);
                                 for (v109 = 0; v109 < 6 && v142 == 0; v109++) {
                                     if (special_enc_chance >= SpclEncRange[v109].start && special_enc_chance <= SpclEncRange[v109].end) {
                                         if ((encounter_specials & (1 << v109)) != 0) {
@@ -1772,13 +1839,7 @@ int world_map(WorldMapContext ctx)
             }
 
             if (should_redraw) {
-                buf_to_buf(wmapbmp[WORLDMAP_FRM_WORLDMAP] + WM_WORLDMAP_WIDTH * viewport_y + viewport_x,
-                    450,
-                    442,
-                    WM_WORLDMAP_WIDTH,
-                    world_buf + 640 * 21 + 22,
-                    640);
-                block_map(viewport_x, viewport_y, world_buf);
+                wm_draw_map(viewport_x, viewport_y);
 
                 if (dropbtn) {
                     temp_x = world_xpos - viewport_x + 10;
@@ -1938,13 +1999,7 @@ int world_map(WorldMapContext ctx)
                 }
             }
 
-            buf_to_buf(wmapbmp[WORLDMAP_FRM_WORLDMAP] + WM_WORLDMAP_WIDTH * viewport_y + viewport_x,
-                450,
-                442,
-                WM_WORLDMAP_WIDTH,
-                world_buf + 21 * WM_WINDOW_WIDTH + 22,
-                WM_WINDOW_WIDTH);
-            block_map(viewport_x, viewport_y, world_buf);
+            wm_draw_map(viewport_x, viewport_y);
 
             trans_buf_to_buf(wmapbmp[WORLDMAP_FRM_BOX],
                 35,
@@ -2188,6 +2243,11 @@ int world_map(WorldMapContext ctx)
 
     out:
 
+        // CE: Destination is not going to be entered.
+        if (is_entering_random_encounter || is_entering_random_terrain) {
+            wmPreloadCancel();
+        }
+
         UnInitWorldMapData();
         art_flush();
 
@@ -2197,7 +2257,7 @@ int world_map(WorldMapContext ctx)
 
             terrain = WorldTerraTable[world_ypos / 50][world_xpos / 50];
             while (1) {
-                map_index = roll_random(0, 2);
+                map_index = roll_random_stream(ROLL_STREAM_ENCOUNTER, 0, 2);
                 if (RandEnctNames[terrain][map_index] != NULL) {
                     break;
                 }
@@ -2236,7 +2296,7 @@ int world_map(WorldMapContext ctx)
 
                 terrain = WorldTerraTable[world_ypos / 50][world_xpos / 50];
                 while (1) {
-                    map_index = roll_random(0, 2);
+                    map_index = roll_random_stream(ROLL_STREAM_ENCOUNTER, 0, 2);
                     if (RandEnctNames[terrain][map_index] != NULL) {
                         break;
                     }
@@ -2688,21 +2748,24 @@ static void TargetTown(int city)
     target_xpos = 50 * city_location[city].column + 50 / 2;
     target_ypos = 50 * city_location[city].row + 50 / 2;
 
-    offset = roll_random(0, 16);
-    if (roll_random(0, 1)) {
+    offset = roll_random_stream(ROLL_STREAM_ENCOUNTER, 0, 16);
+    if (roll_random_stream(ROLL_STREAM_ENCOUNTER, 0, 1)) {
         target_xpos += offset;
     } else {
         target_xpos -= offset;
     }
 
-    offset = roll_random(0, 16);
-    if (roll_random(0, 1)) {
+    offset = roll_random_stream(ROLL_STREAM_ENCOUNTER, 0, 16);
+    if (roll_random_stream(ROLL_STREAM_ENCOUNTER, 0, 1)) {
         target_ypos += offset;
     } else {
         target_ypos -= offset;
     }
 
     world_move_init();
+
+    // CE: Destination is known, warm caches for its maps.
+    wmPreloadStart(city);
 }
 
 // 0x4ACE98
@@ -2863,6 +2926,11 @@ static int InitWorldMapData()
 
     bx_enable = disable_box_bar_win();
 
+    // CE: Cells are composed on demand, see `wm_draw_map`. Without cache map
+    // is drawn the original way.
+    wmap_composed = (unsigned char*)mem_malloc(WM_WORLDMAP_WIDTH * WM_WORLDMAP_HEIGHT);
+    memset(wmap_composed_grid, 0xFF, sizeof(wmap_composed_grid));
+
     return 0;
 }
 
@@ -2874,6 +2942,11 @@ static void UnInitWorldMapData()
     mem_free(line1bit_buf);
     mem_free(sea_mask);
 
+    if (wmap_composed != NULL) {
+        mem_free(wmap_composed);
+        wmap_composed = NULL;
+    }
+
     message_exit(&wrldmap_mesg_file);
 
     for (index = 0; index < WORLDMAP_FRM_COUNT; index++) {
@@ -2999,6 +3072,7 @@ static int world_move_step()
 {
     old_world_xpos = world_xpos;
     old_world_ypos = world_ypos;
+    statever_bump(STATE_VERSION_WORLDMAP);
 
     if (deltaLineX <= deltaLineY) {
         line_index++;
@@ -3031,6 +3105,113 @@ static int world_move_step()
     return 0;
 }
 
+// CE: Same as `world_move_step`, but steps into terrain blocked by walkmask
+// are undone (like travel loop in `world_map` does) and end travel.
+static int wm_travel_step()
+{
+    int rc = world_move_step();
+    if (rc == 0 && walkmask_is_blocked(world_xpos, world_ypos)) {
+        world_xpos = old_world_xpos;
+        world_ypos = old_world_ypos;
+        rc = 1;
+    }
+
+    return rc;
+}
+
+// CE: Travels towards `target_xpos`/`target_ypos` without drawing.
+//
+// Whole route is computed up front with the same terrain rules as travel
+// loop in `world_map` (mountains take twice as long, cities are crossed at
+// double speed for free). Game time for the route is then advanced at once
+// with due events processed in order (see `gtime_skip`); when event handler
+// or script interrupts, party is left at the point of the route reached by
+// then. Fog of war is revealed once per crossed cell and party heals once
+// per day of travel (counted in `wmap_mile`, reset by caller).
+//
+// Random encounters are not rolled - entering encounter maps is up to the
+// worldmap UI.
+//
+// Returns 0 when travel is over (destination reached or terrain blocks the
+// way), 1 when interrupted by event or script, -1 when user wants to quit.
+static int wm_travel()
+{
+    std::vector<WorldmapTravelStep> route;
+    int startX = world_xpos;
+    int startY = world_ypos;
+    int elapsed = 0;
+    int moveCounter = 0;
+    int rc = 0;
+
+    world_move_init();
+    CalcTimeAdder();
+
+    while (rc == 0) {
+        switch (WorldTerraTable[world_ypos / 50][world_xpos / 50]) {
+        case TERRAIN_TYPE_MOUNTAIN:
+            moveCounter--;
+            if (moveCounter <= 0) {
+                moveCounter = 2;
+                rc = wm_travel_step();
+            }
+            elapsed += time_adder;
+            break;
+        case TERRAIN_TYPE_CITY:
+            rc = wm_travel_step();
+            moveCounter--;
+            if (moveCounter <= 0 && rc == 0) {
+                moveCounter = 4;
+                rc = wm_travel_step();
+            }
+            break;
+        default:
+            rc = wm_travel_step();
+            moveCounter = 0;
+            elapsed += time_adder;
+            break;
+        }
+
+        WorldmapTravelStep step;
+        step.x = world_xpos;
+        step.y = world_ypos;
+        step.time = elapsed;
+        route.push_back(step);
+    }
+
+    world_xpos = startX;
+    world_ypos = startY;
+
+    int startTime = game_time();
+    rc = gtime_skip(startTime + elapsed);
+
+    int reached = game_time() - startTime;
+    int currentRow = world_ypos / 50;
+    int currentColumn = world_xpos / 50;
+
+    for (size_t index = 0; index < route.size() && route[index].time <= reached; index++) {
+        old_world_xpos = world_xpos;
+        old_world_ypos = world_ypos;
+        world_xpos = route[index].x;
+        world_ypos = route[index].y;
+
+        if (world_ypos / 50 != currentRow || world_xpos / 50 != currentColumn) {
+            currentRow = world_ypos / 50;
+            currentColumn = world_xpos / 50;
+            UpdVisualArea();
+        }
+
+        wmap_mile++;
+        if (wmap_mile >= wmap_day) {
+            wmap_mile = 0;
+            partyMemberRestingHeal(24);
+        }
+    }
+
+    statever_bump(STATE_VERSION_WORLDMAP);
+
+    return rc;
+}
+
 // 0x4AD628
 static void block_map(unsigned int x, unsigned int y, unsigned char* dst)
 {
@@ -3110,6 +3291,74 @@ static void block_map(unsigned int x, unsigned int y, unsigned char* dst)
     }
 }
 
+// CE: Composes single `WorldGrid` cell into `wmap_composed` the same way
+// `block_map` does it over the window.
+static void wm_compose_cell(int row, int column)
+{
+    int x = column * 50;
+    int y = row * 50;
+    if (x >= WM_WORLDMAP_WIDTH || y >= WM_WORLDMAP_HEIGHT) {
+        return;
+    }
+
+    int width = std::min(50, WM_WORLDMAP_WIDTH - x);
+    int height = std::min(50, WM_WORLDMAP_HEIGHT - y);
+    unsigned char* src = wmapbmp[WORLDMAP_FRM_WORLDMAP] + WM_WORLDMAP_WIDTH * y + x;
+    unsigned char* dst = wmap_composed + WM_WORLDMAP_WIDTH * y + x;
+
+    switch (WorldGrid[row][column]) {
+    case 0:
+        buf_fill(dst, width, height, WM_WORLDMAP_WIDTH, colorTable[0]);
+        break;
+    case 1:
+        // Transparent pixels are skipped, so they are copied first.
+        buf_to_buf(src, width, height, WM_WORLDMAP_WIDTH, dst, WM_WORLDMAP_WIDTH);
+        dark_trans_buf_to_buf(src, width, height, WM_WORLDMAP_WIDTH, wmap_composed, x, y, WM_WORLDMAP_WIDTH, 32786);
+        break;
+    default:
+        buf_to_buf(src, width, height, WM_WORLDMAP_WIDTH, dst, WM_WORLDMAP_WIDTH);
+        break;
+    }
+
+    wmap_composed_grid[row][column] = WorldGrid[row][column];
+}
+
+// CE: Draws visible part of worldmap with fog of war into `world_buf`.
+// Replaces copying map and then `block_map` on every redraw: only cells whose
+// discovery state changed since last time are composed again, the rest is a
+// single blit.
+static void wm_draw_map(int x, int y)
+{
+    if (wmap_composed == NULL) {
+        buf_to_buf(wmapbmp[WORLDMAP_FRM_WORLDMAP] + WM_WORLDMAP_WIDTH * y + x,
+            450,
+            442,
+            WM_WORLDMAP_WIDTH,
+            world_buf + WM_WINDOW_WIDTH * 21 + 22,
+            WM_WINDOW_WIDTH);
+        block_map(x, y, world_buf);
+        return;
+    }
+
+    int lastRow = std::min((y + 442 - 1) / 50, 30);
+    int lastColumn = std::min((x + 450 - 1) / 50, 28);
+
+    for (int row = y / 50; row <= lastRow; row++) {
+        for (int column = x / 50; column <= lastColumn; column++) {
+            if (wmap_composed_grid[row][column] != WorldGrid[row][column]) {
+                wm_compose_cell(row, column);
+            }
+        }
+    }
+
+    buf_to_buf(wmap_composed + WM_WORLDMAP_WIDTH * y + x,
+        450,
+        442,
+        WM_WORLDMAP_WIDTH,
+        world_buf + WM_WINDOW_WIDTH * 21 + 22,
+        WM_WINDOW_WIDTH);
+}
+
 // 0x4AD7D4
 static void DrawTownLabels(unsigned char* src, unsigned char* dst)
 {
@@ -3851,10 +4100,12 @@ int worldmap_script_jump(int city, int a2)
     return 0;
 }
 
+// Travels to given worldmap coordinates instantly, see `wm_travel`. Party
+// follows shortest walkable route (see `walkmask_find_path`), when there is
+// none it heads straight to destination until blocked.
 int worldmap_walk_to_coords(int x, int y)
 {
-    int rc;
-    int moveCounter;
+    WalkmaskPoint waypoints[WALKMASK_MAX_WAYPOINTS];
 
     if (x < 0) {
         x = 0;
@@ -3864,48 +4115,30 @@ int worldmap_walk_to_coords(int x, int y)
 
     if (y < 0) {
         y = 0;
-    } else if (y >= 1500) {
-        y = 1499;
+    } else if (y >= WM_WORLDMAP_HEIGHT) {
+        y = WM_WORLDMAP_HEIGHT - 1;
     }
 
-    target_xpos = x;
-    target_ypos = y;
-    world_move_init();
-    CalcTimeAdder();
+    int count = walkmask_find_path(world_xpos, world_ypos, x, y, waypoints, WALKMASK_MAX_WAYPOINTS);
+    if (count == -1) {
+        waypoints[0].x = x;
+        waypoints[0].y = y;
+        count = 1;
+    }
 
     wmap_mile = 0;
-    moveCounter = 0;
-    rc = 0;
 
-    while (rc == 0) {
-        switch (WorldTerraTable[world_ypos / 50][world_xpos / 50]) {
-        case TERRAIN_TYPE_MOUNTAIN:
-            moveCounter--;
-            if (moveCounter <= 0) {
-                moveCounter = 2;
-                rc = world_move_step();
-            }
-            inc_game_time(time_adder);
-            break;
-        case TERRAIN_TYPE_CITY:
-            rc = world_move_step();
-            moveCounter--;
-            if (moveCounter <= 0 && rc == 0) {
-                moveCounter = 4;
-                rc = world_move_step();
-            }
-            break;
-        default:
-            rc = world_move_step();
-            moveCounter = 0;
-            inc_game_time(time_adder);
-            break;
+    for (int index = 0; index < count; index++) {
+        target_xpos = waypoints[index].x;
+        target_ypos = waypoints[index].y;
+
+        int rc = wm_travel();
+        if (rc != 0) {
+            return rc;
         }
 
-        wmap_mile++;
-        if (wmap_mile >= wmap_day) {
-            wmap_mile = 0;
-            partyMemberRestingHeal(24);
+        if (world_xpos != target_xpos || world_ypos != target_ypos) {
+            break;
         }
     }
 
@@ -3923,6 +4156,7 @@ int worldmap_enter_area_entrance(int area, int entrance)
     // Keep world map metadata in sync with direct programmatic entry.
     world_xpos = 50 * city_location[area].column + 50 / 2;
     world_ypos = 50 * city_location[area].row + 50 / 2;
+    statever_bump(STATE_VERSION_WORLDMAP);
     our_town = area;
     our_section = entrance;
     first_visit_flag |= 1 << area;
@@ -4098,6 +4332,7 @@ int worldmap_teleport_to_area(int area)
 
     world_xpos = 50 * city_location[area].column + 50 / 2;
     world_ypos = 50 * city_location[area].row + 50 / 2;
+    statever_bump(STATE_VERSION_WORLDMAP);
     our_town = area;
     return 0;
 }
@@ -4299,4 +4534,183 @@ static void BlackOut()
     memset(world_buf, colorTable[0], WM_WINDOW_WIDTH * WM_WINDOW_HEIGHT);
 }
 
+// CE: Starts speculative preloading of maps of given town, cancelling
+// preloading of previous destination.
+static void wmPreloadStart(int town)
+{
+    int size;
+    if (!config_get_value(&game_config, GAME_CONFIG_SYSTEM_KEY, GAME_CONFIG_WORLDMAP_PRELOAD_SIZE_KEY, &size) || size <= 0) {
+        return;
+    }
+
+    if (!worldmapIsValidArea(town)) {
+        wmPreloadCancel();
+        return;
+    }
+
+    if (town == wmPreloadTown || town == wmPreloadPendingTown) {
+        return;
+    }
+
+    if (wmPreloadMutex == NULL) {
+        wmPreloadMutex = SDL_CreateMutex();
+        if (wmPreloadMutex == NULL) {
+            return;
+        }
+    }
+
+    wmPreloadCancel();
+
+    wmPreloadPendingTown = town;
+    wmPreloadBudget = (size_t)size * 1024;
+
+    wmPreloadProcess();
+}
+
+// CE: Schedules map files of given town for scanning. All slots should be
+// idle.
+static void wmPreloadBegin(int town)
+{
+    wmPreloadTown = town;
+    wmPreloadPendingTown = -1;
+
+    for (int entrance = 0; entrance < WM_PRELOAD_MAP_CAPACITY; entrance++) {
+        if (!worldmapIsValidEntrance(town, entrance)) {
+            continue;
+        }
+
+        TownHotSpotEntry* entry = &(TownHotSpots[town][entrance]);
+
+        // Entrances often share maps.
+        bool duplicate = false;
+        for (int other = 0; other < entrance; other++) {
+            if (worldmapIsValidEntrance(town, other) && compat_stricmp(TownHotSpots[town][other].name, entry->name) == 0) {
+                duplicate = true;
+                break;
+            }
+        }
+
+        if (duplicate) {
+            continue;
+        }
+
+        char name[16];
+        strcpy(name, entry->name);
+
+        const char* path = map_file_path(name);
+
+        // Map itself is read into db cache for `map_load`, and scanned
+        // separately for art to prefetch.
+        db_prefetch_group(&path, 1, WM_PRELOAD_GROUP, &wmPreloadBudget);
+
+        WorldmapPreloadMap* map = &(wmPreloadMaps[entrance]);
+
+        SDL_LockMutex(wmPreloadMutex);
+        map->state = WM_PRELOAD_READING;
+        map->cancelled = false;
+        SDL_UnlockMutex(wmPreloadMutex);
+
+        if (db_read_async(path, wmPreloadMapRead, map) != 0) {
+            // Callback is not called when request is rejected.
+            SDL_LockMutex(wmPreloadMutex);
+            map->state = WM_PRELOAD_IDLE;
+            SDL_UnlockMutex(wmPreloadMutex);
+        }
+    }
+}
+
+// CE: Drops queued speculative reads. Map files being scanned cannot be
+// stopped, their results are discarded.
+static void wmPreloadCancel()
+{
+    wmPreloadTown = -1;
+    wmPreloadPendingTown = -1;
+
+    if (wmPreloadMutex == NULL) {
+        return;
+    }
+
+    db_prefetch_cancel_group(WM_PRELOAD_GROUP);
+
+    SDL_LockMutex(wmPreloadMutex);
+    for (int index = 0; index < WM_PRELOAD_MAP_CAPACITY; index++) {
+        WorldmapPreloadMap* map = &(wmPreloadMaps[index]);
+        if (map->state == WM_PRELOAD_READING) {
+            map->cancelled = true;
+        } else {
+            map->state = WM_PRELOAD_IDLE;
+        }
+    }
+    SDL_UnlockMutex(wmPreloadMutex);
+}
+
+// CE: Prefetches art and scripts of scanned destination maps within budget,
+// and starts pending destination once previous scans are finished.
+static void wmPreloadProcess()
+{
+    if (wmPreloadMutex == NULL) {
+        return;
+    }
+
+    std::vector<MapScanResult> scans;
+    bool reading = false;
+
+    SDL_LockMutex(wmPreloadMutex);
+    for (int index = 0; index < WM_PRELOAD_MAP_CAPACITY; index++) {
+        WorldmapPreloadMap* map = &(wmPreloadMaps[index]);
+        if (map->state == WM_PRELOAD_READING) {
+            reading = true;
+        } else if (map->state == WM_PRELOAD_READ) {
+            scans.push_back(map->scan);
+            map->state = WM_PRELOAD_IDLE;
+        }
+    }
+    SDL_UnlockMutex(wmPreloadMutex);
+
+    for (const MapScanResult& scan : scans) {
+        if (scan.scriptIndex > 0) {
+            char name[16];
+            if (scr_list_str(scan.scriptIndex - 1, name, sizeof(name)) == 0) {
+                char path[COMPAT_MAX_PATH];
+                snprintf(path, sizeof(path), "scripts\\%s", name);
+
+                const char* paths[1] = { path };
+                db_prefetch_group(paths, 1, WM_PRELOAD_GROUP, &wmPreloadBudget);
+            }
+        }
+
+        for (int index = 0; index < 4096 && wmPreloadBudget != 0; index++) {
+            if ((scan.tiles[index / 8] & (1 << (index % 8))) != 0) {
+                const char* name = art_get_name(art_id(OBJ_TYPE_TILE, index, 0, 0, 0));
+                if (name != NULL) {
+                    db_prefetch_group(&name, 1, WM_PRELOAD_GROUP, &wmPreloadBudget);
+                }
+            }
+        }
+    }
+
+    if (wmPreloadPendingTown != -1 && !reading) {
+        wmPreloadBegin(wmPreloadPendingTown);
+    }
+}
+
+// CE: Scans destination map file on db prefetch thread.
+static void wmPreloadMapRead(void* userData, unsigned char* data, size_t size)
+{
+    WorldmapPreloadMap* map = (WorldmapPreloadMap*)userData;
+
+    MapScanResult scan;
+    int rc = map_scan_file(data, size, &scan);
+
+    SDL_LockMutex(wmPreloadMutex);
+    if (!map->cancelled && rc == 0) {
+        map->scan = scan;
+        map->state = WM_PRELOAD_READ;
+    } else {
+        map->state = WM_PRELOAD_IDLE;
+    }
+    map->cancelled = false;
+    SDL_UnlockMutex(wmPreloadMutex);
+}
+
 } // namespace fallout
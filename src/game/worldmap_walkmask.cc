@@ -1,7 +1,41 @@
 #include "worldmap_walkmask.h"
 
+#include <limits.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <queue>
+#include <vector>
+
 namespace fallout {
 
+// CE: Worldmap size searched by `walkmask_find_path`.
+#define WALKMASK_MAP_WIDTH 1400
+#define WALKMASK_MAP_HEIGHT 1500
+
+// CE: Costs of straight and diagonal move in `walkmask_find_path`.
+#define WALKMASK_STRAIGHT_COST 10
+#define WALKMASK_DIAGONAL_COST 14
+
+typedef struct WalkmaskOpenNode {
+    int estimate;
+    int index;
+} WalkmaskOpenNode;
+
+struct WalkmaskOpenNodeCompare {
+    bool operator()(const WalkmaskOpenNode& a, const WalkmaskOpenNode& b) const
+    {
+        return a.estimate > b.estimate;
+    }
+};
+
+static bool walkmask_span_is_clear(int y, int fromX, int toX);
+static int walkmask_estimate(int fromX, int fromY, int toX, int toY);
+
+static const int walkmask_dx[8] = { 1, 1, 0, -1, -1, -1, 0, 1 };
+static const int walkmask_dy[8] = { 0, 1, 1, 1, 0, -1, -1, -1 };
+
 // NOTE: Yes, this is as crazy as it looks - walk mask data is stored in the
 // code. The walk mask itself is smaller than the worldmap size (1500x1064
 // pixels).
@@ -1510,4 +1544,257 @@ unsigned char WALKMASK_MASK_DATA[1500][133] = {
     { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x80, 0x00 },
 };
 
+// CE: Checks bits `fromX`..`toX` of single walk mask row. Whole bytes are
+// tested eight at a time.
+static bool walkmask_span_is_clear(int y, int fromX, int toX)
+{
+    if (y <= 0 || y >= WALKMASK_HEIGHT) {
+        return true;
+    }
+
+    if (fromX > toX) {
+        int tmp = fromX;
+        fromX = toX;
+        toX = tmp;
+    }
+
+    if (fromX < 0) {
+        fromX = 0;
+    }
+
+    if (toX >= WALKMASK_WIDTH) {
+        toX = WALKMASK_WIDTH - 1;
+    }
+
+    if (fromX > toX) {
+        return true;
+    }
+
+    const unsigned char* row = WALKMASK_MASK_DATA[y];
+    int firstByte = fromX / 8;
+    int lastByte = toX / 8;
+    unsigned char firstMask = (unsigned char)(0xFF >> (fromX % 8));
+    unsigned char lastMask = (unsigned char)(0xFF << (7 - toX % 8));
+
+    if (firstByte == lastByte) {
+        return (row[firstByte] & firstMask & lastMask) == 0;
+    }
+
+    if ((row[firstByte] & firstMask) != 0) {
+        return false;
+    }
+
+    int index = firstByte + 1;
+    while (index + 8 <= lastByte) {
+        uint64_t word;
+        memcpy(&word, row + index, sizeof(word));
+        if (word != 0) {
+            return false;
+        }
+        index += 8;
+    }
+
+    while (index < lastByte) {
+        if (row[index] != 0) {
+            return false;
+        }
+        index++;
+    }
+
+    return (row[lastByte] & lastMask) == 0;
+}
+
+// CE: Returns true if worldmap travel from one position to the other goes
+// through walkable terrain only. Positions are visited exactly like
+// `world_move_step` does, start position is not checked. When line is more
+// horizontal than vertical, positions form runs along rows which are tested
+// with `walkmask_span_is_clear`.
+bool walkmask_line_is_clear(int fromX, int fromY, int toX, int toY)
+{
+    int deltaX = abs(toX - fromX);
+    int deltaY = abs(toY - fromY);
+    int incX = toX < fromX ? -1 : 1;
+    int incY = toY < fromY ? -1 : 1;
+    int error = 0;
+    int x = fromX;
+    int y = fromY;
+
+    if (deltaX <= deltaY) {
+        for (int step = 0; step < deltaY; step++) {
+            error += deltaX;
+            if (error > 0) {
+                error -= deltaY;
+                x += incX;
+            }
+
+            y += incY;
+
+            if (walkmask_is_blocked(x, y)) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    int runY = y;
+    int runX = x + incX;
+    for (int step = 0; step < deltaX; step++) {
+        error += deltaY;
+        if (error > deltaX) {
+            error -= deltaX;
+            y += incY;
+        }
+
+        x += incX;
+
+        if (y != runY) {
+            if (!walkmask_span_is_clear(runY, runX, x - incX)) {
+                return false;
+            }
+
+            runY = y;
+            runX = x;
+        }
+    }
+
+    return walkmask_span_is_clear(runY, runX, x);
+}
+
+static int walkmask_estimate(int fromX, int fromY, int toX, int toY)
+{
+    int deltaX = abs(toX - fromX);
+    int deltaY = abs(toY - fromY);
+
+    if (deltaX < deltaY) {
+        return WALKMASK_DIAGONAL_COST * deltaX + WALKMASK_STRAIGHT_COST * (deltaY - deltaX);
+    } else {
+        return WALKMASK_DIAGONAL_COST * deltaY + WALKMASK_STRAIGHT_COST * (deltaX - deltaY);
+    }
+}
+
+// CE: Finds shortest walkable route between worldmap positions with A* over
+// walk mask (8-connected). Route is then reduced to waypoints joined by
+// straight segments passing `walkmask_line_is_clear`, so travelling them one
+// by one with `world_move_step` never hits blocked terrain. Start position
+// is not included, the last waypoint is destination.
+//
+// Returns number of waypoints, or -1 when destination cannot be reached or
+// route does not fit into `capacity`.
+int walkmask_find_path(int fromX, int fromY, int toX, int toY, WalkmaskPoint* waypoints, int capacity)
+{
+    if (fromX < 0 || fromX >= WALKMASK_MAP_WIDTH || fromY < 0 || fromY >= WALKMASK_MAP_HEIGHT) {
+        return -1;
+    }
+
+    if (toX < 0 || toX >= WALKMASK_MAP_WIDTH || toY < 0 || toY >= WALKMASK_MAP_HEIGHT) {
+        return -1;
+    }
+
+    if (capacity < 1 || walkmask_is_blocked(toX, toY)) {
+        return -1;
+    }
+
+    if (walkmask_line_is_clear(fromX, fromY, toX, toY)) {
+        waypoints[0].x = toX;
+        waypoints[0].y = toY;
+        return 1;
+    }
+
+    int start = WALKMASK_MAP_WIDTH * fromY + fromX;
+    int goal = WALKMASK_MAP_WIDTH * toY + toX;
+
+    // Direction each position was entered from, 0xFF - not reached yet.
+    std::vector<unsigned char> from(WALKMASK_MAP_WIDTH * WALKMASK_MAP_HEIGHT, 0xFF);
+    std::vector<int> costs(WALKMASK_MAP_WIDTH * WALKMASK_MAP_HEIGHT, INT_MAX);
+    std::priority_queue<WalkmaskOpenNode, std::vector<WalkmaskOpenNode>, WalkmaskOpenNodeCompare> open;
+
+    costs[start] = 0;
+    from[start] = 8;
+    open.push({ walkmask_estimate(fromX, fromY, toX, toY), start });
+
+    bool found = false;
+    while (!open.empty()) {
+        WalkmaskOpenNode node = open.top();
+        open.pop();
+
+        if (node.index == goal) {
+            found = true;
+            break;
+        }
+
+        int x = node.index % WALKMASK_MAP_WIDTH;
+        int y = node.index / WALKMASK_MAP_WIDTH;
+        int cost = costs[node.index];
+
+        // Skip stale entries.
+        if (node.estimate - walkmask_estimate(x, y, toX, toY) > cost) {
+            continue;
+        }
+
+        for (int direction = 0; direction < 8; direction++) {
+            int nextX = x + walkmask_dx[direction];
+            int nextY = y + walkmask_dy[direction];
+            if (nextX < 0 || nextX >= WALKMASK_MAP_WIDTH || nextY < 0 || nextY >= WALKMASK_MAP_HEIGHT) {
+                continue;
+            }
+
+            if (walkmask_is_blocked(nextX, nextY)) {
+                continue;
+            }
+
+            int next = WALKMASK_MAP_WIDTH * nextY + nextX;
+            int nextCost = cost + ((direction & 1) != 0 ? WALKMASK_DIAGONAL_COST : WALKMASK_STRAIGHT_COST);
+            if (nextCost < costs[next]) {
+                costs[next] = nextCost;
+                from[next] = (unsigned char)direction;
+                open.push({ nextCost + walkmask_estimate(nextX, nextY, toX, toY), next });
+            }
+        }
+    }
+
+    if (!found) {
+        return -1;
+    }
+
+    // Route from start to goal (start excluded).
+    std::vector<WalkmaskPoint> route;
+    int index = goal;
+    while (index != start) {
+        WalkmaskPoint point;
+        point.x = index % WALKMASK_MAP_WIDTH;
+        point.y = index / WALKMASK_MAP_WIDTH;
+        route.push_back(point);
+
+        int direction = from[index];
+        index = WALKMASK_MAP_WIDTH * (point.y - walkmask_dy[direction]) + point.x - walkmask_dx[direction];
+    }
+
+    // Every single move of the route is a valid straight segment, so each
+    // waypoint advances at least one position.
+    int count = 0;
+    int currentX = fromX;
+    int currentY = fromY;
+    int position = (int)route.size() - 1;
+    while (position >= 0) {
+        int next = position;
+        while (next > 0 && walkmask_line_is_clear(currentX, currentY, route[next - 1].x, route[next - 1].y)) {
+            next--;
+        }
+
+        if (count == capacity) {
+            return -1;
+        }
+
+        waypoints[count] = route[next];
+        currentX = route[next].x;
+        currentY = route[next].y;
+        count++;
+
+        position = next - 1;
+    }
+
+    return count;
+}
+
 } // namespace fallout
@@ -3,7 +3,34 @@
 
 namespace fallout {
 
-extern unsigned char WALKMASK_MASK_DATA[1500][133];
+// Walk mask covers left part of the worldmap only, everything to the right
+// is walkable.
+#define WALKMASK_WIDTH 1064
+#define WALKMASK_HEIGHT 1500
+
+// CE: Maximum number of waypoints returned by `walkmask_find_path`.
+#define WALKMASK_MAX_WAYPOINTS 256
+
+typedef struct WalkmaskPoint {
+    int x;
+    int y;
+} WalkmaskPoint;
+
+extern unsigned char WALKMASK_MASK_DATA[WALKMASK_HEIGHT][133];
+
+// CE: Returns true if worldmap position cannot be walked through. Top row is
+// always walkable, as in original travel loop.
+static inline bool walkmask_is_blocked(int x, int y)
+{
+    if (x < 0 || x >= WALKMASK_WIDTH || y <= 0 || y >= WALKMASK_HEIGHT) {
+        return false;
+    }
+
+    return ((128 >> (x % 8)) & WALKMASK_MASK_DATA[y][x / 8]) != 0;
+}
+
+bool walkmask_line_is_clear(int fromX, int fromY, int toX, int toY);
+int walkmask_find_path(int fromX, int fromY, int toX, int toY, WalkmaskPoint* waypoints, int capacity);
 
 } // namespace fallout
 
@@ -10,7 +10,29 @@
 
 namespace fallout {
 
+// CE: Maximum number of decoded images kept in cache.
+#define DATAFILE_CACHE_CAPACITY 32
+
+// CE: Maximum total size (in bytes) of decoded images kept in cache.
+#define DATAFILE_CACHE_MAX_SIZE (4 * 1024 * 1024)
+
+// CE: Decoded PCX image. Pixels are stored unconverted (in file palette), so
+// entries stay valid when `colorTable` changes, callers always receive their
+// own copy.
+typedef struct DatafileCacheEntry {
+    char path[COMPAT_MAX_PATH];
+    unsigned char* data;
+    int width;
+    int height;
+    bool paletteLoaded;
+    unsigned char palette[768];
+    unsigned int lastUsed;
+} DatafileCacheEntry;
+
 static char* defaultMangleName(char* path);
+static unsigned char* datafileLoadPCX(char* path, int* widthPtr, int* heightPtr);
+static unsigned char* datafileCopyImage(DatafileCacheEntry* entry, int* widthPtr, int* heightPtr);
+static void datafileCacheEvict(DatafileCacheEntry* entry);
 
 // 0x504EAC
 static DatafileLoader* loadFunc = NULL;
@@ -21,6 +43,12 @@ static DatafileNameMangler* mangleName = defaultMangleName;
 // 0x56BF70
 static unsigned char pal[768];
 
+static DatafileCacheEntry datafileCache[DATAFILE_CACHE_CAPACITY];
+
+static unsigned int datafileCacheCounter = 0;
+
+static int datafileCacheSize = 0;
+
 // 0x429450
 static char* defaultMangleName(char* path)
 {
@@ -88,7 +116,7 @@ unsigned char* loadRawDataFile(char* path, int* widthPtr, int* heightPtr)
     char* dot = strrchr(mangledPath, '.');
     if (dot != NULL) {
         if (compat_stricmp(dot + 1, "pcx") == 0) {
-            return loadPCX(mangledPath, widthPtr, heightPtr, pal);
+            return datafileLoadPCX(mangledPath, widthPtr, heightPtr);
         }
     }
 
@@ -186,4 +214,131 @@ unsigned char* datafileLoadBlock(char* path, int* sizePtr)
     return data;
 }
 
+// CE: Loads PCX image through the decoded image cache. Mirrors `loadPCX`,
+// including updating `pal` only when file has a palette.
+static unsigned char* datafileLoadPCX(char* path, int* widthPtr, int* heightPtr)
+{
+    datafileCacheCounter++;
+
+    for (int index = 0; index < DATAFILE_CACHE_CAPACITY; index++) {
+        DatafileCacheEntry* entry = &(datafileCache[index]);
+        if (entry->data != NULL && compat_stricmp(entry->path, path) == 0) {
+            entry->lastUsed = datafileCacheCounter;
+
+            if (entry->paletteLoaded) {
+                memcpy(pal, entry->palette, sizeof(pal));
+            }
+
+            return datafileCopyImage(entry, widthPtr, heightPtr);
+        }
+    }
+
+    DB_FILE* stream = db_fopen(path, "rb");
+    if (stream == NULL) {
+        return NULL;
+    }
+
+    int fileSize = db_filelength(stream);
+    unsigned char* fileData = (unsigned char*)mymalloc(fileSize > 0 ? fileSize : 1, __FILE__, __LINE__);
+    if (fileData == NULL) {
+        db_fclose(stream);
+        return NULL;
+    }
+
+    fileSize = (int)db_fread(fileData, 1, fileSize, stream);
+    db_fclose(stream);
+
+    bool paletteLoaded;
+    unsigned char* data = loadPCXFromBuffer(fileData, fileSize, widthPtr, heightPtr, pal, &paletteLoaded);
+    myfree(fileData, __FILE__, __LINE__);
+
+    if (data == NULL) {
+        return NULL;
+    }
+
+    int width = *widthPtr;
+    int height = *heightPtr;
+    if (width <= 0 || height <= 0 || width * height > DATAFILE_CACHE_MAX_SIZE || strlen(path) >= COMPAT_MAX_PATH) {
+        return data;
+    }
+
+    DatafileCacheEntry* candidate = &(datafileCache[0]);
+    for (int index = 0; index < DATAFILE_CACHE_CAPACITY; index++) {
+        DatafileCacheEntry* entry = &(datafileCache[index]);
+        if (entry->data == NULL) {
+            candidate = entry;
+            break;
+        }
+
+        if (entry->lastUsed < candidate->lastUsed) {
+            candidate = entry;
+        }
+    }
+
+    datafileCacheEvict(candidate);
+
+    // Make room for new image by evicting least recently used ones.
+    while (datafileCacheSize + width * height > DATAFILE_CACHE_MAX_SIZE) {
+        DatafileCacheEntry* oldest = NULL;
+        for (int index = 0; index < DATAFILE_CACHE_CAPACITY; index++) {
+            DatafileCacheEntry* entry = &(datafileCache[index]);
+            if (entry->data != NULL && (oldest == NULL || entry->lastUsed < oldest->lastUsed)) {
+                oldest = entry;
+            }
+        }
+
+        if (oldest == NULL) {
+            break;
+        }
+
+        datafileCacheEvict(oldest);
+    }
+
+    strcpy(candidate->path, path);
+    candidate->data = data;
+    candidate->width = width;
+    candidate->height = height;
+    candidate->paletteLoaded = paletteLoaded;
+    memcpy(candidate->palette, pal, sizeof(candidate->palette));
+    candidate->lastUsed = datafileCacheCounter;
+    datafileCacheSize += width * height;
+
+    return datafileCopyImage(candidate, widthPtr, heightPtr);
+}
+
+static unsigned char* datafileCopyImage(DatafileCacheEntry* entry, int* widthPtr, int* heightPtr)
+{
+    int size = entry->width * entry->height;
+    unsigned char* data = (unsigned char*)mymalloc(size, __FILE__, __LINE__);
+    if (data == NULL) {
+        return NULL;
+    }
+
+    memcpy(data, entry->data, size);
+
+    *widthPtr = entry->width;
+    *heightPtr = entry->height;
+
+    return data;
+}
+
+static void datafileCacheEvict(DatafileCacheEntry* entry)
+{
+    if (entry->data != NULL) {
+        datafileCacheSize -= entry->width * entry->height;
+        myfree(entry->data, __FILE__, __LINE__);
+        entry->data = NULL;
+    }
+}
+
+// CE: Releases every decoded image kept in cache.
+void datafileFlushCache()
+{
+    for (int index = 0; index < DATAFILE_CACHE_CAPACITY; index++) {
+        datafileCacheEvict(&(datafileCache[index]));
+    }
+
+    datafileCacheSize = 0;
+}
+
 } // namespace fallout
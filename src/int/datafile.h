@@ -16,6 +16,7 @@ unsigned char* load256Palette(char* path);
 void trimBuffer(unsigned char* data, int* widthPtr, int* heightPtr);
 unsigned char* datafileGetPalette();
 unsigned char* datafileLoadBlock(char* path, int* sizePtr);
+void datafileFlushCache();
 
 } // namespace fallout
 
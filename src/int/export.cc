@@ -3,14 +3,27 @@
 #include <ctype.h>
 #include <string.h>
 
+#include <string>
+#include <unordered_map>
+#include <vector>
+
 #include "int/intlib.h"
 #include "int/memdbg.h"
 #include "platform_compat.h"
 
 namespace fallout {
 
+// CE: Number of significant characters in exported names (see `name`
+// fields below).
+#define EXPORT_NAME_LENGTH 31
+
+// CE: Initial capacity of export tables, must be power of two.
+#define EXPORT_TABLE_INITIAL_CAPACITY 1024
+
 typedef struct ExternalVariable {
     char name[32];
+    // CE: Hash of `name`, compared before names.
+    unsigned int hash;
     char* programName;
     ProgramValue value;
     char* stringValue;
@@ -18,154 +31,249 @@ typedef struct ExternalVariable {
 
 typedef struct ExternalProcedure {
     char name[32];
+    // CE: Hash of `name`, compared before names.
+    unsigned int hash;
     Program* program;
     int argumentCount;
     int address;
 } ExternalProcedure;
 
 static unsigned int hashName(const char* identifier);
+static bool exportNameEquals(const char* name, const char* identifier);
 static ExternalProcedure* findProc(const char* identifier);
 static ExternalProcedure* findEmptyProc(const char* identifier);
+static void removeProc(ExternalProcedure* externalProcedure);
+static bool growProcTable();
 static ExternalVariable* findVar(const char* identifier);
 static ExternalVariable* findEmptyVar(const char* identifier);
+static bool growVarTable();
 static void exportRemoveProgramReferences(Program* program);
 
+// CE: Open addressing tables with linear probing. Both grow when load factor
+// exceeds 3/4, so probe chains stay short regardless of number of exports.
+//
 // 0x56EED0
-static ExternalProcedure procHashTable[1013];
+static ExternalProcedure* procHashTable = NULL;
+static unsigned int procHashTableCapacity = 0;
+static unsigned int procHashTableLength = 0;
 
 // 0x579CEC
-static ExternalVariable varHashTable[1013];
+static ExternalVariable* varHashTable = NULL;
+static unsigned int varHashTableCapacity = 0;
+static unsigned int varHashTableLength = 0;
+
+// CE: Names of procedures exported by every program, so removing program
+// references does not scan the whole table.
+static std::unordered_map<Program*, std::vector<std::string>> programExports;
 
 // 0x439A10
 static unsigned int hashName(const char* identifier)
 {
     unsigned int v1 = 0;
     const char* pch = identifier;
-    while (*pch != '\0') {
+    // CE: Only significant characters are hashed, modulo is applied by the
+    // caller.
+    while (*pch != '\0' && pch - identifier < EXPORT_NAME_LENGTH) {
         int ch = *pch & 0xFF;
         v1 += (tolower(ch) & 0xFF) + (v1 * 8) + (v1 >> 29);
         pch++;
     }
 
-    v1 = v1 % 1013;
     return v1;
 }
 
+// CE: Compares stored (truncated) name with identifier. Original code compared
+// with full identifier, so names longer than 31 characters were exported
+// again on every call and could never be found.
+static bool exportNameEquals(const char* name, const char* identifier)
+{
+    return compat_strnicmp(name, identifier, EXPORT_NAME_LENGTH) == 0;
+}
+
 // 0x439A58
 static ExternalProcedure* findProc(const char* identifier)
 {
-    // NOTE: Uninline.
-    unsigned int v1 = hashName(identifier);
-    unsigned int v2 = v1;
-
-    ExternalProcedure* externalProcedure = &(procHashTable[v1]);
-    if (externalProcedure->program != NULL) {
-        if (compat_stricmp(externalProcedure->name, identifier) == 0) {
-            return externalProcedure;
-        }
+    if (procHashTableLength == 0) {
+        return NULL;
     }
 
-    do {
-        v1 += 7;
-        if (v1 >= 1013) {
-            v1 -= 1013;
-        }
+    unsigned int hash = hashName(identifier);
+    unsigned int mask = procHashTableCapacity - 1;
 
-        externalProcedure = &(procHashTable[v1]);
-        if (externalProcedure->program != NULL) {
-            if (compat_stricmp(externalProcedure->name, identifier) == 0) {
-                return externalProcedure;
-            }
+    for (unsigned int index = hash & mask;; index = (index + 1) & mask) {
+        ExternalProcedure* externalProcedure = &(procHashTable[index]);
+        if (externalProcedure->name[0] == '\0') {
+            return NULL;
         }
-    } while (v1 != v2);
 
-    return NULL;
+        if (externalProcedure->hash == hash && exportNameEquals(externalProcedure->name, identifier)) {
+            return externalProcedure;
+        }
+    }
 }
 
 // 0x439B18
 static ExternalProcedure* findEmptyProc(const char* identifier)
 {
-    // NOTE: Uninline.
-    unsigned int v1 = hashName(identifier);
-    unsigned int a2 = v1;
-
-    ExternalProcedure* externalProcedure = &(procHashTable[v1]);
-    if (externalProcedure->name[0] == '\0') {
-        return externalProcedure;
+    // Empty name marks free slot.
+    if (identifier[0] == '\0') {
+        return NULL;
     }
 
-    do {
-        v1 += 7;
-        if (v1 >= 1013) {
-            v1 -= 1013;
+    if ((procHashTableLength + 1) * 4 > procHashTableCapacity * 3) {
+        if (!growProcTable()) {
+            return NULL;
         }
+    }
+
+    unsigned int hash = hashName(identifier);
+    unsigned int mask = procHashTableCapacity - 1;
 
-        externalProcedure = &(procHashTable[v1]);
+    for (unsigned int index = hash & mask;; index = (index + 1) & mask) {
+        ExternalProcedure* externalProcedure = &(procHashTable[index]);
         if (externalProcedure->name[0] == '\0') {
+            externalProcedure->hash = hash;
+            procHashTableLength++;
             return externalProcedure;
         }
-    } while (v1 != a2);
+    }
+}
+
+// CE: Removes procedure without leaving a hole in probe chains, entries
+// following it are shifted back.
+static void removeProc(ExternalProcedure* externalProcedure)
+{
+    unsigned int mask = procHashTableCapacity - 1;
+    unsigned int hole = (unsigned int)(externalProcedure - procHashTable);
+
+    for (unsigned int index = (hole + 1) & mask;; index = (index + 1) & mask) {
+        ExternalProcedure* other = &(procHashTable[index]);
+        if (other->name[0] == '\0') {
+            break;
+        }
+
+        // Entry can fill the hole only when its home slot is not between hole
+        // and entry itself (cyclically).
+        unsigned int home = other->hash & mask;
+        if (((index - home) & mask) >= ((index - hole) & mask)) {
+            procHashTable[hole] = *other;
+            hole = index;
+        }
+    }
 
-    return NULL;
+    memset(&(procHashTable[hole]), 0, sizeof(*procHashTable));
+    procHashTableLength--;
+}
+
+// CE: Doubles procedure table and reinserts live entries.
+static bool growProcTable()
+{
+    unsigned int capacity = procHashTableCapacity != 0 ? procHashTableCapacity * 2 : EXPORT_TABLE_INITIAL_CAPACITY;
+    ExternalProcedure* table = (ExternalProcedure*)mycalloc(capacity, sizeof(*table), __FILE__, __LINE__);
+    if (table == NULL) {
+        return false;
+    }
+
+    unsigned int mask = capacity - 1;
+    for (unsigned int index = 0; index < procHashTableCapacity; index++) {
+        ExternalProcedure* externalProcedure = &(procHashTable[index]);
+        if (externalProcedure->name[0] != '\0') {
+            unsigned int slot = externalProcedure->hash & mask;
+            while (table[slot].name[0] != '\0') {
+                slot = (slot + 1) & mask;
+            }
+            table[slot] = *externalProcedure;
+        }
+    }
+
+    if (procHashTable != NULL) {
+        myfree(procHashTable, __FILE__, __LINE__);
+    }
+
+    procHashTable = table;
+    procHashTableCapacity = capacity;
+
+    return true;
 }
 
 // 0x439BAC
 static ExternalVariable* findVar(const char* identifier)
 {
-    // NOTE: Uninline.
-    unsigned int v1 = hashName(identifier);
-    unsigned int v2 = v1;
-
-    ExternalVariable* exportedVariable = &(varHashTable[v1]);
-    if (compat_stricmp(exportedVariable->name, identifier) == 0) {
-        return exportedVariable;
+    if (varHashTableLength == 0) {
+        return NULL;
     }
 
-    do {
-        exportedVariable = &(varHashTable[v1]);
-        if (exportedVariable->name[0] == '\0') {
-            break;
-        }
+    unsigned int hash = hashName(identifier);
+    unsigned int mask = varHashTableCapacity - 1;
 
-        v1 += 7;
-        if (v1 >= 1013) {
-            v1 -= 1013;
+    for (unsigned int index = hash & mask;; index = (index + 1) & mask) {
+        ExternalVariable* exportedVariable = &(varHashTable[index]);
+        if (exportedVariable->name[0] == '\0') {
+            return NULL;
         }
 
-        exportedVariable = &(varHashTable[v1]);
-        if (compat_stricmp(exportedVariable->name, identifier) == 0) {
+        if (exportedVariable->hash == hash && exportNameEquals(exportedVariable->name, identifier)) {
             return exportedVariable;
         }
-    } while (v1 != v2);
-
-    return NULL;
+    }
 }
 
 // 0x439C8C
 static ExternalVariable* findEmptyVar(const char* identifier)
 {
-    // NOTE: Uninline.
-    unsigned int v1 = hashName(identifier);
-    unsigned int v2 = v1;
-
-    ExternalVariable* exportedVariable = &(varHashTable[v1]);
-    if (exportedVariable->name[0] == '\0') {
-        return exportedVariable;
+    // Empty name marks free slot.
+    if (identifier[0] == '\0') {
+        return NULL;
     }
 
-    do {
-        v1 += 7;
-        if (v1 >= 1013) {
-            v1 -= 1013;
+    if ((varHashTableLength + 1) * 4 > varHashTableCapacity * 3) {
+        if (!growVarTable()) {
+            return NULL;
         }
+    }
+
+    unsigned int hash = hashName(identifier);
+    unsigned int mask = varHashTableCapacity - 1;
 
-        exportedVariable = &(varHashTable[v1]);
+    for (unsigned int index = hash & mask;; index = (index + 1) & mask) {
+        ExternalVariable* exportedVariable = &(varHashTable[index]);
         if (exportedVariable->name[0] == '\0') {
+            exportedVariable->hash = hash;
+            varHashTableLength++;
             return exportedVariable;
         }
-    } while (v1 != v2);
+    }
+}
+
+// CE: Doubles variable table and reinserts live entries.
+static bool growVarTable()
+{
+    unsigned int capacity = varHashTableCapacity != 0 ? varHashTableCapacity * 2 : EXPORT_TABLE_INITIAL_CAPACITY;
+    ExternalVariable* table = (ExternalVariable*)mycalloc(capacity, sizeof(*table), __FILE__, __LINE__);
+    if (table == NULL) {
+        return false;
+    }
+
+    unsigned int mask = capacity - 1;
+    for (unsigned int index = 0; index < varHashTableCapacity; index++) {
+        ExternalVariable* exportedVariable = &(varHashTable[index]);
+        if (exportedVariable->name[0] != '\0') {
+            unsigned int slot = exportedVariable->hash & mask;
+            while (table[slot].name[0] != '\0') {
+                slot = (slot + 1) & mask;
+            }
+            table[slot] = *exportedVariable;
+        }
+    }
+
+    if (varHashTable != NULL) {
+        myfree(varHashTable, __FILE__, __LINE__);
+    }
 
-    return NULL;
+    varHashTable = table;
+    varHashTableCapacity = capacity;
+
+    return true;
 }
 
 // 0x439D7C
@@ -233,7 +341,7 @@ int exportExportVariable(Program* program, const char* identifier)
             return 1;
         }
 
-        strncpy(exportedVariable->name, identifier, 31);
+        strncpy(exportedVariable->name, identifier, EXPORT_NAME_LENGTH);
 
         exportedVariable->programName = (char*)mymalloc(strlen(programName) + 1, __FILE__, __LINE__); // // "..\\int\\EXPORT.C", 243
         strcpy(exportedVariable->programName, programName);
@@ -248,13 +356,20 @@ int exportExportVariable(Program* program, const char* identifier)
 // 0x439FFC
 static void exportRemoveProgramReferences(Program* program)
 {
-    for (int index = 0; index < 1013; index++) {
-        ExternalProcedure* externalProcedure = &(procHashTable[index]);
-        if (externalProcedure->program == program) {
-            externalProcedure->name[0] = '\0';
-            externalProcedure->program = NULL;
+    // CE: Only visit procedures exported by this program.
+    auto it = programExports.find(program);
+    if (it == programExports.end()) {
+        return;
+    }
+
+    for (const std::string& name : it->second) {
+        ExternalProcedure* externalProcedure = findProc(name.c_str());
+        if (externalProcedure != NULL && externalProcedure->program == program) {
+            removeProc(externalProcedure);
         }
     }
+
+    programExports.erase(it);
 }
 
 // 0x43A02C
@@ -266,7 +381,7 @@ void initExport()
 // 0x43A038
 void exportClose()
 {
-    for (int index = 0; index < 1013; index++) {
+    for (unsigned int index = 0; index < varHashTableCapacity; index++) {
         ExternalVariable* exportedVariable = &(varHashTable[index]);
 
         if (exportedVariable->name[0] != '\0') {
@@ -277,6 +392,23 @@ void exportClose()
             myfree(exportedVariable->stringValue, __FILE__, __LINE__); // ..\\int\\EXPORT.C, 276
         }
     }
+
+    // CE: Release tables themselves.
+    if (varHashTable != NULL) {
+        myfree(varHashTable, __FILE__, __LINE__);
+        varHashTable = NULL;
+    }
+    varHashTableCapacity = 0;
+    varHashTableLength = 0;
+
+    if (procHashTable != NULL) {
+        myfree(procHashTable, __FILE__, __LINE__);
+        procHashTable = NULL;
+    }
+    procHashTableCapacity = 0;
+    procHashTableLength = 0;
+
+    programExports.clear();
 }
 
 // 0x43A08C
@@ -311,7 +443,9 @@ int exportExportProcedure(Program* program, const char* identifier, int address,
             return 1;
         }
 
-        strncpy(externalProcedure->name, identifier, 31);
+        strncpy(externalProcedure->name, identifier, EXPORT_NAME_LENGTH);
+
+        programExports[program].push_back(externalProcedure->name);
     }
 
     externalProcedure->argumentCount = argumentCount;
@@ -324,7 +458,7 @@ int exportExportProcedure(Program* program, const char* identifier, int address,
 // 0x43A324
 void exportClearAllVariables()
 {
-    for (int index = 0; index < 1013; index++) {
+    for (unsigned int index = 0; index < varHashTableCapacity; index++) {
         ExternalVariable* exportedVariable = &(varHashTable[index]);
         if (exportedVariable->name[0] != '\0') {
             if ((exportedVariable->value.opcode & VALUE_TYPE_MASK) == VALUE_TYPE_STRING) {
@@ -342,6 +476,8 @@ void exportClearAllVariables()
             exportedVariable->value.opcode = 0;
         }
     }
+
+    varHashTableLength = 0;
 }
 
 } // namespace fallout
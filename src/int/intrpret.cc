@@ -1,12 +1,19 @@
 #include "int/intrpret.h"
 
 #include <assert.h>
+#include <ctype.h>
 #include <limits.h>
 #include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
 #include "int/export.h"
 #include "int/intlib.h"
 #include "int/memdbg.h"
@@ -15,15 +22,124 @@
 #include "plib/db/db.h"
 #include "plib/gnw/debug.h"
 #include "plib/gnw/input.h"
+#include "plib/gnw/memory.h"
+#include "plib/gnw/prof.h"
 
 namespace fallout {
 
-// The maximum number of opcodes.
-#define OPCODE_MAX_COUNT 342
-
 // Size of internal stack in bytes (per program).
 #define STACK_SIZE 0x800
 
+// CE: Number of values in data and return stacks. Original code checks for
+// overflow before push, so stack can hold one extra value.
+#define PROGRAM_STACK_CAPACITY (STACK_SIZE + 1)
+
+// CE: Maximum size of cached program images not used by any program.
+#define PROGRAM_IMAGE_CACHE_SIZE (4 * 1024 * 1024)
+
+// CE: Core opcodes are below this index, above are exported functions
+// (registered by intlib and intextra).
+#define OPCODE_EXTERNAL_INDEX ((OPCODE_END_CRITICAL & 0x3FF) + 1)
+
+// CE: Maximum number of spans kept for profile trace.
+#define PROFILE_TRACE_CAPACITY 65536
+
+// CE: `interpretFast` dispatches through table of label addresses where
+// compiler supports it, and through switch elsewhere.
+#if defined(__GNUC__) || defined(__clang__)
+#define INTERPRET_COMPUTED_GOTO 1
+#else
+#define INTERPRET_COMPUTED_GOTO 0
+#endif
+
+// CE: Sequences of plain instructions executed by `interpretFast` as one
+// step. Every sequence starts with `OPCODE_PUSH` (by far the most frequent
+// opcode in profiler histograms) followed by what scripts compile
+// arguments, variable reads, procedure prologues and `if (global == const)`
+// into.
+typedef enum InterpretSuperOp {
+    // Instruction at offset was not looked at yet.
+    INTERPRET_SUPER_OP_UNKNOWN,
+    // No sequence starts at offset.
+    INTERPRET_SUPER_OP_NONE,
+    // push, push
+    INTERPRET_SUPER_OP_PUSH_PUSH,
+    // push, fetch
+    INTERPRET_SUPER_OP_PUSH_FETCH,
+    // push, fetch_global
+    INTERPRET_SUPER_OP_PUSH_FETCH_GLOBAL,
+    // push, push_base
+    INTERPRET_SUPER_OP_PUSH_PUSH_BASE,
+    // push, equal, if
+    INTERPRET_SUPER_OP_PUSH_EQUAL_IF,
+    // push, fetch_global, push, equal, if
+    INTERPRET_SUPER_OP_FETCH_GLOBAL_EQUAL_IF,
+    INTERPRET_SUPER_OP_COUNT,
+} InterpretSuperOp;
+
+// CE: Per-program string interning. Every distinct string content gets an
+// id, so equality of two string values is an id compare once both have
+// been seen.
+typedef struct ProgramStrings {
+    // Content to id.
+    std::unordered_map<std::string, int> ids;
+
+    // Static and dynamic string offsets to id.
+    std::unordered_map<int, int> staticIds;
+    std::unordered_map<int, int> dynamicIds;
+
+    // Content to offset in dynamic strings heap (for `interpretAddString`).
+    std::unordered_map<std::string, int> dynamicOffsets;
+} ProgramStrings;
+
+// CE: Contents of program file shared by every program loaded from it.
+// Images stay cached after their last program is freed (so scripts are not
+// re-read on every map transition) until `PROGRAM_IMAGE_CACHE_SIZE` is
+// exceeded.
+typedef struct ProgramImage {
+    std::string path;
+    unsigned char* data;
+    int size;
+
+    // Decoded opcodes, one entry per 2-byte unit of `data` (see `getOp`).
+    unsigned int* decodedOps;
+    int decodedOpsLength;
+
+    // Superinstructions by decoded opcode (see `InterpretSuperOp`).
+    unsigned char* superOps;
+
+    // Lowercased procedure name to index of its first procedure.
+    std::unordered_map<std::string, int> procedures;
+
+    // Procedure start addresses with their indexes, sorted by address.
+    std::vector<std::pair<int, int>> procedureStarts;
+
+    // Index of first record of this image in `profileRecords` (one per
+    // procedure, then one for code outside of them), -1 - not profiled yet.
+    int profileBase;
+
+    int refCount;
+
+    // Release stamp, oldest unused images are evicted first.
+    unsigned int lastUsed;
+} ProgramImage;
+
+// CE: Profile counters of one procedure.
+typedef struct ProfileRecord {
+    std::string programName;
+    std::string procedureName;
+    unsigned int instructions;
+    unsigned int externalCalls;
+    double milliseconds;
+} ProfileRecord;
+
+// CE: Continuous run of one procedure, for profile trace.
+typedef struct ProfileSpan {
+    int record;
+    double start;
+    double duration;
+} ProfileSpan;
+
 typedef struct ProgramListNode {
     Program* program;
     struct ProgramListNode* next; // next
@@ -37,15 +153,25 @@ static int checkWait(Program* program);
 static const char* findCurrentProc(Program* program);
 static opcode_t fetchWord(unsigned char* data, int pos);
 static int fetchLong(unsigned char* a1, int a2);
-static void storeWord(int value, unsigned char* a2, int a3);
 static void storeLong(int value, unsigned char* stack, int pos);
-static void pushShortStack(unsigned char* a1, int* a2, int value);
-static void pushLongStack(unsigned char* a1, int* a2, int value);
-static int popLongStack(unsigned char* a1, int* a2);
 static opcode_t popShortStack(unsigned char* a1, int* a2);
 static void detachProgram(Program* program);
 static void purgeProgram(Program* program);
 static opcode_t getOp(Program* program);
+static opcode_t decodeOp(Program* program, int pos);
+static int interpretInternString(Program* program, opcode_t opcode, int offset);
+static void interpretIndexProcedures(ProgramImage* image);
+static ProgramImage* programImageAcquire(const char* path);
+static void programImageRelease(ProgramImage* image);
+static void programImageDestroy(ProgramImage* image);
+static void programImageTrim(int budget);
+static int programImageProcedureAt(ProgramImage* image, int address);
+static void interpretProfileStep(Program* program, int instructionPointer, opcode_t opcode);
+static void interpretProfileFlush();
+static double interpretProfileNow();
+static std::string interpretProcedureKey(const char* name);
+static bool interpretIsPlainOp(opcode_t opcode);
+static void interpretFast(Program* program, int a2, int* busy);
 static void checkProgramStrings(Program* program);
 static void op_noop(Program* program);
 static void op_const(Program* program);
@@ -148,12 +274,37 @@ static InterpretOutputFunc* outputFunc = outputStr;
 // 0x519050
 static int cpuBurstSize = 10;
 
+// CE: Use `interpretFast` loop instead of original one.
+static bool fastDispatch = false;
+
 // 0x59E230
 static OpcodeHandler* opTable[OPCODE_MAX_COUNT];
 
+// CE: Number of stack values taken by exported functions registered with
+// `interpretAddFuncs` (see `OpcodeInfo`), zero when unknown.
+static unsigned char opArgs[OPCODE_MAX_COUNT];
+
 // 0x59E788
 static unsigned int suspendTime;
 
+// CE: Loaded program images by path.
+static std::unordered_map<std::string, ProgramImage*> programImages;
+
+// CE: Total size of images with no programs.
+static int programImagesIdleSize = 0;
+
+// CE: Stamp for `ProgramImage::lastUsed`.
+static unsigned int programImagesClock = 0;
+
+// CE: Profiler state (see `interpretProfileStep`).
+static bool profileEnabled = false;
+static std::vector<ProfileRecord> profileRecords;
+static std::vector<ProfileSpan> profileSpans;
+static unsigned int profileOpcodes[OPCODE_MAX_COUNT];
+static int profileCurrentRecord = -1;
+static double profileCurrentStart = 0.0;
+static std::chrono::steady_clock::time_point profileEpoch;
+
 // 0x59E78C
 static Program* currentProgram;
 
@@ -170,10 +321,12 @@ static unsigned int defaultTimerFunc()
 }
 
 // 0x45B408
-void interpretSetTimeFunc(InterpretTimerFunc* timerFunc, int timerTick)
+void interpretSetTimeFunc(InterpretTimerFunc* func, int tick)
 {
-    timerFunc = timerFunc;
-    timerTick = timerTick;
+    // CE: Parameters used to shadow globals making this function no-op.
+    // `NULL` restores default timer which reads `get_time`.
+    timerFunc = func != NULL ? func : defaultTimerFunc;
+    timerTick = tick;
 }
 
 // 0x45B414
@@ -294,13 +447,6 @@ static int fetchLong(unsigned char* data, int pos)
     return value;
 }
 
-// 0x45B6DC
-static void storeWord(int value, unsigned char* stack, int pos)
-{
-    stack[pos++] = (value >> 8) & 0xFF;
-    stack[pos] = value & 0xFF;
-}
-
 // 0x45B6F0
 static void storeLong(int value, unsigned char* stack, int pos)
 {
@@ -310,46 +456,6 @@ static void storeLong(int value, unsigned char* stack, int pos)
     stack[pos] = value & 0xFF;
 }
 
-// 0x45B72C
-static void pushShortStack(unsigned char* data, int* pointer, int value)
-{
-    if (*pointer + 2 >= STACK_SIZE) {
-        interpretError("pushShortStack: Stack overflow.");
-    }
-
-    storeWord(value, data, *pointer);
-
-    *pointer += 2;
-}
-
-// 0x45B774
-static void pushLongStack(unsigned char* data, int* pointer, int value)
-{
-    int v1;
-
-    if (*pointer + 4 >= STACK_SIZE) {
-        // FIXME: Should be pushLongStack.
-        interpretError("pushShortStack: Stack overflow.");
-    }
-
-    v1 = *pointer;
-    storeWord(value >> 16, data, v1);
-    storeWord(value & 0xFFFF, data, v1 + 2);
-    *pointer = v1 + 4;
-}
-
-// 0x45B7CC
-static int popLongStack(unsigned char* data, int* pointer)
-{
-    if (*pointer < 4) {
-        interpretError("\nStack underflow long.");
-    }
-
-    *pointer -= 4;
-
-    return fetchLong(data, *pointer);
-}
-
 // 0x45B814
 static opcode_t popShortStack(unsigned char* data, int* pointer)
 {
@@ -411,16 +517,19 @@ void interpretFreeProgram(Program* program)
         myfree(program->dynamicStrings, __FILE__, __LINE__); // "..\int\INTRPRET.C", 371
     }
 
-    if (program->data != NULL) {
-        myfree(program->data, __FILE__, __LINE__); // "..\int\INTRPRET.C", 372
+    // CE: File contents are shared, only private procedures table is freed.
+    if (program->image != NULL) {
+        myfree(program->procedures, __FILE__, __LINE__);
+        programImageRelease(program->image);
     }
 
     if (program->name != NULL) {
         myfree(program->name, __FILE__, __LINE__); // "..\int\INTRPRET.C", 373
     }
 
-    delete program->stackValues;
-    delete program->returnStackValues;
+    // CE: Both stacks share one allocation.
+    myfree(program->stackValues.values, __FILE__, __LINE__);
+    delete program->strings;
 
     myfree(program, __FILE__, __LINE__); // "..\int\INTRPRET.C", 377
 }
@@ -428,19 +537,14 @@ void interpretFreeProgram(Program* program)
 // 0x45BA44
 Program* allocateProgram(const char* path)
 {
-    DB_FILE* stream = db_fopen(path, "rb");
-    if (stream == NULL) {
-        char err[260];
-        snprintf(err, sizeof(err), "Couldn't open %s for read\n", path);
-        interpretError(err);
+    MemTagScope memTagScope(MEM_TAG_SCRIPT);
+
+    ProgramImage* image = programImageAcquire(path);
+    if (image == NULL) {
         return NULL;
     }
 
-    int fileSize = db_filelength(stream);
-    unsigned char* data = (unsigned char*)mymalloc(fileSize, __FILE__, __LINE__); // ..\int\INTRPRET.C, 398
-
-    db_fread(data, 1, fileSize, stream);
-    db_fclose(stream);
+    unsigned char* data = image->data;
 
     Program* program = (Program*)mymalloc(sizeof(Program), __FILE__, __LINE__); // ..\int\INTRPRET.C, 402
     memset(program, 0, sizeof(Program));
@@ -459,12 +563,407 @@ Program* allocateProgram(const char* path)
     program->identifiers = sizeof(Procedure) * fetchLong(program->procedures, 0) + program->procedures + 4;
     program->staticStrings = program->identifiers + fetchLong(program->identifiers, 0) + 4;
 
-    program->stackValues = new ProgramStack();
-    program->returnStackValues = new ProgramStack();
+    // CE: Procedures table holds per-program timers and flags.
+    size_t proceduresSize = program->identifiers - program->procedures;
+    program->procedures = (unsigned char*)mymalloc(proceduresSize, __FILE__, __LINE__);
+    memcpy(program->procedures, data + 42, proceduresSize);
+
+    program->image = image;
+    program->decodedOps = image->decodedOps;
+    program->decodedOpsLength = image->decodedOpsLength;
+    program->superOps = image->superOps;
+
+    // CE: Stacks never grow, overflow is reported by push functions.
+    program->stackValues.values = (ProgramValue*)mymalloc(sizeof(ProgramValue) * PROGRAM_STACK_CAPACITY * 2, __FILE__, __LINE__);
+    program->stackValues.length = 0;
+    program->returnStackValues.values = program->stackValues.values + PROGRAM_STACK_CAPACITY;
+    program->returnStackValues.length = 0;
+    program->strings = new ProgramStrings();
 
     return program;
 }
 
+// CE: Returns image of program file at `path` with reference taken, loading
+// it when it's not cached.
+static ProgramImage* programImageAcquire(const char* path)
+{
+    auto it = programImages.find(path);
+    if (it != programImages.end()) {
+        ProgramImage* image = it->second;
+        if (image->refCount == 0) {
+            programImagesIdleSize -= image->size;
+        }
+        image->refCount++;
+        return image;
+    }
+
+    DB_FILE* stream = db_fopen(path, "rb");
+    if (stream == NULL) {
+        char err[260];
+        snprintf(err, sizeof(err), "Couldn't open %s for read\n", path);
+        interpretError(err);
+        return NULL;
+    }
+
+    int fileSize = db_filelength(stream);
+    unsigned char* data = (unsigned char*)mymalloc(fileSize, __FILE__, __LINE__); // ..\int\INTRPRET.C, 398
+
+    db_fread(data, 1, fileSize, stream);
+    db_fclose(stream);
+
+    ProgramImage* image = new ProgramImage();
+    image->path = path;
+    image->data = data;
+    image->size = fileSize;
+    image->refCount = 1;
+    image->lastUsed = 0;
+    image->profileBase = -1;
+
+    // Code and tables are interleaved in `data` and instructions can only
+    // be told apart by executing them, so opcodes are decoded the first
+    // time they are fetched rather than in one pass here.
+    image->decodedOps = NULL;
+    image->superOps = NULL;
+    image->decodedOpsLength = fileSize / 2;
+    if (image->decodedOpsLength > 0) {
+        image->decodedOps = (unsigned int*)mymalloc(sizeof(*image->decodedOps) * image->decodedOpsLength, __FILE__, __LINE__);
+        image->superOps = (unsigned char*)mymalloc(sizeof(*image->superOps) * image->decodedOpsLength, __FILE__, __LINE__);
+        if (image->decodedOps != NULL && image->superOps != NULL) {
+            memset(image->decodedOps, 0, sizeof(*image->decodedOps) * image->decodedOpsLength);
+            memset(image->superOps, INTERPRET_SUPER_OP_UNKNOWN, sizeof(*image->superOps) * image->decodedOpsLength);
+        } else {
+            if (image->decodedOps != NULL) {
+                myfree(image->decodedOps, __FILE__, __LINE__);
+                image->decodedOps = NULL;
+            }
+
+            if (image->superOps != NULL) {
+                myfree(image->superOps, __FILE__, __LINE__);
+                image->superOps = NULL;
+            }
+
+            image->decodedOpsLength = 0;
+        }
+    }
+
+    interpretIndexProcedures(image);
+
+    programImages[image->path] = image;
+
+    return image;
+}
+
+// CE: Drops reference to image, keeping it cached for next load.
+static void programImageRelease(ProgramImage* image)
+{
+    image->refCount--;
+    if (image->refCount == 0) {
+        image->lastUsed = ++programImagesClock;
+        programImagesIdleSize += image->size;
+        programImageTrim(PROGRAM_IMAGE_CACHE_SIZE);
+    }
+}
+
+static void programImageDestroy(ProgramImage* image)
+{
+    if (image->decodedOps != NULL) {
+        myfree(image->decodedOps, __FILE__, __LINE__);
+    }
+
+    if (image->superOps != NULL) {
+        myfree(image->superOps, __FILE__, __LINE__);
+    }
+
+    myfree(image->data, __FILE__, __LINE__); // "..\int\INTRPRET.C", 372
+
+    delete image;
+}
+
+// CE: Evicts least recently used images nobody references until their
+// total size is within `budget`.
+static void programImageTrim(int budget)
+{
+    while (programImagesIdleSize > budget) {
+        auto oldest = programImages.end();
+        for (auto it = programImages.begin(); it != programImages.end(); it++) {
+            if (it->second->refCount == 0) {
+                if (oldest == programImages.end() || it->second->lastUsed < oldest->second->lastUsed) {
+                    oldest = it;
+                }
+            }
+        }
+
+        if (oldest == programImages.end()) {
+            break;
+        }
+
+        ProgramImage* image = oldest->second;
+        programImagesIdleSize -= image->size;
+        programImages.erase(oldest);
+        programImageDestroy(image);
+    }
+}
+
+// CE: Returns index of procedure `address` belongs to (the one with the
+// closest start at or before it, same as `findCurrentProc`), or -1.
+static int programImageProcedureAt(ProgramImage* image, int address)
+{
+    auto it = std::upper_bound(image->procedureStarts.begin(),
+        image->procedureStarts.end(),
+        std::make_pair(address, INT_MAX));
+    if (it == image->procedureStarts.begin()) {
+        return -1;
+    }
+
+    return (it - 1)->second;
+}
+
+static double interpretProfileNow()
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - profileEpoch).count();
+}
+
+// CE: Counts instruction at `instructionPointer` and charges time elapsed
+// since procedure last changed to previously running procedure. Clock is
+// only read on procedure changes (and once per `interpret` call). Time of
+// exported function calls goes to calling procedure.
+static void interpretProfileStep(Program* program, int instructionPointer, opcode_t opcode)
+{
+    ProgramImage* image = program->image;
+    if (image->profileBase == -1) {
+        image->profileBase = (int)profileRecords.size();
+
+        unsigned char* ptr = program->procedures + 4;
+        for (size_t index = 0; index < image->procedureStarts.size(); index++) {
+            ProfileRecord record;
+            record.programName = program->name;
+            record.procedureName = interpretGetName(program, fetchLong(ptr, offsetof(Procedure, field_0)));
+            record.instructions = 0;
+            record.externalCalls = 0;
+            record.milliseconds = 0.0;
+            profileRecords.push_back(record);
+
+            ptr += sizeof(Procedure);
+        }
+
+        ProfileRecord record;
+        record.programName = program->name;
+        record.procedureName = "<no proc>";
+        record.instructions = 0;
+        record.externalCalls = 0;
+        record.milliseconds = 0.0;
+        profileRecords.push_back(record);
+    }
+
+    int procedureIndex = -1;
+    int index = instructionPointer >> 1;
+    if ((instructionPointer & 1) == 0 && index < program->decodedOpsLength && (program->decodedOps[index] >> 17) != 0) {
+        procedureIndex = (int)(program->decodedOps[index] >> 17) - 1;
+    } else {
+        procedureIndex = programImageProcedureAt(image, instructionPointer);
+    }
+
+    if (procedureIndex == -1) {
+        procedureIndex = (int)image->procedureStarts.size();
+    }
+
+    int recordIndex = image->profileBase + procedureIndex;
+    if (recordIndex != profileCurrentRecord) {
+        interpretProfileFlush();
+        profileCurrentRecord = recordIndex;
+    }
+
+    ProfileRecord* record = &(profileRecords[recordIndex]);
+    record->instructions++;
+
+    unsigned int opcodeIndex = opcode & 0x3FF;
+    profileOpcodes[opcodeIndex]++;
+    if (opcodeIndex >= OPCODE_EXTERNAL_INDEX) {
+        record->externalCalls++;
+    }
+}
+
+// CE: Charges time of current span to its procedure.
+static void interpretProfileFlush()
+{
+    double now = interpretProfileNow();
+
+    if (profileCurrentRecord != -1) {
+        double duration = now - profileCurrentStart;
+        profileRecords[profileCurrentRecord].milliseconds += duration;
+
+        if (profileSpans.size() < PROFILE_TRACE_CAPACITY) {
+            ProfileSpan span;
+            span.record = profileCurrentRecord;
+            span.start = profileCurrentStart;
+            span.duration = duration;
+            profileSpans.push_back(span);
+        }
+
+        profileCurrentRecord = -1;
+    }
+
+    profileCurrentStart = now;
+}
+
+// CE: Starts (or stops) profiling. While enabled `interpret` always uses
+// original dispatch loop.
+void interpretProfileSetEnabled(bool enabled)
+{
+    if (enabled && !profileEnabled) {
+        profileEpoch = std::chrono::steady_clock::now();
+        profileCurrentRecord = -1;
+        profileCurrentStart = 0.0;
+    } else if (!enabled && profileEnabled) {
+        interpretProfileFlush();
+    }
+
+    profileEnabled = enabled;
+}
+
+bool interpretProfileIsEnabled()
+{
+    return profileEnabled;
+}
+
+void interpretProfileReset()
+{
+    profileRecords.clear();
+    profileSpans.clear();
+    memset(profileOpcodes, 0, sizeof(profileOpcodes));
+    profileCurrentRecord = -1;
+    profileCurrentStart = interpretProfileNow();
+
+    for (auto it = programImages.begin(); it != programImages.end(); it++) {
+        it->second->profileBase = -1;
+    }
+}
+
+// CE: Reports every profiled procedure (same procedure of images loaded
+// more than once is reported once), heaviest first.
+void interpretProfileVisit(InterpretProfileProc* proc, void* userData)
+{
+    std::unordered_map<std::string, ProfileRecord> merged;
+    for (size_t index = 0; index < profileRecords.size(); index++) {
+        ProfileRecord* record = &(profileRecords[index]);
+        if (record->instructions == 0) {
+            continue;
+        }
+
+        std::string key = record->programName + "\n" + record->procedureName;
+        auto it = merged.find(key);
+        if (it == merged.end()) {
+            merged.emplace(key, *record);
+        } else {
+            it->second.instructions += record->instructions;
+            it->second.externalCalls += record->externalCalls;
+            it->second.milliseconds += record->milliseconds;
+        }
+    }
+
+    std::vector<ProfileRecord*> sorted;
+    for (auto it = merged.begin(); it != merged.end(); it++) {
+        sorted.push_back(&(it->second));
+    }
+
+    std::sort(sorted.begin(), sorted.end(), [](ProfileRecord* a, ProfileRecord* b) {
+        if (a->milliseconds != b->milliseconds) {
+            return a->milliseconds > b->milliseconds;
+        }
+        return a->instructions > b->instructions;
+    });
+
+    for (size_t index = 0; index < sorted.size(); index++) {
+        ProfileRecord* record = sorted[index];
+        proc(record->programName.c_str(),
+            record->procedureName.c_str(),
+            record->instructions,
+            record->externalCalls,
+            record->milliseconds,
+            userData);
+    }
+}
+
+static void interpretProfileWriteRow(const char* programName, const char* procedureName, unsigned int instructions, unsigned int externalCalls, double milliseconds, void* userData)
+{
+    fprintf((FILE*)userData, "%12.3f %12u %10u  %s:%s\n", milliseconds, instructions, externalCalls, programName, procedureName);
+}
+
+// CE: Writes procedures sorted by time, then opcode histogram.
+int interpretProfileWriteTable(const char* path)
+{
+    FILE* stream = compat_fopen(path, "wt");
+    if (stream == NULL) {
+        return -1;
+    }
+
+    fprintf(stream, "%12s %12s %10s  %s\n", "ms", "instructions", "externals", "procedure");
+    interpretProfileVisit(interpretProfileWriteRow, stream);
+
+    std::vector<int> opcodes;
+    for (int index = 0; index < OPCODE_MAX_COUNT; index++) {
+        if (profileOpcodes[index] != 0) {
+            opcodes.push_back(index);
+        }
+    }
+
+    std::sort(opcodes.begin(), opcodes.end(), [](int a, int b) {
+        return profileOpcodes[a] > profileOpcodes[b];
+    });
+
+    fprintf(stream, "\n%6s %12s %s\n", "opcode", "count", "kind");
+    for (size_t index = 0; index < opcodes.size(); index++) {
+        int opcodeIndex = opcodes[index];
+        fprintf(stream, "0x%04X %12u %s\n",
+            0x8000 | opcodeIndex,
+            profileOpcodes[opcodeIndex],
+            opcodeIndex >= OPCODE_EXTERNAL_INDEX ? "external" : "core");
+    }
+
+    fclose(stream);
+
+    return 0;
+}
+
+// CE: Writes recorded spans in Chrome trace event format (load it in
+// chrome://tracing or Perfetto).
+int interpretProfileWriteTrace(const char* path)
+{
+    FILE* stream = compat_fopen(path, "wt");
+    if (stream == NULL) {
+        return -1;
+    }
+
+    fprintf(stream, "{\"traceEvents\":[\n");
+    for (size_t index = 0; index < profileSpans.size(); index++) {
+        ProfileSpan* span = &(profileSpans[index]);
+        ProfileRecord* record = &(profileRecords[span->record]);
+
+        // Names come from file paths and script identifiers, backslashes in
+        // paths are the only characters that need escaping.
+        std::string programName;
+        for (char ch : record->programName) {
+            if (ch == '\\') {
+                programName += '/';
+            } else {
+                programName += ch;
+            }
+        }
+
+        fprintf(stream, "%s{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":1}\n",
+            index != 0 ? "," : "",
+            record->procedureName.c_str(),
+            programName.c_str(),
+            span->start * 1000.0,
+            span->duration * 1000.0);
+    }
+    fprintf(stream, "]}\n");
+
+    fclose(stream);
+
+    return 0;
+}
+
 // 0x45BC08
 static opcode_t getOp(Program* program)
 {
@@ -473,8 +972,52 @@ static opcode_t getOp(Program* program)
     instructionPointer = program->instructionPointer;
     program->instructionPointer = instructionPointer + 2;
 
+    // CE: Opcodes at even offsets (practically all of them) are validated
+    // and byte-swapped once, then served from `decodedOps`. Instruction
+    // pointer stays an offset into `data`, so jumps, calls, procedure
+    // addresses and saved programs are not affected.
+    if ((instructionPointer & 1) == 0) {
+        int index = instructionPointer >> 1;
+        if (index < program->decodedOpsLength) {
+            unsigned int entry = program->decodedOps[index];
+            if (entry == 0) {
+                entry = 0x10000 | decodeOp(program, instructionPointer);
+
+                // Upper bits keep owning procedure (plus one, 0 - unknown)
+                // for profiler.
+                int procedureIndex = programImageProcedureAt(program->image, instructionPointer);
+                if (procedureIndex >= 0 && procedureIndex < 0x7FFF) {
+                    entry |= (unsigned int)(procedureIndex + 1) << 17;
+                }
+
+                program->decodedOps[index] = entry;
+            }
+            return (opcode_t)entry;
+        }
+    }
+
+    return decodeOp(program, instructionPointer);
+}
+
+// CE: Fetches opcode at `pos` and checks it refers to known handler.
+static opcode_t decodeOp(Program* program, int pos)
+{
+    char err[260];
+
     // NOTE: Uninline.
-    return fetchWord(program->data, instructionPointer);
+    opcode_t opcode = fetchWord(program->data, pos);
+
+    if (!((opcode >> 8) & 0x80)) {
+        snprintf(err, sizeof(err), "Bad opcode %x %c %d.", opcode, opcode, opcode);
+        interpretError(err);
+    }
+
+    if (opTable[opcode & 0x3FF] == NULL) {
+        snprintf(err, sizeof(err), "Undefined opcode %x.", opcode);
+        interpretError(err);
+    }
+
+    return opcode;
 }
 
 // 0x45BC2C
@@ -519,35 +1062,12 @@ int interpretAddString(Program* program, char* string)
     }
 
     if (program->dynamicStrings != NULL) {
-        // TODO: Needs testing, lots of pointer stuff.
-        unsigned char* heap = program->dynamicStrings + 4;
-        while (*(unsigned short*)heap != 0x8000) {
-            short v2 = *(short*)heap;
-            if (v2 >= 0) {
-                if (v2 == v27) {
-                    if (strcmp(string, (char*)(heap + 4)) == 0) {
-                        return (heap + 4) - (program->dynamicStrings + 4);
-                    }
-                }
-            } else {
-                v2 = -v2;
-                if (v2 > v27) {
-                    if (v2 - v27 <= 4) {
-                        *(short*)heap = v2;
-                    } else {
-                        *(short*)(heap + v27 + 6) = 0;
-                        *(short*)(heap + v27 + 4) = -(v2 - v27 - 4);
-                        *(short*)(heap) = v27;
-                    }
-
-                    *(short*)(heap + 2) = 0;
-                    strcpy((char*)(heap + 4), string);
-
-                    *(heap + v27 + 3) = '\0';
-                    return (heap + 4) - (program->dynamicStrings + 4);
-                }
-            }
-            heap += v2 + 4;
+        // CE: Original code scanned the whole heap for the same string
+        // (and for free blocks to reuse). Nothing releases dynamic strings,
+        // so heap never has free blocks, and duplicates are found by hash.
+        auto it = program->strings->dynamicOffsets.find(string);
+        if (it != program->strings->dynamicOffsets.end()) {
+            return it->second;
         }
     } else {
         program->dynamicStrings = (unsigned char*)mymalloc(8, __FILE__, __LINE__); // "..\int\INTRPRET.C", 459
@@ -575,7 +1095,66 @@ int interpretAddString(Program* program, char* string)
     *(unsigned short*)(v23 + 4) = 0x8000;
     *(short*)(v23 + 6) = 1;
 
-    return v20 + 4 - (program->dynamicStrings + 4);
+    int offset = v20 + 4 - (program->dynamicStrings + 4);
+    program->strings->dynamicOffsets.emplace(string, offset);
+
+    return offset;
+}
+
+// CE: Procedure names are compared with `compat_stricmp`, so they are keyed
+// lowercased.
+static std::string interpretProcedureKey(const char* name)
+{
+    std::string key(name);
+    for (size_t index = 0; index < key.size(); index++) {
+        key[index] = (char)tolower((unsigned char)key[index]);
+    }
+    return key;
+}
+
+// CE: Builds name to index map of procedure table, first procedure wins
+// same as in linear scans it replaces.
+static void interpretIndexProcedures(ProgramImage* image)
+{
+    unsigned char* procedures = image->data + 42;
+    int procedureCount = fetchLong(procedures, 0);
+    unsigned char* identifiers = procedures + 4 + sizeof(Procedure) * procedureCount;
+
+    unsigned char* ptr = procedures + 4;
+    for (int index = 0; index < procedureCount; index++) {
+        int identifierOffset = fetchLong(ptr, offsetof(Procedure, field_0));
+        image->procedures.emplace(interpretProcedureKey((char*)(identifiers + identifierOffset)), index);
+        image->procedureStarts.push_back(std::make_pair(fetchLong(ptr, offsetof(Procedure, field_10)), index));
+
+        ptr += sizeof(Procedure);
+    }
+
+    std::sort(image->procedureStarts.begin(), image->procedureStarts.end());
+}
+
+// CE: Returns id of string value content, equal ids mean equal strings.
+// Strings in both tables are never modified once added, so ids are cached
+// by offset.
+static int interpretInternString(Program* program, opcode_t opcode, int offset)
+{
+    ProgramStrings* strings = program->strings;
+
+    // Same order of checks as in `interpretGetString`.
+    std::unordered_map<int, int>& offsets = (opcode & RAW_VALUE_TYPE_DYNAMIC_STRING) != 0
+        ? strings->dynamicIds
+        : strings->staticIds;
+
+    auto it = offsets.find(offset);
+    if (it != offsets.end()) {
+        return it->second;
+    }
+
+    char* string = interpretGetString(program, opcode, offset);
+    auto result = strings->ids.emplace(string, (int)strings->ids.size());
+    int id = result.first->second;
+    offsets.emplace(offset, id);
+
+    return id;
 }
 
 // 0x45BDB4
@@ -606,7 +1185,7 @@ static void op_push_base(Program* program)
 {
     int argumentCount = programStackPopInteger(program);
     programReturnStackPushInteger(program, program->framePointer);
-    program->framePointer = program->stackValues->size() - argumentCount;
+    program->framePointer = program->stackValues.length - argumentCount;
 }
 
 // 0x45BE5C
@@ -619,15 +1198,20 @@ static void op_pop_base(Program* program)
 // 0x45BEBC
 static void op_pop_to_base(Program* program)
 {
-    while (program->stackValues->size() != program->framePointer) {
-        programStackPopValue(program);
+    // CE: Frame pointer above stack top would never be reached by popping,
+    // treat it as underflow like original vector based code did.
+    if (program->framePointer < 0 || program->framePointer > program->stackValues.length) {
+        interpretError("op_pop_to_base: Stack underflow.");
+        return;
     }
+
+    program->stackValues.length = program->framePointer;
 }
 
 // 0x45BEEC
 static void op_set_global(Program* program)
 {
-    program->basePointer = program->stackValues->size();
+    program->basePointer = program->stackValues.length;
 }
 
 // 0x45BEF8
@@ -743,9 +1327,14 @@ static void op_store(Program* program)
 {
     int addr = programStackPopInteger(program);
     ProgramValue value = programStackPopValue(program);
-    size_t pos = program->framePointer + addr;
+    int pos = program->framePointer + addr;
+
+    if (pos < 0 || pos >= program->stackValues.length) {
+        interpretError("op_store: Invalid stack position %d.", pos);
+        return;
+    }
 
-    program->stackValues->at(pos) = value;
+    program->stackValues.values[pos] = value;
 }
 
 // 0x45C5D0
@@ -753,7 +1342,14 @@ static void op_fetch(Program* program)
 {
     int addr = programStackPopInteger(program);
 
-    ProgramValue value = program->stackValues->at(program->framePointer + addr);
+    int pos = program->framePointer + addr;
+
+    if (pos < 0 || pos >= program->stackValues.length) {
+        interpretError("op_fetch: Invalid stack position %d.", pos);
+        return;
+    }
+
+    ProgramValue value = program->stackValues.values[pos];
     programStackPushValue(program, value);
 }
 
@@ -772,6 +1368,12 @@ static void op_not_equal(Program* program)
     switch (value[1].opcode) {
     case VALUE_TYPE_STRING:
     case VALUE_TYPE_DYNAMIC_STRING:
+        // CE: Compare interned ids instead of contents.
+        if (value[0].opcode == VALUE_TYPE_STRING || value[0].opcode == VALUE_TYPE_DYNAMIC_STRING) {
+            result = interpretInternString(program, value[1].opcode, value[1].integerValue) != interpretInternString(program, value[0].opcode, value[0].integerValue);
+            break;
+        }
+
         strings[1] = interpretGetString(program, value[1].opcode, value[1].integerValue);
 
         switch (value[0].opcode) {
@@ -868,6 +1470,12 @@ static void op_equal(Program* program)
     switch (value[1].opcode) {
     case VALUE_TYPE_STRING:
     case VALUE_TYPE_DYNAMIC_STRING:
+        // CE: Compare interned ids instead of contents.
+        if (value[0].opcode == VALUE_TYPE_STRING || value[0].opcode == VALUE_TYPE_DYNAMIC_STRING) {
+            result = interpretInternString(program, value[1].opcode, value[1].integerValue) == interpretInternString(program, value[0].opcode, value[0].integerValue);
+            break;
+        }
+
         strings[1] = interpretGetString(program, value[1].opcode, value[1].integerValue);
 
         switch (value[0].opcode) {
@@ -2158,7 +2766,14 @@ static void op_fetch_global(Program* program)
 {
     int addr = programStackPopInteger(program);
 
-    ProgramValue value = program->stackValues->at(program->basePointer + addr);
+    int pos = program->basePointer + addr;
+
+    if (pos < 0 || pos >= program->stackValues.length) {
+        interpretError("op_fetch_global: Invalid stack position %d.", pos);
+        return;
+    }
+
+    ProgramValue value = program->stackValues.values[pos];
     programStackPushValue(program, value);
 }
 
@@ -2168,7 +2783,14 @@ static void op_store_global(Program* program)
     int addr = programStackPopInteger(program);
     ProgramValue value = programStackPopValue(program);
 
-    program->stackValues->at(program->basePointer + addr) = value;
+    int pos = program->basePointer + addr;
+
+    if (pos < 0 || pos >= program->stackValues.length) {
+        interpretError("op_store_global: Invalid stack position %d.", pos);
+        return;
+    }
+
+    program->stackValues.values[pos] = value;
 }
 
 // 0x45F73C
@@ -2400,6 +3022,22 @@ static void op_check_arg_count(Program* program)
 static void op_lookup_string_proc(Program* program)
 {
     const char* procedureNameToLookup = programStackPopString(program);
+
+    // CE: Use name index. Main procedure cannot be looked up, it falls back
+    // to scan in case some other procedure has the same name.
+    auto it = program->image->procedures.find(interpretProcedureKey(procedureNameToLookup));
+    if (it == program->image->procedures.end()) {
+        char err[260];
+        snprintf(err, sizeof(err), "Couldn't find string procedure %s\n", procedureNameToLookup);
+        interpretError(err);
+        return;
+    }
+
+    if (it->second != 0) {
+        programStackPushInteger(program, it->second);
+        return;
+    }
+
     int procedureCount = fetchLong(program->procedures, 0);
 
     // Skip procedure count (4 bytes) and main procedure, which cannot be
@@ -2516,6 +3154,9 @@ void interpretClose()
 {
     exportClose();
     intlibClose();
+
+    // CE: Release cached images.
+    programImageTrim(0);
 }
 
 // 0x460628
@@ -2538,8 +3179,6 @@ void interpret(Program* program, int a2)
     // 0x59E798
     static int busy;
 
-    char err[260];
-
     Program* oldCurrentProgram = currentProgram;
 
     if (!enabled) {
@@ -2561,6 +3200,10 @@ void interpret(Program* program, int a2)
     currentProgram = program;
 
     if (setjmp(program->env)) {
+        if (profileEnabled) {
+            interpretProfileFlush();
+        }
+
         currentProgram = oldCurrentProgram;
         program->flags |= PROGRAM_FLAG_EXITED | PROGRAM_FLAG_0x04;
         return;
@@ -2570,50 +3213,51 @@ void interpret(Program* program, int a2)
         a2 = 3;
     }
 
-    while ((program->flags & PROGRAM_FLAG_CRITICAL_SECTION) != 0 || --a2 != -1) {
-        if ((program->flags & (PROGRAM_FLAG_EXITED | PROGRAM_FLAG_0x04 | PROGRAM_FLAG_STOPPED | PROGRAM_FLAG_0x20 | PROGRAM_FLAG_0x40 | PROGRAM_FLAG_0x0100)) != 0) {
-            break;
-        }
+    if (fastDispatch && !profileEnabled) {
+        interpretFast(program, a2, &busy);
+    } else {
+        while ((program->flags & PROGRAM_FLAG_CRITICAL_SECTION) != 0 || --a2 != -1) {
+            if ((program->flags & (PROGRAM_FLAG_EXITED | PROGRAM_FLAG_0x04 | PROGRAM_FLAG_STOPPED | PROGRAM_FLAG_0x20 | PROGRAM_FLAG_0x40 | PROGRAM_FLAG_0x0100)) != 0) {
+                break;
+            }
 
-        if (program->exited) {
-            break;
-        }
+            if (program->exited) {
+                break;
+            }
 
-        if ((program->flags & PROGRAM_IS_WAITING) != 0) {
-            busy = 1;
+            if ((program->flags & PROGRAM_IS_WAITING) != 0) {
+                busy = 1;
 
-            if (program->checkWaitFunc != NULL) {
-                if (!program->checkWaitFunc(program)) {
-                    busy = 0;
-                    continue;
+                if (program->checkWaitFunc != NULL) {
+                    if (!program->checkWaitFunc(program)) {
+                        busy = 0;
+                        continue;
+                    }
                 }
-            }
 
-            busy = 0;
-            program->checkWaitFunc = NULL;
-            program->flags &= ~PROGRAM_IS_WAITING;
-        }
+                busy = 0;
+                program->checkWaitFunc = NULL;
+                program->flags &= ~PROGRAM_IS_WAITING;
+            }
 
-        // NOTE: Uninline.
-        opcode_t opcode = getOp(program);
+            // NOTE: Uninline.
+            opcode_t opcode = getOp(program);
 
-        // TODO: Replace with field_82 and field_80?
-        program->flags &= 0xFFFF;
-        program->flags |= (opcode << 16);
+            // TODO: Replace with field_82 and field_80?
+            program->flags &= 0xFFFF;
+            program->flags |= (opcode << 16);
 
-        if (!((opcode >> 8) & 0x80)) {
-            snprintf(err, sizeof(err), "Bad opcode %x %c %d.", opcode, opcode, opcode);
-            interpretError(err);
-        }
+            if (profileEnabled) {
+                interpretProfileStep(program, program->instructionPointer - 2, opcode);
+            }
 
-        unsigned int opcodeIndex = opcode & 0x3FF;
-        OpcodeHandler* handler = opTable[opcodeIndex];
-        if (handler == NULL) {
-            snprintf(err, sizeof(err), "Undefined opcode %x.", opcode);
-            interpretError(err);
+            // CE: Opcode is validated by `getOp`.
+            opTable[opcode & 0x3FF](program);
         }
+    }
 
-        handler(program);
+    if (profileEnabled) {
+        interpretProfileFlush();
     }
 
     if ((program->flags & PROGRAM_FLAG_EXITED) != 0) {
@@ -2630,6 +3274,360 @@ void interpret(Program* program, int a2)
     currentProgram = oldCurrentProgram;
 }
 
+// CE: Tells whether instruction only works on program stacks, globals and
+// instruction pointer. Such instructions cannot change program flags, stop
+// or start waiting, so state checks can be skipped after them.
+static bool interpretIsPlainOp(opcode_t opcode)
+{
+    switch (opcode & 0x3FF) {
+    case OPCODE_NOOP & 0x3FF:
+    case OPCODE_PUSH & 0x3FF:
+    case OPCODE_JUMP & 0x3FF:
+    case OPCODE_A_TO_D & 0x3FF:
+    case OPCODE_D_TO_A & 0x3FF:
+    case OPCODE_FETCH_GLOBAL & 0x3FF:
+    case OPCODE_STORE_GLOBAL & 0x3FF:
+    case OPCODE_SWAP & 0x3FF:
+    case OPCODE_SWAPA & 0x3FF:
+    case OPCODE_POP & 0x3FF:
+    case OPCODE_DUP & 0x3FF:
+    case OPCODE_POP_BASE & 0x3FF:
+    case OPCODE_POP_TO_BASE & 0x3FF:
+    case OPCODE_PUSH_BASE & 0x3FF:
+    case OPCODE_SET_GLOBAL & 0x3FF:
+    case OPCODE_FETCH_PROCEDURE_ADDRESS & 0x3FF:
+    case OPCODE_IF & 0x3FF:
+    case OPCODE_WHILE & 0x3FF:
+    case OPCODE_STORE & 0x3FF:
+    case OPCODE_FETCH & 0x3FF:
+        return true;
+    }
+
+    return (opcode & 0x3FF) >= (OPCODE_EQUAL & 0x3FF) && (opcode & 0x3FF) <= (OPCODE_NEGATE & 0x3FF);
+}
+
+// CE: Returns core opcode (without type bits) of instruction at `pos`
+// without reporting errors, -1 if there is no valid instruction.
+static int interpretPeekOp(Program* program, int pos)
+{
+    if (pos < 0 || pos + 2 > program->image->size) {
+        return -1;
+    }
+
+    opcode_t opcode = fetchWord(program->data, pos);
+    if ((opcode & 0x8000) == 0 || (opcode & 0x3FF) >= OPCODE_MAX_COUNT || opTable[opcode & 0x3FF] == NULL) {
+        return -1;
+    }
+
+    return opcode & 0x3FF;
+}
+
+// CE: Matches superinstruction starting with push at `pos`. Push is followed
+// by 4-byte operand, so next instruction boundary is known without
+// executing it.
+static int interpretMatchSuperOp(Program* program, int pos)
+{
+    if (pos + 6 > program->image->size) {
+        return INTERPRET_SUPER_OP_NONE;
+    }
+
+    int next = pos + 6;
+    switch (interpretPeekOp(program, next)) {
+    case OPCODE_PUSH & 0x3FF:
+        return INTERPRET_SUPER_OP_PUSH_PUSH;
+    case OPCODE_FETCH & 0x3FF:
+        return INTERPRET_SUPER_OP_PUSH_FETCH;
+    case OPCODE_FETCH_GLOBAL & 0x3FF:
+        if (interpretPeekOp(program, next + 2) == (OPCODE_PUSH & 0x3FF)
+            && interpretPeekOp(program, next + 8) == (OPCODE_EQUAL & 0x3FF)
+            && interpretPeekOp(program, next + 10) == (OPCODE_IF & 0x3FF)) {
+            return INTERPRET_SUPER_OP_FETCH_GLOBAL_EQUAL_IF;
+        }
+        return INTERPRET_SUPER_OP_PUSH_FETCH_GLOBAL;
+    case OPCODE_PUSH_BASE & 0x3FF:
+        return INTERPRET_SUPER_OP_PUSH_PUSH_BASE;
+    case OPCODE_EQUAL & 0x3FF:
+        if (interpretPeekOp(program, next + 2) == (OPCODE_IF & 0x3FF)) {
+            return INTERPRET_SUPER_OP_PUSH_EQUAL_IF;
+        }
+        break;
+    }
+
+    return INTERPRET_SUPER_OP_NONE;
+}
+
+// CE: Returns superinstruction starting with push at `pos`, matching it on
+// first visit. Like `decodedOps` only even offsets are cached, jumps into
+// the middle of a sequence start a sequence of their own (or none).
+static int interpretSuperOpAt(Program* program, int pos)
+{
+    int index = pos >> 1;
+    if ((pos & 1) != 0 || index >= program->decodedOpsLength) {
+        return INTERPRET_SUPER_OP_NONE;
+    }
+
+    int superOp = program->superOps[index];
+    if (superOp == INTERPRET_SUPER_OP_UNKNOWN) {
+        superOp = interpretMatchSuperOp(program, pos);
+        program->superOps[index] = (unsigned char)superOp;
+    }
+
+    return superOp;
+}
+
+// CE: Number of instructions in superinstruction.
+static int interpretSuperOpLength(int superOp)
+{
+    switch (superOp) {
+    case INTERPRET_SUPER_OP_PUSH_EQUAL_IF:
+        return 3;
+    case INTERPRET_SUPER_OP_FETCH_GLOBAL_EQUAL_IF:
+        return 5;
+    }
+
+    return 2;
+}
+
+// CE: Fetches next instruction of superinstruction, same as top of
+// `interpret` loop minus state checks.
+static inline void interpretSuperOpStep(Program* program)
+{
+    opcode_t opcode = getOp(program);
+
+    program->flags &= 0xFFFF;
+    program->flags |= (opcode << 16);
+}
+
+#if INTERPRET_COMPUTED_GOTO
+#define INTERPRET_FAST_CASE(label, index) label:
+#else
+#define INTERPRET_FAST_CASE(label, index) case index:
+#endif
+
+// CE: Same as original loop in `interpret`, but program state is only
+// rechecked after instructions that can change it (calls, waits, exits,
+// critical sections and every exported function). Plain instructions are
+// dispatched through computed goto (or switch) instead of `opTable`, which
+// lets compiler inline their handlers, and frequent sequences of them run
+// as superinstructions. Every instruction of superinstruction counts
+// against [a2], sequences which do not fit are executed one by one.
+// Exported functions with known number of arguments have stack depth
+// checked once before the call.
+static void interpretFast(Program* program, int a2, int* busy)
+{
+#if INTERPRET_COMPUTED_GOTO
+    static void* dispatchTable[OPCODE_MAX_COUNT + INTERPRET_SUPER_OP_COUNT];
+    if (dispatchTable[0] == NULL) {
+        for (int index = 0; index < OPCODE_MAX_COUNT + INTERPRET_SUPER_OP_COUNT; index++) {
+            dispatchTable[index] = &&opOther;
+        }
+
+        dispatchTable[OPCODE_NOOP & 0x3FF] = &&opNoop;
+        dispatchTable[OPCODE_PUSH & 0x3FF] = &&opPush;
+        dispatchTable[OPCODE_JUMP & 0x3FF] = &&opJump;
+        dispatchTable[OPCODE_FETCH_GLOBAL & 0x3FF] = &&opFetchGlobal;
+        dispatchTable[OPCODE_STORE_GLOBAL & 0x3FF] = &&opStoreGlobal;
+        dispatchTable[OPCODE_POP & 0x3FF] = &&opPop;
+        dispatchTable[OPCODE_DUP & 0x3FF] = &&opDup;
+        dispatchTable[OPCODE_POP_BASE & 0x3FF] = &&opPopBase;
+        dispatchTable[OPCODE_POP_TO_BASE & 0x3FF] = &&opPopToBase;
+        dispatchTable[OPCODE_PUSH_BASE & 0x3FF] = &&opPushBase;
+        dispatchTable[OPCODE_IF & 0x3FF] = &&opIf;
+        dispatchTable[OPCODE_WHILE & 0x3FF] = &&opWhile;
+        dispatchTable[OPCODE_STORE & 0x3FF] = &&opStore;
+        dispatchTable[OPCODE_FETCH & 0x3FF] = &&opFetch;
+        dispatchTable[OPCODE_EQUAL & 0x3FF] = &&opEqual;
+        dispatchTable[OPCODE_NOT_EQUAL & 0x3FF] = &&opNotEqual;
+        dispatchTable[OPCODE_ADD & 0x3FF] = &&opAdd;
+        dispatchTable[OPCODE_SUB & 0x3FF] = &&opSub;
+        dispatchTable[OPCODE_AND & 0x3FF] = &&opAnd;
+        dispatchTable[OPCODE_OR & 0x3FF] = &&opOr;
+        dispatchTable[OPCODE_NOT & 0x3FF] = &&opNot;
+        dispatchTable[OPCODE_MAX_COUNT + INTERPRET_SUPER_OP_PUSH_PUSH] = &&superPushPush;
+        dispatchTable[OPCODE_MAX_COUNT + INTERPRET_SUPER_OP_PUSH_FETCH] = &&superPushFetch;
+        dispatchTable[OPCODE_MAX_COUNT + INTERPRET_SUPER_OP_PUSH_FETCH_GLOBAL] = &&superPushFetchGlobal;
+        dispatchTable[OPCODE_MAX_COUNT + INTERPRET_SUPER_OP_PUSH_PUSH_BASE] = &&superPushPushBase;
+        dispatchTable[OPCODE_MAX_COUNT + INTERPRET_SUPER_OP_PUSH_EQUAL_IF] = &&superPushEqualIf;
+        dispatchTable[OPCODE_MAX_COUNT + INTERPRET_SUPER_OP_FETCH_GLOBAL_EQUAL_IF] = &&superFetchGlobalEqualIf;
+    }
+#endif
+
+    bool check = true;
+
+    while ((program->flags & PROGRAM_FLAG_CRITICAL_SECTION) != 0 || --a2 != -1) {
+        if (check) {
+            if ((program->flags & (PROGRAM_FLAG_EXITED | PROGRAM_FLAG_0x04 | PROGRAM_FLAG_STOPPED | PROGRAM_FLAG_0x20 | PROGRAM_FLAG_0x40 | PROGRAM_FLAG_0x0100)) != 0) {
+                break;
+            }
+
+            if (program->exited) {
+                break;
+            }
+
+            if ((program->flags & PROGRAM_IS_WAITING) != 0) {
+                *busy = 1;
+
+                if (program->checkWaitFunc != NULL) {
+                    if (!program->checkWaitFunc(program)) {
+                        *busy = 0;
+                        continue;
+                    }
+                }
+
+                *busy = 0;
+                program->checkWaitFunc = NULL;
+                program->flags &= ~PROGRAM_IS_WAITING;
+            }
+        }
+
+        opcode_t opcode = getOp(program);
+
+        program->flags &= 0xFFFF;
+        program->flags |= (opcode << 16);
+
+        check = false;
+
+        int dispatch = opcode & 0x3FF;
+        if (dispatch == (OPCODE_PUSH & 0x3FF)) {
+            int superOp = interpretSuperOpAt(program, program->instructionPointer - 2);
+            if (superOp != INTERPRET_SUPER_OP_NONE) {
+                // Remaining instructions of sequence are taken from burst.
+                // Critical sections and negative bursts are not limited.
+                int extra = interpretSuperOpLength(superOp) - 1;
+                if ((program->flags & PROGRAM_FLAG_CRITICAL_SECTION) != 0 || a2 < 0) {
+                    dispatch = OPCODE_MAX_COUNT + superOp;
+                } else if (a2 >= extra) {
+                    a2 -= extra;
+                    dispatch = OPCODE_MAX_COUNT + superOp;
+                }
+            }
+        }
+
+#if INTERPRET_COMPUTED_GOTO
+        goto* dispatchTable[dispatch];
+#else
+        switch (dispatch) {
+#endif
+        INTERPRET_FAST_CASE(opNoop, OPCODE_NOOP & 0x3FF)
+            continue;
+        INTERPRET_FAST_CASE(opPush, OPCODE_PUSH & 0x3FF)
+            op_const(program);
+            continue;
+        INTERPRET_FAST_CASE(opJump, OPCODE_JUMP & 0x3FF)
+            op_jmp(program);
+            continue;
+        INTERPRET_FAST_CASE(opFetchGlobal, OPCODE_FETCH_GLOBAL & 0x3FF)
+            op_fetch_global(program);
+            continue;
+        INTERPRET_FAST_CASE(opStoreGlobal, OPCODE_STORE_GLOBAL & 0x3FF)
+            op_store_global(program);
+            continue;
+        INTERPRET_FAST_CASE(opPop, OPCODE_POP & 0x3FF)
+            op_pop(program);
+            continue;
+        INTERPRET_FAST_CASE(opDup, OPCODE_DUP & 0x3FF)
+            op_dup(program);
+            continue;
+        INTERPRET_FAST_CASE(opPopBase, OPCODE_POP_BASE & 0x3FF)
+            op_pop_base(program);
+            continue;
+        INTERPRET_FAST_CASE(opPopToBase, OPCODE_POP_TO_BASE & 0x3FF)
+            op_pop_to_base(program);
+            continue;
+        INTERPRET_FAST_CASE(opPushBase, OPCODE_PUSH_BASE & 0x3FF)
+            op_push_base(program);
+            continue;
+        INTERPRET_FAST_CASE(opIf, OPCODE_IF & 0x3FF)
+            op_if(program);
+            continue;
+        INTERPRET_FAST_CASE(opWhile, OPCODE_WHILE & 0x3FF)
+            op_while(program);
+            continue;
+        INTERPRET_FAST_CASE(opStore, OPCODE_STORE & 0x3FF)
+            op_store(program);
+            continue;
+        INTERPRET_FAST_CASE(opFetch, OPCODE_FETCH & 0x3FF)
+            op_fetch(program);
+            continue;
+        INTERPRET_FAST_CASE(opEqual, OPCODE_EQUAL & 0x3FF)
+            op_equal(program);
+            continue;
+        INTERPRET_FAST_CASE(opNotEqual, OPCODE_NOT_EQUAL & 0x3FF)
+            op_not_equal(program);
+            continue;
+        INTERPRET_FAST_CASE(opAdd, OPCODE_ADD & 0x3FF)
+            op_add(program);
+            continue;
+        INTERPRET_FAST_CASE(opSub, OPCODE_SUB & 0x3FF)
+            op_sub(program);
+            continue;
+        INTERPRET_FAST_CASE(opAnd, OPCODE_AND & 0x3FF)
+            op_and(program);
+            continue;
+        INTERPRET_FAST_CASE(opOr, OPCODE_OR & 0x3FF)
+            op_or(program);
+            continue;
+        INTERPRET_FAST_CASE(opNot, OPCODE_NOT & 0x3FF)
+            op_not(program);
+            continue;
+        INTERPRET_FAST_CASE(superPushPush, OPCODE_MAX_COUNT + INTERPRET_SUPER_OP_PUSH_PUSH)
+            op_const(program);
+            interpretSuperOpStep(program);
+            op_const(program);
+            continue;
+        INTERPRET_FAST_CASE(superPushFetch, OPCODE_MAX_COUNT + INTERPRET_SUPER_OP_PUSH_FETCH)
+            op_const(program);
+            interpretSuperOpStep(program);
+            op_fetch(program);
+            continue;
+        INTERPRET_FAST_CASE(superPushFetchGlobal, OPCODE_MAX_COUNT + INTERPRET_SUPER_OP_PUSH_FETCH_GLOBAL)
+            op_const(program);
+            interpretSuperOpStep(program);
+            op_fetch_global(program);
+            continue;
+        INTERPRET_FAST_CASE(superPushPushBase, OPCODE_MAX_COUNT + INTERPRET_SUPER_OP_PUSH_PUSH_BASE)
+            op_const(program);
+            interpretSuperOpStep(program);
+            op_push_base(program);
+            continue;
+        INTERPRET_FAST_CASE(superPushEqualIf, OPCODE_MAX_COUNT + INTERPRET_SUPER_OP_PUSH_EQUAL_IF)
+            op_const(program);
+            interpretSuperOpStep(program);
+            op_equal(program);
+            interpretSuperOpStep(program);
+            op_if(program);
+            continue;
+        INTERPRET_FAST_CASE(superFetchGlobalEqualIf, OPCODE_MAX_COUNT + INTERPRET_SUPER_OP_FETCH_GLOBAL_EQUAL_IF)
+            op_const(program);
+            interpretSuperOpStep(program);
+            op_fetch_global(program);
+            interpretSuperOpStep(program);
+            op_const(program);
+            interpretSuperOpStep(program);
+            op_equal(program);
+            interpretSuperOpStep(program);
+            op_if(program);
+            continue;
+#if INTERPRET_COMPUTED_GOTO
+        opOther:
+#else
+        default:
+#endif
+            if (program->stackValues.length < opArgs[opcode & 0x3FF]) {
+                interpretError("Stack underflow in opcode %x.", opcode);
+            }
+
+            opTable[opcode & 0x3FF](program);
+            check = !interpretIsPlainOp(opcode);
+            continue;
+#if !INTERPRET_COMPUTED_GOTO
+        }
+#endif
+    }
+}
+
+#undef INTERPRET_FAST_CASE
+
 // Prepares program stacks for executing proc at [address].
 //
 // 0x460884
@@ -2751,16 +3749,10 @@ void executeProc(Program* program, int procedureIndex)
 // 0x461938
 int interpretFindProcedure(Program* program, const char* name)
 {
-    int procedureCount = fetchLong(program->procedures, 0);
-
-    unsigned char* ptr = program->procedures + 4;
-    for (int index = 0; index < procedureCount; index++) {
-        int identifierOffset = fetchLong(ptr, offsetof(Procedure, field_0));
-        if (compat_stricmp((char*)(program->identifiers + identifierOffset), name) == 0) {
-            return index;
-        }
-
-        ptr += sizeof(Procedure);
+    // CE: Use name index.
+    auto it = program->image->procedures.find(interpretProcedureKey(name));
+    if (it != program->image->procedures.end()) {
+        return it->second;
     }
 
     return -1;
@@ -2778,10 +3770,17 @@ void executeProcedure(Program* program, int procedureIndex)
     int procedureFlags;
     char err[256];
     jmp_buf env;
+    char profLabel[PROF_LABEL_SIZE];
 
     procedurePtr = program->procedures + 4 + sizeof(Procedure) * procedureIndex;
     procedureFlags = fetchLong(procedurePtr, 4);
 
+    // CE: Name trace entry after script and procedure.
+    if (prof_tracing) {
+        snprintf(profLabel, sizeof(profLabel), "%s:%s", program->name, interpretGetName(program, fetchLong(procedurePtr, 0)));
+    }
+    ProfScope profScope(PROF_ZONE_SCRIPT_PROCEDURE, prof_tracing ? profLabel : NULL);
+
     if ((procedureFlags & PROCEDURE_FLAG_IMPORTED) != 0) {
         procedureIdentifier = interpretGetName(program, fetchLong(procedurePtr, 0));
         externalProgram = exportFindProcedure(procedureIdentifier, &externalProcedureAddress, &externalProcedureArgumentCount);
@@ -2944,9 +3943,17 @@ void interpretSetCPUBurstSize(int value)
     cpuBurstSize = value;
 }
 
+// CE: Switches between original and `interpretFast` dispatch loops.
+void interpretSetFastDispatch(bool enabled)
+{
+    fastDispatch = enabled;
+}
+
 // 0x461F28
 void updatePrograms()
 {
+    ProfScope profScope(PROF_ZONE_UPDATE_PROGRAMS);
+
     ProgramListNode* curr = head;
     while (curr != NULL) {
         ProgramListNode* next = curr->next;
@@ -3046,6 +4053,16 @@ void interpretAddFunc(int opcode, OpcodeHandler* handler)
     }
 
     opTable[index] = handler;
+    opArgs[index] = 0;
+}
+
+// CE: Registers table of exported functions, see `OpcodeInfo`.
+void interpretAddFuncs(const OpcodeInfo* infos, int length)
+{
+    for (int index = 0; index < length; index++) {
+        interpretAddFunc(infos[index].opcode, infos[index].handler);
+        opArgs[infos[index].opcode & 0x3FFF] = (unsigned char)infos[index].args;
+    }
 }
 
 // 0x4620D4
@@ -3108,11 +4125,12 @@ int interpretLoadProgramState()
 
 void programStackPushValue(Program* program, ProgramValue& programValue)
 {
-    if (program->stackValues->size() > STACK_SIZE) {
+    if (program->stackValues.length >= PROGRAM_STACK_CAPACITY) {
         interpretError("programStackPushValue: Stack overflow.");
+        return;
     }
 
-    program->stackValues->push_back(programValue);
+    program->stackValues.values[program->stackValues.length++] = programValue;
 }
 
 void programStackPushInteger(Program* program, int value)
@@ -3149,14 +4167,16 @@ void programStackPushPointer(Program* program, void* value)
 
 ProgramValue programStackPopValue(Program* program)
 {
-    if (program->stackValues->empty()) {
+    if (program->stackValues.length == 0) {
         interpretError("programStackPopValue: Stack underflow.");
-    }
 
-    ProgramValue programValue = program->stackValues->back();
-    program->stackValues->pop_back();
+        ProgramValue programValue;
+        programValue.opcode = 0;
+        programValue.integerValue = 0;
+        return programValue;
+    }
 
-    return programValue;
+    return program->stackValues.values[--program->stackValues.length];
 }
 
 int programStackPopInteger(Program* program)
@@ -3205,11 +4225,12 @@ void* programStackPopPointer(Program* program)
 
 void programReturnStackPushValue(Program* program, ProgramValue& programValue)
 {
-    if (program->returnStackValues->size() > STACK_SIZE) {
+    if (program->returnStackValues.length >= PROGRAM_STACK_CAPACITY) {
         interpretError("programReturnStackPushValue: Stack overflow.");
+        return;
     }
 
-    program->returnStackValues->push_back(programValue);
+    program->returnStackValues.values[program->returnStackValues.length++] = programValue;
 }
 
 void programReturnStackPushInteger(Program* program, int value)
@@ -3230,14 +4251,16 @@ void programReturnStackPushPointer(Program* program, void* value)
 
 ProgramValue programReturnStackPopValue(Program* program)
 {
-    if (program->returnStackValues->empty()) {
+    if (program->returnStackValues.length == 0) {
         interpretError("programReturnStackPopValue: Stack underflow.");
-    }
 
-    ProgramValue programValue = program->returnStackValues->back();
-    program->returnStackValues->pop_back();
+        ProgramValue programValue;
+        programValue.opcode = 0;
+        programValue.integerValue = 0;
+        return programValue;
+    }
 
-    return programValue;
+    return program->returnStackValues.values[--program->returnStackValues.length];
 }
 
 int programReturnStackPopInteger(Program* program)
@@ -7,6 +7,9 @@
 
 namespace fallout {
 
+// The maximum number of opcodes.
+#define OPCODE_MAX_COUNT 342
+
 typedef enum Opcode {
     OPCODE_NOOP = 0x8000,
     OPCODE_PUSH = 0x8001,
@@ -146,7 +149,15 @@ typedef struct ProgramValue {
     bool isEmpty();
 } ProgramValue;
 
-typedef std::vector<ProgramValue> ProgramStack;
+// CE: Value stack with fixed capacity, allocated once per program (see
+// `PROGRAM_STACK_CAPACITY`).
+typedef struct ProgramStack {
+    ProgramValue* values;
+    int length;
+} ProgramStack;
+
+typedef struct ProgramStrings ProgramStrings;
+typedef struct ProgramImage ProgramImage;
 
 typedef struct Program Program;
 typedef int(InterpretCheckWaitFunc)(Program* program);
@@ -173,8 +184,24 @@ typedef struct Program {
     int flags; // flags
     int windowId;
     bool exited;
-    ProgramStack* stackValues;
-    ProgramStack* returnStackValues;
+    ProgramStack stackValues;
+    ProgramStack returnStackValues;
+
+    // CE: Decoded opcodes, one entry per 2-byte unit of `data` (see
+    // `getOp`).
+    unsigned int* decodedOps;
+    int decodedOpsLength;
+
+    // CE: Superinstructions starting at each 2-byte unit of `data` (see
+    // `interpretFast`), same length as `decodedOps`.
+    unsigned char* superOps;
+
+    // CE: String interning tables (see `interpretInternString`).
+    ProgramStrings* strings;
+
+    // CE: Shared file contents (`data` points into it). Procedures table is
+    // written to at runtime, so `procedures` is a private copy.
+    ProgramImage* image;
 } Program;
 
 typedef char*(InterpretMangleFunc)(char* fileName);
@@ -182,7 +209,42 @@ typedef int(InterpretOutputFunc)(char* string);
 typedef unsigned int(InterpretTimerFunc)();
 typedef void(OpcodeHandler)(Program* program);
 
-void interpretSetTimeFunc(InterpretTimerFunc* timerFunc, int timerTick);
+// CE: Exported function registered with `interpretAddFuncs`.
+typedef struct OpcodeInfo {
+    int opcode;
+    OpcodeHandler* handler;
+
+    // Number of values handler takes off the stack on every path. Checked
+    // once before handler is called, so handler never starts with stack
+    // which is too short for it.
+    int args;
+} OpcodeInfo;
+
+// CE: Checks opcode table at compile time - every opcode fits `opTable`
+// and is listed once.
+constexpr bool interpretOpcodesValid(const OpcodeInfo* infos, int length)
+{
+    for (int index = 0; index < length; index++) {
+        int opcode = infos[index].opcode;
+        if ((opcode & 0x8000) == 0 || (opcode & 0x3FFF) >= OPCODE_MAX_COUNT) {
+            return false;
+        }
+
+        if (infos[index].handler == nullptr || infos[index].args < 0) {
+            return false;
+        }
+
+        for (int other = 0; other < index; other++) {
+            if (infos[other].opcode == opcode) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+void interpretSetTimeFunc(InterpretTimerFunc* func, int tick);
 char* interpretMangleName(char* fileName);
 void interpretOutputFunc(InterpretOutputFunc* func);
 int interpretOutput(const char* format, ...);
@@ -202,12 +264,23 @@ void executeProcedure(Program* program, int procedureIndex);
 void runProgram(Program* program);
 Program* runScript(char* name);
 void interpretSetCPUBurstSize(int value);
+void interpretSetFastDispatch(bool enabled);
+
+typedef void(InterpretProfileProc)(const char* programName, const char* procedureName, unsigned int instructions, unsigned int externalCalls, double milliseconds, void* userData);
+
+void interpretProfileSetEnabled(bool enabled);
+bool interpretProfileIsEnabled();
+void interpretProfileReset();
+void interpretProfileVisit(InterpretProfileProc* proc, void* userData);
+int interpretProfileWriteTable(const char* path);
+int interpretProfileWriteTrace(const char* path);
 void updatePrograms();
 void clearPrograms();
 void clearTopProgram();
 char** getProgramList(int* programListLengthPtr);
 void freeProgramList(char** programList, int programListLength);
 void interpretAddFunc(int opcode, OpcodeHandler* handler);
+void interpretAddFuncs(const OpcodeInfo* infos, int length);
 void interpretSetFilenameFunc(InterpretMangleFunc* func);
 void interpretSuspendEvents();
 void interpretResumeEvents();
@@ -315,7 +315,7 @@ static void movie_MVE_ShowFrame(SDL_Surface* surface, int srcWidth, int srcHeigh
 
     SDL_SetSurfacePalette(surface, gSdlSurface->format->palette);
     SDL_BlitSurface(surface, &srcRect, gSdlSurface, &destRect);
-    SDL_BlitSurface(gSdlSurface, NULL, gSdlTextureSurface, NULL);
+    renderInvalidateRect(destRect.x, destRect.y, destRect.w, destRect.h);
     renderPresent();
 }
 
@@ -971,6 +971,66 @@ void movieSetVolume(int volume)
     movieLibSetVolume(normalized_volume);
 }
 
+// CE: Sets number of threads decoding video of one frame (including main
+// thread).
+void movieSetDecodeThreads(int threads)
+{
+    movieLibSetDecodeThreads(threads);
+}
+
+// CE: Plays only sound of movies started afterwards, video is not decoded.
+void movieSetAudioOnly(bool audioOnly)
+{
+    movieLibSetAudioOnly(audioOnly);
+}
+
+// CE: Decodes movie as fast as possible without showing it or playing its
+// sound, stores decoding time in `msPtr` and checksum of decoded frames in
+// `checksumPtr`. When `reference` is set, blocks are decoded with scalar
+// reference code only. Returns number of frames decoded, or -1 on error.
+int movieBenchmark(char* filePath, bool reference, double* msPtr, unsigned long long* checksumPtr)
+{
+    if (running) {
+        return -1;
+    }
+
+    DB_FILE* stream = db_fopen(filePath, "rb");
+    if (stream == NULL) {
+        return -1;
+    }
+
+    movieLibSetDecodeOnly(true);
+    movieLibSetReferenceDecoder(reference);
+
+    Uint64 start = SDL_GetPerformanceCounter();
+
+    int rc = _MVE_rmPrepMovie(stream, -1, -1, 0);
+    if (rc == 0) {
+        do {
+            rc = _MVE_rmStepMovie();
+        } while (rc == 0);
+    }
+
+    *msPtr = (double)(SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency();
+
+    int frames;
+    int dropped;
+    _MVE_rmFrameCounts(&frames, &dropped);
+
+    *checksumPtr = movieLibGetChecksum();
+
+    _MVE_rmEndMovie();
+    _MVE_ReleaseMem();
+
+    movieLibSetReferenceDecoder(false);
+    movieLibSetDecodeOnly(false);
+
+    db_fclose(stream);
+
+    // Movie ends with -1, anything else is an error.
+    return rc == -1 ? frames : -1;
+}
+
 // 0x4799F0
 void movieUpdate()
 {
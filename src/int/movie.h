@@ -47,6 +47,9 @@ int movieRun(int win, char* filePath);
 int movieRunRect(int win, char* filePath, int a3, int a4, int a5, int a6);
 void movieSetSubtitleFunc(MovieSubtitleFunc* proc);
 void movieSetVolume(int volume);
+void movieSetDecodeThreads(int threads);
+void movieSetAudioOnly(bool audioOnly);
+int movieBenchmark(char* filePath, bool reference, double* msPtr, unsigned long long* checksumPtr);
 void movieUpdate();
 int moviePlaying();
 
@@ -3,6 +3,8 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <unordered_map>
+
 #include "int/intlib.h"
 #include "int/memdbg.h"
 #include "platform_compat.h"
@@ -12,6 +14,9 @@ namespace fallout {
 
 #define NEVS_COUNT 40
 
+// CE: Number of buckets in name hash, power of two.
+#define NEVS_HASH_SIZE 64
+
 typedef struct Nevs {
     bool used;
     char name[32];
@@ -21,12 +26,28 @@ typedef struct Nevs {
     int hits;
     bool busy;
     NevsCallback* callback;
+
+    // CE: Hash of `name` and index of the next entry in the same bucket (-1
+    // terminates chain).
+    unsigned int hash;
+    int hashNext;
+
+    // CE: Index of the next entry owned by the same program (-1 terminates
+    // chain).
+    int programNext;
 } Nevs;
 
 static Nevs* nevs_alloc();
 static void nevs_free(Nevs* nevs);
 static void nevs_removeprogramreferences(Program* program);
 static Nevs* nevs_find(const char* name);
+static unsigned int nevs_hash(const char* name);
+static void nevs_link(Nevs* entry);
+static void nevs_unlink(Nevs* entry);
+static void nevs_link_program(Nevs* entry);
+static void nevs_unlink_program(Nevs* entry);
+static void nevs_reset();
+static void nevs_queue(Nevs* entry);
 
 // 0x637728
 static Nevs* nevs;
@@ -34,6 +55,19 @@ static Nevs* nevs;
 // 0x63772C
 static int anyhits;
 
+// CE: Heads of name hash chains (indexes into `nevs`, -1 - empty).
+static int nevs_buckets[NEVS_HASH_SIZE];
+
+// CE: Heads of chains of entries owned by every program.
+static std::unordered_map<Program*, int> nevs_program_entries;
+
+// CE: Indexes of entries signaled since last `nevs_update`. Entry is queued
+// at most once, flags are kept apart from entries, so they survive
+// `nevs_free` while index is still in the queue.
+static int nevs_pending[NEVS_COUNT];
+static int nevs_pending_length;
+static bool nevs_queued[NEVS_COUNT];
+
 // 0x47A150
 static Nevs* nevs_alloc()
 {
@@ -60,6 +94,12 @@ static Nevs* nevs_alloc()
 // 0x47A1A4
 static void nevs_free(Nevs* entry)
 {
+    // CE: Remove from lookup chains.
+    if (entry->used) {
+        nevs_unlink(entry);
+        nevs_unlink_program(entry);
+    }
+
     entry->used = false;
     memset(entry, 0, sizeof(*entry));
 }
@@ -71,21 +111,21 @@ void nevs_close()
         myfree(nevs, __FILE__, __LINE__); // "..\\int\\NEVS.C", 97
         nevs = NULL;
     }
+
+    nevs_reset();
 }
 
 // 0x47A1E4
 static void nevs_removeprogramreferences(Program* program)
 {
-    int index;
-    Nevs* entry;
-
     if (nevs != NULL) {
-        for (index = 0; index < NEVS_COUNT; index++) {
-            entry = &(nevs[index]);
-            if (entry->used && entry->program == program) {
-                // NOTE: Uninline.
-                nevs_free(entry);
-            }
+        // CE: Free entries owned by program from its chain instead of
+        // checking every entry.
+        auto it = nevs_program_entries.find(program);
+        while (it != nevs_program_entries.end()) {
+            // NOTE: Uninline.
+            nevs_free(&(nevs[it->second]));
+            it = nevs_program_entries.find(program);
         }
     }
 }
@@ -101,6 +141,8 @@ void nevs_initonce()
             debug_printf("nevs_initonce(): out of memory");
             exit(99);
         }
+
+        nevs_reset();
     }
 }
 
@@ -115,9 +157,11 @@ static Nevs* nevs_find(const char* name)
         exit(99);
     }
 
-    for (index = 0; index < NEVS_COUNT; index++) {
+    // CE: Look up in hash chain instead of comparing every entry.
+    unsigned int hash = nevs_hash(name);
+    for (index = nevs_buckets[hash & (NEVS_HASH_SIZE - 1)]; index != -1; index = entry->hashNext) {
         entry = &(nevs[index]);
-        if (entry->used && compat_stricmp(entry->name, name) == 0) {
+        if (entry->hash == hash && compat_stricmp(entry->name, name) == 0) {
             return entry;
         }
     }
@@ -125,6 +169,121 @@ static Nevs* nevs_find(const char* name)
     return NULL;
 }
 
+// CE: Case-insensitive FNV-1a, folds case the same way as `compat_stricmp`.
+static unsigned int nevs_hash(const char* name)
+{
+    unsigned int hash = 2166136261U;
+    for (const unsigned char* pch = (const unsigned char*)name; *pch != '\0'; pch++) {
+        unsigned char ch = *pch;
+        if (ch >= 'a' && ch <= 'z') {
+            ch -= 'a' - 'A';
+        }
+
+        hash ^= ch;
+        hash *= 16777619U;
+    }
+    return hash;
+}
+
+// CE: Adds used entry to hash chain of its name.
+static void nevs_link(Nevs* entry)
+{
+    int index = (int)(entry - nevs);
+    int* head = &(nevs_buckets[entry->hash & (NEVS_HASH_SIZE - 1)]);
+    entry->hashNext = *head;
+    *head = index;
+}
+
+static void nevs_unlink(Nevs* entry)
+{
+    int index = (int)(entry - nevs);
+    int* link = &(nevs_buckets[entry->hash & (NEVS_HASH_SIZE - 1)]);
+    while (*link != -1) {
+        if (*link == index) {
+            *link = entry->hashNext;
+            break;
+        }
+        link = &(nevs[*link].hashNext);
+    }
+    entry->hashNext = -1;
+}
+
+// CE: Adds entry to chain of its program (if any).
+static void nevs_link_program(Nevs* entry)
+{
+    if (entry->program == NULL) {
+        entry->programNext = -1;
+        return;
+    }
+
+    int index = (int)(entry - nevs);
+    auto it = nevs_program_entries.find(entry->program);
+    if (it != nevs_program_entries.end()) {
+        entry->programNext = it->second;
+        it->second = index;
+    } else {
+        entry->programNext = -1;
+        nevs_program_entries.emplace(entry->program, index);
+    }
+}
+
+static void nevs_unlink_program(Nevs* entry)
+{
+    if (entry->program == NULL) {
+        return;
+    }
+
+    auto it = nevs_program_entries.find(entry->program);
+    if (it == nevs_program_entries.end()) {
+        return;
+    }
+
+    int index = (int)(entry - nevs);
+    if (it->second == index) {
+        if (entry->programNext != -1) {
+            it->second = entry->programNext;
+        } else {
+            nevs_program_entries.erase(it);
+        }
+    } else {
+        int curr = it->second;
+        while (curr != -1) {
+            Nevs* prev = &(nevs[curr]);
+            if (prev->programNext == index) {
+                prev->programNext = entry->programNext;
+                break;
+            }
+            curr = prev->programNext;
+        }
+    }
+
+    entry->programNext = -1;
+}
+
+// CE: Clears lookup chains and pending signals.
+static void nevs_reset()
+{
+    for (int index = 0; index < NEVS_HASH_SIZE; index++) {
+        nevs_buckets[index] = -1;
+    }
+
+    nevs_program_entries.clear();
+
+    nevs_pending_length = 0;
+    memset(nevs_queued, 0, sizeof(nevs_queued));
+    anyhits = 0;
+}
+
+// CE: Queues signaled entry for `nevs_update`.
+static void nevs_queue(Nevs* entry)
+{
+    int index = (int)(entry - nevs);
+    if (!nevs_queued[index]) {
+        nevs_queued[index] = true;
+        nevs_pending[nevs_pending_length++] = index;
+    }
+}
+
 // 0x47A2D8
 int nevs_addevent(const char* name, Program* program, int proc, int type)
 {
@@ -133,12 +292,21 @@ int nevs_addevent(const char* name, Program* program, int proc, int type)
     entry = nevs_find(name);
     if (entry == NULL) {
         entry = nevs_alloc();
+        // CE: Name hash is kept for lookups.
+        if (entry != NULL) {
+            entry->hash = nevs_hash(name);
+            nevs_link(entry);
+            entry->program = NULL;
+        }
     }
 
     if (entry == NULL) {
         return 1;
     }
 
+    // CE: Move entry to chain of its new owner.
+    nevs_unlink_program(entry);
+
     entry->used = true;
     strcpy(entry->name, name);
     entry->program = program;
@@ -146,6 +314,8 @@ int nevs_addevent(const char* name, Program* program, int proc, int type)
     entry->type = type;
     entry->callback = NULL;
 
+    nevs_link_program(entry);
+
     return 0;
 }
 
@@ -159,12 +329,20 @@ int nevs_addCevent(const char* name, NevsCallback* callback, int type)
     entry = nevs_find(name);
     if (entry == NULL) {
         entry = nevs_alloc();
+        // CE: Name hash is kept for lookups.
+        if (entry != NULL) {
+            entry->hash = nevs_hash(name);
+            nevs_link(entry);
+            entry->program = NULL;
+        }
     }
 
     if (entry == NULL) {
         return 1;
     }
 
+    nevs_unlink_program(entry);
+
     entry->used = true;
     strcpy(entry->name, name);
     entry->program = NULL;
@@ -211,6 +389,10 @@ int nevs_signal(const char* name)
         && !entry->busy) {
         entry->hits++;
         anyhits++;
+
+        // CE: Queue entry, so that update does not have to look for it.
+        nevs_queue(entry);
+
         return 0;
     }
 
@@ -231,7 +413,20 @@ void nevs_update()
 
     anyhits = 0;
 
-    for (index = 0; index < NEVS_COUNT; index++) {
+    // CE: Process entries signaled so far in order they were signaled, rather
+    // than scanning every entry. Entries signaled by handlers (or with hits
+    // left) are queued anew and processed on the next update.
+    int pending[NEVS_COUNT];
+    int pendingLength = nevs_pending_length;
+    memcpy(pending, nevs_pending, sizeof(*pending) * pendingLength);
+
+    nevs_pending_length = 0;
+    for (int pendingIndex = 0; pendingIndex < pendingLength; pendingIndex++) {
+        nevs_queued[pending[pendingIndex]] = false;
+    }
+
+    for (int pendingIndex = 0; pendingIndex < pendingLength; pendingIndex++) {
+        index = pending[pendingIndex];
         entry = &(nevs[index]);
         if (entry->used
             && ((entry->program != NULL && entry->proc != 0) || entry->callback != NULL)
@@ -253,6 +448,8 @@ void nevs_update()
                 if (entry->type == NEVS_TYPE_EVENT) {
                     // NOTE: Uninline.
                     nevs_free(entry);
+                } else if (entry->used && entry->hits > 0) {
+                    nevs_queue(entry);
                 }
             }
         }
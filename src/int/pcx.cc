@@ -1,6 +1,7 @@
 #include "int/pcx.h"
 
 #include <stdio.h>
+#include <string.h>
 
 #include "int/memdbg.h"
 #include "plib/db/db.h"
@@ -28,10 +29,19 @@ typedef struct PcxHeader {
     unsigned char reserved2[54];
 } PcxHeader;
 
-static short getWord(DB_FILE* stream);
-static void readPcxHeader(PcxHeader* pcxHeader, DB_FILE* stream);
-static int pcxDecodeScanline(unsigned char* data, int size, DB_FILE* stream);
-static int readPcxVgaPalette(PcxHeader* pcxHeader, unsigned char* palette, DB_FILE* stream);
+// CE: Files are read into memory once and decoded from there, rather than
+// via `db_fgetc` for every byte.
+typedef struct PcxReader {
+    const unsigned char* data;
+    int size;
+    int pos;
+} PcxReader;
+
+static int pcxGetByte(PcxReader* reader);
+static short getWord(PcxReader* reader);
+static void readPcxHeader(PcxHeader* pcxHeader, PcxReader* reader);
+static int pcxDecodeScanline(unsigned char* data, int size, PcxReader* reader);
+static int readPcxVgaPalette(PcxHeader* pcxHeader, unsigned char* palette, PcxReader* reader);
 
 // 0x506320
 static unsigned char runcount = 0;
@@ -39,46 +49,61 @@ static unsigned char runcount = 0;
 // 0x506321
 static unsigned char runvalue = 0;
 
+// CE: Mirrors `db_fgetc` (returns -1 past the end of data).
+static int pcxGetByte(PcxReader* reader)
+{
+    if (reader->pos >= reader->size) {
+        return -1;
+    }
+
+    return reader->data[reader->pos++];
+}
+
 // 0x486160
-static short getWord(DB_FILE* stream)
+static short getWord(PcxReader* reader)
 {
-    short value;
-    db_fread(&value, sizeof(value), 1, stream);
+    if (reader->size - reader->pos < 2) {
+        reader->pos = reader->size;
+        return 0;
+    }
+
+    short value = (short)(reader->data[reader->pos] | (reader->data[reader->pos + 1] << 8));
+    reader->pos += 2;
     return value;
 }
 
 // 0x486184
-static void readPcxHeader(PcxHeader* pcxHeader, DB_FILE* stream)
+static void readPcxHeader(PcxHeader* pcxHeader, PcxReader* reader)
 {
-    pcxHeader->identifier = db_fgetc(stream);
-    pcxHeader->version = db_fgetc(stream);
-    pcxHeader->encoding = db_fgetc(stream);
-    pcxHeader->bitsPerPixel = db_fgetc(stream);
-    pcxHeader->minX = getWord(stream);
-    pcxHeader->minY = getWord(stream);
-    pcxHeader->maxX = getWord(stream);
-    pcxHeader->maxY = getWord(stream);
-    pcxHeader->horizontalResolution = getWord(stream);
-    pcxHeader->verticalResolution = getWord(stream);
+    pcxHeader->identifier = pcxGetByte(reader);
+    pcxHeader->version = pcxGetByte(reader);
+    pcxHeader->encoding = pcxGetByte(reader);
+    pcxHeader->bitsPerPixel = pcxGetByte(reader);
+    pcxHeader->minX = getWord(reader);
+    pcxHeader->minY = getWord(reader);
+    pcxHeader->maxX = getWord(reader);
+    pcxHeader->maxY = getWord(reader);
+    pcxHeader->horizontalResolution = getWord(reader);
+    pcxHeader->verticalResolution = getWord(reader);
 
     for (int index = 0; index < 48; index++) {
-        pcxHeader->palette[index] = db_fgetc(stream);
+        pcxHeader->palette[index] = pcxGetByte(reader);
     }
 
-    pcxHeader->reserved1 = db_fgetc(stream);
-    pcxHeader->planeCount = db_fgetc(stream);
-    pcxHeader->bytesPerLine = getWord(stream);
-    pcxHeader->paletteType = getWord(stream);
-    pcxHeader->horizontalScreenSize = getWord(stream);
-    pcxHeader->verticalScreenSize = getWord(stream);
+    pcxHeader->reserved1 = pcxGetByte(reader);
+    pcxHeader->planeCount = pcxGetByte(reader);
+    pcxHeader->bytesPerLine = getWord(reader);
+    pcxHeader->paletteType = getWord(reader);
+    pcxHeader->horizontalScreenSize = getWord(reader);
+    pcxHeader->verticalScreenSize = getWord(reader);
 
     for (int index = 0; index < 54; index++) {
-        pcxHeader->reserved2[index] = db_fgetc(stream);
+        pcxHeader->reserved2[index] = pcxGetByte(reader);
     }
 }
 
 // 0x48631C
-static int pcxDecodeScanline(unsigned char* data, int size, DB_FILE* stream)
+static int pcxDecodeScanline(unsigned char* data, int size, PcxReader* reader)
 {
     unsigned char runLength = runcount;
     unsigned char value = runvalue;
@@ -101,10 +126,10 @@ static int pcxDecodeScanline(unsigned char* data, int size, DB_FILE* stream)
             break;
         }
 
-        value = db_fgetc(stream);
+        value = pcxGetByte(reader);
         if ((value & 0xC0) == 0xC0) {
             runcount = value & 0x3F;
-            value = db_fgetc(stream);
+            value = pcxGetByte(reader);
             runLength = runcount;
         } else {
             runLength = 1;
@@ -118,25 +143,17 @@ static int pcxDecodeScanline(unsigned char* data, int size, DB_FILE* stream)
 }
 
 // 0x4863CC
-static int readPcxVgaPalette(PcxHeader* pcxHeader, unsigned char* palette, DB_FILE* stream)
+static int readPcxVgaPalette(PcxHeader* pcxHeader, unsigned char* palette, PcxReader* reader)
 {
     if (pcxHeader->version != 5) {
         return 0;
     }
 
-    long pos = db_ftell(stream);
-    long size = db_filelength(stream);
-    db_fseek(stream, size - 769, SEEK_SET);
-    if (db_fgetc(stream) != 12) {
-        db_fseek(stream, pos, SEEK_SET);
+    if (reader->size < 769 || reader->data[reader->size - 769] != 12) {
         return 0;
     }
 
-    for (int index = 0; index < 768; index++) {
-        palette[index] = db_fgetc(stream);
-    }
-
-    db_fseek(stream, pos, SEEK_SET);
+    memcpy(palette, reader->data + reader->size - 768, 768);
 
     return 1;
 }
@@ -149,8 +166,35 @@ unsigned char* loadPCX(const char* path, int* widthPtr, int* heightPtr, unsigned
         return NULL;
     }
 
+    int size = db_filelength(stream);
+    unsigned char* buffer = (unsigned char*)mymalloc(size > 0 ? size : 1, __FILE__, __LINE__);
+    if (buffer == NULL) {
+        db_fclose(stream);
+        return NULL;
+    }
+
+    size = (int)db_fread(buffer, 1, size, stream);
+    db_fclose(stream);
+
+    unsigned char* data = loadPCXFromBuffer(buffer, size, widthPtr, heightPtr, palette, NULL);
+
+    myfree(buffer, __FILE__, __LINE__);
+
+    return data;
+}
+
+// CE: Decodes PCX file already read into `buffer`. `paletteLoadedPtr` (if
+// given) receives whether `palette` was overwritten with palette from the
+// file, which only happens for version 5 files with VGA palette.
+unsigned char* loadPCXFromBuffer(const unsigned char* buffer, int size, int* widthPtr, int* heightPtr, unsigned char* palette, bool* paletteLoadedPtr)
+{
+    PcxReader reader;
+    reader.data = buffer;
+    reader.size = size;
+    reader.pos = 0;
+
     PcxHeader pcxHeader;
-    readPcxHeader(&pcxHeader, stream);
+    readPcxHeader(&pcxHeader, &reader);
 
     int width = pcxHeader.maxX - pcxHeader.minX + 1;
     int height = pcxHeader.maxY - pcxHeader.minY + 1;
@@ -159,10 +203,17 @@ unsigned char* loadPCX(const char* path, int* widthPtr, int* heightPtr, unsigned
     *heightPtr = height;
 
     int bytesPerLine = pcxHeader.planeCount * pcxHeader.bytesPerLine;
-    unsigned char* data = (unsigned char*)mymalloc(bytesPerLine * height, __FILE__, __LINE__); // "..\\int\\PCX.C", 195
+
+    // CE: Rows are `width` bytes apart, make sure the image fits even if
+    // `bytesPerLine` is smaller than `width`.
+    int allocSize = bytesPerLine * height;
+    if (allocSize < width * height) {
+        allocSize = width * height;
+    }
+
+    unsigned char* data = (unsigned char*)mymalloc(allocSize, __FILE__, __LINE__); // "..\\int\\PCX.C", 195
     if (data == NULL) {
         // NOTE: This code is unreachable, internal_malloc_safe never fails.
-        db_fclose(stream);
         return NULL;
     }
 
@@ -171,13 +222,14 @@ unsigned char* loadPCX(const char* path, int* widthPtr, int* heightPtr, unsigned
 
     unsigned char* ptr = data;
     for (int y = 0; y < height; y++) {
-        pcxDecodeScanline(ptr, bytesPerLine, stream);
+        pcxDecodeScanline(ptr, bytesPerLine, &reader);
         ptr += width;
     }
 
-    readPcxVgaPalette(&pcxHeader, palette, stream);
-
-    db_fclose(stream);
+    int paletteLoaded = readPcxVgaPalette(&pcxHeader, palette, &reader);
+    if (paletteLoadedPtr != NULL) {
+        *paletteLoadedPtr = paletteLoaded != 0;
+    }
 
     return data;
 }
@@ -4,6 +4,7 @@
 namespace fallout {
 
 unsigned char* loadPCX(const char* path, int* widthPtr, int* heightPtr, unsigned char* palette);
+unsigned char* loadPCXFromBuffer(const unsigned char* buffer, int size, int* widthPtr, int* heightPtr, unsigned char* palette, bool* paletteLoadedPtr);
 
 } // namespace fallout
 
@@ -1,5 +1,6 @@
 #include "int/sound.h"
 
+#include <limits.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -11,6 +12,7 @@
 #endif
 
 #include <algorithm>
+#include <atomic>
 
 #include <SDL.h>
 
@@ -18,10 +20,26 @@
 #include "platform_compat.h"
 #include "plib/gnw/debug.h"
 #include "plib/gnw/memory.h"
+#include "plib/gnw/prof.h"
 #include "plib/gnw/winmain.h"
 
 namespace fallout {
 
+// Interval between volume steps of original timer driven fades (in ms).
+#define SOUND_FADE_INTERVAL 40
+
+// CE: How long completion of non-streamed sounds can go unnoticed (in ms).
+#define SOUND_DONE_POLL_DELAY 100
+
+// CE: Maximum number of buffers decode worker keeps ahead of a streaming
+// sound.
+#define SOUND_DECODE_AHEAD_MAX 16
+
+// CE: How often decode worker rechecks rings while streaming sounds exist
+// (in ms). Main thread does not take the lock to wake the worker when it
+// consumes data, so a wakeup can be missed.
+#define SOUND_DECODE_POLL_DELAY 10
+
 typedef enum SoundStatusFlags {
     SOUND_STATUS_DONE = 0x01,
     SOUND_STATUS_IS_PLAYING = 0x02,
@@ -29,17 +47,42 @@ typedef enum SoundStatusFlags {
     SOUND_STATUS_IS_PAUSED = 0x08,
 } SoundStatusFlags;
 
+// CE: Volume steps are replaced with envelope evaluated by the mixer, game
+// thread only finishes fades the mixer has completed (see `fadeSounds`).
 typedef struct FadeSound {
     Sound* sound;
-    int deltaVolume;
     int targetVolume;
     int initialVolume;
-    int currentVolume;
+
+    // CE: Time (in ms) when envelope reaches target volume.
+    unsigned int endTime;
+
     int field_14;
     struct FadeSound* prev;
     struct FadeSound* next;
 } FadeSound;
 
+// CE: Data of a streaming sound read ahead by decode worker.
+//
+// Ring has single producer (decode worker) and single consumer (main
+// thread), cursors are free running byte counts. Everything else, including
+// file handle of the sound, is protected by `soundDecodeMutex`.
+typedef struct SoundDecodeAhead {
+    Sound* sound;
+    unsigned char* ring;
+    unsigned int capacity;
+    std::atomic<unsigned int> readPos;
+    std::atomic<unsigned int> writePos;
+
+    // Scratch buffer decode worker reads into (one `dataSize` chunk).
+    unsigned char* chunk;
+
+    // Set when file is exhausted, cleared on seek.
+    bool eof;
+
+    struct SoundDecodeAhead* next;
+} SoundDecodeAhead;
+
 static void* defaultMalloc(size_t size);
 static void* defaultRealloc(void* ptr, size_t size);
 static void defaultFree(void* ptr);
@@ -54,11 +97,24 @@ static char* defaultMangler(char* fname);
 static void refreshSoundBuffers(Sound* sound);
 static int preloadBuffers(Sound* sound);
 static int addSoundData(Sound* sound, unsigned char* buf, int size);
-static Uint32 doTimerEvent(Uint32 interval, void* param);
-static void removeTimedEvent(SDL_TimerID* timerId);
+static FadeSound* findFadeSound(Sound* sound);
+static void applyFadeSound(FadeSound* fadeSound);
 static void removeFadeSound(FadeSound* fadeSound);
 static void fadeSounds();
 static int internalSoundFade(Sound* sound, int duration, int targetVolume, int a4);
+static int soundDecodeInit();
+static void soundDecodeExit();
+static int soundDecodeThread(void* data);
+static bool soundDecodeFill(SoundDecodeAhead* decode);
+static void soundDecodeRemove(Sound* sound);
+static void soundDecodeLock();
+static void soundDecodeUnlock();
+static int soundIoOpen(Sound* sound, const char* filePath, int flags);
+static void soundIoClose(Sound* sound);
+static int soundIoRead(Sound* sound, void* buf, unsigned int size);
+static long soundIoSeek(Sound* sound, long offset, int origin);
+static long soundIoTell(Sound* sound);
+static long soundIoFileLength(Sound* sound);
 
 // 0x507E04
 static FadeSound* fadeHead = NULL;
@@ -159,7 +215,24 @@ static bool driverInit;
 // 0x6651C4
 static Sound* soundMgrList;
 
-static SDL_TimerID gFadeSoundsTimerId = 0;
+// CE: Number of buffers decode worker keeps ahead of streaming sounds (0 -
+// decode on main thread).
+static int soundDecodeAheadBuffers = 0;
+
+// CE: Decode worker state, see `SoundDecodeAhead`.
+static SDL_Thread* soundDecodeWorker = NULL;
+static SDL_mutex* soundDecodeMutex = NULL;
+
+// Signalled when decode worker has something to do (ring space freed, sound
+// loaded or rewound, quit requested).
+static SDL_cond* soundDecodeCond = NULL;
+
+static SoundDecodeAhead* soundDecodeList = NULL;
+static bool soundDecodeQuit = false;
+
+// CE: Worker was stopped by `soundDecodeSuspend`, it is started again by
+// `soundDecodeResume` or on first read of a sound read ahead.
+static bool soundDecodeSuspended = false;
 
 // 0x499C80
 static void* defaultMalloc(size_t size)
@@ -346,13 +419,13 @@ static void refreshSoundBuffers(Sound* sound)
         } else {
             int bytesToRead = sound->dataSize;
             if (sound->field_58 != -1) {
-                int pos = sound->io.tell(sound->io.fd);
+                int pos = soundIoTell(sound);
                 if (bytesToRead + pos > sound->field_58) {
                     bytesToRead = sound->field_58 - pos;
                 }
             }
 
-            bytesRead = sound->io.read(sound->io.fd, sound->data, bytesToRead);
+            bytesRead = soundIoRead(sound, sound->data, bytesToRead);
             if (bytesRead < sound->dataSize) {
                 if (!(sound->soundFlags & 0x20) || (sound->soundFlags & 0x0100)) {
                     memset(sound->data + bytesRead, 0, sound->dataSize - bytesRead);
@@ -361,7 +434,7 @@ static void refreshSoundBuffers(Sound* sound)
                 } else {
                     while (bytesRead < sound->dataSize) {
                         if (sound->loops == -1) {
-                            sound->io.seek(sound->io.fd, sound->field_54, SEEK_SET);
+                            soundIoSeek(sound, sound->field_54, SEEK_SET);
                             if (sound->callback != NULL) {
                                 sound->callback(sound->callbackUserData, 0x0400);
                             }
@@ -371,12 +444,12 @@ static void refreshSoundBuffers(Sound* sound)
                                 sound->field_54 = 0;
                                 sound->loops = 0;
                                 sound->soundFlags &= ~0x20;
-                                bytesRead += sound->io.read(sound->io.fd, sound->data + bytesRead, sound->dataSize - bytesRead);
+                                bytesRead += soundIoRead(sound, sound->data + bytesRead, sound->dataSize - bytesRead);
                                 break;
                             }
 
                             sound->loops--;
-                            sound->io.seek(sound->io.fd, sound->field_54, SEEK_SET);
+                            soundIoSeek(sound, sound->field_54, SEEK_SET);
 
                             if (sound->callback != NULL) {
                                 sound->callback(sound->callbackUserData, 0x400);
@@ -386,7 +459,7 @@ static void refreshSoundBuffers(Sound* sound)
                         if (sound->field_58 == -1) {
                             bytesToRead = sound->dataSize - bytesRead;
                         } else {
-                            int pos = sound->io.tell(sound->io.fd);
+                            int pos = soundIoTell(sound);
                             if (sound->dataSize + bytesRead + pos <= sound->field_58) {
                                 bytesToRead = sound->dataSize - bytesRead;
                             } else {
@@ -394,7 +467,7 @@ static void refreshSoundBuffers(Sound* sound)
                             }
                         }
 
-                        int v20 = sound->io.read(sound->io.fd, sound->data + bytesRead, bytesToRead);
+                        int v20 = soundIoRead(sound, sound->data + bytesRead, bytesToRead);
                         bytesRead += v20;
                         if (v20 < bytesToRead) {
                             break;
@@ -461,16 +534,15 @@ void soundClose()
         soundMgrList = next;
     }
 
-    if (gFadeSoundsTimerId != -1) {
-        removeTimedEvent(&gFadeSoundsTimerId);
-    }
-
     while (fadeFreeList != NULL) {
         FadeSound* next = fadeFreeList->next;
         freePtr(fadeFreeList);
         fadeFreeList = next;
     }
 
+    soundDecodeExit();
+    soundDecodeAheadBuffers = 0;
+
     audioEngineExit();
 
     soundErrorno = SOUND_NO_ERROR;
@@ -538,7 +610,7 @@ static int preloadBuffers(Sound* sound)
     unsigned char* v14;
     int size;
 
-    size = sound->io.filelength(sound->io.fd);
+    size = soundIoFileLength(sound);
     sound->fileSize = size;
 
     if ((sound->type & SOUND_TYPE_STREAMING) != 0) {
@@ -559,7 +631,7 @@ static int preloadBuffers(Sound* sound)
     }
 
     buf = (unsigned char*)mallocPtr(size);
-    bytes_read = sound->io.read(sound->io.fd, buf, size);
+    bytes_read = soundIoRead(sound, buf, size);
     if (bytes_read != size) {
         if ((sound->soundFlags & SOUND_LOOPING) == 0 || (sound->soundFlags & SOUND_FLAG_0x100) != 0) {
             memset(buf + bytes_read, 0, size - bytes_read);
@@ -582,8 +654,7 @@ static int preloadBuffers(Sound* sound)
     freePtr(buf);
 
     if ((sound->type & SOUND_TYPE_MEMORY) != 0) {
-        sound->io.close(sound->io.fd);
-        sound->io.fd = -1;
+        soundIoClose(sound);
     } else {
         if (sound->data == NULL) {
             sound->data = (unsigned char*)mallocPtr(sound->dataSize);
@@ -606,8 +677,7 @@ int soundLoad(Sound* sound, char* filePath)
         return soundErrorno;
     }
 
-    sound->io.fd = sound->io.open(nameMangler(filePath), 0x0200);
-    if (sound->io.fd == -1) {
+    if (soundIoOpen(sound, nameMangler(filePath), 0x0200) == -1) {
         soundErrorno = SOUND_FILE_NOT_FOUND;
         return soundErrorno;
     }
@@ -631,7 +701,7 @@ int soundRewind(Sound* sound)
     }
 
     if ((sound->type & SOUND_TYPE_STREAMING) != 0) {
-        sound->io.seek(sound->io.fd, 0, SEEK_SET);
+        soundIoSeek(sound, 0, SEEK_SET);
         sound->lastUpdate = 0;
         sound->lastPosition = 0;
         sound->numBytesRead = 0;
@@ -794,9 +864,11 @@ int soundDelete(Sound* sample)
         return soundErrorno;
     }
 
+    // CE: Detach from decode worker before file is closed.
+    soundDecodeRemove(sample);
+
     if (sample->io.fd != -1) {
-        sample->io.close(sample->io.fd);
-        sample->io.fd = -1;
+        soundIoClose(sample);
     }
 
     soundMgrDelete(sample);
@@ -1070,6 +1142,18 @@ int soundVolume(Sound* sound, int volume)
         return soundErrorno;
     }
 
+    // CE: Fade keeps going to its target (at new master volume), `volume` is
+    // applied when fade is paused.
+    if ((sound->statusFlags & SOUND_STATUS_IS_FADING) != 0) {
+        FadeSound* fadeSound = findFadeSound(sound);
+        if (fadeSound != NULL) {
+            applyFadeSound(fadeSound);
+
+            soundErrorno = SOUND_NO_ERROR;
+            return soundErrorno;
+        }
+    }
+
     normalizedVolume = soundVolumeHMItoDirectSound(masterVol * volume / VOLUME_MAX);
 
     hr = audioEngineSoundBufferSetVolume(sound->soundBuffer, normalizedVolume);
@@ -1318,6 +1402,8 @@ void soundMgrDelete(Sound* sound)
         sound->soundBuffer = -1;
     }
 
+    soundDecodeRemove(sound);
+
     if (sound->deleteCallback != NULL) {
         sound->deleteCallback(sound->deleteUserData);
     }
@@ -1362,28 +1448,6 @@ int soundSetMasterVolume(int volume)
     return soundErrorno;
 }
 
-// 0x49BB48
-static Uint32 doTimerEvent(Uint32 interval, void* param)
-{
-    void (*fn)();
-
-    if (param != NULL) {
-        fn = (void (*)())param;
-        fn();
-    }
-
-    return 40;
-}
-
-// 0x49BB94
-static void removeTimedEvent(SDL_TimerID* timerId)
-{
-    if (*timerId != 0) {
-        SDL_RemoveTimer(*timerId);
-        *timerId = 0;
-    }
-}
-
 // 0x49BBB4
 int soundGetPosition(Sound* sound)
 {
@@ -1435,12 +1499,12 @@ int soundSetPosition(Sound* sound, int pos)
 
         audioEngineSoundBufferSetCurrentPosition(sound->soundBuffer, section * sound->dataSize + pos % sound->dataSize);
 
-        sound->io.seek(sound->io.fd, section * sound->dataSize, SEEK_SET);
-        int bytes_read = sound->io.read(sound->io.fd, sound->data, sound->dataSize);
+        soundIoSeek(sound, section * sound->dataSize, SEEK_SET);
+        int bytes_read = soundIoRead(sound, sound->data, sound->dataSize);
         if (bytes_read < sound->dataSize) {
             if (sound->type & 0x02) {
-                sound->io.seek(sound->io.fd, 0, SEEK_SET);
-                sound->io.read(sound->io.fd, sound->data + bytes_read, sound->dataSize - bytes_read);
+                soundIoSeek(sound, 0, SEEK_SET);
+                soundIoRead(sound, sound->data + bytes_read, sound->dataSize - bytes_read);
             } else {
                 memset(sound->data + bytes_read, 0, sound->dataSize - bytes_read);
             }
@@ -1503,44 +1567,79 @@ static void removeFadeSound(FadeSound* fadeSound)
     fadeSound->next = tmp;
 }
 
+// CE: Finishes fades completed by the mixer (or which can no longer
+// complete since sound has stopped). Called from `soundUpdate`.
+//
 // 0x49BE2C
 static void fadeSounds()
 {
-    FadeSound* ptr;
-
-    ptr = fadeHead;
+    FadeSound* ptr = fadeHead;
     while (ptr != NULL) {
-        if ((ptr->currentVolume > ptr->targetVolume || ptr->currentVolume + ptr->deltaVolume < ptr->targetVolume) && (ptr->currentVolume < ptr->targetVolume || ptr->currentVolume + ptr->deltaVolume > ptr->targetVolume)) {
-            ptr->currentVolume += ptr->deltaVolume;
-            soundVolume(ptr->sound, ptr->currentVolume);
-        } else {
-            if (ptr->targetVolume == 0) {
-                if (ptr->field_14) {
-                    soundPause(ptr->sound);
-                    soundVolume(ptr->sound, ptr->initialVolume);
-                } else {
-                    if (ptr->sound->type & 0x04) {
-                        soundDelete(ptr->sound);
-                    } else {
-                        soundStop(ptr->sound);
+        FadeSound* next = ptr->next;
+        Sound* sound = ptr->sound;
 
-                        ptr->initialVolume = ptr->targetVolume;
-                        ptr->currentVolume = ptr->targetVolume;
-                        ptr->deltaVolume = 0;
+        unsigned int status = 0;
+        if (sound->soundBuffer != -1) {
+            audioEngineSoundBufferGetStatus(sound->soundBuffer, &status);
+        }
 
-                        soundVolume(ptr->sound, ptr->targetVolume);
-                    }
+        if ((status & AUDIO_ENGINE_SOUND_BUFFER_STATUS_PLAYING) != 0 && audioEngineSoundBufferIsFading(sound->soundBuffer)) {
+            ptr = next;
+            continue;
+        }
+
+        int targetVolume = ptr->targetVolume;
+        int initialVolume = ptr->initialVolume;
+        int pause = ptr->field_14;
+
+        removeFadeSound(ptr);
+
+        if (targetVolume == 0) {
+            if (pause) {
+                soundPause(sound);
+                soundVolume(sound, initialVolume);
+            } else {
+                if (sound->type & 0x04) {
+                    soundDelete(sound);
+                } else {
+                    soundStop(sound);
+                    soundVolume(sound, targetVolume);
                 }
             }
+        } else {
+            soundVolume(sound, targetVolume);
+        }
 
-            removeFadeSound(ptr);
+        ptr = next;
+    }
+}
+
+static FadeSound* findFadeSound(Sound* sound)
+{
+    FadeSound* curr = fadeHead;
+    while (curr != NULL) {
+        if (curr->sound == sound) {
+            break;
         }
+
+        curr = curr->next;
     }
 
-    if (fadeHead == NULL) {
-        // NOTE: Uninline.
-        removeTimedEvent(&gFadeSoundsTimerId);
+    return curr;
+}
+
+// Starts envelope to fade target over the remaining fade time.
+static void applyFadeSound(FadeSound* fadeSound)
+{
+    Sound* sound = fadeSound->sound;
+    if (sound->soundBuffer == -1) {
+        return;
     }
+
+    unsigned int now = SDL_GetTicks();
+    unsigned int remaining = (int)(fadeSound->endTime - now) > 0 ? fadeSound->endTime - now : 0;
+
+    audioEngineSoundBufferFade(sound->soundBuffer, soundVolumeHMItoDirectSound(masterVol * fadeSound->targetVolume / VOLUME_MAX), remaining);
 }
 
 // 0x49BF04
@@ -1597,10 +1696,11 @@ static int internalSoundFade(Sound* sound, int duration, int targetVolume, int a
 
     ptr->targetVolume = targetVolume;
     ptr->initialVolume = soundGetVolume(sound);
-    ptr->currentVolume = ptr->initialVolume;
     ptr->field_14 = a4;
-    // TODO: Check.
-    ptr->deltaVolume = 8 * (125 * (targetVolume - ptr->initialVolume)) / (40 * duration);
+
+    // CE: Original stepped volume every 40 ms by 1000 / (40 * duration) of
+    // the distance, so fades last 1.6 times `duration` ms.
+    ptr->endTime = SDL_GetTicks() + duration * SOUND_FADE_INTERVAL * SOUND_FADE_INTERVAL / 1000;
 
     sound->statusFlags |= SOUND_STATUS_IS_FADING;
 
@@ -1617,19 +1717,11 @@ static int internalSoundFade(Sound* sound, int duration, int targetVolume, int a
         shouldPlay = true;
     }
 
+    // NOTE: Playing applies envelope as well (through `soundVolume`).
     if (shouldPlay) {
         soundPlay(sound);
-    }
-
-    if (gFadeSoundsTimerId != 0) {
-        soundErrorno = SOUND_NO_ERROR;
-        return soundErrorno;
-    }
-
-    gFadeSoundsTimerId = SDL_AddTimer(40, doTimerEvent, (void*)fadeSounds);
-    if (gFadeSoundsTimerId == 0) {
-        soundErrorno = SOUND_UNKNOWN_ERROR;
-        return soundErrorno;
+    } else {
+        applyFadeSound(ptr);
     }
 
     soundErrorno = SOUND_NO_ERROR;
@@ -1653,6 +1745,11 @@ void soundFlushAllSounds()
 // 0x49C15C
 void soundUpdate()
 {
+    // CE: Fades used to be finished by timer thread.
+    if (fadeHead != NULL) {
+        fadeSounds();
+    }
+
     Sound* curr = soundMgrList;
     while (curr != NULL) {
         // Sound can be deallocated in `soundContinue`.
@@ -1662,6 +1759,46 @@ void soundUpdate()
     }
 }
 
+// CE: Returns number of milliseconds `soundUpdate` can be postponed. Streamed
+// sounds need to be refilled before their buffers run dry, completion of
+// other sounds (and fades) is reported to callbacks from `soundUpdate` too.
+unsigned int soundUpdateDelay()
+{
+    unsigned int delay = UINT_MAX;
+
+    // Fades are finished once their envelope ends, overdue ones (mixer is
+    // late or paused) are rechecked periodically.
+    unsigned int now = SDL_GetTicks();
+    for (FadeSound* curr = fadeHead; curr != NULL; curr = curr->next) {
+        unsigned int fadeDelay = (int)(curr->endTime - now) > 0 ? curr->endTime - now : SOUND_FADE_INTERVAL;
+        if (fadeDelay < delay) {
+            delay = fadeDelay;
+        }
+    }
+
+    for (Sound* curr = soundMgrList; curr != NULL; curr = curr->next) {
+        if ((curr->statusFlags & SOUND_STATUS_IS_PLAYING) == 0
+            || (curr->statusFlags & (SOUND_STATUS_IS_PAUSED | SOUND_STATUS_DONE)) != 0) {
+            continue;
+        }
+
+        unsigned int soundDelay = SOUND_DONE_POLL_DELAY;
+        if ((curr->type & SOUND_TYPE_STREAMING) != 0) {
+            // Refill once per buffer played.
+            unsigned int bytesPerSecond = curr->rate * curr->channels * (curr->bitsPerSample / 8);
+            if (bytesPerSecond != 0) {
+                soundDelay = (unsigned int)((unsigned long long)curr->dataSize * 1000 / bytesPerSecond);
+            }
+        }
+
+        if (soundDelay < delay) {
+            delay = soundDelay;
+        }
+    }
+
+    return delay;
+}
+
 // 0x49C17C
 int soundSetDefaultFileIO(SoundOpenProc* openProc, SoundCloseProc* closeProc, SoundReadProc* readProc, SoundWriteProc* writeProc, SoundSeekProc* seekProc, SoundTellProc* tellProc, SoundFileLengthProc* fileLengthProc)
 {
@@ -1697,4 +1834,407 @@ int soundSetDefaultFileIO(SoundOpenProc* openProc, SoundCloseProc* closeProc, So
     return soundErrorno;
 }
 
+// CE: Sets number of buffers decode worker keeps ahead of streaming sounds
+// enabled with `soundEnableDecodeAhead` (0 disables worker for sounds enabled
+// afterwards). Worker is started on first use and stopped in `soundClose`.
+int soundSetDecodeAhead(int buffers)
+{
+    if (!driverInit) {
+        soundErrorno = SOUND_NOT_INITIALIZED;
+        return soundErrorno;
+    }
+
+    buffers = std::clamp(buffers, 0, SOUND_DECODE_AHEAD_MAX);
+
+    if (buffers != 0 && soundDecodeSuspended) {
+        soundDecodeResume();
+    }
+
+    if (buffers != 0 && soundDecodeWorker == NULL) {
+        if (soundDecodeMutex != NULL || soundDecodeInit() != 0) {
+            debug_printf("soundSetDecodeAhead: Unable to start decode worker\n");
+            buffers = 0;
+        }
+    }
+
+    soundDecodeAheadBuffers = buffers;
+
+    soundErrorno = SOUND_NO_ERROR;
+    return soundErrorno;
+}
+
+// CE: Moves reading (and decompression) of a streaming sound to decode
+// worker. File IO procs of the sound are then called from worker thread, so
+// they must not touch state used by main thread other than through open and
+// close (which are serialized with the worker). Does nothing when decode
+// worker is disabled or sound is not streamed.
+int soundEnableDecodeAhead(Sound* sound)
+{
+    if (!driverInit) {
+        soundErrorno = SOUND_NOT_INITIALIZED;
+        return soundErrorno;
+    }
+
+    if (sound == NULL) {
+        soundErrorno = SOUND_NO_SOUND;
+        return soundErrorno;
+    }
+
+    if (soundDecodeAheadBuffers == 0 || (sound->type & SOUND_TYPE_STREAMING) == 0 || sound->decodeAhead != NULL) {
+        soundErrorno = SOUND_NO_ERROR;
+        return soundErrorno;
+    }
+
+    SoundDecodeAhead* decode = new SoundDecodeAhead();
+    decode->sound = sound;
+    decode->capacity = soundDecodeAheadBuffers * sound->dataSize;
+    decode->ring = (unsigned char*)mallocPtr(decode->capacity);
+    decode->chunk = (unsigned char*)mallocPtr(sound->dataSize);
+    if (decode->ring == NULL || decode->chunk == NULL) {
+        if (decode->ring != NULL) {
+            freePtr(decode->ring);
+        }
+
+        if (decode->chunk != NULL) {
+            freePtr(decode->chunk);
+        }
+
+        delete decode;
+
+        soundErrorno = SOUND_NO_MEMORY_AVAILABLE;
+        return soundErrorno;
+    }
+
+    SDL_LockMutex(soundDecodeMutex);
+    sound->decodeAhead = decode;
+    decode->next = soundDecodeList;
+    soundDecodeList = decode;
+    SDL_CondSignal(soundDecodeCond);
+    SDL_UnlockMutex(soundDecodeMutex);
+
+    soundErrorno = SOUND_NO_ERROR;
+    return soundErrorno;
+}
+
+static int soundDecodeInit()
+{
+    soundDecodeMutex = SDL_CreateMutex();
+    if (soundDecodeMutex == NULL) {
+        return -1;
+    }
+
+    soundDecodeCond = SDL_CreateCond();
+    if (soundDecodeCond == NULL) {
+        SDL_DestroyMutex(soundDecodeMutex);
+        soundDecodeMutex = NULL;
+        return -1;
+    }
+
+    soundDecodeQuit = false;
+
+    soundDecodeWorker = SDL_CreateThread(soundDecodeThread, "sound_decode", NULL);
+    if (soundDecodeWorker == NULL) {
+        SDL_DestroyCond(soundDecodeCond);
+        SDL_DestroyMutex(soundDecodeMutex);
+        soundDecodeCond = NULL;
+        soundDecodeMutex = NULL;
+        return -1;
+    }
+
+    return 0;
+}
+
+// NOTE: Expects all sounds to be deleted.
+static void soundDecodeExit()
+{
+    if (soundDecodeMutex == NULL) {
+        return;
+    }
+
+    soundDecodeSuspend();
+    soundDecodeSuspended = false;
+
+    SDL_DestroyCond(soundDecodeCond);
+    soundDecodeCond = NULL;
+
+    SDL_DestroyMutex(soundDecodeMutex);
+    soundDecodeMutex = NULL;
+}
+
+// CE: Stops decode worker (for example before process is forked). Data
+// already read ahead stays in rings, the rest is read on main thread until
+// worker is started again.
+void soundDecodeSuspend()
+{
+    if (soundDecodeWorker == NULL) {
+        return;
+    }
+
+    SDL_LockMutex(soundDecodeMutex);
+    soundDecodeQuit = true;
+    SDL_CondSignal(soundDecodeCond);
+    SDL_UnlockMutex(soundDecodeMutex);
+
+    SDL_WaitThread(soundDecodeWorker, NULL);
+    soundDecodeWorker = NULL;
+    soundDecodeSuspended = true;
+}
+
+void soundDecodeResume()
+{
+    if (!soundDecodeSuspended) {
+        return;
+    }
+
+    soundDecodeSuspended = false;
+    soundDecodeQuit = false;
+
+    soundDecodeWorker = SDL_CreateThread(soundDecodeThread, "sound_decode", NULL);
+    if (soundDecodeWorker == NULL) {
+        debug_printf("soundDecodeResume: Unable to start decode worker\n");
+    }
+}
+
+static int soundDecodeThread(void* data)
+{
+    SDL_LockMutex(soundDecodeMutex);
+
+    while (!soundDecodeQuit) {
+        bool busy = false;
+        for (SoundDecodeAhead* decode = soundDecodeList; decode != NULL; decode = decode->next) {
+            if (soundDecodeFill(decode)) {
+                busy = true;
+            }
+        }
+
+        if (busy) {
+            // Let main thread in between chunks.
+            SDL_UnlockMutex(soundDecodeMutex);
+            SDL_LockMutex(soundDecodeMutex);
+        } else if (soundDecodeList != NULL) {
+            SDL_CondWaitTimeout(soundDecodeCond, soundDecodeMutex, SOUND_DECODE_POLL_DELAY);
+        } else {
+            SDL_CondWait(soundDecodeCond, soundDecodeMutex);
+        }
+    }
+
+    SDL_UnlockMutex(soundDecodeMutex);
+
+    return 0;
+}
+
+// Reads one chunk of sound into its ring if there is room for it. Returns
+// `true` if anything was read.
+//
+// NOTE: Called from decode worker with `soundDecodeMutex` held.
+static bool soundDecodeFill(SoundDecodeAhead* decode)
+{
+    Sound* sound = decode->sound;
+    if (decode->eof || sound->io.fd == -1) {
+        return false;
+    }
+
+    unsigned int writePos = decode->writePos.load(std::memory_order_relaxed);
+    unsigned int used = writePos - decode->readPos.load(std::memory_order_acquire);
+    if (decode->capacity - used < (unsigned int)sound->dataSize) {
+        return false;
+    }
+
+    ProfScope profScope(PROF_ZONE_SOUND_DECODE_WORKER);
+
+    int bytesRead = sound->io.read(sound->io.fd, decode->chunk, sound->dataSize);
+    if (bytesRead < sound->dataSize) {
+        decode->eof = true;
+    }
+
+    if (bytesRead <= 0) {
+        return false;
+    }
+
+    unsigned int offset = writePos % decode->capacity;
+    unsigned int head = std::min((unsigned int)bytesRead, decode->capacity - offset);
+    memcpy(decode->ring + offset, decode->chunk, head);
+    memcpy(decode->ring, decode->chunk + head, bytesRead - head);
+
+    decode->writePos.store(writePos + bytesRead, std::memory_order_release);
+
+    return true;
+}
+
+static void soundDecodeRemove(Sound* sound)
+{
+    SoundDecodeAhead* decode = sound->decodeAhead;
+    if (decode == NULL) {
+        return;
+    }
+
+    SDL_LockMutex(soundDecodeMutex);
+
+    SoundDecodeAhead** link = &soundDecodeList;
+    while (*link != decode) {
+        link = &((*link)->next);
+    }
+    *link = decode->next;
+
+    sound->decodeAhead = NULL;
+
+    SDL_UnlockMutex(soundDecodeMutex);
+
+    freePtr(decode->ring);
+    freePtr(decode->chunk);
+    delete decode;
+}
+
+static void soundDecodeLock()
+{
+    if (soundDecodeMutex != NULL) {
+        SDL_LockMutex(soundDecodeMutex);
+    }
+}
+
+static void soundDecodeUnlock()
+{
+    if (soundDecodeMutex != NULL) {
+        SDL_UnlockMutex(soundDecodeMutex);
+    }
+}
+
+// CE: Open and close of every sound are serialized with decode worker, since
+// file IO implementations keep shared tables of open files.
+static int soundIoOpen(Sound* sound, const char* filePath, int flags)
+{
+    soundDecodeLock();
+
+    sound->io.fd = sound->io.open(filePath, flags);
+
+    if (sound->decodeAhead != NULL) {
+        SDL_CondSignal(soundDecodeCond);
+    }
+
+    soundDecodeUnlock();
+
+    return sound->io.fd;
+}
+
+static void soundIoClose(Sound* sound)
+{
+    soundDecodeLock();
+
+    sound->io.close(sound->io.fd);
+    sound->io.fd = -1;
+
+    soundDecodeUnlock();
+}
+
+// CE: Takes data read ahead by decode worker first, then reads the rest
+// directly if worker has fallen behind.
+static int soundIoRead(Sound* sound, void* buf, unsigned int size)
+{
+    SoundDecodeAhead* decode = sound->decodeAhead;
+    if (decode == NULL) {
+        return sound->io.read(sound->io.fd, buf, size);
+    }
+
+    if (soundDecodeSuspended) {
+        soundDecodeResume();
+    }
+
+    unsigned char* dest = (unsigned char*)buf;
+    unsigned int total = 0;
+    while (total < size) {
+        unsigned int readPos = decode->readPos.load(std::memory_order_relaxed);
+        unsigned int available = decode->writePos.load(std::memory_order_acquire) - readPos;
+        if (available == 0) {
+            SDL_LockMutex(soundDecodeMutex);
+
+            if (decode->writePos.load(std::memory_order_relaxed) != readPos) {
+                SDL_UnlockMutex(soundDecodeMutex);
+                continue;
+            }
+
+            if (!decode->eof && sound->io.fd != -1) {
+                int bytesRead = sound->io.read(sound->io.fd, dest + total, size - total);
+                if (bytesRead < (int)(size - total)) {
+                    decode->eof = true;
+                }
+
+                if (bytesRead > 0) {
+                    total += bytesRead;
+                }
+            }
+
+            SDL_UnlockMutex(soundDecodeMutex);
+            break;
+        }
+
+        unsigned int bytesToCopy = std::min(available, size - total);
+        unsigned int offset = readPos % decode->capacity;
+        unsigned int head = std::min(bytesToCopy, decode->capacity - offset);
+        memcpy(dest + total, decode->ring + offset, head);
+        memcpy(dest + total + head, decode->ring, bytesToCopy - head);
+
+        decode->readPos.store(readPos + bytesToCopy, std::memory_order_release);
+        total += bytesToCopy;
+    }
+
+    SDL_CondSignal(soundDecodeCond);
+
+    return total;
+}
+
+// CE: Drops data read ahead, file position of decode worker is ahead of the
+// one seen by main thread by the amount of data in the ring.
+static long soundIoSeek(Sound* sound, long offset, int origin)
+{
+    SoundDecodeAhead* decode = sound->decodeAhead;
+    if (decode == NULL) {
+        return sound->io.seek(sound->io.fd, offset, origin);
+    }
+
+    SDL_LockMutex(soundDecodeMutex);
+
+    if (origin == SEEK_CUR) {
+        offset -= (long)(decode->writePos.load(std::memory_order_relaxed) - decode->readPos.load(std::memory_order_relaxed));
+    }
+
+    long pos = sound->io.seek(sound->io.fd, offset, origin);
+
+    decode->readPos.store(0, std::memory_order_relaxed);
+    decode->writePos.store(0, std::memory_order_relaxed);
+    decode->eof = false;
+
+    SDL_CondSignal(soundDecodeCond);
+    SDL_UnlockMutex(soundDecodeMutex);
+
+    return pos;
+}
+
+static long soundIoTell(Sound* sound)
+{
+    SoundDecodeAhead* decode = sound->decodeAhead;
+    if (decode == NULL) {
+        return sound->io.tell(sound->io.fd);
+    }
+
+    SDL_LockMutex(soundDecodeMutex);
+
+    long pos = sound->io.tell(sound->io.fd);
+    if (pos != -1) {
+        pos -= (long)(decode->writePos.load(std::memory_order_relaxed) - decode->readPos.load(std::memory_order_relaxed));
+    }
+
+    SDL_UnlockMutex(soundDecodeMutex);
+
+    return pos;
+}
+
+static long soundIoFileLength(Sound* sound)
+{
+    soundDecodeLock();
+    long size = sound->io.filelength(sound->io.fd);
+    soundDecodeUnlock();
+
+    return size;
+}
+
 } // namespace fallout
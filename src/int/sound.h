@@ -87,6 +87,8 @@ typedef enum SoundFlags {
     SOUND_FLAG_0x200 = 0x200,
 } SoundFlags;
 
+typedef struct SoundDecodeAhead SoundDecodeAhead;
+
 typedef void SoundCallback(void* userData, int a2);
 typedef void SoundDeleteCallback(void* userData);
 
@@ -119,6 +121,10 @@ typedef struct Sound {
     SoundCallback* callback;
     void* deleteUserData;
     SoundDeleteCallback* deleteCallback;
+
+    // CE: Data read ahead by decode worker (see `soundEnableDecodeAhead`).
+    SoundDecodeAhead* decodeAhead;
+
     struct Sound* next;
     struct Sound* prev;
 } Sound;
@@ -160,6 +166,11 @@ int soundSetPosition(Sound* sound, int a2);
 int soundFade(Sound* sound, int duration, int targetVolume);
 void soundFlushAllSounds();
 void soundUpdate();
+unsigned int soundUpdateDelay();
+int soundSetDecodeAhead(int buffers);
+void soundDecodeSuspend();
+void soundDecodeResume();
+int soundEnableDecodeAhead(Sound* sound);
 int soundSetDefaultFileIO(SoundOpenProc* openProc, SoundCloseProc* closeProc, SoundReadProc* readProc, SoundWriteProc* writeProc, SoundSeekProc* seekProc, SoundTellProc* tellProc, SoundFileLengthProc* fileLengthProc);
 
 } // namespace fallout
@@ -1658,6 +1658,7 @@ static void objs_area_turn_on_off(int a1, int a2, int a3, int a4, int enabled)
                     } else {
                         object->flags |= OBJECT_HIDDEN;
                     }
+                    obj_update_blocking(object);
                     rect_min_bound(&rect, &object_bounds, &rect);
                 }
             }
@@ -1722,6 +1723,8 @@ static void op_set_obj_visibility(Program* program)
                 obj->flags |= OBJECT_NO_BLOCK;
             }
 
+            obj_update_blocking(obj);
+
             tile_refresh_rect(&rect, obj->elevation);
         }
     } else {
@@ -1732,6 +1735,8 @@ static void op_set_obj_visibility(Program* program)
 
             obj->flags &= ~OBJECT_HIDDEN;
 
+            obj_update_blocking(obj);
+
             Rect rect;
             obj_bound(obj, &rect);
             tile_refresh_rect(&rect, obj->elevation);
@@ -1929,7 +1934,7 @@ int correctDeath(Object* critter, int anim, bool forceBack)
 {
     if (anim >= ANIM_BIG_HOLE_SF && anim <= ANIM_FALL_FRONT_BLOOD_SF) {
         int violenceLevel = VIOLENCE_LEVEL_MAXIMUM_BLOOD;
-        config_get_value(&game_config, GAME_CONFIG_PREFERENCES_KEY, GAME_CONFIG_VIOLENCE_LEVEL_KEY, &violenceLevel);
+        config_handle_get_value(&game_config_violence_level, &violenceLevel);
 
         bool useStandardDeath = false;
         if (violenceLevel < VIOLENCE_LEVEL_MAXIMUM_BLOOD) {
@@ -2698,7 +2703,8 @@ static void op_float_msg(Program* program)
 
     Rect rect;
     if (text_object_create(obj, string, font, color, a5, &rect) != -1) {
-        tile_refresh_rect(&rect, obj->elevation);
+        // CE: Drawn together with other text objects on next tick.
+        text_object_refresh(&rect);
     }
 }
 
@@ -2853,7 +2859,7 @@ static void op_reg_anim_animate(Program* program)
 
     if (!isInCombat()) {
         int violenceLevel = VIOLENCE_LEVEL_NONE;
-        if (anim != 20 || object == NULL || object->pid != 0x100002F || (config_get_value(&game_config, GAME_CONFIG_PREFERENCES_KEY, GAME_CONFIG_VIOLENCE_LEVEL_KEY, &violenceLevel) && violenceLevel >= 2)) {
+        if (anim != 20 || object == NULL || object->pid != 0x100002F || (config_handle_get_value(&game_config_violence_level, &violenceLevel) && violenceLevel >= 2)) {
             if (object != NULL) {
                 register_object_animate(object, anim, delay);
             } else {
@@ -4141,190 +4147,197 @@ void intExtraClose()
 {
 }
 
+// CE: Exported functions with number of values each takes off the stack.
+static constexpr OpcodeInfo intExtraOpcodes[] = {
+    { 0x80A1, op_give_exp_points, 1 },
+    { 0x80A2, op_scr_return, 1 },
+    { 0x80A3, op_play_sfx, 1 },
+    { 0x80A4, op_obj_name, 1 },
+    { 0x80A5, op_sfx_build_open_name, 2 },
+    { 0x80A6, op_get_pc_stat, 1 },
+    { 0x80A7, op_tile_contains_pid_obj, 3 },
+    { 0x80A8, op_set_map_start, 4 },
+    { 0x80A9, op_override_map_start, 4 },
+    { 0x80AA, op_has_skill, 2 },
+    { 0x80AB, op_using_skill, 2 },
+    { 0x80AC, op_roll_vs_skill, 3 },
+    { 0x80AD, op_skill_contest, 3 },
+    { 0x80AE, op_do_check, 3 },
+    { 0x80AF, op_is_success, 1 },
+    { 0x80B0, op_is_critical, 1 },
+    { 0x80B1, op_how_much, 1 },
+    { 0x80B2, op_reaction_roll, 3 },
+    { 0x80B3, op_reaction_influence, 3 },
+    { 0x80B4, op_random, 2 },
+    { 0x80B5, op_roll_dice, 2 },
+    { 0x80B6, op_move_to, 3 },
+    { 0x80B7, op_create_object_sid, 4 },
+    { 0x80B8, op_display_msg, 1 },
+    { 0x80B9, op_script_overrides, 0 },
+    { 0x80BA, op_obj_is_carrying_obj_pid, 2 },
+    { 0x80BB, op_tile_contains_obj_pid, 3 },
+    { 0x80BC, op_self_obj, 0 },
+    { 0x80BD, op_source_obj, 0 },
+    { 0x80BE, op_target_obj, 0 },
+    { 0x80BF, op_dude_obj, 0 },
+    { 0x80C0, op_obj_being_used_with, 0 },
+    { 0x80C1, op_local_var, 1 },
+    { 0x80C2, op_set_local_var, 2 },
+    { 0x80C3, op_map_var, 1 },
+    { 0x80C4, op_set_map_var, 2 },
+    { 0x80C5, op_global_var, 1 },
+    { 0x80C6, op_set_global_var, 2 },
+    { 0x80C7, op_script_action, 0 },
+    { 0x80C8, op_obj_type, 1 },
+    { 0x80C9, op_obj_item_subtype, 1 },
+    { 0x80CA, op_get_critter_stat, 2 },
+    { 0x80CB, op_set_critter_stat, 3 },
+    { 0x80CC, op_animate_stand_obj, 1 },
+    { 0x80CD, op_animate_stand_reverse_obj, 1 },
+    { 0x80CE, op_animate_move_obj_to_tile, 3 },
+    { 0x80CF, op_animate_jump, 0 },
+    { 0x80D0, op_attack, 8 },
+    { 0x80D1, op_make_daytime, 0 },
+    { 0x80D2, op_tile_distance, 2 },
+    { 0x80D3, op_tile_distance_objs, 2 },
+    { 0x80D4, op_tile_num, 1 },
+    { 0x80D5, op_tile_num_in_direction, 3 },
+    { 0x80D6, op_pickup_obj, 1 },
+    { 0x80D7, op_drop_obj, 1 },
+    { 0x80D8, op_add_obj_to_inven, 2 },
+    { 0x80D9, op_rm_obj_from_inven, 2 },
+    { 0x80DA, op_wield_obj_critter, 2 },
+    { 0x80DB, op_use_obj, 1 },
+    { 0x80DC, op_obj_can_see_obj, 2 },
+    { 0x80DD, op_attack, 8 },
+    { 0x80DE, op_start_gdialog, 5 },
+    { 0x80DF, op_end_dialogue, 0 },
+    { 0x80E0, op_dialogue_reaction, 1 },
+    { 0x80E1, op_turn_off_objs_in_area, 4 },
+    { 0x80E2, op_turn_on_objs_in_area, 4 },
+    { 0x80E3, op_set_obj_visibility, 2 },
+    { 0x80E4, op_load_map, 2 },
+    { 0x80E5, op_barter_offer, 3 },
+    { 0x80E6, op_barter_asking, 3 },
+    { 0x80E7, op_anim_busy, 1 },
+    { 0x80E8, op_critter_heal, 2 },
+    { 0x80E9, op_set_light_level, 1 },
+    { 0x80EA, op_game_time, 0 },
+    { 0x80EB, op_game_time_in_seconds, 0 },
+    { 0x80EC, op_elevation, 1 },
+    { 0x80ED, op_kill_critter, 2 },
+    { 0x80EE, op_kill_critter_type, 2 },
+    { 0x80EF, op_critter_damage, 3 },
+    { 0x80F0, op_add_timer_event, 3 },
+    { 0x80F1, op_rm_timer_event, 1 },
+    { 0x80F2, op_game_ticks, 1 },
+    { 0x80F3, op_has_trait, 3 },
+    { 0x80F4, op_destroy_object, 1 },
+    { 0x80F5, op_obj_can_hear_obj, 2 },
+    { 0x80F6, op_game_time_hour, 0 },
+    { 0x80F7, op_fixed_param, 0 },
+    { 0x80F8, op_tile_is_visible, 1 },
+    { 0x80F9, op_dialogue_system_enter, 0 },
+    { 0x80FA, op_action_being_used, 0 },
+    { 0x80FB, op_critter_state, 1 },
+    { 0x80FC, op_game_time_advance, 1 },
+    { 0x80FD, op_radiation_inc, 2 },
+    { 0x80FE, op_radiation_dec, 2 },
+    { 0x80FF, op_critter_attempt_placement, 3 },
+    { 0x8100, op_obj_pid, 1 },
+    { 0x8101, op_cur_map_index, 0 },
+    { 0x8102, op_critter_add_trait, 4 },
+    { 0x8103, op_critter_rm_trait, 4 },
+    { 0x8104, op_proto_data, 2 },
+    { 0x8105, op_message_str, 2 },
+    { 0x8106, op_critter_inven_obj, 2 },
+    { 0x8107, op_obj_set_light_level, 3 },
+    { 0x8108, op_world_map, 0 },
+    { 0x8109, op_town_map, 0 },
+    { 0x810A, op_float_msg, 2 },
+    { 0x810B, op_metarule, 2 },
+    { 0x810C, op_anim, 3 },
+    { 0x810D, op_obj_carrying_pid_obj, 2 },
+    { 0x810E, op_reg_anim_func, 2 },
+    { 0x810F, op_reg_anim_animate, 3 },
+    { 0x8110, op_reg_anim_animate_reverse, 3 },
+    { 0x8111, op_reg_anim_obj_move_to_obj, 3 },
+    { 0x8112, op_reg_anim_obj_run_to_obj, 3 },
+    { 0x8113, op_reg_anim_obj_move_to_tile, 3 },
+    { 0x8114, op_reg_anim_obj_run_to_tile, 3 },
+    { 0x8115, op_play_gmovie, 1 },
+    { 0x8116, op_add_mult_objs_to_inven, 3 },
+    { 0x8117, op_rm_mult_objs_from_inven, 3 },
+    { 0x8118, op_get_month, 0 },
+    { 0x8119, op_get_day, 0 },
+    { 0x811A, op_explosion, 3 },
+    { 0x811B, op_days_since_visited, 0 },
+    { 0x811C, op_gsay_start, 0 },
+    { 0x811D, op_gsay_end, 0 },
+    { 0x811E, op_gsay_reply, 2 },
+    { 0x811F, op_gsay_option, 4 },
+    { 0x8120, op_gsay_message, 3 },
+    { 0x8121, op_giq_option, 5 },
+    { 0x8122, op_poison, 2 },
+    { 0x8123, op_get_poison, 1 },
+    { 0x8124, op_party_add, 1 },
+    { 0x8125, op_party_remove, 1 },
+    { 0x8126, op_reg_anim_animate_forever, 2 },
+    { 0x8127, op_critter_injure, 2 },
+    { 0x8128, op_combat_is_initialized, 0 },
+    { 0x8129, op_gdialog_barter, 1 },
+    { 0x812A, op_difficulty_level, 0 },
+    { 0x812B, op_running_burning_guy, 0 },
+    { 0x812C, op_inven_unwield, 0 },
+    { 0x812D, op_obj_is_locked, 1 },
+    { 0x812E, op_obj_lock, 1 },
+    { 0x812F, op_obj_unlock, 1 },
+    { 0x8131, op_obj_open, 1 },
+    { 0x8130, op_obj_is_open, 1 },
+    { 0x8132, op_obj_close, 1 },
+    { 0x8133, op_game_ui_disable, 0 },
+    { 0x8134, op_game_ui_enable, 0 },
+    { 0x8135, op_game_ui_is_disabled, 0 },
+    { 0x8136, op_gfade_out, 1 },
+    { 0x8137, op_gfade_in, 1 },
+    { 0x8138, op_item_caps_total, 1 },
+    { 0x8139, op_item_caps_adjust, 2 },
+    { 0x813A, op_anim_action_frame, 2 },
+    { 0x813B, op_reg_anim_play_sfx, 3 },
+    { 0x813C, op_critter_mod_skill, 3 },
+    { 0x813D, op_sfx_build_char_name, 3 },
+    { 0x813E, op_sfx_build_ambient_name, 1 },
+    { 0x813F, op_sfx_build_interface_name, 1 },
+    { 0x8140, op_sfx_build_item_name, 1 },
+    { 0x8141, op_sfx_build_weapon_name, 4 },
+    { 0x8142, op_sfx_build_scenery_name, 3 },
+    { 0x8143, op_attack_setup, 2 },
+    { 0x8144, op_destroy_mult_objs, 2 },
+    { 0x8145, op_use_obj_on_obj, 2 },
+    { 0x8146, op_endgame_slideshow, 0 },
+    { 0x8147, op_move_obj_inven_to_obj, 2 },
+    { 0x8148, op_endgame_movie, 0 },
+    { 0x8149, op_obj_art_fid, 1 },
+    { 0x814A, op_art_anim, 1 },
+    { 0x814B, op_party_member_obj, 1 },
+    { 0x814C, op_rotation_to_tile, 2 },
+    { 0x814D, op_jam_lock, 1 },
+    { 0x814E, op_gdialog_set_barter_mod, 1 },
+    { 0x814F, op_combat_difficulty, 0 },
+    { 0x8150, op_obj_on_screen, 1 },
+    { 0x8151, op_critter_is_fleeing, 1 },
+    { 0x8152, op_critter_set_flee_state, 2 },
+    { 0x8153, op_terminate_combat, 0 },
+    { 0x8154, op_debug_msg, 1 },
+    { 0x8155, op_critter_stop_attacking, 1 },
+};
+
+static_assert(interpretOpcodesValid(intExtraOpcodes, sizeof(intExtraOpcodes) / sizeof(*intExtraOpcodes)), "bad intextra opcode table");
+
 // 0x452740
 void initIntExtra()
 {
-    interpretAddFunc(0x80A1, op_give_exp_points);
-    interpretAddFunc(0x80A2, op_scr_return);
-    interpretAddFunc(0x80A3, op_play_sfx);
-    interpretAddFunc(0x80A4, op_obj_name);
-    interpretAddFunc(0x80A5, op_sfx_build_open_name);
-    interpretAddFunc(0x80A6, op_get_pc_stat);
-    interpretAddFunc(0x80A7, op_tile_contains_pid_obj);
-    interpretAddFunc(0x80A8, op_set_map_start);
-    interpretAddFunc(0x80A9, op_override_map_start);
-    interpretAddFunc(0x80AA, op_has_skill);
-    interpretAddFunc(0x80AB, op_using_skill);
-    interpretAddFunc(0x80AC, op_roll_vs_skill);
-    interpretAddFunc(0x80AD, op_skill_contest);
-    interpretAddFunc(0x80AE, op_do_check);
-    interpretAddFunc(0x80AF, op_is_success);
-    interpretAddFunc(0x80B0, op_is_critical);
-    interpretAddFunc(0x80B1, op_how_much);
-    interpretAddFunc(0x80B2, op_reaction_roll);
-    interpretAddFunc(0x80B3, op_reaction_influence);
-    interpretAddFunc(0x80B4, op_random);
-    interpretAddFunc(0x80B5, op_roll_dice);
-    interpretAddFunc(0x80B6, op_move_to);
-    interpretAddFunc(0x80B7, op_create_object_sid);
-    interpretAddFunc(0x80B8, op_display_msg);
-    interpretAddFunc(0x80B9, op_script_overrides);
-    interpretAddFunc(0x80BA, op_obj_is_carrying_obj_pid);
-    interpretAddFunc(0x80BB, op_tile_contains_obj_pid);
-    interpretAddFunc(0x80BC, op_self_obj);
-    interpretAddFunc(0x80BD, op_source_obj);
-    interpretAddFunc(0x80BE, op_target_obj);
-    interpretAddFunc(0x80BF, op_dude_obj);
-    interpretAddFunc(0x80C0, op_obj_being_used_with);
-    interpretAddFunc(0x80C1, op_local_var);
-    interpretAddFunc(0x80C2, op_set_local_var);
-    interpretAddFunc(0x80C3, op_map_var);
-    interpretAddFunc(0x80C4, op_set_map_var);
-    interpretAddFunc(0x80C5, op_global_var);
-    interpretAddFunc(0x80C6, op_set_global_var);
-    interpretAddFunc(0x80C7, op_script_action);
-    interpretAddFunc(0x80C8, op_obj_type);
-    interpretAddFunc(0x80C9, op_obj_item_subtype);
-    interpretAddFunc(0x80CA, op_get_critter_stat);
-    interpretAddFunc(0x80CB, op_set_critter_stat);
-    interpretAddFunc(0x80CC, op_animate_stand_obj);
-    interpretAddFunc(0x80CD, op_animate_stand_reverse_obj);
-    interpretAddFunc(0x80CE, op_animate_move_obj_to_tile);
-    interpretAddFunc(0x80CF, op_animate_jump);
-    interpretAddFunc(0x80D0, op_attack);
-    interpretAddFunc(0x80D1, op_make_daytime);
-    interpretAddFunc(0x80D2, op_tile_distance);
-    interpretAddFunc(0x80D3, op_tile_distance_objs);
-    interpretAddFunc(0x80D4, op_tile_num);
-    interpretAddFunc(0x80D5, op_tile_num_in_direction);
-    interpretAddFunc(0x80D6, op_pickup_obj);
-    interpretAddFunc(0x80D7, op_drop_obj);
-    interpretAddFunc(0x80D8, op_add_obj_to_inven);
-    interpretAddFunc(0x80D9, op_rm_obj_from_inven);
-    interpretAddFunc(0x80DA, op_wield_obj_critter);
-    interpretAddFunc(0x80DB, op_use_obj);
-    interpretAddFunc(0x80DC, op_obj_can_see_obj);
-    interpretAddFunc(0x80DD, op_attack);
-    interpretAddFunc(0x80DE, op_start_gdialog);
-    interpretAddFunc(0x80DF, op_end_dialogue);
-    interpretAddFunc(0x80E0, op_dialogue_reaction);
-    interpretAddFunc(0x80E1, op_turn_off_objs_in_area);
-    interpretAddFunc(0x80E2, op_turn_on_objs_in_area);
-    interpretAddFunc(0x80E3, op_set_obj_visibility);
-    interpretAddFunc(0x80E4, op_load_map);
-    interpretAddFunc(0x80E5, op_barter_offer);
-    interpretAddFunc(0x80E6, op_barter_asking);
-    interpretAddFunc(0x80E7, op_anim_busy);
-    interpretAddFunc(0x80E8, op_critter_heal);
-    interpretAddFunc(0x80E9, op_set_light_level);
-    interpretAddFunc(0x80EA, op_game_time);
-    interpretAddFunc(0x80EB, op_game_time_in_seconds);
-    interpretAddFunc(0x80EC, op_elevation);
-    interpretAddFunc(0x80ED, op_kill_critter);
-    interpretAddFunc(0x80EE, op_kill_critter_type);
-    interpretAddFunc(0x80EF, op_critter_damage);
-    interpretAddFunc(0x80F0, op_add_timer_event);
-    interpretAddFunc(0x80F1, op_rm_timer_event);
-    interpretAddFunc(0x80F2, op_game_ticks);
-    interpretAddFunc(0x80F3, op_has_trait);
-    interpretAddFunc(0x80F4, op_destroy_object);
-    interpretAddFunc(0x80F5, op_obj_can_hear_obj);
-    interpretAddFunc(0x80F6, op_game_time_hour);
-    interpretAddFunc(0x80F7, op_fixed_param);
-    interpretAddFunc(0x80F8, op_tile_is_visible);
-    interpretAddFunc(0x80F9, op_dialogue_system_enter);
-    interpretAddFunc(0x80FA, op_action_being_used);
-    interpretAddFunc(0x80FB, op_critter_state);
-    interpretAddFunc(0x80FC, op_game_time_advance);
-    interpretAddFunc(0x80FD, op_radiation_inc);
-    interpretAddFunc(0x80FE, op_radiation_dec);
-    interpretAddFunc(0x80FF, op_critter_attempt_placement);
-    interpretAddFunc(0x8100, op_obj_pid);
-    interpretAddFunc(0x8101, op_cur_map_index);
-    interpretAddFunc(0x8102, op_critter_add_trait);
-    interpretAddFunc(0x8103, op_critter_rm_trait);
-    interpretAddFunc(0x8104, op_proto_data);
-    interpretAddFunc(0x8105, op_message_str);
-    interpretAddFunc(0x8106, op_critter_inven_obj);
-    interpretAddFunc(0x8107, op_obj_set_light_level);
-    interpretAddFunc(0x8108, op_world_map);
-    interpretAddFunc(0x8109, op_town_map);
-    interpretAddFunc(0x810A, op_float_msg);
-    interpretAddFunc(0x810B, op_metarule);
-    interpretAddFunc(0x810C, op_anim);
-    interpretAddFunc(0x810D, op_obj_carrying_pid_obj);
-    interpretAddFunc(0x810E, op_reg_anim_func);
-    interpretAddFunc(0x810F, op_reg_anim_animate);
-    interpretAddFunc(0x8110, op_reg_anim_animate_reverse);
-    interpretAddFunc(0x8111, op_reg_anim_obj_move_to_obj);
-    interpretAddFunc(0x8112, op_reg_anim_obj_run_to_obj);
-    interpretAddFunc(0x8113, op_reg_anim_obj_move_to_tile);
-    interpretAddFunc(0x8114, op_reg_anim_obj_run_to_tile);
-    interpretAddFunc(0x8115, op_play_gmovie);
-    interpretAddFunc(0x8116, op_add_mult_objs_to_inven);
-    interpretAddFunc(0x8117, op_rm_mult_objs_from_inven);
-    interpretAddFunc(0x8118, op_get_month);
-    interpretAddFunc(0x8119, op_get_day);
-    interpretAddFunc(0x811A, op_explosion);
-    interpretAddFunc(0x811B, op_days_since_visited);
-    interpretAddFunc(0x811C, op_gsay_start);
-    interpretAddFunc(0x811D, op_gsay_end);
-    interpretAddFunc(0x811E, op_gsay_reply);
-    interpretAddFunc(0x811F, op_gsay_option);
-    interpretAddFunc(0x8120, op_gsay_message);
-    interpretAddFunc(0x8121, op_giq_option);
-    interpretAddFunc(0x8122, op_poison);
-    interpretAddFunc(0x8123, op_get_poison);
-    interpretAddFunc(0x8124, op_party_add);
-    interpretAddFunc(0x8125, op_party_remove);
-    interpretAddFunc(0x8126, op_reg_anim_animate_forever);
-    interpretAddFunc(0x8127, op_critter_injure);
-    interpretAddFunc(0x8128, op_combat_is_initialized);
-    interpretAddFunc(0x8129, op_gdialog_barter);
-    interpretAddFunc(0x812A, op_difficulty_level);
-    interpretAddFunc(0x812B, op_running_burning_guy);
-    interpretAddFunc(0x812C, op_inven_unwield);
-    interpretAddFunc(0x812D, op_obj_is_locked);
-    interpretAddFunc(0x812E, op_obj_lock);
-    interpretAddFunc(0x812F, op_obj_unlock);
-    interpretAddFunc(0x8131, op_obj_open);
-    interpretAddFunc(0x8130, op_obj_is_open);
-    interpretAddFunc(0x8132, op_obj_close);
-    interpretAddFunc(0x8133, op_game_ui_disable);
-    interpretAddFunc(0x8134, op_game_ui_enable);
-    interpretAddFunc(0x8135, op_game_ui_is_disabled);
-    interpretAddFunc(0x8136, op_gfade_out);
-    interpretAddFunc(0x8137, op_gfade_in);
-    interpretAddFunc(0x8138, op_item_caps_total);
-    interpretAddFunc(0x8139, op_item_caps_adjust);
-    interpretAddFunc(0x813A, op_anim_action_frame);
-    interpretAddFunc(0x813B, op_reg_anim_play_sfx);
-    interpretAddFunc(0x813C, op_critter_mod_skill);
-    interpretAddFunc(0x813D, op_sfx_build_char_name);
-    interpretAddFunc(0x813E, op_sfx_build_ambient_name);
-    interpretAddFunc(0x813F, op_sfx_build_interface_name);
-    interpretAddFunc(0x8140, op_sfx_build_item_name);
-    interpretAddFunc(0x8141, op_sfx_build_weapon_name);
-    interpretAddFunc(0x8142, op_sfx_build_scenery_name);
-    interpretAddFunc(0x8143, op_attack_setup);
-    interpretAddFunc(0x8144, op_destroy_mult_objs);
-    interpretAddFunc(0x8145, op_use_obj_on_obj);
-    interpretAddFunc(0x8146, op_endgame_slideshow);
-    interpretAddFunc(0x8147, op_move_obj_inven_to_obj);
-    interpretAddFunc(0x8148, op_endgame_movie);
-    interpretAddFunc(0x8149, op_obj_art_fid);
-    interpretAddFunc(0x814A, op_art_anim);
-    interpretAddFunc(0x814B, op_party_member_obj);
-    interpretAddFunc(0x814C, op_rotation_to_tile);
-    interpretAddFunc(0x814D, op_jam_lock);
-    interpretAddFunc(0x814E, op_gdialog_set_barter_mod);
-    interpretAddFunc(0x814F, op_combat_difficulty);
-    interpretAddFunc(0x8150, op_obj_on_screen);
-    interpretAddFunc(0x8151, op_critter_is_fleeing);
-    interpretAddFunc(0x8152, op_critter_set_flee_state);
-    interpretAddFunc(0x8153, op_terminate_combat);
-    interpretAddFunc(0x8154, op_debug_msg);
-    interpretAddFunc(0x8155, op_critter_stop_attacking);
+    interpretAddFuncs(intExtraOpcodes, sizeof(intExtraOpcodes) / sizeof(*intExtraOpcodes));
 }
 
 // 0x4531E0
@@ -1664,6 +1664,7 @@ void windowClose()
     }
 
     mousemgrClose();
+    datafileFlushCache();
     db_exit();
     win_exit();
 }
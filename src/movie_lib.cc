@@ -9,11 +9,38 @@
 #include <stdio.h>
 #include <string.h>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define MOVIE_LIB_SSE2
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#define MOVIE_LIB_SSSE3
+#endif
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define MOVIE_LIB_NEON
+#endif
+
+#if defined(MOVIE_LIB_SSE2) || defined(MOVIE_LIB_NEON)
+#define MOVIE_LIB_SIMD
+#endif
+
+#include <algorithm>
+
 #include "audio_engine.h"
 #include "platform_compat.h"
+#include "plib/gnw/jobs.h"
+#include "plib/gnw/prof.h"
 
 namespace fallout {
 
+// CE: Maximum number of threads decoding video opcodes of one frame
+// (including main thread).
+#define MOVIE_DECODE_MAX_THREADS 8
+
+// Maximum number of block rows in one frame.
+#define MOVIE_DECODE_MAX_ROWS 256
+
 typedef struct STRUCT_6B3690 {
     void* field_0;
     unsigned int field_4;
@@ -30,6 +57,37 @@ typedef struct Mve {
 } Mve;
 #pragma pack()
 
+// CE: Range of block rows decoded by one thread, with positions of the rows'
+// first opcode and first data byte.
+typedef struct MovieDecodeStripe {
+    unsigned char* map;
+    unsigned char* data;
+    unsigned char* dest;
+    int rows;
+} MovieDecodeStripe;
+
+// CE: Start of block row as seen by serial decoder.
+typedef struct MovieDecodeRow {
+    unsigned char* map;
+    unsigned char* data;
+    // Cleared when a block is written or copied from across start of this
+    // row, or when row does not start at its band. Rows which start inside
+    // skip run have no `map`, they cannot be split at either.
+    bool splittable;
+} MovieDecodeRow;
+
+// CE: Frame decoder state, stripes are decoded by job system.
+typedef struct MovieDecodeState {
+    // Maximum number of stripes decoded as jobs, 0 - frames are decoded
+    // serially.
+    int threadsLength;
+    // Stripe of every job, main thread decodes first stripe separately.
+    MovieDecodeStripe stripes[MOVIE_DECODE_MAX_THREADS - 1];
+    // Number of opcode pairs in a row.
+    int pairs;
+    JobGroup group;
+} MovieDecodeState;
+
 typedef struct STRUCT_4F6930 {
     int field_0;
     MovieReadProc* readProc;
@@ -96,6 +154,18 @@ static int _MVE_sndDecompM16(unsigned short* a1, unsigned char* a2, int a3, int
 static int _MVE_sndDecompS16(unsigned short* a1, unsigned char* a2, int a3, int a4);
 static void _nfPkConfig();
 static void _nfPkDecomp(unsigned char* buf, unsigned char* a2, int a3, int a4, int a5, int a6);
+static void movieDecodeRows(unsigned char* a1, unsigned char* a2, unsigned char* dest, int a5, int a6);
+static int movieDecodeDataSize(int opcode, const unsigned char* data);
+static void movieCopyBlock(unsigned char* dest, ptrdiff_t offset, int pitch);
+#ifdef MOVIE_LIB_SIMD
+static void movieDecodeBlock2(unsigned char* dest, int pitch, const unsigned char* data);
+static void movieDecodeBlock4(unsigned char* dest, int pitch, const unsigned char* data);
+#endif
+static void movieChecksumFrame();
+static bool movieDecodePlan(unsigned char* a1, unsigned char* a2, int a5, int a6);
+static void movieDecodeMarkRange(int rows, ptrdiff_t start, ptrdiff_t end);
+static bool movieDecodeStripes(unsigned char* a1, unsigned char* a2, unsigned char* dest, int a5, int a6);
+static void movieDecodeStripe(void* data);
 
 static constexpr uint16_t loadUInt16LE(const uint8_t* b);
 static constexpr uint32_t loadUInt32LE(const uint8_t* b);
@@ -516,6 +586,24 @@ static SDL_Surface* gMovieSdlSurface2;
 static int gMveSoundBuffer = -1;
 static unsigned int gMveBufferBytes;
 
+static MovieDecodeState gMovieDecodeState;
+static MovieDecodeRow gMovieDecodeRows[MOVIE_DECODE_MAX_ROWS];
+
+// CE: When set, movies are decoded as fast as possible without sound,
+// palette changes and presentation (see `movieLibSetDecodeOnly`).
+static bool gMovieLibDecodeOnly = false;
+
+// CE: When set, video chunks are skipped and frames are not presented, only
+// sound is played (see `movieLibSetAudioOnly`).
+static bool gMovieLibAudioOnly = false;
+
+// CE: When set, blocks are decoded with scalar code only. Used as reference
+// to check vectorized block decoders.
+static bool gMovieLibReferenceDecoder = false;
+
+// CE: Checksum of frames shown since movie was prepared (decode only mode).
+static unsigned long long gMovieLibChecksum;
+
 // 0x4F4800
 void movieLibSetMemoryProcs(MveMallocFunc* mallocProc, MveFreeFunc* freeProc)
 {
@@ -529,6 +617,53 @@ void movieLibSetReadProc(MovieReadProc* readProc)
     gMovieLibReadProc = readProc;
 }
 
+// CE: Sets number of threads decoding video of one frame (including main
+// thread). Values below 2 decode on main thread only. Stripes are decoded by
+// job system, so the number is also limited by its worker threads.
+void movieLibSetDecodeThreads(int threads)
+{
+    MovieDecodeState* state = &gMovieDecodeState;
+
+    threads -= 1;
+    if (threads <= 0) {
+        state->threadsLength = 0;
+        return;
+    }
+
+    if (threads > MOVIE_DECODE_MAX_THREADS - 1) {
+        threads = MOVIE_DECODE_MAX_THREADS - 1;
+    }
+
+    state->threadsLength = threads;
+}
+
+// CE: Decode only mode is used to measure decoder throughput. Movie is still
+// read and decoded frame by frame with `_MVE_rmStepMovie`, but sound chunks
+// are skipped, nothing is presented and there is no frame pacing.
+void movieLibSetDecodeOnly(bool decodeOnly)
+{
+    gMovieLibDecodeOnly = decodeOnly;
+}
+
+// CE: Audio only mode plays movie sound with regular pacing (which is driven
+// by sound sync chunks), but video is neither decoded nor presented.
+void movieLibSetAudioOnly(bool audioOnly)
+{
+    gMovieLibAudioOnly = audioOnly;
+}
+
+void movieLibSetReferenceDecoder(bool reference)
+{
+    gMovieLibReferenceDecoder = reference;
+}
+
+// CE: Returns checksum of frames decoded in decode only mode since movie was
+// prepared, used to check that decoders produce the same frames.
+unsigned long long movieLibGetChecksum()
+{
+    return gMovieLibChecksum;
+}
+
 // 0x4F4890
 static void _MVE_MemInit(STRUCT_6B3690* a1, int a2, void* a3)
 {
@@ -674,6 +809,9 @@ int _MVE_rmPrepMovie(void* handle, int a2, int a3, char a4)
     _rm_FrameCount = 0;
     _rm_FrameDropCount = 0;
 
+    // FNV-1a offset basis.
+    gMovieLibChecksum = 0xCBF29CE484222325ULL;
+
     return 0;
 }
 
@@ -871,12 +1009,20 @@ LABEL_5:
             v1 = (unsigned short*)_ioNextRecord();
             goto LABEL_5;
         case 2:
+            if (gMovieLibDecodeOnly) {
+                continue;
+            }
+
             if (!_syncInit(v1[0], v1[2])) {
                 v6 = -3;
                 break;
             }
             continue;
         case 3:
+            if (gMovieLibDecodeOnly) {
+                continue;
+            }
+
             if ((v5 >> 24) < 1) {
                 v7 = 0;
             } else {
@@ -894,6 +1040,10 @@ LABEL_5:
             v6 = -4;
             break;
         case 4:
+            if (gMovieLibDecodeOnly) {
+                continue;
+            }
+
             // initialize audio buffers
             _MVE_sndSync();
             continue;
@@ -947,6 +1097,20 @@ LABEL_5:
         case 7:
             ++_rm_FrameCount;
 
+            if (gMovieLibDecodeOnly) {
+                movieChecksumFrame();
+
+                _rm_p = (unsigned char*)v1;
+                _rm_len = v0;
+                return 0;
+            }
+
+            if (gMovieLibAudioOnly) {
+                _rm_p = (unsigned char*)v1;
+                _rm_len = v0;
+                return 0;
+            }
+
             v18 = 0;
             if ((v5 >> 24) >= 1) {
                 v18 = v1[2];
@@ -980,7 +1144,7 @@ LABEL_5:
         case 8:
         case 9:
             // push data to audio buffers?
-            if (v1[1] & _rm_track_bit) {
+            if ((v1[1] & _rm_track_bit) && !gMovieLibDecodeOnly) {
                 v14 = (unsigned char*)v1 + 6;
                 if ((v5 >> 16) != 8) {
                     v14 = NULL;
@@ -1014,6 +1178,10 @@ LABEL_5:
             continue;
         case 17:
             // decode video chunk
+            if (gMovieLibAudioOnly) {
+                continue;
+            }
+
             if ((v5 >> 24) < 3) {
                 v6 = -8;
                 break;
@@ -1866,8 +2034,35 @@ static void _nfPkConfig()
 // 0x4F7359
 static void _nfPkDecomp(unsigned char* a1, unsigned char* a2, int a3, int a4, int a5, int a6)
 {
-    int v49;
     unsigned char* dest;
+
+    dword_6B401B = 8 * a3;
+    dword_6B4017 = 8 * a5;
+    dword_6B401F = 8 * a4 * byte_6B4016;
+    dword_6B4023 = 8 * a6 * byte_6B4016;
+
+    dest = gMovieDirectDrawSurfaceBuffer1;
+
+    if (a3 || a4) {
+        dest = gMovieDirectDrawSurfaceBuffer1 + dword_6B401B + _mveBW * dword_6B401F;
+    }
+
+    // CE: Split frame into stripes of block rows decoded in parallel when
+    // possible.
+    if (movieDecodeStripes(a1, a2, dest, a5, a6)) {
+        return;
+    }
+
+    movieDecodeRows(a1, a2, dest, a5, a6);
+}
+
+// CE: Extracted from `_nfPkDecomp`. Decodes `a6` block rows starting at
+// `dest`, `a1` points to opcodes of the first row and `a2` to its data.
+// Only writes to rows being decoded, so it is safe to run for different
+// stripes of one frame at the same time (see `movieDecodePlan`).
+static void movieDecodeRows(unsigned char* a1, unsigned char* a2, unsigned char* dest, int a5, int a6)
+{
+    int v49;
     int v8;
     int v7;
     int i;
@@ -1884,19 +2079,15 @@ static void _nfPkDecomp(unsigned char* a1, unsigned char* a2, int a3, int a4, in
     unsigned int* dest_ptr;
     unsigned int nibbles[2];
 
-    dword_6B401B = 8 * a3;
-    dword_6B4017 = 8 * a5;
-    dword_6B401F = 8 * a4 * byte_6B4016;
-    dword_6B4023 = 8 * a6 * byte_6B4016;
-
     var_8 = dword_6B3D00 - dword_6B4017;
-    dest = gMovieDirectDrawSurfaceBuffer1;
 
     var_10 = dword_6B3CEC - 8;
 
-    if (a3 || a4) {
-        dest = gMovieDirectDrawSurfaceBuffer1 + dword_6B401B + _mveBW * dword_6B401F;
-    }
+#ifdef MOVIE_LIB_SIMD
+    // CE: Vectorized decoders advance to the next block by 8 bytes, which
+    // does not hold for interlaced frames.
+    bool simd = !gMovieLibReferenceDecoder && byte_6B4016 == 1;
+#endif
 
     while (a6--) {
         v49 = a5 >> 1;
@@ -1950,10 +2141,9 @@ static void _nfPkDecomp(unsigned char* a1, unsigned char* a2, int a3, int a4, in
 
                     value2 = _mveBW;
 
-                    for (i = 0; i < 8; ++i) {
-                        memcpy(dest, dest + v10, 8);
-                        dest += value2;
-                    }
+                    // CE: Rows are copied with 8-byte loads and stores.
+                    movieCopyBlock(dest, v10, value2);
+                    dest += value2 * 8;
 
                     dest -= value2;
 
@@ -1976,6 +2166,15 @@ static void _nfPkDecomp(unsigned char* a1, unsigned char* a2, int a3, int a4, in
                     }
                     break;
                 case 7:
+#ifdef MOVIE_LIB_SIMD
+                    if (simd && a2[0] <= a2[1]) {
+                        movieDecodeBlock2(dest, _mveBW, a2);
+                        a2 += 10;
+                        dest += 8;
+                        break;
+                    }
+#endif
+
                     if (a2[0] > a2[1]) {
                         // 7/1
                         for (i = 0; i < 2; i++) {
@@ -2268,6 +2467,15 @@ static void _nfPkDecomp(unsigned char* a1, unsigned char* a2, int a3, int a4, in
 
                     break;
                 case 9:
+#ifdef MOVIE_LIB_SIMD
+                    if (simd && a2[0] <= a2[1] && a2[2] <= a2[3]) {
+                        movieDecodeBlock4(dest, _mveBW, a2);
+                        a2 += 20;
+                        dest += 8;
+                        break;
+                    }
+#endif
+
                     if (a2[0] > a2[1]) {
                         if (a2[2] > a2[3]) {
                             // 9/1
@@ -2792,6 +3000,356 @@ static void _nfPkDecomp(unsigned char* a1, unsigned char* a2, int a3, int a4, in
     }
 }
 
+// CE: Copies 8x8 block from `offset` bytes away. Every row is loaded before
+// it is stored, so source can overlap the row being written (as it does
+// when block is copied from a few pixels to the right).
+static void movieCopyBlock(unsigned char* dest, ptrdiff_t offset, int pitch)
+{
+    for (int row = 0; row < 8; row++) {
+        uint64_t pixels;
+        memcpy(&pixels, dest + offset, sizeof(pixels));
+        memcpy(dest, &pixels, sizeof(pixels));
+        dest += pitch;
+    }
+}
+
+#ifdef MOVIE_LIB_SIMD
+// CE: Decodes 2-color block (opcode 7 with `data[0] <= data[1]`). Every row
+// is a byte of bits, least significant bit is the leftmost pixel, set bits
+// are painted with `data[1]`, clear ones with `data[0]`.
+static void movieDecodeBlock2(unsigned char* dest, int pitch, const unsigned char* data)
+{
+    const unsigned char* bits = data + 2;
+
+#if defined(MOVIE_LIB_SSE2)
+    const __m128i select = _mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128);
+    __m128i color0 = _mm_set1_epi8(static_cast<char>(data[0]));
+    __m128i delta = _mm_set1_epi8(static_cast<char>(data[0] ^ data[1]));
+
+    for (int row = 0; row < 8; row += 2) {
+        // Bits of two rows, every one repeated 8 times.
+        __m128i spread = _mm_cvtsi32_si128(bits[row] | (bits[row + 1] << 8));
+        spread = _mm_unpacklo_epi8(spread, spread);
+        spread = _mm_unpacklo_epi16(spread, spread);
+        spread = _mm_unpacklo_epi32(spread, spread);
+
+        __m128i mask = _mm_cmpeq_epi8(_mm_and_si128(spread, select), select);
+        __m128i pixels = _mm_xor_si128(color0, _mm_and_si128(delta, mask));
+
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(dest), pixels);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(dest + pitch), _mm_unpackhi_epi64(pixels, pixels));
+        dest += pitch * 2;
+    }
+#elif defined(MOVIE_LIB_NEON)
+    static const uint8_t selectBits[8] = { 1, 2, 4, 8, 16, 32, 64, 128 };
+    uint8x8_t select = vld1_u8(selectBits);
+    uint8x8_t color0 = vdup_n_u8(data[0]);
+    uint8x8_t color1 = vdup_n_u8(data[1]);
+
+    for (int row = 0; row < 8; row++) {
+        uint8x8_t mask = vtst_u8(vdup_n_u8(bits[row]), select);
+        vst1_u8(dest, vbsl_u8(mask, color1, color0));
+        dest += pitch;
+    }
+#endif
+}
+
+// CE: Decodes 4-color block (opcode 9 with `data[0] <= data[1]` and
+// `data[2] <= data[3]`). Every row is a 16-bit little-endian word, pixel `n`
+// is painted with `data[(word >> (2 * n)) & 3]`. Colors are picked with a
+// table shuffle where available.
+static void movieDecodeBlock4(unsigned char* dest, int pitch, const unsigned char* data)
+{
+    const unsigned char* words = data + 4;
+
+#if defined(MOVIE_LIB_SSE2)
+    // Moves bits of pixel `n` to the top of 16-bit lane `n`.
+    const __m128i shifts = _mm_setr_epi16(1 << 14, 1 << 12, 1 << 10, 1 << 8, 1 << 6, 1 << 4, 1 << 2, 1);
+
+#if defined(MOVIE_LIB_SSSE3)
+    __m128i colors = _mm_cvtsi32_si128(data[0] | (data[1] << 8) | (data[2] << 16) | (data[3] << 24));
+#else
+    __m128i colors[4];
+    for (int index = 0; index < 4; index++) {
+        colors[index] = _mm_set1_epi8(static_cast<char>(data[index]));
+    }
+#endif
+
+    for (int row = 0; row < 8; row += 2) {
+        __m128i indices0 = _mm_srli_epi16(_mm_mullo_epi16(_mm_set1_epi16(static_cast<short>(loadUInt16LE(words + row * 2))), shifts), 14);
+        __m128i indices1 = _mm_srli_epi16(_mm_mullo_epi16(_mm_set1_epi16(static_cast<short>(loadUInt16LE(words + row * 2 + 2))), shifts), 14);
+        __m128i indices = _mm_packus_epi16(indices0, indices1);
+
+#if defined(MOVIE_LIB_SSSE3)
+        __m128i pixels = _mm_shuffle_epi8(colors, indices);
+#else
+        __m128i pixels = _mm_setzero_si128();
+        for (int index = 0; index < 4; index++) {
+            __m128i mask = _mm_cmpeq_epi8(indices, _mm_set1_epi8(static_cast<char>(index)));
+            pixels = _mm_or_si128(pixels, _mm_and_si128(mask, colors[index]));
+        }
+#endif
+
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(dest), pixels);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(dest + pitch), _mm_unpackhi_epi64(pixels, pixels));
+        dest += pitch * 2;
+    }
+#elif defined(MOVIE_LIB_NEON)
+    static const int16_t shiftCounts[8] = { 0, -2, -4, -6, -8, -10, -12, -14 };
+    int16x8_t shifts = vld1q_s16(shiftCounts);
+    uint16x8_t mask = vdupq_n_u16(3);
+    uint8x8_t colors = vcreate_u8(data[0] | (data[1] << 8) | (data[2] << 16) | ((uint64_t)data[3] << 24));
+
+    for (int row = 0; row < 8; row++) {
+        uint16x8_t word = vdupq_n_u16(loadUInt16LE(words + row * 2));
+        uint8x8_t indices = vmovn_u16(vandq_u16(vshlq_u16(word, shifts), mask));
+        vst1_u8(dest, vtbl1_u8(colors, indices));
+        dest += pitch;
+    }
+#endif
+}
+#endif
+
+// CE: Adds frame about to be shown to checksum of movie.
+static void movieChecksumFrame()
+{
+    if (gMovieSdlSurface1 == NULL || SDL_LockSurface(gMovieSdlSurface1) != 0) {
+        return;
+    }
+
+    const unsigned char* pixels = (const unsigned char*)gMovieSdlSurface1->pixels;
+    for (int y = 0; y < gMovieSdlSurface1->h; y++) {
+        const unsigned char* row = pixels + y * gMovieSdlSurface1->pitch;
+        for (int x = 0; x < _mveBW; x++) {
+            gMovieLibChecksum ^= row[x];
+            gMovieLibChecksum *= 0x100000001B3ULL;
+        }
+    }
+
+    SDL_UnlockSurface(gMovieSdlSurface1);
+}
+
+// CE: Returns number of data bytes used by block opcode, `data` points to
+// its data. Mirrors `movieDecodeRows`.
+static int movieDecodeDataSize(int opcode, const unsigned char* data)
+{
+    switch (opcode) {
+    case 2:
+    case 3:
+    case 4:
+    case 14:
+        return 1;
+    case 5:
+    case 15:
+        return 2;
+    case 7:
+        return data[0] > data[1] ? 4 : 10;
+    case 8:
+        return data[0] > data[1] ? 12 : 16;
+    case 9:
+        if (data[0] > data[1]) {
+            return 12;
+        }
+        return data[2] > data[3] ? 8 : 20;
+    case 10:
+        return data[0] > data[1] ? 24 : 32;
+    case 11:
+        return 64;
+    case 12:
+        return 16;
+    case 13:
+        return 4;
+    }
+
+    return 0;
+}
+
+// CE: Walks opcodes of frame the same way `movieDecodeRows` does (without
+// decoding) to find where every block row starts in opcode and data streams
+// and which rows decoding can be split at. Stripes must only touch their
+// own bands of frame, otherwise result depends on order in which they are
+// decoded. Skip runs can leave blocks of the following rows off their bands,
+// and blocks copied from the frame being decoded (opcodes 2 and 3) can come
+// from the next band, so split points such blocks cross are dropped.
+static bool movieDecodePlan(unsigned char* a1, unsigned char* a2, int a5, int a6)
+{
+    MovieDecodeRow* rows = gMovieDecodeRows;
+    int total = a6;
+    ptrdiff_t var_8 = dword_6B3D00 - dword_6B4017;
+    ptrdiff_t blockSize = 7 * _mveBW + 8;
+    ptrdiff_t dest = 0;
+    int v49;
+    int v7;
+    unsigned int nibbles[2];
+
+    if (total <= 0 || total > MOVIE_DECODE_MAX_ROWS) {
+        return false;
+    }
+
+    for (int row = 0; row < total; row++) {
+        rows[row].map = NULL;
+        rows[row].data = NULL;
+        rows[row].splittable = true;
+    }
+
+    while (a6--) {
+        int row = total - a6 - 1;
+        rows[row].map = a1;
+        rows[row].data = a2;
+        if (dest != (ptrdiff_t)row * dword_6B3D00) {
+            rows[row].splittable = false;
+        }
+
+        v49 = a5 >> 1;
+        while (v49--) {
+            int v8 = *a1++;
+            nibbles[0] = v8 & 0xF;
+            nibbles[1] = v8 >> 4;
+            for (int j = 0; j < 2; j++) {
+                v7 = nibbles[j];
+
+                switch (v7) {
+                case 1:
+                    break;
+                case 6:
+                    nibbles[0] += 2;
+                    while (nibbles[0]--) {
+                        dest += 16;
+
+                        if (v49--) {
+                            continue;
+                        }
+
+                        dest += var_8;
+
+                        a6--;
+                        v49 = (a5 >> 1) - 1;
+                    }
+                    continue;
+                case 2:
+                case 3:
+                    if (1) {
+                        uint16_t offset = word_51F618[a2[0]];
+                        if (v7 == 3) {
+                            offset = ((-(offset & 0xFF)) & 0xFF) | ((-(offset >> 8) & 0xFF) << 8);
+                        }
+
+                        ptrdiff_t src = dest + getOffset(offset);
+                        movieDecodeMarkRange(total, std::min(src, dest), std::max(src, dest) + blockSize);
+                    }
+                    break;
+                default:
+                    movieDecodeMarkRange(total, dest, dest + blockSize);
+                    break;
+                }
+
+                a2 += movieDecodeDataSize(v7, a2);
+                dest += 8;
+            }
+        }
+
+        dest += var_8;
+
+        // Skip run past the end of frame, leave it to serial decoder.
+        if (a6 < 0) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// CE: Marks rows starting inside byte range `start`..`end` (exclusive) of
+// frame being decoded as not splittable.
+static void movieDecodeMarkRange(int rows, ptrdiff_t start, ptrdiff_t end)
+{
+    ptrdiff_t rowSize = dword_6B3D00;
+
+    // Floor division, range can start above the first row.
+    ptrdiff_t first = (start >= 0 ? start : start - rowSize + 1) / rowSize + 1;
+    ptrdiff_t last = (end - 1 >= 0 ? end - 1 : end - rowSize) / rowSize;
+
+    first = std::max(first, (ptrdiff_t)1);
+    last = std::min(last, (ptrdiff_t)rows - 1);
+
+    for (ptrdiff_t row = first; row <= last; row++) {
+        gMovieDecodeRows[row].splittable = false;
+    }
+}
+
+// CE: Decodes frame in stripes of block rows with job system, the first
+// stripe is decoded on calling thread. Returns false if frame should be
+// decoded serially instead.
+static bool movieDecodeStripes(unsigned char* a1, unsigned char* a2, unsigned char* dest, int a5, int a6)
+{
+    MovieDecodeState* state = &gMovieDecodeState;
+
+    int stripes = std::min(state->threadsLength, jobs_get_worker_count()) + 1;
+    if (stripes < 2 || a6 < 2 * stripes) {
+        return false;
+    }
+
+    // Interlaced frames have blocks of different shape.
+    if (byte_6B4016 != 1) {
+        return false;
+    }
+
+    if (!movieDecodePlan(a1, a2, a5, a6)) {
+        return false;
+    }
+
+    int starts[MOVIE_DECODE_MAX_THREADS + 1];
+    int count = 0;
+    starts[count++] = 0;
+
+    for (int index = 1; index < stripes; index++) {
+        int row = std::max(a6 * index / stripes, starts[count - 1] + 1);
+        while (row < a6 && !(gMovieDecodeRows[row].map != NULL && gMovieDecodeRows[row].splittable)) {
+            row++;
+        }
+
+        if (row >= a6) {
+            break;
+        }
+
+        starts[count++] = row;
+    }
+
+    if (count < 2) {
+        return false;
+    }
+
+    starts[count] = a6;
+
+    state->pairs = a5;
+
+    jobs_group_init(&(state->group));
+    for (int index = 1; index < count; index++) {
+        MovieDecodeStripe* stripe = &(state->stripes[index - 1]);
+        int row = starts[index];
+        stripe->map = gMovieDecodeRows[row].map;
+        stripe->data = gMovieDecodeRows[row].data;
+        stripe->dest = dest + row * dword_6B3D00;
+        stripe->rows = starts[index + 1] - row;
+        jobs_add(&(state->group), movieDecodeStripe, stripe);
+    }
+
+    movieDecodeRows(a1, a2, dest, a5, starts[1]);
+
+    jobs_wait(&(state->group));
+
+    return true;
+}
+
+// CE: Decodes one stripe published by `movieDecodeStripes`.
+static void movieDecodeStripe(void* data)
+{
+    ProfScope profScope(PROF_ZONE_MOVIE_DECODE_WORKER);
+
+    MovieDecodeStripe* stripe = (MovieDecodeStripe*)data;
+    movieDecodeRows(stripe->map, stripe->data, stripe->dest, gMovieDecodeState.pairs, stripe->rows);
+}
+
 constexpr uint16_t loadUInt16LE(const uint8_t* b)
 {
     return (b[1] << 8) | b[0];
@@ -14,6 +14,11 @@ void movieLibSetMemoryProcs(MveMallocFunc* mallocProc, MveFreeFunc* freeProc);
 void movieLibSetReadProc(MovieReadProc* readProc);
 void movieLibSetVolume(int volume);
 void movieLibSetPan(int pan);
+void movieLibSetDecodeThreads(int threads);
+void movieLibSetDecodeOnly(bool decodeOnly);
+void movieLibSetAudioOnly(bool audioOnly);
+void movieLibSetReferenceDecoder(bool reference);
+unsigned long long movieLibGetChecksum();
 void _MVE_sfSVGA(int a1, int a2, int a3, int a4, int a5, int a6, int a7, int a8, int a9);
 void _MVE_sfCallbacks(MovieShowFrameProc* proc);
 void movieLibSetPaletteEntriesProc(void (*fn)(unsigned char*, int, int));
@@ -1,5 +1,7 @@
 #include "platform_compat.h"
 
+#include <limits.h>
+#include <stdint.h>
 #include <string.h>
 
 #ifdef _WIN32
@@ -11,12 +13,24 @@
 #include <io.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <sys/stat.h>
 #else
 #include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <unistd.h>
 #endif
 
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/sendfile.h>
+#include <sys/syscall.h>
+#elif defined(__APPLE__)
+#include <sys/clonefile.h>
+#endif
+
 #ifdef _WIN32
 #include <timeapi.h>
 #else
@@ -229,6 +243,21 @@ int compat_mkdir(const char* path)
 #endif
 }
 
+// Removes empty directory.
+int compat_rmdir(const char* path)
+{
+    char nativePath[COMPAT_MAX_PATH];
+    strcpy(nativePath, path);
+    compat_windows_path_to_native(nativePath);
+    compat_resolve_path(nativePath);
+
+#ifdef _WIN32
+    return _rmdir(nativePath);
+#else
+    return rmdir(nativePath);
+#endif
+}
+
 unsigned int compat_timeGetTime()
 {
 #ifdef _WIN32
@@ -356,4 +385,392 @@ long getFileSize(FILE* stream)
     return filesize;
 }
 
+// Obtains size and modification time (in seconds) of a file or directory.
+int compat_stat(const char* path, long long* sizePtr, long long* mtimePtr)
+{
+    char nativePath[COMPAT_MAX_PATH];
+    strcpy(nativePath, path);
+    compat_windows_path_to_native(nativePath);
+    compat_resolve_path(nativePath);
+
+    // Trailing separators are not accepted on some platforms.
+    size_t length = strlen(nativePath);
+    while (length > 1 && (nativePath[length - 1] == '/' || nativePath[length - 1] == '\\')) {
+        nativePath[--length] = '\0';
+    }
+
+#ifdef _WIN32
+    struct _stat64 st;
+    if (_stat64(nativePath, &st) != 0) {
+        return -1;
+    }
+#else
+    struct stat st;
+    if (stat(nativePath, &st) != 0) {
+        return -1;
+    }
+#endif
+
+    if (sizePtr != NULL) {
+        *sizePtr = st.st_size;
+    }
+
+    if (mtimePtr != NULL) {
+        *mtimePtr = st.st_mtime;
+    }
+
+    return 0;
+}
+
+int compat_copy_file(const char* sourcePath, const char* destinationPath)
+{
+    char nativeSourcePath[COMPAT_MAX_PATH];
+    strcpy(nativeSourcePath, sourcePath);
+    compat_windows_path_to_native(nativeSourcePath);
+    compat_resolve_path(nativeSourcePath);
+
+    char nativeDestinationPath[COMPAT_MAX_PATH];
+    strcpy(nativeDestinationPath, destinationPath);
+    compat_windows_path_to_native(nativeDestinationPath);
+    compat_resolve_path(nativeDestinationPath);
+
+#if defined(_WIN32)
+    return CopyFileA(nativeSourcePath, nativeDestinationPath, FALSE) ? 0 : -1;
+#elif defined(__APPLE__)
+    // Clones share blocks with the source on APFS, so copying is O(1).
+    // `clonefile` refuses to replace existing files.
+    remove(nativeDestinationPath);
+    return clonefile(nativeSourcePath, nativeDestinationPath, 0) == 0 ? 0 : -1;
+#elif defined(__linux__)
+    int sourceFd = open(nativeSourcePath, O_RDONLY);
+    if (sourceFd == -1) {
+        return -1;
+    }
+
+    struct stat st;
+    if (fstat(sourceFd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        close(sourceFd);
+        return -1;
+    }
+
+    int destinationFd = open(nativeDestinationPath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (destinationFd == -1) {
+        close(sourceFd);
+        return -1;
+    }
+
+    off_t remaining = st.st_size;
+    bool useCopyRange = true;
+    while (remaining > 0) {
+        ssize_t copied = -1;
+#if !defined(__ANDROID__)
+        if (useCopyRange) {
+            // Stays in kernel (and can reflink on CoW filesystems). Falls
+            // back to `sendfile` on kernels or filesystems lacking support.
+            copied = copy_file_range(sourceFd, NULL, destinationFd, NULL, (size_t)remaining, 0);
+            if (copied == -1 && (errno == ENOSYS || errno == EXDEV || errno == EINVAL || errno == EOPNOTSUPP)) {
+                useCopyRange = false;
+            }
+        }
+#else
+        useCopyRange = false;
+#endif
+
+        if (!useCopyRange) {
+            copied = sendfile(destinationFd, sourceFd, NULL, (size_t)remaining);
+        }
+
+        if (copied == -1 && errno == EINTR) {
+            continue;
+        }
+
+        if (copied <= 0) {
+            break;
+        }
+
+        remaining -= copied;
+    }
+
+    close(sourceFd);
+
+    if (close(destinationFd) != 0 || remaining != 0) {
+        return -1;
+    }
+
+    return 0;
+#else
+    return -1;
+#endif
+}
+
+int compat_link(const char* existingPath, const char* newPath)
+{
+    char nativeExistingPath[COMPAT_MAX_PATH];
+    strcpy(nativeExistingPath, existingPath);
+    compat_windows_path_to_native(nativeExistingPath);
+    compat_resolve_path(nativeExistingPath);
+
+    char nativeNewPath[COMPAT_MAX_PATH];
+    strcpy(nativeNewPath, newPath);
+    compat_windows_path_to_native(nativeNewPath);
+    compat_resolve_path(nativeNewPath);
+
+#if defined(_WIN32)
+    return CreateHardLinkA(nativeNewPath, nativeExistingPath, NULL) ? 0 : -1;
+#elif defined(__EMSCRIPTEN__)
+    return -1;
+#else
+    return link(nativeExistingPath, nativeNewPath) == 0 ? 0 : -1;
+#endif
+}
+
+void* compat_map_file(FILE* stream, size_t* sizePtr)
+{
+    if (stream == NULL || sizePtr == NULL) {
+        return NULL;
+    }
+
+    long size = getFileSize(stream);
+    if (size <= 0) {
+        return NULL;
+    }
+
+#ifdef _WIN32
+    HANDLE file = (HANDLE)_get_osfhandle(_fileno(stream));
+    if (file == INVALID_HANDLE_VALUE) {
+        return NULL;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (mapping == NULL) {
+        return NULL;
+    }
+
+    // The view keeps mapping object alive, so the handle can be closed right
+    // away.
+    void* ptr = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+
+    if (ptr == NULL) {
+        return NULL;
+    }
+#else
+    void* ptr = mmap(NULL, size, PROT_READ, MAP_SHARED, fileno(stream), 0);
+    if (ptr == MAP_FAILED) {
+        return NULL;
+    }
+#endif
+
+    *sizePtr = size;
+
+    return ptr;
+}
+
+void compat_unmap_file(void* ptr, size_t size)
+{
+    if (ptr == NULL) {
+        return;
+    }
+
+#ifdef _WIN32
+    UnmapViewOfFile(ptr);
+#else
+    munmap(ptr, size);
+#endif
+}
+
+void compat_advise_willneed(const void* ptr, size_t size)
+{
+    if (ptr == NULL || size == 0) {
+        return;
+    }
+
+#ifndef _WIN32
+    // `madvise` requires page-aligned address.
+    uintptr_t pageSize = (uintptr_t)sysconf(_SC_PAGESIZE);
+    uintptr_t start = (uintptr_t)ptr & ~(pageSize - 1);
+    uintptr_t end = (uintptr_t)ptr + size;
+    madvise((void*)start, end - start, MADV_WILLNEED);
+#endif
+}
+
+void compat_advise_file_willneed(FILE* stream, long offset, long size)
+{
+    if (stream == NULL || size <= 0) {
+        return;
+    }
+
+#if defined(POSIX_FADV_WILLNEED)
+    posix_fadvise(fileno(stream), offset, size, POSIX_FADV_WILLNEED);
+#elif defined(F_RDADVISE)
+    struct radvisory advisory;
+    advisory.ra_offset = offset;
+    advisory.ra_count = (int)size;
+    fcntl(fileno(stream), F_RDADVISE, &advisory);
+#endif
+}
+
+bool compat_shm_open(const char* name, size_t size, bool* createdPtr, void** rwPtr, const void** roPtr)
+{
+    if (name == NULL || size == 0 || createdPtr == NULL || rwPtr == NULL || roPtr == NULL) {
+        return false;
+    }
+
+#if defined(_WIN32)
+    unsigned long long size64 = (unsigned long long)size;
+    HANDLE mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, (DWORD)(size64 >> 32), (DWORD)(size64 & 0xFFFFFFFF), name);
+    if (mapping == NULL) {
+        return false;
+    }
+
+    bool created = GetLastError() != ERROR_ALREADY_EXISTS;
+
+    // Views keep mapping object alive, so the handle can be closed right away.
+    void* rw = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+    const void* ro = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, size);
+    CloseHandle(mapping);
+
+    if (rw == NULL || ro == NULL) {
+        if (rw != NULL) {
+            UnmapViewOfFile(rw);
+        }
+
+        if (ro != NULL) {
+            UnmapViewOfFile(ro);
+        }
+
+        return false;
+    }
+#elif defined(__ANDROID__) || defined(__EMSCRIPTEN__)
+    // No POSIX shared memory.
+    return false;
+#else
+    bool created = true;
+    int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd == -1) {
+        if (errno != EEXIST) {
+            return false;
+        }
+
+        created = false;
+        fd = shm_open(name, O_RDWR, 0600);
+        if (fd == -1) {
+            return false;
+        }
+
+        // Creator might not have sized the segment yet.
+        struct stat st;
+        int attempt = 0;
+        while (fstat(fd, &st) == 0 && (size_t)st.st_size < size && attempt < 100) {
+            SDL_Delay(10);
+            attempt++;
+        }
+
+        if ((size_t)st.st_size != size) {
+            close(fd);
+            return false;
+        }
+    } else {
+        if (ftruncate(fd, (off_t)size) != 0) {
+            close(fd);
+            shm_unlink(name);
+            return false;
+        }
+    }
+
+    void* rw = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    void* ro = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (rw == MAP_FAILED || ro == MAP_FAILED) {
+        if (rw != MAP_FAILED) {
+            munmap(rw, size);
+        }
+
+        if (ro != MAP_FAILED) {
+            munmap(ro, size);
+        }
+
+        if (created) {
+            shm_unlink(name);
+        }
+
+        return false;
+    }
+#endif
+
+    *createdPtr = created;
+    *rwPtr = rw;
+    *roPtr = ro;
+
+    return true;
+}
+
+void compat_shm_close(const char* name, size_t size, void* rw, const void* ro, bool unlink)
+{
+#if defined(_WIN32)
+    if (rw != NULL) {
+        UnmapViewOfFile(rw);
+    }
+
+    if (ro != NULL) {
+        UnmapViewOfFile(ro);
+    }
+
+    // Segment is destroyed with the last view.
+    (void)name;
+    (void)size;
+    (void)unlink;
+#elif defined(__ANDROID__) || defined(__EMSCRIPTEN__)
+    (void)name;
+    (void)size;
+    (void)rw;
+    (void)ro;
+    (void)unlink;
+#else
+    if (rw != NULL) {
+        munmap(rw, size);
+    }
+
+    if (ro != NULL) {
+        munmap((void*)ro, size);
+    }
+
+    if (unlink && name != NULL) {
+        shm_unlink(name);
+    }
+#endif
+}
+
+bool compat_futex_wait(int* addr, int expected, int timeout)
+{
+#if defined(__linux__)
+    struct timespec ts;
+    struct timespec* tsPtr = NULL;
+    if (timeout >= 0) {
+        ts.tv_sec = timeout / 1000;
+        ts.tv_nsec = (long)(timeout % 1000) * 1000000;
+        tsPtr = &ts;
+    }
+
+    // Not `FUTEX_PRIVATE_FLAG`, waker may be another process.
+    syscall(SYS_futex, addr, FUTEX_WAIT, expected, tsPtr, NULL, 0);
+    return true;
+#else
+    (void)addr;
+    (void)expected;
+    (void)timeout;
+    return false;
+#endif
+}
+
+void compat_futex_wake(int* addr)
+{
+#if defined(__linux__)
+    syscall(SYS_futex, addr, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+#else
+    (void)addr;
+#endif
+}
+
 } // namespace fallout
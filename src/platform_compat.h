@@ -33,6 +33,7 @@ long compat_lseek(int fileHandle, long offset, int origin);
 long compat_tell(int fileHandle);
 long compat_filelength(int fd);
 int compat_mkdir(const char* path);
+int compat_rmdir(const char* path);
 unsigned int compat_timeGetTime();
 FILE* compat_fopen(const char* path, const char* mode);
 int compat_remove(const char* path);
@@ -41,6 +42,44 @@ void compat_windows_path_to_native(char* path);
 void compat_resolve_path(char* path);
 char* compat_strdup(const char* string);
 long getFileSize(FILE* stream);
+int compat_stat(const char* path, long long* sizePtr, long long* mtimePtr);
+
+// Copies contents of one plain file to another (replacing it) using the
+// fastest copy facility of the OS. Returns -1 when copying is not supported
+// or failed, in which case callers are expected to copy through stdio.
+int compat_copy_file(const char* sourcePath, const char* destinationPath);
+
+// Creates hard link to existing file. Returns -1 when links are not
+// supported (or destination exists).
+int compat_link(const char* existingPath, const char* newPath);
+
+// Maps entire file opened for reading into memory (read-only). Returns `NULL`
+// if mapping is not supported or failed, in which case callers are expected
+// to continue using stdio.
+void* compat_map_file(FILE* stream, size_t* sizePtr);
+void compat_unmap_file(void* ptr, size_t size);
+
+// Hints the OS that given range of mapped memory (or file) will be read soon.
+// These are advisory only and do nothing on platforms lacking such API.
+void compat_advise_willneed(const void* ptr, size_t size);
+void compat_advise_file_willneed(FILE* stream, long offset, long size);
+
+// Opens named shared memory segment of given size (creating it when it does
+// not exist yet) and maps it twice: read-write and read-only. Returns `false`
+// if shared memory is not supported or failed. New segments are
+// zero-filled.
+bool compat_shm_open(const char* name, size_t size, bool* createdPtr, void** rwPtr, const void** roPtr);
+
+// Unmaps shared memory segment. When `unlink` is set the name is removed so
+// subsequent `compat_shm_open` calls create a new segment.
+void compat_shm_close(const char* name, size_t size, void* rw, const void* ro, bool unlink);
+
+// Waits until 32-bit word in shared memory no longer holds `expected`, is
+// woken with `compat_futex_wake`, or `timeout` ms pass (-1 waits forever).
+// Works across processes. Returns `false` when there is no such facility, in
+// which case callers are expected to poll.
+bool compat_futex_wait(int* addr, int expected, int timeout);
+void compat_futex_wake(int* addr);
 
 } // namespace fallout
 
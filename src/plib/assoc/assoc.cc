@@ -13,10 +13,21 @@ namespace fallout {
 // with a check for this value.
 #define DICTIONARY_MARKER 0xFEBAFEBA
 
+// CE: Minimum number of pairs for hash index to be built. Smaller arrays (most
+// config sections) are searched with binary search only.
+#define ASSOC_HASH_MIN_SIZE 32
+
 static void* default_malloc(size_t t);
 static void* default_realloc(void* p, size_t t);
 static void default_free(void* p);
 static int assoc_find(assoc_array* a, const char* name, int* position);
+static unsigned int assoc_hash_key(const char* name);
+static void assoc_hash_free(assoc_array* a);
+static void assoc_hash_build(assoc_array* a);
+static void assoc_hash_add(assoc_array* a, int index, unsigned int hash);
+static int assoc_hash_lookup(assoc_array* a, const char* name, unsigned int hash);
+static void assoc_hash_inserted(assoc_array* a, int position, unsigned int hash);
+static void assoc_hash_deleted(assoc_array* a, int position, unsigned int hash);
 static int assoc_read_long(FILE* fp, long* theLong);
 static int assoc_read_assoc_array(FILE* fp, assoc_array* a);
 static int assoc_write_long(FILE* fp, long theLong);
@@ -76,6 +87,9 @@ int assoc_init(assoc_array* a, int n, size_t datasize, assoc_func_list* assoc_fu
         a->list = NULL;
     }
 
+    a->hash = NULL;
+    a->hash_mask = 0;
+
     if (rc != -1) {
         a->init_flag = DICTIONARY_MARKER;
     }
@@ -127,6 +141,8 @@ int assoc_free(assoc_array* a)
         internal_free(a->list);
     }
 
+    assoc_hash_free(a);
+
     memset(a, 0, sizeof(*a));
 
     return 0;
@@ -137,6 +153,10 @@ int assoc_free(assoc_array* a)
 // Returns 0 if key is found. Otherwise returns -1, in this case [indexPtr]
 // specifies an insertion point for given key.
 //
+// CE: Original code narrowed the range by one element per step (`l + 1`,
+// `r - 1`), making it linear. This is a proper binary search which finds the
+// same key and the same insertion point in a sorted array.
+//
 // 0x4D9CC4
 static int assoc_find(assoc_array* a, const char* name, int* position)
 {
@@ -144,44 +164,170 @@ static int assoc_find(assoc_array* a, const char* name, int* position)
         return -1;
     }
 
-    if (a->size == 0) {
-        *position = 0;
-        return -1;
+    if (a->hash != NULL) {
+        int slot = assoc_hash_lookup(a, name, assoc_hash_key(name));
+        if (slot != -1) {
+            *position = a->hash[slot].index;
+            return 0;
+        }
     }
 
-    int r = a->size - 1;
     int l = 0;
-    int mid = 0;
-    int cmp = 0;
-    while (r >= l) {
-        mid = (l + r) / 2;
+    int r = a->size - 1;
+    while (l <= r) {
+        int mid = l + (r - l) / 2;
 
-        cmp = compat_stricmp(name, a->list[mid].name);
+        int cmp = compat_stricmp(name, a->list[mid].name);
         if (cmp == 0) {
-            break;
+            *position = mid;
+            return 0;
         }
 
         if (cmp > 0) {
-            l = l + 1;
+            l = mid + 1;
         } else {
-            r = r - 1;
+            r = mid - 1;
         }
     }
 
-    if (cmp == 0) {
-        *position = mid;
-        return 0;
+    *position = l;
+
+    return -1;
+}
+
+// CE: Case-insensitive FNV-1a, folds case the same way as `compat_stricmp`.
+static unsigned int assoc_hash_key(const char* name)
+{
+    unsigned int hash = 2166136261U;
+    for (const unsigned char* pch = (const unsigned char*)name; *pch != '\0'; pch++) {
+        unsigned char ch = *pch;
+        if (ch >= 'a' && ch <= 'z') {
+            ch -= 'a' - 'A';
+        }
+
+        hash ^= ch;
+        hash *= 16777619U;
     }
+    return hash;
+}
 
-    if (cmp < 0) {
-        *position = mid;
-    } else {
-        *position = mid + 1;
+static void assoc_hash_free(assoc_array* a)
+{
+    if (a->hash != NULL) {
+        internal_free(a->hash);
+        a->hash = NULL;
+    }
+
+    a->hash_mask = 0;
+}
+
+// CE: (Re)builds hash index from [list] keeping load factor at most 1/2. On
+// allocation failure array silently falls back to binary search.
+static void assoc_hash_build(assoc_array* a)
+{
+    assoc_hash_free(a);
+
+    if (a->size < ASSOC_HASH_MIN_SIZE) {
+        return;
+    }
+
+    int count = 64;
+    while (count < a->size * 4) {
+        count *= 2;
+    }
+
+    a->hash = (assoc_hash_slot*)internal_malloc(sizeof(*a->hash) * count);
+    if (a->hash == NULL) {
+        return;
+    }
+
+    a->hash_mask = count - 1;
+
+    for (int slot = 0; slot < count; slot++) {
+        a->hash[slot].index = -1;
+    }
+
+    for (int index = 0; index < a->size; index++) {
+        assoc_hash_add(a, index, assoc_hash_key(a->list[index].name));
+    }
+}
+
+static void assoc_hash_add(assoc_array* a, int index, unsigned int hash)
+{
+    int slot = hash & a->hash_mask;
+    while (a->hash[slot].index != -1) {
+        slot = (slot + 1) & a->hash_mask;
+    }
+
+    a->hash[slot].index = index;
+    a->hash[slot].hash = hash;
+}
+
+// CE: Returns slot of the given key, or -1 if it's not present.
+static int assoc_hash_lookup(assoc_array* a, const char* name, unsigned int hash)
+{
+    int slot = hash & a->hash_mask;
+    while (a->hash[slot].index != -1) {
+        if (a->hash[slot].hash == hash && compat_stricmp(name, a->list[a->hash[slot].index].name) == 0) {
+            return slot;
+        }
+        slot = (slot + 1) & a->hash_mask;
     }
 
     return -1;
 }
 
+// CE: Updates hash index after pair was inserted into [list] at `position`.
+static void assoc_hash_inserted(assoc_array* a, int position, unsigned int hash)
+{
+    if (a->hash == NULL || a->size * 2 > a->hash_mask + 1) {
+        if (a->size >= ASSOC_HASH_MIN_SIZE) {
+            assoc_hash_build(a);
+        }
+        return;
+    }
+
+    for (int slot = 0; slot <= a->hash_mask; slot++) {
+        if (a->hash[slot].index >= position) {
+            a->hash[slot].index++;
+        }
+    }
+
+    assoc_hash_add(a, position, hash);
+}
+
+// CE: Updates hash index after pair at `position` was removed from [list].
+// Uses backward shift deletion so that probe sequences stay intact.
+static void assoc_hash_deleted(assoc_array* a, int position, unsigned int hash)
+{
+    if (a->hash == NULL) {
+        return;
+    }
+
+    int hole = hash & a->hash_mask;
+    while (a->hash[hole].index != position) {
+        hole = (hole + 1) & a->hash_mask;
+    }
+
+    int next = (hole + 1) & a->hash_mask;
+    while (a->hash[next].index != -1) {
+        int home = a->hash[next].hash & a->hash_mask;
+        if (((next - home) & a->hash_mask) >= ((next - hole) & a->hash_mask)) {
+            a->hash[hole] = a->hash[next];
+            hole = next;
+        }
+        next = (next + 1) & a->hash_mask;
+    }
+
+    a->hash[hole].index = -1;
+
+    for (int slot = 0; slot <= a->hash_mask; slot++) {
+        if (a->hash[slot].index > position) {
+            a->hash[slot].index--;
+        }
+    }
+}
+
 // Returns the index of the entry for the specified key, or -1 if it's not
 // present in the dictionary.
 //
@@ -192,6 +338,13 @@ int assoc_search(assoc_array* a, const char* name)
         return -1;
     }
 
+    // CE: Hash index answers both hits and misses, no need for insertion
+    // point.
+    if (a->hash != NULL) {
+        int slot = assoc_hash_lookup(a, name, assoc_hash_key(name));
+        return slot != -1 ? a->hash[slot].index : -1;
+    }
+
     int index;
     if (assoc_find(a, name, &index) != 0) {
         return -1;
@@ -262,6 +415,8 @@ int assoc_insert(assoc_array* a, const char* name, const void* data)
 
     a->size++;
 
+    assoc_hash_inserted(a, newElementIndex, assoc_hash_key(name));
+
     return 0;
 }
 
@@ -284,6 +439,8 @@ int assoc_delete(assoc_array* a, const char* name)
 
     assoc_pair* entry = &(a->list[indexToRemove]);
 
+    unsigned int hash = assoc_hash_key(entry->name);
+
     // Free key and value (which are copies).
     internal_free(entry->name);
     if (entry->data != NULL) {
@@ -300,6 +457,8 @@ int assoc_delete(assoc_array* a, const char* name)
         memcpy(dest, src, sizeof(*a->list));
     }
 
+    assoc_hash_deleted(a, indexToRemove, hash);
+
     return 0;
 }
 
@@ -414,6 +573,8 @@ int assoc_load(FILE* fp, assoc_array* a, int flags)
         internal_free(a->list);
     }
 
+    assoc_hash_free(a);
+
     if (assoc_read_assoc_array(fp, a) != 0) {
         return -1;
     }
@@ -473,6 +634,10 @@ int assoc_load(FILE* fp, assoc_array* a, int flags)
         }
     }
 
+    // CE: Pairs are read in sorted order straight into [list], index them in
+    // one pass rather than per pair.
+    assoc_hash_build(a);
+
     return 0;
 }
 
@@ -29,6 +29,15 @@ typedef struct assoc_pair {
     void* data;
 } assoc_pair;
 
+// CE: Slot of the optional hash index over assoc keys.
+typedef struct assoc_hash_slot {
+    // Index of the pair in [list], or -1 if slot is empty.
+    int index;
+
+    // Case-insensitive hash of the pair's key.
+    unsigned int hash;
+} assoc_hash_slot;
+
 // A collection of key/value pairs.
 //
 // The keys in assoc array are always strings. Internally pairs are kept sorted
@@ -52,6 +61,15 @@ typedef struct assoc_array {
 
     // The array of key-value pairs.
     assoc_pair* list;
+
+    // CE: Open addressing hash index over keys of [list], built once array
+    // grows large enough (see `ASSOC_HASH_MIN_SIZE`). Pairs are still kept
+    // sorted in [list], so ordered iteration and `assoc_save` are unaffected.
+    assoc_hash_slot* hash;
+
+    // CE: The number of slots in [hash] minus one (slot count is a power of
+    // two).
+    int hash_mask;
 } assoc_array;
 
 int assoc_init(assoc_array* a, int n, size_t datasize, assoc_func_list* assoc_funcs);
@@ -23,6 +23,10 @@ static void setMixTable();
 static void buildBlendTable(unsigned char* ptr, unsigned char ch);
 static void rebuildColorBlendTables();
 static void maxfill();
+static bool colorPaletteIsBlack(const unsigned char* palette);
+static void fadeSystemPaletteColorMod(unsigned char* oldPalette, unsigned char* newPalette, int steps, bool toBlack);
+static void colorFadeApply(unsigned int step, unsigned int steps);
+static void colorFadeProcess();
 
 // 0x4FE0DC
 static char _aColor_cNoError[] = "color.c: No errors\n";
@@ -48,6 +52,25 @@ static double currentGamma = 1.0;
 // 0x539EF0
 static fade_bk_func* colorFadeBkFuncP = NULL;
 
+// CE: State of non-blocking fade, see `colorFadeStart`.
+typedef struct ColorFade {
+    bool active;
+
+    // Set when fade is done by renderer color modulation (one of palettes
+    // is black, see `renderSetColorMod`).
+    bool colorMod;
+    bool toBlack;
+
+    unsigned char oldPalette[768];
+    unsigned char newPalette[768];
+    unsigned int start;
+    unsigned int duration;
+    ColorFadeDoneFunc* callback;
+    void* userData;
+} ColorFade;
+
+static ColorFade colorFade;
+
 // 0x539EF4
 static ColorMallocFunc* mallocPtr = defaultMalloc;
 
@@ -86,6 +109,10 @@ Color colorMixAddTable[256][256];
 // 0x683B00
 Color intensityColorTable[256][256];
 
+// CE: Incremented whenever `intensityColorTable` changes, lets users cache
+// data derived from it.
+static unsigned int intensityColorTableVersion = 1;
+
 // 0x693B00
 Color colorMixMulTable[256][256];
 
@@ -207,6 +234,31 @@ int Color2RGB(int a1)
 // 0x4BFEE0
 void fadeSystemPalette(unsigned char* oldPalette, unsigned char* newPalette, int steps)
 {
+    // CE: Intermediate steps are only visible effect, in turbo mode go
+    // straight to the end while keeping virtual time of the whole fade.
+    if (is_turbo_mode()) {
+        if (colorFadeBkFuncP != NULL) {
+            colorFadeBkFuncP();
+        }
+
+        setSystemPalette(newPalette);
+        renderPresent();
+        for (int step = 0; step <= steps; step++) {
+            sharedFpsLimiter.throttle();
+        }
+        return;
+    }
+
+    // CE: Fades from or to black only scale colors, renderer does that on
+    // GPU instead of converting and uploading entire screen on every step.
+    if (steps > 0 && renderCanColorMod()) {
+        bool toBlack = colorPaletteIsBlack(newPalette);
+        if (toBlack != colorPaletteIsBlack(oldPalette)) {
+            fadeSystemPaletteColorMod(oldPalette, newPalette, steps, toBlack);
+            return;
+        }
+    }
+
     for (int step = 0; step < steps; step++) {
         sharedFpsLimiter.mark();
 
@@ -233,6 +285,145 @@ void fadeSystemPalette(unsigned char* oldPalette, unsigned char* newPalette, int
     sharedFpsLimiter.throttle();
 }
 
+// CE: Same as `fadeSystemPalette`, but palette is only changed at one end
+// and intermediate steps are done with renderer color modulation.
+static void fadeSystemPaletteColorMod(unsigned char* oldPalette, unsigned char* newPalette, int steps, bool toBlack)
+{
+    if (!toBlack) {
+        renderSetColorMod(0);
+        setSystemPalette(newPalette);
+    }
+
+    for (int step = 0; step < steps; step++) {
+        sharedFpsLimiter.mark();
+
+        int level = 255 * step / steps;
+        renderSetColorMod(toBlack ? 255 - level : level);
+
+        if (colorFadeBkFuncP != NULL) {
+            if (step % 128 == 0) {
+                colorFadeBkFuncP();
+            }
+        }
+
+        renderPresent();
+        sharedFpsLimiter.throttle();
+    }
+
+    sharedFpsLimiter.mark();
+    if (toBlack) {
+        setSystemPalette(newPalette);
+    }
+    renderSetColorMod(255);
+    renderPresent();
+    sharedFpsLimiter.throttle();
+}
+
+// CE: Starts palette transition taking `duration` ms which is advanced by
+// background process (see `add_bk_process`), so the caller is not blocked.
+// `callback` is called once new palette is set (right away in turbo mode,
+// where intermediate steps are skipped). Fade which is still in progress is
+// finished first.
+void colorFadeStart(unsigned char* oldPalette, unsigned char* newPalette, unsigned int duration, ColorFadeDoneFunc* callback, void* userData)
+{
+    colorFadeFinish();
+
+    memcpy(colorFade.oldPalette, oldPalette, sizeof(colorFade.oldPalette));
+    memcpy(colorFade.newPalette, newPalette, sizeof(colorFade.newPalette));
+    colorFade.callback = callback;
+    colorFade.userData = userData;
+    colorFade.duration = duration;
+    colorFade.start = get_time();
+    colorFade.active = true;
+
+    if (duration == 0 || is_turbo_mode()) {
+        colorFade.colorMod = false;
+        colorFadeFinish();
+        return;
+    }
+
+    colorFade.toBlack = colorPaletteIsBlack(newPalette);
+    colorFade.colorMod = renderCanColorMod() && colorFade.toBlack != colorPaletteIsBlack(oldPalette);
+
+    if (colorFade.colorMod && !colorFade.toBlack) {
+        renderSetColorMod(0);
+        setSystemPalette(colorFade.newPalette);
+    }
+
+    add_bk_process(colorFadeProcess);
+}
+
+// CE: Returns `true` if fade started with `colorFadeStart` is in progress.
+bool colorFadeIsActive()
+{
+    return colorFade.active;
+}
+
+// CE: Completes fade started with `colorFadeStart` right away.
+void colorFadeFinish()
+{
+    if (!colorFade.active) {
+        return;
+    }
+
+    colorFade.active = false;
+    remove_bk_process(colorFadeProcess);
+
+    setSystemPalette(colorFade.newPalette);
+    if (colorFade.colorMod) {
+        renderSetColorMod(255);
+    }
+
+    ColorFadeDoneFunc* callback = colorFade.callback;
+    colorFade.callback = NULL;
+
+    if (callback != NULL) {
+        callback(colorFade.userData);
+    }
+}
+
+static void colorFadeApply(unsigned int step, unsigned int steps)
+{
+    if (colorFade.colorMod) {
+        int level = (int)(255 * step / steps);
+        renderSetColorMod(colorFade.toBlack ? 255 - level : level);
+        return;
+    }
+
+    unsigned char palette[768];
+    for (int index = 0; index < 768; index++) {
+        palette[index] = colorFade.oldPalette[index] - (colorFade.oldPalette[index] - colorFade.newPalette[index]) * (int)step / (int)steps;
+    }
+
+    setSystemPalette(palette);
+}
+
+static void colorFadeProcess()
+{
+    if (!colorFade.active) {
+        return;
+    }
+
+    unsigned int elapsed = elapsed_time(colorFade.start);
+    if (elapsed >= colorFade.duration) {
+        colorFadeFinish();
+        return;
+    }
+
+    colorFadeApply(elapsed, colorFade.duration);
+}
+
+static bool colorPaletteIsBlack(const unsigned char* palette)
+{
+    for (int index = 0; index < 768; index++) {
+        if (palette[index] != 0) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
 // 0x4BFF94
 void colorSetFadeBkFunc(fade_bk_func* callback)
 {
@@ -325,6 +516,8 @@ static void setIntensityTableColor(int a1)
 // 0x4C0204
 static void setIntensityTables()
 {
+    intensityColorTableVersion++;
+
     for (int index = 0; index < 256; index++) {
         if (mappedColor[index] != 0) {
             setIntensityTableColor(index);
@@ -484,6 +677,7 @@ bool loadColorTable(const char* path)
     if (type == 'NEWC') {
         // NOTE: Uninline.
         colorRead(handle, intensityColorTable, 0x10000);
+        intensityColorTableVersion++;
 
         // NOTE: Uninline.
         colorRead(handle, colorMixAddTable, 0x10000);
@@ -506,6 +700,13 @@ bool loadColorTable(const char* path)
     return true;
 }
 
+// CE: Returns version of `intensityColorTable`, see
+// `intensityColorTableVersion`.
+unsigned int colorIntensityVersion()
+{
+    return intensityColorTableVersion;
+}
+
 // 0x4C063C
 char* colorError()
 {
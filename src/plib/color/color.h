@@ -13,6 +13,7 @@ typedef unsigned char ColorIndex;
 
 typedef const char*(ColorNameMangleFunc)(const char*);
 typedef void(fade_bk_func)();
+typedef void(ColorFadeDoneFunc)(void* userData);
 
 typedef void*(ColorOpenFunc)(const char* path);
 typedef int(ColorReadFunc)(void* fd, void* buffer, size_t size);
@@ -44,12 +45,16 @@ Color RGB2Color(ColorRGB c);
 int Color2RGB(int a1);
 void fadeSystemPalette(unsigned char* oldPalette, unsigned char* newPalette, int steps);
 void colorSetFadeBkFunc(fade_bk_func* callback);
+void colorFadeStart(unsigned char* oldPalette, unsigned char* newPalette, unsigned int duration, ColorFadeDoneFunc* callback, void* userData);
+bool colorFadeIsActive();
+void colorFadeFinish();
 void setBlackSystemPalette();
 void setSystemPalette(unsigned char* palette);
 unsigned char* getSystemPalette();
 void setSystemPaletteEntries(unsigned char* a1, int a2, int a3);
 void getSystemPaletteEntry(int entry, unsigned char* r, unsigned char* g, unsigned char* b);
 bool loadColorTable(const char* path);
+unsigned int colorIntensityVersion();
 char* colorError();
 void setColorPalette(unsigned char* pal);
 void setColorPaletteEntry(int entry, unsigned char r, unsigned char g, unsigned char b);
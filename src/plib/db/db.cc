@@ -11,17 +11,89 @@
 #include <dirent.h>
 #endif
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define DB_SWAP_SSE2
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define DB_SWAP_NEON
+#endif
+
+#include <SDL.h>
 #include <fpattern/fpattern.h>
 
 #include "platform_compat.h"
 #include "plib/assoc/assoc.h"
 #include "plib/db/lzss.h"
+#include "plib/gnw/memory.h"
+#include "plib/gnw/prof.h"
 
 namespace fallout {
 
 #define DB_DATABASE_LIST_CAPACITY 10
 #define DB_DATABASE_FILE_LIST_CAPACITY 32
-#define DB_HASH_TABLE_SIZE 4095
+
+// CE: Entry flag denoting block-compressed entry (type 64) which is followed by
+// a table of big-endian offsets of every 0x4000 byte block. Such entries are
+// produced by `datrepack` tool and allow seeking without decoding preceding
+// blocks. The layout is otherwise identical to ordinary block-compressed
+// entries, so the table is simply ignored by sequential readers.
+#define DB_ENTRY_BLOCK_TABLE 0x100
+
+#define DB_CACHE_BUCKET_COUNT 1024
+
+#define DB_INDEX_MAGIC 0x58494244 // "DBIX"
+#define DB_INDEX_VERSION 2
+#define DB_INDEX_FILE_EXT ".idx"
+
+#define DB_IMAGE_MAGIC 0x4D494244 // "DBIM"
+#define DB_IMAGE_VERSION 1
+#define DB_IMAGE_ALIGNMENT 16
+
+// CE: Sources of `DB_PATH_RECORD`.
+#define DB_PATH_SOURCE_PATCHES 0x1
+#define DB_PATH_SOURCE_DATAFILE 0x2
+
+#define DB_PATH_INDEX_MIN_CAPACITY 1024
+
+// CE: States of `DB_PREFETCH_JOB`.
+#define DB_PREFETCH_QUEUED 0
+#define DB_PREFETCH_RUNNING 1
+#define DB_PREFETCH_DONE 2
+#define DB_PREFETCH_FAILED 3
+
+// CE: Number of elements swapped at once by bulk writers.
+#define DB_SWAP_CHUNK_SIZE 1024
+
+// CE: Stream flag denoting binary write stream which collects output in
+// memory and writes it to file in one go (see `db_write_buffer_put`).
+#define DB_FILE_BUFFERED 0x100
+
+// CE: Stream flag denoting buffered write stream without backing file (see
+// `db_fopen_memory_write`).
+#define DB_FILE_MEMORY 0x200
+
+#define DB_WRITE_BUFFER_INITIAL_CAPACITY 0x10000
+
+// Buffered output is flushed when it grows past this size.
+#define DB_WRITE_BUFFER_MAX_CAPACITY 0x800000
+
+// Maximum number of cached `db_get_file_list` results per database.
+#define DB_FILE_LIST_CACHE_CAPACITY 16
+
+// CE: Container of named members (see `db_pack_write`).
+#define DB_PACK_MAGIC 0x4B504244 // "DBPK"
+#define DB_PACK_VERSION 1
+#define DB_PACK_NAME_LENGTH 16
+#define DB_PACK_HEADER_SIZE 16
+
+// Member is LZSS encoded as a whole.
+#define DB_PACK_MEMBER_COMPRESSED 0x1
+
+#define DB_TRACE_MIN_CAPACITY 256
+
+// Events past this limit are dropped (counters are still updated).
+#define DB_TRACE_MAX_EVENTS 262144
 
 #if defined(_WIN32)
 #define PATH_SEP '\\'
@@ -29,6 +101,9 @@ namespace fallout {
 #define PATH_SEP '/'
 #endif
 
+typedef struct DB_CACHE_ENTRY DB_CACHE_ENTRY;
+typedef struct DB_PREFETCH_JOB DB_PREFETCH_JOB;
+
 typedef struct DB_FILE {
     DB_DATABASE* database;
     unsigned int flags;
@@ -42,19 +117,323 @@ typedef struct DB_FILE {
     int field_18;
     unsigned char* field_1C;
     unsigned char* field_20;
+
+    // CE: Offsets of compressed blocks relative to the beginning of the entry
+    // (see `DB_ENTRY_BLOCK_TABLE`).
+    unsigned int* block_offsets;
+    int block_count;
+
+    // CE: Decompressed entry this stream is a view of (type 128 only).
+    DB_CACHE_ENTRY* cache_entry;
+
+    // CE: I/O tracing (see `db_trace_enable`).
+    bool traced;
+    int trace_record;
+    Uint64 trace_start;
+    size_t trace_bytes;
+
+    // CE: Pending output of buffered write stream.
+    unsigned char* write_buffer;
+    size_t write_length;
+    size_t write_capacity;
 } DB_FILE;
 
+// CE: Decompressed payload of datafile entry kept in `db_cache`.
+typedef struct DB_CACHE_ENTRY {
+    DB_DATABASE* database;
+    int offset;
+    int length;
+    unsigned char* data;
+
+    // The number of open streams viewing [data]. Entries in use are never
+    // evicted.
+    int ref_count;
+
+    // Set when [data] points into startup image (see `db_image_load`) and
+    // must not be freed.
+    bool borrowed;
+
+    // Hash bucket chain.
+    DB_CACHE_ENTRY* next_in_bucket;
+
+    // LRU list, most recently used entries are at the head.
+    DB_CACHE_ENTRY* prev;
+    DB_CACHE_ENTRY* next;
+} DB_CACHE_ENTRY;
+
+typedef struct DB_CACHE {
+    DB_CACHE_ENTRY* buckets[DB_CACHE_BUCKET_COUNT];
+    DB_CACHE_ENTRY* head;
+    DB_CACHE_ENTRY* tail;
+    size_t capacity;
+    size_t size;
+    int entries;
+    unsigned int hits;
+    unsigned int misses;
+    unsigned int evictions;
+} DB_CACHE;
+
+// CE: Datafile entry to be read ahead by prefetch thread.
+typedef struct DB_PREFETCH_JOB {
+    DB_DATABASE* database;
+    dir_entry de;
+
+    // Buffer for decompressed payload (`NULL` for stored entries which are
+    // only advised to the OS). It's allocated and later handed over to
+    // `db_cache` by the main thread, since memory functions registered with
+    // `db_register_mem` are not thread-safe.
+    unsigned char* data;
+
+    int state;
+    DB_PREFETCH_JOB* next;
+
+    // Set for jobs scheduled with `db_read_async`: patches file to try first
+    // (or `NULL`), whether `de` denotes datafile entry to fall back to, and
+    // callback receiving file contents.
+    char* path;
+    bool has_entry;
+    db_read_async_callback* callback;
+    void* user_data;
+
+    // Group given to `db_prefetch_group` (0 for `db_prefetch`), allows
+    // speculative reads to be dropped with `db_prefetch_cancel_group`.
+    int group;
+} DB_PREFETCH_JOB;
+
+// CE: Only job list is shared with prefetch thread, everything else in this
+// module (including `db_cache`) is only accessed from the main thread.
+typedef struct DB_PREFETCH {
+    SDL_Thread* thread;
+    SDL_mutex* mutex;
+
+    // Signalled when jobs are added or finished.
+    SDL_cond* cond;
+
+    // Jobs in submission order (queued, running, and finished ones which are
+    // not yet collected).
+    DB_PREFETCH_JOB* head;
+    DB_PREFETCH_JOB* tail;
+
+    // Size of decompressed buffers held by jobs.
+    size_t size;
+
+    // Set when database is closed, so that prefetch thread does not keep the
+    // datafile open.
+    bool reset_stream;
+    bool quit;
+} DB_PREFETCH;
+
+// CE: Per-file I/O counters.
+typedef struct DB_TRACE_RECORD {
+    char* name;
+    unsigned int hash;
+    int source;
+    unsigned int opens;
+    unsigned int reads;
+    unsigned int seeks;
+    unsigned int cache_hits;
+    size_t bytes_read;
+    size_t bytes_decompressed;
+    Uint64 decode_ticks;
+} DB_TRACE_RECORD;
+
+// CE: Open/close span of a file, or a named mark when `label` is set.
+typedef struct DB_TRACE_EVENT {
+    int record;
+    char* label;
+    Uint64 start;
+    Uint64 end;
+    size_t bytes;
+} DB_TRACE_EVENT;
+
+typedef struct DB_TRACE {
+    bool enabled;
+    Uint64 base;
+
+    DB_TRACE_RECORD* records;
+    int records_length;
+    int records_capacity;
+
+    // Open-addressing table of record indexes (plus one, zero denotes empty
+    // slot), capacity is a power of two.
+    int* slots;
+    int slots_capacity;
+
+    DB_TRACE_EVENT* events;
+    int events_length;
+    int events_capacity;
+    unsigned int dropped_events;
+
+    // Record decompression time is attributed to by `db_decode_entry`.
+    int current;
+} DB_TRACE;
+
+// CE: Startup image, snapshot of `db_cache` taken once game is initialized
+// (see `db_image_save`). Header is followed by `database_count` databases,
+// `entry_count` entries and payloads (aligned to `DB_IMAGE_ALIGNMENT`).
+typedef struct DB_IMAGE_HEADER {
+    unsigned int magic;
+    unsigned int version;
+    unsigned int build_id;
+    int database_count;
+    int entry_count;
+    unsigned int reserved;
+} DB_IMAGE_HEADER;
+
+// Datafile entries were read from, image is only valid while datafile stays
+// the same.
+typedef struct DB_IMAGE_DATABASE {
+    long long datafile_size;
+    long long datafile_mtime;
+    char datafile[COMPAT_MAX_PATH];
+} DB_IMAGE_DATABASE;
+
+typedef struct DB_IMAGE_ENTRY {
+    int database;
+    int offset;
+    int length;
+    unsigned int data_offset;
+} DB_IMAGE_ENTRY;
+
+// CE: Flat datafile directory. It's either built from datafile directory (which
+// is a sequence of serialized assoc arrays), or mapped from a sidecar file
+// saved next to the datafile. All offsets are relative to the beginning of the
+// index. Directories and entries within each directory keep original datafile
+// order (case-insensitive by name).
+typedef struct DB_INDEX_HEADER {
+    unsigned int magic;
+    unsigned int version;
+    long long datafile_size;
+    long long datafile_mtime;
+    int dir_count;
+    int entry_count;
+    unsigned int dirs_offset;
+    unsigned int entries_offset;
+    unsigned int strings_offset;
+    unsigned int strings_size;
+
+    // Offset of `DB_INDEX_PATCHES` (zero if patches are not saved).
+    unsigned int patches_offset;
+    unsigned int reserved;
+} DB_INDEX_HEADER;
+
+typedef struct DB_INDEX_DIR {
+    unsigned int name;
+    int first_entry;
+    int entry_count;
+} DB_INDEX_DIR;
+
+typedef struct DB_INDEX_ENTRY {
+    unsigned int name;
+    dir_entry de;
+} DB_INDEX_ENTRY;
+
+// Snapshot of files found in patches directory (normalized relative paths,
+// see `db_path_normalize`). It's valid as long as modification times of all
+// scanned directories remain the same (adding or removing file or directory
+// updates modification time of the parent directory).
+typedef struct DB_INDEX_PATCHES {
+    unsigned int path;
+    int dir_count;
+    unsigned int dirs_offset;
+    int name_count;
+    unsigned int names_offset;
+    unsigned int reserved;
+} DB_INDEX_PATCHES;
+
+typedef struct DB_INDEX_PATCH_DIR {
+    long long mtime;
+    unsigned int path;
+    unsigned int reserved;
+} DB_INDEX_PATCH_DIR;
+
+typedef struct DB_PATCH_DIR {
+    char* path;
+    long long mtime;
+} DB_PATCH_DIR;
+
+// CE: Location of file known to the database. The same path can be available
+// from both patches and datafile, in which case patches take precedence.
+typedef struct DB_PATH_RECORD {
+    // Hash of the normalized path, zero denotes empty slot.
+    unsigned int hash;
+
+    // Offset of the normalized path in `DB_PATH_INDEX::names`.
+    unsigned int name;
+
+    // Combination of `DB_PATH_SOURCE_*`. Records are never removed, so it can
+    // be zero when patch file is gone after `db_reset_hash_tables`.
+    unsigned int sources;
+
+    // Datafile entry (if `DB_PATH_SOURCE_DATAFILE` is set).
+    dir_entry de;
+} DB_PATH_RECORD;
+
+// CE: Open-addressing (linear probing) hash table of file paths relative to
+// both patches path and datafile path. Replaces original 4095-byte bit table
+// of file names which could only tell that file is definitely not patched.
+typedef struct DB_PATH_INDEX {
+    DB_PATH_RECORD* slots;
+    // Always power of two.
+    int capacity;
+    int length;
+    char* names;
+    size_t names_size;
+    size_t names_capacity;
+} DB_PATH_INDEX;
+
+// CE: Result of `db_get_file_list` (without descriptions).
+typedef struct DB_FILE_LIST_CACHE_ENTRY {
+    // Normalized filespec.
+    char* filespec;
+
+    // Modification time of matching patches directory at the moment of
+    // listing (-1 if it does not exist).
+    long long patches_mtime;
+
+    int count;
+
+    // Names packed in 13 byte slots, in the same order as returned.
+    char* names;
+
+    struct DB_FILE_LIST_CACHE_ENTRY* next;
+} DB_FILE_LIST_CACHE_ENTRY;
+
 typedef struct DB_DATABASE {
     char* datafile;
     FILE* stream;
     char* datafile_path;
     char* patches_path;
     unsigned char should_free_patches_path;
-    assoc_array root;
-    assoc_array* entries;
+
+    // CE: Replaces `root` and `entries` assoc arrays.
+    unsigned char* index_data;
+    size_t index_size;
+    bool index_mapped;
+    bool index_dirty;
+    DB_INDEX_DIR* index_dirs;
+    DB_INDEX_ENTRY* index_entries;
+    char* index_strings;
+    int index_dir_count;
+
+    // CE: Directories scanned while filling path index.
+    DB_PATCH_DIR* patch_dirs;
+    int patch_dirs_length;
+    int patch_dirs_capacity;
+
     int files_length;
     DB_FILE files[DB_DATABASE_FILE_LIST_CAPACITY];
-    unsigned char* hash_table;
+
+    // CE: Replaces original `hash_table`.
+    DB_PATH_INDEX path_index;
+
+    // CE: Read-only view of the entire datafile (see `db_enable_mmap`).
+    unsigned char* mapped_data;
+    size_t mapped_size;
+
+    // CE: Most recently used file lists first.
+    DB_FILE_LIST_CACHE_ENTRY* file_lists;
+    int file_lists_length;
 } DB_DATABASE;
 
 typedef struct DB_FIND_DATA {
@@ -78,16 +457,43 @@ static int db_create_database(DB_DATABASE** database_ptr);
 static int db_destroy_database(DB_DATABASE** database_ptr);
 static int db_init_database(DB_DATABASE* database, const char* datafile, const char* datafile_path);
 static void db_exit_database(DB_DATABASE* database);
+static void db_map_database(DB_DATABASE* database);
+static int db_read_index(DB_DATABASE* database);
+static int db_build_index(DB_DATABASE* database, assoc_array* root, assoc_array* entries);
+static int db_set_index(DB_DATABASE* database, unsigned char* data, size_t size, bool mapped);
+static void db_free_index(DB_DATABASE* database);
+static int db_load_index(DB_DATABASE* database);
+static int db_load_index_patches(DB_DATABASE* database);
+static int db_save_index(DB_DATABASE* database);
+static void db_index_file_path(DB_DATABASE* database, char* path, size_t size);
+static int db_index_find_dir(DB_DATABASE* database, const char* name);
+static int db_index_find_entry(DB_DATABASE* database, int dir_index, const char* name);
+static int db_add_patch_dir(DB_DATABASE* database, const char* path);
+static void db_free_patch_dirs(DB_DATABASE* database);
+static void db_unmap_database(DB_DATABASE* database);
+static unsigned char* db_mapped_entry(DB_DATABASE* database, dir_entry* de);
+static unsigned char* db_mapped_range(DB_DATABASE* database, long offset, long size);
 static int db_init_patches(DB_DATABASE* database, const char* path);
 static void db_exit_patches(DB_DATABASE* database);
 static int db_init_hash_table(DB_DATABASE* database);
 static int db_reset_hash_table(DB_DATABASE* database);
 static int db_fill_hash_table(DB_DATABASE* database, const char* path);
 static int db_add_hash_entry_to_database(DB_DATABASE* database, const char* path, int sep);
-static int db_set_hash_value(DB_DATABASE* database, unsigned int key, unsigned char enabled);
-static int db_get_hash_value(DB_DATABASE* database, const char* path, int sep, int* value_ptr);
-static int db_hash_string_to_key(const char* path, int sep, unsigned int* key_ptr);
 static void db_exit_hash_table(DB_DATABASE* database);
+static int db_path_normalize(const char* path, int sep, char* dest, size_t size);
+static unsigned int db_path_hash(const char* normalized_path);
+static const char* db_path_skip_prefix(const char* path, const char* prefix);
+static int db_path_index_lookup(DB_DATABASE* database, const char* name, DB_PATH_RECORD** record_ptr);
+static DB_PATH_RECORD* db_path_index_find(DB_PATH_INDEX* path_index, const char* normalized_path, unsigned int hash);
+static DB_PATH_RECORD* db_path_index_insert(DB_PATH_INDEX* path_index, const char* normalized_path);
+static int db_path_index_resize(DB_PATH_INDEX* path_index, int capacity);
+static int db_path_index_add_datafile(DB_DATABASE* database);
+static int db_path_index_add_patch(DB_DATABASE* database, const char* normalized_path);
+static long long db_file_list_patches_mtime(DB_DATABASE* database, const char* filespec, bool relative);
+static int db_file_list_cache_find(DB_DATABASE* database, const char* filespec, long long patches_mtime, char*** filelist);
+static void db_file_list_cache_add(DB_DATABASE* database, const char* filespec, long long patches_mtime, char** filelist, int count);
+static void db_file_list_cache_flush(DB_DATABASE* database);
+static void db_file_list_cache_free_entry(DB_FILE_LIST_CACHE_ENTRY* entry);
 static DB_FILE* db_add_fp_rec(FILE* stream, unsigned char* a2, int a3, int flags);
 static int db_delete_fp_rec(DB_FILE* stream);
 static int db_find_empty_position(int* position_ptr);
@@ -102,7 +508,49 @@ static void* db_default_malloc(size_t size);
 static char* db_default_strdup(const char* string);
 static void db_default_free(void* ptr);
 static void db_preload_buffer(DB_FILE* stream);
+static int db_load_block_table(DB_FILE* stream, dir_entry* de);
+static int db_decode_entry(DB_DATABASE* database, dir_entry* de, unsigned char* buf);
+static int db_decode_stream_entry(DB_DATABASE* database, dir_entry* de, unsigned char* buf);
+static int db_decode_mapped_entry(unsigned char* mapped, dir_entry* de, unsigned char* buf);
+static DB_CACHE_ENTRY* db_cache_find(DB_DATABASE* database, int offset);
+static DB_CACHE_ENTRY* db_cache_insert(DB_DATABASE* database, int offset, unsigned char* data, int length);
+static bool db_cache_make_room(size_t size);
+static void db_cache_remove(DB_CACHE_ENTRY* entry);
+static void db_cache_release(DB_CACHE_ENTRY* entry);
+static void db_cache_flush_database(DB_DATABASE* database);
+static DB_FILE* db_add_cache_fp_rec(DB_CACHE_ENTRY* entry, int flags);
+static bool db_cache_contains(DB_DATABASE* database, int offset);
+static unsigned int db_image_hash(const char* string);
+static void db_image_release();
+static int db_prefetch_init();
+static void db_prefetch_exit();
+static int db_prefetch_thread(void* data);
+static void db_prefetch_run(DB_PREFETCH_JOB* job, FILE** stream_ptr, DB_DATABASE** stream_database_ptr);
+static unsigned char* db_prefetch_read(DB_PREFETCH_JOB* job, FILE** stream_ptr, DB_DATABASE** stream_database_ptr, size_t* size_ptr);
+static void db_prefetch_collect(DB_DATABASE* database, int offset);
+static void db_prefetch_cancel(DB_DATABASE* database);
+static void db_prefetch_free_job(DB_PREFETCH_JOB* job);
+static Uint64 db_trace_now();
+static int db_trace_find_record(const char* name, int source);
+static int db_trace_resize(int capacity);
+static DB_FILE* db_trace_open(DB_FILE* stream, int record, Uint64 start);
+static void db_trace_close(DB_FILE* stream);
+static void db_trace_read(int record, Uint64 start, size_t bytes);
+static void db_trace_decoded(int record, Uint64 start, size_t bytes);
+static void db_trace_add_event(int record, const char* label, Uint64 start, Uint64 end, size_t bytes);
+static double db_trace_ticks_to_ms(Uint64 ticks);
+static const char* db_trace_source_name(int source);
 static int fread_short(FILE* stream, unsigned short* s);
+static void db_swap_16(unsigned short* values, int count);
+static void db_swap_32(unsigned int* values, int count);
+static int db_fread_swapped(DB_FILE* stream, void* ptr, size_t size, int count);
+static int db_fwrite_swapped(DB_FILE* stream, const void* ptr, size_t size, int count);
+static bool db_write_buffer_reserve(DB_FILE* stream, size_t size);
+static int db_write_buffer_flush(DB_FILE* stream);
+static int db_pack_write_int(FILE* stream, unsigned int value);
+static inline bool db_write_buffer_put(DB_FILE* stream, const void* data, size_t size);
+static inline bool db_write_buffer_put_16(DB_FILE* stream, unsigned short value);
+static inline bool db_write_buffer_put_32(DB_FILE* stream, unsigned int value);
 
 static inline bool fileFindIsDirectory(DB_FIND_DATA* find_data);
 static inline char* fileFindGetName(DB_FIND_DATA* find_data);
@@ -128,6 +576,21 @@ static db_free_func* db_free = db_default_free;
 // 0x539D48
 static bool hash_is_on = false;
 
+static bool mmap_is_on = false;
+
+static bool index_is_on = false;
+
+static DB_CACHE db_cache;
+
+// CE: Startup image backing borrowed cache entries (see `db_image_load`).
+static unsigned char* db_image_data = NULL;
+static size_t db_image_size = 0;
+static bool db_image_mapped = false;
+
+static DB_PREFETCH db_prefetch_state;
+
+static DB_TRACE db_trace = { false, 0, NULL, 0, 0, NULL, 0, NULL, 0, 0, 0, -1 };
+
 // NOTE: Original type is `unsigned long`.
 //
 // 0x539D4C
@@ -147,6 +610,8 @@ static DB_DATABASE* database_list[DB_DATABASE_LIST_CAPACITY];
 // 0x4AEE90
 DB_DATABASE* db_init(const char* datafile, const char* datafile_path, const char* patches_path, int show_cursor)
 {
+    MemTagScope memTagScope(MEM_TAG_DB);
+
     DB_DATABASE* database;
 
     if (db_create_database(&database) != 0) {
@@ -169,10 +634,14 @@ DB_DATABASE* db_init(const char* datafile, const char* datafile_path, const char
 
     if (hash_is_on) {
         if (db_init_hash_table(database) != 0) {
-            database->hash_table = NULL;
+            db_exit_hash_table(database);
         }
     }
 
+    if (index_is_on && database->index_dirty) {
+        db_save_index(database);
+    }
+
     return database;
 }
 
@@ -236,6 +705,8 @@ int db_close(DB_DATABASE* db_handle)
                 current_database = NULL;
             }
 
+            db_prefetch_cancel(database_list[index]);
+            db_cache_flush_database(database_list[index]);
             db_exit_database(database_list[index]);
             db_exit_patches(database_list[index]);
             db_exit_hash_table(database_list[index]);
@@ -253,11 +724,18 @@ void db_exit()
 {
     int index;
 
+    db_prefetch_exit();
+
     for (index = 0; index < DB_DATABASE_LIST_CAPACITY; index++) {
         if (database_list[index] != NULL) {
             db_close(database_list[index]);
         }
     }
+
+    db_image_release();
+
+    db_trace_reset();
+    db_trace_enable(false);
 }
 
 // 0x4AF068
@@ -266,7 +744,8 @@ int db_dir_entry(const char* name, dir_entry* de)
     char path[COMPAT_MAX_PATH];
     bool v2;
     bool v3;
-    int value;
+    bool indexed;
+    DB_PATH_RECORD* record;
     FILE* stream;
 
     if (current_database == NULL) {
@@ -287,6 +766,10 @@ int db_dir_entry(const char* name, dir_entry* de)
         v2 = false;
     }
 
+    // CE: Resolve both patches and datafile with a single path index probe.
+    record = NULL;
+    indexed = v2 && db_path_index_lookup(current_database, name, &record) == 0;
+
     if (current_database->patches_path != NULL) {
         stream = NULL;
         v3 = false;
@@ -297,7 +780,7 @@ int db_dir_entry(const char* name, dir_entry* de)
 
         compat_windows_path_to_native(path);
 
-        if (db_get_hash_value(current_database, path, PATH_SEP, &value) != 0 || value == 1) {
+        if (!indexed || (record != NULL && (record->sources & DB_PATH_SOURCE_PATCHES) != 0)) {
             v3 = true;
         }
 
@@ -319,14 +802,22 @@ int db_dir_entry(const char* name, dir_entry* de)
         return -1;
     }
 
-    if (v2) {
-        snprintf(path, sizeof(path), "%s%s", current_database->datafile_path, name);
-    }
+    if (indexed) {
+        if (record == NULL || (record->sources & DB_PATH_SOURCE_DATAFILE) == 0) {
+            return -1;
+        }
 
-    compat_strupr(path);
+        *de = record->de;
+    } else {
+        if (v2) {
+            snprintf(path, sizeof(path), "%s%s", current_database->datafile_path, name);
+        }
 
-    if (db_find_dir_entry(path, de) != 0) {
-        return -1;
+        compat_strupr(path);
+
+        if (db_find_dir_entry(path, de) != 0) {
+            return -1;
+        }
     }
 
     if (de->flags == 0) {
@@ -345,7 +836,8 @@ int db_read_to_buf(const char* filename, unsigned char* buf)
     char path[COMPAT_MAX_PATH];
     bool v3;
     FILE* stream;
-    int hash_value;
+    bool indexed;
+    DB_PATH_RECORD* record;
     int size;
     size_t bytes_read;
     int remaining_size;
@@ -353,6 +845,11 @@ int db_read_to_buf(const char* filename, unsigned char* buf)
     dir_entry de;
     unsigned char* end;
     unsigned short v4;
+    unsigned char* mapped;
+    DB_CACHE_ENTRY* cache_entry;
+    int trace_record;
+    Uint64 trace_start;
+    Uint64 decode_start;
 
     if (current_database == NULL) {
         return -1;
@@ -366,12 +863,20 @@ int db_read_to_buf(const char* filename, unsigned char* buf)
         return -1;
     }
 
+    ProfScope profScope(PROF_ZONE_DB_READ, filename);
+
+    trace_start = db_trace_now();
+
     v1 = true;
     if (filename[0] == '@') {
         strcpy(path, filename + 1);
         v1 = false;
     }
 
+    // CE: Resolve both patches and datafile with a single path index probe.
+    record = NULL;
+    indexed = v1 && db_path_index_lookup(current_database, filename, &record) == 0;
+
     if (current_database->patches_path != NULL) {
         stream = NULL;
         v3 = false;
@@ -382,7 +887,7 @@ int db_read_to_buf(const char* filename, unsigned char* buf)
 
         compat_windows_path_to_native(path);
 
-        if (db_get_hash_value(current_database, path, PATH_SEP, &hash_value) != 0 || hash_value == 1) {
+        if (!indexed || (record != NULL && (record->sources & DB_PATH_SOURCE_PATCHES) != 0)) {
             v3 = true;
         }
 
@@ -417,6 +922,8 @@ int db_read_to_buf(const char* filename, unsigned char* buf)
 
             fclose(stream);
 
+            db_trace_read(db_trace_find_record(filename, DB_TRACE_SOURCE_PATCHES), trace_start, size);
+
             return 0;
         }
     }
@@ -425,20 +932,45 @@ int db_read_to_buf(const char* filename, unsigned char* buf)
         return -1;
     }
 
-    if (v1) {
-        snprintf(path, sizeof(path), "%s%s", current_database->datafile_path, filename);
-    }
+    if (indexed) {
+        if (record == NULL || (record->sources & DB_PATH_SOURCE_DATAFILE) == 0) {
+            return -1;
+        }
+
+        de = record->de;
+    } else {
+        if (v1) {
+            snprintf(path, sizeof(path), "%s%s", current_database->datafile_path, filename);
+        }
 
-    compat_strupr(path);
+        compat_strupr(path);
 
-    if (db_find_dir_entry(path, &de) == -1) {
-        return -1;
+        if (db_find_dir_entry(path, &de) == -1) {
+            return -1;
+        }
     }
 
     if (current_database->stream == NULL) {
         return -1;
     }
 
+    trace_record = db_trace_find_record(filename, DB_TRACE_SOURCE_DATAFILE);
+    db_trace.current = trace_record;
+
+    db_prefetch_collect(current_database, de.offset);
+
+    cache_entry = db_cache_find(current_database, de.offset);
+    if (cache_entry != NULL) {
+        memcpy(buf, cache_entry->data, cache_entry->length);
+
+        if (trace_record != -1) {
+            db_trace.records[trace_record].cache_hits++;
+        }
+        db_trace_read(trace_record, trace_start, cache_entry->length);
+
+        return 0;
+    }
+
     if (fseek(current_database->stream, de.offset, SEEK_SET) != 0) {
         return -1;
     }
@@ -447,12 +979,40 @@ int db_read_to_buf(const char* filename, unsigned char* buf)
         de.flags = 16;
     }
 
+    mapped = db_mapped_entry(current_database, &de);
+
     switch (de.flags & 0xF0) {
     case 16:
-        lzss_decode_to_buf(current_database->stream, buf, de.field_C);
+        if (db_decode_entry(current_database, &de, buf) != 0) {
+            return -1;
+        }
         break;
     case 32:
-        if (read_callback != NULL) {
+        if (mapped != NULL) {
+            if (read_callback != NULL) {
+                remaining_size = de.length;
+                chunk_size = read_threshold - read_count;
+
+                while (remaining_size >= chunk_size) {
+                    memcpy(buf, mapped, chunk_size);
+                    buf += chunk_size;
+                    mapped += chunk_size;
+                    remaining_size -= chunk_size;
+
+                    read_count = 0;
+                    read_callback();
+
+                    chunk_size = read_threshold;
+                }
+
+                if (remaining_size != 0) {
+                    memcpy(buf, mapped, remaining_size);
+                    read_count += remaining_size;
+                }
+            } else {
+                memcpy(buf, mapped, de.length);
+            }
+        } else if (read_callback != NULL) {
             remaining_size = de.length;
             chunk_size = read_threshold - read_count;
 
@@ -492,7 +1052,13 @@ int db_read_to_buf(const char* filename, unsigned char* buf)
                             read_callback();
                         }
                     } else {
-                        read_count += lzss_decode_to_buf(current_database->stream, buf, v4);
+                        ProfScope profScope(PROF_ZONE_LZSS_DECODE);
+                        decode_start = db_trace_now();
+                        bytes_read = lzss_decode_to_buf(current_database->stream, buf, v4);
+                        db_trace_decoded(trace_record, decode_start, bytes_read);
+
+                        buf += bytes_read;
+                        read_count += bytes_read;
                         while (read_count >= read_threshold) {
                             read_count -= read_threshold;
                             read_callback();
@@ -501,37 +1067,38 @@ int db_read_to_buf(const char* filename, unsigned char* buf)
                 }
             }
         } else {
-            while (buf < end) {
-                if (fread_short(current_database->stream, &v4) == 0) {
-                    if ((v4 & 0x8000) != 0) {
-                        v4 &= ~0x8000;
-                        fread(buf, 1, v4, current_database->stream);
-                        buf += v4;
-                    } else {
-                        buf += lzss_decode_to_buf(current_database->stream, buf, v4);
-                    }
-                }
+            if (db_decode_entry(current_database, &de, buf) != 0) {
+                return -1;
             }
         }
     }
 
+    db_trace_read(trace_record, trace_start, de.length);
+
     return 0;
 }
 
 // 0x4AF9C4
 DB_FILE* db_fopen(const char* filename, const char* mode)
 {
+    MemTagScope memTagScope(MEM_TAG_DB);
+
     bool v1;
     char path[COMPAT_MAX_PATH];
     FILE* stream;
     bool v2;
-    int hash_value;
+    bool indexed;
+    DB_PATH_RECORD* record;
     int mode_value;
     bool mode_is_text;
+    bool mode_is_update;
     int flags;
     int k;
     dir_entry de;
     unsigned char* buf;
+    DB_CACHE_ENTRY* cache_entry;
+    int trace_record;
+    Uint64 trace_start;
 
     if (current_database == NULL) {
         return NULL;
@@ -551,12 +1118,16 @@ DB_FILE* db_fopen(const char* filename, const char* mode)
 
     mode_value = -1;
     mode_is_text = true;
+    mode_is_update = false;
     for (k = 0; mode[k] != '\0'; k++) {
         switch (mode[k]) {
         case 'b':
             mode_is_text = false;
             break;
         case '+':
+            mode_is_update = true;
+            mode_value = 0;
+            break;
         case 'a':
         case 'w':
             mode_value = 0;
@@ -571,6 +1142,8 @@ DB_FILE* db_fopen(const char* filename, const char* mode)
         return NULL;
     }
 
+    trace_start = db_trace_now();
+
     stream = NULL;
     flags = 1;
     if (mode_is_text) {
@@ -583,6 +1156,10 @@ DB_FILE* db_fopen(const char* filename, const char* mode)
         v1 = false;
     }
 
+    // CE: Resolve both patches and datafile with a single path index probe.
+    record = NULL;
+    indexed = v1 && mode_value != 0 && db_path_index_lookup(current_database, filename, &record) == 0;
+
     if (current_database->patches_path != NULL) {
         v2 = false;
 
@@ -594,9 +1171,10 @@ DB_FILE* db_fopen(const char* filename, const char* mode)
 
         if (mode_value == 0) {
             db_add_hash_entry_to_database(current_database, path, PATH_SEP);
+            db_file_list_invalidate();
             v2 = true;
         } else {
-            if (db_get_hash_value(current_database, path, PATH_SEP, &hash_value) != 0 || hash_value == 1) {
+            if (!indexed || (record != NULL && (record->sources & DB_PATH_SOURCE_PATCHES) != 0)) {
                 v2 = true;
             }
         }
@@ -606,7 +1184,16 @@ DB_FILE* db_fopen(const char* filename, const char* mode)
         }
 
         if (stream != NULL) {
-            return db_add_fp_rec(stream, NULL, 0, flags | 0x4);
+            if (mode_value == 0) {
+                // CE: Output of binary write-only streams is buffered.
+                if (!mode_is_text && !mode_is_update) {
+                    flags |= DB_FILE_BUFFERED;
+                }
+                return db_add_fp_rec(stream, NULL, 0, flags | 0x4);
+            }
+
+            trace_record = db_trace_find_record(filename, DB_TRACE_SOURCE_PATCHES);
+            return db_trace_open(db_add_fp_rec(stream, NULL, 0, flags | 0x4), trace_record, trace_start);
         }
     }
 
@@ -618,21 +1205,25 @@ DB_FILE* db_fopen(const char* filename, const char* mode)
         return NULL;
     }
 
-    if (v1) {
-        snprintf(path, sizeof(path), "%s%s", current_database->datafile_path, filename);
-    }
+    if (indexed) {
+        if (record == NULL || (record->sources & DB_PATH_SOURCE_DATAFILE) == 0) {
+            return NULL;
+        }
 
-    compat_strupr(path);
+        de = record->de;
+    } else {
+        if (v1) {
+            snprintf(path, sizeof(path), "%s%s", current_database->datafile_path, filename);
+        }
 
-    if (db_find_dir_entry(path, &de) == -1) {
-        return NULL;
-    }
+        compat_strupr(path);
 
-    if (current_database->stream == NULL) {
-        return NULL;
+        if (db_find_dir_entry(path, &de) == -1) {
+            return NULL;
+        }
     }
 
-    if (fseek(current_database->stream, de.offset, SEEK_SET) != 0) {
+    if (current_database->stream == NULL) {
         return NULL;
     }
 
@@ -640,20 +1231,79 @@ DB_FILE* db_fopen(const char* filename, const char* mode)
         de.flags = 16;
     }
 
+    trace_record = db_trace_find_record(filename, DB_TRACE_SOURCE_DATAFILE);
+    db_trace.current = trace_record;
+
+    // CE: Compressed entries are served from cache of decompressed payloads
+    // when it's enabled (see `db_cache_set_size`).
+    if ((de.flags & 0xF0) == 16 || (de.flags & 0xF0) == 64) {
+        db_prefetch_collect(current_database, de.offset);
+
+        cache_entry = db_cache_find(current_database, de.offset);
+        if (cache_entry != NULL) {
+            if (trace_record != -1) {
+                db_trace.records[trace_record].cache_hits++;
+            }
+            return db_trace_open(db_add_cache_fp_rec(cache_entry, flags), trace_record, trace_start);
+        }
+
+        if (db_cache.capacity != 0 && (size_t)de.length <= db_cache.capacity / 8) {
+            db_cache.misses++;
+
+            buf = (unsigned char*)internal_malloc(de.length);
+            if (buf == NULL) {
+                return NULL;
+            }
+
+            if (db_decode_entry(current_database, &de, buf) != 0) {
+                internal_free(buf);
+                return NULL;
+            }
+
+            cache_entry = db_cache_insert(current_database, de.offset, buf, de.length);
+            if (cache_entry != NULL) {
+                return db_trace_open(db_add_cache_fp_rec(cache_entry, flags), trace_record, trace_start);
+            }
+
+            // There is no room in cache (all entries are in use), continue
+            // with private buffer.
+            return db_trace_open(db_add_fp_rec(NULL, buf, de.length, flags | 0x10 | 0x8), trace_record, trace_start);
+        }
+    }
+
+    if (fseek(current_database->stream, de.offset, SEEK_SET) != 0) {
+        return NULL;
+    }
+
     switch (de.flags & 0xF0) {
     case 16:
         buf = (unsigned char*)internal_malloc(de.length);
         if (buf != NULL) {
-            lzss_decode_to_buf(current_database->stream, buf, de.field_C);
-            return db_add_fp_rec(NULL, buf, de.length, flags | 0x10 | 0x8);
+            if (db_decode_entry(current_database, &de, buf) != 0) {
+                internal_free(buf);
+                return NULL;
+            }
+            return db_trace_open(db_add_fp_rec(NULL, buf, de.length, flags | 0x10 | 0x8), trace_record, trace_start);
         }
         break;
     case 32:
-        return db_add_fp_rec(current_database->stream, NULL, de.length, flags | 0x20 | 0x8);
+        // CE: Stored entries of mapped datafile are served as in-memory views
+        // (which are handled mostly the same way as decompressed entries).
+        buf = db_mapped_entry(current_database, &de);
+        if (buf != NULL) {
+            return db_trace_open(db_add_fp_rec(NULL, buf, de.length, flags | 0x80 | 0x8), trace_record, trace_start);
+        }
+        return db_trace_open(db_add_fp_rec(current_database->stream, NULL, de.length, flags | 0x20 | 0x8), trace_record, trace_start);
     case 64:
         buf = (unsigned char*)internal_malloc(0x4000);
         if (buf != NULL) {
-            return db_add_fp_rec(current_database->stream, buf, de.length, flags | 0x40 | 0x8);
+            DB_FILE* stream = db_add_fp_rec(current_database->stream, buf, de.length, flags | 0x40 | 0x8);
+            if (stream != NULL && (de.flags & DB_ENTRY_BLOCK_TABLE) != 0) {
+                // Failure to load block table is not fatal, seeking falls
+                // back to sequential decoding.
+                db_load_block_table(stream, &de);
+            }
+            return db_trace_open(stream, trace_record, trace_start);
         }
         break;
     }
@@ -667,92 +1317,385 @@ int db_fclose(DB_FILE* stream)
     return db_delete_fp_rec(stream);
 }
 
-// 0x4AFD50
-size_t db_fread(void* ptr, size_t size, size_t count, DB_FILE* stream)
+// CE: Opens read-only binary stream over [size] bytes of [data]. The data is
+// not copied and must outlive the stream.
+DB_FILE* db_fopen_memory(const unsigned char* data, size_t size)
 {
-    int remaining_size;
-    int chunk_size;
-    size_t bytes_read;
-    unsigned char* buf;
-    size_t elements_read;
-    size_t v1;
+    if (current_database == NULL) {
+        return NULL;
+    }
 
-    buf = (unsigned char*)ptr;
-    elements_read = 0;
+    if (data == NULL) {
+        return NULL;
+    }
 
-    if (stream != NULL) {
-        if ((stream->flags & 0x4) != 0) {
-            if (read_callback != NULL) {
-                remaining_size = size * count;
-                chunk_size = read_threshold - read_count;
+    return db_add_fp_rec(NULL, (unsigned char*)data, (int)size, 0x1 | 0x80 | 0x8);
+}
 
-                while (remaining_size >= chunk_size) {
-                    bytes_read = fread(buf, 1, chunk_size, stream->uncompressed_file_stream);
-                    buf += bytes_read;
-                    remaining_size -= bytes_read;
-                    elements_read += bytes_read;
+// CE: Opens binary write stream which keeps its output in memory. Output is
+// obtained with `db_fclose_memory`.
+DB_FILE* db_fopen_memory_write()
+{
+    if (current_database == NULL) {
+        return NULL;
+    }
 
-                    read_count = 0;
-                    read_callback();
+    return db_add_fp_rec(NULL, NULL, 0, 0x1 | 0x4 | DB_FILE_BUFFERED | DB_FILE_MEMORY);
+}
 
-                    chunk_size = read_threshold;
-                }
+// CE: Closes stream opened with `db_fopen_memory_write` and passes ownership
+// of its output to the caller (to be released with `db_free_memory`).
+unsigned char* db_fclose_memory(DB_FILE* stream, size_t* size_ptr)
+{
+    unsigned char* data;
 
-                if (remaining_size != 0) {
-                    elements_read += fread(buf, 1, remaining_size, stream->uncompressed_file_stream);
-                    read_count += remaining_size;
-                }
+    *size_ptr = 0;
 
-                elements_read /= size;
-            } else {
-                elements_read = fread(buf, size, count, stream->uncompressed_file_stream);
-            }
-        } else {
-            if (ptr != NULL) {
-                switch (stream->flags & 0xF0) {
-                case 16:
-                    if (stream->field_10 != 0) {
-                        elements_read = stream->field_10 / size;
-                        if (elements_read > count) {
-                            elements_read = count;
-                        }
+    if (stream == NULL || (stream->flags & DB_FILE_MEMORY) == 0) {
+        return NULL;
+    }
 
-                        if (elements_read != 0) {
-                            remaining_size = elements_read * size;
-                            if (read_callback != NULL) {
-                                chunk_size = read_threshold - read_count;
-                                while (remaining_size >= chunk_size) {
-                                    remaining_size -= chunk_size;
-                                    memcpy(buf, stream->field_20, chunk_size);
+    data = stream->write_buffer;
+    *size_ptr = stream->write_length;
 
-                                    buf += chunk_size;
-                                    stream->field_20 += chunk_size;
-                                    stream->field_10 -= chunk_size;
+    stream->write_buffer = NULL;
+    stream->write_length = 0;
+    db_delete_fp_rec(stream);
 
-                                    read_count = 0;
-                                    read_callback();
+    return data;
+}
 
-                                    chunk_size = read_threshold;
-                                }
+void db_free_memory(void* ptr)
+{
+    if (ptr != NULL) {
+        internal_free(ptr);
+    }
+}
 
-                                if (remaining_size != 0) {
-                                    memcpy(buf, stream->field_20, remaining_size);
-                                    stream->field_20 += remaining_size;
-                                    stream->field_10 -= remaining_size;
-                                    read_count += remaining_size;
-                                }
-                            } else {
-                                memcpy(ptr, stream->field_20, remaining_size);
-                                stream->field_20 += remaining_size;
-                                stream->field_10 -= remaining_size;
-                            }
-                        }
-                    }
-                    break;
-                case 32:
-                    if (stream->field_10 != 0) {
-                        elements_read = stream->field_10 / size;
-                        if (elements_read > count) {
+// CE: Writes [count] members into single container file at native [path].
+//
+// Container starts with header (magic, version, member count and offset of
+// table of contents) followed by member data. Table of contents is written
+// last, so members are streamed one at a time. Every entry of the table has
+// zero padded name, flags, offset, stored size and size of member. Members
+// are LZSS encoded unless that does not make them smaller. All numbers are
+// big-endian.
+//
+// Only uses stdio and `malloc` so it can be called from any thread.
+int db_pack_write(const char* path, const db_pack_member* members, int count)
+{
+    FILE* stream;
+    unsigned int* entries;
+    unsigned char* encoded;
+    size_t encoded_capacity;
+    unsigned int toc_offset;
+    int rc;
+    int index;
+
+    if (count < 0 || (count != 0 && members == NULL)) {
+        return -1;
+    }
+
+    stream = compat_fopen(path, "wb");
+    if (stream == NULL) {
+        return -1;
+    }
+
+    // Flags, offset, stored size and size of every member.
+    entries = (unsigned int*)malloc(sizeof(*entries) * 4 * (count != 0 ? count : 1));
+    encoded = NULL;
+    encoded_capacity = 0;
+    rc = -1;
+
+    if (entries == NULL) {
+        goto out;
+    }
+
+    if (db_pack_write_int(stream, DB_PACK_MAGIC) == -1
+        || db_pack_write_int(stream, DB_PACK_VERSION) == -1
+        || db_pack_write_int(stream, (unsigned int)count) == -1
+        || db_pack_write_int(stream, 0) == -1) {
+        goto out;
+    }
+
+    for (index = 0; index < count; index++) {
+        const db_pack_member* member = &(members[index]);
+        const unsigned char* data = member->data;
+        unsigned int length = (unsigned int)member->size;
+        unsigned int flags = 0;
+
+        if (length != 0) {
+            size_t bound = LZSS_ENCODE_BOUND(member->size);
+            if (bound > encoded_capacity) {
+                unsigned char* buffer = (unsigned char*)realloc(encoded, bound);
+                if (buffer == NULL) {
+                    goto out;
+                }
+
+                encoded = buffer;
+                encoded_capacity = bound;
+            }
+
+            unsigned int encoded_length = lzss_encode_to_buf(member->data, length, encoded);
+            if (encoded_length < length) {
+                data = encoded;
+                length = encoded_length;
+                flags |= DB_PACK_MEMBER_COMPRESSED;
+            }
+        }
+
+        entries[index * 4] = flags;
+        entries[index * 4 + 1] = (unsigned int)ftell(stream);
+        entries[index * 4 + 2] = length;
+        entries[index * 4 + 3] = (unsigned int)member->size;
+
+        if (length != 0 && fwrite(data, length, 1, stream) != 1) {
+            goto out;
+        }
+    }
+
+    toc_offset = (unsigned int)ftell(stream);
+
+    for (index = 0; index < count; index++) {
+        char name[DB_PACK_NAME_LENGTH];
+        memset(name, 0, sizeof(name));
+        strncpy(name, members[index].name, sizeof(name) - 1);
+
+        if (fwrite(name, sizeof(name), 1, stream) != 1) {
+            goto out;
+        }
+
+        for (int field = 0; field < 4; field++) {
+            if (db_pack_write_int(stream, entries[index * 4 + field]) == -1) {
+                goto out;
+            }
+        }
+    }
+
+    if (fseek(stream, DB_PACK_HEADER_SIZE - 4, SEEK_SET) != 0) {
+        goto out;
+    }
+
+    if (db_pack_write_int(stream, toc_offset) == -1) {
+        goto out;
+    }
+
+    rc = 0;
+
+out:
+
+    if (fclose(stream) != 0) {
+        rc = -1;
+    }
+
+    if (entries != NULL) {
+        free(entries);
+    }
+
+    if (encoded != NULL) {
+        free(encoded);
+    }
+
+    return rc;
+}
+
+// CE: Opens member of container written by `db_pack_write` as read-only
+// binary stream. Member is decoded into memory, container itself is not
+// kept open.
+DB_FILE* db_fopen_pack(const char* pack_path, const char* name)
+{
+    DB_FILE* stream;
+    int magic;
+    int version;
+    int count;
+    int toc_offset;
+    int flags;
+    int offset;
+    int stored_length;
+    int length;
+    unsigned char* stored;
+    unsigned char* data;
+    bool found;
+
+    if (current_database == NULL) {
+        return NULL;
+    }
+
+    stream = db_fopen(pack_path, "rb");
+    if (stream == NULL) {
+        return NULL;
+    }
+
+    if (db_freadInt32(stream, &magic) == -1
+        || magic != DB_PACK_MAGIC
+        || db_freadInt32(stream, &version) == -1
+        || version != DB_PACK_VERSION
+        || db_freadInt32(stream, &count) == -1
+        || db_freadInt32(stream, &toc_offset) == -1
+        || db_fseek(stream, toc_offset, SEEK_SET) != 0) {
+        db_fclose(stream);
+        return NULL;
+    }
+
+    found = false;
+    for (int index = 0; index < count; index++) {
+        char entry_name[DB_PACK_NAME_LENGTH + 1];
+        if (db_fread(entry_name, DB_PACK_NAME_LENGTH, 1, stream) != 1
+            || db_freadInt32(stream, &flags) == -1
+            || db_freadInt32(stream, &offset) == -1
+            || db_freadInt32(stream, &stored_length) == -1
+            || db_freadInt32(stream, &length) == -1) {
+            break;
+        }
+
+        entry_name[DB_PACK_NAME_LENGTH] = '\0';
+        if (compat_stricmp(entry_name, name) == 0) {
+            found = true;
+            break;
+        }
+    }
+
+    if (!found || stored_length < 0 || length < 0 || db_fseek(stream, offset, SEEK_SET) != 0) {
+        db_fclose(stream);
+        return NULL;
+    }
+
+    // Decoded data is owned by the stream (type 16).
+    data = (unsigned char*)internal_malloc(length != 0 ? length : 1);
+    if (data == NULL) {
+        db_fclose(stream);
+        return NULL;
+    }
+
+    if ((flags & DB_PACK_MEMBER_COMPRESSED) != 0) {
+        stored = (unsigned char*)internal_malloc(stored_length != 0 ? stored_length : 1);
+        if (stored == NULL
+            || db_fread(stored, 1, stored_length, stream) != (size_t)stored_length
+            || lzss_decode_mem_to_buf(stored, stored_length, data, length) != length) {
+            if (stored != NULL) {
+                internal_free(stored);
+            }
+            internal_free(data);
+            db_fclose(stream);
+            return NULL;
+        }
+
+        internal_free(stored);
+    } else {
+        if (db_fread(data, 1, length, stream) != (size_t)length) {
+            internal_free(data);
+            db_fclose(stream);
+            return NULL;
+        }
+    }
+
+    db_fclose(stream);
+
+    stream = db_add_fp_rec(NULL, data, length, 0x1 | 0x10 | 0x8);
+    if (stream == NULL) {
+        internal_free(data);
+    }
+
+    return stream;
+}
+
+static int db_pack_write_int(FILE* stream, unsigned int value)
+{
+    unsigned char bytes[4];
+    bytes[0] = (value >> 24) & 0xFF;
+    bytes[1] = (value >> 16) & 0xFF;
+    bytes[2] = (value >> 8) & 0xFF;
+    bytes[3] = value & 0xFF;
+    return fwrite(bytes, sizeof(bytes), 1, stream) == 1 ? 0 : -1;
+}
+
+// 0x4AFD50
+size_t db_fread(void* ptr, size_t size, size_t count, DB_FILE* stream)
+{
+    int remaining_size;
+    int chunk_size;
+    size_t bytes_read;
+    unsigned char* buf;
+    size_t elements_read;
+    size_t v1;
+
+    buf = (unsigned char*)ptr;
+    elements_read = 0;
+
+    if (stream != NULL) {
+        if ((stream->flags & 0x4) != 0) {
+            if (read_callback != NULL) {
+                remaining_size = size * count;
+                chunk_size = read_threshold - read_count;
+
+                while (remaining_size >= chunk_size) {
+                    bytes_read = fread(buf, 1, chunk_size, stream->uncompressed_file_stream);
+                    buf += bytes_read;
+                    remaining_size -= bytes_read;
+                    elements_read += bytes_read;
+
+                    read_count = 0;
+                    read_callback();
+
+                    chunk_size = read_threshold;
+                }
+
+                if (remaining_size != 0) {
+                    elements_read += fread(buf, 1, remaining_size, stream->uncompressed_file_stream);
+                    read_count += remaining_size;
+                }
+
+                elements_read /= size;
+            } else {
+                elements_read = fread(buf, size, count, stream->uncompressed_file_stream);
+            }
+        } else {
+            if (ptr != NULL) {
+                switch (stream->flags & 0xF0) {
+                case 16:
+                case 128:
+                    if (stream->field_10 != 0) {
+                        elements_read = stream->field_10 / size;
+                        if (elements_read > count) {
+                            elements_read = count;
+                        }
+
+                        if (elements_read != 0) {
+                            remaining_size = elements_read * size;
+                            if (read_callback != NULL) {
+                                chunk_size = read_threshold - read_count;
+                                while (remaining_size >= chunk_size) {
+                                    remaining_size -= chunk_size;
+                                    memcpy(buf, stream->field_20, chunk_size);
+
+                                    buf += chunk_size;
+                                    stream->field_20 += chunk_size;
+                                    stream->field_10 -= chunk_size;
+
+                                    read_count = 0;
+                                    read_callback();
+
+                                    chunk_size = read_threshold;
+                                }
+
+                                if (remaining_size != 0) {
+                                    memcpy(buf, stream->field_20, remaining_size);
+                                    stream->field_20 += remaining_size;
+                                    stream->field_10 -= remaining_size;
+                                    read_count += remaining_size;
+                                }
+                            } else {
+                                memcpy(ptr, stream->field_20, remaining_size);
+                                stream->field_20 += remaining_size;
+                                stream->field_10 -= remaining_size;
+                            }
+                        }
+                    }
+                    break;
+                case 32:
+                    if (stream->field_10 != 0) {
+                        elements_read = stream->field_10 / size;
+                        if (elements_read > count) {
                             elements_read = count;
                         }
 
@@ -876,6 +1819,12 @@ size_t db_fread(void* ptr, size_t size, size_t count, DB_FILE* stream)
                 }
             }
         }
+
+        if (stream->traced) {
+            db_trace.records[stream->trace_record].reads++;
+            db_trace.records[stream->trace_record].bytes_read += elements_read * size;
+            stream->trace_bytes += elements_read * size;
+        }
     }
 
     return elements_read;
@@ -893,6 +1842,7 @@ int db_fgetc(DB_FILE* stream)
         } else {
             switch (stream->flags & 0xF0) {
             case 16:
+            case 128:
                 if (stream->field_10 != 0) {
                     ch = *stream->field_20;
                     stream->field_20++;
@@ -947,6 +1897,11 @@ int db_fgetc(DB_FILE* stream)
                 break;
             }
         }
+
+        if (ch != -1 && stream->traced) {
+            db_trace.records[stream->trace_record].bytes_read++;
+            stream->trace_bytes++;
+        }
     }
 
     if (read_callback != NULL) {
@@ -971,6 +1926,7 @@ int db_ungetc(int ch, DB_FILE* stream)
             // `ch` into stream, but steps back in read stream.
             switch (stream->flags & 0xF0) {
             case 16:
+            case 128:
                 if (stream->field_20 != stream->field_1C) {
                     stream->field_20--;
                     stream->field_10++;
@@ -1046,7 +2002,14 @@ int db_fseek(DB_FILE* stream, long offset, int origin)
     int chunks;
 
     if (stream != NULL) {
+        if (stream->traced) {
+            db_trace.records[stream->trace_record].seeks++;
+        }
+
         if ((stream->flags & 0x4) != 0) {
+            if ((stream->flags & DB_FILE_MEMORY) != 0 || db_write_buffer_flush(stream) != 0) {
+                return -1;
+            }
             rc = fseek(stream->uncompressed_file_stream, offset, origin);
         } else {
             current_offset = db_ftell(stream);
@@ -1071,6 +2034,7 @@ int db_fseek(DB_FILE* stream, long offset, int origin)
 
             switch (stream->flags & 0xF0) {
             case 16:
+            case 128:
                 stream->field_20 = stream->field_1C + offset;
                 stream->field_10 = stream->field_C - offset;
                 rc = 0;
@@ -1086,7 +2050,25 @@ int db_fseek(DB_FILE* stream, long offset, int origin)
                 v1 = stream->field_20 + offset - current_offset;
                 if (v1 >= stream->field_1C && v1 < stream->field_1C + 0x4000) {
                     stream->field_20 = v1;
-                    stream->field_10 = current_offset - offset;
+                    // CE: Original code sets `current_offset - offset`.
+                    stream->field_10 = stream->field_C - offset;
+                    rc = 0;
+                } else if (stream->block_offsets != NULL) {
+                    // CE: Decode block containing `offset` directly. Seeking to
+                    // the end of entry keeps last block loaded, so that
+                    // subsequent backward seek can reuse the buffer.
+                    chunks = offset / 0x4000;
+                    if (chunks >= stream->block_count) {
+                        chunks = stream->block_count - 1;
+                    }
+
+                    stream->field_18 = stream->field_14 + stream->block_offsets[chunks];
+                    stream->field_10 = stream->field_C - chunks * 0x4000;
+                    stream->field_20 = stream->field_1C + 0x4000;
+                    db_preload_buffer(stream);
+
+                    stream->field_20 += offset - chunks * 0x4000;
+                    stream->field_10 = stream->field_C - offset;
                     rc = 0;
                 } else {
                     if (offset < current_offset) {
@@ -1112,6 +2094,9 @@ int db_fseek(DB_FILE* stream, long offset, int origin)
                     }
 
                     stream->field_10 = stream->field_C - offset;
+
+                    // CE: Original code does not report success.
+                    rc = 0;
                 }
             }
         }
@@ -1125,10 +2110,14 @@ long db_ftell(DB_FILE* stream)
 {
     if (stream != NULL) {
         if ((stream->flags & 0x4) != 0) {
-            return ftell(stream->uncompressed_file_stream);
+            if ((stream->flags & DB_FILE_MEMORY) != 0) {
+                return (long)stream->write_length;
+            }
+            return ftell(stream->uncompressed_file_stream) + (long)stream->write_length;
         } else {
             switch (stream->flags & 0xF0) {
             case 16:
+            case 128:
                 return stream->field_C - stream->field_10;
             case 32:
             case 64:
@@ -1144,11 +2133,15 @@ long db_ftell(DB_FILE* stream)
 void db_rewind(DB_FILE* stream)
 {
     if (stream != NULL) {
-        if ((stream->flags & 0x4) != 0) {
+        if ((stream->flags & DB_FILE_MEMORY) != 0) {
+            stream->write_length = 0;
+        } else if ((stream->flags & 0x4) != 0) {
+            db_write_buffer_flush(stream);
             rewind(stream->uncompressed_file_stream);
         } else {
             switch (stream->flags & 0xF0) {
             case 16:
+            case 128:
                 stream->field_10 = stream->field_C;
                 stream->field_20 = stream->field_1C;
                 break;
@@ -1171,6 +2164,9 @@ void db_rewind(DB_FILE* stream)
 size_t db_fwrite(const void* buf, size_t size, size_t count, DB_FILE* stream)
 {
     if (stream != NULL && (stream->flags & 0x4) != 0) {
+        if ((stream->flags & DB_FILE_BUFFERED) != 0) {
+            return db_write_buffer_put(stream, buf, size * count) ? count : 0;
+        }
         return fwrite(buf, size, count, stream->uncompressed_file_stream);
     }
 
@@ -1181,6 +2177,10 @@ size_t db_fwrite(const void* buf, size_t size, size_t count, DB_FILE* stream)
 int db_fputc(int ch, DB_FILE* stream)
 {
     if (stream != NULL && (stream->flags & 0x4) != 0) {
+        if ((stream->flags & DB_FILE_BUFFERED) != 0) {
+            unsigned char value = (unsigned char)ch;
+            return db_write_buffer_put(stream, &value, 1) ? value : -1;
+        }
         return fputc(ch, stream->uncompressed_file_stream);
     }
 
@@ -1191,6 +2191,9 @@ int db_fputc(int ch, DB_FILE* stream)
 int db_fputs(const char* string, DB_FILE* stream)
 {
     if (stream != NULL && (stream->flags & 0x4) != 0) {
+        if ((stream->flags & DB_FILE_BUFFERED) != 0) {
+            return db_write_buffer_put(stream, string, strlen(string)) ? 0 : -1;
+        }
         return fputs(string, stream->uncompressed_file_stream);
     }
 
@@ -1281,6 +2284,10 @@ int db_freadFloat(DB_FILE* stream, float* q)
 // 0x4B0870
 int db_fwriteByte(DB_FILE* stream, unsigned char c)
 {
+    if (stream != NULL && (stream->flags & DB_FILE_BUFFERED) != 0) {
+        return db_write_buffer_put(stream, &c, 1) ? 0 : -1;
+    }
+
     // NOTE: Uninline.
     if (db_fputc(c, stream) == -1) {
         return -1;
@@ -1292,6 +2299,10 @@ int db_fwriteByte(DB_FILE* stream, unsigned char c)
 // 0x4B08A0
 int db_fwriteShort(DB_FILE* stream, unsigned short s)
 {
+    if (stream != NULL && (stream->flags & DB_FILE_BUFFERED) != 0) {
+        return db_write_buffer_put_16(stream, s) ? 0 : -1;
+    }
+
     // NOTE: Uninline.
     if (db_fwriteByte(stream, s >> 8) == -1) {
         return -1;
@@ -1308,6 +2319,10 @@ int db_fwriteShort(DB_FILE* stream, unsigned short s)
 // 0x4B08EC
 int db_fwriteInt(DB_FILE* stream, int i)
 {
+    if (stream != NULL && (stream->flags & DB_FILE_BUFFERED) != 0) {
+        return db_write_buffer_put_32(stream, (unsigned int)i) ? 0 : -1;
+    }
+
     if (db_fwriteShort(stream, i >> 16) == -1) {
         return -1;
     }
@@ -1339,6 +2354,11 @@ int db_freadByteCount(DB_FILE* stream, unsigned char* c, int count)
     int index;
     unsigned char value;
 
+    // CE: Binary streams are read in one go.
+    if (stream != NULL && (stream->flags & 0x2) == 0) {
+        return db_fread_swapped(stream, c, sizeof(*c), count);
+    }
+
     for (index = 0; index < count; index++) {
         // NOTE: Uninline.
         if (db_freadByte(stream, &value) == -1) {
@@ -1357,6 +2377,11 @@ int db_freadShortCount(DB_FILE* stream, unsigned short* s, int count)
     int index;
     unsigned short value;
 
+    // CE: Binary streams are read in one go and swapped in place.
+    if (stream != NULL && (stream->flags & 0x2) == 0) {
+        return db_fread_swapped(stream, s, sizeof(*s), count);
+    }
+
     for (index = 0; index < count; index++) {
         // NOTE: Uninline.
         if (db_freadShort(stream, &value) == -1) {
@@ -1375,6 +2400,11 @@ int db_freadIntCount(DB_FILE* stream, int* i, int count)
     int index;
     int value;
 
+    // CE: Binary streams are read in one go and swapped in place.
+    if (stream != NULL && (stream->flags & 0x2) == 0) {
+        return db_fread_swapped(stream, i, sizeof(*i), count);
+    }
+
     for (index = 0; index < count; index++) {
         // NOTE: Uninline.
         if (db_freadInt(stream, &value) == -1) {
@@ -1393,6 +2423,24 @@ int db_freadLongCount(DB_FILE* stream, unsigned long* l, int count)
     int index;
     unsigned long value;
 
+    // CE: Binary streams are read in one go and swapped in place. Values are
+    // 32-bit on disk, so on platforms with 64-bit `long` they're widened
+    // backwards (starting from the last one) to avoid overwriting unread
+    // values.
+    if (stream != NULL && (stream->flags & 0x2) == 0) {
+        if (db_fread_swapped(stream, l, sizeof(unsigned int), count) == -1) {
+            return -1;
+        }
+
+        if (sizeof(*l) != sizeof(unsigned int)) {
+            for (index = count - 1; index >= 0; index--) {
+                l[index] = ((unsigned int*)l)[index];
+            }
+        }
+
+        return 0;
+    }
+
     for (index = 0; index < count; index++) {
         // NOTE: Uninline.
         if (db_freadLong(stream, &value) == -1) {
@@ -1411,6 +2459,11 @@ int db_freadFloatCount(DB_FILE* stream, float* q, int count)
     int index;
     float value;
 
+    // CE: Binary streams are read in one go and swapped in place.
+    if (stream != NULL && (stream->flags & 0x2) == 0) {
+        return db_fread_swapped(stream, q, sizeof(*q), count);
+    }
+
     for (index = 0; index < count; index++) {
         // NOTE: Uninline.
         if (db_freadFloat(stream, &value) == -1) {
@@ -1428,6 +2481,11 @@ int db_fwriteByteCount(DB_FILE* stream, unsigned char* c, int count)
 {
     int index;
 
+    // CE: Write swapped copy in large chunks.
+    if (stream != NULL) {
+        return db_fwrite_swapped(stream, c, sizeof(*c), count);
+    }
+
     for (index = 0; index < count; index++) {
         // NOTE: Uninline.
         if (db_fwriteByte(stream, c[index]) == -1) {
@@ -1443,6 +2501,11 @@ int db_fwriteShortCount(DB_FILE* stream, unsigned short* s, int count)
 {
     int index;
 
+    // CE: Write swapped copy in large chunks.
+    if (stream != NULL) {
+        return db_fwrite_swapped(stream, s, sizeof(*s), count);
+    }
+
     for (index = 0; index < count; index++) {
         // NOTE: Uninline.
         if (db_fwriteShort(stream, s[index]) == -1) {
@@ -1458,6 +2521,11 @@ int db_fwriteIntCount(DB_FILE* stream, int* i, int count)
 {
     int index;
 
+    // CE: Write swapped copy in large chunks.
+    if (stream != NULL) {
+        return db_fwrite_swapped(stream, i, sizeof(*i), count);
+    }
+
     for (index = 0; index < count; index++) {
         // NOTE: Uninline.
         if (db_fwriteInt(stream, i[index]) == -1) {
@@ -1472,6 +2540,28 @@ int db_fwriteIntCount(DB_FILE* stream, int* i, int count)
 int db_fwriteLongCount(DB_FILE* stream, unsigned long* l, int count)
 {
     int index;
+    unsigned int values[DB_SWAP_CHUNK_SIZE];
+    int chunk_size;
+
+    // CE: Narrow values to 32-bit and write them in large chunks.
+    if (stream != NULL) {
+        for (index = 0; index < count; index += chunk_size) {
+            chunk_size = count - index;
+            if (chunk_size > DB_SWAP_CHUNK_SIZE) {
+                chunk_size = DB_SWAP_CHUNK_SIZE;
+            }
+
+            for (int k = 0; k < chunk_size; k++) {
+                values[k] = (unsigned int)l[index + k];
+            }
+
+            if (db_fwrite_swapped(stream, values, sizeof(*values), chunk_size) == -1) {
+                return -1;
+            }
+        }
+
+        return 0;
+    }
 
     for (index = 0; index < count; index++) {
         // NOTE: Uninline.
@@ -1488,6 +2578,11 @@ int db_fwriteFloatCount(DB_FILE* stream, float* q, int count)
 {
     int index;
 
+    // CE: Write swapped copy in large chunks.
+    if (stream != NULL) {
+        return db_fwrite_swapped(stream, q, sizeof(*q), count);
+    }
+
     for (index = 0; index < count; index++) {
         // NOTE: Uninline.
         if (db_fwriteFloat(stream, q[index]) == -1) {
@@ -1545,7 +2640,7 @@ int db_fprintf(DB_FILE* stream, const char* format, ...)
     va_list args;
 
     va_start(args, format);
-    if (stream != NULL && (stream->flags & 0x4) != 0) {
+    if (stream != NULL && (stream->flags & (0x4 | DB_FILE_MEMORY)) == 0x4 && db_write_buffer_flush(stream) == 0) {
         rc = vfprintf(stream->uncompressed_file_stream, format, args);
     } else {
         rc = -1;
@@ -1562,11 +2657,16 @@ int db_feof(DB_FILE* stream)
         return -1;
     }
 
+    if ((stream->flags & DB_FILE_MEMORY) != 0) {
+        return 0;
+    }
+
     if ((stream->flags & 0x4) != 0) {
         return feof(stream->uncompressed_file_stream);
     } else {
         switch (stream->flags & 0xF0) {
         case 16:
+        case 128:
             return stream->field_10 == 0;
         case 32:
         case 64:
@@ -1589,6 +2689,7 @@ int db_get_file_list(const char* filespec, char*** filelist, char*** desclist, i
     int pos;
     int index;
     int count = 0;
+    long long patches_mtime;
 
     if (current_database == NULL) {
         return 0;
@@ -1620,6 +2721,21 @@ int db_get_file_list(const char* filespec, char*** filelist, char*** desclist, i
     filename = sep != NULL ? sep + 1 : filespec_copy;
 
     if (strlen(filename) == 5 && filename[0] == '*' && filename[1] == '.') {
+        // CE: Datafile contents never change, so listing is served from cache
+        // as long as patches directory was not modified. Descriptions are
+        // read from files and are not cached.
+        patches_mtime = 0;
+        if (desclist == NULL) {
+            patches_mtime = db_file_list_patches_mtime(current_database, filespec_copy, v1);
+
+            count = db_file_list_cache_find(current_database, filespec, patches_mtime, filelist);
+            if (count != -1) {
+                return count;
+            }
+
+            count = 0;
+        }
+
         if (desclist != NULL) {
             temp = (char*)internal_malloc(desclen);
             if (temp == NULL) {
@@ -1662,7 +2778,7 @@ int db_get_file_list(const char* filespec, char*** filelist, char*** desclist, i
                 }
 
                 if (strlen(v3) != 0) {
-                    pos = assoc_search(&(current_database->root), v3);
+                    pos = db_index_find_dir(current_database, v3);
                 } else {
                     pos = 0;
                 }
@@ -1674,11 +2790,12 @@ int db_get_file_list(const char* filespec, char*** filelist, char*** desclist, i
                 filename = path;
             }
 
-            if (pos != -1) {
+            if (pos != -1 && pos < current_database->index_dir_count) {
+                DB_INDEX_DIR* dir = &(current_database->index_dirs[pos]);
                 char* name;
                 size_t name_len;
-                for (index = 0; index < current_database->entries[pos].size; index++) {
-                    name = current_database->entries[pos].list[index].name;
+                for (index = dir->first_entry; index < dir->first_entry + dir->entry_count; index++) {
+                    name = current_database->index_strings + current_database->index_entries[index].name;
                     name_len = strlen(name);
                     if (name_len > 4) {
                         if (name[name_len - 3] == filename[2] && name[name_len - 2] == filename[3] && name[name_len - 1] == filename[4]) {
@@ -1744,6 +2861,13 @@ int db_get_file_list(const char* filespec, char*** filelist, char*** desclist, i
             // TODO: Incomplete.
         }
 
+        if (desclist == NULL && (count == 0 || *filelist != NULL)) {
+            db_file_list_cache_add(current_database, filespec, patches_mtime, *filelist, count);
+        }
+
+        // CE: Original code leaks `ary`.
+        assoc_free(&ary);
+
         if (temp != NULL) {
             internal_free(temp);
         }
@@ -1752,6 +2876,21 @@ int db_get_file_list(const char* filespec, char*** filelist, char*** desclist, i
     return count;
 }
 
+// CE: Discards cached file lists of all databases. Should be called after
+// files in patches directory are created, renamed, or removed bypassing
+// `db_fopen` (modification time of directory is not precise enough to catch
+// everything).
+void db_file_list_invalidate()
+{
+    int index;
+
+    for (index = 0; index < DB_DATABASE_LIST_CAPACITY; index++) {
+        if (database_list[index] != NULL) {
+            db_file_list_cache_flush(database_list[index]);
+        }
+    }
+}
+
 // 0x4B1518
 void db_free_file_list(char*** file_list, char*** desclist)
 {
@@ -1848,6 +2987,12 @@ long db_filelength(DB_FILE* stream)
     }
 
     if ((stream->flags & 0x4) != 0) {
+        if ((stream->flags & DB_FILE_MEMORY) != 0) {
+            return (long)stream->write_length;
+        }
+        if (db_write_buffer_flush(stream) != 0) {
+            return -1;
+        }
         return getFileSize(stream->uncompressed_file_stream);
     } else {
         return stream->field_C;
@@ -1924,8 +3069,6 @@ static int db_destroy_database(DB_DATABASE** database_ptr)
 // 0x4B1BC4
 static int db_init_database(DB_DATABASE* database, const char* datafile, const char* datafile_path)
 {
-    assoc_func_list funcs;
-    int index;
     const char* v1;
     size_t v2;
 
@@ -1949,55 +3092,14 @@ static int db_init_database(DB_DATABASE* database, const char* datafile, const c
         return -1;
     }
 
-    if (assoc_init(&(database->root), 0, sizeof(*database->entries), NULL) != 0) {
-        fclose(database->stream);
-        internal_free(database->datafile);
-        database->datafile = NULL;
-        return -1;
-    }
-
-    if (assoc_load(database->stream, &(database->root), 0) != 0) {
-        fclose(database->stream);
-        internal_free(database->datafile);
-        database->datafile = NULL;
-        return -1;
-    }
-
-    database->entries = (assoc_array*)internal_malloc(sizeof(*database->entries) * database->root.size);
-    if (database->entries == NULL) {
-        assoc_free(&(database->root));
-        fclose(database->stream);
-        internal_free(database->datafile);
-        database->datafile = NULL;
-        return -1;
-    }
-
-    funcs.loadFunc = db_assoc_load_dir_entry;
-    funcs.saveFunc = db_assoc_save_dir_entry;
-    funcs.loadFuncDB = NULL;
-    funcs.saveFuncDB = NULL;
-
-    for (index = 0; index < database->root.size; index++) {
-        if (assoc_init(&(database->entries[index]), 0, sizeof(dir_entry), &funcs) != 0) {
-            break;
-        }
-
-        if (assoc_load(database->stream, &(database->entries[index]), 0) != 0) {
-            break;
-        }
-    }
-
-    if (index < database->root.size) {
-        while (--index >= 0) {
-            assoc_free(&(database->entries[index]));
+    // CE: Use persisted index when it's up to date.
+    if (!index_is_on || db_load_index(database) != 0) {
+        if (db_read_index(database) != 0) {
+            fclose(database->stream);
+            internal_free(database->datafile);
+            database->datafile = NULL;
+            return -1;
         }
-
-        internal_free(database->entries);
-        assoc_free(&(database->root));
-        fclose(database->stream);
-        internal_free(database->datafile);
-        database->datafile = NULL;
-        return -1;
     }
 
     if (datafile_path != NULL && strlen(datafile_path) != 0) {
@@ -2012,8 +3114,7 @@ static int db_init_database(DB_DATABASE* database, const char* datafile, const c
     v2 = strlen(v1);
     database->datafile_path = (char*)internal_malloc(v2 + 2);
     if (database->datafile_path == NULL) {
-        internal_free(database->entries);
-        assoc_free(&(database->root));
+        db_free_index(database);
         fclose(database->stream);
         internal_free(database->datafile);
         database->datafile = NULL;
@@ -2027,18 +3128,22 @@ static int db_init_database(DB_DATABASE* database, const char* datafile, const c
         database->datafile_path[v2 + 1] = '\0';
     }
 
+    if (mmap_is_on) {
+        db_map_database(database);
+    }
+
     return 0;
 }
 
 // 0x4B1DE0
 static void db_exit_database(DB_DATABASE* database)
 {
-    int index;
-
     if (database == NULL) {
         return;
     }
 
+    db_unmap_database(database);
+
     if (database->stream != NULL) {
         fclose(database->stream);
         database->stream = NULL;
@@ -2049,15 +3154,9 @@ static void db_exit_database(DB_DATABASE* database)
         database->datafile = NULL;
     }
 
-    if (database->entries != NULL) {
-        for (index = 0; index < database->root.size; index++) {
-            assoc_free(&(database->entries[index]));
-        }
-        internal_free(database->entries);
-        database->entries = NULL;
-    }
-
-    assoc_free(&(database->root));
+    db_free_index(database);
+    db_free_patch_dirs(database);
+    db_file_list_cache_flush(database);
 
     if (database->datafile_path != NULL) {
         internal_free(database->datafile_path);
@@ -2065,677 +3164,3957 @@ static void db_exit_database(DB_DATABASE* database)
     }
 }
 
-// 0x4B1E70
-static int db_init_patches(DB_DATABASE* database, const char* path)
+// Maps datafile into memory. Failure is not an error, the database silently
+// continues to use stdio stream.
+static void db_map_database(DB_DATABASE* database)
 {
-    size_t path_len;
-
-    if (database == NULL) {
-        return -1;
-    }
-
-    if (path == NULL) {
-        database->patches_path = NULL;
-        return 0;
-    }
+    size_t size;
 
-    path_len = strlen(path);
-    if (path_len == 0) {
-        database->patches_path = empty_patches_path;
-        return 0;
+    if (database->stream == NULL || database->mapped_data != NULL) {
+        return;
     }
 
-    database->patches_path = (char*)internal_malloc(path_len + 2);
-    if (database->patches_path == NULL) {
-        return -1;
+    database->mapped_data = (unsigned char*)compat_map_file(database->stream, &size);
+    if (database->mapped_data != NULL) {
+        database->mapped_size = size;
     }
+}
 
-    database->should_free_patches_path = true;
-    strcpy(database->patches_path, path);
-
-    if (database->patches_path[path_len - 1] != '\\') {
-        database->patches_path[path_len] = PATH_SEP;
-        database->patches_path[path_len + 1] = '\0';
+static void db_unmap_database(DB_DATABASE* database)
+{
+    if (database->mapped_data != NULL) {
+        compat_unmap_file(database->mapped_data, database->mapped_size);
+        database->mapped_data = NULL;
+        database->mapped_size = 0;
     }
+}
 
-    return 0;
+// Returns pointer to the beginning of entry's data in mapped datafile, or
+// `NULL` if datafile is not mapped or entry is out of mapping bounds.
+static unsigned char* db_mapped_entry(DB_DATABASE* database, dir_entry* de)
+{
+    return db_mapped_range(database, de->offset, de->length);
 }
 
-// 0x4B1F10
-static void db_exit_patches(DB_DATABASE* database)
+// Returns mapped `size` bytes at `offset` of datafile, or `NULL` if datafile is
+// not mapped.
+static unsigned char* db_mapped_range(DB_DATABASE* database, long offset, long size)
 {
-    if (database == NULL) {
-        return;
+    if (database->mapped_data == NULL) {
+        return NULL;
     }
 
-    if (database->patches_path != NULL) {
-        if (database->should_free_patches_path == true) {
-            internal_free(database->patches_path);
-        }
+    if (offset < 0 || size < 0) {
+        return NULL;
     }
 
-    database->patches_path = empty_patches_path;
-    database->should_free_patches_path = false;
+    if ((size_t)offset + (size_t)size > database->mapped_size) {
+        return NULL;
+    }
+
+    return database->mapped_data + offset;
 }
 
-// 0x4B1F3C
-static int db_init_hash_table(DB_DATABASE* database)
+// Reads datafile directory (a sequence of serialized assoc arrays) and converts
+// it into flat index.
+static int db_read_index(DB_DATABASE* database)
 {
-    if (!hash_is_on) {
+    assoc_array root;
+    assoc_array* entries;
+    assoc_func_list funcs;
+    int index;
+    int rc;
+
+    if (assoc_init(&root, 0, sizeof(assoc_array), NULL) != 0) {
         return -1;
     }
 
-    if (database == NULL) {
+    if (assoc_load(database->stream, &root, 0) != 0) {
+        assoc_free(&root);
         return -1;
     }
 
-    database->hash_table = (unsigned char*)internal_malloc(DB_HASH_TABLE_SIZE);
-    if (database->hash_table == NULL) {
+    entries = (assoc_array*)internal_malloc(sizeof(*entries) * root.size);
+    if (entries == NULL) {
+        assoc_free(&root);
         return -1;
     }
 
-    return db_reset_hash_table(database);
-}
+    funcs.loadFunc = db_assoc_load_dir_entry;
+    funcs.saveFunc = db_assoc_save_dir_entry;
+    funcs.loadFuncDB = NULL;
+    funcs.saveFuncDB = NULL;
 
-// 0x4B1F90
-void db_enable_hash_table()
-{
-    hash_is_on = true;
-}
+    for (index = 0; index < root.size; index++) {
+        if (assoc_init(&(entries[index]), 0, sizeof(dir_entry), &funcs) != 0) {
+            break;
+        }
 
-// 0x4B1F9C
-static int db_reset_hash_table(DB_DATABASE* database)
-{
-    if (!hash_is_on) {
-        return -1;
+        if (assoc_load(database->stream, &(entries[index]), 0) != 0) {
+            assoc_free(&(entries[index]));
+            break;
+        }
     }
 
-    if (database == NULL) {
-        return -1;
+    if (index < root.size) {
+        rc = -1;
+    } else {
+        rc = db_build_index(database, &root, entries);
     }
 
-    if (database->patches_path == NULL) {
+    while (--index >= 0) {
+        assoc_free(&(entries[index]));
+    }
+
+    internal_free(entries);
+    assoc_free(&root);
+
+    return rc;
+}
+
+static int db_build_index(DB_DATABASE* database, assoc_array* root, assoc_array* entries)
+{
+    DB_INDEX_HEADER* header;
+    DB_INDEX_DIR* dirs;
+    DB_INDEX_ENTRY* index_entries;
+    char* strings;
+    unsigned char* data;
+    size_t strings_size;
+    size_t size;
+    int entry_count;
+    int dir_index;
+    int entry_index;
+    int index;
+    long long datafile_size;
+    long long datafile_mtime;
+
+    entry_count = 0;
+    strings_size = 0;
+    for (dir_index = 0; dir_index < root->size; dir_index++) {
+        strings_size += strlen(root->list[dir_index].name) + 1;
+        for (entry_index = 0; entry_index < entries[dir_index].size; entry_index++) {
+            strings_size += strlen(entries[dir_index].list[entry_index].name) + 1;
+        }
+        entry_count += entries[dir_index].size;
+    }
+
+    size = sizeof(*header) + sizeof(*dirs) * root->size + sizeof(*index_entries) * entry_count + strings_size;
+    data = (unsigned char*)internal_malloc(size);
+    if (data == NULL) {
         return -1;
     }
 
-    if (database->hash_table == NULL) {
-        database->hash_table = (unsigned char*)internal_malloc(DB_HASH_TABLE_SIZE);
-        if (database->hash_table == NULL) {
-            return -1;
+    if (compat_stat(database->datafile, &datafile_size, &datafile_mtime) != 0) {
+        datafile_size = -1;
+        datafile_mtime = -1;
+    }
+
+    header = (DB_INDEX_HEADER*)data;
+    memset(header, 0, sizeof(*header));
+    header->magic = DB_INDEX_MAGIC;
+    header->version = DB_INDEX_VERSION;
+    header->datafile_size = datafile_size;
+    header->datafile_mtime = datafile_mtime;
+    header->dir_count = root->size;
+    header->entry_count = entry_count;
+    header->dirs_offset = sizeof(*header);
+    header->entries_offset = header->dirs_offset + sizeof(*dirs) * root->size;
+    header->strings_offset = header->entries_offset + sizeof(*index_entries) * entry_count;
+    header->strings_size = (unsigned int)strings_size;
+
+    dirs = (DB_INDEX_DIR*)(data + header->dirs_offset);
+    index_entries = (DB_INDEX_ENTRY*)(data + header->entries_offset);
+    strings = (char*)(data + header->strings_offset);
+
+    index = 0;
+    strings_size = 0;
+    for (dir_index = 0; dir_index < root->size; dir_index++) {
+        dirs[dir_index].name = (unsigned int)strings_size;
+        dirs[dir_index].first_entry = index;
+        dirs[dir_index].entry_count = entries[dir_index].size;
+        strcpy(strings + strings_size, root->list[dir_index].name);
+        strings_size += strlen(root->list[dir_index].name) + 1;
+
+        for (entry_index = 0; entry_index < entries[dir_index].size; entry_index++) {
+            assoc_pair* pair = &(entries[dir_index].list[entry_index]);
+            index_entries[index].name = (unsigned int)strings_size;
+            index_entries[index].de = *(dir_entry*)pair->data;
+            strcpy(strings + strings_size, pair->name);
+            strings_size += strlen(pair->name) + 1;
+            index++;
         }
     }
 
-    memset(database->hash_table, 0, DB_HASH_TABLE_SIZE);
+    database->index_dirty = true;
 
-    return db_fill_hash_table(database, database->patches_path);
+    return db_set_index(database, data, size, false);
 }
 
-// NOTE: Originally not static, but that would require exposing `DB_DATABASE`
-// which is most likely considered implementation detail.
-//
-// 0x4B2028
-static int db_fill_hash_table(DB_DATABASE* database, const char* path)
+// Validates index layout and sets up pointers into it. On success database
+// takes ownership of `data`.
+static int db_set_index(DB_DATABASE* database, unsigned char* data, size_t size, bool mapped)
 {
-    char pattern[COMPAT_MAX_PATH];
-    DB_FIND_DATA find_data;
-    bool is_directory;
-    char* filename;
+    DB_INDEX_HEADER* header;
+    DB_INDEX_DIR* dirs;
+    DB_INDEX_ENTRY* entries;
+    int index;
 
-    if (!hash_is_on) {
+    if (size < sizeof(*header)) {
         return -1;
     }
 
-    if (database == NULL) {
+    header = (DB_INDEX_HEADER*)data;
+    if (header->magic != DB_INDEX_MAGIC || header->version != DB_INDEX_VERSION) {
         return -1;
     }
 
-    if (database->hash_table == NULL) {
+    if (header->dir_count < 0 || header->entry_count < 0) {
         return -1;
     }
 
-#if defined(_WIN32)
-    snprintf(pattern, sizeof(pattern), "%s%s", path, "*.*");
-#else
-    snprintf(pattern, sizeof(pattern), "%s%s", path, "*");
-#endif
-    compat_windows_path_to_native(pattern);
+    if (header->dirs_offset + sizeof(*dirs) * header->dir_count > size
+        || header->entries_offset + sizeof(*entries) * header->entry_count > size
+        || header->strings_offset + (size_t)header->strings_size > size
+        || header->strings_size == 0
+        || data[header->strings_offset + header->strings_size - 1] != '\0') {
+        return -1;
+    }
 
-    if (db_findfirst(pattern, &find_data) != -1) {
-        do {
-            is_directory = fileFindIsDirectory(&find_data);
-            filename = fileFindGetName(&find_data);
+    dirs = (DB_INDEX_DIR*)(data + header->dirs_offset);
+    entries = (DB_INDEX_ENTRY*)(data + header->entries_offset);
 
-            if (is_directory) {
-                if (strcmp(filename, ".") != 0 && strcmp(filename, "..") != 0) {
-                    snprintf(pattern, sizeof(pattern), "%s%s%c", path, filename, PATH_SEP);
-                    db_fill_hash_table(database, pattern);
-                }
-            } else {
-                db_add_hash_entry_to_database(database, filename, PATH_SEP);
-            }
-        } while (db_findnext(&find_data) != -1);
+    for (index = 0; index < header->dir_count; index++) {
+        if (dirs[index].name >= header->strings_size
+            || dirs[index].first_entry < 0
+            || dirs[index].entry_count < 0
+            || dirs[index].first_entry + dirs[index].entry_count > header->entry_count) {
+            return -1;
+        }
+    }
 
-        db_findclose(&find_data);
+    for (index = 0; index < header->entry_count; index++) {
+        if (entries[index].name >= header->strings_size) {
+            return -1;
+        }
     }
 
+    database->index_data = data;
+    database->index_size = size;
+    database->index_mapped = mapped;
+    database->index_dirs = dirs;
+    database->index_entries = entries;
+    database->index_strings = (char*)(data + header->strings_offset);
+    database->index_dir_count = header->dir_count;
+
     return 0;
 }
 
-// 0x4B2154
-int db_reset_hash_tables()
+static void db_free_index(DB_DATABASE* database)
 {
-    int index;
-
-    if (!hash_is_on) {
-        return -1;
-    }
-
-    for (index = 0; index < DB_DATABASE_LIST_CAPACITY; index++) {
-        if (database_list[index] != NULL) {
-            db_reset_hash_table(database_list[index]);
+    if (database->index_data != NULL) {
+        if (database->index_mapped) {
+            compat_unmap_file(database->index_data, database->index_size);
+        } else {
+            internal_free(database->index_data);
         }
     }
 
-    return 0;
+    database->index_data = NULL;
+    database->index_size = 0;
+    database->index_mapped = false;
+    database->index_dirs = NULL;
+    database->index_entries = NULL;
+    database->index_strings = NULL;
+    database->index_dir_count = 0;
 }
 
-// 0x4B218C
-int db_add_hash_entry(const char* path, int sep)
+// Maps index sidecar if it matches datafile.
+static int db_load_index(DB_DATABASE* database)
 {
-    if (!hash_is_on) {
+    char path[COMPAT_MAX_PATH];
+    FILE* stream;
+    unsigned char* data;
+    size_t size;
+    bool mapped;
+    long long datafile_size;
+    long long datafile_mtime;
+    DB_INDEX_HEADER* header;
+
+    if (compat_stat(database->datafile, &datafile_size, &datafile_mtime) != 0) {
         return -1;
     }
 
-    if (current_database == NULL) {
+    db_index_file_path(database, path, sizeof(path));
+
+    stream = compat_fopen(path, "rb");
+    if (stream == NULL) {
         return -1;
     }
 
-    if (current_database->hash_table == NULL) {
-        return -1;
+    mapped = true;
+    data = (unsigned char*)compat_map_file(stream, &size);
+    if (data == NULL) {
+        mapped = false;
+        size = getFileSize(stream);
+        data = (unsigned char*)internal_malloc(size > 0 ? size : 1);
+        if (data == NULL) {
+            fclose(stream);
+            return -1;
+        }
+
+        if (fread(data, 1, size, stream) != size) {
+            internal_free(data);
+            fclose(stream);
+            return -1;
+        }
     }
 
-    if (path == NULL) {
+    fclose(stream);
+
+    header = (DB_INDEX_HEADER*)data;
+    if (size < sizeof(*header)
+        || header->datafile_size != datafile_size
+        || header->datafile_mtime != datafile_mtime
+        || db_set_index(database, data, size, mapped) != 0) {
+        if (mapped) {
+            compat_unmap_file(data, size);
+        } else {
+            internal_free(data);
+        }
         return -1;
     }
 
-    return db_add_hash_entry_to_database(current_database, path, sep);
+    return 0;
 }
 
-// 0x4B21E0
-static int db_add_hash_entry_to_database(DB_DATABASE* database, const char* path, int sep)
+// Restores patches part of path index from persisted index if patches
+// directories have not been modified since the index was saved.
+static int db_load_index_patches(DB_DATABASE* database)
 {
-    unsigned int key;
+    DB_INDEX_HEADER* header;
+    DB_INDEX_PATCHES* patches;
+    DB_INDEX_PATCH_DIR* dirs;
+    DB_PATH_RECORD* record;
+    const char* name;
+    long long mtime;
+    int index;
 
-    if (!hash_is_on) {
+    if (database->index_data == NULL || database->index_dirty || database->patches_path == NULL) {
         return -1;
     }
 
-    if (database == NULL) {
+    header = (DB_INDEX_HEADER*)database->index_data;
+    if (header->patches_offset == 0 || header->patches_offset + sizeof(*patches) > database->index_size) {
         return -1;
     }
 
-    if (database->hash_table == NULL) {
+    patches = (DB_INDEX_PATCHES*)(database->index_data + header->patches_offset);
+    if (patches->dir_count < 0
+        || patches->name_count < 0
+        || patches->dirs_offset + sizeof(*dirs) * patches->dir_count > database->index_size
+        || patches->names_offset > database->index_size
+        || patches->path >= database->index_size
+        || database->index_data[database->index_size - 1] != '\0') {
         return -1;
     }
 
-    if (db_hash_string_to_key(path, sep, &key) != 0) {
+    if (strcmp((char*)database->index_data + patches->path, database->patches_path) != 0) {
         return -1;
     }
 
-    return db_set_hash_value(database, key, 1);
-}
+    dirs = (DB_INDEX_PATCH_DIR*)(database->index_data + patches->dirs_offset);
+    for (index = 0; index < patches->dir_count; index++) {
+        if (dirs[index].path >= database->index_size) {
+            return -1;
+        }
 
-// 0x4B2258
-static int db_set_hash_value(DB_DATABASE* database, unsigned int key, unsigned char enabled)
-{
-    if (!hash_is_on) {
-        return -1;
-    }
+        if (compat_stat((char*)database->index_data + dirs[index].path, NULL, &mtime) != 0) {
+            return -1;
+        }
 
-    if (database->hash_table == NULL) {
-        return -1;
+        if (mtime != dirs[index].mtime) {
+            return -1;
+        }
     }
 
-    if (key >= 0x7FFF) {
-        return -1;
-    }
+    // Names are consecutive NUL-terminated strings, the last one is guaranteed
+    // to be terminated by the check above.
+    name = (char*)database->index_data + patches->names_offset;
+    for (index = 0; index < patches->name_count; index++) {
+        if (name >= (char*)database->index_data + database->index_size) {
+            return -1;
+        }
 
-    if (enabled == true) {
-        database->hash_table[key / 8] |= 1 << (key % 8);
-    } else {
-        database->hash_table[key / 8] = 0;
+        record = db_path_index_insert(&(database->path_index), name);
+        if (record == NULL) {
+            return -1;
+        }
+
+        record->sources |= DB_PATH_SOURCE_PATCHES;
+        name += strlen(name) + 1;
     }
 
     return 0;
 }
 
-// 0x4B2304
-static int db_get_hash_value(DB_DATABASE* database, const char* path, int sep, int* value_ptr)
+// Writes index (along with the list of patches if it's available) next to
+// datafile. The file is written to temporary location first and then renamed,
+// since current index might be mapped.
+static int db_save_index(DB_DATABASE* database)
 {
-    unsigned int key;
+    char path[COMPAT_MAX_PATH];
+    char temp_path[COMPAT_MAX_PATH];
+    DB_INDEX_HEADER* header;
+    DB_INDEX_PATCHES* patches;
+    DB_INDEX_PATCH_DIR* dirs;
+    DB_PATH_RECORD* record;
+    unsigned char* data;
+    size_t index_size;
+    size_t size;
+    size_t strings_size;
+    size_t pos;
+    size_t length;
+    int index;
+    int name_count;
+    FILE* stream;
+    bool has_patches;
 
-    if (!hash_is_on) {
+    if (database->index_data == NULL || database->datafile == NULL) {
         return -1;
     }
 
-    if (database->hash_table == NULL) {
+    header = (DB_INDEX_HEADER*)database->index_data;
+    index_size = header->strings_offset + header->strings_size;
+
+    has_patches = database->path_index.slots != NULL && database->patches_path != NULL;
+
+    size = (index_size + 7) & ~7;
+    name_count = 0;
+    if (has_patches) {
+        strings_size = strlen(database->patches_path) + 1;
+        for (index = 0; index < database->patch_dirs_length; index++) {
+            strings_size += strlen(database->patch_dirs[index].path) + 1;
+        }
+
+        for (index = 0; index < database->path_index.capacity; index++) {
+            record = &(database->path_index.slots[index]);
+            if ((record->sources & DB_PATH_SOURCE_PATCHES) != 0) {
+                strings_size += strlen(database->path_index.names + record->name) + 1;
+                name_count++;
+            }
+        }
+
+        size += sizeof(*patches) + sizeof(*dirs) * database->patch_dirs_length + strings_size;
+    }
+
+    data = (unsigned char*)internal_malloc(size);
+    if (data == NULL) {
         return -1;
     }
 
-    if (path == NULL) {
+    memset(data, 0, size);
+    memcpy(data, database->index_data, index_size);
+
+    header = (DB_INDEX_HEADER*)data;
+    header->patches_offset = 0;
+
+    if (has_patches) {
+        pos = (index_size + 7) & ~7;
+        header->patches_offset = (unsigned int)pos;
+
+        patches = (DB_INDEX_PATCHES*)(data + pos);
+        pos += sizeof(*patches);
+
+        patches->dir_count = database->patch_dirs_length;
+        patches->dirs_offset = (unsigned int)pos;
+        dirs = (DB_INDEX_PATCH_DIR*)(data + pos);
+        pos += sizeof(*dirs) * database->patch_dirs_length;
+
+        patches->path = (unsigned int)pos;
+        strcpy((char*)data + pos, database->patches_path);
+        pos += strlen(database->patches_path) + 1;
+
+        for (index = 0; index < database->patch_dirs_length; index++) {
+            dirs[index].mtime = database->patch_dirs[index].mtime;
+            dirs[index].path = (unsigned int)pos;
+            strcpy((char*)data + pos, database->patch_dirs[index].path);
+            pos += strlen(database->patch_dirs[index].path) + 1;
+        }
+
+        patches->name_count = name_count;
+        patches->names_offset = (unsigned int)pos;
+        for (index = 0; index < database->path_index.capacity; index++) {
+            record = &(database->path_index.slots[index]);
+            if ((record->sources & DB_PATH_SOURCE_PATCHES) != 0) {
+                length = strlen(database->path_index.names + record->name) + 1;
+                memcpy(data + pos, database->path_index.names + record->name, length);
+                pos += length;
+            }
+        }
+    }
+
+    db_index_file_path(database, path, sizeof(path));
+    snprintf(temp_path, sizeof(temp_path), "%s.tmp", path);
+
+    stream = compat_fopen(temp_path, "wb");
+    if (stream == NULL) {
+        internal_free(data);
         return -1;
     }
 
-    if (db_hash_string_to_key(path, sep, &key) != 0) {
+    if (fwrite(data, 1, size, stream) != size) {
+        fclose(stream);
+        compat_remove(temp_path);
+        internal_free(data);
         return -1;
     }
 
-    if (key >= 0x7FFF) {
+    fclose(stream);
+    internal_free(data);
+
+#if defined(_WIN32)
+    // Rename does not replace existing files on Windows.
+    compat_remove(path);
+#endif
+
+    if (compat_rename(temp_path, path) != 0) {
+        compat_remove(temp_path);
         return -1;
     }
 
-    *value_ptr = (database->hash_table[key / 8] >> (key % 8)) & 1;
+    database->index_dirty = false;
 
     return 0;
 }
 
-// 0x4B2394
-static int db_hash_string_to_key(const char* path, int sep, unsigned int* key_ptr)
+static void db_index_file_path(DB_DATABASE* database, char* path, size_t size)
 {
-    char* copy;
-    char* pch;
-    char* filename;
-    size_t index;
-    unsigned int key;
+    snprintf(path, size, "%s%s", database->datafile, DB_INDEX_FILE_EXT);
+}
 
-    key = 1;
+static int db_index_find_dir(DB_DATABASE* database, const char* name)
+{
+    int lo = 0;
+    int hi = database->index_dir_count - 1;
+
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        int cmp = compat_stricmp(name, database->index_strings + database->index_dirs[mid].name);
+        if (cmp == 0) {
+            return mid;
+        }
 
-    if (path == NULL) {
+        if (cmp > 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid - 1;
+        }
+    }
+
+    return -1;
+}
+
+// Returns global index of entry (i.e. in `index_entries`).
+static int db_index_find_entry(DB_DATABASE* database, int dir_index, const char* name)
+{
+    DB_INDEX_DIR* dir;
+    int lo;
+    int hi;
+
+    if (dir_index < 0 || dir_index >= database->index_dir_count) {
         return -1;
     }
 
-    copy = (char*)internal_strdup(path);
-    compat_strupr(copy);
+    dir = &(database->index_dirs[dir_index]);
+    lo = dir->first_entry;
+    hi = dir->first_entry + dir->entry_count - 1;
 
-    pch = strrchr(copy, sep);
-    if (pch != NULL) {
-        filename = pch + 1;
-    } else {
-        filename = copy;
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        int cmp = compat_stricmp(name, database->index_strings + database->index_entries[mid].name);
+        if (cmp == 0) {
+            return mid;
+        }
+
+        if (cmp > 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid - 1;
+        }
+    }
+
+    return -1;
+}
+
+static int db_add_patch_dir(DB_DATABASE* database, const char* path)
+{
+    DB_PATCH_DIR* patch_dir;
+    long long mtime;
+
+    if (compat_stat(path, NULL, &mtime) != 0) {
+        return -1;
     }
 
-    for (index = 0; index < strlen(filename); index++) {
-        key *= *filename++;
-        key &= 0x7FFFFFFF;
+    if (database->patch_dirs_length == database->patch_dirs_capacity) {
+        int capacity = database->patch_dirs_capacity * 2 + 8;
+        DB_PATCH_DIR* patch_dirs = (DB_PATCH_DIR*)internal_malloc(sizeof(*patch_dirs) * capacity);
+        if (patch_dirs == NULL) {
+            return -1;
+        }
+
+        if (database->patch_dirs != NULL) {
+            memcpy(patch_dirs, database->patch_dirs, sizeof(*patch_dirs) * database->patch_dirs_length);
+            internal_free(database->patch_dirs);
+        }
+
+        database->patch_dirs = patch_dirs;
+        database->patch_dirs_capacity = capacity;
     }
 
-    *key_ptr = key & 0x7FFF;
+    patch_dir = &(database->patch_dirs[database->patch_dirs_length]);
+    patch_dir->path = internal_strdup(path);
+    if (patch_dir->path == NULL) {
+        return -1;
+    }
 
-    internal_free(copy);
+    patch_dir->mtime = mtime;
+    database->patch_dirs_length++;
 
     return 0;
 }
 
-// 0x4B2420
-static void db_exit_hash_table(DB_DATABASE* database)
+static void db_free_patch_dirs(DB_DATABASE* database)
 {
-    if (database->hash_table != NULL) {
-        internal_free(database->hash_table);
+    int index;
+
+    for (index = 0; index < database->patch_dirs_length; index++) {
+        internal_free(database->patch_dirs[index].path);
+    }
+
+    if (database->patch_dirs != NULL) {
+        internal_free(database->patch_dirs);
     }
-    database->hash_table = NULL;
+
+    database->patch_dirs = NULL;
+    database->patch_dirs_length = 0;
+    database->patch_dirs_capacity = 0;
 }
 
-// 0x4B2444
-static DB_FILE* db_add_fp_rec(FILE* stream, unsigned char* a2, int a3, int flags)
+// CE: Enables persisted datafile index (see `DB_INDEX_HEADER`) for subsequent
+// `db_init` calls.
+void db_enable_index()
 {
-    DB_FILE* ptr;
-    int pos;
+    index_is_on = true;
+}
 
-    ptr = NULL;
-    if (current_database->files_length < DB_DATABASE_FILE_LIST_CAPACITY) {
-        if (db_find_empty_position(&pos) == 0) {
-            memset(&(current_database->files[pos]), 0, sizeof(*current_database->files));
-            current_database->files[pos].database = current_database;
+// 0x4B1E70
+static int db_init_patches(DB_DATABASE* database, const char* path)
+{
+    size_t path_len;
 
-            if ((flags & 0x4) != 0) {
-                current_database->files[pos].uncompressed_file_stream = stream;
-                ptr = &(current_database->files[pos]);
-            } else {
-                current_database->files[pos].field_C = a3;
-                current_database->files[pos].field_10 = a3;
+    if (database == NULL) {
+        return -1;
+    }
 
-                switch (flags & 0xF0) {
-                case 16:
-                    current_database->files[pos].field_1C = a2;
-                    current_database->files[pos].field_20 = a2;
-                    ptr = &(current_database->files[pos]);
-                    break;
-                case 32:
-                    current_database->files[pos].field_14 = ftell(stream);
-                    current_database->files[pos].field_18 = ftell(stream);
-                    ptr = &(current_database->files[pos]);
-                    break;
-                case 64:
-                    current_database->files[pos].field_14 = ftell(stream);
-                    current_database->files[pos].field_18 = ftell(stream);
-                    current_database->files[pos].field_1C = a2;
-                    current_database->files[pos].field_20 = a2 + 0x4000;
-                    ptr = &(current_database->files[pos]);
-                    break;
-                }
-            }
-        }
+    if (path == NULL) {
+        database->patches_path = NULL;
+        return 0;
     }
 
-    if (ptr != NULL) {
-        current_database->files[pos].flags = flags;
-        current_database->files[pos].field_8 = 1;
-        current_database->files_length++;
+    path_len = strlen(path);
+    if (path_len == 0) {
+        database->patches_path = empty_patches_path;
+        return 0;
     }
 
-    return ptr;
+    database->patches_path = (char*)internal_malloc(path_len + 2);
+    if (database->patches_path == NULL) {
+        return -1;
+    }
+
+    database->should_free_patches_path = true;
+    strcpy(database->patches_path, path);
+
+    if (database->patches_path[path_len - 1] != '\\') {
+        database->patches_path[path_len] = PATH_SEP;
+        database->patches_path[path_len + 1] = '\0';
+    }
+
+    return 0;
 }
 
-// 0x4B2664
-static int db_delete_fp_rec(DB_FILE* stream)
+// 0x4B1F10
+static void db_exit_patches(DB_DATABASE* database)
 {
-    if (stream == NULL) {
-        return -1;
+    if (database == NULL) {
+        return;
     }
 
-    if ((stream->flags & 0x4) != 0) {
-        fclose(stream->uncompressed_file_stream);
-    } else {
-        switch (stream->flags & 0xF0) {
-        case 16:
-            if (stream->field_1C != NULL) {
-                internal_free(stream->field_1C);
-            }
-            break;
-        case 32:
-            break;
-        case 64:
-            if (stream->field_1C != NULL) {
-                internal_free(stream->field_1C);
-            }
-            break;
+    if (database->patches_path != NULL) {
+        if (database->should_free_patches_path == true) {
+            internal_free(database->patches_path);
         }
     }
 
-    stream->database->files_length -= 1;
-    memset(stream, 0, sizeof(*stream));
+    database->patches_path = empty_patches_path;
+    database->should_free_patches_path = false;
+}
 
-    return 0;
+// 0x4B1F3C
+static int db_init_hash_table(DB_DATABASE* database)
+{
+    if (!hash_is_on) {
+        return -1;
+    }
+
+    if (database == NULL) {
+        return -1;
+    }
+
+    if (db_path_index_resize(&(database->path_index), DB_PATH_INDEX_MIN_CAPACITY) != 0) {
+        return -1;
+    }
+
+    // CE: Datafile entries are indexed too, so that lookups do not need to
+    // binary search datafile directory.
+    if (db_path_index_add_datafile(database) != 0) {
+        return -1;
+    }
+
+    // CE: Reuse persisted list of patches if patches have not changed.
+    if (index_is_on && db_load_index_patches(database) == 0) {
+        return 0;
+    }
+
+    return db_reset_hash_table(database);
 }
 
-// 0x4B26D0
-static int db_find_empty_position(int* position_ptr)
+// 0x4B1F90
+void db_enable_hash_table()
+{
+    hash_is_on = true;
+}
+
+// CE: Enables memory mapping of datafiles opened with subsequent `db_init`
+// calls. Stored entries are then read directly from mapped pages which are
+// shared between processes via page cache.
+void db_enable_mmap()
+{
+    mmap_is_on = true;
+}
+
+// 0x4B1F9C
+static int db_reset_hash_table(DB_DATABASE* database)
 {
     int index;
 
-    if (position_ptr == NULL) {
-        return -1;
-    }
+    if (!hash_is_on) {
+        return -1;
+    }
+
+    if (database == NULL) {
+        return -1;
+    }
+
+    if (database->patches_path == NULL) {
+        return -1;
+    }
+
+    if (database->path_index.slots == NULL) {
+        return -1;
+    }
+
+    for (index = 0; index < database->path_index.capacity; index++) {
+        database->path_index.slots[index].sources &= ~DB_PATH_SOURCE_PATCHES;
+    }
+
+    db_free_patch_dirs(database);
+    database->index_dirty = true;
+
+    return db_fill_hash_table(database, database->patches_path);
+}
+
+// NOTE: Originally not static, but that would require exposing `DB_DATABASE`
+// which is most likely considered implementation detail.
+//
+// 0x4B2028
+static int db_fill_hash_table(DB_DATABASE* database, const char* path)
+{
+    char pattern[COMPAT_MAX_PATH];
+    DB_FIND_DATA find_data;
+    bool is_directory;
+    char* filename;
+
+    if (!hash_is_on) {
+        return -1;
+    }
+
+    if (database == NULL) {
+        return -1;
+    }
+
+    if (database->path_index.slots == NULL) {
+        return -1;
+    }
+
+    if (index_is_on) {
+        db_add_patch_dir(database, path);
+    }
+
+#if defined(_WIN32)
+    snprintf(pattern, sizeof(pattern), "%s%s", path, "*.*");
+#else
+    snprintf(pattern, sizeof(pattern), "%s%s", path, "*");
+#endif
+    compat_windows_path_to_native(pattern);
+
+    if (db_findfirst(pattern, &find_data) != -1) {
+        do {
+            is_directory = fileFindIsDirectory(&find_data);
+            filename = fileFindGetName(&find_data);
+
+            if (is_directory) {
+                if (strcmp(filename, ".") != 0 && strcmp(filename, "..") != 0) {
+                    snprintf(pattern, sizeof(pattern), "%s%s%c", path, filename, PATH_SEP);
+                    db_fill_hash_table(database, pattern);
+                }
+            } else {
+                // CE: Index full path instead of file name.
+                snprintf(pattern, sizeof(pattern), "%s%s", path, filename);
+                db_add_hash_entry_to_database(database, pattern, PATH_SEP);
+            }
+        } while (db_findnext(&find_data) != -1);
+
+        db_findclose(&find_data);
+    }
+
+    return 0;
+}
+
+// 0x4B2154
+int db_reset_hash_tables()
+{
+    int index;
+
+    if (!hash_is_on) {
+        return -1;
+    }
+
+    for (index = 0; index < DB_DATABASE_LIST_CAPACITY; index++) {
+        if (database_list[index] != NULL) {
+            db_reset_hash_table(database_list[index]);
+        }
+    }
+
+    return 0;
+}
+
+// 0x4B218C
+int db_add_hash_entry(const char* path, int sep)
+{
+    if (!hash_is_on) {
+        return -1;
+    }
+
+    if (current_database == NULL) {
+        return -1;
+    }
+
+    if (current_database->path_index.slots == NULL) {
+        return -1;
+    }
+
+    if (path == NULL) {
+        return -1;
+    }
+
+    return db_add_hash_entry_to_database(current_database, path, sep);
+}
+
+// CE: `path` is either relative to patches path, or includes it.
+//
+// 0x4B21E0
+static int db_add_hash_entry_to_database(DB_DATABASE* database, const char* path, int sep)
+{
+    char normalized_path[COMPAT_MAX_PATH];
+    const char* relative_path;
+
+    if (!hash_is_on) {
+        return -1;
+    }
+
+    if (database == NULL) {
+        return -1;
+    }
+
+    if (database->path_index.slots == NULL) {
+        return -1;
+    }
+
+    relative_path = path;
+    if (database->patches_path != NULL) {
+        relative_path = db_path_skip_prefix(path, database->patches_path);
+        if (relative_path == NULL) {
+            relative_path = path;
+        }
+    }
+
+    if (db_path_normalize(relative_path, sep, normalized_path, sizeof(normalized_path)) != 0) {
+        return -1;
+    }
+
+    return db_path_index_add_patch(database, normalized_path);
+}
+
+// 0x4B2420
+static void db_exit_hash_table(DB_DATABASE* database)
+{
+    if (database->path_index.slots != NULL) {
+        internal_free(database->path_index.slots);
+    }
+
+    if (database->path_index.names != NULL) {
+        internal_free(database->path_index.names);
+    }
+
+    memset(&(database->path_index), 0, sizeof(database->path_index));
+}
+
+// CE: Converts path to the form used as a key in path index - upper case,
+// backslash separated, without leading "." component.
+static int db_path_normalize(const char* path, int sep, char* dest, size_t size)
+{
+    size_t index;
+    char ch;
+
+    if (path[0] == '.' && (path[1] == '\\' || path[1] == '/' || path[1] == sep)) {
+        path += 2;
+    }
+
+    index = 0;
+    while (*path != '\0') {
+        if (index + 1 >= size) {
+            return -1;
+        }
+
+        ch = *path++;
+        if (ch == '/' || ch == sep) {
+            ch = '\\';
+        } else if (ch >= 'a' && ch <= 'z') {
+            ch -= 'a' - 'A';
+        }
+
+        dest[index++] = ch;
+    }
+
+    dest[index] = '\0';
+
+    return 0;
+}
+
+// CE: FNV-1a, never returns zero (which denotes empty slot).
+static unsigned int db_path_hash(const char* normalized_path)
+{
+    unsigned int hash = 2166136261U;
+
+    while (*normalized_path != '\0') {
+        hash ^= (unsigned char)*normalized_path++;
+        hash *= 16777619U;
+    }
+
+    return hash != 0 ? hash : 1;
+}
+
+// CE: Returns the rest of `path` if it starts with `prefix` (ignoring case and
+// separator differences), or `NULL` otherwise.
+static const char* db_path_skip_prefix(const char* path, const char* prefix)
+{
+    while (*prefix != '\0') {
+        char ch1 = *path;
+        char ch2 = *prefix;
+
+        if (ch1 == '/') {
+            ch1 = '\\';
+        }
+
+        if (ch2 == '/') {
+            ch2 = '\\';
+        }
+
+        if (ch1 >= 'a' && ch1 <= 'z') {
+            ch1 -= 'a' - 'A';
+        }
+
+        if (ch2 >= 'a' && ch2 <= 'z') {
+            ch2 -= 'a' - 'A';
+        }
+
+        if (ch1 != ch2) {
+            return NULL;
+        }
+
+        path++;
+        prefix++;
+    }
+
+    return path;
+}
+
+// CE: Looks up file `name` (as passed by caller of `db_fopen` and friends, i.e.
+// relative to both patches and datafile path). Returns -1 if path index is not
+// available and caller should fall back to probing patches and datafile.
+// Otherwise sets `record_ptr` to the matching record or `NULL` if there is no
+// such file.
+static int db_path_index_lookup(DB_DATABASE* database, const char* name, DB_PATH_RECORD** record_ptr)
+{
+    char normalized_path[COMPAT_MAX_PATH];
+    DB_PATH_RECORD* record;
+
+    if (!hash_is_on) {
+        return -1;
+    }
+
+    if (database->path_index.slots == NULL) {
+        return -1;
+    }
+
+    if (db_path_normalize(name, PATH_SEP, normalized_path, sizeof(normalized_path)) != 0) {
+        return -1;
+    }
+
+    record = db_path_index_find(&(database->path_index), normalized_path, db_path_hash(normalized_path));
+    if (record != NULL && record->sources == 0) {
+        record = NULL;
+    }
+
+    *record_ptr = record;
+
+    return 0;
+}
+
+static DB_PATH_RECORD* db_path_index_find(DB_PATH_INDEX* path_index, const char* normalized_path, unsigned int hash)
+{
+    unsigned int mask;
+    unsigned int index;
+    DB_PATH_RECORD* record;
+
+    mask = path_index->capacity - 1;
+    index = hash & mask;
+    while (true) {
+        record = &(path_index->slots[index]);
+        if (record->hash == 0) {
+            return NULL;
+        }
+
+        if (record->hash == hash && strcmp(path_index->names + record->name, normalized_path) == 0) {
+            return record;
+        }
+
+        index = (index + 1) & mask;
+    }
+}
+
+// Returns existing or new (with no sources) record for `normalized_path`.
+static DB_PATH_RECORD* db_path_index_insert(DB_PATH_INDEX* path_index, const char* normalized_path)
+{
+    unsigned int hash;
+    unsigned int mask;
+    unsigned int index;
+    size_t length;
+    DB_PATH_RECORD* record;
+
+    hash = db_path_hash(normalized_path);
+
+    record = db_path_index_find(path_index, normalized_path, hash);
+    if (record != NULL) {
+        return record;
+    }
+
+    // Keep load factor under 50%.
+    if ((path_index->length + 1) * 2 > path_index->capacity) {
+        if (db_path_index_resize(path_index, path_index->capacity * 2) != 0) {
+            return NULL;
+        }
+    }
+
+    length = strlen(normalized_path) + 1;
+    if (path_index->names_size + length > path_index->names_capacity) {
+        size_t names_capacity = path_index->names_capacity * 2;
+        char* names;
+
+        if (names_capacity < path_index->names_size + length) {
+            names_capacity = path_index->names_size + length;
+        }
+
+        names = (char*)internal_malloc(names_capacity);
+        if (names == NULL) {
+            return NULL;
+        }
+
+        if (path_index->names != NULL) {
+            memcpy(names, path_index->names, path_index->names_size);
+            internal_free(path_index->names);
+        }
+
+        path_index->names = names;
+        path_index->names_capacity = names_capacity;
+    }
+
+    mask = path_index->capacity - 1;
+    index = hash & mask;
+    while (path_index->slots[index].hash != 0) {
+        index = (index + 1) & mask;
+    }
+
+    record = &(path_index->slots[index]);
+    memset(record, 0, sizeof(*record));
+    record->hash = hash;
+    record->name = (unsigned int)path_index->names_size;
+
+    memcpy(path_index->names + path_index->names_size, normalized_path, length);
+    path_index->names_size += length;
+    path_index->length++;
+
+    return record;
+}
+
+static int db_path_index_resize(DB_PATH_INDEX* path_index, int capacity)
+{
+    DB_PATH_RECORD* slots;
+    unsigned int mask;
+    unsigned int slot;
+    int index;
+
+    if (capacity <= path_index->capacity) {
+        return 0;
+    }
+
+    slots = (DB_PATH_RECORD*)internal_malloc(sizeof(*slots) * capacity);
+    if (slots == NULL) {
+        return -1;
+    }
+
+    memset(slots, 0, sizeof(*slots) * capacity);
+
+    mask = capacity - 1;
+    for (index = 0; index < path_index->capacity; index++) {
+        DB_PATH_RECORD* record = &(path_index->slots[index]);
+        if (record->hash != 0) {
+            slot = record->hash & mask;
+            while (slots[slot].hash != 0) {
+                slot = (slot + 1) & mask;
+            }
+            slots[slot] = *record;
+        }
+    }
+
+    if (path_index->slots != NULL) {
+        internal_free(path_index->slots);
+    }
+
+    path_index->slots = slots;
+    path_index->capacity = capacity;
+
+    return 0;
+}
+
+// Adds every datafile entry reachable from datafile path.
+static int db_path_index_add_datafile(DB_DATABASE* database)
+{
+    char prefix[COMPAT_MAX_PATH];
+    char path[COMPAT_MAX_PATH];
+    char normalized_path[COMPAT_MAX_PATH];
+    const char* relative_path;
+    DB_INDEX_DIR* dir;
+    DB_INDEX_ENTRY* entry;
+    DB_PATH_RECORD* record;
+    int capacity;
+    int dir_index;
+    int entry_index;
+
+    if (database->datafile == NULL) {
+        return 0;
+    }
+
+    capacity = database->path_index.capacity;
+    while (capacity < ((DB_INDEX_HEADER*)database->index_data)->entry_count * 2) {
+        capacity *= 2;
+    }
+
+    if (db_path_index_resize(&(database->path_index), capacity) != 0) {
+        return -1;
+    }
+
+    if (db_path_normalize(database->datafile_path, '\\', prefix, sizeof(prefix)) != 0) {
+        return -1;
+    }
+
+    for (dir_index = 0; dir_index < database->index_dir_count; dir_index++) {
+        dir = &(database->index_dirs[dir_index]);
+        for (entry_index = dir->first_entry; entry_index < dir->first_entry + dir->entry_count; entry_index++) {
+            entry = &(database->index_entries[entry_index]);
+
+            if (strcmp(database->index_strings + dir->name, ".") == 0) {
+                snprintf(path, sizeof(path), "%s", database->index_strings + entry->name);
+            } else {
+                snprintf(path, sizeof(path), "%s\\%s", database->index_strings + dir->name, database->index_strings + entry->name);
+            }
+
+            if (db_path_normalize(path, '\\', normalized_path, sizeof(normalized_path)) != 0) {
+                continue;
+            }
+
+            relative_path = db_path_skip_prefix(normalized_path, prefix);
+            if (relative_path == NULL) {
+                continue;
+            }
+
+            record = db_path_index_insert(&(database->path_index), relative_path);
+            if (record == NULL) {
+                return -1;
+            }
+
+            record->sources |= DB_PATH_SOURCE_DATAFILE;
+            record->de = entry->de;
+        }
+    }
+
+    return 0;
+}
+
+static int db_path_index_add_patch(DB_DATABASE* database, const char* normalized_path)
+{
+    DB_PATH_RECORD* record;
+
+    record = db_path_index_insert(&(database->path_index), normalized_path);
+    if (record == NULL) {
+        return -1;
+    }
+
+    if ((record->sources & DB_PATH_SOURCE_PATCHES) == 0) {
+        record->sources |= DB_PATH_SOURCE_PATCHES;
+
+        // New patch file (i.e. the one written by the game) invalidates
+        // persisted list of patches.
+        database->index_dirty = true;
+    }
+
+    return 0;
+}
+
+// CE: Returns modification time of patches directory `filespec` refers to,
+// 0 if database has no patches, or -1 if directory does not exist.
+static long long db_file_list_patches_mtime(DB_DATABASE* database, const char* filespec, bool relative)
+{
+    char path[COMPAT_MAX_PATH];
+    char* sep;
+    long long mtime;
+
+    if (database->patches_path == NULL) {
+        return 0;
+    }
+
+    if (relative) {
+        snprintf(path, sizeof(path), "%s%s", database->patches_path, filespec);
+    } else {
+        strcpy(path, filespec);
+    }
+
+    sep = strrchr(path, '\\');
+    if (sep != NULL) {
+        sep[1] = '\0';
+    } else if (relative) {
+        strcpy(path, database->patches_path);
+    } else {
+        path[0] = '\0';
+    }
+
+    if (path[0] == '\0') {
+        strcpy(path, ".");
+    }
+
+    if (compat_stat(path, NULL, &mtime) != 0) {
+        return -1;
+    }
+
+    return mtime;
+}
+
+// CE: Copies cached list into newly allocated `filelist` (laid out the same
+// way as in `db_get_file_list`). Returns the number of files, or -1 if list
+// is not cached.
+static int db_file_list_cache_find(DB_DATABASE* database, const char* filespec, long long patches_mtime, char*** filelist)
+{
+    char normalized_filespec[COMPAT_MAX_PATH];
+    DB_FILE_LIST_CACHE_ENTRY** link;
+    DB_FILE_LIST_CACHE_ENTRY* entry;
+    int index;
+
+    if (db_path_normalize(filespec, PATH_SEP, normalized_filespec, sizeof(normalized_filespec)) != 0) {
+        return -1;
+    }
+
+    link = &(database->file_lists);
+    while (*link != NULL) {
+        entry = *link;
+        if (strcmp(entry->filespec, normalized_filespec) == 0) {
+            break;
+        }
+        link = &(entry->next);
+    }
+
+    if (*link == NULL) {
+        return -1;
+    }
+
+    if (entry->patches_mtime != patches_mtime) {
+        *link = entry->next;
+        database->file_lists_length--;
+        db_file_list_cache_free_entry(entry);
+        return -1;
+    }
+
+    if (entry->count != 0) {
+        *filelist = (char**)internal_malloc((sizeof(char*) + 13) * entry->count);
+        if (*filelist == NULL) {
+            return -1;
+        }
+
+        memcpy((char*)*filelist + sizeof(char*) * entry->count, entry->names, 13 * entry->count);
+        for (index = 0; index < entry->count; index++) {
+            (*filelist)[index] = (char*)*filelist + sizeof(char*) * entry->count + 13 * index;
+        }
+    }
+
+    // Move to front.
+    *link = entry->next;
+    entry->next = database->file_lists;
+    database->file_lists = entry;
+
+    return entry->count;
+}
+
+static void db_file_list_cache_add(DB_DATABASE* database, const char* filespec, long long patches_mtime, char** filelist, int count)
+{
+    char normalized_filespec[COMPAT_MAX_PATH];
+    DB_FILE_LIST_CACHE_ENTRY* entry;
+    DB_FILE_LIST_CACHE_ENTRY** link;
+
+    if (db_path_normalize(filespec, PATH_SEP, normalized_filespec, sizeof(normalized_filespec)) != 0) {
+        return;
+    }
+
+    entry = (DB_FILE_LIST_CACHE_ENTRY*)internal_malloc(sizeof(*entry));
+    if (entry == NULL) {
+        return;
+    }
+
+    entry->filespec = internal_strdup(normalized_filespec);
+    if (entry->filespec == NULL) {
+        internal_free(entry);
+        return;
+    }
+
+    entry->names = NULL;
+    if (count != 0) {
+        entry->names = (char*)internal_malloc(13 * count);
+        if (entry->names == NULL) {
+            internal_free(entry->filespec);
+            internal_free(entry);
+            return;
+        }
+
+        // Names are stored right after pointers.
+        memcpy(entry->names, (char*)filelist + sizeof(char*) * count, 13 * count);
+    }
+
+    entry->patches_mtime = patches_mtime;
+    entry->count = count;
+    entry->next = database->file_lists;
+    database->file_lists = entry;
+    database->file_lists_length++;
+
+    if (database->file_lists_length > DB_FILE_LIST_CACHE_CAPACITY) {
+        // Drop least recently used list.
+        link = &(database->file_lists);
+        while ((*link)->next != NULL) {
+            link = &((*link)->next);
+        }
+
+        entry = *link;
+        *link = NULL;
+        database->file_lists_length--;
+        db_file_list_cache_free_entry(entry);
+    }
+}
+
+static void db_file_list_cache_flush(DB_DATABASE* database)
+{
+    DB_FILE_LIST_CACHE_ENTRY* entry;
+
+    while (database->file_lists != NULL) {
+        entry = database->file_lists;
+        database->file_lists = entry->next;
+        db_file_list_cache_free_entry(entry);
+    }
+
+    database->file_lists_length = 0;
+}
+
+static void db_file_list_cache_free_entry(DB_FILE_LIST_CACHE_ENTRY* entry)
+{
+    if (entry->names != NULL) {
+        internal_free(entry->names);
+    }
+
+    internal_free(entry->filespec);
+    internal_free(entry);
+}
+
+// 0x4B2444
+static DB_FILE* db_add_fp_rec(FILE* stream, unsigned char* a2, int a3, int flags)
+{
+    DB_FILE* ptr;
+    int pos;
+
+    ptr = NULL;
+    if (current_database->files_length < DB_DATABASE_FILE_LIST_CAPACITY) {
+        if (db_find_empty_position(&pos) == 0) {
+            memset(&(current_database->files[pos]), 0, sizeof(*current_database->files));
+            current_database->files[pos].database = current_database;
+
+            if ((flags & 0x4) != 0) {
+                current_database->files[pos].uncompressed_file_stream = stream;
+                ptr = &(current_database->files[pos]);
+            } else {
+                current_database->files[pos].field_C = a3;
+                current_database->files[pos].field_10 = a3;
+
+                switch (flags & 0xF0) {
+                case 16:
+                case 128:
+                    current_database->files[pos].field_1C = a2;
+                    current_database->files[pos].field_20 = a2;
+                    ptr = &(current_database->files[pos]);
+                    break;
+                case 32:
+                    current_database->files[pos].field_14 = ftell(stream);
+                    current_database->files[pos].field_18 = ftell(stream);
+                    ptr = &(current_database->files[pos]);
+                    break;
+                case 64:
+                    current_database->files[pos].field_14 = ftell(stream);
+                    current_database->files[pos].field_18 = ftell(stream);
+                    current_database->files[pos].field_1C = a2;
+                    current_database->files[pos].field_20 = a2 + 0x4000;
+                    ptr = &(current_database->files[pos]);
+                    break;
+                }
+            }
+        }
+    }
+
+    if (ptr != NULL) {
+        current_database->files[pos].flags = flags;
+        current_database->files[pos].field_8 = 1;
+        current_database->files_length++;
+    }
+
+    return ptr;
+}
+
+// 0x4B2664
+static int db_delete_fp_rec(DB_FILE* stream)
+{
+    int rc;
+
+    if (stream == NULL) {
+        return -1;
+    }
+
+    db_trace_close(stream);
+
+    rc = 0;
+    if ((stream->flags & 0x4) != 0) {
+        // CE: Write pending output of buffered stream.
+        rc = db_write_buffer_flush(stream);
+        if (stream->write_buffer != NULL) {
+            internal_free(stream->write_buffer);
+        }
+
+        if ((stream->flags & DB_FILE_MEMORY) == 0 && fclose(stream->uncompressed_file_stream) != 0) {
+            rc = -1;
+        }
+    } else {
+        switch (stream->flags & 0xF0) {
+        case 16:
+            if (stream->field_1C != NULL) {
+                internal_free(stream->field_1C);
+            }
+            break;
+        case 32:
+            break;
+        case 128:
+            // Views into mapped datafile or cache are not owned by the stream.
+            if (stream->cache_entry != NULL) {
+                db_cache_release(stream->cache_entry);
+            }
+            break;
+        case 64:
+            if (stream->field_1C != NULL) {
+                internal_free(stream->field_1C);
+            }
+            if (stream->block_offsets != NULL) {
+                internal_free(stream->block_offsets);
+            }
+            break;
+        }
+    }
+
+    stream->database->files_length -= 1;
+    memset(stream, 0, sizeof(*stream));
+
+    return rc;
+}
+
+// 0x4B26D0
+static int db_find_empty_position(int* position_ptr)
+{
+    int index;
+
+    if (position_ptr == NULL) {
+        return -1;
+    }
+
+    if (current_database->files_length >= DB_DATABASE_FILE_LIST_CAPACITY) {
+        return -1;
+    }
+
+    for (index = 0; index < DB_DATABASE_FILE_LIST_CAPACITY; index++) {
+        if (current_database->files[index].field_8 == 0) {
+            *position_ptr = index;
+            return 0;
+        }
+    }
+
+    return -1;
+}
+
+// 0x4B2714
+static int db_find_dir_entry(char* path, dir_entry* de)
+{
+    char* normalized_path;
+    int pos;
+    int dir_index;
+    int entry_index;
+
+    normalized_path = path;
+
+    if (current_database->datafile == NULL) {
+        return -1;
+    }
+
+    if (path == NULL) {
+        return -1;
+    }
+
+    if (de == NULL) {
+        return -1;
+    }
+
+    if (path[0] == '.') {
+        normalized_path = path + 1;
+        if (path[1] == '\\') {
+            normalized_path = path + 2;
+        }
+    }
+
+    pos = strlen(normalized_path) - 1;
+    while (pos >= 0) {
+        if (normalized_path[pos] == '\\') {
+            break;
+        }
+        pos--;
+    }
+
+    if (pos >= 0) {
+        normalized_path[pos] = '\0';
+        dir_index = db_index_find_dir(current_database, normalized_path);
+    } else {
+        dir_index = 0;
+    }
+
+    if (dir_index == -1) {
+        if (pos >= 0) {
+            normalized_path[pos] = '\\';
+        }
+        return -1;
+    }
+
+    entry_index = db_index_find_entry(current_database, dir_index, normalized_path + pos + 1);
+    if (entry_index == -1) {
+        if (pos >= 0) {
+            normalized_path[pos] = '\\';
+        }
+        return -1;
+    }
+
+    if (pos >= 0) {
+        normalized_path[pos] = '\\';
+    }
+
+    *de = current_database->index_entries[entry_index].de;
+
+    return 0;
+}
+
+// 0x4B2810
+static int db_findfirst(const char* path, DB_FIND_DATA* findData)
+{
+#if defined(_WIN32)
+    findData->hFind = FindFirstFileA(path, &(findData->ffd));
+    if (findData->hFind == INVALID_HANDLE_VALUE) {
+        return -1;
+    }
+#else
+    strcpy(findData->path, path);
+
+    char drive[COMPAT_MAX_DRIVE];
+    char dir[COMPAT_MAX_DIR];
+    compat_splitpath(path, drive, dir, NULL, NULL);
+
+    char basePath[COMPAT_MAX_PATH];
+    compat_makepath(basePath, drive, dir, NULL, NULL);
+
+    compat_resolve_path(basePath);
+    findData->dir = opendir(basePath);
+    if (findData->dir == NULL) {
+        return -1;
+    }
+
+    findData->entry = readdir(findData->dir);
+    while (findData->entry != NULL) {
+        char entryPath[COMPAT_MAX_PATH];
+        compat_makepath(entryPath, drive, dir, fileFindGetName(findData), NULL);
+        if (fpattern_match(findData->path, entryPath)) {
+            break;
+        }
+        findData->entry = readdir(findData->dir);
+    }
+
+    if (findData->entry == NULL) {
+        closedir(findData->dir);
+        findData->dir = NULL;
+        return -1;
+    }
+#endif
+
+    return 0;
+}
+
+// 0x4B2838
+static int db_findnext(DB_FIND_DATA* findData)
+{
+#if defined(_WIN32)
+    if (!FindNextFileA(findData->hFind, &(findData->ffd))) {
+        return -1;
+    }
+#else
+    char drive[COMPAT_MAX_DRIVE];
+    char dir[COMPAT_MAX_DIR];
+    compat_splitpath(findData->path, drive, dir, NULL, NULL);
+
+    findData->entry = readdir(findData->dir);
+    while (findData->entry != NULL) {
+        char entryPath[COMPAT_MAX_PATH];
+        compat_makepath(entryPath, drive, dir, fileFindGetName(findData), NULL);
+        if (fpattern_match(findData->path, entryPath)) {
+            break;
+        }
+        findData->entry = readdir(findData->dir);
+    }
+
+    if (findData->entry == NULL) {
+        closedir(findData->dir);
+        findData->dir = NULL;
+        return -1;
+    }
+#endif
+
+    return 0;
+}
+
+// 0x4B2854
+static int db_findclose(DB_FIND_DATA* findData)
+{
+#if defined(_WIN32)
+    if (!FindClose(findData->hFind)) {
+        return -1;
+    }
+#else
+    if (findData->dir != NULL) {
+        if (closedir(findData->dir) != 0) {
+            return -1;
+        }
+    }
+#endif
+
+    return 0;
+}
+
+// 0x4B2868
+static void* internal_malloc(size_t size)
+{
+    db_used_malloc = true;
+    return db_malloc(size);
+}
+
+// 0x4B287C
+static char* internal_strdup(const char* string)
+{
+    db_used_malloc = true;
+    return db_strdup(string);
+}
+
+// 0x4B2890
+static void internal_free(void* ptr)
+{
+    db_free(ptr);
+}
+
+// 0x4B2898
+static void* db_default_malloc(size_t size)
+{
+    return malloc(size);
+}
+
+// 0x4B28A0
+static char* db_default_strdup(const char* string)
+{
+    return compat_strdup(string);
+}
+
+// 0x4B28A8
+static void db_default_free(void* ptr)
+{
+    free(ptr);
+}
+
+// 0x4B28B0
+static void db_preload_buffer(DB_FILE* stream)
+{
+    unsigned short v1;
+    unsigned char* mapped;
+    Uint64 decode_start;
+    int decoded;
+
+    if ((stream->flags & 0x8) != 0 && (stream->flags & 0xF0) == 64) {
+        if (stream->field_10 != 0) {
+            if (stream->field_20 >= stream->field_1C + 0x4000) {
+                decode_start = stream->traced ? db_trace_now() : 0;
+
+                // CE: Decode next block straight from mapped datafile.
+                mapped = db_mapped_range(stream->database, stream->field_18, 2);
+                if (mapped != NULL) {
+                    v1 = (mapped[0] << 8) | mapped[1];
+                    if (db_mapped_range(stream->database, stream->field_18 + 2, v1 & ~0x8000) != NULL) {
+                        if ((v1 & 0x8000) != 0) {
+                            v1 &= ~0x8000;
+                            memcpy(stream->field_1C, mapped + 2, v1);
+                        } else {
+                            ProfScope profScope(PROF_ZONE_LZSS_DECODE);
+                            decoded = lzss_decode_mem_to_buf(mapped + 2, v1, stream->field_1C, 0x4000);
+                            if (stream->traced && decoded != -1) {
+                                db_trace_decoded(stream->trace_record, decode_start, decoded);
+                            }
+                        }
+
+                        stream->field_20 = stream->field_1C;
+                        stream->field_18 += 2 + v1;
+                        return;
+                    }
+                }
+
+                if (fseek(stream->database->stream, stream->field_18, SEEK_SET) == 0) {
+                    if (fread_short(stream->database->stream, &v1) == 0) {
+                        if ((v1 & 0x8000) != 0) {
+                            v1 &= ~0x8000;
+                            fread(stream->field_1C, 1, v1, stream->database->stream);
+                        } else {
+                            ProfScope profScope(PROF_ZONE_LZSS_DECODE);
+                            decoded = lzss_decode_to_buf(stream->database->stream, stream->field_1C, v1);
+                            if (stream->traced) {
+                                db_trace_decoded(stream->trace_record, decode_start, decoded);
+                            }
+                        }
+
+                        stream->field_20 = stream->field_1C;
+                        stream->field_18 = ftell(stream->database->stream);
+                    }
+                }
+            }
+        }
+    }
+}
+
+// Reads block offset table which follows block-compressed entry data.
+static int db_load_block_table(DB_FILE* stream, dir_entry* de)
+{
+    int block_count;
+    long table_offset;
+    unsigned char* mapped;
+    unsigned char bytes[4];
+    int index;
+
+    if (de->length <= 0) {
+        return -1;
+    }
+
+    block_count = (de->length + 0x3FFF) / 0x4000;
+    table_offset = de->offset + de->field_C - block_count * 4;
+    if (table_offset < de->offset) {
+        return -1;
+    }
+
+    stream->block_offsets = (unsigned int*)internal_malloc(sizeof(*stream->block_offsets) * block_count);
+    if (stream->block_offsets == NULL) {
+        return -1;
+    }
+
+    mapped = stream->database->mapped_data;
+    if (mapped != NULL && (size_t)table_offset + block_count * 4 <= stream->database->mapped_size) {
+        mapped += table_offset;
+        for (index = 0; index < block_count; index++) {
+            stream->block_offsets[index] = (mapped[0] << 24) | (mapped[1] << 16) | (mapped[2] << 8) | mapped[3];
+            mapped += 4;
+        }
+    } else {
+        if (fseek(stream->database->stream, table_offset, SEEK_SET) != 0) {
+            internal_free(stream->block_offsets);
+            stream->block_offsets = NULL;
+            return -1;
+        }
+
+        for (index = 0; index < block_count; index++) {
+            if (fread(bytes, 1, 4, stream->database->stream) != 4) {
+                internal_free(stream->block_offsets);
+                stream->block_offsets = NULL;
+                return -1;
+            }
+
+            stream->block_offsets[index] = (bytes[0] << 24) | (bytes[1] << 16) | (bytes[2] << 8) | bytes[3];
+        }
+    }
+
+    stream->block_count = block_count;
+
+    return 0;
+}
+
+// Decodes entire compressed entry into `buf`, which should be at least
+// `de->length` bytes.
+static int db_decode_entry(DB_DATABASE* database, dir_entry* de, unsigned char* buf)
+{
+    unsigned char* mapped;
+    Uint64 start;
+    int rc;
+
+    ProfScope profScope(PROF_ZONE_LZSS_DECODE);
+
+    start = db_trace_now();
+
+    // CE: Decode straight from mapped datafile when possible.
+    mapped = db_mapped_range(database, de->offset, de->field_C);
+    if (mapped != NULL) {
+        rc = db_decode_mapped_entry(mapped, de, buf);
+    } else {
+        rc = db_decode_stream_entry(database, de, buf);
+    }
+
+    if (rc == 0) {
+        db_trace_decoded(db_trace.current, start, de->length);
+    }
+
+    return rc;
+}
+
+static int db_decode_stream_entry(DB_DATABASE* database, dir_entry* de, unsigned char* buf)
+{
+    unsigned char* end;
+    unsigned short v1;
+
+    if (fseek(database->stream, de->offset, SEEK_SET) != 0) {
+        return -1;
+    }
+
+    switch (de->flags & 0xF0) {
+    case 16:
+        lzss_decode_to_buf(database->stream, buf, de->field_C);
+        return 0;
+    case 64:
+        end = buf + de->length;
+        while (buf < end) {
+            if (fread_short(database->stream, &v1) != 0) {
+                return -1;
+            }
+
+            if ((v1 & 0x8000) != 0) {
+                v1 &= ~0x8000;
+                if (buf + v1 > end) {
+                    return -1;
+                }
+                fread(buf, 1, v1, database->stream);
+                buf += v1;
+            } else {
+                buf += lzss_decode_to_buf(database->stream, buf, v1);
+            }
+        }
+        return 0;
+    }
+
+    return -1;
+}
+
+static int db_decode_mapped_entry(unsigned char* mapped, dir_entry* de, unsigned char* buf)
+{
+    unsigned char* end;
+    unsigned char* mapped_end;
+    unsigned short v1;
+    int decoded;
+
+    switch (de->flags & 0xF0) {
+    case 16:
+        if (lzss_decode_mem_to_buf(mapped, de->field_C, buf, de->length) == -1) {
+            return -1;
+        }
+        return 0;
+    case 64:
+        end = buf + de->length;
+        mapped_end = mapped + de->field_C;
+        while (buf < end) {
+            if (mapped_end - mapped < 2) {
+                return -1;
+            }
+
+            v1 = (mapped[0] << 8) | mapped[1];
+            mapped += 2;
+
+            if ((v1 & 0x8000) != 0) {
+                v1 &= ~0x8000;
+                if (buf + v1 > end || mapped + v1 > mapped_end) {
+                    return -1;
+                }
+                memcpy(buf, mapped, v1);
+                buf += v1;
+            } else {
+                if (mapped + v1 > mapped_end) {
+                    return -1;
+                }
+
+                decoded = lzss_decode_mem_to_buf(mapped, v1, buf, (unsigned int)(end - buf));
+                if (decoded == -1) {
+                    return -1;
+                }
+                buf += decoded;
+            }
+
+            mapped += v1;
+        }
+        return 0;
+    }
+
+    return -1;
+}
+
+// CE: Sets the maximum size of decompressed entries cache (in bytes). Passing
+// zero disables cache. Entries which no longer fit are evicted.
+void db_cache_set_size(size_t size)
+{
+    db_cache.capacity = size;
+    db_cache_make_room(0);
+}
+
+// CE: Waits until queued reads are finished, hands their results over and
+// stops prefetch thread (it is started again by the next request). Used
+// before the process is forked, since only calling thread survives `fork`.
+void db_prefetch_quiesce()
+{
+    DB_PREFETCH_JOB* job;
+    bool busy;
+
+    if (db_prefetch_state.thread == NULL) {
+        return;
+    }
+
+    while (true) {
+        busy = false;
+
+        SDL_LockMutex(db_prefetch_state.mutex);
+        for (job = db_prefetch_state.head; job != NULL; job = job->next) {
+            if (job->state == DB_PREFETCH_QUEUED || job->state == DB_PREFETCH_RUNNING) {
+                busy = true;
+                break;
+            }
+        }
+        SDL_UnlockMutex(db_prefetch_state.mutex);
+
+        if (!busy) {
+            break;
+        }
+
+        SDL_Delay(1);
+    }
+
+    db_prefetch_collect(NULL, -1);
+    db_prefetch_exit();
+}
+
+// CE: Reopens datafiles of every database at their current positions. Forked
+// process shares file offsets with its parent through inherited handles, so
+// it has to have handles of its own before reading anything.
+int db_reopen_datafiles()
+{
+    int rc = 0;
+
+    for (int index = 0; index < DB_DATABASE_LIST_CAPACITY; index++) {
+        DB_DATABASE* database = database_list[index];
+        if (database == NULL || database->stream == NULL) {
+            continue;
+        }
+
+        long pos = ftell(database->stream);
+
+        FILE* stream = compat_fopen(database->datafile, "rb");
+        if (stream == NULL || fseek(stream, pos, SEEK_SET) != 0) {
+            if (stream != NULL) {
+                fclose(stream);
+            }
+            rc = -1;
+            continue;
+        }
+
+        fclose(database->stream);
+        database->stream = stream;
+    }
+
+    return rc;
+}
+
+// CE: Frees all cached entries that are not being read at the moment.
+void db_cache_flush()
+{
+    DB_CACHE_ENTRY* entry = db_cache.tail;
+    while (entry != NULL) {
+        DB_CACHE_ENTRY* prev = entry->prev;
+        if (entry->ref_count == 0) {
+            db_cache_remove(entry);
+        }
+        entry = prev;
+    }
+}
+
+void db_cache_get_stats(db_cache_stats* stats)
+{
+    stats->capacity = db_cache.capacity;
+    stats->size = db_cache.size;
+    stats->entries = db_cache.entries;
+    stats->hits = db_cache.hits;
+    stats->misses = db_cache.misses;
+    stats->evictions = db_cache.evictions;
+}
+
+// CE: Saves decompressed payloads held by `db_cache` into startup image at
+// `path`, so that the next run can skip reading and decompressing them (see
+// `db_image_load`). Image is tied to current datafiles and `build_id`.
+int db_image_save(const char* path, const char* build_id)
+{
+    char temp_path[COMPAT_MAX_PATH];
+    DB_IMAGE_HEADER header;
+    DB_IMAGE_DATABASE* databases;
+    DB_IMAGE_ENTRY* entries;
+    DB_CACHE_ENTRY** sources;
+    DB_CACHE_ENTRY* cache_entry;
+    DB_DATABASE* database_map[DB_DATABASE_LIST_CAPACITY];
+    FILE* stream;
+    size_t data_offset;
+    size_t padding;
+    int database_count;
+    int entry_count;
+    int index;
+    int rc;
+
+    static const unsigned char zeroes[DB_IMAGE_ALIGNMENT] = { 0 };
+
+    if (path == NULL || build_id == NULL) {
+        return -1;
+    }
+
+    // Hand over reads which are still in flight.
+    db_prefetch_quiesce();
+
+    databases = (DB_IMAGE_DATABASE*)internal_malloc(sizeof(*databases) * DB_DATABASE_LIST_CAPACITY);
+    entries = (DB_IMAGE_ENTRY*)internal_malloc(sizeof(*entries) * (db_cache.entries + 1));
+    sources = (DB_CACHE_ENTRY**)internal_malloc(sizeof(*sources) * (db_cache.entries + 1));
+    if (databases == NULL || entries == NULL || sources == NULL) {
+        if (sources != NULL) {
+            internal_free(sources);
+        }
+
+        if (entries != NULL) {
+            internal_free(entries);
+        }
+
+        if (databases != NULL) {
+            internal_free(databases);
+        }
+
+        return -1;
+    }
+
+    memset(databases, 0, sizeof(*databases) * DB_DATABASE_LIST_CAPACITY);
+
+    database_count = 0;
+    for (index = 0; index < DB_DATABASE_LIST_CAPACITY; index++) {
+        DB_DATABASE* database = database_list[index];
+        if (database == NULL || database->datafile == NULL) {
+            continue;
+        }
+
+        if (compat_stat(database->datafile, &(databases[database_count].datafile_size), &(databases[database_count].datafile_mtime)) != 0) {
+            continue;
+        }
+
+        strncpy(databases[database_count].datafile, database->datafile, COMPAT_MAX_PATH - 1);
+        database_map[database_count] = database;
+        database_count++;
+    }
+
+    entry_count = 0;
+    for (cache_entry = db_cache.head; cache_entry != NULL; cache_entry = cache_entry->next) {
+        for (index = 0; index < database_count; index++) {
+            if (database_map[index] == cache_entry->database) {
+                break;
+            }
+        }
+
+        // Skip entries of closed databases.
+        if (index == database_count) {
+            continue;
+        }
+
+        entries[entry_count].database = index;
+        entries[entry_count].offset = cache_entry->offset;
+        entries[entry_count].length = cache_entry->length;
+        sources[entry_count] = cache_entry;
+        entry_count++;
+    }
+
+    data_offset = sizeof(header) + sizeof(*databases) * database_count + sizeof(*entries) * entry_count;
+    for (index = 0; index < entry_count; index++) {
+        data_offset = (data_offset + DB_IMAGE_ALIGNMENT - 1) & ~(size_t)(DB_IMAGE_ALIGNMENT - 1);
+        entries[index].data_offset = (unsigned int)data_offset;
+        data_offset += entries[index].length;
+    }
+
+    header.magic = DB_IMAGE_MAGIC;
+    header.version = DB_IMAGE_VERSION;
+    header.build_id = db_image_hash(build_id);
+    header.database_count = database_count;
+    header.entry_count = entry_count;
+    header.reserved = 0;
+
+    snprintf(temp_path, sizeof(temp_path), "%s.tmp", path);
+
+    rc = -1;
+    stream = compat_fopen(temp_path, "wb");
+    if (stream != NULL) {
+        rc = 0;
+        if (fwrite(&header, sizeof(header), 1, stream) != 1
+            || (database_count != 0 && fwrite(databases, sizeof(*databases) * database_count, 1, stream) != 1)
+            || (entry_count != 0 && fwrite(entries, sizeof(*entries) * entry_count, 1, stream) != 1)) {
+            rc = -1;
+        }
+
+        data_offset = sizeof(header) + sizeof(*databases) * database_count + sizeof(*entries) * entry_count;
+        for (index = 0; index < entry_count && rc == 0; index++) {
+            padding = entries[index].data_offset - data_offset;
+            if (padding != 0 && fwrite(zeroes, padding, 1, stream) != 1) {
+                rc = -1;
+                break;
+            }
+
+            if (entries[index].length != 0 && fwrite(sources[index]->data, entries[index].length, 1, stream) != 1) {
+                rc = -1;
+                break;
+            }
+
+            data_offset = entries[index].data_offset + entries[index].length;
+        }
+
+        fclose(stream);
+    }
+
+    internal_free(sources);
+    internal_free(entries);
+    internal_free(databases);
+
+    if (rc != 0) {
+        compat_remove(temp_path);
+        return -1;
+    }
+
+#if defined(_WIN32)
+    // Rename does not replace existing files on Windows.
+    compat_remove(path);
+#endif
+
+    if (compat_rename(temp_path, path) != 0) {
+        compat_remove(temp_path);
+        return -1;
+    }
+
+    return entry_count;
+}
+
+// CE: Maps startup image saved by `db_image_save` and adds its payloads to
+// `db_cache` (without copying them), so that files read during startup are
+// served from cache. Image is rejected when it was made by another build or
+// any of its datafiles is not open or has changed. Returns the number of
+// cached entries, or -1 if image is missing or stale.
+int db_image_load(const char* path, const char* build_id)
+{
+    FILE* stream;
+    unsigned char* data;
+    size_t size;
+    bool mapped;
+    DB_IMAGE_HEADER* header;
+    DB_IMAGE_DATABASE* databases;
+    DB_IMAGE_ENTRY* entries;
+    DB_DATABASE* database_map[DB_DATABASE_LIST_CAPACITY];
+    DB_CACHE_ENTRY* cache_entry;
+    long long datafile_size;
+    long long datafile_mtime;
+    int loaded;
+    int index;
+    int other;
+
+    if (path == NULL || build_id == NULL || db_image_data != NULL || db_cache.capacity == 0) {
+        return -1;
+    }
+
+    stream = compat_fopen(path, "rb");
+    if (stream == NULL) {
+        return -1;
+    }
+
+    mapped = true;
+    data = (unsigned char*)compat_map_file(stream, &size);
+    if (data == NULL) {
+        mapped = false;
+        size = getFileSize(stream);
+        data = (unsigned char*)internal_malloc(size > 0 ? size : 1);
+        if (data == NULL) {
+            fclose(stream);
+            return -1;
+        }
+
+        if (fread(data, 1, size, stream) != size) {
+            internal_free(data);
+            fclose(stream);
+            return -1;
+        }
+    }
+
+    fclose(stream);
+
+    db_image_data = data;
+    db_image_size = size;
+    db_image_mapped = mapped;
+
+    header = (DB_IMAGE_HEADER*)data;
+    if (size < sizeof(*header)
+        || header->magic != DB_IMAGE_MAGIC
+        || header->version != DB_IMAGE_VERSION
+        || header->build_id != db_image_hash(build_id)
+        || header->database_count < 0
+        || header->database_count > DB_DATABASE_LIST_CAPACITY
+        || header->entry_count < 0
+        || size < sizeof(*header) + sizeof(*databases) * header->database_count + sizeof(*entries) * header->entry_count) {
+        db_image_release();
+        return -1;
+    }
+
+    databases = (DB_IMAGE_DATABASE*)(data + sizeof(*header));
+    entries = (DB_IMAGE_ENTRY*)(data + sizeof(*header) + sizeof(*databases) * header->database_count);
+
+    for (index = 0; index < header->database_count; index++) {
+        databases[index].datafile[COMPAT_MAX_PATH - 1] = '\0';
+
+        database_map[index] = NULL;
+        for (other = 0; other < DB_DATABASE_LIST_CAPACITY; other++) {
+            DB_DATABASE* database = database_list[other];
+            if (database != NULL && database->datafile != NULL && strcmp(database->datafile, databases[index].datafile) == 0) {
+                database_map[index] = database;
+                break;
+            }
+        }
+
+        if (database_map[index] == NULL
+            || compat_stat(databases[index].datafile, &datafile_size, &datafile_mtime) != 0
+            || datafile_size != databases[index].datafile_size
+            || datafile_mtime != databases[index].datafile_mtime) {
+            db_image_release();
+            return -1;
+        }
+    }
+
+    loaded = 0;
+    for (index = 0; index < header->entry_count; index++) {
+        DB_IMAGE_ENTRY* entry = &(entries[index]);
+        if (entry->database < 0
+            || entry->database >= header->database_count
+            || entry->length < 0
+            || (size_t)entry->data_offset > size
+            || (size_t)entry->length > size - entry->data_offset) {
+            continue;
+        }
+
+        if (db_cache_contains(database_map[entry->database], entry->offset)) {
+            continue;
+        }
+
+        cache_entry = db_cache_insert(database_map[entry->database], entry->offset, data + entry->data_offset, entry->length);
+        if (cache_entry == NULL) {
+            break;
+        }
+
+        cache_entry->borrowed = true;
+        loaded++;
+    }
+
+    return loaded;
+}
+
+// Releases startup image. Called once databases are closed, borrowed entries
+// are gone by then.
+static void db_image_release()
+{
+    if (db_image_data == NULL) {
+        return;
+    }
+
+    if (db_image_mapped) {
+        compat_unmap_file(db_image_data, db_image_size);
+    } else {
+        internal_free(db_image_data);
+    }
+
+    db_image_data = NULL;
+    db_image_size = 0;
+    db_image_mapped = false;
+}
+
+// FNV-1a hash of build id.
+static unsigned int db_image_hash(const char* string)
+{
+    unsigned int hash = 2166136261u;
+    while (*string != '\0') {
+        hash ^= (unsigned char)*string++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static DB_CACHE_ENTRY* db_cache_find(DB_DATABASE* database, int offset)
+{
+    DB_CACHE_ENTRY* entry;
+
+    if (db_cache.capacity == 0) {
+        return NULL;
+    }
+
+    entry = db_cache.buckets[(unsigned int)offset % DB_CACHE_BUCKET_COUNT];
+    while (entry != NULL) {
+        if (entry->database == database && entry->offset == offset) {
+            break;
+        }
+        entry = entry->next_in_bucket;
+    }
+
+    if (entry == NULL) {
+        return NULL;
+    }
+
+    // Move to the head of LRU list.
+    if (entry != db_cache.head) {
+        entry->prev->next = entry->next;
+        if (entry->next != NULL) {
+            entry->next->prev = entry->prev;
+        } else {
+            db_cache.tail = entry->prev;
+        }
+
+        entry->prev = NULL;
+        entry->next = db_cache.head;
+        db_cache.head->prev = entry;
+        db_cache.head = entry;
+    }
+
+    db_cache.hits++;
+
+    return entry;
+}
+
+// Adds decompressed payload to cache. On success cache takes ownership of
+// `data`.
+static DB_CACHE_ENTRY* db_cache_insert(DB_DATABASE* database, int offset, unsigned char* data, int length)
+{
+    DB_CACHE_ENTRY* entry;
+    unsigned int bucket;
+
+    if (!db_cache_make_room(length)) {
+        return NULL;
+    }
+
+    entry = (DB_CACHE_ENTRY*)internal_malloc(sizeof(*entry));
+    if (entry == NULL) {
+        return NULL;
+    }
+
+    bucket = (unsigned int)offset % DB_CACHE_BUCKET_COUNT;
+
+    entry->database = database;
+    entry->offset = offset;
+    entry->length = length;
+    entry->data = data;
+    entry->ref_count = 0;
+    entry->borrowed = false;
+    entry->next_in_bucket = db_cache.buckets[bucket];
+    db_cache.buckets[bucket] = entry;
+
+    entry->prev = NULL;
+    entry->next = db_cache.head;
+    if (db_cache.head != NULL) {
+        db_cache.head->prev = entry;
+    } else {
+        db_cache.tail = entry;
+    }
+    db_cache.head = entry;
+
+    db_cache.size += length;
+    db_cache.entries++;
+
+    return entry;
+}
+
+// Evicts least recently used entries until there is enough room for `size`
+// bytes.
+static bool db_cache_make_room(size_t size)
+{
+    DB_CACHE_ENTRY* entry;
+
+    if (size > db_cache.capacity) {
+        return false;
+    }
+
+    entry = db_cache.tail;
+    while (entry != NULL && db_cache.size + size > db_cache.capacity) {
+        DB_CACHE_ENTRY* prev = entry->prev;
+        if (entry->ref_count == 0) {
+            db_cache_remove(entry);
+            db_cache.evictions++;
+        }
+        entry = prev;
+    }
+
+    return db_cache.size + size <= db_cache.capacity;
+}
+
+static void db_cache_remove(DB_CACHE_ENTRY* entry)
+{
+    DB_CACHE_ENTRY** link = &(db_cache.buckets[(unsigned int)entry->offset % DB_CACHE_BUCKET_COUNT]);
+    while (*link != entry) {
+        link = &((*link)->next_in_bucket);
+    }
+    *link = entry->next_in_bucket;
+
+    if (entry->prev != NULL) {
+        entry->prev->next = entry->next;
+    } else {
+        db_cache.head = entry->next;
+    }
+
+    if (entry->next != NULL) {
+        entry->next->prev = entry->prev;
+    } else {
+        db_cache.tail = entry->prev;
+    }
+
+    db_cache.size -= entry->length;
+    db_cache.entries--;
+
+    if (!entry->borrowed) {
+        internal_free(entry->data);
+    }
+    internal_free(entry);
+}
+
+static void db_cache_release(DB_CACHE_ENTRY* entry)
+{
+    entry->ref_count--;
+
+    // Entries of closed databases are freed as soon as they are not used.
+    if (entry->ref_count == 0 && entry->database == NULL) {
+        db_cache_remove(entry);
+    }
+}
+
+static void db_cache_flush_database(DB_DATABASE* database)
+{
+    DB_CACHE_ENTRY* entry = db_cache.tail;
+    while (entry != NULL) {
+        DB_CACHE_ENTRY* prev = entry->prev;
+        if (entry->database == database) {
+            if (entry->ref_count == 0) {
+                db_cache_remove(entry);
+            } else {
+                entry->database = NULL;
+            }
+        }
+        entry = prev;
+    }
+}
+
+static DB_FILE* db_add_cache_fp_rec(DB_CACHE_ENTRY* entry, int flags)
+{
+    DB_FILE* stream = db_add_fp_rec(NULL, entry->data, entry->length, flags | 0x80 | 0x8);
+    if (stream != NULL) {
+        stream->cache_entry = entry;
+        entry->ref_count++;
+    }
+    return stream;
+}
+
+static bool db_cache_contains(DB_DATABASE* database, int offset)
+{
+    DB_CACHE_ENTRY* entry;
+
+    entry = db_cache.buckets[(unsigned int)offset % DB_CACHE_BUCKET_COUNT];
+    while (entry != NULL) {
+        if (entry->database == database && entry->offset == offset) {
+            return true;
+        }
+        entry = entry->next_in_bucket;
+    }
+
+    return false;
+}
+
+// CE: Schedules reading of given files of the current database in background.
+// Compressed entries are decompressed into `db_cache` (when it's enabled and
+// entry is small enough to be cached), stored entries are only advised to the
+// OS. Files which are overridden by patches are skipped. Returns the number of
+// scheduled files, or -1 on error.
+int db_prefetch(const char** paths, int count)
+{
+    return db_prefetch_group(paths, count, 0, NULL);
+}
+
+// CE: Same as `db_prefetch`, but tags scheduled jobs with `group` and stops
+// once entries scheduled by this call would exceed `budget` bytes (which is
+// decremented, `NULL` means unlimited).
+int db_prefetch_group(const char** paths, int count, int group, size_t* budget)
+{
+    char path[COMPAT_MAX_PATH];
+    DB_PATH_RECORD* record;
+    DB_PREFETCH_JOB* job;
+    DB_PREFETCH_JOB* other;
+    dir_entry de;
+    unsigned char* data;
+    int type;
+    int index;
+    int queued;
+
+    if (current_database == NULL || current_database->datafile == NULL) {
+        return -1;
+    }
+
+    if (paths == NULL) {
+        return -1;
+    }
+
+    if (db_prefetch_state.thread == NULL) {
+        if (db_prefetch_init() != 0) {
+            return -1;
+        }
+    }
+
+    // Hand over finished jobs to cache first, so that they're not counted
+    // against prefetch budget.
+    db_prefetch_collect(NULL, -1);
+
+    queued = 0;
+    for (index = 0; index < count; index++) {
+        if (paths[index] == NULL || paths[index][0] == '@') {
+            continue;
+        }
+
+        if (db_path_index_lookup(current_database, paths[index], &record) == 0) {
+            if (record == NULL
+                || (record->sources & DB_PATH_SOURCE_PATCHES) != 0
+                || (record->sources & DB_PATH_SOURCE_DATAFILE) == 0) {
+                continue;
+            }
+
+            de = record->de;
+        } else {
+            snprintf(path, sizeof(path), "%s%s", current_database->datafile_path, paths[index]);
+            compat_strupr(path);
+
+            if (db_find_dir_entry(path, &de) != 0) {
+                continue;
+            }
+        }
+
+        if (de.flags == 0) {
+            de.flags = 16;
+        }
+
+        type = de.flags & 0xF0;
+        if (type != 16 && type != 32 && type != 64) {
+            continue;
+        }
+
+        if (budget != NULL && (size_t)de.length > *budget) {
+            break;
+        }
+
+        data = NULL;
+        if (type == 16 || type == 64) {
+            if (db_cache_contains(current_database, de.offset)) {
+                continue;
+            }
+
+            // Same policy as in `db_fopen`, in-flight payloads are limited to
+            // half of the cache so that they do not evict each other.
+            if (db_cache.capacity != 0
+                && (size_t)de.length <= db_cache.capacity / 8
+                && db_prefetch_state.size + de.length <= db_cache.capacity / 2) {
+                data = (unsigned char*)internal_malloc(de.length);
+            }
+        }
+
+        job = (DB_PREFETCH_JOB*)internal_malloc(sizeof(*job));
+        if (job == NULL) {
+            if (data != NULL) {
+                internal_free(data);
+            }
+            break;
+        }
+
+        job->database = current_database;
+        job->de = de;
+        job->data = data;
+        job->state = DB_PREFETCH_QUEUED;
+        job->next = NULL;
+        job->path = NULL;
+        job->has_entry = true;
+        job->callback = NULL;
+        job->user_data = NULL;
+        job->group = group;
+
+        SDL_LockMutex(db_prefetch_state.mutex);
+
+        for (other = db_prefetch_state.head; other != NULL; other = other->next) {
+            if (other->database == job->database && other->de.offset == job->de.offset) {
+                break;
+            }
+        }
+
+        if (other == NULL) {
+            if (db_prefetch_state.tail != NULL) {
+                db_prefetch_state.tail->next = job;
+            } else {
+                db_prefetch_state.head = job;
+            }
+            db_prefetch_state.tail = job;
+
+            if (data != NULL) {
+                db_prefetch_state.size += de.length;
+            }
+
+            SDL_CondSignal(db_prefetch_state.cond);
+            queued++;
+
+            if (budget != NULL) {
+                *budget -= de.length;
+            }
+        }
+
+        SDL_UnlockMutex(db_prefetch_state.mutex);
+
+        if (other != NULL) {
+            db_prefetch_free_job(job);
+        }
+    }
+
+    return queued;
+}
+
+// CE: Drops jobs scheduled by `db_prefetch_group` with given group which are
+// not yet started. Running and finished jobs are left alone, finished ones
+// still end up in cache. Returns the number of dropped jobs.
+int db_prefetch_cancel_group(int group)
+{
+    DB_PREFETCH_JOB** link;
+    DB_PREFETCH_JOB* job;
+    DB_PREFETCH_JOB* prev;
+    int cancelled;
+
+    if (db_prefetch_state.thread == NULL || group == 0) {
+        return 0;
+    }
+
+    cancelled = 0;
+
+    SDL_LockMutex(db_prefetch_state.mutex);
+
+    prev = NULL;
+    link = &(db_prefetch_state.head);
+    while (*link != NULL) {
+        job = *link;
+        if (job->group != group || job->callback != NULL || job->state != DB_PREFETCH_QUEUED) {
+            prev = job;
+            link = &(job->next);
+            continue;
+        }
+
+        *link = job->next;
+        if (db_prefetch_state.tail == job) {
+            db_prefetch_state.tail = prev;
+        }
+
+        if (job->data != NULL) {
+            db_prefetch_state.size -= job->de.length;
+        }
+
+        db_prefetch_free_job(job);
+        cancelled++;
+    }
+
+    SDL_UnlockMutex(db_prefetch_state.mutex);
+
+    return cancelled;
+}
+
+// CE: Reads given file of the current database on prefetch thread. File is
+// resolved the same way as in `db_fopen` (patches first). The callback
+// receives entire (decompressed) contents, or `NULL` on failure, and is
+// called exactly once: on prefetch thread, or on the calling thread if the
+// read is cancelled (because database is closed). The data is only valid
+// during the call.
+int db_read_async(const char* filename, db_read_async_callback* callback, void* user_data)
+{
+    char path[COMPAT_MAX_PATH];
+    DB_PATH_RECORD* record;
+    DB_PREFETCH_JOB* job;
+    dir_entry de;
+    bool indexed;
+    bool has_patches_path;
+    bool has_entry;
+
+    if (current_database == NULL || filename == NULL || callback == NULL) {
+        return -1;
+    }
+
+    if (db_prefetch_state.thread == NULL) {
+        if (db_prefetch_init() != 0) {
+            return -1;
+        }
+    }
+
+    db_prefetch_collect(NULL, -1);
+
+    has_patches_path = false;
+    has_entry = false;
+
+    if (filename[0] == '@') {
+        strcpy(path, filename + 1);
+        compat_windows_path_to_native(path);
+        has_patches_path = true;
+    } else {
+        record = NULL;
+        indexed = db_path_index_lookup(current_database, filename, &record) == 0;
+
+        if (current_database->patches_path != NULL
+            && (!indexed || (record != NULL && (record->sources & DB_PATH_SOURCE_PATCHES) != 0))) {
+            snprintf(path, sizeof(path), "%s%s", current_database->patches_path, filename);
+            compat_windows_path_to_native(path);
+            has_patches_path = true;
+        }
+
+        if (current_database->datafile != NULL) {
+            if (indexed) {
+                if (record != NULL && (record->sources & DB_PATH_SOURCE_DATAFILE) != 0) {
+                    de = record->de;
+                    has_entry = true;
+                }
+            } else {
+                char entry_path[COMPAT_MAX_PATH];
+                snprintf(entry_path, sizeof(entry_path), "%s%s", current_database->datafile_path, filename);
+                compat_strupr(entry_path);
+
+                if (db_find_dir_entry(entry_path, &de) == 0) {
+                    has_entry = true;
+                }
+            }
+        }
+    }
+
+    if (!has_patches_path && !has_entry) {
+        return -1;
+    }
+
+    if (has_entry) {
+        if (de.flags == 0) {
+            de.flags = 16;
+        }
+
+        if ((de.flags & 0xF0) != 16 && (de.flags & 0xF0) != 32 && (de.flags & 0xF0) != 64) {
+            has_entry = false;
+        }
+    }
+
+    job = (DB_PREFETCH_JOB*)internal_malloc(sizeof(*job));
+    if (job == NULL) {
+        return -1;
+    }
+
+    memset(job, 0, sizeof(*job));
+    job->database = current_database;
+    job->state = DB_PREFETCH_QUEUED;
+    job->callback = callback;
+    job->user_data = user_data;
+    job->has_entry = has_entry;
+
+    if (has_entry) {
+        job->de = de;
+    }
+
+    if (has_patches_path) {
+        job->path = internal_strdup(path);
+        if (job->path == NULL) {
+            internal_free(job);
+            return -1;
+        }
+    }
+
+    // Unlike `db_prefetch` jobs are not merged, every caller expects its
+    // callback.
+    SDL_LockMutex(db_prefetch_state.mutex);
+
+    if (db_prefetch_state.tail != NULL) {
+        db_prefetch_state.tail->next = job;
+    } else {
+        db_prefetch_state.head = job;
+    }
+    db_prefetch_state.tail = job;
+
+    SDL_CondSignal(db_prefetch_state.cond);
+
+    SDL_UnlockMutex(db_prefetch_state.mutex);
+
+    return 0;
+}
+
+static int db_prefetch_init()
+{
+    memset(&db_prefetch_state, 0, sizeof(db_prefetch_state));
+
+    db_prefetch_state.mutex = SDL_CreateMutex();
+    if (db_prefetch_state.mutex == NULL) {
+        return -1;
+    }
+
+    db_prefetch_state.cond = SDL_CreateCond();
+    if (db_prefetch_state.cond == NULL) {
+        SDL_DestroyMutex(db_prefetch_state.mutex);
+        db_prefetch_state.mutex = NULL;
+        return -1;
+    }
+
+    db_prefetch_state.thread = SDL_CreateThread(db_prefetch_thread, "db_prefetch", NULL);
+    if (db_prefetch_state.thread == NULL) {
+        SDL_DestroyCond(db_prefetch_state.cond);
+        SDL_DestroyMutex(db_prefetch_state.mutex);
+        db_prefetch_state.cond = NULL;
+        db_prefetch_state.mutex = NULL;
+        return -1;
+    }
+
+    return 0;
+}
+
+static void db_prefetch_exit()
+{
+    DB_PREFETCH_JOB* job;
+
+    if (db_prefetch_state.thread == NULL) {
+        return;
+    }
+
+    SDL_LockMutex(db_prefetch_state.mutex);
+    db_prefetch_state.quit = true;
+    SDL_CondBroadcast(db_prefetch_state.cond);
+    SDL_UnlockMutex(db_prefetch_state.mutex);
+
+    SDL_WaitThread(db_prefetch_state.thread, NULL);
+
+    while (db_prefetch_state.head != NULL) {
+        job = db_prefetch_state.head;
+        db_prefetch_state.head = job->next;
+        db_prefetch_free_job(job);
+    }
+
+    SDL_DestroyCond(db_prefetch_state.cond);
+    SDL_DestroyMutex(db_prefetch_state.mutex);
+
+    memset(&db_prefetch_state, 0, sizeof(db_prefetch_state));
+}
+
+static int db_prefetch_thread(void* data)
+{
+    DB_PREFETCH_JOB* job;
+    FILE* stream;
+    DB_DATABASE* stream_database;
+
+    stream = NULL;
+    stream_database = NULL;
+
+    SDL_LockMutex(db_prefetch_state.mutex);
+
+    while (!db_prefetch_state.quit) {
+        if (db_prefetch_state.reset_stream) {
+            db_prefetch_state.reset_stream = false;
+            if (stream != NULL) {
+                fclose(stream);
+                stream = NULL;
+            }
+            stream_database = NULL;
+        }
+
+        for (job = db_prefetch_state.head; job != NULL; job = job->next) {
+            if (job->state == DB_PREFETCH_QUEUED) {
+                break;
+            }
+        }
+
+        if (job == NULL) {
+            // Do not keep datafile open while idle.
+            if (stream != NULL) {
+                fclose(stream);
+                stream = NULL;
+            }
+            stream_database = NULL;
+
+            SDL_CondWait(db_prefetch_state.cond, db_prefetch_state.mutex);
+            continue;
+        }
+
+        job->state = DB_PREFETCH_RUNNING;
+        SDL_UnlockMutex(db_prefetch_state.mutex);
+
+        {
+            ProfScope profScope(PROF_ZONE_DB_PREFETCH_WORKER, job->path);
+            db_prefetch_run(job, &stream, &stream_database);
+        }
+
+        SDL_LockMutex(db_prefetch_state.mutex);
+        SDL_CondBroadcast(db_prefetch_state.cond);
+    }
+
+    SDL_UnlockMutex(db_prefetch_state.mutex);
+
+    if (stream != NULL) {
+        fclose(stream);
+    }
+
+    return 0;
+}
+
+// Runs on prefetch thread. Database is guaranteed to stay open while the job
+// is running (see `db_prefetch_cancel`).
+static void db_prefetch_run(DB_PREFETCH_JOB* job, FILE** stream_ptr, DB_DATABASE** stream_database_ptr)
+{
+    dir_entry* de;
+    unsigned char* mapped;
+    unsigned char* packed;
+    long size;
+    int rc;
+
+    if (job->callback != NULL) {
+        size_t data_size;
+        unsigned char* data = db_prefetch_read(job, stream_ptr, stream_database_ptr, &data_size);
+        job->callback(job->user_data, data, data_size);
+        free(data);
+
+        SDL_LockMutex(db_prefetch_state.mutex);
+        job->state = DB_PREFETCH_DONE;
+        SDL_UnlockMutex(db_prefetch_state.mutex);
+        return;
+    }
+
+    de = &(job->de);
+    size = (de->flags & 0xF0) == 32 ? de->length : de->field_C;
+    rc = 0;
+
+    mapped = db_mapped_range(job->database, de->offset, size);
+    if (mapped != NULL) {
+        compat_advise_willneed(mapped, size);
+
+        if (job->data != NULL) {
+            rc = db_decode_mapped_entry(mapped, de, job->data);
+        }
+    } else {
+        // Main thread's datafile stream cannot be shared, so prefetch thread
+        // uses its own.
+        if (*stream_database_ptr != job->database) {
+            if (*stream_ptr != NULL) {
+                fclose(*stream_ptr);
+            }
+
+            *stream_ptr = compat_fopen(job->database->datafile, "rb");
+            *stream_database_ptr = job->database;
+        }
+
+        if (*stream_ptr == NULL) {
+            rc = -1;
+        } else if (job->data == NULL) {
+            compat_advise_file_willneed(*stream_ptr, de->offset, size);
+        } else {
+            // Plain `malloc` is used since it's private to this thread.
+            packed = (unsigned char*)malloc(size > 0 ? size : 1);
+            if (packed == NULL) {
+                rc = -1;
+            } else {
+                if (fseek(*stream_ptr, de->offset, SEEK_SET) != 0
+                    || fread(packed, 1, size, *stream_ptr) != (size_t)size) {
+                    rc = -1;
+                } else {
+                    rc = db_decode_mapped_entry(packed, de, job->data);
+                }
+                free(packed);
+            }
+        }
+    }
+
+    SDL_LockMutex(db_prefetch_state.mutex);
+    job->state = rc == 0 ? DB_PREFETCH_DONE : DB_PREFETCH_FAILED;
+    SDL_UnlockMutex(db_prefetch_state.mutex);
+}
+
+// Reads entire file of `db_read_async` job into buffer allocated with plain
+// `malloc` (this runs on prefetch thread). Returns `NULL` on failure.
+static unsigned char* db_prefetch_read(DB_PREFETCH_JOB* job, FILE** stream_ptr, DB_DATABASE** stream_database_ptr, size_t* size_ptr)
+{
+    dir_entry* de;
+    unsigned char* data;
+    unsigned char* mapped;
+    unsigned char* packed;
+    FILE* stream;
+    long size;
+    int rc;
+
+    *size_ptr = 0;
+
+    if (job->path != NULL) {
+        stream = compat_fopen(job->path, "rb");
+        if (stream != NULL) {
+            data = NULL;
+            if (fseek(stream, 0, SEEK_END) == 0) {
+                size = ftell(stream);
+                if (size >= 0 && fseek(stream, 0, SEEK_SET) == 0) {
+                    data = (unsigned char*)malloc(size > 0 ? size : 1);
+                    if (data != NULL && fread(data, 1, size, stream) != (size_t)size) {
+                        free(data);
+                        data = NULL;
+                    }
+                }
+            }
+            fclose(stream);
+
+            if (data != NULL) {
+                *size_ptr = size;
+            }
+
+            // Datafile entry is not a fallback for unreadable patches file,
+            // same as in `db_fopen`.
+            return data;
+        }
+    }
+
+    if (!job->has_entry) {
+        return NULL;
+    }
+
+    de = &(job->de);
+    size = (de->flags & 0xF0) == 32 ? de->length : de->field_C;
+
+    data = (unsigned char*)malloc(de->length > 0 ? de->length : 1);
+    if (data == NULL) {
+        return NULL;
+    }
+
+    rc = -1;
+    mapped = db_mapped_range(job->database, de->offset, size);
+    if (mapped != NULL) {
+        if ((de->flags & 0xF0) == 32) {
+            memcpy(data, mapped, de->length);
+            rc = 0;
+        } else {
+            rc = db_decode_mapped_entry(mapped, de, data);
+        }
+    } else {
+        if (*stream_database_ptr != job->database) {
+            if (*stream_ptr != NULL) {
+                fclose(*stream_ptr);
+            }
+
+            *stream_ptr = compat_fopen(job->database->datafile, "rb");
+            *stream_database_ptr = job->database;
+        }
+
+        if (*stream_ptr != NULL && fseek(*stream_ptr, de->offset, SEEK_SET) == 0) {
+            if ((de->flags & 0xF0) == 32) {
+                if (fread(data, 1, de->length, *stream_ptr) == (size_t)de->length) {
+                    rc = 0;
+                }
+            } else {
+                packed = (unsigned char*)malloc(size > 0 ? size : 1);
+                if (packed != NULL) {
+                    if (fread(packed, 1, size, *stream_ptr) == (size_t)size) {
+                        rc = db_decode_mapped_entry(packed, de, data);
+                    }
+                    free(packed);
+                }
+            }
+        }
+    }
+
+    if (rc != 0) {
+        free(data);
+        return NULL;
+    }
+
+    *size_ptr = de->length;
+
+    return data;
+}
+
+// Moves finished jobs into cache. If `database` is given, also makes sure the
+// entry at `offset` is not being prefetched - waits for it if it's running,
+// or drops it if it's not started yet (the caller is about to read it
+// anyway).
+static void db_prefetch_collect(DB_DATABASE* database, int offset)
+{
+    DB_PREFETCH_JOB** link;
+    DB_PREFETCH_JOB* job;
+    DB_PREFETCH_JOB* prev;
+    bool remove;
+
+    if (db_prefetch_state.thread == NULL) {
+        return;
+    }
+
+    SDL_LockMutex(db_prefetch_state.mutex);
+
+    prev = NULL;
+    link = &(db_prefetch_state.head);
+    while (*link != NULL) {
+        job = *link;
+        remove = false;
+
+        if (job->state == DB_PREFETCH_DONE) {
+            if (job->data != NULL && job->database != NULL && !db_cache_contains(job->database, job->de.offset)) {
+                db_prefetch_state.size -= job->de.length;
+                if (db_cache_insert(job->database, job->de.offset, job->data, job->de.length) != NULL) {
+                    job->data = NULL;
+                } else {
+                    db_prefetch_state.size += job->de.length;
+                }
+            }
+            remove = true;
+        } else if (job->state == DB_PREFETCH_FAILED) {
+            remove = true;
+        } else if (database != NULL && job->database == database && job->de.offset == offset && job->callback == NULL) {
+            if (job->state == DB_PREFETCH_RUNNING) {
+                // Only this thread modifies the list, so it's safe to
+                // continue from the same link.
+                SDL_CondWait(db_prefetch_state.cond, db_prefetch_state.mutex);
+                continue;
+            }
+
+            remove = true;
+        }
+
+        if (remove) {
+            *link = job->next;
+            if (db_prefetch_state.tail == job) {
+                db_prefetch_state.tail = prev;
+            }
+
+            if (job->data != NULL) {
+                db_prefetch_state.size -= job->de.length;
+            }
+
+            db_prefetch_free_job(job);
+        } else {
+            prev = job;
+            link = &(job->next);
+        }
+    }
+
+    SDL_UnlockMutex(db_prefetch_state.mutex);
+}
+
+// Drops all jobs of the database which is about to be closed.
+static void db_prefetch_cancel(DB_DATABASE* database)
+{
+    DB_PREFETCH_JOB** link;
+    DB_PREFETCH_JOB* job;
+    DB_PREFETCH_JOB* prev;
+
+    if (db_prefetch_state.thread == NULL) {
+        return;
+    }
+
+    SDL_LockMutex(db_prefetch_state.mutex);
+
+    prev = NULL;
+    link = &(db_prefetch_state.head);
+    while (*link != NULL) {
+        job = *link;
+        if (job->database != database) {
+            prev = job;
+            link = &(job->next);
+            continue;
+        }
+
+        if (job->state == DB_PREFETCH_RUNNING) {
+            SDL_CondWait(db_prefetch_state.cond, db_prefetch_state.mutex);
+            continue;
+        }
+
+        *link = job->next;
+        if (db_prefetch_state.tail == job) {
+            db_prefetch_state.tail = prev;
+        }
+
+        if (job->data != NULL) {
+            db_prefetch_state.size -= job->de.length;
+        }
+
+        db_prefetch_free_job(job);
+    }
+
+    db_prefetch_state.reset_stream = true;
+    SDL_CondSignal(db_prefetch_state.cond);
+
+    SDL_UnlockMutex(db_prefetch_state.mutex);
+}
+
+static void db_prefetch_free_job(DB_PREFETCH_JOB* job)
+{
+    // `db_read_async` job dropped before it could run.
+    if (job->callback != NULL && job->state != DB_PREFETCH_DONE) {
+        job->callback(job->user_data, NULL, 0);
+    }
+
+    if (job->data != NULL) {
+        internal_free(job->data);
+    }
+
+    if (job->path != NULL) {
+        internal_free(job->path);
+    }
+
+    internal_free(job);
+}
+
+// CE: Enables or disables collection of per-file I/O counters. Disabling
+// keeps collected data so that it can still be queried or dumped.
+void db_trace_enable(bool enable)
+{
+    int database_index;
+    int file_index;
+
+    if (enable == db_trace.enabled) {
+        return;
+    }
+
+    if (enable) {
+        if (db_trace.records == NULL) {
+            db_trace.base = SDL_GetPerformanceCounter();
+        }
+    } else {
+        // Detach open streams, they are not tracked past this point.
+        for (database_index = 0; database_index < DB_DATABASE_LIST_CAPACITY; database_index++) {
+            if (database_list[database_index] != NULL) {
+                for (file_index = 0; file_index < DB_DATABASE_FILE_LIST_CAPACITY; file_index++) {
+                    database_list[database_index]->files[file_index].traced = false;
+                }
+            }
+        }
+    }
+
+    db_trace.enabled = enable;
+    db_trace.current = -1;
+}
+
+bool db_trace_is_enabled()
+{
+    return db_trace.enabled;
+}
+
+// CE: Discards all collected counters and events.
+void db_trace_reset()
+{
+    bool enabled;
+    int index;
+
+    enabled = db_trace.enabled;
+    db_trace_enable(false);
+
+    for (index = 0; index < db_trace.records_length; index++) {
+        internal_free(db_trace.records[index].name);
+    }
+
+    for (index = 0; index < db_trace.events_length; index++) {
+        if (db_trace.events[index].label != NULL) {
+            internal_free(db_trace.events[index].label);
+        }
+    }
+
+    if (db_trace.records != NULL) {
+        internal_free(db_trace.records);
+    }
+
+    if (db_trace.slots != NULL) {
+        internal_free(db_trace.slots);
+    }
+
+    if (db_trace.events != NULL) {
+        internal_free(db_trace.events);
+    }
+
+    memset(&db_trace, 0, sizeof(db_trace));
+    db_trace.current = -1;
+
+    db_trace_enable(enabled);
+}
+
+// CE: Adds named mark to the trace (for example beginning of map loading).
+void db_trace_mark(const char* label)
+{
+    Uint64 now;
+
+    if (!db_trace.enabled || label == NULL) {
+        return;
+    }
+
+    now = SDL_GetPerformanceCounter();
+    db_trace_add_event(-1, label, now, now, 0);
+}
+
+int db_trace_get_file_count()
+{
+    return db_trace.records_length;
+}
+
+int db_trace_get_file_stats(int index, db_trace_file_stats* stats)
+{
+    DB_TRACE_RECORD* record;
+
+    if (index < 0 || index >= db_trace.records_length) {
+        return -1;
+    }
+
+    record = &(db_trace.records[index]);
+    stats->name = record->name;
+    stats->source = record->source;
+    stats->opens = record->opens;
+    stats->reads = record->reads;
+    stats->seeks = record->seeks;
+    stats->cache_hits = record->cache_hits;
+    stats->bytes_read = record->bytes_read;
+    stats->bytes_decompressed = record->bytes_decompressed;
+    stats->decode_time = db_trace_ticks_to_ms(record->decode_ticks);
+
+    return 0;
+}
+
+// CE: Sums counters of all files (`name` is set to `NULL`, `source` to -1).
+void db_trace_get_totals(db_trace_file_stats* stats)
+{
+    Uint64 decode_ticks;
+    int index;
+
+    memset(stats, 0, sizeof(*stats));
+    stats->source = -1;
+
+    decode_ticks = 0;
+    for (index = 0; index < db_trace.records_length; index++) {
+        DB_TRACE_RECORD* record = &(db_trace.records[index]);
+        stats->opens += record->opens;
+        stats->reads += record->reads;
+        stats->seeks += record->seeks;
+        stats->cache_hits += record->cache_hits;
+        stats->bytes_read += record->bytes_read;
+        stats->bytes_decompressed += record->bytes_decompressed;
+        decode_ticks += record->decode_ticks;
+    }
+
+    stats->decode_time = db_trace_ticks_to_ms(decode_ticks);
+}
+
+// CE: Writes per-file counters as CSV (native path, not affected by patches).
+int db_trace_dump_csv(const char* path)
+{
+    FILE* stream;
+    DB_TRACE_RECORD* record;
+    int index;
+
+    stream = compat_fopen(path, "wt");
+    if (stream == NULL) {
+        return -1;
+    }
+
+    fprintf(stream, "name,source,opens,reads,seeks,cache_hits,bytes_read,bytes_decompressed,decode_ms\n");
+
+    for (index = 0; index < db_trace.records_length; index++) {
+        record = &(db_trace.records[index]);
+        fprintf(stream, "\"%s\",%s,%u,%u,%u,%u,%llu,%llu,%.3f\n",
+            record->name,
+            db_trace_source_name(record->source),
+            record->opens,
+            record->reads,
+            record->seeks,
+            record->cache_hits,
+            (unsigned long long)record->bytes_read,
+            (unsigned long long)record->bytes_decompressed,
+            db_trace_ticks_to_ms(record->decode_ticks));
+    }
+
+    fclose(stream);
+
+    return 0;
+}
+
+// CE: Writes open/close spans and marks in Chrome trace event format (which
+// can be loaded into `chrome://tracing` or Perfetto).
+int db_trace_dump_chrome(const char* path)
+{
+    FILE* stream;
+    DB_TRACE_EVENT* event;
+    const char* name;
+    int index;
+
+    stream = compat_fopen(path, "wt");
+    if (stream == NULL) {
+        return -1;
+    }
+
+    fprintf(stream, "{\"traceEvents\":[\n");
+
+    for (index = 0; index < db_trace.events_length; index++) {
+        event = &(db_trace.events[index]);
+        name = event->label != NULL ? event->label : db_trace.records[event->record].name;
+
+        fprintf(stream, "%s{\"name\":\"", index != 0 ? ",\n" : "");
+
+        // Names are paths, backslashes and quotes are the only characters
+        // which need to be escaped.
+        for (; *name != '\0'; name++) {
+            if (*name == '\\' || *name == '"') {
+                fputc('\\', stream);
+            }
+            fputc(*name, stream);
+        }
+
+        if (event->label != NULL) {
+            fprintf(stream, "\",\"cat\":\"mark\",\"ph\":\"i\",\"s\":\"g\",\"pid\":1,\"tid\":1,\"ts\":%.3f}",
+                db_trace_ticks_to_ms(event->start - db_trace.base) * 1000.0);
+        } else {
+            fprintf(stream, "\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"bytes\":%llu}}",
+                db_trace_source_name(db_trace.records[event->record].source),
+                db_trace_ticks_to_ms(event->start - db_trace.base) * 1000.0,
+                db_trace_ticks_to_ms(event->end - event->start) * 1000.0,
+                (unsigned long long)event->bytes);
+        }
+    }
+
+    fprintf(stream, "\n],\"otherData\":{\"dropped_events\":%u}}\n", db_trace.dropped_events);
+
+    fclose(stream);
+
+    return 0;
+}
+
+static Uint64 db_trace_now()
+{
+    return db_trace.enabled ? SDL_GetPerformanceCounter() : 0;
+}
+
+// Returns index of record for given file (creating one if needed), or -1 if
+// tracing is disabled.
+static int db_trace_find_record(const char* name, int source)
+{
+    char normalized_name[COMPAT_MAX_PATH];
+    DB_TRACE_RECORD* record;
+    unsigned int hash;
+    unsigned int mask;
+    unsigned int slot;
+
+    if (!db_trace.enabled) {
+        return -1;
+    }
+
+    if (db_path_normalize(name, PATH_SEP, normalized_name, sizeof(normalized_name)) != 0) {
+        return -1;
+    }
+
+    if (db_trace.records_length >= db_trace.slots_capacity / 2) {
+        if (db_trace_resize(db_trace.slots_capacity != 0 ? db_trace.slots_capacity * 2 : DB_TRACE_MIN_CAPACITY) != 0) {
+            return -1;
+        }
+    }
+
+    hash = db_path_hash(normalized_name);
+    mask = db_trace.slots_capacity - 1;
+    slot = hash & mask;
+    while (db_trace.slots[slot] != 0) {
+        record = &(db_trace.records[db_trace.slots[slot] - 1]);
+        if (record->hash == hash && strcmp(record->name, normalized_name) == 0) {
+            record->source = source;
+            return db_trace.slots[slot] - 1;
+        }
+        slot = (slot + 1) & mask;
+    }
+
+    record = &(db_trace.records[db_trace.records_length]);
+    memset(record, 0, sizeof(*record));
+
+    record->name = internal_strdup(normalized_name);
+    if (record->name == NULL) {
+        return -1;
+    }
+
+    record->hash = hash;
+    record->source = source;
+
+    db_trace.slots[slot] = ++db_trace.records_length;
+
+    return db_trace.records_length - 1;
+}
+
+static int db_trace_resize(int capacity)
+{
+    DB_TRACE_RECORD* records;
+    int* slots;
+    unsigned int mask;
+    unsigned int slot;
+    int index;
+
+    records = (DB_TRACE_RECORD*)internal_malloc(sizeof(*records) * (capacity / 2));
+    if (records == NULL) {
+        return -1;
+    }
+
+    slots = (int*)internal_malloc(sizeof(*slots) * capacity);
+    if (slots == NULL) {
+        internal_free(records);
+        return -1;
+    }
+
+    memset(slots, 0, sizeof(*slots) * capacity);
+
+    if (db_trace.records != NULL) {
+        memcpy(records, db_trace.records, sizeof(*records) * db_trace.records_length);
+        internal_free(db_trace.records);
+    }
+
+    if (db_trace.slots != NULL) {
+        internal_free(db_trace.slots);
+    }
+
+    mask = capacity - 1;
+    for (index = 0; index < db_trace.records_length; index++) {
+        slot = records[index].hash & mask;
+        while (slots[slot] != 0) {
+            slot = (slot + 1) & mask;
+        }
+        slots[slot] = index + 1;
+    }
+
+    db_trace.records = records;
+    db_trace.records_capacity = capacity / 2;
+    db_trace.slots = slots;
+    db_trace.slots_capacity = capacity;
+
+    return 0;
+}
+
+static DB_FILE* db_trace_open(DB_FILE* stream, int record, Uint64 start)
+{
+    if (stream != NULL && record != -1) {
+        db_trace.records[record].opens++;
+
+        stream->traced = true;
+        stream->trace_record = record;
+        stream->trace_start = start;
+        stream->trace_bytes = 0;
+    }
+
+    return stream;
+}
+
+static void db_trace_close(DB_FILE* stream)
+{
+    if (stream->traced) {
+        db_trace_add_event(stream->trace_record, NULL, stream->trace_start, SDL_GetPerformanceCounter(), stream->trace_bytes);
+        stream->traced = false;
+    }
+}
+
+// Accounts entire file read with `db_read_to_buf`.
+static void db_trace_read(int record, Uint64 start, size_t bytes)
+{
+    if (record == -1) {
+        return;
+    }
+
+    db_trace.records[record].opens++;
+    db_trace.records[record].reads++;
+    db_trace.records[record].bytes_read += bytes;
+
+    db_trace_add_event(record, NULL, start, SDL_GetPerformanceCounter(), bytes);
+}
+
+static void db_trace_decoded(int record, Uint64 start, size_t bytes)
+{
+    if (record == -1 || !db_trace.enabled) {
+        return;
+    }
+
+    db_trace.records[record].bytes_decompressed += bytes;
+    db_trace.records[record].decode_ticks += SDL_GetPerformanceCounter() - start;
+}
+
+static void db_trace_add_event(int record, const char* label, Uint64 start, Uint64 end, size_t bytes)
+{
+    DB_TRACE_EVENT* events;
+    DB_TRACE_EVENT* event;
+    int capacity;
+
+    if (db_trace.events_length == db_trace.events_capacity) {
+        if (db_trace.events_capacity >= DB_TRACE_MAX_EVENTS) {
+            db_trace.dropped_events++;
+            return;
+        }
+
+        capacity = db_trace.events_capacity != 0 ? db_trace.events_capacity * 2 : DB_TRACE_MIN_CAPACITY;
+        events = (DB_TRACE_EVENT*)internal_malloc(sizeof(*events) * capacity);
+        if (events == NULL) {
+            db_trace.dropped_events++;
+            return;
+        }
+
+        if (db_trace.events != NULL) {
+            memcpy(events, db_trace.events, sizeof(*events) * db_trace.events_length);
+            internal_free(db_trace.events);
+        }
 
-    if (current_database->files_length >= DB_DATABASE_FILE_LIST_CAPACITY) {
-        return -1;
+        db_trace.events = events;
+        db_trace.events_capacity = capacity;
     }
 
-    for (index = 0; index < DB_DATABASE_FILE_LIST_CAPACITY; index++) {
-        if (current_database->files[index].field_8 == 0) {
-            *position_ptr = index;
-            return 0;
+    event = &(db_trace.events[db_trace.events_length]);
+    event->record = record;
+    event->label = NULL;
+    event->start = start;
+    event->end = end;
+    event->bytes = bytes;
+
+    if (label != NULL) {
+        event->label = internal_strdup(label);
+        if (event->label == NULL) {
+            db_trace.dropped_events++;
+            return;
         }
     }
 
-    return -1;
+    db_trace.events_length++;
 }
 
-// 0x4B2714
-static int db_find_dir_entry(char* path, dir_entry* de)
+static double db_trace_ticks_to_ms(Uint64 ticks)
 {
-    char* normalized_path;
-    int pos;
-    int dir_index;
-    int entry_index;
+    return (double)ticks * 1000.0 / (double)SDL_GetPerformanceFrequency();
+}
 
-    normalized_path = path;
+static const char* db_trace_source_name(int source)
+{
+    return source == DB_TRACE_SOURCE_PATCHES ? "patches" : "datafile";
+}
 
-    if (current_database->datafile == NULL) {
+// 0x4B2970
+static int fread_short(FILE* stream, unsigned short* s)
+{
+    int high;
+    int low;
+
+    high = fgetc(stream);
+    if (high == -1) {
         return -1;
     }
 
-    if (path == NULL) {
+    low = fgetc(stream);
+    if (low == -1) {
         return -1;
     }
 
-    if (de == NULL) {
-        return -1;
+    *s = (low & 0xFF) | (high << 8);
+
+    return 0;
+}
+
+// CE: Converts big-endian 16-bit values to host order (and vice versa) in
+// place.
+static void db_swap_16(unsigned short* values, int count)
+{
+    int index = 0;
+
+#if defined(DB_SWAP_SSE2)
+    for (; index + 8 <= count; index += 8) {
+        __m128i v = _mm_loadu_si128((__m128i*)(values + index));
+        v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+        _mm_storeu_si128((__m128i*)(values + index), v);
+    }
+#elif defined(DB_SWAP_NEON)
+    for (; index + 8 <= count; index += 8) {
+        uint8x16_t v = vld1q_u8((uint8_t*)(values + index));
+        vst1q_u8((uint8_t*)(values + index), vrev16q_u8(v));
     }
+#endif
 
-    if (path[0] == '.') {
-        normalized_path = path + 1;
-        if (path[1] == '\\') {
-            normalized_path = path + 2;
-        }
+    for (; index < count; index++) {
+        values[index] = (unsigned short)((values[index] << 8) | (values[index] >> 8));
     }
+}
 
-    pos = strlen(normalized_path) - 1;
-    while (pos >= 0) {
-        if (normalized_path[pos] == '\\') {
-            break;
-        }
-        pos--;
+// CE: Converts big-endian 32-bit values to host order (and vice versa) in
+// place.
+static void db_swap_32(unsigned int* values, int count)
+{
+    int index = 0;
+
+#if defined(DB_SWAP_SSE2)
+    for (; index + 4 <= count; index += 4) {
+        __m128i v = _mm_loadu_si128((__m128i*)(values + index));
+        // Swap 16-bit halves of every value, then bytes of every half.
+        v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+        v = _mm_shufflehi_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+        v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+        _mm_storeu_si128((__m128i*)(values + index), v);
+    }
+#elif defined(DB_SWAP_NEON)
+    for (; index + 4 <= count; index += 4) {
+        uint8x16_t v = vld1q_u8((uint8_t*)(values + index));
+        vst1q_u8((uint8_t*)(values + index), vrev32q_u8(v));
     }
+#endif
 
-    if (pos >= 0) {
-        normalized_path[pos] = '\0';
-        dir_index = assoc_search(&(current_database->root), normalized_path);
-    } else {
-        dir_index = 0;
+    for (; index < count; index++) {
+        unsigned int value = values[index];
+        values[index] = (value << 24) | ((value & 0xFF00) << 8) | ((value >> 8) & 0xFF00) | (value >> 24);
     }
+}
 
-    if (dir_index == -1) {
-        if (pos >= 0) {
-            normalized_path[pos] = '\\';
-        }
-        return -1;
+// CE: Reads `count` big-endian values of `size` bytes with a single `db_fread`
+// and converts them to host order.
+static int db_fread_swapped(DB_FILE* stream, void* ptr, size_t size, int count)
+{
+    if (count <= 0) {
+        return 0;
     }
 
-    entry_index = assoc_search(&(current_database->entries[dir_index]), normalized_path + pos + 1);
-    if (entry_index == -1) {
-        if (pos >= 0) {
-            normalized_path[pos] = '\\';
-        }
+    if (db_fread(ptr, size, count, stream) != (size_t)count) {
         return -1;
     }
 
-    if (pos >= 0) {
-        normalized_path[pos] = '\\';
+    switch (size) {
+    case 2:
+        db_swap_16((unsigned short*)ptr, count);
+        break;
+    case 4:
+        db_swap_32((unsigned int*)ptr, count);
+        break;
     }
 
-    *de = *((dir_entry*)current_database->entries[dir_index].list[entry_index].data);
-
     return 0;
 }
 
-// 0x4B2810
-static int db_findfirst(const char* path, DB_FIND_DATA* findData)
+// CE: Writes `count` host order values of `size` bytes as big-endian. Values
+// are swapped in chunks on the stack, so `ptr` is left intact.
+static int db_fwrite_swapped(DB_FILE* stream, const void* ptr, size_t size, int count)
 {
-#if defined(_WIN32)
-    findData->hFind = FindFirstFileA(path, &(findData->ffd));
-    if (findData->hFind == INVALID_HANDLE_VALUE) {
-        return -1;
-    }
-#else
-    strcpy(findData->path, path);
-
-    char drive[COMPAT_MAX_DRIVE];
-    char dir[COMPAT_MAX_DIR];
-    compat_splitpath(path, drive, dir, NULL, NULL);
+    unsigned int buffer[DB_SWAP_CHUNK_SIZE];
+    const unsigned char* curr;
+    int chunk_size;
+    int max_chunk_size;
 
-    char basePath[COMPAT_MAX_PATH];
-    compat_makepath(basePath, drive, dir, NULL, NULL);
+    if (count <= 0) {
+        return 0;
+    }
 
-    compat_resolve_path(basePath);
-    findData->dir = opendir(basePath);
-    if (findData->dir == NULL) {
-        return -1;
+    if (size == 1) {
+        if (db_fwrite(ptr, size, count, stream) != (size_t)count) {
+            return -1;
+        }
+        return 0;
     }
 
-    findData->entry = readdir(findData->dir);
-    while (findData->entry != NULL) {
-        char entryPath[COMPAT_MAX_PATH];
-        compat_makepath(entryPath, drive, dir, fileFindGetName(findData), NULL);
-        if (fpattern_match(findData->path, entryPath)) {
+    curr = (const unsigned char*)ptr;
+    max_chunk_size = (int)(sizeof(buffer) / size);
+    while (count > 0) {
+        chunk_size = count < max_chunk_size ? count : max_chunk_size;
+        memcpy(buffer, curr, size * chunk_size);
+
+        switch (size) {
+        case 2:
+            db_swap_16((unsigned short*)buffer, chunk_size);
+            break;
+        case 4:
+            db_swap_32(buffer, chunk_size);
             break;
         }
-        findData->entry = readdir(findData->dir);
-    }
 
-    if (findData->entry == NULL) {
-        closedir(findData->dir);
-        findData->dir = NULL;
-        return -1;
+        if (db_fwrite(buffer, size, chunk_size, stream) != (size_t)chunk_size) {
+            return -1;
+        }
+
+        curr += size * chunk_size;
+        count -= chunk_size;
     }
-#endif
 
     return 0;
 }
 
-// 0x4B2838
-static int db_findnext(DB_FIND_DATA* findData)
+// CE: Makes room for [size] more bytes of buffered output. Buffer grows
+// until it reaches `DB_WRITE_BUFFER_MAX_CAPACITY`, past that the output is
+// flushed to file.
+static bool db_write_buffer_reserve(DB_FILE* stream, size_t size)
 {
-#if defined(_WIN32)
-    if (!FindNextFileA(findData->hFind, &(findData->ffd))) {
-        return -1;
+    size_t capacity;
+    unsigned char* buffer;
+
+    if (stream->write_length + size <= stream->write_capacity) {
+        return true;
     }
-#else
-    char drive[COMPAT_MAX_DRIVE];
-    char dir[COMPAT_MAX_DIR];
-    compat_splitpath(findData->path, drive, dir, NULL, NULL);
 
-    findData->entry = readdir(findData->dir);
-    while (findData->entry != NULL) {
-        char entryPath[COMPAT_MAX_PATH];
-        compat_makepath(entryPath, drive, dir, fileFindGetName(findData), NULL);
-        if (fpattern_match(findData->path, entryPath)) {
-            break;
+    if (stream->write_length + size > DB_WRITE_BUFFER_MAX_CAPACITY && stream->write_length != 0 && (stream->flags & DB_FILE_MEMORY) == 0) {
+        if (db_write_buffer_flush(stream) != 0) {
+            return false;
         }
-        findData->entry = readdir(findData->dir);
-    }
 
-    if (findData->entry == NULL) {
-        closedir(findData->dir);
-        findData->dir = NULL;
-        return -1;
+        if (size <= stream->write_capacity) {
+            return true;
+        }
     }
-#endif
 
-    return 0;
-}
+    capacity = stream->write_capacity != 0 ? stream->write_capacity : DB_WRITE_BUFFER_INITIAL_CAPACITY;
+    while (capacity < stream->write_length + size) {
+        capacity *= 2;
+    }
 
-// 0x4B2854
-static int db_findclose(DB_FIND_DATA* findData)
-{
-#if defined(_WIN32)
-    if (!FindClose(findData->hFind)) {
-        return -1;
+    buffer = (unsigned char*)internal_malloc(capacity);
+    if (buffer == NULL) {
+        return false;
     }
-#else
-    if (findData->dir != NULL) {
-        if (closedir(findData->dir) != 0) {
-            return -1;
-        }
+
+    if (stream->write_buffer != NULL) {
+        memcpy(buffer, stream->write_buffer, stream->write_length);
+        internal_free(stream->write_buffer);
     }
-#endif
 
-    return 0;
-}
+    stream->write_buffer = buffer;
+    stream->write_capacity = capacity;
 
-// 0x4B2868
-static void* internal_malloc(size_t size)
-{
-    db_used_malloc = true;
-    return db_malloc(size);
+    return true;
 }
 
-// 0x4B287C
-static char* internal_strdup(const char* string)
+// CE: Writes buffered output to file with a single `fwrite`.
+static int db_write_buffer_flush(DB_FILE* stream)
 {
-    db_used_malloc = true;
-    return db_strdup(string);
-}
+    size_t length;
 
-// 0x4B2890
-static void internal_free(void* ptr)
-{
-    db_free(ptr);
-}
+    if (stream->write_length == 0 || (stream->flags & DB_FILE_MEMORY) != 0) {
+        return 0;
+    }
 
-// 0x4B2898
-static void* db_default_malloc(size_t size)
-{
-    return malloc(size);
-}
+    length = stream->write_length;
+    stream->write_length = 0;
 
-// 0x4B28A0
-static char* db_default_strdup(const char* string)
-{
-    return compat_strdup(string);
-}
+    if (fwrite(stream->write_buffer, 1, length, stream->uncompressed_file_stream) != length) {
+        return -1;
+    }
 
-// 0x4B28A8
-static void db_default_free(void* ptr)
-{
-    free(ptr);
+    return 0;
 }
 
-// 0x4B28B0
-static void db_preload_buffer(DB_FILE* stream)
+static inline bool db_write_buffer_put(DB_FILE* stream, const void* data, size_t size)
 {
-    unsigned short v1;
+    if (stream->write_length + size > stream->write_capacity && !db_write_buffer_reserve(stream, size)) {
+        return false;
+    }
 
-    if ((stream->flags & 0x8) != 0 && (stream->flags & 0xF0) == 64) {
-        if (stream->field_10 != 0) {
-            if (stream->field_20 >= stream->field_1C + 0x4000) {
-                if (fseek(stream->database->stream, stream->field_18, SEEK_SET) == 0) {
-                    if (fread_short(stream->database->stream, &v1) == 0) {
-                        if ((v1 & 0x8000) != 0) {
-                            v1 &= ~0x8000;
-                            fread(stream->field_1C, 1, v1, stream->database->stream);
-                        } else {
-                            lzss_decode_to_buf(stream->database->stream, stream->field_1C, v1);
-                        }
+    memcpy(stream->write_buffer + stream->write_length, data, size);
+    stream->write_length += size;
 
-                        stream->field_20 = stream->field_1C;
-                        stream->field_18 = ftell(stream->database->stream);
-                    }
-                }
-            }
-        }
-    }
+    return true;
 }
 
-// 0x4B2970
-static int fread_short(FILE* stream, unsigned short* s)
+static inline bool db_write_buffer_put_16(DB_FILE* stream, unsigned short value)
 {
-    int high;
-    int low;
+    unsigned char* dest;
 
-    high = fgetc(stream);
-    if (high == -1) {
-        return -1;
+    if (stream->write_length + 2 > stream->write_capacity && !db_write_buffer_reserve(stream, 2)) {
+        return false;
     }
 
-    low = fgetc(stream);
-    if (low == -1) {
-        return -1;
+    dest = stream->write_buffer + stream->write_length;
+    dest[0] = (unsigned char)(value >> 8);
+    dest[1] = (unsigned char)(value & 0xFF);
+    stream->write_length += 2;
+
+    return true;
+}
+
+static inline bool db_write_buffer_put_32(DB_FILE* stream, unsigned int value)
+{
+    unsigned char* dest;
+
+    if (stream->write_length + 4 > stream->write_capacity && !db_write_buffer_reserve(stream, 4)) {
+        return false;
     }
 
-    *s = (low & 0xFF) | (high << 8);
+    dest = stream->write_buffer + stream->write_length;
+    dest[0] = (unsigned char)(value >> 24);
+    dest[1] = (unsigned char)((value >> 16) & 0xFF);
+    dest[2] = (unsigned char)((value >> 8) & 0xFF);
+    dest[3] = (unsigned char)(value & 0xFF);
+    stream->write_length += 4;
 
-    return 0;
+    return true;
 }
 
 static inline bool fileFindIsDirectory(DB_FIND_DATA* findData)
@@ -2825,6 +7204,11 @@ int db_freadInt32(DB_FILE* stream, int* valuePtr)
 
 int db_freadUInt8List(DB_FILE* stream, unsigned char* arr, int count)
 {
+    // CE: Binary streams are read in one go.
+    if (stream != NULL && (stream->flags & 0x2) == 0) {
+        return db_fread_swapped(stream, arr, sizeof(*arr), count);
+    }
+
     for (int index = 0; index < count; index++) {
         if (db_freadUInt8(stream, &(arr[index])) == -1) {
             return -1;
@@ -2836,6 +7220,11 @@ int db_freadUInt8List(DB_FILE* stream, unsigned char* arr, int count)
 
 int db_freadInt8List(DB_FILE* stream, char* arr, int count)
 {
+    // CE: Binary streams are read in one go.
+    if (stream != NULL && (stream->flags & 0x2) == 0) {
+        return db_fread_swapped(stream, arr, sizeof(*arr), count);
+    }
+
     for (int index = 0; index < count; index++) {
         if (db_freadInt8(stream, &(arr[index])) == -1) {
             return -1;
@@ -2847,6 +7236,11 @@ int db_freadInt8List(DB_FILE* stream, char* arr, int count)
 
 int db_freadInt16List(DB_FILE* stream, short* arr, int count)
 {
+    // CE: Binary streams are read in one go and swapped in place.
+    if (stream != NULL && (stream->flags & 0x2) == 0) {
+        return db_fread_swapped(stream, arr, sizeof(*arr), count);
+    }
+
     for (int index = 0; index < count; index++) {
         if (db_freadInt16(stream, &(arr[index])) == -1) {
             return -1;
@@ -2858,6 +7252,11 @@ int db_freadInt16List(DB_FILE* stream, short* arr, int count)
 
 int db_freadInt32List(DB_FILE* stream, int* arr, int count)
 {
+    // CE: Binary streams are read in one go and swapped in place.
+    if (stream != NULL && (stream->flags & 0x2) == 0) {
+        return db_fread_swapped(stream, arr, sizeof(*arr), count);
+    }
+
     for (int index = 0; index < count; index++) {
         if (db_freadInt32(stream, &(arr[index])) == -1) {
             return -1;
@@ -2911,6 +7310,11 @@ int db_fwriteInt32(DB_FILE* stream, int value)
 
 int db_fwriteUInt8List(DB_FILE* stream, unsigned char* arr, int count)
 {
+    // CE: Write swapped copy in large chunks.
+    if (stream != NULL) {
+        return db_fwrite_swapped(stream, arr, sizeof(*arr), count);
+    }
+
     for (int index = 0; index < count; index++) {
         if (db_fwriteUInt8(stream, arr[index]) == -1) {
             return -1;
@@ -2922,6 +7326,11 @@ int db_fwriteUInt8List(DB_FILE* stream, unsigned char* arr, int count)
 
 int db_fwriteInt8List(DB_FILE* stream, char* arr, int count)
 {
+    // CE: Write swapped copy in large chunks.
+    if (stream != NULL) {
+        return db_fwrite_swapped(stream, arr, sizeof(*arr), count);
+    }
+
     for (int index = 0; index < count; index++) {
         if (db_fwriteInt8(stream, arr[index]) == -1) {
             return -1;
@@ -2933,6 +7342,11 @@ int db_fwriteInt8List(DB_FILE* stream, char* arr, int count)
 
 int db_fwriteInt16List(DB_FILE* stream, short* arr, int count)
 {
+    // CE: Write swapped copy in large chunks.
+    if (stream != NULL) {
+        return db_fwrite_swapped(stream, arr, sizeof(*arr), count);
+    }
+
     for (int index = 0; index < count; index++) {
         if (db_fwriteInt16(stream, arr[index]) == -1) {
             return -1;
@@ -2944,6 +7358,11 @@ int db_fwriteInt16List(DB_FILE* stream, short* arr, int count)
 
 int db_fwriteInt32List(DB_FILE* stream, int* arr, int count)
 {
+    // CE: Write swapped copy in large chunks.
+    if (stream != NULL) {
+        return db_fwrite_swapped(stream, arr, sizeof(*arr), count);
+    }
+
     for (int index = 0; index < count; index++) {
         if (db_fwriteInt32(stream, arr[index]) == -1) {
             return -1;
@@ -17,10 +17,44 @@ typedef struct dir_entry_s {
     int field_C;
 } dir_entry;
 
+typedef struct db_cache_stats {
+    size_t capacity;
+    size_t size;
+    int entries;
+    unsigned int hits;
+    unsigned int misses;
+    unsigned int evictions;
+} db_cache_stats;
+
+#define DB_TRACE_SOURCE_PATCHES 0
+#define DB_TRACE_SOURCE_DATAFILE 1
+
+typedef struct db_trace_file_stats {
+    const char* name;
+    int source;
+    unsigned int opens;
+    unsigned int reads;
+    unsigned int seeks;
+    unsigned int cache_hits;
+    size_t bytes_read;
+    size_t bytes_decompressed;
+
+    // Time spent decompressing (in milliseconds).
+    double decode_time;
+} db_trace_file_stats;
+
+// CE: Member of container written by `db_pack_write`.
+typedef struct db_pack_member {
+    const char* name;
+    const unsigned char* data;
+    size_t size;
+} db_pack_member;
+
 typedef void db_read_callback();
 typedef void*(db_malloc_func)(size_t size);
 typedef char*(db_strdup_func)(const char* string);
 typedef void(db_free_func)(void* ptr);
+typedef void(db_read_async_callback)(void* user_data, unsigned char* data, size_t size);
 
 DB_DATABASE* db_init(const char* datafile, const char* datafile_path, const char* patches_path, int show_cursor);
 int db_select(DB_DATABASE* db_handle);
@@ -66,10 +100,39 @@ int db_fprintf(DB_FILE* stream, const char* format, ...);
 int db_feof(DB_FILE* stream);
 int db_get_file_list(const char* filespec, char*** filelist, char*** desclist, int desclen);
 void db_free_file_list(char*** file_list, char*** desclist);
+void db_file_list_invalidate();
 long db_filelength(DB_FILE* stream);
 void db_register_mem(db_malloc_func* malloc_func, db_strdup_func* strdup_func, db_free_func* free_func);
 void db_register_callback(db_read_callback* callback, size_t threshold);
 void db_enable_hash_table();
+void db_enable_mmap();
+void db_enable_index();
+void db_cache_set_size(size_t size);
+void db_cache_flush();
+void db_cache_get_stats(db_cache_stats* stats);
+int db_image_save(const char* path, const char* build_id);
+int db_image_load(const char* path, const char* build_id);
+int db_prefetch(const char** paths, int count);
+int db_prefetch_group(const char** paths, int count, int group, size_t* budget);
+int db_prefetch_cancel_group(int group);
+void db_prefetch_quiesce();
+int db_reopen_datafiles();
+int db_read_async(const char* path, db_read_async_callback* callback, void* user_data);
+DB_FILE* db_fopen_memory(const unsigned char* data, size_t size);
+DB_FILE* db_fopen_memory_write();
+unsigned char* db_fclose_memory(DB_FILE* stream, size_t* size_ptr);
+void db_free_memory(void* ptr);
+int db_pack_write(const char* path, const db_pack_member* members, int count);
+DB_FILE* db_fopen_pack(const char* pack_path, const char* name);
+void db_trace_enable(bool enable);
+bool db_trace_is_enabled();
+void db_trace_reset();
+void db_trace_mark(const char* label);
+int db_trace_get_file_count();
+int db_trace_get_file_stats(int index, db_trace_file_stats* stats);
+void db_trace_get_totals(db_trace_file_stats* stats);
+int db_trace_dump_csv(const char* path);
+int db_trace_dump_chrome(const char* path);
 int db_reset_hash_tables();
 int db_add_hash_entry(const char* path, int sep);
 
@@ -14,6 +14,18 @@ namespace fallout {
 static inline void lzss_fill_decode_buffer(FILE* stream);
 static inline void lzss_decode_chunk_to_buf(unsigned int type, unsigned char** dest, unsigned int* length);
 static inline void lzss_decode_chunk_to_file(unsigned int type, FILE* stream, unsigned int* length);
+static inline unsigned int lzss_hash(const unsigned char* src);
+
+#define LZSS_RING_SIZE 4096
+#define LZSS_RING_START 4078
+#define LZSS_MIN_MATCH 3
+#define LZSS_MAX_MATCH 18
+#define LZSS_HASH_SIZE 4096
+#define LZSS_MAX_CHAIN 64
+
+// The maximum distance of a back reference. Matches further away can be
+// overwritten in the ring buffer by the decoder while being copied.
+#define LZSS_MAX_DISTANCE (LZSS_RING_SIZE - LZSS_MAX_MATCH)
 
 // 0x6B0860
 static unsigned char decode_buffer[1024];
@@ -215,6 +227,203 @@ void lzss_decode_to_file(FILE* in, FILE* out, unsigned int length)
     } while (0);
 }
 
+// CE: Decodes `length` bytes of in-memory `src` straight into `dest` (which is
+// `size` bytes long) without going through ring buffer - back references are
+// resolved against already decoded output. Literal runs and non-overlapping
+// matches are copied with `memcpy`, only overlapping matches (and matches
+// reaching initial content of the ring buffer) are copied byte by byte.
+// Returns the number of decoded bytes, or -1 if output does not fit into
+// `dest`.
+int lzss_decode_mem_to_buf(const unsigned char* src, unsigned int length, unsigned char* dest, unsigned int size)
+{
+    const unsigned char* in;
+    const unsigned char* in_end;
+    unsigned char* out;
+    unsigned char* out_end;
+    unsigned char* match;
+    unsigned int flags;
+    unsigned int bit;
+    unsigned int run;
+    unsigned int dict_offset;
+    unsigned int distance;
+    unsigned int chunk_length;
+    unsigned int pos;
+    unsigned int index;
+
+    in = src;
+    in_end = src + length;
+    out = dest;
+    out_end = dest + size;
+
+    while (in < in_end) {
+        flags = *in++;
+
+        // Eight literals in a row.
+        if (flags == 0xFF && in_end - in >= 8 && out_end - out >= 8) {
+            memcpy(out, in, 8);
+            in += 8;
+            out += 8;
+            continue;
+        }
+
+        bit = 0;
+        while (bit < 8 && in < in_end) {
+            if ((flags & (1 << bit)) != 0) {
+                run = 1;
+                while (bit + run < 8 && (flags & (1 << (bit + run))) != 0) {
+                    run++;
+                }
+
+                if (run > (unsigned int)(in_end - in)) {
+                    run = (unsigned int)(in_end - in);
+                }
+
+                if (run > (unsigned int)(out_end - out)) {
+                    return -1;
+                }
+
+                memcpy(out, in, run);
+                in += run;
+                out += run;
+                bit += run;
+            } else {
+                if (in_end - in < 2) {
+                    // Truncated reference (malformed input).
+                    in = in_end;
+                    break;
+                }
+
+                dict_offset = in[0] | ((in[1] & 0xF0) << 4);
+                chunk_length = (in[1] & 0x0F) + LZSS_MIN_MATCH;
+                in += 2;
+                bit += 1;
+
+                if (chunk_length > (unsigned int)(out_end - out)) {
+                    return -1;
+                }
+
+                pos = (unsigned int)(out - dest);
+
+                // Ring buffer position of the next output byte is
+                // `(LZSS_RING_START + pos) % LZSS_RING_SIZE`, so the match
+                // starts `distance` bytes back (zero means entire ring).
+                distance = (LZSS_RING_START + pos - dict_offset) & (LZSS_RING_SIZE - 1);
+                if (distance == 0) {
+                    distance = LZSS_RING_SIZE;
+                }
+
+                if (distance > pos) {
+                    // Initial content of ring buffer is spaces.
+                    for (index = 0; index < chunk_length; index++) {
+                        out[index] = pos + index >= distance ? dest[pos + index - distance] : ' ';
+                    }
+                } else if (distance >= chunk_length) {
+                    memcpy(out, out - distance, chunk_length);
+                } else {
+                    match = out - distance;
+                    for (index = 0; index < chunk_length; index++) {
+                        out[index] = match[index];
+                    }
+                }
+
+                out += chunk_length;
+            }
+        }
+    }
+
+    return (int)(out - dest);
+}
+
+// CE: Encodes `length` bytes of `src` into format understood by decoders above.
+// Only references to already encoded data are produced (i.e. initial content
+// of the ring buffer is never used). Returns number of bytes written to
+// `dest`, which should be at least `LZSS_ENCODE_BOUND(length)` bytes.
+unsigned int lzss_encode_to_buf(const unsigned char* src, unsigned int length, unsigned char* dest)
+{
+    int head[LZSS_HASH_SIZE];
+    int prev[LZSS_RING_SIZE];
+    unsigned char* curr;
+    unsigned char* flags;
+    unsigned int pos;
+    unsigned int inserted;
+    int bit;
+
+    for (int index = 0; index < LZSS_HASH_SIZE; index++) {
+        head[index] = -1;
+    }
+
+    curr = dest;
+    pos = 0;
+    inserted = 0;
+
+    while (pos < length) {
+        flags = curr++;
+        *flags = 0;
+
+        for (bit = 0; bit < 8 && pos < length; bit++) {
+            unsigned int max_length = length - pos;
+            if (max_length > LZSS_MAX_MATCH) {
+                max_length = LZSS_MAX_MATCH;
+            }
+
+            unsigned int best_length = 0;
+            unsigned int best_pos = 0;
+
+            if (max_length >= LZSS_MIN_MATCH) {
+                int candidate = head[lzss_hash(src + pos)];
+                int chain = 0;
+                while (candidate != -1 && pos - candidate <= LZSS_MAX_DISTANCE && chain < LZSS_MAX_CHAIN) {
+                    unsigned int match_length = 0;
+                    while (match_length < max_length && src[candidate + match_length] == src[pos + match_length]) {
+                        match_length++;
+                    }
+
+                    if (match_length > best_length) {
+                        best_length = match_length;
+                        best_pos = candidate;
+                        if (match_length == max_length) {
+                            break;
+                        }
+                    }
+
+                    int next = prev[candidate & (LZSS_RING_SIZE - 1)];
+                    if (next >= candidate) {
+                        break;
+                    }
+
+                    candidate = next;
+                    chain++;
+                }
+            }
+
+            if (best_length >= LZSS_MIN_MATCH) {
+                unsigned int dict_offset = (LZSS_RING_START + best_pos) & (LZSS_RING_SIZE - 1);
+                *curr++ = dict_offset & 0xFF;
+                *curr++ = ((dict_offset >> 4) & 0xF0) | (best_length - LZSS_MIN_MATCH);
+                pos += best_length;
+            } else {
+                *flags |= 1 << bit;
+                *curr++ = src[pos];
+                pos += 1;
+            }
+
+            while (inserted < pos && inserted + LZSS_MIN_MATCH <= length) {
+                unsigned int hash = lzss_hash(src + inserted);
+                prev[inserted & (LZSS_RING_SIZE - 1)] = head[hash];
+                head[hash] = inserted;
+                inserted++;
+            }
+        }
+    }
+
+    return curr - dest;
+}
+
+static inline unsigned int lzss_hash(const unsigned char* src)
+{
+    return ((src[0] << 8) ^ (src[1] << 4) ^ src[2]) & (LZSS_HASH_SIZE - 1);
+}
+
 static inline void lzss_fill_decode_buffer(FILE* stream)
 {
     size_t bytes_to_read;
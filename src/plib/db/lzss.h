@@ -7,6 +7,11 @@ namespace fallout {
 
 int lzss_decode_to_buf(FILE* in, unsigned char* dest, unsigned int length);
 void lzss_decode_to_file(FILE* in, FILE* out, unsigned int length);
+int lzss_decode_mem_to_buf(const unsigned char* src, unsigned int length, unsigned char* dest, unsigned int size);
+unsigned int lzss_encode_to_buf(const unsigned char* src, unsigned int length, unsigned char* dest);
+
+// The maximum size of `lzss_encode_to_buf` output for `length` input bytes.
+#define LZSS_ENCODE_BOUND(length) ((length) + ((length) + 7) / 8)
 
 } // namespace fallout
 
@@ -1,5 +1,7 @@
 #include "plib/gnw/button.h"
 
+#include <string.h>
+
 #include "plib/color/color.h"
 #include "plib/gnw/gnw.h"
 #include "plib/gnw/grbuf.h"
@@ -13,6 +15,26 @@ namespace fallout {
 // The maximum number of button groups.
 #define BUTTON_GROUP_LIST_CAPACITY 64
 
+// CE: Size of button index cells in pixels.
+#define BUTTON_INDEX_CELL_SIZE 32
+
+// CE: Windows with fewer buttons are not indexed, walking the list is just
+// as fast.
+#define BUTTON_INDEX_MIN_BUTTONS 16
+
+// CE: Buttons of a window bucketed by cells of `BUTTON_INDEX_CELL_SIZE`
+// pixels. Every cell lists buttons whose rects overlap it, in button list
+// order. Button rects are relative to window and never change, so index only
+// needs to be rebuilt when buttons are added or removed.
+typedef struct ButtonIndex {
+    int columns;
+    int rows;
+    // Buttons of cell `n` are `buttons[cellStart[n]]` to
+    // `buttons[cellStart[n + 1] - 1]`.
+    int* cellStart;
+    Button** buttons;
+} ButtonIndex;
+
 // 0x53A258
 static int last_button_winID = -1;
 
@@ -23,6 +45,8 @@ static Button* button_create(int win, int x, int y, int width, int height, int m
 static bool button_under_mouse(Button* button, Rect* rect);
 static int button_check_group(Button* button);
 static void button_draw(Button* button, Window* window, unsigned char* data, bool draw, Rect* bound, bool sound);
+static ButtonIndex* button_index_build(Window* w);
+static Button* button_index_find(Window* w);
 
 // 0x4C4320
 int win_register_button(int win, int x, int y, int width, int height, int mouseEnterEventCode, int mouseExitEventCode, int mouseDownEventCode, int mouseUpEventCode, unsigned char* up, unsigned char* dn, unsigned char* hover, int flags)
@@ -350,6 +374,8 @@ static Button* button_create(int win, int x, int y, int width, int height, int m
     }
     w->buttonListHead = button;
 
+    GNW_button_index_invalidate(w);
+
     return button;
 }
 
@@ -499,6 +525,12 @@ int GNW_check_buttons(Window* w, int* keyCodePtr)
 
         ButtonCallback* cb = NULL;
 
+        // CE: Find first button under mouse in index instead of testing
+        // every button of the window. Loop below accepts it right away.
+        if (button == w->buttonListHead) {
+            button = button_index_find(w);
+        }
+
         while (button != NULL) {
             if (!(button->flags & BUTTON_FLAG_DISABLED)) {
                 rectCopy(&v58, &(button->rect));
@@ -743,6 +775,175 @@ static bool button_under_mouse(Button* button, Rect* rect)
     return button->mask[width * y + x] != 0;
 }
 
+// CE: Returns first enabled button under mouse in list order (what the loop
+// in `GNW_check_buttons` would find walking from list head), or list head
+// when window has no index.
+static Button* button_index_find(Window* w)
+{
+    ButtonIndex* index = w->buttonIndex;
+    if (index == NULL) {
+        index = button_index_build(w);
+        if (index == NULL) {
+            return w->buttonListHead;
+        }
+    }
+
+    int x;
+    int y;
+    mouse_get_position(&x, &y);
+    x = (x - w->rect.ulx) / BUTTON_INDEX_CELL_SIZE;
+    y = (y - w->rect.uly) / BUTTON_INDEX_CELL_SIZE;
+    if (x < 0 || x >= index->columns || y < 0 || y >= index->rows) {
+        return NULL;
+    }
+
+    int cell = y * index->columns + x;
+    for (int pos = index->cellStart[cell]; pos < index->cellStart[cell + 1]; pos++) {
+        Button* button = index->buttons[pos];
+        if ((button->flags & BUTTON_FLAG_DISABLED) != 0) {
+            continue;
+        }
+
+        Rect rect;
+        rectCopy(&rect, &(button->rect));
+        rectOffset(&rect, w->rect.ulx, w->rect.uly);
+        if (button_under_mouse(button, &rect)) {
+            return button;
+        }
+    }
+
+    return NULL;
+}
+
+// CE: Builds index of window buttons. Returns NULL if window has too few
+// buttons or index cannot be allocated.
+static ButtonIndex* button_index_build(Window* w)
+{
+    int buttonsLength = 0;
+    for (Button* button = w->buttonListHead; button != NULL; button = button->next) {
+        buttonsLength++;
+    }
+
+    if (buttonsLength < BUTTON_INDEX_MIN_BUTTONS) {
+        return NULL;
+    }
+
+    int columns = (w->width + BUTTON_INDEX_CELL_SIZE - 1) / BUTTON_INDEX_CELL_SIZE;
+    int rows = (w->height + BUTTON_INDEX_CELL_SIZE - 1) / BUTTON_INDEX_CELL_SIZE;
+    if (columns <= 0 || rows <= 0) {
+        return NULL;
+    }
+
+    ButtonIndex* index = (ButtonIndex*)mem_malloc(sizeof(*index));
+    if (index == NULL) {
+        return NULL;
+    }
+
+    index->columns = columns;
+    index->rows = rows;
+    index->cellStart = (int*)mem_malloc(sizeof(*index->cellStart) * (columns * rows + 1));
+    index->buttons = NULL;
+    if (index->cellStart == NULL) {
+        w->buttonIndex = index;
+        GNW_button_index_invalidate(w);
+        return NULL;
+    }
+
+    memset(index->cellStart, 0, sizeof(*index->cellStart) * (columns * rows + 1));
+
+    // First pass counts buttons in every cell, second one stores them.
+    for (int pass = 0; pass < 2; pass++) {
+        if (pass == 1) {
+            int total = 0;
+            for (int cell = 0; cell <= columns * rows; cell++) {
+                int count = index->cellStart[cell];
+                index->cellStart[cell] = total;
+                total += count;
+            }
+
+            index->buttons = (Button**)mem_malloc(sizeof(*index->buttons) * (total > 0 ? total : 1));
+            if (index->buttons == NULL) {
+                w->buttonIndex = index;
+                GNW_button_index_invalidate(w);
+                return NULL;
+            }
+        }
+
+        for (Button* button = w->buttonListHead; button != NULL; button = button->next) {
+            int left = button->rect.ulx / BUTTON_INDEX_CELL_SIZE;
+            int top = button->rect.uly / BUTTON_INDEX_CELL_SIZE;
+            int right = button->rect.lrx / BUTTON_INDEX_CELL_SIZE;
+            int bottom = button->rect.lry / BUTTON_INDEX_CELL_SIZE;
+
+            // Parts outside of window are never under mouse.
+            if (button->rect.lrx < 0 || button->rect.lry < 0) {
+                continue;
+            }
+
+            if (left < 0) {
+                left = 0;
+            }
+
+            if (top < 0) {
+                top = 0;
+            }
+
+            if (right >= columns) {
+                right = columns - 1;
+            }
+
+            if (bottom >= rows) {
+                bottom = rows - 1;
+            }
+
+            for (int y = top; y <= bottom; y++) {
+                for (int x = left; x <= right; x++) {
+                    int cell = y * columns + x;
+                    if (pass == 0) {
+                        index->cellStart[cell]++;
+                    } else {
+                        // Start of cell is advanced while filling and
+                        // restored below.
+                        index->buttons[index->cellStart[cell]++] = button;
+                    }
+                }
+            }
+        }
+
+        if (pass == 1) {
+            for (int cell = columns * rows; cell > 0; cell--) {
+                index->cellStart[cell] = index->cellStart[cell - 1];
+            }
+            index->cellStart[0] = 0;
+        }
+    }
+
+    w->buttonIndex = index;
+
+    return index;
+}
+
+// CE: Drops button index of window, it is rebuilt on next use.
+void GNW_button_index_invalidate(Window* w)
+{
+    ButtonIndex* index = w->buttonIndex;
+    if (index == NULL) {
+        return;
+    }
+
+    if (index->cellStart != NULL) {
+        mem_free(index->cellStart);
+    }
+
+    if (index->buttons != NULL) {
+        mem_free(index->buttons);
+    }
+
+    mem_free(index);
+
+    w->buttonIndex = NULL;
+}
+
 // 0x4C5334
 int win_button_winID(int btn)
 {
@@ -787,6 +988,8 @@ int win_delete_button(int btn)
         button->next->prev = button->prev;
     }
 
+    GNW_button_index_invalidate(w);
+
     win_fill(w->id, button->rect.ulx, button->rect.uly, button->rect.lrx - button->rect.ulx + 1, button->rect.lry - button->rect.uly + 1, w->color);
 
     if (button == w->hoveredButton) {
@@ -27,6 +27,7 @@ int win_set_button_rest_state(int btn, bool checked, int flags);
 int win_group_check_buttons(int buttonCount, int* btns, int maxChecked, RadioButtonCallback* func);
 int win_group_radio_buttons(int buttonCount, int* btns);
 void GNW_button_refresh(Window* window, Rect* rect);
+void GNW_button_index_invalidate(Window* window);
 int win_button_press_and_release(int btn);
 
 } // namespace fallout
@@ -1,5 +1,7 @@
 #include "plib/gnw/dxinput.h"
 
+#include "plib/gnw/svga.h"
+
 namespace fallout {
 
 static bool dxinput_mouse_init();
@@ -10,6 +12,16 @@ static void dxinput_keyboard_exit();
 static int gMouseWheelDeltaX = 0;
 static int gMouseWheelDeltaY = 0;
 
+// CE: Without display SDL does not track mouse state, so it's accumulated
+// from (injected) mouse events.
+static int gHeadlessMouseDeltaX = 0;
+static int gHeadlessMouseDeltaY = 0;
+static Uint32 gHeadlessMouseButtons = 0;
+
+// CE: Buttons held down by injected events (see `inject.h`), combined with
+// device state.
+static Uint32 gInjectedMouseButtons = 0;
+
 // 0x4E0400
 bool dxinput_init()
 {
@@ -63,7 +75,20 @@ bool dxinput_get_mouse_state(MouseData* mouseState)
     // update mouse position manually.
     SDL_PumpEvents();
 
-    Uint32 buttons = SDL_GetRelativeMouseState(&(mouseState->x), &(mouseState->y));
+    Uint32 buttons;
+    if (svga_is_headless()) {
+        mouseState->x = gHeadlessMouseDeltaX;
+        mouseState->y = gHeadlessMouseDeltaY;
+        buttons = gHeadlessMouseButtons;
+
+        gHeadlessMouseDeltaX = 0;
+        gHeadlessMouseDeltaY = 0;
+    } else {
+        buttons = SDL_GetRelativeMouseState(&(mouseState->x), &(mouseState->y));
+    }
+
+    buttons |= gInjectedMouseButtons;
+
     mouseState->buttons[0] = (buttons & SDL_BUTTON(SDL_BUTTON_LEFT)) != 0;
     mouseState->buttons[1] = (buttons & SDL_BUTTON(SDL_BUTTON_RIGHT)) != 0;
     mouseState->wheelX = gMouseWheelDeltaX;
@@ -103,6 +128,10 @@ bool dxinput_read_keyboard_buffer(KeyboardData* keyboardData)
 // 0x4E070C
 bool dxinput_mouse_init()
 {
+    if (svga_is_headless()) {
+        return true;
+    }
+
     return SDL_SetRelativeMouseMode(SDL_TRUE) == 0;
 }
 
@@ -131,6 +160,40 @@ void handleMouseEvent(SDL_Event* event)
         gMouseWheelDeltaX += event->wheel.x;
         gMouseWheelDeltaY += event->wheel.y;
     }
+
+    if (svga_is_headless()) {
+        switch (event->type) {
+        case SDL_MOUSEMOTION:
+            gHeadlessMouseDeltaX += event->motion.xrel;
+            gHeadlessMouseDeltaY += event->motion.yrel;
+            break;
+        case SDL_MOUSEBUTTONDOWN:
+            gHeadlessMouseButtons |= SDL_BUTTON(event->button.button);
+            break;
+        case SDL_MOUSEBUTTONUP:
+            gHeadlessMouseButtons &= ~SDL_BUTTON(event->button.button);
+            break;
+        }
+    }
+}
+
+void dxinput_set_injected_mouse_buttons(bool left, bool right)
+{
+    gInjectedMouseButtons = 0;
+
+    if (left) {
+        gInjectedMouseButtons |= SDL_BUTTON(SDL_BUTTON_LEFT);
+    }
+
+    if (right) {
+        gInjectedMouseButtons |= SDL_BUTTON(SDL_BUTTON_RIGHT);
+    }
+}
+
+void dxinput_add_injected_mouse_wheel(int x, int y)
+{
+    gMouseWheelDeltaX += x;
+    gMouseWheelDeltaY += y;
 }
 
 } // namespace fallout
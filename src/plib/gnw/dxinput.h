@@ -29,6 +29,8 @@ bool dxinput_flush_keyboard_buffer();
 bool dxinput_read_keyboard_buffer(KeyboardData* keyboardData);
 
 void handleMouseEvent(SDL_Event* event);
+void dxinput_set_injected_mouse_buttons(bool left, bool right);
+void dxinput_add_injected_mouse_wheel(int x, int y);
 
 } // namespace fallout
 
@@ -0,0 +1,533 @@
+#include "plib/gnw/framecap.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define FRAMECAP_SSE2
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define FRAMECAP_NEON
+#endif
+
+#include <vector>
+
+#include "platform_compat.h"
+#include "plib/gnw/debug.h"
+#include "plib/gnw/svga.h"
+#include "plib/gnw/vclock.h"
+
+namespace fallout {
+
+static size_t framecap_segment_size(int format, int width, int height);
+static int framecap_bytes_per_pixel(int format);
+static void framecap_accumulate_row(unsigned short* accum, const unsigned char* src, int count);
+static void framecap_convert_row(unsigned char* dest, const unsigned char* src, int width);
+static void framecap_sum_pairs(unsigned short* accum, int pixels, int channels);
+static void framecap_pack_row(unsigned char* dest, const unsigned short* accum, int count, int shift);
+static void framecap_downsample_row(unsigned char* dest, unsigned short* accum, int width);
+static void framecap_capture(unsigned char* pixels, int width, int height, int pitch, const SDL_Color* palette);
+static int framecap_pick_slot(FrameCapHeader* header);
+
+// Segment shared by writer (game) and reader (controller) sides. Process is
+// either of them, never both.
+static char framecap_name[64];
+static size_t framecap_size = 0;
+static FrameCapHeader* framecap_header = NULL;
+static unsigned char* framecap_rw = NULL;
+static const unsigned char* framecap_ro = NULL;
+
+// Writer settings.
+static int framecap_format = FRAMECAP_FORMAT_INDEXED;
+static int framecap_downsample = 1;
+static unsigned int framecap_interval = 0;
+
+// Writer state.
+static bool framecap_writer = false;
+static unsigned int framecap_frame = 0;
+static unsigned int framecap_last_time = 0;
+static unsigned int framecap_last_submitted = 0;
+static bool framecap_captured_once = false;
+static FrameCapStats framecap_stats;
+
+// Palette converted to output format, rebuilt for every capture (palette
+// may change between any two frames).
+static unsigned char framecap_lut[256 * 4];
+
+// Scratch rows for downsampling: converted source row and column sums of
+// `framecap_downsample` converted rows.
+static std::vector<unsigned char> framecap_row;
+static std::vector<unsigned short> framecap_accum;
+
+// Reader state.
+static int framecap_reader_slot = -1;
+static int framecap_reader_seq = 0;
+
+static int framecap_bytes_per_pixel(int format)
+{
+    return format == FRAMECAP_FORMAT_RGBA ? 4 : 1;
+}
+
+static size_t framecap_segment_size(int format, int width, int height)
+{
+    size_t frameSize = (size_t)width * (size_t)height * (size_t)framecap_bytes_per_pixel(format);
+
+    // Keep every slot 64-byte aligned.
+    frameSize = (frameSize + 63) & ~(size_t)63;
+
+    return sizeof(FrameCapHeader) + frameSize * FRAMECAP_SLOT_COUNT;
+}
+
+// Adds `count` bytes of `src` to 16-bit column sums. Up to 16 rows of
+// 8-bit values fit in the sums.
+static void framecap_accumulate_row(unsigned short* accum, const unsigned char* src, int count)
+{
+    int index = 0;
+
+#if defined(FRAMECAP_SSE2)
+    __m128i zero = _mm_setzero_si128();
+    for (; index + 16 <= count; index += 16) {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + index));
+        __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(accum + index));
+        __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(accum + index + 8));
+        lo = _mm_add_epi16(lo, _mm_unpacklo_epi8(bytes, zero));
+        hi = _mm_add_epi16(hi, _mm_unpackhi_epi8(bytes, zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(accum + index), lo);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(accum + index + 8), hi);
+    }
+#elif defined(FRAMECAP_NEON)
+    for (; index + 16 <= count; index += 16) {
+        uint8x16_t bytes = vld1q_u8(src + index);
+        uint16x8_t lo = vld1q_u16(accum + index);
+        uint16x8_t hi = vld1q_u16(accum + index + 8);
+        vst1q_u16(accum + index, vaddw_u8(lo, vget_low_u8(bytes)));
+        vst1q_u16(accum + index + 8, vaddw_u8(hi, vget_high_u8(bytes)));
+    }
+#endif
+
+    for (; index < count; index++) {
+        accum[index] += src[index];
+    }
+}
+
+// Converts row of palette indices to output format using `framecap_lut`.
+static void framecap_convert_row(unsigned char* dest, const unsigned char* src, int width)
+{
+    switch (framecap_format) {
+    case FRAMECAP_FORMAT_RGBA:
+        for (int x = 0; x < width; x++) {
+            memcpy(dest + x * 4, framecap_lut + src[x] * 4, 4);
+        }
+        break;
+    case FRAMECAP_FORMAT_GRAY:
+        for (int x = 0; x < width; x++) {
+            dest[x] = framecap_lut[src[x]];
+        }
+        break;
+    default:
+        memcpy(dest, src, width);
+        break;
+    }
+}
+
+// Sums horizontally adjacent pairs of `pixels` pixels of `channels` column
+// sums, in place (sums of pair `i` end up in pixel `i`).
+static void framecap_sum_pairs(unsigned short* accum, int pixels, int channels)
+{
+    int pixel = 0;
+
+#if defined(FRAMECAP_SSE2)
+    if (channels == 4) {
+        for (; pixel + 4 <= pixels; pixel += 4) {
+            __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(accum + pixel * 4));
+            __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(accum + pixel * 4 + 8));
+            __m128i sum = _mm_add_epi16(_mm_unpacklo_epi64(a, b), _mm_unpackhi_epi64(a, b));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(accum + pixel * 2), sum);
+        }
+    } else {
+        // Sums are at most 16 * 255, so signed multiply-add and pack are
+        // exact.
+        __m128i ones = _mm_set1_epi16(1);
+        for (; pixel + 16 <= pixels; pixel += 16) {
+            __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(accum + pixel));
+            __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(accum + pixel + 8));
+            __m128i sum = _mm_packs_epi32(_mm_madd_epi16(a, ones), _mm_madd_epi16(b, ones));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(accum + pixel / 2), sum);
+        }
+    }
+#endif
+
+    for (; pixel + 2 <= pixels; pixel += 2) {
+        for (int channel = 0; channel < channels; channel++) {
+            accum[pixel / 2 * channels + channel] = accum[pixel * channels + channel] + accum[(pixel + 1) * channels + channel];
+        }
+    }
+}
+
+// Divides `count` block sums by block area (`1 << shift`, rounded to
+// nearest) into bytes.
+static void framecap_pack_row(unsigned char* dest, const unsigned short* accum, int count, int shift)
+{
+    int index = 0;
+    unsigned short half = (unsigned short)(1 << (shift - 1));
+
+#if defined(FRAMECAP_SSE2)
+    __m128i bias = _mm_set1_epi16((short)half);
+    __m128i bits = _mm_cvtsi32_si128(shift);
+    for (; index + 8 <= count; index += 8) {
+        __m128i sum = _mm_loadu_si128(reinterpret_cast<const __m128i*>(accum + index));
+        sum = _mm_srl_epi16(_mm_add_epi16(sum, bias), bits);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(dest + index), _mm_packus_epi16(sum, sum));
+    }
+#endif
+
+    for (; index < count; index++) {
+        dest[index] = (unsigned char)((accum[index] + half) >> shift);
+    }
+}
+
+// Averages `framecap_downsample` squared blocks of column sums into `width`
+// output pixels. Column sums are destroyed.
+static void framecap_downsample_row(unsigned char* dest, unsigned short* accum, int width)
+{
+    int channels = framecap_bytes_per_pixel(framecap_format);
+    int pixels = width * framecap_downsample;
+    int shift = 0;
+
+    for (int factor = framecap_downsample; factor > 1; factor /= 2) {
+        framecap_sum_pairs(accum, pixels, channels);
+        pixels /= 2;
+        shift += 2;
+    }
+
+    framecap_pack_row(dest, accum, pixels * channels, shift);
+}
+
+// Picks slot to write next frame to: neither the latest complete frame nor
+// the one reader holds.
+static int framecap_pick_slot(FrameCapHeader* header)
+{
+    int latest = SDL_AtomicGet(&(header->latest));
+    int reading = SDL_AtomicGet(&(header->reading));
+
+    for (int slot = 0; slot < FRAMECAP_SLOT_COUNT; slot++) {
+        if (slot != latest && slot != reading) {
+            return slot;
+        }
+    }
+
+    return 0;
+}
+
+// Receives every present from `svga`.
+static void framecap_capture(unsigned char* pixels, int width, int height, int pitch, const SDL_Color* palette)
+{
+    FrameCapHeader* header = framecap_header;
+    if (header == NULL) {
+        return;
+    }
+
+    // Presents are also reported when nothing changed, so a change held back
+    // by interval is still captured once the interval elapses.
+    unsigned int submitted;
+    renderGetDirtyRectStats(&submitted, NULL);
+
+    unsigned int now = vclock_now();
+    if (framecap_captured_once
+        && (submitted == framecap_last_submitted || now - framecap_last_time < framecap_interval)) {
+        framecap_stats.skipped++;
+        return;
+    }
+
+    Uint64 start = SDL_GetPerformanceCounter();
+
+    for (int index = 0; index < 256; index++) {
+        const SDL_Color* color = &(palette[index]);
+        if (framecap_format == FRAMECAP_FORMAT_GRAY) {
+            // BT.601 luma in 8-bit fixed point.
+            framecap_lut[index] = (unsigned char)((77 * color->r + 150 * color->g + 29 * color->b + 128) >> 8);
+        } else {
+            framecap_lut[index * 4] = color->r;
+            framecap_lut[index * 4 + 1] = color->g;
+            framecap_lut[index * 4 + 2] = color->b;
+            framecap_lut[index * 4 + 3] = 255;
+        }
+    }
+
+    int slot = framecap_pick_slot(header);
+    FrameCapSlot* frameSlot = &(header->slots[slot]);
+    unsigned char* dest = framecap_rw + frameSlot->offset;
+
+    SDL_AtomicAdd(&(frameSlot->seq), 1);
+
+    int factor = framecap_downsample;
+    int outputWidth = (int)header->width;
+    int outputHeight = (int)header->height;
+    int outputPitch = (int)header->pitch;
+
+    if (factor == 1) {
+        for (int y = 0; y < outputHeight; y++) {
+            framecap_convert_row(dest + y * outputPitch, pixels + y * pitch, outputWidth);
+        }
+    } else {
+        int bpp = framecap_bytes_per_pixel(framecap_format);
+        int rowSize = outputWidth * factor * bpp;
+
+        for (int y = 0; y < outputHeight; y++) {
+            memset(framecap_accum.data(), 0, sizeof(unsigned short) * rowSize);
+            for (int row = 0; row < factor; row++) {
+                framecap_convert_row(framecap_row.data(), pixels + (y * factor + row) * pitch, outputWidth * factor);
+                framecap_accumulate_row(framecap_accum.data(), framecap_row.data(), rowSize);
+            }
+            framecap_downsample_row(dest + y * outputPitch, framecap_accum.data(), outputWidth);
+        }
+    }
+
+    if (framecap_format == FRAMECAP_FORMAT_INDEXED) {
+        memcpy(frameSlot->palette, framecap_lut, sizeof(frameSlot->palette));
+    }
+
+    framecap_frame++;
+    frameSlot->frame = framecap_frame;
+    frameSlot->time = now;
+
+    // Atomic add is a full barrier, pixels are visible before slot is
+    // published.
+    SDL_AtomicAdd(&(frameSlot->seq), 1);
+    SDL_AtomicSet(&(header->latest), slot);
+
+    framecap_captured_once = true;
+    framecap_last_time = now;
+    framecap_last_submitted = submitted;
+
+    framecap_stats.captured++;
+    framecap_stats.micros += (SDL_GetPerformanceCounter() - start) * 1000000 / SDL_GetPerformanceFrequency();
+}
+
+// Starts exporting presented frames to shared memory segment `name`.
+// Frames are converted to `format`, downsampled by `downsample` (1, 2 or 4,
+// indexed frames cannot be downsampled) and captured at most once per
+// `interval` ms of game time, and only when screen changed. Must be called
+// after screen is initialized.
+bool framecap_start(const char* name, int format, int downsample, int interval)
+{
+    if (framecap_header != NULL || gSdlSurface == NULL) {
+        return false;
+    }
+
+    if (name == NULL
+        || format < 0 || format >= FRAMECAP_FORMAT_COUNT
+        || (downsample != 1 && downsample != 2 && downsample != 4)
+        || (format == FRAMECAP_FORMAT_INDEXED && downsample != 1)
+        || interval < 0) {
+        return false;
+    }
+
+    int width = gSdlSurface->w / downsample;
+    int height = gSdlSurface->h / downsample;
+    int bpp = framecap_bytes_per_pixel(format);
+    size_t size = framecap_segment_size(format, width, height);
+
+    bool created;
+    void* rw;
+    const void* ro;
+    if (!compat_shm_open(name, size, &created, &rw, &ro)) {
+        debug_printf("Frame capture: could not open %s\n", name);
+        return false;
+    }
+
+    // Segment may be left over from previous run or created by waiting
+    // reader, writer always lays it out anew.
+    FrameCapHeader* header = (FrameCapHeader*)rw;
+    header->format = (uint32_t)format;
+    header->width = (uint32_t)width;
+    header->height = (uint32_t)height;
+    header->pitch = (uint32_t)(width * bpp);
+    SDL_AtomicSet(&(header->latest), -1);
+    SDL_AtomicSet(&(header->reading), -1);
+
+    size_t frameSize = (size - sizeof(FrameCapHeader)) / FRAMECAP_SLOT_COUNT;
+    for (int slot = 0; slot < FRAMECAP_SLOT_COUNT; slot++) {
+        header->slots[slot].offset = (uint32_t)(sizeof(FrameCapHeader) + frameSize * slot);
+        header->slots[slot].frame = 0;
+        SDL_AtomicSet(&(header->slots[slot].seq), 0);
+    }
+
+    header->version = FRAMECAP_VERSION;
+    SDL_AtomicAdd(&(header->attached), 1);
+
+    // Magic goes last, readers ignore segment until it is set.
+    header->magic = FRAMECAP_MAGIC;
+
+    strncpy(framecap_name, name, sizeof(framecap_name) - 1);
+    framecap_name[sizeof(framecap_name) - 1] = '\0';
+    framecap_size = size;
+    framecap_header = header;
+    framecap_rw = (unsigned char*)rw;
+    framecap_ro = (const unsigned char*)ro;
+    framecap_writer = true;
+
+    framecap_format = format;
+    framecap_downsample = downsample;
+    framecap_interval = (unsigned int)interval;
+    framecap_frame = 0;
+    framecap_captured_once = false;
+    memset(&framecap_stats, 0, sizeof(framecap_stats));
+
+    if (downsample != 1) {
+        framecap_row.resize((size_t)width * downsample * bpp);
+        framecap_accum.resize((size_t)width * downsample * bpp);
+    }
+
+    svga_set_frame_capture_func(framecap_capture);
+
+    debug_printf("Frame capture: %s %dx%d, format %d, every %d ms\n", name, width, height, format, interval);
+
+    return true;
+}
+
+void framecap_stop()
+{
+    if (framecap_header == NULL || !framecap_writer) {
+        return;
+    }
+
+    svga_set_frame_capture_func(NULL);
+
+    framecap_header->magic = 0;
+    bool last = SDL_AtomicAdd(&(framecap_header->attached), -1) == 1;
+    compat_shm_close(framecap_name, framecap_size, framecap_rw, framecap_ro, last);
+
+    framecap_header = NULL;
+    framecap_rw = NULL;
+    framecap_ro = NULL;
+    framecap_writer = false;
+
+    std::vector<unsigned char>().swap(framecap_row);
+    std::vector<unsigned short>().swap(framecap_accum);
+}
+
+bool framecap_is_active()
+{
+    return framecap_header != NULL && framecap_writer;
+}
+
+void framecap_get_stats(FrameCapStats* stats)
+{
+    *stats = framecap_stats;
+}
+
+// Attaches to frames exported by another process. Format and size of frames
+// (after downsampling) must match the ones writer uses. Writer does not have
+// to be running yet.
+bool framecap_reader_open(const char* name, int format, int width, int height)
+{
+    if (framecap_header != NULL) {
+        return false;
+    }
+
+    if (name == NULL || format < 0 || format >= FRAMECAP_FORMAT_COUNT || width <= 0 || height <= 0) {
+        return false;
+    }
+
+    size_t size = framecap_segment_size(format, width, height);
+
+    bool created;
+    void* rw;
+    const void* ro;
+    if (!compat_shm_open(name, size, &created, &rw, &ro)) {
+        return false;
+    }
+
+    FrameCapHeader* header = (FrameCapHeader*)rw;
+    SDL_AtomicAdd(&(header->attached), 1);
+
+    strncpy(framecap_name, name, sizeof(framecap_name) - 1);
+    framecap_name[sizeof(framecap_name) - 1] = '\0';
+    framecap_size = size;
+    framecap_header = header;
+    framecap_rw = (unsigned char*)rw;
+    framecap_ro = (const unsigned char*)ro;
+    framecap_writer = false;
+    framecap_reader_slot = -1;
+
+    return true;
+}
+
+void framecap_reader_close()
+{
+    if (framecap_header == NULL || framecap_writer) {
+        return;
+    }
+
+    framecap_reader_release();
+
+    bool last = SDL_AtomicAdd(&(framecap_header->attached), -1) == 1;
+    compat_shm_close(framecap_name, framecap_size, framecap_rw, framecap_ro, last);
+
+    framecap_header = NULL;
+    framecap_rw = NULL;
+    framecap_ro = NULL;
+}
+
+// Holds latest frame until `framecap_reader_release`. Returns `false` when
+// writer has not captured anything yet.
+bool framecap_reader_acquire(FrameCapFrame* frame)
+{
+    FrameCapHeader* header = framecap_header;
+    if (header == NULL || framecap_writer || header->magic != FRAMECAP_MAGIC || header->version != FRAMECAP_VERSION) {
+        return false;
+    }
+
+    framecap_reader_release();
+
+    // Slot is announced before it is checked, writer either sees it held or
+    // has already moved on to another slot by the time seq is read.
+    int slot = SDL_AtomicGet(&(header->latest));
+    if (slot < 0 || slot >= FRAMECAP_SLOT_COUNT) {
+        return false;
+    }
+
+    SDL_AtomicSet(&(header->reading), slot);
+
+    int latest = SDL_AtomicGet(&(header->latest));
+    if (latest != slot) {
+        slot = latest;
+        SDL_AtomicSet(&(header->reading), slot);
+    }
+
+    FrameCapSlot* frameSlot = &(header->slots[slot]);
+    framecap_reader_slot = slot;
+    framecap_reader_seq = SDL_AtomicGet(&(frameSlot->seq));
+
+    frame->format = (int)header->format;
+    frame->width = (int)header->width;
+    frame->height = (int)header->height;
+    frame->pitch = (int)header->pitch;
+    frame->frame = frameSlot->frame;
+    frame->time = frameSlot->time;
+    frame->pixels = framecap_ro + frameSlot->offset;
+    frame->palette = header->format == FRAMECAP_FORMAT_INDEXED ? frameSlot->palette : NULL;
+
+    return (framecap_reader_seq & 1) == 0;
+}
+
+// Releases frame obtained by `framecap_reader_acquire`. Returns `false` if
+// writer overwrote it while it was held (pixels read may be torn).
+bool framecap_reader_release()
+{
+    FrameCapHeader* header = framecap_header;
+    if (header == NULL || framecap_writer || framecap_reader_slot == -1) {
+        return false;
+    }
+
+    bool intact = SDL_AtomicGet(&(header->slots[framecap_reader_slot].seq)) == framecap_reader_seq;
+
+    SDL_AtomicSet(&(header->reading), -1);
+    framecap_reader_slot = -1;
+
+    return intact;
+}
+
+} // namespace fallout
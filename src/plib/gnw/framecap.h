@@ -0,0 +1,111 @@
+#ifndef FALLOUT_PLIB_GNW_FRAMECAP_H_
+#define FALLOUT_PLIB_GNW_FRAMECAP_H_
+
+#include <stdint.h>
+
+#include <SDL.h>
+
+namespace fallout {
+
+// Exports presented frames through shared memory for external controllers.
+//
+// Segment starts with `FrameCapHeader` followed by `FRAMECAP_SLOT_COUNT`
+// frame slots. Game writes each captured frame into a slot which is neither
+// the latest one nor the one held by reader, then publishes it as latest, so
+// reader always has a complete frame to look at without copying it.
+
+#define FRAMECAP_MAGIC 0x50414346 // "FCAP"
+#define FRAMECAP_VERSION 1
+
+#define FRAMECAP_SLOT_COUNT 3
+
+typedef enum FrameCapFormat {
+    // 8-bit palette indices, palette is stored in slot.
+    FRAMECAP_FORMAT_INDEXED,
+
+    // 4 bytes per pixel in R, G, B, A order.
+    FRAMECAP_FORMAT_RGBA,
+
+    // 1 byte of luma per pixel.
+    FRAMECAP_FORMAT_GRAY,
+
+    FRAMECAP_FORMAT_COUNT,
+} FrameCapFormat;
+
+typedef struct FrameCapSlot {
+    // Odd while slot is being written.
+    SDL_atomic_t seq;
+
+    // Capture number, starts from 1.
+    uint32_t frame;
+
+    // Game time (in ms) when frame was captured.
+    uint32_t time;
+
+    // Offset of pixels from the start of the segment.
+    uint32_t offset;
+
+    // R, G, B, A entries (indexed format only).
+    uint8_t palette[256 * 4];
+} FrameCapSlot;
+
+typedef struct FrameCapHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t format;
+    uint32_t width;
+    uint32_t height;
+
+    // Bytes per row of pixels.
+    uint32_t pitch;
+
+    // Slot written last, -1 until first frame is captured.
+    SDL_atomic_t latest;
+
+    // Slot held by reader (not overwritten while held), -1 if none.
+    SDL_atomic_t reading;
+
+    // Number of processes using the segment.
+    SDL_atomic_t attached;
+
+    uint8_t padding[28];
+
+    FrameCapSlot slots[FRAMECAP_SLOT_COUNT];
+} FrameCapHeader;
+
+// Frame obtained by reader. Pixels point into shared memory.
+typedef struct FrameCapFrame {
+    int format;
+    int width;
+    int height;
+    int pitch;
+    unsigned int frame;
+    unsigned int time;
+    const unsigned char* pixels;
+    const unsigned char* palette;
+} FrameCapFrame;
+
+typedef struct FrameCapStats {
+    unsigned int captured;
+
+    // Number of presents skipped because interval did not elapse yet or
+    // screen did not change.
+    unsigned int skipped;
+
+    // Time spent converting frames.
+    unsigned long long micros;
+} FrameCapStats;
+
+bool framecap_start(const char* name, int format, int downsample, int interval);
+void framecap_stop();
+bool framecap_is_active();
+void framecap_get_stats(FrameCapStats* stats);
+
+bool framecap_reader_open(const char* name, int format, int width, int height);
+void framecap_reader_close();
+bool framecap_reader_acquire(FrameCapFrame* frame);
+bool framecap_reader_release();
+
+} // namespace fallout
+
+#endif /* FALLOUT_PLIB_GNW_FRAMECAP_H_ */
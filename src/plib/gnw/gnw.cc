@@ -22,6 +22,9 @@ namespace fallout {
 
 static void win_free(int win);
 static void win_clip(Window* window, RectPtr* rectListNodePtr, unsigned char* a3);
+static bool win_clip_visible(Window* w, RectPtr* rectListNodePtr);
+static void win_layout_changed();
+static void win_free_visible(Window* w);
 static void refresh_all(Rect* rect, unsigned char* a2);
 static void* colorOpen(const char* path);
 static int colorRead(void* handle, void* buf, size_t count);
@@ -72,6 +75,10 @@ static int bk_color;
 // 0x6AC2C8
 static int doing_refresh_all;
 
+// CE: Changes whenever stacking, visibility or position of any window
+// changes, invalidating visible regions cached by `win_clip`.
+static unsigned int win_layout_generation = 1;
+
 // 0x6AC2CC
 void* GNW_texture;
 
@@ -186,6 +193,9 @@ int win_init(VideoOptions* video_options, int flags)
     w->hoveredButton = NULL;
     w->clickedButton = 0;
     w->menuBar = NULL;
+    w->buttonIndex = NULL;
+    w->visibleRects = NULL;
+    w->visibleGeneration = 0;
 
     num_windows = 1;
     GNW_win_init_flag = 1;
@@ -251,6 +261,8 @@ void win_exit(void)
 // 0x4C22F8
 int win_add(int x, int y, int width, int height, int color, int flags)
 {
+    MemTagScope memTagScope(MEM_TAG_UI);
+
     int v23;
     int v25, v26;
     Window* tmp;
@@ -312,6 +324,9 @@ int win_add(int x, int y, int width, int height, int color, int flags)
     w->hoveredButton = 0;
     w->clickedButton = 0;
     w->menuBar = NULL;
+    w->buttonIndex = NULL;
+    w->visibleRects = NULL;
+    w->visibleGeneration = 0;
     w->blitProc = trans_buf_to_buf;
     w->color = color;
     window_index[index] = num_windows;
@@ -347,6 +362,8 @@ int win_add(int x, int y, int width, int height, int color, int flags)
         }
     }
 
+    win_layout_changed();
+
     return index;
 }
 
@@ -378,6 +395,8 @@ void win_delete(int win)
 
     num_windows--;
 
+    win_layout_changed();
+
     // NOTE: Uninline.
     win_refresh_all(&rect);
 }
@@ -405,6 +424,9 @@ static void win_free(int win)
         curr = next;
     }
 
+    GNW_button_index_invalidate(w);
+    win_free_visible(w);
+
     mem_free(w);
 }
 
@@ -413,6 +435,7 @@ void win_buffering(bool state)
 {
     if (screen_buffer != NULL) {
         buffering = state;
+        win_layout_changed();
     }
 }
 
@@ -695,6 +718,7 @@ void win_show(int win)
 
     if (w->flags & WINDOW_HIDDEN) {
         w->flags &= ~WINDOW_HIDDEN;
+        win_layout_changed();
         if (v3 == num_windows - 1) {
             GNW_win_refresh(w, &(w->rect), NULL);
         }
@@ -712,6 +736,7 @@ void win_show(int win)
 
         window[v3] = w;
         window_index[w->id] = v3;
+        win_layout_changed();
         GNW_win_refresh(w, &(w->rect), NULL);
     }
 }
@@ -730,6 +755,7 @@ void win_hide(int win)
 
     if ((w->flags & WINDOW_HIDDEN) == 0) {
         w->flags |= WINDOW_HIDDEN;
+        win_layout_changed();
         refresh_all(&(w->rect), NULL);
     }
 }
@@ -780,6 +806,8 @@ void win_move(int win, int x, int y)
     w->rect.lrx = w->width + x - 1;
     w->rect.lry = w->height + y - 1;
 
+    win_layout_changed();
+
     if ((w->flags & WINDOW_HIDDEN) == 0) {
         GNW_win_refresh(w, &(w->rect), NULL);
 
@@ -998,7 +1026,15 @@ static void win_clip(Window* w, RectPtr* rectListNodePtr, unsigned char* a3)
 {
     int win;
 
-    for (win = window_index[w->id] + 1; win < num_windows; win++) {
+    // CE: Clip against cached visible region of window when possible,
+    // otherwise subtract every window above.
+    if (win_clip_visible(w, rectListNodePtr)) {
+        win = num_windows;
+    } else {
+        win = window_index[w->id] + 1;
+    }
+
+    for (; win < num_windows; win++) {
         if (*rectListNodePtr == NULL) {
             break;
         }
@@ -1026,6 +1062,104 @@ static void win_clip(Window* w, RectPtr* rectListNodePtr, unsigned char* a3)
     }
 }
 
+// CE: Replaces rects in list with their intersections with visible region of
+// window `w`. Returns false if visible region cannot be cached (transparent
+// windows above are redrawn while clipping when buffering) or memory is
+// exhausted, the list is left intact in this case.
+static bool win_clip_visible(Window* w, RectPtr* rectListNodePtr)
+{
+    if (w->visibleGeneration != win_layout_generation) {
+        win_free_visible(w);
+
+        for (int win = window_index[w->id] + 1; win < num_windows; win++) {
+            Window* other = window[win];
+            if ((other->flags & WINDOW_HIDDEN) == 0 && buffering && (other->flags & WINDOW_TRANSPARENT) != 0) {
+                return false;
+            }
+        }
+
+        RectPtr visible = rect_malloc();
+        if (visible == NULL) {
+            return false;
+        }
+
+        rectCopy(&(visible->rect), &(w->rect));
+        visible->next = NULL;
+
+        for (int win = window_index[w->id] + 1; win < num_windows; win++) {
+            if (visible == NULL) {
+                break;
+            }
+
+            Window* other = window[win];
+            if ((other->flags & WINDOW_HIDDEN) == 0) {
+                rect_clip_list(&visible, &(other->rect));
+            }
+        }
+
+        w->visibleRects = visible;
+        w->visibleGeneration = win_layout_generation;
+    }
+
+    RectPtr clipped = NULL;
+    for (RectPtr curr = *rectListNodePtr; curr != NULL; curr = curr->next) {
+        for (RectPtr visible = w->visibleRects; visible != NULL; visible = visible->next) {
+            Rect rect;
+            rect.ulx = std::max(curr->rect.ulx, visible->rect.ulx);
+            rect.uly = std::max(curr->rect.uly, visible->rect.uly);
+            rect.lrx = std::min(curr->rect.lrx, visible->rect.lrx);
+            rect.lry = std::min(curr->rect.lry, visible->rect.lry);
+            if (rect.ulx > rect.lrx || rect.uly > rect.lry) {
+                continue;
+            }
+
+            RectPtr node = rect_malloc();
+            if (node == NULL) {
+                while (clipped != NULL) {
+                    RectPtr next = clipped->next;
+                    rect_free(clipped);
+                    clipped = next;
+                }
+                return false;
+            }
+
+            rectCopy(&(node->rect), &rect);
+            node->next = clipped;
+            clipped = node;
+        }
+    }
+
+    while (*rectListNodePtr != NULL) {
+        RectPtr next = (*rectListNodePtr)->next;
+        rect_free(*rectListNodePtr);
+        *rectListNodePtr = next;
+    }
+
+    *rectListNodePtr = clipped;
+
+    return true;
+}
+
+// CE: Invalidates visible regions of all windows.
+static void win_layout_changed()
+{
+    win_layout_generation++;
+    if (win_layout_generation == 0) {
+        win_layout_generation = 1;
+    }
+}
+
+static void win_free_visible(Window* w)
+{
+    while (w->visibleRects != NULL) {
+        RectPtr next = w->visibleRects->next;
+        rect_free(w->visibleRects);
+        w->visibleRects = next;
+    }
+
+    w->visibleGeneration = 0;
+}
+
 // 0x4C3714
 void win_drag(int win)
 {
@@ -39,6 +39,7 @@ typedef enum ButtonFlags {
 } ButtonFlags;
 
 typedef struct Button Button;
+typedef struct ButtonIndex ButtonIndex;
 typedef struct ButtonGroup ButtonGroup;
 
 typedef void WindowBlitProc(unsigned char* src, int width, int height, int srcPitch, unsigned char* dest, int destPitch);
@@ -78,6 +79,16 @@ typedef struct Window {
     Button* clickedButton;
     MenuBar* menuBar;
     WindowBlitProc* blitProc;
+
+    // CE: Buttons bucketed by location, built on demand (see
+    // `GNW_check_buttons`).
+    ButtonIndex* buttonIndex;
+
+    // CE: Part of window not covered by windows above it, built on demand
+    // (see `win_clip`). Valid while `visibleGeneration` matches current
+    // window layout generation.
+    RectPtr visibleRects;
+    unsigned int visibleGeneration;
 } Window;
 
 typedef struct Button {
@@ -2,10 +2,57 @@
 
 #include <string.h>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define GRBUF_SSE2
+#if defined(__GNUC__) || defined(__clang__) || defined(_MSC_VER)
+#include <immintrin.h>
+#define GRBUF_AVX2
+#endif
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define GRBUF_NEON
+#endif
+
+#include <SDL.h>
+
 #include "plib/color/color.h"
 
+#if defined(GRBUF_AVX2) && (defined(__GNUC__) || defined(__clang__))
+#define GRBUF_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define GRBUF_TARGET_AVX2
+#endif
+
 namespace fallout {
 
+// CE: Row kernels used by blitters, selected once by `grbuf_init_kernels`
+// depending on CPU features. Scalar versions are reference implementations,
+// vectorized ones must produce exactly the same pixels.
+typedef void(GrbufTransRowProc)(unsigned char* dest, const unsigned char* src, int count);
+typedef void(GrbufMaskRowProc)(unsigned char* dest, const unsigned char* src, const unsigned char* mask, int count);
+typedef void(GrbufSwapRowProc)(unsigned char* buf, int count, unsigned char color1, unsigned char color2);
+
+static void grbuf_init_kernels();
+static void trans_row_scalar(unsigned char* dest, const unsigned char* src, int count);
+static void mask_row_scalar(unsigned char* dest, const unsigned char* src, const unsigned char* mask, int count);
+static void swap_row_scalar(unsigned char* buf, int count, unsigned char color1, unsigned char color2);
+#if defined(GRBUF_SSE2) || defined(GRBUF_NEON)
+static void trans_row_simd(unsigned char* dest, const unsigned char* src, int count);
+static void mask_row_simd(unsigned char* dest, const unsigned char* src, const unsigned char* mask, int count);
+static void swap_row_simd(unsigned char* buf, int count, unsigned char color1, unsigned char color2);
+#endif
+#if defined(GRBUF_AVX2)
+GRBUF_TARGET_AVX2 static void trans_row_avx2(unsigned char* dest, const unsigned char* src, int count);
+GRBUF_TARGET_AVX2 static void mask_row_avx2(unsigned char* dest, const unsigned char* src, const unsigned char* mask, int count);
+GRBUF_TARGET_AVX2 static void swap_row_avx2(unsigned char* buf, int count, unsigned char color1, unsigned char color2);
+#endif
+
+static bool grbuf_kernels_initialized = false;
+static GrbufTransRowProc* trans_row = trans_row_scalar;
+static GrbufMaskRowProc* mask_row = mask_row_scalar;
+static GrbufSwapRowProc* swap_row = swap_row_scalar;
+
 // 0x4BD850
 void draw_line(unsigned char* buf, int pitch, int x1, int y1, int x2, int y2, int color)
 {
@@ -219,20 +266,14 @@ void trans_buf_to_buf(unsigned char* src, int width, int height, int srcPitch, u
 void mask_buf_to_buf(unsigned char* src, int width, int height, int srcPitch, unsigned char* mask, int maskPitch, unsigned char* dest, int destPitch)
 {
     int y;
-    int x;
+
+    grbuf_init_kernels();
 
     for (y = 0; y < height; y++) {
-        for (x = 0; x < width; x++) {
-            if (*mask != 0) {
-                *dest = *src;
-            }
-            src++;
-            mask++;
-            dest++;
-        }
-        src += srcPitch - width;
-        mask += maskPitch - width;
-        dest += destPitch - width;
+        mask_row(dest, src, mask, width);
+        src += srcPitch;
+        mask += maskPitch;
+        dest += destPitch;
     }
 }
 
@@ -272,18 +313,30 @@ void lighten_buf(unsigned char* buf, int width, int height, int pitch)
 // 0x4BE31C
 void swap_color_buf(unsigned char* buf, int width, int height, int pitch, int color1, int color2)
 {
-    int step = pitch - width;
-    for (int y = 0; y < height; y++) {
-        for (int x = 0; x < width; x++) {
-            int v1 = *buf & 0xFF;
-            if (v1 == color1) {
-                *buf = color2 & 0xFF;
-            } else if (v1 == color2) {
-                *buf = color1 & 0xFF;
+    // CE: Colors outside of byte range never match (and can not be written
+    // by vectorized kernels), handle them the original way.
+    if (color1 < 0 || color1 > 0xFF || color2 < 0 || color2 > 0xFF) {
+        int step = pitch - width;
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++) {
+                int v1 = *buf & 0xFF;
+                if (v1 == color1) {
+                    *buf = color2 & 0xFF;
+                } else if (v1 == color2) {
+                    *buf = color1 & 0xFF;
+                }
+                buf++;
             }
-            buf++;
+            buf += step;
         }
-        buf += step;
+        return;
+    }
+
+    grbuf_init_kernels();
+
+    for (int y = 0; y < height; y++) {
+        swap_row(buf, width, (unsigned char)color1, (unsigned char)color2);
+        buf += pitch;
     }
 }
 
@@ -343,20 +396,436 @@ void srcCopy(unsigned char* dest, int destPitch, unsigned char* src, int srcPitc
 // 0x4CDC75
 void transSrcCopy(unsigned char* dest, int destPitch, unsigned char* src, int srcPitch, int width, int height)
 {
-    int destSkip = destPitch - width;
-    int srcSkip = srcPitch - width;
+    grbuf_init_kernels();
 
     for (int y = 0; y < height; y++) {
-        for (int x = 0; x < width; x++) {
-            unsigned char c = *src++;
-            if (c != 0) {
-                *dest = c;
+        trans_row(dest, src, width);
+        src += srcPitch;
+        dest += destPitch;
+    }
+}
+
+// CE: Span encoded sprites.
+//
+// Encoded sprite starts with `height` row offsets (ints, from the beginning of
+// encoded data). Every row is a 16-bit number of runs followed by runs. Every
+// run is 16-bit number of transparent pixels to skip (from the end of previous
+// run), 16-bit number of opaque pixels and opaque pixels themselves. 16-bit
+// values are little-endian and unaligned.
+//
+// Returns number of bytes needed to encode sprite with `span_encode`.
+int span_encode_size(unsigned char* src, int width, int height, int pitch)
+{
+    int size = sizeof(int) * height;
+
+    for (int y = 0; y < height; y++) {
+        unsigned char* row = src + pitch * y;
+
+        size += 2;
+
+        int x = 0;
+        while (x < width) {
+            while (x < width && row[x] == 0) {
+                x++;
+            }
+
+            if (x == width) {
+                break;
             }
-            dest++;
+
+            int run = 0;
+            while (x < width && row[x] != 0) {
+                x++;
+                run++;
+            }
+
+            size += 4 + run;
+        }
+    }
+
+    return size;
+}
+
+// CE: Encodes sprite into `dest` which must be at least `span_encode_size`
+// bytes.
+void span_encode(unsigned char* src, int width, int height, int pitch, unsigned char* dest)
+{
+    int* rowOffsets = (int*)dest;
+    unsigned char* ptr = dest + sizeof(int) * height;
+
+    for (int y = 0; y < height; y++) {
+        unsigned char* row = src + pitch * y;
+
+        rowOffsets[y] = (int)(ptr - dest);
+
+        unsigned char* countPtr = ptr;
+        ptr += 2;
+
+        int count = 0;
+        int x = 0;
+        int end = 0;
+        while (x < width) {
+            while (x < width && row[x] == 0) {
+                x++;
+            }
+
+            if (x == width) {
+                break;
+            }
+
+            int start = x;
+            while (x < width && row[x] != 0) {
+                x++;
+            }
+
+            int skip = start - end;
+            int run = x - start;
+
+            ptr[0] = skip & 0xFF;
+            ptr[1] = (skip >> 8) & 0xFF;
+            ptr[2] = run & 0xFF;
+            ptr[3] = (run >> 8) & 0xFF;
+            memcpy(ptr + 4, row + start, run);
+            ptr += 4 + run;
+
+            end = x;
+            count++;
+        }
+
+        countPtr[0] = count & 0xFF;
+        countPtr[1] = (count >> 8) & 0xFF;
+    }
+}
+
+// CE: Span encoded version of `trans_buf_to_buf`. Copies `width` x `height`
+// part of encoded sprite starting at `srcX`, `srcY` to `dest`.
+void span_trans_buf_to_buf(unsigned char* spans, int srcX, int srcY, int width, int height, unsigned char* dest, int destPitch)
+{
+    int* rowOffsets = (int*)spans;
+    int srcRight = srcX + width;
+
+    for (int y = 0; y < height; y++) {
+        unsigned char* ptr = spans + rowOffsets[srcY + y];
+        int count = ptr[0] | (ptr[1] << 8);
+        ptr += 2;
+
+        int x = 0;
+        while (count-- > 0) {
+            x += ptr[0] | (ptr[1] << 8);
+            if (x >= srcRight) {
+                break;
+            }
+
+            int run = ptr[2] | (ptr[3] << 8);
+            ptr += 4;
+
+            int start = x > srcX ? x : srcX;
+            int end = x + run < srcRight ? x + run : srcRight;
+            if (start < end) {
+                memcpy(dest + start - srcX, ptr + start - x, end - start);
+            }
+
+            ptr += run;
+            x += run;
+        }
+
+        dest += destPitch;
+    }
+}
+
+// CE: Selects row kernels for current CPU (once).
+static void grbuf_init_kernels()
+{
+    if (grbuf_kernels_initialized) {
+        return;
+    }
+
+#if defined(GRBUF_SSE2)
+    trans_row = trans_row_simd;
+    mask_row = mask_row_simd;
+    swap_row = swap_row_simd;
+
+#if defined(GRBUF_AVX2)
+    if (SDL_HasAVX2()) {
+        trans_row = trans_row_avx2;
+        mask_row = mask_row_avx2;
+        swap_row = swap_row_avx2;
+    }
+#endif
+#elif defined(GRBUF_NEON)
+    trans_row = trans_row_simd;
+    mask_row = mask_row_simd;
+    swap_row = swap_row_simd;
+#endif
+
+    grbuf_kernels_initialized = true;
+}
+
+// CE: Forces row kernel set, so vectorized kernels can be compared against
+// scalar ones. Returns `false` (keeping current set) when set is not
+// supported by build or CPU.
+bool grbuf_set_kernels(int kernels)
+{
+    switch (kernels) {
+    case GRBUF_KERNELS_AUTO:
+        grbuf_kernels_initialized = false;
+        grbuf_init_kernels();
+        return true;
+    case GRBUF_KERNELS_SCALAR:
+        trans_row = trans_row_scalar;
+        mask_row = mask_row_scalar;
+        swap_row = swap_row_scalar;
+        break;
+#if defined(GRBUF_SSE2) || defined(GRBUF_NEON)
+    case GRBUF_KERNELS_SIMD:
+        trans_row = trans_row_simd;
+        mask_row = mask_row_simd;
+        swap_row = swap_row_simd;
+        break;
+#endif
+#if defined(GRBUF_AVX2)
+    case GRBUF_KERNELS_AVX2:
+        if (!SDL_HasAVX2()) {
+            return false;
+        }
+
+        trans_row = trans_row_avx2;
+        mask_row = mask_row_avx2;
+        swap_row = swap_row_avx2;
+        break;
+#endif
+    default:
+        return false;
+    }
+
+    grbuf_kernels_initialized = true;
+
+    return true;
+}
+
+// CE: Copies non-zero pixels.
+static void trans_row_scalar(unsigned char* dest, const unsigned char* src, int count)
+{
+    for (int x = 0; x < count; x++) {
+        unsigned char c = src[x];
+        if (c != 0) {
+            dest[x] = c;
+        }
+    }
+}
+
+// CE: Copies pixels with non-zero mask.
+static void mask_row_scalar(unsigned char* dest, const unsigned char* src, const unsigned char* mask, int count)
+{
+    for (int x = 0; x < count; x++) {
+        if (mask[x] != 0) {
+            dest[x] = src[x];
+        }
+    }
+}
+
+// CE: Swaps two colors.
+static void swap_row_scalar(unsigned char* buf, int count, unsigned char color1, unsigned char color2)
+{
+    for (int x = 0; x < count; x++) {
+        unsigned char v1 = buf[x];
+        if (v1 == color1) {
+            buf[x] = color2;
+        } else if (v1 == color2) {
+            buf[x] = color1;
+        }
+    }
+}
+
+#if defined(GRBUF_SSE2)
+
+static void trans_row_simd(unsigned char* dest, const unsigned char* src, int count)
+{
+    __m128i zero = _mm_setzero_si128();
+
+    int x = 0;
+    for (; x + 16 <= count; x += 16) {
+        __m128i s = _mm_loadu_si128((const __m128i*)(src + x));
+        __m128i transparent = _mm_cmpeq_epi8(s, zero);
+        int bits = _mm_movemask_epi8(transparent);
+        if (bits == 0xFFFF) {
+            continue;
+        }
+
+        if (bits == 0) {
+            _mm_storeu_si128((__m128i*)(dest + x), s);
+            continue;
         }
-        src += srcSkip;
-        dest += destSkip;
+
+        __m128i d = _mm_loadu_si128((const __m128i*)(dest + x));
+        d = _mm_or_si128(_mm_and_si128(transparent, d), _mm_andnot_si128(transparent, s));
+        _mm_storeu_si128((__m128i*)(dest + x), d);
     }
+
+    trans_row_scalar(dest + x, src + x, count - x);
 }
 
+static void mask_row_simd(unsigned char* dest, const unsigned char* src, const unsigned char* mask, int count)
+{
+    __m128i zero = _mm_setzero_si128();
+
+    int x = 0;
+    for (; x + 16 <= count; x += 16) {
+        __m128i m = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(mask + x)), zero);
+        int bits = _mm_movemask_epi8(m);
+        if (bits == 0xFFFF) {
+            continue;
+        }
+
+        __m128i s = _mm_loadu_si128((const __m128i*)(src + x));
+        if (bits != 0) {
+            __m128i d = _mm_loadu_si128((const __m128i*)(dest + x));
+            s = _mm_or_si128(_mm_and_si128(m, d), _mm_andnot_si128(m, s));
+        }
+        _mm_storeu_si128((__m128i*)(dest + x), s);
+    }
+
+    mask_row_scalar(dest + x, src + x, mask + x, count - x);
+}
+
+static void swap_row_simd(unsigned char* buf, int count, unsigned char color1, unsigned char color2)
+{
+    __m128i c1 = _mm_set1_epi8((char)color1);
+    __m128i c2 = _mm_set1_epi8((char)color2);
+
+    int x = 0;
+    for (; x + 16 <= count; x += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(buf + x));
+        __m128i m1 = _mm_cmpeq_epi8(v, c1);
+        __m128i m2 = _mm_andnot_si128(m1, _mm_cmpeq_epi8(v, c2));
+        if (_mm_movemask_epi8(_mm_or_si128(m1, m2)) == 0) {
+            continue;
+        }
+
+        v = _mm_or_si128(_mm_andnot_si128(_mm_or_si128(m1, m2), v),
+            _mm_or_si128(_mm_and_si128(m1, c2), _mm_and_si128(m2, c1)));
+        _mm_storeu_si128((__m128i*)(buf + x), v);
+    }
+
+    swap_row_scalar(buf + x, count - x, color1, color2);
+}
+
+#elif defined(GRBUF_NEON)
+
+static void trans_row_simd(unsigned char* dest, const unsigned char* src, int count)
+{
+    int x = 0;
+    for (; x + 16 <= count; x += 16) {
+        uint8x16_t s = vld1q_u8(src + x);
+        uint8x16_t d = vld1q_u8(dest + x);
+        vst1q_u8(dest + x, vbslq_u8(vceqq_u8(s, vdupq_n_u8(0)), d, s));
+    }
+
+    trans_row_scalar(dest + x, src + x, count - x);
+}
+
+static void mask_row_simd(unsigned char* dest, const unsigned char* src, const unsigned char* mask, int count)
+{
+    int x = 0;
+    for (; x + 16 <= count; x += 16) {
+        uint8x16_t m = vceqq_u8(vld1q_u8(mask + x), vdupq_n_u8(0));
+        uint8x16_t s = vld1q_u8(src + x);
+        uint8x16_t d = vld1q_u8(dest + x);
+        vst1q_u8(dest + x, vbslq_u8(m, d, s));
+    }
+
+    mask_row_scalar(dest + x, src + x, mask + x, count - x);
+}
+
+static void swap_row_simd(unsigned char* buf, int count, unsigned char color1, unsigned char color2)
+{
+    uint8x16_t c1 = vdupq_n_u8(color1);
+    uint8x16_t c2 = vdupq_n_u8(color2);
+
+    int x = 0;
+    for (; x + 16 <= count; x += 16) {
+        uint8x16_t v = vld1q_u8(buf + x);
+        uint8x16_t m1 = vceqq_u8(v, c1);
+        uint8x16_t m2 = vbicq_u8(vceqq_u8(v, c2), m1);
+        v = vbslq_u8(m1, c2, vbslq_u8(m2, c1, v));
+        vst1q_u8(buf + x, v);
+    }
+
+    swap_row_scalar(buf + x, count - x, color1, color2);
+}
+
+#endif
+
+#if defined(GRBUF_AVX2)
+
+GRBUF_TARGET_AVX2 static void trans_row_avx2(unsigned char* dest, const unsigned char* src, int count)
+{
+    __m256i zero = _mm256_setzero_si256();
+
+    int x = 0;
+    for (; x + 32 <= count; x += 32) {
+        __m256i s = _mm256_loadu_si256((const __m256i*)(src + x));
+        __m256i transparent = _mm256_cmpeq_epi8(s, zero);
+        unsigned int bits = (unsigned int)_mm256_movemask_epi8(transparent);
+        if (bits == 0xFFFFFFFF) {
+            continue;
+        }
+
+        if (bits != 0) {
+            __m256i d = _mm256_loadu_si256((const __m256i*)(dest + x));
+            s = _mm256_blendv_epi8(s, d, transparent);
+        }
+        _mm256_storeu_si256((__m256i*)(dest + x), s);
+    }
+
+    trans_row_simd(dest + x, src + x, count - x);
+}
+
+GRBUF_TARGET_AVX2 static void mask_row_avx2(unsigned char* dest, const unsigned char* src, const unsigned char* mask, int count)
+{
+    __m256i zero = _mm256_setzero_si256();
+
+    int x = 0;
+    for (; x + 32 <= count; x += 32) {
+        __m256i m = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(mask + x)), zero);
+        unsigned int bits = (unsigned int)_mm256_movemask_epi8(m);
+        if (bits == 0xFFFFFFFF) {
+            continue;
+        }
+
+        __m256i s = _mm256_loadu_si256((const __m256i*)(src + x));
+        if (bits != 0) {
+            __m256i d = _mm256_loadu_si256((const __m256i*)(dest + x));
+            s = _mm256_blendv_epi8(s, d, m);
+        }
+        _mm256_storeu_si256((__m256i*)(dest + x), s);
+    }
+
+    mask_row_simd(dest + x, src + x, mask + x, count - x);
+}
+
+GRBUF_TARGET_AVX2 static void swap_row_avx2(unsigned char* buf, int count, unsigned char color1, unsigned char color2)
+{
+    __m256i c1 = _mm256_set1_epi8((char)color1);
+    __m256i c2 = _mm256_set1_epi8((char)color2);
+
+    int x = 0;
+    for (; x + 32 <= count; x += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(buf + x));
+        __m256i m1 = _mm256_cmpeq_epi8(v, c1);
+        __m256i m2 = _mm256_cmpeq_epi8(v, c2);
+        if (_mm256_movemask_epi8(_mm256_or_si256(m1, m2)) == 0) {
+            continue;
+        }
+
+        // First match wins, same as scalar version when colors are equal.
+        v = _mm256_blendv_epi8(_mm256_blendv_epi8(v, c1, m2), c2, m1);
+        _mm256_storeu_si256((__m256i*)(buf + x), v);
+    }
+
+    swap_row_simd(buf + x, count - x, color1, color2);
+}
+
+#endif
+
 } // namespace fallout
@@ -3,6 +3,15 @@
 
 namespace fallout {
 
+// CE: Row kernel sets of blitters, see `grbuf_set_kernels`.
+typedef enum GrbufKernels {
+    // Best set supported by CPU (default).
+    GRBUF_KERNELS_AUTO,
+    GRBUF_KERNELS_SCALAR,
+    GRBUF_KERNELS_SIMD,
+    GRBUF_KERNELS_AVX2,
+} GrbufKernels;
+
 void draw_line(unsigned char* buf, int pitch, int left, int top, int right, int bottom, int color);
 void draw_box(unsigned char* buf, int a2, int a3, int a4, int a5, int a6, int a7);
 void draw_shaded_box(unsigned char* buf, int a2, int a3, int a4, int a5, int a6, int a7, int a8);
@@ -18,6 +27,10 @@ void swap_color_buf(unsigned char* buf, int width, int height, int pitch, int co
 void buf_outline(unsigned char* buf, int width, int height, int pitch, int a5);
 void srcCopy(unsigned char* dest, int destPitch, unsigned char* src, int srcPitch, int width, int height);
 void transSrcCopy(unsigned char* dest, int destPitch, unsigned char* src, int srcPitch, int width, int height);
+int span_encode_size(unsigned char* src, int width, int height, int pitch);
+void span_encode(unsigned char* src, int width, int height, int pitch, unsigned char* dest);
+void span_trans_buf_to_buf(unsigned char* spans, int srcX, int srcY, int width, int height, unsigned char* dest, int destPitch);
+bool grbuf_set_kernels(int kernels);
 
 } // namespace fallout
 
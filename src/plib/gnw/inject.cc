@@ -0,0 +1,122 @@
+#include "plib/gnw/inject.h"
+
+#include <SDL.h>
+
+namespace fallout {
+
+#define INJECT_QUEUE_MASK (INJECT_QUEUE_CAPACITY - 1)
+
+static_assert((INJECT_QUEUE_CAPACITY & INJECT_QUEUE_MASK) == 0, "capacity must be power of two");
+
+// Slot of the queue. `sequence` equals slot's position when slot is free for
+// a producer at that position, and position + 1 when it holds event which
+// can be consumed.
+typedef struct InjectSlot {
+    SDL_atomic_t sequence;
+    InjectEvent event;
+} InjectSlot;
+
+static InjectSlot inject_slots[INJECT_QUEUE_CAPACITY];
+
+// Next position to push to, shared by producers.
+static SDL_atomic_t inject_tail;
+
+// Next position to pop from, owned by main thread.
+static int inject_head = 0;
+
+// Number of events rejected because queue was full.
+static SDL_atomic_t inject_rejected;
+
+// Resets queue, must be called before any thread pushes events.
+void inject_init()
+{
+    for (int index = 0; index < INJECT_QUEUE_CAPACITY; index++) {
+        SDL_AtomicSet(&(inject_slots[index].sequence), index);
+    }
+
+    SDL_AtomicSet(&inject_tail, 0);
+    SDL_AtomicSet(&inject_rejected, 0);
+    inject_head = 0;
+}
+
+// Adds event to the queue, can be called from any thread. Returns false if
+// queue is full, so caller can retry later instead of losing event.
+bool inject_push(const InjectEvent* event)
+{
+    int position = SDL_AtomicGet(&inject_tail);
+    InjectSlot* slot;
+
+    while (true) {
+        slot = &(inject_slots[position & INJECT_QUEUE_MASK]);
+
+        int diff = SDL_AtomicGet(&(slot->sequence)) - position;
+        if (diff == 0) {
+            if (SDL_AtomicCAS(&inject_tail, position, position + 1)) {
+                break;
+            }
+        } else if (diff < 0) {
+            SDL_AtomicAdd(&inject_rejected, 1);
+            return false;
+        }
+
+        position = SDL_AtomicGet(&inject_tail);
+    }
+
+    slot->event = *event;
+    SDL_AtomicSet(&(slot->sequence), position + 1);
+
+    return true;
+}
+
+bool inject_push_key(int key, bool down, int x, int y, unsigned int time)
+{
+    InjectEvent event = {};
+    event.type = INJECT_EVENT_TYPE_KEY;
+    event.time = time;
+    event.x = x;
+    event.y = y;
+    event.key = key;
+    event.down = down;
+    return inject_push(&event);
+}
+
+bool inject_push_mouse(int x, int y, int buttons, unsigned int time)
+{
+    InjectEvent event = {};
+    event.type = INJECT_EVENT_TYPE_MOUSE;
+    event.time = time;
+    event.x = x;
+    event.y = y;
+    event.buttons = buttons;
+    return inject_push(&event);
+}
+
+// Copies event at the front of the queue without removing it. Main thread
+// only.
+bool inject_peek(InjectEvent* event)
+{
+    InjectSlot* slot = &(inject_slots[inject_head & INJECT_QUEUE_MASK]);
+    if (SDL_AtomicGet(&(slot->sequence)) - (inject_head + 1) < 0) {
+        return false;
+    }
+
+    *event = slot->event;
+
+    return true;
+}
+
+// Removes event at the front of the queue (which must be there, see
+// `inject_peek`). Main thread only.
+void inject_pop()
+{
+    InjectSlot* slot = &(inject_slots[inject_head & INJECT_QUEUE_MASK]);
+    SDL_AtomicSet(&(slot->sequence), inject_head + INJECT_QUEUE_CAPACITY);
+    inject_head++;
+}
+
+int inject_get_rejected_count()
+{
+    return SDL_AtomicGet(&inject_rejected);
+}
+
+} // namespace fallout
@@ -0,0 +1,55 @@
+#ifndef FALLOUT_PLIB_GNW_INJECT_H_
+#define FALLOUT_PLIB_GNW_INJECT_H_
+
+namespace fallout {
+
+// Queue of input events injected by control threads (agent bridge, network
+// control), drained by `GNW95_process_message` on main thread.
+//
+// The queue is bounded and lock-free, any number of threads can push, only
+// main thread pops. Unlike SDL events injected events carry absolute mouse
+// position and the time (on virtual clock, see `vclock_now`) when they are
+// due, so batches can be queued ahead and are replayed at the game's pace.
+
+#define INJECT_QUEUE_CAPACITY 1024
+
+typedef enum InjectEventType {
+    INJECT_EVENT_TYPE_KEY,
+    INJECT_EVENT_TYPE_MOUSE,
+} InjectEventType;
+
+typedef struct InjectEvent {
+    InjectEventType type;
+
+    // Virtual clock time when event is due, events are delivered in order
+    // they were pushed, so earlier events with later time hold back the
+    // rest. 0 - as soon as possible.
+    unsigned int time;
+
+    // Mouse position (in screen coordinates) set before event is delivered,
+    // -1 keeps mouse where it is.
+    int x;
+    int y;
+
+    // SDL scancode and state of `INJECT_EVENT_TYPE_KEY`.
+    int key;
+    bool down;
+
+    // Buttons held down (`MOUSE_STATE_*`) and wheel movement of
+    // `INJECT_EVENT_TYPE_MOUSE`.
+    int buttons;
+    int wheelX;
+    int wheelY;
+} InjectEvent;
+
+void inject_init();
+bool inject_push(const InjectEvent* event);
+bool inject_push_key(int key, bool down, int x, int y, unsigned int time);
+bool inject_push_mouse(int x, int y, int buttons, unsigned int time);
+bool inject_peek(InjectEvent* event);
+void inject_pop();
+int inject_get_rejected_count();
+
+} // namespace fallout
+
+#endif /* FALLOUT_PLIB_GNW_INJECT_H_ */
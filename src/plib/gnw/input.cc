@@ -10,11 +10,16 @@
 #include "plib/gnw/dxinput.h"
 #include "plib/gnw/gnw.h"
 #include "plib/gnw/grbuf.h"
+#include "plib/gnw/inject.h"
 #include "plib/gnw/intrface.h"
+#include "plib/gnw/jobs.h"
 #include "plib/gnw/memory.h"
+#include "plib/gnw/mouse.h"
+#include "plib/gnw/prof.h"
 #include "plib/gnw/svga.h"
 #include "plib/gnw/text.h"
 #include "plib/gnw/touch.h"
+#include "plib/gnw/vclock.h"
 #include "plib/gnw/vcr.h"
 #include "plib/gnw/winmain.h"
 
@@ -49,8 +54,10 @@ static int default_pause_window();
 static void buf_blit(unsigned char* src, unsigned int src_pitch, unsigned int a3, unsigned int x, unsigned int y, unsigned int width, unsigned int height, unsigned int dest_x, unsigned int dest_y);
 static void GNW95_build_key_map();
 static void GNW95_process_key(KeyboardData* data);
+static void GNW95_process_injected();
 
 static void idleImpl();
+static bool GNW95_key_repeat_pending();
 
 // 0x539D6C
 static IdleFunc* idle_func = NULL;
@@ -58,6 +65,10 @@ static IdleFunc* idle_func = NULL;
 // 0x539D70
 static FocusFunc* focus_func = NULL;
 
+// CE: Returns how long (in ms) message processing can block waiting for
+// events while screen is idle. Blocking is disabled when it's not set.
+static IdleWaitFunc* idle_wait_func = NULL;
+
 // 0x539D74
 static unsigned int GNW95_repeat_rate = 80;
 
@@ -122,6 +133,13 @@ static bool bk_disabled;
 // 0x671F08
 static unsigned int bk_process_time;
 
+// CE: Specifies whether game runs on stepped clock as fast as possible (see
+// `set_turbo_mode`).
+static bool turbo_enabled = false;
+
+// CE: Specifies whether presents are skipped in turbo mode.
+static bool turbo_skip_present = false;
+
 // 0x4B32C0
 int GNW_input_init(int use_msec_timer)
 {
@@ -144,6 +162,9 @@ int GNW_input_init(int use_msec_timer)
     GNW95_build_key_map();
     GNW95_clear_time_stamps();
 
+    // CE: Control threads may push events as soon as input is up.
+    inject_init();
+
     using_msec_timer = use_msec_timer;
     input_put = 0;
     input_get = -1;
@@ -213,10 +234,15 @@ void get_input_position(int* x, int* y)
 // 0x4B342C
 void process_bk()
 {
+    ProfScope profScope(PROF_ZONE_PROCESS_BK);
+
     int v1;
 
     GNW_do_bk_process();
 
+    // CE: Apply results handed back by worker threads.
+    jobs_process_commits();
+
     if (vcr_update() != 3) {
         mouse_info();
     }
@@ -631,12 +657,20 @@ void register_screendump(int new_screendump_key, ScreenDumpFunc* new_screendump_
 // 0x4B3BB8
 unsigned int get_time()
 {
-    return SDL_GetTicks();
+    // CE: Time comes from clock service, which may be scaled or stepped.
+    return vclock_now();
 }
 
 // 0x4B3BC4
 void pause_for_tocks(unsigned int delay)
 {
+    // CE: Nothing to wait for on stepped clock, jump to the end of the pause.
+    if (vclock_get_mode() == VCLOCK_MODE_STEPPED) {
+        process_bk();
+        vclock_step(delay);
+        return;
+    }
+
     // NOTE: Uninline.
     unsigned int start = get_time();
     unsigned int end = get_time();
@@ -656,7 +690,12 @@ void pause_for_tocks(unsigned int delay)
 // 0x4B3C00
 void block_for_tocks(unsigned int ms)
 {
-    unsigned int start = SDL_GetTicks();
+    if (vclock_get_mode() == VCLOCK_MODE_STEPPED) {
+        vclock_step(ms);
+        return;
+    }
+
+    unsigned int start = get_time();
     unsigned int diff;
     do {
         // NOTE: Uninline
@@ -667,12 +706,40 @@ void block_for_tocks(unsigned int ms)
 // 0x4B3C28
 unsigned int elapsed_time(unsigned int start)
 {
-    unsigned int end = SDL_GetTicks();
+    unsigned int end = get_time();
 
     // NOTE: Uninline.
     return elapsed_tocks(end, start);
 }
 
+// CE: Enables or disables turbo mode. Turbo mode switches clock service to
+// stepped mode where every frame (`FpsLimiter::throttle`) takes exactly its
+// share of game time and waits return immediately, so game logic sees the
+// same time regardless of how fast the host is. When `skip_present` is set,
+// `renderPresent` does nothing (headless only).
+void set_turbo_mode(bool enabled, bool skip_present)
+{
+    if (enabled) {
+        vclock_set_frame_step(true);
+        vclock_set_mode(VCLOCK_MODE_STEPPED);
+    } else if (turbo_enabled) {
+        vclock_set_mode(VCLOCK_MODE_REAL);
+    }
+
+    turbo_enabled = enabled;
+    turbo_skip_present = enabled && skip_present;
+}
+
+bool is_turbo_mode()
+{
+    return turbo_enabled;
+}
+
+bool turbo_skips_present()
+{
+    return turbo_skip_present;
+}
+
 // 0x4B3C48
 unsigned int elapsed_tocks(unsigned int end, unsigned int start)
 {
@@ -683,6 +750,18 @@ unsigned int elapsed_tocks(unsigned int end, unsigned int start)
     }
 }
 
+// CE: Returns number of milliseconds left until `period` elapses since
+// `start` (0 when it has already elapsed).
+unsigned int remaining_tocks(unsigned int now, unsigned int start, unsigned int period)
+{
+    unsigned int elapsed = elapsed_tocks(now, start);
+    if (elapsed >= period) {
+        return 0;
+    }
+
+    return period - elapsed;
+}
+
 // 0x4B3C58
 unsigned int get_bk_time()
 {
@@ -737,6 +816,16 @@ IdleFunc* get_idle_func()
     return idle_func;
 }
 
+void set_idle_wait_func(IdleWaitFunc* new_idle_wait_func)
+{
+    idle_wait_func = new_idle_wait_func;
+}
+
+IdleWaitFunc* get_idle_wait_func()
+{
+    return idle_wait_func;
+}
+
 // 0x4B3CD8
 static void GNW95_build_key_map()
 {
@@ -1081,10 +1170,27 @@ void GNW95_input_exit()
 // 0x4B4538
 void GNW95_process_message()
 {
+    ProfScope profScope(PROF_ZONE_PROCESS_MESSAGE);
+
     // We need to process event loop even if program is not active or keyboard
     // is disabled, because if we ignore it, we'll never be able to reactivate
     // it again.
 
+    // CE: Nothing changed on screen since last frame, sleep until next event
+    // or deadline reported by the game (event stays in the queue).
+    if (idle_wait_func != NULL && GNW95_isActive && renderIsIdle() && !GNW95_key_repeat_pending()) {
+        unsigned int timeout = idle_wait_func();
+
+        unsigned int mouseDelay = mouse_anim_next_delay();
+        if (mouseDelay < timeout) {
+            timeout = mouseDelay;
+        }
+
+        if (timeout != 0) {
+            SDL_WaitEventTimeout(NULL, (int)timeout);
+        }
+    }
+
     KeyboardData keyboardData;
     SDL_Event e;
     while (SDL_PollEvent(&e)) {
@@ -1138,6 +1244,8 @@ void GNW95_process_message()
         }
     }
 
+    GNW95_process_injected();
+
     touch_process_gesture();
 
     if (GNW95_isActive && !kb_is_disabled()) {
@@ -1202,6 +1310,51 @@ static void GNW95_process_key(KeyboardData* data)
     }
 }
 
+// CE: Delivers injected events which are due. Delivery stops after the first
+// event which produces input (key press, button change or wheel), the rest
+// waits for the next call, so that presses are not coalesced and every one
+// is picked up with its own mouse position.
+static void GNW95_process_injected()
+{
+    static int buttons = 0;
+
+    unsigned int now = vclock_peek();
+
+    InjectEvent event;
+    while (inject_peek(&event)) {
+        if (event.time != 0 && (int)(event.time - now) > 0) {
+            break;
+        }
+
+        inject_pop();
+
+        if (event.x != -1 && event.y != -1) {
+            mouse_set_position(event.x, event.y);
+        }
+
+        bool produced = false;
+        if (event.type == INJECT_EVENT_TYPE_KEY) {
+            if (!kb_is_disabled()) {
+                KeyboardData keyboardData;
+                keyboardData.key = event.key;
+                keyboardData.down = event.down ? 1 : 0;
+                GNW95_process_key(&keyboardData);
+                produced = event.down;
+            }
+        } else if (event.type == INJECT_EVENT_TYPE_MOUSE) {
+            dxinput_set_injected_mouse_buttons((event.buttons & MOUSE_STATE_LEFT_BUTTON_DOWN) != 0,
+                (event.buttons & MOUSE_STATE_RIGHT_BUTTON_DOWN) != 0);
+            dxinput_add_injected_mouse_wheel(event.wheelX, event.wheelY);
+            produced = event.buttons != buttons || event.wheelX != 0 || event.wheelY != 0;
+            buttons = event.buttons;
+        }
+
+        if (produced) {
+            break;
+        }
+    }
+}
+
 // 0x4B4734
 void GNW95_lost_focus()
 {
@@ -1224,6 +1377,10 @@ void GNW95_lost_focus()
 
 static void idleImpl()
 {
+    if (turbo_enabled) {
+        return;
+    }
+
     SDL_Delay(125);
 }
 
@@ -1237,4 +1394,16 @@ void endTextInput()
     SDL_StopTextInput();
 }
 
+// CE: Returns `true` if any key is held down (and is going to be repeated).
+static bool GNW95_key_repeat_pending()
+{
+    for (int key = 0; key < SDL_NUM_SCANCODES; key++) {
+        if (GNW95_key_time_stamps[key].time != -1) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
 } // namespace fallout
@@ -13,6 +13,7 @@ typedef void(FocusFunc)(int);
 typedef void(BackgroundProcess)();
 typedef int(PauseWinFunc)();
 typedef int(ScreenDumpFunc)(int width, int height, unsigned char* buffer, unsigned char* palette);
+typedef unsigned int(IdleWaitFunc)();
 
 int GNW_input_init(int use_msec_timer);
 void GNW_input_exit();
@@ -35,7 +36,11 @@ void pause_for_tocks(unsigned int ms);
 void block_for_tocks(unsigned int ms);
 unsigned int elapsed_time(unsigned int a1);
 unsigned int elapsed_tocks(unsigned int a1, unsigned int a2);
+unsigned int remaining_tocks(unsigned int now, unsigned int start, unsigned int period);
 unsigned int get_bk_time();
+void set_turbo_mode(bool enabled, bool skip_present);
+bool is_turbo_mode();
+bool turbo_skips_present();
 void set_repeat_rate(unsigned int rate);
 unsigned int get_repeat_rate();
 void set_repeat_delay(unsigned int delay);
@@ -44,6 +49,8 @@ void set_focus_func(FocusFunc* new_focus_func);
 FocusFunc* get_focus_func();
 void set_idle_func(IdleFunc* new_idle_func);
 IdleFunc* get_idle_func();
+void set_idle_wait_func(IdleWaitFunc* new_idle_wait_func);
+IdleWaitFunc* get_idle_wait_func();
 int GNW95_input_init();
 void GNW95_input_exit();
 void GNW95_process_message();
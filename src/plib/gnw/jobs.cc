@@ -0,0 +1,332 @@
+#include "plib/gnw/jobs.h"
+
+#include <deque>
+#include <vector>
+
+#include "plib/gnw/debug.h"
+
+namespace fallout {
+
+// Idle wait of `jobs_wait`, in case jobs of the group are run by threads
+// which are waiting themselves.
+#define JOBS_WAIT_TIMEOUT 1
+
+typedef struct Job {
+    JobProc* proc;
+    void* data;
+    JobGroup* group;
+} Job;
+
+typedef struct JobQueue {
+    SDL_SpinLock lock;
+    std::deque<Job> jobs;
+} JobQueue;
+
+static int jobs_thread(void* data);
+static bool jobs_start(int workers);
+static void jobs_stop();
+static bool jobs_take(int self, Job* job);
+static void jobs_run(Job* job);
+
+// Queue 0 belongs to main thread (and threads outside of pool), queue
+// `index + 1` - to worker `index`.
+static JobQueue jobs_queues[JOBS_MAX_WORKERS + 1];
+
+// Queue of the calling thread.
+static thread_local int jobs_queue_index = 0;
+
+static SDL_Thread* jobs_threads[JOBS_MAX_WORKERS];
+static int jobs_workers = 0;
+
+// Number of workers to restart with `jobs_resume`.
+static int jobs_suspended_workers = 0;
+
+// Number of jobs in all queues.
+static SDL_atomic_t jobs_queued;
+
+// Protects waiting on conditions below, queues have locks of their own.
+static SDL_mutex* jobs_mutex = NULL;
+static SDL_cond* jobs_work_cond = NULL;
+static SDL_cond* jobs_done_cond = NULL;
+static bool jobs_quit = false;
+
+static SDL_SpinLock jobs_commits_lock = 0;
+static std::vector<Job> jobs_commits;
+
+// Starts `workers` worker threads (in addition to main thread, which is the
+// calling one). Zero workers makes jobs run on the thread adding them.
+bool jobs_init(int workers)
+{
+    jobs_exit();
+
+    if (workers > JOBS_MAX_WORKERS) {
+        workers = JOBS_MAX_WORKERS;
+    }
+
+    jobs_suspended_workers = 0;
+
+    if (workers <= 0) {
+        return true;
+    }
+
+    if (!jobs_start(workers)) {
+        return false;
+    }
+
+    debug_printf("Job system: %d worker threads\n", jobs_workers);
+
+    return true;
+}
+
+// Runs jobs left in queues and pending commits, then stops worker threads.
+void jobs_exit()
+{
+    jobs_stop();
+    jobs_suspended_workers = 0;
+
+    jobs_process_commits();
+}
+
+int jobs_get_worker_count()
+{
+    return jobs_workers;
+}
+
+void jobs_group_init(JobGroup* group)
+{
+    SDL_AtomicSet(&(group->pending), 0);
+}
+
+// Adds job to group. Job may run on any thread, before this function
+// returns.
+void jobs_add(JobGroup* group, JobProc* proc, void* data)
+{
+    Job job;
+    job.proc = proc;
+    job.data = data;
+    job.group = group;
+
+    if (jobs_workers == 0) {
+        proc(data);
+        return;
+    }
+
+    SDL_AtomicAdd(&(group->pending), 1);
+
+    JobQueue* queue = &(jobs_queues[jobs_queue_index]);
+    SDL_AtomicLock(&(queue->lock));
+    queue->jobs.push_back(job);
+    SDL_AtomicUnlock(&(queue->lock));
+
+    SDL_AtomicAdd(&jobs_queued, 1);
+
+    SDL_LockMutex(jobs_mutex);
+    SDL_CondSignal(jobs_work_cond);
+    SDL_UnlockMutex(jobs_mutex);
+}
+
+// Waits until every job of group is finished, running queued jobs (of any
+// group) in the meantime.
+void jobs_wait(JobGroup* group)
+{
+    while (SDL_AtomicGet(&(group->pending)) > 0) {
+        Job job;
+        if (jobs_take(jobs_queue_index, &job)) {
+            jobs_run(&job);
+            continue;
+        }
+
+        SDL_LockMutex(jobs_mutex);
+        if (SDL_AtomicGet(&(group->pending)) > 0 && SDL_AtomicGet(&jobs_queued) == 0) {
+            SDL_CondWaitTimeout(jobs_done_cond, jobs_mutex, JOBS_WAIT_TIMEOUT);
+        }
+        SDL_UnlockMutex(jobs_mutex);
+    }
+}
+
+// Schedules `proc` to run on main thread at the next safe point (see
+// `jobs_process_commits`). Can be called from any thread.
+void jobs_commit(JobProc* proc, void* data)
+{
+    Job job;
+    job.proc = proc;
+    job.data = data;
+    job.group = NULL;
+
+    SDL_AtomicLock(&jobs_commits_lock);
+    jobs_commits.push_back(job);
+    SDL_AtomicUnlock(&jobs_commits_lock);
+}
+
+// Runs commits scheduled with `jobs_commit` in order they were made. Must be
+// called on main thread.
+void jobs_process_commits()
+{
+    std::vector<Job> commits;
+
+    SDL_AtomicLock(&jobs_commits_lock);
+    commits.swap(jobs_commits);
+    SDL_AtomicUnlock(&jobs_commits_lock);
+
+    for (Job& commit : commits) {
+        commit.proc(commit.data);
+    }
+}
+
+// Stops worker threads (for example before process is forked), jobs run on
+// the thread adding them until `jobs_resume`.
+void jobs_suspend()
+{
+    int workers = jobs_workers;
+    jobs_stop();
+    jobs_suspended_workers = workers;
+}
+
+void jobs_resume()
+{
+    if (jobs_suspended_workers != 0 && jobs_workers == 0) {
+        jobs_start(jobs_suspended_workers);
+    }
+
+    jobs_suspended_workers = 0;
+}
+
+static bool jobs_start(int workers)
+{
+    jobs_mutex = SDL_CreateMutex();
+    jobs_work_cond = SDL_CreateCond();
+    jobs_done_cond = SDL_CreateCond();
+    if (jobs_mutex == NULL || jobs_work_cond == NULL || jobs_done_cond == NULL) {
+        jobs_stop();
+        return false;
+    }
+
+    SDL_AtomicSet(&jobs_queued, 0);
+    jobs_quit = false;
+
+    for (int index = 0; index < workers; index++) {
+        jobs_threads[index] = SDL_CreateThread(jobs_thread, "jobs", (void*)(intptr_t)(index + 1));
+        if (jobs_threads[index] == NULL) {
+            break;
+        }
+        jobs_workers++;
+    }
+
+    if (jobs_workers == 0) {
+        jobs_stop();
+        return false;
+    }
+
+    return true;
+}
+
+static void jobs_stop()
+{
+    if (jobs_workers != 0) {
+        // Finish what is queued, groups may be waited for later.
+        Job job;
+        while (jobs_take(0, &job)) {
+            jobs_run(&job);
+        }
+
+        SDL_LockMutex(jobs_mutex);
+        jobs_quit = true;
+        SDL_CondBroadcast(jobs_work_cond);
+        SDL_UnlockMutex(jobs_mutex);
+
+        for (int index = 0; index < jobs_workers; index++) {
+            SDL_WaitThread(jobs_threads[index], NULL);
+            jobs_threads[index] = NULL;
+        }
+
+        jobs_workers = 0;
+    }
+
+    if (jobs_done_cond != NULL) {
+        SDL_DestroyCond(jobs_done_cond);
+        jobs_done_cond = NULL;
+    }
+
+    if (jobs_work_cond != NULL) {
+        SDL_DestroyCond(jobs_work_cond);
+        jobs_work_cond = NULL;
+    }
+
+    if (jobs_mutex != NULL) {
+        SDL_DestroyMutex(jobs_mutex);
+        jobs_mutex = NULL;
+    }
+}
+
+// Takes job from the back of own queue, or steals one from the front of
+// another queue.
+static bool jobs_take(int self, Job* job)
+{
+    if (SDL_AtomicGet(&jobs_queued) == 0) {
+        return false;
+    }
+
+    int count = jobs_workers + 1;
+    for (int offset = 0; offset < count; offset++) {
+        JobQueue* queue = &(jobs_queues[(self + offset) % count]);
+
+        SDL_AtomicLock(&(queue->lock));
+        bool taken = !queue->jobs.empty();
+        if (taken) {
+            if (offset == 0) {
+                *job = queue->jobs.back();
+                queue->jobs.pop_back();
+            } else {
+                *job = queue->jobs.front();
+                queue->jobs.pop_front();
+            }
+        }
+        SDL_AtomicUnlock(&(queue->lock));
+
+        if (taken) {
+            SDL_AtomicAdd(&jobs_queued, -1);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void jobs_run(Job* job)
+{
+    job->proc(job->data);
+
+    if (SDL_AtomicAdd(&(job->group->pending), -1) == 1) {
+        SDL_LockMutex(jobs_mutex);
+        SDL_CondBroadcast(jobs_done_cond);
+        SDL_UnlockMutex(jobs_mutex);
+    }
+}
+
+static int jobs_thread(void* data)
+{
+    jobs_queue_index = (int)(intptr_t)data;
+
+    while (true) {
+        Job job;
+        if (jobs_take(jobs_queue_index, &job)) {
+            jobs_run(&job);
+            continue;
+        }
+
+        SDL_LockMutex(jobs_mutex);
+        while (!jobs_quit && SDL_AtomicGet(&jobs_queued) == 0) {
+            SDL_CondWait(jobs_work_cond, jobs_mutex);
+        }
+        bool quit = jobs_quit && SDL_AtomicGet(&jobs_queued) == 0;
+        SDL_UnlockMutex(jobs_mutex);
+
+        if (quit) {
+            break;
+        }
+    }
+
+    return 0;
+}
+
+} // namespace fallout
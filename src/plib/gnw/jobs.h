@@ -0,0 +1,46 @@
+#ifndef FALLOUT_PLIB_GNW_JOBS_H_
+#define FALLOUT_PLIB_GNW_JOBS_H_
+
+#include <SDL.h>
+
+namespace fallout {
+
+// Job system shared by subsystems which need worker threads.
+//
+// Every worker thread (and main thread) has a queue of its own. Jobs are
+// added to the queue of the calling thread and taken from its back (last in,
+// first out), idle threads steal from the front of other queues. Jobs added
+// from threads outside of the pool go to the main thread's queue.
+//
+// Jobs are grouped with `JobGroup` and waited for with `jobs_wait`, which
+// runs queued jobs while waiting, so groups can be nested. Work which has to
+// touch game state is handed back to main thread with `jobs_commit` and runs
+// at the next safe point (see `process_bk`).
+//
+// Without worker threads (not initialized, configured to none, or suspended
+// with `jobs_suspend`) jobs run right away on the calling thread.
+
+#define JOBS_MAX_WORKERS 16
+
+typedef void(JobProc)(void* data);
+
+// Set of jobs which can be waited for.
+typedef struct JobGroup {
+    // Number of jobs added to group which have not finished yet.
+    SDL_atomic_t pending;
+} JobGroup;
+
+bool jobs_init(int workers);
+void jobs_exit();
+int jobs_get_worker_count();
+void jobs_group_init(JobGroup* group);
+void jobs_add(JobGroup* group, JobProc* proc, void* data);
+void jobs_wait(JobGroup* group);
+void jobs_commit(JobProc* proc, void* data);
+void jobs_process_commits();
+void jobs_suspend();
+void jobs_resume();
+
+} // namespace fallout
+
+#endif /* FALLOUT_PLIB_GNW_JOBS_H_ */
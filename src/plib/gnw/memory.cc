@@ -4,6 +4,8 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <atomic>
+
 #include "plib/gnw/debug.h"
 #include "plib/gnw/gnw.h"
 
@@ -16,12 +18,18 @@ namespace fallout {
 #define MEMORY_BLOCK_FOOTER_GUARD 0xBEEFCAFE
 
 // A header of a memory block.
-typedef struct MemoryBlockHeader {
+//
+// CE: Aligned to two words so that adding `tag` keeps data aligned the same
+// way as original header did (on 64 bit platforms it also keeps its size).
+typedef struct alignas(2 * sizeof(size_t)) MemoryBlockHeader {
     // Size of the memory block including header and footer.
     size_t size;
 
     // See `MEMORY_BLOCK_HEADER_GUARD`.
     int guard;
+
+    // CE: See `MemTag`.
+    int tag;
 } MemoryBlockHeader;
 
 // A footer of a memory block.
@@ -35,6 +43,33 @@ static void* my_realloc(void* ptr, size_t size);
 static void my_free(void* ptr);
 static void* mem_prep_block(void* block, size_t size);
 static void mem_check_block(void* block);
+static void mem_tag_account(int tag, long long size, int blocks);
+
+// CE: Allocation stats of one tag. Updated from every thread allocating
+// memory, hence atomics (relaxed, stats need no ordering).
+typedef struct MemTagCounters {
+    std::atomic<long long> size;
+    std::atomic<long long> peakSize;
+    std::atomic<int> blocks;
+    std::atomic<unsigned long long> allocations;
+    std::atomic<unsigned long long> operations;
+} MemTagCounters;
+
+static const char* mem_tag_names[MEM_TAG_COUNT] = {
+    "other",
+    "art",
+    "sound",
+    "script",
+    "map",
+    "ui",
+    "proto",
+    "db",
+    "combat",
+};
+
+static MemTagCounters mem_tag_counters[MEM_TAG_COUNT];
+
+static thread_local int mem_current_tag = MEM_TAG_OTHER;
 
 // 0x539D18
 static MallocFunc* p_malloc = my_malloc;
@@ -88,6 +123,9 @@ static void* my_malloc(size_t size)
             // NOTE: Uninline.
             ptr = mem_prep_block(block, size);
 
+            ((MemoryBlockHeader*)block)->tag = mem_current_tag;
+            mem_tag_account(mem_current_tag, (long long)size, 1);
+
             num_blocks++;
             if (num_blocks > max_blocks) {
                 max_blocks = num_blocks;
@@ -117,6 +155,7 @@ static void* my_realloc(void* ptr, size_t size)
 
         MemoryBlockHeader* header = (MemoryBlockHeader*)block;
         size_t oldSize = header->size;
+        int tag = header->tag;
 
         mem_allocated -= oldSize;
 
@@ -136,6 +175,10 @@ static void* my_realloc(void* ptr, size_t size)
 
             // NOTE: Uninline.
             ptr = mem_prep_block(newBlock, size);
+
+            // CE: Block stays with the tag it was allocated with.
+            ((MemoryBlockHeader*)newBlock)->tag = tag;
+            mem_tag_account(tag, (long long)size - (long long)oldSize, 0);
         } else {
             if (size != 0) {
                 mem_allocated += oldSize;
@@ -144,6 +187,7 @@ static void* my_realloc(void* ptr, size_t size)
                 debug_printf("Realloc failure.\n");
             } else {
                 num_blocks--;
+                mem_tag_account(tag, -(long long)oldSize, -1);
             }
             ptr = NULL;
         }
@@ -172,6 +216,8 @@ static void my_free(void* ptr)
         mem_allocated -= header->size;
         num_blocks--;
 
+        mem_tag_account(header->tag, -(long long)header->size, -1);
+
         free(block);
     }
 }
@@ -182,6 +228,18 @@ void mem_check()
     if (p_malloc == my_malloc) {
         debug_printf("Current memory allocated: %6d blocks, %9u bytes total\n", num_blocks, mem_allocated);
         debug_printf("Max memory allocated:     %6d blocks, %9u bytes total\n", max_blocks, max_allocated);
+
+        // CE: Breakdown by tag.
+        for (int tag = 0; tag < MEM_TAG_COUNT; tag++) {
+            MemTagStats stats;
+            mem_get_tag_stats(tag, &stats);
+            debug_printf("  %-8s %6u blocks, %9u bytes (peak %9u), %llu allocations\n",
+                mem_tag_names[tag],
+                stats.blocks,
+                (unsigned int)stats.size,
+                (unsigned int)stats.peakSize,
+                stats.allocations);
+        }
     }
 }
 
@@ -228,4 +286,87 @@ static void mem_check_block(void* block)
     }
 }
 
+static void mem_tag_account(int tag, long long size, int blocks)
+{
+    if (tag < 0 || tag >= MEM_TAG_COUNT) {
+        tag = MEM_TAG_OTHER;
+    }
+
+    MemTagCounters* counters = &(mem_tag_counters[tag]);
+    long long current = counters->size.fetch_add(size, std::memory_order_relaxed) + size;
+
+    if (blocks != 0) {
+        counters->blocks.fetch_add(blocks, std::memory_order_relaxed);
+        if (blocks > 0) {
+            counters->allocations.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    long long peak = counters->peakSize.load(std::memory_order_relaxed);
+    while (current > peak && !counters->peakSize.compare_exchange_weak(peak, current, std::memory_order_relaxed)) {
+    }
+}
+
+// CE: Selects tag for allocations made by calling thread, returns previous
+// one. See `MemTagScope`.
+int mem_set_tag(int tag)
+{
+    int prev = mem_current_tag;
+    mem_current_tag = tag >= 0 && tag < MEM_TAG_COUNT ? tag : MEM_TAG_OTHER;
+    return prev;
+}
+
+const char* mem_tag_name(int tag)
+{
+    if (tag < 0 || tag >= MEM_TAG_COUNT) {
+        return NULL;
+    }
+
+    return mem_tag_names[tag];
+}
+
+// CE: Only allocations made through default allocator are accounted (see
+// `mem_register_func`).
+bool mem_get_tag_stats(int tag, MemTagStats* stats)
+{
+    if (tag < 0 || tag >= MEM_TAG_COUNT || stats == NULL) {
+        return false;
+    }
+
+    MemTagCounters* counters = &(mem_tag_counters[tag]);
+    long long size = counters->size.load(std::memory_order_relaxed);
+    long long peakSize = counters->peakSize.load(std::memory_order_relaxed);
+    int blocks = counters->blocks.load(std::memory_order_relaxed);
+
+    stats->size = size > 0 ? (size_t)size : 0;
+    stats->peakSize = peakSize > 0 ? (size_t)peakSize : 0;
+    stats->blocks = blocks > 0 ? (unsigned int)blocks : 0;
+    stats->allocations = counters->allocations.load(std::memory_order_relaxed);
+    stats->operations = counters->operations.load(std::memory_order_relaxed);
+
+    return true;
+}
+
+// CE: Counts one operation of subsystem accounted to tag (see
+// `MemTagStats`).
+void mem_count_tag_operation(int tag)
+{
+    if (tag < 0 || tag >= MEM_TAG_COUNT) {
+        return;
+    }
+
+    mem_tag_counters[tag].operations.fetch_add(1, std::memory_order_relaxed);
+}
+
+// CE: Reports stats of every tag, used by debug overlay and external
+// tooling.
+void mem_visit_tag_stats(MemTagStatsProc* proc, void* userData)
+{
+    for (int tag = 0; tag < MEM_TAG_COUNT; tag++) {
+        MemTagStats stats;
+        mem_get_tag_stats(tag, &stats);
+        proc(tag, mem_tag_names[tag], &stats, userData);
+    }
+}
+
 } // namespace fallout
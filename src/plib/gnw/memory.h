@@ -5,6 +5,43 @@
 
 namespace fallout {
 
+// CE: Subsystems memory allocated with `mem_malloc` is accounted to. Current
+// tag is selected per thread with `MemTagScope`, block keeps tag it was
+// allocated with until it is freed.
+typedef enum MemTag {
+    MEM_TAG_OTHER,
+    MEM_TAG_ART,
+    MEM_TAG_SOUND,
+    MEM_TAG_SCRIPT,
+    MEM_TAG_MAP,
+    MEM_TAG_UI,
+    MEM_TAG_PROTO,
+    MEM_TAG_DB,
+    MEM_TAG_COMBAT,
+    MEM_TAG_COUNT,
+} MemTag;
+
+typedef struct MemTagStats {
+    // Bytes currently allocated (including block guards).
+    size_t size;
+
+    // Highest value of `size` so far.
+    size_t peakSize;
+
+    // Number of blocks currently allocated.
+    unsigned int blocks;
+
+    // Number of allocations made so far.
+    unsigned long long allocations;
+
+    // Number of operations (such as attacks) reported by subsystem with
+    // `mem_count_tag_operation`, allocations per operation can be derived
+    // from it.
+    unsigned long long operations;
+} MemTagStats;
+
+typedef void(MemTagStatsProc)(int tag, const char* name, const MemTagStats* stats, void* userData);
+
 typedef void*(MallocFunc)(size_t size);
 typedef void*(ReallocFunc)(void* ptr, size_t newSize);
 typedef void(FreeFunc)(void* ptr);
@@ -15,6 +52,32 @@ void* mem_realloc(void* ptr, size_t size);
 void mem_free(void* ptr);
 void mem_check();
 void mem_register_func(MallocFunc* mallocFunc, ReallocFunc* reallocFunc, FreeFunc* freeFunc);
+int mem_set_tag(int tag);
+const char* mem_tag_name(int tag);
+bool mem_get_tag_stats(int tag, MemTagStats* stats);
+void mem_count_tag_operation(int tag);
+void mem_visit_tag_stats(MemTagStatsProc* proc, void* userData);
+
+// CE: Accounts allocations made until the end of enclosing block to given
+// tag (innermost scope wins).
+class MemTagScope {
+public:
+    explicit MemTagScope(int tag)
+        : _prev(mem_set_tag(tag))
+    {
+    }
+
+    ~MemTagScope()
+    {
+        mem_set_tag(_prev);
+    }
+
+    MemTagScope(const MemTagScope&) = delete;
+    MemTagScope& operator=(const MemTagScope&) = delete;
+
+private:
+    int _prev;
+};
 
 } // namespace fallout
 
@@ -1,5 +1,7 @@
 #include "plib/gnw/mouse.h"
 
+#include <limits.h>
+
 #include "plib/color/color.h"
 #include "plib/gnw/dxinput.h"
 #include "plib/gnw/gnw.h"
@@ -90,6 +92,9 @@ static unsigned int mouse_speed;
 // 0x671F3C
 static int mouse_curr_frame;
 
+// 0x539DD8
+static unsigned int mouse_anim_ticker = 0;
+
 // 0x671F40
 static bool have_mouse;
 
@@ -309,11 +314,8 @@ int mouse_set_anim_frames(unsigned char* frames, int num_frames, int start_frame
 // 0x4B4B10
 static void mouse_anim()
 {
-    // 0x539DD8
-    static unsigned int ticker = 0;
-
-    if (elapsed_time(ticker) >= mouse_speed) {
-        ticker = get_time();
+    if (elapsed_time(mouse_anim_ticker) >= mouse_speed) {
+        mouse_anim_ticker = get_time();
 
         if (++mouse_curr_frame == mouse_num_frames) {
             mouse_curr_frame = 0;
@@ -327,6 +329,17 @@ static void mouse_anim()
     }
 }
 
+// CE: Returns number of milliseconds until next frame of animated cursor
+// (UINT_MAX if cursor is not animated).
+unsigned int mouse_anim_next_delay()
+{
+    if (mouse_fptr == NULL) {
+        return UINT_MAX;
+    }
+
+    return remaining_tocks(get_time(), mouse_anim_ticker, mouse_speed);
+}
+
 // 0x4B4B88
 void mouse_show()
 {
@@ -37,6 +37,7 @@ void mouse_get_shape(unsigned char** buf, int* width, int* length, int* full, in
 int mouse_set_shape(unsigned char* buf, int width, int length, int full, int hotx, int hoty, char trans);
 int mouse_get_anim(unsigned char** frames, int* num_frames, int* width, int* length, int* hotx, int* hoty, char* trans, int* speed);
 int mouse_set_anim_frames(unsigned char* frames, int num_frames, int start_frame, int width, int length, int hotx, int hoty, char trans, int speed);
+unsigned int mouse_anim_next_delay();
 void mouse_show();
 void mouse_hide();
 void mouse_info();
@@ -0,0 +1,539 @@
+#include "plib/gnw/prof.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "platform_compat.h"
+#include "plib/color/color.h"
+#include "plib/gnw/gnw.h"
+#include "plib/gnw/text.h"
+
+namespace fallout {
+
+// Default number of zone entries kept for Chrome trace (oldest are
+// overwritten).
+#define PROF_TRACE_CAPACITY 65536
+
+// Bounds of `prof_set_trace_capacity`.
+#define PROF_TRACE_MIN_CAPACITY 1024
+#define PROF_TRACE_MAX_CAPACITY (4 * 1024 * 1024)
+
+// Overlay is redrawn every that many frames.
+#define PROF_OVERLAY_INTERVAL 30
+
+#define PROF_OVERLAY_WIDTH 300
+
+typedef struct ProfTraceEvent {
+    int zone;
+    SDL_threadID thread;
+
+    // Index of frame the entry ended in.
+    unsigned int frame;
+
+    Uint64 start;
+    Uint64 end;
+
+    // Empty when zone entry has no label.
+    char label[PROF_LABEL_SIZE];
+} ProfTraceEvent;
+
+// Track of Chrome trace.
+typedef struct ProfTraceThread {
+    SDL_threadID thread;
+
+    // Zone of the first entry of thread, names the track of threads other
+    // than main one (workers have zones of their own).
+    int zone;
+} ProfTraceThread;
+
+static void prof_overlay_update();
+static int prof_histogram_bucket(unsigned int micros);
+static void prof_write_json_string(FILE* stream, const char* string);
+
+static const char* prof_zone_names[PROF_ZONE_COUNT] = {
+    "frame",
+    "process_bk",
+    "GNW95_process_message",
+    "object_animate",
+    "queue_process",
+    "updatePrograms",
+    "scripts_check_state",
+    "refresh_game",
+    "renderPresent",
+    "audio_callback",
+    "db_read",
+    "lzss_decode",
+    "art_load",
+    "script_procedure",
+    "tile_render",
+    "movie_decode",
+    "sound_decode",
+    "sfx_decode",
+    "db_prefetch",
+    "save_write",
+};
+
+// Checked by `ProfScope` before taking time, so disabled profiler costs a
+// branch per zone.
+bool prof_enabled = false;
+
+// Time spent in zones during current frame (in us) and number of entries,
+// updated from any thread.
+static SDL_atomic_t prof_frame_micros[PROF_ZONE_COUNT];
+static SDL_atomic_t prof_frame_calls[PROF_ZONE_COUNT];
+
+// Per-frame totals of last `PROF_HISTORY_SIZE` frames (in us).
+static unsigned int prof_history[PROF_ZONE_COUNT][PROF_HISTORY_SIZE];
+static unsigned int prof_histograms[PROF_ZONE_COUNT][PROF_HISTOGRAM_BUCKETS];
+static unsigned long long prof_calls[PROF_ZONE_COUNT];
+static unsigned int prof_frames = 0;
+
+static Uint64 prof_frequency = 0;
+static Uint64 prof_base = 0;
+static Uint64 prof_frame_start = 0;
+static SDL_threadID prof_main_thread = 0;
+
+// Specifies whether zone entries are kept for `prof_dump_chrome`, checked
+// before building labels which are only needed in trace.
+bool prof_tracing = false;
+
+static SDL_SpinLock prof_trace_lock = 0;
+static std::vector<ProfTraceEvent> prof_trace_events;
+static size_t prof_trace_next = 0;
+static size_t prof_trace_capacity = PROF_TRACE_CAPACITY;
+
+// State to restore when capture started with `prof_capture_start` ends.
+static bool prof_capture_active = false;
+static bool prof_capture_saved_enabled = false;
+static bool prof_capture_saved_tracing = false;
+
+static bool prof_overlay = false;
+static int prof_overlay_window = -1;
+
+// Starts or stops recording. Calling thread is considered main one (frames
+// are ended on it).
+void prof_set_enabled(bool enabled)
+{
+    if (enabled && !prof_enabled) {
+        prof_frequency = SDL_GetPerformanceFrequency();
+        prof_main_thread = SDL_ThreadID();
+        prof_reset();
+    }
+
+    prof_enabled = enabled;
+
+    if (!enabled) {
+        prof_set_overlay(false);
+    }
+}
+
+// Specifies whether zone entries are kept for `prof_dump_chrome`.
+void prof_set_trace(bool enabled)
+{
+    SDL_AtomicLock(&prof_trace_lock);
+    prof_tracing = enabled;
+    if (enabled) {
+        prof_trace_events.reserve(prof_trace_capacity);
+    }
+    SDL_AtomicUnlock(&prof_trace_lock);
+}
+
+// Sets number of zone entries kept for trace. Kept entries are discarded.
+void prof_set_trace_capacity(int capacity)
+{
+    capacity = std::max(capacity, PROF_TRACE_MIN_CAPACITY);
+    capacity = std::min(capacity, PROF_TRACE_MAX_CAPACITY);
+
+    SDL_AtomicLock(&prof_trace_lock);
+    prof_trace_capacity = (size_t)capacity;
+    prof_trace_events.clear();
+    prof_trace_events.shrink_to_fit();
+    prof_trace_next = 0;
+    if (prof_tracing) {
+        prof_trace_events.reserve(prof_trace_capacity);
+    }
+    SDL_AtomicUnlock(&prof_trace_lock);
+}
+
+// Starts recording trace from now on, regardless of whether profiler was
+// enabled. Returns `false` if capture is already in progress.
+bool prof_capture_start()
+{
+    if (prof_capture_active) {
+        return false;
+    }
+
+    prof_capture_saved_enabled = prof_enabled;
+    prof_capture_saved_tracing = prof_tracing;
+
+    if (!prof_enabled) {
+        prof_set_enabled(true);
+    }
+
+    SDL_AtomicLock(&prof_trace_lock);
+    prof_trace_events.clear();
+    prof_trace_next = 0;
+    SDL_AtomicUnlock(&prof_trace_lock);
+
+    prof_set_trace(true);
+
+    prof_capture_active = true;
+
+    return true;
+}
+
+// Ends capture started with `prof_capture_start`, writes it to `path` (see
+// `prof_dump_chrome`) and restores previous profiler state.
+int prof_capture_stop(const char* path)
+{
+    if (!prof_capture_active) {
+        return -1;
+    }
+
+    int rc = prof_dump_chrome(path);
+
+    prof_capture_active = false;
+
+    prof_set_trace(prof_capture_saved_tracing);
+
+    if (!prof_capture_saved_enabled) {
+        prof_set_enabled(false);
+    }
+
+    return rc;
+}
+
+bool prof_is_capturing()
+{
+    return prof_capture_active;
+}
+
+// Shows zone percentiles in the top-left corner of the screen.
+void prof_set_overlay(bool enabled)
+{
+    prof_overlay = enabled;
+
+    if (!enabled && prof_overlay_window != -1) {
+        win_delete(prof_overlay_window);
+        prof_overlay_window = -1;
+    }
+}
+
+void prof_reset()
+{
+    for (int zone = 0; zone < PROF_ZONE_COUNT; zone++) {
+        SDL_AtomicSet(&(prof_frame_micros[zone]), 0);
+        SDL_AtomicSet(&(prof_frame_calls[zone]), 0);
+    }
+
+    memset(prof_history, 0, sizeof(prof_history));
+    memset(prof_histograms, 0, sizeof(prof_histograms));
+    memset(prof_calls, 0, sizeof(prof_calls));
+    prof_frames = 0;
+
+    prof_base = SDL_GetPerformanceCounter();
+    prof_frame_start = prof_base;
+
+    SDL_AtomicLock(&prof_trace_lock);
+    prof_trace_events.clear();
+    prof_trace_next = 0;
+    SDL_AtomicUnlock(&prof_trace_lock);
+}
+
+// Adds zone entry, see `ProfScope`.
+void prof_record(int zone, Uint64 start, Uint64 end, const char* label)
+{
+    if (zone < 0 || zone >= PROF_ZONE_COUNT || prof_frequency == 0) {
+        return;
+    }
+
+    int micros = (int)((end - start) * 1000000 / prof_frequency);
+    SDL_AtomicAdd(&(prof_frame_micros[zone]), micros);
+    SDL_AtomicAdd(&(prof_frame_calls[zone]), 1);
+
+    if (prof_tracing) {
+        ProfTraceEvent event;
+        event.zone = zone;
+        event.thread = SDL_ThreadID();
+        event.frame = prof_frames;
+        event.start = start;
+        event.end = end;
+
+        if (label != NULL) {
+            strncpy(event.label, label, sizeof(event.label) - 1);
+            event.label[sizeof(event.label) - 1] = '\0';
+        } else {
+            event.label[0] = '\0';
+        }
+
+        SDL_AtomicLock(&prof_trace_lock);
+        if (prof_trace_events.size() < prof_trace_capacity) {
+            prof_trace_events.push_back(event);
+        } else {
+            prof_trace_events[prof_trace_next] = event;
+            prof_trace_next = (prof_trace_next + 1) % prof_trace_capacity;
+        }
+        SDL_AtomicUnlock(&prof_trace_lock);
+    }
+}
+
+static int prof_histogram_bucket(unsigned int micros)
+{
+    int bucket = 0;
+    while (micros != 0 && bucket < PROF_HISTOGRAM_BUCKETS - 1) {
+        micros >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+// Closes current frame. Called once per iteration of main loops (see
+// `FpsLimiter::mark`).
+void prof_end_frame()
+{
+    if (!prof_enabled) {
+        return;
+    }
+
+    Uint64 now = SDL_GetPerformanceCounter();
+    prof_record(PROF_ZONE_FRAME, prof_frame_start, now);
+    prof_frame_start = now;
+
+    int slot = prof_frames % PROF_HISTORY_SIZE;
+    for (int zone = 0; zone < PROF_ZONE_COUNT; zone++) {
+        unsigned int micros = (unsigned int)SDL_AtomicSet(&(prof_frame_micros[zone]), 0);
+        unsigned int calls = (unsigned int)SDL_AtomicSet(&(prof_frame_calls[zone]), 0);
+
+        prof_history[zone][slot] = micros;
+        prof_histograms[zone][prof_histogram_bucket(micros)]++;
+        prof_calls[zone] += calls;
+    }
+
+    prof_frames++;
+
+    if (prof_overlay && prof_frames % PROF_OVERLAY_INTERVAL == 0) {
+        prof_overlay_update();
+    }
+}
+
+const char* prof_zone_name(int zone)
+{
+    if (zone < 0 || zone >= PROF_ZONE_COUNT) {
+        return NULL;
+    }
+
+    return prof_zone_names[zone];
+}
+
+bool prof_get_zone_stats(int zone, ProfZoneStats* stats)
+{
+    if (zone < 0 || zone >= PROF_ZONE_COUNT || stats == NULL) {
+        return false;
+    }
+
+    memset(stats, 0, sizeof(*stats));
+
+    unsigned int count = std::min(prof_frames, (unsigned int)PROF_HISTORY_SIZE);
+    if (count != 0) {
+        unsigned int values[PROF_HISTORY_SIZE];
+        memcpy(values, prof_history[zone], sizeof(*values) * count);
+        std::sort(values, values + count);
+
+        unsigned long long total = 0;
+        for (unsigned int index = 0; index < count; index++) {
+            total += values[index];
+        }
+
+        stats->mean = (double)total / count / 1000.0;
+        stats->p50 = values[(count - 1) * 50 / 100] / 1000.0;
+        stats->p95 = values[(count - 1) * 95 / 100] / 1000.0;
+        stats->p99 = values[(count - 1) * 99 / 100] / 1000.0;
+        stats->max = values[count - 1] / 1000.0;
+    }
+
+    stats->calls = prof_calls[zone];
+    memcpy(stats->histogram, prof_histograms[zone], sizeof(stats->histogram));
+
+    return true;
+}
+
+unsigned int prof_get_frame_count()
+{
+    return prof_frames;
+}
+
+static void prof_overlay_update()
+{
+    if (!GNW_win_init_flag) {
+        return;
+    }
+
+    int lineHeight = text_height() + 1;
+    int height = lineHeight * (PROF_ZONE_COUNT + 1) + 4;
+
+    if (prof_overlay_window == -1) {
+        prof_overlay_window = win_add(0, 0, PROF_OVERLAY_WIDTH, height, colorTable[0], WINDOW_MOVE_ON_TOP);
+        if (prof_overlay_window == -1) {
+            prof_overlay = false;
+            return;
+        }
+    }
+
+    win_fill(prof_overlay_window, 0, 0, PROF_OVERLAY_WIDTH, height, colorTable[0]);
+
+    char line[80];
+    snprintf(line, sizeof(line), "%-22s %6s %6s %6s", "zone (ms)", "p50", "p95", "p99");
+    win_print(prof_overlay_window, line, 0, 2, 2, colorTable[32767]);
+
+    for (int zone = 0; zone < PROF_ZONE_COUNT; zone++) {
+        ProfZoneStats stats;
+        prof_get_zone_stats(zone, &stats);
+
+        snprintf(line, sizeof(line), "%-22.22s %6.2f %6.2f %6.2f", prof_zone_names[zone], stats.p50, stats.p95, stats.p99);
+        win_print(prof_overlay_window, line, 0, 2, 2 + lineHeight * (zone + 1), colorTable[992]);
+    }
+
+    win_draw(prof_overlay_window);
+}
+
+// Writes percentiles and histograms of every zone.
+int prof_dump_table(const char* path)
+{
+    FILE* stream = compat_fopen(path, "wt");
+    if (stream == NULL) {
+        return -1;
+    }
+
+    fprintf(stream, "%u frames\n\n", prof_frames);
+    fprintf(stream, "%-24s %10s %8s %8s %8s %8s %8s\n", "zone", "calls", "mean", "p50", "p95", "p99", "max");
+
+    for (int zone = 0; zone < PROF_ZONE_COUNT; zone++) {
+        ProfZoneStats stats;
+        prof_get_zone_stats(zone, &stats);
+        fprintf(stream, "%-24s %10llu %8.3f %8.3f %8.3f %8.3f %8.3f\n",
+            prof_zone_names[zone],
+            stats.calls,
+            stats.mean,
+            stats.p50,
+            stats.p95,
+            stats.p99,
+            stats.max);
+    }
+
+    fprintf(stream, "\nframes by time spent in zone (bucket is upper bound in us)\n");
+    fprintf(stream, "%-24s", "zone");
+    for (int bucket = 0; bucket < PROF_HISTOGRAM_BUCKETS - 1; bucket++) {
+        fprintf(stream, " %8u", 1u << bucket);
+    }
+    fprintf(stream, " %8s\n", "more");
+
+    for (int zone = 0; zone < PROF_ZONE_COUNT; zone++) {
+        fprintf(stream, "%-24s", prof_zone_names[zone]);
+        for (int bucket = 0; bucket < PROF_HISTOGRAM_BUCKETS; bucket++) {
+            fprintf(stream, " %8u", prof_histograms[zone][bucket]);
+        }
+        fprintf(stream, "\n");
+    }
+
+    fclose(stream);
+
+    return 0;
+}
+
+static void prof_write_json_string(FILE* stream, const char* string)
+{
+    fputc('"', stream);
+    for (const char* pch = string; *pch != '\0'; pch++) {
+        unsigned char ch = (unsigned char)*pch;
+        if (ch == '"' || ch == '\\') {
+            fputc('\\', stream);
+            fputc(ch, stream);
+        } else if (ch < 0x20) {
+            fprintf(stream, "\\u%04x", ch);
+        } else {
+            fputc(ch, stream);
+        }
+    }
+    fputc('"', stream);
+}
+
+// Writes kept zone entries in Chrome trace event format (load it in
+// chrome://tracing or Perfetto). Every thread gets track of its own: main
+// thread is the first one, others are named after zone they entered first
+// (audio callback, worker pools). Labeled entries are named after label,
+// with zone as category. Every entry carries index of frame it ended in.
+int prof_dump_chrome(const char* path)
+{
+    FILE* stream = compat_fopen(path, "wt");
+    if (stream == NULL) {
+        return -1;
+    }
+
+    SDL_AtomicLock(&prof_trace_lock);
+
+    fprintf(stream, "{\"traceEvents\":[\n");
+
+    std::vector<ProfTraceThread> threads;
+
+    ProfTraceThread mainThread;
+    mainThread.thread = prof_main_thread;
+    mainThread.zone = PROF_ZONE_FRAME;
+    threads.push_back(mainThread);
+
+    size_t count = prof_trace_events.size();
+    for (size_t index = 0; index < count; index++) {
+        // Oldest event is the next one to be overwritten.
+        const ProfTraceEvent* event = &(prof_trace_events[(prof_trace_next + index) % count]);
+
+        size_t tid = 0;
+        while (tid < threads.size() && threads[tid].thread != event->thread) {
+            tid++;
+        }
+
+        if (tid == threads.size()) {
+            ProfTraceThread thread;
+            thread.thread = event->thread;
+            thread.zone = event->zone;
+            threads.push_back(thread);
+        }
+
+        double start = (double)(event->start - prof_base) * 1000000.0 / (double)prof_frequency;
+        double duration = (double)(event->end - event->start) * 1000000.0 / (double)prof_frequency;
+
+        fprintf(stream, "%s{\"name\":", index != 0 ? "," : "");
+        if (event->label[0] != '\0') {
+            prof_write_json_string(stream, event->label);
+            fprintf(stream, ",\"cat\":\"%s\"", prof_zone_names[event->zone]);
+        } else {
+            fprintf(stream, "\"%s\",\"cat\":\"prof\"", prof_zone_names[event->zone]);
+        }
+        fprintf(stream, ",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%d,\"args\":{\"frame\":%u}}\n",
+            start,
+            duration,
+            (int)tid + 1,
+            event->frame);
+    }
+
+    for (size_t tid = 0; tid < threads.size(); tid++) {
+        fprintf(stream, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}\n",
+            count != 0 || tid != 0 ? "," : "",
+            (int)tid + 1,
+            tid == 0 ? "main" : prof_zone_names[threads[tid].zone]);
+        fprintf(stream, ",{\"name\":\"thread_sort_index\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"sort_index\":%d}}\n",
+            (int)tid + 1,
+            (int)tid);
+    }
+
+    fprintf(stream, "]}\n");
+
+    SDL_AtomicUnlock(&prof_trace_lock);
+
+    fclose(stream);
+
+    return 0;
+}
+
+} // namespace fallout
@@ -0,0 +1,120 @@
+#ifndef FALLOUT_PLIB_GNW_PROF_H_
+#define FALLOUT_PLIB_GNW_PROF_H_
+
+#include <SDL.h>
+
+namespace fallout {
+
+// Frame-time profiler.
+//
+// Code marks zones with `ProfScope`. Time spent in every zone is summed per
+// frame (frame ends with `prof_end_frame`) and kept for the last
+// `PROF_HISTORY_SIZE` frames, which percentiles are computed from. Zones may
+// be entered from any thread (audio callback and worker pools run on their
+// own ones).
+//
+// With trace enabled every zone entry is also kept in a bounded ring (oldest
+// entries are overwritten), which `prof_dump_chrome` writes in Chrome trace
+// format with one track per thread. Capture can be started and stopped at
+// runtime with `prof_capture_start`/`prof_capture_stop`.
+
+#define PROF_HISTORY_SIZE 512
+
+// Buckets of duration histogram, bucket `i` counts frames where zone took
+// [2^(i-1), 2^i) us (bucket 0 - less than 1 us, last one - everything
+// longer).
+#define PROF_HISTOGRAM_BUCKETS 24
+
+// Maximum length of zone entry label (including terminator), longer ones are
+// truncated.
+#define PROF_LABEL_SIZE 48
+
+typedef enum ProfZone {
+    PROF_ZONE_FRAME,
+    PROF_ZONE_PROCESS_BK,
+    PROF_ZONE_PROCESS_MESSAGE,
+    PROF_ZONE_OBJECT_ANIMATE,
+    PROF_ZONE_QUEUE_PROCESS,
+    PROF_ZONE_UPDATE_PROGRAMS,
+    PROF_ZONE_SCRIPTS_CHECK_STATE,
+    PROF_ZONE_REFRESH_GAME,
+    PROF_ZONE_RENDER_PRESENT,
+    PROF_ZONE_AUDIO_CALLBACK,
+    PROF_ZONE_DB_READ,
+    PROF_ZONE_LZSS_DECODE,
+    PROF_ZONE_ART_LOAD,
+    PROF_ZONE_SCRIPT_PROCEDURE,
+    PROF_ZONE_TILE_RENDER_WORKER,
+    PROF_ZONE_MOVIE_DECODE_WORKER,
+    PROF_ZONE_SOUND_DECODE_WORKER,
+    PROF_ZONE_SFX_DECODE_WORKER,
+    PROF_ZONE_DB_PREFETCH_WORKER,
+    PROF_ZONE_SAVE_WORKER,
+    PROF_ZONE_COUNT,
+} ProfZone;
+
+typedef struct ProfZoneStats {
+    // Over frames in history (in ms).
+    double mean;
+    double p50;
+    double p95;
+    double p99;
+    double max;
+
+    // Total number of entries into zone.
+    unsigned long long calls;
+
+    // Over all recorded frames.
+    unsigned int histogram[PROF_HISTOGRAM_BUCKETS];
+} ProfZoneStats;
+
+extern bool prof_enabled;
+extern bool prof_tracing;
+
+void prof_set_enabled(bool enabled);
+void prof_set_trace(bool enabled);
+void prof_set_trace_capacity(int capacity);
+bool prof_capture_start();
+int prof_capture_stop(const char* path);
+bool prof_is_capturing();
+void prof_set_overlay(bool enabled);
+void prof_reset();
+void prof_record(int zone, Uint64 start, Uint64 end, const char* label = NULL);
+void prof_end_frame();
+const char* prof_zone_name(int zone);
+bool prof_get_zone_stats(int zone, ProfZoneStats* stats);
+unsigned int prof_get_frame_count();
+int prof_dump_table(const char* path);
+int prof_dump_chrome(const char* path);
+
+// Measures time spent until the end of enclosing block. Optional `label`
+// (file name, script procedure, etc.) names the entry in trace, it must stay
+// valid until the end of the block.
+class ProfScope {
+public:
+    explicit ProfScope(int zone, const char* label = NULL)
+        : _zone(zone)
+        , _label(label)
+        , _start(prof_enabled ? SDL_GetPerformanceCounter() : 0)
+    {
+    }
+
+    ~ProfScope()
+    {
+        if (_start != 0 && prof_enabled) {
+            prof_record(_zone, _start, SDL_GetPerformanceCounter(), _label);
+        }
+    }
+
+    ProfScope(const ProfScope&) = delete;
+    ProfScope& operator=(const ProfScope&) = delete;
+
+private:
+    int _zone;
+    const char* _label;
+    Uint64 _start;
+};
+
+} // namespace fallout
+
+#endif /* FALLOUT_PLIB_GNW_PROF_H_ */
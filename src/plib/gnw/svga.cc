@@ -1,14 +1,29 @@
 #include "plib/gnw/svga.h"
 
+#include <string.h>
+
+#include <algorithm>
+
+#include "plib/gnw/debug.h"
 #include "plib/gnw/gnw.h"
 #include "plib/gnw/grbuf.h"
+#include "plib/gnw/input.h"
 #include "plib/gnw/mouse.h"
+#include "plib/gnw/prof.h"
 #include "plib/gnw/winmain.h"
 
 namespace fallout {
 
 static bool createRenderer(int width, int height);
 static void destroyRenderer();
+static void renderFlush();
+static int rectArea(const SDL_Rect* rect);
+static bool svga_init_headless(VideoOptions* video_options);
+static void renderAddDirtyRect(int x, int y, int width, int height);
+static void renderInvalidatePaletteEntries(int start, int count);
+static void renderMarkBandsStale(int y, int height);
+static bool renderEnsureScaleTexture();
+static void renderCopyScaled();
 
 // screen rect
 Rect scr_size;
@@ -25,6 +40,68 @@ SDL_Surface* gSdlTextureSurface = NULL;
 // TODO: Remove once migration to update-render cycle is completed.
 FpsLimiter sharedFpsLimiter;
 
+// CE: Maximum number of separate dirty rects kept per frame.
+#define DIRTY_RECTS_CAPACITY 32
+
+// CE: Minimum percentage of bounding box area covered by two dirty rects
+// for them to be merged into the bounding box.
+#define DIRTY_RECTS_MERGE_THRESHOLD 75
+
+// CE: Parts of `gSdlSurface` changed since last present (its contents or
+// palette). Conversion to `gSdlTextureSurface` and texture upload are deferred
+// until `renderPresent`, so they are done once per frame. Overlapping and
+// adjacent rects are merged when their bounding box is not much larger than
+// their union.
+static SDL_Rect gSdlDirtyRects[DIRTY_RECTS_CAPACITY];
+static int gSdlDirtyRectsLength = 0;
+
+// CE: Number of rects passed to `renderInvalidateRect` and number of rects
+// actually uploaded by `renderFlush`.
+static unsigned int gSdlDirtyRectsSubmitted = 0;
+static unsigned int gSdlDirtyRectsFlushed = 0;
+
+// CE: Specifies whether last present was skipped because nothing changed,
+// and total number of skipped presents.
+static bool gSdlPresentSkipped = false;
+static unsigned int gSdlPresentsSkipped = 0;
+
+// CE: Specifies whether screen is kept in memory only, without window and
+// renderer (only `gSdlSurface` is available).
+static bool gSdlHeadless = false;
+
+static FrameCaptureFunc* gSdlFrameCaptureFunc = NULL;
+
+// CE: Height of horizontal bands of `gSdlSurface` tracked by
+// `gSdlPaletteBands`.
+#define PALETTE_BAND_HEIGHT 16
+
+// CE: Set of palette indices used by pixels of a band. Used to only convert
+// bands affected by palette entry changes (color cycling changes a few
+// entries many times per second). Bands are rescanned lazily once their
+// contents change.
+typedef struct PaletteBand {
+    Uint32 used[256 / 32];
+    bool stale;
+} PaletteBand;
+
+static PaletteBand* gSdlPaletteBands = NULL;
+static int gSdlPaletteBandsLength = 0;
+
+// CE: Brightness of presented frame (0-255) applied by renderer as texture
+// color modulation, see `renderSetColorMod`. Set when it changed since last
+// present.
+static int gSdlColorMod = 255;
+static bool gSdlColorModChanged = false;
+
+// CE: Filtering of screen scaled to window, see `VideoScaleFilter`.
+static int gSdlScaleFilter = VIDEO_SCALE_FILTER_NEAREST;
+
+// CE: Render target holding screen upscaled by integer factor
+// `gSdlScaleTextureFactor` for sharp bilinear filter, created on first
+// present and whenever factor changes.
+static SDL_Texture* gSdlScaleTexture = NULL;
+static int gSdlScaleTextureFactor = 0;
+
 // 0x4CB310
 void GNW95_SetPaletteEntries(unsigned char* palette, int start, int count)
 {
@@ -41,7 +118,11 @@ void GNW95_SetPaletteEntries(unsigned char* palette, int start, int count)
         }
 
         SDL_SetPaletteColors(gSdlSurface->format->palette, colors, start, count);
-        SDL_BlitSurface(gSdlSurface, NULL, gSdlTextureSurface, NULL);
+
+        // CE: Conversion is deferred until present, fades and color cycling
+        // change palette many times per frame. Only parts of screen using
+        // changed entries are converted.
+        renderInvalidatePaletteEntries(start, count);
     }
 }
 
@@ -59,7 +140,7 @@ void GNW95_SetPalette(unsigned char* palette)
         }
 
         SDL_SetPaletteColors(gSdlSurface->format->palette, colors, 0, 256);
-        SDL_BlitSurface(gSdlSurface, NULL, gSdlTextureSurface, NULL);
+        renderAddDirtyRect(0, 0, gSdlSurface->w, gSdlSurface->h);
     }
 }
 
@@ -68,22 +149,21 @@ void GNW95_ShowRect(unsigned char* src, unsigned int srcPitch, unsigned int a3,
 {
     buf_to_buf(src + srcPitch * srcY + srcX, srcWidth, srcHeight, srcPitch, (unsigned char*)gSdlSurface->pixels + gSdlSurface->pitch * destY + destX, gSdlSurface->pitch);
 
-    SDL_Rect srcRect;
-    srcRect.x = destX;
-    srcRect.y = destY;
-    srcRect.w = srcWidth;
-    srcRect.h = srcHeight;
-
-    SDL_Rect destRect;
-    destRect.x = destX;
-    destRect.y = destY;
-    SDL_BlitSurface(gSdlSurface, &srcRect, gSdlTextureSurface, &destRect);
+    // CE: Only 8-bit surface is updated here, see `renderFlush`.
+    renderInvalidateRect(destX, destY, srcWidth, srcHeight);
 }
 
 bool svga_init(VideoOptions* video_options)
 {
+    gSdlHeadless = video_options->headless;
+    if (gSdlHeadless) {
+        return svga_init_headless(video_options);
+    }
+
     SDL_SetHint(SDL_HINT_RENDER_DRIVER, "opengl");
 
+    gSdlScaleFilter = video_options->scaleFilter;
+
     if (SDL_InitSubSystem(SDL_INIT_VIDEO) != 0) {
         return false;
     }
@@ -124,6 +204,8 @@ bool svga_init(VideoOptions* video_options)
 
         SDL_DestroyWindow(gSdlWindow);
         gSdlWindow = NULL;
+
+        return false;
     }
 
     SDL_Color colors[256];
@@ -150,6 +232,14 @@ bool svga_init(VideoOptions* video_options)
 
 void svga_exit()
 {
+    debug_printf("Screen: %u dirty rects submitted, %u uploaded, %u presents skipped\n", gSdlDirtyRectsSubmitted, gSdlDirtyRectsFlushed, gSdlPresentsSkipped);
+
+    if (gSdlPaletteBands != NULL) {
+        SDL_free(gSdlPaletteBands);
+        gSdlPaletteBands = NULL;
+        gSdlPaletteBandsLength = 0;
+    }
+
     destroyRenderer();
 
     if (gSdlWindow != NULL) {
@@ -157,9 +247,72 @@ void svga_exit()
         gSdlWindow = NULL;
     }
 
+    if (gSdlHeadless) {
+        if (gSdlSurface != NULL) {
+            SDL_FreeSurface(gSdlSurface);
+            gSdlSurface = NULL;
+        }
+
+        SDL_QuitSubSystem(SDL_INIT_EVENTS);
+        return;
+    }
+
     SDL_QuitSubSystem(SDL_INIT_VIDEO);
 }
 
+// CE: Sets up screen kept in memory only. No display is needed, input comes
+// from events pushed into SDL event queue.
+static bool svga_init_headless(VideoOptions* video_options)
+{
+    if (SDL_InitSubSystem(SDL_INIT_EVENTS) != 0) {
+        return false;
+    }
+
+    gSdlSurface = SDL_CreateRGBSurface(0,
+        video_options->width,
+        video_options->height,
+        8,
+        0,
+        0,
+        0,
+        0);
+    if (gSdlSurface == NULL) {
+        return false;
+    }
+
+    SDL_Color colors[256];
+    for (int index = 0; index < 256; index++) {
+        colors[index].r = index;
+        colors[index].g = index;
+        colors[index].b = index;
+        colors[index].a = 255;
+    }
+
+    SDL_SetPaletteColors(gSdlSurface->format->palette, colors, 0, 256);
+
+    scr_size.ulx = 0;
+    scr_size.uly = 0;
+    scr_size.lrx = video_options->width - 1;
+    scr_size.lry = video_options->height - 1;
+
+    mouse_blit_trans = NULL;
+    scr_blit = GNW95_ShowRect;
+    mouse_blit = GNW95_ShowRect;
+
+    return true;
+}
+
+bool svga_is_headless()
+{
+    return gSdlHeadless;
+}
+
+// CE: Sets function receiving presented frames (`NULL` disables capture).
+void svga_set_frame_capture_func(FrameCaptureFunc* func)
+{
+    gSdlFrameCaptureFunc = func;
+}
+
 int screenGetWidth()
 {
     // TODO: Make it on par with _xres;
@@ -183,11 +336,21 @@ static bool createRenderer(int width, int height)
         return false;
     }
 
+    // CE: Both integer modes need the picture to be on integer scale
+    // (sharp bilinear only in its first pass, see `renderCopyScaled`).
+    if (gSdlScaleFilter == VIDEO_SCALE_FILTER_INTEGER) {
+        SDL_RenderSetIntegerScale(gSdlRenderer, SDL_TRUE);
+    }
+
     gSdlTexture = SDL_CreateTexture(gSdlRenderer, SDL_PIXELFORMAT_RGB888, SDL_TEXTUREACCESS_STREAMING, width, height);
     if (gSdlTexture == NULL) {
         return false;
     }
 
+    SDL_SetTextureScaleMode(gSdlTexture, SDL_ScaleModeNearest);
+
+    SDL_SetTextureColorMod(gSdlTexture, gSdlColorMod, gSdlColorMod, gSdlColorMod);
+
     Uint32 format;
     if (SDL_QueryTexture(gSdlTexture, &format, NULL, NULL, NULL) != 0) {
         return false;
@@ -203,6 +366,12 @@ static bool createRenderer(int width, int height)
 
 static void destroyRenderer()
 {
+    if (gSdlScaleTexture != NULL) {
+        SDL_DestroyTexture(gSdlScaleTexture);
+        gSdlScaleTexture = NULL;
+        gSdlScaleTextureFactor = 0;
+    }
+
     if (gSdlTextureSurface != NULL) {
         SDL_FreeSurface(gSdlTextureSurface);
         gSdlTextureSurface = NULL;
@@ -223,14 +392,360 @@ void handleWindowSizeChanged()
 {
     destroyRenderer();
     createRenderer(screenGetWidth(), screenGetHeight());
+
+    // CE: New texture is blank.
+    if (gSdlSurface != NULL) {
+        renderInvalidateRect(0, 0, gSdlSurface->w, gSdlSurface->h);
+    }
+}
+
+// CE: Marks part of `gSdlSurface` to be converted and uploaded to texture on
+// next present. Must be called whenever pixels of `gSdlSurface` change.
+void renderInvalidateRect(int x, int y, int width, int height)
+{
+    if (width <= 0 || height <= 0) {
+        return;
+    }
+
+    renderMarkBandsStale(y, height);
+    renderAddDirtyRect(x, y, width, height);
+}
+
+// CE: Invalidates bands with pixels using palette entries `start` to
+// `start + count - 1`. Stale bands are rescanned first.
+static void renderInvalidatePaletteEntries(int start, int count)
+{
+    if (count <= 0) {
+        return;
+    }
+
+    // Nothing is converted without renderer, scanning would be a waste.
+    if (gSdlHeadless) {
+        renderAddDirtyRect(0, 0, gSdlSurface->w, gSdlSurface->h);
+        return;
+    }
+
+    if (gSdlPaletteBands == NULL) {
+        int length = (gSdlSurface->h + PALETTE_BAND_HEIGHT - 1) / PALETTE_BAND_HEIGHT;
+        gSdlPaletteBands = (PaletteBand*)SDL_malloc(sizeof(*gSdlPaletteBands) * length);
+        if (gSdlPaletteBands == NULL) {
+            renderAddDirtyRect(0, 0, gSdlSurface->w, gSdlSurface->h);
+            return;
+        }
+
+        gSdlPaletteBandsLength = length;
+        for (int index = 0; index < length; index++) {
+            gSdlPaletteBands[index].stale = true;
+        }
+    }
+
+    Uint32 changed[256 / 32];
+    memset(changed, 0, sizeof(changed));
+    for (int entry = start; entry < start + count && entry < 256; entry++) {
+        changed[entry / 32] |= 1u << (entry % 32);
+    }
+
+    // Adjacent affected bands are submitted as a single rect.
+    int runStart = -1;
+    for (int index = 0; index <= gSdlPaletteBandsLength; index++) {
+        bool affected = false;
+
+        if (index < gSdlPaletteBandsLength) {
+            PaletteBand* band = &(gSdlPaletteBands[index]);
+            int y = index * PALETTE_BAND_HEIGHT;
+            int height = std::min(PALETTE_BAND_HEIGHT, gSdlSurface->h - y);
+
+            if (band->stale) {
+                memset(band->used, 0, sizeof(band->used));
+
+                for (int row = 0; row < height; row++) {
+                    unsigned char* pixels = (unsigned char*)gSdlSurface->pixels + gSdlSurface->pitch * (y + row);
+                    for (int x = 0; x < gSdlSurface->w; x++) {
+                        band->used[pixels[x] / 32] |= 1u << (pixels[x] % 32);
+                    }
+                }
+
+                band->stale = false;
+            }
+
+            for (int word = 0; word < 256 / 32; word++) {
+                if ((band->used[word] & changed[word]) != 0) {
+                    affected = true;
+                    break;
+                }
+            }
+        }
+
+        if (affected) {
+            if (runStart == -1) {
+                runStart = index;
+            }
+        } else if (runStart != -1) {
+            int y = runStart * PALETTE_BAND_HEIGHT;
+            int height = std::min(index * PALETTE_BAND_HEIGHT, gSdlSurface->h) - y;
+            renderAddDirtyRect(0, y, gSdlSurface->w, height);
+            runStart = -1;
+        }
+    }
+}
+
+// CE: Marks bands overlapping given rows for rescanning.
+static void renderMarkBandsStale(int y, int height)
+{
+    if (gSdlPaletteBands == NULL) {
+        return;
+    }
+
+    int first = std::max(y, 0) / PALETTE_BAND_HEIGHT;
+    int last = std::min((y + height - 1) / PALETTE_BAND_HEIGHT, gSdlPaletteBandsLength - 1);
+    for (int index = first; index <= last; index++) {
+        gSdlPaletteBands[index].stale = true;
+    }
+}
+
+static void renderAddDirtyRect(int x, int y, int width, int height)
+{
+    if (width <= 0 || height <= 0) {
+        return;
+    }
+
+    gSdlDirtyRectsSubmitted++;
+
+    SDL_Rect rect;
+    rect.x = x;
+    rect.y = y;
+    rect.w = width;
+    rect.h = height;
+
+    // Merge with existing rects as long as merging is efficient, every merge
+    // grows the rect, so it's checked against all remaining rects again.
+    int index = 0;
+    while (index < gSdlDirtyRectsLength) {
+        SDL_Rect* dirtyRect = &(gSdlDirtyRects[index]);
+
+        SDL_Rect bounds;
+        SDL_UnionRect(dirtyRect, &rect, &bounds);
+
+        SDL_Rect overlap;
+        int overlapArea = SDL_IntersectRect(dirtyRect, &rect, &overlap) ? rectArea(&overlap) : 0;
+        int coveredArea = rectArea(dirtyRect) + rectArea(&rect) - overlapArea;
+
+        if ((long long)coveredArea * 100 >= (long long)rectArea(&bounds) * DIRTY_RECTS_MERGE_THRESHOLD) {
+            rect = bounds;
+            gSdlDirtyRects[index] = gSdlDirtyRects[--gSdlDirtyRectsLength];
+            index = 0;
+        } else {
+            index++;
+        }
+    }
+
+    if (gSdlDirtyRectsLength < DIRTY_RECTS_CAPACITY) {
+        gSdlDirtyRects[gSdlDirtyRectsLength++] = rect;
+        return;
+    }
+
+    // No room - merge into the rect which grows the least.
+    int best = 0;
+    int bestGrowth = 0;
+    for (index = 0; index < gSdlDirtyRectsLength; index++) {
+        SDL_Rect bounds;
+        SDL_UnionRect(&(gSdlDirtyRects[index]), &rect, &bounds);
+
+        int growth = rectArea(&bounds) - rectArea(&(gSdlDirtyRects[index]));
+        if (index == 0 || growth < bestGrowth) {
+            best = index;
+            bestGrowth = growth;
+        }
+    }
+
+    SDL_UnionRect(&(gSdlDirtyRects[best]), &rect, &(gSdlDirtyRects[best]));
+}
+
+// CE: Reports number of dirty rects submitted and uploaded so far.
+void renderGetDirtyRectStats(unsigned int* submittedPtr, unsigned int* flushedPtr)
+{
+    if (submittedPtr != NULL) {
+        *submittedPtr = gSdlDirtyRectsSubmitted;
+    }
+
+    if (flushedPtr != NULL) {
+        *flushedPtr = gSdlDirtyRectsFlushed;
+    }
+}
+
+// CE: Converts changed parts of `gSdlSurface` and uploads them to texture.
+static void renderFlush()
+{
+    if (gSdlDirtyRectsLength == 0) {
+        return;
+    }
+
+    SDL_Rect bounds;
+    bounds.x = 0;
+    bounds.y = 0;
+    bounds.w = gSdlSurface->w;
+    bounds.h = gSdlSurface->h;
+
+    for (int index = 0; index < gSdlDirtyRectsLength; index++) {
+        SDL_Rect rect;
+        if (!SDL_IntersectRect(&(gSdlDirtyRects[index]), &bounds, &rect)) {
+            continue;
+        }
+
+        SDL_Rect destRect = rect;
+        SDL_BlitSurface(gSdlSurface, &rect, gSdlTextureSurface, &destRect);
+
+        unsigned char* pixels = (unsigned char*)gSdlTextureSurface->pixels
+            + gSdlTextureSurface->pitch * rect.y
+            + gSdlTextureSurface->format->BytesPerPixel * rect.x;
+        SDL_UpdateTexture(gSdlTexture, &rect, pixels, gSdlTextureSurface->pitch);
+
+        gSdlDirtyRectsFlushed++;
+    }
+
+    gSdlDirtyRectsLength = 0;
+}
+
+static int rectArea(const SDL_Rect* rect)
+{
+    return rect->w * rect->h;
 }
 
 void renderPresent()
 {
-    SDL_UpdateTexture(gSdlTexture, NULL, gSdlTextureSurface->pixels, gSdlTextureSurface->pitch);
+    ProfScope profScope(PROF_ZONE_RENDER_PRESENT);
+
+    // CE: Turbo runs may opt out of presenting altogether. Dirty rects are
+    // dropped since headless screen has nothing to upload them to.
+    if (gSdlHeadless && turbo_skips_present()) {
+        gSdlDirtyRectsLength = 0;
+        return;
+    }
+
+    // CE: Capture sees skipped presents too (see `FrameCaptureFunc`).
+    if (gSdlFrameCaptureFunc != NULL) {
+        gSdlFrameCaptureFunc((unsigned char*)gSdlSurface->pixels,
+            gSdlSurface->w,
+            gSdlSurface->h,
+            gSdlSurface->pitch,
+            gSdlSurface->format->palette->colors);
+    }
+
+    // CE: Presenting the same frame again keeps GPU busy for nothing.
+    if (gSdlDirtyRectsLength == 0 && !gSdlColorModChanged) {
+        gSdlPresentSkipped = true;
+        gSdlPresentsSkipped++;
+        return;
+    }
+
+    gSdlPresentSkipped = false;
+    gSdlColorModChanged = false;
+
+    if (gSdlHeadless) {
+        gSdlDirtyRectsFlushed += gSdlDirtyRectsLength;
+        gSdlDirtyRectsLength = 0;
+        return;
+    }
+
+    renderFlush();
     SDL_RenderClear(gSdlRenderer);
-    SDL_RenderCopy(gSdlRenderer, gSdlTexture, NULL, NULL);
+    renderCopyScaled();
     SDL_RenderPresent(gSdlRenderer);
 }
 
+// CE: Makes sure `gSdlScaleTexture` matches largest integer scale of screen
+// fitting window. Returns `false` if sharp bilinear filter cannot be used
+// (window is smaller than screen, or renderer has no render targets).
+static bool renderEnsureScaleTexture()
+{
+    int outputWidth;
+    int outputHeight;
+    if (SDL_GetRendererOutputSize(gSdlRenderer, &outputWidth, &outputHeight) != 0) {
+        return false;
+    }
+
+    int factor = std::min(outputWidth / gSdlSurface->w, outputHeight / gSdlSurface->h);
+    if (factor <= 1) {
+        return false;
+    }
+
+    if (factor == gSdlScaleTextureFactor) {
+        return true;
+    }
+
+    if (gSdlScaleTexture != NULL) {
+        SDL_DestroyTexture(gSdlScaleTexture);
+        gSdlScaleTexture = NULL;
+        gSdlScaleTextureFactor = 0;
+    }
+
+    if (!SDL_RenderTargetSupported(gSdlRenderer)) {
+        return false;
+    }
+
+    gSdlScaleTexture = SDL_CreateTexture(gSdlRenderer,
+        SDL_PIXELFORMAT_RGB888,
+        SDL_TEXTUREACCESS_TARGET,
+        gSdlSurface->w * factor,
+        gSdlSurface->h * factor);
+    if (gSdlScaleTexture == NULL) {
+        debug_printf("svga: cannot create %dx scale texture: %s\n", factor, SDL_GetError());
+        return false;
+    }
+
+    SDL_SetTextureScaleMode(gSdlScaleTexture, SDL_ScaleModeLinear);
+    gSdlScaleTextureFactor = factor;
+
+    return true;
+}
+
+// CE: Draws screen texture to window with configured filter. Scaling happens
+// on GPU entirely, screen is converted and uploaded at its own resolution no
+// matter how large window is.
+static void renderCopyScaled()
+{
+    if (gSdlScaleFilter == VIDEO_SCALE_FILTER_SHARP_BILINEAR && renderEnsureScaleTexture()) {
+        // Logical size does not apply to render targets, screen fills scale
+        // texture exactly.
+        SDL_SetRenderTarget(gSdlRenderer, gSdlScaleTexture);
+        SDL_RenderCopy(gSdlRenderer, gSdlTexture, NULL, NULL);
+        SDL_SetRenderTarget(gSdlRenderer, NULL);
+        SDL_RenderCopy(gSdlRenderer, gSdlScaleTexture, NULL, NULL);
+        return;
+    }
+
+    SDL_RenderCopy(gSdlRenderer, gSdlTexture, NULL, NULL);
+}
+
+// CE: Returns `true` if screen did not change since last present.
+bool renderIsIdle()
+{
+    return gSdlPresentSkipped && gSdlDirtyRectsLength == 0 && !gSdlColorModChanged;
+}
+
+// CE: Returns `true` if brightness of presented frames can be changed with
+// `renderSetColorMod`. Not available without renderer, and when frames are
+// captured (capture sees 8-bit screen and its palette only).
+bool renderCanColorMod()
+{
+    return !gSdlHeadless && gSdlTexture != NULL && gSdlFrameCaptureFunc == NULL;
+}
+
+// CE: Scales colors of presented frames by `level / 255` on GPU, without
+// converting and uploading screen again. Takes effect on next present.
+void renderSetColorMod(int level)
+{
+    level = std::clamp(level, 0, 255);
+    if (level == gSdlColorMod) {
+        return;
+    }
+
+    gSdlColorMod = level;
+    gSdlColorModChanged = true;
+
+    if (gSdlTexture != NULL) {
+        SDL_SetTextureColorMod(gSdlTexture, level, level, level);
+    }
+}
+
 } // namespace fallout
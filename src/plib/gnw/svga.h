@@ -19,6 +19,11 @@ extern SDL_Texture* gSdlTexture;
 extern SDL_Surface* gSdlTextureSurface;
 extern FpsLimiter sharedFpsLimiter;
 
+// CE: Receives every presented frame (8-bit pixels and palette). Also called
+// when present is skipped because screen did not change, in which case
+// frame is the same as in previous call.
+typedef void(FrameCaptureFunc)(unsigned char* pixels, int width, int height, int pitch, const SDL_Color* palette);
+
 void GNW95_SetPaletteEntries(unsigned char* a1, int a2, int a3);
 void GNW95_SetPalette(unsigned char* palette);
 void GNW95_ShowRect(unsigned char* src, unsigned int src_pitch, unsigned int a3, unsigned int src_x, unsigned int src_y, unsigned int src_width, unsigned int src_height, unsigned int dest_x, unsigned int dest_y);
@@ -28,7 +33,14 @@ void svga_exit();
 int screenGetWidth();
 int screenGetHeight();
 void handleWindowSizeChanged();
+void renderInvalidateRect(int x, int y, int width, int height);
+void renderGetDirtyRectStats(unsigned int* submittedPtr, unsigned int* flushedPtr);
 void renderPresent();
+bool renderIsIdle();
+bool renderCanColorMod();
+void renderSetColorMod(int level);
+bool svga_is_headless();
+void svga_set_frame_capture_func(FrameCaptureFunc* func);
 
 } // namespace fallout
 
@@ -14,11 +14,32 @@ typedef int(SetModeFunc)();
 typedef void(ScreenTransBlitFunc)(unsigned char* srcBuf, unsigned int srcW, unsigned int srcH, unsigned int subX, unsigned int subY, unsigned int subW, unsigned int subH, unsigned int dstX, unsigned int dstY, unsigned char trans);
 typedef void(ScreenBlitFunc)(unsigned char* srcBuf, unsigned int srcW, unsigned int srcH, unsigned int subX, unsigned int subY, unsigned int subW, unsigned int subH, unsigned int dstX, unsigned int dstY);
 
+// CE: Filtering of screen when it is scaled to window.
+typedef enum VideoScaleFilter {
+    // Nearest neighbor, fills window (uneven pixels when scale is
+    // fractional).
+    VIDEO_SCALE_FILTER_NEAREST,
+
+    // Nearest neighbor at largest integer scale fitting window, rest of
+    // window is black.
+    VIDEO_SCALE_FILTER_INTEGER,
+
+    // Nearest neighbor to largest integer scale fitting window, then bilinear
+    // to fill window (sharp pixels without uneven rows and columns).
+    VIDEO_SCALE_FILTER_SHARP_BILINEAR,
+} VideoScaleFilter;
+
 typedef struct VideoOptions {
     int width;
     int height;
     bool fullscreen;
     int scale;
+
+    // CE: One of `VideoScaleFilter`.
+    int scaleFilter;
+
+    // CE: Keep screen in memory only (no window or renderer).
+    bool headless;
 } VideoOptions;
 
 } // namespace fallout
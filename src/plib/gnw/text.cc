@@ -16,7 +16,32 @@ namespace fallout {
 // The maximum number of font managers.
 #define FONT_MANAGER_MAX 10
 
+// CE: Horizontal run of set pixels of a glyph.
+typedef struct TextSpan {
+    unsigned short x;
+    unsigned short y;
+    unsigned short length;
+} TextSpan;
+
+// CE: Glyphs of a font pre-expanded from 1-bit bitmaps into spans, so drawing
+// fills runs of pixels instead of testing every bit, and advances of every
+// character, so measuring does not look up glyph info.
+typedef struct TextFontCache {
+    // Width plus spacing, 0 for characters not in the font.
+    int advance[256];
+
+    // Widest glyph plus spacing (see `GNW_text_max`).
+    int max;
+
+    // Spans of glyph `n` are `spans[spanIndex[n]]` to
+    // `spans[spanIndex[n + 1] - 1]`. NULL if font is drawn from bitmaps.
+    int* spanIndex;
+    TextSpan* spans;
+} TextFontCache;
+
 static int load_font(int n);
+static void text_cache_build(int n);
+static void text_cache_free(int n);
 static void GNW_text_font(int font_num);
 static bool text_font_exists(int font_num, FontMgrPtr* mgr);
 static void GNW_text_to_buf(unsigned char* buf, const char* str, int swidth, int fullw, int color);
@@ -67,6 +92,9 @@ static FontMgr font_managers[FONT_MANAGER_MAX];
 // 0x6AC118
 static Font* curr_font;
 
+static TextFontCache font_cache[TEXT_FONT_MAX];
+static TextFontCache* curr_font_cache;
+
 // 0x4C161C
 int GNW_text_init()
 {
@@ -120,6 +148,7 @@ void GNW_text_exit()
 
     for (i = 0; i < TEXT_FONT_MAX; i++) {
         if (font[i].num != 0) {
+            text_cache_free(i);
             mem_free(font[i].info);
             mem_free(font[i].data);
         }
@@ -180,6 +209,8 @@ static int load_font(int n)
 
     rc = 0;
 
+    text_cache_build(n);
+
 out:
 
     if (rc != 0) {
@@ -201,6 +232,113 @@ out:
     return rc;
 }
 
+// CE: Builds glyph cache of font `n`. Spans are optional: if they cannot be
+// allocated glyphs are drawn from bitmaps.
+static void text_cache_build(int n)
+{
+    Font* fnt = &(font[n]);
+    TextFontCache* cache = &(font_cache[n]);
+    int glyph;
+    int spansLength;
+    int index;
+
+    for (index = 0; index < 256; index++) {
+        if (index < fnt->num) {
+            cache->advance[index] = fnt->info[index].width + fnt->spacing;
+        } else {
+            cache->advance[index] = 0;
+        }
+    }
+
+    cache->max = 0;
+    for (glyph = 0; glyph < fnt->num; glyph++) {
+        if (cache->max < fnt->info[glyph].width) {
+            cache->max = fnt->info[glyph].width;
+        }
+    }
+    cache->max += fnt->spacing;
+
+    // Fonts without glyphs (or with more than char can address) keep
+    // original drawing.
+    cache->spanIndex = NULL;
+    cache->spans = NULL;
+    if (fnt->num <= 0 || fnt->num > 256) {
+        return;
+    }
+
+    // First pass counts spans, second one stores them.
+    spansLength = 0;
+    for (int pass = 0; pass < 2; pass++) {
+        if (pass == 1) {
+            cache->spanIndex = (int*)mem_malloc(sizeof(*cache->spanIndex) * (fnt->num + 1));
+            cache->spans = (TextSpan*)mem_malloc(sizeof(*cache->spans) * (spansLength > 0 ? spansLength : 1));
+            if (cache->spanIndex == NULL || cache->spans == NULL) {
+                text_cache_free(n);
+                return;
+            }
+        }
+
+        index = 0;
+        for (glyph = 0; glyph < fnt->num; glyph++) {
+            FontInfo* info = &(fnt->info[glyph]);
+            unsigned char* data = fnt->data + info->offset;
+            int pitch = (info->width + 7) >> 3;
+
+            if (pass == 1) {
+                cache->spanIndex[glyph] = index;
+            }
+
+            for (int y = 0; y < fnt->height; y++) {
+                int x = 0;
+                while (x < info->width) {
+                    while (x < info->width && (data[x >> 3] & (0x80 >> (x & 7))) == 0) {
+                        x++;
+                    }
+
+                    if (x == info->width) {
+                        break;
+                    }
+
+                    int start = x;
+                    while (x < info->width && (data[x >> 3] & (0x80 >> (x & 7))) != 0) {
+                        x++;
+                    }
+
+                    if (pass == 1) {
+                        TextSpan* span = &(cache->spans[index]);
+                        span->x = start;
+                        span->y = y;
+                        span->length = x - start;
+                    }
+                    index++;
+                }
+                data += pitch;
+            }
+        }
+
+        if (pass == 0) {
+            spansLength = index;
+        } else {
+            cache->spanIndex[fnt->num] = index;
+        }
+    }
+}
+
+static void text_cache_free(int n)
+{
+    TextFontCache* cache = &(font_cache[n]);
+
+    if (cache->spanIndex != NULL) {
+        mem_free(cache->spanIndex);
+        cache->spanIndex = NULL;
+    }
+
+    if (cache->spans != NULL) {
+        mem_free(cache->spans);
+        cache->spans = NULL;
+    }
+}
+
 // 0x4C1840
 int text_add_manager(FontMgrPtr mgr)
 {
@@ -261,6 +399,7 @@ static void GNW_text_font(int font_num)
     }
 
     curr_font = &(font[font_num]);
+    curr_font_cache = &(font_cache[font_num]);
 }
 
 // 0x4C1994
@@ -336,6 +475,18 @@ void GNW_text_to_buf(unsigned char* buf, const char* str, int swidth, int fullw,
                 break;
             }
 
+            // CE: Fill pre-expanded spans.
+            if (curr_font_cache->spans != NULL && (ch & 0xFF) < curr_font->num) {
+                TextSpan* span = &(curr_font_cache->spans[curr_font_cache->spanIndex[ch & 0xFF]]);
+                TextSpan* spanEnd = &(curr_font_cache->spans[curr_font_cache->spanIndex[(ch & 0xFF) + 1]]);
+                for (; span < spanEnd; span++) {
+                    memset(ptr + span->y * fullw + span->x, color & 0xFF, span->length);
+                }
+
+                ptr = end;
+                continue;
+            }
+
             unsigned char* glyphData = curr_font->data + glyph->offset;
             for (int y = 0; y < curr_font->height; y++) {
                 int bits = 0x80;
@@ -381,15 +532,12 @@ static int GNW_text_width(const char* str)
 {
     int i;
     int len;
-    FontInfo* fi;
 
     len = 0;
 
+    // CE: Sum cached advances.
     for (i = 0; str[i] != '\0'; i++) {
-        if (str[i] < curr_font->num) {
-            fi = &(curr_font->info[str[i]]);
-            len += curr_font->spacing + fi->width;
-        }
+        len += curr_font_cache->advance[str[i] & 0xFF];
     }
 
     return len;
@@ -422,20 +570,8 @@ static int GNW_text_size(const char* str)
 // 0x4C1CB8
 static int GNW_text_max()
 {
-    int i;
-    int len;
-    FontInfo* fi;
-
-    len = 0;
-
-    for (i = 0; i < curr_font->num; i++) {
-        fi = &(curr_font->info[i]);
-        if (len < fi->width) {
-            len = fi->width;
-        }
-    }
-
-    return len + curr_font->spacing;
+    // CE: Widest glyph is found once when font is loaded.
+    return curr_font_cache->max;
 }
 
 } // namespace fallout
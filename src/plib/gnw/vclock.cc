@@ -0,0 +1,159 @@
+#include "plib/gnw/vclock.h"
+
+#include <SDL.h>
+
+namespace fallout {
+
+// Number of reads in stepped mode after which clock moves by one tock on its
+// own. Busy-wait loops poll clock until it passes deadline, this lets them
+// complete.
+#define VCLOCK_SPIN_READS 16
+
+static void vclock_rebase();
+
+static VClockMode vclock_mode = VCLOCK_MODE_REAL;
+
+// Multiplier applied to wall time in `VCLOCK_MODE_SCALED`.
+static double vclock_scale = 1.0;
+
+// Specifies whether `vclock_wait_frame` steps clock by frame duration in
+// `VCLOCK_MODE_STEPPED`. When disabled only explicit steps move the clock.
+static bool vclock_frame_step = true;
+
+// Clock value and wall time at the moment of last mode or scale change. Clock
+// continues from where it was, so timestamps taken in one mode stay valid in
+// another.
+static unsigned int vclock_base = 0;
+static unsigned int vclock_real_base = 0;
+
+// Clock value in `VCLOCK_MODE_STEPPED`.
+static unsigned int vclock_stepped_time = 0;
+
+// Number of reads since clock last moved in `VCLOCK_MODE_STEPPED`.
+static unsigned int vclock_spin_reads = 0;
+
+// Stores current clock value as base for new mode or scale.
+static void vclock_rebase()
+{
+    unsigned int now = vclock_now();
+    vclock_base = now;
+    vclock_real_base = SDL_GetTicks();
+    vclock_stepped_time = now;
+    vclock_spin_reads = 0;
+}
+
+void vclock_set_mode(VClockMode mode)
+{
+    if (mode == vclock_mode) {
+        return;
+    }
+
+    vclock_rebase();
+    vclock_mode = mode;
+}
+
+VClockMode vclock_get_mode()
+{
+    return vclock_mode;
+}
+
+void vclock_set_scale(double scale)
+{
+    if (scale <= 0.0) {
+        return;
+    }
+
+    vclock_rebase();
+    vclock_scale = scale;
+}
+
+double vclock_get_scale()
+{
+    return vclock_scale;
+}
+
+void vclock_set_frame_step(bool enabled)
+{
+    vclock_frame_step = enabled;
+}
+
+bool vclock_get_frame_step()
+{
+    return vclock_frame_step;
+}
+
+// Returns current clock value in ms.
+unsigned int vclock_now()
+{
+    switch (vclock_mode) {
+    case VCLOCK_MODE_SCALED:
+        return vclock_base + static_cast<unsigned int>((SDL_GetTicks() - vclock_real_base) * vclock_scale);
+    case VCLOCK_MODE_STEPPED:
+        if (++vclock_spin_reads >= VCLOCK_SPIN_READS) {
+            vclock_step(1);
+        }
+        return vclock_stepped_time;
+    default:
+        return vclock_base + (SDL_GetTicks() - vclock_real_base);
+    }
+}
+
+// Returns current clock value without counting as a read in stepped mode.
+// Used by observers which follow the clock without waiting on it, so that
+// they do not move stepped clock on their own.
+unsigned int vclock_peek()
+{
+    if (vclock_mode == VCLOCK_MODE_STEPPED) {
+        return vclock_stepped_time;
+    }
+
+    return vclock_now();
+}
+
+// Moves clock forward. Does nothing unless clock is stepped.
+void vclock_step(unsigned int ms)
+{
+    if (vclock_mode != VCLOCK_MODE_STEPPED) {
+        return;
+    }
+
+    vclock_stepped_time += ms;
+    vclock_spin_reads = 0;
+}
+
+// Lets given amount of clock time pass. In stepped mode clock is moved
+// instead of waiting.
+void vclock_sleep(unsigned int ms)
+{
+    switch (vclock_mode) {
+    case VCLOCK_MODE_SCALED:
+        SDL_Delay(static_cast<Uint32>(ms / vclock_scale));
+        break;
+    case VCLOCK_MODE_STEPPED:
+        vclock_step(ms);
+        break;
+    default:
+        SDL_Delay(ms);
+        break;
+    }
+}
+
+// Waits until frame which started at `start` took `duration` of clock time.
+// In stepped mode frame takes exactly `duration` (or nothing if frame stepping
+// is disabled).
+void vclock_wait_frame(unsigned int start, unsigned int duration)
+{
+    if (vclock_mode == VCLOCK_MODE_STEPPED) {
+        if (vclock_frame_step) {
+            vclock_step(duration);
+        }
+        return;
+    }
+
+    unsigned int elapsed = vclock_now() - start;
+    if (elapsed < duration) {
+        vclock_sleep(duration - elapsed);
+    }
+}
+
+} // namespace fallout
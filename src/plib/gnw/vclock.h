@@ -0,0 +1,31 @@
+#ifndef FALLOUT_PLIB_GNW_VCLOCK_H_
+#define FALLOUT_PLIB_GNW_VCLOCK_H_
+
+namespace fallout {
+
+typedef enum VClockMode {
+    // Follows wall clock.
+    VCLOCK_MODE_REAL,
+
+    // Follows wall clock multiplied by scale (see `vclock_set_scale`).
+    VCLOCK_MODE_SCALED,
+
+    // Moves only when stepped (see `vclock_step`), waits return immediately.
+    VCLOCK_MODE_STEPPED,
+} VClockMode;
+
+void vclock_set_mode(VClockMode mode);
+VClockMode vclock_get_mode();
+void vclock_set_scale(double scale);
+double vclock_get_scale();
+void vclock_set_frame_step(bool enabled);
+bool vclock_get_frame_step();
+unsigned int vclock_now();
+unsigned int vclock_peek();
+void vclock_step(unsigned int ms);
+void vclock_sleep(unsigned int ms);
+void vclock_wait_frame(unsigned int start, unsigned int duration);
+
+} // namespace fallout
+
+#endif /* FALLOUT_PLIB_GNW_VCLOCK_H_ */
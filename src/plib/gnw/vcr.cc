@@ -4,6 +4,7 @@
 
 #include "plib/gnw/input.h"
 #include "plib/gnw/memory.h"
+#include "plib/gnw/vclock.h"
 
 namespace fallout {
 
@@ -225,7 +226,17 @@ int vcr_update()
                         * (vcrEntry->time - vcr_last_play_event.time)
                         / (vcrEntry->counter - vcr_last_play_event.counter);
 
-                    while (elapsed_time(vcr_start_time) < delay) {
+                    // CE: On stepped clock (turbo mode) busy-waiting would
+                    // only move time one spin at a time, jump right to the
+                    // event instead.
+                    if (vclock_get_mode() == VCLOCK_MODE_STEPPED) {
+                        unsigned int elapsed = elapsed_time(vcr_start_time);
+                        if (elapsed < delay) {
+                            vclock_step(delay - elapsed);
+                        }
+                    } else {
+                        while (elapsed_time(vcr_start_time) < delay) {
+                        }
                     }
                 }
             }
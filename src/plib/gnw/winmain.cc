@@ -72,7 +72,10 @@ int main(int argc, char* argv[])
 
 } // namespace fallout
 
+// CE: Tools linking game sources provide their own entry point.
+#ifndef FALLOUT_CUSTOM_MAIN
 int main(int argc, char* argv[])
 {
     return fallout::main(argc, argv);
 }
+#endif
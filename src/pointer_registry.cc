@@ -1,7 +1,15 @@
 #include "pointer_registry.h"
 
+#include <stddef.h>
+
 namespace fallout {
 
+// Low bits of handle are slot index, high bits (except sign bit) are slot
+// generation.
+#define POINTER_REGISTRY_INDEX_BITS 24
+#define POINTER_REGISTRY_INDEX_MASK ((1 << POINTER_REGISTRY_INDEX_BITS) - 1)
+#define POINTER_REGISTRY_GENERATION_MASK 0x7F
+
 PointerRegistry* PointerRegistry::shared()
 {
     static PointerRegistry* shared = new PointerRegistry();
@@ -10,24 +18,56 @@ PointerRegistry* PointerRegistry::shared()
 
 PointerRegistry::PointerRegistry()
 {
-    // 0 is reserved for nullptr, so start with 1.
-    _next = 1;
+    _freeHead = -1;
 }
 
 int PointerRegistry::store(void* ptr)
 {
     if (ptr == nullptr) return 0;
-    int ref = _next++;
-    _map[ref] = ptr;
-    return ref;
+
+    int index;
+    if (_freeHead != -1) {
+        index = _freeHead;
+        _freeHead = _slots[index].nextFree;
+    } else {
+        if (_slots.size() > POINTER_REGISTRY_INDEX_MASK) {
+            return 0;
+        }
+
+        index = static_cast<int>(_slots.size());
+
+        // Generation is never 0, so that handle of slot 0 is not confused
+        // with nullptr.
+        _slots.push_back({ nullptr, 1, -1 });
+    }
+
+    Slot& slot = _slots[index];
+    slot.ptr = ptr;
+    slot.nextFree = -1;
+
+    return (slot.generation << POINTER_REGISTRY_INDEX_BITS) | index;
 }
 
 void* PointerRegistry::fetch(int ref, bool remove)
 {
-    if (ref == 0) return nullptr;
-    void* ptr = _map[ref];
+    if (ref <= 0) return nullptr;
+
+    size_t index = static_cast<size_t>(ref & POINTER_REGISTRY_INDEX_MASK);
+    int generation = (ref >> POINTER_REGISTRY_INDEX_BITS) & POINTER_REGISTRY_GENERATION_MASK;
+    if (index >= _slots.size()) return nullptr;
+
+    Slot& slot = _slots[index];
+    if (slot.generation != generation || slot.ptr == nullptr) return nullptr;
+
+    void* ptr = slot.ptr;
     if (remove) {
-        _map.erase(ref);
+        slot.ptr = nullptr;
+
+        // Bump generation to invalidate outstanding handles, skipping 0.
+        slot.generation = (slot.generation % POINTER_REGISTRY_GENERATION_MASK) + 1;
+
+        slot.nextFree = _freeHead;
+        _freeHead = static_cast<int>(index);
     }
     return ptr;
 }
@@ -1,10 +1,16 @@
 #ifndef FALLOUT_POINTER_REGISTRY_H_
 #define FALLOUT_POINTER_REGISTRY_H_
 
-#include <unordered_map>
+#include <vector>
 
 namespace fallout {
 
+// Maps pointers to int handles (for APIs passing handles as int).
+//
+// Handles are slot indexes combined with slot generation, so lookups are
+// plain array accesses, freed slots are reused, and handles of removed
+// pointers are detected as stale instead of aliasing newer pointers. Handle
+// 0 always represents nullptr, valid handles are always positive.
 class PointerRegistry {
 public:
     static PointerRegistry* shared();
@@ -15,8 +21,14 @@ public:
     void* fetch(int ref, bool remove = false);
 
 private:
-    std::unordered_map<int, void*> _map;
-    int _next;
+    struct Slot {
+        void* ptr;
+        int generation;
+        int nextFree;
+    };
+
+    std::vector<Slot> _slots;
+    int _freeHead;
 };
 
 int ptrToInt(void* ptr);
@@ -0,0 +1,318 @@
+// Measures combat throughput with scripted battles.
+//
+// Game is initialized without display and map is loaded. Every battle spawns
+// groups of critters given on command line next to each other, each group is
+// a team engaging the others. Player is knocked out and moved away, so the
+// whole battle is decided by combat AI. Battles run in fast mode (see
+// `combat_set_fast_mode`) with seeded random numbers until requested number
+// of rounds is played; battle that ends early (one team is wiped out) is
+// followed by a fresh one.
+//
+// Reported are turns per second, time spent in combat AI, and path and hit
+// chance queries per turn. Results are printed as JSON to stdout. Run from
+// game directory (where `master.dat` and `critter.dat` are).
+//
+// Critters placed on the map itself take part too if they decide to join.
+//
+// Usage: combatbench rounds seed map.map team:pid:ai_packet:count ...
+//
+// Pids may be given in hex (`0x...`).
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <vector>
+
+#include "game/anim.h"
+#include "game/combat.h"
+#include "game/game.h"
+#include "game/map.h"
+#include "game/object.h"
+#include "game/roll.h"
+#include "game/tile.h"
+#include "plib/gnw/winmain.h"
+
+namespace fallout {
+
+// Distance (in hexes) between center of the map and each group.
+#define BENCH_GROUP_DISTANCE 4
+
+// Distance (in hexes) player is moved away from the battle.
+#define BENCH_DUDE_DISTANCE 40
+
+// Maximum distance from group position searched for open tiles.
+#define BENCH_SPAWN_RADIUS 8
+
+// Stops benchmark if battles keep ending without a single round (all
+// critters failed to spawn or nobody wants to fight).
+#define BENCH_MAX_EMPTY_BATTLES 4
+
+typedef struct BenchGroup {
+    int team;
+    int pid;
+    int aiPacket;
+    int count;
+} BenchGroup;
+
+static bool parseGroup(const char* spec, BenchGroup* group)
+{
+    char* end;
+
+    group->team = (int)strtol(spec, &end, 0);
+    if (*end != ':') {
+        return false;
+    }
+
+    group->pid = (int)strtol(end + 1, &end, 0);
+    if (*end != ':') {
+        return false;
+    }
+
+    group->aiPacket = (int)strtol(end + 1, &end, 0);
+    if (*end != ':') {
+        return false;
+    }
+
+    group->count = (int)strtol(end + 1, &end, 0);
+    if (*end != '\0' || group->count <= 0) {
+        return false;
+    }
+
+    return true;
+}
+
+static int openTileNear(int tile, int elevation)
+{
+    if (obj_blocking_at(NULL, tile, elevation) == NULL) {
+        return tile;
+    }
+
+    for (int distance = 1; distance <= BENCH_SPAWN_RADIUS; distance++) {
+        for (int rotation = 0; rotation < ROTATION_COUNT; rotation++) {
+            int candidate = tile_num_in_direction(tile, rotation, distance);
+            if (candidate != -1 && obj_blocking_at(NULL, candidate, elevation) == NULL) {
+                return candidate;
+            }
+        }
+    }
+
+    return -1;
+}
+
+static void spawnGroups(std::vector<BenchGroup>& groups, int center, int elevation, std::vector<Object*>& critters, std::vector<Object*>& leaders)
+{
+    for (size_t index = 0; index < groups.size(); index++) {
+        BenchGroup* group = &(groups[index]);
+
+        // Spread groups around the center, so they face each other.
+        int rotation = (int)(index * ROTATION_COUNT / groups.size());
+        int position = tile_num_in_direction(center, rotation, BENCH_GROUP_DISTANCE);
+        if (position == -1) {
+            position = center;
+        }
+
+        Object* leader = NULL;
+        for (int count = 0; count < group->count; count++) {
+            int tile = openTileNear(position, elevation);
+            if (tile == -1) {
+                break;
+            }
+
+            Object* critter;
+            if (obj_pid_new(&critter, group->pid) == -1) {
+                break;
+            }
+
+            critter->data.critter.combat.team = group->team;
+            critter->data.critter.combat.aiPacket = group->aiPacket;
+            critter->data.critter.combat.maneuver |= CRITTER_MANEUVER_ENGAGING;
+            obj_move_to_tile(critter, tile, elevation, NULL);
+
+            critters.push_back(critter);
+            if (leader == NULL) {
+                leader = critter;
+            }
+        }
+
+        leaders.push_back(leader);
+    }
+}
+
+static void removeCritters(std::vector<Object*>& critters)
+{
+    for (Object* critter : critters) {
+        obj_erase_object(critter, NULL);
+    }
+
+    critters.clear();
+}
+
+static int bench(int rounds, unsigned int seed, const char* mapName, std::vector<BenchGroup>& groups)
+{
+    game_force_headless(true);
+
+    char executable[] = "combatbench";
+    char* args[] = { executable, NULL };
+    if (game_init("FALLOUT", false, 0, 0, 1, args) == -1) {
+        fprintf(stderr, "Could not initialize game\n");
+        return EXIT_FAILURE;
+    }
+
+    GNW95_isActive = true;
+
+    char path[64];
+    snprintf(path, sizeof(path), "%s", mapName);
+    if (map_load(path) != 0) {
+        fprintf(stderr, "Could not load %s\n", mapName);
+        game_exit();
+        return EXIT_FAILURE;
+    }
+
+    combat_set_fast_mode(true);
+
+    int elevation = obj_dude->elevation;
+    int center = obj_dude->tile;
+
+    int dudeTile = tile_num_in_direction(center, ROTATION_SW, BENCH_DUDE_DISTANCE);
+    if (dudeTile != -1) {
+        dudeTile = openTileNear(dudeTile, elevation);
+    }
+    if (dudeTile != -1) {
+        obj_move_to_tile(obj_dude, dudeTile, elevation, NULL);
+    }
+
+    int spawned = 0;
+    int battles = 0;
+    int emptyBattles = 0;
+    double wallTime = 0.0;
+    CombatStats total;
+    memset(&total, 0, sizeof(total));
+
+    unsigned int paths = anim_path_requests();
+    unsigned int nodes = anim_path_nodes_expanded();
+
+    while ((int)total.rounds < rounds && emptyBattles < BENCH_MAX_EMPTY_BATTLES) {
+        // Reseed per battle so every battle is reproducible on its own.
+        roll_seed_streams((unsigned long long)seed + (unsigned long long)battles);
+
+        std::vector<Object*> critters;
+        std::vector<Object*> leaders;
+        spawnGroups(groups, center, elevation, critters, leaders);
+        spawned += (int)critters.size();
+
+        if (leaders.size() < 2 || leaders[0] == NULL || leaders[1] == NULL) {
+            removeCritters(critters);
+            emptyBattles++;
+            battles++;
+            continue;
+        }
+
+        obj_dude->data.critter.combat.results |= DAM_KNOCKED_OUT;
+
+        STRUCT_664980 attack;
+        memset(&attack, 0, sizeof(attack));
+        attack.attacker = leaders[0];
+        attack.defender = leaders[1];
+
+        combat_set_round_limit(rounds - (int)total.rounds);
+        combat_reset_stats();
+
+        auto battleStart = std::chrono::steady_clock::now();
+        combat(&attack);
+        auto battleEnd = std::chrono::steady_clock::now();
+        wallTime += std::chrono::duration<double>(battleEnd - battleStart).count();
+
+        CombatStats stats;
+        combat_get_stats(&stats);
+        total.rounds += stats.rounds;
+        total.turns += stats.turns;
+        total.aiTurns += stats.aiTurns;
+        total.aiTime += stats.aiTime;
+        total.toHitQueries += stats.toHitQueries;
+
+        if (stats.rounds == 0) {
+            emptyBattles++;
+        }
+
+        removeCritters(critters);
+        obj_dude->data.critter.combat.results &= ~DAM_KNOCKED_OUT;
+
+        battles++;
+    }
+
+    combat_set_round_limit(0);
+
+    paths = anim_path_requests() - paths;
+    nodes = anim_path_nodes_expanded() - nodes;
+
+    double turns = total.turns != 0 ? (double)total.turns : 1.0;
+
+    printf("{\n");
+    printf("  \"map\": \"%s\",\n", mapName);
+    printf("  \"seed\": %u,\n", seed);
+    printf("  \"groups\": [\n");
+    for (size_t index = 0; index < groups.size(); index++) {
+        BenchGroup* group = &(groups[index]);
+        printf("    {\"team\": %d, \"pid\": %d, \"ai_packet\": %d, \"count\": %d}%s\n",
+            group->team,
+            group->pid,
+            group->aiPacket,
+            group->count,
+            index + 1 < groups.size() ? "," : "");
+    }
+    printf("  ],\n");
+    printf("  \"battles\": %d,\n", battles);
+    printf("  \"critters_spawned\": %d,\n", spawned);
+    printf("  \"rounds\": %u,\n", total.rounds);
+    printf("  \"turns\": %u,\n", total.turns);
+    printf("  \"ai_turns\": %u,\n", total.aiTurns);
+    printf("  \"wall_s\": %.3f,\n", wallTime);
+    printf("  \"turns_per_s\": %.2f,\n", wallTime > 0.0 ? (double)total.turns / wallTime : 0.0);
+    printf("  \"ai_ms\": %.3f,\n", total.aiTime);
+    printf("  \"ai_us_per_turn\": %.2f,\n", total.aiTurns != 0 ? total.aiTime * 1000.0 / (double)total.aiTurns : 0.0);
+    printf("  \"ai_us_per_critter\": %.2f,\n", spawned != 0 ? total.aiTime * 1000.0 / (double)spawned : 0.0);
+    printf("  \"path_requests_per_turn\": %.2f,\n", (double)paths / turns);
+    printf("  \"path_nodes_per_turn\": %.2f,\n", (double)nodes / turns);
+    printf("  \"to_hit_queries_per_turn\": %.2f\n", (double)total.toHitQueries / turns);
+    printf("}\n");
+
+    game_exit();
+
+    return EXIT_SUCCESS;
+}
+
+} // namespace fallout
+
+int main(int argc, char* argv[])
+{
+    if (argc < 5) {
+        fprintf(stderr, "Usage: combatbench rounds seed map.map team:pid:ai_packet:count ...\n");
+        return EXIT_FAILURE;
+    }
+
+    int rounds = atoi(argv[1]);
+    if (rounds <= 0) {
+        rounds = 1;
+    }
+
+    unsigned int seed = (unsigned int)strtoul(argv[2], NULL, 10);
+
+    std::vector<fallout::BenchGroup> groups;
+    for (int index = 4; index < argc; index++) {
+        fallout::BenchGroup group;
+        if (!fallout::parseGroup(argv[index], &group)) {
+            fprintf(stderr, "Invalid group: %s\n", argv[index]);
+            return EXIT_FAILURE;
+        }
+        groups.push_back(group);
+    }
+
+    if (groups.size() < 2) {
+        fprintf(stderr, "At least two groups are required\n");
+        return EXIT_FAILURE;
+    }
+
+    return fallout::bench(rounds, seed, argv[3], groups);
+}
@@ -0,0 +1,177 @@
+// Measures LZSS decoding throughput over every compressed entry of DAT file.
+//
+// Each entry is decoded with both stream decoder (`lzss_decode_to_buf`, which
+// is used for non-mapped datafiles) and in-memory decoder
+// (`lzss_decode_mem_to_buf`), results are cross-checked.
+//
+// Usage: datbench <file.dat> [iterations]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "datfile.h"
+#include "plib/db/lzss.h"
+
+namespace fallout {
+
+// Compressed payload of a single entry (or a single block of block-compressed
+// entry).
+struct BenchChunk {
+    int offset;
+    int packedLength;
+    int length;
+};
+
+static bool collectChunks(const std::vector<unsigned char>& data, const DatEntry& entry, std::vector<BenchChunk>& chunks)
+{
+    int type = entry.flags & 0xF0;
+    if (type == 0) {
+        type = 16;
+    }
+
+    if ((size_t)entry.offset + (size_t)entry.packedLength > data.size()) {
+        return false;
+    }
+
+    switch (type) {
+    case 16:
+        chunks.push_back({ entry.offset, entry.packedLength, entry.length });
+        return true;
+    case 64:
+        for (int pos = entry.offset, remaining = entry.length; remaining > 0;) {
+            if ((size_t)pos + 2 > data.size()) {
+                return false;
+            }
+
+            int blockLength = (data[pos] << 8) | data[pos + 1];
+            pos += 2;
+
+            int length = remaining < DAT_BLOCK_SIZE ? remaining : DAT_BLOCK_SIZE;
+            if ((blockLength & DAT_BLOCK_UNCOMPRESSED) != 0) {
+                blockLength &= ~DAT_BLOCK_UNCOMPRESSED;
+            } else {
+                chunks.push_back({ pos, blockLength, length });
+            }
+
+            pos += blockLength;
+            remaining -= length;
+        }
+        return true;
+    }
+
+    // Stored entries are not interesting.
+    return true;
+}
+
+static int bench(const char* path, int iterations)
+{
+    FILE* stream = fopen(path, "rb");
+    if (stream == NULL) {
+        fprintf(stderr, "Could not open %s\n", path);
+        return EXIT_FAILURE;
+    }
+
+    int rootHeader[4];
+    std::vector<DatDirectory> directories;
+    if (!readDirectories(stream, rootHeader, directories)) {
+        fprintf(stderr, "%s is not a valid datafile\n", path);
+        fclose(stream);
+        return EXIT_FAILURE;
+    }
+
+    fseek(stream, 0, SEEK_END);
+    std::vector<unsigned char> data(ftell(stream));
+    fseek(stream, 0, SEEK_SET);
+    if (fread(data.data(), 1, data.size(), stream) != data.size()) {
+        fprintf(stderr, "Could not read %s\n", path);
+        fclose(stream);
+        return EXIT_FAILURE;
+    }
+
+    std::vector<BenchChunk> chunks;
+    int maxLength = 0;
+    for (const DatDirectory& directory : directories) {
+        for (const DatEntry& entry : directory.entries) {
+            if (!collectChunks(data, entry, chunks)) {
+                fprintf(stderr, "Invalid entry %s\\%s\n", directory.name.c_str(), entry.name.c_str());
+                fclose(stream);
+                return EXIT_FAILURE;
+            }
+        }
+    }
+
+    double totalLength = 0;
+    for (const BenchChunk& chunk : chunks) {
+        totalLength += chunk.length;
+        if (chunk.length > maxLength) {
+            maxLength = chunk.length;
+        }
+    }
+
+    // Slack for decoders which do not check output bounds.
+    std::vector<unsigned char> expected(maxLength + 64);
+    std::vector<unsigned char> actual(maxLength + 64);
+
+    int mismatches = 0;
+    for (const BenchChunk& chunk : chunks) {
+        fseek(stream, chunk.offset, SEEK_SET);
+        int expectedLength = lzss_decode_to_buf(stream, expected.data(), chunk.packedLength);
+        int actualLength = lzss_decode_mem_to_buf(data.data() + chunk.offset, chunk.packedLength, actual.data(), (unsigned int)actual.size());
+        if (expectedLength != actualLength || memcmp(expected.data(), actual.data(), expectedLength) != 0) {
+            mismatches++;
+        }
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (int iteration = 0; iteration < iterations; iteration++) {
+        for (const BenchChunk& chunk : chunks) {
+            fseek(stream, chunk.offset, SEEK_SET);
+            lzss_decode_to_buf(stream, expected.data(), chunk.packedLength);
+        }
+    }
+    double streamSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+    for (int iteration = 0; iteration < iterations; iteration++) {
+        for (const BenchChunk& chunk : chunks) {
+            lzss_decode_mem_to_buf(data.data() + chunk.offset, chunk.packedLength, actual.data(), (unsigned int)actual.size());
+        }
+    }
+    double memorySeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    fclose(stream);
+
+    double megabytes = totalLength * iterations / (1024.0 * 1024.0);
+    printf("%s: %zu compressed chunks, %.1f MB decoded per iteration, %d iterations\n", path, chunks.size(), totalLength / (1024.0 * 1024.0), iterations);
+    printf("stream: %8.3f s %8.1f MB/s\n", streamSeconds, megabytes / streamSeconds);
+    printf("memory: %8.3f s %8.1f MB/s (x%.2f)\n", memorySeconds, megabytes / memorySeconds, streamSeconds / memorySeconds);
+
+    if (mismatches != 0) {
+        fprintf(stderr, "%d chunks decoded differently\n", mismatches);
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+} // namespace fallout
+
+int main(int argc, char* argv[])
+{
+    if (argc != 2 && argc != 3) {
+        fprintf(stderr, "Usage: %s <file.dat> [iterations]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    int iterations = argc == 3 ? atoi(argv[2]) : 10;
+    if (iterations <= 0) {
+        iterations = 1;
+    }
+
+    return fallout::bench(argv[1], iterations);
+}
@@ -0,0 +1,75 @@
+// Reading of DAT directory shared by datafile tools.
+
+#include "datfile.h"
+
+namespace fallout {
+
+bool readLong(FILE* stream, int* valuePtr)
+{
+    unsigned char bytes[4];
+    if (fread(bytes, 1, 4, stream) != 4) {
+        return false;
+    }
+
+    *valuePtr = (bytes[0] << 24) | (bytes[1] << 16) | (bytes[2] << 8) | bytes[3];
+    return true;
+}
+
+bool readName(FILE* stream, std::string& name)
+{
+    int length = fgetc(stream);
+    if (length == -1) {
+        return false;
+    }
+
+    name.resize(length);
+    if (length != 0 && fread(&name[0], 1, length, stream) != (size_t)length) {
+        return false;
+    }
+
+    return true;
+}
+
+bool readDirectories(FILE* stream, int* rootHeader, std::vector<DatDirectory>& directories)
+{
+    for (int index = 0; index < 4; index++) {
+        if (!readLong(stream, &(rootHeader[index]))) {
+            return false;
+        }
+    }
+
+    directories.resize(rootHeader[0]);
+    for (DatDirectory& directory : directories) {
+        if (!readName(stream, directory.name)) {
+            return false;
+        }
+
+        // Root assoc array has no payload in stock datafiles.
+        if (rootHeader[2] != 0 && fseek(stream, rootHeader[2], SEEK_CUR) != 0) {
+            return false;
+        }
+    }
+
+    for (DatDirectory& directory : directories) {
+        for (int index = 0; index < 4; index++) {
+            if (!readLong(stream, &(directory.header[index]))) {
+                return false;
+            }
+        }
+
+        directory.entries.resize(directory.header[0]);
+        for (DatEntry& entry : directory.entries) {
+            if (!readName(stream, entry.name)
+                || !readLong(stream, &(entry.flags))
+                || !readLong(stream, &(entry.offset))
+                || !readLong(stream, &(entry.length))
+                || !readLong(stream, &(entry.packedLength))) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+} // namespace fallout
@@ -0,0 +1,35 @@
+#ifndef FALLOUT_TOOLS_DATFILE_H_
+#define FALLOUT_TOOLS_DATFILE_H_
+
+#include <stdio.h>
+
+#include <string>
+#include <vector>
+
+namespace fallout {
+
+#define DAT_BLOCK_SIZE 0x4000
+#define DAT_BLOCK_UNCOMPRESSED 0x8000
+#define DAT_ENTRY_BLOCK_TABLE 0x100
+
+struct DatEntry {
+    std::string name;
+    int flags;
+    int offset;
+    int length;
+    int packedLength;
+};
+
+struct DatDirectory {
+    std::string name;
+    int header[4];
+    std::vector<DatEntry> entries;
+};
+
+bool readLong(FILE* stream, int* valuePtr);
+bool readName(FILE* stream, std::string& name);
+bool readDirectories(FILE* stream, int* rootHeader, std::vector<DatDirectory>& directories);
+
+} // namespace fallout
+
+#endif /* FALLOUT_TOOLS_DATFILE_H_ */
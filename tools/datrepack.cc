@@ -0,0 +1,238 @@
+// Converts stock DAT file into seekable layout understood by `db_fopen`.
+//
+// Every compressed entry is split into 0x4000 byte blocks which are encoded
+// independently (the same way as block-compressed entries of original
+// datafiles) and followed by the table of block offsets. Stored entries are
+// copied as is. Resulting datafile remains readable by original engine.
+//
+// Usage: datrepack <input.dat> <output.dat>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include "datfile.h"
+#include "plib/db/lzss.h"
+
+namespace fallout {
+
+static void writeLong(std::vector<unsigned char>& buffer, int value)
+{
+    buffer.push_back((value >> 24) & 0xFF);
+    buffer.push_back((value >> 16) & 0xFF);
+    buffer.push_back((value >> 8) & 0xFF);
+    buffer.push_back(value & 0xFF);
+}
+
+static void writeName(std::vector<unsigned char>& buffer, const std::string& name)
+{
+    buffer.push_back(name.size() & 0xFF);
+    buffer.insert(buffer.end(), name.begin(), name.end());
+}
+
+static std::vector<unsigned char> writeDirectories(const int* rootHeader, const std::vector<DatDirectory>& directories)
+{
+    std::vector<unsigned char> buffer;
+
+    writeLong(buffer, (int)directories.size());
+    writeLong(buffer, (int)directories.size());
+    writeLong(buffer, 0);
+    writeLong(buffer, rootHeader[3]);
+
+    for (const DatDirectory& directory : directories) {
+        writeName(buffer, directory.name);
+    }
+
+    for (const DatDirectory& directory : directories) {
+        for (int index = 0; index < 4; index++) {
+            writeLong(buffer, directory.header[index]);
+        }
+
+        for (const DatEntry& entry : directory.entries) {
+            writeName(buffer, entry.name);
+            writeLong(buffer, entry.flags);
+            writeLong(buffer, entry.offset);
+            writeLong(buffer, entry.length);
+            writeLong(buffer, entry.packedLength);
+        }
+    }
+
+    return buffer;
+}
+
+static bool readEntry(FILE* stream, const DatEntry& entry, std::vector<unsigned char>& data)
+{
+    data.resize(entry.length);
+
+    if (fseek(stream, entry.offset, SEEK_SET) != 0) {
+        return false;
+    }
+
+    int type = entry.flags & 0xF0;
+    if (type == 0) {
+        type = 16;
+    }
+
+    switch (type) {
+    case 16:
+        lzss_decode_to_buf(stream, data.data(), entry.packedLength);
+        return true;
+    case 32:
+        return fread(data.data(), 1, entry.length, stream) == (size_t)entry.length;
+    case 64:
+        for (int pos = 0; pos < entry.length;) {
+            int hi = fgetc(stream);
+            int lo = fgetc(stream);
+            if (hi == -1 || lo == -1) {
+                return false;
+            }
+
+            int blockLength = (hi << 8) | lo;
+            if ((blockLength & DAT_BLOCK_UNCOMPRESSED) != 0) {
+                blockLength &= ~DAT_BLOCK_UNCOMPRESSED;
+                if (pos + blockLength > entry.length || fread(data.data() + pos, 1, blockLength, stream) != (size_t)blockLength) {
+                    return false;
+                }
+                pos += blockLength;
+            } else {
+                // Decoded block never exceeds block size.
+                unsigned char block[DAT_BLOCK_SIZE];
+                int decoded = lzss_decode_to_buf(stream, block, blockLength);
+                if (decoded > entry.length - pos) {
+                    decoded = entry.length - pos;
+                }
+                memcpy(data.data() + pos, block, decoded);
+                pos += decoded;
+            }
+        }
+        return true;
+    }
+
+    return false;
+}
+
+static void encodeEntry(const std::vector<unsigned char>& data, std::vector<unsigned char>& packed)
+{
+    std::vector<unsigned char> encoded(LZSS_ENCODE_BOUND(DAT_BLOCK_SIZE));
+    std::vector<int> offsets;
+
+    packed.clear();
+
+    for (size_t pos = 0; pos < data.size(); pos += DAT_BLOCK_SIZE) {
+        unsigned int blockLength = data.size() - pos;
+        if (blockLength > DAT_BLOCK_SIZE) {
+            blockLength = DAT_BLOCK_SIZE;
+        }
+
+        offsets.push_back((int)packed.size());
+
+        unsigned int encodedLength = lzss_encode_to_buf(data.data() + pos, blockLength, encoded.data());
+        if (encodedLength < blockLength) {
+            packed.push_back((encodedLength >> 8) & 0xFF);
+            packed.push_back(encodedLength & 0xFF);
+            packed.insert(packed.end(), encoded.begin(), encoded.begin() + encodedLength);
+        } else {
+            packed.push_back(((blockLength | DAT_BLOCK_UNCOMPRESSED) >> 8) & 0xFF);
+            packed.push_back(blockLength & 0xFF);
+            packed.insert(packed.end(), data.begin() + pos, data.begin() + pos + blockLength);
+        }
+    }
+
+    for (int offset : offsets) {
+        writeLong(packed, offset);
+    }
+}
+
+static int repack(const char* inputPath, const char* outputPath)
+{
+    FILE* in = fopen(inputPath, "rb");
+    if (in == NULL) {
+        fprintf(stderr, "Could not open %s\n", inputPath);
+        return EXIT_FAILURE;
+    }
+
+    int rootHeader[4];
+    std::vector<DatDirectory> directories;
+    if (!readDirectories(in, rootHeader, directories)) {
+        fprintf(stderr, "%s is not a valid datafile\n", inputPath);
+        fclose(in);
+        return EXIT_FAILURE;
+    }
+
+    FILE* out = fopen(outputPath, "wb");
+    if (out == NULL) {
+        fprintf(stderr, "Could not create %s\n", outputPath);
+        fclose(in);
+        return EXIT_FAILURE;
+    }
+
+    // Directory does not change its size, so it's written twice - first to
+    // reserve space, and then with actual offsets.
+    std::vector<unsigned char> header = writeDirectories(rootHeader, directories);
+    fwrite(header.data(), 1, header.size(), out);
+
+    std::vector<unsigned char> data;
+    std::vector<unsigned char> packed;
+    long offset = (long)header.size();
+    int repacked = 0;
+    int copied = 0;
+
+    for (DatDirectory& directory : directories) {
+        for (DatEntry& entry : directory.entries) {
+            if (!readEntry(in, entry, data)) {
+                fprintf(stderr, "Could not read %s\\%s\n", directory.name.c_str(), entry.name.c_str());
+                fclose(out);
+                fclose(in);
+                return EXIT_FAILURE;
+            }
+
+            if ((entry.flags & 0xF0) == 32) {
+                fwrite(data.data(), 1, data.size(), out);
+                entry.offset = offset;
+                entry.packedLength = 0;
+                offset += (long)data.size();
+                copied++;
+            } else {
+                encodeEntry(data, packed);
+                fwrite(packed.data(), 1, packed.size(), out);
+                entry.flags = 64 | DAT_ENTRY_BLOCK_TABLE;
+                entry.offset = offset;
+                entry.packedLength = (int)packed.size();
+                offset += (long)packed.size();
+                repacked++;
+            }
+        }
+    }
+
+    header = writeDirectories(rootHeader, directories);
+    fseek(out, 0, SEEK_SET);
+    fwrite(header.data(), 1, header.size(), out);
+
+    bool success = ferror(out) == 0;
+    fclose(out);
+    fclose(in);
+
+    if (!success) {
+        fprintf(stderr, "Could not write %s\n", outputPath);
+        return EXIT_FAILURE;
+    }
+
+    printf("%s: %d entries repacked, %d entries copied, %ld bytes\n", outputPath, repacked, copied, offset);
+
+    return EXIT_SUCCESS;
+}
+
+} // namespace fallout
+
+int main(int argc, char* argv[])
+{
+    if (argc != 3) {
+        fprintf(stderr, "Usage: %s <input.dat> <output.dat>\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    return fallout::repack(argv[1], argv[2]);
+}
@@ -0,0 +1,1231 @@
+// Microbenchmarks of engine kernels, baseline for performance work.
+//
+// Game is initialized without display (so color tables, blend tables, tiles,
+// message lists, event queue and interpreter are the real ones), then each
+// kernel is run on synthetic input:
+//
+//   - `grbuf.cc` and `object.cc` blitters at several sprite sizes,
+//   - `lzss_decode_mem_to_buf` and `lzss_decode_to_buf`,
+//   - `frame_ptr` over every frame of player art,
+//   - `cache_lock`/`cache_unlock` with working set larger than cache,
+//   - `make_path_func` on seeded obstacle grid,
+//   - `tile_num`, `tile_coord`, `tile_num_in_direction` and `tile_dir` with
+//     original calculations and with precomputed tile tables,
+//   - `queue_add`/`queue_process` with no-op handler,
+//   - interpreter dispatch on generated program (arithmetic loop),
+//   - `message_search` on misc message list,
+//   - audio mixer with N looping buffers (offline audio backend only).
+//
+// Results are printed as JSON to stdout, one entry per kernel and size, so
+// runs can be compared over time. Run from game directory (where
+// `master.dat` and `critter.dat` are).
+//
+// With `--check`, nothing is timed. Instead optimized kernels are compared
+// against reference implementations on seeded input and exit code is
+// non-zero when any output differs:
+//
+//   - vectorized `transSrcCopy`, `mask_buf_to_buf` and `swap_color_buf` row
+//     kernels against scalar ones, byte for byte (odd widths and unaligned
+//     pitches included),
+//   - `tile_coord`, `tile_num`, `tile_num_in_direction` and `tile_dir` with
+//     precomputed tile tables against original calculations, for every tile
+//     and several view centers,
+//   - audio mixer against original mixing (one source frame at a time
+//     through `SDL_AudioStream`), for sources matching output format and
+//     for converted and resampled ones (offline audio backend only).
+//     Conversions without rate change must match byte for byte, resampled
+//     output within `CHECK_MIX_TOLERANCE`.
+//
+// Usage: fallout-ce-bench [iterations] [seed]
+//        fallout-ce-bench --check [seed]
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "audio_engine.h"
+#include "game/anim.h"
+#include "game/art.h"
+#include "game/cache.h"
+#include "game/game.h"
+#include "game/message.h"
+#include "game/object.h"
+#include "game/queue.h"
+#include "game/scripts.h"
+#include "game/tile.h"
+#include "int/intrpret.h"
+#include "platform_compat.h"
+#include "plib/db/db.h"
+#include "plib/db/lzss.h"
+#include "plib/gnw/grbuf.h"
+#include "plib/gnw/winmain.h"
+
+#include <SDL.h>
+
+namespace fallout {
+
+// Number of timed samples per kernel, each sample covers `batch` calls so
+// clock overhead does not dominate small kernels.
+#define BENCH_SAMPLES 64
+
+// Destination buffer of blitters (game window size).
+#define BENCH_DEST_WIDTH 640
+#define BENCH_DEST_HEIGHT 480
+
+// Directory for generated files, removed on exit.
+#define BENCH_TEMP_DIR "kernelbench.tmp"
+
+// Size of program header preceding procedure table, see `benchInterpreter`.
+#define BENCH_PROGRAM_HEADER_SIZE 42
+
+// Number of random inputs cycled by tile benchmarks.
+#define BENCH_TILE_INPUTS 1024
+
+// Number of view centers tried by tile tables check.
+#define CHECK_TILE_CENTERS 16
+
+// Guard bytes around checked buffers, kernels writing outside of their
+// rows show up as mismatches.
+#define CHECK_GUARD_SIZE 64
+
+// Output format of offline audio backends (see `audioEngineMix`).
+#define CHECK_MIX_FORMAT AUDIO_S16SYS
+#define CHECK_MIX_CHANNELS 2
+#define CHECK_MIX_RATE 22050
+
+// Maximum difference of resampled 16-bit samples (1% of full scale).
+// Original code restarted resampler on every source frame, so output can
+// differ slightly where interpolation phase differs.
+#define CHECK_MIX_TOLERANCE 328
+
+// Mixer output per call (one callback period of offline backend: 1024
+// stereo 16-bit frames).
+#define BENCH_MIX_LENGTH 4096
+
+typedef struct BenchSize {
+    int width;
+    int height;
+} BenchSize;
+
+static const BenchSize benchSpriteSizes[] = {
+    { 16, 16 },
+    { 64, 64 },
+    { 160, 120 },
+    { 400, 300 },
+};
+
+static bool benchFirst = true;
+
+// Number of failed checks, see `checkReport`.
+static int checkFailures = 0;
+
+static double percentile(std::vector<double>& values, double fraction)
+{
+    if (values.empty()) {
+        return 0.0;
+    }
+
+    std::sort(values.begin(), values.end());
+
+    size_t index = (size_t)(fraction * (double)(values.size() - 1) + 0.5);
+    return values[index];
+}
+
+// Runs `fn` `BENCH_SAMPLES` x `batch` times and prints per call timings.
+template <typename Fn>
+static void benchRun(const char* kernel, const char* variant, int batch, Fn fn)
+{
+    if (batch < 1) {
+        batch = 1;
+    }
+
+    // Warm up caches and lazily built tables.
+    for (int index = 0; index < batch; index++) {
+        fn();
+    }
+
+    std::vector<double> nanos;
+    nanos.reserve(BENCH_SAMPLES);
+
+    double total = 0.0;
+    for (int sample = 0; sample < BENCH_SAMPLES; sample++) {
+        auto start = std::chrono::steady_clock::now();
+        for (int index = 0; index < batch; index++) {
+            fn();
+        }
+        auto end = std::chrono::steady_clock::now();
+
+        double value = std::chrono::duration<double, std::nano>(end - start).count() / batch;
+        nanos.push_back(value);
+        total += value;
+    }
+
+    printf("%s    {\"kernel\": \"%s\", \"variant\": \"%s\", \"calls\": %d, \"mean_ns\": %.1f, \"p50_ns\": %.1f, \"p99_ns\": %.1f}",
+        benchFirst ? "" : ",\n",
+        kernel,
+        variant,
+        BENCH_SAMPLES * batch,
+        total / BENCH_SAMPLES,
+        percentile(nanos, 0.50),
+        percentile(nanos, 0.99));
+
+    benchFirst = false;
+}
+
+static void benchSkip(const char* kernel, const char* reason)
+{
+    printf("%s    {\"kernel\": \"%s\", \"skipped\": \"%s\"}", benchFirst ? "" : ",\n", kernel, reason);
+    benchFirst = false;
+}
+
+// Batch size giving roughly `iterations` x 64x64 pixels per sample.
+static int benchPixelBatch(int iterations, int width, int height)
+{
+    return std::max(1, (int)((long long)iterations * 64 * 64 / ((long long)width * height)));
+}
+
+// Sprite of given size: opaque ellipse of palette colors (avoiding animated
+// ones) on transparent background, like most critter frames.
+static std::vector<unsigned char> benchSprite(int width, int height, std::mt19937& random)
+{
+    std::uniform_int_distribution<int> colors(1, 0xE4);
+
+    std::vector<unsigned char> pixels(width * height, 0);
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            double dx = (x + 0.5) / width * 2.0 - 1.0;
+            double dy = (y + 0.5) / height * 2.0 - 1.0;
+            if (dx * dx + dy * dy <= 1.0) {
+                pixels[y * width + x] = (unsigned char)colors(random);
+            }
+        }
+    }
+
+    return pixels;
+}
+
+static void benchBlitters(int iterations, std::mt19937& random)
+{
+    std::vector<unsigned char> dest(BENCH_DEST_WIDTH * BENCH_DEST_HEIGHT);
+    for (size_t index = 0; index < dest.size(); index++) {
+        dest[index] = (unsigned char)(index % 0xE5);
+    }
+
+    for (const BenchSize& size : benchSpriteSizes) {
+        int width = size.width;
+        int height = size.height;
+        int batch = benchPixelBatch(iterations, width, height);
+
+        char variant[32];
+        snprintf(variant, sizeof(variant), "%dx%d", width, height);
+
+        std::vector<unsigned char> sprite = benchSprite(width, height, random);
+        unsigned char* src = sprite.data();
+
+        std::vector<unsigned char> spans(span_encode_size(src, width, height, width));
+        span_encode(src, width, height, width, spans.data());
+
+        std::vector<unsigned char> mask(width * height);
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++) {
+                mask[y * width + x] = (unsigned char)(x * 128 / width);
+            }
+        }
+
+        benchRun("buf_to_buf", variant, batch, [&]() {
+            buf_to_buf(src, width, height, width, dest.data(), BENCH_DEST_WIDTH);
+        });
+
+        benchRun("trans_buf_to_buf", variant, batch, [&]() {
+            trans_buf_to_buf(src, width, height, width, dest.data(), BENCH_DEST_WIDTH);
+        });
+
+        benchRun("span_trans_buf_to_buf", variant, batch, [&]() {
+            span_trans_buf_to_buf(spans.data(), 0, 0, width, height, dest.data(), BENCH_DEST_WIDTH);
+        });
+
+        benchRun("dark_trans_buf_to_buf", variant, batch, [&]() {
+            dark_trans_buf_to_buf(src, width, height, width, dest.data(), 0, 0, BENCH_DEST_WIDTH, 0x8000);
+        });
+
+        benchRun("dark_trans_buf_to_buf_full_light", variant, batch, [&]() {
+            dark_trans_buf_to_buf(src, width, height, width, dest.data(), 0, 0, BENCH_DEST_WIDTH, 0x10000);
+        });
+
+        benchRun("dark_trans_span_to_buf", variant, batch, [&]() {
+            dark_trans_span_to_buf(spans.data(), 0, 0, width, height, dest.data(), 0, 0, BENCH_DEST_WIDTH, 0x8000);
+        });
+
+        if (redBlendTable != NULL) {
+            benchRun("dark_translucent_trans_buf_to_buf", variant, batch, [&]() {
+                dark_translucent_trans_buf_to_buf(src, width, height, width, dest.data(), 0, 0, BENCH_DEST_WIDTH, 0x8000, redBlendTable, commonGrayTable);
+            });
+        }
+
+        benchRun("intensity_mask_buf_to_buf", variant, batch, [&]() {
+            intensity_mask_buf_to_buf(src, width, height, width, dest.data(), BENCH_DEST_WIDTH, mask.data(), width, 0x8000);
+        });
+    }
+}
+
+static void benchLzss(int iterations, std::mt19937& random)
+{
+    // Text-like data: words from small vocabulary, compresses about as well
+    // as scripts and message files.
+    static const char* words[] = { "critter", "the", "of", "item", "tile", "script", "map", "elevation", "rotation", "frame" };
+    std::uniform_int_distribution<int> wordIndex(0, sizeof(words) / sizeof(words[0]) - 1);
+
+    std::vector<unsigned char> data;
+    while (data.size() < 64 * 1024) {
+        const char* word = words[wordIndex(random)];
+        data.insert(data.end(), word, word + strlen(word));
+        data.push_back(' ');
+    }
+    data.resize(64 * 1024);
+
+    std::vector<unsigned char> encoded(LZSS_ENCODE_BOUND(data.size()));
+    unsigned int encodedLength = lzss_encode_to_buf(data.data(), (unsigned int)data.size(), encoded.data());
+
+    std::vector<unsigned char> decoded(data.size());
+    int batch = std::max(1, iterations / 64);
+
+    benchRun("lzss_decode_mem_to_buf", "64k", batch, [&]() {
+        lzss_decode_mem_to_buf(encoded.data(), encodedLength, decoded.data(), (unsigned int)decoded.size());
+    });
+
+    FILE* stream = tmpfile();
+    if (stream == NULL) {
+        benchSkip("lzss_decode_to_buf", "no temporary file");
+        return;
+    }
+
+    fwrite(encoded.data(), 1, encodedLength, stream);
+
+    benchRun("lzss_decode_to_buf", "64k", batch, [&]() {
+        fseek(stream, 0, SEEK_SET);
+        lzss_decode_to_buf(stream, decoded.data(), encodedLength);
+    });
+
+    fclose(stream);
+}
+
+static void benchFramePtr(int iterations)
+{
+    CacheEntry* cacheEntry;
+    Art* art = art_ptr_lock(obj_dude->fid, &cacheEntry);
+    if (art == NULL) {
+        benchSkip("frame_ptr", "no player art");
+        return;
+    }
+
+    int frameCount = art_frame_max_frame(art);
+    volatile int sink = 0;
+
+    benchRun("frame_ptr", "player", iterations, [&]() {
+        for (int rotation = 0; rotation < ROTATION_COUNT; rotation++) {
+            for (int frame = 0; frame < frameCount; frame++) {
+                ArtFrame* frm = frame_ptr(art, frame, rotation);
+                if (frm != NULL) {
+                    sink = sink + frm->width;
+                }
+            }
+        }
+    });
+
+    art_ptr_unlock(cacheEntry);
+}
+
+static int benchCacheSize(int key, int* sizePtr)
+{
+    *sizePtr = 4096 + (key % 8) * 1024;
+    return 0;
+}
+
+static int benchCacheRead(int key, int* sizePtr, unsigned char* buffer)
+{
+    *sizePtr = 4096 + (key % 8) * 1024;
+    memset(buffer, key & 0xFF, *sizePtr);
+    return 0;
+}
+
+static void benchCacheFree(void* ptr)
+{
+}
+
+static void benchCache(int iterations, std::mt19937& random)
+{
+    // Working set of about 8 MB against 2 MB cache, so most locks after
+    // warm up evict something.
+    Cache cache;
+    if (!cache_init(&cache, benchCacheSize, benchCacheRead, benchCacheFree, 2 << 20)) {
+        benchSkip("cache_lock", "cache_init failed");
+        return;
+    }
+
+    std::vector<int> keys(4096);
+    std::uniform_int_distribution<int> hot(0, 63);
+    std::uniform_int_distribution<int> cold(64, 1087);
+    std::uniform_int_distribution<int> coin(0, 3);
+    for (size_t index = 0; index < keys.size(); index++) {
+        keys[index] = coin(random) == 0 ? cold(random) : hot(random);
+    }
+
+    size_t next = 0;
+    benchRun("cache_lock_unlock", "churn", iterations, [&]() {
+        void* data;
+        CacheEntry* cacheEntry;
+        if (cache_lock(&cache, keys[next], &data, &cacheEntry)) {
+            cache_unlock(&cache, cacheEntry);
+        }
+        next = (next + 1) % keys.size();
+    });
+
+    cache_exit(&cache);
+}
+
+// Obstacles of `benchPathCallback`.
+static std::vector<unsigned char> benchPathGrid;
+
+static Object* benchPathCallback(Object* object, int tile, int elevation)
+{
+    if (tile < 0 || tile >= HEX_GRID_SIZE || benchPathGrid[tile] != 0) {
+        return object;
+    }
+
+    return NULL;
+}
+
+static void benchPath(int iterations, std::mt19937& random)
+{
+    benchPathGrid.assign(HEX_GRID_SIZE, 0);
+
+    std::uniform_int_distribution<int> percent(0, 99);
+    for (int tile = 0; tile < HEX_GRID_SIZE; tile++) {
+        benchPathGrid[tile] = percent(random) < 20 ? 1 : 0;
+    }
+
+    std::uniform_int_distribution<int> tiles(0, HEX_GRID_SIZE - 1);
+    std::uniform_int_distribution<int> rotations(0, ROTATION_COUNT - 1);
+
+    // Pairs of open tiles at most 30 hexes apart.
+    std::vector<std::pair<int, int>> queries;
+    while (queries.size() < 256) {
+        int from = tiles(random);
+        if (benchPathGrid[from] != 0) {
+            continue;
+        }
+
+        int to = tile_num_in_direction(from, rotations(random), 10 + percent(random) % 20);
+        if (to == -1 || benchPathGrid[to] != 0) {
+            continue;
+        }
+
+        queries.push_back(std::make_pair(from, to));
+    }
+
+    unsigned char path[800];
+    size_t next = 0;
+    benchRun("make_path_func", "grid_20pct", std::max(1, iterations / 64), [&]() {
+        make_path_func(obj_dude, queries[next].first, queries[next].second, path, 0, benchPathCallback);
+        next = (next + 1) % queries.size();
+    });
+
+    benchPathGrid.clear();
+}
+
+static int benchQueueHandler(Object* owner, void* data)
+{
+    return 0;
+}
+
+// Runs tile functions with original calculations and with tables on the
+// same inputs.
+static void benchTiles(int iterations, std::mt19937& random)
+{
+    std::uniform_int_distribution<int> tiles(0, HEX_GRID_SIZE - 1);
+    std::uniform_int_distribution<int> rotations(0, ROTATION_COUNT - 1);
+    std::uniform_int_distribution<int> distances(1, 8);
+    std::uniform_int_distribution<int> screenXs(-320, 960);
+    std::uniform_int_distribution<int> screenYs(-240, 720);
+
+    std::vector<int> tiles1(BENCH_TILE_INPUTS);
+    std::vector<int> tiles2(BENCH_TILE_INPUTS);
+    std::vector<int> inputRotations(BENCH_TILE_INPUTS);
+    std::vector<int> inputDistances(BENCH_TILE_INPUTS);
+    std::vector<int> screenX(BENCH_TILE_INPUTS);
+    std::vector<int> screenY(BENCH_TILE_INPUTS);
+    for (int index = 0; index < BENCH_TILE_INPUTS; index++) {
+        tiles1[index] = tiles(random);
+        tiles2[index] = tiles(random);
+        inputRotations[index] = rotations(random);
+        inputDistances[index] = distances(random);
+        screenX[index] = screenXs(random);
+        screenY[index] = screenYs(random);
+    }
+
+    int batch = std::max(1, iterations * 16);
+
+    for (int tables = 0; tables < 2; tables++) {
+        const char* variant = tables != 0 ? "tables" : "original";
+        tile_set_tables_enabled(tables != 0);
+
+        int next = 0;
+        volatile int sink = 0;
+
+        benchRun("tile_num", variant, batch, [&]() {
+            sink = sink + tile_num(screenX[next], screenY[next], 0, true);
+            next = (next + 1) % BENCH_TILE_INPUTS;
+        });
+
+        benchRun("tile_coord", variant, batch, [&]() {
+            int x;
+            int y;
+            tile_coord(tiles1[next], &x, &y, 0);
+            sink = sink + x + y;
+            next = (next + 1) % BENCH_TILE_INPUTS;
+        });
+
+        benchRun("tile_num_in_direction", variant, batch, [&]() {
+            sink = sink + tile_num_in_direction(tiles1[next], inputRotations[next], inputDistances[next]);
+            next = (next + 1) % BENCH_TILE_INPUTS;
+        });
+
+        benchRun("tile_dir", variant, batch, [&]() {
+            sink = sink + tile_dir(tiles1[next], tiles2[next]);
+            next = (next + 1) % BENCH_TILE_INPUTS;
+        });
+    }
+
+    tile_set_tables_enabled(true);
+}
+
+static void benchQueue(int iterations, std::mt19937& random)
+{
+    // Sneak events carry no data, their handler is replaced for the run.
+    EventTypeDescription saved = q_func[EVENT_TYPE_SNEAK];
+    q_func[EVENT_TYPE_SNEAK].handlerProc = benchQueueHandler;
+    q_func[EVENT_TYPE_SNEAK].freeProc = NULL;
+
+    std::uniform_int_distribution<int> delays(1, 1000);
+    std::vector<int> eventDelays(1024);
+    for (size_t index = 0; index < eventDelays.size(); index++) {
+        eventDelays[index] = delays(random);
+    }
+
+    int count = (int)eventDelays.size();
+
+    benchRun("queue_add", "1024_events", 1, [&]() {
+        for (int index = 0; index < count; index++) {
+            queue_add(eventDelays[index], obj_dude, NULL, EVENT_TYPE_SNEAK);
+        }
+        queue_remove_this(obj_dude, EVENT_TYPE_SNEAK);
+    });
+
+    benchRun("queue_process", "1024_events", 1, [&]() {
+        for (int index = 0; index < count; index++) {
+            queue_add(eventDelays[index], obj_dude, NULL, EVENT_TYPE_SNEAK);
+        }
+        inc_game_time(1000);
+        queue_process();
+    });
+
+    queue_remove_this(obj_dude, EVENT_TYPE_SNEAK);
+    q_func[EVENT_TYPE_SNEAK] = saved;
+}
+
+static void benchStoreWord(std::vector<unsigned char>& data, int value)
+{
+    data.push_back((unsigned char)((value >> 8) & 0xFF));
+    data.push_back((unsigned char)(value & 0xFF));
+}
+
+static void benchStoreLong(std::vector<unsigned char>& data, int value)
+{
+    benchStoreWord(data, (value >> 16) & 0xFFFF);
+    benchStoreWord(data, value & 0xFFFF);
+}
+
+// Runs generated program consisting of endless loop of 6 instructions:
+// push 1, push 2, add, pop, push loop address, jump. Interpreter is asked
+// to execute fixed number of instructions, so no procedure framing is
+// needed.
+static void benchInterpreter(int iterations)
+{
+    std::vector<unsigned char> data(BENCH_PROGRAM_HEADER_SIZE, 0);
+
+    // No procedures, no identifiers, no static strings.
+    benchStoreLong(data, 0);
+    benchStoreLong(data, 0);
+    benchStoreLong(data, 0);
+
+    int loop = (int)data.size();
+    benchStoreWord(data, VALUE_TYPE_INT);
+    benchStoreLong(data, 1);
+    benchStoreWord(data, VALUE_TYPE_INT);
+    benchStoreLong(data, 2);
+    benchStoreWord(data, OPCODE_ADD);
+    benchStoreWord(data, OPCODE_POP);
+    benchStoreWord(data, VALUE_TYPE_INT);
+    benchStoreLong(data, loop);
+    benchStoreWord(data, OPCODE_JUMP);
+
+    compat_mkdir(BENCH_TEMP_DIR);
+
+    char path[COMPAT_MAX_PATH];
+    snprintf(path, sizeof(path), "%s/bench.int", BENCH_TEMP_DIR);
+
+    FILE* stream = fopen(path, "wb");
+    if (stream == NULL) {
+        benchSkip("interpret", "cannot write program");
+        return;
+    }
+    fwrite(data.data(), 1, data.size(), stream);
+    fclose(stream);
+
+    // Separate database with temporary directory as patches, so game data
+    // is not touched.
+    DB_DATABASE* oldDatabase = db_current();
+    DB_DATABASE* database = db_init(NULL, NULL, BENCH_TEMP_DIR, 0);
+    if (database == INVALID_DATABASE_HANDLE) {
+        benchSkip("interpret", "cannot open temporary database");
+        remove(path);
+        return;
+    }
+
+    db_select(database);
+    Program* program = allocateProgram("bench.int");
+    db_select(oldDatabase);
+
+    if (program == NULL) {
+        benchSkip("interpret", "cannot load program");
+    } else {
+        program->instructionPointer = loop;
+
+        // 6000 instructions per call.
+        benchRun("interpret", "arith_loop_6000_ops", std::max(1, iterations / 64), [&]() {
+            interpret(program, 6000);
+        });
+
+        interpretFreeProgram(program);
+    }
+
+    db_close(database);
+    remove(path);
+}
+
+static void benchMessages(int iterations, std::mt19937& random)
+{
+    std::uniform_int_distribution<int> numbers(0, 10000);
+    std::vector<int> queries(1024);
+    for (size_t index = 0; index < queries.size(); index++) {
+        queries[index] = numbers(random);
+    }
+
+    size_t next = 0;
+    benchRun("message_search", "misc", iterations, [&]() {
+        MessageListItem messageListItem;
+        messageListItem.num = queries[next];
+        message_search(&misc_message_file, &messageListItem);
+        next = (next + 1) % queries.size();
+    });
+}
+
+static void benchMixer(int iterations, std::mt19937& random)
+{
+    unsigned char stream[BENCH_MIX_LENGTH];
+    if (!audioEngineMix(stream, sizeof(stream))) {
+        benchSkip("audio_mix", "offline audio backend is not active");
+        return;
+    }
+
+    std::uniform_int_distribution<int> samples(-8192, 8191);
+
+    static const int bufferCounts[] = { 1, 4, 16 };
+    for (int bufferCount : bufferCounts) {
+        std::vector<int> buffers;
+        for (int index = 0; index < bufferCount; index++) {
+            // One second of 16-bit stereo noise, looped.
+            unsigned int size = 22050 * 4;
+            int soundBuffer = audioEngineCreateSoundBuffer(size, 16, 2, 22050);
+            if (soundBuffer == -1) {
+                break;
+            }
+
+            void* audioPtr1;
+            unsigned int audioBytes1;
+            void* audioPtr2;
+            unsigned int audioBytes2;
+            if (audioEngineSoundBufferLock(soundBuffer, 0, 0, &audioPtr1, &audioBytes1, &audioPtr2, &audioBytes2, AUDIO_ENGINE_SOUND_BUFFER_LOCK_ENTIRE_BUFFER)) {
+                short* pcm = (short*)audioPtr1;
+                for (unsigned int sample = 0; sample < audioBytes1 / 2; sample++) {
+                    pcm[sample] = (short)samples(random);
+                }
+                audioEngineSoundBufferUnlock(soundBuffer, audioPtr1, audioBytes1, audioPtr2, audioBytes2);
+            }
+
+            audioEngineSoundBufferPlay(soundBuffer, AUDIO_ENGINE_SOUND_BUFFER_PLAY_LOOPING);
+            buffers.push_back(soundBuffer);
+        }
+
+        char variant[32];
+        snprintf(variant, sizeof(variant), "%d_buffers", (int)buffers.size());
+
+        benchRun("audio_mix", variant, std::max(1, iterations / 64), [&]() {
+            audioEngineMix(stream, sizeof(stream));
+        });
+
+        for (int soundBuffer : buffers) {
+            audioEngineSoundBufferStop(soundBuffer);
+            audioEngineSoundBufferRelease(soundBuffer);
+        }
+    }
+}
+
+// Prints result of one check, failed checks are also reported to stderr.
+static void checkReport(const char* check, const char* variant, int cases, int mismatches)
+{
+    printf("%s    {\"check\": \"%s\", \"variant\": \"%s\", \"cases\": %d, \"mismatches\": %d}",
+        benchFirst ? "" : ",\n",
+        check,
+        variant,
+        cases,
+        mismatches);
+
+    if (mismatches != 0) {
+        fprintf(stderr, "%s (%s): %d of %d cases differ\n", check, variant, mismatches, cases);
+        checkFailures++;
+    }
+
+    benchFirst = false;
+}
+
+// Random pixels, [transparent] percent of them zero.
+static void checkFill(std::vector<unsigned char>& pixels, int transparent, std::mt19937& random)
+{
+    std::uniform_int_distribution<int> percents(0, 99);
+    std::uniform_int_distribution<int> colors(1, 0xFF);
+
+    for (size_t index = 0; index < pixels.size(); index++) {
+        pixels[index] = percents(random) < transparent ? 0 : (unsigned char)colors(random);
+    }
+}
+
+// Runs `fn` on copies of [dest] with scalar and with [kernels] row kernels.
+// Whole buffers (guards included) are compared.
+template <typename Fn>
+static bool checkKernels(int kernels, const std::vector<unsigned char>& dest, Fn fn)
+{
+    std::vector<unsigned char> expected(dest);
+    grbuf_set_kernels(GRBUF_KERNELS_SCALAR);
+    fn(expected.data());
+
+    std::vector<unsigned char> actual(dest);
+    grbuf_set_kernels(kernels);
+    fn(actual.data());
+
+    return expected == actual;
+}
+
+static void checkGrbufKernels(int kernels, const char* variant, std::mt19937& random)
+{
+    // Every width up to a few vectors covers every tail length of both 16
+    // and 32 byte kernels, followed by a few wide rows.
+    std::vector<int> widths;
+    for (int width = 1; width <= 100; width++) {
+        widths.push_back(width);
+    }
+    widths.push_back(255);
+    widths.push_back(639);
+    widths.push_back(640);
+
+    std::uniform_int_distribution<int> heights(1, 5);
+    std::uniform_int_distribution<int> paddings(0, 37);
+    std::uniform_int_distribution<int> offsets(0, 31);
+    std::uniform_int_distribution<int> percents(0, 100);
+    std::uniform_int_distribution<int> colors(0, 0xFF);
+
+    int cases = 0;
+    int transMismatches = 0;
+    int maskMismatches = 0;
+    int swapMismatches = 0;
+
+    for (int width : widths) {
+        int height = heights(random);
+        int srcPitch = width + paddings(random);
+        int maskPitch = width + paddings(random);
+        int destPitch = width + paddings(random);
+        int srcOffset = offsets(random);
+        int maskOffset = offsets(random);
+        int destOffset = offsets(random);
+
+        std::vector<unsigned char> src(CHECK_GUARD_SIZE + srcOffset + srcPitch * height + CHECK_GUARD_SIZE);
+        std::vector<unsigned char> mask(CHECK_GUARD_SIZE + maskOffset + maskPitch * height + CHECK_GUARD_SIZE);
+        std::vector<unsigned char> dest(CHECK_GUARD_SIZE + destOffset + destPitch * height + CHECK_GUARD_SIZE);
+        checkFill(src, percents(random), random);
+        checkFill(mask, percents(random), random);
+        checkFill(dest, 0, random);
+
+        unsigned char* srcStart = src.data() + CHECK_GUARD_SIZE + srcOffset;
+        unsigned char* maskStart = mask.data() + CHECK_GUARD_SIZE + maskOffset;
+        size_t destStart = CHECK_GUARD_SIZE + destOffset;
+
+        if (!checkKernels(kernels, dest, [&](unsigned char* buf) {
+                transSrcCopy(buf + destStart, destPitch, srcStart, srcPitch, width, height);
+            })) {
+            transMismatches++;
+        }
+
+        if (!checkKernels(kernels, dest, [&](unsigned char* buf) {
+                mask_buf_to_buf(srcStart, width, height, srcPitch, maskStart, maskPitch, buf + destStart, destPitch);
+            })) {
+            maskMismatches++;
+        }
+
+        // Colors are taken from buffer so both of them are present, equal
+        // colors are checked too.
+        std::vector<unsigned char> swap(dest);
+        int color1 = swap[destStart];
+        int color2 = percents(random) < 10 ? color1 : colors(random);
+        for (size_t index = destStart; index < swap.size() - CHECK_GUARD_SIZE; index++) {
+            int percent = percents(random);
+            if (percent < 30) {
+                swap[index] = (unsigned char)color1;
+            } else if (percent < 60) {
+                swap[index] = (unsigned char)color2;
+            }
+        }
+
+        if (!checkKernels(kernels, swap, [&](unsigned char* buf) {
+                swap_color_buf(buf + destStart, width, height, destPitch, color1, color2);
+            })) {
+            swapMismatches++;
+        }
+
+        cases++;
+    }
+
+    char name[64];
+    snprintf(name, sizeof(name), "%s_vs_scalar", variant);
+    checkReport("transSrcCopy", name, cases, transMismatches);
+    checkReport("mask_buf_to_buf", name, cases, maskMismatches);
+    checkReport("swap_color_buf", name, cases, swapMismatches);
+}
+
+static void checkGrbuf(std::mt19937& random)
+{
+    if (grbuf_set_kernels(GRBUF_KERNELS_SIMD)) {
+        checkGrbufKernels(GRBUF_KERNELS_SIMD, "simd", random);
+    }
+
+    if (grbuf_set_kernels(GRBUF_KERNELS_AVX2)) {
+        checkGrbufKernels(GRBUF_KERNELS_AVX2, "avx2", random);
+    }
+
+    grbuf_set_kernels(GRBUF_KERNELS_AUTO);
+}
+
+// Results of tile functions for one view center, see `checkTileResults`.
+typedef struct CheckTileResults {
+    std::vector<int> coords;
+    std::vector<int> nums;
+    std::vector<int> neighbors;
+    std::vector<int> walks;
+    std::vector<int> dirs;
+} CheckTileResults;
+
+// Collects results of tile functions for every tile (plus random walks,
+// directions and screen points from [random]).
+static void checkTileResults(CheckTileResults* results, std::mt19937& random)
+{
+    std::uniform_int_distribution<int> tiles(0, HEX_GRID_SIZE - 1);
+    std::uniform_int_distribution<int> rotations(0, ROTATION_COUNT - 1);
+    std::uniform_int_distribution<int> distances(0, 50);
+    std::uniform_int_distribution<int> screenXs(-320, 960);
+    std::uniform_int_distribution<int> screenYs(-240, 720);
+
+    results->coords.clear();
+    results->nums.clear();
+    results->neighbors.clear();
+    results->walks.clear();
+    results->dirs.clear();
+
+    for (int tile = -1; tile <= HEX_GRID_SIZE; tile++) {
+        int x = 0;
+        int y = 0;
+        results->coords.push_back(tile_coord(tile, &x, &y, 0));
+        results->coords.push_back(x);
+        results->coords.push_back(y);
+
+        // Center of tile maps back to it.
+        results->nums.push_back(tile_num(x + 16, y + 8, 0, true));
+
+        for (int rotation = 0; rotation < ROTATION_COUNT; rotation++) {
+            results->neighbors.push_back(tile_num_in_direction(tile, rotation, 1));
+        }
+    }
+
+    for (int index = 0; index < HEX_GRID_SIZE; index++) {
+        int tile = tiles(random);
+        results->walks.push_back(tile_num_in_direction(tile, rotations(random), distances(random)));
+        results->dirs.push_back(tile_dir(tile, tiles(random)));
+        results->nums.push_back(tile_num(screenXs(random), screenYs(random), 0, true));
+    }
+}
+
+static void checkTiles(std::mt19937& random)
+{
+    std::uniform_int_distribution<int> tiles(0, HEX_GRID_SIZE - 1);
+
+    int centers = 0;
+    int coordMismatches = 0;
+    int numMismatches = 0;
+    int neighborMismatches = 0;
+    int walkMismatches = 0;
+    int dirMismatches = 0;
+
+    int oldCenter = tile_center_tile;
+
+    CheckTileResults expected;
+    CheckTileResults actual;
+    for (int attempt = 0; attempt < CHECK_TILE_CENTERS * 16 && centers < CHECK_TILE_CENTERS; attempt++) {
+        // Odd columns are moved to even ones by `tile_set_center`, both
+        // kinds are tried.
+        if (tile_set_center(tiles(random), TILE_SET_CENTER_FLAG_IGNORE_SCROLL_RESTRICTIONS) != 0) {
+            continue;
+        }
+
+        unsigned int seed = (unsigned int)random();
+
+        tile_set_tables_enabled(false);
+        std::mt19937 expectedRandom(seed);
+        checkTileResults(&expected, expectedRandom);
+
+        tile_set_tables_enabled(true);
+        std::mt19937 actualRandom(seed);
+        checkTileResults(&actual, actualRandom);
+
+        coordMismatches += expected.coords != actual.coords ? 1 : 0;
+        numMismatches += expected.nums != actual.nums ? 1 : 0;
+        neighborMismatches += expected.neighbors != actual.neighbors ? 1 : 0;
+        walkMismatches += expected.walks != actual.walks ? 1 : 0;
+        dirMismatches += expected.dirs != actual.dirs ? 1 : 0;
+        centers++;
+    }
+
+    tile_set_center(oldCenter, TILE_SET_CENTER_FLAG_IGNORE_SCROLL_RESTRICTIONS);
+
+    checkReport("tile_coord", "tables_vs_original", centers, coordMismatches);
+    checkReport("tile_num", "tables_vs_original", centers, numMismatches);
+    checkReport("tile_num_in_direction", "tables_vs_original", centers, neighborMismatches);
+    checkReport("tile_num_in_direction_walk", "tables_vs_original", centers, walkMismatches);
+    checkReport("tile_dir", "tables_vs_original", centers, dirMismatches);
+
+    if (centers == 0) {
+        fprintf(stderr, "tile tables: no view center could be set\n");
+        checkFailures++;
+    }
+}
+
+// Source of mixer check.
+typedef struct CheckMixSource {
+    const char* name;
+    int bitsPerSample;
+    int channels;
+    int rate;
+    bool looping;
+} CheckMixSource;
+
+static const CheckMixSource checkMixSources[] = {
+    { "matching", 16, 2, 22050, false },
+    { "matching_looping", 16, 2, 22050, true },
+    { "converted_s8_mono", 8, 1, 22050, false },
+    { "converted_s8_mono_looping", 8, 1, 22050, true },
+    { "resampled_11025_mono", 16, 1, 11025, false },
+    { "resampled_44100", 16, 2, 44100, false },
+};
+
+// Original mixer callback for one sound buffer at full volume: source is
+// put into audio stream one frame at a time and converted data is mixed as
+// soon as it's available. Appends [callbacks] x [length] bytes to [output]
+// and returns number of bytes which came from the sound.
+static size_t checkMixReference(const CheckMixSource* source, const std::vector<unsigned char>& data, int callbacks, int length, std::vector<unsigned char>& output)
+{
+    SDL_AudioStream* stream = SDL_NewAudioStream(source->bitsPerSample == 16 ? AUDIO_S16 : AUDIO_S8,
+        source->channels,
+        source->rate,
+        CHECK_MIX_FORMAT,
+        CHECK_MIX_CHANNELS,
+        CHECK_MIX_RATE);
+    if (stream == NULL) {
+        return 0;
+    }
+
+    size_t produced = 0;
+    int srcFrameSize = source->bitsPerSample / 8 * source->channels;
+    unsigned int size = (unsigned int)data.size();
+    unsigned int pos = 0;
+    bool playing = true;
+
+    std::vector<unsigned char> callback(length);
+    for (int index = 0; index < callbacks; index++) {
+        memset(callback.data(), 0, length);
+
+        if (playing) {
+            unsigned char buffer[1024];
+            int offset = 0;
+            while (offset < length) {
+                int remaining = std::min(length - offset, (int)sizeof(buffer));
+
+                SDL_AudioStreamPut(stream, data.data() + pos, srcFrameSize);
+                pos += srcFrameSize;
+
+                int bytesRead = SDL_AudioStreamGet(stream, buffer, remaining);
+                if (bytesRead == -1) {
+                    break;
+                }
+
+                SDL_MixAudioFormat(callback.data() + offset, buffer, CHECK_MIX_FORMAT, bytesRead, SDL_MIX_MAXVOLUME);
+                produced = output.size() + offset + bytesRead;
+
+                if (pos >= size) {
+                    if (source->looping) {
+                        pos %= size;
+                    } else {
+                        playing = false;
+                        break;
+                    }
+                }
+
+                offset += bytesRead;
+            }
+        }
+
+        output.insert(output.end(), callback.begin(), callback.end());
+    }
+
+    SDL_FreeAudioStream(stream);
+
+    return produced;
+}
+
+// Current mixer with the same source in sound buffer. Returns `false` when
+// buffer could not be created.
+static bool checkMixEngine(const CheckMixSource* source, const std::vector<unsigned char>& data, int callbacks, int length, std::vector<unsigned char>& output)
+{
+    int soundBuffer = audioEngineCreateSoundBuffer((unsigned int)data.size(), source->bitsPerSample, source->channels, source->rate);
+    if (soundBuffer == -1) {
+        return false;
+    }
+
+    void* audioPtr1;
+    unsigned int audioBytes1;
+    void* audioPtr2;
+    unsigned int audioBytes2;
+    if (audioEngineSoundBufferLock(soundBuffer, 0, 0, &audioPtr1, &audioBytes1, &audioPtr2, &audioBytes2, AUDIO_ENGINE_SOUND_BUFFER_LOCK_ENTIRE_BUFFER)) {
+        memcpy(audioPtr1, data.data(), std::min((size_t)audioBytes1, data.size()));
+        audioEngineSoundBufferUnlock(soundBuffer, audioPtr1, audioBytes1, audioPtr2, audioBytes2);
+    }
+
+    audioEngineSoundBufferPlay(soundBuffer, source->looping ? AUDIO_ENGINE_SOUND_BUFFER_PLAY_LOOPING : 0);
+
+    std::vector<unsigned char> callback(length);
+    for (int index = 0; index < callbacks; index++) {
+        audioEngineMix(callback.data(), length);
+        output.insert(output.end(), callback.begin(), callback.end());
+    }
+
+    audioEngineSoundBufferStop(soundBuffer);
+    audioEngineSoundBufferRelease(soundBuffer);
+
+    return true;
+}
+
+static void checkMixer(std::mt19937& random)
+{
+    unsigned char stream[BENCH_MIX_LENGTH];
+    if (!audioEngineMix(stream, sizeof(stream))) {
+        benchSkip("audio_mix", "offline audio backend is not active");
+        return;
+    }
+
+    // Buffers must not advance on virtual clock between mixes.
+    audioEnginePause();
+
+    std::uniform_int_distribution<int> frequencies(110, 440);
+    std::uniform_int_distribution<int> durations(5000, 20000);
+
+    for (const CheckMixSource& source : checkMixSources) {
+        // Low frequency tone, so resampling differences stay small, of
+        // length which is not a multiple of callback period.
+        int frames = durations(random);
+        double frequency = frequencies(random);
+        int frameSize = source.bitsPerSample / 8 * source.channels;
+        std::vector<unsigned char> data(frames * frameSize);
+        for (int frame = 0; frame < frames; frame++) {
+            double value = sin(2.0 * M_PI * frequency * frame / source.rate);
+            for (int channel = 0; channel < source.channels; channel++) {
+                int sample = frame * source.channels + channel;
+                if (source.bitsPerSample == 16) {
+                    Sint16 pcm = (Sint16)lrint(value * 8000.0);
+                    memcpy(data.data() + sample * 2, &pcm, sizeof(pcm));
+                } else {
+                    data[sample] = (unsigned char)(signed char)lrint(value * 60.0);
+                }
+            }
+        }
+
+        // Whole sound plus silence after it (or a few loops).
+        long long outputFrames = (long long)frames * CHECK_MIX_RATE / source.rate;
+        int callbacks = (int)(outputFrames * CHECK_MIX_CHANNELS * 2 / BENCH_MIX_LENGTH) + 3;
+        if (source.looping) {
+            callbacks *= 3;
+        }
+
+        std::vector<unsigned char> expected;
+        size_t produced = checkMixReference(&source, data, callbacks, BENCH_MIX_LENGTH, expected);
+
+        std::vector<unsigned char> actual;
+        if (expected.empty() || !checkMixEngine(&source, data, callbacks, BENCH_MIX_LENGTH, actual)) {
+            benchSkip("audio_mix", "sound buffer could not be created");
+            continue;
+        }
+
+        // Original code dropped samples held back by resampler at the end
+        // of sound, they are played now. Only samples produced by original
+        // code are compared.
+        int tolerance = source.rate != CHECK_MIX_RATE ? CHECK_MIX_TOLERANCE : 0;
+        int samples = (int)((source.looping ? expected.size() : produced) / 2);
+        int mismatches = 0;
+        for (int sample = 0; sample < samples; sample++) {
+            Sint16 expectedSample;
+            Sint16 actualSample;
+            memcpy(&expectedSample, expected.data() + sample * 2, sizeof(expectedSample));
+            memcpy(&actualSample, actual.data() + sample * 2, sizeof(actualSample));
+
+            if (abs(expectedSample - actualSample) > tolerance) {
+                mismatches++;
+            }
+        }
+
+        checkReport("audio_mix", source.name, samples, mismatches);
+    }
+
+    audioEngineResume();
+}
+
+static int check(unsigned int seed)
+{
+    game_force_headless(true);
+
+    char executable[] = "fallout-ce-bench";
+    char* args[] = { executable, NULL };
+    if (game_init("FALLOUT", false, 0, 0, 1, args) == -1) {
+        fprintf(stderr, "Could not initialize game\n");
+        return EXIT_FAILURE;
+    }
+
+    GNW95_isActive = true;
+
+    printf("{\n");
+    printf("  \"seed\": %u,\n", seed);
+    printf("  \"checks\": [\n");
+
+    std::mt19937 grbufRandom(seed);
+    checkGrbuf(grbufRandom);
+
+    std::mt19937 tileRandom(seed + 1);
+    checkTiles(tileRandom);
+
+    std::mt19937 mixerRandom(seed + 2);
+    checkMixer(mixerRandom);
+
+    printf("\n  ]\n}\n");
+
+    game_exit();
+
+    return checkFailures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static int bench(int iterations, unsigned int seed)
+{
+    game_force_headless(true);
+
+    char executable[] = "fallout-ce-bench";
+    char* args[] = { executable, NULL };
+    if (game_init("FALLOUT", false, 0, 0, 1, args) == -1) {
+        fprintf(stderr, "Could not initialize game\n");
+        return EXIT_FAILURE;
+    }
+
+    GNW95_isActive = true;
+
+    printf("{\n");
+    printf("  \"iterations\": %d,\n", iterations);
+    printf("  \"seed\": %u,\n", seed);
+    printf("  \"samples\": %d,\n", BENCH_SAMPLES);
+    printf("  \"results\": [\n");
+
+    // Every group gets its own stream, so adding kernels does not change
+    // inputs of the others.
+    std::mt19937 blitRandom(seed);
+    benchBlitters(iterations, blitRandom);
+
+    std::mt19937 lzssRandom(seed + 1);
+    benchLzss(iterations, lzssRandom);
+
+    benchFramePtr(iterations);
+
+    std::mt19937 cacheRandom(seed + 2);
+    benchCache(iterations, cacheRandom);
+
+    std::mt19937 pathRandom(seed + 3);
+    benchPath(iterations, pathRandom);
+
+    std::mt19937 tileRandom(seed + 7);
+    benchTiles(iterations, tileRandom);
+
+    std::mt19937 queueRandom(seed + 4);
+    benchQueue(iterations, queueRandom);
+
+    benchInterpreter(iterations);
+
+    std::mt19937 messageRandom(seed + 5);
+    benchMessages(iterations, messageRandom);
+
+    std::mt19937 mixerRandom(seed + 6);
+    benchMixer(iterations, mixerRandom);
+
+    printf("\n  ]\n}\n");
+
+    game_exit();
+
+    compat_rmdir(BENCH_TEMP_DIR);
+
+    return EXIT_SUCCESS;
+}
+
+} // namespace fallout
+
+int main(int argc, char* argv[])
+{
+    if (argc >= 2 && strcmp(argv[1], "--check") == 0) {
+        unsigned int seed = argc >= 3 ? (unsigned int)strtoul(argv[2], NULL, 10) : 1;
+        return fallout::check(seed);
+    }
+
+    int iterations = argc >= 2 ? atoi(argv[1]) : 256;
+    if (iterations <= 0) {
+        iterations = 1;
+    }
+
+    unsigned int seed = argc >= 3 ? (unsigned int)strtoul(argv[2], NULL, 10) : 1;
+
+    return fallout::bench(iterations, seed);
+}
@@ -0,0 +1,542 @@
+// Measures pathfinding and line of sight queries over shipped maps.
+//
+// Game is initialized without display, then every map is loaded and each of
+// its elevations receives the same seeded set of queries:
+//
+//   - `make_path` between open tiles (nodes expanded are reported),
+//   - `make_straight_path` with blocking callback,
+//   - `combat_is_shot_blocked` with player as shooter.
+//
+// Results are printed as JSON to stdout. Run from game directory (where
+// `master.dat` and `critter.dat` are).
+//
+// With `--check`, maps are not loaded. Instead `make_path_func` is run on
+// seeded random grids against a copy of the original linear scan search
+// (lowest cost open node and lowest free slot found by scanning every
+// node), and exit code is non-zero when any path length or rotation
+// differs, tie-breaking included.
+//
+// Usage: pathbench [queries] [seed] [map.map ...]
+//        pathbench --check [grids] [seed]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "game/anim.h"
+#include "game/combat.h"
+#include "game/game.h"
+#include "game/map.h"
+#include "game/object.h"
+#include "game/tile.h"
+#include "plib/db/db.h"
+#include "plib/gnw/winmain.h"
+
+namespace fallout {
+
+// Maximum distance (in hexes) between endpoints of a query. Matches typical
+// movement and weapon ranges rather than map-wide walks.
+#define BENCH_MAX_DISTANCE 40
+
+// Number of attempts to find open tile before elevation is skipped.
+#define BENCH_TILE_ATTEMPTS 4096
+
+// Number of queries made on every grid by `--check`.
+#define CHECK_QUERIES_PER_GRID 256
+
+// Capacity of node lists of original search.
+#define CHECK_NODE_CAPACITY 2000
+
+// Maximum path length of original search.
+#define CHECK_PATH_MAX_LENGTH 800
+
+// Node of original search (same layout as `PathNode` in anim.cc).
+struct CheckPathNode {
+    int tile;
+    int from;
+    int rotation;
+    int field_C;
+    int field_10;
+};
+
+// Timings and counters of one query kind.
+struct BenchSeries {
+    std::vector<double> micros;
+    int failures = 0;
+    unsigned int nodes = 0;
+};
+
+// Blocked tiles of grid being checked.
+static std::vector<bool> checkBlocked;
+
+// Returned for blocked tiles, never dereferenced because player cannot use
+// doors while pathfinding.
+static Object checkBlocker;
+
+static CheckPathNode checkOpen[CHECK_NODE_CAPACITY];
+static CheckPathNode checkClosed[CHECK_NODE_CAPACITY];
+static unsigned char checkSeen[(HEX_GRID_SIZE + 7) / 8];
+
+static int randomOpenTile(std::mt19937& random, int elevation)
+{
+    std::uniform_int_distribution<int> tiles(0, HEX_GRID_SIZE - 1);
+    for (int attempt = 0; attempt < BENCH_TILE_ATTEMPTS; attempt++) {
+        int tile = tiles(random);
+        if (obj_blocking_at(obj_dude, tile, elevation) == NULL) {
+            return tile;
+        }
+    }
+
+    return -1;
+}
+
+static int randomNearbyTile(std::mt19937& random, int from)
+{
+    std::uniform_int_distribution<int> rotations(0, ROTATION_COUNT - 1);
+    std::uniform_int_distribution<int> distances(1, BENCH_MAX_DISTANCE);
+
+    int to = from;
+    int remaining = distances(random);
+    while (remaining > 0) {
+        int step = std::min(remaining, 1 + remaining / 2);
+        int next = tile_num_in_direction(to, rotations(random), step);
+        if (next != -1) {
+            to = next;
+        }
+        remaining -= step;
+    }
+
+    return to;
+}
+
+static double percentile(std::vector<double>& values, double fraction)
+{
+    if (values.empty()) {
+        return 0.0;
+    }
+
+    std::sort(values.begin(), values.end());
+
+    size_t index = (size_t)(fraction * (double)(values.size() - 1) + 0.5);
+    return values[index];
+}
+
+static void printSeries(const char* name, BenchSeries& series, bool last)
+{
+    double total = 0.0;
+    for (double value : series.micros) {
+        total += value;
+    }
+
+    size_t count = series.micros.size();
+    printf("        \"%s\": {\"queries\": %zu, \"failures\": %d, \"nodes_expanded\": %u, \"mean_us\": %.2f, \"p50_us\": %.2f, \"p99_us\": %.2f}%s\n",
+        name,
+        count,
+        series.failures,
+        series.nodes,
+        count != 0 ? total / (double)count : 0.0,
+        percentile(series.micros, 0.50),
+        percentile(series.micros, 0.99),
+        last ? "" : ",");
+}
+
+static bool benchElevation(int elevation, int queries, std::mt19937& random, bool first)
+{
+    int start = randomOpenTile(random, elevation);
+    if (start == -1) {
+        return false;
+    }
+
+    obj_move_to_tile(obj_dude, start, elevation, NULL);
+
+    BenchSeries paths;
+    BenchSeries lines;
+    BenchSeries shots;
+
+    unsigned char rotations[800];
+    for (int query = 0; query < queries; query++) {
+        int from = randomOpenTile(random, elevation);
+        if (from == -1) {
+            break;
+        }
+
+        int to = randomNearbyTile(random, from);
+
+        obj_move_to_tile(obj_dude, from, elevation, NULL);
+
+        unsigned int nodes = anim_path_nodes_expanded();
+        auto pathStart = std::chrono::steady_clock::now();
+        int length = make_path(obj_dude, from, to, rotations, 0);
+        auto pathEnd = std::chrono::steady_clock::now();
+        paths.micros.push_back(std::chrono::duration<double, std::micro>(pathEnd - pathStart).count());
+        paths.nodes += anim_path_nodes_expanded() - nodes;
+        if (length == 0) {
+            paths.failures++;
+        }
+
+        Object* obstacle = NULL;
+        auto lineStart = std::chrono::steady_clock::now();
+        make_straight_path(obj_dude, from, to, NULL, &obstacle, 32);
+        auto lineEnd = std::chrono::steady_clock::now();
+        lines.micros.push_back(std::chrono::duration<double, std::micro>(lineEnd - lineStart).count());
+        if (obstacle != NULL) {
+            lines.failures++;
+        }
+
+        int critters;
+        auto shotStart = std::chrono::steady_clock::now();
+        bool blocked = combat_is_shot_blocked(obj_dude, from, to, NULL, &critters);
+        auto shotEnd = std::chrono::steady_clock::now();
+        shots.micros.push_back(std::chrono::duration<double, std::micro>(shotEnd - shotStart).count());
+        if (blocked) {
+            shots.failures++;
+        }
+    }
+
+    printf("%s      {\n", first ? "" : ",\n");
+    printf("        \"elevation\": %d,\n", elevation);
+    printSeries("make_path", paths, false);
+    printSeries("make_straight_path", lines, false);
+    printSeries("combat_is_shot_blocked", shots, true);
+    printf("      }");
+
+    return true;
+}
+
+static void benchMap(const char* name, int queries, unsigned int seed, bool first)
+{
+    char path[64];
+    snprintf(path, sizeof(path), "%s", name);
+
+    printf("%s    {\n", first ? "" : ",\n");
+    printf("      \"map\": \"%s\",\n", name);
+
+    if (map_load(path) != 0) {
+        printf("      \"error\": \"load failed\"\n    }");
+        return;
+    }
+
+    printf("      \"elevations\": [\n");
+
+    bool firstElevation = true;
+    for (int elevation = 0; elevation < ELEVATION_COUNT; elevation++) {
+        // Reseed per elevation so every elevation gets the same query stream
+        // regardless of which maps were benchmarked before.
+        std::mt19937 random(seed + (unsigned int)elevation);
+        if (benchElevation(elevation, queries, random, firstElevation)) {
+            firstElevation = false;
+        }
+    }
+
+    printf("\n      ]\n    }");
+}
+
+static Object* checkBlockingAt(Object* object, int tile, int elevation)
+{
+    return checkBlocked[tile] ? &checkBlocker : NULL;
+}
+
+// Original `make_path_func` before open and free slot heaps, limited to
+// player (so doors always block).
+static int checkReferencePath(Object* object, int from, int to, unsigned char* rotations, int a5, PathBuilderCallback* callback)
+{
+    if (a5) {
+        if (callback(object, to, object->elevation) != NULL) {
+            return 0;
+        }
+    }
+
+    bool isNotInCombat = !isInCombat();
+
+    memset(checkSeen, 0, sizeof(checkSeen));
+
+    checkSeen[from / 8] |= 1 << (from & 7);
+
+    checkOpen[0].tile = from;
+    checkOpen[0].from = -1;
+    checkOpen[0].rotation = 0;
+    checkOpen[0].field_C = EST(from, to);
+    checkOpen[0].field_10 = 0;
+
+    for (int index = 1; index < CHECK_NODE_CAPACITY; index += 1) {
+        checkOpen[index].tile = -1;
+    }
+
+    int toScreenX;
+    int toScreenY;
+    tile_coord(to, &toScreenX, &toScreenY, object->elevation);
+
+    int closedLength = 0;
+    int openLength = 1;
+    CheckPathNode temp;
+
+    while (1) {
+        int best = -1;
+
+        CheckPathNode* prev = NULL;
+        int visited = 0;
+        for (int index = 0; visited < openLength; index += 1) {
+            CheckPathNode* curr = &(checkOpen[index]);
+            if (curr->tile != -1) {
+                visited++;
+                if (best == -1 || (curr->field_C + curr->field_10) < (prev->field_C + prev->field_10)) {
+                    prev = curr;
+                    best = index;
+                }
+            }
+        }
+
+        CheckPathNode* curr = &(checkOpen[best]);
+
+        memcpy(&temp, curr, sizeof(temp));
+
+        openLength -= 1;
+
+        curr->tile = -1;
+
+        if (temp.tile == to) {
+            if (openLength == 0) {
+                openLength = 1;
+            }
+            break;
+        }
+
+        memcpy(&(checkClosed[closedLength]), &temp, sizeof(temp));
+
+        closedLength += 1;
+
+        if (closedLength == CHECK_NODE_CAPACITY) {
+            return 0;
+        }
+
+        for (int rotation = 0; rotation < ROTATION_COUNT; rotation++) {
+            int tile = tile_num_in_direction(temp.tile, rotation, 1);
+            int bit = 1 << (tile & 7);
+            if ((checkSeen[tile / 8] & bit) != 0) {
+                continue;
+            }
+
+            if (tile != to) {
+                if (callback(object, tile, object->elevation) != NULL) {
+                    continue;
+                }
+            }
+
+            int slot = 0;
+            for (; slot < CHECK_NODE_CAPACITY; slot++) {
+                if (checkOpen[slot].tile == -1) {
+                    break;
+                }
+            }
+
+            openLength += 1;
+
+            if (openLength == CHECK_NODE_CAPACITY) {
+                return 0;
+            }
+
+            checkSeen[tile / 8] |= bit;
+
+            CheckPathNode* node = &(checkOpen[slot]);
+            node->tile = tile;
+            node->from = temp.tile;
+            node->rotation = rotation;
+
+            int newX;
+            int newY;
+            tile_coord(tile, &newX, &newY, object->elevation);
+
+            node->field_C = idist(newX, newY, toScreenX, toScreenY);
+            node->field_10 = temp.field_10 + 50;
+
+            if (isNotInCombat && temp.rotation != rotation) {
+                node->field_10 += 10;
+            }
+        }
+
+        if (openLength == 0) {
+            break;
+        }
+    }
+
+    if (openLength == 0) {
+        return 0;
+    }
+
+    int index = 0;
+    for (; index < CHECK_PATH_MAX_LENGTH; index++) {
+        if (temp.tile == from) {
+            break;
+        }
+
+        rotations[index] = temp.rotation & 0xFF;
+
+        int parent = 0;
+        while (checkClosed[parent].tile != temp.from) {
+            parent++;
+        }
+
+        memcpy(&temp, &(checkClosed[parent]), sizeof(temp));
+    }
+
+    std::reverse(rotations, rotations + index);
+
+    return index;
+}
+
+// Fills grid with blocked tiles at random density (up to a half, so both
+// open fields and mazes are covered), then compares both searches. Returns
+// number of mismatching queries.
+static int checkGrid(int grid, std::mt19937& random)
+{
+    std::uniform_int_distribution<int> densities(0, 50);
+    std::uniform_int_distribution<int> percents(0, 99);
+
+    int density = densities(random);
+    checkBlocked.assign(HEX_GRID_SIZE, false);
+    for (int tile = 0; tile < HEX_GRID_SIZE; tile++) {
+        checkBlocked[tile] = percents(random) < density;
+    }
+
+    int mismatches = 0;
+    unsigned char expected[CHECK_PATH_MAX_LENGTH];
+    unsigned char actual[CHECK_PATH_MAX_LENGTH];
+    std::uniform_int_distribution<int> tiles(0, HEX_GRID_SIZE - 1);
+    for (int query = 0; query < CHECK_QUERIES_PER_GRID; query++) {
+        int from = tiles(random);
+        int to = randomNearbyTile(random, from);
+        int a5 = query & 1;
+
+        checkBlocked[from] = false;
+
+        int expectedLength = checkReferencePath(obj_dude, from, to, expected, a5, checkBlockingAt);
+        int actualLength = make_path_func(obj_dude, from, to, actual, a5, checkBlockingAt);
+
+        if (expectedLength != actualLength || memcmp(expected, actual, expectedLength) != 0) {
+            int step = 0;
+            while (step < expectedLength && step < actualLength && expected[step] == actual[step]) {
+                step++;
+            }
+
+            fprintf(stderr, "grid %d (density %d%%), %d -> %d: expected length %d, got %d, first difference at step %d\n",
+                grid,
+                density,
+                from,
+                to,
+                expectedLength,
+                actualLength,
+                step);
+            mismatches++;
+        }
+    }
+
+    return mismatches;
+}
+
+static int check(int grids, unsigned int seed)
+{
+    game_force_headless(true);
+
+    char executable[] = "pathbench";
+    char* args[] = { executable, NULL };
+    if (game_init("FALLOUT", false, 0, 0, 1, args) == -1) {
+        fprintf(stderr, "Could not initialize game\n");
+        return EXIT_FAILURE;
+    }
+
+    GNW95_isActive = true;
+
+    std::mt19937 random(seed);
+
+    int mismatches = 0;
+    for (int grid = 0; grid < grids; grid++) {
+        mismatches += checkGrid(grid, random);
+    }
+
+    printf("{\n");
+    printf("  \"grids\": %d,\n", grids);
+    printf("  \"seed\": %u,\n", seed);
+    printf("  \"queries\": %d,\n", grids * CHECK_QUERIES_PER_GRID);
+    printf("  \"mismatches\": %d\n", mismatches);
+    printf("}\n");
+
+    game_exit();
+
+    return mismatches == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static int bench(int queries, unsigned int seed, int mapCount, char** mapNames)
+{
+    game_force_headless(true);
+
+    char executable[] = "pathbench";
+    char* args[] = { executable, NULL };
+    if (game_init("FALLOUT", false, 0, 0, 1, args) == -1) {
+        fprintf(stderr, "Could not initialize game\n");
+        return EXIT_FAILURE;
+    }
+
+    GNW95_isActive = true;
+
+    std::vector<std::string> maps;
+    if (mapCount != 0) {
+        for (int index = 0; index < mapCount; index++) {
+            maps.push_back(mapNames[index]);
+        }
+    } else {
+        char** fileList;
+        int fileListLength = db_get_file_list("maps\\*.map", &fileList, NULL, 0);
+        for (int index = 0; index < fileListLength; index++) {
+            maps.push_back(fileList[index]);
+        }
+        db_free_file_list(&fileList, NULL);
+        std::sort(maps.begin(), maps.end());
+    }
+
+    printf("{\n");
+    printf("  \"queries\": %d,\n", queries);
+    printf("  \"seed\": %u,\n", seed);
+    printf("  \"max_distance\": %d,\n", BENCH_MAX_DISTANCE);
+    printf("  \"maps\": [\n");
+
+    for (size_t index = 0; index < maps.size(); index++) {
+        benchMap(maps[index].c_str(), queries, seed, index == 0);
+    }
+
+    printf("\n  ]\n}\n");
+
+    game_exit();
+
+    return EXIT_SUCCESS;
+}
+
+} // namespace fallout
+
+int main(int argc, char* argv[])
+{
+    if (argc >= 2 && strcmp(argv[1], "--check") == 0) {
+        int grids = argc >= 3 ? atoi(argv[2]) : 64;
+        if (grids <= 0) {
+            grids = 1;
+        }
+
+        unsigned int seed = argc >= 4 ? (unsigned int)strtoul(argv[3], NULL, 10) : 1;
+        return fallout::check(grids, seed);
+    }
+
+    int queries = argc >= 2 ? atoi(argv[1]) : 1000;
+    if (queries <= 0) {
+        queries = 1;
+    }
+
+    unsigned int seed = argc >= 3 ? (unsigned int)strtoul(argv[2], NULL, 10) : 1;
+
+    int mapCount = argc > 3 ? argc - 3 : 0;
+    return fallout::bench(queries, seed, mapCount, argv + 3);
+}
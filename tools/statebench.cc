@@ -0,0 +1,264 @@
+// Compares binary and JSON encoding of state sent to external controllers.
+//
+// Game is initialized without display, then every map is loaded, player is
+// placed on a seeded set of open tiles and for each placement state is
+// encoded repeatedly:
+//
+//   - `statebin_encode` into reused buffer,
+//   - `statebin_to_json` of the same document (JSON fallback),
+//   - reading every record back from the binary document,
+//   - `statebin_encode` against versions of the previous document (delta),
+//     which only carries sections changed by moving the player.
+//
+// Results are printed as JSON to stdout. Run from game directory (where
+// `master.dat` and `critter.dat` are).
+//
+// Usage: statebench [ticks] [radius] [map.map ...]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "game/game.h"
+#include "game/map.h"
+#include "game/object.h"
+#include "game/statebin.h"
+#include "plib/db/db.h"
+#include "plib/gnw/winmain.h"
+
+namespace fallout {
+
+// Number of player placements per map. State is re-encoded `ticks` times
+// per placement, like a controller polling a standing player.
+#define BENCH_PLACEMENTS 16
+
+// Number of attempts to find open tile for placement.
+#define BENCH_TILE_ATTEMPTS 4096
+
+// Timings and sizes of one encoding.
+struct BenchSeries {
+    std::vector<double> micros;
+    unsigned long long bytes = 0;
+};
+
+static double percentile(std::vector<double>& values, double fraction)
+{
+    if (values.empty()) {
+        return 0.0;
+    }
+
+    std::sort(values.begin(), values.end());
+
+    size_t index = (size_t)(fraction * (double)(values.size() - 1) + 0.5);
+    return values[index];
+}
+
+static void printSeries(const char* name, BenchSeries& series, bool last)
+{
+    double total = 0.0;
+    for (double value : series.micros) {
+        total += value;
+    }
+
+    size_t count = series.micros.size();
+    printf("      \"%s\": {\"ticks\": %zu, \"bytes_per_tick\": %.1f, \"mean_us\": %.2f, \"p50_us\": %.2f, \"p99_us\": %.2f}%s\n",
+        name,
+        count,
+        count != 0 ? (double)series.bytes / (double)count : 0.0,
+        count != 0 ? total / (double)count : 0.0,
+        percentile(series.micros, 0.50),
+        percentile(series.micros, 0.99),
+        last ? "" : ",");
+}
+
+// Touches every field reachable from document, so read cost is measured
+// rather than optimized away.
+static unsigned int readDocument(const std::vector<unsigned char>& buffer)
+{
+    const StateBinHeader* header = statebin_header(buffer.data(), buffer.size());
+    if (header == NULL) {
+        return 0;
+    }
+
+    unsigned int sum = header->sequence;
+
+    const StateBinDude* dude = statebin_dude(header);
+    if (dude != NULL) {
+        for (int stat = 0; stat < STAT_COUNT; stat++) {
+            sum += (unsigned int)dude->stats[stat];
+        }
+    }
+
+    int objectCount;
+    const StateBinObject* objects = statebin_objects(header, &objectCount);
+    for (int index = 0; index < objectCount; index++) {
+        sum += (unsigned int)objects[index].id + (unsigned int)objects[index].tile;
+        sum += (unsigned int)statebin_string(header, objects[index].name)[0];
+    }
+
+    int itemCount;
+    const StateBinItem* items = statebin_inventory(header, &itemCount);
+    for (int index = 0; index < itemCount; index++) {
+        sum += (unsigned int)items[index].pid * (unsigned int)items[index].quantity;
+    }
+
+    return sum;
+}
+
+static void benchMap(const char* name, int ticks, const StateBinOptions* options, std::mt19937& random, bool first)
+{
+    char path[64];
+    snprintf(path, sizeof(path), "%s", name);
+
+    printf("%s    {\n", first ? "" : ",\n");
+    printf("      \"map\": \"%s\",\n", name);
+
+    if (map_load(path) != 0) {
+        printf("      \"error\": \"load failed\"\n    }");
+        return;
+    }
+
+    BenchSeries binary;
+    BenchSeries json;
+    BenchSeries read;
+    BenchSeries delta;
+    unsigned int objects = 0;
+    unsigned int checksum = 0;
+
+    std::vector<unsigned char> buffer;
+    std::vector<unsigned char> deltaBuffer;
+    std::string text;
+
+    StateBinOptions deltaOptions = *options;
+    uint32_t baseVersions[STATE_VERSION_COUNT];
+    deltaOptions.baseVersions = NULL;
+    std::uniform_int_distribution<int> tiles(0, HEX_GRID_SIZE - 1);
+
+    for (int placement = 0; placement < BENCH_PLACEMENTS; placement++) {
+        int elevation = obj_dude->elevation;
+        for (int attempt = 0; attempt < BENCH_TILE_ATTEMPTS; attempt++) {
+            int tile = tiles(random);
+            if (obj_blocking_at(obj_dude, tile, elevation) == NULL) {
+                obj_move_to_tile(obj_dude, tile, elevation, NULL);
+                break;
+            }
+        }
+
+        for (int tick = 0; tick < ticks; tick++) {
+            auto binaryStart = std::chrono::steady_clock::now();
+            size_t size = statebin_encode(&buffer, (unsigned int)tick, options);
+            auto binaryEnd = std::chrono::steady_clock::now();
+            binary.micros.push_back(std::chrono::duration<double, std::micro>(binaryEnd - binaryStart).count());
+            binary.bytes += size;
+
+            auto readStart = std::chrono::steady_clock::now();
+            checksum += readDocument(buffer);
+            auto readEnd = std::chrono::steady_clock::now();
+            read.micros.push_back(std::chrono::duration<double, std::micro>(readEnd - readStart).count());
+            read.bytes += size;
+
+            // JSON fallback pays for collecting state too.
+            auto jsonStart = std::chrono::steady_clock::now();
+            statebin_encode(&buffer, (unsigned int)tick, options);
+            statebin_to_json(statebin_header(buffer.data(), buffer.size()), &text);
+            auto jsonEnd = std::chrono::steady_clock::now();
+            json.micros.push_back(std::chrono::duration<double, std::micro>(jsonEnd - jsonStart).count());
+            json.bytes += text.size();
+
+            auto deltaStart = std::chrono::steady_clock::now();
+            size_t deltaSize = statebin_encode(&deltaBuffer, (unsigned int)tick, &deltaOptions);
+            auto deltaEnd = std::chrono::steady_clock::now();
+            delta.micros.push_back(std::chrono::duration<double, std::micro>(deltaEnd - deltaStart).count());
+            delta.bytes += deltaSize;
+
+            memcpy(baseVersions, statebin_header(deltaBuffer.data(), deltaBuffer.size())->versions, sizeof(baseVersions));
+            deltaOptions.baseVersions = baseVersions;
+        }
+
+        int count;
+        statebin_objects(statebin_header(buffer.data(), buffer.size()), &count);
+        objects += (unsigned int)count;
+    }
+
+    printf("      \"mean_objects\": %.1f,\n", (double)objects / BENCH_PLACEMENTS);
+    printf("      \"checksum\": %u,\n", checksum);
+    printSeries("binary_encode", binary, false);
+    printSeries("binary_read", read, false);
+    printSeries("json_encode", json, false);
+    printSeries("delta_encode", delta, true);
+    printf("    }");
+}
+
+static int bench(int ticks, int radius, int mapCount, char** mapNames)
+{
+    game_force_headless(true);
+
+    char executable[] = "statebench";
+    char* args[] = { executable, NULL };
+    if (game_init("FALLOUT", false, 0, 0, 1, args) == -1) {
+        fprintf(stderr, "Could not initialize game\n");
+        return EXIT_FAILURE;
+    }
+
+    GNW95_isActive = true;
+
+    std::vector<std::string> maps;
+    if (mapCount != 0) {
+        for (int index = 0; index < mapCount; index++) {
+            maps.push_back(mapNames[index]);
+        }
+    } else {
+        char** fileList;
+        int fileListLength = db_get_file_list("maps\\*.map", &fileList, NULL, 0);
+        for (int index = 0; index < fileListLength; index++) {
+            maps.push_back(fileList[index]);
+        }
+        db_free_file_list(&fileList, NULL);
+        std::sort(maps.begin(), maps.end());
+    }
+
+    StateBinOptions options;
+    options.objectRadius = radius;
+    options.names = true;
+    options.baseVersions = NULL;
+
+    printf("{\n");
+    printf("  \"ticks\": %d,\n", ticks);
+    printf("  \"radius\": %d,\n", radius);
+    printf("  \"maps\": [\n");
+
+    std::mt19937 random(1);
+    for (size_t index = 0; index < maps.size(); index++) {
+        benchMap(maps[index].c_str(), ticks, &options, random, index == 0);
+    }
+
+    printf("\n  ]\n}\n");
+
+    game_exit();
+
+    return EXIT_SUCCESS;
+}
+
+} // namespace fallout
+
+int main(int argc, char* argv[])
+{
+    int ticks = argc >= 2 ? atoi(argv[1]) : 100;
+    if (ticks <= 0) {
+        ticks = 1;
+    }
+
+    int radius = argc >= 3 ? atoi(argv[2]) : 20;
+    if (radius < 0) {
+        radius = 0;
+    }
+
+    int mapCount = argc > 3 ? argc - 3 : 0;
+    return fallout::bench(ticks, radius, mapCount, argv + 3);
+}